@@ -110,6 +110,8 @@ extern "C" {
 
 typedef struct osmesa_context *OSMesaContext;
 
+typedef struct osmesa_context_pool *OSMesaContextPool;
+
 
 /*
  * Create an Off-Screen Mesa rendering context.  The only attribute needed is
@@ -324,6 +326,47 @@ OSMesaPostprocess(OSMesaContext osmesa, const char *filter,
                   unsigned enable_value);
 
 
+/**
+ * Create a pool of contexts which all have the attributes given by
+ * attribList (see OSMesaCreateContextAttribs()).  numContexts contexts are
+ * created up front.  Contexts taken from a pool may be used from different
+ * threads at the same time and keep their internal buffers between uses.
+ * Only available with Gallium drivers.
+ * New in Mesa 11.2
+ */
+GLAPI OSMesaContextPool GLAPIENTRY
+OSMesaCreateContextPool(const int *attribList, OSMesaContext sharelist,
+                        GLint numContexts);
+
+
+/**
+ * Destroy a context pool and all its contexts.  All contexts acquired
+ * from it must have been released first.
+ * New in Mesa 11.2
+ */
+GLAPI void GLAPIENTRY
+OSMesaDestroyContextPool(OSMesaContextPool pool);
+
+
+/**
+ * Take an unused context from the pool, creating one if there's none.
+ * Bind it with OSMesaMakeCurrent().  The GL state is whatever the previous
+ * user left; the OSMesaPixelStore() values are reset to their defaults.
+ * New in Mesa 11.2
+ */
+GLAPI OSMesaContext GLAPIENTRY
+OSMesaAcquireContext(OSMesaContextPool pool);
+
+
+/**
+ * Return a context to its pool.  If the context is current in the calling
+ * thread it is unbound.
+ * New in Mesa 11.2
+ */
+GLAPI void GLAPIENTRY
+OSMesaReleaseContext(OSMesaContext osmesa);
+
+
 #ifdef __cplusplus
 }
 #endif
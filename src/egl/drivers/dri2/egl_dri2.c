@@ -764,6 +764,10 @@ dri2_initialize(_EGLDriver *drv, _EGLDisplay *disp)
       if (disp->Options.TestOnly)
          return EGL_TRUE;
       return dri2_initialize_surfaceless(drv, disp);
+   case _EGL_PLATFORM_DEVICE:
+      if (disp->Options.TestOnly)
+         return EGL_TRUE;
+      return dri2_initialize_device(drv, disp);
 #endif
 
 #ifdef HAVE_X11_PLATFORM
@@ -213,6 +213,7 @@ struct dri2_egl_display
    int			     formats;
    uint32_t                  capabilities;
    int			     is_render_node;
+   int                       num_color_buffers;
 #endif
 
    int			     is_different_gpu;
@@ -233,6 +234,8 @@ enum wayland_buffer_type {
 };
 #endif
 
+#define DRI2_MAX_COLOR_BUFFERS 8
+
 struct dri2_egl_surface
 {
    _EGLSurface          base;
@@ -256,6 +259,7 @@ struct dri2_egl_surface
    int                    dy;
    struct wl_callback    *throttle_callback;
    int			  format;
+   unsigned               release_serial;
 #endif
 
 #ifdef HAVE_DRM_PLATFORM
@@ -270,6 +274,10 @@ struct dri2_egl_surface
       __DRIimage         *dri_image;
       /* for is_different_gpu case. NULL else */
       __DRIimage         *linear_copy;
+      /* box (x1, y1, x2, y2) of dri_image not yet copied to linear_copy */
+      int                 damage[4];
+      /* order in which the compositor released the buffer */
+      unsigned            release_serial;
       /* for swrast */
       void *data;
       int data_size;
@@ -279,7 +287,7 @@ struct dri2_egl_surface
 #endif
       int                 locked;
       int                 age;
-   } color_buffers[4], *back, *current;
+   } color_buffers[DRI2_MAX_COLOR_BUFFERS], *back, *current;
 #endif
 
 #ifdef HAVE_ANDROID_PLATFORM
@@ -372,6 +380,9 @@ dri2_initialize_android(_EGLDriver *drv, _EGLDisplay *disp);
 EGLBoolean
 dri2_initialize_surfaceless(_EGLDriver *drv, _EGLDisplay *disp);
 
+EGLBoolean
+dri2_initialize_device(_EGLDriver *drv, _EGLDisplay *disp);
+
 void
 dri2_flush_drawable_for_swapbuffers(_EGLDisplay *disp, _EGLSurface *draw);
 
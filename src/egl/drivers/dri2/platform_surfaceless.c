@@ -35,6 +35,7 @@
 
 #include "egl_dri2.h"
 #include "egl_dri2_fallbacks.h"
+#include "egldevice.h"
 #include "loader.h"
 
 static struct dri2_egl_display_vtbl dri2_surfaceless_display_vtbl = {
@@ -74,8 +75,36 @@ surfaceless_get_buffers_with_format(__DRIdrawable * driDrawable,
 
 #define DRM_RENDER_DEV_NAME  "%s/renderD%d"
 
-EGLBoolean
-dri2_initialize_surfaceless(_EGLDriver *drv, _EGLDisplay *disp)
+/**
+ * Open a render node and load its driver.  On failure, nothing is left
+ * open.
+ */
+static EGLBoolean
+surfaceless_probe_device(_EGLDisplay *disp, const char *path)
+{
+   struct dri2_egl_display *dri2_dpy = disp->DriverData;
+
+   dri2_dpy->fd = loader_open_device(path);
+   if (dri2_dpy->fd < 0)
+      return EGL_FALSE;
+
+   dri2_dpy->driver_name = loader_get_driver_for_fd(dri2_dpy->fd, 0);
+   if (dri2_dpy->driver_name) {
+      if (dri2_load_driver(disp))
+         return EGL_TRUE;
+      free(dri2_dpy->driver_name);
+   }
+   close(dri2_dpy->fd);
+
+   return EGL_FALSE;
+}
+
+/**
+ * Initialize a display on the render node at path, or on the first usable
+ * one when path is NULL.
+ */
+static EGLBoolean
+surfaceless_initialize(_EGLDriver *drv, _EGLDisplay *disp, const char *path)
 {
    struct dri2_egl_display *dri2_dpy;
    const char* err;
@@ -90,28 +119,22 @@ dri2_initialize_surfaceless(_EGLDriver *drv, _EGLDisplay *disp)
 
    disp->DriverData = (void *) dri2_dpy;
 
-   const int limit = 64;
-   const int base = 128;
-   for (i = 0; i < limit; ++i) {
-      char *card_path;
-      if (asprintf(&card_path, DRM_RENDER_DEV_NAME, DRM_DIR_NAME, base + i) < 0)
-         continue;
-
-      dri2_dpy->fd = loader_open_device(card_path);
-
-      free(card_path);
-      if (dri2_dpy->fd < 0)
-         continue;
-
-      dri2_dpy->driver_name = loader_get_driver_for_fd(dri2_dpy->fd, 0);
-      if (dri2_dpy->driver_name) {
-         if (dri2_load_driver(disp)) {
-            driver_loaded = 1;
+   if (path) {
+      driver_loaded = surfaceless_probe_device(disp, path);
+   } else {
+      const int limit = 64;
+      const int base = 128;
+      for (i = 0; i < limit; ++i) {
+         char *card_path;
+         if (asprintf(&card_path, DRM_RENDER_DEV_NAME,
+                      DRM_DIR_NAME, base + i) < 0)
+            continue;
+
+         driver_loaded = surfaceless_probe_device(disp, card_path);
+         free(card_path);
+         if (driver_loaded)
             break;
-         }
-         free(dri2_dpy->driver_name);
       }
-      close(dri2_dpy->fd);
    }
 
    if (!driver_loaded) {
@@ -160,3 +183,24 @@ cleanup_display:
 
    return _eglError(EGL_NOT_INITIALIZED, err);
 }
+
+EGLBoolean
+dri2_initialize_surfaceless(_EGLDriver *drv, _EGLDisplay *disp)
+{
+   return surfaceless_initialize(drv, disp, NULL);
+}
+
+/**
+ * EGL_EXT_platform_device displays are surfaceless displays bound to one
+ * render node, so that a process can drive several GPUs at once.
+ */
+EGLBoolean
+dri2_initialize_device(_EGLDriver *drv, _EGLDisplay *disp)
+{
+   _EGLDevice *dev = disp->PlatformDisplay;
+
+   if (!dev)
+      return _eglError(EGL_NOT_INITIALIZED, "DRI2: no device");
+
+   return surfaceless_initialize(drv, disp, dev->Path);
+}
@@ -45,6 +45,9 @@
 #include <wayland-client.h>
 #include "wayland-drm-client-protocol.h"
 
+#define MIN2(A, B)  (((A) < (B)) ? (A) : (B))
+#define MAX2(A, B)  (((A) > (B)) ? (A) : (B))
+
 enum wl_drm_format_flags {
    HAS_ARGB8888 = 1,
    HAS_XRGB8888 = 2,
@@ -102,6 +105,7 @@ wl_buffer_release(void *data, struct wl_buffer *buffer)
    }
 
    dri2_surf->color_buffers[i].locked = 0;
+   dri2_surf->color_buffers[i].release_serial = ++dri2_surf->release_serial;
 }
 
 static const struct wl_buffer_listener wl_buffer_listener = {
@@ -300,6 +304,37 @@ dri2_wl_release_buffers(struct dri2_egl_surface *dri2_surf)
    }
 }
 
+/**
+ * Give the compositor a chance to release buffers before we look for a free
+ * one.
+ */
+static int
+throttle(struct dri2_egl_surface *dri2_surf)
+{
+   struct dri2_egl_display *dri2_dpy =
+      dri2_egl_display(dri2_surf->base.Resource.Display);
+
+   /* With a swap interval of 0 don't wait for the sync request sent after
+    * the last commit, only handle the release events that already arrived.
+    * Acquiring a buffer then only blocks when the compositor holds all of
+    * them.
+    */
+   if (dri2_surf->base.SwapInterval == 0)
+      return wl_display_dispatch_queue_pending(dri2_dpy->wl_dpy,
+                                               dri2_dpy->wl_queue);
+
+   /* Otherwise we always want to throttle to some event (either a frame
+    * callback or a sync request) after the commit so that we can be sure the
+    * compositor has had a chance to handle it and send us a release event
+    * before we look for a free buffer */
+   while (dri2_surf->throttle_callback != NULL)
+      if (wl_display_dispatch_queue(dri2_dpy->wl_dpy,
+                                    dri2_dpy->wl_queue) == -1)
+         return -1;
+
+   return 0;
+}
+
 static int
 get_back_bo(struct dri2_egl_surface *dri2_surf)
 {
@@ -327,30 +362,34 @@ get_back_bo(struct dri2_egl_surface *dri2_surf)
       return -1;
    }
 
-   /* We always want to throttle to some event (either a frame callback or
-    * a sync request) after the commit so that we can be sure the
-    * compositor has had a chance to handle it and send us a release event
-    * before we look for a free buffer */
-   while (dri2_surf->throttle_callback != NULL)
-      if (wl_display_dispatch_queue(dri2_dpy->wl_dpy,
-                                    dri2_dpy->wl_queue) == -1)
-         return -1;
+   if (throttle(dri2_surf) == -1)
+      return -1;
 
-   if (dri2_surf->back == NULL) {
-      for (i = 0; i < ARRAY_SIZE(dri2_surf->color_buffers); i++) {
+   while (dri2_surf->back == NULL) {
+      for (i = 0; i < dri2_dpy->num_color_buffers; i++) {
          /* Get an unlocked buffer, preferrably one with a dri_buffer
-          * already allocated. */
+          * already allocated, reusing buffers in the order the compositor
+          * released them. */
          if (dri2_surf->color_buffers[i].locked)
             continue;
          if (dri2_surf->back == NULL)
             dri2_surf->back = &dri2_surf->color_buffers[i];
          else if (dri2_surf->back->dri_image == NULL)
             dri2_surf->back = &dri2_surf->color_buffers[i];
+         else if (dri2_surf->color_buffers[i].dri_image &&
+                  dri2_surf->color_buffers[i].release_serial <
+                  dri2_surf->back->release_serial)
+            dri2_surf->back = &dri2_surf->color_buffers[i];
       }
-   }
 
-   if (dri2_surf->back == NULL)
-      return -1;
+      if (dri2_surf->back)
+         break;
+
+      /* The compositor holds all our buffers, wait for one to come back */
+      if (wl_display_dispatch_queue(dri2_dpy->wl_dpy,
+                                    dri2_dpy->wl_queue) == -1)
+         return -1;
+   }
 
    if (dri2_dpy->is_different_gpu &&
        dri2_surf->back->linear_copy == NULL) {
@@ -376,6 +415,8 @@ get_back_bo(struct dri2_egl_surface *dri2_surf)
                                          0 : __DRI_IMAGE_USE_SHARE,
                                       NULL);
       dri2_surf->back->age = 0;
+      dri2_surf->back->damage[0] = dri2_surf->back->damage[1] = 0;
+      dri2_surf->back->damage[2] = dri2_surf->back->damage[3] = INT_MAX;
    }
    if (dri2_surf->back->dri_image == NULL)
       return -1;
@@ -653,6 +694,106 @@ create_wl_buffer(struct dri2_egl_surface *dri2_surf)
                           &wl_buffer_listener, dri2_surf);
 }
 
+static void
+damage_union(int *damage, const int *box)
+{
+   if (box[0] >= box[2] || box[1] >= box[3])
+      return;
+
+   if (damage[0] >= damage[2] || damage[1] >= damage[3]) {
+      memcpy(damage, box, 4 * sizeof(int));
+      return;
+   }
+
+   damage[0] = MIN2(damage[0], box[0]);
+   damage[1] = MIN2(damage[1], box[1]);
+   damage[2] = MAX2(damage[2], box[2]);
+   damage[3] = MAX2(damage[3], box[3]);
+}
+
+/**
+ * For the is_different_gpu case, copy the parts of the current buffer that
+ * changed since its linear copy was last updated. Every other buffer
+ * accumulates the damage of this frame for its next swap.
+ */
+static void
+update_linear_copy(struct dri2_egl_surface *dri2_surf,
+                   __DRIcontext *dri_context,
+                   const EGLint *rects, EGLint n_rects)
+{
+   struct dri2_egl_display *dri2_dpy =
+      dri2_egl_display(dri2_surf->base.Resource.Display);
+   int box[4] = { INT_MAX, INT_MAX, 0, 0 };
+   int *damage = dri2_surf->current->damage;
+   int i, x1, y1, x2, y2;
+
+   if (n_rects == 0) {
+      box[0] = box[1] = 0;
+      box[2] = box[3] = INT_MAX;
+   }
+
+   /* Damage rectangles have their origin at the bottom left */
+   for (i = 0; i < n_rects; i++) {
+      const EGLint *rect = &rects[i * 4];
+
+      box[0] = MIN2(box[0], rect[0]);
+      box[1] = MIN2(box[1], dri2_surf->base.Height - rect[1] - rect[3]);
+      box[2] = MAX2(box[2], rect[0] + rect[2]);
+      box[3] = MAX2(box[3], dri2_surf->base.Height - rect[1]);
+   }
+
+   for (i = 0; i < ARRAY_SIZE(dri2_surf->color_buffers); i++) {
+      if (&dri2_surf->color_buffers[i] != dri2_surf->current)
+         damage_union(dri2_surf->color_buffers[i].damage, box);
+   }
+
+   damage_union(damage, box);
+   x1 = MAX2(damage[0], 0);
+   y1 = MAX2(damage[1], 0);
+   x2 = MIN2(damage[2], dri2_surf->base.Width);
+   y2 = MIN2(damage[3], dri2_surf->base.Height);
+   damage[0] = damage[1] = damage[2] = damage[3] = 0;
+
+   if (x2 <= x1 || y2 <= y1)
+      return;
+
+   dri2_dpy->image->blitImage(dri_context,
+                              dri2_surf->current->linear_copy,
+                              dri2_surf->current->dri_image,
+                              x1, y1, x2 - x1, y2 - y1,
+                              x1, y1, x2 - x1, y2 - y1, 0);
+}
+
+/**
+ * Post the damage rectangles in buffer coordinates, if the compositor
+ * supports it.
+ */
+static EGLBoolean
+try_damage_buffer(struct dri2_egl_surface *dri2_surf,
+                  const EGLint *rects, EGLint n_rects)
+{
+#ifdef WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION
+   int i;
+
+   if (wl_proxy_get_version((struct wl_proxy *) dri2_surf->wl_win->surface) <
+       WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION)
+      return EGL_FALSE;
+
+   for (i = 0; i < n_rects; i++) {
+      const EGLint *rect = &rects[i * 4];
+
+      wl_surface_damage_buffer(dri2_surf->wl_win->surface,
+                               rect[0],
+                               dri2_surf->base.Height - rect[1] - rect[3],
+                               rect[2], rect[3]);
+   }
+
+   return EGL_TRUE;
+#else
+   return EGL_FALSE;
+#endif
+}
+
 /**
  * Called via eglSwapBuffers(), drv->API.SwapBuffers().
  */
@@ -703,21 +844,28 @@ dri2_wl_swap_buffers_with_damage(_EGLDriver *drv,
    dri2_surf->dx = 0;
    dri2_surf->dy = 0;
 
-   /* We deliberately ignore the damage region and post maximum damage, due to
-    * https://bugs.freedesktop.org/78190 */
-   wl_surface_damage(dri2_surf->wl_win->surface,
-                     0, 0, INT32_MAX, INT32_MAX);
+   /* Surface-coordinate damage is wrong for scaled or transformed buffers
+    * (https://bugs.freedesktop.org/78190), so only pass the damage region on
+    * when it can be given in buffer coordinates and post maximum damage
+    * otherwise.
+    */
+   if (n_rects == 0 || !try_damage_buffer(dri2_surf, rects, n_rects))
+      wl_surface_damage(dri2_surf->wl_win->surface,
+                        0, 0, INT32_MAX, INT32_MAX);
 
    if (dri2_dpy->is_different_gpu) {
       _EGLContext *ctx = _eglGetCurrentContext();
       struct dri2_egl_context *dri2_ctx = dri2_egl_context(ctx);
-      dri2_dpy->image->blitImage(dri2_ctx->dri_context,
-                                 dri2_surf->current->linear_copy,
-                                 dri2_surf->current->dri_image,
-                                 0, 0, dri2_surf->base.Width,
-                                 dri2_surf->base.Height,
-                                 0, 0, dri2_surf->base.Width,
-                                 dri2_surf->base.Height, 0);
+
+      /* Without swap damage, only the EGL_KHR_partial_update region can
+       * have been rendered to in this frame.
+       */
+      if (n_rects == 0 && draw->SetDamageRegionCalled)
+         update_linear_copy(dri2_surf, dri2_ctx->dri_context,
+                            draw->DamageRegion, 1);
+      else
+         update_linear_copy(dri2_surf, dri2_ctx->dri_context,
+                            rects, n_rects);
    }
 
    dri2_flush_drawable_for_swapbuffers(disp, draw);
@@ -971,6 +1119,19 @@ dri2_wl_swap_interval(_EGLDriver *drv,
    return EGL_TRUE;
 }
 
+static void
+dri2_wl_setup_color_buffers(struct dri2_egl_display *dri2_dpy)
+{
+   GLint num_color_buffers = 4;
+
+   if (dri2_dpy->config)
+      dri2_dpy->config->configQueryi(dri2_dpy->dri_screen,
+                                     "wl_color_buffers", &num_color_buffers);
+
+   dri2_dpy->num_color_buffers =
+      MAX2(MIN2(num_color_buffers, DRI2_MAX_COLOR_BUFFERS), 2);
+}
+
 static void
 dri2_wl_setup_swap_interval(struct dri2_egl_display *dri2_dpy)
 {
@@ -1126,6 +1287,7 @@ dri2_initialize_wayland_drm(_EGLDriver *drv, _EGLDisplay *disp)
       goto cleanup_driver;
 
    dri2_wl_setup_swap_interval(dri2_dpy);
+   dri2_wl_setup_color_buffers(dri2_dpy);
 
    /* To use Prime, we must have _DRI_IMAGE v7 at least.
     * createImageFromFds support indicates that Prime export/import
@@ -1179,6 +1341,7 @@ dri2_initialize_wayland_drm(_EGLDriver *drv, _EGLDisplay *disp)
    disp->Extensions.EXT_buffer_age = EGL_TRUE;
 
    disp->Extensions.EXT_swap_buffers_with_damage = EGL_TRUE;
+   disp->Extensions.KHR_partial_update = EGL_TRUE;
 
    /* Fill vtbl last to prevent accidentally calling virtual function during
     * initialization.
@@ -1392,17 +1555,11 @@ swrast_update_buffers(struct dri2_egl_surface *dri2_surf)
 
    /* find back buffer */
 
-   /* We always want to throttle to some event (either a frame callback or
-    * a sync request) after the commit so that we can be sure the
-    * compositor has had a chance to handle it and send us a release event
-    * before we look for a free buffer */
-   while (dri2_surf->throttle_callback != NULL)
-      if (wl_display_dispatch_queue(dri2_dpy->wl_dpy,
-                                    dri2_dpy->wl_queue) == -1)
-         return -1;
+   if (throttle(dri2_surf) == -1)
+      return -1;
 
    /* try get free buffer already created */
-   for (i = 0; i < ARRAY_SIZE(dri2_surf->color_buffers); i++) {
+   for (i = 0; i < dri2_dpy->num_color_buffers; i++) {
       if (!dri2_surf->color_buffers[i].locked &&
           dri2_surf->color_buffers[i].wl_buffer) {
           dri2_surf->back = &dri2_surf->color_buffers[i];
@@ -1412,7 +1569,7 @@ swrast_update_buffers(struct dri2_egl_surface *dri2_surf)
 
    /* else choose any another free location */
    if (!dri2_surf->back) {
-      for (i = 0; i < ARRAY_SIZE(dri2_surf->color_buffers); i++) {
+      for (i = 0; i < dri2_dpy->num_color_buffers; i++) {
          if (!dri2_surf->color_buffers[i].locked) {
              dri2_surf->back = &dri2_surf->color_buffers[i];
              if (!dri2_wl_swrast_allocate_buffer(dri2_dpy,
@@ -1820,6 +1977,7 @@ dri2_initialize_wayland_swrast(_EGLDriver *drv, _EGLDisplay *disp)
       goto cleanup_driver;
 
    dri2_wl_setup_swap_interval(dri2_dpy);
+   dri2_wl_setup_color_buffers(dri2_dpy);
 
    types = EGL_WINDOW_BIT;
    for (i = 0; dri2_dpy->driver_configs[i]; i++) {
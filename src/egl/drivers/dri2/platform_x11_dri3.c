@@ -371,7 +371,9 @@ const __DRIimageLoaderExtension dri3_image_loader_extension = {
 };
 
 static EGLBoolean
-dri3_swap_buffers(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *draw)
+dri3_swap_buffers_with_damage(_EGLDriver *drv, _EGLDisplay *disp,
+                              _EGLSurface *draw,
+                              const EGLint *rects, EGLint n_rects)
 {
    struct dri3_egl_surface *dri3_surf = dri3_egl_surface(draw);
 
@@ -379,9 +381,24 @@ dri3_swap_buffers(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *draw)
    if (draw->Type == EGL_PIXMAP_BIT || draw->Type == EGL_PBUFFER_BIT)
       return 0;
 
-   return loader_dri3_swap_buffers_msc(&dri3_surf->loader_drawable,
-                                       0, 0, 0, 0,
-                                       draw->SwapBehavior == EGL_BUFFER_PRESERVED) != -1;
+   /* Without swap damage, only the EGL_KHR_partial_update region can have
+    * been rendered to in this frame.
+    */
+   if (n_rects == 0 && draw->SetDamageRegionCalled) {
+      rects = draw->DamageRegion;
+      n_rects = 1;
+   }
+
+   return loader_dri3_swap_buffers_with_damage(&dri3_surf->loader_drawable,
+                                               0, 0, 0, 0,
+                                               draw->SwapBehavior == EGL_BUFFER_PRESERVED,
+                                               rects, n_rects) != -1;
+}
+
+static EGLBoolean
+dri3_swap_buffers(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *draw)
+{
+   return dri3_swap_buffers_with_damage(drv, disp, draw, NULL, 0);
 }
 
 static EGLBoolean
@@ -425,7 +442,7 @@ struct dri2_egl_display_vtbl dri3_x11_display_vtbl = {
    .create_image = dri3_create_image_khr,
    .swap_interval = dri3_set_swap_interval,
    .swap_buffers = dri3_swap_buffers,
-   .swap_buffers_with_damage = dri2_fallback_swap_buffers_with_damage,
+   .swap_buffers_with_damage = dri3_swap_buffers_with_damage,
    .swap_buffers_region = dri2_fallback_swap_buffers_region,
    .post_sub_buffer = dri2_fallback_post_sub_buffer,
    .copy_buffers = dri3_copy_buffers,
@@ -92,6 +92,7 @@
 
 #include "eglglobals.h"
 #include "eglcontext.h"
+#include "egldevice.h"
 #include "egldisplay.h"
 #include "egltypedefs.h"
 #include "eglcurrent.h"
@@ -318,6 +319,14 @@ eglGetPlatformDisplayEXT(EGLenum platform, void *native_display,
                                   attrib_list);
       break;
 #endif
+   case EGL_PLATFORM_DEVICE_EXT: {
+      _EGLDevice *dev = _eglLookupDevice((EGLDeviceEXT) native_display);
+
+      if (!dev)
+         RETURN_EGL_ERROR(NULL, EGL_BAD_PARAMETER, NULL);
+      dpy = _eglGetDeviceDisplay(dev, attrib_list);
+      break;
+   }
    default:
       RETURN_EGL_ERROR(NULL, EGL_BAD_PARAMETER, NULL);
    }
@@ -403,6 +412,7 @@ _eglCreateExtensionsString(_EGLDisplay *dpy)
       _eglAppendExtension(&exts, "EGL_KHR_image");
    _EGL_CHECK_EXTENSION(KHR_image_base);
    _EGL_CHECK_EXTENSION(KHR_image_pixmap);
+   _EGL_CHECK_EXTENSION(KHR_partial_update);
    _EGL_CHECK_EXTENSION(KHR_reusable_sync);
    _EGL_CHECK_EXTENSION(KHR_surfaceless_context);
    _EGL_CHECK_EXTENSION(KHR_vg_parent_image);
@@ -1009,6 +1019,12 @@ eglSwapBuffers(EGLDisplay dpy, EGLSurface surface)
 
    ret = drv->API.SwapBuffers(drv, disp, surf);
 
+   /* EGL_KHR_partial_update: a new frame starts after the swap */
+   if (ret) {
+      surf->SetDamageRegionCalled = EGL_FALSE;
+      surf->BufferAgeRead = EGL_FALSE;
+   }
+
    RETURN_EGL_EVAL(disp, ret);
 }
 
@@ -1035,9 +1051,49 @@ eglSwapBuffersWithDamageEXT(EGLDisplay dpy, EGLSurface surface,
 
    ret = drv->API.SwapBuffersWithDamageEXT(drv, disp, surf, rects, n_rects);
 
+   if (ret) {
+      surf->SetDamageRegionCalled = EGL_FALSE;
+      surf->BufferAgeRead = EGL_FALSE;
+   }
+
    RETURN_EGL_EVAL(disp, ret);
 }
 
+static EGLBoolean EGLAPIENTRY
+eglSetDamageRegionKHR(EGLDisplay dpy, EGLSurface surface,
+                      EGLint *rects, EGLint n_rects)
+{
+   _EGLContext *ctx = _eglGetCurrentContext();
+   _EGLDisplay *disp = _eglLockDisplay(dpy);
+   _EGLSurface *surf = _eglLookupSurface(surface, disp);
+   _EGLDriver *drv;
+
+   _EGL_CHECK_SURFACE(disp, surf, EGL_FALSE, drv);
+   (void) drv;
+
+   if (!disp->Extensions.KHR_partial_update)
+      RETURN_EGL_EVAL(disp, EGL_FALSE);
+
+   if (_eglGetContextHandle(ctx) == EGL_NO_CONTEXT ||
+       surf != ctx->DrawSurface ||
+       surf->Type != EGL_WINDOW_BIT ||
+       surf->SwapBehavior != EGL_BUFFER_DESTROYED)
+      RETURN_EGL_ERROR(disp, EGL_BAD_MATCH, EGL_FALSE);
+
+   /* The region can only be set once per frame, after the buffer age has
+    * been queried.
+    */
+   if (surf->SetDamageRegionCalled || !surf->BufferAgeRead)
+      RETURN_EGL_ERROR(disp, EGL_BAD_ACCESS, EGL_FALSE);
+
+   if ((n_rects > 0 && rects == NULL) || n_rects < 0)
+      RETURN_EGL_ERROR(disp, EGL_BAD_PARAMETER, EGL_FALSE);
+
+   _eglSetDamageRegion(surf, rects, n_rects);
+
+   RETURN_EGL_SUCCESS(disp, EGL_TRUE);
+}
+
 EGLBoolean EGLAPIENTRY
 eglCopyBuffers(EGLDisplay dpy, EGLSurface surface, EGLNativePixmapType target)
 {
@@ -1797,6 +1853,71 @@ eglExportDMABUFImageMESA(EGLDisplay dpy, EGLImage image,
    RETURN_EGL_EVAL(disp, ret);
 }
 
+static EGLBoolean EGLAPIENTRY
+eglQueryDevicesEXT(EGLint max_devices, EGLDeviceEXT *devices,
+                   EGLint *num_devices)
+{
+   if (!num_devices || (devices && max_devices <= 0))
+      RETURN_EGL_ERROR(NULL, EGL_BAD_PARAMETER, EGL_FALSE);
+
+   *num_devices = _eglEnumerateDevices(max_devices, devices);
+
+   RETURN_EGL_SUCCESS(NULL, EGL_TRUE);
+}
+
+static const char * EGLAPIENTRY
+eglQueryDeviceStringEXT(EGLDeviceEXT device, EGLint name)
+{
+   _EGLDevice *dev = _eglLookupDevice(device);
+
+   if (!dev)
+      RETURN_EGL_ERROR(NULL, EGL_BAD_DEVICE_EXT, NULL);
+
+   switch (name) {
+   case EGL_EXTENSIONS:
+      RETURN_EGL_SUCCESS(NULL, "EGL_EXT_device_drm");
+   case EGL_DRM_DEVICE_FILE_EXT:
+      RETURN_EGL_SUCCESS(NULL, dev->Path);
+   default:
+      RETURN_EGL_ERROR(NULL, EGL_BAD_PARAMETER, NULL);
+   }
+}
+
+static EGLBoolean EGLAPIENTRY
+eglQueryDeviceAttribEXT(EGLDeviceEXT device, EGLint attribute,
+                        EGLAttrib *value)
+{
+   _EGLDevice *dev = _eglLookupDevice(device);
+
+   if (!dev)
+      RETURN_EGL_ERROR(NULL, EGL_BAD_DEVICE_EXT, EGL_FALSE);
+
+   /* None of the exposed device extensions defines an attribute. */
+   RETURN_EGL_ERROR(NULL, EGL_BAD_ATTRIBUTE, EGL_FALSE);
+}
+
+static EGLBoolean EGLAPIENTRY
+eglQueryDisplayAttribEXT(EGLDisplay dpy, EGLint attribute, EGLAttrib *value)
+{
+   _EGLDisplay *disp = _eglLockDisplay(dpy);
+
+   if (!disp)
+      RETURN_EGL_ERROR(NULL, EGL_BAD_DISPLAY, EGL_FALSE);
+
+   switch (attribute) {
+   case EGL_DEVICE_EXT:
+      /* Only displays created on a device know which one they use. */
+      if (disp->Platform != _EGL_PLATFORM_DEVICE)
+         RETURN_EGL_ERROR(disp, EGL_BAD_ATTRIBUTE, EGL_FALSE);
+      *value = (EGLAttrib) disp->PlatformDisplay;
+      break;
+   default:
+      RETURN_EGL_ERROR(disp, EGL_BAD_ATTRIBUTE, EGL_FALSE);
+   }
+
+   RETURN_EGL_SUCCESS(disp, EGL_TRUE);
+}
+
 __eglMustCastToProperFunctionPointerType EGLAPIENTRY
 eglGetProcAddress(const char *procname)
 {
@@ -1871,12 +1992,17 @@ eglGetProcAddress(const char *procname)
       { "eglCreateWaylandBufferFromImageWL", (_EGLProc) eglCreateWaylandBufferFromImageWL },
       { "eglPostSubBufferNV", (_EGLProc) eglPostSubBufferNV },
       { "eglSwapBuffersWithDamageEXT", (_EGLProc) eglSwapBuffersWithDamageEXT },
+      { "eglSetDamageRegionKHR", (_EGLProc) eglSetDamageRegionKHR },
       { "eglGetPlatformDisplayEXT", (_EGLProc) eglGetPlatformDisplayEXT },
       { "eglCreatePlatformWindowSurfaceEXT", (_EGLProc) eglCreatePlatformWindowSurfaceEXT },
       { "eglCreatePlatformPixmapSurfaceEXT", (_EGLProc) eglCreatePlatformPixmapSurfaceEXT },
       { "eglGetSyncValuesCHROMIUM", (_EGLProc) eglGetSyncValuesCHROMIUM },
       { "eglExportDMABUFImageQueryMESA", (_EGLProc) eglExportDMABUFImageQueryMESA },
       { "eglExportDMABUFImageMESA", (_EGLProc) eglExportDMABUFImageMESA },
+      { "eglQueryDevicesEXT", (_EGLProc) eglQueryDevicesEXT },
+      { "eglQueryDeviceStringEXT", (_EGLProc) eglQueryDeviceStringEXT },
+      { "eglQueryDeviceAttribEXT", (_EGLProc) eglQueryDeviceAttribEXT },
+      { "eglQueryDisplayAttribEXT", (_EGLProc) eglQueryDisplayAttribEXT },
       { NULL, NULL }
    };
    EGLint i;
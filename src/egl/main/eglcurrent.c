@@ -261,6 +261,9 @@ _eglError(EGLint errCode, const char *msg)
       case EGL_BAD_CURRENT_SURFACE:
          s = "EGL_BAD_CURRENT_SURFACE";
          break;
+      case EGL_BAD_DEVICE_EXT:
+         s = "EGL_BAD_DEVICE_EXT";
+         break;
       case EGL_BAD_DISPLAY:
          s = "EGL_BAD_DISPLAY";
          break;
@@ -0,0 +1,160 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Mesa contributors
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+
+/**
+ * Functions related to EGLDeviceEXT.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "c11/threads.h"
+
+#include "egldevice.h"
+#include "eglglobals.h"
+#include "egllog.h"
+
+
+#define _EGL_RENDER_NODE_PATH "/dev/dri/renderD%d"
+#define _EGL_RENDER_NODE_BASE 128
+#define _EGL_RENDER_NODE_COUNT 64
+
+
+/**
+ * Build the device list.  Called with the global mutex locked.
+ *
+ * Only nodes that exist are listed.  Whether a driver can be loaded for one
+ * is not known until a display is initialized on it.
+ */
+static void
+_eglProbeDevices(void)
+{
+   _EGLDevice **tail = &_eglGlobal.DeviceList;
+   int i;
+
+   for (i = 0; i < _EGL_RENDER_NODE_COUNT; i++) {
+      _EGLDevice *dev;
+      char *path;
+
+      if (asprintf(&path, _EGL_RENDER_NODE_PATH,
+                   _EGL_RENDER_NODE_BASE + i) < 0)
+         break;
+
+      if (access(path, R_OK | W_OK) != 0) {
+         free(path);
+         continue;
+      }
+
+      dev = calloc(1, sizeof(*dev));
+      if (!dev) {
+         free(path);
+         break;
+      }
+
+      _eglLog(_EGL_DEBUG, "found device %s", path);
+      dev->Path = path;
+      *tail = dev;
+      tail = &dev->Next;
+   }
+
+   _eglGlobal.DevicesProbed = EGL_TRUE;
+}
+
+
+/**
+ * Finish device management.
+ */
+void
+_eglFiniDevice(void)
+{
+   _EGLDevice *devList, *dev;
+
+   /* atexit function is called with global mutex locked */
+   devList = _eglGlobal.DeviceList;
+   while (devList) {
+      /* pop list head */
+      dev = devList;
+      devList = devList->Next;
+
+      free(dev->Path);
+      free(dev);
+   }
+   _eglGlobal.DeviceList = NULL;
+   _eglGlobal.DevicesProbed = EGL_FALSE;
+}
+
+
+/**
+ * Return the number of devices.  When devices is not NULL, also store up to
+ * max_devices of them there.
+ */
+EGLint
+_eglEnumerateDevices(EGLint max_devices, EGLDeviceEXT *devices)
+{
+   _EGLDevice *dev;
+   EGLint count = 0;
+
+   mtx_lock(_eglGlobal.Mutex);
+
+   if (!_eglGlobal.DevicesProbed)
+      _eglProbeDevices();
+
+   for (dev = _eglGlobal.DeviceList; dev; dev = dev->Next) {
+      if (devices) {
+         if (count >= max_devices)
+            break;
+         devices[count] = _eglGetDeviceHandle(dev);
+      }
+      count++;
+   }
+
+   mtx_unlock(_eglGlobal.Mutex);
+
+   return count;
+}
+
+
+/**
+ * Return the device of a handle, or NULL if the handle is not one returned
+ * by eglQueryDevicesEXT.
+ */
+_EGLDevice *
+_eglLookupDevice(EGLDeviceEXT device)
+{
+   _EGLDevice *dev;
+
+   mtx_lock(_eglGlobal.Mutex);
+   for (dev = _eglGlobal.DeviceList; dev; dev = dev->Next) {
+      if (_eglGetDeviceHandle(dev) == device)
+         break;
+   }
+   mtx_unlock(_eglGlobal.Mutex);
+
+   return dev;
+}
@@ -0,0 +1,79 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Mesa contributors
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+
+#ifndef EGLDEVICE_INCLUDED
+#define EGLDEVICE_INCLUDED
+
+
+#include "egltypedefs.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A DRM render node, as exposed by EGL_EXT_device_enumeration.
+ *
+ * Devices are probed once and live until the library is unloaded, so the
+ * handles handed out to the application never dangle.
+ */
+struct _egl_device
+{
+   _EGLDevice *Next;
+
+   /* path of the render node, for EGL_DRM_DEVICE_FILE_EXT */
+   char *Path;
+};
+
+
+extern void
+_eglFiniDevice(void);
+
+
+extern EGLint
+_eglEnumerateDevices(EGLint max_devices, EGLDeviceEXT *devices);
+
+
+extern _EGLDevice *
+_eglLookupDevice(EGLDeviceEXT device);
+
+
+static inline EGLDeviceEXT
+_eglGetDeviceHandle(_EGLDevice *dev)
+{
+   return (EGLDeviceEXT) dev;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EGLDEVICE_INCLUDED */
@@ -71,6 +71,7 @@ static const struct {
    { _EGL_PLATFORM_ANDROID, "android" },
    { _EGL_PLATFORM_HAIKU, "haiku" },
    { _EGL_PLATFORM_SURFACELESS, "surfaceless" },
+   { _EGL_PLATFORM_DEVICE, "device" },
 };
 
 
@@ -519,3 +520,16 @@ _eglGetWaylandDisplay(struct wl_display *native_display,
    return _eglFindDisplay(_EGL_PLATFORM_WAYLAND, native_display);
 }
 #endif /* HAVE_WAYLAND_PLATFORM */
+
+_EGLDisplay*
+_eglGetDeviceDisplay(_EGLDevice *dev, const EGLint *attrib_list)
+{
+   /* EGL_EXT_platform_device recognizes no attributes. */
+   if (attrib_list != NULL && attrib_list[0] != EGL_NONE) {
+      _eglError(EGL_BAD_ATTRIBUTE, "eglGetPlatformDisplay");
+      return NULL;
+   }
+
+   /* One display per device, so that each GPU gets its own driver screen. */
+   return _eglFindDisplay(_EGL_PLATFORM_DEVICE, dev);
+}
@@ -33,6 +33,7 @@
 #include "c11/threads.h"
 
 #include "eglglobals.h"
+#include "egldevice.h"
 #include "egldisplay.h"
 #include "egldriver.h"
 
@@ -43,16 +44,23 @@ struct _egl_global _eglGlobal =
 {
    &_eglGlobalMutex,       /* Mutex */
    NULL,                   /* DisplayList */
-   2,                      /* NumAtExitCalls */
+   NULL,                   /* DeviceList */
+   EGL_FALSE,              /* DevicesProbed */
+   3,                      /* NumAtExitCalls */
    {
       /* default AtExitCalls, called in reverse order */
       _eglUnloadDrivers, /* always called last */
+      _eglFiniDevice,
       _eglFiniDisplay
    },
 
    /* ClientExtensionsString */
    "EGL_EXT_client_extensions"
+   " EGL_EXT_device_base"
+   " EGL_EXT_device_enumeration"
+   " EGL_EXT_device_query"
    " EGL_EXT_platform_base"
+   " EGL_EXT_platform_device"
    " EGL_EXT_platform_wayland"
    " EGL_EXT_platform_x11"
    " EGL_KHR_client_get_all_proc_addresses"
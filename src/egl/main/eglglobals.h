@@ -47,6 +47,10 @@ struct _egl_global
    /* the list of all displays */
    _EGLDisplay *DisplayList;
 
+   /* the list of all devices, probed on first use */
+   _EGLDevice *DeviceList;
+   EGLBoolean DevicesProbed;
+
    EGLint NumAtExitCalls;
    void (*AtExitCalls[10])(void);
 
@@ -45,6 +45,10 @@
 #include "eglsurface.h"
 
 
+#define MIN2(A, B)  (((A) < (B)) ? (A) : (B))
+#define MAX2(A, B)  (((A) > (B)) ? (A) : (B))
+
+
 static void
 _eglClampSwapInterval(_EGLSurface *surf, EGLint interval)
 {
@@ -300,6 +304,9 @@ _eglInitSurface(_EGLSurface *surf, _EGLDisplay *dpy, EGLint type,
 
    surf->PostSubBufferSupportedNV = EGL_FALSE;
 
+   surf->BufferAgeRead = EGL_FALSE;
+   surf->SetDamageRegionCalled = EGL_FALSE;
+
    /* the default swap interval is 1 */
    _eglClampSwapInterval(surf, 1);
 
@@ -381,11 +388,13 @@ _eglQuerySurface(_EGLDriver *drv, _EGLDisplay *dpy, _EGLSurface *surface,
       *value = surface->PostSubBufferSupportedNV;
       break;
    case EGL_BUFFER_AGE_EXT:
-      if (!dpy->Extensions.EXT_buffer_age) {
+      if (!dpy->Extensions.EXT_buffer_age &&
+          !dpy->Extensions.KHR_partial_update) {
          _eglError(EGL_BAD_ATTRIBUTE, "eglQuerySurface");
          return EGL_FALSE;
       }
       *value = drv->API.QueryBufferAge(drv, dpy, surface);
+      surface->BufferAgeRead = EGL_TRUE;
       break;
    default:
       _eglError(EGL_BAD_ATTRIBUTE, "eglQuerySurface");
@@ -513,6 +522,43 @@ _eglReleaseTexImage(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *surf,
 }
 
 
+/**
+ * Record the EGL_KHR_partial_update damage region of the current frame.
+ * Only the bounding box of the rectangles is kept, clamped to the surface;
+ * an empty list means the whole surface.
+ */
+void
+_eglSetDamageRegion(_EGLSurface *surf, const EGLint *rects, EGLint n_rects)
+{
+   EGLint x1 = surf->Width, y1 = surf->Height, x2 = 0, y2 = 0;
+   EGLint i;
+
+   if (n_rects == 0) {
+      x1 = y1 = 0;
+      x2 = surf->Width;
+      y2 = surf->Height;
+   }
+
+   for (i = 0; i < n_rects; i++) {
+      const EGLint *rect = &rects[i * 4];
+
+      x1 = MIN2(x1, MAX2(rect[0], 0));
+      y1 = MIN2(y1, MAX2(rect[1], 0));
+      x2 = MAX2(x2, MIN2(rect[0] + rect[2], surf->Width));
+      y2 = MAX2(y2, MIN2(rect[1] + rect[3], surf->Height));
+   }
+
+   if (x2 <= x1 || y2 <= y1)
+      x1 = y1 = x2 = y2 = 0;
+
+   surf->DamageRegion[0] = x1;
+   surf->DamageRegion[1] = y1;
+   surf->DamageRegion[2] = x2 - x1;
+   surf->DamageRegion[3] = y2 - y1;
+   surf->SetDamageRegionCalled = EGL_TRUE;
+}
+
+
 EGLBoolean
 _eglSwapInterval(_EGLDriver *drv, _EGLDisplay *dpy, _EGLSurface *surf,
                  EGLint interval)
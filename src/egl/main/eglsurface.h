@@ -81,6 +81,14 @@ struct _egl_surface
    EGLBoolean BoundToTexture;
 
    EGLBoolean PostSubBufferSupportedNV;
+
+   /* EGL_KHR_partial_update state, reset on every swap */
+   EGLBoolean BufferAgeRead;
+   EGLBoolean SetDamageRegionCalled;
+   /* Bounding box (x, y, width, height) of the damage region, with the
+    * origin at the bottom left like swap damage rectangles.
+    */
+   EGLint DamageRegion[4];
 };
 
 
@@ -104,6 +112,10 @@ extern EGLBoolean
 _eglReleaseTexImage(_EGLDriver *drv, _EGLDisplay *disp, _EGLSurface *surf, EGLint buffer);
 
 
+extern void
+_eglSetDamageRegion(_EGLSurface *surf, const EGLint *rects, EGLint n_rects);
+
+
 extern EGLBoolean
 _eglSwapInterval(_EGLDriver *drv, _EGLDisplay *dpy, _EGLSurface *surf, EGLint interval);
 
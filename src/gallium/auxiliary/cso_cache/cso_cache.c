@@ -29,6 +29,7 @@
  */
 
 #include "util/u_debug.h"
+#include "util/hash64.h"
 
 #include "util/u_memory.h"
 
@@ -42,38 +43,17 @@ struct cso_cache {
 
    cso_sanitize_callback sanitize_cb;
    void                 *sanitize_data;
+
+   struct cso_cache_stats stats;
 };
 
-#if 1
+/* Hash the whole key: cheaper schemes like XORing its words collide as soon
+ * as two states differ by swapped field values.
+ */
 static unsigned hash_key(const void *key, unsigned key_size)
 {
-   unsigned *ikey = (unsigned *)key;
-   unsigned hash = 0, i;
-
-   assert(key_size % 4 == 0);
-
-   /* I'm sure this can be improved on:
-    */
-   for (i = 0; i < key_size/4; i++)
-      hash ^= ikey[i];
-
-   return hash;
+   return _mesa_hash64_fold(_mesa_hash64_data(key, key_size, 0));
 }
-#else
-static unsigned hash_key(const unsigned char *p, int n)
-{
-   unsigned h = 0;
-   unsigned g;
-
-   while (n--) {
-      h = (h << 4) + *p++;
-      if ((g = (h & 0xf0000000)) != 0)
-         h ^= g >> 23;
-      h &= ~g;
-   }
-   return h;
-}
-#endif
 
 unsigned cso_construct_key(void *item, int item_size)
 {
@@ -229,10 +209,14 @@ struct cso_hash_iter cso_find_state_template(struct cso_cache *sc,
    struct cso_hash_iter iter = cso_find_state(sc, hash_key, type);
    while (!cso_hash_iter_is_null(iter)) {
       void *iter_data = cso_hash_iter_data(iter);
-      if (!memcmp(iter_data, templ, size))
+      if (!memcmp(iter_data, templ, size)) {
+         sc->stats.hits++;
          return iter;
+      }
+      sc->stats.collisions++;
       iter = cso_hash_iter_next(iter);
    }
+   sc->stats.misses++;
    return iter;
 }
 
@@ -257,6 +241,8 @@ struct cso_cache *cso_cache_create(void)
    sc->sanitize_cb        = sanitize_cb;
    sc->sanitize_data      = 0;
 
+   memset(&sc->stats, 0, sizeof(sc->stats));
+
    return sc;
 }
 
@@ -312,6 +298,12 @@ int cso_maximum_cache_size(const struct cso_cache *sc)
    return sc->max_size;
 }
 
+void cso_cache_get_stats(const struct cso_cache *sc,
+                         struct cso_cache_stats *stats)
+{
+   *stats = sc->stats;
+}
+
 void cso_cache_set_sanitize_callback(struct cso_cache *sc,
                                      cso_sanitize_callback cb,
                                      void *user_data)
@@ -103,6 +103,14 @@ typedef void (*cso_sanitize_callback)(struct cso_hash *hash,
 
 struct cso_cache;
 
+/** Counts of state lookups, for the HUD. */
+struct cso_cache_stats {
+   uint64_t hits;       /**< lookups that found the state in the cache */
+   uint64_t misses;     /**< lookups that had to create the state */
+   uint64_t collisions; /**< other states with the same hash compared */
+   uint64_t skips;      /**< sets of the bound state that needed no lookup */
+};
+
 struct cso_blend {
    struct pipe_blend_state state;
    void *data;
@@ -168,6 +176,9 @@ void * cso_take_state(struct cso_cache *sc, unsigned hash_key,
 void cso_set_maximum_cache_size(struct cso_cache *sc, int number);
 int cso_maximum_cache_size(const struct cso_cache *sc);
 
+void cso_cache_get_stats(const struct cso_cache *sc,
+                         struct cso_cache_stats *stats);
+
 #ifdef	__cplusplus
 }
 #endif
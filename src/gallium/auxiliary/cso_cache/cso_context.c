@@ -45,6 +45,7 @@
 #include "tgsi/tgsi_parse.h"
 
 #include "cso_cache/cso_context.h"
+#include "hud/hud_counters.h"
 #include "cso_cache/cso_cache.h"
 #include "cso_cache/cso_hash.h"
 #include "cso_context.h"
@@ -108,6 +109,16 @@ struct cso_context {
    void *tesseval_shader, *tesseval_shader_saved;
    void *velements, *velements_saved;
    struct pipe_query *render_condition, *render_condition_saved;
+
+   /** The cache entries of the bound blend, DSA and rasterizer states,
+    * so that setting the same state again doesn't need a lookup.
+    * NULL if the bound state didn't come from cso_set_*.
+    */
+   const struct cso_blend *blend_cso;
+   const struct cso_depth_stencil_alpha *depth_stencil_cso;
+   const struct cso_rasterizer *rasterizer_cso;
+   uint64_t skipped_lookups;
+
    uint render_condition_mode, render_condition_mode_saved;
    boolean render_condition_cond, render_condition_cond_saved;
 
@@ -127,6 +138,8 @@ static boolean delete_blend_state(struct cso_context *ctx, void *state)
    if (ctx->blend == cso->data)
       return FALSE;
 
+   if (ctx->blend_cso == cso)
+      ctx->blend_cso = NULL;
    if (cso->delete_state)
       cso->delete_state(cso->context, cso->data);
    FREE(state);
@@ -141,6 +154,8 @@ static boolean delete_depth_stencil_state(struct cso_context *ctx, void *state)
    if (ctx->depth_stencil == cso->data)
       return FALSE;
 
+   if (ctx->depth_stencil_cso == cso)
+      ctx->depth_stencil_cso = NULL;
    if (cso->delete_state)
       cso->delete_state(cso->context, cso->data);
    FREE(state);
@@ -163,6 +178,8 @@ static boolean delete_rasterizer_state(struct cso_context *ctx, void *state)
 
    if (ctx->rasterizer == cso->data)
       return FALSE;
+   if (ctx->rasterizer_cso == cso)
+      ctx->rasterizer_cso = NULL;
    if (cso->delete_state)
       cso->delete_state(cso->context, cso->data);
    FREE(state);
@@ -371,6 +388,18 @@ void cso_destroy_context( struct cso_context *ctx )
 }
 
 
+/**
+ * Return the lookup counts of the state cache, for the HUD.
+ */
+void
+cso_get_cache_stats(const struct cso_context *ctx,
+                    struct cso_cache_stats *stats)
+{
+   cso_cache_get_stats(ctx->cache, stats);
+   stats->skips = ctx->skipped_lookups;
+}
+
+
 /* Those function will either find the state of the given template
  * in the cache or they will create a new state from the given
  * template, insert it in the cache and return it.
@@ -386,17 +415,27 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
 {
    unsigned key_size, hash_key;
    struct cso_hash_iter iter;
-   void *handle;
+   struct cso_blend *cso;
 
    key_size = templ->independent_blend_enable ?
       sizeof(struct pipe_blend_state) :
       (char *)&(templ->rt[1]) - (char *)templ;
+
+   /* State trackers tend to set the same state over and over.  The bound
+    * state can't be evicted from the cache, so comparing with it is enough.
+    */
+   if (ctx->blend_cso && ctx->blend == ctx->blend_cso->data &&
+       memcmp(&ctx->blend_cso->state, templ, key_size) == 0) {
+      ctx->skipped_lookups++;
+      return PIPE_OK;
+   }
+
    hash_key = cso_construct_key((void*)templ, key_size);
    iter = cso_find_state_template(ctx->cache, hash_key, CSO_BLEND,
                                   (void*)templ, key_size);
 
    if (cso_hash_iter_is_null(iter)) {
-      struct cso_blend *cso = MALLOC(sizeof(struct cso_blend));
+      cso = MALLOC(sizeof(struct cso_blend));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -411,16 +450,15 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
    }
    else {
-      handle = ((struct cso_blend *)cso_hash_iter_data(iter))->data;
+      cso = (struct cso_blend *)cso_hash_iter_data(iter);
    }
 
-   if (ctx->blend != handle) {
-      ctx->blend = handle;
-      ctx->pipe->bind_blend_state(ctx->pipe, handle);
+   ctx->blend_cso = cso;
+   if (ctx->blend != cso->data) {
+      ctx->blend = cso->data;
+      ctx->pipe->bind_blend_state(ctx->pipe, cso->data);
    }
    return PIPE_OK;
 }
@@ -447,16 +485,24 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
                             const struct pipe_depth_stencil_alpha_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_depth_stencil_alpha_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_DEPTH_STENCIL_ALPHA,
-                                                       (void*)templ, key_size);
-   void *handle;
+   unsigned hash_key;
+   struct cso_hash_iter iter;
+   struct cso_depth_stencil_alpha *cso;
+
+   if (ctx->depth_stencil_cso &&
+       ctx->depth_stencil == ctx->depth_stencil_cso->data &&
+       memcmp(&ctx->depth_stencil_cso->state, templ, key_size) == 0) {
+      ctx->skipped_lookups++;
+      return PIPE_OK;
+   }
+
+   hash_key = cso_construct_key((void*)templ, key_size);
+   iter = cso_find_state_template(ctx->cache, hash_key,
+                                  CSO_DEPTH_STENCIL_ALPHA,
+                                  (void*)templ, key_size);
 
    if (cso_hash_iter_is_null(iter)) {
-      struct cso_depth_stencil_alpha *cso =
-         MALLOC(sizeof(struct cso_depth_stencil_alpha));
+      cso = MALLOC(sizeof(struct cso_depth_stencil_alpha));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -473,17 +519,15 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
    }
    else {
-      handle = ((struct cso_depth_stencil_alpha *)
-                cso_hash_iter_data(iter))->data;
+      cso = (struct cso_depth_stencil_alpha *)cso_hash_iter_data(iter);
    }
 
-   if (ctx->depth_stencil != handle) {
-      ctx->depth_stencil = handle;
-      ctx->pipe->bind_depth_stencil_alpha_state(ctx->pipe, handle);
+   ctx->depth_stencil_cso = cso;
+   if (ctx->depth_stencil != cso->data) {
+      ctx->depth_stencil = cso->data;
+      ctx->pipe->bind_depth_stencil_alpha_state(ctx->pipe, cso->data);
    }
    return PIPE_OK;
 }
@@ -510,15 +554,22 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
                                    const struct pipe_rasterizer_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_rasterizer_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_RASTERIZER,
-                                                       (void*)templ, key_size);
-   void *handle = NULL;
+   unsigned hash_key;
+   struct cso_hash_iter iter;
+   struct cso_rasterizer *cso;
+
+   if (ctx->rasterizer_cso && ctx->rasterizer == ctx->rasterizer_cso->data &&
+       memcmp(&ctx->rasterizer_cso->state, templ, key_size) == 0) {
+      ctx->skipped_lookups++;
+      return PIPE_OK;
+   }
+
+   hash_key = cso_construct_key((void*)templ, key_size);
+   iter = cso_find_state_template(ctx->cache, hash_key, CSO_RASTERIZER,
+                                  (void*)templ, key_size);
 
    if (cso_hash_iter_is_null(iter)) {
-      struct cso_rasterizer *cso = MALLOC(sizeof(struct cso_rasterizer));
+      cso = MALLOC(sizeof(struct cso_rasterizer));
       if (!cso)
          return PIPE_ERROR_OUT_OF_MEMORY;
 
@@ -533,16 +584,15 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
          FREE(cso);
          return PIPE_ERROR_OUT_OF_MEMORY;
       }
-
-      handle = cso->data;
    }
    else {
-      handle = ((struct cso_rasterizer *)cso_hash_iter_data(iter))->data;
+      cso = (struct cso_rasterizer *)cso_hash_iter_data(iter);
    }
 
-   if (ctx->rasterizer != handle) {
-      ctx->rasterizer = handle;
-      ctx->pipe->bind_rasterizer_state(ctx->pipe, handle);
+   ctx->rasterizer_cso = cso;
+   if (ctx->rasterizer != cso->data) {
+      ctx->rasterizer = cso->data;
+      ctx->pipe->bind_rasterizer_state(ctx->pipe, cso->data);
    }
    return PIPE_OK;
 }
@@ -1423,6 +1473,7 @@ cso_draw_vbo(struct cso_context *cso,
              const struct pipe_draw_info *info)
 {
    struct u_vbuf *vbuf = cso->vbuf;
+   int64_t start = hud_counter_begin_time();
 
    if (vbuf) {
       u_vbuf_draw_vbo(vbuf, info);
@@ -1430,6 +1481,33 @@ cso_draw_vbo(struct cso_context *cso,
       struct pipe_context *pipe = cso->pipe;
       pipe->draw_vbo(pipe, info);
    }
+
+   hud_counter_end_time(HUD_COUNTER_DRAW_TIME, start);
+}
+
+/**
+ * Draw num_draws primitives with the same state, in one call to the driver
+ * if it supports that.
+ */
+void
+cso_draw_vbo_multi(struct cso_context *cso,
+                   const struct pipe_draw_info *info,
+                   unsigned num_draws)
+{
+   struct pipe_context *pipe = cso->pipe;
+   unsigned i;
+
+   /* u_vbuf may have to translate vertex buffers differently per draw. */
+   if (cso->vbuf || !pipe->draw_vbo_multi) {
+      for (i = 0; i < num_draws; i++)
+         cso_draw_vbo(cso, &info[i]);
+   } else {
+      int64_t start = hud_counter_begin_time();
+
+      pipe->draw_vbo_multi(pipe, info, num_draws);
+
+      hud_counter_end_time(HUD_COUNTER_DRAW_TIME, start);
+   }
 }
 
 void
@@ -39,11 +39,15 @@ extern "C" {
 #endif
 
 struct cso_context;
+struct cso_cache_stats;
 struct u_vbuf;
 
 struct cso_context *cso_create_context( struct pipe_context *pipe );
 void cso_destroy_context( struct cso_context *cso );
 
+void cso_get_cache_stats(const struct cso_context *cso,
+                         struct cso_cache_stats *stats);
+
 
 enum pipe_error cso_set_blend( struct cso_context *cso,
                                const struct pipe_blend_state *blend );
@@ -225,6 +229,11 @@ void
 cso_draw_vbo(struct cso_context *cso,
              const struct pipe_draw_info *info);
 
+void
+cso_draw_vbo_multi(struct cso_context *cso,
+                   const struct pipe_draw_info *info,
+                   unsigned num_draws);
+
 void
 cso_draw_arrays_instanced(struct cso_context *cso, uint mode,
                           uint start, uint count,
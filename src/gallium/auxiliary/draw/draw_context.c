@@ -523,6 +523,23 @@ draw_enable_point_sprites(struct draw_context *draw, boolean enable)
 }
 
 
+/**
+ * Sets the number of entries of the cache of fetched vertices used when
+ * splitting indexed draws.  Vertices found in the cache are shaded once
+ * and referenced again through the indices handed to the backend, so
+ * drivers doing vertex processing in software on large vertex buffers
+ * benefit from a cache bigger than the default.  The size is rounded to a
+ * power of two; the DRAW_VERTEX_CACHE_SIZE environment variable, if set,
+ * takes precedence.
+ */
+void
+draw_set_vertex_cache_size(struct draw_context *draw, unsigned size)
+{
+   draw_do_flush( draw, DRAW_FLUSH_STATE_CHANGE );
+   draw->pt.vertex_cache_size = size;
+}
+
+
 void
 draw_set_force_passthrough( struct draw_context *draw, boolean enable )
 {
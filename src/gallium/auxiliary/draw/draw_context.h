@@ -115,6 +115,8 @@ void draw_enable_line_stipple(struct draw_context *draw, boolean enable);
 
 void draw_enable_point_sprites(struct draw_context *draw, boolean enable);
 
+void draw_set_vertex_cache_size(struct draw_context *draw, unsigned size);
+
 void draw_set_zs_format(struct draw_context *draw, enum pipe_format format);
 
 boolean
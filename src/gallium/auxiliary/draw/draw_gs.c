@@ -685,9 +685,9 @@ void draw_geometry_shader_prepare(struct draw_geometry_shader *shader,
 {
    boolean use_llvm = draw->llvm != NULL;
    if (!use_llvm && shader && shader->machine->Tokens != shader->state.tokens) {
-      tgsi_exec_machine_bind_shader(shader->machine,
-                                    shader->state.tokens,
-                                    draw->gs.tgsi.sampler);
+      tgsi_exec_machine_bind_exec_shader(shader->machine,
+                                         shader->exec_shader,
+                                         draw->gs.tgsi.sampler);
    }
 }
 
@@ -818,6 +818,15 @@ draw_create_geometry_shader(struct draw_context *draw,
 
    gs->machine = draw->gs.tgsi.machine;
 
+   if (!draw->llvm) {
+      gs->exec_shader = tgsi_exec_shader_create(gs->state.tokens);
+      if (!gs->exec_shader) {
+         FREE((void*) gs->state.tokens);
+         FREE(gs);
+         return NULL;
+      }
+   }
+
 #ifdef HAVE_LLVM
    if (use_llvm) {
       int vector_size = gs->vector_length * sizeof(float);
@@ -905,6 +914,12 @@ void draw_delete_geometry_shader(struct draw_context *draw,
    }
 #endif
 
+   if (dgs->exec_shader) {
+      if (dgs->machine->Tokens == dgs->state.tokens)
+         tgsi_exec_machine_bind_exec_shader(dgs->machine, NULL, NULL);
+      tgsi_exec_shader_destroy(dgs->exec_shader);
+   }
+
    FREE(dgs->primitive_lengths);
    FREE((void*) dgs->state.tokens);
    FREE(dgs);
@@ -60,6 +60,7 @@ struct draw_geometry_shader {
    struct draw_context *draw;
 
    struct tgsi_exec_machine *machine;
+   struct tgsi_exec_shader *exec_shader; /**< decoded once for the machine */
 
    /* This member will disappear shortly:*/
    struct pipe_shader_state state;
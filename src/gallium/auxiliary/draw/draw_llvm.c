@@ -51,6 +51,7 @@
 #include "tgsi/tgsi_exec.h"
 #include "tgsi/tgsi_dump.h"
 
+#include "util/u_atomic.h"
 #include "util/u_math.h"
 #include "util/u_pointer.h"
 #include "util/u_string.h"
@@ -497,6 +498,9 @@ draw_llvm_create(struct draw_context *draw, LLVMContextRef context)
 
    llvm->draw = draw;
 
+   /* Without compile threads shaders just get compiled while drawing. */
+   gallivm_start_compile_threads();
+
    llvm->context = context;
    if (!llvm->context) {
       llvm->context = LLVMContextCreate();
@@ -529,11 +533,73 @@ draw_llvm_destroy(struct draw_llvm *llvm)
       LLVMContextDispose(llvm->context);
    llvm->context = NULL;
 
+   gallivm_stop_compile_threads();
+
    /* XXX free other draw_llvm data? */
    FREE(llvm);
 }
 
 
+/**
+ * Build the IR of a vertex shader variant in variant->gallivm.
+ */
+static void
+draw_llvm_generate_variant(struct draw_llvm *llvm,
+                           struct draw_llvm_variant *variant,
+                           unsigned num_inputs)
+{
+   LLVMTypeRef vertex_header;
+
+   create_jit_types(variant);
+
+   vertex_header = create_jit_vertex_header(variant->gallivm, num_inputs);
+
+   variant->vertex_header_ptr_type = LLVMPointerType(vertex_header, 0);
+
+   draw_llvm_generate(llvm, variant, FALSE);  /* linear */
+   draw_llvm_generate(llvm, variant, TRUE);   /* elts */
+}
+
+
+/**
+ * Called on the compile thread once the optimized build is compiled.
+ */
+static void
+draw_llvm_variant_compiled(struct gallivm_state *gallivm, void *data)
+{
+   struct draw_llvm_variant *variant = data;
+
+   variant->opt_jit_func = (draw_jit_vert_func)
+         gallivm_jit_function(gallivm, variant->opt_function);
+
+   variant->opt_jit_func_elts = (draw_jit_vert_func_elts)
+         gallivm_jit_function(gallivm, variant->opt_function_elts);
+
+   gallivm_free_ir(gallivm);
+
+   /* Also a barrier, so the functions are seen before opt_done. */
+   p_atomic_inc(&variant->opt_done);
+}
+
+
+/**
+ * Switch the variant over to its optimized build if it's done compiling.
+ */
+void
+draw_llvm_update_variant(struct draw_llvm_variant *variant)
+{
+   if (!variant->opt_gallivm || !p_atomic_read(&variant->opt_done))
+      return;
+
+   variant->jit_func = variant->opt_jit_func;
+   variant->jit_func_elts = variant->opt_jit_func_elts;
+
+   gallivm_destroy(variant->gallivm);
+   variant->gallivm = variant->opt_gallivm;
+   variant->opt_gallivm = NULL;
+}
+
+
 /**
  * Create LLVM-generated code for a vertex shader.
  */
@@ -545,12 +611,11 @@ draw_llvm_create_variant(struct draw_llvm *llvm,
    struct draw_llvm_variant *variant;
    struct llvm_vertex_shader *shader =
       llvm_vertex_shader(llvm->draw->vs.vertex_shader);
-   LLVMTypeRef vertex_header;
    char module_name[64];
 
-   variant = MALLOC(sizeof *variant +
-                    shader->variant_key_size -
-                    sizeof variant->key);
+   variant = CALLOC(1, sizeof *variant +
+                       shader->variant_key_size -
+                       sizeof variant->key);
    if (!variant)
       return NULL;
 
@@ -560,10 +625,6 @@ draw_llvm_create_variant(struct draw_llvm *llvm,
    util_snprintf(module_name, sizeof(module_name), "draw_llvm_vs_variant%u",
                  variant->shader->variants_cached);
 
-   variant->gallivm = gallivm_create(module_name, llvm->context);
-
-   create_jit_types(variant);
-
    memcpy(&variant->key, key, shader->variant_key_size);
 
    if (gallivm_debug & (GALLIVM_DEBUG_TGSI | GALLIVM_DEBUG_IR)) {
@@ -571,12 +632,28 @@ draw_llvm_create_variant(struct draw_llvm *llvm,
       draw_llvm_dump_variant_key(&variant->key);
    }
 
-   vertex_header = create_jit_vertex_header(variant->gallivm, num_inputs);
-
-   variant->vertex_header_ptr_type = LLVMPointerType(vertex_header, 0);
-
-   draw_llvm_generate(llvm, variant, FALSE);  /* linear */
-   draw_llvm_generate(llvm, variant, TRUE);   /* elts */
+   /*
+    * Build the optimized code in a context of its own, so that it can be
+    * compiled in the background if it's big, and make do with an
+    * unoptimized build meanwhile.
+    */
+   variant->gallivm = gallivm_create(module_name, NULL, NULL);
+   draw_llvm_generate_variant(llvm, variant, num_inputs);
+
+   if (gallivm_compile_module_async(variant->gallivm,
+                                    draw_llvm_variant_compiled, variant)) {
+      variant->opt_gallivm = variant->gallivm;
+      variant->opt_function = variant->function;
+      variant->opt_function_elts = variant->function_elts;
+
+      util_snprintf(module_name, sizeof(module_name),
+                    "draw_llvm_vs_variant%u_fast",
+                    variant->shader->variants_cached);
+
+      variant->gallivm = gallivm_create(module_name, llvm->context, NULL);
+      variant->gallivm->no_opt = TRUE;
+      draw_llvm_generate_variant(llvm, variant, num_inputs);
+   }
 
    gallivm_compile_module(variant->gallivm);
 
@@ -628,6 +705,7 @@ generate_vs(struct draw_llvm_variant *variant,
                      NULL,
                      draw_sampler,
                      &llvm->draw->vs.vertex_shader->info,
+                     NULL,
                      NULL);
 
    {
@@ -2034,6 +2112,9 @@ draw_llvm_destroy_variant(struct draw_llvm_variant *variant)
 {
    struct draw_llvm *llvm = variant->llvm;
 
+   /* This waits for the compile thread to be done with it. */
+   if (variant->opt_gallivm)
+      gallivm_destroy(variant->opt_gallivm);
    gallivm_destroy(variant->gallivm);
 
    remove_from_list(&variant->list_item_local);
@@ -2230,7 +2311,8 @@ draw_gs_llvm_generate(struct draw_llvm *llvm,
                      NULL,
                      sampler,
                      &llvm->draw->gs.geometry_shader->info,
-                     (const struct lp_build_tgsi_gs_iface *)&gs_iface);
+                     (const struct lp_build_tgsi_gs_iface *)&gs_iface,
+                     NULL);
 
    sampler->destroy(sampler);
 
@@ -2265,7 +2347,7 @@ draw_gs_llvm_create_variant(struct draw_llvm *llvm,
    util_snprintf(module_name, sizeof(module_name), "draw_llvm_gs_variant%u",
                  variant->shader->variants_cached);
 
-   variant->gallivm = gallivm_create(module_name, llvm->context);
+   variant->gallivm = gallivm_create(module_name, llvm->context, NULL);
 
    create_gs_jit_types(variant);
 
@@ -400,6 +400,17 @@ struct draw_llvm_variant
    draw_jit_vert_func jit_func;
    draw_jit_vert_func_elts jit_func_elts;
 
+   /**
+    * Optimized build being compiled in the background, which replaces the
+    * above once done, see draw_llvm_update_variant().
+    */
+   struct gallivm_state *opt_gallivm;
+   LLVMValueRef opt_function;
+   LLVMValueRef opt_function_elts;
+   draw_jit_vert_func opt_jit_func;
+   draw_jit_vert_func_elts opt_jit_func_elts;
+   int opt_done;
+
    struct llvm_vertex_shader *shader;
 
    struct draw_llvm *llvm;
@@ -501,6 +512,9 @@ draw_llvm_create_variant(struct draw_llvm *llvm,
 void
 draw_llvm_destroy_variant(struct draw_llvm_variant *variant);
 
+void
+draw_llvm_update_variant(struct draw_llvm_variant *variant);
+
 struct draw_llvm_variant_key *
 draw_llvm_make_variant_key(struct draw_llvm *llvm, char *store);
 
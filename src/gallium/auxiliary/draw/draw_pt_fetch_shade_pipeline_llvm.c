@@ -25,9 +25,11 @@
  *
  **************************************************************************/
 
+#include "util/u_debug.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
+#include "util/u_queue.h"
 #include "draw/draw_context.h"
 #include "draw/draw_gs.h"
 #include "draw/draw_vbuf.h"
@@ -39,6 +41,28 @@
 #include "gallivm/lp_bld_init.h"
 
 
+/* Vertex shading of a draw is split between DRAW_VS_THREADS worker threads
+ * and the calling thread, as long as each of them gets at least
+ * LLVM_VS_MIN_VERTICES_PER_THREAD vertices.  0 threads, the default, shades
+ * everything on the calling thread.
+ */
+#define LLVM_VS_MAX_THREADS 16
+#define LLVM_VS_MIN_VERTICES_PER_THREAD 128
+
+DEBUG_GET_ONCE_NUM_OPTION(draw_vs_threads, "DRAW_VS_THREADS", 0)
+
+struct llvm_middle_end;
+
+struct llvm_vs_job {
+   struct llvm_middle_end *fpme;
+   const struct draw_fetch_info *fetch_info;
+   struct vertex_header *verts;
+   unsigned start;
+   unsigned count;
+   unsigned clipped;
+   struct util_queue_fence fence;
+};
+
 struct llvm_middle_end {
    struct draw_pt_middle_end base;
    struct draw_context *draw;
@@ -56,6 +80,9 @@ struct llvm_middle_end {
 
    struct draw_llvm *llvm;
    struct draw_llvm_variant *current_variant;
+
+   struct util_queue vs_queue;
+   struct llvm_vs_job vs_jobs[LLVM_VS_MAX_THREADS];
 };
 
 
@@ -336,6 +363,117 @@ emit(struct pt_emit *emit,
 }
 
 
+/**
+ * Run the vertex shader on \p count vertices of \p fetch_info starting at
+ * \p start, writing them to the same place in \p verts as when shading
+ * all the vertices at once.
+ */
+static unsigned
+llvm_shade_vertices(struct llvm_middle_end *fpme,
+                    const struct draw_fetch_info *fetch_info,
+                    struct vertex_header *verts,
+                    unsigned start,
+                    unsigned count)
+{
+   struct draw_context *draw = fpme->draw;
+
+   if (fpme->current_variant->opt_gallivm)
+      draw_llvm_update_variant(fpme->current_variant);
+
+   verts = (struct vertex_header *)
+      ((char *) verts + start * fpme->vertex_size);
+
+   if (fetch_info->linear)
+      return fpme->current_variant->jit_func( &fpme->llvm->jit_context,
+                                              verts,
+                                              draw->pt.user.vbuffer,
+                                              fetch_info->start + start,
+                                              count,
+                                              fpme->vertex_size,
+                                              draw->pt.vertex_buffer,
+                                              draw->instance_id,
+                                              draw->start_index,
+                                              draw->start_instance);
+   else
+      return fpme->current_variant->jit_func_elts( &fpme->llvm->jit_context,
+                                                   verts,
+                                                   draw->pt.user.vbuffer,
+                                                   fetch_info->elts + start,
+                                                   draw->pt.user.eltMax,
+                                                   count,
+                                                   fpme->vertex_size,
+                                                   draw->pt.vertex_buffer,
+                                                   draw->instance_id,
+                                                   draw->pt.user.eltBias,
+                                                   draw->start_instance);
+}
+
+
+static void
+llvm_shade_vertices_job(void *data, int thread_index)
+{
+   struct llvm_vs_job *job = (struct llvm_vs_job *) data;
+
+   job->clipped = llvm_shade_vertices(job->fpme, job->fetch_info, job->verts,
+                                      job->start, job->count);
+}
+
+
+/**
+ * Run the vertex shader on all the vertices of \p fetch_info.
+ *
+ * If there are enough vertices, they are split in chunks shaded in
+ * parallel by the worker threads and the calling thread.  The generated
+ * code only reads the vertex buffers and the JIT context, and each chunk
+ * is written to its own part of \p verts, so the result is the same as
+ * shading them all at once.  Chunks are a multiple of the vector width,
+ * so that only the last one has a partial vector.
+ *
+ * Returns the ORed clip flags of all the vertices.
+ */
+static unsigned
+llvm_shade(struct llvm_middle_end *fpme,
+           const struct draw_fetch_info *fetch_info,
+           struct vertex_header *verts)
+{
+   const unsigned vector_length = lp_native_vector_width / 32;
+   const unsigned count = fetch_info->count;
+   unsigned num_chunks, chunk_size, num_jobs = 0;
+   unsigned clipped, start, i;
+
+   if (!util_queue_is_initialized(&fpme->vs_queue))
+      return llvm_shade_vertices(fpme, fetch_info, verts, 0, count);
+
+   num_chunks = MIN2(fpme->vs_queue.num_threads + 1,
+                     count / LLVM_VS_MIN_VERTICES_PER_THREAD);
+   if (num_chunks <= 1)
+      return llvm_shade_vertices(fpme, fetch_info, verts, 0, count);
+
+   chunk_size = align(DIV_ROUND_UP(count, num_chunks), vector_length);
+
+   for (start = chunk_size; start < count; start += chunk_size) {
+      struct llvm_vs_job *job = &fpme->vs_jobs[num_jobs++];
+
+      job->fpme = fpme;
+      job->fetch_info = fetch_info;
+      job->verts = verts;
+      job->start = start;
+      job->count = MIN2(chunk_size, count - start);
+      util_queue_add_job(&fpme->vs_queue, job, &job->fence,
+                         llvm_shade_vertices_job);
+   }
+
+   clipped = llvm_shade_vertices(fpme, fetch_info, verts, 0, chunk_size);
+
+   for (i = 0; i < num_jobs; i++) {
+      util_queue_job_wait(&fpme->vs_jobs[i].fence);
+      clipped |= fpme->vs_jobs[i].clipped;
+   }
+
+   return clipped;
+}
+
+
 static void
 llvm_pipeline_generic(struct draw_pt_middle_end *middle,
                       const struct draw_fetch_info *fetch_info,
@@ -373,29 +511,7 @@ llvm_pipeline_generic(struct draw_pt_middle_end *middle,
       draw->statistics.vs_invocations += fetch_info->count;
    }
 
-   if (fetch_info->linear)
-      clipped = fpme->current_variant->jit_func( &fpme->llvm->jit_context,
-                                       llvm_vert_info.verts,
-                                       draw->pt.user.vbuffer,
-                                       fetch_info->start,
-                                       fetch_info->count,
-                                       fpme->vertex_size,
-                                       draw->pt.vertex_buffer,
-                                       draw->instance_id,
-                                       draw->start_index,
-                                       draw->start_instance);
-   else
-      clipped = fpme->current_variant->jit_func_elts( &fpme->llvm->jit_context,
-                                            llvm_vert_info.verts,
-                                            draw->pt.user.vbuffer,
-                                            fetch_info->elts,
-                                            draw->pt.user.eltMax,
-                                            fetch_info->count,
-                                            fpme->vertex_size,
-                                            draw->pt.vertex_buffer,
-                                            draw->instance_id,
-                                            draw->pt.user.eltBias,
-                                            draw->start_instance);
+   clipped = llvm_shade(fpme, fetch_info, llvm_vert_info.verts);
 
    /* Finished with fetch and vs:
     */
@@ -585,6 +701,13 @@ static void
 llvm_middle_end_destroy(struct draw_pt_middle_end *middle)
 {
    struct llvm_middle_end *fpme = llvm_middle_end(middle);
+   unsigned i;
+
+   if (util_queue_is_initialized(&fpme->vs_queue)) {
+      util_queue_destroy(&fpme->vs_queue);
+      for (i = 0; i < LLVM_VS_MAX_THREADS; i++)
+         util_queue_fence_destroy(&fpme->vs_jobs[i].fence);
+   }
 
    if (fpme->fetch)
       draw_pt_fetch_destroy( fpme->fetch );
@@ -606,6 +729,7 @@ struct draw_pt_middle_end *
 draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
 {
    struct llvm_middle_end *fpme = 0;
+   unsigned num_threads;
 
    if (!draw->llvm)
       return NULL;
@@ -646,6 +770,16 @@ draw_pt_fetch_pipeline_or_emit_llvm(struct draw_context *draw)
 
    fpme->current_variant = NULL;
 
+   num_threads = MIN2(debug_get_option_draw_vs_threads(), LLVM_VS_MAX_THREADS);
+   if (num_threads > 0 &&
+       util_queue_init(&fpme->vs_queue, "drawvs", LLVM_VS_MAX_THREADS,
+                       num_threads)) {
+      unsigned i;
+
+      for (i = 0; i < LLVM_VS_MAX_THREADS; i++)
+         util_queue_fence_init(&fpme->vs_jobs[i].fence);
+   }
+
    return &fpme->base;
 
  fail:
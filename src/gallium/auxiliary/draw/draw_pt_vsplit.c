@@ -23,6 +23,7 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
+#include "util/u_debug.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 
@@ -33,6 +34,16 @@
 #define SEGMENT_SIZE 1024
 #define MAP_SIZE     256
 
+/* DRAW_VERTEX_CACHE_SIZE or draw_set_vertex_cache_size() can make the
+ * cache of fetched vertices bigger than MAP_SIZE, up to MAX_MAP_SIZE
+ * entries.  As nothing is shared between segments, segments are then made
+ * as big as the cache, up to MAX_SEGMENT_SIZE vertices.
+ */
+#define MAX_SEGMENT_SIZE 4096
+#define MAX_MAP_SIZE     4096
+
+DEBUG_GET_ONCE_NUM_OPTION(draw_vertex_cache_size, "DRAW_VERTEX_CACHE_SIZE", 0)
+
 /* The largest possible index withing an index buffer */
 #define MAX_ELT_IDX 0xffffffff
 
@@ -48,14 +59,15 @@ struct vsplit_frontend {
    ushort segment_size;
 
    /* buffers for splitting */
-   unsigned fetch_elts[SEGMENT_SIZE];
-   ushort draw_elts[SEGMENT_SIZE];
-   ushort identity_draw_elts[SEGMENT_SIZE];
+   unsigned fetch_elts[MAX_SEGMENT_SIZE];
+   ushort draw_elts[MAX_SEGMENT_SIZE];
+   ushort identity_draw_elts[MAX_SEGMENT_SIZE];
 
    struct {
       /* map a fetch element to a draw element */
-      unsigned fetches[MAP_SIZE];
-      ushort draws[MAP_SIZE];
+      unsigned *fetches;
+      ushort *draws;
+      unsigned size;
       boolean has_max_fetch;
 
       ushort num_fetch_elts;
@@ -67,7 +79,22 @@ struct vsplit_frontend {
 static void
 vsplit_clear_cache(struct vsplit_frontend *vsplit)
 {
-   memset(vsplit->cache.fetches, 0xff, sizeof(vsplit->cache.fetches));
+   /* Only the entries of the elements fetched since the last clear can be
+    * set, except for the one forced by vsplit_add_cache_uint().
+    */
+   if (vsplit->cache.has_max_fetch ||
+       vsplit->cache.num_fetch_elts > vsplit->cache.size / 4) {
+      memset(vsplit->cache.fetches, 0xff,
+             vsplit->cache.size * sizeof(vsplit->cache.fetches[0]));
+   }
+   else {
+      unsigned i;
+
+      for (i = 0; i < vsplit->cache.num_fetch_elts; i++)
+         vsplit->cache.fetches[vsplit->fetch_elts[i] &
+                               (vsplit->cache.size - 1)] = ~0;
+   }
+
    vsplit->cache.has_max_fetch = FALSE;
    vsplit->cache.num_fetch_elts = 0;
    vsplit->cache.num_draw_elts = 0;
@@ -79,6 +106,9 @@ vsplit_flush_cache(struct vsplit_frontend *vsplit, unsigned flags)
    vsplit->middle->run(vsplit->middle,
          vsplit->fetch_elts, vsplit->cache.num_fetch_elts,
          vsplit->draw_elts, vsplit->cache.num_draw_elts, flags);
+
+   /* Clear the cache while fetch_elts still says which entries are set. */
+   vsplit_clear_cache(vsplit);
 }
 
 /**
@@ -89,7 +119,7 @@ vsplit_add_cache(struct vsplit_frontend *vsplit, unsigned fetch, unsigned ofbias
 {
    unsigned hash;
 
-   hash = fetch % MAP_SIZE;
+   hash = fetch & (vsplit->cache.size - 1);
 
    /* If the value isn't in the cache or it's an overflow due to the
     * element bias */
@@ -203,7 +233,7 @@ vsplit_add_cache_uint(struct vsplit_frontend *vsplit, const uint *elts,
 
    /* special care for DRAW_MAX_FETCH_IDX */
    if (raw_elem_idx == DRAW_MAX_FETCH_IDX && !vsplit->cache.has_max_fetch) {
-      unsigned hash = fetch % MAP_SIZE;
+      unsigned hash = fetch & (vsplit->cache.size - 1);
       vsplit->cache.fetches[hash] = raw_elem_idx - 1; /* force update */
       vsplit->cache.has_max_fetch = TRUE;
    }
@@ -237,6 +267,7 @@ static void vsplit_prepare(struct draw_pt_front_end *frontend,
                            unsigned opt)
 {
    struct vsplit_frontend *vsplit = (struct vsplit_frontend *) frontend;
+   unsigned cache_size;
 
    switch (vsplit->draw->pt.user.eltSize) {
    case 0:
@@ -259,10 +290,20 @@ static void vsplit_prepare(struct draw_pt_front_end *frontend,
    /* split only */
    vsplit->prim = in_prim;
 
+   /* The cache is empty between runs, and the entries past the current
+    * size are never set, so it can be resized here.
+    */
+   cache_size = debug_get_option_draw_vertex_cache_size();
+   if (!cache_size)
+      cache_size = vsplit->draw->pt.vertex_cache_size;
+   vsplit->cache.size = util_next_power_of_two(CLAMP(cache_size, MAP_SIZE,
+                                                     MAX_MAP_SIZE));
+
    vsplit->middle = middle;
    middle->prepare(middle, vsplit->prim, opt, &vsplit->max_vertices);
 
-   vsplit->segment_size = MIN2(SEGMENT_SIZE, vsplit->max_vertices);
+   vsplit->segment_size = MIN2(MAX2(SEGMENT_SIZE, vsplit->cache.size),
+                               vsplit->max_vertices);
 }
 
 
@@ -279,6 +320,10 @@ static void vsplit_flush(struct draw_pt_front_end *frontend, unsigned flags)
 
 static void vsplit_destroy(struct draw_pt_front_end *frontend)
 {
+   struct vsplit_frontend *vsplit = (struct vsplit_frontend *) frontend;
+
+   FREE(vsplit->cache.fetches);
+   FREE(vsplit->cache.draws);
    FREE(frontend);
 }
 
@@ -291,13 +336,22 @@ struct draw_pt_front_end *draw_pt_vsplit(struct draw_context *draw)
    if (!vsplit)
       return NULL;
 
+   vsplit->cache.size = MAP_SIZE;
+   vsplit->cache.fetches = MALLOC(MAX_MAP_SIZE * sizeof(unsigned));
+   vsplit->cache.draws = MALLOC(MAX_MAP_SIZE * sizeof(ushort));
+   if (!vsplit->cache.fetches || !vsplit->cache.draws) {
+      vsplit_destroy(&vsplit->base);
+      return NULL;
+   }
+   memset(vsplit->cache.fetches, 0xff, MAX_MAP_SIZE * sizeof(unsigned));
+
    vsplit->base.prepare = vsplit_prepare;
    vsplit->base.run     = NULL;
    vsplit->base.flush   = vsplit_flush;
    vsplit->base.destroy = vsplit_destroy;
    vsplit->draw = draw;
 
-   for (i = 0; i < SEGMENT_SIZE; i++)
+   for (i = 0; i < MAX_SEGMENT_SIZE; i++)
       vsplit->identity_draw_elts[i] = i;
 
    return &vsplit->base;
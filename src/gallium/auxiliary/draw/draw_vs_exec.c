@@ -47,6 +47,7 @@
 struct exec_vertex_shader {
    struct draw_vertex_shader base;
    struct tgsi_exec_machine *machine;
+   struct tgsi_exec_shader *exec_shader; /**< decoded once for the machine */
 };
 
 static struct exec_vertex_shader *exec_vertex_shader( struct draw_vertex_shader *vs )
@@ -68,9 +69,9 @@ vs_exec_prepare( struct draw_vertex_shader *shader,
     * Avoid rebinding when possible.
     */
    if (evs->machine->Tokens != shader->state.tokens) {
-      tgsi_exec_machine_bind_shader(evs->machine,
-                                    shader->state.tokens,
-                                    draw->vs.tgsi.sampler);
+      tgsi_exec_machine_bind_exec_shader(evs->machine,
+                                         evs->exec_shader,
+                                         draw->vs.tgsi.sampler);
    }
 }
 
@@ -214,6 +215,12 @@ vs_exec_run_linear( struct draw_vertex_shader *shader,
 static void
 vs_exec_delete( struct draw_vertex_shader *dvs )
 {
+   struct exec_vertex_shader *evs = exec_vertex_shader(dvs);
+
+   if (evs->machine->Tokens == dvs->state.tokens)
+      tgsi_exec_machine_bind_exec_shader(evs->machine, NULL, NULL);
+
+   tgsi_exec_shader_destroy(evs->exec_shader);
    FREE((void*) dvs->state.tokens);
    FREE( dvs );
 }
@@ -235,6 +242,13 @@ draw_create_vs_exec(struct draw_context *draw,
       return NULL;
    }
 
+   vs->exec_shader = tgsi_exec_shader_create(vs->base.state.tokens);
+   if (!vs->exec_shader) {
+      FREE((void*) vs->base.state.tokens);
+      FREE(vs);
+      return NULL;
+   }
+
    tgsi_scan_shader(state->tokens, &vs->base.info);
 
    vs->base.state.stream_output = state->stream_output;
@@ -49,10 +49,11 @@ struct lp_build_context;
  * Block cache
  *
  * Optional block cache to be used when unpacking big pixel blocks.
- * Must be a power of 2
+ * Must be a power of 2.  The decoded blocks take 64 bytes each, so this
+ * is 16 KiB plus the tags, leaving room for other data in a 32 KiB L1.
  */
 
-#define LP_BUILD_FORMAT_CACHE_SIZE 128
+#define LP_BUILD_FORMAT_CACHE_SIZE 256
 
 /*
  * Note: cache_data needs 16 byte alignment.
@@ -164,6 +165,9 @@ lp_build_fetch_subsampled_rgba_aos(struct gallivm_state *gallivm,
                                    LLVMValueRef j);
 
 
+boolean
+lp_build_format_is_cached(const struct util_format_description *format_desc);
+
 LLVMValueRef
 lp_build_fetch_cached_texels(struct gallivm_state *gallivm,
                              const struct util_format_description *format_desc,
@@ -43,7 +43,7 @@
  * a small cache helps.
  * The elements in the cache are the decoded blocks - currently things
  * are restricted to formats which are 4x4 block based, and the decoded
- * texels must fit into 4x8 bits.
+ * texels must fit into 4x8 bits (see lp_build_format_is_cached()).
  * The cache is direct mapped so hitrates aren't all that great and cache
  * thrashing could happen.
  *
@@ -155,37 +155,39 @@ update_cached_block(struct gallivm_state *gallivm,
    LLVMValueRef function;
    LLVMValueRef tag_value, tmp_ptr;
    LLVMValueRef col[4];
-   unsigned i, j;
+   unsigned i;
 
    /*
-    * Use format_desc->fetch_rgba_8unorm() for each pixel in the block.
-    * This doesn't actually make any sense whatsoever, someone would need
-    * to write a function doing this for all pixels in a block (either as
-    * an external c function or with generated code). Don't ask.
+    * Decode the whole block with a single format_desc->unpack_rgba_8unorm()
+    * call, rather than fetching the 16 pixels one by one.
     */
 
    {
       /*
        * Function to call looks like:
-       *   fetch(uint8_t *dst, const uint8_t *src, unsigned i, unsigned j)
+       *   unpack(uint8_t *dst_row, unsigned dst_stride,
+       *          const uint8_t *src_row, unsigned src_stride,
+       *          unsigned width, unsigned height)
        */
       LLVMTypeRef ret_type;
-      LLVMTypeRef arg_types[4];
+      LLVMTypeRef arg_types[6];
       LLVMTypeRef function_type;
 
-      assert(format_desc->fetch_rgba_8unorm);
+      assert(format_desc->unpack_rgba_8unorm);
 
       ret_type = LLVMVoidTypeInContext(gallivm->context);
       arg_types[0] = pi8t;
-      arg_types[1] = pi8t;
-      arg_types[2] = i32t;
+      arg_types[1] = i32t;
+      arg_types[2] = pi8t;
       arg_types[3] = i32t;
+      arg_types[4] = i32t;
+      arg_types[5] = i32t;
       function_type = LLVMFunctionType(ret_type, arg_types,
                                        Elements(arg_types), 0);
 
-      /* make const pointer for the C fetch_rgba_8unorm function */
+      /* make const pointer for the C unpack_rgba_8unorm function */
       function = lp_build_const_int_pointer(gallivm,
-         func_to_pointer((func_pointer) format_desc->fetch_rgba_8unorm));
+         func_to_pointer((func_pointer) format_desc->unpack_rgba_8unorm));
 
       /* cast the callee pointer to the function's type */
       function = LLVMBuildBitCast(builder, function,
@@ -199,26 +201,20 @@ update_cached_block(struct gallivm_state *gallivm,
    tmp_ptr = LLVMBuildBitCast(builder, tmp_ptr, pi8t, "");
 
    /*
-    * Invoke format_desc->fetch_rgba_8unorm() for each pixel.
-    * This is going to be really really slow.
-    * Note: the block store format is actually
-    * x0y0x0y1x0y2x0y3 x1y0x1y1x1y2x1y3 ...
+    * Unpack the block as 4 rows of 4 pixels, so the block store format is
+    * x0y0x1y0x2y0x3y0 x0y1x1y1x2y1x3y1 ...
+    * The source stride doesn't matter as the rows are all in one block.
     */
-   for (i = 0; i < 4; ++i) {
-      for (j = 0; j < 4; ++j) {
-         LLVMValueRef args[4];
-         LLVMValueRef dst_offset = lp_build_const_int32(gallivm, (i * 4 + j) * 4);
-
-         /*
-          * Note we actually supply a pointer to the start of the block,
-          * not the start of the texture.
-          */
-         args[0] = LLVMBuildGEP(gallivm->builder, tmp_ptr, &dst_offset, 1, "");
-         args[1] = ptr_addr;
-         args[2] = LLVMConstInt(i32t, i, 0);
-         args[3] = LLVMConstInt(i32t, j, 0);
-         LLVMBuildCall(builder, function, args, Elements(args), "");
-      }
+   {
+      LLVMValueRef args[6];
+
+      args[0] = tmp_ptr;
+      args[1] = LLVMConstInt(i32t, 4 * 4, 0);
+      args[2] = ptr_addr;
+      args[3] = LLVMConstInt(i32t, 0, 0);
+      args[4] = LLVMConstInt(i32t, 4, 0);
+      args[5] = LLVMConstInt(i32t, 4, 0);
+      LLVMBuildCall(builder, function, args, Elements(args), "");
    }
 
    /* Finally store the block - pointless mem copy + update tag. */
@@ -235,6 +231,43 @@ update_cached_block(struct gallivm_state *gallivm,
 }
 
 
+/**
+ * Whether texels of this format can be fetched through the block cache.
+ *
+ * The formats need to decode to 8 bits per channel without loss: S3TC,
+ * ETC1 and ETC2 except for the 11 bit formats, and unsigned RGTC/LATC
+ * (which the util decoders decode to 8 bits anyway).
+ */
+boolean
+lp_build_format_is_cached(const struct util_format_description *format_desc)
+{
+   if (format_desc->block.width != 4 ||
+       format_desc->block.height != 4 ||
+       !format_desc->unpack_rgba_8unorm)
+      return FALSE;
+
+   if (format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC)
+      return TRUE;
+
+   switch (format_desc->format) {
+   case PIPE_FORMAT_ETC1_RGB8:
+   case PIPE_FORMAT_ETC2_RGB8:
+   case PIPE_FORMAT_ETC2_SRGB8:
+   case PIPE_FORMAT_ETC2_RGB8A1:
+   case PIPE_FORMAT_ETC2_SRGB8A1:
+   case PIPE_FORMAT_ETC2_RGBA8:
+   case PIPE_FORMAT_ETC2_SRGBA8:
+   case PIPE_FORMAT_RGTC1_UNORM:
+   case PIPE_FORMAT_RGTC2_UNORM:
+   case PIPE_FORMAT_LATC1_UNORM:
+   case PIPE_FORMAT_LATC2_UNORM:
+      return TRUE;
+   default:
+      return FALSE;
+   }
+}
+
+
 /*
  * Do a cached lookup.
  *
@@ -302,8 +335,8 @@ lp_build_fetch_cached_texels(struct gallivm_state *gallivm,
 
    hash_mask = lp_build_const_int_vec(gallivm, type, LP_BUILD_FORMAT_CACHE_SIZE - 1);
    hash_index = LLVMBuildAnd(builder, hash_index, hash_mask, "");
-   ij_index = LLVMBuildShl(builder, i, lp_build_const_int_vec(gallivm, type, 2), "");
-   ij_index = LLVMBuildAdd(builder, ij_index, j, "");
+   ij_index = LLVMBuildShl(builder, j, lp_build_const_int_vec(gallivm, type, 2), "");
+   ij_index = LLVMBuildAdd(builder, ij_index, i, "");
    block_index = LLVMBuildShl(builder, hash_index,
                               lp_build_const_int_vec(gallivm, type, 4), "");
    block_index = LLVMBuildAdd(builder, ij_index, block_index, "");
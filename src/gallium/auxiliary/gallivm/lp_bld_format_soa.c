@@ -485,7 +485,7 @@ lp_build_fetch_rgba_soa(struct gallivm_state *gallivm,
       return;
    }
 
-   if (format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC &&
+   if (lp_build_format_is_cached(format_desc) &&
        /* non-srgb case is already handled above */
        format_desc->colorspace == UTIL_FORMAT_COLORSPACE_SRGB &&
        type.floating && type.width == 32 &&
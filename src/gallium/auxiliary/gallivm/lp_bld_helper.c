@@ -0,0 +1,330 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Helper functions shared between shader variants.
+ *
+ * Each helper lives in a module of its own, which is compiled as soon as
+ * the helper is built, and is called from variants through its address.
+ * Helpers are looked up by a key made of their name, their function type
+ * and a blob of state supplied by the caller, which must cover everything
+ * the generated code depends on.
+ *
+ * The cache can be shared by all the contexts of a screen: a helper is
+ * built in the LLVM context of the variant that first needs it, but once
+ * compiled only its code is kept, so it can be called from any context.
+ */
+
+
+#include "util/u_debug.h"
+#include "util/u_dynarray.h"
+#include "util/u_hash.h"
+#include "util/u_hash_table.h"
+#include "util/u_memory.h"
+#include "os/os_thread.h"
+#include "os/os_time.h"
+#include "lp_bld_const.h"
+#include "lp_bld_debug.h"
+#include "lp_bld_helper.h"
+#include "lp_bld_init.h"
+
+
+struct lp_helper
+{
+   struct util_dynarray key;
+   struct gallivm_state *gallivm;
+   /** The compiled function, or NULL if building it failed */
+   func_pointer code;
+};
+
+
+struct lp_helper_cache
+{
+   pipe_mutex mutex;
+   struct util_hash_table *helpers;
+};
+
+
+static unsigned
+helper_key_hash(void *key)
+{
+   const struct util_dynarray *buf = key;
+   return util_hash_crc32(buf->data, buf->size);
+}
+
+
+static int
+helper_key_compare(void *key1, void *key2)
+{
+   const struct util_dynarray *buf1 = key1;
+   const struct util_dynarray *buf2 = key2;
+
+   if (buf1->size != buf2->size)
+      return 1;
+   return memcmp(buf1->data, buf2->data, buf1->size);
+}
+
+
+/**
+ * Append a description of an LLVM type to a helper key.
+ *
+ * Types can't be compared directly, as the helper may be called from
+ * another LLVM context than the one it was built in.
+ */
+static void
+append_type(struct util_dynarray *buf, LLVMTypeRef type)
+{
+   LLVMTypeKind kind = LLVMGetTypeKind(type);
+   LLVMTypeRef *elems;
+   unsigned i, count;
+
+   util_dynarray_append(buf, unsigned, kind);
+
+   switch (kind) {
+   case LLVMIntegerTypeKind:
+      util_dynarray_append(buf, unsigned, LLVMGetIntTypeWidth(type));
+      break;
+   case LLVMVectorTypeKind:
+      util_dynarray_append(buf, unsigned, LLVMGetVectorSize(type));
+      append_type(buf, LLVMGetElementType(type));
+      break;
+   case LLVMArrayTypeKind:
+      util_dynarray_append(buf, unsigned, LLVMGetArrayLength(type));
+      append_type(buf, LLVMGetElementType(type));
+      break;
+   case LLVMPointerTypeKind:
+      util_dynarray_append(buf, unsigned, LLVMGetPointerAddressSpace(type));
+      append_type(buf, LLVMGetElementType(type));
+      break;
+   case LLVMStructTypeKind:
+      count = LLVMCountStructElementTypes(type);
+      util_dynarray_append(buf, unsigned, count);
+      util_dynarray_append(buf, unsigned, LLVMIsPackedStruct(type));
+      elems = MALLOC(count * sizeof *elems);
+      if (elems) {
+         LLVMGetStructElementTypes(type, elems);
+         for (i = 0; i < count; i++) {
+            append_type(buf, elems[i]);
+         }
+         FREE(elems);
+      }
+      break;
+   case LLVMFunctionTypeKind:
+      count = LLVMCountParamTypes(type);
+      util_dynarray_append(buf, unsigned, count);
+      append_type(buf, LLVMGetReturnType(type));
+      elems = MALLOC(count * sizeof *elems);
+      if (elems) {
+         LLVMGetParamTypes(type, elems);
+         for (i = 0; i < count; i++) {
+            append_type(buf, elems[i]);
+         }
+         FREE(elems);
+      }
+      break;
+   default:
+      break;
+   }
+}
+
+
+struct lp_helper_cache *
+lp_helper_cache_create(void)
+{
+   struct lp_helper_cache *cache = CALLOC_STRUCT(lp_helper_cache);
+   if (!cache)
+      return NULL;
+
+   cache->helpers = util_hash_table_create(helper_key_hash,
+                                           helper_key_compare);
+   if (!cache->helpers) {
+      FREE(cache);
+      return NULL;
+   }
+
+   pipe_mutex_init(cache->mutex);
+
+   return cache;
+}
+
+
+static enum pipe_error
+destroy_helper(void *key, void *value, void *data)
+{
+   struct lp_helper *helper = value;
+
+   if (helper->gallivm)
+      gallivm_destroy(helper->gallivm);
+   util_dynarray_fini(&helper->key);
+   FREE(helper);
+
+   return PIPE_OK;
+}
+
+
+/**
+ * Free all helpers.  No code calling them may run anymore.
+ */
+void
+lp_helper_cache_destroy(struct lp_helper_cache *cache)
+{
+   if (!cache)
+      return;
+
+   util_hash_table_foreach(cache->helpers, destroy_helper, NULL);
+   util_hash_table_destroy(cache->helpers);
+   pipe_mutex_destroy(cache->mutex);
+   FREE(cache);
+}
+
+
+static void
+build_helper(struct lp_helper *helper,
+             LLVMContextRef context,
+             const char *name,
+             LLVMTypeRef function_type,
+             lp_build_helper_func build,
+             void *data)
+{
+   struct gallivm_state *gallivm;
+   LLVMValueRef function;
+   LLVMBasicBlockRef block;
+   int64_t time_begin = 0;
+
+   if (gallivm_debug & GALLIVM_DEBUG_PERF)
+      time_begin = os_time_get();
+
+   gallivm = gallivm_create(name, context, NULL);
+   if (!gallivm)
+      return;
+
+   function = LLVMAddFunction(gallivm->module, name, function_type);
+   LLVMSetFunctionCallConv(function, LLVMCCallConv);
+
+   block = LLVMAppendBasicBlockInContext(gallivm->context, function, "entry");
+   LLVMPositionBuilderAtEnd(gallivm->builder, block);
+
+   build(gallivm, function, data);
+
+   gallivm_verify_function(gallivm, function);
+   gallivm_compile_module(gallivm);
+   helper->code = gallivm_jit_function(gallivm, function);
+   gallivm_free_ir(gallivm);
+   helper->gallivm = gallivm;
+
+   if (gallivm_debug & GALLIVM_DEBUG_PERF) {
+      int64_t time_end = os_time_get();
+      int time_msec = (int)(time_end - time_begin) / 1000;
+      debug_printf("building helper %s took %d msec\n", name, time_msec);
+   }
+}
+
+
+/**
+ * Call a helper function, building it first if no variant did yet.
+ *
+ * \param name  name of the helper, which is part of the key
+ * \param key  state the code built by \p build depends on, besides the
+ *             name and the function type
+ * \param build  callback emitting the function body
+ * \return the result of the call, or NULL if helpers can't be used here,
+ *         in which case the caller must emit the code inline.
+ */
+LLVMValueRef
+lp_build_helper_call(struct gallivm_state *gallivm,
+                     const char *name,
+                     const void *key,
+                     unsigned key_size,
+                     LLVMTypeRef function_type,
+                     lp_build_helper_func build,
+                     void *data,
+                     LLVMValueRef *args,
+                     unsigned num_args)
+{
+   struct lp_helper_cache *cache = gallivm->helpers;
+   struct util_dynarray lookup;
+   struct lp_helper *helper;
+   LLVMValueRef function;
+
+   /*
+    * Calls embed the helper's address, so the code could not be reused by
+    * another process.  Don't spoil objects meant for the disk cache.
+    */
+   if (!cache || gallivm->cache)
+      return NULL;
+
+   util_dynarray_init(&lookup);
+   memcpy(util_dynarray_grow(&lookup, strlen(name) + 1), name,
+          strlen(name) + 1);
+   append_type(&lookup, function_type);
+   memcpy(util_dynarray_grow(&lookup, key_size), key, key_size);
+
+   pipe_mutex_lock(cache->mutex);
+
+   helper = util_hash_table_get(cache->helpers, &lookup);
+   if (helper) {
+      util_dynarray_fini(&lookup);
+   }
+   else {
+      helper = CALLOC_STRUCT(lp_helper);
+      if (!helper) {
+         pipe_mutex_unlock(cache->mutex);
+         util_dynarray_fini(&lookup);
+         return NULL;
+      }
+
+      helper->key = lookup;
+
+      /*
+       * Building is done with the lock held so that concurrent variants
+       * don't build the same helper twice.  A failed build is remembered
+       * too, so that it isn't retried for every variant.
+       */
+      build_helper(helper, gallivm->context, name, function_type,
+                   build, data);
+
+      if (util_hash_table_set(cache->helpers, &helper->key,
+                              helper) != PIPE_OK) {
+         pipe_mutex_unlock(cache->mutex);
+         destroy_helper(NULL, helper, NULL);
+         return NULL;
+      }
+   }
+
+   pipe_mutex_unlock(cache->mutex);
+
+   if (!helper->code)
+      return NULL;
+
+   function = lp_build_const_int_pointer(gallivm,
+                                         func_to_pointer(helper->code));
+   function = LLVMBuildBitCast(gallivm->builder, function,
+                               LLVMPointerType(function_type, 0), name);
+
+   return LLVMBuildCall(gallivm->builder, function, args, num_args, "");
+}
@@ -0,0 +1,80 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Helper functions shared between shader variants.
+ *
+ * Big chunks of code such as texture sampling come out the same in many
+ * variants.  Instead of emitting them into every module, a variant can call
+ * a helper function which is compiled into a module of its own the first
+ * time it is needed, and reused by all later variants with the same key.
+ */
+
+
+#ifndef LP_BLD_HELPER_H
+#define LP_BLD_HELPER_H
+
+
+#include "gallivm/lp_bld.h"
+
+
+struct lp_helper_cache;
+
+
+/**
+ * Emit the body of a helper function.
+ *
+ * \param gallivm  the helper's own gallivm state, with a fresh builder
+ * \param function  the function to fill in, of the type passed to
+ *                  lp_build_helper_call()
+ */
+typedef void
+(*lp_build_helper_func)(struct gallivm_state *gallivm,
+                        LLVMValueRef function,
+                        void *data);
+
+
+struct lp_helper_cache *
+lp_helper_cache_create(void);
+
+void
+lp_helper_cache_destroy(struct lp_helper_cache *cache);
+
+LLVMValueRef
+lp_build_helper_call(struct gallivm_state *gallivm,
+                     const char *name,
+                     const void *key,
+                     unsigned key_size,
+                     LLVMTypeRef function_type,
+                     lp_build_helper_func build,
+                     void *data,
+                     LLVMValueRef *args,
+                     unsigned num_args);
+
+
+#endif /* !LP_BLD_HELPER_H */
@@ -30,11 +30,14 @@
 #include "pipe/p_compiler.h"
 #include "util/u_cpu_detect.h"
 #include "util/u_debug.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/simple_list.h"
+#include "os/os_thread.h"
 #include "os/os_time.h"
 #include "lp_bld.h"
 #include "lp_bld_debug.h"
+#include "lp_bld_type.h"
 #include "lp_bld_misc.h"
 #include "lp_bld_init.h"
 
@@ -145,7 +148,18 @@ create_pass_manager(struct gallivm_state *gallivm)
    LLVMSetDataLayout(gallivm->module, "");
 #endif
 
-   if ((gallivm_debug & GALLIVM_DEBUG_NO_OPT) == 0) {
+   return TRUE;
+}
+
+
+/**
+ * Install the optimization passes.  This is deferred until the module gets
+ * compiled, so that gallivm_state::no_opt can be set after creation.
+ */
+static void
+add_optimization_passes(struct gallivm_state *gallivm)
+{
+   if ((gallivm_debug & GALLIVM_DEBUG_NO_OPT) == 0 && !gallivm->no_opt) {
       /* These are the passes currently listed in llvm-c/Transforms/Scalar.h,
        * but there are more on SVN.
        * TODO: Add more passes.
@@ -165,8 +179,6 @@ create_pass_manager(struct gallivm_state *gallivm)
        */
       LLVMAddPromoteMemoryToRegisterPass(gallivm->passmgr);
    }
-
-   return TRUE;
 }
 
 
@@ -199,7 +211,17 @@ gallivm_free_ir(struct gallivm_state *gallivm)
    if (gallivm->builder)
       LLVMDisposeBuilder(gallivm->builder);
 
-   /* The LLVMContext should be owned by the parent of gallivm. */
+   /* The object cache must outlive the engine, which is gone by now. */
+   if (gallivm->cache && gallivm->cache->jit_obj_cache) {
+      lp_free_objcache(gallivm->cache->jit_obj_cache);
+      gallivm->cache->jit_obj_cache = NULL;
+   }
+
+   /* Otherwise the LLVMContext is owned by the parent of gallivm. */
+   if (gallivm->own_context && gallivm->context) {
+      LLVMContextDispose(gallivm->context);
+      gallivm->own_context = FALSE;
+   }
 
    gallivm->engine = NULL;
    gallivm->target = NULL;
@@ -207,6 +229,7 @@ gallivm_free_ir(struct gallivm_state *gallivm)
    gallivm->passmgr = NULL;
    gallivm->context = NULL;
    gallivm->builder = NULL;
+   gallivm->cache = NULL;
 }
 
 
@@ -233,7 +256,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
       char *error = NULL;
       int ret;
 
-      if (gallivm_debug & GALLIVM_DEBUG_NO_OPT) {
+      if ((gallivm_debug & GALLIVM_DEBUG_NO_OPT) || gallivm->no_opt) {
          optlevel = None;
       }
       else {
@@ -246,6 +269,7 @@ init_gallivm_engine(struct gallivm_state *gallivm)
                                                     gallivm->memorymgr,
                                                     (unsigned) optlevel,
                                                     USE_MCJIT,
+                                                    gallivm->cache,
                                                     &error);
       if (ret) {
          _debug_printf("%s\n", error);
@@ -302,7 +326,13 @@ init_gallivm_state(struct gallivm_state *gallivm, const char *name,
    if (!lp_build_init())
       return FALSE;
 
-   gallivm->context = context;
+   if (context) {
+      gallivm->context = context;
+   }
+   else {
+      gallivm->context = LLVMContextCreate();
+      gallivm->own_context = TRUE;
+   }
 
    if (!gallivm->context)
       goto fail;
@@ -414,9 +444,23 @@ lp_build_init(void)
       lp_native_vector_width = 128;
    }
  
+   /* 512-bit vectors are only used when asked for with
+    * LP_NATIVE_VECTOR_WIDTH=512, as the AVX-512 code paths have seen much
+    * less testing than the AVX ones.
+    */
    lp_native_vector_width = debug_get_num_option("LP_NATIVE_VECTOR_WIDTH",
                                                  lp_native_vector_width);
 
+   if (lp_native_vector_width > 256 &&
+       !(util_cpu_caps.has_avx512f && HAVE_LLVM >= 0x0306)) {
+      lp_native_vector_width = 256;
+   }
+   lp_native_vector_width = MIN2(lp_native_vector_width, LP_MAX_VECTOR_WIDTH);
+
+   if (lp_native_vector_width <= 256) {
+      util_cpu_caps.has_avx512f = 0;
+   }
+
    if (lp_native_vector_width <= 128) {
       /* Hide AVX support, as often LLVM AVX intrinsics are only guarded by
        * "util_cpu_caps.has_avx" predicate, and lack the
@@ -427,6 +471,7 @@ lp_build_init(void)
        */
       util_cpu_caps.has_avx = 0;
       util_cpu_caps.has_avx2 = 0;
+      util_cpu_caps.has_avx512f = 0;
       util_cpu_caps.has_f16c = 0;
    }
 
@@ -462,6 +507,7 @@ lp_build_init(void)
    util_cpu_caps.has_sse4_2 = 0;
    util_cpu_caps.has_avx = 0;
    util_cpu_caps.has_avx2 = 0;
+   util_cpu_caps.has_avx512f = 0;
    util_cpu_caps.has_f16c = 0;
 #endif
 
@@ -472,9 +518,16 @@ lp_build_init(void)
 
 /**
  * Create a new gallivm_state object.
+ *
+ * \param context  the LLVM context to build the IR in, or NULL to create
+ *                 one which is disposed together with the IR.  Modules
+ *                 compiled in the background need a context of their own.
+ * \param cache  optional object code cache, see struct lp_cached_code.  It
+ *               must stay valid until gallivm_free_ir() is called.
  */
 struct gallivm_state *
-gallivm_create(const char *name, LLVMContextRef context)
+gallivm_create(const char *name, LLVMContextRef context,
+               struct lp_cached_code *cache)
 {
    struct gallivm_state *gallivm;
 
@@ -484,6 +537,9 @@ gallivm_create(const char *name, LLVMContextRef context)
          FREE(gallivm);
          gallivm = NULL;
       }
+      else {
+         gallivm->cache = cache;
+      }
    }
 
    return gallivm;
@@ -496,6 +552,7 @@ gallivm_create(const char *name, LLVMContextRef context)
 void
 gallivm_destroy(struct gallivm_state *gallivm)
 {
+   gallivm_wait_compile(gallivm);
    gallivm_free_ir(gallivm);
    gallivm_free_code(gallivm);
    FREE(gallivm);
@@ -548,6 +605,7 @@ gallivm_compile_module(struct gallivm_state *gallivm)
       time_begin = os_time_get();
 
    /* Run optimization passes */
+   add_optimization_passes(gallivm);
    LLVMInitializeFunctionPassManager(gallivm->passmgr);
    func = LLVMGetFirstFunction(gallivm->module);
    while (func) {
@@ -643,3 +701,227 @@ gallivm_jit_function(struct gallivm_state *gallivm,
 
    return jit_func;
 }
+
+
+/*
+ * Background compilation.
+ *
+ * Optimizing and generating code for a big module can take long enough to
+ * stall rendering noticeably.  Modules built in a LLVM context of their own
+ * can instead be compiled by a small pool of worker threads, while the
+ * caller makes do with something cheaper in the meantime, such as an
+ * unoptimized build of the same code.
+ */
+
+#define GALLIVM_MAX_COMPILE_THREADS 4
+
+/** Smaller modules are quicker to compile right away */
+#define GALLIVM_ASYNC_COMPILE_MIN_INSTRS 1000
+
+struct gallivm_compile_job
+{
+   struct gallivm_compile_job *next, *prev;
+   struct gallivm_state *gallivm;
+   gallivm_compile_done_func done;
+   void *data;
+};
+
+static struct {
+   unsigned refcount;
+   unsigned num_threads;
+   boolean exit;
+   pipe_thread threads[GALLIVM_MAX_COMPILE_THREADS];
+   pipe_condvar queue_cond;      /**< signalled when a job is queued */
+   pipe_condvar done_cond;       /**< broadcast when a job is done */
+   struct gallivm_compile_job queue;
+} compile_pool;
+
+pipe_static_mutex(compile_pool_mutex);
+
+
+static PIPE_THREAD_ROUTINE(compile_thread_function, init_data)
+{
+   struct gallivm_compile_job *job;
+
+   pipe_thread_setname("gallivm-jit");
+
+   pipe_mutex_lock(compile_pool_mutex);
+   while (1) {
+      while (!compile_pool.exit && is_empty_list(&compile_pool.queue))
+         pipe_condvar_wait(compile_pool.queue_cond, compile_pool_mutex);
+
+      /* Jobs still queued get done before exiting. */
+      if (is_empty_list(&compile_pool.queue))
+         break;
+
+      job = first_elem(&compile_pool.queue);
+      remove_from_list(job);
+      pipe_mutex_unlock(compile_pool_mutex);
+
+      gallivm_compile_module(job->gallivm);
+      job->done(job->gallivm, job->data);
+
+      pipe_mutex_lock(compile_pool_mutex);
+      job->gallivm->compile_pending = FALSE;
+      FREE(job);
+      pipe_condvar_broadcast(compile_pool.done_cond);
+   }
+   pipe_mutex_unlock(compile_pool_mutex);
+
+   return 0;
+}
+
+
+/**
+ * Take a reference to the compile threads, starting them with the first
+ * one.  The number of threads defaults to one less than the number of CPUs
+ * and can be changed with GALLIVM_COMPILE_THREADS.
+ *
+ * \return FALSE if there are no compile threads, in which case
+ *         gallivm_compile_module_async() always declines.
+ */
+boolean
+gallivm_start_compile_threads(void)
+{
+#if USE_MCJIT
+   unsigned num_threads, i;
+   boolean ret;
+
+   if (!lp_build_init())
+      return FALSE;
+
+   pipe_mutex_lock(compile_pool_mutex);
+
+   if (compile_pool.refcount++ == 0) {
+      num_threads = util_cpu_caps.nr_cpus > 1 ? util_cpu_caps.nr_cpus - 1 : 0;
+      num_threads = debug_get_num_option("GALLIVM_COMPILE_THREADS",
+                                         num_threads);
+      num_threads = MIN2(num_threads, GALLIVM_MAX_COMPILE_THREADS);
+
+      make_empty_list(&compile_pool.queue);
+      pipe_condvar_init(compile_pool.queue_cond);
+      pipe_condvar_init(compile_pool.done_cond);
+      compile_pool.exit = FALSE;
+
+      for (i = 0; i < num_threads; i++) {
+         compile_pool.threads[i] =
+            pipe_thread_create(compile_thread_function, NULL);
+      }
+      compile_pool.num_threads = num_threads;
+   }
+
+   ret = compile_pool.num_threads > 0;
+
+   pipe_mutex_unlock(compile_pool_mutex);
+
+   return ret;
+#else
+   /* The old JIT generates code lazily, on the calling thread. */
+   return FALSE;
+#endif
+}
+
+
+/**
+ * Drop a reference to the compile threads, and stop them with the last one
+ * once they're done with all the modules handed to them.
+ */
+void
+gallivm_stop_compile_threads(void)
+{
+#if USE_MCJIT
+   unsigned num_threads, i;
+
+   pipe_mutex_lock(compile_pool_mutex);
+
+   assert(compile_pool.refcount);
+   if (--compile_pool.refcount) {
+      pipe_mutex_unlock(compile_pool_mutex);
+      return;
+   }
+
+   compile_pool.exit = TRUE;
+   pipe_condvar_broadcast(compile_pool.queue_cond);
+   num_threads = compile_pool.num_threads;
+   compile_pool.num_threads = 0;
+
+   pipe_mutex_unlock(compile_pool_mutex);
+
+   for (i = 0; i < num_threads; i++) {
+      pipe_thread_wait(compile_pool.threads[i]);
+   }
+
+   pipe_condvar_destroy(compile_pool.queue_cond);
+   pipe_condvar_destroy(compile_pool.done_cond);
+#endif
+}
+
+
+/**
+ * Compile a module on one of the compile threads.
+ *
+ * The module must have been created with a LLVM context of its own, and
+ * mustn't be touched until \p done has been called, or until
+ * gallivm_wait_compile() returns.
+ *
+ * \return FALSE if the module should rather be compiled right away with
+ *         gallivm_compile_module(): there are no compile threads, or the
+ *         module is small enough.
+ */
+boolean
+gallivm_compile_module_async(struct gallivm_state *gallivm,
+                             gallivm_compile_done_func done,
+                             void *data)
+{
+   struct gallivm_compile_job *job;
+
+   if (!gallivm->own_context || gallivm->compiled)
+      return FALSE;
+
+   if (lp_build_count_ir_module(gallivm->module) <
+       GALLIVM_ASYNC_COMPILE_MIN_INSTRS)
+      return FALSE;
+
+   job = CALLOC_STRUCT(gallivm_compile_job);
+   if (!job)
+      return FALSE;
+
+   job->gallivm = gallivm;
+   job->done = done;
+   job->data = data;
+
+   if (gallivm_debug & GALLIVM_DEBUG_PERF) {
+      debug_printf("compiling module %s in the background\n",
+                   lp_get_module_id(gallivm->module));
+   }
+
+   pipe_mutex_lock(compile_pool_mutex);
+   if (!compile_pool.num_threads) {
+      pipe_mutex_unlock(compile_pool_mutex);
+      FREE(job);
+      return FALSE;
+   }
+   gallivm->compile_pending = TRUE;
+   insert_at_tail(&compile_pool.queue, job);
+   pipe_condvar_signal(compile_pool.queue_cond);
+   pipe_mutex_unlock(compile_pool_mutex);
+
+   return TRUE;
+}
+
+
+/**
+ * Wait for a module handed to gallivm_compile_module_async() to be
+ * compiled.  Returns immediately for any other module.
+ */
+void
+gallivm_wait_compile(struct gallivm_state *gallivm)
+{
+   if (!gallivm->compile_pending)
+      return;
+
+   pipe_mutex_lock(compile_pool_mutex);
+   while (gallivm->compile_pending)
+      pipe_condvar_wait(compile_pool.done_cond, compile_pool_mutex);
+   pipe_mutex_unlock(compile_pool_mutex);
+}
@@ -35,6 +35,31 @@
 #include "lp_bld.h"
 #include <llvm-c/ExecutionEngine.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+struct lp_helper_cache;
+
+
+/**
+ * Compiled object code handed in and out of gallivm_compile_module().
+ *
+ * If data is non-NULL on entry the object is loaded from it instead of
+ * running LLVM code generation; otherwise, the freshly generated object is
+ * returned in data (malloc'ed, to be freed by the caller) unless dont_cache
+ * was set while building the IR, e.g. because it embeds absolute addresses
+ * which are only valid in this process.
+ */
+struct lp_cached_code
+{
+   void *data;
+   size_t data_size;
+   boolean dont_cache;
+   void *jit_obj_cache;
+};
+
 
 struct gallivm_state
 {
@@ -46,16 +71,36 @@ struct gallivm_state
    LLVMBuilderRef builder;
    LLVMMCJITMemoryManagerRef memorymgr;
    struct lp_generated_code *code;
+   struct lp_cached_code *cache;
+   /** Optional helper functions shared with other modules, see lp_bld_helper.c */
+   struct lp_helper_cache *helpers;
    unsigned compiled;
+
+   /** Skip the optimization passes and use the fastest code generation */
+   boolean no_opt;
+   /** The context was created by gallivm_create() and goes with the IR */
+   boolean own_context;
+   /** Being compiled by a worker thread, protected by the worker lock */
+   boolean compile_pending;
 };
 
 
+/**
+ * Called on the worker thread once the module is compiled.  This is the
+ * place to get the function pointers with gallivm_jit_function() and to
+ * free the IR.
+ */
+typedef void
+(*gallivm_compile_done_func)(struct gallivm_state *gallivm, void *data);
+
+
 boolean
 lp_build_init(void);
 
 
 struct gallivm_state *
-gallivm_create(const char *name, LLVMContextRef context);
+gallivm_create(const char *name, LLVMContextRef context,
+               struct lp_cached_code *cache);
 
 void
 gallivm_destroy(struct gallivm_state *gallivm);
@@ -70,6 +115,20 @@ gallivm_verify_function(struct gallivm_state *gallivm,
 void
 gallivm_compile_module(struct gallivm_state *gallivm);
 
+boolean
+gallivm_start_compile_threads(void);
+
+void
+gallivm_stop_compile_threads(void);
+
+boolean
+gallivm_compile_module_async(struct gallivm_state *gallivm,
+                             gallivm_compile_done_func done,
+                             void *data);
+
+void
+gallivm_wait_compile(struct gallivm_state *gallivm);
+
 func_pointer
 gallivm_jit_function(struct gallivm_state *gallivm,
                      LLVMValueRef func);
@@ -82,4 +141,8 @@ void
 lp_set_store_alignment(LLVMValueRef Inst,
 		       unsigned Align);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* !LP_BLD_INIT_H */
@@ -65,6 +65,7 @@
 #include <llvm/ExecutionEngine/JITMemoryManager.h>
 #else
 #include <llvm/ExecutionEngine/SectionMemoryManager.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
 #endif
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/Host.h>
@@ -87,6 +88,7 @@
 #include "util/u_debug.h"
 #include "util/u_cpu_detect.h"
 
+#include "lp_bld_init.h"
 #include "lp_bld_misc.h"
 
 namespace {
@@ -422,6 +424,55 @@ class ShaderMemoryManager : public DelegatingJITMemoryManager {
 };
 
 
+#if HAVE_LLVM >= 0x0306
+/**
+ * MCJIT object cache backed by a struct lp_cached_code.
+ *
+ * MCJIT asks for the object before running code generation, and hands the
+ * object back once generated if it had to produce it.  Each engine holds a
+ * single module, so a single object is all there is to remember.
+ */
+class LPObjectCache : public llvm::ObjectCache {
+   private:
+      struct lp_cached_code *cache;
+
+   public:
+      LPObjectCache(struct lp_cached_code *cache) :
+         cache(cache)
+      {
+      }
+
+      ~LPObjectCache()
+      {
+      }
+
+      void notifyObjectCompiled(const llvm::Module *M,
+                                llvm::MemoryBufferRef Obj)
+      {
+         if (cache->dont_cache || cache->data)
+            return;
+
+         cache->data = malloc(Obj.getBufferSize());
+         if (!cache->data)
+            return;
+         memcpy(cache->data, Obj.getBufferStart(), Obj.getBufferSize());
+         cache->data_size = Obj.getBufferSize();
+      }
+
+      std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *M)
+      {
+         if (!cache->data)
+            return NULL;
+
+         return llvm::MemoryBuffer::getMemBuffer(
+                   llvm::StringRef((const char *)cache->data,
+                                   cache->data_size),
+                   "", false);
+      }
+};
+#endif
+
+
 /**
  * Same as LLVMCreateJITCompilerForModule, but:
  * - allows using MCJIT and enabling AVX feature where available.
@@ -440,6 +491,7 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
                                         LLVMMCJITMemoryManagerRef CMM,
                                         unsigned OptLevel,
                                         int useMCJIT,
+                                        struct lp_cached_code *cache,
                                         char **OutError)
 {
    using namespace llvm;
@@ -532,6 +584,9 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
    MAttrs.push_back(util_cpu_caps.has_avx  ? "+avx"  : "-avx");
    MAttrs.push_back(util_cpu_caps.has_f16c ? "+f16c" : "-f16c");
    MAttrs.push_back(util_cpu_caps.has_avx2 ? "+avx2" : "-avx2");
+#if HAVE_LLVM >= 0x0306
+   MAttrs.push_back(util_cpu_caps.has_avx512f ? "+avx512f" : "-avx512f");
+#endif
 #endif
 
 #if defined(PIPE_ARCH_PPC)
@@ -596,6 +651,13 @@ lp_build_create_jit_compiler_for_module(LLVMExecutionEngineRef *OutJIT,
 
    JIT = builder.create();
    if (JIT) {
+#if HAVE_LLVM >= 0x0306
+      if (cache) {
+         LPObjectCache *objcache = new LPObjectCache(cache);
+         cache->jit_obj_cache = objcache;
+         JIT->setObjectCache(objcache);
+      }
+#endif
       *OutJIT = wrap(JIT);
       return 0;
    }
@@ -614,6 +676,15 @@ lp_free_generated_code(struct lp_generated_code *code)
    ShaderMemoryManager::freeGeneratedCode(code);
 }
 
+extern "C"
+void
+lp_free_objcache(void *objcache)
+{
+#if HAVE_LLVM >= 0x0306
+   delete reinterpret_cast<LPObjectCache *>(objcache);
+#endif
+}
+
 extern "C"
 LLVMMCJITMemoryManagerRef
 lp_get_default_memory_manager()
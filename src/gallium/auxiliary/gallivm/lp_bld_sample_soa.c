@@ -55,6 +55,8 @@
 #include "lp_bld_flow.h"
 #include "lp_bld_gather.h"
 #include "lp_bld_format.h"
+#include "lp_bld_helper.h"
+#include "lp_bld_init.h"
 #include "lp_bld_sample.h"
 #include "lp_bld_sample_aos.h"
 #include "lp_bld_struct.h"
@@ -3108,7 +3110,7 @@ lp_build_sample_gen_func(struct gallivm_state *gallivm,
    if (dynamic_state->cache_ptr) {
       const struct util_format_description *format_desc;
       format_desc = util_format_description(static_texture_state->format);
-      if (format_desc && format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC) {
+      if (format_desc && lp_build_format_is_cached(format_desc)) {
          need_cache = TRUE;
       }
    }
@@ -3184,9 +3186,55 @@ lp_build_sample_gen_func(struct gallivm_state *gallivm,
 }
 
 
+struct lp_build_sample_helper_data
+{
+   const struct lp_static_texture_state *static_texture_state;
+   const struct lp_static_sampler_state *static_sampler_state;
+   struct lp_sampler_dynamic_state *dynamic_state;
+   const struct lp_sampler_params *params;
+   unsigned num_param;
+};
+
+
+/**
+ * Everything the code of a shared sampling function depends on, besides
+ * the units and sample key in its name and the function type.
+ */
+struct lp_build_sample_helper_key
+{
+   struct lp_static_texture_state static_texture_state;
+   struct lp_static_sampler_state static_sampler_state;
+   struct lp_sampler_dynamic_state dynamic_state;
+   struct lp_type type;
+};
+
+
+static void
+lp_build_sample_helper(struct gallivm_state *gallivm,
+                       LLVMValueRef function,
+                       void *data)
+{
+   const struct lp_build_sample_helper_data *helper = data;
+
+   lp_build_sample_gen_func(gallivm,
+                            helper->static_texture_state,
+                            helper->static_sampler_state,
+                            helper->dynamic_state,
+                            helper->params->type,
+                            helper->params->texture_index,
+                            helper->params->sampler_index,
+                            function,
+                            helper->num_param,
+                            helper->params->sample_key);
+}
+
+
 /**
  * Call the matching function for texture sampling.
  * If there's no match, generate a new one.
+ *
+ * The function is taken from the gallivm helpers if there are any, so that
+ * it gets compiled only once for all variants, or else from the module.
  */
 static void
 lp_build_sample_soa_func(struct gallivm_state *gallivm,
@@ -3200,8 +3248,12 @@ lp_build_sample_soa_func(struct gallivm_state *gallivm,
                              LLVMGetInsertBlock(builder)));
    LLVMValueRef function, inst;
    LLVMValueRef args[LP_MAX_TEX_FUNC_ARGS];
+   LLVMTypeRef arg_types[LP_MAX_TEX_FUNC_ARGS];
+   LLVMTypeRef ret_type;
+   LLVMTypeRef function_type;
+   LLVMTypeRef val_type[4];
    LLVMBasicBlockRef bb;
-   LLVMValueRef tex_ret;
+   LLVMValueRef tex_ret = NULL;
    unsigned num_args = 0;
    char func_name[64];
    unsigned i, num_coords, num_derivs, num_offsets, layer;
@@ -3223,7 +3275,7 @@ lp_build_sample_soa_func(struct gallivm_state *gallivm,
    if (dynamic_state->cache_ptr) {
       const struct util_format_description *format_desc;
       format_desc = util_format_description(static_texture_state->format);
-      if (format_desc && format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC) {
+      if (format_desc && lp_build_format_is_cached(format_desc)) {
          /*
           * This is not 100% correct, if we have cache but the
           * util_format_s3tc_prefer is true the cache won't get used
@@ -3242,90 +3294,21 @@ lp_build_sample_soa_func(struct gallivm_state *gallivm,
    util_snprintf(func_name, sizeof(func_name), "texfunc_res_%d_sam_%d_%x",
                  texture_index, sampler_index, sample_key);
 
-   function = LLVMGetNamedFunction(module, func_name);
-
-   if(!function) {
-      LLVMTypeRef arg_types[LP_MAX_TEX_FUNC_ARGS];
-      LLVMTypeRef ret_type;
-      LLVMTypeRef function_type;
-      LLVMTypeRef val_type[4];
-      unsigned num_param = 0;
-
-      /*
-       * Generate the function prototype.
-       */
-
-      arg_types[num_param++] = LLVMTypeOf(params->context_ptr);
-      if (need_cache) {
-         arg_types[num_param++] = LLVMTypeOf(params->thread_data_ptr);
-      }
-      for (i = 0; i < num_coords; i++) {
-         arg_types[num_param++] = LLVMTypeOf(coords[0]);
-         assert(LLVMTypeOf(coords[0]) == LLVMTypeOf(coords[i]));
-      }
-      if (layer) {
-         arg_types[num_param++] = LLVMTypeOf(coords[layer]);
-         assert(LLVMTypeOf(coords[0]) == LLVMTypeOf(coords[layer]));
-      }
-      if (sample_key & LP_SAMPLER_SHADOW) {
-         arg_types[num_param++] = LLVMTypeOf(coords[0]);
-      }
-      if (sample_key & LP_SAMPLER_OFFSETS) {
-         for (i = 0; i < num_offsets; i++) {
-            arg_types[num_param++] = LLVMTypeOf(offsets[0]);
-            assert(LLVMTypeOf(offsets[0]) == LLVMTypeOf(offsets[i]));
-         }
-      }
-      if (lod_control == LP_SAMPLER_LOD_BIAS ||
-          lod_control == LP_SAMPLER_LOD_EXPLICIT) {
-         arg_types[num_param++] = LLVMTypeOf(params->lod);
-      }
-      else if (lod_control == LP_SAMPLER_LOD_DERIVATIVES) {
-         for (i = 0; i < num_derivs; i++) {
-            arg_types[num_param++] = LLVMTypeOf(derivs->ddx[i]);
-            arg_types[num_param++] = LLVMTypeOf(derivs->ddy[i]);
-            assert(LLVMTypeOf(derivs->ddx[0]) == LLVMTypeOf(derivs->ddx[i]));
-            assert(LLVMTypeOf(derivs->ddy[0]) == LLVMTypeOf(derivs->ddy[i]));
-         }
-      }
-
-      val_type[0] = val_type[1] = val_type[2] = val_type[3] =
-         lp_build_vec_type(gallivm, params->type);
-      ret_type = LLVMStructTypeInContext(gallivm->context, val_type, 4, 0);
-      function_type = LLVMFunctionType(ret_type, arg_types, num_param, 0);
-      function = LLVMAddFunction(module, func_name, function_type);
-
-      for (i = 0; i < num_param; ++i) {
-         if(LLVMGetTypeKind(arg_types[i]) == LLVMPointerTypeKind) {
-            LLVMAddAttribute(LLVMGetParam(function, i), LLVMNoAliasAttribute);
-         }
-      }
-
-      LLVMSetFunctionCallConv(function, LLVMFastCallConv);
-      LLVMSetLinkage(function, LLVMPrivateLinkage);
-
-      lp_build_sample_gen_func(gallivm,
-                               static_texture_state,
-                               static_sampler_state,
-                               dynamic_state,
-                               params->type,
-                               texture_index,
-                               sampler_index,
-                               function,
-                               num_param,
-                               sample_key);
-   }
+   /*
+    * Gather the arguments, and generate the function prototype out of them.
+    */
 
-   num_args = 0;
    args[num_args++] = params->context_ptr;
    if (need_cache) {
       args[num_args++] = params->thread_data_ptr;
    }
    for (i = 0; i < num_coords; i++) {
       args[num_args++] = coords[i];
+      assert(LLVMTypeOf(coords[0]) == LLVMTypeOf(coords[i]));
    }
    if (layer) {
       args[num_args++] = coords[layer];
+      assert(LLVMTypeOf(coords[0]) == LLVMTypeOf(coords[layer]));
    }
    if (sample_key & LP_SAMPLER_SHADOW) {
       args[num_args++] = coords[4];
@@ -3333,6 +3316,7 @@ lp_build_sample_soa_func(struct gallivm_state *gallivm,
    if (sample_key & LP_SAMPLER_OFFSETS) {
       for (i = 0; i < num_offsets; i++) {
          args[num_args++] = offsets[i];
+         assert(LLVMTypeOf(offsets[0]) == LLVMTypeOf(offsets[i]));
       }
    }
    if (lod_control == LP_SAMPLER_LOD_BIAS ||
@@ -3343,15 +3327,75 @@ lp_build_sample_soa_func(struct gallivm_state *gallivm,
       for (i = 0; i < num_derivs; i++) {
          args[num_args++] = derivs->ddx[i];
          args[num_args++] = derivs->ddy[i];
+         assert(LLVMTypeOf(derivs->ddx[0]) == LLVMTypeOf(derivs->ddx[i]));
+         assert(LLVMTypeOf(derivs->ddy[0]) == LLVMTypeOf(derivs->ddy[i]));
       }
    }
 
    assert(num_args <= LP_MAX_TEX_FUNC_ARGS);
 
-   tex_ret = LLVMBuildCall(builder, function, args, num_args, "");
-   bb = LLVMGetInsertBlock(builder);
-   inst = LLVMGetLastInstruction(bb);
-   LLVMSetInstructionCallConv(inst, LLVMFastCallConv);
+   for (i = 0; i < num_args; i++) {
+      arg_types[i] = LLVMTypeOf(args[i]);
+   }
+
+   val_type[0] = val_type[1] = val_type[2] = val_type[3] =
+      lp_build_vec_type(gallivm, params->type);
+   ret_type = LLVMStructTypeInContext(gallivm->context, val_type, 4, 0);
+   function_type = LLVMFunctionType(ret_type, arg_types, num_args, 0);
+
+   if (gallivm->helpers) {
+      struct lp_build_sample_helper_key key;
+      struct lp_build_sample_helper_data data;
+
+      memset(&key, 0, sizeof key);
+      key.static_texture_state = *static_texture_state;
+      key.static_sampler_state = *static_sampler_state;
+      key.dynamic_state = *dynamic_state;
+      key.type = params->type;
+
+      data.static_texture_state = static_texture_state;
+      data.static_sampler_state = static_sampler_state;
+      data.dynamic_state = dynamic_state;
+      data.params = params;
+      data.num_param = num_args;
+
+      tex_ret = lp_build_helper_call(gallivm, func_name, &key, sizeof key,
+                                     function_type, lp_build_sample_helper,
+                                     &data, args, num_args);
+   }
+
+   if (!tex_ret) {
+      function = LLVMGetNamedFunction(module, func_name);
+
+      if(!function) {
+         function = LLVMAddFunction(module, func_name, function_type);
+
+         for (i = 0; i < num_args; ++i) {
+            if(LLVMGetTypeKind(arg_types[i]) == LLVMPointerTypeKind) {
+               LLVMAddAttribute(LLVMGetParam(function, i), LLVMNoAliasAttribute);
+            }
+         }
+
+         LLVMSetFunctionCallConv(function, LLVMFastCallConv);
+         LLVMSetLinkage(function, LLVMPrivateLinkage);
+
+         lp_build_sample_gen_func(gallivm,
+                                  static_texture_state,
+                                  static_sampler_state,
+                                  dynamic_state,
+                                  params->type,
+                                  texture_index,
+                                  sampler_index,
+                                  function,
+                                  num_args,
+                                  sample_key);
+      }
+
+      tex_ret = LLVMBuildCall(builder, function, args, num_args, "");
+      bb = LLVMGetInsertBlock(builder);
+      inst = LLVMGetLastInstruction(bb);
+      LLVMSetInstructionCallConv(inst, LLVMFastCallConv);
+   }
 
    for (i = 0; i < 4; i++) {
       params->texel[i] = LLVMBuildExtractValue(gallivm->builder, tex_ret, i, "");
@@ -63,6 +63,7 @@ struct lp_build_mask_context;
 struct gallivm_state;
 struct lp_derivatives;
 struct lp_build_tgsi_gs_iface;
+struct lp_build_tgsi_cs_iface;
 
 
 enum lp_build_tex_modifier {
@@ -166,6 +167,12 @@ struct lp_bld_tgsi_system_values {
    LLVMValueRef prim_id;
    LLVMValueRef basevertex;
    LLVMValueRef invocation_id;
+
+   /* Compute shaders: thread_id is a vector, the others are scalars. */
+   LLVMValueRef thread_id[3];
+   LLVMValueRef block_id[3];
+   LLVMValueRef grid_size[3];
+   LLVMValueRef block_size[3];
 };
 
 
@@ -233,7 +240,8 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
                   LLVMValueRef thread_data_ptr,
                   struct lp_build_sampler_soa *sampler,
                   const struct tgsi_shader_info *info,
-                  const struct lp_build_tgsi_gs_iface *gs_iface);
+                  const struct lp_build_tgsi_gs_iface *gs_iface,
+                  const struct lp_build_tgsi_cs_iface *cs_iface);
 
 
 void
@@ -396,6 +404,12 @@ struct lp_build_tgsi_context
      */
    void (*emit_prologue)(struct lp_build_tgsi_context*);
 
+   /** This function allows the user to insert some instructions after the
+     * declarations have been processed, right before the first instruction.
+     * It is optional.
+     */
+   void (*emit_prologue_post_decl)(struct lp_build_tgsi_context*);
+
    /** This function allows the user to insert some instructions at the end of
      * the program.  This callback is intended to be used for emitting
      * instructions to handle the export for the output registers, but it can
@@ -428,6 +442,32 @@ struct lp_build_tgsi_gs_iface
                        LLVMValueRef emitted_prims_vec);
 };
 
+/**
+ * Compute shader interface.
+ *
+ * Shaders with barriers are run in phases, each phase running the code
+ * between two barriers for all the threads of a block before the next
+ * phase starts.  The temporaries are kept in temps_ptr so that they
+ * survive from one phase to the next.
+ */
+struct lp_build_tgsi_cs_iface
+{
+   /**
+    * Return the base address (i8 *) of the given RESOURCE register, and its
+    * size in bytes in \p size.
+    */
+   LLVMValueRef (*resource_ptr)(const struct lp_build_tgsi_cs_iface *cs_iface,
+                                struct lp_build_tgsi_context * bld_base,
+                                unsigned index,
+                                LLVMValueRef *size);
+
+   /** Which phase to run (i32), or NULL if barriers aren't supported. */
+   LLVMValueRef phase;
+
+   /** Storage (i8 *) for the temporaries, used when phase is set. */
+   LLVMValueRef temps_ptr;
+};
+
 struct lp_build_tgsi_soa_context
 {
    struct lp_build_tgsi_context bld_base;
@@ -441,6 +481,11 @@ struct lp_build_tgsi_soa_context
    LLVMValueRef emitted_vertices_vec_ptr;
    LLVMValueRef max_output_vertices_vec;
 
+   const struct lp_build_tgsi_cs_iface *cs_iface;
+   /** Switch dispatching to the code following each barrier. */
+   LLVMValueRef phase_switch;
+   unsigned num_phases;
+
    LLVMValueRef consts_ptr;
    LLVMValueRef const_sizes_ptr;
    LLVMValueRef consts[LP_MAX_TGSI_CONST_BUFFERS];
@@ -1678,6 +1678,33 @@ emit_fetch_system_value(
       atype = TGSI_TYPE_UNSIGNED;
       break;
 
+   case TGSI_SEMANTIC_THREAD_ID:
+      if (swizzle < 3 && bld->system_values.thread_id[swizzle])
+         res = bld->system_values.thread_id[swizzle];
+      else
+         res = bld_base->uint_bld.zero;
+      atype = TGSI_TYPE_UNSIGNED;
+      break;
+
+   case TGSI_SEMANTIC_BLOCK_ID:
+   case TGSI_SEMANTIC_GRID_SIZE:
+   case TGSI_SEMANTIC_BLOCK_SIZE:
+   {
+      const unsigned semantic =
+         info->system_value_semantic_name[reg->Register.Index];
+      const LLVMValueRef *values =
+         semantic == TGSI_SEMANTIC_BLOCK_ID ? bld->system_values.block_id :
+         semantic == TGSI_SEMANTIC_GRID_SIZE ? bld->system_values.grid_size :
+                                               bld->system_values.block_size;
+
+      if (swizzle < 3 && values[swizzle])
+         res = lp_build_broadcast_scalar(&bld_base->uint_bld, values[swizzle]);
+      else
+         res = bld_base->uint_bld.zero;
+      atype = TGSI_TYPE_UNSIGNED;
+      break;
+   }
+
    default:
       assert(!"unexpected semantic in emit_fetch_system_value");
       res = bld_base->base.zero;
@@ -2028,7 +2055,9 @@ emit_store(
    unsigned chan_index;
    struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
    enum tgsi_opcode_type dtype = tgsi_opcode_infer_dst_type(inst->Instruction.Opcode);
-   if(info->num_dst) {
+
+   /* STORE writes its resource itself. */
+   if(info->num_dst && inst->Dst[0].Register.File != TGSI_FILE_RESOURCE) {
       LLVMValueRef pred[TGSI_NUM_CHANNELS];
 
       emit_fetch_predicate( bld, inst, pred );
@@ -3734,12 +3763,219 @@ cont_emit(
    lp_exec_continue(&bld->exec_mask);
 }
 
+/**
+ * Whether the shader is split in phases at its barriers.
+ */
+static inline boolean
+uses_phases(const struct lp_build_tgsi_soa_context *bld)
+{
+   return bld->cs_iface && bld->cs_iface->phase &&
+          bld->bld_base.info->opcode_count[TGSI_OPCODE_BARRIER] > 0;
+}
+
+/**
+ * Return the byte offsets of the given channel of a LOAD or STORE, and in
+ * \p valid which of them are in bounds of the resource.  Offsets out of
+ * bounds are replaced by zero, so that they can be gathered from safely.
+ */
+static LLVMValueRef
+get_resource_offsets(struct lp_build_tgsi_soa_context *bld,
+                     LLVMValueRef offset,
+                     LLVMValueRef size,
+                     unsigned chan,
+                     LLVMValueRef *valid)
+{
+   struct gallivm_state *gallivm = bld->bld_base.base.gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_build_context *uint_bld = &bld->bld_base.uint_bld;
+   LLVMValueRef size_vec = lp_build_broadcast_scalar(uint_bld, size);
+   LLVMValueRef chan_offset, in_size, room;
+
+   chan_offset = LLVMBuildAdd(builder, offset,
+                              lp_build_const_int_vec(gallivm, uint_bld->type,
+                                                     chan * 4), "");
+
+   /* offset + 4 <= size, without overflowing */
+   in_size = lp_build_cmp(uint_bld, PIPE_FUNC_LESS, chan_offset, size_vec);
+   room = LLVMBuildSub(builder, size_vec, chan_offset, "");
+   room = lp_build_cmp(uint_bld, PIPE_FUNC_GEQUAL, room,
+                       lp_build_const_int_vec(gallivm, uint_bld->type, 4));
+   *valid = LLVMBuildAnd(builder, in_size, room, "");
+
+   return lp_build_select(uint_bld, *valid, chan_offset, uint_bld->zero);
+}
+
+/**
+ * LOAD dst, RES[x], addr
+ *
+ * Only raw buffer access is supported: each enabled channel is read from
+ * the dword at byte offset addr.x + 4 * chan.  Reads out of bounds return
+ * zero.
+ */
+static void
+load_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   const struct tgsi_full_instruction *inst = emit_data->inst;
+   struct lp_build_context *uint_bld = &bld_base->uint_bld;
+   LLVMValueRef base, size, offset;
+   unsigned chan;
+
+   if (!bld->cs_iface ||
+       inst->Src[0].Register.File != TGSI_FILE_RESOURCE) {
+      assert(0);
+      TGSI_FOR_EACH_DST0_ENABLED_CHANNEL(inst, chan) {
+         emit_data->output[chan] = bld_base->base.zero;
+      }
+      return;
+   }
+
+   base = bld->cs_iface->resource_ptr(bld->cs_iface, bld_base,
+                                      inst->Src[0].Register.Index, &size);
+   offset = lp_build_emit_fetch(bld_base, inst, 1, TGSI_CHAN_X);
+   offset = LLVMBuildBitCast(builder, offset, uint_bld->vec_type, "");
+
+   TGSI_FOR_EACH_DST0_ENABLED_CHANNEL(inst, chan) {
+      LLVMValueRef valid, offsets, res;
+
+      offsets = get_resource_offsets(bld, offset, size, chan, &valid);
+      res = lp_build_gather(gallivm, uint_bld->type.length, 32, 32, TRUE,
+                            base, offsets, FALSE);
+      res = lp_build_select(uint_bld, valid, res, uint_bld->zero);
+      emit_data->output[chan] =
+         LLVMBuildBitCast(builder, res, bld_base->base.vec_type, "");
+   }
+}
+
+/**
+ * STORE RES[x], addr, src
+ *
+ * The counterpart of LOAD.  Each active element is written on its own, so
+ * that elements of other invocations in the same dwords are left alone.
+ */
+static void
+store_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   const struct tgsi_full_instruction *inst = emit_data->inst;
+   struct lp_build_context *uint_bld = &bld_base->uint_bld;
+   LLVMTypeRef int32_ptr_type =
+      LLVMPointerType(LLVMInt32TypeInContext(gallivm->context), 0);
+   LLVMValueRef base, size, offset, exec_mask;
+   unsigned chan, i;
+
+   if (!bld->cs_iface ||
+       inst->Dst[0].Register.File != TGSI_FILE_RESOURCE) {
+      assert(0);
+      return;
+   }
+
+   base = bld->cs_iface->resource_ptr(bld->cs_iface, bld_base,
+                                      inst->Dst[0].Register.Index, &size);
+   offset = lp_build_emit_fetch(bld_base, inst, 0, TGSI_CHAN_X);
+   offset = LLVMBuildBitCast(builder, offset, uint_bld->vec_type, "");
+   exec_mask = mask_vec(bld_base);
+
+   TGSI_FOR_EACH_DST0_ENABLED_CHANNEL(inst, chan) {
+      LLVMValueRef valid, offsets, value, store_mask;
+
+      offsets = get_resource_offsets(bld, offset, size, chan, &valid);
+      store_mask = LLVMBuildAnd(builder, valid, exec_mask, "");
+      value = lp_build_emit_fetch(bld_base, inst, 1, chan);
+      value = LLVMBuildBitCast(builder, value, uint_bld->vec_type, "");
+
+      for (i = 0; i < uint_bld->type.length; i++) {
+         LLVMValueRef ii = lp_build_const_int32(gallivm, i);
+         LLVMValueRef cond, ptr;
+         struct lp_build_if_state ifthen;
+
+         cond = LLVMBuildExtractElement(builder, store_mask, ii, "");
+         cond = LLVMBuildICmp(builder, LLVMIntNE, cond,
+                              lp_build_const_int32(gallivm, 0), "");
+
+         lp_build_if(&ifthen, gallivm, cond);
+         ptr = lp_build_gather_elem_ptr(gallivm, uint_bld->type.length,
+                                        base, offsets, i);
+         ptr = LLVMBuildBitCast(builder, ptr, int32_ptr_type, "");
+         LLVMBuildStore(builder,
+                        LLVMBuildExtractElement(builder, value, ii, ""),
+                        ptr);
+         lp_build_endif(&ifthen);
+      }
+   }
+}
+
+/**
+ * BARRIER
+ *
+ * With phases, the current phase ends here, and the code after the
+ * barrier becomes a new phase.  None of the masks computed so far are
+ * available in the new phase, so this only works outside of control flow;
+ * elsewhere the barrier is ignored.  The masks of invocations which
+ * returned from main before the barrier are not kept either.
+ */
+static void
+barrier_emit(
+   const struct lp_build_tgsi_action * action,
+   struct lp_build_tgsi_context * bld_base,
+   struct lp_build_emit_data * emit_data)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   LLVMBuilderRef builder = gallivm->builder;
+   struct lp_exec_mask *mask = &bld->exec_mask;
+   struct function_ctx *ctx = func_ctx(mask);
+   LLVMBasicBlockRef resume;
+
+   if (!bld->phase_switch)
+      return;
+
+   if (mask->function_stack_size > 1 ||
+       ctx->cond_stack_size ||
+       ctx->loop_stack_size ||
+       ctx->switch_stack_size) {
+      _debug_printf("warning: ignoring BARRIER inside control flow\n");
+      return;
+   }
+
+   LLVMBuildBr(builder, bld->mask->skip.block);
+
+   resume = lp_build_insert_new_block(gallivm, "barrier_resume");
+   LLVMAddCase(bld->phase_switch,
+               lp_build_const_int32(gallivm, bld->num_phases++), resume);
+   LLVMPositionBuilderAtEnd(builder, resume);
+
+   mask->has_mask = FALSE;
+   mask->ret_in_main = FALSE;
+   mask->exec_mask = mask->ret_mask = mask->break_mask = mask->cont_mask =
+         mask->cond_mask = mask->switch_mask =
+         LLVMConstAllOnes(mask->int_vec_type);
+   ctx->ret_mask = mask->ret_mask;
+}
+
 static void emit_prologue(struct lp_build_tgsi_context * bld_base)
 {
    struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
    struct gallivm_state * gallivm = bld_base->base.gallivm;
 
-   if (bld->indirect_files & (1 << TGSI_FILE_TEMPORARY)) {
+   if (uses_phases(bld)) {
+      /* The temporaries must survive from one phase to the next. */
+      bld->temps_array =
+         LLVMBuildBitCast(gallivm->builder, bld->cs_iface->temps_ptr,
+                          LLVMPointerType(bld_base->base.vec_type, 0),
+                          "temp_array");
+   }
+   else if (bld->indirect_files & (1 << TGSI_FILE_TEMPORARY)) {
       LLVMValueRef array_size =
          lp_build_const_int32(gallivm,
                          bld_base->info->file_max[TGSI_FILE_TEMPORARY] * 4 + 4);
@@ -3825,6 +4061,29 @@ static void emit_prologue(struct lp_build_tgsi_context * bld_base)
    }
 }
 
+/**
+ * Dispatch to the code of the phase being run, once the declarations have
+ * set up everything the phases share.
+ */
+static void emit_prologue_post_decl(struct lp_build_tgsi_context * bld_base)
+{
+   struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
+   struct gallivm_state * gallivm = bld_base->base.gallivm;
+   LLVMBasicBlockRef phase0;
+
+   if (!uses_phases(bld))
+      return;
+
+   phase0 = lp_build_insert_new_block(gallivm, "phase0");
+   bld->phase_switch =
+      LLVMBuildSwitch(gallivm->builder, bld->cs_iface->phase,
+                      bld->mask->skip.block,
+                      bld_base->info->opcode_count[TGSI_OPCODE_BARRIER] + 1);
+   LLVMAddCase(bld->phase_switch, lp_build_const_int32(gallivm, 0), phase0);
+   bld->num_phases = 1;
+   LLVMPositionBuilderAtEnd(gallivm->builder, phase0);
+}
+
 static void emit_epilogue(struct lp_build_tgsi_context * bld_base)
 {
    struct lp_build_tgsi_soa_context * bld = lp_soa_context(bld_base);
@@ -3877,7 +4136,8 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
                   LLVMValueRef thread_data_ptr,
                   struct lp_build_sampler_soa *sampler,
                   const struct tgsi_shader_info *info,
-                  const struct lp_build_tgsi_gs_iface *gs_iface)
+                  const struct lp_build_tgsi_gs_iface *gs_iface,
+                  const struct lp_build_tgsi_cs_iface *cs_iface)
 {
    struct lp_build_tgsi_soa_context bld;
 
@@ -3945,6 +4205,7 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
    bld.bld_base.emit_immediate = lp_emit_immediate_soa;
 
    bld.bld_base.emit_prologue = emit_prologue;
+   bld.bld_base.emit_prologue_post_decl = emit_prologue_post_decl;
    bld.bld_base.emit_epilogue = emit_epilogue;
 
    /* Set opcode actions */
@@ -4017,6 +4278,16 @@ lp_build_tgsi_soa(struct gallivm_state *gallivm,
                                 max_output_vertices);
    }
 
+   if (cs_iface) {
+      bld.cs_iface = cs_iface;
+      bld.bld_base.op_actions[TGSI_OPCODE_LOAD].emit = load_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_STORE].emit = store_emit;
+      bld.bld_base.op_actions[TGSI_OPCODE_BARRIER].emit = barrier_emit;
+
+      if (uses_phases(&bld))
+         bld.indirect_files |= (1 << TGSI_FILE_TEMPORARY);
+   }
+
    lp_exec_mask_init(&bld.exec_mask, &bld.bld_base.int_bld);
 
    bld.system_values = *system_values;
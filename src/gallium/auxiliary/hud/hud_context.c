@@ -33,6 +33,7 @@
  * Set GALLIUM_HUD=help for more info.
  */
 
+#include <inttypes.h>
 #include <signal.h>
 #include <stdio.h>
 
@@ -41,6 +42,7 @@
 #include "hud/font.h"
 
 #include "cso_cache/cso_context.h"
+#include "os/os_time.h"
 #include "util/u_draw_quad.h"
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
@@ -63,6 +65,9 @@ struct hud_context {
    struct hud_batch_query_context *batch_query;
    struct list_head pane_list;
 
+   /* GALLIUM_HUD_DUMP */
+   FILE *dump_file;
+
    /* states */
    struct pipe_blend_state alpha_blend;
    struct pipe_depth_stencil_alpha_state dsa;
@@ -452,8 +457,18 @@ hud_draw(struct hud_context *hud, struct pipe_resource *tex)
    struct hud_pane *pane;
    struct hud_graph *gr;
 
-   if (!huds_visible)
+   if (!huds_visible) {
+      /* Keep dumping values while the HUD is hidden. */
+      if (hud->dump_file) {
+         hud_batch_query_update(hud->batch_query);
+         LIST_FOR_EACH_ENTRY(pane, &hud->pane_list, head) {
+            LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+               gr->query_new_value(gr);
+            }
+         }
+      }
       return;
+   }
 
    hud->fb_width = tex->width0;
    hud->fb_height = tex->height0;
@@ -721,6 +736,11 @@ hud_pane_add_graph(struct hud_pane *pane, struct hud_graph *gr)
 void
 hud_graph_add_value(struct hud_graph *gr, uint64_t value)
 {
+   if (gr->dump_file) {
+      fprintf(gr->dump_file, "%" PRIu64 ",%s,%" PRIu64 "\n",
+              os_time_get(), gr->name, value);
+   }
+
    gr->current_value = value;
    value = value > gr->pane->ceiling ? gr->pane->ceiling : value;
 
@@ -911,6 +931,15 @@ hud_parse_env_var(struct hud_context *hud, const char *env)
       if (strcmp(name, "fps") == 0) {
          hud_fps_graph_install(pane);
       }
+      else if (strcmp(name, "frametime-p50") == 0) {
+         hud_frametime_graph_install(pane, 50);
+      }
+      else if (strcmp(name, "frametime-p99") == 0) {
+         hud_frametime_graph_install(pane, 99);
+      }
+      else if (strcmp(name, "frametime-max") == 0) {
+         hud_frametime_graph_install(pane, 100);
+      }
       else if (strcmp(name, "cpu") == 0) {
          hud_cpu_graph_install(pane, ALL_CPUS);
       }
@@ -936,10 +965,17 @@ hud_parse_env_var(struct hud_context *hud, const char *env)
                                 0);
       }
       else {
-         boolean processed = FALSE;
+         boolean processed;
+
+         /* CSO cache counters */
+         processed = hud_cso_graph_install(pane, hud->cso, name);
+
+         /* state tracker and driver CPU time */
+         if (!processed)
+            processed = hud_counter_graph_install(pane, name);
 
          /* pipeline statistics queries */
-         if (has_pipeline_stats_query(hud->pipe->screen)) {
+         if (!processed && has_pipeline_stats_query(hud->pipe->screen)) {
             static const char *pipeline_statistics_names[] =
             {
                "ia-vertices",
@@ -1057,6 +1093,34 @@ hud_parse_env_var(struct hud_context *hud, const char *env)
    }
 }
 
+/**
+ * Open the file named by GALLIUM_HUD_DUMP, if set, and make all graphs
+ * write their values to it.
+ */
+static void
+hud_open_dump_file(struct hud_context *hud)
+{
+   const char *filename = debug_get_option("GALLIUM_HUD_DUMP", NULL);
+   struct hud_pane *pane;
+   struct hud_graph *gr;
+
+   if (!filename)
+      return;
+
+   hud->dump_file = fopen(filename, "w");
+   if (!hud->dump_file) {
+      fprintf(stderr, "gallium_hud: can't open dump file %s\n", filename);
+      return;
+   }
+   fprintf(hud->dump_file, "time_us,graph,value\n");
+
+   LIST_FOR_EACH_ENTRY(pane, &hud->pane_list, head) {
+      LIST_FOR_EACH_ENTRY(gr, &pane->graph_list, head) {
+         gr->dump_file = hud->dump_file;
+      }
+   }
+}
+
 static void
 print_help(struct pipe_screen *screen)
 {
@@ -1100,13 +1164,32 @@ print_help(struct pipe_screen *screen)
    puts("");
    puts("  Example: GALLIUM_HUD=\".w256.h64.x1600.y520.d.c1000fps+cpu,.datom-count\"");
    puts("");
+   puts("  If GALLIUM_HUD_DUMP is set to a file name, every value shown is also");
+   puts("  written to that file as a \"time_us,graph,value\" CSV line, even while");
+   puts("  the HUD is hidden.");
+   puts("");
    puts("  Available names:");
    puts("    fps");
+   puts("    frametime-p50");
+   puts("    frametime-p99");
+   puts("    frametime-max");
    puts("    cpu");
 
    for (i = 0; i < num_cpus; i++)
       printf("    cpu%i\n", i);
 
+   puts("    cso-hits");
+   puts("    cso-misses");
+   puts("    cso-collisions");
+   puts("    cso-skips");
+   puts("    shader-compiles");
+   puts("    buffer-reallocs");
+   puts("    validate-time");
+   puts("    draw-time");
+   puts("    flush-time");
+   puts("    flushes");
+   puts("    throttle-time");
+
    if (has_occlusion_query(screen))
       puts("    samples-passed");
    if (has_streamout(screen))
@@ -1320,6 +1403,7 @@ hud_create(struct pipe_context *pipe, struct cso_context *cso)
 #endif
 
    hud_parse_env_var(hud, env);
+   hud_open_dump_file(hud);
    return hud;
 }
 
@@ -1339,6 +1423,9 @@ hud_destroy(struct hud_context *hud)
       FREE(pane);
    }
 
+   if (hud->dump_file)
+      fclose(hud->dump_file);
+
    hud_batch_query_cleanup(&hud->batch_query);
    pipe->delete_fs_state(pipe, hud->fs_color);
    pipe->delete_fs_state(pipe, hud->fs_text);
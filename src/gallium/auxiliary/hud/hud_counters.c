@@ -0,0 +1,140 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/* This file contains the counters of hud_counters.h and the graphs showing
+ * them on the HUD, as averages per frame.
+ */
+
+#include "hud/hud_private.h"
+#include "hud/hud_counters.h"
+#include "os/os_time.h"
+#include "util/u_memory.h"
+
+uint64_t hud_counters[HUD_NUM_COUNTERS];
+boolean hud_counters_timing;
+
+static const struct {
+   const char *name;
+   enum hud_counter counter;
+   boolean is_time;
+} counter_graphs[] = {
+   {"shader-compiles", HUD_COUNTER_SHADER_COMPILES, FALSE},
+   {"buffer-reallocs", HUD_COUNTER_BUFFER_REALLOCS, FALSE},
+   {"validate-time", HUD_COUNTER_VALIDATE_TIME, TRUE},
+   {"draw-time", HUD_COUNTER_DRAW_TIME, TRUE},
+   {"flush-time", HUD_COUNTER_FLUSH_TIME, TRUE},
+   {"flushes", HUD_COUNTER_FLUSHES, FALSE},
+   {"throttle-time", HUD_COUNTER_THROTTLE_TIME, TRUE},
+};
+
+struct counter_info {
+   enum hud_counter counter;
+   boolean is_time;
+   int frames;
+   uint64_t last_value;
+   uint64_t last_time;
+};
+
+static void
+query_counter(struct hud_graph *gr)
+{
+   struct counter_info *info = gr->query_data;
+   uint64_t now = os_time_get();
+   uint64_t value = p_atomic_read(&hud_counters[info->counter]);
+
+   info->frames++;
+
+   if (info->last_time) {
+      if (info->last_time + gr->pane->period <= now) {
+         uint64_t delta = (value - info->last_value) / info->frames;
+
+         /* Times are counted in nanoseconds and shown in microseconds. */
+         if (info->is_time)
+            delta /= 1000;
+
+         hud_graph_add_value(gr, delta);
+         info->frames = 0;
+         info->last_value = value;
+         info->last_time = now;
+      }
+   }
+   else {
+      info->frames = 0;
+      info->last_value = value;
+      info->last_time = now;
+   }
+}
+
+static void
+free_query_data(void *p)
+{
+   FREE(p);
+}
+
+/**
+ * Add a graph of one of the counters of hud_counters.h to \p pane, if
+ * \p name is one of them.
+ */
+boolean
+hud_counter_graph_install(struct hud_pane *pane, const char *name)
+{
+   struct hud_graph *gr;
+   struct counter_info *info;
+   unsigned i;
+
+   for (i = 0; i < Elements(counter_graphs); i++) {
+      if (strcmp(name, counter_graphs[i].name) == 0)
+         break;
+   }
+   if (i == Elements(counter_graphs))
+      return FALSE;
+
+   gr = CALLOC_STRUCT(hud_graph);
+   if (!gr)
+      return TRUE;
+
+   strcpy(gr->name, counter_graphs[i].name);
+   info = CALLOC_STRUCT(counter_info);
+   if (!info) {
+      FREE(gr);
+      return TRUE;
+   }
+
+   info->counter = counter_graphs[i].counter;
+   info->is_time = counter_graphs[i].is_time;
+   gr->query_data = info;
+   gr->query_new_value = query_counter;
+   gr->free_query_data = free_query_data;
+
+   hud_pane_add_graph(pane, gr);
+
+   if (info->is_time) {
+      pane->type = PIPE_DRIVER_QUERY_TYPE_MICROSECONDS;
+      hud_counters_timing = TRUE;
+   }
+   return TRUE;
+}
@@ -0,0 +1,86 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/* Counters that state trackers and auxiliary modules bump, so that the HUD
+ * can show where the CPU time of a frame goes.
+ *
+ * The counters are global rather than per context, like the HUD's CPU load
+ * graphs.  The times are only measured while a HUD graph shows one of them.
+ */
+
+#ifndef HUD_COUNTERS_H
+#define HUD_COUNTERS_H
+
+#include "pipe/p_compiler.h"
+#include "os/os_time.h"
+#include "util/u_atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum hud_counter {
+   HUD_COUNTER_SHADER_COMPILES,  /**< driver shaders created */
+   HUD_COUNTER_BUFFER_REALLOCS,  /**< buffers (re)allocated for new data */
+   HUD_COUNTER_VALIDATE_TIME,    /**< state validation, in nanoseconds */
+   HUD_COUNTER_DRAW_TIME,        /**< driver draw calls, in nanoseconds */
+   HUD_COUNTER_FLUSH_TIME,       /**< driver and winsys flushes, in ns */
+   HUD_COUNTER_FLUSHES,          /**< context flushes */
+   HUD_COUNTER_THROTTLE_TIME,    /**< waiting for earlier frames, in ns */
+   HUD_NUM_COUNTERS
+};
+
+extern uint64_t hud_counters[HUD_NUM_COUNTERS];
+extern boolean hud_counters_timing;
+
+static inline void
+hud_counter_add(enum hud_counter counter, uint64_t value)
+{
+   p_atomic_add(&hud_counters[counter], value);
+}
+
+/**
+ * Return the start time of a timed section, or 0 if nothing shows times.
+ */
+static inline int64_t
+hud_counter_begin_time(void)
+{
+   return unlikely(hud_counters_timing) ? os_time_get_nano() : 0;
+}
+
+static inline void
+hud_counter_end_time(enum hud_counter counter, int64_t start)
+{
+   if (unlikely(start))
+      hud_counter_add(counter, os_time_get_nano() - start);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HUD_COUNTERS_H */
@@ -0,0 +1,149 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/* This file contains code for displaying the lookup counts of the CSO cache
+ * on the HUD, as an average per frame.
+ */
+
+#include "hud/hud_private.h"
+#include "cso_cache/cso_cache.h"
+#include "cso_cache/cso_context.h"
+#include "os/os_time.h"
+#include "util/u_memory.h"
+
+enum cso_stat {
+   CSO_STAT_HITS,
+   CSO_STAT_MISSES,
+   CSO_STAT_COLLISIONS,
+   CSO_STAT_SKIPS,
+};
+
+static const char *cso_stat_names[] = {
+   "cso-hits",
+   "cso-misses",
+   "cso-collisions",
+   "cso-skips",
+};
+
+struct cso_info {
+   struct cso_context *cso;
+   enum cso_stat stat;
+   int frames;
+   uint64_t last_value;
+   uint64_t last_time;
+};
+
+static uint64_t
+get_cso_stat(struct cso_info *info)
+{
+   struct cso_cache_stats stats;
+
+   cso_get_cache_stats(info->cso, &stats);
+
+   switch (info->stat) {
+   case CSO_STAT_HITS:
+      return stats.hits;
+   case CSO_STAT_MISSES:
+      return stats.misses;
+   case CSO_STAT_COLLISIONS:
+      return stats.collisions;
+   case CSO_STAT_SKIPS:
+   default:
+      return stats.skips;
+   }
+}
+
+static void
+query_cso(struct hud_graph *gr)
+{
+   struct cso_info *info = gr->query_data;
+   uint64_t now = os_time_get();
+
+   info->frames++;
+
+   if (info->last_time) {
+      if (info->last_time + gr->pane->period <= now) {
+         uint64_t value = get_cso_stat(info);
+
+         hud_graph_add_value(gr, (value - info->last_value) / info->frames);
+         info->frames = 0;
+         info->last_value = value;
+         info->last_time = now;
+      }
+   }
+   else {
+      info->frames = 0;
+      info->last_value = get_cso_stat(info);
+      info->last_time = now;
+   }
+}
+
+static void
+free_query_data(void *p)
+{
+   FREE(p);
+}
+
+/**
+ * Add a graph of one of the CSO cache counters to \p pane, if \p name is
+ * one of them.
+ */
+boolean
+hud_cso_graph_install(struct hud_pane *pane, struct cso_context *cso,
+                      const char *name)
+{
+   struct hud_graph *gr;
+   struct cso_info *info;
+   unsigned i;
+
+   for (i = 0; i < ARRAY_SIZE(cso_stat_names); i++) {
+      if (strcmp(name, cso_stat_names[i]) == 0)
+         break;
+   }
+   if (i == ARRAY_SIZE(cso_stat_names))
+      return FALSE;
+
+   gr = CALLOC_STRUCT(hud_graph);
+   if (!gr)
+      return TRUE;
+
+   strcpy(gr->name, cso_stat_names[i]);
+   info = CALLOC_STRUCT(cso_info);
+   if (!info) {
+      FREE(gr);
+      return TRUE;
+   }
+
+   info->cso = cso;
+   info->stat = (enum cso_stat) i;
+   gr->query_data = info;
+   gr->query_new_value = query_cso;
+   gr->free_query_data = free_query_data;
+
+   hud_pane_add_graph(pane, gr);
+   return TRUE;
+}
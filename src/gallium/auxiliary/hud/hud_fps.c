@@ -25,11 +25,15 @@
  *
  **************************************************************************/
 
-/* This file contains code for calculating framerate for displaying on the HUD.
+/* This file contains code for calculating framerate and frame times for
+ * displaying on the HUD.
  */
 
+#include <stdlib.h>
+
 #include "hud/hud_private.h"
 #include "os/os_time.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 
 struct fps_info {
@@ -90,3 +94,104 @@ hud_fps_graph_install(struct hud_pane *pane)
 
    hud_pane_add_graph(pane, gr);
 }
+
+
+struct frametime_info {
+   unsigned percentile; /* 100 for the maximum */
+   uint64_t last_frame;
+   uint64_t last_time;
+
+   /* the frame times of the current period, in microseconds */
+   uint64_t *frame_times;
+   unsigned num_frames;
+   unsigned max_frames;
+};
+
+static int
+compare_frame_times(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t *)a;
+   uint64_t y = *(const uint64_t *)b;
+
+   return x < y ? -1 : x > y;
+}
+
+static void
+query_frametime(struct hud_graph *gr)
+{
+   struct frametime_info *info = gr->query_data;
+   uint64_t now = os_time_get();
+
+   if (info->last_frame) {
+      if (info->num_frames == info->max_frames) {
+         unsigned max_frames = MAX2(info->max_frames * 2, 64);
+         uint64_t *frame_times =
+            REALLOC(info->frame_times,
+                    info->max_frames * sizeof(*frame_times),
+                    max_frames * sizeof(*frame_times));
+         if (!frame_times)
+            return;
+         info->frame_times = frame_times;
+         info->max_frames = max_frames;
+      }
+      info->frame_times[info->num_frames++] = now - info->last_frame;
+   }
+   info->last_frame = now;
+
+   if (info->last_time) {
+      if (info->last_time + gr->pane->period <= now && info->num_frames) {
+         unsigned index = (info->num_frames - 1) * info->percentile / 100;
+
+         qsort(info->frame_times, info->num_frames,
+               sizeof(*info->frame_times), compare_frame_times);
+         hud_graph_add_value(gr, info->frame_times[index]);
+         info->num_frames = 0;
+         info->last_time = now;
+      }
+   }
+   else {
+      info->last_time = now;
+   }
+}
+
+static void
+free_frametime_data(void *p)
+{
+   struct frametime_info *info = p;
+
+   FREE(info->frame_times);
+   FREE(info);
+}
+
+/**
+ * Add a graph of the frame time at \p percentile (50, 99 or 100 for the
+ * longest frame) over each period.
+ */
+void
+hud_frametime_graph_install(struct hud_pane *pane, unsigned percentile)
+{
+   struct hud_graph *gr = CALLOC_STRUCT(hud_graph);
+   struct frametime_info *info;
+
+   if (!gr)
+      return;
+
+   if (percentile >= 100)
+      strcpy(gr->name, "frametime-max");
+   else
+      sprintf(gr->name, "frametime-p%u", percentile);
+
+   info = CALLOC_STRUCT(frametime_info);
+   if (!info) {
+      FREE(gr);
+      return;
+   }
+   info->percentile = MIN2(percentile, 100);
+
+   gr->query_data = info;
+   gr->query_new_value = query_frametime;
+   gr->free_query_data = free_frametime_data;
+
+   hud_pane_add_graph(pane, gr);
+   pane->type = PIPE_DRIVER_QUERY_TYPE_MICROSECONDS;
+}
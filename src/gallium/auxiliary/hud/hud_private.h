@@ -28,9 +28,13 @@
 #ifndef HUD_PRIVATE_H
 #define HUD_PRIVATE_H
 
+#include <stdio.h>
+
 #include "pipe/p_context.h"
 #include "util/list.h"
 
+struct cso_context;
+
 struct hud_graph {
    /* initialized by common code */
    struct list_head head;
@@ -43,6 +47,7 @@ struct hud_graph {
    void *query_data;
    void (*query_new_value)(struct hud_graph *gr);
    void (*free_query_data)(void *ptr); /**< do not use ordinary free() */
+   FILE *dump_file; /**< if not NULL, values are also written here as CSV */
 
    /* mutable variables */
    unsigned num_vertices;
@@ -87,7 +92,11 @@ struct hud_batch_query_context;
 int hud_get_num_cpus(void);
 
 void hud_fps_graph_install(struct hud_pane *pane);
+void hud_frametime_graph_install(struct hud_pane *pane, unsigned percentile);
+boolean hud_counter_graph_install(struct hud_pane *pane, const char *name);
 void hud_cpu_graph_install(struct hud_pane *pane, unsigned cpu_index);
+boolean hud_cso_graph_install(struct hud_pane *pane, struct cso_context *cso,
+                              const char *name);
 void hud_pipe_query_install(struct hud_batch_query_context **pbq,
                             struct hud_pane *pane, struct pipe_context *pipe,
                             const char *name, unsigned query_type,
@@ -39,6 +39,10 @@
  *       return;
  *    }
  *
+ * Translated index buffers are kept in a small cache, so static meshes are
+ * only converted once.  Entries are keyed by a hash of the source indices
+ * rather than by buffer, so writes to the source buffer through any path
+ * (transfers, copies, stream output) simply miss the cache.
  */
 
 #include "pipe/p_state.h"
@@ -46,10 +50,33 @@
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
 #include "util/u_upload_mgr.h"
+#include "util/hash64.h"
 
 #include "indices/u_indices.h"
 #include "indices/u_primconvert.h"
 
+/** Number of translated index buffers kept (direct mapped). */
+#define PRIMCONVERT_CACHE_SIZE 32
+
+struct primconvert_cache_key
+{
+   uint64_t src_hash;           /**< of the source indices, 0 if generated */
+   unsigned mode;
+   unsigned index_size;         /**< of the source indices, 0 if generated */
+   unsigned start;              /**< only for generated indices */
+   unsigned count;
+   unsigned pv;
+   unsigned primitive_restart;
+   unsigned restart_index;
+};
+
+struct primconvert_cache_entry
+{
+   struct primconvert_cache_key key;
+   struct pipe_resource *buffer; /**< holds the translated indices */
+   unsigned offset;
+};
+
 struct primconvert_context
 {
    struct pipe_context *pipe;
@@ -57,6 +84,7 @@ struct primconvert_context
    uint32_t primtypes_mask;
    unsigned api_pv;
    struct u_upload_mgr *upload;
+   struct primconvert_cache_entry cache[PRIMCONVERT_CACHE_SIZE];
 };
 
 
@@ -74,6 +102,10 @@ util_primconvert_create(struct pipe_context *pipe, uint32_t primtypes_mask)
 void
 util_primconvert_destroy(struct primconvert_context *pc)
 {
+   unsigned i;
+
+   for (i = 0; i < PRIMCONVERT_CACHE_SIZE; i++)
+      pipe_resource_reference(&pc->cache[i].buffer, NULL);
    if (pc->upload)
       u_upload_destroy(pc->upload);
    util_primconvert_save_index_buffer(pc, NULL);
@@ -107,6 +139,42 @@ util_primconvert_save_rasterizer_state(struct primconvert_context *pc,
    pc->api_pv = rast->flatshade_first ? PV_FIRST : PV_LAST;
 }
 
+/**
+ * Returns the cache entry for the given draw, and whether it holds the
+ * translated indices already.
+ */
+static struct primconvert_cache_entry *
+cache_lookup(struct primconvert_context *pc,
+             const struct pipe_draw_info *info,
+             const void *src, unsigned index_size, boolean *hit)
+{
+   struct primconvert_cache_key key;
+   struct primconvert_cache_entry *entry;
+
+   memset(&key, 0, sizeof(key));
+   key.mode = info->mode;
+   key.count = info->count;
+   key.pv = pc->api_pv;
+   if (src) {
+      key.src_hash = _mesa_hash64_data(src, info->count * index_size, 0);
+      key.index_size = index_size;
+      key.primitive_restart = info->primitive_restart;
+      if (info->primitive_restart)
+         key.restart_index = info->restart_index;
+   } else {
+      key.start = info->start;
+   }
+
+   entry = &pc->cache[_mesa_hash64_data(&key, sizeof(key), 0) %
+                      PRIMCONVERT_CACHE_SIZE];
+   *hit = entry->buffer && memcmp(&entry->key, &key, sizeof(key)) == 0;
+   if (!*hit) {
+      pipe_resource_reference(&entry->buffer, NULL);
+      entry->key = key;
+   }
+   return entry;
+}
+
 void
 util_primconvert_draw_vbo(struct primconvert_context *pc,
                           const struct pipe_draw_info *info)
@@ -118,6 +186,8 @@ util_primconvert_draw_vbo(struct primconvert_context *pc,
    u_translate_func trans_func;
    u_generate_func gen_func;
    const void *src = NULL;
+   struct primconvert_cache_entry *entry = NULL;
+   boolean hit = FALSE;
    void *dst;
 
    memset(&new_ib, 0, sizeof(new_ib));
@@ -152,25 +222,50 @@ util_primconvert_draw_vbo(struct primconvert_context *pc,
                         &gen_func);
    }
 
-   if (!pc->upload) {
-      pc->upload = u_upload_create(pc->pipe, 4096, 4, PIPE_BIND_INDEX_BUFFER);
+   /* User indices are usually streamed, so don't bother hashing them. */
+   if (!info->indexed || !ib->user_buffer) {
+      entry = cache_lookup(pc, info,
+                           info->indexed ? (const uint8_t *)src +
+                                           info->start * ib->index_size :
+                                           NULL,
+                           ib->index_size, &hit);
    }
 
-   u_upload_alloc(pc->upload, 0, new_ib.index_size * new_info.count,
-                  &new_ib.offset, &new_ib.buffer, &dst);
-
-   if (info->indexed) {
-      trans_func(src, info->start, info->count, new_info.count, info->restart_index, dst);
+   if (hit) {
+      pipe_resource_reference(&new_ib.buffer, entry->buffer);
+      new_ib.offset = entry->offset;
    }
    else {
-      gen_func(info->start, new_info.count, dst);
+      if (!pc->upload) {
+         pc->upload = u_upload_create(pc->pipe, 4096, 4,
+                                      PIPE_BIND_INDEX_BUFFER);
+      }
+
+      u_upload_alloc(pc->upload, 0, new_ib.index_size * new_info.count,
+                     &new_ib.offset, &new_ib.buffer, &dst);
+
+      if (info->indexed) {
+         trans_func(src, info->start, info->count, new_info.count, info->restart_index, dst);
+      }
+      else {
+         gen_func(info->start, new_info.count, dst);
+      }
+
+      u_upload_unmap(pc->upload);
+
+      /* Our upload manager is never given fences, so it doesn't recycle
+       * retired buffers, and the indices stay valid for as long as the
+       * entry holds the buffer.
+       */
+      if (entry) {
+         pipe_resource_reference(&entry->buffer, new_ib.buffer);
+         entry->offset = new_ib.offset;
+      }
    }
 
    if (src_transfer)
       pipe_buffer_unmap(pc->pipe, src_transfer);
 
-   u_upload_unmap(pc->upload);
-
    /* bind new index buffer: */
    pc->pipe->set_index_buffer(pc->pipe, &new_ib);
 
@@ -27,10 +27,23 @@
  **************************************************************************/
 
 #include "pb_cache.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_time.h"
 
 
+/**
+ * Buffers are kept in one list per power-of-two size class, so that
+ * finding a buffer only looks at the few classes that can hold compatible
+ * sizes rather than at every cached buffer.
+ */
+static unsigned
+pb_cache_bucket_index(pb_size size)
+{
+   return size ? util_logbase2(size) : 0;
+}
+
+
 /**
  * Actually destroy the buffer.
  */
@@ -50,7 +63,7 @@ destroy_buffer_locked(struct pb_cache_entry *entry)
 }
 
 /**
- * Free as many cache buffers from the list head as possible.
+ * Free as many cache buffers from the list heads as possible.
  */
 static void
 release_expired_buffers_locked(struct pb_cache *mgr)
@@ -58,21 +71,26 @@ release_expired_buffers_locked(struct pb_cache *mgr)
    struct list_head *curr, *next;
    struct pb_cache_entry *entry;
    int64_t now;
+   unsigned i;
 
    now = os_time_get();
 
-   curr = mgr->cache.next;
-   next = curr->next;
-   while (curr != &mgr->cache) {
-      entry = LIST_ENTRY(struct pb_cache_entry, curr, head);
+   for (i = 0; i < PB_CACHE_NUM_BUCKETS; i++) {
+      struct list_head *cache = &mgr->buckets[i];
 
-      if (!os_time_timeout(entry->start, entry->end, now))
-         break;
+      curr = cache->next;
+      next = curr->next;
+      while (curr != cache) {
+         entry = LIST_ENTRY(struct pb_cache_entry, curr, head);
 
-      destroy_buffer_locked(entry);
+         if (!os_time_timeout(entry->start, entry->end, now))
+            break;
 
-      curr = next;
-      next = curr->next;
+         destroy_buffer_locked(entry);
+
+         curr = next;
+         next = curr->next;
+      }
    }
 }
 
@@ -99,7 +117,8 @@ pb_cache_add_buffer(struct pb_cache_entry *entry)
 
    entry->start = os_time_get();
    entry->end = entry->start + mgr->usecs;
-   LIST_ADDTAIL(&entry->head, &mgr->cache);
+   LIST_ADDTAIL(&entry->head,
+                &mgr->buckets[pb_cache_bucket_index(entry->buffer->size)]);
    ++mgr->num_buffers;
    mgr->cache_size += entry->buffer->size;
    pipe_mutex_unlock(mgr->mutex);
@@ -136,28 +155,28 @@ pb_cache_is_buffer_compat(struct pb_cache_entry *entry,
 }
 
 /**
- * Find a compatible buffer in the cache, return it, and remove it
- * from the cache.
+ * Find a compatible buffer in one size class of the cache.
+ *
+ * Buffers are ordered from the least recently added, so expired buffers
+ * are freed until the first hot one.
  */
-struct pb_buffer *
-pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
-                        unsigned alignment, unsigned usage)
+static struct pb_cache_entry *
+pb_cache_reclaim_from_bucket_locked(struct pb_cache *mgr,
+                                    struct list_head *cache, int64_t now,
+                                    pb_size size, unsigned alignment,
+                                    unsigned usage)
 {
    struct pb_cache_entry *entry;
    struct pb_cache_entry *cur_entry;
    struct list_head *cur, *next;
-   int64_t now;
    int ret = 0;
 
-   pipe_mutex_lock(mgr->mutex);
-
    entry = NULL;
-   cur = mgr->cache.next;
+   cur = cache->next;
    next = cur->next;
 
    /* search in the expired buffers, freeing them in the process */
-   now = os_time_get();
-   while (cur != &mgr->cache) {
+   while (cur != cache) {
       cur_entry = LIST_ENTRY(struct pb_cache_entry, cur, head);
 
       if (!entry && (ret = pb_cache_is_buffer_compat(cur_entry, size,
@@ -179,7 +198,7 @@ pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
 
    /* keep searching in the hot buffers */
    if (!entry && ret != -1) {
-      while (cur != &mgr->cache) {
+      while (cur != cache) {
          cur_entry = LIST_ENTRY(struct pb_cache_entry, cur, head);
          ret = pb_cache_is_buffer_compat(cur_entry, size, alignment, usage);
 
@@ -195,6 +214,40 @@ pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
       }
    }
 
+   return entry;
+}
+
+/**
+ * Find a compatible buffer in the cache, return it, and remove it
+ * from the cache.
+ */
+struct pb_buffer *
+pb_cache_reclaim_buffer(struct pb_cache *mgr, pb_size size,
+                        unsigned alignment, unsigned usage)
+{
+   struct pb_cache_entry *entry = NULL;
+   double max_size = (double) mgr->size_factor * size;
+   unsigned first = pb_cache_bucket_index(size);
+   unsigned last = max_size >= (double) ~(pb_size) 0 ?
+                   PB_CACHE_NUM_BUCKETS - 1 :
+                   pb_cache_bucket_index((pb_size) max_size);
+   int64_t now;
+   unsigned i;
+
+   if (usage & mgr->bypass_usage)
+      return NULL;
+
+   pipe_mutex_lock(mgr->mutex);
+
+   /* Only the size classes that can hold sizes from size to
+    * size_factor * size can have compatible buffers.
+    */
+   now = os_time_get();
+   for (i = first; i <= last && !entry; i++) {
+      entry = pb_cache_reclaim_from_bucket_locked(mgr, &mgr->buckets[i], now,
+                                                  size, alignment, usage);
+   }
+
    /* found a compatible buffer, return it */
    if (entry) {
       struct pb_buffer *buf = entry->buffer;
@@ -220,15 +273,20 @@ pb_cache_release_all_buffers(struct pb_cache *mgr)
 {
    struct list_head *curr, *next;
    struct pb_cache_entry *buf;
+   unsigned i;
 
    pipe_mutex_lock(mgr->mutex);
-   curr = mgr->cache.next;
-   next = curr->next;
-   while (curr != &mgr->cache) {
-      buf = LIST_ENTRY(struct pb_cache_entry, curr, head);
-      destroy_buffer_locked(buf);
-      curr = next;
+   for (i = 0; i < PB_CACHE_NUM_BUCKETS; i++) {
+      struct list_head *cache = &mgr->buckets[i];
+
+      curr = cache->next;
       next = curr->next;
+      while (curr != cache) {
+         buf = LIST_ENTRY(struct pb_cache_entry, curr, head);
+         destroy_buffer_locked(buf);
+         curr = next;
+         next = curr->next;
+      }
    }
    pipe_mutex_unlock(mgr->mutex);
 }
@@ -263,7 +321,10 @@ pb_cache_init(struct pb_cache *mgr, uint usecs, float size_factor,
               void (*destroy_buffer)(struct pb_buffer *buf),
               bool (*can_reclaim)(struct pb_buffer *buf))
 {
-   LIST_INITHEAD(&mgr->cache);
+   unsigned i;
+
+   for (i = 0; i < PB_CACHE_NUM_BUCKETS; i++)
+      LIST_INITHEAD(&mgr->buckets[i]);
    pipe_mutex_init(mgr->mutex);
    mgr->cache_size = 0;
    mgr->max_cache_size = maximum_cache_size;
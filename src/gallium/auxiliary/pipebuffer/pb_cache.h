@@ -44,9 +44,15 @@ struct pb_cache_entry
    int64_t start, end; /**< Caching time interval */
 };
 
+/** One bucket for each power of two of the buffer size. */
+#define PB_CACHE_NUM_BUCKETS 32
+
 struct pb_cache
 {
-   struct list_head cache;
+   /* Lists of unused buffers, ordered from the least recently added, for
+    * each size class.
+    */
+   struct list_head buckets[PB_CACHE_NUM_BUCKETS];
    pipe_mutex mutex;
    uint64_t cache_size;
    uint64_t max_cache_size;
@@ -60,6 +60,7 @@
 #include "tgsi_exec.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "util/u_sse.h"
 
 
 #define DEBUG_EXECUTION 0
@@ -86,10 +87,16 @@ static void
 micro_abs(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   const __m128 sign = _mm_set1_ps(-0.0f);
+
+   _mm_storeu_ps(dst->f, _mm_andnot_ps(sign, _mm_loadu_ps(src->f)));
+#else
    dst->f[0] = fabsf(src->f[0]);
    dst->f[1] = fabsf(src->f[1]);
    dst->f[2] = fabsf(src->f[2]);
    dst->f[3] = fabsf(src->f[3]);
+#endif
 }
 
 static void
@@ -140,10 +147,17 @@ micro_cmp(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   const __m128 lt = _mm_cmplt_ps(_mm_loadu_ps(src0->f), _mm_setzero_ps());
+
+   _mm_storeu_ps(dst->f, _mm_or_ps(_mm_and_ps(lt, _mm_loadu_ps(src1->f)),
+                                  _mm_andnot_ps(lt, _mm_loadu_ps(src2->f))));
+#else
    dst->f[0] = src0->f[0] < 0.0f ? src1->f[0] : src2->f[0];
    dst->f[1] = src0->f[1] < 0.0f ? src1->f[1] : src2->f[1];
    dst->f[2] = src0->f[2] < 0.0f ? src1->f[2] : src2->f[2];
    dst->f[3] = src0->f[3] < 0.0f ? src1->f[3] : src2->f[3];
+#endif
 }
 
 static void
@@ -494,10 +508,18 @@ micro_lrp(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   const __m128 s2 = _mm_loadu_ps(src2->f);
+
+   _mm_storeu_ps(dst->f, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src0->f),
+                                              _mm_sub_ps(_mm_loadu_ps(src1->f), s2)),
+                                   s2));
+#else
    dst->f[0] = src0->f[0] * (src1->f[0] - src2->f[0]) + src2->f[0];
    dst->f[1] = src0->f[1] * (src1->f[1] - src2->f[1]) + src2->f[1];
    dst->f[2] = src0->f[2] * (src1->f[2] - src2->f[2]) + src2->f[2];
    dst->f[3] = src0->f[3] * (src1->f[3] - src2->f[3]) + src2->f[3];
+#endif
 }
 
 static void
@@ -506,20 +528,30 @@ micro_mad(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src1,
           const union tgsi_exec_channel *src2)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)),
+                                   _mm_loadu_ps(src2->f)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0] + src2->f[0];
    dst->f[1] = src0->f[1] * src1->f[1] + src2->f[1];
    dst->f[2] = src0->f[2] * src1->f[2] + src2->f[2];
    dst->f[3] = src0->f[3] * src1->f[3] + src2->f[3];
+#endif
 }
 
 static void
 micro_mov(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_si128((__m128i *) dst->u,
+                    _mm_loadu_si128((const __m128i *) src->u));
+#else
    dst->u[0] = src->u[0];
    dst->u[1] = src->u[1];
    dst->u[2] = src->u[2];
    dst->u[3] = src->u[3];
+#endif
 }
 
 static void
@@ -579,10 +611,15 @@ micro_seq(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmpeq_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)),
+                                   _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] == src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] == src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] == src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] == src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -590,10 +627,15 @@ micro_sge(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)),
+                                   _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] >= src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] >= src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] >= src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] >= src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -621,10 +663,15 @@ micro_sgt(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmpgt_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)),
+                                   _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] > src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] > src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] > src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] > src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -642,10 +689,15 @@ micro_sle(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmple_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)),
+                                   _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] <= src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] <= src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] <= src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] <= src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -653,10 +705,15 @@ micro_slt(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)),
+                                   _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] < src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] < src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] < src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -664,10 +721,15 @@ micro_sne(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_and_ps(_mm_cmpneq_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)),
+                                   _mm_set1_ps(1.0f)));
+#else
    dst->f[0] = src0->f[0] != src1->f[0] ? 1.0f : 0.0f;
    dst->f[1] = src0->f[1] != src1->f[1] ? 1.0f : 0.0f;
    dst->f[2] = src0->f[2] != src1->f[2] ? 1.0f : 0.0f;
    dst->f[3] = src0->f[3] != src1->f[3] ? 1.0f : 0.0f;
+#endif
 }
 
 static void
@@ -844,98 +906,43 @@ tgsi_check_soa_dependencies(const struct tgsi_full_instruction *inst)
 
 
 /**
- * Initialize machine state by expanding tokens to full instructions,
- * allocating temporary storage, setting up constants, etc.
- * After this, we can call tgsi_exec_machine_run() many times.
+ * Expand the tokens to full declarations and instructions, and collect the
+ * immediates, so that the shader can be bound to machines any number of
+ * times without parsing it again.
  */
-void 
-tgsi_exec_machine_bind_shader(
-   struct tgsi_exec_machine *mach,
-   const struct tgsi_token *tokens,
-   struct tgsi_sampler *sampler)
+struct tgsi_exec_shader *
+tgsi_exec_shader_create(const struct tgsi_token *tokens)
 {
-   uint k;
+   struct tgsi_exec_shader *shader;
    struct tgsi_parse_context parse;
-   struct tgsi_full_instruction *instructions;
-   struct tgsi_full_declaration *declarations;
-   uint maxInstructions = 10, numInstructions = 0;
-   uint maxDeclarations = 10, numDeclarations = 0;
+   uint maxInstructions = 10;
+   uint maxDeclarations = 10;
+   uint maxImmediates = 10;
 
 #if 0
    tgsi_dump(tokens, 0);
 #endif
 
-   util_init_math();
-
-
-   mach->Tokens = tokens;
-   mach->Sampler = sampler;
-
-   if (!tokens) {
-      /* unbind and free all */
-      FREE(mach->Declarations);
-      mach->Declarations = NULL;
-      mach->NumDeclarations = 0;
-
-      FREE(mach->Instructions);
-      mach->Instructions = NULL;
-      mach->NumInstructions = 0;
-
-      return;
-   }
-
-   k = tgsi_parse_init (&parse, mach->Tokens);
-   if (k != TGSI_PARSE_OK) {
+   if (tgsi_parse_init(&parse, tokens) != TGSI_PARSE_OK) {
       debug_printf( "Problem parsing!\n" );
-      return;
+      return NULL;
    }
 
-   mach->Processor = parse.FullHeader.Processor.Processor;
-   mach->ImmLimit = 0;
-   mach->NumOutputs = 0;
-
-   if (mach->Processor == TGSI_PROCESSOR_GEOMETRY &&
-       !mach->UsedGeometryShader) {
-      struct tgsi_exec_vector *inputs;
-      struct tgsi_exec_vector *outputs;
-
-      inputs = align_malloc(sizeof(struct tgsi_exec_vector) *
-                            TGSI_MAX_PRIM_VERTICES * PIPE_MAX_SHADER_INPUTS,
-                            16);
-
-      if (!inputs)
-         return;
-
-      outputs = align_malloc(sizeof(struct tgsi_exec_vector) *
-                             TGSI_MAX_TOTAL_VERTICES, 16);
-
-      if (!outputs) {
-         align_free(inputs);
-         return;
-      }
-
-      align_free(mach->Inputs);
-      align_free(mach->Outputs);
+   shader = CALLOC_STRUCT(tgsi_exec_shader);
+   if (!shader)
+      goto fail;
 
-      mach->Inputs = inputs;
-      mach->Outputs = outputs;
-      mach->UsedGeometryShader = TRUE;
-   }
+   shader->Tokens = tokens;
+   shader->Processor = parse.FullHeader.Processor.Processor;
 
-   declarations = (struct tgsi_full_declaration *)
+   shader->Declarations = (struct tgsi_full_declaration *)
       MALLOC( maxDeclarations * sizeof(struct tgsi_full_declaration) );
-
-   if (!declarations) {
-      return;
-   }
-
-   instructions = (struct tgsi_full_instruction *)
+   shader->Instructions = (struct tgsi_full_instruction *)
       MALLOC( maxInstructions * sizeof(struct tgsi_full_instruction) );
+   shader->Imms = MALLOC( maxImmediates * sizeof(shader->Imms[0]) );
 
-   if (!instructions) {
-      FREE( declarations );
-      return;
-   }
+   if (!shader->Declarations || !shader->Instructions || !shader->Imms)
+      goto fail;
 
    while( !tgsi_parse_end_of_tokens( &parse ) ) {
       uint i;
@@ -944,65 +951,79 @@ tgsi_exec_machine_bind_shader(
       switch( parse.FullToken.Token.Type ) {
       case TGSI_TOKEN_TYPE_DECLARATION:
          /* save expanded declaration */
-         if (numDeclarations == maxDeclarations) {
-            declarations = REALLOC(declarations,
+         if (shader->NumDeclarations == maxDeclarations) {
+            shader->Declarations = REALLOC(shader->Declarations,
                                    maxDeclarations
                                    * sizeof(struct tgsi_full_declaration),
                                    (maxDeclarations + 10)
                                    * sizeof(struct tgsi_full_declaration));
             maxDeclarations += 10;
+            if (!shader->Declarations)
+               goto fail;
          }
          if (parse.FullToken.FullDeclaration.Declaration.File == TGSI_FILE_OUTPUT) {
             unsigned reg;
             for (reg = parse.FullToken.FullDeclaration.Range.First;
                  reg <= parse.FullToken.FullDeclaration.Range.Last;
                  ++reg) {
-               ++mach->NumOutputs;
+               ++shader->NumOutputs;
             }
          }
-         memcpy(declarations + numDeclarations,
+         memcpy(shader->Declarations + shader->NumDeclarations,
                 &parse.FullToken.FullDeclaration,
-                sizeof(declarations[0]));
-         numDeclarations++;
+                sizeof(shader->Declarations[0]));
+         shader->NumDeclarations++;
          break;
 
       case TGSI_TOKEN_TYPE_IMMEDIATE:
          {
             uint size = parse.FullToken.FullImmediate.Immediate.NrTokens - 1;
             assert( size <= 4 );
-            assert( mach->ImmLimit + 1 <= TGSI_EXEC_NUM_IMMEDIATES );
+            assert( shader->ImmLimit + 1 <= TGSI_EXEC_NUM_IMMEDIATES );
+
+            if (shader->ImmLimit == maxImmediates) {
+               shader->Imms = REALLOC(shader->Imms,
+                                      maxImmediates * sizeof(shader->Imms[0]),
+                                      (maxImmediates + 10)
+                                      * sizeof(shader->Imms[0]));
+               maxImmediates += 10;
+               if (!shader->Imms)
+                  goto fail;
+            }
 
             for( i = 0; i < size; i++ ) {
-               mach->Imms[mach->ImmLimit][i] = 
-		  parse.FullToken.FullImmediate.u[i].Float;
+               shader->Imms[shader->ImmLimit][i] =
+                  parse.FullToken.FullImmediate.u[i].Float;
             }
-            mach->ImmLimit += 1;
+            shader->ImmLimit += 1;
          }
          break;
 
       case TGSI_TOKEN_TYPE_INSTRUCTION:
 
          /* save expanded instruction */
-         if (numInstructions == maxInstructions) {
-            instructions = REALLOC(instructions,
+         if (shader->NumInstructions == maxInstructions) {
+            shader->Instructions = REALLOC(shader->Instructions,
                                    maxInstructions
                                    * sizeof(struct tgsi_full_instruction),
                                    (maxInstructions + 10)
                                    * sizeof(struct tgsi_full_instruction));
             maxInstructions += 10;
+            if (!shader->Instructions)
+               goto fail;
          }
 
-         memcpy(instructions + numInstructions,
+         memcpy(shader->Instructions + shader->NumInstructions,
                 &parse.FullToken.FullInstruction,
-                sizeof(instructions[0]));
+                sizeof(shader->Instructions[0]));
 
-         numInstructions++;
+         shader->NumInstructions++;
          break;
 
       case TGSI_TOKEN_TYPE_PROPERTY:
-         if (mach->Processor == TGSI_PROCESSOR_GEOMETRY) {
+         if (shader->Processor == TGSI_PROCESSOR_GEOMETRY) {
             if (parse.FullToken.FullProperty.Property.PropertyName == TGSI_PROPERTY_GS_MAX_OUTPUT_VERTICES) {
-               mach->MaxOutputVertices = parse.FullToken.FullProperty.u[0].Data;
+               shader->MaxOutputVertices = parse.FullToken.FullProperty.u[0].Data;
             }
          }
          break;
@@ -1013,13 +1034,132 @@ tgsi_exec_machine_bind_shader(
    }
    tgsi_parse_free (&parse);
 
-   FREE(mach->Declarations);
-   mach->Declarations = declarations;
-   mach->NumDeclarations = numDeclarations;
+   return shader;
 
-   FREE(mach->Instructions);
-   mach->Instructions = instructions;
-   mach->NumInstructions = numInstructions;
+fail:
+   tgsi_parse_free (&parse);
+   tgsi_exec_shader_destroy(shader);
+   return NULL;
+}
+
+
+void
+tgsi_exec_shader_destroy(struct tgsi_exec_shader *shader)
+{
+   if (shader) {
+      FREE(shader->Declarations);
+      FREE(shader->Instructions);
+      FREE(shader->Imms);
+      FREE(shader);
+   }
+}
+
+
+/**
+ * Initialize machine state for running a shader decoded by
+ * tgsi_exec_shader_create(), allocating temporary storage, setting up
+ * constants, etc.  The machine references the shader's instructions, so
+ * the shader must be unbound before it's destroyed.
+ * After this, we can call tgsi_exec_machine_run() many times.
+ */
+void
+tgsi_exec_machine_bind_exec_shader(
+   struct tgsi_exec_machine *mach,
+   const struct tgsi_exec_shader *shader,
+   struct tgsi_sampler *sampler)
+{
+   util_init_math();
+
+   tgsi_exec_shader_destroy(mach->OwnedShader);
+   mach->OwnedShader = NULL;
+
+   mach->Tokens = NULL;
+   mach->Sampler = sampler;
+
+   mach->Declarations = NULL;
+   mach->NumDeclarations = 0;
+   mach->Instructions = NULL;
+   mach->NumInstructions = 0;
+
+   if (!shader) {
+      /* unbind */
+      return;
+   }
+
+   if (shader->Processor == TGSI_PROCESSOR_GEOMETRY &&
+       !mach->UsedGeometryShader) {
+      struct tgsi_exec_vector *inputs;
+      struct tgsi_exec_vector *outputs;
+
+      inputs = align_malloc(sizeof(struct tgsi_exec_vector) *
+                            TGSI_MAX_PRIM_VERTICES * PIPE_MAX_SHADER_INPUTS,
+                            16);
+
+      if (!inputs)
+         return;
+
+      outputs = align_malloc(sizeof(struct tgsi_exec_vector) *
+                             TGSI_MAX_TOTAL_VERTICES, 16);
+
+      if (!outputs) {
+         align_free(inputs);
+         return;
+      }
+
+      align_free(mach->Inputs);
+      align_free(mach->Outputs);
+
+      mach->Inputs = inputs;
+      mach->Outputs = outputs;
+      mach->UsedGeometryShader = TRUE;
+   }
+
+   mach->Tokens = shader->Tokens;
+   mach->Processor = shader->Processor;
+
+   mach->ImmLimit = shader->ImmLimit;
+   memcpy(mach->Imms, shader->Imms, shader->ImmLimit * sizeof(mach->Imms[0]));
+
+   mach->NumOutputs = shader->NumOutputs;
+   if (shader->MaxOutputVertices)
+      mach->MaxOutputVertices = shader->MaxOutputVertices;
+
+   mach->Declarations = shader->Declarations;
+   mach->NumDeclarations = shader->NumDeclarations;
+   mach->Instructions = shader->Instructions;
+   mach->NumInstructions = shader->NumInstructions;
+}
+
+
+/**
+ * Initialize machine state by expanding tokens to full instructions,
+ * allocating temporary storage, setting up constants, etc.
+ * After this, we can call tgsi_exec_machine_run() many times.
+ *
+ * This parses the tokens each time; shaders bound repeatedly should be
+ * decoded once with tgsi_exec_shader_create() instead.
+ */
+void 
+tgsi_exec_machine_bind_shader(
+   struct tgsi_exec_machine *mach,
+   const struct tgsi_token *tokens,
+   struct tgsi_sampler *sampler)
+{
+   struct tgsi_exec_shader *shader = NULL;
+
+   if (tokens) {
+      shader = tgsi_exec_shader_create(tokens);
+      if (!shader)
+         return;
+   }
+
+   tgsi_exec_machine_bind_exec_shader(mach, shader, sampler);
+
+   /* The machine owns the shader decoded for it */
+   if (mach->Tokens)
+      mach->OwnedShader = shader;
+   else
+      tgsi_exec_shader_destroy(shader);
 }
 
 
@@ -1080,8 +1220,7 @@ void
 tgsi_exec_machine_destroy(struct tgsi_exec_machine *mach)
 {
    if (mach) {
-      FREE(mach->Instructions);
-      FREE(mach->Declarations);
+      tgsi_exec_shader_destroy(mach->OwnedShader);
 
       align_free(mach->Inputs);
       align_free(mach->Outputs);
@@ -1095,10 +1234,14 @@ micro_add(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_add_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] + src1->f[0];
    dst->f[1] = src0->f[1] + src1->f[1];
    dst->f[2] = src0->f[2] + src1->f[2];
    dst->f[3] = src0->f[3] + src1->f[3];
+#endif
 }
 
 static void
@@ -1140,10 +1283,14 @@ micro_max(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_max_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] > src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] > src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] > src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] > src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -1151,10 +1298,14 @@ micro_min(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_min_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] < src1->f[0] ? src0->f[0] : src1->f[0];
    dst->f[1] = src0->f[1] < src1->f[1] ? src0->f[1] : src1->f[1];
    dst->f[2] = src0->f[2] < src1->f[2] ? src0->f[2] : src1->f[2];
    dst->f[3] = src0->f[3] < src1->f[3] ? src0->f[3] : src1->f[3];
+#endif
 }
 
 static void
@@ -1162,10 +1313,14 @@ micro_mul(union tgsi_exec_channel *dst,
           const union tgsi_exec_channel *src0,
           const union tgsi_exec_channel *src1)
 {
+#if defined(PIPE_ARCH_SSE)
+   _mm_storeu_ps(dst->f, _mm_mul_ps(_mm_loadu_ps(src0->f), _mm_loadu_ps(src1->f)));
+#else
    dst->f[0] = src0->f[0] * src1->f[0];
    dst->f[1] = src0->f[1] * src1->f[1];
    dst->f[2] = src0->f[2] * src1->f[2];
    dst->f[3] = src0->f[3] * src1->f[3];
+#endif
 }
 
 static void
@@ -1173,10 +1328,16 @@ micro_neg(
    union tgsi_exec_channel *dst,
    const union tgsi_exec_channel *src )
 {
+#if defined(PIPE_ARCH_SSE)
+   const __m128 sign = _mm_set1_ps(-0.0f);
+
+   _mm_storeu_ps(dst->f, _mm_xor_ps(sign, _mm_loadu_ps(src->f)));
+#else
    dst->f[0] = -src->f[0];
    dst->f[1] = -src->f[1];
    dst->f[2] = -src->f[2];
    dst->f[3] = -src->f[3];
+#endif
 }
 
 static void
@@ -1765,6 +1926,35 @@ store_dest(struct tgsi_exec_machine *mach,
    if (!dst)
       return;
 
+#if defined(PIPE_ARCH_SSE)
+   {
+      const __m128i bits = _mm_set_epi32(8, 4, 2, 1);
+      const __m128i mask =
+         _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(execmask), bits), bits);
+      __m128i value = _mm_loadu_si128((const __m128i *) chan->i);
+
+      if (inst->Instruction.Saturate) {
+         const __m128 f = _mm_castsi128_ps(value);
+         const __m128 one = _mm_set1_ps(1.0f);
+         const __m128 lt = _mm_cmplt_ps(f, _mm_setzero_ps());
+         const __m128 gt = _mm_cmpgt_ps(f, one);
+
+         /* Like the C code below, NaN and -0.0 are left alone. */
+         value = _mm_castps_si128(
+            _mm_or_ps(_mm_andnot_ps(_mm_or_ps(lt, gt), f),
+                      _mm_and_ps(gt, one)));
+      }
+
+      if ((execmask & 0xf) != 0xf) {
+         const __m128i old = _mm_loadu_si128((const __m128i *) dst->i);
+         value = _mm_or_si128(_mm_and_si128(mask, value),
+                              _mm_andnot_si128(mask, old));
+      }
+      _mm_storeu_si128((__m128i *) dst->i, value);
+      return;
+   }
+#endif
+
    if (!inst->Instruction.Saturate) {
       for (i = 0; i < TGSI_QUAD_SIZE; i++)
          if (execmask & (1 << i))
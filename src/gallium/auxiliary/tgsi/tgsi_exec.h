@@ -270,6 +270,28 @@ enum tgsi_break_type {
 #define TGSI_EXEC_MAX_BREAK_STACK (TGSI_EXEC_MAX_LOOP_NESTING + TGSI_EXEC_MAX_SWITCH_NESTING)
 
 
+/**
+ * A shader expanded to full declarations and instructions, which can be
+ * bound to a machine without parsing the tokens again.
+ */
+struct tgsi_exec_shader
+{
+   const struct tgsi_token *Tokens;
+   unsigned Processor; /**< TGSI_PROCESSOR_x */
+
+   struct tgsi_full_instruction *Instructions;
+   uint NumInstructions;
+
+   struct tgsi_full_declaration *Declarations;
+   uint NumDeclarations;
+
+   float (*Imms)[4];
+   unsigned ImmLimit;
+
+   unsigned NumOutputs;
+   unsigned MaxOutputVertices; /**< GEOMETRY only, 0 if not declared */
+};
+
 /**
  * Run-time virtual machine state for executing TGSI shader.
  */
@@ -365,6 +387,9 @@ struct tgsi_exec_machine
    struct tgsi_full_declaration *Declarations;
    uint NumDeclarations;
 
+   /** Shader decoded by tgsi_exec_machine_bind_shader(), if any */
+   struct tgsi_exec_shader *OwnedShader;
+
    struct tgsi_declaration_sampler_view
       SamplerViews[PIPE_MAX_SHADER_SAMPLER_VIEWS];
 
@@ -384,6 +409,18 @@ tgsi_exec_machine_bind_shader(
    const struct tgsi_token *tokens,
    struct tgsi_sampler *sampler);
 
+struct tgsi_exec_shader *
+tgsi_exec_shader_create(const struct tgsi_token *tokens);
+
+void
+tgsi_exec_shader_destroy(struct tgsi_exec_shader *shader);
+
+void
+tgsi_exec_machine_bind_exec_shader(
+   struct tgsi_exec_machine *mach,
+   const struct tgsi_exec_shader *shader,
+   struct tgsi_sampler *sampler);
+
 uint
 tgsi_exec_machine_run(
    struct tgsi_exec_machine *mach );
@@ -112,6 +112,13 @@ struct translate {
 
    void (*release)( struct translate * );
 
+   /**
+    * Create a new translate for the same key, with its own buffer state.
+    * The generated code, if any, is shared with the original and stays
+    * valid until both have been released.
+    */
+   struct translate *(*clone)( struct translate * );
+
    void (*set_buffer)( struct translate *,
 		       unsigned i,
 		       const void *ptr,
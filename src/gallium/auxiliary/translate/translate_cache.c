@@ -26,6 +26,7 @@
  **************************************************************************/
 
 #include "util/u_memory.h"
+#include "os/os_thread.h"
 #include "pipe/p_state.h"
 #include "translate.h"
 #include "translate_cache.h"
@@ -37,6 +38,18 @@ struct translate_cache {
    struct cso_hash *hash;
 };
 
+/*
+ * Translates built for any cache, shared by all of them.  Generating the
+ * code for a key is what's expensive, and the draw module and u_vbuf of
+ * every context keep asking for the same few layouts.  These translates are
+ * never run: each cache gets its own clone, which shares the generated code
+ * but has its own buffer state.  The shared translates are released when
+ * the last cache is destroyed.
+ */
+pipe_static_mutex(shared_mutex);
+static struct cso_hash *shared_hash;
+static unsigned shared_users;
+
 struct translate_cache * translate_cache_create( void )
 {
    struct translate_cache *cache = MALLOC_STRUCT(translate_cache);
@@ -45,13 +58,23 @@ struct translate_cache * translate_cache_create( void )
    }
 
    cache->hash = cso_hash_create();
+   if (!cache->hash) {
+      FREE(cache);
+      return NULL;
+   }
+
+   pipe_mutex_lock(shared_mutex);
+   if (!shared_hash)
+      shared_hash = cso_hash_create();
+   shared_users++;
+   pipe_mutex_unlock(shared_mutex);
+
    return cache;
 }
 
 
-static inline void delete_translates(struct translate_cache *cache)
+static inline void delete_translates(struct cso_hash *hash)
 {
-   struct cso_hash *hash = cache->hash;
    struct cso_hash_iter iter = cso_hash_first_node(hash);
    while (!cso_hash_iter_is_null(iter)) {
       struct translate *state = (struct translate*)cso_hash_iter_data(iter);
@@ -64,9 +87,17 @@ static inline void delete_translates(struct translate_cache *cache)
 
 void translate_cache_destroy(struct translate_cache *cache)
 {
-   delete_translates(cache);
+   delete_translates(cache->hash);
    cso_hash_delete(cache->hash);
    FREE(cache);
+
+   pipe_mutex_lock(shared_mutex);
+   if (--shared_users == 0 && shared_hash) {
+      delete_translates(shared_hash);
+      cso_hash_delete(shared_hash);
+      shared_hash = NULL;
+   }
+   pipe_mutex_unlock(shared_mutex);
 }
 
 
@@ -91,16 +122,35 @@ struct translate * translate_cache_find(struct translate_cache *cache,
                                         struct translate_key *key)
 {
    unsigned hash_key = create_key(key);
+   unsigned size = translate_hash_key_size(key);
+   struct translate *shared;
    struct translate *translate = (struct translate*)
       cso_hash_find_data_from_template(cache->hash,
                                        hash_key,
-                                       key, sizeof(*key));
+                                       key, size);
 
-   if (!translate) {
-      /* create/insert */
-      translate = translate_create(key);
-      cso_hash_insert(cache->hash, hash_key, translate);
+   if (translate)
+      return translate;
+
+   pipe_mutex_lock(shared_mutex);
+   shared = (struct translate*)
+      cso_hash_find_data_from_template(shared_hash, hash_key, key, size);
+   if (!shared) {
+      shared = translate_create(key);
+      if (shared)
+         cso_hash_insert(shared_hash, hash_key, shared);
    }
+   pipe_mutex_unlock(shared_mutex);
+
+   /* This cache holds a reference on the shared translates, so the one we
+    * found can't go away while we clone it.
+    */
+   if (!shared)
+      return NULL;
+
+   translate = shared->clone(shared);
+   if (translate)
+      cso_hash_insert(cache->hash, hash_key, translate);
 
    return translate;
 }
@@ -31,6 +31,10 @@
  * translate's if one suitable for a given translate_key has already been
  * created.
  *
+ * The generated code is shared between all translate caches, which may be
+ * used from different threads; the translates returned by a cache are only
+ * its own.
+ *
  * Note: this functionality depends and requires the CSO module.
  */
 struct translate_cache;
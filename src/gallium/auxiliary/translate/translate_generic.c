@@ -34,6 +34,7 @@
 #include "util/u_format.h"
 #include "util/u_half.h"
 #include "util/u_math.h"
+#include "util/half_float.h"
 #include "pipe/p_state.h"
 #include "translate.h"
 
@@ -105,6 +106,42 @@ emit_##NAME(const void *attrib, void *ptr)		\
 }
 
 
+/**
+ * Fetch a half-float vertex attribute, converting all four channels at
+ * once.  Missing channels are filled with 0, 0, 0, 1 before the conversion.
+ */
+#define FETCH_HALF( NAME, SZ )                                          \
+static void                                                             \
+fetch_##NAME(void *dst, const uint8_t *src, unsigned i, unsigned j)     \
+{                                                                       \
+   uint16_t in[4] = { 0, 0, 0, 0x3c00 };                                \
+                                                                        \
+   memcpy(in, src, SZ * sizeof(uint16_t));                              \
+   _mesa_half_to_float_array((float *) dst, in, 4);                     \
+}
+
+FETCH_HALF( R16G16B16A16_FLOAT, 4 )
+FETCH_HALF( R16G16B16_FLOAT, 3 )
+FETCH_HALF( R16G16_FLOAT, 2 )
+FETCH_HALF( R16_FLOAT, 1 )
+
+static fetch_func get_half_fetch_func( enum pipe_format format )
+{
+   switch (format) {
+   case PIPE_FORMAT_R16G16B16A16_FLOAT:
+      return &fetch_R16G16B16A16_FLOAT;
+   case PIPE_FORMAT_R16G16B16_FLOAT:
+      return &fetch_R16G16B16_FLOAT;
+   case PIPE_FORMAT_R16G16_FLOAT:
+      return &fetch_R16G16_FLOAT;
+   case PIPE_FORMAT_R16_FLOAT:
+      return &fetch_R16_FLOAT;
+   default:
+      return NULL;
+   }
+}
+
+
 #define TO_64_FLOAT(x)   ((double) x)
 #define TO_32_FLOAT(x)   (x)
 #define TO_16_FLOAT(x)   util_float_to_half(x)
@@ -746,6 +783,13 @@ static void generic_release( struct translate *translate )
    FREE(translate);
 }
 
+static struct translate *generic_clone( struct translate *translate )
+{
+   /* There is no generated code to share, so this is as cheap as it gets.
+    */
+   return translate_generic_create( &translate->key );
+}
+
 static boolean
 is_legal_int_format_combo( const struct util_format_description *src,
                            const struct util_format_description *dst )
@@ -779,6 +823,7 @@ struct translate *translate_generic_create( const struct translate_key *key )
 
    tg->translate.key = *key;
    tg->translate.release = generic_release;
+   tg->translate.clone = generic_clone;
    tg->translate.set_buffer = generic_set_buffer;
    tg->translate.run_elts = generic_run_elts;
    tg->translate.run_elts16 = generic_run_elts16;
@@ -811,7 +856,9 @@ struct translate *translate_generic_create( const struct translate_key *key )
          }
       } else {
          assert(format_desc->fetch_rgba_float);
-         tg->attrib[i].fetch = (fetch_func)format_desc->fetch_rgba_float;
+         tg->attrib[i].fetch = get_half_fetch_func(key->element[i].input_format);
+         if (!tg->attrib[i].fetch)
+            tg->attrib[i].fetch = (fetch_func)format_desc->fetch_rgba_float;
       }
 
       tg->attrib[i].buffer = key->element[i].input_buffer;
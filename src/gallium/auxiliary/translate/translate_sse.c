@@ -31,6 +31,7 @@
 #include "util/u_memory.h"
 #include "util/u_math.h"
 #include "util/u_format.h"
+#include "util/u_atomic.h"
 
 #include "translate.h"
 
@@ -100,6 +101,12 @@ struct translate_sse
    struct x86_function elt8_func;
    struct x86_function *func;
 
+   /* The translate owning the functions above, which clones share.  Its
+    * refcount counts itself and its clones.
+    */
+   struct translate_sse *code;
+   int32_t refcount;
+
      PIPE_ALIGN_VAR(16) float consts[NUM_CONSTS][4];
    int8_t reg_to_const[16];
    int8_t const_to_reg[NUM_CONSTS];
@@ -1465,13 +1472,48 @@ static void
 translate_sse_release(struct translate *translate)
 {
    struct translate_sse *p = (struct translate_sse *) translate;
+   struct translate_sse *code = p->code;
+
+   if (code != p)
+      os_free_aligned(p);
+
+   if (!p_atomic_dec_zero(&code->refcount))
+      return;
+
+   x86_release_func(&code->elt8_func);
+   x86_release_func(&code->elt16_func);
+   x86_release_func(&code->elt_func);
+   x86_release_func(&code->linear_func);
+
+   os_free_aligned(code);
+}
+
+
+static struct translate *
+translate_sse_clone(struct translate *translate)
+{
+   struct translate_sse *p = (struct translate_sse *) translate;
+   struct translate_sse *code = p->code;
+   struct translate_sse *clone;
+   unsigned i;
+
+   clone = os_malloc_aligned(sizeof(struct translate_sse), 16);
+   if (!clone)
+      return NULL;
+
+   /* The generated code only reaches the translate_sse through the machine
+    * pointer it is called with, so a copy can run it with its own buffers.
+    */
+   memcpy(clone, code, sizeof(*clone));
+   memset(clone->buffer, 0, sizeof(clone->buffer));
+   for (i = 0; i < clone->nr_buffer_variants; i++)
+      clone->buffer_variant[i].ptr = NULL;
+   clone->instance_id = 0;
+   clone->start_instance = 0;
 
-   x86_release_func(&p->elt8_func);
-   x86_release_func(&p->elt16_func);
-   x86_release_func(&p->elt_func);
-   x86_release_func(&p->linear_func);
+   p_atomic_inc(&code->refcount);
 
-   os_free_aligned(p);
+   return &clone->translate;
 }
 
 
@@ -1491,9 +1533,12 @@ translate_sse2_create(const struct translate_key *key)
 
    memset(p, 0, sizeof(*p));
    memcpy(p->consts, consts, sizeof(consts));
+   p->code = p;
+   p->refcount = 1;
 
    p->translate.key = *key;
    p->translate.release = translate_sse_release;
+   p->translate.clone = translate_sse_clone;
    p->translate.set_buffer = translate_sse_set_buffer;
 
    assert(key->nr_elements <= TRANSLATE_MAX_ATTRIBS);
@@ -51,6 +51,14 @@
 
 #define INVALID_PTR ((void*)~0)
 
+/* Groups of saved states, whose restoration is deferred during a batch. */
+#define BLITTER_RESTORE_VERTEX      (1 << 0)
+#define BLITTER_RESTORE_FRAGMENT    (1 << 1)
+#define BLITTER_RESTORE_FB          (1 << 2)
+#define BLITTER_RESTORE_TEXTURES    (1 << 3)
+#define BLITTER_RESTORE_SCISSOR     (1 << 4)
+#define BLITTER_RESTORE_RENDER_COND (1 << 5)
+
 #define GET_CLEAR_BLEND_STATE_IDX(clear_buffers) \
    ((clear_buffers) / PIPE_CLEAR_COLOR0)
 
@@ -72,6 +80,9 @@ struct blitter_context_priv
    void *vs; /**< Vertex shader which passes {pos, generic} to the output.*/
    void *vs_pos_only[4]; /**< Vertex shader which passes pos to the output.*/
    void *vs_layered; /**< Vertex shader which sets LAYER = INSTANCEID. */
+   /** Vertex shaders which also add INSTANCEID to the texcoord layer,
+    *  indexed by the texcoord channel holding the layer. */
+   void *vs_layered_blit[4];
 
    /* Fragment shaders. */
    void *fs_empty;
@@ -141,6 +152,16 @@ struct blitter_context_priv
    boolean has_texture_multisample;
    boolean cached_all_shaders;
 
+   /* Between util_blitter_begin_batch and util_blitter_end_batch. */
+   boolean batch;
+   unsigned batch_restore;   /**< BLITTER_RESTORE_* deferred to the end */
+
+   /* The blitter's own state objects currently bound, only tracked
+    * during a batch to skip redundant binds. */
+   void *bound_fs, *bound_vs, *bound_blend, *bound_dsa;
+   void *bound_rs, *bound_velem;
+   boolean bound_vertex_stages;
+
    /* The Draw module overrides these functions.
     * Always create the blitter before Draw. */
    void   (*bind_fs_state)(struct pipe_context *, void *);
@@ -325,6 +346,67 @@ struct blitter_context *util_blitter_create(struct pipe_context *pipe)
    return &ctx->base;
 }
 
+/* Bind the blitter's own state objects.  During a batch, the object which
+ * is already bound isn't bound again. */
+static void blitter_bind_fs(struct blitter_context_priv *ctx, void *fs)
+{
+   if (ctx->batch && ctx->bound_fs == fs)
+      return;
+   ctx->bound_fs = fs;
+   ctx->bind_fs_state(ctx->base.pipe, fs);
+}
+
+static void blitter_bind_vs(struct blitter_context_priv *ctx, void *vs)
+{
+   if (ctx->batch && ctx->bound_vs == vs)
+      return;
+   ctx->bound_vs = vs;
+   ctx->base.pipe->bind_vs_state(ctx->base.pipe, vs);
+}
+
+static void blitter_bind_blend(struct blitter_context_priv *ctx, void *blend)
+{
+   if (ctx->batch && ctx->bound_blend == blend)
+      return;
+   ctx->bound_blend = blend;
+   ctx->base.pipe->bind_blend_state(ctx->base.pipe, blend);
+}
+
+static void blitter_bind_dsa(struct blitter_context_priv *ctx, void *dsa)
+{
+   if (ctx->batch && ctx->bound_dsa == dsa)
+      return;
+   ctx->bound_dsa = dsa;
+   ctx->base.pipe->bind_depth_stencil_alpha_state(ctx->base.pipe, dsa);
+}
+
+static void blitter_bind_rs(struct blitter_context_priv *ctx, void *rs)
+{
+   if (ctx->batch && ctx->bound_rs == rs)
+      return;
+   ctx->bound_rs = rs;
+   ctx->base.pipe->bind_rasterizer_state(ctx->base.pipe, rs);
+}
+
+static void blitter_bind_velem(struct blitter_context_priv *ctx, void *velem)
+{
+   if (ctx->batch && ctx->bound_velem == velem)
+      return;
+   ctx->bound_velem = velem;
+   ctx->base.pipe->bind_vertex_elements_state(ctx->base.pipe, velem);
+}
+
+static void blitter_forget_bound_states(struct blitter_context_priv *ctx)
+{
+   ctx->bound_fs = INVALID_PTR;
+   ctx->bound_vs = INVALID_PTR;
+   ctx->bound_blend = INVALID_PTR;
+   ctx->bound_dsa = INVALID_PTR;
+   ctx->bound_rs = INVALID_PTR;
+   ctx->bound_velem = INVALID_PTR;
+   ctx->bound_vertex_stages = FALSE;
+}
+
 static void bind_vs_pos_only(struct blitter_context_priv *ctx,
                              unsigned num_so_channels)
 {
@@ -347,7 +429,7 @@ static void bind_vs_pos_only(struct blitter_context_priv *ctx,
                                                      &so);
    }
 
-   pipe->bind_vs_state(pipe, ctx->vs_pos_only[index]);
+   blitter_bind_vs(ctx, ctx->vs_pos_only[index]);
 }
 
 static void bind_vs_passthrough(struct blitter_context_priv *ctx)
@@ -363,7 +445,7 @@ static void bind_vs_passthrough(struct blitter_context_priv *ctx)
                                              semantic_indices, FALSE);
    }
 
-   pipe->bind_vs_state(pipe, ctx->vs);
+   blitter_bind_vs(ctx, ctx->vs);
 }
 
 static void bind_vs_layered(struct blitter_context_priv *ctx)
@@ -374,7 +456,20 @@ static void bind_vs_layered(struct blitter_context_priv *ctx)
       ctx->vs_layered = util_make_layered_clear_vertex_shader(pipe);
    }
 
-   pipe->bind_vs_state(pipe, ctx->vs_layered);
+   blitter_bind_vs(ctx, ctx->vs_layered);
+}
+
+static void bind_vs_layered_blit(struct blitter_context_priv *ctx,
+                                 unsigned layer_chan)
+{
+   struct pipe_context *pipe = ctx->base.pipe;
+
+   if (!ctx->vs_layered_blit[layer_chan]) {
+      ctx->vs_layered_blit[layer_chan] =
+         util_make_layered_blit_vertex_shader(pipe, layer_chan);
+   }
+
+   blitter_bind_vs(ctx, ctx->vs_layered_blit[layer_chan]);
 }
 
 static void bind_fs_empty(struct blitter_context_priv *ctx)
@@ -386,7 +481,7 @@ static void bind_fs_empty(struct blitter_context_priv *ctx)
       ctx->fs_empty = util_make_empty_fragment_shader(pipe);
    }
 
-   ctx->bind_fs_state(pipe, ctx->fs_empty);
+   blitter_bind_fs(ctx, ctx->fs_empty);
 }
 
 static void bind_fs_write_one_cbuf(struct blitter_context_priv *ctx)
@@ -400,7 +495,7 @@ static void bind_fs_write_one_cbuf(struct blitter_context_priv *ctx)
                                                TGSI_INTERPOLATE_CONSTANT, FALSE);
    }
 
-   ctx->bind_fs_state(pipe, ctx->fs_write_one_cbuf);
+   blitter_bind_fs(ctx, ctx->fs_write_one_cbuf);
 }
 
 static void bind_fs_write_all_cbufs(struct blitter_context_priv *ctx)
@@ -414,7 +509,7 @@ static void bind_fs_write_all_cbufs(struct blitter_context_priv *ctx)
                                                TGSI_INTERPOLATE_CONSTANT, TRUE);
    }
 
-   ctx->bind_fs_state(pipe, ctx->fs_write_all_cbufs);
+   blitter_bind_fs(ctx, ctx->fs_write_all_cbufs);
 }
 
 void util_blitter_destroy(struct blitter_context *blitter)
@@ -448,6 +543,9 @@ void util_blitter_destroy(struct blitter_context *blitter)
          pipe->delete_vs_state(pipe, ctx->vs_pos_only[i]);
    if (ctx->vs_layered)
       pipe->delete_vs_state(pipe, ctx->vs_layered);
+   for (i = 0; i < 4; i++)
+      if (ctx->vs_layered_blit[i])
+         pipe->delete_vs_state(pipe, ctx->vs_layered_blit[i]);
    pipe->delete_vertex_elements_state(pipe, ctx->velem_state);
    for (i = 0; i < 4; i++) {
       if (ctx->velem_state_readbuf[i]) {
@@ -555,6 +653,11 @@ static void blitter_restore_vertex_states(struct blitter_context_priv *ctx)
    struct pipe_context *pipe = ctx->base.pipe;
    unsigned i;
 
+   if (ctx->batch) {
+      ctx->batch_restore |= BLITTER_RESTORE_VERTEX;
+      return;
+   }
+
    /* Vertex buffer. */
    pipe->set_vertex_buffers(pipe, ctx->base.vb_slot, 1,
                             &ctx->base.saved_vertex_buffer);
@@ -612,6 +715,11 @@ static void blitter_restore_fragment_states(struct blitter_context_priv *ctx)
 {
    struct pipe_context *pipe = ctx->base.pipe;
 
+   if (ctx->batch) {
+      ctx->batch_restore |= BLITTER_RESTORE_FRAGMENT;
+      return;
+   }
+
    /* Fragment shader. */
    ctx->bind_fs_state(pipe, ctx->base.saved_fs);
    ctx->base.saved_fs = INVALID_PTR;
@@ -655,6 +763,11 @@ static void blitter_restore_render_cond(struct blitter_context_priv *ctx)
 {
    struct pipe_context *pipe = ctx->base.pipe;
 
+   if (ctx->batch) {
+      ctx->batch_restore |= BLITTER_RESTORE_RENDER_COND;
+      return;
+   }
+
    if (ctx->base.saved_render_cond_query) {
       pipe->render_condition(pipe, ctx->base.saved_render_cond_query,
                              ctx->base.saved_render_cond_cond,
@@ -667,10 +780,27 @@ static void blitter_restore_fb_state(struct blitter_context_priv *ctx)
 {
    struct pipe_context *pipe = ctx->base.pipe;
 
+   if (ctx->batch) {
+      ctx->batch_restore |= BLITTER_RESTORE_FB;
+      return;
+   }
+
    pipe->set_framebuffer_state(pipe, &ctx->base.saved_fb_state);
    util_unreference_framebuffer_state(&ctx->base.saved_fb_state);
 }
 
+static void blitter_restore_scissor(struct blitter_context_priv *ctx)
+{
+   struct pipe_context *pipe = ctx->base.pipe;
+
+   if (ctx->batch) {
+      ctx->batch_restore |= BLITTER_RESTORE_SCISSOR;
+      return;
+   }
+
+   pipe->set_scissor_states(pipe, 0, 1, &ctx->base.saved_scissor);
+}
+
 static void blitter_check_saved_textures(struct blitter_context_priv *ctx)
 {
    assert(ctx->base.saved_num_sampler_states != ~0);
@@ -682,6 +812,11 @@ static void blitter_restore_textures(struct blitter_context_priv *ctx)
    struct pipe_context *pipe = ctx->base.pipe;
    unsigned i;
 
+   if (ctx->batch) {
+      ctx->batch_restore |= BLITTER_RESTORE_TEXTURES;
+      return;
+   }
+
    /* Fragment sampler states. */
    pipe->bind_sampler_states(pipe, PIPE_SHADER_FRAGMENT, 0,
                              ctx->base.saved_num_sampler_states,
@@ -700,6 +835,41 @@ static void blitter_restore_textures(struct blitter_context_priv *ctx)
    ctx->base.saved_num_sampler_views = ~0;
 }
 
+void util_blitter_begin_batch(struct blitter_context *blitter)
+{
+   struct blitter_context_priv *ctx = (struct blitter_context_priv*)blitter;
+
+   assert(!ctx->batch);
+   ctx->batch = TRUE;
+   ctx->batch_restore = 0;
+   blitter_forget_bound_states(ctx);
+}
+
+void util_blitter_end_batch(struct blitter_context *blitter)
+{
+   struct blitter_context_priv *ctx = (struct blitter_context_priv*)blitter;
+   unsigned restore = ctx->batch_restore;
+
+   assert(ctx->batch);
+   ctx->batch = FALSE;
+   ctx->batch_restore = 0;
+
+   /* Restore everything the operations of the batch would have restored,
+    * in the same order. */
+   if (restore & BLITTER_RESTORE_VERTEX)
+      blitter_restore_vertex_states(ctx);
+   if (restore & BLITTER_RESTORE_FRAGMENT)
+      blitter_restore_fragment_states(ctx);
+   if (restore & BLITTER_RESTORE_TEXTURES)
+      blitter_restore_textures(ctx);
+   if (restore & BLITTER_RESTORE_FB)
+      blitter_restore_fb_state(ctx);
+   if (restore & BLITTER_RESTORE_SCISSOR)
+      blitter_restore_scissor(ctx);
+   if (restore & BLITTER_RESTORE_RENDER_COND)
+      blitter_restore_render_cond(ctx);
+}
+
 static void blitter_set_rectangle(struct blitter_context_priv *ctx,
                                   int x1, int y1, int x2, int y2,
                                   float depth)
@@ -1163,13 +1333,17 @@ static void blitter_set_common_draw_rect_state(struct blitter_context_priv *ctx,
 {
    struct pipe_context *pipe = ctx->base.pipe;
 
-   pipe->bind_rasterizer_state(pipe, scissor ? ctx->rs_state_scissor
-                                             : ctx->rs_state);
+   blitter_bind_rs(ctx, scissor ? ctx->rs_state_scissor
+                                : ctx->rs_state);
    if (vs_layered)
       bind_vs_layered(ctx);
    else
       bind_vs_passthrough(ctx);
 
+   if (ctx->batch && ctx->bound_vertex_stages)
+      return;
+   ctx->bound_vertex_stages = TRUE;
+
    if (ctx->has_geometry_shader)
       pipe->bind_gs_state(pipe, NULL);
    if (ctx->has_tessellation) {
@@ -1281,27 +1455,27 @@ static void util_blitter_clear_custom(struct blitter_context *blitter,
 
    /* bind states */
    if (custom_blend) {
-      pipe->bind_blend_state(pipe, custom_blend);
+      blitter_bind_blend(ctx, custom_blend);
    } else {
-      pipe->bind_blend_state(pipe, get_clear_blend_state(ctx, clear_buffers));
+      blitter_bind_blend(ctx, get_clear_blend_state(ctx, clear_buffers));
    }
 
    if (custom_dsa) {
-      pipe->bind_depth_stencil_alpha_state(pipe, custom_dsa);
+      blitter_bind_dsa(ctx, custom_dsa);
    } else if ((clear_buffers & PIPE_CLEAR_DEPTHSTENCIL) == PIPE_CLEAR_DEPTHSTENCIL) {
-      pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_write_depth_stencil);
+      blitter_bind_dsa(ctx, ctx->dsa_write_depth_stencil);
    } else if (clear_buffers & PIPE_CLEAR_DEPTH) {
-      pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_write_depth_keep_stencil);
+      blitter_bind_dsa(ctx, ctx->dsa_write_depth_keep_stencil);
    } else if (clear_buffers & PIPE_CLEAR_STENCIL) {
-      pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_write_stencil);
+      blitter_bind_dsa(ctx, ctx->dsa_keep_depth_write_stencil);
    } else {
-      pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
+      blitter_bind_dsa(ctx, ctx->dsa_keep_depth_stencil);
    }
 
    sr.ref_value[0] = stencil & 0xff;
    pipe->set_stencil_ref(pipe, &sr);
 
-   pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
+   blitter_bind_velem(ctx, ctx->velem_state);
    bind_fs_write_all_cbufs(ctx);
    pipe->set_sample_mask(pipe, ~0);
 
@@ -1570,24 +1744,21 @@ void util_blitter_blit_generic(struct blitter_context *blitter,
    fb_state.zsbuf = NULL;
 
    if (blit_depth || blit_stencil) {
-      pipe->bind_blend_state(pipe, ctx->blend[0][0]);
+      blitter_bind_blend(ctx, ctx->blend[0][0]);
 
       if (blit_depth && blit_stencil) {
-         pipe->bind_depth_stencil_alpha_state(pipe,
-                                              ctx->dsa_write_depth_stencil);
-         ctx->bind_fs_state(pipe,
+         blitter_bind_dsa(ctx, ctx->dsa_write_depth_stencil);
+         blitter_bind_fs(ctx,
                blitter_get_fs_texfetch_depthstencil(ctx, src_target,
                                                     src_samples));
       } else if (blit_depth) {
-         pipe->bind_depth_stencil_alpha_state(pipe,
-                                              ctx->dsa_write_depth_keep_stencil);
-         ctx->bind_fs_state(pipe,
+         blitter_bind_dsa(ctx, ctx->dsa_write_depth_keep_stencil);
+         blitter_bind_fs(ctx,
                blitter_get_fs_texfetch_depth(ctx, src_target,
                                              src_samples));
       } else { /* is_stencil */
-         pipe->bind_depth_stencil_alpha_state(pipe,
-                                              ctx->dsa_keep_depth_write_stencil);
-         ctx->bind_fs_state(pipe,
+         blitter_bind_dsa(ctx, ctx->dsa_keep_depth_write_stencil);
+         blitter_bind_fs(ctx,
                blitter_get_fs_texfetch_stencil(ctx, src_target,
                                                src_samples));
       }
@@ -1595,9 +1766,9 @@ void util_blitter_blit_generic(struct blitter_context *blitter,
    } else {
       unsigned colormask = mask & PIPE_MASK_RGBA;
 
-      pipe->bind_blend_state(pipe, ctx->blend[colormask][alpha_blend]);
-      pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
-      ctx->bind_fs_state(pipe,
+      blitter_bind_blend(ctx, ctx->blend[colormask][alpha_blend]);
+      blitter_bind_dsa(ctx, ctx->dsa_keep_depth_stencil);
+      blitter_bind_fs(ctx,
             blitter_get_fs_texfetch_col(ctx, src->format, src_target,
                                         src_samples, dst_samples, filter));
    }
@@ -1657,7 +1828,7 @@ void util_blitter_blit_generic(struct blitter_context *blitter,
                                 0, 1, &sampler_state);
    }
 
-   pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
+   blitter_bind_velem(ctx, ctx->velem_state);
    if (scissor) {
       pipe->set_scissor_states(pipe, 0, 1, scissor);
    }
@@ -1694,6 +1865,49 @@ void util_blitter_blit_generic(struct blitter_context *blitter,
                               dstbox->x + dstbox->width,
                               dstbox->y + dstbox->height, 0,
                               UTIL_BLITTER_ATTRIB_TEXCOORD, &coord);
+   } else if (ctx->has_layered &&
+              dstbox->depth > 1 && srcbox->depth == dstbox->depth &&
+              (src_target == PIPE_TEXTURE_1D_ARRAY ||
+               src_target == PIPE_TEXTURE_2D_ARRAY) &&
+              (dst->texture->target == PIPE_TEXTURE_1D_ARRAY ||
+               dst->texture->target == PIPE_TEXTURE_2D_ARRAY) &&
+              src_samples <= 1 && dst_samples <= 1) {
+      /* Unscaled in Z between arrays: draw all layers at once, with the
+       * instance id selecting both the destination layer and the source
+       * layer.  This makes e.g. mipmap generation of big arrays one draw
+       * per level instead of one per level and layer.
+       */
+      struct pipe_surface *layered, surf_templ;
+
+      memset(&surf_templ, 0, sizeof(surf_templ));
+      surf_templ.format = dst->format;
+      surf_templ.u.tex.level = dst->u.tex.level;
+      surf_templ.u.tex.first_layer = dst->u.tex.first_layer;
+      surf_templ.u.tex.last_layer = dst->u.tex.first_layer + dstbox->depth - 1;
+      layered = pipe->create_surface(pipe, dst->texture, &surf_templ);
+
+      if (layered) {
+         if (blit_depth || blit_stencil) {
+            fb_state.zsbuf = layered;
+         } else {
+            fb_state.cbufs[0] = layered;
+         }
+         pipe->set_framebuffer_state(pipe, &fb_state);
+
+         bind_vs_layered_blit(ctx,
+                              src_target == PIPE_TEXTURE_1D_ARRAY ? 1 : 2);
+         pipe->set_sample_mask(pipe, ~0);
+         blitter_set_texcoords(ctx, src, src_width0, src_height0,
+                               srcbox->z, 0,
+                               srcbox->x, srcbox->y,
+                               srcbox->x + srcbox->width,
+                               srcbox->y + srcbox->height);
+         blitter_draw(ctx, dstbox->x, dstbox->y,
+                      dstbox->x + dstbox->width,
+                      dstbox->y + dstbox->height, 0, dstbox->depth);
+
+         pipe_surface_reference(&layered, NULL);
+      }
    } else {
       /* Draw the quad with the generic codepath. */
       int dst_z;
@@ -1776,7 +1990,7 @@ void util_blitter_blit_generic(struct blitter_context *blitter,
    blitter_restore_textures(ctx);
    blitter_restore_fb_state(ctx);
    if (scissor) {
-      pipe->set_scissor_states(pipe, 0, 1, &ctx->base.saved_scissor);
+      blitter_restore_scissor(ctx);
    }
    blitter_restore_render_cond(ctx);
    blitter_unset_running_flag(ctx);
@@ -1839,10 +2053,10 @@ void util_blitter_clear_render_target(struct blitter_context *blitter,
    blitter_disable_render_cond(ctx);
 
    /* bind states */
-   pipe->bind_blend_state(pipe, ctx->blend[PIPE_MASK_RGBA][0]);
-   pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
+   blitter_bind_blend(ctx, ctx->blend[PIPE_MASK_RGBA][0]);
+   blitter_bind_dsa(ctx, ctx->dsa_keep_depth_stencil);
    bind_fs_write_one_cbuf(ctx);
-   pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
+   blitter_bind_velem(ctx, ctx->velem_state);
 
    /* set a framebuffer state */
    fb_state.width = dstsurf->width;
@@ -1901,26 +2115,26 @@ void util_blitter_clear_depth_stencil(struct blitter_context *blitter,
    blitter_disable_render_cond(ctx);
 
    /* bind states */
-   pipe->bind_blend_state(pipe, ctx->blend[0][0]);
+   blitter_bind_blend(ctx, ctx->blend[0][0]);
    if ((clear_flags & PIPE_CLEAR_DEPTHSTENCIL) == PIPE_CLEAR_DEPTHSTENCIL) {
       sr.ref_value[0] = stencil & 0xff;
-      pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_write_depth_stencil);
+      blitter_bind_dsa(ctx, ctx->dsa_write_depth_stencil);
       pipe->set_stencil_ref(pipe, &sr);
    }
    else if (clear_flags & PIPE_CLEAR_DEPTH) {
-      pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_write_depth_keep_stencil);
+      blitter_bind_dsa(ctx, ctx->dsa_write_depth_keep_stencil);
    }
    else if (clear_flags & PIPE_CLEAR_STENCIL) {
       sr.ref_value[0] = stencil & 0xff;
-      pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_write_stencil);
+      blitter_bind_dsa(ctx, ctx->dsa_keep_depth_write_stencil);
       pipe->set_stencil_ref(pipe, &sr);
    }
    else
       /* hmm that should be illegal probably, or make it a no-op somewhere */
-      pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
+      blitter_bind_dsa(ctx, ctx->dsa_keep_depth_stencil);
 
    bind_fs_empty(ctx);
-   pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
+   blitter_bind_velem(ctx, ctx->velem_state);
 
    /* set a framebuffer state */
    fb_state.width = dstsurf->width;
@@ -1975,14 +2189,14 @@ void util_blitter_custom_depth_stencil(struct blitter_context *blitter,
    blitter_disable_render_cond(ctx);
 
    /* bind states */
-   pipe->bind_blend_state(pipe, cbsurf ? ctx->blend[PIPE_MASK_RGBA][0] :
-                                         ctx->blend[0][0]);
-   pipe->bind_depth_stencil_alpha_state(pipe, dsa_stage);
+   blitter_bind_blend(ctx, cbsurf ? ctx->blend[PIPE_MASK_RGBA][0] :
+                                    ctx->blend[0][0]);
+   blitter_bind_dsa(ctx, dsa_stage);
    if (cbsurf)
       bind_fs_write_one_cbuf(ctx);
    else
       bind_fs_empty(ctx);
-   pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
+   blitter_bind_velem(ctx, ctx->velem_state);
 
    /* set a framebuffer state */
    fb_state.width = zsurf->width;
@@ -2057,7 +2271,7 @@ void util_blitter_copy_buffer(struct blitter_context *blitter,
    vb.stride = 4;
 
    pipe->set_vertex_buffers(pipe, ctx->base.vb_slot, 1, &vb);
-   pipe->bind_vertex_elements_state(pipe, ctx->velem_state_readbuf[0]);
+   blitter_bind_velem(ctx, ctx->velem_state_readbuf[0]);
    bind_vs_pos_only(ctx, 1);
    if (ctx->has_geometry_shader)
       pipe->bind_gs_state(pipe, NULL);
@@ -2065,7 +2279,7 @@ void util_blitter_copy_buffer(struct blitter_context *blitter,
       pipe->bind_tcs_state(pipe, NULL);
       pipe->bind_tes_state(pipe, NULL);
    }
-   pipe->bind_rasterizer_state(pipe, ctx->rs_discard_state);
+   blitter_bind_rs(ctx, ctx->rs_discard_state);
 
    so_target = pipe->create_stream_output_target(pipe, dst, dstx, size);
    pipe->set_stream_output_targets(pipe, 1, &so_target, offsets);
@@ -2123,8 +2337,7 @@ void util_blitter_clear_buffer(struct blitter_context *blitter,
    blitter_disable_render_cond(ctx);
 
    pipe->set_vertex_buffers(pipe, ctx->base.vb_slot, 1, &vb);
-   pipe->bind_vertex_elements_state(pipe,
-                                    ctx->velem_state_readbuf[num_channels-1]);
+   blitter_bind_velem(ctx, ctx->velem_state_readbuf[num_channels-1]);
    bind_vs_pos_only(ctx, num_channels);
    if (ctx->has_geometry_shader)
       pipe->bind_gs_state(pipe, NULL);
@@ -2132,7 +2345,7 @@ void util_blitter_clear_buffer(struct blitter_context *blitter,
       pipe->bind_tcs_state(pipe, NULL);
       pipe->bind_tes_state(pipe, NULL);
    }
-   pipe->bind_rasterizer_state(pipe, ctx->rs_discard_state);
+   blitter_bind_rs(ctx, ctx->rs_discard_state);
 
    so_target = pipe->create_stream_output_target(pipe, dst, offset, size);
    pipe->set_stream_output_targets(pipe, 1, &so_target, offsets);
@@ -2169,9 +2382,9 @@ void util_blitter_custom_resolve_color(struct blitter_context *blitter,
    blitter_disable_render_cond(ctx);
 
    /* bind states */
-   pipe->bind_blend_state(pipe, custom_blend);
-   pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
-   pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
+   blitter_bind_blend(ctx, custom_blend);
+   blitter_bind_dsa(ctx, ctx->dsa_keep_depth_stencil);
+   blitter_bind_velem(ctx, ctx->velem_state);
    bind_fs_write_one_cbuf(ctx);
    pipe->set_sample_mask(pipe, sample_mask);
 
@@ -2232,11 +2445,11 @@ void util_blitter_custom_color(struct blitter_context *blitter,
    blitter_disable_render_cond(ctx);
 
    /* bind states */
-   pipe->bind_blend_state(pipe, custom_blend ? custom_blend
-                                             : ctx->blend[PIPE_MASK_RGBA][0]);
-   pipe->bind_depth_stencil_alpha_state(pipe, ctx->dsa_keep_depth_stencil);
+   blitter_bind_blend(ctx, custom_blend ? custom_blend
+                                        : ctx->blend[PIPE_MASK_RGBA][0]);
+   blitter_bind_dsa(ctx, ctx->dsa_keep_depth_stencil);
    bind_fs_write_one_cbuf(ctx);
-   pipe->bind_vertex_elements_state(pipe, ctx->velem_state);
+   blitter_bind_velem(ctx, ctx->velem_state);
    pipe->set_sample_mask(pipe, (1ull << MAX2(1, dstsurf->texture->nr_samples)) - 1);
 
    /* set a framebuffer state */
@@ -365,6 +365,26 @@ void util_blitter_custom_resolve_color(struct blitter_context *blitter,
                                        void *custom_blend,
                                        enum pipe_format format);
 
+/**
+ * Start a batch of blitter operations.
+ *
+ * The states are saved once before the batch, and only restored by
+ * util_blitter_end_batch(), instead of around each operation.  The blitter's
+ * own state objects aren't bound again by operations which use the ones
+ * already bound.  The driver must not save or bind any state between the
+ * operations of a batch; driver-internal state (like a decompression flag)
+ * may change.
+ *
+ * This is intended for loops over levels, layers or samples, like
+ * decompressing a whole texture.
+ */
+void util_blitter_begin_batch(struct blitter_context *blitter);
+
+/**
+ * Finish a batch of blitter operations and restore the saved states.
+ */
+void util_blitter_end_batch(struct blitter_context *blitter);
+
 /* The functions below should be used to save currently bound constant state
  * objects inside a driver. The objects are automatically restored at the end
  * of the util_blitter_{clear, copy_region, fill_region} functions and then
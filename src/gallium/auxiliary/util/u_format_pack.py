@@ -611,6 +611,43 @@ def generate_pack_kernel(format, src_channel, src_native_type):
         print_channels(format, pack_into_union)
 
 
+# Functions with SSE2 row functions in u_format_sse2.c, as (format, function)
+sse2_functions = set([
+    ('r8g8b8a8_unorm', 'unpack_rgba_8unorm'),
+    ('r8g8b8a8_unorm', 'pack_rgba_8unorm'),
+    ('r8g8b8a8_unorm', 'unpack_rgba_float'),
+    ('r8g8b8a8_unorm', 'pack_rgba_float'),
+    ('b8g8r8a8_unorm', 'unpack_rgba_8unorm'),
+    ('b8g8r8a8_unorm', 'pack_rgba_8unorm'),
+    ('b8g8r8a8_unorm', 'unpack_rgba_float'),
+    ('b8g8r8a8_unorm', 'pack_rgba_float'),
+    ('b5g6r5_unorm', 'unpack_rgba_8unorm'),
+    ('b5g6r5_unorm', 'unpack_rgba_float'),
+    ('r16_float', 'unpack_rgba_float'),
+    ('r16g16b16a16_float', 'unpack_rgba_float'),
+    ('r32_float', 'unpack_rgba_float'),
+    ('r32_float', 'pack_rgba_float'),
+])
+
+
+def generate_row_loop(format, function, src_step, dst_step):
+    '''Generate the start of the loop over the pixels of a row, letting the
+    SSE2 row function do as much of the row as it can first.'''
+
+    name = format.short_name()
+
+    if (name, function) in sse2_functions:
+        print '      x = 0;'
+        print '#ifdef PIPE_ARCH_SSE'
+        print '      x = util_format_%s_%s_sse2(dst, src, width);' % (name, function)
+        print '      src += x * %u;' % (src_step,)
+        print '      dst += x * %u;' % (dst_step,)
+        print '#endif'
+        print '      for(; x < width; x += %u) {' % (format.block_width,)
+    else:
+        print '      for(x = 0; x < width; x += %u) {' % (format.block_width,)
+
+
 def generate_format_unpack(format, dst_channel, dst_native_type, dst_suffix):
     '''Generate the function to unpack pixels from a particular format'''
 
@@ -625,7 +662,8 @@ def generate_format_unpack(format, dst_channel, dst_native_type, dst_suffix):
         print '   for(y = 0; y < height; y += %u) {' % (format.block_height,)
         print '      %s *dst = dst_row;' % (dst_native_type)
         print '      const uint8_t *src = src_row;'
-        print '      for(x = 0; x < width; x += %u) {' % (format.block_width,)
+        generate_row_loop(format, 'unpack_' + dst_suffix,
+                          format.block_size() / 8, 4)
         
         generate_unpack_kernel(format, dst_channel, dst_native_type)
     
@@ -654,7 +692,8 @@ def generate_format_pack(format, src_channel, src_native_type, src_suffix):
         print '   for(y = 0; y < height; y += %u) {' % (format.block_height,)
         print '      const %s *src = src_row;' % (src_native_type)
         print '      uint8_t *dst = dst_row;'
-        print '      for(x = 0; x < width; x += %u) {' % (format.block_width,)
+        generate_row_loop(format, 'pack_' + src_suffix,
+                          4, format.block_size() / 8)
     
         generate_pack_kernel(format, src_channel, src_native_type)
             
@@ -699,6 +738,7 @@ def generate(formats):
     print '#include "util/format_srgb.h"'
     print '#include "u_format_yuv.h"'
     print '#include "u_format_zs.h"'
+    print '#include "u_format_sse2.h"'
     print
 
     for format in formats:
@@ -0,0 +1,495 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * SSE2 row functions for the most common formats.
+ *
+ * These must give exactly the same results as the code generated by
+ * u_format_pack.py, so they follow its arithmetic step by step rather than
+ * using the fastest approximation.
+ */
+
+
+#include "pipe/p_config.h"
+
+#if defined(PIPE_ARCH_SSE)
+
+#include "u_debug.h"
+#include "u_format_sse2.h"
+#include "u_sse.h"
+
+
+/**
+ * Swap the first and third byte of each pixel, i.e. RGBA8 <-> BGRA8.
+ */
+static inline __m128i
+swap_rb(__m128i v)
+{
+   const __m128i ag_mask = _mm_set1_epi32(0xff00ff00);
+   const __m128i byte_mask = _mm_set1_epi32(0xff);
+
+   return _mm_or_si128(_mm_and_si128(v, ag_mask),
+                       _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16),
+                                                  byte_mask),
+                                    _mm_slli_epi32(_mm_and_si128(v, byte_mask),
+                                                   16)));
+}
+
+
+/**
+ * ubyte_to_float() of the four bytes of the first pixel.
+ */
+static inline __m128
+ubyte4_to_float(__m128i bytes)
+{
+   const __m128i zero = _mm_setzero_si128();
+   __m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero);
+
+   return _mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(1.0f / 255.0f));
+}
+
+
+/**
+ * float_to_ubyte() of four floats, returned in the low byte of each lane.
+ *
+ * Like float_to_ubyte(), this clamps by looking at the bits of the floats,
+ * so that NaNs end up the same way.
+ */
+static inline __m128i
+float_to_ubyte4(__m128 f)
+{
+   const __m128i i = _mm_castps_si128(f);
+   const __m128i byte_mask = _mm_set1_epi32(0xff);
+   __m128i negative = _mm_cmplt_epi32(i, _mm_setzero_si128());
+   __m128i one_or_more = _mm_cmpgt_epi32(i, _mm_set1_epi32(0x3f7fffff));
+   __m128 t;
+   __m128i r;
+
+   t = _mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(255.0f / 256.0f)),
+                  _mm_set1_ps(32768.0f));
+   r = _mm_and_si128(_mm_castps_si128(t), byte_mask);
+   r = _mm_or_si128(_mm_andnot_si128(one_or_more, r),
+                    _mm_and_si128(one_or_more, byte_mask));
+   return _mm_andnot_si128(negative, r);
+}
+
+
+/**
+ * float_to_ubyte() of four RGBA float pixels, packed into RGBA8 pixels.
+ */
+static inline __m128i
+pack_float_to_ubyte(const float *src)
+{
+   __m128i p0 = float_to_ubyte4(_mm_loadu_ps(src + 0));
+   __m128i p1 = float_to_ubyte4(_mm_loadu_ps(src + 4));
+   __m128i p2 = float_to_ubyte4(_mm_loadu_ps(src + 8));
+   __m128i p3 = float_to_ubyte4(_mm_loadu_ps(src + 12));
+
+   return _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+}
+
+
+/**
+ * util_half_to_float() of the low 16 bits of each lane.
+ */
+static inline __m128
+half_to_float4(__m128i h)
+{
+   const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32(0xef << 23));
+   const __m128 infnan_exp = _mm_castsi128_ps(_mm_set1_epi32(0xff << 23));
+   __m128i bits = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13);
+   __m128i sign = _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16);
+   __m128 f = _mm_mul_ps(_mm_castsi128_ps(bits), magic);
+   __m128 infnan = _mm_cmpge_ps(f, _mm_set1_ps(65536.0f));
+
+   f = _mm_or_ps(f, _mm_and_ps(infnan, infnan_exp));
+   return _mm_or_ps(f, _mm_castsi128_ps(sign));
+}
+
+
+/**
+ * Store four red values as (r, 0, 0, 1) pixels.
+ */
+static inline void
+store_r_float4(float *dst, __m128 r)
+{
+   const __m128 zero_one = _mm_set_ps(1.0f, 0.0f, 1.0f, 0.0f);
+   __m128 lo = _mm_unpacklo_ps(r, _mm_setzero_ps());
+   __m128 hi = _mm_unpackhi_ps(r, _mm_setzero_ps());
+
+   _mm_storeu_ps(dst + 0, _mm_movelh_ps(lo, zero_one));
+   _mm_storeu_ps(dst + 4, _mm_movehl_ps(zero_one, lo));
+   _mm_storeu_ps(dst + 8, _mm_movelh_ps(hi, zero_one));
+   _mm_storeu_ps(dst + 12, _mm_movehl_ps(zero_one, hi));
+}
+
+
+/**
+ * Divide each x by 31 or 63, where x is a multiple of 255 no bigger than
+ * 31 * 255 or 63 * 255 respectively.
+ */
+static inline __m128i
+div_by_31(__m128i x)
+{
+   return _mm_srli_epi16(_mm_mulhi_epu16(x, _mm_set1_epi16(8457)), 2);
+}
+
+static inline __m128i
+div_by_63(__m128i x)
+{
+   return _mm_srli_epi16(_mm_mulhi_epu16(x, _mm_set1_epi16(8323)), 3);
+}
+
+
+unsigned
+util_format_r8g8b8a8_unorm_unpack_rgba_8unorm_sse2(uint8_t *dst,
+                                                   const uint8_t *src,
+                                                   unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      _mm_storeu_si128((__m128i *)dst,
+                       _mm_loadu_si128((const __m128i *)src));
+      src += 16;
+      dst += 16;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_r8g8b8a8_unorm_pack_rgba_8unorm_sse2(uint8_t *dst,
+                                                 const uint8_t *src,
+                                                 unsigned width)
+{
+   return util_format_r8g8b8a8_unorm_unpack_rgba_8unorm_sse2(dst, src, width);
+}
+
+
+unsigned
+util_format_r8g8b8a8_unorm_unpack_rgba_float_sse2(float *dst,
+                                                  const uint8_t *src,
+                                                  unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *)src);
+
+      _mm_storeu_ps(dst + 0, ubyte4_to_float(v));
+      _mm_storeu_ps(dst + 4, ubyte4_to_float(_mm_srli_si128(v, 4)));
+      _mm_storeu_ps(dst + 8, ubyte4_to_float(_mm_srli_si128(v, 8)));
+      _mm_storeu_ps(dst + 12, ubyte4_to_float(_mm_srli_si128(v, 12)));
+      src += 16;
+      dst += 16;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_r8g8b8a8_unorm_pack_rgba_float_sse2(uint8_t *dst,
+                                                const float *src,
+                                                unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      _mm_storeu_si128((__m128i *)dst, pack_float_to_ubyte(src));
+      src += 16;
+      dst += 16;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_b8g8r8a8_unorm_unpack_rgba_8unorm_sse2(uint8_t *dst,
+                                                   const uint8_t *src,
+                                                   unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *)src);
+
+      _mm_storeu_si128((__m128i *)dst, swap_rb(v));
+      src += 16;
+      dst += 16;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_b8g8r8a8_unorm_pack_rgba_8unorm_sse2(uint8_t *dst,
+                                                 const uint8_t *src,
+                                                 unsigned width)
+{
+   return util_format_b8g8r8a8_unorm_unpack_rgba_8unorm_sse2(dst, src, width);
+}
+
+
+unsigned
+util_format_b8g8r8a8_unorm_unpack_rgba_float_sse2(float *dst,
+                                                  const uint8_t *src,
+                                                  unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      __m128i v = swap_rb(_mm_loadu_si128((const __m128i *)src));
+
+      _mm_storeu_ps(dst + 0, ubyte4_to_float(v));
+      _mm_storeu_ps(dst + 4, ubyte4_to_float(_mm_srli_si128(v, 4)));
+      _mm_storeu_ps(dst + 8, ubyte4_to_float(_mm_srli_si128(v, 8)));
+      _mm_storeu_ps(dst + 12, ubyte4_to_float(_mm_srli_si128(v, 12)));
+      src += 16;
+      dst += 16;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_b8g8r8a8_unorm_pack_rgba_float_sse2(uint8_t *dst,
+                                                const float *src,
+                                                unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      _mm_storeu_si128((__m128i *)dst, swap_rb(pack_float_to_ubyte(src)));
+      src += 16;
+      dst += 16;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_b5g6r5_unorm_unpack_rgba_8unorm_sse2(uint8_t *dst,
+                                                 const uint8_t *src,
+                                                 unsigned width)
+{
+   const __m128i c255 = _mm_set1_epi16(255);
+   const __m128i mask5 = _mm_set1_epi16(0x1f);
+   const __m128i mask6 = _mm_set1_epi16(0x3f);
+   const __m128i alpha = _mm_set1_epi16((short)0xff00);
+   unsigned x;
+
+   for (x = 0; x + 8 <= width; x += 8) {
+      __m128i v = _mm_loadu_si128((const __m128i *)src);
+      __m128i r = _mm_srli_epi16(v, 11);
+      __m128i g = _mm_and_si128(_mm_srli_epi16(v, 5), mask6);
+      __m128i b = _mm_and_si128(v, mask5);
+      __m128i rg, ba;
+
+      r = div_by_31(_mm_mullo_epi16(r, c255));
+      g = div_by_63(_mm_mullo_epi16(g, c255));
+      b = div_by_31(_mm_mullo_epi16(b, c255));
+
+      rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+      ba = _mm_or_si128(b, alpha);
+      _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(rg, ba));
+      _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi16(rg, ba));
+      src += 16;
+      dst += 32;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_b5g6r5_unorm_unpack_rgba_float_sse2(float *dst,
+                                                const uint8_t *src,
+                                                unsigned width)
+{
+   const __m128i mask5 = _mm_set1_epi32(0x1f);
+   const __m128i mask6 = _mm_set1_epi32(0x3f);
+   const __m128 scale5 = _mm_set1_ps(1.0f / 0x1f);
+   const __m128 scale6 = _mm_set1_ps(1.0f / 0x3f);
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      __m128i v = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)src),
+                                     _mm_setzero_si128());
+      __m128 r = _mm_cvtepi32_ps(_mm_srli_epi32(v, 11));
+      __m128 g = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 5), mask6));
+      __m128 b = _mm_cvtepi32_ps(_mm_and_si128(v, mask5));
+      __m128 a = _mm_set1_ps(1.0f);
+
+      r = _mm_mul_ps(r, scale5);
+      g = _mm_mul_ps(g, scale6);
+      b = _mm_mul_ps(b, scale5);
+      _MM_TRANSPOSE4_PS(r, g, b, a);
+
+      _mm_storeu_ps(dst + 0, r);
+      _mm_storeu_ps(dst + 4, g);
+      _mm_storeu_ps(dst + 8, b);
+      _mm_storeu_ps(dst + 12, a);
+      src += 8;
+      dst += 16;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_r16_float_unpack_rgba_float_sse2(float *dst,
+                                             const uint8_t *src,
+                                             unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      __m128i h = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)src),
+                                     _mm_setzero_si128());
+
+      store_r_float4(dst, half_to_float4(h));
+      src += 8;
+      dst += 16;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_r16g16b16a16_float_unpack_rgba_float_sse2(float *dst,
+                                                      const uint8_t *src,
+                                                      unsigned width)
+{
+   const __m128i zero = _mm_setzero_si128();
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      __m128i p01 = _mm_loadu_si128((const __m128i *)src);
+      __m128i p23 = _mm_loadu_si128((const __m128i *)(src + 16));
+
+      _mm_storeu_ps(dst + 0, half_to_float4(_mm_unpacklo_epi16(p01, zero)));
+      _mm_storeu_ps(dst + 4, half_to_float4(_mm_unpackhi_epi16(p01, zero)));
+      _mm_storeu_ps(dst + 8, half_to_float4(_mm_unpacklo_epi16(p23, zero)));
+      _mm_storeu_ps(dst + 12, half_to_float4(_mm_unpackhi_epi16(p23, zero)));
+      src += 32;
+      dst += 16;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_r32_float_unpack_rgba_float_sse2(float *dst,
+                                             const uint8_t *src,
+                                             unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      store_r_float4(dst, _mm_loadu_ps((const float *)src));
+      src += 16;
+      dst += 16;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_r32_float_pack_rgba_float_sse2(uint8_t *dst,
+                                           const float *src,
+                                           unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      __m128 rg01 = _mm_unpacklo_ps(_mm_loadu_ps(src + 0),
+                                    _mm_loadu_ps(src + 4));
+      __m128 rg23 = _mm_unpacklo_ps(_mm_loadu_ps(src + 8),
+                                    _mm_loadu_ps(src + 12));
+
+      _mm_storeu_ps((float *)dst, _mm_movelh_ps(rg01, rg23));
+      src += 16;
+      dst += 16;
+   }
+   return x;
+}
+
+
+/**
+ * z24_unorm_to_z32_float() of four depth values, which is done in double
+ * precision.
+ */
+static inline __m128
+z24_unorm_to_z32_float4(__m128i z)
+{
+   const __m128d scale = _mm_set1_pd(1.0 / 0xffffff);
+   __m128d lo = _mm_mul_pd(_mm_cvtepi32_pd(z), scale);
+   __m128d hi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(z, 8)), scale);
+
+   return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+
+unsigned
+util_format_z24_unorm_s8_uint_unpack_z_float_sse2(float *dst,
+                                                  const uint8_t *src,
+                                                  unsigned width)
+{
+   const __m128i mask = _mm_set1_epi32(0xffffff);
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *)src);
+
+      _mm_storeu_ps(dst, z24_unorm_to_z32_float4(_mm_and_si128(v, mask)));
+      src += 16;
+      dst += 4;
+   }
+   return x;
+}
+
+
+unsigned
+util_format_s8_uint_z24_unorm_unpack_z_float_sse2(float *dst,
+                                                  const uint8_t *src,
+                                                  unsigned width)
+{
+   unsigned x;
+
+   for (x = 0; x + 4 <= width; x += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *)src);
+
+      _mm_storeu_ps(dst, z24_unorm_to_z32_float4(_mm_srli_epi32(v, 8)));
+      src += 16;
+      dst += 4;
+   }
+   return x;
+}
+
+#endif /* PIPE_ARCH_SSE */
@@ -0,0 +1,142 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * SSE2 row functions for the most common formats.
+ *
+ * Each function converts as many pixels of a row as it can in blocks of
+ * 4 (or 8) pixels and returns how many it did; the generated pack/unpack
+ * functions do the rest of the row one pixel at a time.  The results are
+ * bit for bit those of the generic code.
+ */
+
+
+#ifndef U_FORMAT_SSE2_H_
+#define U_FORMAT_SSE2_H_
+
+
+#include "pipe/p_compiler.h"
+#include "pipe/p_config.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#if defined(PIPE_ARCH_SSE)
+
+unsigned
+util_format_r8g8b8a8_unorm_unpack_rgba_8unorm_sse2(uint8_t *dst,
+                                                   const uint8_t *src,
+                                                   unsigned width);
+
+unsigned
+util_format_r8g8b8a8_unorm_pack_rgba_8unorm_sse2(uint8_t *dst,
+                                                 const uint8_t *src,
+                                                 unsigned width);
+
+unsigned
+util_format_r8g8b8a8_unorm_unpack_rgba_float_sse2(float *dst,
+                                                  const uint8_t *src,
+                                                  unsigned width);
+
+unsigned
+util_format_r8g8b8a8_unorm_pack_rgba_float_sse2(uint8_t *dst,
+                                                const float *src,
+                                                unsigned width);
+
+unsigned
+util_format_b8g8r8a8_unorm_unpack_rgba_8unorm_sse2(uint8_t *dst,
+                                                   const uint8_t *src,
+                                                   unsigned width);
+
+unsigned
+util_format_b8g8r8a8_unorm_pack_rgba_8unorm_sse2(uint8_t *dst,
+                                                 const uint8_t *src,
+                                                 unsigned width);
+
+unsigned
+util_format_b8g8r8a8_unorm_unpack_rgba_float_sse2(float *dst,
+                                                  const uint8_t *src,
+                                                  unsigned width);
+
+unsigned
+util_format_b8g8r8a8_unorm_pack_rgba_float_sse2(uint8_t *dst,
+                                                const float *src,
+                                                unsigned width);
+
+unsigned
+util_format_b5g6r5_unorm_unpack_rgba_8unorm_sse2(uint8_t *dst,
+                                                 const uint8_t *src,
+                                                 unsigned width);
+
+unsigned
+util_format_b5g6r5_unorm_unpack_rgba_float_sse2(float *dst,
+                                                const uint8_t *src,
+                                                unsigned width);
+
+unsigned
+util_format_r16_float_unpack_rgba_float_sse2(float *dst,
+                                             const uint8_t *src,
+                                             unsigned width);
+
+unsigned
+util_format_r16g16b16a16_float_unpack_rgba_float_sse2(float *dst,
+                                                      const uint8_t *src,
+                                                      unsigned width);
+
+unsigned
+util_format_r32_float_unpack_rgba_float_sse2(float *dst,
+                                             const uint8_t *src,
+                                             unsigned width);
+
+unsigned
+util_format_r32_float_pack_rgba_float_sse2(uint8_t *dst,
+                                           const float *src,
+                                           unsigned width);
+
+unsigned
+util_format_z24_unorm_s8_uint_unpack_z_float_sse2(float *dst,
+                                                  const uint8_t *src,
+                                                  unsigned width);
+
+unsigned
+util_format_s8_uint_z24_unorm_unpack_z_float_sse2(float *dst,
+                                                  const uint8_t *src,
+                                                  unsigned width);
+
+#endif /* PIPE_ARCH_SSE */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_FORMAT_SSE2_H_ */
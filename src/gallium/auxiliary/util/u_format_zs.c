@@ -29,6 +29,7 @@
 #include "u_debug.h"
 #include "u_math.h"
 #include "u_format_zs.h"
+#include "u_format_sse2.h"
 
 
 /*
@@ -343,7 +344,13 @@ util_format_z24_unorm_s8_uint_unpack_z_float(float *dst_row, unsigned dst_stride
    for(y = 0; y < height; ++y) {
       float *dst = dst_row;
       const uint32_t *src = (const uint32_t *)src_row;
-      for(x = 0; x < width; ++x) {
+      x = 0;
+#ifdef PIPE_ARCH_SSE
+      x = util_format_z24_unorm_s8_uint_unpack_z_float_sse2(dst, src_row, width);
+      src += x;
+      dst += x;
+#endif
+      for(; x < width; ++x) {
          uint32_t value =  util_cpu_to_le32(*src++);
          *dst++ = z24_unorm_to_z32_float(value & 0xffffff);
       }
@@ -457,7 +464,13 @@ util_format_s8_uint_z24_unorm_unpack_z_float(float *dst_row, unsigned dst_stride
    for(y = 0; y < height; ++y) {
       float *dst = dst_row;
       const uint32_t *src = (const uint32_t *)src_row;
-      for(x = 0; x < width; ++x) {
+      x = 0;
+#ifdef PIPE_ARCH_SSE
+      x = util_format_s8_uint_z24_unorm_unpack_z_float_sse2(dst, src_row, width);
+      src += x;
+      dst += x;
+#endif
+      for(; x < width; ++x) {
          uint32_t value = util_cpu_to_le32(*src++);
          *dst++ = z24_unorm_to_z32_float(value >> 8);
       }
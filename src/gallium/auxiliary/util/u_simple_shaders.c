@@ -130,6 +130,47 @@ void *util_make_layered_clear_vertex_shader(struct pipe_context *pipe)
    return pipe->create_vs_state(pipe, &state);
 }
 
+/**
+ * Takes position and texcoords, and outputs position, LAYER = INSTANCEID,
+ * and the texcoords with the instance id added to the layer coordinate in
+ * channel layer_chan.  Used for blitting all layers of an array texture
+ * with one instanced draw.
+ */
+void *util_make_layered_blit_vertex_shader(struct pipe_context *pipe,
+                                           unsigned layer_chan)
+{
+   struct ureg_program *ureg;
+   struct ureg_src pos, texcoord, instance_id;
+   struct ureg_dst out_pos, out_texcoord, out_layer, layer;
+
+   assert(layer_chan < 4);
+
+   ureg = ureg_create(TGSI_PROCESSOR_VERTEX);
+   if (!ureg)
+      return NULL;
+
+   pos = ureg_DECL_vs_input(ureg, 0);
+   texcoord = ureg_DECL_vs_input(ureg, 1);
+   instance_id = ureg_DECL_system_value(ureg, 0, TGSI_SEMANTIC_INSTANCEID, 0);
+   out_pos = ureg_DECL_output(ureg, TGSI_SEMANTIC_POSITION, 0);
+   out_texcoord = ureg_DECL_output(ureg, TGSI_SEMANTIC_GENERIC, 0);
+   out_layer = ureg_DECL_output(ureg, TGSI_SEMANTIC_LAYER, 0);
+   layer = ureg_DECL_temporary(ureg);
+
+   ureg_MOV(ureg, out_pos, pos);
+   ureg_MOV(ureg, out_texcoord, texcoord);
+   ureg_U2F(ureg, ureg_writemask(layer, TGSI_WRITEMASK_X),
+            ureg_scalar(instance_id, TGSI_SWIZZLE_X));
+   ureg_ADD(ureg, ureg_writemask(out_texcoord, 1 << layer_chan),
+            ureg_scalar(texcoord, layer_chan),
+            ureg_scalar(ureg_src(layer), TGSI_SWIZZLE_X));
+   ureg_MOV(ureg, ureg_writemask(out_layer, TGSI_WRITEMASK_X),
+            ureg_scalar(instance_id, TGSI_SWIZZLE_X));
+   ureg_END(ureg);
+
+   return ureg_create_shader_and_destroy(ureg, pipe);
+}
+
 /**
  * Takes position and color, and outputs position, color, and instance id.
  */
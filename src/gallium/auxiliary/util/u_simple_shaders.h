@@ -65,6 +65,10 @@ util_make_layered_clear_vertex_shader(struct pipe_context *pipe);
 extern void *
 util_make_layered_clear_helper_vertex_shader(struct pipe_context *pipe);
 
+extern void *
+util_make_layered_blit_vertex_shader(struct pipe_context *pipe,
+                                     unsigned layer_chan);
+
 extern void *
 util_make_layered_clear_geometry_shader(struct pipe_context *pipe);
 
@@ -22,6 +22,7 @@
 
 #include "util/u_slab.h"
 
+#include "util/u_atomic.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/simple_list.h"
@@ -169,3 +170,221 @@ void util_slab_destroy(struct util_slab_mempool *pool)
 
    pipe_mutex_destroy(pool->mutex);
 }
+
+
+/*
+ * Parent and child pools.
+ */
+
+struct util_slab_child_page {
+   struct util_slab_child_page *next;
+
+   /* Blocks not yet freed, once the owning child has been destroyed. */
+   unsigned num_remaining;
+
+   /* The blocks follow. */
+};
+
+struct util_slab_child_block {
+   struct util_slab_child_block *next_free;
+
+   /* The child pool which owns the block, or the page with the lowest
+    * bit set once the child has been destroyed.
+    */
+   intptr_t owner;
+
+   intptr_t magic;
+};
+
+static struct util_slab_child_block *
+util_slab_get_child_block(struct util_slab_parent_pool *parent,
+                          struct util_slab_child_page *page, unsigned index)
+{
+   return (struct util_slab_child_block*)
+          ((uint8_t*)page + align(sizeof(struct util_slab_child_page),
+                                  sizeof(intptr_t)) +
+           (parent->block_size * index));
+}
+
+void util_slab_create_parent(struct util_slab_parent_pool *parent,
+                             unsigned item_size,
+                             unsigned num_blocks)
+{
+   parent->block_size = align(sizeof(struct util_slab_child_block) +
+                              align(item_size, sizeof(intptr_t)),
+                              sizeof(intptr_t));
+   parent->num_blocks = num_blocks;
+   parent->num_pages = 0;
+
+   pipe_mutex_init(parent->mutex);
+}
+
+/* All the children must have been destroyed. */
+void util_slab_destroy_parent(struct util_slab_parent_pool *parent)
+{
+   pipe_mutex_destroy(parent->mutex);
+}
+
+void util_slab_create_child(struct util_slab_child_pool *pool,
+                            struct util_slab_parent_pool *parent)
+{
+   memset(pool, 0, sizeof(*pool));
+   pool->parent = parent;
+}
+
+static void util_slab_free_orphaned(struct util_slab_parent_pool *parent,
+                                    struct util_slab_child_block *block)
+{
+   struct util_slab_child_page *page;
+
+   assert(block->owner & 1);
+   page = (struct util_slab_child_page *)(block->owner & ~(intptr_t)1);
+
+   if (!p_atomic_dec_return(&page->num_remaining)) {
+      p_atomic_dec(&parent->num_pages);
+      FREE(page);
+   }
+}
+
+/**
+ * Orphan the child's pages: blocks still used elsewhere keep their page
+ * alive until they're freed.
+ */
+void util_slab_destroy_child(struct util_slab_child_pool *pool)
+{
+   struct util_slab_parent_pool *parent = pool->parent;
+   struct util_slab_child_block *block;
+
+   if (!parent)
+      return;
+
+   pipe_mutex_lock(parent->mutex);
+
+   while (pool->pages) {
+      struct util_slab_child_page *page = pool->pages;
+      unsigned i;
+
+      pool->pages = page->next;
+      p_atomic_set(&page->num_remaining, parent->num_blocks);
+
+      for (i = 0; i < parent->num_blocks; i++) {
+         block = util_slab_get_child_block(parent, page, i);
+         p_atomic_set(&block->owner, (intptr_t)page | 1);
+      }
+   }
+
+   while (pool->migrated) {
+      block = pool->migrated;
+      pool->migrated = block->next_free;
+      util_slab_free_orphaned(parent, block);
+   }
+
+   pipe_mutex_unlock(parent->mutex);
+
+   while (pool->first_free) {
+      block = pool->first_free;
+      pool->first_free = block->next_free;
+      util_slab_free_orphaned(parent, block);
+   }
+
+   pool->parent = NULL;
+}
+
+static boolean util_slab_child_add_new_page(struct util_slab_child_pool *pool)
+{
+   struct util_slab_parent_pool *parent = pool->parent;
+   struct util_slab_child_page *page;
+   struct util_slab_child_block *block;
+   unsigned i;
+
+   page = MALLOC(align(sizeof(struct util_slab_child_page), sizeof(intptr_t)) +
+                 parent->num_blocks * parent->block_size);
+   if (!page)
+      return FALSE;
+
+   for (i = 0; i < parent->num_blocks; i++) {
+      block = util_slab_get_child_block(parent, page, i);
+      block->owner = (intptr_t)pool;
+      block->magic = UTIL_SLAB_MAGIC;
+      block->next_free = pool->first_free;
+      pool->first_free = block;
+   }
+
+   page->next = pool->pages;
+   pool->pages = page;
+
+   pool->stats.num_pages++;
+   p_atomic_inc(&parent->num_pages);
+   return TRUE;
+}
+
+/**
+ * Allocate a block.  Only the thread using the child may call this.
+ */
+void *util_slab_child_alloc(struct util_slab_child_pool *pool)
+{
+   struct util_slab_child_block *block;
+
+   if (!pool->first_free) {
+      /* Take back the blocks other children freed for us.  The unlocked
+       * read only decides whether to bother with the mutex.
+       */
+      if (p_atomic_read(&pool->migrated)) {
+         pipe_mutex_lock(pool->parent->mutex);
+         pool->first_free = pool->migrated;
+         pool->migrated = NULL;
+         pipe_mutex_unlock(pool->parent->mutex);
+      }
+
+      if (!pool->first_free && !util_slab_child_add_new_page(pool))
+         return NULL;
+   }
+
+   block = pool->first_free;
+   assert(block->magic == UTIL_SLAB_MAGIC);
+   pool->first_free = block->next_free;
+   pool->stats.num_allocs++;
+
+   return (uint8_t*)block + sizeof(struct util_slab_child_block);
+}
+
+/**
+ * Free a block allocated from any child of the same parent.  Only the
+ * thread using the child may call this.
+ */
+void util_slab_child_free(struct util_slab_child_pool *pool, void *ptr)
+{
+   struct util_slab_child_block *block =
+         (struct util_slab_child_block*)
+         ((uint8_t*)ptr - sizeof(struct util_slab_child_block));
+   struct util_slab_parent_pool *parent = pool->parent;
+   intptr_t owner;
+
+   assert(block->magic == UTIL_SLAB_MAGIC);
+   pool->stats.num_frees++;
+
+   if (p_atomic_read(&block->owner) == (intptr_t)pool) {
+      block->next_free = pool->first_free;
+      pool->first_free = block;
+      return;
+   }
+
+   pool->stats.num_migrated_frees++;
+
+   /* The owner may be destroyed by another thread meanwhile, so only
+    * trust block->owner with the mutex held.
+    */
+   pipe_mutex_lock(parent->mutex);
+   owner = p_atomic_read(&block->owner);
+   if (!(owner & 1)) {
+      struct util_slab_child_pool *owner_pool =
+         (struct util_slab_child_pool *)owner;
+
+      block->next_free = owner_pool->migrated;
+      owner_pool->migrated = block;
+      pipe_mutex_unlock(parent->mutex);
+   } else {
+      pipe_mutex_unlock(parent->mutex);
+      util_slab_free_orphaned(parent, block);
+   }
+}
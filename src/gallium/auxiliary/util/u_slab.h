@@ -30,6 +30,9 @@
  *
  * Candidates: transfer_map
  *
+ * util_slab_mempool is meant for one thread (or a mutex for all of them),
+ * the parent/child pools below for memory shared by several contexts.
+ *
  * @author Marek Olšák
  */
 
@@ -93,4 +96,65 @@ util_slab_free(struct util_slab_mempool *pool, void *ptr)
    pool->free(pool, ptr);
 }
 
+
+/*
+ * Slab pools shared by several contexts or threads.
+ *
+ * The parent pool is normally owned by the screen and each context gets a
+ * child pool.  Allocations, and frees of blocks the child itself handed
+ * out, take no lock at all.  A block freed through another child is put
+ * on its owner's "migrated" list under the parent's mutex, and the owner
+ * takes them all back the next time its own free list runs dry.
+ *
+ * A child may be destroyed while other children still hold some of its
+ * blocks; its pages are then freed when their last block is.
+ */
+
+struct util_slab_child_block;
+struct util_slab_child_page;
+
+struct util_slab_parent_pool {
+   pipe_mutex mutex;
+
+   unsigned block_size;
+   unsigned num_blocks;  /* per page */
+   unsigned num_pages;   /* pages currently allocated by all children */
+};
+
+struct util_slab_stats {
+   uint64_t num_allocs;
+   uint64_t num_frees;
+   uint64_t num_migrated_frees;  /* frees of blocks owned by another child */
+   unsigned num_pages;           /* pages allocated by this child */
+};
+
+struct util_slab_child_pool {
+   struct util_slab_parent_pool *parent;
+
+   struct util_slab_child_page *pages;
+
+   /* Only accessed by the thread using the child. */
+   struct util_slab_child_block *first_free;
+
+   /* Blocks freed by other children, protected by the parent's mutex. */
+   struct util_slab_child_block *migrated;
+
+   struct util_slab_stats stats;
+};
+
+void util_slab_create_parent(struct util_slab_parent_pool *parent,
+                             unsigned item_size,
+                             unsigned num_blocks);
+
+void util_slab_destroy_parent(struct util_slab_parent_pool *parent);
+
+void util_slab_create_child(struct util_slab_child_pool *pool,
+                            struct util_slab_parent_pool *parent);
+
+void util_slab_destroy_child(struct util_slab_child_pool *pool);
+
+void *util_slab_child_alloc(struct util_slab_child_pool *pool);
+
+void util_slab_child_free(struct util_slab_child_pool *pool, void *ptr);
+
 #endif
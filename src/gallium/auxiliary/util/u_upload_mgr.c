@@ -32,12 +32,24 @@
 #include "pipe/p_defines.h"
 #include "util/u_inlines.h"
 #include "pipe/p_context.h"
+#include "pipe/p_screen.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "hud/hud_counters.h"
 
 #include "u_upload_mgr.h"
 
 
+/* Number of full upload buffers kept around for reuse. */
+#define UPLOAD_MAX_RETIRED 4
+
+struct u_upload_retired {
+   struct pipe_resource *buffer;
+   struct pipe_transfer *transfer; /* Kept for persistent mappings only. */
+   uint8_t *map;
+   struct pipe_fence_handle *fence; /* Signalled once the GPU is done. */
+};
+
 struct u_upload_mgr {
    struct pipe_context *pipe;
 
@@ -52,6 +64,13 @@ struct u_upload_mgr {
    uint8_t *map;    /* Pointer to the mapped upload buffer. */
    unsigned offset; /* Aligned offset to the upload buffer, pointing
                      * at the first unused byte. */
+
+   /* Full upload buffers, oldest first.  Only kept once the user started
+    * giving us fences with u_upload_fence().
+    */
+   boolean use_fences;
+   struct u_upload_retired retired[UPLOAD_MAX_RETIRED];
+   unsigned num_retired;
 };
 
 
@@ -122,13 +141,117 @@ static void u_upload_release_buffer(struct u_upload_mgr *upload)
 }
 
 
+static void
+u_upload_release_retired(struct u_upload_mgr *upload,
+                         struct u_upload_retired *retired)
+{
+   struct pipe_screen *screen = upload->pipe->screen;
+
+   if (retired->transfer)
+      pipe_transfer_unmap(upload->pipe, retired->transfer);
+   pipe_resource_reference(&retired->buffer, NULL);
+   screen->fence_reference(screen, &retired->fence, NULL);
+}
+
+
+static void
+u_upload_remove_oldest_retired(struct u_upload_mgr *upload)
+{
+   upload->num_retired--;
+   memmove(&upload->retired[0], &upload->retired[1],
+           upload->num_retired * sizeof(upload->retired[0]));
+}
+
+
+/**
+ * Put the full upload buffer aside, so that it can be reused once the GPU
+ * is done with it instead of allocating a new one.  Persistent mappings
+ * are kept as well.
+ */
+static void
+u_upload_retire_buffer(struct u_upload_mgr *upload)
+{
+   struct u_upload_retired *retired;
+
+   if (!upload->use_fences || !upload->buffer) {
+      u_upload_release_buffer(upload);
+      return;
+   }
+
+   upload_unmap_internal(upload, FALSE);
+
+   if (upload->num_retired == UPLOAD_MAX_RETIRED) {
+      u_upload_release_retired(upload, &upload->retired[0]);
+      u_upload_remove_oldest_retired(upload);
+   }
+
+   retired = &upload->retired[upload->num_retired++];
+   retired->buffer = upload->buffer;
+   retired->transfer = upload->transfer;
+   retired->map = upload->map;
+   retired->fence = NULL;
+
+   upload->buffer = NULL;
+   upload->transfer = NULL;
+   upload->map = NULL;
+}
+
+
+/**
+ * Make the oldest retired buffer the upload buffer again if it's big
+ * enough and the GPU is done with it.
+ */
+static boolean
+u_upload_reuse_buffer(struct u_upload_mgr *upload, unsigned size)
+{
+   struct pipe_screen *screen = upload->pipe->screen;
+   struct u_upload_retired *retired = &upload->retired[0];
+
+   if (!upload->num_retired || !retired->fence ||
+       retired->buffer->width0 < size ||
+       !screen->fence_finish(screen, retired->fence, 0))
+      return FALSE;
+
+   upload->buffer = retired->buffer;
+   upload->transfer = retired->transfer;
+   upload->map = retired->map;
+   upload->offset = 0;
+   screen->fence_reference(screen, &retired->fence, NULL);
+   u_upload_remove_oldest_retired(upload);
+
+   return TRUE;
+}
+
+
 void u_upload_destroy( struct u_upload_mgr *upload )
 {
+   unsigned i;
+
    u_upload_release_buffer( upload );
+   for (i = 0; i < upload->num_retired; i++)
+      u_upload_release_retired(upload, &upload->retired[i]);
    FREE( upload );
 }
 
 
+void u_upload_fence( struct u_upload_mgr *upload,
+                     struct pipe_fence_handle *fence )
+{
+   struct pipe_screen *screen = upload->pipe->screen;
+   unsigned i;
+
+   if (!fence)
+      return;
+
+   upload->use_fences = TRUE;
+
+   for (i = 0; i < upload->num_retired; i++) {
+      if (!upload->retired[i].fence)
+         screen->fence_reference(screen, &upload->retired[i].fence, fence);
+   }
+}
+
+
 static void
 u_upload_alloc_buffer(struct u_upload_mgr *upload,
                       unsigned min_size)
@@ -137,13 +260,17 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload,
    struct pipe_resource buffer;
    unsigned size;
 
-   /* Release the old buffer, if present:
+   size = align(MAX2(upload->default_size, min_size), 4096);
+
+   /* Put the old buffer aside, if present, and reuse an older one if
+    * possible:
     */
-   u_upload_release_buffer( upload );
+   u_upload_retire_buffer( upload );
+   if (u_upload_reuse_buffer(upload, size))
+      return;
 
    /* Allocate a new one: 
     */
-   size = align(MAX2(upload->default_size, min_size), 4096);
 
    memset(&buffer, 0, sizeof buffer);
    buffer.target = PIPE_BUFFER;
@@ -164,6 +291,8 @@ u_upload_alloc_buffer(struct u_upload_mgr *upload,
    if (upload->buffer == NULL)
       return;
 
+   hud_counter_add(HUD_COUNTER_BUFFER_REALLOCS, 1);
+
    /* Map the new buffer. */
    upload->map = pipe_buffer_map_range(upload->pipe, upload->buffer,
                                        0, size, upload->map_flags,
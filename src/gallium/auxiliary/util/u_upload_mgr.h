@@ -36,6 +36,7 @@
 
 struct pipe_context;
 struct pipe_resource;
+struct pipe_fence_handle;
 
 
 /**
@@ -68,6 +69,20 @@ void u_upload_destroy( struct u_upload_mgr *upload );
  */
 void u_upload_unmap( struct u_upload_mgr *upload );
 
+/**
+ * Let the upload manager reuse its full buffers.
+ *
+ * \param upload           Upload manager
+ * \param fence            Fence of a flush that was just done.
+ *
+ * Once this has been called, upload buffers that fill up are kept until the
+ * fence of the next flush signals, and are then reused (with their
+ * persistent mapping, if any) instead of allocating new ones.  Without it,
+ * full buffers are released right away.
+ */
+void u_upload_fence( struct u_upload_mgr *upload,
+                     struct pipe_fence_handle *fence );
+
 /**
  * Sub-allocate new memory from the upload buffer.
  *
@@ -66,6 +66,11 @@
  *
  * 2) User buffer uploading (u_vbuf_upload_buffers)
  *
+ * This is only done if the driver doesn't support PIPE_CAP_USER_VERTEX_BUFFERS.
+ * Drivers which can read client memory (softpipe, llvmpipe, ...) get user
+ * buffers passed through untouched, unless they need translating, and are
+ * expected to be done with them once draw_vbo returns.
+ *
  * Only the [min_index, max_index] range is uploaded (just like Translate)
  * with a single memcpy.
  *
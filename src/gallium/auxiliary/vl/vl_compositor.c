@@ -30,6 +30,7 @@
 #include "pipe/p_compiler.h"
 #include "pipe/p_context.h"
 
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_draw.h"
 #include "util/u_surface.h"
@@ -709,13 +710,17 @@ static void
 gen_vertex_data(struct vl_compositor *c, struct vl_compositor_state *s, struct u_rect *dirty)
 {
    struct vertex2f *vb;
+   unsigned num_layers = util_bitcount(s->used_layers);
    unsigned i;
 
    assert(c);
 
-   /* Allocate new memory for vertices. */
+   if (!num_layers)
+      return;
+
+   /* Allocate new memory for the vertices of the used layers only. */
    u_upload_alloc(c->upload, 0,
-                  c->vertex_buf.stride * VL_COMPOSITOR_MAX_LAYERS * 4, /* size */
+                  c->vertex_buf.stride * num_layers * 4, /* size */
                   &c->vertex_buf.buffer_offset, &c->vertex_buf.buffer,
                   (void**)&vb);
 
@@ -754,6 +759,8 @@ gen_vertex_data(struct vl_compositor *c, struct vl_compositor_state *s, struct u
 static void
 draw_layers(struct vl_compositor *c, struct vl_compositor_state *s, struct u_rect *dirty)
 {
+   struct pipe_viewport_state *last_viewport = NULL;
+   void *last_blend = NULL, *last_fs = NULL;
    unsigned vb_index, i;
 
    assert(c);
@@ -765,9 +772,22 @@ draw_layers(struct vl_compositor *c, struct vl_compositor_state *s, struct u_rec
          unsigned num_sampler_views = !samplers[1] ? 1 : !samplers[2] ? 2 : 3;
          void *blend = layer->blend ? layer->blend : i ? c->blend_add : c->blend_clear;
 
-         c->pipe->bind_blend_state(c->pipe, blend);
-         c->pipe->set_viewport_states(c->pipe, 0, 1, &layer->viewport);
-         c->pipe->bind_fs_state(c->pipe, layer->fs);
+         /* Layers usually share most of their state, only bind what
+          * changes from one layer to the next.
+          */
+         if (blend != last_blend) {
+            c->pipe->bind_blend_state(c->pipe, blend);
+            last_blend = blend;
+         }
+         if (!last_viewport ||
+             memcmp(last_viewport, &layer->viewport, sizeof(layer->viewport))) {
+            c->pipe->set_viewport_states(c->pipe, 0, 1, &layer->viewport);
+            last_viewport = &layer->viewport;
+         }
+         if (layer->fs != last_fs) {
+            c->pipe->bind_fs_state(c->pipe, layer->fs);
+            last_fs = layer->fs;
+         }
          c->pipe->bind_sampler_states(c->pipe, PIPE_SHADER_FRAGMENT, 0,
                                       num_sampler_views, layer->samplers);
          c->pipe->set_sampler_views(c->pipe, PIPE_SHADER_FRAGMENT, 0,
@@ -123,6 +123,20 @@ dd_context_get_query_result(struct pipe_context *_pipe,
    return pipe->get_query_result(pipe, dd_query_unwrap(query), wait, result);
 }
 
+static void
+dd_context_get_query_result_resource(struct pipe_context *_pipe,
+                                     struct pipe_query *query, boolean wait,
+                                     enum pipe_query_value_type result_type,
+                                     int index,
+                                     struct pipe_resource *resource,
+                                     unsigned offset)
+{
+   struct pipe_context *pipe = dd_context(_pipe)->pipe;
+
+   pipe->get_query_result_resource(pipe, dd_query_unwrap(query), wait,
+                                   result_type, index, resource, offset);
+}
+
 static void
 dd_context_render_condition(struct pipe_context *_pipe,
                             struct pipe_query *query, boolean condition,
@@ -132,9 +146,9 @@ dd_context_render_condition(struct pipe_context *_pipe,
    struct pipe_context *pipe = dctx->pipe;
 
    pipe->render_condition(pipe, dd_query_unwrap(query), condition, mode);
-   dctx->render_cond.query = dd_query(query);
-   dctx->render_cond.condition = condition;
-   dctx->render_cond.mode = mode;
+   dctx->draw_state.render_cond.query = dd_query(query);
+   dctx->draw_state.render_cond.condition = condition;
+   dctx->draw_state.render_cond.mode = mode;
 }
 
 
@@ -142,6 +156,17 @@ dd_context_render_condition(struct pipe_context *_pipe,
  * constant (immutable) non-shader states
  */
 
+/* Frees the wrapper when neither the state tracker nor any recorded call
+ * use it anymore.  The driver CSO is deleted earlier, by delete_*_state.
+ */
+void
+dd_state_destroy(struct dd_state *hstate)
+{
+   if (hstate->is_shader)
+      tgsi_free_tokens(hstate->state.shader.tokens);
+   FREE(hstate);
+}
+
 #define DD_CSO_CREATE(name, shortname) \
    static void * \
    dd_context_create_##name##_state(struct pipe_context *_pipe, \
@@ -153,6 +178,7 @@ dd_context_render_condition(struct pipe_context *_pipe,
       if (!hstate) \
          return NULL; \
       hstate->cso = pipe->create_##name##_state(pipe, state); \
+      hstate->refcount = 1; \
       hstate->state.shortname = *state; \
       return hstate; \
    }
@@ -165,7 +191,7 @@ dd_context_render_condition(struct pipe_context *_pipe,
       struct pipe_context *pipe = dctx->pipe; \
       struct dd_state *hstate = state; \
  \
-      dctx->shortname = hstate; \
+      dctx->draw_state.shortname = hstate; \
       pipe->bind_##name##_state(pipe, hstate ? hstate->cso : NULL); \
    }
 
@@ -178,7 +204,7 @@ dd_context_render_condition(struct pipe_context *_pipe,
       struct dd_state *hstate = state; \
  \
       pipe->delete_##name##_state(pipe, hstate->cso); \
-      FREE(hstate); \
+      dd_state_reference(&hstate, NULL); \
    }
 
 #define DD_CSO_WHOLE(name, shortname) \
@@ -200,7 +226,7 @@ dd_context_bind_sampler_states(struct pipe_context *_pipe, unsigned shader,
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
-   memcpy(&dctx->sampler_states[shader][start], states,
+   memcpy(&dctx->draw_state.sampler_states[shader][start], states,
           sizeof(void*) * count);
 
    if (states) {
@@ -229,6 +255,7 @@ dd_context_create_vertex_elements_state(struct pipe_context *_pipe,
    if (!hstate)
       return NULL;
    hstate->cso = pipe->create_vertex_elements_state(pipe, num_elems, elems);
+   hstate->refcount = 1;
    memcpy(hstate->state.velems.velems, elems, sizeof(elems[0]) * num_elems);
    hstate->state.velems.count = num_elems;
    return hstate;
@@ -253,6 +280,8 @@ DD_CSO_DELETE(vertex_elements)
       if (!hstate) \
          return NULL; \
       hstate->cso = pipe->create_##name##_state(pipe, state); \
+      hstate->refcount = 1; \
+      hstate->is_shader = true; \
       hstate->state.shader = *state; \
       hstate->state.shader.tokens = tgsi_dup_tokens(state->tokens); \
       return hstate; \
@@ -265,7 +294,7 @@ DD_CSO_DELETE(vertex_elements)
       struct pipe_context *pipe = dctx->pipe; \
       struct dd_state *hstate = state; \
    \
-      dctx->shaders[PIPE_SHADER_##NAME] = hstate; \
+      dctx->draw_state.shaders[PIPE_SHADER_##NAME] = hstate; \
       pipe->bind_##name##_state(pipe, hstate ? hstate->cso : NULL); \
    } \
     \
@@ -277,8 +306,7 @@ DD_CSO_DELETE(vertex_elements)
       struct dd_state *hstate = state; \
    \
       pipe->delete_##name##_state(pipe, hstate->cso); \
-      tgsi_free_tokens(hstate->state.shader.tokens); \
-      FREE(hstate); \
+      dd_state_reference(&hstate, NULL); \
    }
 
 DD_SHADER(FRAGMENT, fs)
@@ -299,7 +327,7 @@ DD_SHADER(TESS_EVAL, tes)
       struct dd_context *dctx = dd_context(_pipe); \
       struct pipe_context *pipe = dctx->pipe; \
  \
-      dctx->name = deref; \
+      dctx->draw_state.name = deref; \
       pipe->set_##name(pipe, ref); \
    }
 
@@ -319,8 +347,8 @@ dd_context_set_constant_buffer(struct pipe_context *_pipe,
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
-   safe_memcpy(&dctx->constant_buffers[shader][index], constant_buffer,
-          sizeof(*constant_buffer));
+   safe_memcpy(&dctx->draw_state.constant_buffers[shader][index],
+               constant_buffer, sizeof(*constant_buffer));
    pipe->set_constant_buffer(pipe, shader, index, constant_buffer);
 }
 
@@ -332,7 +360,7 @@ dd_context_set_scissor_states(struct pipe_context *_pipe,
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
-   safe_memcpy(&dctx->scissors[start_slot], states,
+   safe_memcpy(&dctx->draw_state.scissors[start_slot], states,
                sizeof(*states) * num_scissors);
    pipe->set_scissor_states(pipe, start_slot, num_scissors, states);
 }
@@ -345,7 +373,7 @@ dd_context_set_viewport_states(struct pipe_context *_pipe,
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
-   safe_memcpy(&dctx->viewports[start_slot], states,
+   safe_memcpy(&dctx->draw_state.viewports[start_slot], states,
                sizeof(*states) * num_viewports);
    pipe->set_viewport_states(pipe, start_slot, num_viewports, states);
 }
@@ -357,8 +385,10 @@ static void dd_context_set_tess_state(struct pipe_context *_pipe,
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
-   memcpy(dctx->tess_default_levels, default_outer_level, sizeof(float) * 4);
-   memcpy(dctx->tess_default_levels+4, default_inner_level, sizeof(float) * 2);
+   memcpy(dctx->draw_state.tess_default_levels, default_outer_level,
+          sizeof(float) * 4);
+   memcpy(dctx->draw_state.tess_default_levels+4, default_inner_level,
+          sizeof(float) * 2);
    pipe->set_tess_state(pipe, default_outer_level, default_inner_level);
 }
 
@@ -478,7 +508,7 @@ dd_context_set_sampler_views(struct pipe_context *_pipe, unsigned shader,
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
-   safe_memcpy(&dctx->sampler_views[shader][start], views,
+   safe_memcpy(&dctx->draw_state.sampler_views[shader][start], views,
                sizeof(views[0]) * num);
    pipe->set_sampler_views(pipe, shader, start, num, views);
 }
@@ -491,7 +521,7 @@ dd_context_set_shader_images(struct pipe_context *_pipe, unsigned shader,
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
-   safe_memcpy(&dctx->shader_images[shader][start], views,
+   safe_memcpy(&dctx->draw_state.shader_images[shader][start], views,
                sizeof(views[0]) * num);
    pipe->set_shader_images(pipe, shader, start, num, views);
 }
@@ -504,7 +534,7 @@ dd_context_set_shader_buffers(struct pipe_context *_pipe, unsigned shader,
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
-   safe_memcpy(&dctx->shader_buffers[shader][start], buffers,
+   safe_memcpy(&dctx->draw_state.shader_buffers[shader][start], buffers,
                sizeof(buffers[0]) * num_buffers);
    pipe->set_shader_buffers(pipe, shader, start, num_buffers, buffers);
 }
@@ -517,7 +547,7 @@ dd_context_set_vertex_buffers(struct pipe_context *_pipe,
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
-   safe_memcpy(&dctx->vertex_buffers[start], buffers,
+   safe_memcpy(&dctx->draw_state.vertex_buffers[start], buffers,
                sizeof(buffers[0]) * num_buffers);
    pipe->set_vertex_buffers(pipe, start, num_buffers, buffers);
 }
@@ -529,7 +559,7 @@ dd_context_set_index_buffer(struct pipe_context *_pipe,
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
-   safe_memcpy(&dctx->index_buffer, ib, sizeof(*ib));
+   safe_memcpy(&dctx->draw_state.index_buffer, ib, sizeof(*ib));
    pipe->set_index_buffer(pipe, ib);
 }
 
@@ -542,9 +572,10 @@ dd_context_set_stream_output_targets(struct pipe_context *_pipe,
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
-   dctx->num_so_targets = num_targets;
-   safe_memcpy(dctx->so_targets, tgs, sizeof(*tgs) * num_targets);
-   safe_memcpy(dctx->so_offsets, offsets, sizeof(*offsets) * num_targets);
+   dctx->draw_state.num_so_targets = num_targets;
+   safe_memcpy(dctx->draw_state.so_targets, tgs, sizeof(*tgs) * num_targets);
+   safe_memcpy(dctx->draw_state.so_offsets, offsets,
+               sizeof(*offsets) * num_targets);
    pipe->set_stream_output_targets(pipe, num_targets, tgs, offsets);
 }
 
@@ -554,6 +585,7 @@ dd_context_destroy(struct pipe_context *_pipe)
    struct dd_context *dctx = dd_context(_pipe);
    struct pipe_context *pipe = dctx->pipe;
 
+   dd_release_records(dctx);
    pipe->destroy(pipe);
    FREE(dctx);
 }
@@ -648,6 +680,17 @@ dd_context_invalidate_resource(struct pipe_context *_pipe,
    pipe->invalidate_resource(pipe, resource);
 }
 
+static boolean
+dd_context_resource_commit(struct pipe_context *_pipe,
+                           struct pipe_resource *resource,
+                           unsigned level, struct pipe_box *box,
+                           boolean commit)
+{
+   struct pipe_context *pipe = dd_context(_pipe)->pipe;
+
+   return pipe->resource_commit(pipe, resource, level, box, commit);
+}
+
 static enum pipe_reset_status
 dd_context_get_device_reset_status(struct pipe_context *_pipe)
 {
@@ -679,6 +722,15 @@ dd_context_create(struct dd_screen *dscreen, struct pipe_context *pipe)
       return NULL;
    }
 
+   if (dscreen->mode == DD_RECORD_CALLS) {
+      dctx->records = CALLOC(dscreen->num_records, sizeof(*dctx->records));
+      if (!dctx->records) {
+         FREE(dctx);
+         pipe->destroy(pipe);
+         return NULL;
+      }
+   }
+
    dctx->pipe = pipe;
    dctx->base.priv = pipe->priv; /* expose wrapped priv data */
    dctx->base.screen = &dscreen->base;
@@ -691,6 +743,7 @@ dd_context_create(struct dd_screen *dscreen, struct pipe_context *pipe)
    CTX_INIT(begin_query);
    CTX_INIT(end_query);
    CTX_INIT(get_query_result);
+   CTX_INIT(get_query_result_resource);
    CTX_INIT(create_blend_state);
    CTX_INIT(bind_blend_state);
    CTX_INIT(delete_blend_state);
@@ -761,11 +814,12 @@ dd_context_create(struct dd_screen *dscreen, struct pipe_context *pipe)
    /* set_global_binding */
    CTX_INIT(get_sample_position);
    CTX_INIT(invalidate_resource);
+   CTX_INIT(resource_commit);
    CTX_INIT(get_device_reset_status);
    CTX_INIT(dump_debug_state);
 
    dd_init_draw_functions(dctx);
 
-   dctx->sample_mask = ~0;
+   dctx->draw_state.sample_mask = ~0;
    return &dctx->base;
 }
@@ -29,62 +29,14 @@
 
 #include "util/u_dump.h"
 #include "util/u_format.h"
+#include "util/u_framebuffer.h"
+#include "util/u_inlines.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "os/os_time.h"
 #include "tgsi/tgsi_scan.h"
 
 
-enum call_type
-{
-   CALL_DRAW_VBO,
-   CALL_RESOURCE_COPY_REGION,
-   CALL_BLIT,
-   CALL_FLUSH_RESOURCE,
-   CALL_CLEAR,
-   CALL_CLEAR_BUFFER,
-   CALL_CLEAR_RENDER_TARGET,
-   CALL_CLEAR_DEPTH_STENCIL,
-};
-
-struct call_resource_copy_region
-{
-   struct pipe_resource *dst;
-   unsigned dst_level;
-   unsigned dstx, dsty, dstz;
-   struct pipe_resource *src;
-   unsigned src_level;
-   const struct pipe_box *src_box;
-};
-
-struct call_clear
-{
-   unsigned buffers;
-   const union pipe_color_union *color;
-   double depth;
-   unsigned stencil;
-};
-
-struct call_clear_buffer
-{
-   struct pipe_resource *res;
-   unsigned offset;
-   unsigned size;
-   const void *clear_value;
-   int clear_value_size;
-};
-
-struct dd_call
-{
-   enum call_type type;
-
-   union {
-      struct pipe_draw_info draw_vbo;
-      struct call_resource_copy_region resource_copy_region;
-      struct pipe_blit_info blit;
-      struct pipe_resource *flush_resource;
-      struct call_clear clear;
-      struct call_clear_buffer clear_buffer;
-   } info;
-};
-
 static FILE *
 dd_get_file_stream(struct dd_context *dctx)
 {
@@ -106,17 +58,17 @@ dd_close_file_stream(FILE *f)
 }
 
 static unsigned
-dd_num_active_viewports(struct dd_context *dctx)
+dd_num_active_viewports(struct dd_draw_state *dstate)
 {
    struct tgsi_shader_info info;
    const struct tgsi_token *tokens;
 
-   if (dctx->shaders[PIPE_SHADER_GEOMETRY])
-      tokens = dctx->shaders[PIPE_SHADER_GEOMETRY]->state.shader.tokens;
-   else if (dctx->shaders[PIPE_SHADER_TESS_EVAL])
-      tokens = dctx->shaders[PIPE_SHADER_TESS_EVAL]->state.shader.tokens;
-   else if (dctx->shaders[PIPE_SHADER_VERTEX])
-      tokens = dctx->shaders[PIPE_SHADER_VERTEX]->state.shader.tokens;
+   if (dstate->shaders[PIPE_SHADER_GEOMETRY])
+      tokens = dstate->shaders[PIPE_SHADER_GEOMETRY]->state.shader.tokens;
+   else if (dstate->shaders[PIPE_SHADER_TESS_EVAL])
+      tokens = dstate->shaders[PIPE_SHADER_TESS_EVAL]->state.shader.tokens;
+   else if (dstate->shaders[PIPE_SHADER_VERTEX])
+      tokens = dstate->shaders[PIPE_SHADER_VERTEX]->state.shader.tokens;
    else
       return 1;
 
@@ -207,19 +159,20 @@ util_dump_query(FILE *f, struct dd_query *query)
 }
 
 static void
-dd_dump_render_condition(struct dd_context *dctx, FILE *f)
+dd_dump_render_condition(struct dd_draw_state *dstate, FILE *f)
 {
-   if (dctx->render_cond.query) {
+   if (dstate->render_cond.query) {
       fprintf(f, "render condition:\n");
-      DUMP_M(query, &dctx->render_cond, query);
-      DUMP_M(uint, &dctx->render_cond, condition);
-      DUMP_M(uint, &dctx->render_cond, mode);
+      DUMP_M(query, &dstate->render_cond, query);
+      DUMP_M(uint, &dstate->render_cond, condition);
+      DUMP_M(uint, &dstate->render_cond, mode);
       fprintf(f, "\n");
    }
 }
 
 static void
-dd_dump_draw_vbo(struct dd_context *dctx, struct pipe_draw_info *info, FILE *f)
+dd_dump_draw_vbo(struct dd_draw_state *dstate, struct pipe_draw_info *info,
+                 FILE *f)
 {
    int sh, i;
    const char *shader_str[PIPE_SHADER_TYPES];
@@ -233,9 +186,9 @@ dd_dump_draw_vbo(struct dd_context *dctx, struct pipe_draw_info *info, FILE *f)
 
    DUMP(draw_info, info);
    if (info->indexed) {
-      DUMP(index_buffer, &dctx->index_buffer);
-      if (dctx->index_buffer.buffer)
-         DUMP_M(resource, &dctx->index_buffer, buffer);
+      DUMP(index_buffer, &dstate->index_buffer);
+      if (dstate->index_buffer.buffer)
+         DUMP_M(resource, &dstate->index_buffer, buffer);
    }
    if (info->count_from_stream_output)
       DUMP_M(stream_output_target, info,
@@ -246,31 +199,31 @@ dd_dump_draw_vbo(struct dd_context *dctx, struct pipe_draw_info *info, FILE *f)
 
    /* TODO: dump active queries */
 
-   dd_dump_render_condition(dctx, f);
+   dd_dump_render_condition(dstate, f);
 
    for (i = 0; i < PIPE_MAX_ATTRIBS; i++)
-      if (dctx->vertex_buffers[i].buffer ||
-          dctx->vertex_buffers[i].user_buffer) {
-         DUMP_I(vertex_buffer, &dctx->vertex_buffers[i], i);
-         if (dctx->vertex_buffers[i].buffer)
-            DUMP_M(resource, &dctx->vertex_buffers[i], buffer);
+      if (dstate->vertex_buffers[i].buffer ||
+          dstate->vertex_buffers[i].user_buffer) {
+         DUMP_I(vertex_buffer, &dstate->vertex_buffers[i], i);
+         if (dstate->vertex_buffers[i].buffer)
+            DUMP_M(resource, &dstate->vertex_buffers[i], buffer);
       }
 
-   if (dctx->velems) {
+   if (dstate->velems) {
       print_named_value(f, "num vertex elements",
-                        dctx->velems->state.velems.count);
-      for (i = 0; i < dctx->velems->state.velems.count; i++) {
+                        dstate->velems->state.velems.count);
+      for (i = 0; i < dstate->velems->state.velems.count; i++) {
          fprintf(f, "  ");
-         DUMP_I(vertex_element, &dctx->velems->state.velems.velems[i], i);
+         DUMP_I(vertex_element, &dstate->velems->state.velems.velems[i], i);
       }
    }
 
-   print_named_value(f, "num stream output targets", dctx->num_so_targets);
-   for (i = 0; i < dctx->num_so_targets; i++)
-      if (dctx->so_targets[i]) {
-         DUMP_I(stream_output_target, dctx->so_targets[i], i);
-         DUMP_M(resource, dctx->so_targets[i], buffer);
-         fprintf(f, "  offset = %i\n", dctx->so_offsets[i]);
+   print_named_value(f, "num stream output targets", dstate->num_so_targets);
+   for (i = 0; i < dstate->num_so_targets; i++)
+      if (dstate->so_targets[i]) {
+         DUMP_I(stream_output_target, dstate->so_targets[i], i);
+         DUMP_M(resource, dstate->so_targets[i], buffer);
+         fprintf(f, "  offset = %i\n", dstate->so_offsets[i]);
       }
 
    fprintf(f, "\n");
@@ -279,60 +232,61 @@ dd_dump_draw_vbo(struct dd_context *dctx, struct pipe_draw_info *info, FILE *f)
          continue;
 
       if (sh == PIPE_SHADER_TESS_CTRL &&
-          !dctx->shaders[PIPE_SHADER_TESS_CTRL] &&
-          dctx->shaders[PIPE_SHADER_TESS_EVAL])
+          !dstate->shaders[PIPE_SHADER_TESS_CTRL] &&
+          dstate->shaders[PIPE_SHADER_TESS_EVAL])
          fprintf(f, "tess_state: {default_outer_level = {%f, %f, %f, %f}, "
                  "default_inner_level = {%f, %f}}\n",
-                 dctx->tess_default_levels[0],
-                 dctx->tess_default_levels[1],
-                 dctx->tess_default_levels[2],
-                 dctx->tess_default_levels[3],
-                 dctx->tess_default_levels[4],
-                 dctx->tess_default_levels[5]);
+                 dstate->tess_default_levels[0],
+                 dstate->tess_default_levels[1],
+                 dstate->tess_default_levels[2],
+                 dstate->tess_default_levels[3],
+                 dstate->tess_default_levels[4],
+                 dstate->tess_default_levels[5]);
 
       if (sh == PIPE_SHADER_FRAGMENT)
-         if (dctx->rs) {
-            unsigned num_viewports = dd_num_active_viewports(dctx);
+         if (dstate->rs) {
+            unsigned num_viewports = dd_num_active_viewports(dstate);
 
-            if (dctx->rs->state.rs.clip_plane_enable)
-               DUMP(clip_state, &dctx->clip_state);
+            if (dstate->rs->state.rs.clip_plane_enable)
+               DUMP(clip_state, &dstate->clip_state);
 
             for (i = 0; i < num_viewports; i++)
-               DUMP_I(viewport_state, &dctx->viewports[i], i);
+               DUMP_I(viewport_state, &dstate->viewports[i], i);
 
-            if (dctx->rs->state.rs.scissor)
+            if (dstate->rs->state.rs.scissor)
                for (i = 0; i < num_viewports; i++)
-                  DUMP_I(scissor_state, &dctx->scissors[i], i);
+                  DUMP_I(scissor_state, &dstate->scissors[i], i);
 
-            DUMP(rasterizer_state, &dctx->rs->state.rs);
+            DUMP(rasterizer_state, &dstate->rs->state.rs);
 
-            if (dctx->rs->state.rs.poly_stipple_enable)
-               DUMP(poly_stipple, &dctx->polygon_stipple);
+            if (dstate->rs->state.rs.poly_stipple_enable)
+               DUMP(poly_stipple, &dstate->polygon_stipple);
             fprintf(f, "\n");
          }
 
-      if (!dctx->shaders[sh])
+      if (!dstate->shaders[sh])
          continue;
 
       fprintf(f, COLOR_SHADER "begin shader: %s" COLOR_RESET "\n", shader_str[sh]);
-      DUMP(shader_state, &dctx->shaders[sh]->state.shader);
+      DUMP(shader_state, &dstate->shaders[sh]->state.shader);
 
       for (i = 0; i < PIPE_MAX_CONSTANT_BUFFERS; i++)
-         if (dctx->constant_buffers[sh][i].buffer ||
-             dctx->constant_buffers[sh][i].user_buffer) {
-            DUMP_I(constant_buffer, &dctx->constant_buffers[sh][i], i);
-            if (dctx->constant_buffers[sh][i].buffer)
-               DUMP_M(resource, &dctx->constant_buffers[sh][i], buffer);
+         if (dstate->constant_buffers[sh][i].buffer ||
+             dstate->constant_buffers[sh][i].user_buffer) {
+            DUMP_I(constant_buffer, &dstate->constant_buffers[sh][i], i);
+            if (dstate->constant_buffers[sh][i].buffer)
+               DUMP_M(resource, &dstate->constant_buffers[sh][i], buffer);
          }
 
       for (i = 0; i < PIPE_MAX_SAMPLERS; i++)
-         if (dctx->sampler_states[sh][i])
-            DUMP_I(sampler_state, &dctx->sampler_states[sh][i]->state.sampler, i);
+         if (dstate->sampler_states[sh][i])
+            DUMP_I(sampler_state,
+                   &dstate->sampler_states[sh][i]->state.sampler, i);
 
       for (i = 0; i < PIPE_MAX_SAMPLERS; i++)
-         if (dctx->sampler_views[sh][i]) {
-            DUMP_I(sampler_view, dctx->sampler_views[sh][i], i);
-            DUMP_M(resource, dctx->sampler_views[sh][i], texture);
+         if (dstate->sampler_views[sh][i]) {
+            DUMP_I(sampler_view, dstate->sampler_views[sh][i], i);
+            DUMP_M(resource, dstate->sampler_views[sh][i], texture);
          }
 
       /* TODO: print shader images */
@@ -341,37 +295,37 @@ dd_dump_draw_vbo(struct dd_context *dctx, struct pipe_draw_info *info, FILE *f)
       fprintf(f, COLOR_SHADER "end shader: %s" COLOR_RESET "\n\n", shader_str[sh]);
    }
 
-   if (dctx->dsa)
-      DUMP(depth_stencil_alpha_state, &dctx->dsa->state.dsa);
-   DUMP(stencil_ref, &dctx->stencil_ref);
+   if (dstate->dsa)
+      DUMP(depth_stencil_alpha_state, &dstate->dsa->state.dsa);
+   DUMP(stencil_ref, &dstate->stencil_ref);
 
-   if (dctx->blend)
-      DUMP(blend_state, &dctx->blend->state.blend);
-   DUMP(blend_color, &dctx->blend_color);
+   if (dstate->blend)
+      DUMP(blend_state, &dstate->blend->state.blend);
+   DUMP(blend_color, &dstate->blend_color);
 
-   print_named_value(f, "min_samples", dctx->min_samples);
-   print_named_xvalue(f, "sample_mask", dctx->sample_mask);
+   print_named_value(f, "min_samples", dstate->min_samples);
+   print_named_xvalue(f, "sample_mask", dstate->sample_mask);
    fprintf(f, "\n");
 
-   DUMP(framebuffer_state, &dctx->framebuffer_state);
-   for (i = 0; i < dctx->framebuffer_state.nr_cbufs; i++)
-      if (dctx->framebuffer_state.cbufs[i]) {
+   DUMP(framebuffer_state, &dstate->framebuffer_state);
+   for (i = 0; i < dstate->framebuffer_state.nr_cbufs; i++)
+      if (dstate->framebuffer_state.cbufs[i]) {
          fprintf(f, "  " COLOR_STATE "cbufs[%i]:" COLOR_RESET "\n    ", i);
-         DUMP(surface, dctx->framebuffer_state.cbufs[i]);
+         DUMP(surface, dstate->framebuffer_state.cbufs[i]);
          fprintf(f, "    ");
-         DUMP(resource, dctx->framebuffer_state.cbufs[i]->texture);
+         DUMP(resource, dstate->framebuffer_state.cbufs[i]->texture);
       }
-   if (dctx->framebuffer_state.zsbuf) {
+   if (dstate->framebuffer_state.zsbuf) {
       fprintf(f, "  " COLOR_STATE "zsbuf:" COLOR_RESET "\n    ");
-      DUMP(surface, dctx->framebuffer_state.zsbuf);
+      DUMP(surface, dstate->framebuffer_state.zsbuf);
       fprintf(f, "    ");
-      DUMP(resource, dctx->framebuffer_state.zsbuf->texture);
+      DUMP(resource, dstate->framebuffer_state.zsbuf->texture);
    }
    fprintf(f, "\n");
 }
 
 static void
-dd_dump_resource_copy_region(struct dd_context *dctx,
+dd_dump_resource_copy_region(struct dd_draw_state *dstate,
                              struct call_resource_copy_region *info,
                              FILE *f)
 {
@@ -383,11 +337,11 @@ dd_dump_resource_copy_region(struct dd_context *dctx,
    DUMP_M(uint, info, dstz);
    DUMP_M(resource, info, src);
    DUMP_M(uint, info, src_level);
-   DUMP_M(box, info, src_box);
+   DUMP_M_ADDR(box, info, src_box);
 }
 
 static void
-dd_dump_blit(struct dd_context *dctx, struct pipe_blit_info *info, FILE *f)
+dd_dump_blit(struct dd_draw_state *dstate, struct pipe_blit_info *info, FILE *f)
 {
    fprintf(f, "%s:\n", __func__+8);
    DUMP_M(resource, info, dst.resource);
@@ -407,33 +361,33 @@ dd_dump_blit(struct dd_context *dctx, struct pipe_blit_info *info, FILE *f)
    DUMP_M(uint, info, render_condition_enable);
 
    if (info->render_condition_enable)
-      dd_dump_render_condition(dctx, f);
+      dd_dump_render_condition(dstate, f);
 }
 
 static void
-dd_dump_flush_resource(struct dd_context *dctx, struct pipe_resource *res,
-                       FILE *f)
+dd_dump_flush_resource(struct dd_draw_state *dstate,
+                       struct pipe_resource *res, FILE *f)
 {
    fprintf(f, "%s:\n", __func__+8);
    DUMP(resource, res);
 }
 
 static void
-dd_dump_clear(struct dd_context *dctx, struct call_clear *info, FILE *f)
+dd_dump_clear(struct dd_draw_state *dstate, struct call_clear *info, FILE *f)
 {
    fprintf(f, "%s:\n", __func__+8);
    DUMP_M(uint, info, buffers);
-   DUMP_M(color_union, info, color);
+   DUMP_M_ADDR(color_union, info, color);
    DUMP_M(double, info, depth);
    DUMP_M(hex, info, stencil);
 }
 
 static void
-dd_dump_clear_buffer(struct dd_context *dctx, struct call_clear_buffer *info,
-                     FILE *f)
+dd_dump_clear_buffer(struct dd_draw_state *dstate,
+                     struct call_clear_buffer *info, FILE *f)
 {
    int i;
-   const char *value = (const char*)info->clear_value;
+   const char *value = info->clear_value;
 
    fprintf(f, "%s:\n", __func__+8);
    DUMP_M(resource, info, res);
@@ -448,14 +402,14 @@ dd_dump_clear_buffer(struct dd_context *dctx, struct call_clear_buffer *info,
 }
 
 static void
-dd_dump_clear_render_target(struct dd_context *dctx, FILE *f)
+dd_dump_clear_render_target(struct dd_draw_state *dstate, FILE *f)
 {
    fprintf(f, "%s:\n", __func__+8);
    /* TODO */
 }
 
 static void
-dd_dump_clear_depth_stencil(struct dd_context *dctx, FILE *f)
+dd_dump_clear_depth_stencil(struct dd_draw_state *dstate, FILE *f)
 {
    fprintf(f, "%s:\n", __func__+8);
    /* TODO */
@@ -472,6 +426,37 @@ dd_dump_driver_state(struct dd_context *dctx, FILE *f, unsigned flags)
    }
 }
 
+static void
+dd_dump_call_info(struct dd_draw_state *dstate, struct dd_call *call, FILE *f)
+{
+   switch (call->type) {
+   case CALL_DRAW_VBO:
+      dd_dump_draw_vbo(dstate, &call->info.draw_vbo, f);
+      break;
+   case CALL_RESOURCE_COPY_REGION:
+      dd_dump_resource_copy_region(dstate, &call->info.resource_copy_region,
+                                   f);
+      break;
+   case CALL_BLIT:
+      dd_dump_blit(dstate, &call->info.blit, f);
+      break;
+   case CALL_FLUSH_RESOURCE:
+      dd_dump_flush_resource(dstate, call->info.flush_resource, f);
+      break;
+   case CALL_CLEAR:
+      dd_dump_clear(dstate, &call->info.clear, f);
+      break;
+   case CALL_CLEAR_BUFFER:
+      dd_dump_clear_buffer(dstate, &call->info.clear_buffer, f);
+      break;
+   case CALL_CLEAR_RENDER_TARGET:
+      dd_dump_clear_render_target(dstate, f);
+      break;
+   case CALL_CLEAR_DEPTH_STENCIL:
+      dd_dump_clear_depth_stencil(dstate, f);
+   }
+}
+
 static void
 dd_dump_call(struct dd_context *dctx, struct dd_call *call, unsigned flags)
 {
@@ -480,36 +465,257 @@ dd_dump_call(struct dd_context *dctx, struct dd_call *call, unsigned flags)
    if (!f)
       return;
 
-   switch (call->type) {
+   dd_dump_call_info(&dctx->draw_state, call, f);
+   dd_dump_driver_state(dctx, f, flags);
+   dd_close_file_stream(f);
+}
+
+
+/********************************************************************
+ * call recording
+ */
+
+static void
+dd_copy_draw_state(struct dd_draw_state *dst, struct dd_draw_state *src)
+{
+   unsigned i, j;
+
+   dst->render_cond.condition = src->render_cond.condition;
+   dst->render_cond.mode = src->render_cond.mode;
+
+   pipe_resource_reference(&dst->index_buffer.buffer,
+                           src->index_buffer.buffer);
+   dst->index_buffer = src->index_buffer;
+
+   for (i = 0; i < PIPE_MAX_ATTRIBS; i++) {
+      pipe_resource_reference(&dst->vertex_buffers[i].buffer,
+                              src->vertex_buffers[i].buffer);
+      dst->vertex_buffers[i] = src->vertex_buffers[i];
+   }
+
+   dst->num_so_targets = src->num_so_targets;
+   for (i = 0; i < PIPE_MAX_SO_BUFFERS; i++)
+      pipe_so_target_reference(&dst->so_targets[i],
+                               i < src->num_so_targets ?
+                                  src->so_targets[i] : NULL);
+   memcpy(dst->so_offsets, src->so_offsets, sizeof(src->so_offsets));
+
+   for (i = 0; i < PIPE_SHADER_TYPES; i++) {
+      dd_state_reference(&dst->shaders[i], src->shaders[i]);
+
+      for (j = 0; j < PIPE_MAX_CONSTANT_BUFFERS; j++) {
+         pipe_resource_reference(&dst->constant_buffers[i][j].buffer,
+                                 src->constant_buffers[i][j].buffer);
+         dst->constant_buffers[i][j] = src->constant_buffers[i][j];
+      }
+
+      for (j = 0; j < PIPE_MAX_SAMPLERS; j++) {
+         pipe_sampler_view_reference(&dst->sampler_views[i][j],
+                                     src->sampler_views[i][j]);
+         dd_state_reference(&dst->sampler_states[i][j],
+                            src->sampler_states[i][j]);
+      }
+   }
+
+   dd_state_reference(&dst->velems, src->velems);
+   dd_state_reference(&dst->rs, src->rs);
+   dd_state_reference(&dst->dsa, src->dsa);
+   dd_state_reference(&dst->blend, src->blend);
+
+   dst->blend_color = src->blend_color;
+   dst->stencil_ref = src->stencil_ref;
+   dst->sample_mask = src->sample_mask;
+   dst->min_samples = src->min_samples;
+   dst->clip_state = src->clip_state;
+   util_copy_framebuffer_state(&dst->framebuffer_state,
+                               &src->framebuffer_state);
+   dst->polygon_stipple = src->polygon_stipple;
+   memcpy(dst->scissors, src->scissors, sizeof(src->scissors));
+   memcpy(dst->viewports, src->viewports, sizeof(src->viewports));
+   memcpy(dst->tess_default_levels, src->tess_default_levels,
+          sizeof(src->tess_default_levels));
+}
+
+static void
+dd_unreference_copy_of_draw_state(struct dd_draw_state *dst)
+{
+   unsigned i, j;
+
+   pipe_resource_reference(&dst->index_buffer.buffer, NULL);
+
+   for (i = 0; i < PIPE_MAX_ATTRIBS; i++)
+      pipe_resource_reference(&dst->vertex_buffers[i].buffer, NULL);
+
+   for (i = 0; i < PIPE_MAX_SO_BUFFERS; i++)
+      pipe_so_target_reference(&dst->so_targets[i], NULL);
+
+   for (i = 0; i < PIPE_SHADER_TYPES; i++) {
+      dd_state_reference(&dst->shaders[i], NULL);
+
+      for (j = 0; j < PIPE_MAX_CONSTANT_BUFFERS; j++)
+         pipe_resource_reference(&dst->constant_buffers[i][j].buffer, NULL);
+
+      for (j = 0; j < PIPE_MAX_SAMPLERS; j++) {
+         pipe_sampler_view_reference(&dst->sampler_views[i][j], NULL);
+         dd_state_reference(&dst->sampler_states[i][j], NULL);
+      }
+   }
+
+   dd_state_reference(&dst->velems, NULL);
+   dd_state_reference(&dst->rs, NULL);
+   dd_state_reference(&dst->dsa, NULL);
+   dd_state_reference(&dst->blend, NULL);
+
+   util_unreference_framebuffer_state(&dst->framebuffer_state);
+}
+
+/* dst must not hold any references. */
+static void
+dd_copy_call(struct dd_call *dst, struct dd_call *src)
+{
+   memset(dst, 0, sizeof(*dst));
+   dst->type = src->type;
+
+   switch (src->type) {
    case CALL_DRAW_VBO:
-      dd_dump_draw_vbo(dctx, &call->info.draw_vbo, f);
+      pipe_so_target_reference(&dst->info.draw_vbo.count_from_stream_output,
+                               src->info.draw_vbo.count_from_stream_output);
+      pipe_resource_reference(&dst->info.draw_vbo.indirect,
+                              src->info.draw_vbo.indirect);
+      dst->info.draw_vbo = src->info.draw_vbo;
       break;
    case CALL_RESOURCE_COPY_REGION:
-      dd_dump_resource_copy_region(dctx, &call->info.resource_copy_region, f);
+      pipe_resource_reference(&dst->info.resource_copy_region.dst,
+                              src->info.resource_copy_region.dst);
+      pipe_resource_reference(&dst->info.resource_copy_region.src,
+                              src->info.resource_copy_region.src);
+      dst->info.resource_copy_region = src->info.resource_copy_region;
       break;
    case CALL_BLIT:
-      dd_dump_blit(dctx, &call->info.blit, f);
+      pipe_resource_reference(&dst->info.blit.dst.resource,
+                              src->info.blit.dst.resource);
+      pipe_resource_reference(&dst->info.blit.src.resource,
+                              src->info.blit.src.resource);
+      dst->info.blit = src->info.blit;
       break;
    case CALL_FLUSH_RESOURCE:
-      dd_dump_flush_resource(dctx, call->info.flush_resource, f);
+      pipe_resource_reference(&dst->info.flush_resource,
+                              src->info.flush_resource);
       break;
-   case CALL_CLEAR:
-      dd_dump_clear(dctx, &call->info.clear, f);
+   case CALL_CLEAR_BUFFER:
+      pipe_resource_reference(&dst->info.clear_buffer.res,
+                              src->info.clear_buffer.res);
+      dst->info.clear_buffer = src->info.clear_buffer;
+      break;
+   default:
+      dst->info = src->info;
+   }
+}
+
+static void
+dd_unreference_copy_of_call(struct dd_call *dst)
+{
+   switch (dst->type) {
+   case CALL_DRAW_VBO:
+      pipe_so_target_reference(&dst->info.draw_vbo.count_from_stream_output,
+                               NULL);
+      pipe_resource_reference(&dst->info.draw_vbo.indirect, NULL);
+      break;
+   case CALL_RESOURCE_COPY_REGION:
+      pipe_resource_reference(&dst->info.resource_copy_region.dst, NULL);
+      pipe_resource_reference(&dst->info.resource_copy_region.src, NULL);
+      break;
+   case CALL_BLIT:
+      pipe_resource_reference(&dst->info.blit.dst.resource, NULL);
+      pipe_resource_reference(&dst->info.blit.src.resource, NULL);
+      break;
+   case CALL_FLUSH_RESOURCE:
+      pipe_resource_reference(&dst->info.flush_resource, NULL);
       break;
    case CALL_CLEAR_BUFFER:
-      dd_dump_clear_buffer(dctx, &call->info.clear_buffer, f);
+      pipe_resource_reference(&dst->info.clear_buffer.res, NULL);
       break;
-   case CALL_CLEAR_RENDER_TARGET:
-      dd_dump_clear_render_target(dctx, f);
+   default:
       break;
-   case CALL_CLEAR_DEPTH_STENCIL:
-      dd_dump_clear_depth_stencil(dctx, f);
    }
+}
 
-   dd_dump_driver_state(dctx, f, flags);
+static void
+dd_record_call(struct dd_context *dctx, struct dd_call *call)
+{
+   struct dd_screen *dscreen = dd_screen(dctx->base.screen);
+   struct dd_record *record =
+      &dctx->records[dctx->num_recorded % dscreen->num_records];
+   struct dd_query *query = dctx->draw_state.render_cond.query;
+
+   dd_unreference_copy_of_call(&record->call);
+   dd_copy_call(&record->call, call);
+   dd_copy_draw_state(&record->state, &dctx->draw_state);
+
+   /* The query may be destroyed before the record is dumped. */
+   if (query) {
+      record->render_cond_query = *query;
+      record->state.render_cond.query = &record->render_cond_query;
+   } else {
+      record->state.render_cond.query = NULL;
+   }
+
+   record->draw_call = dctx->num_draw_calls;
+   dctx->num_recorded++;
+}
+
+static void
+dd_dump_records(struct dd_context *dctx, const char *cause)
+{
+   struct dd_screen *dscreen = dd_screen(dctx->base.screen);
+   FILE *f = dd_get_file_stream(dctx);
+   unsigned i;
+
+   if (!f)
+      return;
+
+   fprintf(f, "dd: %s.\n", cause);
+   if (dctx->pending_fence)
+      fprintf(f, "dd: The oldest unfinished flush was submitted after %u "
+              "draw calls.\n", dctx->pending_fence_draw_call);
+   fprintf(f, "dd: Dumping the last %u recorded calls.\n\n",
+           MIN2(dctx->num_recorded, dscreen->num_records));
+
+   for (i = dctx->num_recorded > dscreen->num_records ?
+           dctx->num_recorded - dscreen->num_records : 0;
+        i < dctx->num_recorded; i++) {
+      struct dd_record *record = &dctx->records[i % dscreen->num_records];
+
+      fprintf(f, "**************************************************"
+              "***************************\n");
+      fprintf(f, "Draw call %u:\n\n", record->draw_call);
+      dd_dump_call_info(&record->state, &record->call, f);
+   }
+
+   dd_dump_driver_state(dctx, f, PIPE_DEBUG_DEVICE_IS_HUNG);
    dd_close_file_stream(f);
 }
 
+void
+dd_release_records(struct dd_context *dctx)
+{
+   struct dd_screen *dscreen = dd_screen(dctx->base.screen);
+   struct pipe_screen *screen = dctx->pipe->screen;
+   unsigned i;
+
+   if (!dctx->records)
+      return;
+
+   for (i = 0; i < dscreen->num_records; i++) {
+      dd_unreference_copy_of_call(&dctx->records[i].call);
+      dd_unreference_copy_of_draw_state(&dctx->records[i].state);
+   }
+   FREE(dctx->records);
+   dctx->records = NULL;
+
+   screen->fence_reference(screen, &dctx->pending_fence, NULL);
+}
+
 static void
 dd_kill_process(void)
 {
@@ -565,6 +771,52 @@ dd_flush_and_handle_hang(struct dd_context *dctx,
    }
 }
 
+/* Unlike dd_flush_and_check_hang, this never waits: it only polls the
+ * oldest flush which hasn't finished yet, and reports a hang once that one
+ * has been pending for longer than the timeout.
+ */
+static void
+dd_flush_and_check_records(struct dd_context *dctx,
+                           struct pipe_fence_handle **flush_fence,
+                           unsigned flush_flags)
+{
+   struct pipe_fence_handle *fence = NULL;
+   struct pipe_context *pipe = dctx->pipe;
+   struct pipe_screen *screen = pipe->screen;
+   int64_t timeout_us = dd_screen(dctx->base.screen)->timeout_ms * 1000ll;
+   int64_t now;
+
+   pipe->flush(pipe, &fence, flush_flags);
+   if (flush_fence)
+      screen->fence_reference(screen, flush_fence, fence);
+
+   now = os_time_get();
+
+   if (dctx->pending_fence &&
+       screen->fence_finish(screen, dctx->pending_fence, 0))
+      screen->fence_reference(screen, &dctx->pending_fence, NULL);
+
+   if (dctx->pending_fence) {
+      if (now - dctx->pending_fence_time > timeout_us) {
+         fprintf(stderr, "dd: GPU hang detected!\n");
+         dd_dump_records(dctx, "GPU hang detected in pipe->flush()");
+         dd_kill_process();
+      }
+   } else if (fence) {
+      screen->fence_reference(screen, &dctx->pending_fence, fence);
+      dctx->pending_fence_time = now;
+      dctx->pending_fence_draw_call = dctx->num_draw_calls;
+   }
+   screen->fence_reference(screen, &fence, NULL);
+
+   if (pipe->get_device_reset_status &&
+       pipe->get_device_reset_status(pipe) != PIPE_NO_RESET) {
+      fprintf(stderr, "dd: GPU reset detected!\n");
+      dd_dump_records(dctx, "GPU reset detected in pipe->flush()");
+      dd_kill_process();
+   }
+}
+
 static void
 dd_context_flush(struct pipe_context *_pipe,
                  struct pipe_fence_handle **fence, unsigned flags)
@@ -580,6 +832,9 @@ dd_context_flush(struct pipe_context *_pipe,
    case DD_DUMP_ALL_CALLS:
       pipe->flush(pipe, fence, flags);
       break;
+   case DD_RECORD_CALLS:
+      dd_flush_and_check_records(dctx, fence, flags);
+      break;
    default:
       assert(0);
    }
@@ -617,6 +872,9 @@ dd_after_draw(struct dd_context *dctx, struct dd_call *call)
       case DD_DUMP_ALL_CALLS:
          dd_dump_call(dctx, call, 0);
          break;
+      case DD_RECORD_CALLS:
+         dd_record_call(dctx, call);
+         break;
       default:
          assert(0);
       }
@@ -663,7 +921,7 @@ dd_context_resource_copy_region(struct pipe_context *_pipe,
    call.info.resource_copy_region.dstz = dstz;
    call.info.resource_copy_region.src = src;
    call.info.resource_copy_region.src_level = src_level;
-   call.info.resource_copy_region.src_box = src_box;
+   call.info.resource_copy_region.src_box = *src_box;
 
    dd_before_draw(dctx);
    pipe->resource_copy_region(pipe,
@@ -714,7 +972,10 @@ dd_context_clear(struct pipe_context *_pipe, unsigned buffers,
 
    call.type = CALL_CLEAR;
    call.info.clear.buffers = buffers;
-   call.info.clear.color = color;
+   if (color)
+      call.info.clear.color = *color;
+   else
+      memset(&call.info.clear.color, 0, sizeof(call.info.clear.color));
    call.info.clear.depth = depth;
    call.info.clear.stencil = stencil;
 
@@ -772,7 +1033,8 @@ dd_context_clear_buffer(struct pipe_context *_pipe, struct pipe_resource *res,
    call.info.clear_buffer.res = res;
    call.info.clear_buffer.offset = offset;
    call.info.clear_buffer.size = size;
-   call.info.clear_buffer.clear_value = clear_value;
+   assert(clear_value_size <= sizeof(call.info.clear_buffer.clear_value));
+   memcpy(call.info.clear_buffer.clear_value, clear_value, clear_value_size);
    call.info.clear_buffer.clear_value_size = clear_value_size;
 
    dd_before_draw(dctx);
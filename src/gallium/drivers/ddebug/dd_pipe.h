@@ -35,7 +35,8 @@
 
 enum dd_mode {
    DD_DETECT_HANGS,
-   DD_DUMP_ALL_CALLS
+   DD_DUMP_ALL_CALLS,
+   DD_RECORD_CALLS
 };
 
 struct dd_screen
@@ -46,6 +47,7 @@ struct dd_screen
    enum dd_mode mode;
    bool no_flush;
    unsigned skip_count;
+   unsigned num_records; /* size of the DD_RECORD_CALLS ring buffer */
 };
 
 struct dd_query
@@ -58,6 +60,11 @@ struct dd_state
 {
    void *cso;
 
+   /* One reference is owned by the state tracker, the others by recorded
+    * calls, which can outlive the deletion of the CSO. */
+   unsigned refcount;
+   bool is_shader;
+
    union {
       struct pipe_blend_state blend;
       struct pipe_depth_stencil_alpha_state dsa;
@@ -71,11 +78,61 @@ struct dd_state
    } state;
 };
 
-struct dd_context
+enum call_type
 {
-   struct pipe_context base;
-   struct pipe_context *pipe;
+   CALL_DRAW_VBO,
+   CALL_RESOURCE_COPY_REGION,
+   CALL_BLIT,
+   CALL_FLUSH_RESOURCE,
+   CALL_CLEAR,
+   CALL_CLEAR_BUFFER,
+   CALL_CLEAR_RENDER_TARGET,
+   CALL_CLEAR_DEPTH_STENCIL,
+};
+
+struct call_resource_copy_region
+{
+   struct pipe_resource *dst;
+   unsigned dst_level;
+   unsigned dstx, dsty, dstz;
+   struct pipe_resource *src;
+   unsigned src_level;
+   struct pipe_box src_box;
+};
+
+struct call_clear
+{
+   unsigned buffers;
+   union pipe_color_union color;
+   double depth;
+   unsigned stencil;
+};
+
+struct call_clear_buffer
+{
+   struct pipe_resource *res;
+   unsigned offset;
+   unsigned size;
+   char clear_value[16];
+   int clear_value_size;
+};
+
+struct dd_call
+{
+   enum call_type type;
+
+   union {
+      struct pipe_draw_info draw_vbo;
+      struct call_resource_copy_region resource_copy_region;
+      struct pipe_blit_info blit;
+      struct pipe_resource *flush_resource;
+      struct call_clear clear;
+      struct call_clear_buffer clear_buffer;
+   } info;
+};
 
+struct dd_draw_state
+{
    struct {
       struct dd_query *query;
       bool condition;
@@ -111,8 +168,36 @@ struct dd_context
    struct pipe_scissor_state scissors[PIPE_MAX_VIEWPORTS];
    struct pipe_viewport_state viewports[PIPE_MAX_VIEWPORTS];
    float tess_default_levels[6];
+};
+
+/* A call recorded by DD_RECORD_CALLS with the state it was executed with.
+ * The record holds references to everything it points to, except shader
+ * images and buffers, which aren't dumped.
+ */
+struct dd_record
+{
+   unsigned draw_call;
+   struct dd_call call;
+   struct dd_draw_state state;
+   struct dd_query render_cond_query;
+};
+
+struct dd_context
+{
+   struct pipe_context base;
+   struct pipe_context *pipe;
 
+   struct dd_draw_state draw_state;
    unsigned num_draw_calls;
+
+   /* DD_RECORD_CALLS: the last dd_screen::num_records calls, and the oldest
+    * flush which hasn't finished yet.
+    */
+   struct dd_record *records;
+   unsigned num_recorded;
+   struct pipe_fence_handle *pending_fence;
+   int64_t pending_fence_time;
+   unsigned pending_fence_draw_call;
 };
 
 
@@ -122,6 +207,23 @@ dd_context_create(struct dd_screen *dscreen, struct pipe_context *pipe);
 void
 dd_init_draw_functions(struct dd_context *dctx);
 
+void
+dd_release_records(struct dd_context *dctx);
+
+void
+dd_state_destroy(struct dd_state *hstate);
+
+
+static inline void
+dd_state_reference(struct dd_state **dst, struct dd_state *src)
+{
+   if (src)
+      src->refcount++;
+   if (*dst && --(*dst)->refcount == 0)
+      dd_state_destroy(*dst);
+   *dst = src;
+}
+
 
 static inline struct dd_context *
 dd_context(struct pipe_context *pipe)
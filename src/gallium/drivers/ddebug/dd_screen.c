@@ -27,6 +27,7 @@
 
 #include "dd_pipe.h"
 #include "dd_public.h"
+#include "util/u_math.h"
 #include "util/u_memory.h"
 #include <stdio.h>
 
@@ -272,6 +273,7 @@ ddebug_screen_create(struct pipe_screen *screen)
    const char *option = debug_get_option("GALLIUM_DDEBUG", NULL);
    bool dump_always = option && !strcmp(option, "always");
    bool no_flush = option && strstr(option, "noflush");
+   bool record = option && strstr(option, "record");
    bool help = option && !strcmp(option, "help");
    unsigned timeout = 0;
 
@@ -290,6 +292,16 @@ ddebug_screen_create(struct pipe_screen *screen)
       puts("    $HOME/"DD_DIR"/ when a hang is detected.");
       puts("    If 'noflush' is specified, only detect hangs in pipe->flush.");
       puts("");
+      puts("  GALLIUM_DDEBUG=[timeout in ms] record");
+      puts("    Record the last draw calls and their states in a ring buffer without");
+      puts("    flushing or waiting. Every pipe->flush checks for a device reset and");
+      puts("    for a previous flush not finished within the given timeout, and dumps");
+      puts("    the recorded calls and driver information into $HOME/"DD_DIR"/ when");
+      puts("    either is detected.");
+      puts("");
+      puts("  GALLIUM_DDEBUG_RECORD=[count]");
+      puts("    Number of draw calls kept by 'record'. The default is 64.");
+      puts("");
       puts("  GALLIUM_DDEBUG_SKIP=[count]");
       puts("    Skip flush and hang detection for the given initial number of draw calls.");
       puts("");
@@ -337,8 +349,11 @@ ddebug_screen_create(struct pipe_screen *screen)
 
    dscreen->screen = screen;
    dscreen->timeout_ms = timeout;
-   dscreen->mode = dump_always ? DD_DUMP_ALL_CALLS : DD_DETECT_HANGS;
+   dscreen->mode = dump_always ? DD_DUMP_ALL_CALLS :
+                   record ? DD_RECORD_CALLS : DD_DETECT_HANGS;
    dscreen->no_flush = no_flush;
+   dscreen->num_records =
+      MAX2(debug_get_num_option("GALLIUM_DDEBUG_RECORD", 64), 1);
 
    switch (dscreen->mode) {
    case DD_DUMP_ALL_CALLS:
@@ -348,6 +363,11 @@ ddebug_screen_create(struct pipe_screen *screen)
       fprintf(stderr, "Gallium debugger active. "
               "The hang detection timout is %i ms.\n", timeout);
       break;
+   case DD_RECORD_CALLS:
+      fprintf(stderr, "Gallium debugger active. Recording the last %u calls. "
+              "The hang detection timeout is %i ms.\n",
+              dscreen->num_records, timeout);
+      break;
    default:
       assert(0);
    }
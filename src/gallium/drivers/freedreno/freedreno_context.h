@@ -231,6 +231,7 @@ struct fd_context {
 		FD_GMEM_LOGICOP_ENABLED      = 0x20,
 	} gmem_reason;
 	unsigned num_draws;   /* number of draws in current batch */
+	uint64_t draw_area;   /* sum of the draws' scissor areas, in pixels */
 
 	/* Stats/counters:
 	 */
@@ -238,6 +239,7 @@ struct fd_context {
 		uint64_t prims_emitted;
 		uint64_t draw_calls;
 		uint64_t batch_total, batch_sysmem, batch_gmem, batch_restore;
+		uint64_t batch_gmem_overdraw;
 	} stats;
 
 	/* we can't really sanely deal with wraparound point in ringbuffer
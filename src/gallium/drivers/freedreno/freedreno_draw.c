@@ -170,6 +170,8 @@ fd_draw_vbo(struct pipe_context *pctx, const struct pipe_draw_info *info)
 			resource_written(ctx, ctx->streamout.targets[i]->buffer);
 
 	ctx->num_draws++;
+	ctx->draw_area += (scissor->maxx - scissor->minx) *
+			(scissor->maxy - scissor->miny);
 
 	prims = u_reduced_prims_for_vertices(info->mode, info->count);
 
@@ -353,6 +353,28 @@ render_sysmem(struct fd_context *ctx)
 	fd_reset_wfi(ctx);
 }
 
+/* Estimate whether bypassing GMEM saves memory bandwidth for a batch that
+ * doesn't need any of the GMEM-only features.  Through GMEM, every pixel
+ * within the draw bounds is resolved (and restored first, unless cleared)
+ * once, whatever the overdraw.  In bypass mode every draw writes straight
+ * to memory, which we estimate from the draws' scissor areas.
+ */
+static bool
+sysmem_is_cheaper(struct fd_context *ctx)
+{
+	struct pipe_scissor_state *scissor = &ctx->max_scissor;
+	uint64_t bounds_area;
+
+	/* a handful of draws can't make up for the per-tile overhead: */
+	if (ctx->num_draws <= 5)
+		return true;
+
+	bounds_area = (uint64_t)(scissor->maxx - scissor->minx) *
+			(scissor->maxy - scissor->miny);
+
+	return ctx->draw_area <= bounds_area * (ctx->restore ? 2 : 1);
+}
+
 void
 fd_gmem_render_tiles(struct fd_context *ctx)
 {
@@ -360,11 +382,17 @@ fd_gmem_render_tiles(struct fd_context *ctx)
 	bool sysmem = false;
 
 	if (ctx->emit_sysmem_prep) {
-		if (ctx->cleared || ctx->gmem_reason || (ctx->num_draws > 5)) {
+		if (ctx->cleared || ctx->gmem_reason) {
 			DBG("GMEM: cleared=%x, gmem_reason=%x, num_draws=%u",
 				ctx->cleared, ctx->gmem_reason, ctx->num_draws);
-		} else if (!(fd_mesa_debug & FD_DBG_NOBYPASS)) {
+		} else if (fd_mesa_debug & FD_DBG_NOBYPASS) {
+			/* GMEM forced */
+		} else if (sysmem_is_cheaper(ctx)) {
 			sysmem = true;
+		} else {
+			DBG("GMEM: num_draws=%u, draw_area=%llu", ctx->num_draws,
+				(unsigned long long)ctx->draw_area);
+			ctx->stats.batch_gmem_overdraw++;
 		}
 	}
 
@@ -101,6 +101,7 @@ fd_get_driver_query_info(struct pipe_screen *pscreen,
 			{"batches-sysmem", FD_QUERY_BATCH_SYSMEM, {0}},
 			{"batches-gmem", FD_QUERY_BATCH_GMEM, {0}},
 			{"restores", FD_QUERY_BATCH_RESTORE, {0}},
+			{"batches-gmem-overdraw", FD_QUERY_BATCH_GMEM_OVERDRAW, {0}},
 			{"prims-emitted", PIPE_QUERY_PRIMITIVES_EMITTED, {0}},
 	};
 
@@ -67,6 +67,8 @@ read_counter(struct fd_context *ctx, int type)
 		return ctx->stats.batch_gmem;
 	case FD_QUERY_BATCH_RESTORE:
 		return ctx->stats.batch_restore;
+	case FD_QUERY_BATCH_GMEM_OVERDRAW:
+		return ctx->stats.batch_gmem_overdraw;
 	}
 	return 0;
 }
@@ -79,6 +81,7 @@ is_rate_query(struct fd_query *q)
 	case FD_QUERY_BATCH_SYSMEM:
 	case FD_QUERY_BATCH_GMEM:
 	case FD_QUERY_BATCH_RESTORE:
+	case FD_QUERY_BATCH_GMEM_OVERDRAW:
 		return true;
 	default:
 		return false;
@@ -149,6 +152,7 @@ fd_sw_create_query(struct fd_context *ctx, unsigned query_type)
 	case FD_QUERY_BATCH_SYSMEM:
 	case FD_QUERY_BATCH_GMEM:
 	case FD_QUERY_BATCH_RESTORE:
+	case FD_QUERY_BATCH_GMEM_OVERDRAW:
 		break;
 	default:
 		return NULL;
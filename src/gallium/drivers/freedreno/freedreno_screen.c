@@ -238,6 +238,8 @@ fd_screen_get_param(struct pipe_screen *pscreen, enum pipe_cap param)
 	case PIPE_CAP_SHAREABLE_SHADERS:
 	case PIPE_CAP_COPY_BETWEEN_COMPRESSED_AND_PLAIN_FORMATS:
 	case PIPE_CAP_CLEAR_TEXTURE:
+	case PIPE_CAP_QUERY_BUFFER_OBJECT:
+	case PIPE_CAP_SPARSE_BUFFER_PAGE_SIZE:
 		return 0;
 
 	case PIPE_CAP_MAX_VIEWPORTS:
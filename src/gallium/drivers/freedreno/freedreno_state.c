@@ -31,6 +31,7 @@
 #include "util/u_string.h"
 #include "util/u_memory.h"
 #include "util/u_helpers.h"
+#include "util/u_framebuffer.h"
 
 #include "freedreno_state.h"
 #include "freedreno_context.h"
@@ -124,6 +125,14 @@ fd_set_framebuffer_state(struct pipe_context *pctx,
 	DBG("%d: cbufs[0]=%p, zsbuf=%p", ctx->needs_flush,
 			framebuffer->cbufs[0], framebuffer->zsbuf);
 
+	/* Rebinding the same render targets (which state trackers and
+	 * u_blitter do a lot) can keep on adding to the current batch,
+	 * rather than resolving it and restoring the tiles again for the
+	 * next one:
+	 */
+	if (util_framebuffer_state_equal(cso, framebuffer))
+		return;
+
 	fd_context_render(pctx);
 
 	if ((cso->width != framebuffer->width) ||
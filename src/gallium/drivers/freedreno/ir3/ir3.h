@@ -259,6 +259,12 @@ struct ir3_instruction {
 	 */
 	void *data;
 
+	/* used by the scheduler to track the number of not yet scheduled
+	 * consumers of the value written by this instruction (ie. whether
+	 * it is still occupying a register):
+	 */
+	unsigned use_count;
+
 	/* Used during CP and RA stages.  For fanin and shader inputs/
 	 * outputs where we need a sequence of consecutive registers,
 	 * keep track of each src instructions left (ie 'n-1') and right
@@ -201,6 +201,16 @@ static struct nir_shader *to_nir(struct ir3_compile *ctx,
 	nir_remove_dead_variables(s);
 	nir_validate_shader(s);
 
+	if (fd_mesa_debug & FD_DBG_SHADERDB) {
+		nir_shader_stats stats;
+		nir_gather_stats(s, &stats);
+
+		fprintf(stderr, "SHADER-DB: %s prog %d/%d: %u NIR instructions, %u NIR loops\n",
+				ir3_shader_stage(so->shader),
+				so->shader->id, so->id,
+				stats.instrs, stats.loops);
+	}
+
 	if (fd_mesa_debug & FD_DBG_DISASM) {
 		debug_printf("----------------------\n");
 		nir_print_shader(s, stdout);
@@ -49,7 +49,25 @@
  * To solve this, when we are in such a scheduling "critical section",
  * and we encounter a conflicting write to a special register, we try
  * to schedule any remaining instructions that use that value first.
+ *
+ * Since the depth based algo only cares about hiding latency, it will
+ * happily start on many independent chains of instructions at once,
+ * which can result in a lot of values being live at the same time.
+ * The larger the register footprint of the shader, the fewer threads
+ * the hw can keep in flight, which in the end hurts latency hiding
+ * more than a few nop's would.  So we also keep an estimate of the
+ * number of live (scalar) values, and once that goes over the limit
+ * we prefer instructions which free up registers (or at least do not
+ * allocate new ones) over instructions which would avoid a stall.
+ */
+
+/* Occupancy model: on a3xx/a4xx the full register footprint (in vec4
+ * registers, ie. max_reg + 1) is what limits the number of threads in
+ * flight.  The exact steps are not known, but going much beyond 16
+ * vec4 registers costs waves, so above this point we start trading
+ * latency hiding for register footprint:
  */
+#define SCHED_PRESSURE_LIMIT (4 * 16)
 
 struct ir3_sched_ctx {
 	struct ir3_block *block;           /* the current block */
@@ -57,6 +75,7 @@ struct ir3_sched_ctx {
 	struct ir3_instruction *scheduled; /* last scheduled instr XXX remove*/
 	struct ir3_instruction *addr;      /* current a0.x user, if any */
 	struct ir3_instruction *pred;      /* current p0.x user, if any */
+	unsigned live_values;              /* estimated # of live scalar values */
 	bool error;
 };
 
@@ -65,6 +84,100 @@ static bool is_sfu_or_mem(struct ir3_instruction *instr)
 	return is_sfu(instr) || is_mem(instr);
 }
 
+/* fanin/fanout meta instructions just alias the registers of their
+ * srcs, so for the purposes of tracking register pressure we look
+ * through them to the instructions which actually write a register:
+ */
+static bool is_alias_meta(struct ir3_instruction *instr)
+{
+	return is_meta(instr) && ((instr->opc == OPC_META_FO) ||
+			(instr->opc == OPC_META_FI));
+}
+
+/* number of (scalar) registers written by instruction: */
+static unsigned
+dest_size(struct ir3_instruction *instr)
+{
+	if (is_alias_meta(instr) || (instr->regs_count == 0))
+		return 0;
+	if (writes_addr(instr) || writes_pred(instr))
+		return 0;
+	return MAX2(1, util_last_bit(instr->regs[0]->wrmask));
+}
+
+/* adjust the use_count of the values read by the instruction: */
+static void
+update_use_count(struct ir3_instruction *instr, int delta)
+{
+	struct ir3_instruction *src;
+
+	foreach_ssa_src(src, instr) {
+		if (is_alias_meta(src))
+			update_use_count(src, delta);
+		else
+			src->use_count += delta;
+	}
+}
+
+/* release the values read by a just scheduled instruction, for any
+ * that were the last remaining use in the current block:
+ */
+static void
+release_srcs(struct ir3_sched_ctx *ctx, struct ir3_instruction *instr)
+{
+	struct ir3_instruction *src;
+
+	foreach_ssa_src(src, instr) {
+		if (is_alias_meta(src)) {
+			release_srcs(ctx, src);
+			continue;
+		}
+
+		/* values used by other blocks stay live until the end of
+		 * the block:
+		 */
+		if ((src->block != ctx->block) || (src->use_count == 0))
+			continue;
+
+		if (--src->use_count == 0) {
+			unsigned size = dest_size(src);
+			ctx->live_values -= MIN2(size, ctx->live_values);
+		}
+	}
+}
+
+/* number of values which would be released by scheduling instr: */
+static unsigned
+freed_values(struct ir3_sched_ctx *ctx, struct ir3_instruction *instr)
+{
+	struct ir3_instruction *src;
+	unsigned freed = 0;
+
+	foreach_ssa_src(src, instr) {
+		if (is_alias_meta(src))
+			freed += freed_values(ctx, src);
+		else if ((src->block == ctx->block) && (src->use_count == 1))
+			freed += dest_size(src);
+	}
+
+	return freed;
+}
+
+/* change in the number of live values if instr were scheduled: */
+static int
+live_effect(struct ir3_sched_ctx *ctx, struct ir3_instruction *instr)
+{
+	int effect = 0;
+
+	if (is_alias_meta(instr))
+		return 0;
+
+	if (instr->use_count > 0)
+		effect += dest_size(instr);
+
+	return effect - (int)freed_values(ctx, instr);
+}
+
 #define NULL_INSTR ((void *)~0)
 
 static void
@@ -104,6 +217,12 @@ schedule(struct ir3_sched_ctx *ctx, struct ir3_instruction *instr)
 
 	instr->flags |= IR3_INSTR_MARK;
 
+	if (!is_alias_meta(instr)) {
+		release_srcs(ctx, instr);
+		if (instr->use_count > 0)
+			ctx->live_values += dest_size(instr);
+	}
+
 	list_addtail(&instr->node, &instr->block->instr_list);
 	ctx->scheduled = instr;
 
@@ -368,6 +487,8 @@ find_eligible_instr(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes)
 {
 	struct ir3_instruction *best_instr = NULL;
 	unsigned min_delay = ~0;
+	int min_live = INT_MAX;
+	bool pressure = ctx->live_values > SCHED_PRESSURE_LIMIT;
 
 	/* TODO we'd really rather use the list/array of block outputs.  But we
 	 * don't have such a thing.  Recursing *every* instruction in the list
@@ -384,6 +505,26 @@ find_eligible_instr(struct ir3_sched_ctx *ctx, struct ir3_sched_notes *notes)
 			continue;
 
 		delay = delay_calc(ctx, candidate);
+
+		/* if we are over the register pressure limit, first try to
+		 * reduce the number of live values, and only then hide latency:
+		 */
+		if (pressure) {
+			int live = live_effect(ctx, candidate);
+
+			if ((live < min_live) ||
+					((live == min_live) && (delay < min_delay))) {
+				best_instr = candidate;
+				min_delay = delay;
+				min_live = live;
+			}
+
+			if ((min_live < 0) && (min_delay == 0))
+				break;
+
+			continue;
+		}
+
 		if (delay < min_delay) {
 			best_instr = candidate;
 			min_delay = delay;
@@ -495,6 +636,9 @@ sched_block(struct ir3_sched_ctx *ctx, struct ir3_block *block)
 	ctx->addr = NULL;
 	ctx->pred = NULL;
 
+	/* as is register pressure tracking: */
+	ctx->live_values = 0;
+
 	/* move all instructions to the unscheduled list, and
 	 * empty the block's instruction list (to which we will
 	 * be inserting).
@@ -638,6 +782,35 @@ sched_insert_parallel_copies(struct ir3_block *block)
 	}
 }
 
+/* count the uses of each value, for register pressure tracking: */
+static void
+sched_calc_use_counts(struct ir3 *ir)
+{
+	list_for_each_entry (struct ir3_block, block, &ir->block_list, node) {
+		list_for_each_entry (struct ir3_instruction, instr, &block->instr_list, node) {
+			instr->use_count = 0;
+		}
+	}
+
+	list_for_each_entry (struct ir3_block, block, &ir->block_list, node) {
+		list_for_each_entry (struct ir3_instruction, instr, &block->instr_list, node) {
+			if (!is_alias_meta(instr))
+				update_use_count(instr, 1);
+		}
+	}
+
+	/* shader outputs are live until the end: */
+	for (unsigned i = 0; i < ir->noutputs; i++) {
+		struct ir3_instruction *out = ir->outputs[i];
+		if (!out)
+			continue;
+		if (is_alias_meta(out))
+			update_use_count(out, 1);
+		else
+			out->use_count++;
+	}
+}
+
 int ir3_sched(struct ir3 *ir)
 {
 	struct ir3_sched_ctx ctx = {0};
@@ -645,6 +818,7 @@ int ir3_sched(struct ir3 *ir)
 		sched_insert_parallel_copies(block);
 	}
 	ir3_clear_mark(ir);
+	sched_calc_use_counts(ir);
 	list_for_each_entry (struct ir3_block, block, &ir->block_list, node) {
 		sched_block(&ctx, block);
 	}
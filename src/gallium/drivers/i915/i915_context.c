@@ -213,6 +213,8 @@ i915_create_context(struct pipe_screen *screen, void *priv, unsigned flags)
    draw_install_aaline_stage(i915->draw, &i915->base);
    draw_install_aapoint_stage(i915->draw, &i915->base);
    draw_enable_point_sprites(i915->draw, TRUE);
+   /* Reuse shaded vertices across the whole of a vbuf segment. */
+   draw_set_vertex_cache_size(i915->draw, 1024);
 
    i915->dirty = ~0;
    i915->hardware_dirty = ~0;
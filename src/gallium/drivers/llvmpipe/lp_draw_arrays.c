@@ -48,23 +48,20 @@
  * Draw vertex arrays, with optional indexing, optional instancing.
  * All the other drawing functions are implemented in terms of this function.
  * Basically, map the vertex buffers (and drawing surfaces), then hand off
- * the drawing to the 'draw' module.
+ * the num_draws (non-indirect) draws to the 'draw' module.
  */
 static void
-llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
+llvmpipe_draw_mapped(struct llvmpipe_context *lp,
+                     const struct pipe_draw_info *info,
+                     unsigned num_draws)
 {
-   struct llvmpipe_context *lp = llvmpipe_context(pipe);
    struct draw_context *draw = lp->draw;
    const void *mapped_indices = NULL;
+   boolean indexed = FALSE;
    unsigned i;
 
-   if (!llvmpipe_check_render_cond(lp))
-      return;
-
-   if (info->indirect) {
-      util_draw_indirect(pipe, info);
-      return;
-   }
+   for (i = 0; i < num_draws; i++)
+      indexed |= info[i].indexed;
 
    if (lp->dirty)
       llvmpipe_update_derived( lp );
@@ -86,7 +83,7 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    }
 
    /* Map index buffer, if present */
-   if (info->indexed) {
+   if (indexed) {
       unsigned available_space = ~0;
       mapped_indices = lp->index_buffer.user_buffer;
       if (!mapped_indices) {
@@ -129,7 +126,8 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
                                     lp->active_statistics_queries > 0);
 
    /* draw! */
-   draw_vbo(draw, info);
+   for (i = 0; i < num_draws; i++)
+      draw_vbo(draw, &info[i]);
 
    /*
     * unmap vertex/index buffers
@@ -162,8 +160,48 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
 }
 
 
+/**
+ * Draw several primitives, mapping the buffers only once for all the
+ * direct draws in a row.
+ */
+static void
+llvmpipe_draw_vbo_multi(struct pipe_context *pipe,
+                        const struct pipe_draw_info *info,
+                        unsigned num_draws)
+{
+   struct llvmpipe_context *lp = llvmpipe_context(pipe);
+
+   if (!llvmpipe_check_render_cond(lp))
+      return;
+
+   while (num_draws) {
+      unsigned n = 1;
+
+      if (info->indirect) {
+         util_draw_indirect(pipe, info);
+      }
+      else {
+         while (n < num_draws && !info[n].indirect)
+            n++;
+         llvmpipe_draw_mapped(lp, info, n);
+      }
+
+      info += n;
+      num_draws -= n;
+   }
+}
+
+
+static void
+llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
+{
+   llvmpipe_draw_vbo_multi(pipe, info, 1);
+}
+
+
 void
 llvmpipe_init_draw_funcs(struct llvmpipe_context *llvmpipe)
 {
    llvmpipe->pipe.draw_vbo = llvmpipe_draw_vbo;
+   llvmpipe->pipe.draw_vbo_multi = llvmpipe_draw_vbo_multi;
 }
@@ -61,7 +61,11 @@
 #define LP_MAX_WIDTH  (1 << (LP_MAX_TEXTURE_LEVELS - 1))
 
 
-#define LP_MAX_THREADS 16
+/**
+ * Max number of rasterizer threads. The actual number defaults to the
+ * number of CPUs and can be overridden with LP_NUM_THREADS.
+ */
+#define LP_MAX_THREADS 128
 
 
 /**
@@ -93,4 +97,12 @@
  */
 #define LP_MAX_SETUP_VARIANTS 64
 
+/**
+ * Compute shader limits.
+ */
+#define LP_MAX_CS_RESOURCES 32
+#define LP_MAX_CS_BLOCK_SIZE 1024
+#define LP_MAX_CS_LOCAL_MEM (32 * 1024)
+#define LP_MAX_CS_INPUT_MEM 4096
+
 #endif /* LP_LIMITS_H */
@@ -50,6 +50,7 @@ lp_print_counters(void)
 
       debug_printf("llvmpipe: nr_triangles:                 %9u\n", lp_count.nr_tris);
       debug_printf("llvmpipe: nr_culled_triangles:          %9u\n", lp_count.nr_culled_tris);
+      debug_printf("llvmpipe: nr_rects:                     %9u\n", lp_count.nr_rects);
 
       total_64 = (lp_count.nr_empty_64 + 
                   lp_count.nr_fully_covered_64 +
@@ -98,10 +99,21 @@ lp_print_counters(void)
       debug_printf("llvmpipe:   nr_empty_4x4:               %9u (%3.0f%% of %u)\n", lp_count.nr_empty_4, p1, total_4);
       debug_printf("llvmpipe:   nr_non_empty_4x4:           %9u (%3.0f%% of %u)\n", lp_count.nr_non_empty_4, p4, total_4);
 
+      debug_printf("llvmpipe: nr_depth_rejected_64x64:      %9u\n", lp_count.nr_depth_rejected_64);
+      debug_printf("llvmpipe: nr_depth_rejected_16x16:      %9u\n", lp_count.nr_depth_rejected_16);
+
       debug_printf("llvmpipe: nr_color_tile_clear:          %9u\n", lp_count.nr_color_tile_clear);
       debug_printf("llvmpipe: nr_color_tile_load:           %9u\n", lp_count.nr_color_tile_load);
       debug_printf("llvmpipe: nr_color_tile_store:          %9u\n", lp_count.nr_color_tile_store);
 
+      if (lp_count.nr_texture_cache_access) {
+         p1 = 100.0 * (float) (lp_count.nr_texture_cache_access -
+                               lp_count.nr_texture_cache_miss) /
+              (float) lp_count.nr_texture_cache_access;
+         debug_printf("llvmpipe: nr_texture_cache_access:      %9llu\n", (unsigned long long) lp_count.nr_texture_cache_access);
+         debug_printf("llvmpipe:   nr_texture_cache_miss:      %9llu (%3.0f%% hit rate)\n", (unsigned long long) lp_count.nr_texture_cache_miss, p1);
+      }
+
       debug_printf("llvmpipe: nr_llvm_compiles:             %u\n", lp_count.nr_llvm_compiles);
       debug_printf("llvmpipe: total LLVM compile time:      %.2f sec\n", lp_count.llvm_compile_time / 1000000.0);
       debug_printf("llvmpipe: average LLVM compile time:    %.2f sec\n", lp_count.llvm_compile_time / 1000000.0 / lp_count.nr_llvm_compiles);
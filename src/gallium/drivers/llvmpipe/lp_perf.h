@@ -42,6 +42,7 @@ struct lp_counters
 {
    unsigned nr_tris;
    unsigned nr_culled_tris;
+   unsigned nr_rects;  /**< pairs of triangles drawn as one rectangle */
    unsigned nr_empty_64;
    unsigned nr_fully_covered_64;
    unsigned nr_partially_covered_64;
@@ -56,12 +57,18 @@ struct lp_counters
    unsigned nr_fully_covered_4;
    unsigned nr_partially_covered_4;
    unsigned nr_non_empty_4;
+   unsigned nr_depth_rejected_64;  /**< tiles behind the tile's max depth */
+   unsigned nr_depth_rejected_16;
    unsigned nr_llvm_compiles;
    int64_t llvm_compile_time;  /**< total, in microseconds */
 
    unsigned nr_color_tile_clear;
    unsigned nr_color_tile_load;
    unsigned nr_color_tile_store;
+
+   /** compressed texture block cache, see LP_BUILD_FORMAT_CACHE_DEBUG */
+   uint64_t nr_texture_cache_access;
+   uint64_t nr_texture_cache_miss;
 };
 
 
@@ -33,6 +33,7 @@
 #include "draw/draw_context.h"
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
+#include "util/u_string.h"
 #include "os/os_time.h"
 #include "lp_context.h"
 #include "lp_flush.h"
@@ -40,6 +41,7 @@
 #include "lp_query.h"
 #include "lp_screen.h"
 #include "lp_state.h"
+#include "lp_texture.h"
 #include "lp_rast.h"
 
 
@@ -48,6 +50,113 @@ static struct llvmpipe_query *llvmpipe_query( struct pipe_query *p )
    return (struct llvmpipe_query *)p;
 }
 
+
+#define X(name_, query_type_, type_, result_type_) \
+   { \
+      .name = name_, \
+      .query_type = LP_QUERY_##query_type_, \
+      .type = PIPE_DRIVER_QUERY_TYPE_##type_, \
+      .result_type = PIPE_DRIVER_QUERY_RESULT_TYPE_##result_type_, \
+      .group_id = ~(unsigned)0 \
+   }
+
+static const struct pipe_driver_query_info lp_driver_query_list[] = {
+   X("rast-tiles",              RAST_TILES,              UINT64,       AVERAGE),
+   X("rast-fragments-shaded",   RAST_FRAGMENTS_SHADED,   UINT64,       AVERAGE),
+   X("rast-fragments-rejected", RAST_FRAGMENTS_REJECTED, UINT64,       AVERAGE),
+   X("rast-shade-tile-time",    RAST_SHADE_TILE_TIME,    MICROSECONDS, AVERAGE),
+   X("rast-idle-time",          RAST_IDLE_TIME,          MICROSECONDS, AVERAGE),
+};
+
+#undef X
+
+
+static boolean
+is_driver_query(unsigned type)
+{
+   return type >= PIPE_QUERY_DRIVER_SPECIFIC;
+}
+
+
+/**
+ * Current value of the counter behind a driver query, summed over the
+ * threads unless it's a per-thread query.
+ */
+static uint64_t
+get_driver_query_value(struct llvmpipe_screen *screen, unsigned type)
+{
+   unsigned num_tasks = lp_rast_get_num_tasks(screen->rast);
+   struct lp_rast_counters counters;
+   uint64_t value = 0;
+   unsigned i;
+
+   if (type >= LP_QUERY_RAST_THREAD_BUSY) {
+      lp_rast_get_counters(screen->rast, type - LP_QUERY_RAST_THREAD_BUSY,
+                           &counters);
+      return counters.busy_time;
+   }
+
+   for (i = 0; i < num_tasks; i++) {
+      lp_rast_get_counters(screen->rast, i, &counters);
+
+      switch (type) {
+      case LP_QUERY_RAST_TILES:
+         value += counters.tiles;
+         break;
+      case LP_QUERY_RAST_FRAGMENTS_SHADED:
+         value += counters.blocks_shaded *
+                  LP_RASTER_BLOCK_SIZE * LP_RASTER_BLOCK_SIZE;
+         break;
+      case LP_QUERY_RAST_FRAGMENTS_REJECTED:
+         value += counters.blocks_rejected *
+                  LP_RASTER_BLOCK_SIZE * LP_RASTER_BLOCK_SIZE;
+         break;
+      case LP_QUERY_RAST_SHADE_TILE_TIME:
+         value += counters.shade_tile_time;
+         break;
+      case LP_QUERY_RAST_IDLE_TIME:
+         value += counters.idle_time;
+         break;
+      default:
+         assert(0);
+         break;
+      }
+   }
+
+   return value;
+}
+
+
+static int
+llvmpipe_get_driver_query_info(struct pipe_screen *_screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
+   unsigned num_tasks = lp_rast_get_num_tasks(screen->rast);
+
+   if (!info)
+      return Elements(lp_driver_query_list) + num_tasks;
+
+   if (index < Elements(lp_driver_query_list)) {
+      *info = lp_driver_query_list[index];
+      return 1;
+   }
+
+   index -= Elements(lp_driver_query_list);
+   if (index >= num_tasks)
+      return 0;
+
+   memset(info, 0, sizeof *info);
+   info->name = screen->thread_query_names[index];
+   info->query_type = LP_QUERY_RAST_THREAD_BUSY + index;
+   info->max_value.u64 = 100;
+   info->type = PIPE_DRIVER_QUERY_TYPE_PERCENTAGE;
+   info->result_type = PIPE_DRIVER_QUERY_RESULT_TYPE_AVERAGE;
+   info->group_id = ~(unsigned)0;
+   return 1;
+}
+
 static struct pipe_query *
 llvmpipe_create_query(struct pipe_context *pipe, 
                       unsigned type,
@@ -55,7 +164,10 @@ llvmpipe_create_query(struct pipe_context *pipe,
 {
    struct llvmpipe_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES ||
+          (is_driver_query(type) &&
+           type < LP_QUERY_RAST_THREAD_BUSY +
+                  lp_rast_get_num_tasks(llvmpipe_screen(pipe->screen)->rast)));
 
    pq = CALLOC_STRUCT( llvmpipe_query );
 
@@ -101,6 +213,28 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
    uint64_t *result = (uint64_t *)vresult;
    int i;
 
+   if (is_driver_query(pq->type)) {
+      uint64_t value = pq->end[0] - pq->start[0];
+
+      switch (pq->type) {
+      case LP_QUERY_RAST_SHADE_TILE_TIME:
+      case LP_QUERY_RAST_IDLE_TIME:
+         *result = value / 1000;
+         break;
+      case LP_QUERY_RAST_TILES:
+      case LP_QUERY_RAST_FRAGMENTS_SHADED:
+      case LP_QUERY_RAST_FRAGMENTS_REJECTED:
+         *result = value;
+         break;
+      default:
+         /* thread busy percentage */
+         *result = pq->end_time > pq->start_time ?
+                   MIN2(value * 100 / (pq->end_time - pq->start_time), 100) : 0;
+         break;
+      }
+      return TRUE;
+   }
+
    if (pq->fence) {
       /* only have a fence if there was a scene */
       if (!lp_fence_signalled(pq->fence)) {
@@ -168,11 +302,11 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
       struct pipe_query_data_pipeline_statistics *stats =
          (struct pipe_query_data_pipeline_statistics *)vresult;
       /* only ps_invocations come from binned query */
+      *stats = pq->stats;
       for (i = 0; i < num_threads; i++) {
-         pq->stats.ps_invocations += pq->end[i];
+         stats->ps_invocations += pq->end[i];
       }
-      pq->stats.ps_invocations *= LP_RASTER_BLOCK_SIZE * LP_RASTER_BLOCK_SIZE;
-      *stats = pq->stats;
+      stats->ps_invocations *= LP_RASTER_BLOCK_SIZE * LP_RASTER_BLOCK_SIZE;
    }
       break;
    default:
@@ -184,12 +318,92 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
 }
 
 
+/**
+ * Store the result of a query into a buffer.  Without wait, nothing is
+ * stored if the result isn't available yet, except for the availability
+ * itself (index -1).
+ */
+static void
+llvmpipe_get_query_result_resource(struct pipe_context *pipe,
+                                   struct pipe_query *q,
+                                   boolean wait,
+                                   enum pipe_query_value_type result_type,
+                                   int index,
+                                   struct pipe_resource *resource,
+                                   unsigned offset)
+{
+   struct llvmpipe_query *pq = llvmpipe_query(q);
+   uint8_t *dst = (uint8_t *) llvmpipe_resource_data(resource) + offset;
+   union pipe_query_result result;
+   boolean ready;
+   uint64_t value;
+
+   ready = llvmpipe_get_query_result(pipe, q, wait, &result);
+
+   if (index == -1) {
+      value = ready;
+   } else if (!ready) {
+      return;
+   } else {
+      switch (pq->type) {
+      case PIPE_QUERY_OCCLUSION_PREDICATE:
+      case PIPE_QUERY_SO_OVERFLOW_PREDICATE:
+      case PIPE_QUERY_GPU_FINISHED:
+         value = result.b;
+         break;
+      case PIPE_QUERY_SO_STATISTICS:
+         value = index == 0 ? result.so_statistics.num_primitives_written :
+                              result.so_statistics.primitives_storage_needed;
+         break;
+      case PIPE_QUERY_PIPELINE_STATISTICS:
+         assert(index < sizeof(result.pipeline_statistics) / sizeof(uint64_t));
+         value = ((uint64_t *) &result.pipeline_statistics)[index];
+         break;
+      default:
+         value = result.u64;
+         break;
+      }
+   }
+
+   llvmpipe_flush_resource(pipe, resource, 0, FALSE, TRUE, FALSE,
+                           __FUNCTION__);
+
+   switch (result_type) {
+   case PIPE_QUERY_TYPE_I32: {
+      int32_t v = MIN2(value, INT32_MAX);
+      memcpy(dst, &v, sizeof(v));
+      break;
+   }
+   case PIPE_QUERY_TYPE_U32: {
+      uint32_t v = MIN2(value, UINT32_MAX);
+      memcpy(dst, &v, sizeof(v));
+      break;
+   }
+   case PIPE_QUERY_TYPE_I64: {
+      int64_t v = MIN2(value, INT64_MAX);
+      memcpy(dst, &v, sizeof(v));
+      break;
+   }
+   case PIPE_QUERY_TYPE_U64:
+      memcpy(dst, &value, sizeof(value));
+      break;
+   }
+}
+
+
 static boolean
 llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
 {
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
+   if (is_driver_query(pq->type)) {
+      pq->start[0] = get_driver_query_value(llvmpipe_screen(pipe->screen),
+                                            pq->type);
+      pq->start_time = os_time_get_nano();
+      return true;
+   }
+
    /* Check if the query is already in the scene.  If so, we need to
     * flush the scene now.  Real apps shouldn't re-use a query in a
     * frame of rendering.
@@ -245,6 +459,13 @@ llvmpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
+   if (is_driver_query(pq->type)) {
+      pq->end[0] = get_driver_query_value(llvmpipe_screen(pipe->screen),
+                                          pq->type);
+      pq->end_time = os_time_get_nano();
+      return;
+   }
+
    lp_setup_end_query(llvmpipe->setup, pq);
 
    switch (pq->type) {
@@ -327,6 +548,20 @@ void llvmpipe_init_query_funcs(struct llvmpipe_context *llvmpipe )
    llvmpipe->pipe.begin_query = llvmpipe_begin_query;
    llvmpipe->pipe.end_query = llvmpipe_end_query;
    llvmpipe->pipe.get_query_result = llvmpipe_get_query_result;
+   llvmpipe->pipe.get_query_result_resource = llvmpipe_get_query_result_resource;
 }
 
 
+
+void llvmpipe_init_screen_query_funcs(struct llvmpipe_screen *screen)
+{
+   unsigned i;
+
+   for (i = 0; i < lp_rast_get_num_tasks(screen->rast); i++) {
+      util_snprintf(screen->thread_query_names[i],
+                    sizeof screen->thread_query_names[i],
+                    "rast-thread%u-busy", i);
+   }
+
+   screen->base.get_driver_query_info = llvmpipe_get_driver_query_info;
+}
@@ -39,6 +39,21 @@
 
 
 struct llvmpipe_context;
+struct llvmpipe_screen;
+
+
+/**
+ * Driver queries, see llvmpipe_get_driver_query_info().  They read the
+ * rasterizer threads' counters when begun and ended, so they count all
+ * the rasterization done meanwhile, by any context.
+ */
+#define LP_QUERY_RAST_TILES              (PIPE_QUERY_DRIVER_SPECIFIC + 0)
+#define LP_QUERY_RAST_FRAGMENTS_SHADED   (PIPE_QUERY_DRIVER_SPECIFIC + 1)
+#define LP_QUERY_RAST_FRAGMENTS_REJECTED (PIPE_QUERY_DRIVER_SPECIFIC + 2)
+#define LP_QUERY_RAST_SHADE_TILE_TIME    (PIPE_QUERY_DRIVER_SPECIFIC + 3)
+#define LP_QUERY_RAST_IDLE_TIME          (PIPE_QUERY_DRIVER_SPECIFIC + 4)
+/** Percentage of the time thread i was busy, one query per thread */
+#define LP_QUERY_RAST_THREAD_BUSY        (PIPE_QUERY_DRIVER_SPECIFIC + 5)
 
 
 struct llvmpipe_query {
@@ -50,11 +65,17 @@ struct llvmpipe_query {
    unsigned num_primitives_written;
 
    struct pipe_query_data_pipeline_statistics stats;
+
+   /* driver queries: when begun and ended, in nanoseconds */
+   int64_t start_time;
+   int64_t end_time;
 };
 
 
 extern void llvmpipe_init_query_funcs(struct llvmpipe_context * );
 
+extern void llvmpipe_init_screen_query_funcs(struct llvmpipe_screen *);
+
 extern boolean llvmpipe_check_render_cond(struct llvmpipe_context *);
 
 #endif /* LP_QUERY_H */
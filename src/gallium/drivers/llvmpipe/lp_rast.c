@@ -69,15 +69,18 @@ lp_rast_begin( struct lp_rasterizer *rast,
    LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
 
    lp_scene_begin_rasterization( scene );
-   lp_scene_bin_iter_begin( scene );
+   lp_scene_bin_iter_begin( scene, MAX2(1, rast->num_threads) );
 }
 
 
+/**
+ * The scene itself is retired by the setup code once its fence has been
+ * signalled, so that binning of the next scenes can overlap with
+ * rasterization.
+ */
 static void
 lp_rast_end( struct lp_rasterizer *rast )
 {
-   lp_scene_end_rasterization( rast->curr_scene );
-
    rast->curr_scene = NULL;
 }
 
@@ -107,6 +110,7 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
 
    task->thread_data.vis_counter = 0;
    task->ps_invocations = 0;
+   task->zmax = FLT_MAX;
 
    for (i = 0; i < task->scene->fb.nr_cbufs; i++) {
       if (task->scene->fb.cbufs[i]) {
@@ -169,6 +173,40 @@ lp_rast_clear_color(struct lp_rasterizer_task *task,
 }
 
 
+/**
+ * Return the depth value in a packed z/stencil clear value, or FLT_MAX if
+ * the clear doesn't set the depth of every pixel.
+ */
+static float
+lp_rast_clear_zmax(enum pipe_format format, uint64_t value, uint64_t mask)
+{
+   union fi fui;
+
+   if ((mask & util_pack64_mask_z(format, ~0)) !=
+       util_pack64_mask_z(format, ~0))
+      return FLT_MAX;
+
+   switch (format) {
+   case PIPE_FORMAT_Z16_UNORM:
+      return (float)(value & 0xffff) / 65535.0f;
+   case PIPE_FORMAT_Z32_UNORM:
+      return (float)((double)(uint32_t)value / 4294967295.0);
+   case PIPE_FORMAT_Z32_FLOAT:
+   case PIPE_FORMAT_Z32_FLOAT_S8X24_UINT:
+      fui.ui = (uint32_t)value;
+      return fui.f;
+   case PIPE_FORMAT_Z24_UNORM_S8_UINT:
+   case PIPE_FORMAT_Z24X8_UNORM:
+      return (float)(value & 0xffffff) / 16777215.0f;
+   case PIPE_FORMAT_S8_UINT_Z24_UNORM:
+   case PIPE_FORMAT_X8Z24_UNORM:
+      return (float)((value >> 8) & 0xffffff) / 16777215.0f;
+   default:
+      return FLT_MAX;
+   }
+}
+
+
 /**
  * Clear the rasterizer's current z/stencil tile.
  * This is a bin command called during bin processing.
@@ -280,6 +318,11 @@ lp_rast_clear_zstencil(struct lp_rasterizer_task *task,
          }
          dst_layer += scene->zsbuf.layer_stride;
       }
+
+      task->zmax = lp_rast_clear_zmax(scene->fb.zsbuf->format,
+                                      clear_value64, clear_mask64);
+      if (task->state && task->state->variant->zmax_invalidate)
+         task->zmax = FLT_MAX;
    }
 }
 
@@ -300,6 +343,7 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
    struct lp_fragment_shader_variant *variant;
    const unsigned tile_x = task->x, tile_y = task->y;
    unsigned x, y;
+   int64_t start;
 
    if (inputs->disable) {
       /* This command was partially binned and has been disabled */
@@ -315,6 +359,15 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
    }
    variant = state->variant;
 
+   if (lp_rast_depth_reject(task, inputs, tile_x, tile_y, TILE_SIZE)) {
+      LP_COUNT(nr_depth_rejected_64);
+      task->counters.blocks_rejected += (TILE_SIZE / 4) * (TILE_SIZE / 4);
+      return;
+   }
+
+   start = os_time_get_nano();
+   task->counters.blocks_shaded += (task->width / 4) * (task->height / 4);
+
    /* render the whole 64x64 tile in 4x4 chunks */
    for (y = 0; y < task->height; y += 4){
       for (x = 0; x < task->width; x += 4) {
@@ -364,6 +417,8 @@ lp_rast_shade_tile(struct lp_rasterizer_task *task,
          END_JIT_CALL();
       }
    }
+
+   task->counters.shade_tile_time += os_time_get_nano() - start;
 }
 
 
@@ -448,6 +503,7 @@ lp_rast_shade_quads_mask(struct lp_rasterizer_task *task,
       /* not very accurate would need a popcount on the mask */
       /* always count this not worth bothering? */
       task->ps_invocations += 1 * variant->ps_inv_multiplier;
+      task->counters.blocks_shaded++;
 
       /* Propagate non-interpolated raster state. */
       task->thread_data.raster_state.viewport_index = inputs->viewport_index;
@@ -536,6 +592,9 @@ lp_rast_set_state(struct lp_rasterizer_task *task,
                   const union lp_rast_cmd_arg arg)
 {
    task->state = arg.state;
+
+   if (task->state->variant->zmax_invalidate)
+      task->zmax = FLT_MAX;
 }
 
 
@@ -623,6 +682,8 @@ static void
 rasterize_bin(struct lp_rasterizer_task *task,
               const struct cmd_bin *bin, int x, int y )
 {
+   task->counters.tiles++;
+
    lp_rast_tile_begin( task, bin, x, y );
 
    do_rasterize_bin(task, bin, x, y);
@@ -663,6 +724,8 @@ static void
 rasterize_scene(struct lp_rasterizer_task *task,
                 struct lp_scene *scene)
 {
+   int64_t start = os_time_get_nano();
+
    task->scene = scene;
 
    /* Clear the cache tags. This should not always be necessary but
@@ -683,7 +746,8 @@ rasterize_scene(struct lp_rasterizer_task *task,
          int i, j;
 
          assert(scene);
-         while ((bin = lp_scene_bin_iter_next(scene, &i, &j))) {
+         while ((bin = lp_scene_bin_iter_next(scene, task->thread_index,
+                                              &i, &j))) {
             if (!is_empty_bin( bin ))
                rasterize_bin(task, bin, i, j);
          }
@@ -693,18 +757,15 @@ rasterize_scene(struct lp_rasterizer_task *task,
 
 #if LP_BUILD_FORMAT_CACHE_DEBUG
    {
-      uint64_t total, miss;
-      total = task->thread_data.cache->cache_access_total;
-      miss = task->thread_data.cache->cache_access_miss;
-      if (total) {
-         debug_printf("thread %d cache access %llu miss %llu hit rate %f\n",
-                 task->thread_index, (long long unsigned)total,
-                 (long long unsigned)miss,
-                 (float)(total - miss)/(float)total);
-      }
+      LP_COUNT_ADD(nr_texture_cache_access,
+                   task->thread_data.cache->cache_access_total);
+      LP_COUNT_ADD(nr_texture_cache_miss,
+                   task->thread_data.cache->cache_access_miss);
    }
 #endif
 
+   task->counters.busy_time += os_time_get_nano() - start;
+
    if (scene->fence) {
       lp_fence_signal(scene->fence);
    }
@@ -746,6 +807,7 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
       unsigned i;
 
       lp_scene_enqueue( rast->full_scenes, scene );
+      rast->num_work++;
 
       /* signal the threads that there's work to do */
       for (i = 0; i < rast->num_threads; i++) {
@@ -757,23 +819,86 @@ lp_rast_queue_scene( struct lp_rasterizer *rast,
 }
 
 
+/**
+ * Run \p func on all the rasterizer threads, after the scenes queued so
+ * far, and wait for it to return on all of them.
+ *
+ * Like lp_rast_queue_scene(), the caller must hold the screen's rast_mutex,
+ * which also keeps other scenes from being queued until the job is done.
+ */
 void
-lp_rast_finish( struct lp_rasterizer *rast )
+lp_rast_run_job(struct lp_rasterizer *rast,
+                lp_rast_job_func func,
+                void *data)
 {
    if (rast->num_threads == 0) {
-      /* nothing to do */
+      unsigned fpstate = util_fpstate_get();
+
+      util_fpstate_set_denorms_to_zero(fpstate);
+      func(data, 0);
+      util_fpstate_set(fpstate);
    }
    else {
-      int i;
+      unsigned i;
+
+      /* Threads tell the job from the scenes queued before it by counting
+       * how many times they were woken up.
+       */
+      rast->job_func = func;
+      rast->job_data = data;
+      rast->job_index = rast->num_work++;
 
-      /* wait for work to complete */
       for (i = 0; i < rast->num_threads; i++) {
-         pipe_semaphore_wait(&rast->tasks[i].work_done);
+         pipe_semaphore_signal(&rast->tasks[i].work_ready);
       }
+
+      pipe_semaphore_wait(&rast->job_done);
+      rast->job_func = NULL;
+      rast->job_data = NULL;
    }
 }
 
 
+/**
+ * Number of tasks with counters, which is one even when rendering without
+ * threads.
+ */
+unsigned
+lp_rast_get_num_tasks(const struct lp_rasterizer *rast)
+{
+   return MAX2(1, rast->num_threads);
+}
+
+
+/**
+ * Get the counters of a rasterizer task.  While the thread is running,
+ * they can be a little behind, or on 32-bit hosts torn, so they're only
+ * good for profiling.
+ */
+void
+lp_rast_get_counters(const struct lp_rasterizer *rast,
+                     unsigned thread_index,
+                     struct lp_rast_counters *counters)
+{
+   assert(thread_index < lp_rast_get_num_tasks(rast));
+   *counters = rast->tasks[thread_index].counters;
+}
+
+
+/**
+ * Wait for the other threads, counting it as idle time.
+ */
+static void
+rast_barrier_wait(struct lp_rasterizer_task *task)
+{
+   int64_t start = os_time_get_nano();
+
+   pipe_barrier_wait( &task->rast->barrier );
+
+   task->counters.idle_time += os_time_get_nano() - start;
+}
+
+
 /**
  * This is the thread's main entrypoint.
  * It's a simple loop:
@@ -799,14 +924,34 @@ static PIPE_THREAD_ROUTINE( thread_function, init_data )
    util_fpstate_set_denorms_to_zero(fpstate);
 
    while (1) {
+      unsigned work;
+      int64_t start;
+
       /* wait for work */
       if (debug)
          debug_printf("thread %d waiting for work\n", task->thread_index);
+      start = os_time_get_nano();
       pipe_semaphore_wait(&task->work_ready);
+      task->counters.idle_time += os_time_get_nano() - start;
 
       if (rast->exit_flag)
          break;
 
+      work = task->num_work++;
+      if (rast->job_func && work == rast->job_index) {
+         start = os_time_get_nano();
+         rast->job_func(rast->job_data, task->thread_index);
+         task->counters.busy_time += os_time_get_nano() - start;
+
+         /* wait for all threads to finish with this job */
+         rast_barrier_wait(task);
+
+         if (task->thread_index == 0) {
+            pipe_semaphore_signal(&rast->job_done);
+         }
+         continue;
+      }
+
       if (task->thread_index == 0) {
          /* thread[0]:
           *  - get next scene to rasterize
@@ -819,7 +964,7 @@ static PIPE_THREAD_ROUTINE( thread_function, init_data )
       /* Wait for all threads to get here so that threads[1+] don't
        * get a null rast->curr_scene pointer.
        */
-      pipe_barrier_wait( &rast->barrier );
+      rast_barrier_wait(task);
 
       /* do work */
       if (debug)
@@ -829,19 +974,17 @@ static PIPE_THREAD_ROUTINE( thread_function, init_data )
                       rast->curr_scene);
       
       /* wait for all threads to finish with this scene */
-      pipe_barrier_wait( &rast->barrier );
+      rast_barrier_wait(task);
 
-      /* XXX: shouldn't be necessary:
-       */
       if (task->thread_index == 0) {
          lp_rast_end( rast );
       }
 
-      /* signal done with work */
+      /* Nobody waits for individual scenes here; completion is tracked
+       * by the scene fences.
+       */
       if (debug)
          debug_printf("thread %d done working\n", task->thread_index);
-
-      pipe_semaphore_signal(&task->work_done);
    }
 
 #ifdef _WIN32
@@ -911,6 +1054,7 @@ lp_rast_create( unsigned num_threads )
 
    /* for synchronizing rasterization threads */
    pipe_barrier_init( &rast->barrier, rast->num_threads );
+   pipe_semaphore_init( &rast->job_done, 0 );
 
    memset(lp_dummy_tile, 0, sizeof lp_dummy_tile);
 
@@ -968,6 +1112,7 @@ void lp_rast_destroy( struct lp_rasterizer *rast )
 
    /* for synchronizing rasterization threads */
    pipe_barrier_destroy( &rast->barrier );
+   pipe_semaphore_destroy( &rast->job_done );
 
    lp_scene_queue_destroy(rast->full_scenes);
 
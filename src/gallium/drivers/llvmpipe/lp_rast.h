@@ -137,6 +137,20 @@ struct lp_rast_triangle {
 };
 
 
+/**
+ * Counters of the work done by a rasterizer thread.  They're always kept,
+ * and only ever go up, see lp_rast_get_counters().
+ */
+struct lp_rast_counters {
+   uint64_t tiles;            /**< tiles rasterized */
+   uint64_t blocks_shaded;    /**< 4x4 blocks the shader was run on */
+   uint64_t blocks_rejected;  /**< 4x4 blocks rejected by depth before shading */
+   uint64_t shade_tile_time;  /**< nanoseconds spent in lp_rast_shade_tile() */
+   uint64_t busy_time;        /**< nanoseconds spent rasterizing scenes */
+   uint64_t idle_time;        /**< nanoseconds spent waiting for work */
+};
+
+
 struct lp_rast_clear_rb {
    union util_color color_val;
    unsigned cbuf;
@@ -160,8 +174,24 @@ void
 lp_rast_queue_scene( struct lp_rasterizer *rast,
                      struct lp_scene *scene );
 
+/**
+ * Function run on each rasterizer thread by lp_rast_run_job().
+ * \param thread_index  index of the thread, less than the number of threads
+ */
+typedef void (*lp_rast_job_func)(void *data, unsigned thread_index);
+
+void
+lp_rast_run_job(struct lp_rasterizer *rast,
+                lp_rast_job_func func,
+                void *data);
+
+unsigned
+lp_rast_get_num_tasks(const struct lp_rasterizer *rast);
+
 void
-lp_rast_finish( struct lp_rasterizer *rast );
+lp_rast_get_counters(const struct lp_rasterizer *rast,
+                     unsigned thread_index,
+                     struct lp_rast_counters *counters);
 
 
 union lp_rast_cmd_arg {
@@ -30,6 +30,7 @@
 
 #include "os/os_thread.h"
 #include "util/u_format.h"
+#include "util/u_math.h"
 #include "gallivm/lp_bld_debug.h"
 #include "lp_memory.h"
 #include "lp_rast.h"
@@ -91,6 +92,12 @@ struct lp_rasterizer_task
    uint8_t *color_tiles[PIPE_MAX_COLOR_BUFS];
    uint8_t *depth_tile;
 
+   /**
+    * Upper bound of the depth values in the current tile, or FLT_MAX when
+    * not known.  Set by depth clears, see lp_rast_depth_reject().
+    */
+   float zmax;
+
    /** "back" pointer */
    struct lp_rasterizer *rast;
 
@@ -102,6 +109,12 @@ struct lp_rasterizer_task
    uint64_t ps_invocations;
    uint8_t ps_inv_multiplier;
 
+   /** Only written by this task's thread */
+   struct lp_rast_counters counters;
+
+   /** Number of times this thread was woken up, see lp_rast_run_job() */
+   unsigned num_work;
+
    pipe_semaphore work_ready;
    pipe_semaphore work_done;
 };
@@ -131,6 +144,15 @@ struct lp_rasterizer
 
    /** For synchronizing the rasterization threads */
    pipe_barrier barrier;
+
+   /** Number of times the threads were woken up */
+   unsigned num_work;
+
+   /** Job run by all threads instead of a scene, see lp_rast_run_job() */
+   lp_rast_job_func job_func;
+   void *job_data;
+   unsigned job_index;
+   pipe_semaphore job_done;
 };
 
 
@@ -217,6 +239,45 @@ lp_rast_get_depth_block_pointer(struct lp_rasterizer_task *task,
 
 
 
+/**
+ * Check whether all fragments of a triangle in the \p size x \p size block
+ * at \p x, \p y are behind the depth values in the tile and so fail a
+ * LESS or LEQUAL depth test.
+ *
+ * The fragment shader interpolates z linearly from the position coefficients
+ * (and clamps it to 1.0), so its minimum over the block is at one of the
+ * corners.  The margin covers the interpolation rounding and the conversion
+ * to the depth buffer format.
+ * \param x, y location of the block in window coords
+ */
+static inline boolean
+lp_rast_depth_reject(const struct lp_rasterizer_task *task,
+                     const struct lp_rast_shader_inputs *inputs,
+                     int x, int y, unsigned size)
+{
+   float a0, dzdx, dzdy, zmin, margin;
+
+   if (task->zmax == FLT_MAX || !task->state->variant->zmax_test)
+      return FALSE;
+
+   a0 = GET_A0(inputs)[0][2];
+   dzdx = GET_DADX(inputs)[0][2];
+   dzdy = GET_DADY(inputs)[0][2];
+
+   zmin = a0 +
+          dzdx * (float)(dzdx < 0.0f ? x + (int)size : x) +
+          dzdy * (float)(dzdy < 0.0f ? y + (int)size : y);
+   zmin = MIN2(zmin, 1.0f);
+
+   margin = (fabsf(a0) +
+             fabsf(dzdx) * (float)(x + (int)size) +
+             fabsf(dzdy) * (float)(y + (int)size)) * (1.0f / (1 << 20)) +
+            1.0f / (1 << 15);
+
+   return zmin > task->zmax + margin;
+}
+
+
 /**
  * Shade all pixels in a 4x4 block.  The fragment code omits the
  * triangle in/out tests.
@@ -262,6 +323,7 @@ lp_rast_shade_quads_all( struct lp_rasterizer_task *task,
       /* not very accurate would need a popcount on the mask */
       /* always count this not worth bothering? */
       task->ps_invocations += 1 * variant->ps_inv_multiplier;
+      task->counters.blocks_shaded++;
 
       /* Propagate non-interpolated raster state. */
       task->thread_data.raster_state.viewport_index = inputs->viewport_index;
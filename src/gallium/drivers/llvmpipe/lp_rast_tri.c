@@ -58,6 +58,13 @@ block_full_16(struct lp_rasterizer_task *task,
    unsigned ix, iy;
    assert(x % 16 == 0);
    assert(y % 16 == 0);
+
+   if (lp_rast_depth_reject(task, &tri->inputs, x, y, 16)) {
+      LP_COUNT(nr_depth_rejected_16);
+      task->counters.blocks_rejected += 16;
+      return;
+   }
+
    for (iy = 0; iy < 16; iy += 4)
       for (ix = 0; ix < 16; ix += 4)
 	 block_full_4(task, tri, x + ix, y + iy);
@@ -301,6 +308,12 @@ lp_rast_triangle_32_3_16(struct lp_rasterizer_task *task,
    __m128i span_1;                /* 0,dcdx,2dcdx,3dcdx for plane 1 */
    __m128i span_2;                /* 0,dcdx,2dcdx,3dcdx for plane 2 */
    __m128i unused;
+
+   if (lp_rast_depth_reject(task, &tri->inputs, x, y, 16)) {
+      LP_COUNT(nr_depth_rejected_16);
+      task->counters.blocks_rejected += 16;
+      return;
+   }
    
    transpose4_epi32(&p0, &p1, &p2, &zero,
                     &c, &dcdx, &dcdy, &rej4);
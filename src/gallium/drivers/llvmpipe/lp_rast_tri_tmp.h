@@ -75,6 +75,12 @@ TAG(do_block_16)(struct lp_rasterizer_task *task,
    unsigned outmask, inmask, partmask, partial_mask;
    unsigned j;
 
+   if (lp_rast_depth_reject(task, &tri->inputs, x, y, 16)) {
+      LP_COUNT(nr_depth_rejected_16);
+      task->counters.blocks_rejected += 16;
+      return;
+   }
+
    outmask = 0;                 /* outside one or more trivial reject planes */
    partmask = 0;                /* outside one or more trivial accept planes */
 
@@ -169,6 +175,12 @@ TAG(lp_rast_triangle)(struct lp_rasterizer_task *task,
       return;
    }
 
+   if (lp_rast_depth_reject(task, &tri->inputs, x, y, TILE_SIZE)) {
+      LP_COUNT(nr_depth_rejected_64);
+      task->counters.blocks_rejected += (TILE_SIZE / 4) * (TILE_SIZE / 4);
+      return;
+   }
+
    outmask = 0;                 /* outside one or more trivial reject planes */
    partmask = 0;                /* outside one or more trivial accept planes */
 
@@ -272,6 +284,12 @@ TRI_16(struct lp_rasterizer_task *task,
    x += task->x;
    y += task->y;
 
+   if (lp_rast_depth_reject(task, &tri->inputs, x, y, 16)) {
+      LP_COUNT(nr_depth_rejected_16);
+      task->counters.blocks_rejected += 16;
+      return;
+   }
+
    for (j = 0; j < NR_PLANES; j++) {
       const int dcdx = -plane[j].dcdx * 4;
       const int dcdy = plane[j].dcdy * 4;
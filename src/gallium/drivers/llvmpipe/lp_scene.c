@@ -34,6 +34,7 @@
 #include "lp_scene.h"
 #include "lp_fence.h"
 #include "lp_debug.h"
+#include "lp_screen.h"
 
 
 #define RESOURCE_REF_SZ 32
@@ -46,6 +47,97 @@ struct resource_ref {
 };
 
 
+/**
+ * Data blocks released by scenes, shared by all the contexts of a screen,
+ * so that binning heavy scenes doesn't malloc and free them all the time.
+ */
+struct lp_block_pool {
+   pipe_mutex mutex;
+   struct data_block *head;
+   unsigned num_blocks;
+
+   /* Statistics, printed with LP_DEBUG=scene */
+   unsigned num_allocated;
+   unsigned num_reused;
+};
+
+
+struct lp_block_pool *
+lp_block_pool_create(void)
+{
+   struct lp_block_pool *pool = CALLOC_STRUCT(lp_block_pool);
+   if (!pool)
+      return NULL;
+
+   pipe_mutex_init(pool->mutex);
+   return pool;
+}
+
+
+void
+lp_block_pool_destroy(struct lp_block_pool *pool)
+{
+   struct data_block *block, *next;
+
+   for (block = pool->head; block; block = next) {
+      next = block->next;
+      FREE(block);
+   }
+
+   pipe_mutex_destroy(pool->mutex);
+   FREE(pool);
+}
+
+
+static struct data_block *
+lp_block_pool_get(struct lp_block_pool *pool)
+{
+   struct data_block *block;
+
+   pipe_mutex_lock(pool->mutex);
+   block = pool->head;
+   if (block) {
+      pool->head = block->next;
+      pool->num_blocks--;
+      pool->num_reused++;
+   }
+   else {
+      pool->num_allocated++;
+   }
+   pipe_mutex_unlock(pool->mutex);
+
+   if (!block)
+      block = MALLOC_STRUCT(data_block);
+
+   return block;
+}
+
+
+/**
+ * Give a list of blocks back to the pool.  What doesn't fit is freed.
+ */
+static void
+lp_block_pool_put(struct lp_block_pool *pool, struct data_block *list)
+{
+   struct data_block *next;
+
+   pipe_mutex_lock(pool->mutex);
+   while (list && pool->num_blocks < LP_BLOCK_POOL_MAX_BLOCKS) {
+      next = list->next;
+      list->next = pool->head;
+      pool->head = list;
+      pool->num_blocks++;
+      list = next;
+   }
+   pipe_mutex_unlock(pool->mutex);
+
+   for (; list; list = next) {
+      next = list->next;
+      FREE(list);
+   }
+}
+
+
 /**
  * Create a new scene object.
  * \param queue  the queue to put newly rendered/emptied scenes into
@@ -54,15 +146,21 @@ struct lp_scene *
 lp_scene_create( struct pipe_context *pipe )
 {
    struct lp_scene *scene = CALLOC_STRUCT(lp_scene);
+   unsigned i;
+
    if (!scene)
       return NULL;
 
    scene->pipe = pipe;
+   scene->block_pool = llvmpipe_screen(pipe->screen)->block_pool;
+   scene->max_size = LP_SCENE_MAX_SIZE;
 
    scene->data.head =
       CALLOC_STRUCT(data_block);
 
-   pipe_mutex_init(scene->mutex);
+   for (i = 0; i < Elements(scene->bin_ranges); i++) {
+      pipe_mutex_init(scene->bin_ranges[i].mutex);
+   }
 
 #ifdef DEBUG
    /* Do some scene limit sanity checks here */
@@ -89,8 +187,12 @@ lp_scene_create( struct pipe_context *pipe )
 void
 lp_scene_destroy(struct lp_scene *scene)
 {
+   unsigned i;
+
    lp_fence_reference(&scene->fence, NULL);
-   pipe_mutex_destroy(scene->mutex);
+   for (i = 0; i < Elements(scene->bin_ranges); i++) {
+      pipe_mutex_destroy(scene->bin_ranges[i].mutex);
+   }
    assert(scene->data.head->next == NULL);
    FREE(scene->data.head);
    FREE(scene);
@@ -235,6 +337,7 @@ lp_scene_end_rasterization(struct lp_scene *scene )
 
    /* Reset all command lists:
     */
+   memset(scene->super_tile_mask, 0, sizeof(scene->super_tile_mask));
    for (i = 0; i < scene->tiles_x; i++) {
       for (j = 0; j < scene->tiles_y; j++) {
          struct cmd_bin *bin = lp_scene_get_bin(scene, i, j);
@@ -274,16 +377,12 @@ lp_scene_end_rasterization(struct lp_scene *scene )
                       j, scene->resource_reference_size);
    }
 
-   /* Free all scene data blocks:
+   /* Give all scene data blocks but the current one back to the pool:
     */
    {
       struct data_block_list *list = &scene->data;
-      struct data_block *block, *tmp;
 
-      for (block = list->head->next; block; block = tmp) {
-         tmp = block->next;
-	 FREE(block);
-      }
+      lp_block_pool_put(scene->block_pool, list->head->next);
 
       list->head->next = NULL;
       list->head->used = 0;
@@ -330,13 +429,13 @@ lp_scene_new_cmd_block( struct lp_scene *scene,
 struct data_block *
 lp_scene_new_data_block( struct lp_scene *scene )
 {
-   if (scene->scene_size + DATA_BLOCK_SIZE > LP_SCENE_MAX_SIZE) {
+   if (scene->scene_size + DATA_BLOCK_SIZE > scene->max_size) {
       if (0) debug_printf("%s: failed\n", __FUNCTION__);
       scene->alloc_failed = TRUE;
       return NULL;
    }
    else {
-      struct data_block *block = MALLOC_STRUCT(data_block);
+      struct data_block *block = lp_block_pool_get(scene->block_pool);
       if (!block)
          return NULL;
       
@@ -449,61 +548,109 @@ lp_scene_is_resource_referenced(const struct lp_scene *scene,
 
 
 
-/** advance curr_x,y to the next bin */
-static boolean
-next_bin(struct lp_scene *scene)
+/**
+ * Prepare for iterating over the bins with \p num_threads threads.
+ *
+ * Only bins with commands are iterated over; the super-tile masks let
+ * empty parts of the framebuffer be skipped 16 tiles at a time.  The bins
+ * are split into one contiguous band of rows per thread, so
+ * that each thread mostly works on neighbouring tiles, which share
+ * framebuffer cache lines and, with threads spread in order over the
+ * CPUs, the thread's caches and memory node.
+ */
+void
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_threads )
 {
-   scene->curr_x++;
-   if (scene->curr_x >= scene->tiles_x) {
-      scene->curr_x = 0;
-      scene->curr_y++;
+   unsigned super_tiles_x =
+      (scene->tiles_x + SUPER_TILE_SIZE - 1) >> SUPER_TILE_ORDER;
+   unsigned num_bins = 0;
+   unsigned i, x, y;
+
+   for (y = 0; y < scene->tiles_y; y++) {
+      const uint16_t *masks = scene->super_tile_mask[y >> SUPER_TILE_ORDER];
+      unsigned shift = (y & (SUPER_TILE_SIZE - 1)) * SUPER_TILE_SIZE;
+
+      for (i = 0; i < super_tiles_x; i++) {
+         unsigned row = (masks[i] >> shift) & ((1 << SUPER_TILE_SIZE) - 1);
+
+         while (row) {
+            x = (i << SUPER_TILE_ORDER) + u_bit_scan(&row);
+            scene->active_bins[num_bins++] = y * scene->tiles_x + x;
+         }
+      }
    }
-   if (scene->curr_y >= scene->tiles_y) {
-      /* no more bins */
-      return FALSE;
+
+   assert(num_threads >= 1 && num_threads <= Elements(scene->bin_ranges));
+
+   scene->num_bin_ranges = num_threads;
+   for (i = 0; i < num_threads; i++) {
+      scene->bin_ranges[i].next = num_bins * i / num_threads;
+      scene->bin_ranges[i].end = num_bins * (i + 1) / num_threads;
    }
-   return TRUE;
 }
 
 
-void
-lp_scene_bin_iter_begin( struct lp_scene *scene )
+/**
+ * Take a bin from the range: from its front for the owning thread,
+ * from its back for other threads.
+ */
+static boolean
+take_bin(struct lp_bin_range *range, boolean steal, int *bin)
 {
-   scene->curr_x = scene->curr_y = -1;
+   boolean found = FALSE;
+
+   /* Unlocked check to skip exhausted ranges cheaply. */
+   if (range->next >= range->end)
+      return FALSE;
+
+   pipe_mutex_lock(range->mutex);
+   if (range->next < range->end) {
+      *bin = steal ? --range->end : range->next++;
+      found = TRUE;
+   }
+   pipe_mutex_unlock(range->mutex);
+
+   return found;
 }
 
 
 /**
  * Return pointer to next bin to be rendered.
- * The lp_scene::curr_x and ::curr_y fields will be advanced.
  * Multiple rendering threads will call this function to get a chunk
  * of work (a bin) to work on.
+ *
+ * A thread first takes the bins of its own range. Once that's exhausted,
+ * it steals bins from the other ranges, trying the neighbouring ones
+ * first.
  */
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene , int *x, int *y)
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned thread_index,
+                        int *x, int *y )
 {
-   struct cmd_bin *bin = NULL;
-
-   pipe_mutex_lock(scene->mutex);
-
-   if (scene->curr_x < 0) {
-      /* first bin */
-      scene->curr_x = 0;
-      scene->curr_y = 0;
-   }
-   else if (!next_bin(scene)) {
-      /* no more bins left */
-      goto end;
+   unsigned n = scene->num_bin_ranges;
+   unsigned own = thread_index % n;
+   unsigned i;
+   int index, bin;
+
+   if (!take_bin(&scene->bin_ranges[own], FALSE, &index)) {
+      /* Visit the other ranges at offsets +1, -1, +2, -2, ... */
+      for (i = 1; i < n; i++) {
+         unsigned offset = (i & 1) ? (i + 1) / 2 : n - i / 2;
+
+         if (take_bin(&scene->bin_ranges[(own + offset) % n], TRUE, &index))
+            break;
+      }
+      if (i == n) {
+         /* no more bins left */
+         return NULL;
+      }
    }
 
-   bin = lp_scene_get_bin(scene, scene->curr_x, scene->curr_y);
-   *x = scene->curr_x;
-   *y = scene->curr_y;
+   bin = scene->active_bins[index];
+   *x = bin % scene->tiles_x;
+   *y = bin / scene->tiles_x;
 
-end:
-   /*printf("return bin %p at %d, %d\n", (void *) bin, *bin_x, *bin_y);*/
-   pipe_mutex_unlock(scene->mutex);
-   return bin;
+   return lp_scene_get_bin(scene, *x, *y);
 }
 
 
@@ -557,6 +704,14 @@ void lp_scene_end_binning( struct lp_scene *scene )
                    scene->scene_size);
       debug_printf("  data size: %u\n",
                    lp_scene_data_size(scene));
+      debug_printf("  max size: %u\n",
+                   scene->max_size);
+      pipe_mutex_lock(scene->block_pool->mutex);
+      debug_printf("  block pool: %u free, %u reused, %u allocated\n",
+                   scene->block_pool->num_blocks,
+                   scene->block_pool->num_reused,
+                   scene->block_pool->num_allocated);
+      pipe_mutex_unlock(scene->block_pool->mutex);
 
       if (0)
          lp_debug_bins( scene );
@@ -41,6 +41,7 @@
 
 struct lp_scene_queue;
 struct lp_rast_state;
+struct lp_block_pool;
 
 /* We're limited to 2K by 2K for 32bit fixed point rasterization.
  * Will need a 64-bit version for larger framebuffers.
@@ -48,6 +49,15 @@ struct lp_rast_state;
 #define TILES_X (LP_MAX_WIDTH / TILE_SIZE)
 #define TILES_Y (LP_MAX_HEIGHT / TILE_SIZE)
 
+/* Tiles are grouped in 4x4 super-tiles (256x256 pixels), so that large
+ * triangles can be binned and empty parts of the framebuffer skipped
+ * without looking at each tile.
+ */
+#define SUPER_TILE_ORDER 2
+#define SUPER_TILE_SIZE (1 << SUPER_TILE_ORDER)
+#define SUPER_TILES_X ((TILES_X + SUPER_TILE_SIZE - 1) >> SUPER_TILE_ORDER)
+#define SUPER_TILES_Y ((TILES_Y + SUPER_TILE_SIZE - 1) >> SUPER_TILE_ORDER)
+
 
 /* Commands per command block (ideally so sizeof(cmd_block) is a power of
  * two in size.)
@@ -58,9 +68,17 @@ struct lp_rast_state;
  */
 #define DATA_BLOCK_SIZE (64 * 1024)
 
-/* Scene temporary storage is clamped to this size:
+/* Scene temporary storage is clamped to this size by default.  Contexts
+ * whose scenes keep running out of it get bigger scenes, up to
+ * LP_SCENE_MAX_SIZE_LIMIT, so that large draws aren't split into many
+ * flushes:
  */
 #define LP_SCENE_MAX_SIZE (9*1024*1024)
+#define LP_SCENE_MAX_SIZE_LIMIT (8*LP_SCENE_MAX_SIZE)
+
+/* Number of unused data blocks kept around for the next scenes:
+ */
+#define LP_BLOCK_POOL_MAX_BLOCKS (2*LP_SCENE_MAX_SIZE/DATA_BLOCK_SIZE)
 
 /* The maximum amount of texture storage referenced by a scene is
  * clamped to this size:
@@ -117,6 +135,17 @@ struct data_block_list {
 
 struct resource_ref;
 
+/**
+ * Range of bins, in row-major order, which one rasterizer thread works on
+ * before it starts stealing bins from other threads.
+ */
+struct lp_bin_range {
+   pipe_mutex mutex;
+   int next;   /**< next bin the owning thread will take */
+   int end;    /**< one past the last bin; other threads steal from here */
+};
+
+
 /**
  * All bins and bin data are contained here.
  * Per-bin data goes into the 'tile' bins.
@@ -160,6 +189,12 @@ struct lp_scene {
     */
    unsigned scene_size;
 
+   /** The limit for scene_size, see LP_SCENE_MAX_SIZE */
+   unsigned max_size;
+
+   /** Where the scene gets its data blocks from and returns them to */
+   struct lp_block_pool *block_pool;
+
    /** Sum of sizes of all resources referenced by the scene.  Sums
     * all the textures read by the scene:
     */
@@ -173,8 +208,15 @@ struct lp_scene {
     */
    unsigned tiles_x, tiles_y;
 
-   int curr_x, curr_y;  /**< for iterating over bins */
-   pipe_mutex mutex;
+   /** for iterating over bins, one range per rasterizer thread */
+   struct lp_bin_range bin_ranges[LP_MAX_THREADS];
+   unsigned num_bin_ranges;
+
+   /** Indices of the bins with commands, which the ranges above index */
+   unsigned active_bins[TILES_X * TILES_Y];
+
+   /** One bit per tile of each super-tile, set once its bin has a command */
+   uint16_t super_tile_mask[SUPER_TILES_Y][SUPER_TILES_X];
 
    struct cmd_bin tile[TILES_X][TILES_Y];
    struct data_block_list data;
@@ -182,6 +224,10 @@ struct lp_scene {
 
 
 
+struct lp_block_pool *lp_block_pool_create(void);
+
+void lp_block_pool_destroy(struct lp_block_pool *pool);
+
 struct lp_scene *lp_scene_create(struct pipe_context *pipe);
 
 void lp_scene_destroy(struct lp_scene *scene);
@@ -219,7 +265,7 @@ lp_scene_alloc( struct lp_scene *scene, unsigned size)
    if (LP_DEBUG & DEBUG_MEM)
       debug_printf("alloc %u block %u/%u tot %u/%u\n",
 		   size, block->used, DATA_BLOCK_SIZE,
-		   scene->scene_size, LP_SCENE_MAX_SIZE);
+		   scene->scene_size, scene->max_size);
 
    if (block->used + size > DATA_BLOCK_SIZE) {
       block = lp_scene_new_data_block( scene );
@@ -253,7 +299,7 @@ lp_scene_alloc_aligned( struct lp_scene *scene, unsigned size,
       debug_printf("alloc %u block %u/%u tot %u/%u\n",
 		   size + alignment - 1,
 		   block->used, DATA_BLOCK_SIZE,
-		   scene->scene_size, LP_SCENE_MAX_SIZE);
+		   scene->scene_size, scene->max_size);
        
    if (block->used + size + alignment - 1 > DATA_BLOCK_SIZE) {
       block = lp_scene_new_data_block( scene );
@@ -310,6 +356,11 @@ lp_scene_bin_command( struct lp_scene *scene,
    assert(cmd < LP_RAST_OP_MAX);
 
    if (tail == NULL || tail->count == CMD_BLOCK_MAX) {
+      if (tail == NULL) {
+         scene->super_tile_mask[y >> SUPER_TILE_ORDER][x >> SUPER_TILE_ORDER] |=
+            1 << ((y & (SUPER_TILE_SIZE - 1)) * SUPER_TILE_SIZE +
+                  (x & (SUPER_TILE_SIZE - 1)));
+      }
       tail = lp_scene_new_cmd_block( scene, bin );
       if (!tail) {
          return FALSE;
@@ -379,10 +430,11 @@ lp_scene_get_num_bins( const struct lp_scene *scene )
 
 
 void
-lp_scene_bin_iter_begin( struct lp_scene *scene );
+lp_scene_bin_iter_begin( struct lp_scene *scene, unsigned num_threads );
 
 struct cmd_bin *
-lp_scene_bin_iter_next( struct lp_scene *scene, int *x, int *y );
+lp_scene_bin_iter_next( struct lp_scene *scene, unsigned thread_index,
+                        int *x, int *y );
 
 
 
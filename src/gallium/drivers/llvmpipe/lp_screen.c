@@ -36,6 +36,8 @@
 #include "pipe/p_screen.h"
 #include "draw/draw_context.h"
 #include "gallivm/lp_bld_type.h"
+#include "gallivm/lp_bld_helper.h"
+#include "gallivm/lp_bld_init.h"
 
 #include "os/os_misc.h"
 #include "os/os_time.h"
@@ -46,8 +48,10 @@
 #include "lp_context.h"
 #include "lp_debug.h"
 #include "lp_public.h"
+#include "lp_query.h"
 #include "lp_limits.h"
 #include "lp_rast.h"
+#include "lp_scene.h"
 
 #include "state_tracker/sw_winsys.h"
 
@@ -210,7 +214,7 @@ llvmpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
    case PIPE_CAP_QUADS_FOLLOW_PROVOKING_VERTEX_CONVENTION:
       return 0;
    case PIPE_CAP_COMPUTE:
-      return 0;
+      return 1;
    case PIPE_CAP_USER_VERTEX_BUFFERS:
    case PIPE_CAP_USER_INDEX_BUFFERS:
       return 1;
@@ -302,6 +306,10 @@ llvmpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
    case PIPE_CAP_COPY_BETWEEN_COMPRESSED_AND_PLAIN_FORMATS:
    case PIPE_CAP_CLEAR_TEXTURE:
       return 0;
+   case PIPE_CAP_QUERY_BUFFER_OBJECT:
+      return 1;
+   case PIPE_CAP_SPARSE_BUFFER_PAGE_SIZE:
+      return 0;
    }
    /* should only get here on unhandled cases */
    debug_printf("Unexpected PIPE_CAP %d query\n", param);
@@ -338,11 +346,149 @@ llvmpipe_get_shader_param(struct pipe_screen *screen, unsigned shader, enum pipe
       default:
          return draw_get_shader_param(shader, param);
       }
+   case PIPE_SHADER_COMPUTE:
+      switch (param) {
+      case PIPE_SHADER_CAP_MAX_TEXTURE_SAMPLERS:
+      case PIPE_SHADER_CAP_MAX_SAMPLER_VIEWS:
+         /* no sampling in compute shaders yet, see lp_state_cs.c */
+         return 0;
+      default:
+         return gallivm_get_shader_param(param);
+      }
    default:
       return 0;
    }
 }
 
+static int
+llvmpipe_get_compute_param(struct pipe_screen *_screen,
+                           enum pipe_compute_cap param,
+                           void *ret)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
+   union {
+      const char *ir_target;
+      uint64_t grid_dimension;
+      uint64_t max_grid_size[3];
+      uint64_t max_block_size[3];
+      uint64_t max_threads_per_block;
+      uint64_t max_global_size;
+      uint64_t max_local_size;
+      uint64_t max_private_size;
+      uint64_t max_input_size;
+      uint64_t max_mem_alloc_size;
+      uint32_t max_clock_frequency;
+      uint32_t max_compute_units;
+      uint32_t images_supported;
+      uint32_t subgroup_size;
+   } val;
+   const void *ptr;
+   int size;
+
+   switch (param) {
+   case PIPE_COMPUTE_CAP_IR_TARGET:
+      val.ir_target = "tgsi";
+
+      ptr = val.ir_target;
+      size = strlen(val.ir_target) + 1;
+      break;
+   case PIPE_COMPUTE_CAP_GRID_DIMENSION:
+      val.grid_dimension = Elements(val.max_grid_size);
+
+      ptr = &val.grid_dimension;
+      size = sizeof(val.grid_dimension);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_GRID_SIZE:
+      val.max_grid_size[0] = 65535;
+      val.max_grid_size[1] = 65535;
+      val.max_grid_size[2] = 65535;
+
+      ptr = &val.max_grid_size;
+      size = sizeof(val.max_grid_size);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_BLOCK_SIZE:
+      val.max_block_size[0] = LP_MAX_CS_BLOCK_SIZE;
+      val.max_block_size[1] = LP_MAX_CS_BLOCK_SIZE;
+      val.max_block_size[2] = 64;
+
+      ptr = &val.max_block_size;
+      size = sizeof(val.max_block_size);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_THREADS_PER_BLOCK:
+      val.max_threads_per_block = LP_MAX_CS_BLOCK_SIZE;
+
+      ptr = &val.max_threads_per_block;
+      size = sizeof(val.max_threads_per_block);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_GLOBAL_SIZE:
+      /* GLOBAL memory isn't supported */
+      val.max_global_size = 0;
+
+      ptr = &val.max_global_size;
+      size = sizeof(val.max_global_size);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_LOCAL_SIZE:
+      val.max_local_size = LP_MAX_CS_LOCAL_MEM;
+
+      ptr = &val.max_local_size;
+      size = sizeof(val.max_local_size);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_PRIVATE_SIZE:
+      /* PRIVATE memory isn't supported */
+      val.max_private_size = 0;
+
+      ptr = &val.max_private_size;
+      size = sizeof(val.max_private_size);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_INPUT_SIZE:
+      val.max_input_size = LP_MAX_CS_INPUT_MEM;
+
+      ptr = &val.max_input_size;
+      size = sizeof(val.max_input_size);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_MEM_ALLOC_SIZE:
+      val.max_mem_alloc_size = LP_MAX_TEXTURE_SIZE;
+
+      ptr = &val.max_mem_alloc_size;
+      size = sizeof(val.max_mem_alloc_size);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_CLOCK_FREQUENCY:
+      /* not known */
+      val.max_clock_frequency = 1000;
+
+      ptr = &val.max_clock_frequency;
+      size = sizeof(val.max_clock_frequency);
+      break;
+   case PIPE_COMPUTE_CAP_MAX_COMPUTE_UNITS:
+      val.max_compute_units = MAX2(1, screen->num_threads);
+
+      ptr = &val.max_compute_units;
+      size = sizeof(val.max_compute_units);
+      break;
+   case PIPE_COMPUTE_CAP_IMAGES_SUPPORTED:
+      val.images_supported = 0;
+
+      ptr = &val.images_supported;
+      size = sizeof(val.images_supported);
+      break;
+   case PIPE_COMPUTE_CAP_SUBGROUP_SIZE:
+      val.subgroup_size = lp_native_vector_width / 32;
+
+      ptr = &val.subgroup_size;
+      size = sizeof(val.subgroup_size);
+      break;
+   default:
+      ptr = NULL;
+      size = 0;
+      break;
+   }
+
+   if (ret)
+      memcpy(ret, ptr, size);
+
+   return size;
+}
+
 static float
 llvmpipe_get_paramf(struct pipe_screen *screen, enum pipe_capf param)
 {
@@ -497,8 +643,11 @@ llvmpipe_flush_frontbuffer(struct pipe_screen *_screen,
    struct llvmpipe_resource *texture = llvmpipe_resource(resource);
 
    assert(texture->dt);
-   if (texture->dt)
+   if (texture->dt) {
+      /* Rendering isn't waited for at flush time anymore. */
+      llvmpipe_resource_wait_rendering(_screen, resource, FALSE);
       winsys->displaytarget_display(winsys, texture->dt, context_private, sub_box);
+   }
 }
 
 static void
@@ -510,6 +659,14 @@ llvmpipe_destroy_screen( struct pipe_screen *_screen )
    if (screen->rast)
       lp_rast_destroy(screen->rast);
 
+   llvmpipe_destroy_fs_code_cache(screen);
+
+   lp_helper_cache_destroy(screen->helpers);
+
+   gallivm_stop_compile_threads();
+
+   lp_block_pool_destroy(screen->block_pool);
+
    lp_jit_screen_cleanup(screen);
 
    if(winsys->destroy)
@@ -596,6 +753,7 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    screen->base.get_device_vendor = llvmpipe_get_vendor; // TODO should be the CPU vendor
    screen->base.get_param = llvmpipe_get_param;
    screen->base.get_shader_param = llvmpipe_get_shader_param;
+   screen->base.get_compute_param = llvmpipe_get_compute_param;
    screen->base.get_paramf = llvmpipe_get_paramf;
    screen->base.is_format_supported = llvmpipe_is_format_supported;
 
@@ -623,6 +781,37 @@ llvmpipe_create_screen(struct sw_winsys *winsys)
    }
    pipe_mutex_init(screen->rast_mutex);
 
+   llvmpipe_init_screen_query_funcs(screen);
+
+   if (!llvmpipe_init_fs_code_cache(screen)) {
+      lp_rast_destroy(screen->rast);
+      pipe_mutex_destroy(screen->rast_mutex);
+      lp_jit_screen_cleanup(screen);
+      FREE(screen);
+      return NULL;
+   }
+
+   screen->block_pool = lp_block_pool_create();
+   if (!screen->block_pool) {
+      llvmpipe_destroy_fs_code_cache(screen);
+      lp_rast_destroy(screen->rast);
+      pipe_mutex_destroy(screen->rast_mutex);
+      lp_jit_screen_cleanup(screen);
+      FREE(screen);
+      return NULL;
+   }
+
+   /* Not fatal, sampling code just gets emitted into every variant. */
+   screen->helpers = lp_helper_cache_create();
+
+   /* Without compile threads shaders just get compiled while drawing. */
+   gallivm_start_compile_threads();
+
+   screen->scene_max_size =
+      debug_get_num_option("LP_SCENE_MAX_SIZE", LP_SCENE_MAX_SIZE >> 20) << 20;
+   screen->scene_max_size = CLAMP(screen->scene_max_size, LP_SCENE_MAX_SIZE,
+                                  LP_SCENE_MAX_SIZE_LIMIT);
+
    util_format_s3tc_init();
 
    return &screen->base;
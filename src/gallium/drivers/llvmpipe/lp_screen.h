@@ -38,9 +38,14 @@
 #include "pipe/p_defines.h"
 #include "os/os_thread.h"
 #include "gallivm/lp_bld.h"
+#include "lp_limits.h"
 
 
 struct sw_winsys;
+struct hash_table;
+struct disk_cache;
+struct lp_block_pool;
+struct lp_helper_cache;
 
 
 struct llvmpipe_screen
@@ -57,6 +62,23 @@ struct llvmpipe_screen
 
    struct lp_rasterizer *rast;
    pipe_mutex rast_mutex;
+
+   /** Unused scene data blocks, see lp_scene.c */
+   struct lp_block_pool *block_pool;
+
+   /** Initial scene size limit, from LP_SCENE_MAX_SIZE (in MB) */
+   unsigned scene_max_size;
+
+   /** Fragment shader code shared by all contexts, see lp_state_fs.c */
+   pipe_mutex fs_code_mutex;
+   struct hash_table *fs_code_cache;
+   struct disk_cache *disk_shader_cache;
+
+   /** Shader helper functions shared by all variants, see lp_bld_helper.c */
+   struct lp_helper_cache *helpers;
+
+   /** Names of the per-thread driver queries, see lp_query.c */
+   char thread_query_names[LP_MAX_THREADS][24];
 };
 
 
@@ -78,10 +78,15 @@ lp_setup_get_empty_scene(struct lp_setup_context *setup)
          debug_printf("%s: wait for scene %d\n",
                       __FUNCTION__, setup->scene->fence->id);
 
+      /* The scene may still be in flight. Once it's rasterized, release
+       * the resources and memory it holds.
+       */
       lp_fence_wait(setup->scene->fence);
+      lp_scene_end_rasterization(setup->scene);
    }
 
    lp_scene_begin_binning(setup->scene, &setup->fb, setup->rasterizer_discard);
+   setup->scene->max_size = setup->scene_max_size;
 
 }
 
@@ -152,6 +157,7 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
 {
    struct lp_scene *scene = setup->scene;
    struct llvmpipe_screen *screen = llvmpipe_screen(scene->pipe->screen);
+   unsigned i;
 
    scene->num_active_queries = setup->active_binned_queries;
    memcpy(scene->active_queries, setup->active_queries,
@@ -159,6 +165,19 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
 
    lp_scene_end_binning(scene);
 
+   /* Go back to smaller scenes once the big ones aren't needed anymore. */
+   if (setup->scene_max_size > screen->scene_max_size &&
+       scene->scene_size < setup->scene_max_size / 4) {
+      if (++setup->small_scenes >= 16) {
+         setup->scene_max_size = MAX2(setup->scene_max_size / 2,
+                                      screen->scene_max_size);
+         setup->small_scenes = 0;
+      }
+   }
+   else {
+      setup->small_scenes = 0;
+   }
+
    lp_fence_reference(&setup->last_fence, scene->fence);
 
    if (setup->last_fence)
@@ -166,21 +185,24 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
 
    pipe_mutex_lock(screen->rast_mutex);
 
-   /* FIXME: We enqueue the scene then wait on the rasterizer to finish.
-    * This means we never actually run any vertex stuff in parallel to
-    * rasterization (not in the same context at least) which is what the
-    * multiple scenes per setup is about - when we get a new empty scene
-    * any old one is already empty again because we waited here for
-    * raster tasks to be finished. Ideally, we shouldn't need to wait here
-    * and rely on fences elsewhere when waiting is necessary.
-    * Certainly, lp_scene_end_rasterization() would need to be deferred too
-    * and there's probably other bits why this doesn't actually work.
+   /* Remember which scene writes the framebuffer, so that accesses from
+    * outside this context (other contexts, presentation) can wait for it.
+    */
+   for (i = 0; i < scene->fb.nr_cbufs; i++) {
+      if (scene->fb.cbufs[i])
+         llvmpipe_resource_set_fence(scene->fb.cbufs[i]->texture,
+                                     scene->fence);
+   }
+   if (scene->fb.zsbuf)
+      llvmpipe_resource_set_fence(scene->fb.zsbuf->texture, scene->fence);
+
+   /* Don't wait for the rasterizer here. The scene is retired when it's
+    * picked for binning again (see lp_setup_get_empty_scene), and the
+    * fences take care of everything that needs to wait for rendering.
     */
    lp_rast_queue_scene(screen->rast, scene);
-   lp_rast_finish(screen->rast);
    pipe_mutex_unlock(screen->rast_mutex);
 
-   lp_scene_end_rasterization(setup->scene);
    lp_setup_reset( setup );
 
    LP_DBG(DEBUG_SETUP, "%s done \n", __FUNCTION__);
@@ -975,9 +997,17 @@ lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
       return LP_REFERENCED_FOR_READ | LP_REFERENCED_FOR_WRITE;
    }
 
-   /* check textures referenced by the scene */
+   /* check textures referenced by the scenes, skipping the ones which
+    * have been rasterized already but not retired yet
+    */
    for (i = 0; i < Elements(setup->scenes); i++) {
-      if (lp_scene_is_resource_referenced(setup->scenes[i], texture)) {
+      struct lp_scene *scene = setup->scenes[i];
+
+      if (scene->fence && lp_fence_issued(scene->fence) &&
+          lp_fence_signalled(scene->fence))
+         continue;
+
+      if (lp_scene_is_resource_referenced(scene, texture)) {
          return LP_REFERENCED_FOR_READ;
       }
    }
@@ -1281,8 +1311,10 @@ lp_setup_destroy( struct lp_setup_context *setup )
    for (i = 0; i < Elements(setup->scenes); i++) {
       struct lp_scene *scene = setup->scenes[i];
 
-      if (scene->fence)
+      if (scene->fence) {
          lp_fence_wait(scene->fence);
+         lp_scene_end_rasterization(scene);
+      }
 
       lp_scene_destroy(scene);
    }
@@ -1319,6 +1351,7 @@ lp_setup_create( struct pipe_context *pipe,
 
 
    setup->num_threads = screen->num_threads;
+   setup->scene_max_size = screen->scene_max_size;
    setup->vbuf = draw_vbuf_stage(draw, &setup->base);
    if (!setup->vbuf) {
       goto no_vbuf;
@@ -1481,6 +1514,17 @@ lp_setup_flush_and_restart(struct lp_setup_context *setup)
 
    assert(setup->state == SETUP_ACTIVE);
 
+   /* The scene ran out of memory: let the next ones grow, so that big
+    * batches of draws aren't flushed in many small pieces.
+    */
+   if (setup->scene && lp_scene_is_oom(setup->scene) &&
+       setup->scene_max_size < LP_SCENE_MAX_SIZE_LIMIT) {
+      setup->scene_max_size = MIN2(setup->scene_max_size * 2,
+                                   LP_SCENE_MAX_SIZE_LIMIT);
+      LP_DBG(DEBUG_SCENE, "scene size limit raised to %u\n",
+             setup->scene_max_size);
+   }
+
    if (!set_scene_state(setup, SETUP_FLUSHED, __FUNCTION__))
       return FALSE;
    
@@ -54,9 +54,10 @@
 struct lp_setup_variant;
 
 
-/** Max number of scenes */
-/* XXX: make multiple scenes per context work, see lp_setup_rasterize_scene */
-#define MAX_SCENES 1
+/** Max number of scenes per context.
+ * While one scene is being rasterized, the next ones can be binned.
+ */
+#define MAX_SCENES 4
 
 
 
@@ -91,6 +92,11 @@ struct lp_setup_context
    struct lp_scene *scenes[MAX_SCENES];  /**< all the scenes */
    struct lp_scene *scene;               /**< current scene being built */
 
+   /** Size limit of the scenes, grown when they run out of memory */
+   unsigned scene_max_size;
+   /** Number of scenes in a row which used little of scene_max_size */
+   unsigned small_scenes;
+
    struct lp_fence *last_fence;
    struct llvmpipe_query *active_queries[LP_MAX_ACTIVE_BINNED_QUERIES];
    unsigned active_binned_queries;
@@ -168,6 +174,14 @@ struct lp_setup_context
 };
 
 void lp_setup_choose_triangle( struct lp_setup_context *setup );
+
+boolean lp_setup_rect( struct lp_setup_context *setup,
+                       const float (*a0)[4],
+                       const float (*a1)[4],
+                       const float (*a2)[4],
+                       const float (*b0)[4],
+                       const float (*b1)[4],
+                       const float (*b2)[4] );
 void lp_setup_choose_line( struct lp_setup_context *setup );
 void lp_setup_choose_point( struct lp_setup_context *setup );
 
@@ -29,6 +29,8 @@
  * Binning code for triangles
  */
 
+#include <float.h>
+
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_rect.h"
@@ -254,6 +256,89 @@ lp_setup_whole_tile(struct lp_setup_context *setup,
 }
 
 
+/**
+ * Setup the plane of the edge going from (x, y) to (x - dx, y - dy), for
+ * a primitive with counter-clockwise edges.
+ */
+static inline void
+setup_edge_plane(const struct lp_setup_context *setup,
+                 struct lp_rast_plane *plane,
+                 int dx, int dy, int x, int y)
+{
+   plane->dcdy = dx;
+   plane->dcdx = dy;
+
+   /* half-edge constants, will be interated over the whole render
+    * target.
+    */
+   plane->c = IMUL64(plane->dcdx, x) - IMUL64(plane->dcdy, y);
+
+   /* correct for top-left vs. bottom-left fill convention.
+    */
+   if (plane->dcdx < 0) {
+      /* both fill conventions want this - adjust for left edges */
+      plane->c++;
+   }
+   else if (plane->dcdx == 0) {
+      if (setup->bottom_edge_rule == 0){
+         /* correct for top-left fill convention:
+          */
+         if (plane->dcdy > 0) plane->c++;
+      }
+      else {
+         /* correct for bottom-left fill convention:
+          */
+         if (plane->dcdy < 0) plane->c++;
+      }
+   }
+
+   /* Scale up to match c:
+    */
+   assert((plane->dcdx << FIXED_ORDER) >> FIXED_ORDER == plane->dcdx);
+   assert((plane->dcdy << FIXED_ORDER) >> FIXED_ORDER == plane->dcdy);
+   plane->dcdx <<= FIXED_ORDER;
+   plane->dcdy <<= FIXED_ORDER;
+
+   /* find trivial reject offsets for each edge for a single-pixel
+    * sized block.  These will be scaled up at each recursive level to
+    * match the active blocksize.  Scaling in this way works best if
+    * the blocks are square.
+    */
+   plane->eo = 0;
+   if (plane->dcdx < 0) plane->eo -= plane->dcdx;
+   if (plane->dcdy > 0) plane->eo += plane->dcdy;
+}
+
+
+/**
+ * Setup the four planes of a scissor rectangle.
+ */
+static inline void
+setup_scissor_planes(struct lp_rast_plane *plane,
+                     const struct u_rect *scissor)
+{
+   plane[0].dcdx = -1;
+   plane[0].dcdy = 0;
+   plane[0].c = 1-scissor->x0;
+   plane[0].eo = 1;
+
+   plane[1].dcdx = 1;
+   plane[1].dcdy = 0;
+   plane[1].c = scissor->x1+1;
+   plane[1].eo = 0;
+
+   plane[2].dcdx = 0;
+   plane[2].dcdy = 1;
+   plane[2].c = 1-scissor->y0;
+   plane[2].eo = 1;
+
+   plane[3].dcdx = 0;
+   plane[3].dcdy = -1;
+   plane[3].c = scissor->y1+1;
+   plane[3].eo = 0;
+}
+
+
 /**
  * Do basic setup for triangle rasterization and determine which
  * framebuffer tiles are touched.  Put the triangle in the scene's
@@ -464,56 +549,14 @@ do_triangle_ccw(struct lp_setup_context *setup,
    } else
 #endif
    {
-      int i;
-      plane[0].dcdy = position->dx01;
-      plane[1].dcdy = position->x[1] - position->x[2];
-      plane[2].dcdy = position->dx20;
-      plane[0].dcdx = position->dy01;
-      plane[1].dcdx = position->y[1] - position->y[2];
-      plane[2].dcdx = position->dy20;
-  
-      for (i = 0; i < 3; i++) {
-         /* half-edge constants, will be interated over the whole render
-          * target.
-          */
-         plane[i].c = IMUL64(plane[i].dcdx, position->x[i]) -
-               IMUL64(plane[i].dcdy, position->y[i]);
-
-         /* correct for top-left vs. bottom-left fill convention.
-          */         
-         if (plane[i].dcdx < 0) {
-            /* both fill conventions want this - adjust for left edges */
-            plane[i].c++;            
-         }
-         else if (plane[i].dcdx == 0) {
-            if (setup->bottom_edge_rule == 0){
-               /* correct for top-left fill convention:
-                */
-               if (plane[i].dcdy > 0) plane[i].c++;
-            }
-            else {
-               /* correct for bottom-left fill convention:
-                */
-               if (plane[i].dcdy < 0) plane[i].c++;
-            }
-         }
-
-         /* Scale up to match c:
-          */
-         assert((plane[i].dcdx << FIXED_ORDER) >> FIXED_ORDER == plane[i].dcdx);
-         assert((plane[i].dcdy << FIXED_ORDER) >> FIXED_ORDER == plane[i].dcdy);
-         plane[i].dcdx <<= FIXED_ORDER;
-         plane[i].dcdy <<= FIXED_ORDER;
-
-         /* find trivial reject offsets for each edge for a single-pixel
-          * sized block.  These will be scaled up at each recursive level to
-          * match the active blocksize.  Scaling in this way works best if
-          * the blocks are square.
-          */
-         plane[i].eo = 0;
-         if (plane[i].dcdx < 0) plane[i].eo -= plane[i].dcdx;
-         if (plane[i].dcdy > 0) plane[i].eo += plane[i].dcdy;
-      }
+      setup_edge_plane(setup, &plane[0], position->dx01, position->dy01,
+                       position->x[0], position->y[0]);
+      setup_edge_plane(setup, &plane[1],
+                       position->x[1] - position->x[2],
+                       position->y[1] - position->y[2],
+                       position->x[1], position->y[1]);
+      setup_edge_plane(setup, &plane[2], position->dx20, position->dy20,
+                       position->x[2], position->y[2]);
    }
 
    if (0) {
@@ -556,27 +599,7 @@ do_triangle_ccw(struct lp_setup_context *setup,
     * these planes elsewhere.
     */
    if (nr_planes == 7) {
-      const struct u_rect *scissor = &setup->scissors[viewport_index];
-
-      plane[3].dcdx = -1;
-      plane[3].dcdy = 0;
-      plane[3].c = 1-scissor->x0;
-      plane[3].eo = 1;
-
-      plane[4].dcdx = 1;
-      plane[4].dcdy = 0;
-      plane[4].c = scissor->x1+1;
-      plane[4].eo = 0;
-
-      plane[5].dcdx = 0;
-      plane[5].dcdy = 1;
-      plane[5].c = 1-scissor->y0;
-      plane[5].eo = 1;
-
-      plane[6].dcdx = 0;
-      plane[6].dcdy = -1;
-      plane[6].c = scissor->y1+1;
-      plane[6].eo = 0;
+      setup_scissor_planes(&plane[3], &setup->scissors[viewport_index]);
    }
 
    return lp_setup_bin_triangle(setup, tri, &bbox, nr_planes, viewport_index);
@@ -724,7 +747,7 @@ lp_setup_bin_triangle( struct lp_setup_context *setup,
       int64_t eo[MAX_PLANES];
       int64_t xstep[MAX_PLANES];
       int64_t ystep[MAX_PLANES];
-      int x, y;
+      int sx, sy, x, y;
 
       int ix0 = trimmed_box.x0 / TILE_SIZE;
       int iy0 = trimmed_box.y0 / TILE_SIZE;
@@ -747,70 +770,110 @@ lp_setup_bin_triangle( struct lp_setup_context *setup,
 
 
 
-      /* Test tile-sized blocks against the triangle.
-       * Discard blocks fully outside the tri.  If the block is fully
-       * contained inside the tri, bin an lp_rast_shade_tile command.
-       * Else, bin a lp_rast_triangle command.
+      /* Test super-tile sized blocks against the triangle first, so that
+       * large triangles don't need testing tile by tile: blocks fully
+       * outside the tri are skipped, and the tiles of blocks fully inside
+       * the tri are all shaded.  The tiles of the remaining blocks are
+       * tested like the blocks.  Tiles fully contained in the tri get an
+       * lp_rast_shade_tile command, partially covered ones an
+       * lp_rast_triangle command.
        */
-      for (y = iy0; y <= iy1; y++)
+      for (sy = iy0 & ~(SUPER_TILE_SIZE - 1); sy <= iy1; sy += SUPER_TILE_SIZE)
       {
-         boolean in = FALSE;  /* are we inside the triangle? */
-         int64_t cx[MAX_PLANES];
-
-         for (i = 0; i < nr_planes; i++)
-            cx[i] = c[i];
-
-         for (x = ix0; x <= ix1; x++)
+         for (sx = ix0 & ~(SUPER_TILE_SIZE - 1); sx <= ix1; sx += SUPER_TILE_SIZE)
          {
+            int tx0 = MAX2(sx, ix0);
+            int ty0 = MAX2(sy, iy0);
+            int tx1 = MIN2(sx + SUPER_TILE_SIZE - 1, ix1);
+            int ty1 = MIN2(sy + SUPER_TILE_SIZE - 1, iy1);
+            int64_t cy[MAX_PLANES];
             int out = 0;
             int partial = 0;
 
             for (i = 0; i < nr_planes; i++) {
-               int64_t planeout = cx[i] + eo[i];
-               int64_t planepartial = cx[i] + ei[i] - 1;
+               int64_t cs = c[i] + (sx - ix0) * xstep[i] + (sy - iy0) * ystep[i];
+               int64_t planeout = cs + (eo[i] << SUPER_TILE_ORDER);
+               int64_t planepartial = cs + (ei[i] << SUPER_TILE_ORDER) - 1;
                out |= (int) (planeout >> 63);
                partial |= ((int) (planepartial >> 63)) & (1<<i);
             }
 
             if (out) {
-               /* do nothing */
-               if (in)
-                  break;  /* exiting triangle, all done with this row */
-               LP_COUNT(nr_empty_64);
+               LP_COUNT_ADD(nr_empty_64, (tx1 - tx0 + 1) * (ty1 - ty0 + 1));
+               continue;
             }
-            else if (partial) {
-               /* Not trivially accepted by at least one plane -
-                * rasterize/shade partial tile
-                */
-               int count = util_bitcount(partial);
-               in = TRUE;
-               
-               if (!lp_scene_bin_cmd_with_state( scene, x, y,
-                                                 setup->fs.stored,
-                                                 use_32bits ?
-                                                 lp_rast_32_tri_tab[count] :
-                                                 lp_rast_tri_tab[count],
-                                                 lp_rast_arg_triangle(tri, partial) ))
-                  goto fail;
-
-               LP_COUNT(nr_partially_covered_64);
-            }
-            else {
-               /* triangle covers the whole tile- shade whole tile */
-               LP_COUNT(nr_fully_covered_64);
-               in = TRUE;
-               if (!lp_setup_whole_tile(setup, &tri->inputs, x, y))
-                  goto fail;
+
+            if (!partial) {
+               /* triangle covers the whole block - shade whole tiles */
+               for (y = ty0; y <= ty1; y++) {
+                  for (x = tx0; x <= tx1; x++) {
+                     LP_COUNT(nr_fully_covered_64);
+                     if (!lp_setup_whole_tile(setup, &tri->inputs, x, y))
+                        goto fail;
+                  }
+               }
+               continue;
             }
 
-            /* Iterate cx values across the region: */
             for (i = 0; i < nr_planes; i++)
-               cx[i] += xstep[i];
+               cy[i] = c[i] + (tx0 - ix0) * xstep[i] + (ty0 - iy0) * ystep[i];
+
+            for (y = ty0; y <= ty1; y++)
+            {
+               int64_t cx[MAX_PLANES];
+
+               for (i = 0; i < nr_planes; i++)
+                  cx[i] = cy[i];
+
+               for (x = tx0; x <= tx1; x++)
+               {
+                  out = 0;
+                  partial = 0;
+
+                  for (i = 0; i < nr_planes; i++) {
+                     int64_t planeout = cx[i] + eo[i];
+                     int64_t planepartial = cx[i] + ei[i] - 1;
+                     out |= (int) (planeout >> 63);
+                     partial |= ((int) (planepartial >> 63)) & (1<<i);
+                  }
+
+                  if (out) {
+                     /* do nothing */
+                     LP_COUNT(nr_empty_64);
+                  }
+                  else if (partial) {
+                     /* Not trivially accepted by at least one plane -
+                      * rasterize/shade partial tile
+                      */
+                     int count = util_bitcount(partial);
+
+                     if (!lp_scene_bin_cmd_with_state( scene, x, y,
+                                                       setup->fs.stored,
+                                                       use_32bits ?
+                                                       lp_rast_32_tri_tab[count] :
+                                                       lp_rast_tri_tab[count],
+                                                       lp_rast_arg_triangle(tri, partial) ))
+                        goto fail;
+
+                     LP_COUNT(nr_partially_covered_64);
+                  }
+                  else {
+                     /* triangle covers the whole tile- shade whole tile */
+                     LP_COUNT(nr_fully_covered_64);
+                     if (!lp_setup_whole_tile(setup, &tri->inputs, x, y))
+                        goto fail;
+                  }
+
+                  /* Iterate cx values across the block: */
+                  for (i = 0; i < nr_planes; i++)
+                     cx[i] += xstep[i];
+               }
+
+               /* Iterate cy values down the block: */
+               for (i = 0; i < nr_planes; i++)
+                  cy[i] += ystep[i];
+            }
          }
-
-         /* Iterate c values down the region: */
-         for (i = 0; i < nr_planes; i++)
-            c[i] += ystep[i];
       }
    }
 
@@ -1033,3 +1096,295 @@ lp_setup_choose_triangle( struct lp_setup_context *setup )
       break;
    }
 }
+
+
+/**
+ * Setup and bin a screen-aligned rectangle, given its corners in
+ * counter-clockwise order, and a triangle of it to setup the interpolants
+ * with.
+ */
+static boolean
+do_rect_ccw(struct lp_setup_context *setup,
+            const int x[4],
+            const int y[4],
+            const float (*v0)[4],
+            const float (*v1)[4],
+            const float (*v2)[4],
+            boolean frontfacing)
+{
+   struct lp_scene *scene = setup->scene;
+   const struct lp_setup_variant_key *key = &setup->setup.variant->key;
+   struct lp_rast_triangle *tri;
+   struct lp_rast_plane *plane;
+   struct u_rect bbox;
+   unsigned tri_bytes;
+   int nr_planes = 4;
+   unsigned viewport_index = 0;
+   unsigned layer = 0;
+   const float (*pv)[4];
+   int adj = (setup->bottom_edge_rule != 0) ? 1 : 0;
+   int i;
+
+   pv = setup->flatshade_first ? v0 : v2;
+   if (setup->viewport_index_slot > 0) {
+      unsigned *udata = (unsigned*)pv[setup->viewport_index_slot];
+      viewport_index = lp_clamp_viewport_idx(*udata);
+   }
+   if (setup->layer_slot > 0) {
+      layer = *(unsigned*)pv[setup->layer_slot];
+      layer = MIN2(layer, scene->fb_max_layer);
+   }
+
+   /* Same rounding as for triangles, see do_triangle_ccw(). */
+   bbox.x0 = x[0] >> FIXED_ORDER;
+   bbox.x1 = (x[2] - 1) >> FIXED_ORDER;
+   bbox.y0 = (y[0] + adj) >> FIXED_ORDER;
+   bbox.y1 = (y[2] - 1 + adj) >> FIXED_ORDER;
+
+   if (bbox.x1 < bbox.x0 ||
+       bbox.y1 < bbox.y0 ||
+       !u_rect_test_intersection(&setup->draw_regions[viewport_index], &bbox)) {
+      LP_COUNT_ADD(nr_culled_tris, 2);
+      return TRUE;
+   }
+
+   bbox.x0 = MAX2(bbox.x0, 0);
+   bbox.y0 = MAX2(bbox.y0, 0);
+
+   /* The scissor planes are only needed if the scissor cuts the rect. */
+   if (setup->scissor_test) {
+      const struct u_rect *scissor = &setup->scissors[viewport_index];
+
+      if (bbox.x0 < scissor->x0 || bbox.x1 > scissor->x1 ||
+          bbox.y0 < scissor->y0 || bbox.y1 > scissor->y1)
+         nr_planes = 8;
+   }
+
+   tri = lp_setup_alloc_triangle(scene,
+                                 key->num_inputs,
+                                 nr_planes,
+                                 &tri_bytes);
+   if (!tri)
+      return FALSE;
+
+   LP_COUNT(nr_rects);
+
+   setup->setup.variant->jit_function( v0,
+                                       v1,
+                                       v2,
+                                       frontfacing,
+                                       GET_A0(&tri->inputs),
+                                       GET_DADX(&tri->inputs),
+                                       GET_DADY(&tri->inputs) );
+
+   tri->inputs.frontfacing = frontfacing;
+   tri->inputs.disable = FALSE;
+   tri->inputs.opaque = setup->fs.current.variant->opaque;
+   tri->inputs.layer = layer;
+   tri->inputs.viewport_index = viewport_index;
+
+   plane = GET_PLANES(tri);
+
+   for (i = 0; i < 4; i++) {
+      int j = (i + 1) % 4;
+      setup_edge_plane(setup, &plane[i], x[i] - x[j], y[i] - y[j], x[i], y[i]);
+   }
+
+   if (nr_planes == 8) {
+      setup_scissor_planes(&plane[4], &setup->scissors[viewport_index]);
+   }
+
+   return lp_setup_bin_triangle(setup, tri, &bbox, nr_planes, viewport_index);
+}
+
+
+/**
+ * Whether the attributes of vertex m are those at a + b - o, that is where
+ * the plane going through the attributes of vertices a, b and o puts them.
+ */
+static boolean
+rect_attribs_coplanar(const struct lp_setup_context *setup,
+                      const float (*a)[4],
+                      const float (*b)[4],
+                      const float (*o)[4],
+                      const float (*m)[4])
+{
+   const float *fa = a[0], *fb = b[0], *fo = o[0], *fm = m[0];
+   unsigned size = setup->vertex_info->size;
+   unsigned i;
+
+   /* Perspective correct interpolation is linear only if w is the same
+    * everywhere.
+    */
+   if (fm[3] != fa[3] || fm[3] != fb[3] || fm[3] != fo[3])
+      return FALSE;
+
+   /* Everything but x, y and w, which are known to be fine. */
+   for (i = 2; i < size; i++) {
+      float expected = fa[i] + fb[i] - fo[i];
+      float tolerance = (fabsf(fa[i]) + fabsf(fb[i]) + fabsf(fo[i])) *
+                        (4.0f * FLT_EPSILON);
+
+      if (i == 3)
+         continue;
+
+      /* Written so that NaNs fail. */
+      if (!(fabsf(fm[i] - expected) <= tolerance))
+         return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Draw triangles a and b as one rectangle if they are the two halves of a
+ * screen-aligned rectangle, split along a diagonal, with interpolants that
+ * go through the same planes over both.  That's what textured quads and
+ * blits usually look like, and it spares rasterizing the diagonal, which
+ * otherwise turns all the tiles along it into partially covered ones,
+ * shaded once for each triangle.
+ *
+ * The pixels covered, and everything else, are exactly as if the
+ * triangles were drawn one after the other.
+ *
+ * \return FALSE if the triangles weren't drawn.
+ */
+boolean
+lp_setup_rect(struct lp_setup_context *setup,
+              const float (*a0)[4],
+              const float (*a1)[4],
+              const float (*a2)[4],
+              const float (*b0)[4],
+              const float (*b1)[4],
+              const float (*b2)[4])
+{
+   const float (*v[6])[4] = { a0, a1, a2, b0, b1, b2 };
+   const float (*corner[2][4])[4];
+   const struct lp_setup_variant_key *key;
+   const float (*pv_a)[4], (*pv_b)[4];
+   unsigned mask[2] = { 0, 0 };
+   unsigned missing_a, missing_b, shared0, shared1;
+   int fx[6], fy[6];
+   int x[4], y[4];
+   int64_t area_a, area_b;
+   boolean frontfacing;
+   unsigned i;
+
+   if (setup->cullmode == PIPE_FACE_FRONT_AND_BACK)
+      return FALSE;
+
+   for (i = 0; i < 6; i++) {
+      fx[i] = subpixel_snap(v[i][0][0] - setup->pixel_offset);
+      fy[i] = subpixel_snap(v[i][0][1] - setup->pixel_offset);
+   }
+
+   /* Corners from top-left, counter-clockwise. */
+   x[0] = x[1] = MIN3(fx[0], fx[1], fx[2]);
+   x[2] = x[3] = MAX3(fx[0], fx[1], fx[2]);
+   y[0] = y[3] = MIN3(fy[0], fy[1], fy[2]);
+   y[1] = y[2] = MAX3(fy[0], fy[1], fy[2]);
+
+   if (x[0] == x[2] || y[0] == y[1])
+      return FALSE;
+
+   /* All vertices must be on corners, each triangle on three different
+    * ones.  Corners are numbered with bit 0 for right and bit 1 for bottom.
+    */
+   for (i = 0; i < 6; i++) {
+      unsigned c;
+
+      if (fx[i] == x[0])
+         c = 0;
+      else if (fx[i] == x[2])
+         c = 1;
+      else
+         return FALSE;
+
+      if (fy[i] == y[1])
+         c |= 2;
+      else if (fy[i] != y[0])
+         return FALSE;
+
+      if (mask[i / 3] & (1 << c))
+         return FALSE;
+      mask[i / 3] |= 1 << c;
+      corner[i / 3][c] = v[i];
+   }
+
+   /* Each triangle leaves one corner out.  Those must be opposite for the
+    * triangles to exactly cover the rect without overlapping.
+    */
+   missing_a = util_logbase2(~mask[0] & 0xf);
+   missing_b = util_logbase2(~mask[1] & 0xf);
+   if (missing_b != (missing_a ^ 3))
+      return FALSE;
+
+   shared0 = missing_a ^ 1;
+   shared1 = missing_a ^ 2;
+
+   area_a = IMUL64(fx[0] - fx[1], fy[2] - fy[0]) -
+            IMUL64(fx[2] - fx[0], fy[0] - fy[1]);
+   area_b = IMUL64(fx[3] - fx[4], fy[5] - fy[3]) -
+            IMUL64(fx[5] - fx[3], fy[3] - fy[4]);
+   if ((area_a > 0) != (area_b > 0))
+      return FALSE;
+
+   key = &setup->setup.variant->key;
+   pv_a = setup->flatshade_first ? a0 : a2;
+   pv_b = setup->flatshade_first ? b0 : b2;
+
+   if (memcmp(corner[0][shared0], corner[1][shared0],
+              setup->vertex_info->size * sizeof(float)) != 0 ||
+       memcmp(corner[0][shared1], corner[1][shared1],
+              setup->vertex_info->size * sizeof(float)) != 0 ||
+       !rect_attribs_coplanar(setup,
+                              corner[0][shared0], corner[0][shared1],
+                              corner[0][missing_b], corner[1][missing_a]))
+      return FALSE;
+
+   /* Flat inputs come from each triangle's provoking vertex. */
+   for (i = 0; i < key->num_inputs; i++) {
+      unsigned src = key->inputs[i].src_index;
+
+      if (key->inputs[i].cyl_wrap)
+         return FALSE;
+
+      if (key->inputs[i].interp == LP_INTERP_CONSTANT &&
+          memcmp(pv_a[src], pv_b[src], sizeof pv_a[src]) != 0)
+         return FALSE;
+   }
+   if ((setup->viewport_index_slot > 0 &&
+        memcmp(pv_a[setup->viewport_index_slot],
+               pv_b[setup->viewport_index_slot],
+               sizeof pv_a[0]) != 0) ||
+       (setup->layer_slot > 0 &&
+        memcmp(pv_a[setup->layer_slot], pv_b[setup->layer_slot],
+               sizeof pv_a[0]) != 0))
+      return FALSE;
+
+   /* Same facing and culling as triangle_cw/ccw/both. */
+   frontfacing = area_a > 0 ? setup->ccw_is_frontface :
+                              !setup->ccw_is_frontface;
+   if (setup->cullmode & (frontfacing ? PIPE_FACE_FRONT : PIPE_FACE_BACK))
+      return TRUE;
+
+   if (setup->cullmode == PIPE_FACE_NONE) {
+      struct llvmpipe_context *lp_context =
+         (struct llvmpipe_context *)setup->pipe;
+
+      if (lp_context->active_statistics_queries &&
+          !llvmpipe_rasterization_disabled(lp_context)) {
+         lp_context->pipeline_statistics.c_primitives += 2;
+      }
+   }
+
+   if (!do_rect_ccw(setup, x, y, a0, a1, a2, frontfacing)) {
+      if (!lp_setup_flush_and_restart(setup))
+         return TRUE;
+
+      do_rect_ccw(setup, x, y, a0, a1, a2, frontfacing);
+   }
+
+   return TRUE;
+}
@@ -129,6 +129,24 @@ static inline const_float4_ptr get_vert( const void *vertex_buffer,
    return (const_float4_ptr)((char *)vertex_buffer + index * stride);
 }
 
+/**
+ * Emit two triangles, as one rectangle if that's what they make up.
+ */
+static inline void
+emit_tri_pair(struct lp_setup_context *setup,
+              const float (*a0)[4],
+              const float (*a1)[4],
+              const float (*a2)[4],
+              const float (*b0)[4],
+              const float (*b1)[4],
+              const float (*b2)[4])
+{
+   if (!lp_setup_rect(setup, a0, a1, a2, b0, b1, b2)) {
+      setup->triangle( setup, a0, a1, a2 );
+      setup->triangle( setup, b0, b1, b2 );
+   }
+}
+
 /**
  * draw elements / indexed primitives
  */
@@ -184,15 +202,46 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
       break;
 
    case PIPE_PRIM_TRIANGLES:
-      for (i = 2; i < nr; i += 3) {
+      for (i = 5; i < nr; i += 6) {
+         emit_tri_pair( setup,
+                        get_vert(vertex_buffer, indices[i-5], stride),
+                        get_vert(vertex_buffer, indices[i-4], stride),
+                        get_vert(vertex_buffer, indices[i-3], stride),
+                        get_vert(vertex_buffer, indices[i-2], stride),
+                        get_vert(vertex_buffer, indices[i-1], stride),
+                        get_vert(vertex_buffer, indices[i-0], stride) );
+      }
+      if (i - 3 < nr) {
          setup->triangle( setup,
-                          get_vert(vertex_buffer, indices[i-2], stride),
-                          get_vert(vertex_buffer, indices[i-1], stride),
-                          get_vert(vertex_buffer, indices[i-0], stride) );
+                          get_vert(vertex_buffer, indices[i-5], stride),
+                          get_vert(vertex_buffer, indices[i-4], stride),
+                          get_vert(vertex_buffer, indices[i-3], stride) );
       }
       break;
 
    case PIPE_PRIM_TRIANGLE_STRIP:
+      if (nr == 4) {
+         /* the two triangles emitted below */
+         if (flatshade_first) {
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, indices[0], stride),
+                           get_vert(vertex_buffer, indices[1], stride),
+                           get_vert(vertex_buffer, indices[2], stride),
+                           get_vert(vertex_buffer, indices[1], stride),
+                           get_vert(vertex_buffer, indices[3], stride),
+                           get_vert(vertex_buffer, indices[2], stride) );
+         }
+         else {
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, indices[0], stride),
+                           get_vert(vertex_buffer, indices[1], stride),
+                           get_vert(vertex_buffer, indices[2], stride),
+                           get_vert(vertex_buffer, indices[2], stride),
+                           get_vert(vertex_buffer, indices[1], stride),
+                           get_vert(vertex_buffer, indices[3], stride) );
+         }
+         break;
+      }
       if (flatshade_first) {
          for (i = 2; i < nr; i += 1) {
             /* emit first triangle vertex as first triangle vertex */
@@ -215,6 +264,28 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
       break;
 
    case PIPE_PRIM_TRIANGLE_FAN:
+      if (nr == 4) {
+         /* the two triangles emitted below */
+         if (flatshade_first) {
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, indices[1], stride),
+                           get_vert(vertex_buffer, indices[2], stride),
+                           get_vert(vertex_buffer, indices[0], stride),
+                           get_vert(vertex_buffer, indices[2], stride),
+                           get_vert(vertex_buffer, indices[3], stride),
+                           get_vert(vertex_buffer, indices[0], stride) );
+         }
+         else {
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, indices[0], stride),
+                           get_vert(vertex_buffer, indices[1], stride),
+                           get_vert(vertex_buffer, indices[2], stride),
+                           get_vert(vertex_buffer, indices[0], stride),
+                           get_vert(vertex_buffer, indices[2], stride),
+                           get_vert(vertex_buffer, indices[3], stride) );
+         }
+         break;
+      }
       if (flatshade_first) {
          for (i = 2; i < nr; i += 1) {
             /* emit first non-spoke vertex as first vertex */
@@ -240,29 +311,25 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
       if (flatshade_first) { 
          /* emit last quad vertex as first triangle vertex */
          for (i = 3; i < nr; i += 4) {
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, indices[i-0], stride),
-                             get_vert(vertex_buffer, indices[i-3], stride),
-                             get_vert(vertex_buffer, indices[i-2], stride) );
-
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, indices[i-0], stride),
-                             get_vert(vertex_buffer, indices[i-2], stride),
-                             get_vert(vertex_buffer, indices[i-1], stride) );
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, indices[i-0], stride),
+                           get_vert(vertex_buffer, indices[i-3], stride),
+                           get_vert(vertex_buffer, indices[i-2], stride),
+                           get_vert(vertex_buffer, indices[i-0], stride),
+                           get_vert(vertex_buffer, indices[i-2], stride),
+                           get_vert(vertex_buffer, indices[i-1], stride) );
          }
       }
       else {
          /* emit last quad vertex as last triangle vertex */
          for (i = 3; i < nr; i += 4) {
-            setup->triangle( setup,
-                          get_vert(vertex_buffer, indices[i-3], stride),
-                          get_vert(vertex_buffer, indices[i-2], stride),
-                          get_vert(vertex_buffer, indices[i-0], stride) );
-
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, indices[i-2], stride),
-                             get_vert(vertex_buffer, indices[i-1], stride),
-                             get_vert(vertex_buffer, indices[i-0], stride) );
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, indices[i-3], stride),
+                           get_vert(vertex_buffer, indices[i-2], stride),
+                           get_vert(vertex_buffer, indices[i-0], stride),
+                           get_vert(vertex_buffer, indices[i-2], stride),
+                           get_vert(vertex_buffer, indices[i-1], stride),
+                           get_vert(vertex_buffer, indices[i-0], stride) );
          }
       }
       break;
@@ -272,27 +339,25 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
       if (flatshade_first) { 
          /* emit last quad vertex as first triangle vertex */
          for (i = 3; i < nr; i += 2) {
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, indices[i-0], stride),
-                             get_vert(vertex_buffer, indices[i-3], stride),
-                             get_vert(vertex_buffer, indices[i-2], stride) );
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, indices[i-0], stride),
-                             get_vert(vertex_buffer, indices[i-1], stride),
-                             get_vert(vertex_buffer, indices[i-3], stride) );
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, indices[i-0], stride),
+                           get_vert(vertex_buffer, indices[i-3], stride),
+                           get_vert(vertex_buffer, indices[i-2], stride),
+                           get_vert(vertex_buffer, indices[i-0], stride),
+                           get_vert(vertex_buffer, indices[i-1], stride),
+                           get_vert(vertex_buffer, indices[i-3], stride) );
          }
       }
       else {
          /* emit last quad vertex as last triangle vertex */
          for (i = 3; i < nr; i += 2) {
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, indices[i-3], stride),
-                             get_vert(vertex_buffer, indices[i-2], stride),
-                             get_vert(vertex_buffer, indices[i-0], stride) );
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, indices[i-1], stride),
-                             get_vert(vertex_buffer, indices[i-3], stride),
-                             get_vert(vertex_buffer, indices[i-0], stride) );
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, indices[i-3], stride),
+                           get_vert(vertex_buffer, indices[i-2], stride),
+                           get_vert(vertex_buffer, indices[i-0], stride),
+                           get_vert(vertex_buffer, indices[i-1], stride),
+                           get_vert(vertex_buffer, indices[i-3], stride),
+                           get_vert(vertex_buffer, indices[i-0], stride) );
          }
       }
       break;
@@ -382,15 +447,46 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
       break;
 
    case PIPE_PRIM_TRIANGLES:
-      for (i = 2; i < nr; i += 3) {
+      for (i = 5; i < nr; i += 6) {
+         emit_tri_pair( setup,
+                        get_vert(vertex_buffer, i-5, stride),
+                        get_vert(vertex_buffer, i-4, stride),
+                        get_vert(vertex_buffer, i-3, stride),
+                        get_vert(vertex_buffer, i-2, stride),
+                        get_vert(vertex_buffer, i-1, stride),
+                        get_vert(vertex_buffer, i-0, stride) );
+      }
+      if (i - 3 < nr) {
          setup->triangle( setup,
-                          get_vert(vertex_buffer, i-2, stride),
-                          get_vert(vertex_buffer, i-1, stride),
-                          get_vert(vertex_buffer, i-0, stride) );
+                          get_vert(vertex_buffer, i-5, stride),
+                          get_vert(vertex_buffer, i-4, stride),
+                          get_vert(vertex_buffer, i-3, stride) );
       }
       break;
 
    case PIPE_PRIM_TRIANGLE_STRIP:
+      if (nr == 4) {
+         /* the two triangles emitted below */
+         if (flatshade_first) {
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, 0, stride),
+                           get_vert(vertex_buffer, 1, stride),
+                           get_vert(vertex_buffer, 2, stride),
+                           get_vert(vertex_buffer, 1, stride),
+                           get_vert(vertex_buffer, 3, stride),
+                           get_vert(vertex_buffer, 2, stride) );
+         }
+         else {
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, 0, stride),
+                           get_vert(vertex_buffer, 1, stride),
+                           get_vert(vertex_buffer, 2, stride),
+                           get_vert(vertex_buffer, 2, stride),
+                           get_vert(vertex_buffer, 1, stride),
+                           get_vert(vertex_buffer, 3, stride) );
+         }
+         break;
+      }
       if (flatshade_first) {
          for (i = 2; i < nr; i++) {
             /* emit first triangle vertex as first triangle vertex */
@@ -412,6 +508,28 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
       break;
 
    case PIPE_PRIM_TRIANGLE_FAN:
+      if (nr == 4) {
+         /* the two triangles emitted below */
+         if (flatshade_first) {
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, 1, stride),
+                           get_vert(vertex_buffer, 2, stride),
+                           get_vert(vertex_buffer, 0, stride),
+                           get_vert(vertex_buffer, 2, stride),
+                           get_vert(vertex_buffer, 3, stride),
+                           get_vert(vertex_buffer, 0, stride) );
+         }
+         else {
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, 0, stride),
+                           get_vert(vertex_buffer, 1, stride),
+                           get_vert(vertex_buffer, 2, stride),
+                           get_vert(vertex_buffer, 0, stride),
+                           get_vert(vertex_buffer, 2, stride),
+                           get_vert(vertex_buffer, 3, stride) );
+         }
+         break;
+      }
       if (flatshade_first) {
          for (i = 2; i < nr; i += 1) {
             /* emit first non-spoke vertex as first vertex */
@@ -437,27 +555,25 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
       if (flatshade_first) { 
          /* emit last quad vertex as first triangle vertex */
          for (i = 3; i < nr; i += 4) {
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, i-0, stride),
-                             get_vert(vertex_buffer, i-3, stride),
-                             get_vert(vertex_buffer, i-2, stride) );
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, i-0, stride),
-                             get_vert(vertex_buffer, i-2, stride),
-                             get_vert(vertex_buffer, i-1, stride) );
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, i-0, stride),
+                           get_vert(vertex_buffer, i-3, stride),
+                           get_vert(vertex_buffer, i-2, stride),
+                           get_vert(vertex_buffer, i-0, stride),
+                           get_vert(vertex_buffer, i-2, stride),
+                           get_vert(vertex_buffer, i-1, stride) );
          }
       }
       else {
          /* emit last quad vertex as last triangle vertex */
          for (i = 3; i < nr; i += 4) {
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, i-3, stride),
-                             get_vert(vertex_buffer, i-2, stride),
-                             get_vert(vertex_buffer, i-0, stride) );
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, i-2, stride),
-                             get_vert(vertex_buffer, i-1, stride),
-                             get_vert(vertex_buffer, i-0, stride) );
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, i-3, stride),
+                           get_vert(vertex_buffer, i-2, stride),
+                           get_vert(vertex_buffer, i-0, stride),
+                           get_vert(vertex_buffer, i-2, stride),
+                           get_vert(vertex_buffer, i-1, stride),
+                           get_vert(vertex_buffer, i-0, stride) );
          }
       }
       break;
@@ -467,27 +583,25 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
       if (flatshade_first) { 
          /* emit last quad vertex as first triangle vertex */
          for (i = 3; i < nr; i += 2) {
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, i-0, stride),
-                             get_vert(vertex_buffer, i-3, stride),
-                             get_vert(vertex_buffer, i-2, stride) );
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, i-0, stride),
-                             get_vert(vertex_buffer, i-1, stride),
-                             get_vert(vertex_buffer, i-3, stride) );
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, i-0, stride),
+                           get_vert(vertex_buffer, i-3, stride),
+                           get_vert(vertex_buffer, i-2, stride),
+                           get_vert(vertex_buffer, i-0, stride),
+                           get_vert(vertex_buffer, i-1, stride),
+                           get_vert(vertex_buffer, i-3, stride) );
          }
       }
       else {
          /* emit last quad vertex as last triangle vertex */
          for (i = 3; i < nr; i += 2) {
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, i-3, stride),
-                             get_vert(vertex_buffer, i-2, stride),
-                             get_vert(vertex_buffer, i-0, stride) );
-            setup->triangle( setup,
-                             get_vert(vertex_buffer, i-1, stride),
-                             get_vert(vertex_buffer, i-3, stride),
-                             get_vert(vertex_buffer, i-0, stride) );
+            emit_tri_pair( setup,
+                           get_vert(vertex_buffer, i-3, stride),
+                           get_vert(vertex_buffer, i-2, stride),
+                           get_vert(vertex_buffer, i-0, stride),
+                           get_vert(vertex_buffer, i-1, stride),
+                           get_vert(vertex_buffer, i-3, stride),
+                           get_vert(vertex_buffer, i-0, stride) );
          }
       }
       break;
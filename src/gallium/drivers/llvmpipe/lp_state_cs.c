@@ -0,0 +1,636 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Compute shaders.
+ *
+ * A shader is compiled when it's created: the code of the shader runs one
+ * vector of invocations of a block, and launch_grid runs it over all the
+ * invocations of all the blocks.  The blocks are shared out between the
+ * rasterizer threads, and each thread has scratch memory holding the LOCAL
+ * memory of the block it's running and the temporaries of its invocations.
+ *
+ * Only compute shaders loading and storing RAW buffers are supported:
+ * there's no sampling, no atomics and no GLOBAL or PRIVATE memory.
+ */
+
+#include "pipe/p_defines.h"
+#include "util/u_atomic.h"
+#include "util/u_format.h"
+#include "util/u_inlines.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/u_string.h"
+#include "tgsi/tgsi_dump.h"
+#include "tgsi/tgsi_parse.h"
+#include "gallivm/lp_bld_const.h"
+#include "gallivm/lp_bld_debug.h"
+#include "gallivm/lp_bld_flow.h"
+#include "gallivm/lp_bld_init.h"
+#include "gallivm/lp_bld_logic.h"
+#include "gallivm/lp_bld_struct.h"
+#include "gallivm/lp_bld_swizzle.h"
+#include "gallivm/lp_bld_tgsi.h"
+#include "gallivm/lp_bld_type.h"
+
+#include "lp_context.h"
+#include "lp_debug.h"
+#include "lp_flush.h"
+#include "lp_rast.h"
+#include "lp_screen.h"
+#include "lp_state.h"
+#include "lp_state_cs.h"
+#include "lp_texture.h"
+
+
+static unsigned cs_no = 0;
+
+/** Bound to constant buffer slots which have no buffer. */
+static const float fake_const_buf[4];
+
+/** Bound to resource slots which have no buffer, with a size of zero. */
+static uint32_t fake_resource[4];
+
+
+struct lp_cs_iface
+{
+   struct lp_build_tgsi_cs_iface base;
+
+   LLVMValueRef context_ptr;
+   LLVMValueRef shared_ptr;
+   unsigned local_mem_size;
+   unsigned input_mem_size;
+};
+
+
+static LLVMValueRef
+lp_cs_resource_ptr(const struct lp_build_tgsi_cs_iface *cs_iface,
+                   struct lp_build_tgsi_context * bld_base,
+                   unsigned index,
+                   LLVMValueRef *size)
+{
+   const struct lp_cs_iface *iface = (const struct lp_cs_iface *)cs_iface;
+   struct gallivm_state *gallivm = bld_base->base.gallivm;
+   LLVMValueRef lindex;
+
+   switch (index) {
+   case TGSI_RESOURCE_LOCAL:
+      *size = lp_build_const_int32(gallivm, iface->local_mem_size);
+      return iface->shared_ptr;
+   case TGSI_RESOURCE_INPUT:
+      *size = lp_build_const_int32(gallivm, iface->input_mem_size);
+      return lp_jit_cs_context_input(gallivm, iface->context_ptr);
+   default:
+      assert(index < LP_MAX_CS_RESOURCES);
+      lindex = lp_build_const_int32(gallivm, index);
+      *size = lp_build_array_get(gallivm,
+                                 lp_jit_cs_context_resource_sizes(gallivm,
+                                                                  iface->context_ptr),
+                                 lindex);
+      return lp_build_array_get(gallivm,
+                                lp_jit_cs_context_resources(gallivm,
+                                                            iface->context_ptr),
+                                lindex);
+   }
+}
+
+
+/**
+ * Generate the function running one vector of invocations.
+ *
+ * Any change here must be reflected in lp_jit.h's lp_jit_cs_func function
+ * pointer type, and vice-versa.
+ */
+static void
+generate_compute(struct lp_compute_shader *shader)
+{
+   struct gallivm_state *gallivm = shader->gallivm;
+   LLVMContextRef lc = gallivm->context;
+   LLVMBuilderRef builder = gallivm->builder;
+   LLVMTypeRef int32_type = LLVMInt32TypeInContext(lc);
+   LLVMTypeRef int8_ptr_type = LLVMPointerType(LLVMInt8TypeInContext(lc), 0);
+   LLVMTypeRef arg_types[8];
+   LLVMTypeRef func_type;
+   LLVMValueRef function, context_ptr, thread_start, phase, shared_ptr;
+   LLVMValueRef temps_ptr;
+   LLVMValueRef grid_size_ptr, block_size_ptr;
+   LLVMValueRef lanes[LP_MAX_VECTOR_LENGTH];
+   LLVMValueRef linear, size_x, size_xy, total;
+   LLVMBasicBlockRef block;
+   struct lp_type type;
+   struct lp_build_context uint_bld;
+   struct lp_build_mask_context mask;
+   struct lp_bld_tgsi_system_values system_values;
+   struct lp_cs_iface iface;
+   char func_name[64];
+   unsigned i;
+
+   memset(&type, 0, sizeof type);
+   type.floating = TRUE;      /* floating point values */
+   type.sign = TRUE;          /* values are signed */
+   type.norm = FALSE;         /* values are not limited to [0,1] or [-1,1] */
+   type.width = 32;           /* 32-bit float */
+   type.length = shader->vector_length;
+
+   lp_build_context_init(&uint_bld, gallivm, lp_uint_type(type));
+
+   util_snprintf(func_name, sizeof(func_name), "%s_main",
+                 lp_get_module_id(gallivm->module));
+
+   arg_types[0] = shader->jit_context_ptr_type;        /* context */
+   arg_types[1] = int32_type;                          /* block_x */
+   arg_types[2] = int32_type;                          /* block_y */
+   arg_types[3] = int32_type;                          /* block_z */
+   arg_types[4] = int32_type;                          /* thread_start */
+   arg_types[5] = int32_type;                          /* phase */
+   arg_types[6] = int8_ptr_type;                       /* shared */
+   arg_types[7] = int8_ptr_type;                       /* temps */
+
+   func_type = LLVMFunctionType(LLVMVoidTypeInContext(lc),
+                                arg_types, Elements(arg_types), 0);
+
+   function = LLVMAddFunction(gallivm->module, func_name, func_type);
+   LLVMSetFunctionCallConv(function, LLVMCCallConv);
+   shader->function = function;
+
+   LLVMAddAttribute(LLVMGetParam(function, 6), LLVMNoAliasAttribute);
+   LLVMAddAttribute(LLVMGetParam(function, 7), LLVMNoAliasAttribute);
+
+   memset(&system_values, 0, sizeof(system_values));
+
+   context_ptr  = LLVMGetParam(function, 0);
+   system_values.block_id[0] = LLVMGetParam(function, 1);
+   system_values.block_id[1] = LLVMGetParam(function, 2);
+   system_values.block_id[2] = LLVMGetParam(function, 3);
+   thread_start = LLVMGetParam(function, 4);
+   phase        = LLVMGetParam(function, 5);
+   shared_ptr   = LLVMGetParam(function, 6);
+   temps_ptr    = LLVMGetParam(function, 7);
+
+   lp_build_name(context_ptr, "context");
+   lp_build_name(system_values.block_id[0], "block_x");
+   lp_build_name(system_values.block_id[1], "block_y");
+   lp_build_name(system_values.block_id[2], "block_z");
+   lp_build_name(thread_start, "thread_start");
+   lp_build_name(phase, "phase");
+   lp_build_name(shared_ptr, "shared");
+   lp_build_name(temps_ptr, "temps");
+
+   block = LLVMAppendBasicBlockInContext(lc, function, "entry");
+   LLVMPositionBuilderAtEnd(builder, block);
+
+   grid_size_ptr = lp_jit_cs_context_grid_size(gallivm, context_ptr);
+   block_size_ptr = lp_jit_cs_context_block_size(gallivm, context_ptr);
+   for (i = 0; i < 3; i++) {
+      LLVMValueRef index = lp_build_const_int32(gallivm, i);
+      system_values.grid_size[i] =
+         lp_build_array_get(gallivm, grid_size_ptr, index);
+      system_values.block_size[i] =
+         lp_build_array_get(gallivm, block_size_ptr, index);
+   }
+
+   /*
+    * Split the linear ids of the invocations into thread ids.
+    */
+   for (i = 0; i < type.length; i++)
+      lanes[i] = lp_build_const_int32(gallivm, i);
+   linear = LLVMBuildAdd(builder,
+                         lp_build_broadcast_scalar(&uint_bld, thread_start),
+                         LLVMConstVector(lanes, type.length), "");
+
+   size_x = lp_build_broadcast_scalar(&uint_bld, system_values.block_size[0]);
+   size_xy = LLVMBuildMul(builder, system_values.block_size[0],
+                          system_values.block_size[1], "");
+   total = LLVMBuildMul(builder, size_xy, system_values.block_size[2], "");
+   size_xy = lp_build_broadcast_scalar(&uint_bld, size_xy);
+
+   system_values.thread_id[0] = LLVMBuildURem(builder, linear, size_x, "");
+   system_values.thread_id[1] =
+      LLVMBuildURem(builder, LLVMBuildUDiv(builder, linear, size_x, ""),
+                    lp_build_broadcast_scalar(&uint_bld,
+                                              system_values.block_size[1]),
+                    "");
+   system_values.thread_id[2] = LLVMBuildUDiv(builder, linear, size_xy, "");
+
+   /* The last vector of a block may have invocations past its end. */
+   lp_build_mask_begin(&mask, gallivm, type,
+                       lp_build_cmp(&uint_bld, PIPE_FUNC_LESS, linear,
+                                    lp_build_broadcast_scalar(&uint_bld,
+                                                              total)));
+
+   memset(&iface, 0, sizeof iface);
+   iface.base.resource_ptr = lp_cs_resource_ptr;
+   iface.base.phase = phase;
+   iface.base.temps_ptr = temps_ptr;
+   iface.context_ptr = context_ptr;
+   iface.shared_ptr = shared_ptr;
+   iface.local_mem_size = shader->req_local_mem;
+   iface.input_mem_size = shader->req_input_mem;
+
+   lp_build_tgsi_soa(gallivm, shader->tokens, type, &mask,
+                     lp_jit_cs_context_constants(gallivm, context_ptr),
+                     lp_jit_cs_context_num_constants(gallivm, context_ptr),
+                     &system_values,
+                     NULL, NULL,
+                     context_ptr, NULL,
+                     NULL, &shader->info, NULL, &iface.base);
+
+   lp_build_mask_end(&mask);
+
+   LLVMBuildRetVoid(builder);
+
+   gallivm_verify_function(gallivm, function);
+}
+
+
+/**
+ * Check that the shader only uses what generate_compute() supports.
+ */
+static boolean
+check_compute_shader(const struct tgsi_token *tokens,
+                     const struct tgsi_shader_info *info)
+{
+   struct tgsi_parse_context parse;
+   boolean supported = TRUE;
+   unsigned i;
+
+   if (info->file_count[TGSI_FILE_SAMPLER] ||
+       info->file_count[TGSI_FILE_SAMPLER_VIEW]) {
+      debug_printf("llvmpipe: no sampling in compute shaders\n");
+      return FALSE;
+   }
+
+   for (i = TGSI_OPCODE_ATOMUADD; i <= TGSI_OPCODE_ATOMIMAX; i++) {
+      if (info->opcode_count[i]) {
+         debug_printf("llvmpipe: no atomics in compute shaders\n");
+         return FALSE;
+      }
+   }
+
+   tgsi_parse_init(&parse, tokens);
+   while (supported && !tgsi_parse_end_of_tokens(&parse)) {
+      tgsi_parse_token(&parse);
+
+      if (parse.FullToken.Token.Type == TGSI_TOKEN_TYPE_DECLARATION) {
+         const struct tgsi_full_declaration *decl =
+            &parse.FullToken.FullDeclaration;
+
+         if (decl->Declaration.File == TGSI_FILE_RESOURCE) {
+            for (i = decl->Range.First; i <= decl->Range.Last; i++) {
+               if (i == TGSI_RESOURCE_LOCAL || i == TGSI_RESOURCE_INPUT)
+                  continue;
+               if (i >= LP_MAX_CS_RESOURCES ||
+                   decl->Resource.Resource != TGSI_TEXTURE_BUFFER ||
+                   !decl->Resource.Raw) {
+                  debug_printf("llvmpipe: unsupported resource RES[%u]\n", i);
+                  supported = FALSE;
+               }
+            }
+         }
+      }
+      else if (parse.FullToken.Token.Type == TGSI_TOKEN_TYPE_INSTRUCTION) {
+         const struct tgsi_full_instruction *inst =
+            &parse.FullToken.FullInstruction;
+
+         for (i = 0; i < inst->Instruction.NumSrcRegs; i++) {
+            if (inst->Src[i].Register.File == TGSI_FILE_RESOURCE &&
+                (i != 0 || inst->Instruction.Opcode != TGSI_OPCODE_LOAD))
+               supported = FALSE;
+         }
+         for (i = 0; i < inst->Instruction.NumDstRegs; i++) {
+            if (inst->Dst[i].Register.File == TGSI_FILE_RESOURCE &&
+                inst->Instruction.Opcode != TGSI_OPCODE_STORE)
+               supported = FALSE;
+         }
+         if (!supported)
+            debug_printf("llvmpipe: unsupported use of a resource\n");
+      }
+   }
+   tgsi_parse_free(&parse);
+
+   return supported;
+}
+
+
+static void *
+llvmpipe_create_compute_state(struct pipe_context *pipe,
+                              const struct pipe_compute_state *templ)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   struct lp_compute_shader *shader;
+   char module_name[64];
+
+   if (templ->req_local_mem > LP_MAX_CS_LOCAL_MEM ||
+       templ->req_input_mem > LP_MAX_CS_INPUT_MEM ||
+       templ->req_private_mem)
+      return NULL;
+
+   shader = CALLOC_STRUCT(lp_compute_shader);
+   if (!shader)
+      return NULL;
+
+   shader->no = cs_no++;
+   shader->tokens = tgsi_dup_tokens(templ->prog);
+   if (!shader->tokens) {
+      FREE(shader);
+      return NULL;
+   }
+
+   tgsi_scan_shader(shader->tokens, &shader->info);
+
+   if (LP_DEBUG & DEBUG_TGSI) {
+      debug_printf("llvmpipe: Create compute shader %p:\n", (void *)shader);
+      tgsi_dump(shader->tokens, 0);
+   }
+
+   if (!check_compute_shader(shader->tokens, &shader->info)) {
+      FREE((void *)shader->tokens);
+      FREE(shader);
+      return NULL;
+   }
+
+   shader->req_local_mem = templ->req_local_mem;
+   shader->req_input_mem = templ->req_input_mem;
+   shader->vector_length = MIN2(lp_native_vector_width / 32, 16);
+   shader->num_phases = shader->info.opcode_count[TGSI_OPCODE_BARRIER] + 1;
+   if (shader->num_phases > 1) {
+      shader->temps_size = (shader->info.file_max[TGSI_FILE_TEMPORARY] + 1) *
+                           TGSI_NUM_CHANNELS * shader->vector_length * 4;
+   }
+
+   util_snprintf(module_name, sizeof(module_name), "cs%u", shader->no);
+
+   shader->gallivm = gallivm_create(module_name, llvmpipe->context, NULL);
+   if (!shader->gallivm) {
+      FREE((void *)shader->tokens);
+      FREE(shader);
+      return NULL;
+   }
+
+   lp_jit_init_cs_types(shader);
+   generate_compute(shader);
+
+   gallivm_compile_module(shader->gallivm);
+   shader->jit_function = (lp_jit_cs_func)
+      gallivm_jit_function(shader->gallivm, shader->function);
+   gallivm_free_ir(shader->gallivm);
+
+   return shader;
+}
+
+
+static void
+llvmpipe_bind_compute_state(struct pipe_context *pipe, void *cs)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+
+   llvmpipe->cs = (struct lp_compute_shader *)cs;
+}
+
+
+static void
+llvmpipe_delete_compute_state(struct pipe_context *pipe, void *cs)
+{
+   struct lp_compute_shader *shader = (struct lp_compute_shader *)cs;
+
+   if (!shader)
+      return;
+
+   gallivm_destroy(shader->gallivm);
+   FREE((void *)shader->tokens);
+   FREE(shader);
+}
+
+
+static void
+llvmpipe_set_compute_resources(struct pipe_context *pipe,
+                               unsigned start, unsigned count,
+                               struct pipe_surface **resources)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   unsigned i;
+
+   assert(start + count <= Elements(llvmpipe->cs_resources));
+
+   for (i = 0; i < count; i++) {
+      pipe_surface_reference(&llvmpipe->cs_resources[start + i],
+                             resources ? resources[i] : NULL);
+   }
+}
+
+
+/**
+ * GLOBAL memory isn't supported, shaders using it fail to compile, so there
+ * is nothing to bind.  The handles are left alone.
+ */
+static void
+llvmpipe_set_global_binding(struct pipe_context *pipe,
+                            unsigned first, unsigned count,
+                            struct pipe_resource **resources,
+                            uint32_t **handles)
+{
+}
+
+
+/**
+ * Everything the rasterizer threads need to run a grid.
+ */
+struct lp_cs_job
+{
+   struct lp_jit_cs_context context;
+   lp_jit_cs_func func;
+
+   uint8_t *input;
+
+   unsigned grid_size[3];
+   uint64_t num_blocks;
+   uint64_t next_block;
+
+   unsigned num_phases;
+   unsigned vector_length;
+   unsigned num_vectors;        /**< vectors of invocations per block */
+   unsigned temps_size;
+
+   /** Per thread scratch memory: LOCAL memory followed by temporaries */
+   uint8_t *scratch;
+   unsigned scratch_size;
+   unsigned local_size;
+};
+
+
+/**
+ * Run blocks until there are none left.  Called on each rasterizer thread.
+ */
+static void
+lp_cs_run_blocks(void *data, unsigned thread_index)
+{
+   struct lp_cs_job *job = (struct lp_cs_job *)data;
+   uint8_t *shared = job->scratch + thread_index * job->scratch_size;
+   uint8_t *temps = shared + job->local_size;
+   uint64_t block;
+
+   while ((block = p_atomic_inc_return(&job->next_block) - 1) <
+          job->num_blocks) {
+      unsigned x = block % job->grid_size[0];
+      unsigned y = (block / job->grid_size[0]) % job->grid_size[1];
+      unsigned z = block / ((uint64_t)job->grid_size[0] * job->grid_size[1]);
+      unsigned phase, v;
+
+      /* Each phase runs for the whole block before the next one starts,
+       * which is what makes barriers work.
+       */
+      for (phase = 0; phase < job->num_phases; phase++) {
+         for (v = 0; v < job->num_vectors; v++) {
+            job->func(&job->context, x, y, z, v * job->vector_length,
+                      phase, shared, temps + v * job->temps_size);
+         }
+      }
+   }
+}
+
+
+static void
+llvmpipe_launch_grid(struct pipe_context *pipe,
+                     const uint *block_layout, const uint *grid_layout,
+                     uint32_t pc, const void *input)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+   struct llvmpipe_screen *screen = llvmpipe_screen(pipe->screen);
+   struct lp_compute_shader *shader = llvmpipe->cs;
+   struct lp_cs_job job;
+   unsigned num_threads = MAX2(1, screen->num_threads);
+   unsigned block_threads;
+   unsigned i;
+
+   if (!shader || !shader->jit_function)
+      return;
+
+   block_threads = block_layout[0] * block_layout[1] * block_layout[2];
+   if (!block_threads || block_threads > LP_MAX_CS_BLOCK_SIZE ||
+       !grid_layout[0] || !grid_layout[1] || !grid_layout[2])
+      return;
+
+   memset(&job, 0, sizeof job);
+   job.func = shader->jit_function;
+
+   for (i = 0; i < LP_MAX_TGSI_CONST_BUFFERS; i++) {
+      const struct pipe_constant_buffer *cb =
+         &llvmpipe->constants[PIPE_SHADER_COMPUTE][i];
+      const ubyte *data = NULL;
+
+      if (cb->buffer)
+         data = (const ubyte *) llvmpipe_resource_data(cb->buffer);
+      else if (cb->user_buffer)
+         data = (const ubyte *) cb->user_buffer;
+
+      if (data) {
+         job.context.constants[i] =
+            (const float *)(data + cb->buffer_offset);
+         job.context.num_constants[i] =
+            MIN2(cb->buffer_size, LP_MAX_TGSI_CONST_BUFFER_SIZE) /
+            (sizeof(float) * 4);
+      }
+      else {
+         job.context.constants[i] = fake_const_buf;
+      }
+   }
+
+   for (i = 0; i < LP_MAX_CS_RESOURCES; i++) {
+      const struct pipe_surface *surf = llvmpipe->cs_resources[i];
+
+      if (surf && !llvmpipe_resource_is_texture(surf->texture)) {
+         const unsigned cpp = util_format_get_blocksize(surf->format);
+         const unsigned first = surf->u.buf.first_element;
+         const unsigned last = MIN2(surf->u.buf.last_element,
+                                    surf->texture->width0 / cpp - 1);
+
+         job.context.resources[i] =
+            (uint8_t *)llvmpipe_resource_data(surf->texture) + first * cpp;
+         job.context.resource_sizes[i] =
+            last >= first ? (last - first + 1) * cpp : 0;
+      }
+      else {
+         job.context.resources[i] = (uint8_t *)fake_resource;
+      }
+   }
+
+   /* Keep the INPUT memory in bounds even without an input. */
+   job.input = MALLOC(MAX2(shader->req_input_mem, 4));
+   if (!job.input)
+      return;
+   if (input)
+      memcpy(job.input, input, shader->req_input_mem);
+   else
+      memset(job.input, 0, shader->req_input_mem);
+   job.context.input = job.input;
+
+   for (i = 0; i < 3; i++) {
+      job.context.grid_size[i] = job.grid_size[i] = grid_layout[i];
+      job.context.block_size[i] = block_layout[i];
+   }
+   job.num_blocks = (uint64_t)grid_layout[0] * grid_layout[1] *
+                    grid_layout[2];
+
+   job.num_phases = shader->num_phases;
+   job.vector_length = shader->vector_length;
+   job.num_vectors = DIV_ROUND_UP(block_threads, shader->vector_length);
+   job.temps_size = shader->temps_size;
+   job.local_size = align(shader->req_local_mem, 64);
+   job.scratch_size = align(job.local_size +
+                            job.num_vectors * job.temps_size, 64);
+   job.scratch = align_malloc(MAX2(num_threads * job.scratch_size, 64), 64);
+   if (!job.scratch) {
+      FREE(job.input);
+      return;
+   }
+
+   /* Queue the rendering done so far, the rasterizer threads get to the
+    * grid right after it.
+    */
+   llvmpipe_flush(pipe, NULL, __FUNCTION__);
+
+   pipe_mutex_lock(screen->rast_mutex);
+   lp_rast_run_job(screen->rast, lp_cs_run_blocks, &job);
+   pipe_mutex_unlock(screen->rast_mutex);
+
+   align_free(job.scratch);
+   FREE(job.input);
+}
+
+
+void
+llvmpipe_init_cs_funcs(struct llvmpipe_context *llvmpipe)
+{
+   llvmpipe->pipe.create_compute_state = llvmpipe_create_compute_state;
+   llvmpipe->pipe.bind_compute_state = llvmpipe_bind_compute_state;
+   llvmpipe->pipe.delete_compute_state = llvmpipe_delete_compute_state;
+   llvmpipe->pipe.set_compute_resources = llvmpipe_set_compute_resources;
+   llvmpipe->pipe.set_global_binding = llvmpipe_set_global_binding;
+   llvmpipe->pipe.launch_grid = llvmpipe_launch_grid;
+}
@@ -0,0 +1,82 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+
+
+#ifndef LP_STATE_CS_H_
+#define LP_STATE_CS_H_
+
+
+#include "pipe/p_compiler.h"
+#include "pipe/p_state.h"
+#include "tgsi/tgsi_scan.h" /* for tgsi_shader_info */
+#include "gallivm/lp_bld.h"
+#include "lp_jit.h"
+
+
+struct gallivm_state;
+struct llvmpipe_context;
+
+
+/**
+ * A compute shader.
+ *
+ * There are no variants: nothing outside of the shader affects its code.
+ * The code runs the invocations of a block one vector at a time; shaders
+ * with barriers are run in phases, see lp_build_tgsi_cs_iface.
+ */
+struct lp_compute_shader
+{
+   const struct tgsi_token *tokens;
+   struct tgsi_shader_info info;
+
+   unsigned no;
+
+   unsigned req_local_mem;
+   unsigned req_input_mem;
+
+   struct gallivm_state *gallivm;
+   LLVMTypeRef jit_context_ptr_type;
+   LLVMValueRef function;
+   lp_jit_cs_func jit_function;
+
+   /** Invocations run by each call of jit_function */
+   unsigned vector_length;
+
+   /** Number of phases the code is split in by its barriers */
+   unsigned num_phases;
+
+   /** Bytes of temporaries of each vector of invocations, with phases */
+   unsigned temps_size;
+};
+
+
+void
+llvmpipe_init_cs_funcs(struct llvmpipe_context *llvmpipe);
+
+
+#endif /* LP_STATE_CS_H_ */
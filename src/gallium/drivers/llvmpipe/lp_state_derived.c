@@ -213,6 +213,9 @@ void llvmpipe_update_derived( struct llvmpipe_context *llvmpipe )
                           LP_NEW_OCCLUSION_QUERY))
       llvmpipe_update_fs( llvmpipe );
 
+   if (llvmpipe->nr_fs_pending)
+      llvmpipe_update_fs_code( llvmpipe );
+
    if (llvmpipe->dirty & (LP_NEW_RASTERIZER)) {
       boolean discard =
          (llvmpipe->sample_mask & 1) == 0 ||
@@ -67,6 +67,10 @@
 #include "util/u_string.h"
 #include "util/simple_list.h"
 #include "util/u_dual_blend.h"
+#include "util/u_cpu_detect.h"
+#include "util/disk_cache.h"
+#include "util/hash_table.h"
+#include "util/mesa-sha1.h"
 #include "os/os_time.h"
 #include "pipe/p_shader_tokens.h"
 #include "draw/draw_context.h"
@@ -101,6 +105,7 @@
 #include "lp_flush.h"
 #include "lp_state_fs.h"
 #include "lp_rast.h"
+#include "lp_screen.h"
 
 
 /** Fragment shader number (for debugging) */
@@ -422,7 +427,7 @@ generate_fs_loop(struct gallivm_state *gallivm,
                      consts_ptr, num_consts_ptr, &system_values,
                      interp->inputs,
                      outputs, context_ptr, thread_data_ptr,
-                     sampler, &shader->info.base, NULL);
+                     sampler, &shader->info.base, NULL, NULL);
 
    /* Alpha test */
    if (key->alpha.enabled) {
@@ -2249,8 +2254,9 @@ generate_fragment(struct llvmpipe_context *lp,
 
    blend_vec_type = lp_build_vec_type(gallivm, blend_type);
 
-   util_snprintf(func_name, sizeof(func_name), "fs%u_variant%u_%s",
-                 shader->no, variant->no, partial_mask ? "partial" : "whole");
+   util_snprintf(func_name, sizeof(func_name), "%s_%s",
+                 lp_get_module_id(gallivm->module),
+                 partial_mask ? "partial" : "whole");
 
    arg_types[0] = variant->jit_context_ptr_type;       /* context */
    arg_types[1] = int32_type;                          /* x */
@@ -2544,10 +2550,364 @@ lp_debug_fs_variant(const struct lp_fragment_shader_variant *variant)
    tgsi_dump(variant->shader->base.tokens, 0);
    dump_fs_variant_key(&variant->key);
    debug_printf("variant->opaque = %u\n", variant->opaque);
+   debug_printf("variant->zmax_test = %u\n", variant->zmax_test);
    debug_printf("\n");
 }
 
 
+/*
+ * Fragment shader code cache.
+ *
+ * Compiled code is looked up by shader tokens and variant key in a table
+ * owned by the screen, so that contexts sharing a screen, or shaders
+ * recreated from the same tokens, don't compile the same code twice.
+ * When the disk cache is enabled the object code is written there as
+ * well, and later runs only build the IR and skip LLVM code generation.
+ * Otherwise big shaders are first compiled without optimizations, and
+ * replaced once an optimized build is done compiling in the background.
+ */
+
+/**
+ * Optimized build of some code, compiled by a gallivm compile thread.
+ */
+struct lp_fs_async
+{
+   struct gallivm_state *gallivm;
+   LLVMValueRef function[2];
+   lp_jit_frag_func jit_function[2];
+   int done;
+};
+
+/**
+ * JIT code shared by all the variants generated from the same tokens and
+ * variant key, whichever context they belong to.
+ */
+struct lp_fs_code
+{
+   unsigned refcount;           /**< protected by screen->fs_code_mutex */
+
+   uint32_t hash;
+   unsigned key_size;
+   void *key;                   /**< tokens followed by the variant key */
+
+   struct gallivm_state *gallivm;
+   lp_jit_frag_func jit_function[2];
+   unsigned nr_instrs;
+
+   /** The optimized build replacing the functions above, if any */
+   struct lp_fs_async *async;
+};
+
+
+/**
+ * Called on the compile thread once the optimized build is compiled.
+ */
+static void
+lp_fs_async_done(struct gallivm_state *gallivm, void *data)
+{
+   struct lp_fs_async *async = data;
+
+   if (async->function[RAST_EDGE_TEST]) {
+      async->jit_function[RAST_EDGE_TEST] = (lp_jit_frag_func)
+         gallivm_jit_function(gallivm, async->function[RAST_EDGE_TEST]);
+   }
+
+   if (async->function[RAST_WHOLE]) {
+      async->jit_function[RAST_WHOLE] = (lp_jit_frag_func)
+         gallivm_jit_function(gallivm, async->function[RAST_WHOLE]);
+   } else {
+      async->jit_function[RAST_WHOLE] = async->jit_function[RAST_EDGE_TEST];
+   }
+
+   gallivm_free_ir(gallivm);
+
+   /* Also a barrier, so the functions are seen before done. */
+   p_atomic_inc(&async->done);
+}
+
+
+/**
+ * Get the best functions available in \p code.
+ * \return FALSE if better ones are still being compiled.
+ */
+static boolean
+lp_fs_code_get_functions(const struct lp_fs_code *code,
+                         lp_jit_frag_func jit_function[2])
+{
+   if (code->async && p_atomic_read(&code->async->done)) {
+      jit_function[RAST_EDGE_TEST] = code->async->jit_function[RAST_EDGE_TEST];
+      jit_function[RAST_WHOLE] = code->async->jit_function[RAST_WHOLE];
+      return TRUE;
+   }
+
+   jit_function[RAST_EDGE_TEST] = code->jit_function[RAST_EDGE_TEST];
+   jit_function[RAST_WHOLE] = code->jit_function[RAST_WHOLE];
+   return code->async == NULL;
+}
+
+
+static void
+lp_fs_async_destroy(struct lp_fs_async *async)
+{
+   if (async) {
+      /* This waits for the compile thread to be done with it. */
+      gallivm_destroy(async->gallivm);
+      FREE(async);
+   }
+}
+
+
+static uint32_t
+lp_fs_code_hash(const void *key)
+{
+   const struct lp_fs_code *code = key;
+   return code->hash;
+}
+
+
+static bool
+lp_fs_code_equals(const void *a, const void *b)
+{
+   const struct lp_fs_code *code_a = a;
+   const struct lp_fs_code *code_b = b;
+
+   return code_a->key_size == code_b->key_size &&
+          memcmp(code_a->key, code_b->key, code_a->key_size) == 0;
+}
+
+
+/**
+ * Fill in the lookup key of \p code for the given shader and variant key.
+ * Returns FALSE on out of memory.
+ */
+static boolean
+lp_fs_code_init_key(struct lp_fs_code *code,
+                    const struct lp_fragment_shader *shader,
+                    const struct lp_fragment_shader_variant_key *key)
+{
+   unsigned tokens_size =
+      tgsi_num_tokens(shader->base.tokens) * sizeof(struct tgsi_token);
+
+   code->key_size = tokens_size + shader->variant_key_size;
+   code->key = MALLOC(code->key_size);
+   if (!code->key)
+      return FALSE;
+
+   memcpy(code->key, shader->base.tokens, tokens_size);
+   memcpy((char *)code->key + tokens_size, key, shader->variant_key_size);
+   code->hash = _mesa_hash_data(code->key, code->key_size);
+   return TRUE;
+}
+
+
+/**
+ * Look for already compiled code, and take a reference to it if found.
+ */
+static struct lp_fs_code *
+lp_fs_code_lookup(struct llvmpipe_screen *screen,
+                  const struct lp_fragment_shader *shader,
+                  const struct lp_fragment_shader_variant_key *key)
+{
+   struct lp_fs_code search;
+   struct hash_entry *entry;
+   struct lp_fs_code *code = NULL;
+
+   if (!lp_fs_code_init_key(&search, shader, key))
+      return NULL;
+
+   pipe_mutex_lock(screen->fs_code_mutex);
+   entry = _mesa_hash_table_search(screen->fs_code_cache, &search);
+   if (entry) {
+      code = entry->data;
+      code->refcount++;
+   }
+   pipe_mutex_unlock(screen->fs_code_mutex);
+
+   FREE(search.key);
+   return code;
+}
+
+
+/**
+ * Wrap the code freshly compiled in variant->gallivm into a lp_fs_code
+ * and publish it.  If another context got there first, its code is used
+ * instead and ours thrown away.  Takes ownership of variant->gallivm and
+ * of \p async, the optimized build of the same code if any.
+ */
+static struct lp_fs_code *
+lp_fs_code_insert(struct llvmpipe_screen *screen,
+                  const struct lp_fragment_shader *shader,
+                  struct lp_fragment_shader_variant *variant,
+                  struct lp_fs_async *async)
+{
+   struct lp_fs_code *code;
+   struct hash_entry *entry;
+
+   code = CALLOC_STRUCT(lp_fs_code);
+   if (!code) {
+      lp_fs_async_destroy(async);
+      return NULL;
+   }
+
+   if (!lp_fs_code_init_key(code, shader, &variant->key)) {
+      lp_fs_async_destroy(async);
+      FREE(code);
+      return NULL;
+   }
+
+   code->refcount = 1;
+   code->async = async;
+   code->gallivm = variant->gallivm;
+   code->jit_function[RAST_EDGE_TEST] = variant->jit_function[RAST_EDGE_TEST];
+   code->jit_function[RAST_WHOLE] = variant->jit_function[RAST_WHOLE];
+   code->nr_instrs = variant->nr_instrs;
+   variant->gallivm = NULL;
+
+   pipe_mutex_lock(screen->fs_code_mutex);
+   entry = _mesa_hash_table_search(screen->fs_code_cache, code);
+   if (entry) {
+      struct lp_fs_code *existing = entry->data;
+      existing->refcount++;
+      pipe_mutex_unlock(screen->fs_code_mutex);
+
+      lp_fs_async_destroy(code->async);
+      gallivm_destroy(code->gallivm);
+      FREE(code->key);
+      FREE(code);
+      return existing;
+   }
+   /* If this fails the code just won't be shared. */
+   _mesa_hash_table_insert(screen->fs_code_cache, code, code);
+   pipe_mutex_unlock(screen->fs_code_mutex);
+
+   return code;
+}
+
+
+/**
+ * Drop a reference to shared code, freeing it with the last one.
+ */
+static void
+lp_fs_code_release(struct llvmpipe_screen *screen, struct lp_fs_code *code)
+{
+   struct hash_entry *entry;
+   unsigned refcount;
+
+   pipe_mutex_lock(screen->fs_code_mutex);
+   refcount = --code->refcount;
+   if (!refcount) {
+      entry = _mesa_hash_table_search(screen->fs_code_cache, code);
+      if (entry && entry->data == code)
+         _mesa_hash_table_remove(screen->fs_code_cache, entry);
+   }
+   pipe_mutex_unlock(screen->fs_code_mutex);
+
+   if (!refcount) {
+      lp_fs_async_destroy(code->async);
+      gallivm_destroy(code->gallivm);
+      FREE(code->key);
+      FREE(code);
+   }
+}
+
+
+/**
+ * Compute the on-disk cache key of a variant.  Besides the tokens and the
+ * variant key, the object code depends on the LLVM version and the CPU
+ * features it was generated for.
+ *
+ * Returns FALSE if the disk cache can't be used.
+ */
+static boolean
+lp_fs_disk_cache_key(struct llvmpipe_screen *screen,
+                     const struct lp_fragment_shader *shader,
+                     const struct lp_fragment_shader_variant_key *key,
+                     cache_key disk_key)
+{
+#if defined(HAVE_SHA1)
+   static const char build_id[] = "llvmpipe " PACKAGE_VERSION;
+   unsigned llvm_version = HAVE_LLVM * 100 + MESA_LLVM_VERSION_PATCH;
+   unsigned debug_flags = gallivm_debug;
+   struct mesa_sha1 *ctx;
+
+   if (!screen->disk_shader_cache)
+      return FALSE;
+
+   ctx = _mesa_sha1_init();
+   if (!ctx)
+      return FALSE;
+
+   _mesa_sha1_update(ctx, build_id, sizeof(build_id));
+   _mesa_sha1_update(ctx, &llvm_version, sizeof(llvm_version));
+   _mesa_sha1_update(ctx, &debug_flags, sizeof(debug_flags));
+   _mesa_sha1_update(ctx, &util_cpu_caps, sizeof(util_cpu_caps));
+   _mesa_sha1_update(ctx, shader->base.tokens,
+                     tgsi_num_tokens(shader->base.tokens) *
+                     sizeof(struct tgsi_token));
+   _mesa_sha1_update(ctx, key, shader->variant_key_size);
+   return _mesa_sha1_final(ctx, disk_key);
+#else
+   return FALSE;
+#endif
+}
+
+
+boolean
+llvmpipe_init_fs_code_cache(struct llvmpipe_screen *screen)
+{
+   pipe_mutex_init(screen->fs_code_mutex);
+
+   screen->fs_code_cache = _mesa_hash_table_create(NULL, lp_fs_code_hash,
+                                                   lp_fs_code_equals);
+   if (!screen->fs_code_cache) {
+      pipe_mutex_destroy(screen->fs_code_mutex);
+      return FALSE;
+   }
+
+   /* The object cache is only hooked into MCJIT with LLVM 3.6+. */
+#if HAVE_LLVM >= 0x0306
+   screen->disk_shader_cache = disk_cache_create();
+#endif
+   return TRUE;
+}
+
+
+void
+llvmpipe_destroy_fs_code_cache(struct llvmpipe_screen *screen)
+{
+   /* All the variants are gone with their contexts by now. */
+   assert(!screen->fs_code_cache->entries);
+
+   if (screen->disk_shader_cache)
+      disk_cache_destroy(screen->disk_shader_cache);
+   _mesa_hash_table_destroy(screen->fs_code_cache, NULL);
+   pipe_mutex_destroy(screen->fs_code_mutex);
+}
+
+
+/**
+ * Build the IR of the variant's functions in variant->gallivm.
+ */
+static void
+generate_variant_functions(struct llvmpipe_context *lp,
+                           struct lp_fragment_shader *shader,
+                           struct lp_fragment_shader_variant *variant)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
+
+   variant->gallivm->helpers = screen->helpers;
+
+   lp_jit_init_types(variant);
+
+   generate_fragment(lp, shader, variant, RAST_EDGE_TEST);
+
+   if (variant->opaque) {
+      /* Specialized shader, which doesn't need to read the color buffer. */
+      generate_fragment(lp, shader, variant, RAST_WHOLE);
+   }
+}
+
+
 /**
  * Generate a new fragment shader variant from the shader code and
  * other state indicated by the key.
@@ -2557,24 +2917,21 @@ generate_variant(struct llvmpipe_context *lp,
                  struct lp_fragment_shader *shader,
                  const struct lp_fragment_shader_variant_key *key)
 {
+   struct llvmpipe_screen *screen = llvmpipe_screen(lp->pipe.screen);
    struct lp_fragment_shader_variant *variant;
    const struct util_format_description *cbuf0_format_desc;
    boolean fullcolormask;
    char module_name[64];
+   struct lp_cached_code cached;
+   cache_key disk_key;
+   boolean use_disk_cache;
+   boolean disk_cache_hit;
+   struct lp_fs_async *async = NULL;
 
    variant = CALLOC_STRUCT(lp_fragment_shader_variant);
    if (!variant)
       return NULL;
 
-   util_snprintf(module_name, sizeof(module_name), "fs%u_variant%u",
-                 shader->no, shader->variants_created);
-
-   variant->gallivm = gallivm_create(module_name, lp->context);
-   if (!variant->gallivm) {
-      FREE(variant);
-      return NULL;
-   }
-
    variant->shader = shader;
    variant->list_item_global.base = variant;
    variant->list_item_local.base = variant;
@@ -2602,6 +2959,28 @@ generate_variant(struct llvmpipe_context *lp,
          !shader->info.base.uses_kill
       ? TRUE : FALSE;
 
+   /*
+    * The rasterizer tracks an upper bound of the depth values in each tile
+    * (see lp_rast_depth_reject()).  Depth clamping and shader depth writes
+    * change the depth compared against it, and stencil ops may need to see
+    * the fragments failing the depth test.
+    */
+   variant->zmax_test =
+         key->depth.enabled &&
+         (key->depth.func == PIPE_FUNC_LESS ||
+          key->depth.func == PIPE_FUNC_LEQUAL) &&
+         !key->depth_clamp &&
+         !key->stencil[0].enabled &&
+         !shader->info.base.writes_z;
+
+   variant->zmax_invalidate =
+         key->depth.enabled &&
+         key->depth.writemask &&
+         key->depth.func != PIPE_FUNC_NEVER &&
+         key->depth.func != PIPE_FUNC_LESS &&
+         key->depth.func != PIPE_FUNC_LEQUAL &&
+         key->depth.func != PIPE_FUNC_EQUAL;
+
    if ((shader->info.base.num_tokens <= 1) &&
        !key->depth.enabled && !key->stencil[0].enabled) {
       variant->ps_inv_multiplier = 0;
@@ -2613,18 +2992,94 @@ generate_variant(struct llvmpipe_context *lp,
       lp_debug_fs_variant(variant);
    }
 
-   lp_jit_init_types(variant);
-   
-   if (variant->jit_function[RAST_EDGE_TEST] == NULL)
-      generate_fragment(lp, shader, variant, RAST_EDGE_TEST);
+   /*
+    * Reuse the code if some context already compiled it.
+    */
+   variant->code = lp_fs_code_lookup(screen, shader, key);
+   if (variant->code) {
+      variant->pending = !lp_fs_code_get_functions(variant->code,
+                                                   variant->jit_function);
+      variant->nr_instrs = variant->code->nr_instrs;
+      return variant;
+   }
+
+   memset(&cached, 0, sizeof cached);
+   disk_cache_hit = FALSE;
+   use_disk_cache = lp_fs_disk_cache_key(screen, shader, key, disk_key);
+   if (use_disk_cache) {
+      pipe_mutex_lock(screen->fs_code_mutex);
+      cached.data = disk_cache_get(screen->disk_shader_cache, disk_key,
+                                   &cached.data_size);
+      pipe_mutex_unlock(screen->fs_code_mutex);
+      disk_cache_hit = cached.data != NULL;
+
+      /* The cached object refers to its functions by name, so the name
+       * must not depend on the order shaders get created in.
+       */
+      util_snprintf(module_name, sizeof(module_name),
+                    "fs_%02x%02x%02x%02x%02x%02x%02x%02x",
+                    disk_key[0], disk_key[1], disk_key[2], disk_key[3],
+                    disk_key[4], disk_key[5], disk_key[6], disk_key[7]);
+   }
+   else {
+      util_snprintf(module_name, sizeof(module_name), "fs%u_variant%u",
+                    shader->no, variant->no);
+   }
+
+   /*
+    * Objects for the disk cache are compiled right away.  Otherwise the
+    * module gets a LLVM context of its own, so that it can be compiled in
+    * the background if it's big.
+    */
+   variant->gallivm = gallivm_create(module_name,
+                                     use_disk_cache ? lp->context : NULL,
+                                     use_disk_cache ? &cached : NULL);
+   if (!variant->gallivm) {
+      free(cached.data);
+      FREE(variant);
+      return NULL;
+   }
 
-   if (variant->jit_function[RAST_WHOLE] == NULL) {
-      if (variant->opaque) {
-         /* Specialized shader, which doesn't need to read the color buffer. */
-         generate_fragment(lp, shader, variant, RAST_WHOLE);
+   generate_variant_functions(lp, shader, variant);
+
+   if (!use_disk_cache) {
+      async = CALLOC_STRUCT(lp_fs_async);
+      if (async) {
+         async->gallivm = variant->gallivm;
+         async->function[RAST_EDGE_TEST] = variant->function[RAST_EDGE_TEST];
+         async->function[RAST_WHOLE] = variant->function[RAST_WHOLE];
+
+         if (!gallivm_compile_module_async(async->gallivm,
+                                           lp_fs_async_done, async)) {
+            FREE(async);
+            async = NULL;
+         }
       }
    }
 
+   if (async) {
+      /*
+       * Make do with an unoptimized build of the same code until the
+       * optimized one is ready.
+       */
+      util_snprintf(module_name, sizeof(module_name), "fs%u_variant%u_fast",
+                    shader->no, variant->no);
+
+      variant->gallivm = gallivm_create(module_name, lp->context, NULL);
+      if (!variant->gallivm) {
+         gallivm_destroy(async->gallivm);
+         FREE(async);
+         FREE(variant);
+         return NULL;
+      }
+
+      variant->gallivm->no_opt = TRUE;
+      variant->function[RAST_EDGE_TEST] = NULL;
+      variant->function[RAST_WHOLE] = NULL;
+
+      generate_variant_functions(lp, shader, variant);
+   }
+
    /*
     * Compile everything
     */
@@ -2649,6 +3104,29 @@ generate_variant(struct llvmpipe_context *lp,
 
    gallivm_free_ir(variant->gallivm);
 
+   /* cached.data is only filled in by code generation if the object can
+    * be reused by another process.
+    */
+   if (use_disk_cache && !disk_cache_hit && cached.data) {
+      pipe_mutex_lock(screen->fs_code_mutex);
+      disk_cache_put(screen->disk_shader_cache, disk_key,
+                     cached.data, cached.data_size);
+      pipe_mutex_unlock(screen->fs_code_mutex);
+   }
+   free(cached.data);
+
+   variant->code = lp_fs_code_insert(screen, shader, variant, async);
+   if (!variant->code) {
+      gallivm_destroy(variant->gallivm);
+      FREE(variant);
+      return NULL;
+   }
+
+   /* Another context may have won the race to publish the code. */
+   variant->pending = !lp_fs_code_get_functions(variant->code,
+                                                variant->jit_function);
+   variant->nr_instrs = variant->code->nr_instrs;
+
    return variant;
 }
 
@@ -2783,7 +3261,10 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
                    lp->nr_fs_variants);
    }
 
-   gallivm_destroy(variant->gallivm);
+   lp_fs_code_release(llvmpipe_screen(lp->pipe.screen), variant->code);
+
+   if (variant->pending)
+      lp->nr_fs_pending--;
 
    /* remove from shader's list */
    remove_from_list(&variant->list_item_local);
@@ -3180,6 +3661,8 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
          lp->nr_fs_variants++;
          lp->nr_fs_instrs += variant->nr_instrs;
          shader->variants_cached++;
+         if (variant->pending)
+            lp->nr_fs_pending++;
       }
    }
 
@@ -3188,6 +3671,28 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
 }
 
 
+/**
+ * Switch the variants whose optimized functions got compiled in the
+ * meantime over to them.  Scenes already set up pick up the new functions
+ * as well, the old ones stay around until the code is released.
+ */
+void
+llvmpipe_update_fs_code(struct llvmpipe_context *lp)
+{
+   struct lp_fs_variant_list_item *li;
+
+   foreach(li, &lp->fs_variants_list) {
+      struct lp_fragment_shader_variant *variant = li->base;
+
+      if (variant->pending &&
+          lp_fs_code_get_functions(variant->code, variant->jit_function)) {
+         variant->pending = FALSE;
+         lp->nr_fs_pending--;
+      }
+   }
+}
+
+
 
 
 
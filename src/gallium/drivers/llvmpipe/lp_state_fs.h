@@ -85,6 +85,10 @@ struct lp_fragment_shader_variant_key
 };
 
 
+struct lp_fs_code;
+struct llvmpipe_screen;
+
+
 /** doubly-linked list item */
 struct lp_fs_variant_list_item
 {
@@ -100,8 +104,21 @@ struct lp_fragment_shader_variant
    boolean opaque;
    uint8_t ps_inv_multiplier;
 
+   /**
+    * The depth test only passes fragments nearer than what is in the depth
+    * buffer, so blocks behind the tile's maximum depth can be skipped.
+    */
+   boolean zmax_test;
+
+   /** Depth writes may make the tile's maximum depth larger. */
+   boolean zmax_invalidate;
+
+   /** Only valid while the variant is being generated */
    struct gallivm_state *gallivm;
 
+   /** Compiled code, possibly shared with other variants and contexts */
+   struct lp_fs_code *code;
+
    LLVMTypeRef jit_context_ptr_type;
    LLVMTypeRef jit_thread_data_ptr_type;
    LLVMTypeRef jit_linear_context_ptr_type;
@@ -110,6 +127,9 @@ struct lp_fragment_shader_variant
 
    lp_jit_frag_func jit_function[2];
 
+   /** Optimized functions are still being compiled, see lp_fs_async */
+   boolean pending;
+
    /* Total number of LLVM instructions generated */
    unsigned nr_instrs;
 
@@ -153,5 +173,11 @@ llvmpipe_remove_shader_variant(struct llvmpipe_context *lp,
 boolean
 llvmpipe_rasterization_disabled(struct llvmpipe_context *lp);
 
+boolean
+llvmpipe_init_fs_code_cache(struct llvmpipe_screen *screen);
+
+void
+llvmpipe_destroy_fs_code_cache(struct llvmpipe_screen *screen);
+
 
 #endif /* LP_STATE_FS_H_ */
@@ -35,9 +35,9 @@
 struct lp_sampler_static_state;
 
 /**
- * Whether texture cache is used for s3tc textures.
+ * Whether texture cache is used for compressed textures.
  */
-#define LP_USE_TEXTURE_CACHE 0
+#define LP_USE_TEXTURE_CACHE 1
 
 /**
  * Pure-LLVM texture sampling code generator.
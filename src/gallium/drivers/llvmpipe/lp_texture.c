@@ -44,6 +44,7 @@
 #include "util/u_transfer.h"
 
 #include "lp_context.h"
+#include "lp_fence.h"
 #include "lp_flush.h"
 #include "lp_screen.h"
 #include "lp_texture.h"
@@ -310,6 +311,58 @@ llvmpipe_resource_create(struct pipe_screen *_screen,
    return llvmpipe_resource_create_front(_screen, templat, NULL);
 }
 
+
+/**
+ * Create a 2D texture which uses the given user memory as its storage.
+ * The memory must be laid out the way llvmpipe_texture_layout() would lay
+ * it out: the caller can get the row stride by mapping the resource.
+ * Since the rasterizer reads and writes whole LP_RASTER_BLOCK_SIZE blocks,
+ * only heights which are a multiple of the block size are accepted.
+ */
+static struct pipe_resource *
+llvmpipe_resource_from_user_memory(struct pipe_screen *_screen,
+                                   const struct pipe_resource *templat,
+                                   void *user_memory)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(_screen);
+   struct llvmpipe_resource *lpr;
+
+   if ((templat->target != PIPE_TEXTURE_2D &&
+        templat->target != PIPE_TEXTURE_RECT) ||
+       templat->last_level != 0 ||
+       templat->depth0 != 1 ||
+       templat->array_size != 1 ||
+       templat->nr_samples > 1 ||
+       util_format_is_compressed(templat->format) ||
+       templat->height0 % LP_RASTER_BLOCK_SIZE != 0 ||
+       (uintptr_t) user_memory % 16 != 0)
+      return NULL;
+
+   lpr = CALLOC_STRUCT(llvmpipe_resource);
+   if (!lpr)
+      return NULL;
+
+   lpr->base = *templat;
+   pipe_reference_init(&lpr->base.reference, 1);
+   lpr->base.screen = &screen->base;
+
+   if (!llvmpipe_texture_layout(screen, lpr, false)) {
+      FREE(lpr);
+      return NULL;
+   }
+
+   lpr->tex_data = user_memory;
+   lpr->userBuffer = TRUE;
+   lpr->id = id_counter++;
+
+#ifdef DEBUG
+   insert_at_tail(&resource_list, lpr);
+#endif
+
+   return &lpr->base;
+}
+
+
 static void
 llvmpipe_resource_destroy(struct pipe_screen *pscreen,
                           struct pipe_resource *pt)
@@ -324,7 +377,7 @@ llvmpipe_resource_destroy(struct pipe_screen *pscreen,
    }
    else if (llvmpipe_resource_is_texture(pt)) {
       /* free linear image data */
-      if (lpr->tex_data) {
+      if (lpr->tex_data && !lpr->userBuffer) {
          align_free(lpr->tex_data);
          lpr->tex_data = NULL;
       }
@@ -339,6 +392,8 @@ llvmpipe_resource_destroy(struct pipe_screen *pscreen,
       remove_from_list(lpr);
 #endif
 
+   lp_fence_reference(&lpr->fence, NULL);
+
    FREE(lpr);
 }
 
@@ -538,6 +593,11 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
          assert(do_not_block);
          return NULL;
       }
+
+      /* Another context may still be rendering to it. */
+      if (!llvmpipe_resource_wait_rendering(pipe->screen, resource,
+                                            do_not_block))
+         return NULL;
    }
 
    /* Check if we're mapping the current constant buffer */
@@ -789,6 +849,56 @@ llvmpipe_print_resources(void)
 #endif
 
 
+/**
+ * Record the fence of the last scene rendering to the resource.
+ * The caller must hold the screen's rast_mutex.
+ */
+void
+llvmpipe_resource_set_fence(struct pipe_resource *resource,
+                            struct lp_fence *fence)
+{
+   struct llvmpipe_resource *lpr = llvmpipe_resource(resource);
+
+   lp_fence_reference(&lpr->fence, fence);
+}
+
+
+/**
+ * Wait until the last scene rendering to the resource, from any context,
+ * has been rasterized.
+ *
+ * Returns FALSE if it would have blocked, but do_not_block was set, TRUE
+ * otherwise.
+ */
+boolean
+llvmpipe_resource_wait_rendering(struct pipe_screen *pscreen,
+                                 struct pipe_resource *resource,
+                                 boolean do_not_block)
+{
+   struct llvmpipe_screen *screen = llvmpipe_screen(pscreen);
+   struct llvmpipe_resource *lpr = llvmpipe_resource(resource);
+   struct lp_fence *fence = NULL;
+   boolean ret = TRUE;
+
+   pipe_mutex_lock(screen->rast_mutex);
+   lp_fence_reference(&fence, lpr->fence);
+   pipe_mutex_unlock(screen->rast_mutex);
+
+   if (!fence)
+      return TRUE;
+
+   if (!lp_fence_signalled(fence)) {
+      if (do_not_block)
+         ret = FALSE;
+      else
+         lp_fence_wait(fence);
+   }
+
+   lp_fence_reference(&fence, NULL);
+   return ret;
+}
+
+
 void
 llvmpipe_init_screen_resource_funcs(struct pipe_screen *screen)
 {
@@ -808,6 +918,7 @@ llvmpipe_init_screen_resource_funcs(struct pipe_screen *screen)
 /*   screen->resource_create_front = llvmpipe_resource_create_front; */
    screen->resource_destroy = llvmpipe_resource_destroy;
    screen->resource_from_handle = llvmpipe_resource_from_handle;
+   screen->resource_from_user_memory = llvmpipe_resource_from_user_memory;
    screen->resource_get_handle = llvmpipe_resource_get_handle;
    screen->can_create_resource = llvmpipe_can_create_resource;
 }
@@ -45,6 +45,7 @@ enum lp_texture_usage
 struct pipe_context;
 struct pipe_screen;
 struct llvmpipe_context;
+struct lp_fence;
 
 struct sw_displaytarget;
 
@@ -85,9 +86,15 @@ struct llvmpipe_resource
     */
    void *data;
 
-   boolean userBuffer;  /** Is this a user-space buffer? */
+   boolean userBuffer;  /** Is data or tex_data owned by the user? */
    unsigned timestamp;
 
+   /**
+    * Fence of the last scene rendering to this resource, in any context.
+    * Protected by the screen's rast_mutex.
+    */
+   struct lp_fence *fence;
+
    unsigned id;  /**< temporary, for debugging */
 
 #ifdef DEBUG
@@ -236,4 +243,13 @@ llvmpipe_is_resource_referenced( struct pipe_context *pipe,
 unsigned
 llvmpipe_get_format_alignment(enum pipe_format format);
 
+void
+llvmpipe_resource_set_fence(struct pipe_resource *resource,
+                            struct lp_fence *fence);
+
+boolean
+llvmpipe_resource_wait_rendering(struct pipe_screen *screen,
+                                 struct pipe_resource *resource,
+                                 boolean do_not_block);
+
 #endif /* LP_TEXTURE_H */
@@ -78,6 +78,16 @@ static boolean noop_get_query_result(struct pipe_context *ctx,
 	return TRUE;
 }
 
+static void noop_get_query_result_resource(struct pipe_context *ctx,
+					   struct pipe_query *query,
+					   boolean wait,
+					   enum pipe_query_value_type result_type,
+					   int index,
+					   struct pipe_resource *resource,
+					   unsigned offset)
+{
+}
+
 
 /*
  * resource
@@ -246,6 +256,16 @@ noop_flush_resource(struct pipe_context *ctx,
 }
 
 
+static boolean
+noop_resource_commit(struct pipe_context *ctx,
+                     struct pipe_resource *resource,
+                     unsigned level, struct pipe_box *box,
+                     boolean commit)
+{
+	return TRUE;
+}
+
+
 /*
  * context
  */
@@ -277,11 +297,13 @@ static struct pipe_context *noop_create_context(struct pipe_screen *screen,
 	ctx->resource_copy_region = noop_resource_copy_region;
 	ctx->blit = noop_blit;
 	ctx->flush_resource = noop_flush_resource;
+	ctx->resource_commit = noop_resource_commit;
 	ctx->create_query = noop_create_query;
 	ctx->destroy_query = noop_destroy_query;
 	ctx->begin_query = noop_begin_query;
 	ctx->end_query = noop_end_query;
 	ctx->get_query_result = noop_get_query_result;
+	ctx->get_query_result_resource = noop_get_query_result_resource;
 	ctx->transfer_map = noop_transfer_map;
 	ctx->transfer_flush_region = noop_transfer_flush_region;
 	ctx->transfer_unmap = noop_transfer_unmap;
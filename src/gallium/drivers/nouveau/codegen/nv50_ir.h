@@ -759,6 +759,7 @@ public:
    bool isCommutationLegal(const Instruction *) const; // must be adjacent !
    bool isActionEqual(const Instruction *) const;
    bool isResultEqual(const Instruction *) const;
+   unsigned int hash() const; // equal if isResultEqual
 
    void print() const;
 
@@ -2912,7 +2912,9 @@ NV50PostRaConstantFolding::visit(BasicBlock *bb)
 
 // =============================================================================
 
-// Common subexpression elimination. Stupid O^2 implementation.
+// Common subexpression elimination. Instructions that don't read any LValue
+// are looked up in a hash table, those that do are compared against the other
+// users of their least used LValue source.
 class LocalCSE : public Pass
 {
 private:
@@ -2920,7 +2922,9 @@ private:
 
    inline bool tryReplace(Instruction **, Instruction *);
 
-   DLList ops[OP_LAST + 1];
+   static const unsigned int HASH_SIZE = 256;
+
+   DLList ops[HASH_SIZE];
 };
 
 class GlobalCSE : public Pass
@@ -3021,6 +3025,50 @@ Instruction::isResultEqual(const Instruction *that) const
    return true;
 }
 
+static inline unsigned int
+hashCombine(unsigned int h, uint64_t v)
+{
+   h ^= (unsigned int)v + 0x9e3779b9 + (h << 6) + (h >> 2);
+   h ^= (unsigned int)(v >> 32) + 0x9e3779b9 + (h << 6) + (h >> 2);
+   return h;
+}
+
+// Only looks at (a subset of) what isResultEqual compares, so that any two
+// instructions which are equal also have the same hash.
+unsigned int
+Instruction::hash() const
+{
+   unsigned int h = op;
+   unsigned int s;
+
+   h = hashCombine(h, dType);
+   h = hashCombine(h, sType);
+   h = hashCombine(h, subOp);
+   h = hashCombine(h, predSrc);
+
+   for (s = 0; this->srcExists(s); ++s) {
+      const Value *v = this->getSrc(s);
+
+      h = hashCombine(h, this->src(s).mod.neg() | (this->src(s).mod.abs() << 1));
+
+      if (v->asImm()) {
+         h = hashCombine(h, v->reg.data.u64);
+      } else
+      if (v->asSym()) {
+         h = hashCombine(h, v->reg.file);
+         h = hashCombine(h, v->reg.fileIndex);
+         if (v->reg.file == FILE_SYSTEM_VALUE)
+            h = hashCombine(h, v->reg.data.sv.sv | (v->reg.data.sv.index << 8));
+         else
+            h = hashCombine(h, v->reg.data.offset);
+      } else {
+         // other values are compared strictly
+         h = hashCombine(h, (uintptr_t)v);
+      }
+   }
+   return hashCombine(h, s);
+}
+
 // pull through common expressions from different in-blocks
 bool
 GlobalCSE::visit(BasicBlock *bb)
@@ -3100,7 +3148,7 @@ LocalCSE::visit(BasicBlock *bb)
          next = ir->next;
 
          if (ir->fixed) {
-            ops[ir->op].insert(ir);
+            ops[ir->hash() % HASH_SIZE].insert(ir);
             continue;
          }
 
@@ -3118,7 +3166,7 @@ LocalCSE::visit(BasicBlock *bb)
                      break;
             }
          } else {
-            DLLIST_FOR_EACH(&ops[ir->op], iter)
+            DLLIST_FOR_EACH(&ops[ir->hash() % HASH_SIZE], iter)
             {
                Instruction *ik = reinterpret_cast<Instruction *>(iter.get());
                if (tryReplace(&ir, ik))
@@ -3127,11 +3175,11 @@ LocalCSE::visit(BasicBlock *bb)
          }
 
          if (ir)
-            ops[ir->op].insert(ir);
+            ops[ir->hash() % HASH_SIZE].insert(ir);
          else
             ++replaced;
       }
-      for (unsigned int i = 0; i <= OP_LAST; ++i)
+      for (unsigned int i = 0; i < HASH_SIZE; ++i)
          ops[i].clear();
 
    } while (replaced);
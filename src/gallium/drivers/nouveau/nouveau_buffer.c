@@ -133,9 +133,71 @@ nouveau_buffer_destroy(struct pipe_screen *pscreen,
    NOUVEAU_DRV_STAT(nouveau_screen(pscreen), buf_obj_current_count, -1);
 }
 
+/* Drop the current upload buffer. It is only unreferenced once the GPU is
+ * done with it, transfers still using it hold their own reference.
+ */
+void
+nouveau_transfer_upload_release(struct nouveau_context *nv)
+{
+   if (nv->upload.bo) {
+      if (!nouveau_fence_work(nv->upload.fence, nouveau_fence_unref_bo,
+                              nv->upload.bo))
+         nouveau_bo_ref(NULL, &nv->upload.bo);
+      nv->upload.bo = NULL;
+   }
+   nouveau_fence_ref(NULL, &nv->upload.fence);
+   nv->upload.offset = 0;
+   nv->upload.mapped = 0;
+}
+
+/* Sub-allocate a staging area from the context's upload buffer. Areas are
+ * handed out linearly. When we run out of space, the buffer is reused from
+ * the start if no transfer is using it anymore and all copies from it have
+ * completed, otherwise it is replaced by a new one so that we never stall.
+ */
+static bool
+nouveau_transfer_upload_alloc(struct nouveau_context *nv,
+                              struct nouveau_transfer *tx, unsigned size)
+{
+   unsigned offset = align(nv->upload.offset, NOUVEAU_MIN_BUFFER_MAP_ALIGN);
+
+   if (size > NOUVEAU_UPLOAD_BUF_SIZE / 4)
+      return false;
+
+   if (!nv->upload.bo || (offset + size > NOUVEAU_UPLOAD_BUF_SIZE)) {
+      offset = 0;
+
+      if (!nv->upload.bo || nv->upload.mapped ||
+          (nv->upload.fence && !nouveau_fence_signalled(nv->upload.fence))) {
+         struct nouveau_bo *bo = NULL;
+
+         if (nouveau_bo_new(nv->screen->device,
+                            NOUVEAU_BO_GART | NOUVEAU_BO_MAP, 4096,
+                            NOUVEAU_UPLOAD_BUF_SIZE, NULL, &bo))
+            return false;
+         if (nouveau_bo_map(bo, NOUVEAU_BO_WR, nv->client)) {
+            nouveau_bo_ref(NULL, &bo);
+            return false;
+         }
+         nouveau_transfer_upload_release(nv);
+         nv->upload.bo = bo;
+      }
+   }
+
+   nouveau_bo_ref(nv->upload.bo, &tx->bo);
+   tx->offset = offset;
+   tx->mm = NULL;
+
+   nv->upload.offset = offset + size;
+   nv->upload.mapped++;
+
+   return true;
+}
+
 /* Set up a staging area for the transfer. This is either done in "regular"
  * system memory if the driver supports push_data (nv50+) and the data is
- * small enough (and permit_pb == true), or in GART memory.
+ * small enough (and permit_pb == true), or in GART memory, preferably in the
+ * context's upload buffer.
  */
 static uint8_t *
 nouveau_transfer_staging(struct nouveau_context *nv,
@@ -152,8 +214,9 @@ nouveau_transfer_staging(struct nouveau_context *nv,
       if (tx->map)
          tx->map += adj;
    } else {
-      tx->mm =
-         nouveau_mm_allocate(nv->screen->mm_GART, size, &tx->bo, &tx->offset);
+      if (!nouveau_transfer_upload_alloc(nv, tx, size))
+         tx->mm = nouveau_mm_allocate(nv->screen->mm_GART, size,
+                                      &tx->bo, &tx->offset);
       if (tx->bo) {
          tx->offset += adj;
          if (!nouveau_bo_map(tx->bo, 0, NULL))
@@ -287,6 +350,10 @@ nouveau_buffer_transfer_del(struct nouveau_context *nv,
 {
    if (tx->map) {
       if (likely(tx->bo)) {
+         if (tx->bo == nv->upload.bo) {
+            nouveau_fence_ref(nv->screen->fence.current, &nv->upload.fence);
+            nv->upload.mapped--;
+         }
          nouveau_fence_work(nv->screen->fence.current,
                             nouveau_fence_unref_bo, tx->bo);
          if (tx->mm)
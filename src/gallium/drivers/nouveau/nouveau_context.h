@@ -7,7 +7,10 @@
 
 #define NOUVEAU_MAX_SCRATCH_BUFS 4
 
+#define NOUVEAU_UPLOAD_BUF_SIZE (1 << 20)
+
 struct nv04_resource;
+struct nouveau_fence;
 
 struct nouveau_context {
    struct pipe_context pipe;
@@ -50,6 +53,16 @@ struct nouveau_context {
       unsigned bo_size;
    } scratch;
 
+   /* persistently mapped GART buffer from which staging areas for buffer
+    * transfers are sub-allocated
+    */
+   struct {
+      struct nouveau_bo *bo;
+      unsigned offset;
+      unsigned mapped; /* nr of transfers still using the current bo */
+      struct nouveau_fence *fence; /* last use of the current bo */
+   } upload;
+
    struct {
       uint32_t buf_cache_count;
       uint32_t buf_cache_frame;
@@ -90,6 +103,9 @@ void *
 nouveau_scratch_get(struct nouveau_context *, unsigned size, uint64_t *gpu_addr,
                     struct nouveau_bo **);
 
+void
+nouveau_transfer_upload_release(struct nouveau_context *);
+
 static inline void
 nouveau_context_destroy(struct nouveau_context *ctx)
 {
@@ -99,6 +115,8 @@ nouveau_context_destroy(struct nouveau_context *ctx)
       if (ctx->scratch.bo[i])
          nouveau_bo_ref(NULL, &ctx->scratch.bo[i]);
 
+   nouveau_transfer_upload_release(ctx);
+
    FREE(ctx);
 }
 
@@ -405,6 +405,9 @@ struct pipe_context* r300_create_context(struct pipe_screen* screen,
         draw_wide_point_sprites(r300->draw, FALSE);
         draw_enable_line_stipple(r300->draw, TRUE);
         draw_enable_point_sprites(r300->draw, FALSE);
+        /* Shade each vertex of a segment once; the vertex buffer can hold
+         * segments of up to 4096 vertices. */
+        draw_set_vertex_cache_size(r300->draw, 4096);
     }
 
     if (!r300_setup_atoms(r300))
@@ -43,6 +43,11 @@
 #include <inttypes.h>
 
 #define ITEM_ALIGNMENT 1024
+
+/* The pool grows by at least this fraction of its size, so that a series
+ * of allocations doesn't copy the whole pool each time. */
+#define POOL_GROWTH_DIVISOR 2
+
 /**
  * Creates a new pool.
  */
@@ -90,6 +95,14 @@ static void compute_memory_pool_init(struct compute_memory_pool * pool,
 void compute_memory_pool_delete(struct compute_memory_pool* pool)
 {
 	COMPUTE_DBG(pool->screen, "* compute_memory_pool_delete()\n");
+	COMPUTE_DBG(pool->screen, "  size = %"PRIi64" dw, peak allocated = %"PRIi64" dw\n"
+		"  promoted items = %"PRIu64" (%"PRIu64" placed in holes)\n"
+		"  grows = %"PRIu64", defrags = %"PRIu64", "
+		"moved items = %"PRIu64" (%"PRIu64" dw)\n",
+		pool->size_in_dw, pool->stats.peak_allocated_in_dw,
+		pool->stats.num_promoted, pool->stats.num_placed_in_holes,
+		pool->stats.num_grows, pool->stats.num_defrags,
+		pool->stats.num_moved_items, pool->stats.moved_in_dw);
 	free(pool->shadow);
 	if (pool->bo) {
 		pool->screen->b.b.resource_destroy((struct pipe_screen *)
@@ -116,9 +129,10 @@ int64_t compute_memory_prealloc_chunk(
 {
 	struct compute_memory_item *item;
 
-	int last_end = 0;
+	int64_t last_end = 0;
 
-	assert(size_in_dw <= pool->size_in_dw);
+	if (size_in_dw > pool->size_in_dw)
+		return -1;
 
 	COMPUTE_DBG(pool->screen, "* compute_memory_prealloc_chunk() size_in_dw = %"PRIi64"\n",
 		size_in_dw);
@@ -189,6 +203,9 @@ struct list_head *compute_memory_postalloc_chunk(
 int compute_memory_grow_defrag_pool(struct compute_memory_pool *pool,
 	struct pipe_context *pipe, int new_size_in_dw)
 {
+	if (pool->bo)
+		new_size_in_dw = MAX2(new_size_in_dw,
+			pool->size_in_dw + pool->size_in_dw / POOL_GROWTH_DIVISOR);
 	new_size_in_dw = align(new_size_in_dw, ITEM_ALIGNMENT);
 
 	COMPUTE_DBG(pool->screen, "* compute_memory_grow_defrag_pool() "
@@ -202,6 +219,8 @@ int compute_memory_grow_defrag_pool(struct compute_memory_pool *pool,
 	} else {
 		struct r600_resource *temp = NULL;
 
+		pool->stats.num_grows++;
+
 		temp = r600_compute_buffer_alloc_vram(pool->screen, new_size_in_dw * 4);
 
 		if (temp != NULL) {
@@ -280,6 +299,7 @@ int compute_memory_finalize_pending(struct compute_memory_pool* pool,
 	int64_t allocated = 0;
 	int64_t unallocated = 0;
 	int64_t last_pos;
+	int64_t start_in_dw;
 
 	int err = 0;
 
@@ -307,6 +327,37 @@ int compute_memory_finalize_pending(struct compute_memory_pool* pool,
 		return 0;
 	}
 
+	pool->stats.peak_allocated_in_dw = MAX2(pool->stats.peak_allocated_in_dw,
+		allocated + unallocated);
+
+	/* First put the items in the free space that is already there, the
+	 * whole pool is only copied around when something doesn't fit. */
+	if (pool->bo) {
+		LIST_FOR_EACH_ENTRY_SAFE(item, next, pool->unallocated_list, link) {
+			if (!(item->status & ITEM_FOR_PROMOTING))
+				continue;
+
+			start_in_dw = compute_memory_prealloc_chunk(pool,
+				item->size_in_dw);
+			if (start_in_dw == -1)
+				continue;
+
+			err = compute_memory_promote_item(pool, item, pipe, start_in_dw);
+			item->status &= ~ITEM_FOR_PROMOTING;
+			pool->stats.num_placed_in_holes++;
+
+			allocated += align(item->size_in_dw, ITEM_ALIGNMENT);
+			unallocated -= align(item->size_in_dw, ITEM_ALIGNMENT);
+
+			if (err == -1)
+				return -1;
+		}
+
+		if (unallocated == 0) {
+			return 0;
+		}
+	}
+
 	if (pool->size_in_dw < allocated + unallocated) {
 		err = compute_memory_grow_defrag_pool(pool, pipe, allocated + unallocated);
 		if (err == -1)
@@ -354,6 +405,8 @@ void compute_memory_defrag(struct compute_memory_pool *pool,
 
 	COMPUTE_DBG(pool->screen, "* compute_memory_defrag()\n");
 
+	pool->stats.num_defrags++;
+
 	last_pos = 0;
 	LIST_FOR_EACH_ENTRY(item, pool->item_list, link) {
 		if (src != dst || item->start_in_dw != last_pos) {
@@ -395,9 +448,10 @@ int compute_memory_promote_item(struct compute_memory_pool *pool,
 	/* Remove the item from the unallocated list */
 	list_del(&item->link);
 
-	/* Add it back to the item_list */
-	list_addtail(&item->link, pool->item_list);
+	/* Add it back to the item_list, keeping it sorted */
+	list_add(&item->link, compute_memory_postalloc_chunk(pool, start_in_dw));
 	item->start_in_dw = start_in_dw;
+	pool->stats.num_promoted++;
 
 	if (src) {
 		u_box_1d(0, item->size_in_dw * 4, &box);
@@ -496,6 +550,9 @@ void compute_memory_move_item(struct compute_memory_pool *pool,
 			item->id, item->start_in_dw, item->start_in_dw * 4,
 			new_start_in_dw, new_start_in_dw * 4);
 
+	pool->stats.num_moved_items++;
+	pool->stats.moved_in_dw += item->size_in_dw;
+
 	if (pool->item_list != item->link.prev) {
 		prev = container_of(item->link.prev, item, link);
 		assert(prev->start_in_dw + prev->size_in_dw <= new_start_in_dw);
@@ -56,6 +56,18 @@ struct compute_memory_item
 	struct list_head link;
 };
 
+/** Counters printed with R600_DEBUG=compute when the pool is deleted */
+struct compute_memory_pool_stats
+{
+	uint64_t num_promoted;		/**< Items moved into the pool */
+	uint64_t num_placed_in_holes;	/**< ... without growing or defragmenting */
+	uint64_t num_grows;
+	uint64_t num_defrags;
+	uint64_t num_moved_items;	/**< Items copied by grows and defrags */
+	uint64_t moved_in_dw;
+	int64_t peak_allocated_in_dw;
+};
+
 struct compute_memory_pool
 {
 	int64_t next_id;	/**< For generating unique IDs for memory chunks */
@@ -74,6 +86,8 @@ struct compute_memory_pool
 	/** Unallocated memory items, this list contains all the items that aren't
 	 * yet in the pool */
 	struct list_head *unallocated_list;
+
+	struct compute_memory_pool_stats stats;
 };
 
 
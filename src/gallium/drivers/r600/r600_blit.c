@@ -147,6 +147,9 @@ static void r600_blit_decompress_depth(struct pipe_context *ctx,
 	rctx->db_misc_state.copy_sample = first_sample;
 	r600_mark_atom_dirty(rctx, &rctx->db_misc_state.atom);
 
+	r600_blitter_begin(ctx, R600_DECOMPRESS);
+	util_blitter_begin_batch(rctx->blitter);
+
 	for (level = first_level; level <= last_level; level++) {
 		if (!staging && !(texture->dirty_level_mask & (1 << level)))
 			continue;
@@ -176,10 +179,8 @@ static void r600_blit_decompress_depth(struct pipe_context *ctx,
 				cbsurf = ctx->create_surface(ctx,
 						&flushed_depth_texture->resource.b.b, &surf_tmpl);
 
-				r600_blitter_begin(ctx, R600_DECOMPRESS);
 				util_blitter_custom_depth_stencil(rctx->blitter, zsurf, cbsurf, 1 << sample,
 								  rctx->custom_dsa_flush, depth);
-				r600_blitter_end(ctx);
 
 				pipe_surface_reference(&zsurf, NULL);
 				pipe_surface_reference(&cbsurf, NULL);
@@ -195,6 +196,9 @@ static void r600_blit_decompress_depth(struct pipe_context *ctx,
 		}
 	}
 
+	util_blitter_end_batch(rctx->blitter);
+	r600_blitter_end(ctx);
+
 	/* reenable compression in DB_RENDER_CONTROL */
 	rctx->db_misc_state.flush_depthstencil_through_cb = false;
 	r600_mark_atom_dirty(rctx, &rctx->db_misc_state.atom);
@@ -222,6 +226,9 @@ static void r600_blit_decompress_depth_in_place(struct r600_context *rctx,
 
 	surf_tmpl.format = texture->resource.b.b.format;
 
+	r600_blitter_begin(&rctx->b.b, R600_DECOMPRESS);
+	util_blitter_begin_batch(rctx->blitter);
+
 	for (level = first_level; level <= last_level; level++) {
 		if (!(*dirty_level_mask & (1 << level)))
 			continue;
@@ -239,10 +246,8 @@ static void r600_blit_decompress_depth_in_place(struct r600_context *rctx,
 
 			zsurf = rctx->b.b.create_surface(&rctx->b.b, &texture->resource.b.b, &surf_tmpl);
 
-			r600_blitter_begin(&rctx->b.b, R600_DECOMPRESS);
 			util_blitter_custom_depth_stencil(rctx->blitter, zsurf, NULL, ~0,
 							  rctx->custom_dsa_flush, 1.0f);
-			r600_blitter_end(&rctx->b.b);
 
 			pipe_surface_reference(&zsurf, NULL);
 		}
@@ -254,6 +259,9 @@ static void r600_blit_decompress_depth_in_place(struct r600_context *rctx,
 		}
 	}
 
+	util_blitter_end_batch(rctx->blitter);
+	r600_blitter_end(&rctx->b.b);
+
 	/* Disable decompression in DB_RENDER_CONTROL */
 	rctx->db_misc_state.flush_depth_inplace = false;
 	rctx->db_misc_state.flush_stencil_inplace = false;
@@ -306,6 +314,9 @@ static void r600_blit_decompress_color(struct pipe_context *ctx,
 	if (!rtex->dirty_level_mask)
 		return;
 
+	r600_blitter_begin(ctx, R600_DECOMPRESS);
+	util_blitter_begin_batch(rctx->blitter);
+
 	for (level = first_level; level <= last_level; level++) {
 		if (!(rtex->dirty_level_mask & (1 << level)))
 			continue;
@@ -324,10 +335,8 @@ static void r600_blit_decompress_color(struct pipe_context *ctx,
 			surf_tmpl.u.tex.last_layer = layer;
 			cbsurf = ctx->create_surface(ctx, &rtex->resource.b.b, &surf_tmpl);
 
-			r600_blitter_begin(ctx, R600_DECOMPRESS);
 			util_blitter_custom_color(rctx->blitter, cbsurf,
 				rtex->fmask.size ? rctx->custom_blend_decompress : rctx->custom_blend_fastclear);
-			r600_blitter_end(ctx);
 
 			pipe_surface_reference(&cbsurf, NULL);
 		}
@@ -338,6 +347,9 @@ static void r600_blit_decompress_color(struct pipe_context *ctx,
 			rtex->dirty_level_mask &= ~(1 << level);
 		}
 	}
+
+	util_blitter_end_batch(rctx->blitter);
+	r600_blitter_end(ctx);
 }
 
 void r600_decompress_color_textures(struct r600_context *rctx,
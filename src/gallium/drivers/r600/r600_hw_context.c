@@ -248,8 +248,13 @@ void r600_context_gfx_flush(void *context, unsigned flags,
 	struct r600_context *ctx = context;
 	struct radeon_winsys_cs *cs = ctx->b.gfx.cs;
 
-	if (cs->cdw == ctx->b.initial_gfx_cs_size && !fence)
+	/* Nothing was submitted since the last flush, so its fence will do. */
+	if (cs->cdw == ctx->b.initial_gfx_cs_size &&
+	    (!fence || ctx->last_gfx_fence)) {
+		if (fence)
+			ctx->b.ws->fence_reference(fence, ctx->last_gfx_fence);
 		return;
+	}
 
 	r600_preflush_suspend_features(&ctx->b);
 
@@ -275,7 +280,11 @@ void r600_context_gfx_flush(void *context, unsigned flags,
 	}
 
 	/* Flush the CS. */
-	ctx->b.ws->cs_flush(cs, flags, fence, ctx->screen->b.cs_count++);
+	ctx->b.ws->cs_flush(cs, flags, &ctx->last_gfx_fence,
+			    ctx->screen->b.cs_count++);
+
+	if (fence)
+		ctx->b.ws->fence_reference(fence, ctx->last_gfx_fence);
 
 	r600_begin_new_cs(ctx);
 }
@@ -469,7 +478,7 @@ void r600_dma_copy_buffer(struct r600_context *rctx,
 	size >>= 2; /* convert to dwords */
 	ncopy = (size / R600_DMA_COPY_MAX_SIZE_DW) + !!(size % R600_DMA_COPY_MAX_SIZE_DW);
 
-	r600_need_dma_space(&rctx->b, ncopy * 5);
+	r600_need_dma_space(&rctx->b, ncopy * 5, rdst, rsrc);
 	for (i = 0; i < ncopy; i++) {
 		csize = size < R600_DMA_COPY_MAX_SIZE_DW ? size : R600_DMA_COPY_MAX_SIZE_DW;
 		/* emit reloc before writing cs so that cs is always in consistent state */
@@ -57,6 +57,8 @@ static const struct debug_named_value r600_debug_options[] = {
 	{ "sbnofallback", DBG_SB_NO_FALLBACK, "Abort on errors instead of fallback" },
 	{ "sbdisasm", DBG_SB_DISASM, "Use sb disassembler for shader dumps" },
 	{ "sbsafemath", DBG_SB_SAFEMATH, "Disable unsafe math optimizations" },
+	{ "sbtime", DBG_SB_TIME, "Print the time spent in each optimization pass" },
+	{ "sbnocache", DBG_SB_NO_CACHE, "Optimize repeated bytecode again instead of reusing the result" },
 
 	DEBUG_NAMED_VALUE_END /* must be last */
 };
@@ -107,6 +109,7 @@ static void r600_destroy_context(struct pipe_context *context)
 
 	FREE(rctx->start_compute_cs_cmd.buf);
 
+	rctx->b.ws->fence_reference(&rctx->last_gfx_fence, NULL);
 	r600_common_context_cleanup(&rctx->b);
 	FREE(rctx);
 }
@@ -348,6 +351,8 @@ static int r600_get_param(struct pipe_screen* pscreen, enum pipe_cap param)
 	case PIPE_CAP_FORCE_PERSAMPLE_INTERP:
 	case PIPE_CAP_SHAREABLE_SHADERS:
 	case PIPE_CAP_CLEAR_TEXTURE:
+	case PIPE_CAP_QUERY_BUFFER_OBJECT:
+	case PIPE_CAP_SPARSE_BUFFER_PAGE_SIZE:
 		return 0;
 
 	case PIPE_CAP_MAX_SHADER_PATCH_VARYINGS:
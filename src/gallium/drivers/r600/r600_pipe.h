@@ -255,6 +255,8 @@ struct r600_gs_rings_state {
 #define DBG_SB_NO_FALLBACK	(1 << 26)
 #define DBG_SB_DISASM	(1 << 27)
 #define DBG_SB_SAFEMATH	(1 << 28)
+#define DBG_SB_TIME		(1 << 19)
+#define DBG_SB_NO_CACHE	(1 << 20)
 
 struct r600_screen {
 	struct r600_common_screen	b;
@@ -439,6 +441,7 @@ struct r600_context {
 	struct r600_screen		*screen;
 	struct blitter_context		*blitter;
 	struct u_suballocator		*allocator_fetch_shader;
+	struct pipe_fence_handle	*last_gfx_fence;
 
 	/* Hardware info. */
 	boolean				has_vertex_cache;
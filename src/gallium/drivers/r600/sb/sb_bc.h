@@ -34,6 +34,7 @@
 #include <string>
 #include <vector>
 #include <stack>
+#include <map>
 
 struct r600_bytecode;
 struct r600_shader;
@@ -606,12 +607,41 @@ struct shader_stats {
 	void dump_diff(shader_stats &s);
 };
 
+// accumulated run time of one pass, for R600_DEBUG=sbtime
+struct sb_pass_time {
+	int64_t total_ns;
+	unsigned count;
+
+	sb_pass_time() : total_ns(), count() {}
+};
+
+// result of processing some input bytecode, reused when the same bytecode
+// is compiled again (e.g. for another shader variant)
+struct sb_cache_entry {
+	// false if sb failed and the input bytecode was used as is
+	bool optimized;
+	std::vector<uint32_t> bytecode;
+	unsigned ngpr;
+	unsigned nstack;
+
+	sb_cache_entry() : optimized(), bytecode(), ngpr(), nstack() {}
+};
+
 class sb_context {
 
 public:
 
+	// the key starts with the hash of the rest so that the comparisons in
+	// the map usually stop at the first element
+	typedef std::vector<uint32_t> cache_key;
+	typedef std::map<cache_key, sb_cache_entry> bytecode_cache;
+
 	shader_stats src_stats, opt_stats;
 
+	std::map<std::string, sb_pass_time> pass_times;
+	bytecode_cache cache;
+	unsigned cache_hits, cache_misses;
+
 	r600_isa *isa;
 
 	sb_hw_chip hw_chip;
@@ -638,12 +668,15 @@ public:
 	static unsigned dry_run;
 	static unsigned no_fallback;
 	static unsigned safe_math;
+	static unsigned time_passes;
+	static unsigned no_cache;
 
 	static unsigned dskip_start;
 	static unsigned dskip_end;
 	static unsigned dskip_mode;
 
-	sb_context() : src_stats(), opt_stats(), isa(0),
+	sb_context() : src_stats(), opt_stats(), pass_times(), cache(),
+			cache_hits(), cache_misses(), isa(0),
 			hw_chip(HW_CHIP_UNKNOWN), hw_class(HW_CLASS_UNKNOWN) {}
 
 	int init(r600_isa *isa, sb_hw_chip chip, sb_hw_class cclass);
@@ -35,6 +35,8 @@ unsigned sb_context::dump_stat = 0;
 unsigned sb_context::dry_run = 0;
 unsigned sb_context::no_fallback = 0;
 unsigned sb_context::safe_math = 0;
+unsigned sb_context::time_passes = 0;
+unsigned sb_context::no_cache = 0;
 
 unsigned sb_context::dskip_start = 0;
 unsigned sb_context::dskip_end = 0;
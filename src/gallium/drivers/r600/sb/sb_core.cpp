@@ -27,6 +27,7 @@
 #define SB_RA_SCHED_CHECK DEBUG
 
 #include "os/os_time.h"
+#include "util/hash_table.h"
 #include "r600_pipe.h"
 #include "r600_shader.h"
 
@@ -42,9 +43,18 @@
 
 using namespace r600_sb;
 
+// the cache is simply dropped when it grows beyond this
+#define SB_CACHE_MAX_ENTRIES 256
+
 static sb_hw_class translate_chip_class(enum chip_class cc);
 static sb_hw_chip translate_chip(enum radeon_family rf);
 
+static void build_cache_key(sb_context::cache_key &key,
+                            struct r600_bytecode *bc,
+                            struct r600_shader *pshader);
+static void add_cache_entry(sb_context *ctx, sb_context::cache_key &key,
+                            struct r600_bytecode *bc, bool optimized);
+
 sb_context *r600_sb_context_create(struct r600_context *rctx) {
 
 	sb_context *sctx = new sb_context();
@@ -62,6 +72,8 @@ sb_context *r600_sb_context_create(struct r600_context *rctx) {
 	sb_context::dry_run = df & DBG_SB_DRY_RUN;
 	sb_context::no_fallback = df & DBG_SB_NO_FALLBACK;
 	sb_context::safe_math = df & DBG_SB_SAFEMATH;
+	sb_context::time_passes = df & DBG_SB_TIME;
+	sb_context::no_cache = df & DBG_SB_NO_CACHE;
 
 	sb_context::dskip_start = debug_get_num_option("R600_SB_DSKIP_START", 0);
 	sb_context::dskip_end = debug_get_num_option("R600_SB_DSKIP_END", 0);
@@ -83,6 +95,20 @@ void r600_sb_context_destroy(void * sctx) {
 			ctx->src_stats.dump_diff(ctx->opt_stats);
 		}
 
+		if (sb_context::time_passes) {
+			sblog << "\nsb: context pass times:\n";
+			for (std::map<std::string, sb_pass_time>::iterator
+					I = ctx->pass_times.begin(), E = ctx->pass_times.end();
+					I != E; ++I) {
+				sblog << "  ";
+				sblog.print_wl(I->first, 20);
+				sblog << ((double)I->second.total_ns)/1000000.0 << " ms in "
+						<< I->second.count << " runs\n";
+			}
+			sblog << "sb: bytecode cache: " << ctx->cache_hits << " hits, "
+					<< ctx->cache_misses << " misses\n";
+		}
+
 		delete ctx;
 	}
 }
@@ -101,10 +127,47 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 	}
 
 	int64_t time_start = 0;
-	if (sb_context::dump_stat) {
+	if (sb_context::dump_stat || sb_context::time_passes) {
 		time_start = os_time_get_nano();
 	}
 
+	/* Shader variants often end up with the same bytecode, reuse the result
+	 * of the previous run for it.  Dumps and statistics need the full
+	 * processing, so they bypass the cache.
+	 */
+	bool use_cache = optimize && !dump_bytecode && !sb_context::no_cache &&
+			!sb_context::dump_pass && !sb_context::dump_stat &&
+			!sb_context::dry_run && !sb_context::dskip_mode;
+	sb_context::cache_key key;
+
+	if (use_cache) {
+		build_cache_key(key, bc, pshader);
+
+		sb_context::bytecode_cache::iterator I = ctx->cache.find(key);
+		if (I != ctx->cache.end()) {
+			sb_cache_entry &e = I->second;
+
+			if (e.optimized) {
+				free(bc->bytecode);
+				bc->ndw = e.bytecode.size();
+				bc->bytecode = (uint32_t*) malloc(bc->ndw << 2);
+				std::copy(e.bytecode.begin(), e.bytecode.end(), bc->bytecode);
+
+				bc->ngpr = e.ngpr;
+				bc->nstack = e.nstack;
+			}
+
+			++ctx->cache_hits;
+			if (sb_context::time_passes) {
+				sblog << "sb: shader " << shader_id << " found in cache ( "
+						<< ((double)(os_time_get_nano() - time_start))/1000000.0
+						<< " ms ).\n";
+			}
+			return 0;
+		}
+		++ctx->cache_misses;
+	}
+
 	SB_DUMP_STAT( sblog << "\nsb: shader " << shader_id << "\n"; );
 
 	bc_parser parser(*ctx, bc, pshader);
@@ -159,12 +222,22 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 
 #define SB_RUN_PASS(n, dump) \
 	do { \
+		int64_t pass_start = 0; \
+		if (sb_context::time_passes) \
+			pass_start = os_time_get_nano(); \
 		r = n(*sh).run(); \
+		if (sb_context::time_passes) { \
+			sb_pass_time &pt = ctx->pass_times[#n]; \
+			pt.total_ns += os_time_get_nano() - pass_start; \
+			++pt.count; \
+		} \
 		if (r) { \
 			sblog << "sb: error (" << r << ") in the " << #n << " pass.\n"; \
 			if (sb_context::no_fallback) \
 				return r; \
 			sblog << "sb: using unoptimized bytecode...\n"; \
+			if (use_cache) \
+				add_cache_entry(ctx, key, bc, false); \
 			delete sh; \
 			return 0; \
 		} \
@@ -262,6 +335,9 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 
 		bc->ngpr = sh->ngpr;
 		bc->nstack = sh->nstack;
+
+		if (use_cache)
+			add_cache_entry(ctx, key, bc, true);
 	} else {
 		SB_DUMP_STAT( sblog << "sb: dry run: optimized bytecode is not used\n"; );
 	}
@@ -281,12 +357,78 @@ int r600_sb_bytecode_process(struct r600_context *rctx,
 		sh->opt_stats.dump();
 		sblog << "diff: ";
 		sh->src_stats.dump_diff(sh->opt_stats);
+	} else if (sb_context::time_passes) {
+		sblog << "sb: processing shader " << shader_id << " done ( "
+				<< ((double)(os_time_get_nano() - time_start))/1000000.0
+				<< " ms ).\n";
 	}
 
 	delete sh;
 	return 0;
 }
 
+/* The key holds everything from the bytecode and the shader info that
+ * bc_parser looks at, so equal keys give equal optimizer results.
+ */
+static void build_cache_key(sb_context::cache_key &key,
+                            struct r600_bytecode *bc,
+                            struct r600_shader *pshader) {
+	key.clear();
+	key.reserve(bc->ndw + 32);
+
+	key.push_back(0); // hash, filled in below
+	key.push_back(sb_context::safe_math);
+	key.push_back(bc->type);
+	key.push_back(bc->ngpr);
+	key.push_back(bc->nstack);
+	key.push_back(pshader != NULL);
+
+	if (pshader) {
+		key.push_back(pshader->vs_as_ls);
+		key.push_back(pshader->vs_as_es);
+		key.push_back(pshader->tes_as_es);
+		key.push_back(pshader->indirect_files);
+		key.push_back(pshader->bc.ngpr);
+
+		key.push_back(pshader->num_arrays);
+		for (unsigned i = 0; i < pshader->num_arrays; ++i) {
+			r600_shader_array &a = pshader->arrays[i];
+			key.push_back(a.gpr_start);
+			key.push_back(a.gpr_count);
+			key.push_back(a.comp_mask);
+		}
+
+		key.push_back(pshader->ninput);
+		for (unsigned i = 0; i < pshader->ninput; ++i) {
+			r600_shader_io &in = pshader->input[i];
+			key.push_back(in.gpr);
+			key.push_back(in.spi_sid);
+			key.push_back(in.interpolate);
+			key.push_back(in.interpolate_location);
+		}
+	}
+
+	key.push_back(bc->ndw);
+	key.insert(key.end(), bc->bytecode, bc->bytecode + bc->ndw);
+
+	key[0] = _mesa_hash_data(&key[1], (key.size() - 1) * sizeof(uint32_t));
+}
+
+static void add_cache_entry(sb_context *ctx, sb_context::cache_key &key,
+                            struct r600_bytecode *bc, bool optimized) {
+	if (ctx->cache.size() >= SB_CACHE_MAX_ENTRIES)
+		ctx->cache.clear();
+
+	sb_cache_entry &e = ctx->cache[key];
+
+	e.optimized = optimized;
+	if (optimized) {
+		e.bytecode.assign(bc->bytecode, bc->bytecode + bc->ndw);
+		e.ngpr = bc->ngpr;
+		e.nstack = bc->nstack;
+	}
+}
+
 static sb_hw_chip translate_chip(enum radeon_family rf) {
 	switch (rf) {
 
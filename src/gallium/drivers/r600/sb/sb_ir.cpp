@@ -259,10 +259,12 @@ value_hash node::hash_src() {
 
 	value_hash h = 12345;
 
+	// summing keeps the hash independent of the operand order while equal
+	// operands don't cancel each other out like they would with xor
 	for (int k = 0, e = src.size(); k < e; ++k) {
 		value *s = src[k];
 		if (s)
-			h ^=  (s->hash());
+			h += hash_mix(s->hash());
 	}
 
 	return h;
@@ -274,7 +276,14 @@ value_hash node::hash() {
 	if (parent && parent->subtype == NST_LOOP_PHI_CONTAINER)
 		return 47451;
 
-	return hash_src() ^ (subtype << 13) ^ (type << 3);
+	value_hash h = hash_src() ^ (subtype << 13) ^ (type << 3);
+
+	// only the same op can give an equal expression, see
+	// expr_handler::ops_equal
+	if (is_alu_inst())
+		h ^= static_cast<alu_node*>(this)->bc.op << 20;
+
+	return hash_mix(h);
 }
 
 void r600_sb::container_node::append_from(container_node* c) {
@@ -256,6 +256,21 @@ public:
 	sb_bitset& operator&=(const sb_bitset &bs2);
 	sb_bitset& mask(const sb_bitset &bs2);
 
+	// same as |=, returns true if any bit was added
+	bool or_checked(const sb_bitset &bs2) {
+		if (bit_size < bs2.bit_size) {
+			resize(bs2.bit_size);
+		}
+
+		basetype changed = 0;
+		for (unsigned i = 0, c = std::min(data.size(), bs2.data.size()); i < c;
+				++i) {
+			changed |= bs2.data[i] & ~data[i];
+			data[i] |= bs2.data[i];
+		}
+		return changed != 0;
+	}
+
 	friend sb_bitset operator|(const sb_bitset &b1, const sb_bitset &b2) {
 			sb_bitset nbs(b1);
 			nbs |= b2;
@@ -353,7 +368,11 @@ public:
 	}
 	iterator end(shader &sh) { return iterator(sh, this, bs.size()); }
 
-	bool add_set_checked(sb_value_set & s2);
+	bool add_set_checked(sb_value_set & s2) {
+		if (bs.size() < s2.bs.size())
+			bs.resize(s2.bs.size());
+		return bs.or_checked(s2.bs);
+	}
 
 	void add_set(sb_value_set & s2)  {
 		if (bs.size() < s2.bs.size())
@@ -439,6 +458,17 @@ sb_ostream& operator << (sb_ostream &o, value &v);
 
 typedef uint32_t value_hash;
 
+// spreads the input bits over the whole hash, value_table only uses the low
+// bits to select the bucket
+inline value_hash hash_mix(value_hash h) {
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
 enum use_kind {
 	UK_SRC,
 	UK_SRC_REL,
@@ -185,15 +185,19 @@ value_hash value::hash() {
 	else if (def)
 		ghash = def->hash();
 	else
-		ghash = ((uintptr_t)this) | 1;
+		ghash = hash_mix((uintptr_t)this ^ ((uint64_t)(uintptr_t)this >> 32));
+
+	// zero means "not computed yet"
+	if (!ghash)
+		ghash = 1;
 
 	return ghash;
 }
 
 value_hash value::rel_hash() {
 	value_hash h = rel ? rel->hash() : 0;
-	h |= select << 10;
-	h |= array->hash();
+	h = hash_mix(h + (select << 10));
+	h ^= hash_mix(array->hash());
 	return h;
 }
 
@@ -412,17 +416,6 @@ unsigned sb_bitset::find_bit(unsigned start) {
 sb_value_set::iterator::iterator(shader& sh, sb_value_set* s, unsigned nb)
 	: vp(sh.get_value_pool()), s(s), nb(nb) {}
 
-bool sb_value_set::add_set_checked(sb_value_set& s2) {
-	if (bs.size() < s2.bs.size())
-		bs.resize(s2.bs.size());
-	sb_bitset nbs = bs | s2.bs;
-	if (bs != nbs) {
-		bs.swap(nbs);
-		return true;
-	}
-	return false;
-}
-
 void r600_sb::sb_value_set::remove_set(sb_value_set& s2) {
 	bs.mask(s2.bs);
 }
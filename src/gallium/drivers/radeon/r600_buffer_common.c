@@ -163,6 +163,15 @@ bool r600_init_resource(struct r600_common_screen *rscreen,
 		flags |= RADEON_FLAG_NO_CPU_ACCESS;
 	}
 
+	/* Sparse buffers only reserve address space. The winsys backs the
+	 * committed pages with VRAM and they can't be mapped. */
+	if (res->b.b.target == PIPE_BUFFER &&
+	    res->b.b.flags & PIPE_RESOURCE_FLAG_SPARSE) {
+		res->domains = RADEON_DOMAIN_VRAM;
+		flags = RADEON_FLAG_SPARSE | RADEON_FLAG_NO_CPU_ACCESS;
+		use_reusable_pool = false;
+	}
+
 	if (rscreen->debug_flags & DBG_NO_WC)
 		flags &= ~RADEON_FLAG_GTT_WC;
 
@@ -219,7 +228,7 @@ static void *r600_buffer_get_transfer(struct pipe_context *ctx,
 				      unsigned offset)
 {
 	struct r600_common_context *rctx = (struct r600_common_context*)ctx;
-	struct r600_transfer *transfer = util_slab_alloc(&rctx->pool_transfers);
+	struct r600_transfer *transfer = util_slab_child_alloc(&rctx->pool_transfers);
 
 	transfer->transfer.resource = resource;
 	transfer->transfer.level = level;
@@ -258,6 +267,37 @@ static void *r600_buffer_transfer_map(struct pipe_context *ctx,
 
 	assert(box->x + box->width <= resource->width0);
 
+	/* Sparse buffers can't be mapped and can't be reallocated on discard.
+	 * Go through a staging buffer, which is written back by
+	 * r600_buffer_do_flush_region. */
+	if (resource->flags & PIPE_RESOURCE_FLAG_SPARSE) {
+		struct r600_resource *staging;
+
+		staging = (struct r600_resource*) pipe_buffer_create(
+				ctx->screen, PIPE_BIND_TRANSFER_READ, PIPE_USAGE_STAGING,
+				box->width + (box->x % R600_MAP_BUFFER_ALIGNMENT));
+		if (!staging)
+			return NULL;
+
+		if (!(usage & (PIPE_TRANSFER_DISCARD_RANGE |
+			       PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE))) {
+			rctx->dma_copy(ctx, &staging->b.b, 0,
+				       box->x % R600_MAP_BUFFER_ALIGNMENT,
+				       0, 0, resource, level, box);
+		}
+
+		data = r600_buffer_map_sync_with_rings(rctx, staging,
+						       usage & ~PIPE_TRANSFER_UNSYNCHRONIZED);
+		if (!data) {
+			pipe_resource_reference((struct pipe_resource**)&staging, NULL);
+			return NULL;
+		}
+		data += box->x % R600_MAP_BUFFER_ALIGNMENT;
+
+		return r600_buffer_get_transfer(ctx, resource, level, usage, box,
+						ptransfer, data, staging, 0);
+	}
+
 	/* See if the buffer range being mapped has never been initialized,
 	 * in which case it can be mapped unsynchronized. */
 	if (!(usage & PIPE_TRANSFER_UNSYNCHRONIZED) &&
@@ -397,7 +437,7 @@ static void r600_buffer_transfer_unmap(struct pipe_context *ctx,
 	if (rtransfer->staging)
 		pipe_resource_reference((struct pipe_resource**)&rtransfer->staging, NULL);
 
-	util_slab_free(&rctx->pool_transfers, transfer);
+	util_slab_child_free(&rctx->pool_transfers, transfer);
 }
 
 static const struct u_resource_vtbl r600_buffer_vtbl =
@@ -30,6 +30,8 @@
 #include "r600_pipe_common.h"
 #include "r600d_common.h"
 
+#include <inttypes.h>
+
 /* Max counters per HW block */
 #define R600_QUERY_MAX_COUNTERS 16
 
@@ -87,6 +89,7 @@ struct r600_pc_group {
 };
 
 struct r600_pc_counter {
+	const char *name;
 	unsigned base;
 	unsigned dwords;
 	unsigned stride;
@@ -209,11 +212,65 @@ static void r600_pc_query_add_result(struct r600_common_context *ctx,
 	}
 }
 
+/* Print the per-draw results of a query created with RADEON_PC_SAMPLE_DRAWS,
+ * oldest first. */
+static void r600_pc_query_dump_samples(struct r600_common_context *ctx,
+				       struct r600_query_pc *query,
+				       struct r600_query_buffer *qbuf,
+				       unsigned *sample)
+{
+	unsigned results_base;
+	uint32_t *map;
+	unsigned i, j;
+
+	if (qbuf->previous)
+		r600_pc_query_dump_samples(ctx, query, qbuf->previous, sample);
+
+	map = r600_buffer_map_sync_with_rings(ctx, qbuf->buf,
+					      PIPE_TRANSFER_READ |
+					      PIPE_TRANSFER_DONTBLOCK);
+	if (!map)
+		return;
+
+	for (results_base = 0; results_base != qbuf->results_end;
+	     results_base += query->b.result_size) {
+		uint32_t *results = map + results_base / 4;
+
+		fprintf(stderr, "perfcounter sample %u:", (*sample)++);
+		for (i = 0; i < query->num_counters; ++i) {
+			struct r600_pc_counter *counter = &query->counters[i];
+			uint64_t value = 0;
+
+			for (j = 0; j < counter->dwords; ++j)
+				value += results[counter->base + j * counter->stride];
+
+			fprintf(stderr, " %s=%"PRIu64, counter->name, value);
+		}
+		fprintf(stderr, "\n");
+	}
+}
+
+static boolean r600_pc_query_get_result(struct r600_common_context *ctx,
+					struct r600_query *rquery,
+					boolean wait,
+					union pipe_query_result *result)
+{
+	struct r600_query_pc *query = (struct r600_query_pc *)rquery;
+	unsigned sample = 0;
+
+	if (!r600_query_hw_get_result(ctx, rquery, wait, result))
+		return FALSE;
+
+	if (query->b.flags & R600_QUERY_HW_FLAG_SAMPLE_DRAWS)
+		r600_pc_query_dump_samples(ctx, query, &query->b.buffer, &sample);
+	return TRUE;
+}
+
 static struct r600_query_ops batch_query_ops = {
 	.destroy = r600_pc_query_destroy,
 	.begin = r600_query_hw_begin,
 	.end = r600_query_hw_end,
-	.get_result = r600_query_hw_get_result
+	.get_result = r600_pc_query_get_result
 };
 
 static struct r600_query_hw_ops batch_query_hw_ops = {
@@ -293,6 +350,9 @@ static struct r600_pc_group *get_group_state(struct r600_common_screen *screen,
 	return group;
 }
 
+static boolean r600_init_block_names(struct r600_common_screen *screen,
+				     struct r600_perfcounter_block *block);
+
 struct pipe_query *r600_create_batch_query(struct pipe_context *ctx,
 					   unsigned num_queries,
 					   unsigned *query_types)
@@ -316,6 +376,8 @@ struct pipe_query *r600_create_batch_query(struct pipe_context *ctx,
 	query->b.b.ops = &batch_query_ops;
 	query->b.ops = &batch_query_hw_ops;
 	query->b.flags = R600_QUERY_HW_FLAG_TIMER;
+	if (pc->sample_draws)
+		query->b.flags |= R600_QUERY_HW_FLAG_SAMPLE_DRAWS;
 
 	query->num_counters = num_queries;
 
@@ -393,6 +455,12 @@ struct pipe_query *r600_create_batch_query(struct pipe_context *ctx,
 		block = lookup_counter(pc, query_types[i] - R600_QUERY_FIRST_PERFCOUNTER,
 				       &base_gid, &sub_index);
 
+		if (!block->selector_names &&
+		    !r600_init_block_names(screen, block))
+			goto error;
+		counter->name = block->selector_names +
+				sub_index * block->selector_name_stride;
+
 		sub_gid = sub_index / block->num_selectors;
 		sub_index = sub_index % block->num_selectors;
 
@@ -591,6 +659,7 @@ boolean r600_perfcounters_init(struct r600_perfcounters *pc,
 
 	pc->separate_se = debug_get_bool_option("RADEON_PC_SEPARATE_SE", FALSE);
 	pc->separate_instance = debug_get_bool_option("RADEON_PC_SEPARATE_INSTANCE", FALSE);
+	pc->sample_draws = debug_get_bool_option("RADEON_PC_SAMPLE_DRAWS", FALSE);
 
 	return TRUE;
 }
@@ -46,6 +46,8 @@ struct r600_multi_fence {
 	struct pipe_reference reference;
 	struct pipe_fence_handle *gfx;
 	struct pipe_fence_handle *sdma;
+	/* Set once both fences are signalled, to skip the winsys next time. */
+	volatile int signalled;
 };
 
 /*
@@ -116,10 +118,20 @@ void r600_draw_rectangle(struct blitter_context *blitter,
 	pipe_resource_reference(&buf, NULL);
 }
 
-void r600_need_dma_space(struct r600_common_context *ctx, unsigned num_dw)
+void r600_need_dma_space(struct r600_common_context *ctx, unsigned num_dw,
+			 struct r600_resource *dst, struct r600_resource *src)
 {
-	/* Flush the GFX IB if it's not empty. */
-	if (ctx->gfx.cs->cdw > ctx->initial_gfx_cs_size)
+	/* Flush the GFX IB if the DMA copy depends on it: if it accesses
+	 * the destination or writes the source. Other pending GFX work can
+	 * keep accumulating; the kernel orders the rings for every buffer
+	 * once both IBs have been submitted. */
+	if (ctx->gfx.cs->cdw > ctx->initial_gfx_cs_size &&
+	    ((dst &&
+	      ctx->ws->cs_is_buffer_referenced(ctx->gfx.cs, dst->buf,
+					       RADEON_USAGE_READWRITE)) ||
+	     (src &&
+	      ctx->ws->cs_is_buffer_referenced(ctx->gfx.cs, src->buf,
+					       RADEON_USAGE_WRITE))))
 		ctx->gfx.flush(ctx, RADEON_FLUSH_ASYNC, NULL);
 
 	/* Flush if there's not enough space. */
@@ -227,12 +239,44 @@ static enum pipe_reset_status r600_get_reset_status(struct pipe_context *ctx)
 	return PIPE_UNKNOWN_CONTEXT_RESET;
 }
 
+static void r600_set_debug_callback(struct pipe_context *ctx,
+				    const struct pipe_debug_callback *cb)
+{
+	struct r600_common_context *rctx = (struct r600_common_context *)ctx;
+
+	if (cb)
+		rctx->debug = *cb;
+	else
+		memset(&rctx->debug, 0, sizeof(rctx->debug));
+}
+
+static boolean r600_resource_commit(struct pipe_context *pctx,
+				    struct pipe_resource *resource,
+				    unsigned level, struct pipe_box *box,
+				    boolean commit)
+{
+	struct r600_common_context *ctx = (struct r600_common_context *)pctx;
+	struct r600_resource *res = r600_resource(resource);
+
+	/* The mapping changes immediately, so submit the IBs that use the
+	 * buffer first. The winsys waits for them before decommitting. */
+	if (ctx->ws->cs_is_buffer_referenced(ctx->gfx.cs, res->buf,
+					     RADEON_USAGE_READWRITE))
+		ctx->gfx.flush(ctx, RADEON_FLUSH_ASYNC, NULL);
+	if (ctx->dma.cs &&
+	    ctx->ws->cs_is_buffer_referenced(ctx->dma.cs, res->buf,
+					     RADEON_USAGE_READWRITE))
+		ctx->dma.flush(ctx, RADEON_FLUSH_ASYNC, NULL);
+
+	assert(resource->target == PIPE_BUFFER);
+
+	return ctx->ws->buffer_commit(res->buf, box->x, box->width, commit);
+}
+
 bool r600_common_context_init(struct r600_common_context *rctx,
 			      struct r600_common_screen *rscreen)
 {
-	util_slab_create(&rctx->pool_transfers,
-			 sizeof(struct r600_transfer), 64,
-			 UTIL_SLAB_SINGLETHREADED);
+	util_slab_create_child(&rctx->pool_transfers, &rscreen->pool_transfers);
 
 	rctx->screen = rscreen;
 	rctx->ws = rscreen->ws;
@@ -252,6 +296,10 @@ bool r600_common_context_init(struct r600_common_context *rctx,
 	rctx->b.transfer_inline_write = u_default_transfer_inline_write;
         rctx->b.memory_barrier = r600_memory_barrier;
 	rctx->b.flush = r600_flush_from_st;
+	rctx->b.set_debug_callback = r600_set_debug_callback;
+
+	if (rscreen->ws->buffer_commit)
+		rctx->b.resource_commit = r600_resource_commit;
 
 	if (rscreen->info.drm_major == 2 && rscreen->info.drm_minor >= 43) {
 		rctx->b.get_device_reset_status = r600_get_reset_status;
@@ -294,6 +342,11 @@ bool r600_common_context_init(struct r600_common_context *rctx,
 
 void r600_common_context_cleanup(struct r600_common_context *rctx)
 {
+	unsigned i;
+
+	for (i = 0; i < rctx->num_staging_textures; i++)
+		pipe_resource_reference((struct pipe_resource**)&rctx->staging_textures[i], NULL);
+
 	if (rctx->gfx.cs)
 		rctx->ws->cs_destroy(rctx->gfx.cs);
 	if (rctx->dma.cs)
@@ -305,7 +358,7 @@ void r600_common_context_cleanup(struct r600_common_context *rctx)
 		u_upload_destroy(rctx->uploader);
 	}
 
-	util_slab_destroy(&rctx->pool_transfers);
+	util_slab_destroy_child(&rctx->pool_transfers);
 
 	if (rctx->allocator_so_filled_size) {
 		u_suballocator_destroy(rctx->allocator_so_filled_size);
@@ -748,6 +801,10 @@ static boolean r600_fence_finish(struct pipe_screen *screen,
 	struct r600_multi_fence *rfence = (struct r600_multi_fence *)fence;
 	int64_t abs_timeout = os_time_get_absolute_timeout(timeout);
 
+	/* This can only go from false to true, so races don't matter. */
+	if (rfence->signalled)
+		return true;
+
 	if (rfence->sdma) {
 		if (!rws->fence_wait(rws, rfence->sdma, timeout))
 			return false;
@@ -759,10 +816,11 @@ static boolean r600_fence_finish(struct pipe_screen *screen,
 		}
 	}
 
-	if (!rfence->gfx)
-		return true;
+	if (rfence->gfx && !rws->fence_wait(rws, rfence->gfx, timeout))
+		return false;
 
-	return rws->fence_wait(rws, rfence->gfx, timeout);
+	rfence->signalled = true;
+	return true;
 }
 
 static bool r600_interpret_tiling(struct r600_common_screen *rscreen,
@@ -939,6 +997,8 @@ bool r600_common_screen_init(struct r600_common_screen *rscreen,
 	util_format_s3tc_init();
 	pipe_mutex_init(rscreen->aux_context_lock);
 	pipe_mutex_init(rscreen->gpu_load_mutex);
+	util_slab_create_parent(&rscreen->pool_transfers,
+				sizeof(struct r600_transfer), 64);
 
 	if (((rscreen->info.drm_major == 2 && rscreen->info.drm_minor >= 28) ||
 	     rscreen->info.drm_major == 3) &&
@@ -990,6 +1050,7 @@ void r600_destroy_common_screen(struct r600_common_screen *rscreen)
 	pipe_mutex_destroy(rscreen->gpu_load_mutex);
 	pipe_mutex_destroy(rscreen->aux_context_lock);
 	rscreen->aux_context->destroy(rscreen->aux_context);
+	util_slab_destroy_parent(&rscreen->pool_transfers);
 
 	if (rscreen->trace_bo)
 		pipe_resource_reference((struct pipe_resource**)&rscreen->trace_bo, NULL);
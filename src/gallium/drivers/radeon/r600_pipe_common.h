@@ -90,6 +90,10 @@
 
 #define R600_MAP_BUFFER_ALIGNMENT 64
 
+/* Staging textures of finished uploads kept around for reuse. */
+#define R600_NUM_CACHED_STAGING_TEXTURES	8
+#define R600_MAX_CACHED_STAGING_SIZE		(4 * 1024 * 1024)
+
 struct r600_common_context;
 struct r600_perfcounters;
 
@@ -295,6 +299,9 @@ struct r600_common_screen {
 	struct pipe_context		*aux_context;
 	pipe_mutex			aux_context_lock;
 
+	/* Backing store of the contexts' transfer pools. */
+	struct util_slab_parent_pool	pool_transfers;
+
 	struct r600_resource		*trace_bo;
 	uint32_t			*trace_ptr;
 	unsigned			cs_count;
@@ -389,7 +396,11 @@ struct r600_common_context {
 
 	struct u_upload_mgr		*uploader;
 	struct u_suballocator		*allocator_so_filled_size;
-	struct util_slab_mempool	pool_transfers;
+	struct util_slab_child_pool	pool_transfers;
+
+	/* Staging textures of finished uploads, oldest first. */
+	struct r600_texture		*staging_textures[R600_NUM_CACHED_STAGING_TEXTURES];
+	unsigned			num_staging_textures;
 
 	/* Current unaccounted memory usage. */
 	uint64_t			vram;
@@ -413,6 +424,8 @@ struct r600_common_context {
 	unsigned			num_cs_dw_nontimer_queries_suspend;
 	bool				nontimer_queries_suspended_by_flush;
 	unsigned			num_cs_dw_timer_queries_suspend;
+	/* Active queries with R600_QUERY_HW_FLAG_SAMPLE_DRAWS. */
+	unsigned			num_draw_sampled_queries;
 	/* Additional hardware info. */
 	unsigned			backend_mask;
 	unsigned			max_db; /* for OQ */
@@ -440,6 +453,8 @@ struct r600_common_context {
 	 * the GPU addresses are updated. */
 	struct list_head		texture_buffers;
 
+	struct pipe_debug_callback	debug;
+
 	/* Copy one resource to another using async DMA. */
 	void (*dma_copy)(struct pipe_context *ctx,
 			 struct pipe_resource *dst,
@@ -521,7 +536,8 @@ void r600_screen_clear_buffer(struct r600_common_screen *rscreen, struct pipe_re
 struct pipe_resource *r600_resource_create_common(struct pipe_screen *screen,
 						  const struct pipe_resource *templ);
 const char *r600_get_llvm_processor_name(enum radeon_family family);
-void r600_need_dma_space(struct r600_common_context *ctx, unsigned num_dw);
+void r600_need_dma_space(struct r600_common_context *ctx, unsigned num_dw,
+			 struct r600_resource *dst, struct r600_resource *src);
 
 /* r600_gpu_load.c */
 void r600_gpu_load_kill_thread(struct r600_common_screen *rscreen);
@@ -538,6 +554,7 @@ void r600_suspend_nontimer_queries(struct r600_common_context *ctx);
 void r600_resume_nontimer_queries(struct r600_common_context *ctx);
 void r600_suspend_timer_queries(struct r600_common_context *ctx);
 void r600_resume_timer_queries(struct r600_common_context *ctx);
+void r600_query_hw_sample_draw(struct r600_common_context *ctx);
 void r600_query_init_backend_mask(struct r600_common_context *ctx);
 
 /* r600_streamout.c */
@@ -698,6 +698,9 @@ boolean r600_query_hw_begin(struct r600_common_context *rctx,
 		LIST_ADDTAIL(&query->list, &rctx->active_timer_queries);
 	else
 		LIST_ADDTAIL(&query->list, &rctx->active_nontimer_queries);
+
+	if (query->flags & R600_QUERY_HW_FLAG_SAMPLE_DRAWS)
+		rctx->num_draw_sampled_queries++;
    return true;
 }
 
@@ -721,6 +724,9 @@ void r600_query_hw_end(struct r600_common_context *rctx,
 
 	if (!(query->flags & R600_QUERY_HW_FLAG_NO_START))
 		LIST_DELINIT(&query->list);
+
+	if (query->flags & R600_QUERY_HW_FLAG_SAMPLE_DRAWS)
+		rctx->num_draw_sampled_queries--;
 }
 
 static unsigned r600_query_read_result(void *map, unsigned start_index, unsigned end_index,
@@ -1015,6 +1021,32 @@ void r600_resume_timer_queries(struct r600_common_context *ctx)
 			    &ctx->num_cs_dw_timer_queries_suspend);
 }
 
+/* Called by the driver after each draw call while num_draw_sampled_queries
+ * is non-zero. Every active query with R600_QUERY_HW_FLAG_SAMPLE_DRAWS ends
+ * its current result and begins a new one, so that the query buffer holds
+ * one result per draw. The sum over all results is unchanged.
+ */
+void r600_query_hw_sample_draw(struct r600_common_context *ctx)
+{
+	struct r600_query_hw *query;
+	unsigned num_dw = 0;
+
+	LIST_FOR_EACH_ENTRY(query, &ctx->active_timer_queries, list) {
+		if (query->flags & R600_QUERY_HW_FLAG_SAMPLE_DRAWS)
+			num_dw += query->num_cs_dw_begin + 2 * query->num_cs_dw_end;
+	}
+
+	/* Same as resuming: this must not be interrupted by flushes. */
+	ctx->need_gfx_cs_space(&ctx->b, num_dw, FALSE);
+
+	LIST_FOR_EACH_ENTRY(query, &ctx->active_timer_queries, list) {
+		if (query->flags & R600_QUERY_HW_FLAG_SAMPLE_DRAWS) {
+			r600_query_hw_emit_stop(ctx, query);
+			r600_query_hw_emit_start(ctx, query);
+		}
+	}
+}
+
 /* Get backends mask */
 void r600_query_init_backend_mask(struct r600_common_context *ctx)
 {
@@ -76,6 +76,9 @@ enum {
 	R600_QUERY_HW_FLAG_NO_START = (1 << 0),
 	R600_QUERY_HW_FLAG_TIMER = (1 << 1),
 	R600_QUERY_HW_FLAG_PREDICATE = (1 << 2),
+	/* End the current result and begin a new one after every draw, see
+	 * r600_query_hw_sample_draw. */
+	R600_QUERY_HW_FLAG_SAMPLE_DRAWS = (1 << 3),
 };
 
 struct r600_query_hw_ops {
@@ -233,6 +236,7 @@ struct r600_perfcounters {
 
 	boolean separate_se;
 	boolean separate_instance;
+	boolean sample_draws;
 };
 
 struct pipe_query *r600_create_batch_query(struct pipe_context *ctx,
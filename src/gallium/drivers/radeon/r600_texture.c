@@ -994,6 +994,61 @@ static void r600_init_temp_resource_from_box(struct pipe_resource *res,
 	}
 }
 
+/* Return an idle staging texture from the cache that can hold "templ",
+ * or NULL. The caller takes over the reference. */
+static struct r600_texture *
+r600_get_cached_staging_texture(struct r600_common_context *rctx,
+				const struct pipe_resource *templ)
+{
+	unsigned i;
+
+	for (i = 0; i < rctx->num_staging_textures; i++) {
+		struct r600_texture *staging = rctx->staging_textures[i];
+		struct pipe_resource *res = &staging->resource.b.b;
+
+		if (res->target != templ->target ||
+		    res->format != templ->format ||
+		    res->usage != templ->usage ||
+		    res->width0 < templ->width0 ||
+		    res->height0 < templ->height0 ||
+		    res->depth0 < templ->depth0 ||
+		    res->array_size < templ->array_size)
+			continue;
+
+		/* Uploads map the staging texture unsynchronized. */
+		if (r600_rings_is_buffer_referenced(rctx, staging->resource.buf,
+						    RADEON_USAGE_READWRITE) ||
+		    !rctx->ws->buffer_wait(staging->resource.buf, 0,
+					   RADEON_USAGE_READWRITE))
+			continue;
+
+		rctx->num_staging_textures--;
+		memmove(&rctx->staging_textures[i], &rctx->staging_textures[i + 1],
+			(rctx->num_staging_textures - i) * sizeof(rctx->staging_textures[0]));
+		return staging;
+	}
+	return NULL;
+}
+
+/* Put the staging texture of a finished upload into the cache, evicting
+ * the oldest entry if it's full. This takes over the reference. */
+static void r600_cache_staging_texture(struct r600_common_context *rctx,
+				       struct r600_resource *staging)
+{
+	if (staging->buf->size > R600_MAX_CACHED_STAGING_SIZE) {
+		pipe_resource_reference((struct pipe_resource**)&staging, NULL);
+		return;
+	}
+
+	if (rctx->num_staging_textures == R600_NUM_CACHED_STAGING_TEXTURES) {
+		pipe_resource_reference((struct pipe_resource**)&rctx->staging_textures[0], NULL);
+		rctx->num_staging_textures--;
+		memmove(&rctx->staging_textures[0], &rctx->staging_textures[1],
+			rctx->num_staging_textures * sizeof(rctx->staging_textures[0]));
+	}
+	rctx->staging_textures[rctx->num_staging_textures++] = (struct r600_texture*)staging;
+}
+
 static void *r600_texture_transfer_map(struct pipe_context *ctx,
 				       struct pipe_resource *texture,
 				       unsigned level,
@@ -1112,8 +1167,15 @@ static void *r600_texture_transfer_map(struct pipe_context *ctx,
 		resource.usage = (usage & PIPE_TRANSFER_READ) ?
 			PIPE_USAGE_STAGING : PIPE_USAGE_STREAM;
 
+		/* Uploads can reuse the staging texture of an earlier upload
+		 * as long as it's big enough; only the top-left corner is used. */
+		staging = NULL;
+		if (!(usage & PIPE_TRANSFER_READ))
+			staging = r600_get_cached_staging_texture(rctx, &resource);
+
 		/* Create the temporary texture. */
-		staging = (struct r600_texture*)ctx->screen->resource_create(ctx->screen, &resource);
+		if (!staging)
+			staging = (struct r600_texture*)ctx->screen->resource_create(ctx->screen, &resource);
 		if (!staging) {
 			R600_ERR("failed to create temporary texture to hold untiled copy\n");
 			FREE(trans);
@@ -1168,8 +1230,13 @@ static void r600_texture_transfer_unmap(struct pipe_context *ctx,
 		}
 	}
 
-	if (rtransfer->staging)
-		pipe_resource_reference((struct pipe_resource**)&rtransfer->staging, NULL);
+	if (rtransfer->staging) {
+		if (!rtex->is_depth && !(transfer->usage & PIPE_TRANSFER_READ))
+			r600_cache_staging_texture((struct r600_common_context*)ctx,
+						   rtransfer->staging);
+		else
+			pipe_resource_reference((struct pipe_resource**)&rtransfer->staging, NULL);
+	}
 
 	FREE(transfer);
 }
@@ -1376,6 +1443,18 @@ static void vi_get_fast_clear_parameters(enum pipe_format surface_format,
 		*reset_value |= 0x40404040U;
 }
 
+/* Return the size of the DCC of one level, or 0 if it can't be cleared on
+ * its own. The DCC of each level is placed after the previous level. */
+static uint64_t vi_dcc_level_size(struct r600_texture *rtex, unsigned level)
+{
+	uint64_t start = rtex->surface.level[level].dcc_offset;
+	uint64_t end = level < rtex->resource.b.b.last_level ?
+			       rtex->surface.level[level + 1].dcc_offset :
+			       rtex->surface.dcc_size;
+
+	return end > start ? end - start : 0;
+}
+
 void evergreen_do_fast_color_clear(struct r600_common_context *rctx,
 				   struct pipe_framebuffer_state *fb,
 				   struct r600_atom *fb_state,
@@ -1390,6 +1469,7 @@ void evergreen_do_fast_color_clear(struct r600_common_context *rctx,
 	for (i = 0; i < fb->nr_cbufs; i++) {
 		struct r600_surface *surf;
 		struct r600_texture *tex;
+		unsigned level;
 		unsigned clear_bit = PIPE_CLEAR_COLOR0 << i;
 
 		if (!fb->cbufs[i])
@@ -1401,6 +1481,7 @@ void evergreen_do_fast_color_clear(struct r600_common_context *rctx,
 
 		surf = (struct r600_surface *)fb->cbufs[i];
 		tex = (struct r600_texture *)fb->cbufs[i]->texture;
+		level = fb->cbufs[i]->u.tex.level;
 
 		/* 128-bit formats are unusupported */
 		if (util_format_get_blocksizebits(fb->cbufs[i]->format) > 64) {
@@ -1409,22 +1490,23 @@ void evergreen_do_fast_color_clear(struct r600_common_context *rctx,
 
 		/* the clear is allowed if all layers are bound */
 		if (fb->cbufs[i]->u.tex.first_layer != 0 ||
-		    fb->cbufs[i]->u.tex.last_layer != util_max_layer(&tex->resource.b.b, 0)) {
+		    fb->cbufs[i]->u.tex.last_layer != util_max_layer(&tex->resource.b.b, level)) {
 			continue;
 		}
 
-		/* cannot clear mipmapped textures */
-		if (fb->cbufs[i]->texture->last_level != 0) {
+		/* CMASK only covers the first level, so mipmapped textures
+		 * can only be fast cleared with DCC, one level at a time. */
+		if (fb->cbufs[i]->texture->last_level != 0 && !tex->dcc_buffer) {
 			continue;
 		}
 
 		/* only supported on tiled surfaces */
-		if (tex->surface.level[0].mode < RADEON_SURF_MODE_1D) {
+		if (tex->surface.level[level].mode < RADEON_SURF_MODE_1D) {
 			continue;
 		}
 
 		/* fast color clear with 1D tiling doesn't work on old kernels and CIK */
-		if (tex->surface.level[0].mode == RADEON_SURF_MODE_1D &&
+		if (tex->surface.level[level].mode == RADEON_SURF_MODE_1D &&
 		    rctx->chip_class >= CIK &&
 		    rctx->screen->info.drm_major == 2 &&
 		    rctx->screen->info.drm_minor < 38) {
@@ -1434,17 +1516,27 @@ void evergreen_do_fast_color_clear(struct r600_common_context *rctx,
 		if (tex->dcc_buffer) {
 			uint32_t reset_value;
 			bool clear_words_needed;
+			uint64_t dcc_size = vi_dcc_level_size(tex, level);
 
 			if (rctx->screen->debug_flags & DBG_NO_DCC_CLEAR)
 				continue;
 
+			if (!dcc_size)
+				continue;
+
+			/* The clear color is per texture. Other levels that
+			 * still need a fast clear eliminate use the old one. */
+			if (tex->dirty_level_mask & ~(1 << level))
+				continue;
+
 			vi_get_fast_clear_parameters(fb->cbufs[i]->format, color, &reset_value, &clear_words_needed);
 
 			rctx->clear_buffer(&rctx->b, &tex->dcc_buffer->b.b,
-					0, tex->surface.dcc_size, reset_value, true);
+					tex->surface.level[level].dcc_offset,
+					dcc_size, reset_value, true);
 
 			if (clear_words_needed)
-				tex->dirty_level_mask |= 1 << fb->cbufs[i]->u.tex.level;
+				tex->dirty_level_mask |= 1 << level;
 		} else {
 			/* RB+ doesn't work with CMASK fast clear. */
 			if (surf->sx_ps_downconvert)
@@ -1460,7 +1552,7 @@ void evergreen_do_fast_color_clear(struct r600_common_context *rctx,
 			rctx->clear_buffer(&rctx->b, &tex->cmask_buffer->b.b,
 					tex->cmask.offset, tex->cmask.size, 0, true);
 
-			tex->dirty_level_mask |= 1 << fb->cbufs[i]->u.tex.level;
+			tex->dirty_level_mask |= 1 << level;
 		}
 
 		evergreen_set_clear_color(tex, fb->cbufs[i]->format, color);
@@ -229,6 +229,44 @@ void rvce_frame_offset(struct rvce_encoder *enc, struct rvce_cpb_slot *slot,
 	*chroma_offset = *luma_offset + pitch * vpitch;
 }
 
+/**
+ * get a feedback buffer, reusing one of the already read ones if possible
+ */
+static struct rvid_buffer *get_feedback_buffer(struct rvce_encoder *enc)
+{
+	struct rvce_feedback *fb;
+
+	if (!LIST_IS_EMPTY(&enc->free_fbs)) {
+		fb = LIST_ENTRY(struct rvce_feedback, enc->free_fbs.next, list);
+		LIST_DEL(&fb->list);
+		return &fb->buf;
+	}
+
+	fb = CALLOC_STRUCT(rvce_feedback);
+	if (!fb)
+		return NULL;
+
+	if (!rvid_create_buffer(enc->screen, &fb->buf, 512, PIPE_USAGE_STAGING)) {
+		FREE(fb);
+		return NULL;
+	}
+	return &fb->buf;
+}
+
+/**
+ * free the feedback buffers not in use by the state tracker
+ */
+static void free_feedback_buffers(struct rvce_encoder *enc)
+{
+	struct rvce_feedback *fb, *next;
+
+	LIST_FOR_EACH_ENTRY_SAFE(fb, next, &enc->free_fbs, list) {
+		rvid_destroy_buffer(&fb->buf);
+		FREE(fb);
+	}
+	LIST_INITHEAD(&enc->free_fbs);
+}
+
 /**
  * destroy this video encoder
  */
@@ -247,6 +285,7 @@ static void rvce_destroy(struct pipe_video_codec *encoder)
 	}
 	rvid_destroy_buffer(&enc->cpb);
 	enc->ws->cs_destroy(enc->cs);
+	free_feedback_buffers(enc);
 	FREE(enc->cpb_array);
 	FREE(enc);
 }
@@ -307,8 +346,8 @@ static void rvce_encode_bitstream(struct pipe_video_codec *encoder,
 	enc->get_buffer(destination, &enc->bs_handle, NULL);
 	enc->bs_size = destination->width0;
 
-	*fb = enc->fb = CALLOC_STRUCT(rvid_buffer);
-	if (!rvid_create_buffer(enc->screen, enc->fb, 512, PIPE_USAGE_STAGING)) {
+	*fb = enc->fb = get_feedback_buffer(enc);
+	if (!enc->fb) {
 		RVID_ERR("Can't create feedback buffer.\n");
 		return;
 	}
@@ -343,22 +382,28 @@ static void rvce_get_feedback(struct pipe_video_codec *encoder,
 			      void *feedback, unsigned *size)
 {
 	struct rvce_encoder *enc = (struct rvce_encoder*)encoder;
-	struct rvid_buffer *fb = feedback;
+	struct rvce_feedback *fb = feedback;
+
+	if (!fb)
+		return;
 
 	if (size) {
-		uint32_t *ptr = enc->ws->buffer_map(fb->res->buf, enc->cs, PIPE_TRANSFER_READ_WRITE);
+		uint32_t *ptr = enc->ws->buffer_map(fb->buf.res->buf, enc->cs, PIPE_TRANSFER_READ);
 
-		if (ptr[1]) {
+		if (ptr && ptr[1]) {
 			*size = ptr[4] - ptr[9];
 		} else {
 			*size = 0;
 		}
 
-		enc->ws->buffer_unmap(fb->res->buf);
+		enc->ws->buffer_unmap(fb->buf.res->buf);
 	}
-	//dump_feedback(enc, fb);
-	rvid_destroy_buffer(fb);
-	FREE(fb);
+	//dump_feedback(enc, &fb->buf);
+
+	/* Commands using the buffer execute in order on the VCE ring, so it
+	 * can be handed out again even when it wasn't waited for.
+	 */
+	LIST_ADDTAIL(&fb->list, &enc->free_fbs);
 }
 
 /**
@@ -425,6 +470,7 @@ struct pipe_video_codec *rvce_create_encoder(struct pipe_context *context,
 	enc->base.flush = rvce_flush;
 	enc->base.get_feedback = rvce_get_feedback;
 	enc->get_buffer = get_buffer;
+	LIST_INITHEAD(&enc->free_fbs);
 
 	enc->screen = context->screen;
 	enc->ws = ws;
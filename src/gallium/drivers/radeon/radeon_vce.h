@@ -46,6 +46,9 @@
 #define RVCE_MAX_BITSTREAM_OUTPUT_ROW_SIZE (4096 * 16 * 2.5)
 #define RVCE_MAX_AUX_BUFFER_NUM 4
 
+/* frames a session can have queued before the oldest feedback is read */
+#define RVCE_MAX_FRAMES_IN_FLIGHT 4
+
 struct r600_common_screen;
 
 /* driver dependent callback */
@@ -63,6 +66,12 @@ struct rvce_cpb_slot {
 	unsigned			pic_order_cnt;
 };
 
+/* Feedback buffer, reused across frames */
+struct rvce_feedback {
+	struct rvid_buffer		buf;	/* must be first */
+	struct list_head		list;
+};
+
 /* VCE encoder representation */
 struct rvce_encoder {
 	struct pipe_video_codec		base;
@@ -104,6 +113,7 @@ struct rvce_encoder {
 	unsigned			cpb_num;
 
 	struct rvid_buffer		*fb;
+	struct list_head		free_fbs;
 	struct rvid_buffer		cpb;
 	struct pipe_h264_enc_picture_desc pic;
 
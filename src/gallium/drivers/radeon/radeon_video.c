@@ -227,7 +227,7 @@ int rvid_get_video_param(struct pipe_screen *screen,
 	        case PIPE_VIDEO_CAP_SUPPORTS_PROGRESSIVE:
         	        return true;
 	        case PIPE_VIDEO_CAP_STACKED_FRAMES:
-			return (rscreen->family < CHIP_TONGA) ? 1 : 2;
+			return RVCE_MAX_FRAMES_IN_FLIGHT;
 	        default:
         	        return 0;
 		}
@@ -65,8 +65,11 @@ enum radeon_bo_flag { /* bitfield */
     RADEON_FLAG_GTT_WC =        (1 << 0),
     RADEON_FLAG_CPU_ACCESS =    (1 << 1),
     RADEON_FLAG_NO_CPU_ACCESS = (1 << 2),
+    RADEON_FLAG_SPARSE =        (1 << 3),
 };
 
+#define RADEON_SPARSE_PAGE_SIZE (64 * 1024)
+
 enum radeon_bo_usage { /* bitfield */
     RADEON_USAGE_READ = 2,
     RADEON_USAGE_WRITE = 4,
@@ -555,6 +558,26 @@ struct radeon_winsys {
      */
     enum radeon_bo_domain (*buffer_get_initial_domain)(struct pb_buffer *buf);
 
+    /**
+     * Commit or decommit the memory backing a range of a sparse buffer
+     * (one created with RADEON_FLAG_SPARSE). Sparse buffers are never
+     * CPU-mappable.
+     *
+     * The range must be aligned to RADEON_SPARSE_PAGE_SIZE, except that it
+     * may end at the end of the buffer. The caller must make sure that no
+     * CS which hasn't been flushed yet uses the buffer.
+     *
+     * This is NULL if the winsys doesn't support sparse buffers.
+     *
+     * \param buf       A sparse winsys buffer object
+     * \param offset    The start of the range in bytes
+     * \param size      The size of the range in bytes
+     * \param commit    Whether to commit or decommit the range
+     * \return          false if the memory couldn't be allocated
+     */
+    bool (*buffer_commit)(struct pb_buffer *buf, uint64_t offset,
+                          uint64_t size, bool commit);
+
     /**************************************************************************
      * Command submission.
      *
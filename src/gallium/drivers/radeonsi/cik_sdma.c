@@ -59,7 +59,7 @@ static void cik_sdma_do_copy_buffer(struct si_context *ctx,
 	src_offset += r600_resource(src)->gpu_address;
 
 	ncopy = (size + CIK_SDMA_COPY_MAX_SIZE - 1) / CIK_SDMA_COPY_MAX_SIZE;
-	r600_need_dma_space(&ctx->b, ncopy * 7);
+	r600_need_dma_space(&ctx->b, ncopy * 7, rdst, rsrc);
 
 	radeon_add_to_buffer_list(&ctx->b, &ctx->b.dma, rsrc, RADEON_USAGE_READ,
 			      RADEON_PRIO_SDMA_BUFFER);
@@ -169,7 +169,7 @@ static void cik_sdma_copy_tile(struct si_context *ctx,
 		cheight &= ~(y_align - 1);
 	}
 	ncopy = (copy_height + cheight - 1) / cheight;
-	r600_need_dma_space(&ctx->b, ncopy * 12);
+	r600_need_dma_space(&ctx->b, ncopy * 12, &rdst->resource, &rsrc->resource);
 
 	radeon_add_to_buffer_list(&ctx->b, &ctx->b.dma, &rsrc->resource,
 			      RADEON_USAGE_READ, RADEON_PRIO_SDMA_TEXTURE);
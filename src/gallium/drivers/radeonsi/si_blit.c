@@ -131,6 +131,9 @@ static void si_blit_decompress_depth(struct pipe_context *ctx,
 
 	assert(sctx->dbcb_depth_copy_enabled || sctx->dbcb_stencil_copy_enabled);
 
+	si_blitter_begin(ctx, SI_DECOMPRESS);
+	util_blitter_begin_batch(sctx->blitter);
+
 	for (level = first_level; level <= last_level; level++) {
 		if (!staging && !(texture->dirty_level_mask & (1 << level)))
 			continue;
@@ -158,10 +161,8 @@ static void si_blit_decompress_depth(struct pipe_context *ctx,
 				cbsurf = ctx->create_surface(ctx,
 						(struct pipe_resource*)flushed_depth_texture, &surf_tmpl);
 
-				si_blitter_begin(ctx, SI_DECOMPRESS);
 				util_blitter_custom_depth_stencil(sctx->blitter, zsurf, cbsurf, 1 << sample,
 								  sctx->custom_dsa_flush, depth);
-				si_blitter_end(ctx);
 
 				pipe_surface_reference(&zsurf, NULL);
 				pipe_surface_reference(&cbsurf, NULL);
@@ -177,6 +178,9 @@ static void si_blit_decompress_depth(struct pipe_context *ctx,
 		}
 	}
 
+	util_blitter_end_batch(sctx->blitter);
+	si_blitter_end(ctx);
+
 	sctx->dbcb_depth_copy_enabled = false;
 	sctx->dbcb_stencil_copy_enabled = false;
 	si_mark_atom_dirty(sctx, &sctx->db_render_state);
@@ -203,6 +207,9 @@ static void si_blit_decompress_depth_in_place(struct si_context *sctx,
 
 	surf_tmpl.format = texture->resource.b.b.format;
 
+	si_blitter_begin(&sctx->b.b, SI_DECOMPRESS);
+	util_blitter_begin_batch(sctx->blitter);
+
 	for (level = first_level; level <= last_level; level++) {
 		if (!(*dirty_level_mask & (1 << level)))
 			continue;
@@ -220,11 +227,9 @@ static void si_blit_decompress_depth_in_place(struct si_context *sctx,
 
 			zsurf = sctx->b.b.create_surface(&sctx->b.b, &texture->resource.b.b, &surf_tmpl);
 
-			si_blitter_begin(&sctx->b.b, SI_DECOMPRESS);
 			util_blitter_custom_depth_stencil(sctx->blitter, zsurf, NULL, ~0,
 							  sctx->custom_dsa_flush,
 							  1.0f);
-			si_blitter_end(&sctx->b.b);
 
 			pipe_surface_reference(&zsurf, NULL);
 		}
@@ -236,6 +241,9 @@ static void si_blit_decompress_depth_in_place(struct si_context *sctx,
 		}
 	}
 
+	util_blitter_end_batch(sctx->blitter);
+	si_blitter_end(&sctx->b.b);
+
 	sctx->db_flush_depth_inplace = false;
 	sctx->db_flush_stencil_inplace = false;
 	si_mark_atom_dirty(sctx, &sctx->db_render_state);
@@ -279,6 +287,9 @@ static void si_blit_decompress_color(struct pipe_context *ctx,
 	if (!rtex->dirty_level_mask)
 		return;
 
+	si_blitter_begin(ctx, SI_DECOMPRESS);
+	util_blitter_begin_batch(sctx->blitter);
+
 	for (level = first_level; level <= last_level; level++) {
 		if (!(rtex->dirty_level_mask & (1 << level)))
 			continue;
@@ -297,11 +308,9 @@ static void si_blit_decompress_color(struct pipe_context *ctx,
 			surf_tmpl.u.tex.last_layer = layer;
 			cbsurf = ctx->create_surface(ctx, &rtex->resource.b.b, &surf_tmpl);
 
-			si_blitter_begin(ctx, SI_DECOMPRESS);
 			util_blitter_custom_color(sctx->blitter, cbsurf,
 				rtex->fmask.size ? sctx->custom_blend_decompress :
 						   sctx->custom_blend_fastclear);
-			si_blitter_end(ctx);
 
 			pipe_surface_reference(&cbsurf, NULL);
 		}
@@ -312,6 +321,9 @@ static void si_blit_decompress_color(struct pipe_context *ctx,
 			rtex->dirty_level_mask &= ~(1 << level);
 		}
 	}
+
+	util_blitter_end_batch(sctx->blitter);
+	si_blitter_end(ctx);
 }
 
 void si_decompress_color_textures(struct si_context *sctx,
@@ -30,7 +30,8 @@
  *
  * This file is responsible for managing such lists. It keeps a copy of all
  * descriptors in CPU memory and re-uploads a whole list if some slots have
- * been changed.
+ * been changed. Slots are only marked dirty if their contents really
+ * change, so rebinding the same state doesn't cause an upload.
  *
  * This code is also reponsible for updating shader pointers to those lists.
  *
@@ -72,6 +73,8 @@ static uint32_t null_descriptor[8] = {
 	 * descriptor */
 };
 
+static const uint32_t null_buffer_descriptor[4];
+
 static void si_init_descriptors(struct si_descriptors *desc,
 				unsigned shader_userdata_index,
 				unsigned element_dw_size,
@@ -84,7 +87,9 @@ static void si_init_descriptors(struct si_descriptors *desc,
 	desc->list = CALLOC(num_elements, element_dw_size * 4);
 	desc->element_dw_size = element_dw_size;
 	desc->num_elements = num_elements;
-	desc->list_dirty = true; /* upload the list before the next draw */
+	/* upload the list before the next draw */
+	desc->dirty_mask = num_elements == 64 ? ~0llu :
+					       (1llu << num_elements) - 1;
 	desc->shader_userdata_offset = shader_userdata_index * 4;
 
 	/* Initialize the array to NULL descriptors if the element size is 8. */
@@ -100,13 +105,32 @@ static void si_release_descriptors(struct si_descriptors *desc)
 	FREE(desc->list);
 }
 
+/* Set a descriptor in the CPU copy of the list. The slot is only marked
+ * dirty if the descriptor differs from the one that is already there. */
+static void si_set_descriptor(struct si_descriptors *desc, unsigned slot,
+			      const uint32_t *data)
+{
+	uint32_t *dst = desc->list + slot * desc->element_dw_size;
+	unsigned size = desc->element_dw_size * 4;
+
+	if (memcmp(dst, data, size) == 0)
+		return;
+
+	memcpy(dst, data, size);
+	desc->dirty_mask |= 1llu << slot;
+}
+
+/* Upload the list if any slot has changed. The whole list is always
+ * uploaded, because shaders access it through a single pointer and
+ * a list that may still be in use by the GPU can't be updated in place.
+ */
 static bool si_upload_descriptors(struct si_context *sctx,
 				  struct si_descriptors *desc)
 {
 	unsigned list_size = desc->num_elements * desc->element_dw_size * 4;
 	void *ptr;
 
-	if (!desc->list_dirty)
+	if (!desc->dirty_mask)
 		return true;
 
 	u_upload_alloc(sctx->b.uploader, 0, list_size,
@@ -120,7 +144,7 @@ static bool si_upload_descriptors(struct si_context *sctx,
 	radeon_add_to_buffer_list(&sctx->b, &sctx->b.gfx, desc->buffer,
 			      RADEON_USAGE_READ, RADEON_PRIO_DESCRIPTORS);
 
-	desc->list_dirty = false;
+	desc->dirty_mask = 0;
 	desc->pointer_dirty = true;
 	si_mark_atom_dirty(sctx, &sctx->shader_userdata.atom);
 	return true;
@@ -187,15 +211,13 @@ static void si_set_sampler_view(struct si_context *sctx, unsigned shader,
 				RADEON_PRIO_DCC);
 
 		pipe_sampler_view_reference(&views->views[slot], view);
-		memcpy(views->desc.list + slot*8, view_desc, 8*4);
+		si_set_descriptor(&views->desc, slot, view_desc);
 		views->desc.enabled_mask |= 1llu << slot;
 	} else {
 		pipe_sampler_view_reference(&views->views[slot], NULL);
-		memcpy(views->desc.list + slot*8, null_descriptor, 8*4);
+		si_set_descriptor(&views->desc, slot, null_descriptor);
 		views->desc.enabled_mask &= ~(1llu << slot);
 	}
-
-	views->desc.list_dirty = true;
 }
 
 static void si_set_sampler_views(struct pipe_context *ctx,
@@ -292,8 +314,7 @@ static void si_bind_sampler_states(struct pipe_context *ctx, unsigned shader,
 		if (!sstates[i])
 			continue;
 
-		memcpy(samplers->desc.list + slot*4, sstates[i]->val, 4*4);
-		samplers->desc.list_dirty = true;
+		si_set_descriptor(&samplers->desc, slot, sstates[i]->val);
 	}
 }
 
@@ -512,7 +533,7 @@ static void si_set_constant_buffer(struct pipe_context *ctx, uint shader, uint s
 		}
 
 		/* Set the descriptor. */
-		uint32_t *desc = buffers->desc.list + slot*4;
+		uint32_t desc[4];
 		desc[0] = va;
 		desc[1] = S_008F04_BASE_ADDRESS_HI(va >> 32) |
 			  S_008F04_STRIDE(0);
@@ -523,6 +544,7 @@ static void si_set_constant_buffer(struct pipe_context *ctx, uint shader, uint s
 			  S_008F0C_DST_SEL_W(V_008F0C_SQ_SEL_W) |
 			  S_008F0C_NUM_FORMAT(V_008F0C_BUF_NUM_FORMAT_FLOAT) |
 			  S_008F0C_DATA_FORMAT(V_008F0C_BUF_DATA_FORMAT_32);
+		si_set_descriptor(&buffers->desc, slot, desc);
 
 		buffers->buffers[slot] = buffer;
 		radeon_add_to_buffer_list(&sctx->b, &sctx->b.gfx,
@@ -531,11 +553,9 @@ static void si_set_constant_buffer(struct pipe_context *ctx, uint shader, uint s
 		buffers->desc.enabled_mask |= 1llu << slot;
 	} else {
 		/* Clear the descriptor. */
-		memset(buffers->desc.list + slot*4, 0, sizeof(uint32_t) * 4);
+		si_set_descriptor(&buffers->desc, slot, null_buffer_descriptor);
 		buffers->desc.enabled_mask &= ~(1llu << slot);
 	}
-
-	buffers->desc.list_dirty = true;
 }
 
 /* RING BUFFERS */
@@ -603,7 +623,7 @@ void si_set_ring_buffer(struct pipe_context *ctx, uint shader, uint slot,
 			num_records *= stride;
 
 		/* Set the descriptor. */
-		uint32_t *desc = buffers->desc.list + slot*4;
+		uint32_t desc[4];
 		desc[0] = va;
 		desc[1] = S_008F04_BASE_ADDRESS_HI(va >> 32) |
 			  S_008F04_STRIDE(stride) |
@@ -618,6 +638,7 @@ void si_set_ring_buffer(struct pipe_context *ctx, uint shader, uint slot,
 			  S_008F0C_ELEMENT_SIZE(element_size) |
 			  S_008F0C_INDEX_STRIDE(index_stride) |
 			  S_008F0C_ADD_TID_ENABLE(add_tid);
+		si_set_descriptor(&buffers->desc, slot, desc);
 
 		pipe_resource_reference(&buffers->buffers[slot], buffer);
 		radeon_add_to_buffer_list(&sctx->b, &sctx->b.gfx,
@@ -626,11 +647,9 @@ void si_set_ring_buffer(struct pipe_context *ctx, uint shader, uint slot,
 		buffers->desc.enabled_mask |= 1llu << slot;
 	} else {
 		/* Clear the descriptor. */
-		memset(buffers->desc.list + slot*4, 0, sizeof(uint32_t) * 4);
+		si_set_descriptor(&buffers->desc, slot, null_buffer_descriptor);
 		buffers->desc.enabled_mask &= ~(1llu << slot);
 	}
-
-	buffers->desc.list_dirty = true;
 }
 
 /* STREAMOUT BUFFERS */
@@ -697,7 +716,7 @@ static void si_set_streamout_targets(struct pipe_context *ctx,
 			 * the buffer will be considered not bound and store
 			 * instructions will be no-ops.
 			 */
-			uint32_t *desc = buffers->desc.list + bufidx*4;
+			uint32_t desc[4];
 			desc[0] = va;
 			desc[1] = S_008F04_BASE_ADDRESS_HI(va >> 32);
 			desc[2] = 0xffffffff;
@@ -706,6 +725,7 @@ static void si_set_streamout_targets(struct pipe_context *ctx,
 				  S_008F0C_DST_SEL_Z(V_008F0C_SQ_SEL_Z) |
 				  S_008F0C_DST_SEL_W(V_008F0C_SQ_SEL_W) |
 				  S_008F0C_DATA_FORMAT(V_008F0C_BUF_DATA_FORMAT_32);
+			si_set_descriptor(&buffers->desc, bufidx, desc);
 
 			/* Set the resource. */
 			pipe_resource_reference(&buffers->buffers[bufidx],
@@ -716,8 +736,8 @@ static void si_set_streamout_targets(struct pipe_context *ctx,
 			buffers->desc.enabled_mask |= 1llu << bufidx;
 		} else {
 			/* Clear the descriptor and unset the resource. */
-			memset(buffers->desc.list + bufidx*4, 0,
-			       sizeof(uint32_t) * 4);
+			si_set_descriptor(&buffers->desc, bufidx,
+					  null_buffer_descriptor);
 			pipe_resource_reference(&buffers->buffers[bufidx],
 						NULL);
 			buffers->desc.enabled_mask &= ~(1llu << bufidx);
@@ -726,12 +746,10 @@ static void si_set_streamout_targets(struct pipe_context *ctx,
 	for (; i < old_num_targets; i++) {
 		bufidx = SI_SO_BUF_OFFSET + i;
 		/* Clear the descriptor and unset the resource. */
-		memset(buffers->desc.list + bufidx*4, 0, sizeof(uint32_t) * 4);
+		si_set_descriptor(&buffers->desc, bufidx, null_buffer_descriptor);
 		pipe_resource_reference(&buffers->buffers[bufidx], NULL);
 		buffers->desc.enabled_mask &= ~(1llu << bufidx);
 	}
-
-	buffers->desc.list_dirty = true;
 }
 
 static void si_desc_reset_buffer_offset(struct pipe_context *ctx,
@@ -807,7 +825,7 @@ static void si_invalidate_buffer(struct pipe_context *ctx, struct pipe_resource
 			if (buffers->buffers[i] == buf) {
 				si_desc_reset_buffer_offset(ctx, buffers->desc.list + i*4,
 							    old_va, buf);
-				buffers->desc.list_dirty = true;
+				buffers->desc.dirty_mask |= 1llu << i;
 
 				radeon_add_to_buffer_list(&sctx->b, &sctx->b.gfx,
 						      rbuffer, buffers->shader_usage,
@@ -836,7 +854,7 @@ static void si_invalidate_buffer(struct pipe_context *ctx, struct pipe_resource
 			if (buffers->buffers[i] == buf) {
 				si_desc_reset_buffer_offset(ctx, buffers->desc.list + i*4,
 							    old_va, buf);
-				buffers->desc.list_dirty = true;
+				buffers->desc.dirty_mask |= 1llu << i;
 
 				radeon_add_to_buffer_list(&sctx->b, &sctx->b.gfx,
 						      rbuffer, buffers->shader_usage,
@@ -861,7 +879,7 @@ static void si_invalidate_buffer(struct pipe_context *ctx, struct pipe_resource
 			if (views->views[i]->texture == buf) {
 				si_desc_reset_buffer_offset(ctx, views->desc.list + i*8+4,
 							    old_va, buf);
-				views->desc.list_dirty = true;
+				views->desc.dirty_mask |= 1llu << i;
 
 				radeon_add_to_buffer_list(&sctx->b, &sctx->b.gfx,
 						      rbuffer, RADEON_USAGE_READ,
@@ -27,6 +27,7 @@
 
 #include "radeon/radeon_llvm_emit.h"
 #include "radeon/radeon_uvd.h"
+#include "util/u_cpu_detect.h"
 #include "util/u_memory.h"
 #include "vl/vl_decoder.h"
 
@@ -97,16 +98,29 @@ si_amdgpu_get_reset_status(struct pipe_context *ctx)
 	return sctx->b.ws->ctx_query_reset_status(sctx->b.ctx);
 }
 
+LLVMTargetMachineRef si_create_llvm_target_machine(struct si_screen *sscreen)
+{
+#if HAVE_LLVM >= 0x0306
+	const char *triple = "amdgcn--";
+	LLVMTargetRef r600_target = radeon_llvm_get_r600_target(triple);
+
+	return LLVMCreateTargetMachine(r600_target, triple,
+				       r600_get_llvm_processor_name(sscreen->b.family),
+				       "+DumpCode,+vgpr-spilling",
+				       LLVMCodeGenLevelDefault,
+				       LLVMRelocDefault,
+				       LLVMCodeModelDefault);
+#else
+	return NULL;
+#endif
+}
+
 static struct pipe_context *si_create_context(struct pipe_screen *screen,
                                               void *priv, unsigned flags)
 {
 	struct si_context *sctx = CALLOC_STRUCT(si_context);
 	struct si_screen* sscreen = (struct si_screen *)screen;
 	struct radeon_winsys *ws = sscreen->b.ws;
-	LLVMTargetRef r600_target;
-#if HAVE_LLVM >= 0x0306
-	const char *triple = "amdgcn--";
-#endif
 	int shader, i;
 
 	if (!sctx)
@@ -210,16 +224,8 @@ static struct pipe_context *si_create_context(struct pipe_screen *screen,
 	 */
 	sctx->scratch_waves = 32 * sscreen->b.info.max_compute_units;
 
-#if HAVE_LLVM >= 0x0306
 	/* Initialize LLVM TargetMachine */
-	r600_target = radeon_llvm_get_r600_target(triple);
-	sctx->tm = LLVMCreateTargetMachine(r600_target, triple,
-					   r600_get_llvm_processor_name(sscreen->b.family),
-					   "+DumpCode,+vgpr-spilling",
-					   LLVMCodeGenLevelDefault,
-					   LLVMRelocDefault,
-					   LLVMCodeModelDefault);
-#endif
+	sctx->tm = si_create_llvm_target_machine(sscreen);
 
 	return &sctx->b.b;
 fail:
@@ -340,8 +346,12 @@ static int si_get_param(struct pipe_screen* pscreen, enum pipe_cap param)
 	case PIPE_CAP_TEXTURE_GATHER_OFFSETS:
 	case PIPE_CAP_VERTEXID_NOBASE:
 	case PIPE_CAP_CLEAR_TEXTURE:
+	case PIPE_CAP_QUERY_BUFFER_OBJECT:
 		return 0;
 
+	case PIPE_CAP_SPARSE_BUFFER_PAGE_SIZE:
+		return sscreen->b.ws->buffer_commit ? RADEON_SPARSE_PAGE_SIZE : 0;
+
 	case PIPE_CAP_MAX_SHADER_PATCH_VARYINGS:
 		return 30;
 
@@ -519,6 +529,7 @@ static int si_get_shader_param(struct pipe_screen* pscreen, unsigned shader, enu
 static void si_destroy_screen(struct pipe_screen* pscreen)
 {
 	struct si_screen *sscreen = (struct si_screen *)pscreen;
+	unsigned i;
 
 	if (!sscreen)
 		return;
@@ -526,6 +537,17 @@ static void si_destroy_screen(struct pipe_screen* pscreen)
 	if (!sscreen->b.ws->unref(sscreen->b.ws))
 		return;
 
+	if (util_queue_is_initialized(&sscreen->shader_compiler_queue))
+		util_queue_destroy(&sscreen->shader_compiler_queue);
+
+#if HAVE_LLVM >= 0x0306
+	for (i = 0; i < ARRAY_SIZE(sscreen->tm); i++)
+		if (sscreen->tm[i])
+			LLVMDisposeTargetMachine(sscreen->tm[i]);
+#endif
+
+	si_destroy_shader_cache(sscreen);
+
 	r600_destroy_common_screen(&sscreen->b);
 }
 
@@ -610,6 +632,7 @@ static bool si_init_gs_info(struct si_screen *sscreen)
 struct pipe_screen *radeonsi_screen_create(struct radeon_winsys *ws)
 {
 	struct si_screen *sscreen = CALLOC_STRUCT(si_screen);
+	unsigned num_compiler_threads, i;
 
 	if (!sscreen) {
 		return NULL;
@@ -630,6 +653,23 @@ struct pipe_screen *radeonsi_screen_create(struct radeon_winsys *ws)
 		return NULL;
 	}
 
+	/* Without the cache, shaders are simply always compiled. */
+	si_init_shader_cache(sscreen);
+
+	/* Compile shaders in the background when there is more than one CPU.
+	 * The calling thread keeps one CPU for itself.
+	 */
+	util_cpu_detect();
+	num_compiler_threads = MIN2(util_cpu_caps.nr_cpus - 1,
+				    ARRAY_SIZE(sscreen->tm));
+	if (num_compiler_threads > 0 &&
+	    !debug_get_bool_option("RADEON_DISABLE_ASYNC_COMPILE", FALSE) &&
+	    util_queue_init(&sscreen->shader_compiler_queue, "si_shader",
+			    32, num_compiler_threads)) {
+		for (i = 0; i < sscreen->shader_compiler_queue.num_threads; i++)
+			sscreen->tm[i] = si_create_llvm_target_machine(sscreen);
+	}
+
 	if (!debug_get_bool_option("RADEON_DISABLE_PERFCOUNTERS", FALSE))
 		si_init_perfcounters(sscreen);
 
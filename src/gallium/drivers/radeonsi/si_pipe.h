@@ -28,6 +28,8 @@
 
 #include "si_state.h"
 
+#include "util/u_queue.h"
+
 #include <llvm-c/TargetMachine.h>
 
 #ifdef PIPE_ARCH_BIG_ENDIAN
@@ -77,13 +79,26 @@
 #define SI_GET_TRACE_POINT_ID(x)	((x) & 0xffff)
 
 #define SI_MAX_VIEWPORTS	16
+#define SI_MAX_SCISSOR		16384
 #define SI_MAX_BORDER_COLORS	4096
 
 struct si_compute;
 
+#define SI_MAX_COMPILER_THREADS		4
+
 struct si_screen {
 	struct r600_common_screen	b;
 	unsigned			gs_table_depth;
+
+	/* Shader compiler queue for multithreaded compilation. */
+	struct util_queue		shader_compiler_queue;
+	/* One TargetMachine per compiler thread; LLVM doesn't allow sharing. */
+	LLVMTargetMachineRef		tm[SI_MAX_COMPILER_THREADS];
+
+	/* Compiled shader binaries, keyed by a hash of TGSI + shader key. */
+	pipe_mutex			shader_cache_mutex;
+	struct hash_table		*shader_cache;
+	struct disk_cache		*disk_shader_cache;
 };
 
 struct si_blend_color {
@@ -144,6 +159,9 @@ struct si_scissors {
 	struct r600_atom		atom;
 	unsigned			dirty_mask;
 	struct pipe_scissor_state	states[SI_MAX_VIEWPORTS];
+	/* The scissors that are emitted depend on these, too. */
+	bool				scissor_enable;
+	bool				vs_window_space;
 };
 
 struct si_viewports {
@@ -275,6 +293,8 @@ struct si_context {
 	/* Scratch buffer */
 	struct r600_resource	*scratch_buffer;
 	boolean                 emit_scratch_reloc;
+	/* A shader needing the current scratch size has been deleted. */
+	bool			scratch_buffer_shrink;
 	unsigned		scratch_waves;
 	unsigned		spi_tmpring_size;
 
@@ -351,6 +371,9 @@ void si_init_compute_functions(struct si_context *sctx);
 /* si_perfcounters.c */
 void si_init_perfcounters(struct si_screen *screen);
 
+/* si_pipe.c */
+LLVMTargetMachineRef si_create_llvm_target_machine(struct si_screen *sscreen);
+
 /* si_uvd.c */
 struct pipe_video_codec *si_uvd_create_decoder(struct pipe_context *context,
 					       const struct pipe_video_codec *templ);
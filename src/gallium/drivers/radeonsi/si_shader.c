@@ -3741,6 +3741,11 @@ static void preload_ring_buffers(struct si_shader_context *si_shader_ctx)
 	}
 }
 
+/* Not real registers: LLVM reports the number of spilled registers in
+ * the config section with these keys. */
+#define SPILLED_SGPRS	0x4
+#define SPILLED_VGPRS	0x8
+
 void si_shader_binary_read_config(const struct si_screen *sscreen,
 				struct si_shader *shader,
 				unsigned symbol_offset)
@@ -3783,6 +3788,12 @@ void si_shader_binary_read_config(const struct si_screen *sscreen,
 			shader->scratch_bytes_per_wave =
 				G_00B860_WAVESIZE(value) * 256 * 4 * 1;
 			break;
+		case SPILLED_SGPRS:
+			shader->num_spilled_sgprs = value;
+			break;
+		case SPILLED_VGPRS:
+			shader->num_spilled_vgprs = value;
+			break;
 		default:
 			fprintf(stderr, "Warning: Compiler emitted unknown "
 				"config register: 0x%x\n", reg);
@@ -3840,7 +3851,8 @@ int si_shader_binary_upload(struct si_screen *sscreen, struct si_shader *shader)
 	return 0;
 }
 
-int si_shader_binary_read(struct si_screen *sscreen, struct si_shader *shader)
+int si_shader_binary_read(struct si_screen *sscreen, struct si_shader *shader,
+			  struct pipe_debug_callback *debug)
 {
 	const struct radeon_shader_binary *binary = &shader->binary;
 	unsigned i;
@@ -3869,28 +3881,32 @@ int si_shader_binary_read(struct si_screen *sscreen, struct si_shader *shader)
 		}
 
 		fprintf(stderr, "*** SHADER STATS ***\n"
-			"SGPRS: %d\nVGPRS: %d\nCode Size: %d bytes\nLDS: %d blocks\n"
+			"SGPRS: %d\nVGPRS: %d\nSpilled SGPRs: %d\n"
+			"Spilled VGPRs: %d\nCode Size: %d bytes\nLDS: %d blocks\n"
 			"Scratch: %d bytes per wave\n********************\n",
-			shader->num_sgprs, shader->num_vgprs, binary->code_size,
-			shader->lds_size, shader->scratch_bytes_per_wave);
+			shader->num_sgprs, shader->num_vgprs,
+			shader->num_spilled_sgprs, shader->num_spilled_vgprs,
+			binary->code_size, shader->lds_size,
+			shader->scratch_bytes_per_wave);
 	}
+
+	pipe_debug_message(debug, SHADER_INFO,
+			   "Shader Stats: SGPRS: %d VGPRS: %d "
+			   "Spilled SGPRs: %d Spilled VGPRs: %d "
+			   "Code Size: %d LDS: %d Scratch: %d",
+			   shader->num_sgprs, shader->num_vgprs,
+			   shader->num_spilled_sgprs, shader->num_spilled_vgprs,
+			   binary->code_size, shader->lds_size,
+			   shader->scratch_bytes_per_wave);
 	return 0;
 }
 
-int si_compile_llvm(struct si_screen *sscreen, struct si_shader *shader,
-		    LLVMTargetMachineRef tm, LLVMModuleRef mod)
+/* Upload the binary and free the parts of it that are no longer needed. */
+static int si_shader_binary_finish(struct si_screen *sscreen,
+				   struct si_shader *shader,
+				   struct pipe_debug_callback *debug)
 {
-	int r = 0;
-	bool dump_asm = r600_can_dump_shader(&sscreen->b,
-				shader->selector ? shader->selector->tokens : NULL);
-	bool dump_ir = dump_asm && !(sscreen->b.debug_flags & DBG_NO_IR);
-
-	r = radeon_llvm_compile(mod, &shader->binary,
-		r600_get_llvm_processor_name(sscreen->b.family), dump_ir, dump_asm, tm);
-	if (r)
-		return r;
-
-	r = si_shader_binary_read(sscreen, shader);
+	int r = si_shader_binary_read(sscreen, shader, debug);
 
 	FREE(shader->binary.config);
 	FREE(shader->binary.rodata);
@@ -3904,10 +3920,29 @@ int si_compile_llvm(struct si_screen *sscreen, struct si_shader *shader,
 	return r;
 }
 
+int si_compile_llvm(struct si_screen *sscreen, struct si_shader *shader,
+		    LLVMTargetMachineRef tm, LLVMModuleRef mod,
+		    struct pipe_debug_callback *debug)
+{
+	int r = 0;
+	bool dump_asm = r600_can_dump_shader(&sscreen->b,
+				shader->selector ? shader->selector->tokens : NULL);
+	bool dump_ir = dump_asm && !(sscreen->b.debug_flags & DBG_NO_IR);
+
+	r = radeon_llvm_compile(mod, &shader->binary,
+		r600_get_llvm_processor_name(sscreen->b.family), dump_ir, dump_asm, tm);
+	if (r)
+		return r;
+
+	si_shader_cache_insert_shader(sscreen, shader);
+	return si_shader_binary_finish(sscreen, shader, debug);
+}
+
 /* Generate code for the hardware VS shader stage to go with a geometry shader */
 static int si_generate_gs_copy_shader(struct si_screen *sscreen,
 				      struct si_shader_context *si_shader_ctx,
-				      struct si_shader *gs, bool dump)
+				      struct si_shader *gs, bool dump,
+				      struct pipe_debug_callback *debug)
 {
 	struct gallivm_state *gallivm = &si_shader_ctx->radeon_bld.gallivm;
 	struct lp_build_tgsi_context *bld_base = &si_shader_ctx->radeon_bld.soa.bld_base;
@@ -3974,7 +4009,8 @@ static int si_generate_gs_copy_shader(struct si_screen *sscreen,
 		fprintf(stderr, "Copy Vertex Shader for Geometry Shader:\n\n");
 
 	r = si_compile_llvm(sscreen, si_shader_ctx->shader,
-			    si_shader_ctx->tm, bld_base->base.gallivm->module);
+			    si_shader_ctx->tm, bld_base->base.gallivm->module,
+			    debug);
 
 	radeon_llvm_dispose(&si_shader_ctx->radeon_bld);
 
@@ -4028,7 +4064,8 @@ void si_dump_shader_key(unsigned shader, union si_shader_key *key, FILE *f)
 }
 
 int si_shader_create(struct si_screen *sscreen, LLVMTargetMachineRef tm,
-		     struct si_shader *shader)
+		     struct si_shader *shader,
+		     struct pipe_debug_callback *debug)
 {
 	struct si_shader_selector *sel = shader->selector;
 	struct tgsi_token *tokens = sel->tokens;
@@ -4041,6 +4078,9 @@ int si_shader_create(struct si_screen *sscreen, LLVMTargetMachineRef tm,
 			    shader->key.ps.poly_stipple;
 	bool dump = r600_can_dump_shader(&sscreen->b, sel->tokens);
 
+	if (si_shader_cache_load_shader(sscreen, shader))
+		return si_shader_binary_finish(sscreen, shader, debug);
+
 	if (poly_stipple) {
 		tokens = util_pstipple_create_fragment_shader(tokens, NULL,
 						SI_POLY_STIPPLE_SAMPLER);
@@ -4182,7 +4222,7 @@ int si_shader_create(struct si_screen *sscreen, LLVMTargetMachineRef tm,
 	radeon_llvm_finalize_module(&si_shader_ctx.radeon_bld);
 
 	mod = bld_base->base.gallivm->module;
-	r = si_compile_llvm(sscreen, shader, tm, mod);
+	r = si_compile_llvm(sscreen, shader, tm, mod, debug);
 	if (r) {
 		fprintf(stderr, "LLVM failed to compile shader\n");
 		goto out;
@@ -4196,7 +4236,7 @@ int si_shader_create(struct si_screen *sscreen, LLVMTargetMachineRef tm,
 		shader->gs_copy_shader->key = shader->key;
 		si_shader_ctx.shader = shader->gs_copy_shader;
 		if ((r = si_generate_gs_copy_shader(sscreen, &si_shader_ctx,
-						    shader, dump))) {
+						    shader, dump, debug))) {
 			free(shader->gs_copy_shader);
 			shader->gs_copy_shader = NULL;
 			goto out;
@@ -71,6 +71,7 @@
 #include <llvm-c/Core.h> /* LLVMModuleRef */
 #include "tgsi/tgsi_scan.h"
 #include "si_state.h"
+#include "util/u_queue.h"
 
 struct radeon_shader_binary;
 struct radeon_shader_reloc;
@@ -178,43 +179,6 @@ struct radeon_shader_reloc;
 
 struct si_shader;
 
-/* A shader selector is a gallium CSO and contains shader variants and
- * binaries for one TGSI program. This can be shared by multiple contexts.
- */
-struct si_shader_selector {
-	pipe_mutex		mutex;
-	struct si_shader	*first_variant; /* immutable after the first variant */
-	struct si_shader	*last_variant; /* mutable */
-
-	struct tgsi_token       *tokens;
-	struct pipe_stream_output_info  so;
-	struct tgsi_shader_info		info;
-
-	/* PIPE_SHADER_[VERTEX|FRAGMENT|...] */
-	unsigned	type;
-
-	/* Whether the shader has to use a conditional assignment to
-	 * choose between weights when emulating
-	 * pipe_rasterizer_state::force_persample_interp.
-	 * If false, "si_emit_spi_ps_input" will take care of it instead.
-	 */
-	bool		forces_persample_interp_for_persp;
-	bool		forces_persample_interp_for_linear;
-
-	unsigned	esgs_itemsize;
-	unsigned	gs_input_verts_per_prim;
-	unsigned	gs_output_prim;
-	unsigned	gs_max_out_vertices;
-	unsigned	gs_num_invocations;
-	unsigned	max_gs_stream; /* count - 1 */
-	unsigned	gsvs_vertex_size;
-	unsigned	max_gsvs_emit_size;
-
-	/* masks of "get_unique_index" bits */
-	uint64_t	outputs_written;
-	uint32_t	patch_outputs_written;
-};
-
 /* Valid shader configurations:
  *
  * API shaders       VS | TCS | TES | GS |pass| PS
@@ -258,6 +222,54 @@ union si_shader_key {
 	} tes; /* tessellation evaluation shader */
 };
 
+/* A shader selector is a gallium CSO and contains shader variants and
+ * binaries for one TGSI program. This can be shared by multiple contexts.
+ */
+struct si_shader_selector {
+	struct si_screen	*screen;
+	struct util_queue_fence ready;
+
+	pipe_mutex		mutex;
+	struct si_shader	*first_variant; /* immutable after the first variant */
+	struct si_shader	*last_variant; /* mutable */
+
+	/* The key the main variant is (being) compiled with when the
+	 * selector is created. */
+	union si_shader_key	main_key;
+
+	struct tgsi_token       *tokens;
+	struct pipe_stream_output_info  so;
+	struct tgsi_shader_info		info;
+
+	/* PIPE_SHADER_[VERTEX|FRAGMENT|...] */
+	unsigned	type;
+
+	/* Whether the shader has to use a conditional assignment to
+	 * choose between weights when emulating
+	 * pipe_rasterizer_state::force_persample_interp.
+	 * If false, "si_emit_spi_ps_input" will take care of it instead.
+	 */
+	bool		forces_persample_interp_for_persp;
+	bool		forces_persample_interp_for_linear;
+
+	/* PS: whether any COLOR input is read, which is what two-sided
+	 * lighting changes. */
+	bool		ps_reads_color;
+
+	unsigned	esgs_itemsize;
+	unsigned	gs_input_verts_per_prim;
+	unsigned	gs_output_prim;
+	unsigned	gs_max_out_vertices;
+	unsigned	gs_num_invocations;
+	unsigned	max_gs_stream; /* count - 1 */
+	unsigned	gsvs_vertex_size;
+	unsigned	max_gsvs_emit_size;
+
+	/* masks of "get_unique_index" bits */
+	uint64_t	outputs_written;
+	uint32_t	patch_outputs_written;
+};
+
 struct si_shader {
 	struct si_shader_selector	*selector;
 	struct si_shader		*next_variant;
@@ -269,6 +281,8 @@ struct si_shader {
 	struct radeon_shader_binary	binary;
 	unsigned			num_sgprs;
 	unsigned			num_vgprs;
+	unsigned			num_spilled_sgprs;
+	unsigned			num_spilled_vgprs;
 	unsigned			lds_size;
 	unsigned			spi_ps_input_ena;
 	unsigned			float_mode;
@@ -327,14 +341,17 @@ static inline bool si_vs_exports_prim_id(struct si_shader *shader)
 
 /* radeonsi_shader.c */
 int si_shader_create(struct si_screen *sscreen, LLVMTargetMachineRef tm,
-		     struct si_shader *shader);
+		     struct si_shader *shader,
+		     struct pipe_debug_callback *debug);
 void si_dump_shader_key(unsigned shader, union si_shader_key *key, FILE *f);
 int si_compile_llvm(struct si_screen *sscreen, struct si_shader *shader,
-		    LLVMTargetMachineRef tm, LLVMModuleRef mod);
+		    LLVMTargetMachineRef tm, LLVMModuleRef mod,
+		    struct pipe_debug_callback *debug);
 void si_shader_destroy(struct si_shader *shader);
 unsigned si_shader_io_get_unique_index(unsigned semantic_name, unsigned index);
 int si_shader_binary_upload(struct si_screen *sscreen, struct si_shader *shader);
-int si_shader_binary_read(struct si_screen *sscreen, struct si_shader *shader);
+int si_shader_binary_read(struct si_screen *sscreen, struct si_shader *shader,
+			  struct pipe_debug_callback *debug);
 void si_shader_apply_scratch_relocs(struct si_context *sctx,
 			struct si_shader *shader,
 			uint64_t scratch_va);
@@ -626,22 +626,119 @@ static void si_set_scissor_states(struct pipe_context *ctx,
 	si_mark_atom_dirty(sctx, &sctx->scissors.atom);
 }
 
+/* The hw scissor is always enabled. Compute the scissor for viewport i as
+ * the viewport rectangle, intersected with the user scissor if that is
+ * enabled. This keeps pixels outside the viewport from being drawn when
+ * the guard band lets primitives through the clipper unclipped.
+ */
+static void si_get_scissor(struct si_context *sctx, unsigned i,
+			   struct pipe_scissor_state *scissor)
+{
+	struct pipe_viewport_state *vp = &sctx->viewports.states[i];
+	float minx, miny, maxx, maxy;
+
+	scissor->minx = 0;
+	scissor->miny = 0;
+	scissor->maxx = SI_MAX_SCISSOR;
+	scissor->maxy = SI_MAX_SCISSOR;
+
+	/* Window-space positions bypass the viewport transformation, and
+	 * r600_draw_rectangle sets an identity viewport. Only apply the user
+	 * scissor for them. */
+	if (!sctx->scissors.vs_window_space &&
+	    !(vp->scale[0] == 1 && vp->scale[1] == 1 &&
+	      vp->translate[0] == 0 && vp->translate[1] == 0)) {
+		/* Convert (-1, -1) and (1, 1) from clip space into window
+		 * space. Inverted viewports have a negative scale. */
+		minx = vp->translate[0] - fabsf(vp->scale[0]);
+		miny = vp->translate[1] - fabsf(vp->scale[1]);
+		maxx = vp->translate[0] + fabsf(vp->scale[0]);
+		maxy = vp->translate[1] + fabsf(vp->scale[1]);
+
+		scissor->minx = CLAMP(minx, 0, SI_MAX_SCISSOR);
+		scissor->miny = CLAMP(miny, 0, SI_MAX_SCISSOR);
+		scissor->maxx = CLAMP(ceilf(maxx), 0, SI_MAX_SCISSOR);
+		scissor->maxy = CLAMP(ceilf(maxy), 0, SI_MAX_SCISSOR);
+	}
+
+	if (sctx->scissors.scissor_enable) {
+		struct pipe_scissor_state *state = &sctx->scissors.states[i];
+
+		scissor->minx = MAX2(scissor->minx, state->minx);
+		scissor->miny = MAX2(scissor->miny, state->miny);
+		scissor->maxx = MIN2(scissor->maxx, state->maxx);
+		scissor->maxy = MIN2(scissor->maxy, state->maxy);
+	}
+}
+
+static void si_emit_one_scissor(struct radeon_winsys_cs *cs,
+				struct pipe_scissor_state *scissor)
+{
+	radeon_emit(cs, S_028250_TL_X(scissor->minx) |
+			S_028250_TL_Y(scissor->miny) |
+			S_028250_WINDOW_OFFSET_DISABLE(1));
+	radeon_emit(cs, S_028254_BR_X(scissor->maxx) |
+			S_028254_BR_Y(scissor->maxy));
+}
+
+/* Return how far from (0,0) primitives can extend in clip space before
+ * they have to be clipped, i.e. the largest symmetric range that the
+ * viewport transformation maps into the supported window coordinates.
+ */
+static void si_get_guardband(struct pipe_viewport_state *vp,
+			     float *guardband_x, float *guardband_y)
+{
+	/* Use a limit one pixel smaller to allow for some precision error. */
+	const float max_range = 32767 - 1;
+	float scale_x = MAX2(fabsf(vp->scale[0]), 0.5);
+	float scale_y = MAX2(fabsf(vp->scale[1]), 0.5);
+
+	*guardband_x = (max_range - fabsf(vp->translate[0])) / scale_x;
+	*guardband_y = (max_range - fabsf(vp->translate[1])) / scale_y;
+}
+
+static void si_emit_guardband(struct si_context *sctx, unsigned num_viewports)
+{
+	struct radeon_winsys_cs *cs = sctx->b.gfx.cs;
+	float guardband_x = FLT_MAX, guardband_y = FLT_MAX;
+	unsigned i;
+
+	for (i = 0; i < num_viewports; i++) {
+		float x, y;
+
+		si_get_guardband(&sctx->viewports.states[i], &x, &y);
+		guardband_x = MIN2(guardband_x, x);
+		guardband_y = MIN2(guardband_y, y);
+	}
+
+	/* The viewport itself may exceed the supported range. */
+	guardband_x = MAX2(guardband_x, 1.0);
+	guardband_y = MAX2(guardband_y, 1.0);
+
+	/* Primitives completely outside the viewport are still discarded.
+	 * If any of the GB registers is updated, all of them must be. */
+	radeon_set_context_reg_seq(cs, R_028BE8_PA_CL_GB_VERT_CLIP_ADJ, 4);
+	radeon_emit(cs, fui(guardband_y)); /* R_028BE8_PA_CL_GB_VERT_CLIP_ADJ */
+	radeon_emit(cs, fui(1.0));         /* R_028BEC_PA_CL_GB_VERT_DISC_ADJ */
+	radeon_emit(cs, fui(guardband_x)); /* R_028BF0_PA_CL_GB_HORZ_CLIP_ADJ */
+	radeon_emit(cs, fui(1.0));         /* R_028BF4_PA_CL_GB_HORZ_DISC_ADJ */
+}
+
 static void si_emit_scissors(struct si_context *sctx, struct r600_atom *atom)
 {
 	struct radeon_winsys_cs *cs = sctx->b.gfx.cs;
-	struct pipe_scissor_state *states = sctx->scissors.states;
+	struct pipe_scissor_state scissor;
 	unsigned mask = sctx->scissors.dirty_mask;
 
 	/* The simple case: Only 1 viewport is active. */
-	if (mask & 1 &&
-	    !si_get_vs_info(sctx)->writes_viewport_index) {
-		radeon_set_context_reg_seq(cs, R_028250_PA_SC_VPORT_SCISSOR_0_TL, 2);
-		radeon_emit(cs, S_028250_TL_X(states[0].minx) |
-				S_028250_TL_Y(states[0].miny) |
-				S_028250_WINDOW_OFFSET_DISABLE(1));
-		radeon_emit(cs, S_028254_BR_X(states[0].maxx) |
-				S_028254_BR_Y(states[0].maxy));
-		sctx->scissors.dirty_mask &= ~1; /* clear one bit */
+	if (!si_get_vs_info(sctx)->writes_viewport_index) {
+		if (mask & 1) {
+			si_get_scissor(sctx, 0, &scissor);
+			radeon_set_context_reg_seq(cs, R_028250_PA_SC_VPORT_SCISSOR_0_TL, 2);
+			si_emit_one_scissor(cs, &scissor);
+			sctx->scissors.dirty_mask &= ~1; /* clear one bit */
+		}
+		si_emit_guardband(sctx, 1);
 		return;
 	}
 
@@ -653,14 +750,12 @@ static void si_emit_scissors(struct si_context *sctx, struct r600_atom *atom)
 		radeon_set_context_reg_seq(cs, R_028250_PA_SC_VPORT_SCISSOR_0_TL +
 					       start * 4 * 2, count * 2);
 		for (i = start; i < start+count; i++) {
-			radeon_emit(cs, S_028250_TL_X(states[i].minx) |
-					S_028250_TL_Y(states[i].miny) |
-					S_028250_WINDOW_OFFSET_DISABLE(1));
-			radeon_emit(cs, S_028254_BR_X(states[i].maxx) |
-					S_028254_BR_Y(states[i].maxy));
+			si_get_scissor(sctx, i, &scissor);
+			si_emit_one_scissor(cs, &scissor);
 		}
 	}
 	sctx->scissors.dirty_mask = 0;
+	si_emit_guardband(sctx, SI_MAX_VIEWPORTS);
 }
 
 static void si_set_viewport_states(struct pipe_context *ctx,
@@ -676,6 +771,10 @@ static void si_set_viewport_states(struct pipe_context *ctx,
 
 	sctx->viewports.dirty_mask |= ((1 << num_viewports) - 1) << start_slot;
 	si_mark_atom_dirty(sctx, &sctx->viewports.atom);
+
+	/* The scissors and the guard band are derived from the viewports. */
+	sctx->scissors.dirty_mask |= ((1 << num_viewports) - 1) << start_slot;
+	si_mark_atom_dirty(sctx, &sctx->scissors.atom);
 }
 
 static void si_emit_viewports(struct si_context *sctx, struct r600_atom *atom)
@@ -786,6 +885,7 @@ static void *si_create_rs_state(struct pipe_context *ctx,
 	rs->flatshade = state->flatshade;
 	rs->sprite_coord_enable = state->sprite_coord_enable;
 	rs->rasterizer_discard = state->rasterizer_discard;
+	rs->scissor_enable = state->scissor;
 	rs->pa_sc_line_stipple = state->line_stipple_enable ?
 				S_028A0C_LINE_PATTERN(state->line_stipple_pattern) |
 				S_028A0C_REPEAT_COUNT(state->line_stipple_factor) : 0;
@@ -830,7 +930,7 @@ static void *si_create_rs_state(struct pipe_context *ctx,
 		       S_028A48_MSAA_ENABLE(state->multisample ||
 					    state->poly_smooth ||
 					    state->line_smooth) |
-		       S_028A48_VPORT_SCISSOR_ENABLE(state->scissor));
+		       S_028A48_VPORT_SCISSOR_ENABLE(1));
 
 	si_pm4_set_reg(pm4, R_028BE4_PA_SU_VTX_CNTL,
 		       S_028BE4_PIX_CENTER(state->half_pixel_center) |
@@ -897,6 +997,12 @@ static void si_bind_rs_state(struct pipe_context *ctx, void *state)
 	    (!old_rs || old_rs->multisample_enable != rs->multisample_enable))
 		si_mark_atom_dirty(sctx, &sctx->db_render_state);
 
+	if (rs->scissor_enable != sctx->scissors.scissor_enable) {
+		sctx->scissors.scissor_enable = rs->scissor_enable;
+		sctx->scissors.dirty_mask = (1 << SI_MAX_VIEWPORTS) - 1;
+		si_mark_atom_dirty(sctx, &sctx->scissors.atom);
+	}
+
 	si_pm4_bind_state(sctx, rasterizer, rs);
 	si_update_poly_offset_state(sctx);
 
@@ -3580,10 +3686,6 @@ static void si_init_config(struct si_context *sctx)
 	/* PA_SU_HARDWARE_SCREEN_OFFSET must be 0 due to hw bug on SI */
 	si_pm4_set_reg(pm4, R_028234_PA_SU_HARDWARE_SCREEN_OFFSET, 0);
 	si_pm4_set_reg(pm4, R_028820_PA_CL_NANINF_CNTL, 0);
-	si_pm4_set_reg(pm4, R_028BE8_PA_CL_GB_VERT_CLIP_ADJ, fui(1.0));
-	si_pm4_set_reg(pm4, R_028BEC_PA_CL_GB_VERT_DISC_ADJ, fui(1.0));
-	si_pm4_set_reg(pm4, R_028BF0_PA_CL_GB_HORZ_CLIP_ADJ, fui(1.0));
-	si_pm4_set_reg(pm4, R_028BF4_PA_CL_GB_HORZ_DISC_ADJ, fui(1.0));
 	si_pm4_set_reg(pm4, R_028AC0_DB_SRESULTS_COMPARE_STATE0, 0x0);
 	si_pm4_set_reg(pm4, R_028AC4_DB_SRESULTS_COMPARE_STATE1, 0x0);
 	si_pm4_set_reg(pm4, R_028AC8_DB_PRELOAD_CONTROL, 0x0);
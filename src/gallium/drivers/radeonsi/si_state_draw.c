@@ -882,6 +882,9 @@ void si_draw_vbo(struct pipe_context *ctx, const struct pipe_draw_info *info)
 	if (sctx->trace_buf)
 		si_trace_emit(sctx);
 
+	if (sctx->b.num_draw_sampled_queries)
+		r600_query_hw_sample_draw(&sctx->b);
+
 	/* Workaround for a VGT hang when streamout is enabled.
 	 * It must be done after drawing. */
 	if ((sctx->b.family == CHIP_HAWAII ||
@@ -29,12 +29,16 @@
 #include "si_shader.h"
 #include "sid.h"
 #include "radeon/r600_cs.h"
+#include "radeon/radeon_elf_util.h"
 
 #include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_ureg.h"
 #include "util/u_memory.h"
 #include "util/u_prim.h"
 #include "util/u_simple_shaders.h"
+#include "util/disk_cache.h"
+#include "util/hash_table.h"
+#include "util/mesa-sha1.h"
 
 static void si_set_tesseval_regs(struct si_shader *shader,
 				 struct si_pm4_state *pm4)
@@ -496,6 +500,355 @@ static void si_shader_init_pm4_state(struct si_shader *shader)
 	}
 }
 
+/* SHADER CACHE
+ *
+ * Compiled variants are stored in memory and, when the on-disk cache is
+ * enabled, on disk. The cache key is a SHA-1 of the TGSI tokens, the
+ * shader key and everything else that affects code generation, so any
+ * (tokens, key) pair seen before skips LLVM entirely.
+ *
+ * The on-disk cache isn't thread-safe, so it's also accessed under
+ * shader_cache_mutex.
+ */
+
+static uint32_t si_shader_cache_key_hash(const void *key)
+{
+	/* The key is a SHA-1, so any 4 bytes of it are a good hash. */
+	return *(const uint32_t *)key;
+}
+
+static bool si_shader_cache_key_equals(const void *a, const void *b)
+{
+	return memcmp(a, b, CACHE_KEY_SIZE) == 0;
+}
+
+static bool si_shader_cache_allowed(struct si_screen *sscreen,
+				    struct si_shader *shader)
+{
+	struct si_shader_selector *sel = shader->selector;
+
+	/* Compute kernels have no selector. Geometry shaders would also
+	 * need their copy shader cached, so they are always compiled.
+	 * Shaders that are being dumped are compiled to get the dumps.
+	 */
+	return sscreen->shader_cache &&
+	       sel && sel->type != PIPE_SHADER_GEOMETRY &&
+	       !shader->is_gs_copy_shader &&
+	       !r600_can_dump_shader(&sscreen->b, sel->tokens);
+}
+
+/* Return false if the key can't be computed, e.g. without SHA-1 support. */
+static bool si_shader_cache_compute_key(struct si_screen *sscreen,
+					struct si_shader *shader,
+					cache_key key)
+{
+#if defined(HAVE_SHA1)
+	struct si_shader_selector *sel = shader->selector;
+	struct mesa_sha1 *ctx = _mesa_sha1_init();
+	static const char build_id[] = PACKAGE_VERSION;
+	unsigned llvm_version = HAVE_LLVM;
+
+	if (!ctx)
+		return false;
+
+	_mesa_sha1_update(ctx, build_id, sizeof(build_id));
+	_mesa_sha1_update(ctx, &llvm_version, sizeof(llvm_version));
+	_mesa_sha1_update(ctx, &sscreen->b.family, sizeof(sscreen->b.family));
+	_mesa_sha1_update(ctx, sel->tokens,
+			  tgsi_num_tokens(sel->tokens) * sizeof(struct tgsi_token));
+	_mesa_sha1_update(ctx, &sel->so, sizeof(sel->so));
+	_mesa_sha1_update(ctx, &shader->key, sizeof(shader->key));
+	return _mesa_sha1_final(ctx, key);
+#else
+	return false;
+#endif
+}
+
+/* The parts of si_shader that are filled in while translating TGSI. */
+#define SI_SHADER_STATE1_BEGIN	offsetof(struct si_shader, spi_shader_col_format)
+#define SI_SHADER_STATE1_END	offsetof(struct si_shader, key)
+#define SI_SHADER_STATE2_BEGIN	offsetof(struct si_shader, nparam)
+#define SI_SHADER_STATE2_END	sizeof(struct si_shader)
+
+struct si_shader_cache_header {
+	uint32_t	size; /* of the whole blob */
+	uint32_t	code_size;
+	uint32_t	config_size;
+	uint32_t	config_size_per_symbol;
+	uint32_t	rodata_size;
+	uint32_t	global_symbol_count;
+	uint32_t	reloc_count;
+};
+
+static void *write_chunk(void *ptr, const void *data, size_t size)
+{
+	if (size)
+		memcpy(ptr, data, size);
+	return (char *)ptr + size;
+}
+
+static const void *read_chunk(const void *ptr, const void *end,
+			      void *data, size_t size)
+{
+	if (!ptr || (const char *)end - (const char *)ptr < size)
+		return NULL;
+	if (size)
+		memcpy(data, ptr, size);
+	return (const char *)ptr + size;
+}
+
+/* Serialize the compiled binary and the state derived from TGSI. */
+static void *si_shader_cache_serialize(struct si_shader *shader, size_t *out_size)
+{
+	const struct radeon_shader_binary *binary = &shader->binary;
+	struct si_shader_cache_header hdr;
+	size_t size;
+	unsigned i;
+	void *blob, *ptr;
+
+	hdr.code_size = binary->code_size;
+	hdr.config_size = binary->config_size;
+	hdr.config_size_per_symbol = binary->config_size_per_symbol;
+	hdr.rodata_size = binary->rodata_size;
+	hdr.global_symbol_count = binary->global_symbol_count;
+	hdr.reloc_count = binary->reloc_count;
+
+	size = sizeof(hdr) +
+	       SI_SHADER_STATE1_END - SI_SHADER_STATE1_BEGIN +
+	       SI_SHADER_STATE2_END - SI_SHADER_STATE2_BEGIN +
+	       hdr.code_size + hdr.config_size + hdr.rodata_size +
+	       hdr.global_symbol_count * sizeof(uint64_t);
+	for (i = 0; i < binary->reloc_count; i++)
+		size += sizeof(uint64_t) + sizeof(uint32_t) +
+			strlen(binary->relocs[i].name);
+	hdr.size = size;
+
+	blob = malloc(size);
+	if (!blob)
+		return NULL;
+
+	ptr = write_chunk(blob, &hdr, sizeof(hdr));
+	ptr = write_chunk(ptr, (char *)shader + SI_SHADER_STATE1_BEGIN,
+			  SI_SHADER_STATE1_END - SI_SHADER_STATE1_BEGIN);
+	ptr = write_chunk(ptr, (char *)shader + SI_SHADER_STATE2_BEGIN,
+			  SI_SHADER_STATE2_END - SI_SHADER_STATE2_BEGIN);
+	ptr = write_chunk(ptr, binary->code, hdr.code_size);
+	ptr = write_chunk(ptr, binary->config, hdr.config_size);
+	ptr = write_chunk(ptr, binary->rodata, hdr.rodata_size);
+	ptr = write_chunk(ptr, binary->global_symbol_offsets,
+			  hdr.global_symbol_count * sizeof(uint64_t));
+	for (i = 0; i < binary->reloc_count; i++) {
+		uint64_t offset = binary->relocs[i].offset;
+		uint32_t name_len = strlen(binary->relocs[i].name);
+
+		ptr = write_chunk(ptr, &offset, sizeof(offset));
+		ptr = write_chunk(ptr, &name_len, sizeof(name_len));
+		ptr = write_chunk(ptr, binary->relocs[i].name, name_len);
+	}
+	assert((char *)ptr - (char *)blob == size);
+
+	*out_size = size;
+	return blob;
+}
+
+static const void *read_alloc_chunk(const void *ptr, const void *end,
+				    void **data, size_t size)
+{
+	if (!size)
+		return ptr;
+
+	*data = MALLOC(size);
+	if (!*data)
+		return NULL;
+	return read_chunk(ptr, end, *data, size);
+}
+
+static bool si_shader_cache_deserialize(struct si_shader *shader,
+					const void *blob, size_t size)
+{
+	struct radeon_shader_binary *binary = &shader->binary;
+	struct si_shader_cache_header hdr;
+	const void *end = (const char *)blob + size;
+	const void *ptr;
+	unsigned i;
+
+	ptr = read_chunk(blob, end, &hdr, sizeof(hdr));
+	if (!ptr || hdr.size != size)
+		return false;
+
+	ptr = read_chunk(ptr, end, (char *)shader + SI_SHADER_STATE1_BEGIN,
+			 SI_SHADER_STATE1_END - SI_SHADER_STATE1_BEGIN);
+	ptr = read_chunk(ptr, end, (char *)shader + SI_SHADER_STATE2_BEGIN,
+			 SI_SHADER_STATE2_END - SI_SHADER_STATE2_BEGIN);
+
+	binary->code_size = hdr.code_size;
+	binary->config_size = hdr.config_size;
+	binary->config_size_per_symbol = hdr.config_size_per_symbol;
+	binary->rodata_size = hdr.rodata_size;
+	binary->global_symbol_count = hdr.global_symbol_count;
+	ptr = read_alloc_chunk(ptr, end, (void **)&binary->code,
+			       hdr.code_size);
+	ptr = read_alloc_chunk(ptr, end, (void **)&binary->config,
+			       hdr.config_size);
+	ptr = read_alloc_chunk(ptr, end, (void **)&binary->rodata,
+			       hdr.rodata_size);
+	ptr = read_alloc_chunk(ptr, end, (void **)&binary->global_symbol_offsets,
+			       hdr.global_symbol_count * sizeof(uint64_t));
+
+	if (ptr && hdr.reloc_count) {
+		binary->relocs = CALLOC(hdr.reloc_count,
+					sizeof(struct radeon_shader_reloc));
+		if (!binary->relocs)
+			ptr = NULL;
+	}
+
+	for (i = 0; ptr && i < hdr.reloc_count; i++) {
+		struct radeon_shader_reloc *reloc = &binary->relocs[i];
+		uint32_t name_len;
+
+		binary->reloc_count = i + 1;
+		ptr = read_chunk(ptr, end, &reloc->offset, sizeof(reloc->offset));
+		ptr = read_chunk(ptr, end, &name_len, sizeof(name_len));
+		if (!ptr)
+			break;
+
+		reloc->name = MALLOC(name_len + 1);
+		if (!reloc->name) {
+			ptr = NULL;
+			break;
+		}
+		ptr = read_chunk(ptr, end, reloc->name, name_len);
+		reloc->name[name_len] = 0;
+	}
+
+	if (!ptr || ptr != end) {
+		FREE(binary->code);
+		FREE(binary->config);
+		FREE(binary->rodata);
+		FREE(binary->global_symbol_offsets);
+		if (binary->relocs)
+			radeon_shader_binary_free_relocs(binary->relocs,
+							 binary->reloc_count);
+		memset(binary, 0, sizeof(*binary));
+		return false;
+	}
+	return true;
+}
+
+/* Add a serialized shader to the in-memory cache, which takes ownership
+ * of the blob. The cache mutex must be held.
+ */
+static void si_shader_cache_insert_blob(struct si_screen *sscreen,
+					const cache_key key, void *blob)
+{
+	uint8_t *key_copy;
+
+	if (_mesa_hash_table_search(sscreen->shader_cache, key)) {
+		free(blob);
+		return;
+	}
+
+	key_copy = malloc(CACHE_KEY_SIZE);
+	if (!key_copy) {
+		free(blob);
+		return;
+	}
+
+	memcpy(key_copy, key, CACHE_KEY_SIZE);
+	_mesa_hash_table_insert(sscreen->shader_cache, key_copy, blob);
+}
+
+/* Add the freshly compiled binary of the shader to the cache. */
+void si_shader_cache_insert_shader(struct si_screen *sscreen,
+				   struct si_shader *shader)
+{
+	cache_key key;
+	void *blob;
+	size_t size;
+
+	if (!si_shader_cache_allowed(sscreen, shader) ||
+	    !si_shader_cache_compute_key(sscreen, shader, key))
+		return;
+
+	blob = si_shader_cache_serialize(shader, &size);
+	if (!blob)
+		return;
+
+	pipe_mutex_lock(sscreen->shader_cache_mutex);
+	if (sscreen->disk_shader_cache)
+		disk_cache_put(sscreen->disk_shader_cache, key, blob, size);
+	si_shader_cache_insert_blob(sscreen, key, blob);
+	pipe_mutex_unlock(sscreen->shader_cache_mutex);
+}
+
+/* Fill in the shader from the cache. Return false on a cache miss. */
+bool si_shader_cache_load_shader(struct si_screen *sscreen,
+				 struct si_shader *shader)
+{
+	struct hash_entry *entry;
+	cache_key key;
+	void *blob;
+	size_t size;
+	bool found = false;
+
+	if (!si_shader_cache_allowed(sscreen, shader) ||
+	    !si_shader_cache_compute_key(sscreen, shader, key))
+		return false;
+
+	pipe_mutex_lock(sscreen->shader_cache_mutex);
+	entry = _mesa_hash_table_search(sscreen->shader_cache, key);
+	if (entry) {
+		blob = entry->data;
+		size = ((struct si_shader_cache_header *)blob)->size;
+		found = si_shader_cache_deserialize(shader, blob, size);
+	} else if (sscreen->disk_shader_cache) {
+		blob = disk_cache_get(sscreen->disk_shader_cache, key, &size);
+		if (blob) {
+			found = si_shader_cache_deserialize(shader, blob, size);
+			if (found) {
+				/* Keep it in memory for the next lookup. */
+				si_shader_cache_insert_blob(sscreen, key, blob);
+			} else {
+				/* Corrupted or truncated entry. */
+				disk_cache_remove(sscreen->disk_shader_cache, key);
+				free(blob);
+			}
+		}
+	}
+	pipe_mutex_unlock(sscreen->shader_cache_mutex);
+	return found;
+}
+
+bool si_init_shader_cache(struct si_screen *sscreen)
+{
+	pipe_mutex_init(sscreen->shader_cache_mutex);
+	sscreen->shader_cache =
+		_mesa_hash_table_create(NULL, si_shader_cache_key_hash,
+					si_shader_cache_key_equals);
+	if (!sscreen->shader_cache)
+		return false;
+
+	/* This is NULL if the on-disk cache is disabled. */
+	sscreen->disk_shader_cache = disk_cache_create();
+	return true;
+}
+
+static void si_destroy_shader_cache_entry(struct hash_entry *entry)
+{
+	free((void *)entry->key);
+	free(entry->data);
+}
+
+void si_destroy_shader_cache(struct si_screen *sscreen)
+{
+	if (sscreen->shader_cache)
+		_mesa_hash_table_destroy(sscreen->shader_cache,
+					 si_destroy_shader_cache_entry);
+	if (sscreen->disk_shader_cache)
+		disk_cache_destroy(sscreen->disk_shader_cache);
+	pipe_mutex_destroy(sscreen->shader_cache_mutex);
+}
+
 /* Compute the key for the hw shader variant */
 static inline void si_shader_selector_key(struct pipe_context *ctx,
 					  struct si_shader_selector *sel,
@@ -508,8 +861,10 @@ static inline void si_shader_selector_key(struct pipe_context *ctx,
 
 	switch (sel->type) {
 	case PIPE_SHADER_VERTEX:
+		/* Vertex elements that the shader doesn't read don't matter. */
 		if (sctx->vertex_elements)
-			for (i = 0; i < sctx->vertex_elements->count; ++i)
+			for (i = 0; i < MIN2(sctx->vertex_elements->count,
+					     sel->info.num_inputs); ++i)
 				key->vs.instance_divisors[i] =
 					sctx->vertex_elements->elements[i].instance_divisor;
 
@@ -523,8 +878,10 @@ static inline void si_shader_selector_key(struct pipe_context *ctx,
 			key->vs.export_prim_id = 1;
 		break;
 	case PIPE_SHADER_TESS_CTRL:
-		key->tcs.prim_mode =
-			sctx->tes_shader.cso->info.properties[TGSI_PROPERTY_TES_PRIM_MODE];
+		/* TES may not be bound yet when the selector is created. */
+		if (sctx->tes_shader.cso)
+			key->tcs.prim_mode =
+				sctx->tes_shader.cso->info.properties[TGSI_PROPERTY_TES_PRIM_MODE];
 		break;
 	case PIPE_SHADER_TESS_EVAL:
 		if (sctx->gs_shader.cso)
@@ -567,6 +924,24 @@ static inline void si_shader_selector_key(struct pipe_context *ctx,
 		if (sctx->queued.named.dsa &&
 		    !sctx->framebuffer.cb0_is_integer)
 			key->ps.alpha_func = sctx->queued.named.dsa->alpha_func;
+
+		/* Clear the state that this shader doesn't depend on, so that
+		 * changing it doesn't compile a new variant. */
+		if (!sel->ps_reads_color)
+			key->ps.color_two_side = 0;
+
+		if (sel->info.properties[TGSI_PROPERTY_FS_COLOR0_WRITES_ALL_CBUFS] &&
+		    sel->info.colors_written & 0x1)
+			key->ps.export_16bpc &= (1 << (key->ps.last_cbuf + 1)) - 1;
+		else
+			key->ps.export_16bpc &= sel->info.colors_written;
+
+		if (!(sel->info.colors_written & 0x1))
+			key->ps.alpha_func = PIPE_FUNC_ALWAYS;
+		if (!sel->info.colors_written) {
+			key->ps.alpha_to_one = 0;
+			key->ps.clamp_color = 0;
+		}
 		break;
 	}
 	default:
@@ -594,6 +969,9 @@ static int si_shader_select(struct pipe_context *ctx,
 	if (likely(current && memcmp(&current->key, &key, sizeof(key)) == 0))
 		return 0;
 
+	/* The main variant may still be compiling on a compiler thread. */
+	util_queue_job_wait(&sel->ready);
+
 	pipe_mutex_lock(sel->mutex);
 
 	/* Find the shader variant. */
@@ -616,7 +994,7 @@ static int si_shader_select(struct pipe_context *ctx,
 	shader->selector = sel;
 	shader->key = key;
 
-	r = si_shader_create(sctx->screen, sctx->tm, shader);
+	r = si_shader_create(sctx->screen, sctx->tm, shader, &sctx->b.debug);
 	if (unlikely(r)) {
 		R600_ERR("Failed to build shader variant (type=%u) %d\n",
 			 sel->type, r);
@@ -639,9 +1017,53 @@ static int si_shader_select(struct pipe_context *ctx,
 	return 0;
 }
 
+/* Compile the variant for sel->main_key and add it to the selector.
+ * This is the job executed by the shader compiler queue.
+ */
+static void si_init_shader_selector_async(void *job, int thread_index)
+{
+	struct si_shader_selector *sel = (struct si_shader_selector *)job;
+	struct si_screen *sscreen = sel->screen;
+	struct si_shader *shader;
+	int r;
+
+	assert(thread_index >= 0 && thread_index < ARRAY_SIZE(sscreen->tm));
+
+	shader = CALLOC_STRUCT(si_shader);
+	if (!shader)
+		return;
+
+	shader->selector = sel;
+	shader->key = sel->main_key;
+
+	/* The debug callback isn't thread-safe, so stats aren't reported
+	 * from here. si_create_shader_selector doesn't use the queue when
+	 * a callback is set. */
+	r = si_shader_create(sscreen, sscreen->tm[thread_index], shader, NULL);
+	if (unlikely(r)) {
+		R600_ERR("Failed to build shader variant (type=%u) %d\n",
+			 sel->type, r);
+		FREE(shader);
+		return;
+	}
+	si_shader_init_pm4_state(shader);
+
+	pipe_mutex_lock(sel->mutex);
+	if (!sel->last_variant) {
+		sel->first_variant = shader;
+		sel->last_variant = shader;
+	} else {
+		sel->last_variant->next_variant = shader;
+		sel->last_variant = shader;
+	}
+	pipe_mutex_unlock(sel->mutex);
+	p_atomic_inc(&sscreen->b.num_compilations);
+}
+
 static void *si_create_shader_selector(struct pipe_context *ctx,
 				       const struct pipe_shader_state *state)
 {
+	struct si_context *sctx = (struct si_context *)ctx;
 	struct si_screen *sscreen = (struct si_screen *)ctx->screen;
 	struct si_shader_selector *sel = CALLOC_STRUCT(si_shader_selector);
 	int i;
@@ -649,6 +1071,7 @@ static void *si_create_shader_selector(struct pipe_context *ctx,
 	if (!sel)
 		return NULL;
 
+	sel->screen = sscreen;
 	sel->tokens = tgsi_dup_tokens(state->tokens);
 	if (!sel->tokens) {
 		FREE(sel);
@@ -730,20 +1153,42 @@ static void *si_create_shader_selector(struct pipe_context *ctx,
 		}
 		sel->esgs_itemsize = util_last_bit64(sel->outputs_written) * 16;
 		break;
+
+	case PIPE_SHADER_FRAGMENT:
+		for (i = 0; i < sel->info.num_inputs; i++) {
+			if (sel->info.input_semantic_name[i] == TGSI_SEMANTIC_COLOR)
+				sel->ps_reads_color = true;
+		}
+		break;
 	}
 
-	if (sscreen->b.debug_flags & DBG_PRECOMPILE) {
+	pipe_mutex_init(sel->mutex);
+	util_queue_fence_init(&sel->ready);
+
+	/* Compile synchronously if there is a debug callback, so that the
+	 * shader stats can be reported through it. */
+	if ((sscreen->b.debug_flags & DBG_PRECOMPILE) ||
+	    sctx->b.debug.debug_message) {
 		struct si_shader_ctx_state state = {sel};
 
 		if (si_shader_select(ctx, &state)) {
 			fprintf(stderr, "radeonsi: can't create a shader\n");
+			util_queue_fence_destroy(&sel->ready);
+			pipe_mutex_destroy(sel->mutex);
 			tgsi_free_tokens(sel->tokens);
 			FREE(sel);
 			return NULL;
 		}
+	} else if (util_queue_is_initialized(&sscreen->shader_compiler_queue)) {
+		/* Guess the key from the current states and compile the main
+		 * variant in the background, so that it's likely ready by
+		 * the time the shader is used for the first draw call.
+		 */
+		si_shader_selector_key(ctx, sel, &sel->main_key);
+		util_queue_add_job(&sscreen->shader_compiler_queue, sel,
+				   &sel->ready, si_init_shader_selector_async);
 	}
 
-	pipe_mutex_init(sel->mutex);
 	return sel;
 }
 
@@ -756,6 +1201,16 @@ static void *si_create_shader_selector(struct pipe_context *ctx,
 static void si_update_viewports_and_scissors(struct si_context *sctx)
 {
 	struct tgsi_shader_info *info = si_get_vs_info(sctx);
+	bool window_space = info &&
+		info->properties[TGSI_PROPERTY_VS_WINDOW_SPACE_POSITION];
+
+	/* The scissors are derived from the viewports unless the positions
+	 * are in window space. */
+	if (window_space != sctx->scissors.vs_window_space) {
+		sctx->scissors.vs_window_space = window_space;
+		sctx->scissors.dirty_mask = (1 << SI_MAX_VIEWPORTS) - 1;
+		si_mark_atom_dirty(sctx, &sctx->scissors.atom);
+	}
 
 	if (!info || !info->writes_viewport_index)
 		return;
@@ -854,7 +1309,7 @@ static void si_delete_shader_selector(struct pipe_context *ctx, void *state)
 {
 	struct si_context *sctx = (struct si_context *)ctx;
 	struct si_shader_selector *sel = (struct si_shader_selector *)state;
-	struct si_shader *p = sel->first_variant, *c;
+	struct si_shader *p, *c;
 	struct si_shader_ctx_state *current_shader[SI_NUM_SHADERS] = {
 		[PIPE_SHADER_VERTEX] = &sctx->vs_shader,
 		[PIPE_SHADER_TESS_CTRL] = &sctx->tcs_shader,
@@ -863,6 +1318,20 @@ static void si_delete_shader_selector(struct pipe_context *ctx, void *state)
 		[PIPE_SHADER_FRAGMENT] = &sctx->ps_shader,
 	};
 
+	util_queue_job_wait(&sel->ready);
+
+	/* If this shader needed the current scratch buffer size, let
+	 * si_update_spi_tmpring_size shrink the buffer to what the
+	 * remaining shaders need. */
+	for (p = sel->first_variant; p; p = p->next_variant) {
+		if (sctx->scratch_buffer && p->scratch_bytes_per_wave &&
+		    p->scratch_bytes_per_wave * sctx->scratch_waves >=
+		    sctx->scratch_buffer->b.b.width0)
+			sctx->scratch_buffer_shrink = true;
+	}
+
+	p = sel->first_variant;
+
 	if (current_shader[sel->type]->cso == sel) {
 		current_shader[sel->type]->cso = NULL;
 		current_shader[sel->type]->current = NULL;
@@ -902,6 +1371,7 @@ static void si_delete_shader_selector(struct pipe_context *ctx, void *state)
 		p = c;
 	}
 
+	util_queue_fence_destroy(&sel->ready);
 	pipe_mutex_destroy(sel->mutex);
 	free(sel->tokens);
 	free(sel);
@@ -1274,6 +1744,18 @@ static bool si_update_spi_tmpring_size(struct si_context *sctx)
 		sctx->scratch_waves;
 	int r;
 
+	if (sctx->scratch_buffer_shrink) {
+		sctx->scratch_buffer_shrink = false;
+
+		/* Release the buffer if the bound shaders need less. Shaders
+		 * that are bound later and need more will grow it again. */
+		if (scratch_needed_size < current_scratch_buffer_size) {
+			r600_resource_reference(&sctx->scratch_buffer, NULL);
+			current_scratch_buffer_size = 0;
+			sctx->emit_scratch_reloc = true;
+		}
+	}
+
 	if (scratch_needed_size > 0) {
 		if (scratch_needed_size > current_scratch_buffer_size) {
 			/* Create a bigger scratch buffer */
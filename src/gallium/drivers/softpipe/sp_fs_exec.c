@@ -47,7 +47,8 @@
 struct sp_exec_fragment_shader
 {
    struct sp_fragment_shader_variant base;
-   /* No other members for now */
+   /** The tokens decoded once, rather than on every prepare */
+   struct tgsi_exec_shader *exec_shader;
 };
 
 
@@ -64,12 +65,20 @@ exec_prepare( const struct sp_fragment_shader_variant *var,
               struct tgsi_exec_machine *machine,
               struct tgsi_sampler *sampler )
 {
+   struct sp_exec_fragment_shader *spefs = sp_exec_fragment_shader(var);
+
+   if (!spefs->exec_shader) {
+      spefs->exec_shader = tgsi_exec_shader_create(var->tokens);
+      if (!spefs->exec_shader)
+         return;
+   }
+
    /*
     * Bind tokens/shader to the interpreter's machine state.
     */
-   tgsi_exec_machine_bind_shader(machine,
-                                 var->tokens,
-                                 sampler);
+   tgsi_exec_machine_bind_exec_shader(machine,
+                                      spefs->exec_shader,
+                                      sampler);
 }
 
 
@@ -179,10 +188,13 @@ static void
 exec_delete(struct sp_fragment_shader_variant *var,
             struct tgsi_exec_machine *machine)
 {
+   struct sp_exec_fragment_shader *spefs = sp_exec_fragment_shader(var);
+
    if (machine->Tokens == var->tokens) {
-      tgsi_exec_machine_bind_shader(machine, NULL, NULL);
+      tgsi_exec_machine_bind_exec_shader(machine, NULL, NULL);
    }
 
+   tgsi_exec_shader_destroy(spefs->exec_shader);
    FREE( (void *) var->tokens );
    FREE(var);
 }
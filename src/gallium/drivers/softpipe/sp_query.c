@@ -34,8 +34,10 @@
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
 #include "sp_context.h"
+#include "sp_flush.h"
 #include "sp_query.h"
 #include "sp_state.h"
+#include "sp_texture.h"
 
 struct softpipe_query {
    unsigned type;
@@ -256,6 +258,74 @@ softpipe_get_query_result(struct pipe_context *pipe,
 }
 
 
+/**
+ * Store the result of a query into a buffer.  Softpipe results are always
+ * available by the time they are asked for, so this never has to wait.
+ */
+static void
+softpipe_get_query_result_resource(struct pipe_context *pipe,
+                                   struct pipe_query *q,
+                                   boolean wait,
+                                   enum pipe_query_value_type result_type,
+                                   int index,
+                                   struct pipe_resource *resource,
+                                   unsigned offset)
+{
+   struct softpipe_query *sq = softpipe_query(q);
+   uint8_t *dst = (uint8_t *) softpipe_resource_data(resource) + offset;
+   union pipe_query_result result;
+   uint64_t value;
+
+   if (index == -1) {
+      value = 1;
+   } else {
+      softpipe_get_query_result(pipe, q, TRUE, &result);
+
+      switch (sq->type) {
+      case PIPE_QUERY_OCCLUSION_PREDICATE:
+      case PIPE_QUERY_SO_OVERFLOW_PREDICATE:
+      case PIPE_QUERY_GPU_FINISHED:
+         value = result.b;
+         break;
+      case PIPE_QUERY_SO_STATISTICS:
+         value = index == 0 ? result.so_statistics.num_primitives_written :
+                              result.so_statistics.primitives_storage_needed;
+         break;
+      case PIPE_QUERY_PIPELINE_STATISTICS:
+         assert(index < sizeof(result.pipeline_statistics) / sizeof(uint64_t));
+         value = ((uint64_t *) &result.pipeline_statistics)[index];
+         break;
+      default:
+         value = result.u64;
+         break;
+      }
+   }
+
+   softpipe_flush_resource(pipe, resource, 0, 0, 0, FALSE, TRUE, FALSE);
+
+   switch (result_type) {
+   case PIPE_QUERY_TYPE_I32: {
+      int32_t v = MIN2(value, INT32_MAX);
+      memcpy(dst, &v, sizeof(v));
+      break;
+   }
+   case PIPE_QUERY_TYPE_U32: {
+      uint32_t v = MIN2(value, UINT32_MAX);
+      memcpy(dst, &v, sizeof(v));
+      break;
+   }
+   case PIPE_QUERY_TYPE_I64: {
+      int64_t v = MIN2(value, INT64_MAX);
+      memcpy(dst, &v, sizeof(v));
+      break;
+   }
+   case PIPE_QUERY_TYPE_U64:
+      memcpy(dst, &value, sizeof(value));
+      break;
+   }
+}
+
+
 /**
  * Called by rendering function to check rendering is conditional.
  * \return TRUE if we should render, FALSE if we should skip rendering
@@ -290,6 +360,7 @@ void softpipe_init_query_funcs(struct softpipe_context *softpipe )
    softpipe->pipe.begin_query = softpipe_begin_query;
    softpipe->pipe.end_query = softpipe_end_query;
    softpipe->pipe.get_query_result = softpipe_get_query_result;
+   softpipe->pipe.get_query_result_resource = softpipe_get_query_result_resource;
 }
 
 
@@ -252,6 +252,10 @@ softpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
    case PIPE_CAP_COPY_BETWEEN_COMPRESSED_AND_PLAIN_FORMATS:
    case PIPE_CAP_CLEAR_TEXTURE:
       return 0;
+   case PIPE_CAP_QUERY_BUFFER_OBJECT:
+      return 1;
+   case PIPE_CAP_SPARSE_BUFFER_PAGE_SIZE:
+      return 0;
    }
    /* should only get here on unhandled cases */
    debug_printf("Unexpected PIPE_CAP %d query\n", param);
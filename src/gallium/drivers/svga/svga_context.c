@@ -80,6 +80,7 @@ static void svga_destroy( struct pipe_context *pipe )
    /* free HW constant buffers */
    for (shader = 0; shader < Elements(svga->state.hw_draw.constbuf); shader++) {
       pipe_resource_reference(&svga->state.hw_draw.constbuf[shader], NULL);
+      FREE(svga->state.hw_draw.default_constbuf_copy[shader].data);
    }
 
    pipe->delete_blend_state(pipe, svga->noop_blend);
@@ -245,6 +246,8 @@ struct pipe_context *svga_context_create(struct pipe_screen *screen,
           sizeof(svga->state.hw_draw.constbuf));
    memset(svga->state.hw_draw.default_constbuf_size, 0,
           sizeof(svga->state.hw_draw.default_constbuf_size));
+   memset(svga->state.hw_draw.default_constbuf_copy, 0,
+          sizeof(svga->state.hw_draw.default_constbuf_copy));
    memset(svga->state.hw_draw.enabled_constbufs, 0,
           sizeof(svga->state.hw_draw.enabled_constbufs));
 
@@ -59,8 +59,12 @@
 #define SVGA_QUERY_NUM_RESOURCES           (PIPE_QUERY_DRIVER_SPECIFIC + 9)
 #define SVGA_QUERY_NUM_STATE_OBJECTS       (PIPE_QUERY_DRIVER_SPECIFIC + 10)
 #define SVGA_QUERY_NUM_SURFACE_VIEWS       (PIPE_QUERY_DRIVER_SPECIFIC + 11)
+#define SVGA_QUERY_SURFACE_CACHE_BYTES     (PIPE_QUERY_DRIVER_SPECIFIC + 12)
+#define SVGA_QUERY_SURFACE_CACHE_HITS      (PIPE_QUERY_DRIVER_SPECIFIC + 13)
+#define SVGA_QUERY_SURFACE_CACHE_MISSES    (PIPE_QUERY_DRIVER_SPECIFIC + 14)
+#define SVGA_QUERY_SURFACE_CACHE_EVICTIONS (PIPE_QUERY_DRIVER_SPECIFIC + 15)
 /*SVGA_QUERY_MAX has to be last because it is size of an array*/
-#define SVGA_QUERY_MAX                     (PIPE_QUERY_DRIVER_SPECIFIC + 12)
+#define SVGA_QUERY_MAX                     (PIPE_QUERY_DRIVER_SPECIFIC + 16)
 
 /**
  * Maximum supported number of constant buffers per shader
@@ -315,6 +319,20 @@ struct svga_hw_view_state
    int dirty;
 };
 
+/**
+ * Copy of the contents of a default (0th) VGPU10 constant buffer as last
+ * emitted, with the layout of the user and extra constants in it.
+ */
+struct svga_hw_constbuf_copy
+{
+   void *data;
+   unsigned size;
+   unsigned user_size;
+   unsigned extra_offset;
+   unsigned extra_size;
+   boolean valid;
+};
+
 /* Updated by calling svga_update_state( SVGA_STATE_HW_DRAW )
  */
 struct svga_hw_draw_state
@@ -353,6 +371,9 @@ struct svga_hw_draw_state
    /* used for rebinding */
    unsigned num_sampler_views[PIPE_SHADER_TYPES];
    unsigned default_constbuf_size[PIPE_SHADER_TYPES];
+
+   /* used to skip redundant default constant buffer uploads */
+   struct svga_hw_constbuf_copy default_constbuf_copy[PIPE_SHADER_TYPES];
 };
 
 
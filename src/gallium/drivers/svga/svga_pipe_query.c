@@ -732,6 +732,10 @@ svga_create_query(struct pipe_context *pipe,
    case SVGA_QUERY_NUM_SURFACE_VIEWS:
    case SVGA_QUERY_NUM_RESOURCES_MAPPED:
    case SVGA_QUERY_NUM_BYTES_UPLOADED:
+   case SVGA_QUERY_SURFACE_CACHE_BYTES:
+   case SVGA_QUERY_SURFACE_CACHE_HITS:
+   case SVGA_QUERY_SURFACE_CACHE_MISSES:
+   case SVGA_QUERY_SURFACE_CACHE_EVICTIONS:
       break;
    default:
       assert(!"unexpected query type in svga_create_query()");
@@ -800,6 +804,10 @@ svga_destroy_query(struct pipe_context *pipe, struct pipe_query *q)
    case SVGA_QUERY_NUM_SURFACE_VIEWS:
    case SVGA_QUERY_NUM_RESOURCES_MAPPED:
    case SVGA_QUERY_NUM_BYTES_UPLOADED:
+   case SVGA_QUERY_SURFACE_CACHE_BYTES:
+   case SVGA_QUERY_SURFACE_CACHE_HITS:
+   case SVGA_QUERY_SURFACE_CACHE_MISSES:
+   case SVGA_QUERY_SURFACE_CACHE_EVICTIONS:
       /* nothing */
       break;
    default:
@@ -887,6 +895,10 @@ svga_begin_query(struct pipe_context *pipe, struct pipe_query *q)
    case SVGA_QUERY_NUM_RESOURCES:
    case SVGA_QUERY_NUM_STATE_OBJECTS:
    case SVGA_QUERY_NUM_SURFACE_VIEWS:
+   case SVGA_QUERY_SURFACE_CACHE_BYTES:
+   case SVGA_QUERY_SURFACE_CACHE_HITS:
+   case SVGA_QUERY_SURFACE_CACHE_MISSES:
+   case SVGA_QUERY_SURFACE_CACHE_EVICTIONS:
       /* nothing */
       break;
    default:
@@ -980,6 +992,10 @@ svga_end_query(struct pipe_context *pipe, struct pipe_query *q)
    case SVGA_QUERY_NUM_RESOURCES:
    case SVGA_QUERY_NUM_STATE_OBJECTS:
    case SVGA_QUERY_NUM_SURFACE_VIEWS:
+   case SVGA_QUERY_SURFACE_CACHE_BYTES:
+   case SVGA_QUERY_SURFACE_CACHE_HITS:
+   case SVGA_QUERY_SURFACE_CACHE_MISSES:
+   case SVGA_QUERY_SURFACE_CACHE_EVICTIONS:
       /* nothing */
       break;
    default:
@@ -1090,6 +1106,18 @@ svga_get_query_result(struct pipe_context *pipe,
    case SVGA_QUERY_NUM_SURFACE_VIEWS:
       vresult->u64 = svga->hud.num_surface_views;
       break;
+   case SVGA_QUERY_SURFACE_CACHE_BYTES:
+      vresult->u64 = svgascreen->cache.total_size;
+      break;
+   case SVGA_QUERY_SURFACE_CACHE_HITS:
+      vresult->u64 = svgascreen->cache.num_hits;
+      break;
+   case SVGA_QUERY_SURFACE_CACHE_MISSES:
+      vresult->u64 = svgascreen->cache.num_misses;
+      break;
+   case SVGA_QUERY_SURFACE_CACHE_EVICTIONS:
+      vresult->u64 = svgascreen->cache.num_evictions;
+      break;
    default:
       assert(!"unexpected query type in svga_get_query_result");
    }
@@ -384,6 +384,8 @@ svga_get_param(struct pipe_screen *screen, enum pipe_cap param)
    case PIPE_CAP_SHAREABLE_SHADERS:
    case PIPE_CAP_COPY_BETWEEN_COMPRESSED_AND_PLAIN_FORMATS:
    case PIPE_CAP_CLEAR_TEXTURE:
+   case PIPE_CAP_QUERY_BUFFER_OBJECT:
+   case PIPE_CAP_SPARSE_BUFFER_PAGE_SIZE:
       return 0;
    }
 
@@ -811,6 +813,14 @@ svga_get_driver_query_info(struct pipe_screen *screen,
             PIPE_DRIVER_QUERY_TYPE_UINT64),
       QUERY("num-surface-views", SVGA_QUERY_NUM_SURFACE_VIEWS,
             PIPE_DRIVER_QUERY_TYPE_UINT64),
+      QUERY("surface-cache-bytes", SVGA_QUERY_SURFACE_CACHE_BYTES,
+            PIPE_DRIVER_QUERY_TYPE_BYTES),
+      QUERY("surface-cache-hits", SVGA_QUERY_SURFACE_CACHE_HITS,
+            PIPE_DRIVER_QUERY_TYPE_UINT64),
+      QUERY("surface-cache-misses", SVGA_QUERY_SURFACE_CACHE_MISSES,
+            PIPE_DRIVER_QUERY_TYPE_UINT64),
+      QUERY("surface-cache-evictions", SVGA_QUERY_SURFACE_CACHE_EVICTIONS,
+            PIPE_DRIVER_QUERY_TYPE_UINT64),
    };
 #undef QUERY
 
@@ -154,6 +154,11 @@ svga_screen_cache_lookup(struct svga_screen *svgascreen,
       next = curr->next;
    }
 
+   if (handle)
+      cache->num_hits++;
+   else
+      cache->num_misses++;
+
    pipe_mutex_unlock(cache->mutex);
 
    if (SVGA_DEBUG & DEBUG_DMA)
@@ -186,6 +191,7 @@ svga_screen_cache_shrink(struct svga_screen *svgascreen,
          /* we don't want to discard vertex/index buffers */
 
          cache->total_size -= surface_size(&entry->key);
+         cache->num_evictions++;
 
          assert(entry->handle);
          sws->surface_reference(sws, &entry->handle, NULL);
@@ -228,19 +234,19 @@ svga_screen_cache_add(struct svga_screen *svgascreen,
    *p_handle = NULL;
    pipe_mutex_lock(cache->mutex);
 
-   if (surf_size >= SVGA_HOST_SURFACE_CACHE_BYTES) {
+   if (surf_size >= cache->max_size) {
       /* this surface is too large to cache, just free it */
       sws->surface_reference(sws, &handle, NULL);
       pipe_mutex_unlock(cache->mutex);
       return;
    }
 
-   if (cache->total_size + surf_size > SVGA_HOST_SURFACE_CACHE_BYTES) {
+   if (cache->total_size + surf_size > cache->max_size) {
       /* Adding this surface would exceed the cache size.
        * Try to discard least recently used entries until we hit the
        * new target cache size.
        */
-      unsigned target_size = SVGA_HOST_SURFACE_CACHE_BYTES - surf_size;
+      unsigned target_size = cache->max_size - surf_size;
 
       svga_screen_cache_shrink(svgascreen, target_size);
 
@@ -272,6 +278,7 @@ svga_screen_cache_add(struct svga_screen *svgascreen,
                "unref sid %p (make space)\n", entry->handle);
 
       cache->total_size -= surface_size(&entry->key);
+      cache->num_evictions++;
 
       sws->surface_reference(sws, &entry->handle, NULL);
 
@@ -389,6 +396,9 @@ svga_screen_cache_init(struct svga_screen *svgascreen)
 
    pipe_mutex_init(cache->mutex);
 
+   cache->max_size = debug_get_num_option("SVGA_SURFACE_CACHE_BYTES",
+                                          SVGA_HOST_SURFACE_CACHE_BYTES);
+
    for (i = 0; i < SVGA_HOST_SURFACE_CACHE_BUCKETS; ++i)
       LIST_INITHEAD(&cache->bucket[i]);
 
@@ -38,7 +38,7 @@
 
 
 /* Guess the storage size of cached surfaces and try and keep it under
- * this amount:
+ * this amount by default (see SVGA_SURFACE_CACHE_BYTES):
  */ 
 #define SVGA_HOST_SURFACE_CACHE_BYTES (16 * 1024 * 1024)
 
@@ -124,6 +124,14 @@ struct svga_host_surface_cache
 
    /** Sum of sizes of all surfaces (in bytes) */
    unsigned total_size;
+
+   /** Budget for total_size (in bytes) */
+   unsigned max_size;
+
+   /** HUD counters */
+   uint64_t num_hits;
+   uint64_t num_misses;
+   uint64_t num_evictions;
 };
 
 
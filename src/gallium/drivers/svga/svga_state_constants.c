@@ -367,26 +367,38 @@ emit_const_range(struct svga_context *svga,
                          values[i][2],
                          values[i][3]);
 
-         /* Look for more consecutive dirty constants.
+         /* Look for more consecutive dirty constants.  A single unchanged
+          * constant between two dirty ones is sent along with them, as
+          * that takes less command buffer space than starting a new
+          * command.
           */
          j = i + 1;
-         while (j < count &&
-                j < i + MAX_CONST_REG_COUNT &&
-                memcmp(svga->state.hw_draw.cb[shader][offset + j],
+         while (j < count && j < i + MAX_CONST_REG_COUNT) {
+            if (memcmp(svga->state.hw_draw.cb[shader][offset + j],
                        values[j],
                        4 * sizeof(float)) != 0) {
-
-            if (SVGA_DEBUG & DEBUG_CONSTS)
-               debug_printf("%s %s %d: %f %f %f %f\n",
-                            __FUNCTION__,
-                            shader == PIPE_SHADER_VERTEX ? "VERT" : "FRAG",
-                            offset + j,
-                            values[j][0],
-                            values[j][1],
-                            values[j][2],
-                            values[j][3]);
-
-            ++j;
+               if (SVGA_DEBUG & DEBUG_CONSTS)
+                  debug_printf("%s %s %d: %f %f %f %f\n",
+                               __FUNCTION__,
+                               shader == PIPE_SHADER_VERTEX ? "VERT" : "FRAG",
+                               offset + j,
+                               values[j][0],
+                               values[j][1],
+                               values[j][2],
+                               values[j][3]);
+
+               ++j;
+            }
+            else if (j + 1 < count &&
+                     j + 1 < i + MAX_CONST_REG_COUNT &&
+                     memcmp(svga->state.hw_draw.cb[shader][offset + j + 1],
+                            values[j + 1],
+                            4 * sizeof(float)) != 0) {
+               ++j;
+            }
+            else {
+               break;
+            }
          }
 
          assert(j >= i + 1);
@@ -419,7 +431,7 @@ emit_const_range(struct svga_context *svga,
                 values[i],
                 (j - i) * 4 * sizeof(float));
 
-         i = j + 1;
+         i = j;
       } else {
          ++i;
       }
@@ -535,6 +547,73 @@ emit_consts_vgpu9(struct svga_context *svga, unsigned shader)
 
 
 
+/**
+ * Check if the default constant buffer about to be emitted for a shader
+ * stage has the same layout and contents as the last one.
+ */
+static boolean
+constbuf_unchanged_vgpu10(const struct svga_context *svga, unsigned shader,
+                          const void *user_data, unsigned user_size,
+                          const void *extras, unsigned extra_offset,
+                          unsigned extra_size)
+{
+   const struct svga_hw_constbuf_copy *copy =
+      &svga->state.hw_draw.default_constbuf_copy[shader];
+   const char *data = copy->data;
+   const unsigned extra_end = extra_offset + extra_size;
+
+   if (!copy->valid ||
+       copy->user_size != user_size ||
+       copy->extra_offset != extra_offset ||
+       copy->extra_size != extra_size)
+      return FALSE;
+
+   /* The extra constants may overwrite part of the user constants */
+   if (MIN2(user_size, extra_offset) &&
+       memcmp(data, user_data, MIN2(user_size, extra_offset)) != 0)
+      return FALSE;
+
+   if (extra_size && memcmp(data + extra_offset, extras, extra_size) != 0)
+      return FALSE;
+
+   if (user_size > extra_end &&
+       memcmp(data + extra_end, (const char *) user_data + extra_end,
+              user_size - extra_end) != 0)
+      return FALSE;
+
+   return TRUE;
+}
+
+
+/**
+ * Keep a copy of the default constant buffer contents just emitted.
+ */
+static void
+constbuf_save_vgpu10(struct svga_context *svga, unsigned shader,
+                     const void *data, unsigned size, unsigned user_size,
+                     unsigned extra_offset, unsigned extra_size)
+{
+   struct svga_hw_constbuf_copy *copy =
+      &svga->state.hw_draw.default_constbuf_copy[shader];
+
+   /* Only becomes valid once the buffer is actually bound */
+   copy->valid = FALSE;
+
+   if (size != copy->size) {
+      FREE(copy->data);
+      copy->data = MALLOC(size);
+      copy->size = copy->data ? size : 0;
+   }
+
+   if (copy->data) {
+      memcpy(copy->data, data, size);
+      copy->user_size = user_size;
+      copy->extra_offset = extra_offset;
+      copy->extra_size = extra_size;
+   }
+}
+
+
 static enum pipe_error
 emit_constbuf_vgpu10(struct svga_context *svga, unsigned shader)
 {
@@ -600,6 +679,17 @@ emit_constbuf_vgpu10(struct svga_context *svga, unsigned shader)
       }
    }
 
+   /* Don't upload and rebind the same constants again.  Any of the state
+    * the extra constants depend on triggers this function, even if those
+    * constants didn't actually change.
+    */
+   if (constbuf_unchanged_vgpu10(svga, shader, src_map, cbuf->buffer_size,
+                                 extras, extra_offset, extra_size)) {
+      if (src_map)
+         pipe_buffer_unmap(&svga->pipe, src_transfer);
+      return PIPE_OK;
+   }
+
    /* The new/dest buffer's size must be large enough to hold the original,
     * user-specified constants, plus the extra constants.
     * The size of the original constant buffer _should_ agree with what the
@@ -630,6 +720,10 @@ emit_constbuf_vgpu10(struct svga_context *svga, unsigned shader)
       assert(extra_offset + extra_size <= new_buf_size);
       memcpy((char *) dst_map + extra_offset, extras, extra_size);
    }
+
+   constbuf_save_vgpu10(svga, shader, dst_map, new_buf_size,
+                        cbuf->buffer_size, extra_offset, extra_size);
+
    u_upload_unmap(svga->const0_upload);
 
    /* Issue the SetSingleConstantBuffer command */
@@ -660,6 +754,8 @@ emit_constbuf_vgpu10(struct svga_context *svga, unsigned shader)
    pipe_resource_reference(&svga->state.hw_draw.constbuf[shader], dst_buffer);
 
    svga->state.hw_draw.default_constbuf_size[shader] = new_buf_size;
+   svga->state.hw_draw.default_constbuf_copy[shader].valid =
+      svga->state.hw_draw.default_constbuf_copy[shader].data != NULL;
 
    pipe_resource_reference(&dst_buffer, NULL);
 
@@ -262,6 +262,37 @@ trace_context_get_query_result(struct pipe_context *_pipe,
 }
 
 
+static inline void
+trace_context_get_query_result_resource(struct pipe_context *_pipe,
+                                        struct pipe_query *_query,
+                                        boolean wait,
+                                        enum pipe_query_value_type result_type,
+                                        int index,
+                                        struct pipe_resource *_resource,
+                                        unsigned offset)
+{
+   struct trace_context *tr_ctx = trace_context(_pipe);
+   struct pipe_context *pipe = tr_ctx->pipe;
+   struct pipe_query *query = trace_query_unwrap(_query);
+   struct pipe_resource *resource = trace_resource_unwrap(tr_ctx, _resource);
+
+   trace_dump_call_begin("pipe_context", "get_query_result_resource");
+
+   trace_dump_arg(ptr, pipe);
+   trace_dump_arg(ptr, query);
+   trace_dump_arg(bool, wait);
+   trace_dump_arg(uint, result_type);
+   trace_dump_arg(int, index);
+   trace_dump_arg(ptr, resource);
+   trace_dump_arg(uint, offset);
+
+   pipe->get_query_result_resource(pipe, query, wait, result_type, index,
+                                   resource, offset);
+
+   trace_dump_call_end();
+}
+
+
 static inline void *
 trace_context_create_blend_state(struct pipe_context *_pipe,
                                  const struct pipe_blend_state *state)
@@ -1181,6 +1212,36 @@ trace_context_flush_resource(struct pipe_context *_pipe,
 }
 
 
+static boolean
+trace_context_resource_commit(struct pipe_context *_pipe,
+                              struct pipe_resource *resource,
+                              unsigned level, struct pipe_box *box,
+                              boolean commit)
+{
+   struct trace_context *tr_ctx = trace_context(_pipe);
+   struct pipe_context *pipe = tr_ctx->pipe;
+   boolean ret;
+
+   resource = trace_resource_unwrap(tr_ctx, resource);
+
+   trace_dump_call_begin("pipe_context", "resource_commit");
+
+   trace_dump_arg(ptr, pipe);
+   trace_dump_arg(ptr, resource);
+   trace_dump_arg(uint, level);
+   trace_dump_arg(box, box);
+   trace_dump_arg(bool, commit);
+
+   ret = pipe->resource_commit(pipe, resource, level, box, commit);
+
+   trace_dump_ret(bool, ret);
+
+   trace_dump_call_end();
+
+   return ret;
+}
+
+
 static inline void
 trace_context_clear(struct pipe_context *_pipe,
                     unsigned buffers,
@@ -1564,6 +1625,7 @@ trace_context_create(struct trace_screen *tr_scr,
    TR_CTX_INIT(begin_query);
    TR_CTX_INIT(end_query);
    TR_CTX_INIT(get_query_result);
+   TR_CTX_INIT(get_query_result_resource);
    TR_CTX_INIT(create_blend_state);
    TR_CTX_INIT(bind_blend_state);
    TR_CTX_INIT(delete_blend_state);
@@ -1616,6 +1678,7 @@ trace_context_create(struct trace_screen *tr_scr,
    TR_CTX_INIT(resource_copy_region);
    TR_CTX_INIT(blit);
    TR_CTX_INIT(flush_resource);
+   TR_CTX_INIT(resource_commit);
    TR_CTX_INIT(clear);
    TR_CTX_INIT(clear_render_target);
    TR_CTX_INIT(clear_depth_stencil);
@@ -0,0 +1,396 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Binary trace stream encoder and writer thread.  See tr_dump_bin.h for
+ * the format.
+ */
+
+#include <string.h>
+
+#include "os/os_thread.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "util/hash_table.h"
+#include "util/ralloc.h"
+
+#include "tr_dump_bin.h"
+
+
+#define TRACE_BIN_CHUNK_SIZE (1 << 20)
+
+/* Bounds the memory used when the disk can't keep up. */
+#define TRACE_BIN_MAX_QUEUED_CHUNKS 64
+
+struct trace_bin_chunk
+{
+   struct trace_bin_chunk *next;
+   size_t size;
+   uint8_t data[TRACE_BIN_CHUNK_SIZE];
+};
+
+/* Key of the table of byte arrays already in the stream. */
+struct trace_bin_blob
+{
+   uint64_t hash;
+   size_t size;
+};
+
+static FILE *stream = NULL;
+static struct trace_bin_chunk *chunk = NULL;
+
+static struct hash_table *names = NULL;
+static struct hash_table *blobs = NULL;
+
+/* The queue of chunks to write, shared with the writer thread. */
+pipe_static_mutex(queue_mutex);
+static pipe_condvar queue_cond;
+static pipe_condvar space_cond;
+static struct trace_bin_chunk *queue_head = NULL;
+static struct trace_bin_chunk **queue_tail = &queue_head;
+static unsigned num_queued = 0;
+static boolean writer_quit = FALSE;
+static pipe_thread writer;
+
+
+static PIPE_THREAD_ROUTINE(trace_bin_writer, param)
+{
+   pipe_thread_setname("trace_writer");
+
+   pipe_mutex_lock(queue_mutex);
+   for (;;) {
+      struct trace_bin_chunk *c;
+
+      while (!queue_head && !writer_quit)
+         pipe_condvar_wait(queue_cond, queue_mutex);
+      if (!queue_head)
+         break;
+
+      c = queue_head;
+      queue_head = c->next;
+      if (!queue_head)
+         queue_tail = &queue_head;
+      num_queued--;
+      pipe_condvar_signal(space_cond);
+      pipe_mutex_unlock(queue_mutex);
+
+      fwrite(c->data, c->size, 1, stream);
+      FREE(c);
+
+      pipe_mutex_lock(queue_mutex);
+   }
+   pipe_mutex_unlock(queue_mutex);
+
+   fflush(stream);
+   return 0;
+}
+
+
+static void
+trace_bin_submit(void)
+{
+   if (!chunk || !chunk->size)
+      return;
+
+   chunk->next = NULL;
+
+   pipe_mutex_lock(queue_mutex);
+   while (num_queued >= TRACE_BIN_MAX_QUEUED_CHUNKS)
+      pipe_condvar_wait(space_cond, queue_mutex);
+   *queue_tail = chunk;
+   queue_tail = &chunk->next;
+   num_queued++;
+   pipe_condvar_signal(queue_cond);
+   pipe_mutex_unlock(queue_mutex);
+
+   chunk = NULL;
+}
+
+
+static void
+trace_bin_write(const void *data, size_t size)
+{
+   const uint8_t *p = data;
+
+   while (size) {
+      size_t n;
+
+      if (!chunk) {
+         chunk = MALLOC_STRUCT(trace_bin_chunk);
+         if (!chunk)
+            return;
+         chunk->size = 0;
+      }
+
+      n = MIN2(size, TRACE_BIN_CHUNK_SIZE - chunk->size);
+      memcpy(chunk->data + chunk->size, p, n);
+      chunk->size += n;
+      p += n;
+      size -= n;
+
+      if (chunk->size == TRACE_BIN_CHUNK_SIZE)
+         trace_bin_submit();
+   }
+}
+
+
+static inline void
+trace_bin_write_byte(uint8_t byte)
+{
+   if (chunk && chunk->size < TRACE_BIN_CHUNK_SIZE)
+      chunk->data[chunk->size++] = byte;
+   else
+      trace_bin_write(&byte, 1);
+}
+
+
+void
+trace_bin_op(enum trace_bin_op op)
+{
+   trace_bin_write_byte(op);
+}
+
+
+void
+trace_bin_uint(uint64_t value)
+{
+   while (value >= 0x80) {
+      trace_bin_write_byte((value & 0x7f) | 0x80);
+      value >>= 7;
+   }
+   trace_bin_write_byte(value);
+}
+
+
+void
+trace_bin_int(int64_t value)
+{
+   trace_bin_uint(((uint64_t) value << 1) ^ (uint64_t) (value >> 63));
+}
+
+
+void
+trace_bin_float(double value)
+{
+   uint64_t bits;
+   unsigned i;
+
+   memcpy(&bits, &value, sizeof(bits));
+   for (i = 0; i < 8; i++)
+      trace_bin_write_byte(bits >> (i * 8));
+}
+
+
+static void
+trace_bin_data(const void *data, size_t size)
+{
+   trace_bin_uint(size);
+   trace_bin_write(data, size);
+}
+
+
+void
+trace_bin_string(const char *str)
+{
+   trace_bin_op(TRACE_BIN_STRING);
+   trace_bin_data(str, strlen(str));
+}
+
+
+/**
+ * Returns the index of a name, defining the name in the stream first if it
+ * isn't there yet.
+ */
+unsigned
+trace_bin_name(const char *name)
+{
+   uint32_t hash = _mesa_hash_string(name);
+   struct hash_entry *entry =
+      _mesa_hash_table_search_pre_hashed(names, hash, name);
+   uintptr_t index;
+
+   if (entry) {
+      index = (uintptr_t) entry->data;
+   } else {
+      index = names->entries;
+      _mesa_hash_table_insert_pre_hashed(names, hash,
+                                         ralloc_strdup(names, name),
+                                         (void *) index);
+      trace_bin_op(TRACE_BIN_STRING_DEF);
+      trace_bin_data(name, strlen(name));
+   }
+
+   return index;
+}
+
+
+/**
+ * Writes an opcode whose operand is a name.
+ */
+void
+trace_bin_name_op(enum trace_bin_op op, const char *name)
+{
+   unsigned index = trace_bin_name(name);
+
+   trace_bin_op(op);
+   trace_bin_uint(index);
+}
+
+
+static uint64_t
+trace_bin_hash_bytes(const void *data, size_t size)
+{
+   const uint8_t *p = data;
+   uint64_t hash = 0xcbf29ce484222325ull;
+   size_t i;
+
+   for (i = 0; i < size; i++) {
+      hash ^= p[i];
+      hash *= 0x100000001b3ull;
+   }
+   return hash;
+}
+
+static uint32_t
+trace_bin_blob_hash(const void *key)
+{
+   const struct trace_bin_blob *blob = key;
+
+   return (uint32_t) (blob->hash ^ (blob->hash >> 32));
+}
+
+static bool
+trace_bin_blob_equal(const void *a, const void *b)
+{
+   const struct trace_bin_blob *blob_a = a, *blob_b = b;
+
+   return blob_a->hash == blob_b->hash && blob_a->size == blob_b->size;
+}
+
+
+/**
+ * Byte arrays are identified by a 64-bit hash of their content and their
+ * size, so a collision would make the trace show the wrong data; this is
+ * unlikely enough for a debugging aid.
+ */
+void
+trace_bin_bytes(const void *data, size_t size)
+{
+   struct trace_bin_blob key, *blob;
+   struct hash_entry *entry;
+   uintptr_t index;
+
+   if (size < TRACE_BIN_MIN_SHARED_BYTES) {
+      trace_bin_op(TRACE_BIN_BYTES_INLINE);
+      trace_bin_data(data, size);
+      return;
+   }
+
+   key.hash = trace_bin_hash_bytes(data, size);
+   key.size = size;
+
+   entry = _mesa_hash_table_search(blobs, &key);
+   if (entry) {
+      index = (uintptr_t) entry->data;
+   } else {
+      index = blobs->entries;
+      blob = ralloc(blobs, struct trace_bin_blob);
+      if (!blob) {
+         trace_bin_op(TRACE_BIN_BYTES_INLINE);
+         trace_bin_data(data, size);
+         return;
+      }
+      *blob = key;
+      _mesa_hash_table_insert(blobs, blob, (void *) index);
+      trace_bin_op(TRACE_BIN_BYTES_DEF);
+      trace_bin_data(data, size);
+   }
+
+   trace_bin_op(TRACE_BIN_BYTES);
+   trace_bin_uint(index);
+}
+
+
+boolean
+trace_bin_begin(FILE *_stream)
+{
+   static const char magic[] = TRACE_BIN_MAGIC;
+
+   names = _mesa_hash_table_create(NULL, _mesa_key_hash_string,
+                                   _mesa_key_string_equal);
+   blobs = _mesa_hash_table_create(NULL, trace_bin_blob_hash,
+                                   trace_bin_blob_equal);
+   if (!names || !blobs)
+      goto fail;
+
+   pipe_condvar_init(queue_cond);
+   pipe_condvar_init(space_cond);
+   stream = _stream;
+   writer_quit = FALSE;
+   writer = pipe_thread_create(trace_bin_writer, NULL);
+   if (!writer) {
+      pipe_condvar_destroy(queue_cond);
+      pipe_condvar_destroy(space_cond);
+      goto fail;
+   }
+
+   trace_bin_write(magic, sizeof(magic) - 1);
+   trace_bin_write_byte(TRACE_BIN_VERSION);
+   return TRUE;
+
+fail:
+   _mesa_hash_table_destroy(names, NULL);
+   _mesa_hash_table_destroy(blobs, NULL);
+   names = blobs = NULL;
+   return FALSE;
+}
+
+
+/**
+ * Writes out everything encoded so far and stops the writer thread.
+ */
+void
+trace_bin_end(void)
+{
+   trace_bin_submit();
+   FREE(chunk);
+   chunk = NULL;
+
+   pipe_mutex_lock(queue_mutex);
+   writer_quit = TRUE;
+   pipe_condvar_signal(queue_cond);
+   pipe_mutex_unlock(queue_mutex);
+   pipe_thread_wait(writer);
+
+   pipe_condvar_destroy(queue_cond);
+   pipe_condvar_destroy(space_cond);
+   _mesa_hash_table_destroy(names, NULL);
+   _mesa_hash_table_destroy(blobs, NULL);
+   names = blobs = NULL;
+   stream = NULL;
+}
@@ -0,0 +1,109 @@
+/**************************************************************************
+ *
+ * Copyright 2016 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Binary trace stream, written instead of the XML when
+ * GALLIUM_TRACE_FORMAT=binary.
+ *
+ * The stream encodes the same tree of elements as the XML, as one opcode
+ * byte per element followed by its operands.  Unsigned integers are LEB128
+ * varints, signed ones are zigzag encoded first, and floats are little
+ * endian doubles.  Names (classes, methods, arguments, structs, members and
+ * enums) are defined once with TRACE_BIN_STRING_DEF and then referred to by
+ * index.  Byte arrays of TRACE_BIN_MIN_SHARED_BYTES or more are likewise
+ * defined once per distinct content with TRACE_BIN_BYTES_DEF, so repeated
+ * uploads of the same data cost a few bytes each.
+ *
+ * The encoded data is handed over in large chunks to a writer thread, so
+ * the traced application doesn't wait for the disk.
+ *
+ * src/gallium/tools/trace/bin2xml.py converts the stream to the XML.
+ */
+
+#ifndef TR_DUMP_BIN_H
+#define TR_DUMP_BIN_H
+
+#include <stdio.h>
+
+#include "pipe/p_compiler.h"
+
+
+#define TRACE_BIN_MAGIC "GALLIUM-TRACE-BIN"  /* followed by a version byte */
+#define TRACE_BIN_VERSION 1
+
+#define TRACE_BIN_MIN_SHARED_BYTES 64
+
+enum trace_bin_op
+{
+   TRACE_BIN_STRING_DEF = 1, /* length, bytes: defines the next name index */
+   TRACE_BIN_BYTES_DEF,      /* length, bytes: defines the next bytes index */
+   TRACE_BIN_CALL_BEGIN,     /* class name, method name */
+   TRACE_BIN_CALL_END,       /* signed call duration in microseconds */
+   TRACE_BIN_ARG_BEGIN,      /* name */
+   TRACE_BIN_ARG_END,
+   TRACE_BIN_RET_BEGIN,
+   TRACE_BIN_RET_END,
+   TRACE_BIN_BOOL,           /* one byte */
+   TRACE_BIN_INT,            /* signed */
+   TRACE_BIN_UINT,           /* unsigned */
+   TRACE_BIN_FLOAT,          /* double */
+   TRACE_BIN_BYTES,          /* bytes index */
+   TRACE_BIN_BYTES_INLINE,   /* length, bytes */
+   TRACE_BIN_STRING,         /* length, bytes */
+   TRACE_BIN_ENUM,           /* name */
+   TRACE_BIN_ARRAY_BEGIN,
+   TRACE_BIN_ARRAY_END,
+   TRACE_BIN_ELEM_BEGIN,
+   TRACE_BIN_ELEM_END,
+   TRACE_BIN_STRUCT_BEGIN,   /* name */
+   TRACE_BIN_STRUCT_END,
+   TRACE_BIN_MEMBER_BEGIN,   /* name */
+   TRACE_BIN_MEMBER_END,
+   TRACE_BIN_NULL,
+   TRACE_BIN_PTR,            /* unsigned */
+};
+
+
+/*
+ * All functions but trace_bin_begin and trace_bin_end expect the call
+ * mutex to be held.
+ */
+boolean trace_bin_begin(FILE *stream);
+void trace_bin_end(void);
+
+void trace_bin_op(enum trace_bin_op op);
+unsigned trace_bin_name(const char *name);
+void trace_bin_name_op(enum trace_bin_op op, const char *name);
+void trace_bin_uint(uint64_t value);
+void trace_bin_int(int64_t value);
+void trace_bin_float(double value);
+void trace_bin_string(const char *str);
+void trace_bin_bytes(const void *data, size_t size);
+
+
+#endif /* TR_DUMP_BIN_H */
@@ -173,14 +173,27 @@ vc4_cl_references_bo(struct pipe_context *pctx, struct vc4_bo *bo)
         return false;
 }
 
+/**
+ * Drops the stores of the current job to an invalidated framebuffer
+ * attachment, and the loads of it for any rendering that follows, since its
+ * contents are now undefined.
+ */
 static void
 vc4_invalidate_resource(struct pipe_context *pctx, struct pipe_resource *prsc)
 {
         struct vc4_context *vc4 = vc4_context(pctx);
+        struct pipe_surface *cbuf = vc4->framebuffer.cbufs[0];
         struct pipe_surface *zsurf = vc4->framebuffer.zsbuf;
 
-        if (zsurf && zsurf->texture == prsc)
+        if (cbuf && cbuf->texture == prsc) {
+                vc4->resolve &= ~PIPE_CLEAR_COLOR0;
+                vc4->cleared |= PIPE_CLEAR_COLOR0;
+        }
+
+        if (zsurf && zsurf->texture == prsc) {
                 vc4->resolve &= ~(PIPE_CLEAR_DEPTH | PIPE_CLEAR_STENCIL);
+                vc4->cleared |= PIPE_CLEAR_DEPTH | PIPE_CLEAR_STENCIL;
+        }
 }
 
 static void
@@ -205,8 +218,6 @@ vc4_context_destroy(struct pipe_context *pctx)
         pipe_surface_reference(&vc4->color_write, NULL);
         pipe_surface_reference(&vc4->color_read, NULL);
 
-        vc4_program_fini(pctx);
-
         ralloc_free(vc4);
 }
 
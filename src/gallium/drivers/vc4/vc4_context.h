@@ -102,6 +102,11 @@ struct vc4_uncompiled_shader {
         uint32_t program_id;
         /** How many variants of this program were compiled, for shader-db. */
         uint32_t compiled_variant_count;
+        /**
+         * Number of CSOs handed out for these tokens, across all contexts.
+         * Protected by vc4_screen::shader_cache_lock.
+         */
+        uint32_t refcount;
         struct pipe_shader_state base;
 };
 
@@ -273,10 +278,6 @@ struct vc4_context {
 
         struct primconvert_context *primconvert;
 
-        struct hash_table *fs_cache, *vs_cache;
-        uint32_t next_uncompiled_program_id;
-        uint64_t next_compiled_program_id;
-
         struct ra_regs *regs;
         unsigned int reg_class_any;
         unsigned int reg_class_a_or_b_or_acc;
@@ -381,7 +382,8 @@ struct pipe_context *vc4_context_create(struct pipe_screen *pscreen,
 void vc4_draw_init(struct pipe_context *pctx);
 void vc4_state_init(struct pipe_context *pctx);
 void vc4_program_init(struct pipe_context *pctx);
-void vc4_program_fini(struct pipe_context *pctx);
+void vc4_program_screen_init(struct pipe_screen *pscreen);
+void vc4_program_screen_fini(struct pipe_screen *pscreen);
 void vc4_query_init(struct pipe_context *pctx);
 void vc4_simulator_init(struct vc4_screen *screen);
 int vc4_simulator_flush(struct vc4_context *vc4,
@@ -381,10 +381,19 @@ vc4_clear(struct pipe_context *pctx, unsigned buffers,
 
         /* We can't flag new buffers for clearing once we've queued draws.  We
          * could avoid this by using the 3d engine to clear.
+         *
+         * If the clear overwrites every buffer the queued draws rendered to,
+         * though, nothing they did can be observed (the framebuffer is all
+         * a job writes), so just throw the job away instead of spending the
+         * memory bandwidth on loading and storing its tiles.
          */
         if (vc4->draw_calls_queued) {
-                perf_debug("Flushing rendering to process new clear.\n");
-                vc4_flush(pctx);
+                if (!(vc4->resolve & ~buffers)) {
+                        vc4_job_reset(vc4);
+                } else {
+                        perf_debug("Flushing rendering to process new clear.\n");
+                        vc4_flush(pctx);
+                }
         }
 
         if (buffers & PIPE_CLEAR_COLOR0) {
@@ -29,6 +29,8 @@
 #include "util/u_memory.h"
 #include "util/ralloc.h"
 #include "util/hash_table.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
 #include "tgsi/tgsi_dump.h"
 #include "tgsi/tgsi_lowering.h"
 #include "tgsi/tgsi_parse.h"
@@ -1352,7 +1354,10 @@ vc4_optimize_nir(struct nir_shader *s)
                 progress = nir_copy_prop(s) || progress;
                 progress = nir_opt_dce(s) || progress;
                 progress = nir_opt_cse(s) || progress;
-                progress = nir_opt_peephole_select(s) || progress;
+                /* We can't emit general if statements, so flatten
+                 * everything we can.
+                 */
+                progress = nir_opt_peephole_select(s, UINT_MAX) || progress;
                 progress = nir_opt_algebraic(s) || progress;
                 progress = nir_opt_constant_folding(s) || progress;
                 progress = nir_opt_undef(s) || progress;
@@ -1721,28 +1726,6 @@ static const nir_shader_compiler_options nir_options = {
         .lower_negate = true,
 };
 
-static bool
-count_nir_instrs_in_block(nir_block *block, void *state)
-{
-        int *count = (int *) state;
-        nir_foreach_instr(block, instr) {
-                *count = *count + 1;
-        }
-        return true;
-}
-
-static int
-count_nir_instrs(nir_shader *nir)
-{
-        int count = 0;
-        nir_foreach_overload(nir, overload) {
-                if (!overload->impl)
-                        continue;
-                nir_foreach_block(overload->impl, count_nir_instrs_in_block, &count);
-        }
-        return count;
-}
-
 static struct vc4_compile *
 vc4_shader_ntq(struct vc4_context *vc4, enum qstage stage,
                        struct vc4_key *key)
@@ -1809,10 +1792,18 @@ vc4_shader_ntq(struct vc4_context *vc4, enum qstage stage,
         nir_convert_from_ssa(c->s, true);
 
         if (vc4_debug & VC4_DEBUG_SHADERDB) {
+                nir_shader_stats stats;
+                nir_gather_stats(c->s, &stats);
+
                 fprintf(stderr, "SHADER-DB: %s prog %d/%d: %d NIR instructions\n",
                         qir_get_stage_name(c->stage),
                         c->program_id, c->variant_id,
-                        count_nir_instrs(c->s));
+                        stats.instrs);
+                fprintf(stderr, "SHADER-DB: %s prog %d/%d: "
+                        "%d NIR ALU, %d NIR tex, %d NIR loops\n",
+                        qir_get_stage_name(c->stage),
+                        c->program_id, c->variant_id,
+                        stats.alu_instrs, stats.tex_instrs, stats.loops);
         }
 
         if (vc4_debug & VC4_DEBUG_NIR) {
@@ -1876,17 +1867,45 @@ vc4_shader_ntq(struct vc4_context *vc4, enum qstage stage,
         return c;
 }
 
+/**
+ * Creates the CSO for a shader.
+ *
+ * Identical shaders created by different contexts share a single CSO (and
+ * thus the compiled variants in the screen's caches), so that each context
+ * doesn't have to compile them again.
+ */
 static void *
 vc4_shader_state_create(struct pipe_context *pctx,
                         const struct pipe_shader_state *cso)
 {
-        struct vc4_context *vc4 = vc4_context(pctx);
-        struct vc4_uncompiled_shader *so = CALLOC_STRUCT(vc4_uncompiled_shader);
-        if (!so)
+        struct vc4_screen *screen = vc4_screen(pctx->screen);
+        struct vc4_uncompiled_shader *so;
+
+        pipe_mutex_lock(screen->shader_cache_lock);
+
+        struct hash_entry *entry =
+                _mesa_hash_table_search(screen->uncompiled_shaders,
+                                        cso->tokens);
+        if (entry) {
+                so = entry->data;
+                so->refcount++;
+                pipe_mutex_unlock(screen->shader_cache_lock);
+                return so;
+        }
+
+        so = CALLOC_STRUCT(vc4_uncompiled_shader);
+        if (!so) {
+                pipe_mutex_unlock(screen->shader_cache_lock);
                 return NULL;
+        }
 
         so->base.tokens = tgsi_dup_tokens(cso->tokens);
-        so->program_id = vc4->next_uncompiled_program_id++;
+        so->program_id = screen->next_uncompiled_program_id++;
+        so->refcount = 1;
+        _mesa_hash_table_insert(screen->uncompiled_shaders,
+                                so->base.tokens, so);
+
+        pipe_mutex_unlock(screen->shader_cache_lock);
 
         return so;
 }
@@ -1910,29 +1929,229 @@ copy_uniform_state_to_shader(struct vc4_compiled_shader *shader,
         vc4_set_shader_uniform_dirty_flags(shader);
 }
 
+/**
+ * Layout of a compiled shader in the on-disk cache.  The header is followed
+ * by the QPU instructions, the uniform data and contents, the UBO ranges and
+ * (for fragment shaders) the input slots.
+ */
+struct vc4_disk_shader {
+        uint32_t qpu_inst_count;
+        uint32_t uniform_count;
+        uint32_t num_texture_samples;
+        uint32_t num_ubo_ranges;
+        uint32_t ubo_size;
+        uint32_t color_inputs;
+        uint8_t num_inputs;
+        uint8_t vattr_offsets[9];
+        uint8_t vattrs_live;
+};
+
+/**
+ * Computes the on-disk cache key of a shader variant.
+ *
+ * The uncompiled shader and the FS a VS is compiled against are referenced
+ * by pointer and runtime ID in the variant key, which mean nothing to
+ * another process, so what they stand for is hashed instead.
+ *
+ * Returns false if the disk cache can't be used.
+ */
+static bool
+vc4_disk_cache_key(struct vc4_context *vc4, enum qstage stage,
+                   const struct vc4_key *key, uint32_t key_size,
+                   cache_key disk_key)
+{
+#if defined(HAVE_SHA1)
+        static const char build_id[] = "vc4 " PACKAGE_VERSION;
+        const struct tgsi_token *tokens = key->shader_state->base.tokens;
+        union {
+                struct vc4_fs_key fs;
+                struct vc4_vs_key vs;
+        } stable_key;
+        struct mesa_sha1 *ctx;
+
+        /* Dumps and shader-db stats come from compiling the shader. */
+        if (!vc4->screen->disk_shader_cache ||
+            (vc4_debug & (VC4_DEBUG_SHADERDB | VC4_DEBUG_QIR |
+                          VC4_DEBUG_QPU | VC4_DEBUG_TGSI | VC4_DEBUG_NIR)))
+                return false;
+
+        memcpy(&stable_key, key, key_size);
+        stable_key.fs.base.shader_state = NULL;
+        if (stage != QSTAGE_FRAG)
+                stable_key.vs.compiled_fs_id = 0;
+
+        ctx = _mesa_sha1_init();
+        if (!ctx)
+                return false;
+
+        _mesa_sha1_update(ctx, build_id, sizeof(build_id));
+        _mesa_sha1_update(ctx, &stage, sizeof(stage));
+        _mesa_sha1_update(ctx, tokens,
+                          tgsi_num_tokens(tokens) * sizeof(*tokens));
+        _mesa_sha1_update(ctx, &stable_key, key_size);
+        if (stage != QSTAGE_FRAG) {
+                _mesa_sha1_update(ctx, vc4->prog.fs->input_slots,
+                                  vc4->prog.fs->num_inputs *
+                                  sizeof(*vc4->prog.fs->input_slots));
+        }
+        return _mesa_sha1_final(ctx, disk_key);
+#else
+        return false;
+#endif
+}
+
+static void
+vc4_disk_cache_put(struct vc4_screen *screen, const cache_key disk_key,
+                   enum qstage stage, struct vc4_compiled_shader *shader,
+                   const uint64_t *qpu_insts, uint32_t qpu_inst_count)
+{
+        struct vc4_shader_uniform_info *uinfo = &shader->uniforms;
+        struct vc4_disk_shader header;
+        size_t size = (sizeof(header) +
+                       qpu_inst_count * sizeof(uint64_t) +
+                       uinfo->count * (sizeof(uint32_t) * 2) +
+                       shader->num_ubo_ranges * sizeof(struct vc4_ubo_range) +
+                       (stage == QSTAGE_FRAG ?
+                        shader->num_inputs * sizeof(struct vc4_varying_slot) :
+                        0));
+        uint8_t *data = malloc(size);
+        uint8_t *p = data;
+
+        if (!data)
+                return;
+
+        memset(&header, 0, sizeof(header));
+        header.qpu_inst_count = qpu_inst_count;
+        header.uniform_count = uinfo->count;
+        header.num_texture_samples = uinfo->num_texture_samples;
+        header.num_ubo_ranges = shader->num_ubo_ranges;
+        header.ubo_size = shader->ubo_size;
+        header.color_inputs = shader->color_inputs;
+        header.num_inputs = shader->num_inputs;
+        memcpy(header.vattr_offsets, shader->vattr_offsets,
+               sizeof(header.vattr_offsets));
+        header.vattrs_live = shader->vattrs_live;
+
+        memcpy(p, &header, sizeof(header));
+        p += sizeof(header);
+        memcpy(p, qpu_insts, qpu_inst_count * sizeof(uint64_t));
+        p += qpu_inst_count * sizeof(uint64_t);
+        memcpy(p, uinfo->data, uinfo->count * sizeof(uint32_t));
+        p += uinfo->count * sizeof(uint32_t);
+        for (int i = 0; i < uinfo->count; i++) {
+                uint32_t contents = uinfo->contents[i];
+                memcpy(p, &contents, sizeof(contents));
+                p += sizeof(contents);
+        }
+        memcpy(p, shader->ubo_ranges,
+               shader->num_ubo_ranges * sizeof(struct vc4_ubo_range));
+        p += shader->num_ubo_ranges * sizeof(struct vc4_ubo_range);
+        if (stage == QSTAGE_FRAG) {
+                memcpy(p, shader->input_slots,
+                       shader->num_inputs * sizeof(struct vc4_varying_slot));
+                p += shader->num_inputs * sizeof(struct vc4_varying_slot);
+        }
+        assert(p == data + size);
+
+        disk_cache_put(screen->disk_shader_cache, disk_key, data, size);
+        free(data);
+}
+
+/**
+ * Recreates a compiled shader from the on-disk cache, or returns NULL if it
+ * isn't there.
+ */
 static struct vc4_compiled_shader *
-vc4_get_compiled_shader(struct vc4_context *vc4, enum qstage stage,
-                        struct vc4_key *key)
+vc4_disk_cache_get(struct vc4_screen *screen, const cache_key disk_key,
+                   enum qstage stage)
 {
-        struct hash_table *ht;
-        uint32_t key_size;
+        struct vc4_disk_shader header;
+        size_t size;
+        uint8_t *data = disk_cache_get(screen->disk_shader_cache, disk_key,
+                                       &size);
+        uint8_t *p = data;
+
+        if (!data)
+                return NULL;
+
+        if (size < sizeof(header))
+                goto fail;
+        memcpy(&header, p, sizeof(header));
+        p += sizeof(header);
+
+        if (size != (sizeof(header) +
+                     header.qpu_inst_count * sizeof(uint64_t) +
+                     header.uniform_count * (sizeof(uint32_t) * 2) +
+                     header.num_ubo_ranges * sizeof(struct vc4_ubo_range) +
+                     (stage == QSTAGE_FRAG ?
+                      header.num_inputs * sizeof(struct vc4_varying_slot) :
+                      0)))
+                goto fail;
+
+        struct vc4_compiled_shader *shader =
+                rzalloc(NULL, struct vc4_compiled_shader);
+        struct vc4_shader_uniform_info *uinfo = &shader->uniforms;
+
+        shader->bo = vc4_bo_alloc_shader(screen, p,
+                                         header.qpu_inst_count *
+                                         sizeof(uint64_t));
+        p += header.qpu_inst_count * sizeof(uint64_t);
+
+        uinfo->count = header.uniform_count;
+        uinfo->num_texture_samples = header.num_texture_samples;
+        uinfo->data = ralloc_array(shader, uint32_t, uinfo->count);
+        memcpy(uinfo->data, p, uinfo->count * sizeof(uint32_t));
+        p += uinfo->count * sizeof(uint32_t);
+        uinfo->contents = ralloc_array(shader, enum quniform_contents,
+                                       uinfo->count);
+        for (int i = 0; i < uinfo->count; i++) {
+                uint32_t contents;
+                memcpy(&contents, p, sizeof(contents));
+                uinfo->contents[i] = contents;
+                p += sizeof(contents);
+        }
+        vc4_set_shader_uniform_dirty_flags(shader);
+
+        shader->num_ubo_ranges = header.num_ubo_ranges;
+        shader->ubo_size = header.ubo_size;
+        if (shader->num_ubo_ranges) {
+                shader->ubo_ranges = ralloc_array(shader, struct vc4_ubo_range,
+                                                  shader->num_ubo_ranges);
+                memcpy(shader->ubo_ranges, p,
+                       shader->num_ubo_ranges * sizeof(struct vc4_ubo_range));
+                p += shader->num_ubo_ranges * sizeof(struct vc4_ubo_range);
+        }
+
+        shader->color_inputs = header.color_inputs;
+        shader->num_inputs = header.num_inputs;
+        memcpy(shader->vattr_offsets, header.vattr_offsets,
+               sizeof(shader->vattr_offsets));
+        shader->vattrs_live = header.vattrs_live;
         if (stage == QSTAGE_FRAG) {
-                ht = vc4->fs_cache;
-                key_size = sizeof(struct vc4_fs_key);
-        } else {
-                ht = vc4->vs_cache;
-                key_size = sizeof(struct vc4_vs_key);
+                shader->input_slots = ralloc_array(shader,
+                                                   struct vc4_varying_slot,
+                                                   shader->num_inputs);
+                memcpy(shader->input_slots, p,
+                       shader->num_inputs * sizeof(struct vc4_varying_slot));
         }
 
-        struct vc4_compiled_shader *shader;
-        struct hash_entry *entry = _mesa_hash_table_search(ht, key);
-        if (entry)
-                return entry->data;
+        free(data);
+        return shader;
+
+fail:
+        free(data);
+        return NULL;
+}
 
+static struct vc4_compiled_shader *
+vc4_compile_shader(struct vc4_context *vc4, enum qstage stage,
+                   struct vc4_key *key, bool use_disk_cache,
+                   const cache_key disk_key)
+{
+        struct vc4_compiled_shader *shader;
         struct vc4_compile *c = vc4_shader_ntq(vc4, stage, key);
         shader = rzalloc(NULL, struct vc4_compiled_shader);
 
-        shader->program_id = vc4->next_compiled_program_id++;
         if (stage == QSTAGE_FRAG) {
                 bool input_live[c->num_input_slots];
 
@@ -2018,13 +2237,67 @@ vc4_get_compiled_shader(struct vc4_context *vc4, enum qstage stage,
                 }
         }
 
+        if (use_disk_cache) {
+                vc4_disk_cache_put(vc4->screen, disk_key, stage, shader,
+                                   c->qpu_insts, c->qpu_inst_count);
+        }
+
         qir_compile_destroy(c);
 
+        return shader;
+}
+
+/**
+ * Returns the variant of the shader for the given key, out of the screen's
+ * caches (shared by all contexts) or the disk cache if possible.
+ */
+static struct vc4_compiled_shader *
+vc4_get_compiled_shader(struct vc4_context *vc4, enum qstage stage,
+                        struct vc4_key *key)
+{
+        struct vc4_screen *screen = vc4->screen;
+        struct hash_table *ht;
+        uint32_t key_size;
+        if (stage == QSTAGE_FRAG) {
+                ht = screen->fs_cache;
+                key_size = sizeof(struct vc4_fs_key);
+        } else {
+                ht = screen->vs_cache;
+                key_size = sizeof(struct vc4_vs_key);
+        }
+
+        /* The lock is held over the compile as well, so that contexts
+         * racing to compile the same variant do it only once.
+         */
+        pipe_mutex_lock(screen->shader_cache_lock);
+
+        struct vc4_compiled_shader *shader;
+        struct hash_entry *entry = _mesa_hash_table_search(ht, key);
+        if (entry) {
+                pipe_mutex_unlock(screen->shader_cache_lock);
+                return entry->data;
+        }
+
+        cache_key disk_key;
+        bool use_disk_cache = vc4_disk_cache_key(vc4, stage, key, key_size,
+                                                 disk_key);
+
+        shader = NULL;
+        if (use_disk_cache)
+                shader = vc4_disk_cache_get(screen, disk_key, stage);
+        if (!shader) {
+                shader = vc4_compile_shader(vc4, stage, key, use_disk_cache,
+                                            disk_key);
+        }
+        shader->program_id = screen->next_compiled_program_id++;
+
         struct vc4_key *dup_key;
         dup_key = ralloc_size(shader, key_size);
         memcpy(dup_key, key, key_size);
         _mesa_hash_table_insert(ht, dup_key, shader);
 
+        pipe_mutex_unlock(screen->shader_cache_lock);
+
         return shader;
 }
 
@@ -2180,6 +2453,25 @@ vc4_update_compiled_shaders(struct vc4_context *vc4, uint8_t prim_mode)
         vc4_update_compiled_vs(vc4, prim_mode);
 }
 
+static uint32_t
+uncompiled_shader_hash(const void *key)
+{
+        const struct tgsi_token *tokens = key;
+        return _mesa_hash_data(tokens,
+                               tgsi_num_tokens(tokens) * sizeof(*tokens));
+}
+
+static bool
+uncompiled_shader_compare(const void *key1, const void *key2)
+{
+        const struct tgsi_token *tokens1 = key1, *tokens2 = key2;
+        unsigned num_tokens = tgsi_num_tokens(tokens1);
+
+        return (tgsi_num_tokens(tokens2) == num_tokens &&
+                memcmp(tokens1, tokens2,
+                       num_tokens * sizeof(*tokens1)) == 0);
+}
+
 static uint32_t
 fs_cache_hash(const void *key)
 {
@@ -2222,14 +2514,28 @@ delete_from_cache_if_matches(struct hash_table *ht,
 static void
 vc4_shader_state_delete(struct pipe_context *pctx, void *hwcso)
 {
-        struct vc4_context *vc4 = vc4_context(pctx);
+        struct vc4_screen *screen = vc4_screen(pctx->screen);
         struct vc4_uncompiled_shader *so = hwcso;
 
-        struct hash_entry *entry;
-        hash_table_foreach(vc4->fs_cache, entry)
-                delete_from_cache_if_matches(vc4->fs_cache, entry, so);
-        hash_table_foreach(vc4->vs_cache, entry)
-                delete_from_cache_if_matches(vc4->vs_cache, entry, so);
+        pipe_mutex_lock(screen->shader_cache_lock);
+
+        if (--so->refcount) {
+                pipe_mutex_unlock(screen->shader_cache_lock);
+                return;
+        }
+
+        struct hash_entry *entry =
+                _mesa_hash_table_search(screen->uncompiled_shaders,
+                                        so->base.tokens);
+        if (entry)
+                _mesa_hash_table_remove(screen->uncompiled_shaders, entry);
+
+        hash_table_foreach(screen->fs_cache, entry)
+                delete_from_cache_if_matches(screen->fs_cache, entry, so);
+        hash_table_foreach(screen->vs_cache, entry)
+                delete_from_cache_if_matches(screen->vs_cache, entry, so);
+
+        pipe_mutex_unlock(screen->shader_cache_lock);
 
         free((void *)so->base.tokens);
         free(so);
@@ -2254,8 +2560,6 @@ vc4_vp_state_bind(struct pipe_context *pctx, void *hwcso)
 void
 vc4_program_init(struct pipe_context *pctx)
 {
-        struct vc4_context *vc4 = vc4_context(pctx);
-
         pctx->create_vs_state = vc4_shader_state_create;
         pctx->delete_vs_state = vc4_shader_state_delete;
 
@@ -2264,30 +2568,45 @@ vc4_program_init(struct pipe_context *pctx)
 
         pctx->bind_fs_state = vc4_fp_state_bind;
         pctx->bind_vs_state = vc4_vp_state_bind;
+}
+
+void
+vc4_program_screen_init(struct pipe_screen *pscreen)
+{
+        struct vc4_screen *screen = vc4_screen(pscreen);
 
-        vc4->fs_cache = _mesa_hash_table_create(pctx, fs_cache_hash,
-                                                fs_cache_compare);
-        vc4->vs_cache = _mesa_hash_table_create(pctx, vs_cache_hash,
-                                                vs_cache_compare);
+        pipe_mutex_init(screen->shader_cache_lock);
+        screen->uncompiled_shaders =
+                _mesa_hash_table_create(screen, uncompiled_shader_hash,
+                                        uncompiled_shader_compare);
+        screen->fs_cache = _mesa_hash_table_create(screen, fs_cache_hash,
+                                                   fs_cache_compare);
+        screen->vs_cache = _mesa_hash_table_create(screen, vs_cache_hash,
+                                                   vs_cache_compare);
+        screen->disk_shader_cache = disk_cache_create();
 }
 
 void
-vc4_program_fini(struct pipe_context *pctx)
+vc4_program_screen_fini(struct pipe_screen *pscreen)
 {
-        struct vc4_context *vc4 = vc4_context(pctx);
+        struct vc4_screen *screen = vc4_screen(pscreen);
 
         struct hash_entry *entry;
-        hash_table_foreach(vc4->fs_cache, entry) {
+        hash_table_foreach(screen->fs_cache, entry) {
                 struct vc4_compiled_shader *shader = entry->data;
                 vc4_bo_unreference(&shader->bo);
                 ralloc_free(shader);
-                _mesa_hash_table_remove(vc4->fs_cache, entry);
+                _mesa_hash_table_remove(screen->fs_cache, entry);
         }
 
-        hash_table_foreach(vc4->vs_cache, entry) {
+        hash_table_foreach(screen->vs_cache, entry) {
                 struct vc4_compiled_shader *shader = entry->data;
                 vc4_bo_unreference(&shader->bo);
                 ralloc_free(shader);
-                _mesa_hash_table_remove(vc4->vs_cache, entry);
+                _mesa_hash_table_remove(screen->vs_cache, entry);
         }
+
+        if (screen->disk_shader_cache)
+                disk_cache_destroy(screen->disk_shader_cache);
+        pipe_mutex_destroy(screen->shader_cache_lock);
 }
@@ -476,7 +476,18 @@ latency_between(struct schedule_node *before, struct schedule_node *after)
             after->inst->op == QOP_TEX_RESULT)
                 return 100;
 
-        return 1;
+        /* SFU results show up in r4 two instructions after the write, so
+         * try to fill those slots with other work rather than NOPs.
+         */
+        switch (before->inst->op) {
+        case QOP_RCP:
+        case QOP_RSQ:
+        case QOP_EXP2:
+        case QOP_LOG2:
+                return 3;
+        default:
+                return 1;
+        }
 }
 
 /** Recursive computation of the delay member of a node. */
@@ -437,6 +437,7 @@ calculate_reverse_deps(struct vc4_compile *c, struct list_head *schedule_list)
 
 struct choose_scoreboard {
         int tick;
+        uint32_t time;
         int last_sfu_write_tick;
         uint32_t last_waddr_a, last_waddr_b;
 };
@@ -570,6 +571,20 @@ choose_instruction_to_schedule(struct choose_scoreboard *scoreboard,
                         continue;
                 }
 
+                /* Prefer instructions whose inputs should have landed by now
+                 * over ones that would still be waiting on the latency of
+                 * their parents (texture fetches, SFU ops, regfile writes).
+                 */
+                bool ready = n->unblocked_time <= scoreboard->time;
+                bool chosen_ready = chosen->unblocked_time <= scoreboard->time;
+                if (ready && !chosen_ready) {
+                        chosen = n;
+                        chosen_prio = prio;
+                        continue;
+                } else if (!ready && chosen_ready) {
+                        continue;
+                }
+
                 if (n->delay > chosen->delay) {
                         chosen = n;
                         chosen_prio = prio;
@@ -756,6 +771,8 @@ schedule_instructions(struct vc4_compile *c, struct list_head *schedule_list)
         }
 
         while (!list_empty(schedule_list)) {
+                scoreboard.time = time;
+
                 struct schedule_node *chosen =
                         choose_instruction_to_schedule(&scoreboard,
                                                        schedule_list,
@@ -781,6 +798,7 @@ schedule_instructions(struct vc4_compile *c, struct list_head *schedule_list)
                  */
                 if (chosen) {
                         time = MAX2(chosen->unblocked_time, time);
+                        scoreboard.time = time;
                         list_del(&chosen->link);
                         mark_instruction_scheduled(schedule_list, time,
                                                    chosen, true);
@@ -82,6 +82,7 @@ vc4_screen_get_vendor(struct pipe_screen *pscreen)
 static void
 vc4_screen_destroy(struct pipe_screen *pscreen)
 {
+        vc4_program_screen_fini(pscreen);
         vc4_bufmgr_destroy(pscreen);
         ralloc_free(pscreen);
 }
@@ -189,6 +190,8 @@ vc4_screen_get_param(struct pipe_screen *pscreen, enum pipe_cap param)
 	case PIPE_CAP_SHAREABLE_SHADERS:
 	case PIPE_CAP_COPY_BETWEEN_COMPRESSED_AND_PLAIN_FORMATS:
 	case PIPE_CAP_CLEAR_TEXTURE:
+	case PIPE_CAP_QUERY_BUFFER_OBJECT:
+	case PIPE_CAP_SPARSE_BUFFER_PAGE_SIZE:
                 return 0;
 
                 /* Stream output. */
@@ -489,6 +492,7 @@ vc4_screen_create(int fd)
 #endif
 
         vc4_resource_screen_init(pscreen);
+        vc4_program_screen_init(pscreen);
 
         pscreen->get_name = vc4_screen_get_name;
         pscreen->get_vendor = vc4_screen_get_vendor;
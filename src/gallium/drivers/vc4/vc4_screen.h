@@ -75,6 +75,18 @@ struct vc4_screen {
 
         uint32_t bo_size;
         uint32_t bo_count;
+
+        /** @{
+         * Shader CSOs and their compiled variants, shared by all contexts
+         * so that identical shaders are only compiled once.
+         */
+        pipe_mutex shader_cache_lock;
+        struct hash_table *uncompiled_shaders;
+        struct hash_table *fs_cache, *vs_cache;
+        uint32_t next_uncompiled_program_id;
+        uint64_t next_compiled_program_id;
+        struct disk_cache *disk_shader_cache;
+        /** @} */
 };
 
 static inline struct vc4_screen *
@@ -27,6 +27,7 @@
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_helpers.h"
+#include "util/u_framebuffer.h"
 
 #include "vc4_context.h"
 
@@ -409,6 +410,14 @@ vc4_set_framebuffer_state(struct pipe_context *pctx,
         struct pipe_framebuffer_state *cso = &vc4->framebuffer;
         unsigned i;
 
+        /* Rebinding the same framebuffer (common around blits and with
+         * state trackers that set it every frame) can keep rendering into
+         * the current job, instead of storing all of its tiles out and
+         * loading them back in.
+         */
+        if (util_framebuffer_state_equal(cso, framebuffer))
+                return;
+
         vc4_flush(pctx);
 
         for (i = 0; i < framebuffer->nr_cbufs; i++)
@@ -52,6 +52,11 @@
 #include "vc4_context.h"
 #include "vc4_tiling.h"
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define VC4_TILING_USE_NEON 1
+#endif
+
 /** Return the width in pixels of a 64-byte microtile. */
 uint32_t
 vc4_utile_width(int cpp)
@@ -98,30 +103,98 @@ vc4_size_is_lt(uint32_t width, uint32_t height, int cpp)
                 height <= 4 * vc4_utile_height(cpp));
 }
 
+/**
+ * Copies a 64-byte utile of @cpp out to a raster image.  Utiles are always
+ * either 8 rows of 8 bytes (cpp == 1) or 4 rows of 16 bytes, so the row size
+ * is made a compile-time constant for each case, letting the compiler turn
+ * the copies into plain (or NEON) loads and stores instead of memcpy calls.
+ */
 void
 vc4_load_utile(void *dst, void *src, uint32_t dst_stride, uint32_t cpp)
 {
-        uint32_t utile_h = vc4_utile_height(cpp);
-        uint32_t row_size = 64 / utile_h;
+#ifdef VC4_TILING_USE_NEON
+        uint8x16_t q0 = vld1q_u8(src);
+        uint8x16_t q1 = vld1q_u8(src + 16);
+        uint8x16_t q2 = vld1q_u8(src + 32);
+        uint8x16_t q3 = vld1q_u8(src + 48);
 
-        for (int y = 0; y < utile_h; y++) {
-                memcpy(dst, src, row_size);
-                dst += dst_stride;
-                src += row_size;
+        if (cpp == 1) {
+                vst1_u8(dst + 0 * dst_stride, vget_low_u8(q0));
+                vst1_u8(dst + 1 * dst_stride, vget_high_u8(q0));
+                vst1_u8(dst + 2 * dst_stride, vget_low_u8(q1));
+                vst1_u8(dst + 3 * dst_stride, vget_high_u8(q1));
+                vst1_u8(dst + 4 * dst_stride, vget_low_u8(q2));
+                vst1_u8(dst + 5 * dst_stride, vget_high_u8(q2));
+                vst1_u8(dst + 6 * dst_stride, vget_low_u8(q3));
+                vst1_u8(dst + 7 * dst_stride, vget_high_u8(q3));
+        } else {
+                vst1q_u8(dst + 0 * dst_stride, q0);
+                vst1q_u8(dst + 1 * dst_stride, q1);
+                vst1q_u8(dst + 2 * dst_stride, q2);
+                vst1q_u8(dst + 3 * dst_stride, q3);
         }
+#else
+        if (cpp == 1) {
+                for (int y = 0; y < 8; y++) {
+                        memcpy(dst, src, 8);
+                        dst += dst_stride;
+                        src += 8;
+                }
+        } else {
+                for (int y = 0; y < 4; y++) {
+                        memcpy(dst, src, 16);
+                        dst += dst_stride;
+                        src += 16;
+                }
+        }
+#endif
 }
 
+/**
+ * Copies a 64-byte utile of @cpp in from a raster image.  See
+ * vc4_load_utile().
+ */
 void
 vc4_store_utile(void *dst, void *src, uint32_t src_stride, uint32_t cpp)
 {
-        uint32_t utile_h = vc4_utile_height(cpp);
-        uint32_t row_size = 64 / utile_h;
+#ifdef VC4_TILING_USE_NEON
+        uint8x16_t q0, q1, q2, q3;
+
+        if (cpp == 1) {
+                q0 = vcombine_u8(vld1_u8(src + 0 * src_stride),
+                                 vld1_u8(src + 1 * src_stride));
+                q1 = vcombine_u8(vld1_u8(src + 2 * src_stride),
+                                 vld1_u8(src + 3 * src_stride));
+                q2 = vcombine_u8(vld1_u8(src + 4 * src_stride),
+                                 vld1_u8(src + 5 * src_stride));
+                q3 = vcombine_u8(vld1_u8(src + 6 * src_stride),
+                                 vld1_u8(src + 7 * src_stride));
+        } else {
+                q0 = vld1q_u8(src + 0 * src_stride);
+                q1 = vld1q_u8(src + 1 * src_stride);
+                q2 = vld1q_u8(src + 2 * src_stride);
+                q3 = vld1q_u8(src + 3 * src_stride);
+        }
 
-        for (int y = 0; y < utile_h; y++) {
-                memcpy(dst, src, row_size);
-                dst += row_size;
-                src += src_stride;
+        vst1q_u8(dst, q0);
+        vst1q_u8(dst + 16, q1);
+        vst1q_u8(dst + 32, q2);
+        vst1q_u8(dst + 48, q3);
+#else
+        if (cpp == 1) {
+                for (int y = 0; y < 8; y++) {
+                        memcpy(dst, src, 8);
+                        dst += 8;
+                        src += src_stride;
+                }
+        } else {
+                for (int y = 0; y < 4; y++) {
+                        memcpy(dst, src, 16);
+                        dst += 16;
+                        src += src_stride;
+                }
         }
+#endif
 }
 
 static void
@@ -24,9 +24,15 @@
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
 #include "virgl_context.h"
+#include "virgl_encode.h"
 #include "virgl_resource.h"
 #include "virgl_screen.h"
 
+/* Writes up to this size are sent inline in the command stream instead of
+ * with a separate transfer to the host.
+ */
+#define VIRGL_INLINE_WRITE_THRESHOLD 4096
+
 static void virgl_buffer_destroy(struct pipe_screen *screen,
                                  struct pipe_resource *buf)
 {
@@ -107,6 +113,20 @@ static void virgl_buffer_transfer_unmap(struct pipe_context *ctx,
       if (!(transfer->usage & PIPE_TRANSFER_FLUSH_EXPLICIT)) {
          struct virgl_screen *vs = virgl_screen(ctx->screen);
          vbuf->base.clean = FALSE;
+
+         /* small uploads (typically streamed vertex/index data) go along with
+          * the command stream, saving a round trip to the host each */
+         if (transfer->box.width <= VIRGL_INLINE_WRITE_THRESHOLD) {
+            uint8_t *ptr = vs->vws->resource_map(vs->vws, vbuf->base.hw_res);
+            if (ptr) {
+               virgl_encoder_inline_write(vctx, &vbuf->base, transfer->level,
+                                          trans->base.usage, &transfer->box,
+                                          ptr + trans->offset, 0, 0);
+               util_slab_free(&vctx->texture_transfer_pool, trans);
+               return;
+            }
+         }
+
          vctx->num_transfers++;
          vs->vws->transfer_put(vs->vws, vbuf->base.hw_res,
                                &transfer->box, trans->base.stride, trans->base.layer_stride, trans->offset, transfer->level);
@@ -252,6 +252,9 @@ static void virgl_bind_blend_state(struct pipe_context *ctx,
 {
    struct virgl_context *vctx = virgl_context(ctx);
    uint32_t handle = (unsigned long)blend_state;
+   if (vctx->blend_handle == handle)
+      return;
+   vctx->blend_handle = handle;
    virgl_encode_bind_object(vctx, handle, VIRGL_OBJECT_BLEND);
 }
 
@@ -279,6 +282,9 @@ static void virgl_bind_depth_stencil_alpha_state(struct pipe_context *ctx,
 {
    struct virgl_context *vctx = virgl_context(ctx);
    uint32_t handle = (unsigned long)blend_state;
+   if (vctx->dsa_handle == handle)
+      return;
+   vctx->dsa_handle = handle;
    virgl_encode_bind_object(vctx, handle, VIRGL_OBJECT_DSA);
 }
 
@@ -307,6 +313,9 @@ static void virgl_bind_rasterizer_state(struct pipe_context *ctx,
    struct virgl_context *vctx = virgl_context(ctx);
    uint32_t handle = (unsigned long)rs_state;
 
+   if (vctx->rs_handle == handle)
+      return;
+   vctx->rs_handle = handle;
    virgl_encode_bind_object(vctx, handle, VIRGL_OBJECT_RASTERIZER);
 }
 
@@ -363,6 +372,9 @@ static void virgl_bind_vertex_elements_state(struct pipe_context *ctx,
 {
    struct virgl_context *vctx = virgl_context(ctx);
    uint32_t handle = (unsigned long)ve;
+   if (vctx->ve_handle == handle)
+      return;
+   vctx->ve_handle = handle;
    virgl_encode_bind_object(vctx, handle, VIRGL_OBJECT_VERTEX_ELEMENTS);
 }
 
@@ -69,6 +69,13 @@ struct virgl_context {
    unsigned num_so_targets;
 
    struct pipe_resource *ubos[PIPE_SHADER_TYPES][PIPE_MAX_CONSTANT_BUFFERS];
+
+   /* currently bound state objects, to skip redundant binds */
+   uint32_t blend_handle;
+   uint32_t dsa_handle;
+   uint32_t rs_handle;
+   uint32_t ve_handle;
+
    int num_transfers;
    int num_draws;
    struct list_head to_flush_bufs;
@@ -95,6 +95,13 @@ struct pipe_context {
    /*@{*/
    void (*draw_vbo)( struct pipe_context *pipe,
                      const struct pipe_draw_info *info );
+
+   /**
+    * Same as calling draw_vbo for each of the num_draws draws.  Optional.
+    */
+   void (*draw_vbo_multi)( struct pipe_context *pipe,
+                           const struct pipe_draw_info *info,
+                           unsigned num_draws );
    /*@}*/
 
    /**
@@ -150,6 +157,27 @@ struct pipe_context {
                                struct pipe_query *q,
                                boolean wait,
                                union pipe_query_result *result);
+
+   /**
+    * Get results of a query, storing into resource. Note that this may not
+    * be used with batch queries.
+    *
+    * \param wait  if true, this query will block until the result is ready
+    * \param result_type  the type of the value being stored
+    * \param index  for queries that return multiple pieces of data, which
+    *               item of that data to store (e.g. for
+    *               PIPE_QUERY_PIPELINE_STATISTICS).
+    *               When the index is -1, instead of the value of the query
+    *               the driver should instead write a 1 or 0 to the appropriate
+    *               location with 1 meaning that the query result is available.
+    */
+   void (*get_query_result_resource)(struct pipe_context *pipe,
+                                     struct pipe_query *q,
+                                     boolean wait,
+                                     enum pipe_query_value_type result_type,
+                                     int index,
+                                     struct pipe_resource *resource,
+                                     unsigned offset);
    /*@}*/
 
    /**
@@ -658,6 +686,24 @@ struct pipe_context {
    void (*invalidate_resource)(struct pipe_context *ctx,
                                struct pipe_resource *resource);
 
+   /**
+    * Commit or decommit the memory backing a region of a sparse resource
+    * (one created with PIPE_RESOURCE_FLAG_SPARSE).
+    *
+    * For buffers, the box must be aligned to the page size returned by
+    * PIPE_CAP_SPARSE_BUFFER_PAGE_SIZE, except that it may end at the end
+    * of the buffer.  Contents of newly committed pages are undefined.
+    *
+    * \param level   the mipmap level, 0 for buffers
+    * \param box     the region to commit or decommit
+    * \param commit  whether to commit or decommit the region
+    * \return FALSE if committing failed because of insufficient memory
+    */
+   boolean (*resource_commit)(struct pipe_context *ctx,
+                              struct pipe_resource *resource,
+                              unsigned level, struct pipe_box *box,
+                              boolean commit);
+
    /**
     * Return information about unexpected device resets.
     */
@@ -69,10 +69,16 @@ command_queue::flush() {
    if (!queued_events.empty()) {
       pipe->flush(pipe, &fence, 0);
 
-      while (!queued_events.empty() &&
-             queued_events.front()().signalled()) {
-         queued_events.front()().fence(fence);
-         queued_events.pop_front();
+      // Events of an out-of-order queue may be signalled in any
+      // order, fence all the ones submitted so far and keep the rest
+      // queued.
+      for (auto it = queued_events.begin(); it != queued_events.end();) {
+         if ((*it)().signalled()) {
+            (*it)().fence(fence);
+            it = queued_events.erase(it);
+         } else {
+            ++it;
+         }
       }
 
       screen->fence_reference(screen, &fence, NULL);
@@ -89,11 +95,37 @@ command_queue::profiling_enabled() const {
    return props & CL_QUEUE_PROFILING_ENABLE;
 }
 
+bool
+command_queue::out_of_order() const {
+   return props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+}
+
 void
 command_queue::sequence(hard_event &ev) {
    std::lock_guard<std::mutex> lock(queued_events_mutex);
-   if (!queued_events.empty())
-      queued_events.back()().chain(ev);
+
+   if (!out_of_order()) {
+      if (!queued_events.empty())
+         queued_events.back()().chain(ev);
+
+   } else if ((ev.command() == CL_COMMAND_MARKER ||
+               ev.command() == CL_COMMAND_BARRIER) && ev.deps.empty()) {
+      // A marker or barrier without a wait list waits for all the
+      // previously enqueued commands.
+      for (hard_event &qev : queued_events)
+         qev.chain(ev);
+
+   } else {
+      // Other commands only depend on their wait list and on the
+      // last barrier still pending.
+      for (auto it = queued_events.rbegin();
+           it != queued_events.rend(); ++it) {
+         if ((*it)().command() == CL_COMMAND_BARRIER) {
+            (*it)().chain(ev);
+            break;
+         }
+      }
+   }
 
    queued_events.push_back(ev);
 }
@@ -150,6 +150,14 @@ root_resource::root_resource(clover::device &dev, memory_obj &obj,
 
    if (obj.flags() & (CL_MEM_ALLOC_HOST_PTR | CL_MEM_USE_HOST_PTR)) {
       info.usage = PIPE_USAGE_STAGING;
+
+      // Ask for host-visible coherent storage so the buffer can be
+      // mapped directly instead of through a staging copy.
+      if (info.target == PIPE_BUFFER &&
+          dev.pipe->get_param(dev.pipe,
+                              PIPE_CAP_BUFFER_MAP_PERSISTENT_COHERENT))
+         info.flags = (PIPE_RESOURCE_FLAG_MAP_PERSISTENT |
+                       PIPE_RESOURCE_FLAG_MAP_COHERENT);
    }
 
    pipe = dev.pipe->resource_create(dev.pipe, &info);
@@ -194,6 +202,14 @@ mapping::mapping(command_queue &q, resource &r,
                       PIPE_TRANSFER_DISCARD_RANGE : 0) |
                      (!blocking ? PIPE_TRANSFER_UNSYNCHRONIZED : 0));
 
+   // Invalidating the whole storage of a buffer lets the driver
+   // reallocate it rather than stall or copy through a staging area.
+   if ((flags & CL_MAP_WRITE_INVALIDATE_REGION) &&
+       r.pipe->target == PIPE_BUFFER &&
+       r.offset[0] == 0 && origin[0] == 0 &&
+       region[0] == r.pipe->width0)
+      usage |= PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE;
+
    p = pctx->transfer_map(pctx, r.pipe, 0, usage,
                           box(origin + r.offset, region), &pxfer);
    if (!p) {
@@ -68,6 +68,8 @@
 #include "pipe/p_state.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
+#include "util/disk_cache.h"
+#include "util/mesa-sha1.h"
 
 #include <iostream>
 #include <iomanip>
@@ -76,6 +78,7 @@
 #include <sstream>
 #include <libelf.h>
 #include <gelf.h>
+#include <sys/stat.h>
 
 using namespace clover;
 
@@ -832,6 +835,70 @@ namespace {
       return debug_flags;
    }
 
+   struct disk_cache *
+   get_disk_cache() {
+      static struct disk_cache *cache = disk_cache_create();
+      return cache;
+   }
+
+   ///
+   /// Compute the on-disk cache key of a program build.  Besides the
+   /// inputs of the build, the result depends on the compiler and on the
+   /// libclc library linked into the program.
+   ///
+   /// Returns false if the disk cache can't be used.
+   ///
+   bool
+   get_cache_key(cache_key key, const std::string &source,
+                 const header_map &headers, enum pipe_shader_ir ir,
+                 const std::string &processor, const std::string &triple,
+                 const std::string &opts) {
+#if defined(HAVE_SHA1)
+      static const char build_id[] = "clover " PACKAGE_VERSION;
+      const unsigned llvm_version = HAVE_LLVM * 100 + MESA_LLVM_VERSION_PATCH;
+      const std::string libclc_path = LIBCLC_LIBEXECDIR + processor + "-"
+                                                        + triple + ".bc";
+      struct stat libclc_stat = {};
+      struct mesa_sha1 *ctx;
+
+      // Keep dumping the intermediate results when asked to.
+      if (!get_disk_cache() || get_debug_flags())
+         return false;
+
+      ctx = _mesa_sha1_init();
+      if (!ctx)
+         return false;
+
+      auto update_string = [&](const std::string &str) {
+         const uint32_t size = str.size();
+         _mesa_sha1_update(ctx, &size, sizeof(size));
+         _mesa_sha1_update(ctx, str.data(), size);
+      };
+
+      stat(libclc_path.c_str(), &libclc_stat);
+
+      _mesa_sha1_update(ctx, build_id, sizeof(build_id));
+      _mesa_sha1_update(ctx, &llvm_version, sizeof(llvm_version));
+      _mesa_sha1_update(ctx, &libclc_stat.st_size,
+                        sizeof(libclc_stat.st_size));
+      _mesa_sha1_update(ctx, &libclc_stat.st_mtime,
+                        sizeof(libclc_stat.st_mtime));
+      _mesa_sha1_update(ctx, &ir, sizeof(ir));
+      update_string(processor);
+      update_string(triple);
+      update_string(opts);
+      update_string(source);
+      for (auto &header : headers) {
+         update_string(header.first);
+         update_string(header.second);
+      }
+
+      return _mesa_sha1_final(ctx, key);
+#else
+      return false;
+#endif
+   }
+
 } // End anonymous namespace
 
 module
@@ -851,6 +918,19 @@ clover::compile_program_llvm(const std::string &source,
    clang::LangAS::Map address_spaces;
    llvm::LLVMContext llvm_ctx;
    unsigned optimization_level;
+   cache_key key;
+   const bool use_disk_cache = get_cache_key(key, source, headers, ir,
+                                             processor, triple, opts);
+
+   if (use_disk_cache) {
+      size_t size;
+      if (char *data = static_cast<char *>(
+             disk_cache_get(get_disk_cache(), key, &size))) {
+         std::istringstream is(std::string(data, size));
+         free(data);
+         return module::deserialize(is);
+      }
+   }
 
    llvm_ctx.setDiagnosticHandler(diagnostic_handler, &r_log);
 
@@ -897,5 +977,12 @@ clover::compile_program_llvm(const std::string &source,
    delete mod;
 #endif
 
+   if (use_disk_cache) {
+      std::ostringstream os;
+      m.serialize(os);
+      const std::string data = os.str();
+      disk_cache_put(get_disk_cache(), key, data.data(), data.size());
+   }
+
    return m;
 }
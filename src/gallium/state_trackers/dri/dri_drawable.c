@@ -33,6 +33,7 @@
 #include "dri_context.h"
 #include "dri_drawable.h"
 
+#include "hud/hud_counters.h"
 #include "pipe/p_screen.h"
 #include "util/u_format.h"
 #include "util/u_memory.h"
@@ -350,6 +351,21 @@ swap_fences_push_back(struct dri_drawable *draw,
 }
 
 
+/**
+ * swap_fences_is_last - whether \p fence is the last one queued
+ *
+ * Drivers return the previous fence when a flush has nothing to submit, so
+ * this catches back-to-back flushes without any rendering in between.
+ */
+static boolean
+swap_fences_is_last(struct dri_drawable *draw,
+                    struct pipe_fence_handle *fence)
+{
+   return draw->cur_fences &&
+          draw->swap_fences[(draw->head - 1) & DRI_SWAP_FENCES_MASK] == fence;
+}
+
+
 /**
  * swap_fences_unref - empty the throttle queue
  *
@@ -510,29 +526,37 @@ dri_flush(__DRIcontext *cPriv,
         reason == __DRI2_THROTTLE_FLUSHFRONT)) {
       /* Throttle.
        *
-       * This pulls a fence off the throttling queue and waits for it if the
-       * number of fences on the throttling queue has reached the desired
-       * number.
+       * This flushes to insert a fence at the current rendering position.
+       * This requires that the st_context_iface flush method returns a fence
+       * even if there are no commands to flush.
+       *
+       * Then it pulls a fence off the throttling queue and waits for it if
+       * the number of fences on the throttling queue has reached the desired
+       * number, and pushes the new fence on the queue.  Waiting after the
+       * flush keeps the GPU busy while the CPU waits.
        *
-       * Then flushes to insert a fence at the current rendering position, and
-       * pushes that fence on the queue. This requires that the st_context_iface
-       * flush method returns a fence even if there are no commands to flush.
+       * If nothing was rendered since the last throttled flush, e.g. for
+       * back-to-back glFlush calls on the front buffer, the fence is the one
+       * queued last, and there is no new frame to throttle.
        */
       struct pipe_screen *screen = drawable->screen->base.screen;
-      struct pipe_fence_handle *fence;
-
-      fence = swap_fences_pop_front(drawable);
-      if (fence) {
-         (void) screen->fence_finish(screen, fence, PIPE_TIMEOUT_INFINITE);
-         screen->fence_reference(screen, &fence, NULL);
-      }
+      struct pipe_fence_handle *fence = NULL, *oldest;
 
       ctx->st->flush(ctx->st, flush_flags, &fence);
 
-      if (fence) {
+      if (fence && !swap_fences_is_last(drawable, fence)) {
+         oldest = swap_fences_pop_front(drawable);
+         if (oldest) {
+            int64_t start = hud_counter_begin_time();
+
+            (void) screen->fence_finish(screen, oldest, PIPE_TIMEOUT_INFINITE);
+            hud_counter_end_time(HUD_COUNTER_THROTTLE_TIME, start);
+            screen->fence_reference(screen, &oldest, NULL);
+         }
+
          swap_fences_push_back(drawable, fence);
-         screen->fence_reference(screen, &fence, NULL);
       }
+      screen->fence_reference(screen, &fence, NULL);
    }
    else if (flags & (__DRI2_FLUSH_DRAWABLE | __DRI2_FLUSH_CONTEXT)) {
       ctx->st->flush(ctx->st, flush_flags, NULL);
@@ -72,6 +72,11 @@ const __DRIconfigOptionsExtension gallium_config_options = {
          DRI_CONF_ALLOW_GLSL_EXTENSION_DIRECTIVE_MIDSHADER("false")
       DRI_CONF_SECTION_END
 
+      DRI_CONF_SECTION_PERFORMANCE
+         DRI_CONF_MESA_GLTHREAD("false")
+         DRI_CONF_MAX_FRAMES_IN_FLIGHT(-1)
+      DRI_CONF_SECTION_END
+
       DRI_CONF_SECTION_MISCELLANEOUS
          DRI_CONF_ALWAYS_HAVE_DEPTH_BUFFER("false")
       DRI_CONF_SECTION_END
@@ -98,6 +103,8 @@ dri_fill_st_options(struct st_config_options *options,
       driQueryOptionb(optionCache, "force_s3tc_enable");
    options->allow_glsl_extension_directive_midshader =
       driQueryOptionb(optionCache, "allow_glsl_extension_directive_midshader");
+   options->mesa_glthread =
+      driQueryOptionb(optionCache, "mesa_glthread");
 }
 
 static const __DRIconfig **
@@ -413,6 +420,8 @@ dri_init_screen_helper(struct dri_screen *screen,
                        struct pipe_screen *pscreen,
                        const char* driver_name)
 {
+   int max_frames;
+
    screen->base.screen = pscreen;
    screen->base.get_egl_image = dri_get_egl_image;
    screen->base.get_param = dri_get_param;
@@ -435,6 +444,13 @@ dri_init_screen_helper(struct dri_screen *screen,
 
    dri_fill_st_options(&screen->options, &screen->optionCache);
 
+   /* Let drirc override the winsys throttling, e.g. to lower latency. */
+   max_frames = driQueryOptioni(&screen->optionCache, "max_frames_in_flight");
+   if (max_frames >= 0) {
+      screen->throttling_enabled = max_frames > 0;
+      screen->default_throttle_frames = max_frames;
+   }
+
    /* Handle force_s3tc_enable. */
    if (!util_format_s3tc_enabled && screen->options.force_s3tc_enable) {
       /* Ensure libtxc_dxtn has been loaded if available.
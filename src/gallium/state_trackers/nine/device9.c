@@ -3284,6 +3284,46 @@ NineDevice9_GetVertexShader( struct NineDevice9 *This,
     return D3D_OK;
 }
 
+/* Unchanged registers between two changed ones are uploaded anyway if
+ * there are at most this many of them, to avoid many tiny uploads.
+ */
+#define NINE_CONST_F_MAX_GAP 4
+
+/* Copy float constants and only mark the registers whose value actually
+ * changed as dirty, so nine_update_state uploads just those ranges.
+ * Returns TRUE if anything changed.
+ */
+static boolean
+nine_update_const_f(struct NineDevice9 *This, float *const_f,
+                    struct nine_range **changed, UINT StartRegister,
+                    const float *pConstantData, UINT Vector4fCount)
+{
+    const unsigned vec4_size = 4 * sizeof(const_f[0]);
+    unsigned i, bgn = 0, end = 0;
+    boolean dirty = FALSE;
+
+    for (i = StartRegister; i < StartRegister + Vector4fCount; ++i) {
+        const float *src = &pConstantData[(i - StartRegister) * 4];
+
+        if (!memcmp(&const_f[i * 4], src, vec4_size))
+            continue;
+        memcpy(&const_f[i * 4], src, vec4_size);
+
+        if (dirty && i - end > NINE_CONST_F_MAX_GAP) {
+            nine_ranges_insert(changed, bgn, end, &This->range_pool);
+            bgn = i;
+        } else if (!dirty) {
+            bgn = i;
+        }
+        end = i + 1;
+        dirty = TRUE;
+    }
+    if (dirty)
+        nine_ranges_insert(changed, bgn, end, &This->range_pool);
+
+    return dirty;
+}
+
 HRESULT WINAPI
 NineDevice9_SetVertexShaderConstantF( struct NineDevice9 *This,
                                       UINT StartRegister,
@@ -3303,18 +3343,19 @@ NineDevice9_SetVertexShaderConstantF( struct NineDevice9 *This,
     user_assert(pConstantData, D3DERR_INVALIDCALL);
 
     if (!This->is_recording) {
-        if (!memcmp(&state->vs_const_f[StartRegister * 4], pConstantData,
-                    Vector4fCount * 4 * sizeof(state->vs_const_f[0])))
+        if (!nine_update_const_f(This, state->vs_const_f,
+                                 &state->changed.vs_const_f, StartRegister,
+                                 pConstantData, Vector4fCount))
             return D3D_OK;
-    }
-
-    memcpy(&state->vs_const_f[StartRegister * 4],
-           pConstantData,
-           Vector4fCount * 4 * sizeof(state->vs_const_f[0]));
+    } else {
+        memcpy(&state->vs_const_f[StartRegister * 4],
+               pConstantData,
+               Vector4fCount * 4 * sizeof(state->vs_const_f[0]));
 
-    nine_ranges_insert(&state->changed.vs_const_f,
-                       StartRegister, StartRegister + Vector4fCount,
-                       &This->range_pool);
+        nine_ranges_insert(&state->changed.vs_const_f,
+                           StartRegister, StartRegister + Vector4fCount,
+                           &This->range_pool);
+    }
 
     state->changed.group |= NINE_STATE_VS_CONST;
 
@@ -3665,18 +3706,19 @@ NineDevice9_SetPixelShaderConstantF( struct NineDevice9 *This,
     user_assert(pConstantData, D3DERR_INVALIDCALL);
 
     if (!This->is_recording) {
-        if (!memcmp(&state->ps_const_f[StartRegister * 4], pConstantData,
-                    Vector4fCount * 4 * sizeof(state->ps_const_f[0])))
+        if (!nine_update_const_f(This, state->ps_const_f,
+                                 &state->changed.ps_const_f, StartRegister,
+                                 pConstantData, Vector4fCount))
             return D3D_OK;
-    }
-
-    memcpy(&state->ps_const_f[StartRegister * 4],
-           pConstantData,
-           Vector4fCount * 4 * sizeof(state->ps_const_f[0]));
+    } else {
+        memcpy(&state->ps_const_f[StartRegister * 4],
+               pConstantData,
+               Vector4fCount * 4 * sizeof(state->ps_const_f[0]));
 
-    nine_ranges_insert(&state->changed.ps_const_f,
-                       StartRegister, StartRegister + Vector4fCount,
-                       &This->range_pool);
+        nine_ranges_insert(&state->changed.ps_const_f,
+                           StartRegister, StartRegister + Vector4fCount,
+                           &This->range_pool);
+    }
 
     state->changed.group |= NINE_STATE_PS_CONST;
 
@@ -35,12 +35,17 @@
  * display target resource.  However, softpipe doesn't support "upside-down"
  * rendering which would be needed for the OSMESA_Y_UP=TRUE case.
  *
- * With llvmpipe we could only render directly into the user's buffer when its
- * width and height is a multiple of the tile size (64 pixels).
+ * With llvmpipe we render directly into the user's buffer when OSMESA_Y_UP
+ * is FALSE and the driver can lay the color buffer out the way the user's
+ * buffer is (see osmesa_validate_color_buffer()).  In all other cases we
+ * render into ordinary resources then copy the results to the user's buffer
+ * in the flush_front() function which is called when the app calls
+ * glFlush/Finish.
  *
- * Because of these constraints we always render into ordinary resources then
- * copy the results to the user's buffer in the flush_front() function which
- * is called when the app calls glFlush/Finish.
+ * Contexts may be used from several threads at once.  A buffer is only
+ * handed out to one context at a time, and OSMesaCreateContextPool() lets
+ * servers keep a set of ready-made contexts (and their buffers) around
+ * instead of creating them per image.
  *
  * In general, the OSMesa interface is pretty ugly and not a good match
  * for Gallium.  But we're interested in doing the best we can to preserve
@@ -58,10 +63,13 @@
 #include "pipe/p_screen.h"
 #include "pipe/p_state.h"
 
+#include "os/os_thread.h"
+
 #include "util/u_atomic.h"
 #include "util/u_box.h"
 #include "util/u_debug.h"
 #include "util/u_format.h"
+#include "util/u_inlines.h"
 #include "util/u_memory.h"
 
 #include "postprocess/filters.h"
@@ -87,6 +95,17 @@ struct osmesa_buffer
 
    void *map;
 
+   /**
+    * The user memory and row stride the color buffer was last validated
+    * for, NULL/0 if direct rendering wasn't wanted.  When direct is set the
+    * color texture uses that memory as its storage.
+    */
+   void *color_map;
+   unsigned color_stride;
+   boolean direct;
+
+   struct osmesa_context *ctx;  /**< context the buffer is bound to */
+
    struct osmesa_buffer *next;  /**< next in linked list */
 };
 
@@ -110,6 +129,19 @@ struct osmesa_context
    /** Which postprocessing filters are enabled. */
    unsigned pp_enabled[PP_FILTERS];
    struct pp_queue_t *pp;
+
+   struct osmesa_context_pool *pool;  /**< pool the context belongs to */
+   struct osmesa_context *next_free;  /**< next in the pool's free list */
+};
+
+
+struct osmesa_context_pool
+{
+   pipe_mutex mutex;
+   int *attribs;                 /**< copy of the attribute list */
+   OSMesaContext sharelist;
+   struct osmesa_context *free_list;
+   unsigned num_acquired;
 };
 
 
@@ -123,6 +155,9 @@ struct osmesa_context
  */
 static struct osmesa_buffer *BufferList = NULL;
 
+/** Protects BufferList and the singletons below. */
+pipe_static_mutex(osmesa_mutex);
+
 
 /**
  * Called from the ST manager.
@@ -142,9 +177,11 @@ static struct st_api *
 get_st_api(void)
 {
    static struct st_api *stapi = NULL;
+   pipe_mutex_lock(osmesa_mutex);
    if (!stapi) {
       stapi = st_gl_api_create();
    }
+   pipe_mutex_unlock(osmesa_mutex);
    return stapi;
 }
 
@@ -156,6 +193,7 @@ static struct st_manager *
 get_st_manager(void)
 {
    static struct st_manager *stmgr = NULL;
+   pipe_mutex_lock(osmesa_mutex);
    if (!stmgr) {
       stmgr = CALLOC_STRUCT(st_manager);
       if (stmgr) {
@@ -164,6 +202,7 @@ get_st_manager(void)
          stmgr->get_egl_image = NULL;
       }         
    }
+   pipe_mutex_unlock(osmesa_mutex);
    return stmgr;
 }
 
@@ -299,6 +338,56 @@ stfbi_to_osbuffer(struct st_framebuffer_iface *stfbi)
 }
 
 
+/**
+ * Return the row stride of the user's color buffer, in bytes.
+ */
+static unsigned
+osmesa_user_stride(const struct osmesa_context *osmesa,
+                   const struct osmesa_buffer *osbuffer)
+{
+   unsigned bpp = util_format_get_blocksize(osbuffer->visual.color_format);
+
+   if (osmesa->user_row_length)
+      return bpp * osmesa->user_row_length;
+   else
+      return bpp * osbuffer->width;
+}
+
+
+/**
+ * Return the user memory we'd like to render into directly, or NULL if
+ * the image has to be copied there by flush_front().  Gallium puts the
+ * first row at the top, so OSMESA_Y_UP=TRUE always needs the copy.
+ */
+static void *
+osmesa_direct_map(const struct osmesa_context *osmesa,
+                  const struct osmesa_buffer *osbuffer)
+{
+   struct pipe_screen *screen = get_st_manager()->screen;
+
+   if (osmesa->y_up || !screen->resource_from_user_memory)
+      return NULL;
+   return osbuffer->map;
+}
+
+
+/**
+ * Bump the framebuffer stamp, so that the st revalidates it, when the
+ * color buffer needs to move to other user memory or to switch between
+ * direct rendering and copying.
+ */
+static void
+osmesa_check_direct(const struct osmesa_context *osmesa,
+                    struct osmesa_buffer *osbuffer)
+{
+   void *map = osmesa_direct_map(osmesa, osbuffer);
+   unsigned stride = map ? osmesa_user_stride(osmesa, osbuffer) : 0;
+
+   if (map != osbuffer->color_map || stride != osbuffer->color_stride)
+      p_atomic_inc(&osbuffer->stfb->stamp);
+}
+
+
 /**
  * Called via glFlush/glFinish.  This is where we copy the contents
  * of the driver's color buffer into the user-specified buffer.
@@ -319,6 +408,9 @@ osmesa_st_framebuffer_flush_front(struct st_context_iface *stctx,
    unsigned y, bytes, bpp;
    int dst_stride;
 
+   if (!res)
+      return FALSE;
+
    if (osmesa->pp) {
       struct pipe_resource *zsbuf = NULL;
       unsigned i;
@@ -343,8 +435,17 @@ osmesa_st_framebuffer_flush_front(struct st_context_iface *stctx,
 
    u_box_2d(0, 0, res->width0, res->height0, &box);
 
+   /* This also waits for the rendering to finish */
    map = pipe->transfer_map(pipe, res, 0, PIPE_TRANSFER_READ, &box,
                             &transfer);
+   if (!map)
+      return FALSE;
+
+   if (osbuffer->direct) {
+      /* the image is already in the user's buffer */
+      pipe->transfer_unmap(pipe, transfer);
+      return TRUE;
+   }
 
    /*
     * Copy the color buffer from the resource to the user's buffer.
@@ -352,10 +453,7 @@ osmesa_st_framebuffer_flush_front(struct st_context_iface *stctx,
    bpp = util_format_get_blocksize(osbuffer->visual.color_format);
    src = map;
    dst = osbuffer->map;
-   if (osmesa->user_row_length)
-      dst_stride = bpp * osmesa->user_row_length;
-   else
-      dst_stride = bpp * osbuffer->width;
+   dst_stride = osmesa_user_stride(osmesa, osbuffer);
    bytes = bpp * res->width0;
 
    if (osmesa->y_up) {
@@ -376,9 +474,85 @@ osmesa_st_framebuffer_flush_front(struct st_context_iface *stctx,
 }
 
 
+/**
+ * Check that a resource created from user memory is laid out exactly like
+ * the user's buffer.
+ */
+static boolean
+osmesa_check_layout(struct pipe_context *pipe, struct pipe_resource *res,
+                    void *user_map, unsigned user_stride)
+{
+   struct pipe_transfer *transfer = NULL;
+   struct pipe_box box;
+   boolean match;
+   void *map;
+
+   u_box_2d(0, 0, res->width0, res->height0, &box);
+
+   map = pipe->transfer_map(pipe, res, 0, PIPE_TRANSFER_READ, &box,
+                            &transfer);
+   if (!map)
+      return FALSE;
+
+   match = map == user_map && transfer->stride == user_stride;
+
+   pipe->transfer_unmap(pipe, transfer);
+
+   return match;
+}
+
+
+/**
+ * (Re)create the color buffer if needed.  We render right into the user's
+ * memory when it's wanted and the driver can do it with the user's row
+ * stride; otherwise an ordinary resource is used and flush_front() copies
+ * the image.
+ */
+static void
+osmesa_validate_color_buffer(struct st_context_iface *stctx,
+                             struct osmesa_buffer *osbuffer,
+                             const struct pipe_resource *templat)
+{
+   OSMesaContext osmesa = (OSMesaContext) stctx->st_manager_private;
+   struct pipe_screen *screen = get_st_manager()->screen;
+   struct pipe_resource **color = &osbuffer->textures[ST_ATTACHMENT_FRONT_LEFT];
+   struct pipe_resource *res = NULL;
+   void *map = osmesa_direct_map(osmesa, osbuffer);
+   unsigned stride = map ? osmesa_user_stride(osmesa, osbuffer) : 0;
+   boolean direct = FALSE;
+
+   if (*color && map == osbuffer->color_map &&
+       stride == osbuffer->color_stride)
+      return;
+
+   if (map) {
+      res = screen->resource_from_user_memory(screen, templat, map);
+      if (res && osmesa_check_layout(stctx->pipe, res, map, stride))
+         direct = TRUE;
+      else
+         pipe_resource_reference(&res, NULL);
+   }
+
+   if (!res) {
+      if (*color && !osbuffer->direct)
+         pipe_resource_reference(&res, *color);
+      else
+         res = screen->resource_create(screen, templat);
+   }
+
+   pipe_resource_reference(color, res);
+   pipe_resource_reference(&res, NULL);
+
+   osbuffer->color_map = map;
+   osbuffer->color_stride = stride;
+   osbuffer->direct = direct;
+}
+
+
 /**
  * Called by the st manager to validate the framebuffer (allocate
- * its resources).
+ * its resources).  The resources are kept in the osmesa_buffer, so that
+ * another context or st_framebuffer using the buffer gets the same ones.
  */
 static boolean
 osmesa_st_framebuffer_validate(struct st_context_iface *stctx,
@@ -432,8 +606,15 @@ osmesa_st_framebuffer_validate(struct st_context_iface *stctx,
 
       templat.format = format;
       templat.bind = bind;
-      out[i] = osbuffer->textures[statts[i]] =
-         screen->resource_create(screen, &templat);
+
+      if (statts[i] == ST_ATTACHMENT_FRONT_LEFT)
+         osmesa_validate_color_buffer(stctx, osbuffer, &templat);
+      else if (!osbuffer->textures[statts[i]])
+         osbuffer->textures[statts[i]] =
+            screen->resource_create(screen, &templat);
+
+      out[i] = NULL;
+      pipe_resource_reference(&out[i], osbuffer->textures[statts[i]]);
    }
 
    return TRUE;
@@ -455,6 +636,7 @@ osmesa_create_st_framebuffer(void)
 
 /**
  * Create new buffer and add to linked list.
+ * Called with osmesa_mutex held.
  */
 static struct osmesa_buffer *
 osmesa_create_buffer(enum pipe_format color_format,
@@ -480,24 +662,45 @@ osmesa_create_buffer(enum pipe_format color_format,
 }
 
 
+static inline boolean
+osmesa_buffer_matches(const struct osmesa_buffer *b,
+                      enum pipe_format color_format,
+                      enum pipe_format ds_format,
+                      enum pipe_format accum_format,
+                      GLsizei width, GLsizei height)
+{
+   return b->visual.color_format == color_format &&
+          b->visual.depth_stencil_format == ds_format &&
+          b->visual.accum_format == accum_format &&
+          b->width == width &&
+          b->height == height;
+}
+
+
 /**
- * Search linked list for a buffer with matching pixel formats and size.
+ * Search linked list for a buffer with matching pixel formats and size
+ * which isn't bound to another context.  The context's current buffer is
+ * preferred since the st already has a framebuffer for it.
+ * Called with osmesa_mutex held.
  */
 static struct osmesa_buffer *
-osmesa_find_buffer(enum pipe_format color_format,
+osmesa_find_buffer(struct osmesa_context *osmesa,
+                   enum pipe_format color_format,
                    enum pipe_format ds_format,
                    enum pipe_format accum_format,
                    GLsizei width, GLsizei height)
 {
-   struct osmesa_buffer *b;
+   struct osmesa_buffer *b = osmesa->current_buffer;
+
+   if (b && osmesa_buffer_matches(b, color_format, ds_format, accum_format,
+                                  width, height))
+      return b;
 
    /* Check if we already have a suitable buffer for the given formats */
    for (b = BufferList; b; b = b->next) {
-      if (b->visual.color_format == color_format &&
-          b->visual.depth_stencil_format == ds_format &&
-          b->visual.accum_format == accum_format &&
-          b->width == width &&
-          b->height == height) {
+      if (!b->ctx &&
+          osmesa_buffer_matches(b, color_format, ds_format, accum_format,
+                                width, height)) {
          return b;
       }
    }
@@ -505,9 +708,28 @@ osmesa_find_buffer(enum pipe_format color_format,
 }
 
 
+/**
+ * Let other contexts use the context's current buffer.
+ * Called with osmesa_mutex held.
+ */
+static void
+osmesa_unbind_buffer(struct osmesa_context *osmesa)
+{
+   if (osmesa->current_buffer) {
+      assert(osmesa->current_buffer->ctx == osmesa);
+      osmesa->current_buffer->ctx = NULL;
+      osmesa->current_buffer = NULL;
+   }
+}
+
+
 static void
 osmesa_destroy_buffer(struct osmesa_buffer *osbuffer)
 {
+   unsigned i;
+
+   for (i = 0; i < Elements(osbuffer->textures); i++)
+      pipe_resource_reference(&osbuffer->textures[i], NULL);
    FREE(osbuffer->stfb);
    FREE(osbuffer);
 }
@@ -712,6 +934,10 @@ GLAPI void GLAPIENTRY
 OSMesaDestroyContext(OSMesaContext osmesa)
 {
    if (osmesa) {
+      pipe_mutex_lock(osmesa_mutex);
+      osmesa_unbind_buffer(osmesa);
+      pipe_mutex_unlock(osmesa_mutex);
+
       pp_free(osmesa->pp);
       osmesa->stctx->destroy(osmesa->stctx);
       FREE(osmesa);
@@ -763,8 +989,10 @@ OSMesaMakeCurrent(OSMesaContext osmesa, void *buffer, GLenum type,
       return GL_FALSE;
    }
 
+   pipe_mutex_lock(osmesa_mutex);
+
    /* See if we already have a buffer that uses these pixel formats */
-   osbuffer = osmesa_find_buffer(color_format,
+   osbuffer = osmesa_find_buffer(osmesa, color_format,
                                  osmesa->depth_stencil_format,
                                  osmesa->accum_format, width, height);
    if (!osbuffer) {
@@ -772,8 +1000,19 @@ OSMesaMakeCurrent(OSMesaContext osmesa, void *buffer, GLenum type,
       osbuffer = osmesa_create_buffer(color_format,
                                       osmesa->depth_stencil_format,
                                       osmesa->accum_format);
+      if (!osbuffer) {
+         pipe_mutex_unlock(osmesa_mutex);
+         return GL_FALSE;
+      }
    }
 
+   if (osbuffer != osmesa->current_buffer) {
+      osmesa_unbind_buffer(osmesa);
+      osbuffer->ctx = osmesa;
+   }
+
+   pipe_mutex_unlock(osmesa_mutex);
+
    osbuffer->width = width;
    osbuffer->height = height;
    osbuffer->map = buffer;
@@ -784,6 +1023,8 @@ OSMesaMakeCurrent(OSMesaContext osmesa, void *buffer, GLenum type,
    osmesa->current_buffer = osbuffer;
    osmesa->type = type;
 
+   osmesa_check_direct(osmesa, osbuffer);
+
    stapi->make_current(stapi, osmesa->stctx, osbuffer->stfb, osbuffer->stfb);
 
    if (!osmesa->ever_used) {
@@ -840,6 +1081,9 @@ OSMesaPixelStore(GLint pname, GLint value)
       fprintf(stderr, "Invalid pname in OSMesaPixelStore()\n");
       return;
    }
+
+   if (osmesa->current_buffer)
+      osmesa_check_direct(osmesa, osmesa->current_buffer);
 }
 
 
@@ -983,6 +1227,10 @@ static struct name_function functions[] = {
    { "OSMesaGetProcAddress", (OSMESAproc) OSMesaGetProcAddress },
    { "OSMesaColorClamp", (OSMESAproc) OSMesaColorClamp },
    { "OSMesaPostprocess", (OSMESAproc) OSMesaPostprocess },
+   { "OSMesaCreateContextPool", (OSMESAproc) OSMesaCreateContextPool },
+   { "OSMesaDestroyContextPool", (OSMESAproc) OSMesaDestroyContextPool },
+   { "OSMesaAcquireContext", (OSMESAproc) OSMesaAcquireContext },
+   { "OSMesaReleaseContext", (OSMESAproc) OSMesaReleaseContext },
    { NULL, NULL }
 };
 
@@ -1031,3 +1279,134 @@ OSMesaPostprocess(OSMesaContext osmesa, const char *filter,
       debug_warning("Calling OSMesaPostprocess() after OSMesaMakeCurrent()\n");
    }
 }
+
+
+/**
+ * Create a pool of contexts which all use the same attribute list.
+ * numContexts contexts are created right away; more are created by
+ * OSMesaAcquireContext() when all of them are in use.
+ */
+GLAPI OSMesaContextPool GLAPIENTRY
+OSMesaCreateContextPool(const int *attribList, OSMesaContext sharelist,
+                        GLint numContexts)
+{
+   struct osmesa_context_pool *pool;
+   unsigned n = 0;
+   int i;
+
+   pool = CALLOC_STRUCT(osmesa_context_pool);
+   if (!pool)
+      return NULL;
+
+   while (attribList[n])
+      n += 2;
+
+   pool->attribs = MALLOC((n + 1) * sizeof(int));
+   if (!pool->attribs) {
+      FREE(pool);
+      return NULL;
+   }
+   memcpy(pool->attribs, attribList, (n + 1) * sizeof(int));
+   pool->sharelist = sharelist;
+   pipe_mutex_init(pool->mutex);
+
+   for (i = 0; i < numContexts; i++) {
+      OSMesaContext osmesa = OSMesaCreateContextAttribs(pool->attribs,
+                                                        sharelist);
+      if (!osmesa) {
+         OSMesaDestroyContextPool(pool);
+         return NULL;
+      }
+      osmesa->pool = pool;
+      osmesa->next_free = pool->free_list;
+      pool->free_list = osmesa;
+   }
+
+   return pool;
+}
+
+
+/**
+ * Destroy a context pool and its contexts.  All the contexts must have
+ * been released.
+ */
+GLAPI void GLAPIENTRY
+OSMesaDestroyContextPool(OSMesaContextPool pool)
+{
+   if (pool) {
+      assert(pool->num_acquired == 0);
+
+      while (pool->free_list) {
+         OSMesaContext osmesa = pool->free_list;
+         pool->free_list = osmesa->next_free;
+         OSMesaDestroyContext(osmesa);
+      }
+
+      pipe_mutex_destroy(pool->mutex);
+      FREE(pool->attribs);
+      FREE(pool);
+   }
+}
+
+
+/**
+ * Take a context out of the pool for the calling thread.  The context is
+ * used with OSMesaMakeCurrent() as usual; it keeps the GL state left by
+ * its previous user, but its OSMesaPixelStore() values are the defaults.
+ * A context which rendered images of the same size and format before
+ * renders into the same internal buffers.
+ */
+GLAPI OSMesaContext GLAPIENTRY
+OSMesaAcquireContext(OSMesaContextPool pool)
+{
+   OSMesaContext osmesa;
+
+   pipe_mutex_lock(pool->mutex);
+   osmesa = pool->free_list;
+   if (osmesa)
+      pool->free_list = osmesa->next_free;
+   pool->num_acquired++;
+   pipe_mutex_unlock(pool->mutex);
+
+   if (!osmesa) {
+      osmesa = OSMesaCreateContextAttribs(pool->attribs, pool->sharelist);
+      if (!osmesa) {
+         pipe_mutex_lock(pool->mutex);
+         pool->num_acquired--;
+         pipe_mutex_unlock(pool->mutex);
+         return NULL;
+      }
+      osmesa->pool = pool;
+   }
+
+   osmesa->next_free = NULL;
+   return osmesa;
+}
+
+
+/**
+ * Put a context back into its pool.  This must be called from the thread
+ * the context was last made current in; the context is unbound from it.
+ */
+GLAPI void GLAPIENTRY
+OSMesaReleaseContext(OSMesaContext osmesa)
+{
+   struct osmesa_context_pool *pool = osmesa->pool;
+
+   if (!pool)
+      return;
+
+   if (OSMesaGetCurrentContext() == osmesa) {
+      struct st_api *stapi = get_st_api();
+      stapi->make_current(stapi, NULL, NULL, NULL);
+   }
+
+   osmesa->user_row_length = 0;
+   osmesa->y_up = GL_TRUE;
+
+   pipe_mutex_lock(pool->mutex);
+   osmesa->next_free = pool->free_list;
+   pool->free_list = osmesa;
+   pool->num_acquired--;
+   pipe_mutex_unlock(pool->mutex);
+}
@@ -59,6 +59,7 @@ vlVaBeginPicture(VADriverContextP ctx, VAContextID context_id, VASurfaceID rende
       return VA_STATUS_ERROR_INVALID_SURFACE;
 
    context->target = surf->buffer;
+   context->target_id = render_target;
 
    if (!context->decoder) {
       /* VPP */
@@ -323,6 +324,7 @@ vlVaEndPicture(VADriverContextP ctx, VAContextID context_id)
 {
    vlVaDriver *drv;
    vlVaContext *context;
+   vlVaSurface *surf;
 
    if (!ctx)
       return VA_STATUS_ERROR_INVALID_CONTEXT;
@@ -335,16 +337,19 @@ vlVaEndPicture(VADriverContextP ctx, VAContextID context_id)
    if (!context)
       return VA_STATUS_ERROR_INVALID_CONTEXT;
 
-   if (!context->decoder) {
-      if (context->templat.profile != PIPE_VIDEO_PROFILE_UNKNOWN)
-         return VA_STATUS_ERROR_INVALID_CONTEXT;
-
-      /* VPP */
-      return VA_STATUS_SUCCESS;
+   if (context->decoder) {
+      context->mpeg4.frame_num++;
+      context->decoder->end_frame(context->decoder, context->target, &context->desc.base);
+   } else if (context->templat.profile != PIPE_VIDEO_PROFILE_UNKNOWN) {
+      return VA_STATUS_ERROR_INVALID_CONTEXT;
    }
 
-   context->mpeg4.frame_num++;
-   context->decoder->end_frame(context->decoder, context->target, &context->desc.base);
+   /* Kick off the rendering and remember its fence, so the application
+    * can queue more pictures and only wait on the surfaces it needs.
+    */
+   surf = handle_table_get(drv->htab, context->target_id);
+   if (surf)
+      drv->pipe->flush(drv->pipe, &surf->fence, 0);
 
    return VA_STATUS_SUCCESS;
 }
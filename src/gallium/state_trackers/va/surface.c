@@ -72,6 +72,7 @@ vlVaDestroySurfaces(VADriverContextP ctx, VASurfaceID *surface_list, int num_sur
       vlVaSurface *surf = handle_table_get(drv->htab, surface_list[i]);
       if (surf->buffer)
          surf->buffer->destroy(surf->buffer);
+      drv->pipe->screen->fence_reference(drv->pipe->screen, &surf->fence, NULL);
       util_dynarray_fini(&surf->subpics);
       FREE(surf);
       handle_table_remove(drv->htab, surface_list[i]);
@@ -83,18 +84,50 @@ vlVaDestroySurfaces(VADriverContextP ctx, VASurfaceID *surface_list, int num_sur
 VAStatus
 vlVaSyncSurface(VADriverContextP ctx, VASurfaceID render_target)
 {
+   vlVaDriver *drv;
+   vlVaSurface *surf;
+   struct pipe_screen *screen;
+
    if (!ctx)
       return VA_STATUS_ERROR_INVALID_CONTEXT;
 
+   drv = VL_VA_DRIVER(ctx);
+   surf = handle_table_get(drv->htab, render_target);
+   if (!surf)
+      return VA_STATUS_ERROR_INVALID_SURFACE;
+
+   screen = drv->pipe->screen;
+   if (surf->fence) {
+      screen->fence_finish(screen, surf->fence, PIPE_TIMEOUT_INFINITE);
+      screen->fence_reference(screen, &surf->fence, NULL);
+   }
+
    return VA_STATUS_SUCCESS;
 }
 
 VAStatus
 vlVaQuerySurfaceStatus(VADriverContextP ctx, VASurfaceID render_target, VASurfaceStatus *status)
 {
+   vlVaDriver *drv;
+   vlVaSurface *surf;
+   struct pipe_screen *screen;
+
    if (!ctx)
       return VA_STATUS_ERROR_INVALID_CONTEXT;
 
+   drv = VL_VA_DRIVER(ctx);
+   surf = handle_table_get(drv->htab, render_target);
+   if (!surf)
+      return VA_STATUS_ERROR_INVALID_SURFACE;
+
+   screen = drv->pipe->screen;
+   if (surf->fence && !screen->fence_finish(screen, surf->fence, 0)) {
+      *status = VASurfaceRendering;
+   } else {
+      screen->fence_reference(screen, &surf->fence, NULL);
+      *status = VASurfaceReady;
+   }
+
    return VA_STATUS_SUCCESS;
 }
 
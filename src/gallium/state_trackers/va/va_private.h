@@ -217,6 +217,7 @@ typedef struct {
 typedef struct {
    struct pipe_video_codec templat, *decoder;
    struct pipe_video_buffer *target;
+   VASurfaceID target_id;
    union {
       struct pipe_picture_desc base;
       struct pipe_mpeg12_picture_desc mpeg12;
@@ -252,6 +253,7 @@ typedef struct {
 typedef struct {
    struct pipe_video_buffer templat, *buffer;
    struct util_dynarray subpics; /* vlVaSubpicture */
+   struct pipe_fence_handle *fence; /* last rendering to the surface */
 } vlVaSurface;
 
 // Public functions:
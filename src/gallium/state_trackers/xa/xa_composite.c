@@ -469,6 +469,61 @@ bind_samplers(struct xa_context *ctx,
 				   ctx->bound_sampler_views);
 }
 
+static int
+picture_state_equal(const struct xa_picture *a, const struct xa_picture *b)
+{
+    if (!a || !b)
+	return a == b;
+
+    /* The transforms only affect the vertex data. */
+    if (a->pict_format != b->pict_format ||
+	a->srf != b->srf ||
+	a->alpha_map != b->alpha_map ||
+	a->has_transform != b->has_transform ||
+	a->component_alpha != b->component_alpha ||
+	a->wrap != b->wrap ||
+	a->filter != b->filter)
+	return FALSE;
+
+    if (!a->src_pict || !b->src_pict)
+	return a->src_pict == b->src_pict;
+
+    return memcmp(a->src_pict, b->src_pict, sizeof(*a->src_pict)) == 0;
+}
+
+static struct xa_picture *
+save_picture(struct xa_context *ctx, unsigned int i,
+	     const struct xa_picture *pic)
+{
+    if (!pic)
+	return NULL;
+
+    ctx->pending_pict[i] = *pic;
+    if (pic->src_pict) {
+	ctx->pending_src_pict[i] = *pic->src_pict;
+	ctx->pending_pict[i].src_pict = &ctx->pending_src_pict[i];
+    }
+
+    return &ctx->pending_pict[i];
+}
+
+/*
+ * Draw the vertices of the pending composite operation, if any, and
+ * release its state.
+ */
+void
+xa_ctx_composite_flush(struct xa_context *ctx)
+{
+    if (!ctx->comp_pending)
+	return;
+
+    renderer_draw_flush(ctx);
+
+    ctx->comp_pending = FALSE;
+    ctx->has_solid_color = FALSE;
+    xa_ctx_sampler_views_destroy(ctx);
+}
+
 XA_EXPORT int
 xa_composite_prepare(struct xa_context *ctx,
 		     const struct xa_composite *comp)
@@ -479,6 +534,27 @@ xa_composite_prepare(struct xa_context *ctx,
     if (comp->mask && !comp->mask->srf)
 	return -XA_ERR_INVAL;
 
+    /*
+     * Keep accumulating vertices if the state is the same as for the
+     * previous composite, which is typical for glyph rendering.
+     */
+    if (ctx->comp_pending) {
+	const struct xa_composite *prev = &ctx->pending_comp;
+
+	if (comp->op == prev->op &&
+	    comp->no_solid == prev->no_solid &&
+	    picture_state_equal(comp->src, prev->src) &&
+	    picture_state_equal(comp->mask, prev->mask) &&
+	    picture_state_equal(comp->dst, prev->dst)) {
+	    ctx->comp_pending = FALSE;
+	    if (ctx->num_bound_samplers != 0)
+		ctx->comp = comp;
+	    return XA_ERR_NONE;
+	}
+
+	xa_ctx_composite_flush(ctx);
+    }
+
     ret = xa_ctx_srf_create(ctx, dst_srf);
     if (ret != XA_ERR_NONE)
 	return ret;
@@ -501,6 +577,12 @@ xa_composite_prepare(struct xa_context *ctx,
 	ctx->comp = comp;
     }
 
+    ctx->pending_comp.src = save_picture(ctx, 0, comp->src);
+    ctx->pending_comp.mask = save_picture(ctx, 1, comp->mask);
+    ctx->pending_comp.dst = save_picture(ctx, 2, comp->dst);
+    ctx->pending_comp.op = comp->op;
+    ctx->pending_comp.no_solid = comp->no_solid;
+
     xa_ctx_srf_destroy(ctx);
     return XA_ERR_NONE;
 }
@@ -534,11 +616,12 @@ xa_composite_rect(struct xa_context *ctx,
 XA_EXPORT void
 xa_composite_done(struct xa_context *ctx)
 {
-    renderer_draw_flush(ctx);
-
+    /*
+     * Defer the draw, the next composite may be batched with this one.
+     * Any other operation on the context flushes it.
+     */
     ctx->comp = NULL;
-    ctx->has_solid_color = FALSE;
-    xa_ctx_sampler_views_destroy(ctx);
+    ctx->comp_pending = TRUE;
 }
 
 static const struct xa_composite_allocation a = {
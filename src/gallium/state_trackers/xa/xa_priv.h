@@ -121,6 +121,16 @@ struct xa_context {
     unsigned int num_bound_samplers;
     struct pipe_sampler_view *bound_sampler_views[XA_MAX_SAMPLERS];
     const struct xa_composite *comp;
+
+    /*
+     * Copy of the last composite operation while its vertices haven't
+     * been drawn yet, so that following composites with the same state
+     * can be batched into the same draw.
+     */
+    int comp_pending;
+    struct xa_composite pending_comp;
+    struct xa_picture pending_pict[3];
+    union xa_source_pict pending_src_pict[3];
 };
 
 static inline void
@@ -248,6 +258,9 @@ xa_ctx_srf_destroy(struct xa_context *ctx);
 extern void
 xa_ctx_sampler_views_destroy(struct xa_context *ctx);
 
+void
+xa_ctx_composite_flush(struct xa_context *ctx);
+
 /*
  * xa_renderer.c
  */
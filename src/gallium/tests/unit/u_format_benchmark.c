@@ -0,0 +1,270 @@
+/**************************************************************************
+ *
+ * Copyright 2015 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+
+/**
+ * @file
+ * Measures how many pixels per second the pack/unpack functions of the
+ * formats with SIMD row functions convert, and checks that converting whole
+ * rows gives the same bits as converting one pixel at a time, which always
+ * goes through the generic code.
+ */
+
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "os/os_time.h"
+#include "util/u_format.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+
+
+#define WIDTH 1024
+#define HEIGHT 64
+#define ITERATIONS 16
+
+
+enum op {
+   UNPACK_RGBA_FLOAT,
+   PACK_RGBA_FLOAT,
+   UNPACK_RGBA_8UNORM,
+   PACK_RGBA_8UNORM,
+   UNPACK_Z_FLOAT,
+};
+
+static const char *op_names[] = {
+   "unpack_rgba_float",
+   "pack_rgba_float",
+   "unpack_rgba_8unorm",
+   "pack_rgba_8unorm",
+   "unpack_z_float",
+};
+
+static const enum pipe_format formats[] = {
+   PIPE_FORMAT_R8G8B8A8_UNORM,
+   PIPE_FORMAT_B8G8R8A8_UNORM,
+   PIPE_FORMAT_B5G6R5_UNORM,
+   PIPE_FORMAT_R16_FLOAT,
+   PIPE_FORMAT_R16G16B16A16_FLOAT,
+   PIPE_FORMAT_R32_FLOAT,
+   PIPE_FORMAT_Z24_UNORM_S8_UINT,
+   PIPE_FORMAT_S8_UINT_Z24_UNORM,
+};
+
+
+static uint32_t seed = 1;
+
+static uint32_t
+next_random(void)
+{
+   seed = seed * 1103515245 + 12345;
+   return seed >> 8;
+}
+
+
+/**
+ * Mostly values in the [-0.25, 1.25] range, with a few arbitrary bit
+ * patterns, NaNs and infinities included.
+ */
+static void
+fill_floats(float *data, unsigned count)
+{
+   unsigned i;
+
+   for (i = 0; i < count; i++) {
+      if (next_random() % 16 == 0) {
+         union fi fi;
+         fi.ui = (next_random() << 8) ^ next_random();
+         data[i] = fi.f;
+      }
+      else {
+         data[i] = (next_random() % 6001) / 4000.0f - 0.25f;
+      }
+   }
+}
+
+
+static void
+fill_bytes(uint8_t *data, unsigned count)
+{
+   unsigned i;
+
+   for (i = 0; i < count; i++)
+      data[i] = next_random();
+}
+
+
+static boolean
+has_op(const struct util_format_description *desc, enum op op)
+{
+   switch (op) {
+   case UNPACK_RGBA_FLOAT:
+      return desc->unpack_rgba_float != NULL;
+   case PACK_RGBA_FLOAT:
+      return desc->pack_rgba_float != NULL;
+   case UNPACK_RGBA_8UNORM:
+      return desc->unpack_rgba_8unorm != NULL;
+   case PACK_RGBA_8UNORM:
+      return desc->pack_rgba_8unorm != NULL;
+   case UNPACK_Z_FLOAT:
+      return desc->unpack_z_float != NULL;
+   }
+   return FALSE;
+}
+
+
+/**
+ * Convert \p width x \p height pixels from \p src to \p dst.
+ */
+static void
+run_op(const struct util_format_description *desc, enum op op,
+       void *dst, unsigned dst_stride, const void *src, unsigned src_stride,
+       unsigned width, unsigned height)
+{
+   switch (op) {
+   case UNPACK_RGBA_FLOAT:
+      desc->unpack_rgba_float(dst, dst_stride, src, src_stride, width, height);
+      break;
+   case PACK_RGBA_FLOAT:
+      desc->pack_rgba_float(dst, dst_stride, src, src_stride, width, height);
+      break;
+   case UNPACK_RGBA_8UNORM:
+      desc->unpack_rgba_8unorm(dst, dst_stride, src, src_stride, width, height);
+      break;
+   case PACK_RGBA_8UNORM:
+      desc->pack_rgba_8unorm(dst, dst_stride, src, src_stride, width, height);
+      break;
+   case UNPACK_Z_FLOAT:
+      desc->unpack_z_float(dst, dst_stride, src, src_stride, width, height);
+      break;
+   }
+}
+
+
+static boolean
+test_op(const struct util_format_description *desc, enum op op)
+{
+   const unsigned packed_stride = WIDTH * desc->block.bits / 8;
+   unsigned unpacked_stride;
+   unsigned src_stride, dst_stride, dst_size, x, y, i;
+   uint8_t *src, *dst, *ref;
+   int64_t start, end;
+   boolean success = TRUE;
+
+   switch (op) {
+   case UNPACK_RGBA_FLOAT:
+   case PACK_RGBA_FLOAT:
+      unpacked_stride = WIDTH * 4 * sizeof(float);
+      break;
+   case UNPACK_Z_FLOAT:
+      unpacked_stride = WIDTH * sizeof(float);
+      break;
+   default:
+      unpacked_stride = WIDTH * 4;
+      break;
+   }
+
+   if (op == PACK_RGBA_FLOAT || op == PACK_RGBA_8UNORM) {
+      src_stride = unpacked_stride;
+      dst_stride = packed_stride;
+   }
+   else {
+      src_stride = packed_stride;
+      dst_stride = unpacked_stride;
+   }
+
+   dst_size = dst_stride * HEIGHT;
+   src = MALLOC(src_stride * HEIGHT);
+   dst = MALLOC(dst_size);
+   ref = MALLOC(dst_size);
+   if (!src || !dst || !ref) {
+      FREE(src);
+      FREE(dst);
+      FREE(ref);
+      return FALSE;
+   }
+
+   if (op == PACK_RGBA_FLOAT)
+      fill_floats((float *)src, src_stride * HEIGHT / sizeof(float));
+   else
+      fill_bytes(src, src_stride * HEIGHT);
+
+   /* Packing leaves the bits of other channels alone in some formats. */
+   memset(dst, 0, dst_size);
+   memset(ref, 0, dst_size);
+
+   for (y = 0; y < HEIGHT; y++) {
+      for (x = 0; x < WIDTH; x++) {
+         run_op(desc, op,
+                ref + y * dst_stride + x * (dst_stride / WIDTH), dst_stride,
+                src + y * src_stride + x * (src_stride / WIDTH), src_stride,
+                1, 1);
+      }
+   }
+
+   start = os_time_get();
+   for (i = 0; i < ITERATIONS; i++)
+      run_op(desc, op, dst, dst_stride, src, src_stride, WIDTH, HEIGHT);
+   end = os_time_get();
+
+   printf("%-20s %-18s %8.1f Mpixels/s\n", desc->short_name, op_names[op],
+          (double)WIDTH * HEIGHT * ITERATIONS / MAX2(end - start, 1));
+
+   if (memcmp(dst, ref, dst_size) != 0) {
+      printf("%s: %s of whole rows differs from one pixel at a time\n",
+             desc->short_name, op_names[op]);
+      success = FALSE;
+   }
+
+   FREE(src);
+   FREE(dst);
+   FREE(ref);
+
+   return success;
+}
+
+
+int main(int argc, char **argv)
+{
+   boolean success = TRUE;
+   unsigned i, op;
+
+   for (i = 0; i < Elements(formats); i++) {
+      const struct util_format_description *desc =
+         util_format_description(formats[i]);
+
+      for (op = UNPACK_RGBA_FLOAT; op <= UNPACK_Z_FLOAT; op++) {
+         if (has_op(desc, op))
+            success = test_op(desc, op) && success;
+      }
+   }
+
+   return success ? 0 : 1;
+}
@@ -0,0 +1,222 @@
+#!/usr/bin/env python
+##########################################################################
+#
+# Copyright 2016 VMware, Inc.
+# All Rights Reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sub license, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+#
+# The above copyright notice and this permission notice (including the
+# next paragraph) shall be included in all copies or substantial portions
+# of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+# IN NO EVENT SHALL VMWARE AND/OR ITS SUPPLIERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+##########################################################################
+
+'''Converts a binary trace (GALLIUM_TRACE_FORMAT=binary) to the XML written
+by the trace driver by default, for use with the other tools.
+
+See src/gallium/drivers/trace/tr_dump_bin.h for the format.'''
+
+
+import sys
+import struct
+import optparse
+
+
+MAGIC = 'GALLIUM-TRACE-BIN'
+VERSION = 1
+
+(STRING_DEF, BYTES_DEF, CALL_BEGIN, CALL_END, ARG_BEGIN, ARG_END,
+ RET_BEGIN, RET_END, BOOL, INT, UINT, FLOAT, BYTES, BYTES_INLINE, STRING,
+ ENUM, ARRAY_BEGIN, ARRAY_END, ELEM_BEGIN, ELEM_END, STRUCT_BEGIN,
+ STRUCT_END, MEMBER_BEGIN, MEMBER_END, NULL, PTR) = range(1, 27)
+
+
+class TruncatedTrace(Exception):
+    pass
+
+
+def escape(s):
+    '''Mimics trace_dump_escape.'''
+    out = []
+    for c in s:
+        o = ord(c)
+        if c == '<':
+            out.append('&lt;')
+        elif c == '>':
+            out.append('&gt;')
+        elif c == '&':
+            out.append('&amp;')
+        elif c == '\'':
+            out.append('&apos;')
+        elif c == '"':
+            out.append('&quot;')
+        elif o >= 0x20 and o <= 0x7e:
+            out.append(c)
+        else:
+            out.append('&#%u;' % o)
+    return ''.join(out)
+
+
+class BinaryTraceConverter:
+
+    def __init__(self, data, out):
+        self.data = data
+        self.pos = 0
+        self.out = out
+        self.names = []
+        self.blobs = []
+        self.call_no = 0
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise TruncatedTrace
+        b = ord(self.data[self.pos])
+        self.pos += 1
+        return b
+
+    def uint(self):
+        value = 0
+        shift = 0
+        while True:
+            b = self.byte()
+            value |= (b & 0x7f) << shift
+            shift += 7
+            if not b & 0x80:
+                return value
+
+    def int(self):
+        value = self.uint()
+        return (value >> 1) ^ -(value & 1)
+
+    def raw(self, size):
+        if self.pos + size > len(self.data):
+            raise TruncatedTrace
+        s = self.data[self.pos:self.pos + size]
+        self.pos += size
+        return s
+
+    def chunk(self):
+        return self.raw(self.uint())
+
+    def name(self):
+        return self.names[self.uint()]
+
+    def write(self, s):
+        self.out.write(s)
+
+    def write_bytes(self, s):
+        self.write('<bytes>' + ''.join(['%02X' % ord(c) for c in s]) + '</bytes>')
+
+    def convert(self):
+        if self.raw(len(MAGIC)) != MAGIC:
+            raise ValueError('not a binary gallium trace')
+        version = self.byte()
+        if version != VERSION:
+            raise ValueError('unsupported binary trace version %u' % version)
+
+        self.write("<?xml version='1.0' encoding='UTF-8'?>\n")
+        self.write("<?xml-stylesheet type='text/xsl' href='trace.xsl'?>\n")
+        self.write("<trace version='0.1'>\n")
+        try:
+            while self.pos < len(self.data):
+                self.convert_op(self.byte())
+        except TruncatedTrace:
+            sys.stderr.write('warning: the trace is truncated\n')
+        self.write('</trace>\n')
+
+    def convert_op(self, op):
+        write = self.write
+        if op == STRING_DEF:
+            self.names.append(self.chunk())
+        elif op == BYTES_DEF:
+            self.blobs.append(self.chunk())
+        elif op == CALL_BEGIN:
+            klass = self.name()
+            method = self.name()
+            self.call_no += 1
+            write("\t<call no='%u' class='%s' method='%s'>\n" %
+                  (self.call_no, escape(klass), escape(method)))
+        elif op == CALL_END:
+            write('\t\t<time><int>%i</int></time>\n\t</call>\n' % self.int())
+        elif op == ARG_BEGIN:
+            write("\t\t<arg name='%s'>" % escape(self.name()))
+        elif op == ARG_END:
+            write('</arg>\n')
+        elif op == RET_BEGIN:
+            write('\t\t<ret>')
+        elif op == RET_END:
+            write('</ret>\n')
+        elif op == BOOL:
+            write('<bool>%u</bool>' % (self.uint() != 0))
+        elif op == INT:
+            write('<int>%i</int>' % self.int())
+        elif op == UINT:
+            write('<uint>%u</uint>' % self.uint())
+        elif op == FLOAT:
+            write('<float>%g</float>' % struct.unpack('<d', self.raw(8))[0])
+        elif op == BYTES:
+            self.write_bytes(self.blobs[self.uint()])
+        elif op == BYTES_INLINE:
+            self.write_bytes(self.chunk())
+        elif op == STRING:
+            write('<string>%s</string>' % escape(self.chunk()))
+        elif op == ENUM:
+            write('<enum>%s</enum>' % escape(self.name()))
+        elif op == ARRAY_BEGIN:
+            write('<array>')
+        elif op == ARRAY_END:
+            write('</array>')
+        elif op == ELEM_BEGIN:
+            write('<elem>')
+        elif op == ELEM_END:
+            write('</elem>')
+        elif op == STRUCT_BEGIN:
+            write("<struct name='%s'>" % self.name())
+        elif op == STRUCT_END:
+            write('</struct>')
+        elif op == MEMBER_BEGIN:
+            write("<member name='%s'>" % self.name())
+        elif op == MEMBER_END:
+            write('</member>')
+        elif op == NULL:
+            write('<null/>')
+        elif op == PTR:
+            write('<ptr>0x%08x</ptr>' % self.uint())
+        else:
+            raise ValueError('unknown opcode %u at offset %u' %
+                             (op, self.pos - 1))
+
+
+def main():
+    optparser = optparse.OptionParser(
+        usage="\n\t%prog [options] BINARY-TRACE [XML-TRACE]")
+    (options, args) = optparser.parse_args(sys.argv[1:])
+
+    if len(args) not in (1, 2):
+        optparser.error('incorrect number of arguments')
+
+    data = open(args[0], 'rb').read()
+    if len(args) > 1:
+        out = open(args[1], 'wt')
+    else:
+        out = sys.stdout
+    BinaryTraceConverter(data, out).convert()
+
+
+if __name__ == '__main__':
+    main()
@@ -49,6 +49,22 @@ static bool amdgpu_bo_wait(struct pb_buffer *_buf, uint64_t timeout,
    struct amdgpu_winsys *ws = bo->ws;
    int i;
 
+   if (bo->sparse) {
+      bool idle = true;
+
+      /* The timeout applies to each backing buffer, which is fine for
+       * the 0 and infinite timeouts that are used in practice. */
+      pipe_mutex_lock(bo->commit_lock);
+      for (i = 0; idle && i < bo->num_backings; i++)
+         idle = amdgpu_bo_wait(&bo->backings[i].bo->base, timeout, usage);
+      pipe_mutex_unlock(bo->commit_lock);
+      return idle;
+   }
+
+   /* Wait if any ioctl is being submitted with this buffer. */
+   if (!os_wait_until_zero(&bo->num_active_ioctls, timeout))
+      return false;
+
    if (bo->is_shared) {
       /* We can't use user fences for shared buffers, because user fences
        * are local to this process only. If we want to wait for all buffer
@@ -161,6 +177,11 @@ static void *amdgpu_bo_map(struct pb_buffer *buf,
    int r;
    void *cpu = NULL;
 
+   /* Sparse buffers have no kernel BO that could be mapped. */
+   assert(!bo->sparse);
+   if (bo->sparse)
+      return NULL;
+
    /* If it's not unsynchronized bo_map, flush CS if needed and then wait. */
    if (!(usage & PIPE_TRANSFER_UNSYNCHRONIZED)) {
       /* DONTBLOCK doesn't make sense with UNSYNCHRONIZED. */
@@ -205,16 +226,29 @@ static void *amdgpu_bo_map(struct pb_buffer *buf,
              * (neither one is changing it).
              *
              * Only check whether the buffer is being used for write. */
-            if (cs && amdgpu_bo_is_referenced_by_cs_with_usage(cs, bo,
-                                                               RADEON_USAGE_WRITE)) {
-               cs->flush_cs(cs->flush_data, 0, NULL);
+            if (cs) {
+               if (amdgpu_bo_is_referenced_by_cs_with_usage(cs, bo,
+                                                            RADEON_USAGE_WRITE)) {
+                  cs->flush_cs(cs->flush_data, 0, NULL);
+               } else {
+                  /* Try to avoid busy-waiting in amdgpu_bo_wait. */
+                  if (p_atomic_read(&bo->num_active_ioctls))
+                     amdgpu_cs_sync_flush(rcs);
+               }
             }
             amdgpu_bo_wait((struct pb_buffer*)bo, PIPE_TIMEOUT_INFINITE,
                            RADEON_USAGE_WRITE);
          } else {
             /* Mapping for write. */
-            if (cs && amdgpu_bo_is_referenced_by_cs(cs, bo))
-               cs->flush_cs(cs->flush_data, 0, NULL);
+            if (cs) {
+               if (amdgpu_bo_is_referenced_by_cs(cs, bo)) {
+                  cs->flush_cs(cs->flush_data, 0, NULL);
+               } else {
+                  /* Try to avoid busy-waiting in amdgpu_bo_wait. */
+                  if (p_atomic_read(&bo->num_active_ioctls))
+                     amdgpu_cs_sync_flush(rcs);
+               }
+            }
 
             amdgpu_bo_wait((struct pb_buffer*)bo, PIPE_TIMEOUT_INFINITE,
                            RADEON_USAGE_READWRITE);
@@ -343,6 +377,219 @@ bool amdgpu_bo_can_reclaim(struct pb_buffer *_buf)
    return amdgpu_bo_wait(_buf, 0, RADEON_USAGE_READWRITE);
 }
 
+static void amdgpu_bo_sparse_unmap_page(struct amdgpu_winsys_bo *bo,
+                                        unsigned page)
+{
+   struct amdgpu_sparse_commitment *commitment = &bo->commitments[page];
+   struct amdgpu_winsys_bo *backing = commitment->backing;
+   unsigned i;
+
+   amdgpu_bo_va_op(backing->bo,
+                   (uint64_t)commitment->page * RADEON_SPARSE_PAGE_SIZE,
+                   RADEON_SPARSE_PAGE_SIZE,
+                   bo->va + (uint64_t)page * RADEON_SPARSE_PAGE_SIZE,
+                   0, AMDGPU_VA_OP_UNMAP);
+   commitment->backing = NULL;
+
+   for (i = 0; i < bo->num_backings; i++) {
+      if (bo->backings[i].bo == backing)
+         break;
+   }
+   assert(i < bo->num_backings);
+
+   /* Release the backing buffer with its last page. Command streams that
+    * still use it hold their own reference. */
+   if (--bo->backings[i].num_committed_pages == 0) {
+      amdgpu_winsys_bo_reference(&bo->backings[i].bo, NULL);
+      bo->backings[i] = bo->backings[--bo->num_backings];
+   }
+}
+
+static void amdgpu_bo_sparse_destroy(struct pb_buffer *_buf)
+{
+   struct amdgpu_winsys_bo *bo = amdgpu_winsys_bo(_buf);
+   unsigned page;
+
+   for (page = 0; page < bo->num_pages; page++) {
+      if (bo->commitments[page].backing)
+         amdgpu_bo_sparse_unmap_page(bo, page);
+   }
+   assert(bo->num_backings == 0);
+
+   amdgpu_va_range_free(bo->va_handle);
+   pipe_mutex_destroy(bo->commit_lock);
+   FREE(bo->commitments);
+   FREE(bo->backings);
+   FREE(bo);
+}
+
+static const struct pb_vtbl amdgpu_winsys_bo_sparse_vtbl = {
+   amdgpu_bo_sparse_destroy
+   /* other functions are never called */
+};
+
+static struct pb_buffer *amdgpu_bo_sparse_create(struct amdgpu_winsys *ws,
+                                                 unsigned size,
+                                                 enum radeon_bo_domain domain)
+{
+   struct amdgpu_winsys_bo *bo;
+   int r;
+
+   bo = CALLOC_STRUCT(amdgpu_winsys_bo);
+   if (!bo)
+      return NULL;
+
+   size = align(size, RADEON_SPARSE_PAGE_SIZE);
+   bo->num_pages = size / RADEON_SPARSE_PAGE_SIZE;
+   bo->commitments = CALLOC(bo->num_pages, sizeof(*bo->commitments));
+   if (!bo->commitments)
+      goto error_commitments;
+
+   r = amdgpu_va_range_alloc(ws->dev, amdgpu_gpu_va_range_general,
+                             size, RADEON_SPARSE_PAGE_SIZE, 0,
+                             &bo->va, &bo->va_handle, 0);
+   if (r)
+      goto error_va_alloc;
+
+   pipe_reference_init(&bo->base.reference, 1);
+   bo->base.alignment = RADEON_SPARSE_PAGE_SIZE;
+   bo->base.usage = PB_USAGE_GPU_WRITE | PB_USAGE_GPU_READ;
+   bo->base.size = size;
+   bo->base.vtbl = &amdgpu_winsys_bo_sparse_vtbl;
+   bo->ws = ws;
+   bo->initial_domain = domain;
+   bo->unique_id = __sync_fetch_and_add(&ws->next_bo_unique_id, 1);
+   bo->sparse = true;
+   pipe_mutex_init(bo->commit_lock);
+   return &bo->base;
+
+error_va_alloc:
+   FREE(bo->commitments);
+error_commitments:
+   FREE(bo);
+   return NULL;
+}
+
+/* Allocate a buffer for num_pages pages and add it to the backing buffers. */
+static struct amdgpu_sparse_backing *
+amdgpu_bo_sparse_add_backing(struct amdgpu_winsys_bo *bo, unsigned num_pages)
+{
+   struct amdgpu_winsys_bo *backing;
+
+   if (bo->num_backings == bo->max_backings) {
+      unsigned max_backings = MAX2(8, bo->max_backings * 2);
+      struct amdgpu_sparse_backing *backings =
+         REALLOC(bo->backings,
+                 bo->max_backings * sizeof(*bo->backings),
+                 max_backings * sizeof(*bo->backings));
+      if (!backings)
+         return NULL;
+
+      bo->backings = backings;
+      bo->max_backings = max_backings;
+   }
+
+   backing = amdgpu_create_bo(bo->ws, num_pages * RADEON_SPARSE_PAGE_SIZE,
+                              RADEON_SPARSE_PAGE_SIZE, 0, bo->initial_domain,
+                              0);
+   if (!backing) {
+      /* Clear the cache and try again. */
+      pb_cache_release_all_buffers(&bo->ws->bo_cache);
+      backing = amdgpu_create_bo(bo->ws, num_pages * RADEON_SPARSE_PAGE_SIZE,
+                                 RADEON_SPARSE_PAGE_SIZE, 0,
+                                 bo->initial_domain, 0);
+      if (!backing)
+         return NULL;
+   }
+
+   bo->backings[bo->num_backings].bo = backing;
+   bo->backings[bo->num_backings].num_committed_pages = 0;
+   return &bo->backings[bo->num_backings++];
+}
+
+/* Each page is mapped separately, because the kernel can only unmap whole
+ * mappings. Runs of pages that are committed together share one backing
+ * buffer to keep the number of buffers in command streams low.
+ */
+static bool amdgpu_bo_sparse_commit(struct pb_buffer *buf, uint64_t offset,
+                                    uint64_t size, bool commit)
+{
+   struct amdgpu_winsys_bo *bo = amdgpu_winsys_bo(buf);
+   unsigned page = offset / RADEON_SPARSE_PAGE_SIZE;
+   unsigned end = (offset + size + RADEON_SPARSE_PAGE_SIZE - 1) /
+                  RADEON_SPARSE_PAGE_SIZE;
+   bool ok = true;
+
+   assert(bo->sparse);
+   assert(offset % RADEON_SPARSE_PAGE_SIZE == 0);
+   assert(end <= bo->num_pages);
+
+   pipe_mutex_lock(bo->commit_lock);
+
+   if (commit) {
+      while (page < end) {
+         struct amdgpu_sparse_backing *backing;
+         unsigned num_pages, i;
+
+         if (bo->commitments[page].backing) {
+            page++;
+            continue;
+         }
+
+         for (num_pages = 1; page + num_pages < end; num_pages++) {
+            if (bo->commitments[page + num_pages].backing)
+               break;
+         }
+
+         backing = amdgpu_bo_sparse_add_backing(bo, num_pages);
+         if (!backing) {
+            ok = false;
+            break;
+         }
+
+         for (i = 0; i < num_pages; i++) {
+            if (amdgpu_bo_va_op(backing->bo->bo,
+                                (uint64_t)i * RADEON_SPARSE_PAGE_SIZE,
+                                RADEON_SPARSE_PAGE_SIZE,
+                                bo->va +
+                                (uint64_t)(page + i) * RADEON_SPARSE_PAGE_SIZE,
+                                0, AMDGPU_VA_OP_MAP)) {
+               ok = false;
+               break;
+            }
+            bo->commitments[page + i].backing = backing->bo;
+            bo->commitments[page + i].page = i;
+            backing->num_committed_pages++;
+         }
+
+         if (!backing->num_committed_pages) {
+            amdgpu_winsys_bo_reference(&backing->bo, NULL);
+            bo->num_backings--;
+         }
+         if (!ok)
+            break;
+
+         page += num_pages;
+      }
+   } else {
+      for (; page < end; page++) {
+         struct amdgpu_winsys_bo *backing = bo->commitments[page].backing;
+
+         if (!backing)
+            continue;
+
+         /* Make sure that command streams using the page have reached the
+          * kernel, which then defers the unmap until they are done. */
+         os_wait_until_zero(&backing->num_active_ioctls,
+                            PIPE_TIMEOUT_INFINITE);
+         amdgpu_bo_sparse_unmap_page(bo, page);
+      }
+   }
+
+   pipe_mutex_unlock(bo->commit_lock);
+   return ok;
+}
+
 static unsigned eg_tile_split(unsigned tile_split)
 {
    switch (tile_split) {
@@ -463,6 +710,9 @@ amdgpu_bo_create(struct radeon_winsys *rws,
    struct amdgpu_winsys_bo *bo;
    unsigned usage = 0;
 
+   if (flags & RADEON_FLAG_SPARSE)
+      return amdgpu_bo_sparse_create(ws, size, domain);
+
    /* Don't use VRAM if the GPU doesn't have much. This is only the initial
     * domain. The kernel is free to move the buffer if it wants to.
     *
@@ -609,6 +859,9 @@ static boolean amdgpu_bo_get_handle(struct pb_buffer *buffer,
    enum amdgpu_bo_handle_type type;
    int r;
 
+   if (bo->sparse)
+      return FALSE;
+
    bo->use_reusable_pool = false;
 
    switch (whandle->type) {
@@ -701,6 +954,7 @@ void amdgpu_bo_init_functions(struct amdgpu_winsys *ws)
    ws->base.buffer_create = amdgpu_bo_create;
    ws->base.buffer_from_handle = amdgpu_bo_from_handle;
    ws->base.buffer_from_ptr = amdgpu_bo_from_ptr;
+   ws->base.buffer_commit = amdgpu_bo_sparse_commit;
    ws->base.buffer_get_handle = amdgpu_bo_get_handle;
    ws->base.buffer_get_virtual_address = amdgpu_bo_get_va;
    ws->base.buffer_get_initial_domain = amdgpu_bo_get_initial_domain;
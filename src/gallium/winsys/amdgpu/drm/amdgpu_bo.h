@@ -36,6 +36,17 @@
 #include "amdgpu_winsys.h"
 #include "pipebuffer/pb_bufmgr.h"
 
+/* A buffer whose pages back committed pages of sparse buffers. */
+struct amdgpu_sparse_backing {
+   struct amdgpu_winsys_bo *bo;
+   unsigned num_committed_pages;
+};
+
+struct amdgpu_sparse_commitment {
+   struct amdgpu_winsys_bo *backing; /* NULL if the page isn't committed */
+   uint32_t page; /* the page of the backing buffer */
+};
+
 struct amdgpu_winsys_bo {
    struct pb_buffer base;
    struct pb_cache_entry cache_entry;
@@ -53,6 +64,10 @@ struct amdgpu_winsys_bo {
    /* how many command streams is this bo referenced in? */
    int num_cs_references;
 
+   /* how many command streams, which are being emitted in a separate
+    * thread, is this bo referenced in? */
+   int num_active_ioctls;
+
    /* whether buffer_get_handle or buffer_from_handle was called,
     * it can only transition from false to true
     */
@@ -60,6 +75,19 @@ struct amdgpu_winsys_bo {
 
    /* Fences for buffer synchronization. */
    struct pipe_fence_handle *fence[RING_LAST];
+
+   /* Sparse buffers only own a VA range and have no kernel BO. Each
+    * committed page is a page of a backing buffer mapped into the range.
+    * Command streams use the backing buffers, so the fences above are
+    * unused and waiting for a sparse buffer waits for its backing buffers.
+    */
+   bool sparse;
+   pipe_mutex commit_lock;
+   unsigned num_pages;
+   struct amdgpu_sparse_commitment *commitments;
+   unsigned num_backings;
+   unsigned max_backings;
+   struct amdgpu_sparse_backing *backings;
 };
 
 bool amdgpu_bo_can_reclaim(struct pb_buffer *_buf);
@@ -50,6 +50,7 @@ amdgpu_fence_create(struct amdgpu_ctx *ctx, unsigned ip_type,
    fence->fence.ip_type = ip_type;
    fence->fence.ip_instance = ip_instance;
    fence->fence.ring = ring;
+   fence->submission_in_progress = true;
    p_atomic_inc(&ctx->refcount);
    return (struct pipe_fence_handle *)fence;
 }
@@ -62,6 +63,7 @@ static void amdgpu_fence_submitted(struct pipe_fence_handle *fence,
 
    rfence->fence.fence = request->seq_no;
    rfence->user_fence_cpu_address = user_fence_cpu_address;
+   rfence->submission_in_progress = false;
 }
 
 static void amdgpu_fence_signalled(struct pipe_fence_handle *fence)
@@ -69,6 +71,7 @@ static void amdgpu_fence_signalled(struct pipe_fence_handle *fence)
    struct amdgpu_fence *rfence = (struct amdgpu_fence*)fence;
 
    rfence->signalled = true;
+   rfence->submission_in_progress = false;
 }
 
 bool amdgpu_fence_wait(struct pipe_fence_handle *fence, uint64_t timeout,
@@ -88,6 +91,13 @@ bool amdgpu_fence_wait(struct pipe_fence_handle *fence, uint64_t timeout,
    else
       abs_timeout = os_time_get_absolute_timeout(timeout);
 
+   /* The fence might not have a number assigned if its IB is being
+    * submitted in the other thread right now. Wait until the submission
+    * is done. */
+   if (!os_wait_until_zero_abs_timeout(&rfence->submission_in_progress,
+                                       abs_timeout))
+      return false;
+
    user_fence_cpu = rfence->user_fence_cpu_address;
    if (user_fence_cpu && *user_fence_cpu >= rfence->fence.fence) {
 	rfence->signalled = true;
@@ -237,17 +247,16 @@ static bool amdgpu_get_new_ib(struct amdgpu_cs *cs)
       cs->big_ib_winsys_buffer = (struct amdgpu_winsys_bo*)cs->big_ib_buffer;
    }
 
-   cs->ib.ib_mc_address = cs->big_ib_winsys_buffer->va + cs->used_ib_space;
+   cs->csc->ib.ib_mc_address = cs->big_ib_winsys_buffer->va +
+                               cs->used_ib_space;
    cs->base.buf = (uint32_t*)(cs->ib_mapped + cs->used_ib_space);
    cs->base.max_dw = ib_size / 4;
    return true;
 }
 
-static boolean amdgpu_init_cs_context(struct amdgpu_cs *cs,
+static boolean amdgpu_init_cs_context(struct amdgpu_cs_context *cs,
                                       enum ring_type ring_type)
 {
-   int i;
-
    switch (ring_type) {
    case RING_DMA:
       cs->request.ip_type = AMDGPU_HW_IP_DMA;
@@ -294,13 +303,12 @@ static boolean amdgpu_init_cs_context(struct amdgpu_cs *cs,
       return FALSE;
    }
 
-   for (i = 0; i < Elements(cs->buffer_indices_hashlist); i++) {
-      cs->buffer_indices_hashlist[i] = -1;
-   }
+   /* The hash table is zeroed, so no entry matches the first generation. */
+   cs->generation = 1;
    return TRUE;
 }
 
-static void amdgpu_cs_context_cleanup(struct amdgpu_cs *cs)
+static void amdgpu_cs_context_cleanup(struct amdgpu_cs_context *cs)
 {
    unsigned i;
 
@@ -310,22 +318,36 @@ static void amdgpu_cs_context_cleanup(struct amdgpu_cs *cs)
       cs->handles[i] = NULL;
       cs->flags[i] = 0;
    }
+   for (i = 0; i < cs->num_sparse_buffers; i++) {
+      p_atomic_dec(&cs->sparse_buffers[i].bo->num_cs_references);
+      amdgpu_winsys_bo_reference(&cs->sparse_buffers[i].bo, NULL);
+   }
+   for (i = 0; i < cs->num_fence_dependencies; i++)
+      amdgpu_fence_reference(&cs->fence_dependencies[i], NULL);
 
    cs->num_buffers = 0;
+   cs->num_sparse_buffers = 0;
+   cs->num_fence_dependencies = 0;
    cs->used_gart = 0;
    cs->used_vram = 0;
+   amdgpu_fence_reference(&cs->fence, NULL);
 
-   for (i = 0; i < Elements(cs->buffer_indices_hashlist); i++) {
-      cs->buffer_indices_hashlist[i] = -1;
+   /* Invalidate the hash table without touching it. Only clear it when the
+    * generation wraps around, so that stale entries can't match again. */
+   if (++cs->generation == 0) {
+      memset(cs->buffer_hash, 0, sizeof(cs->buffer_hash));
+      cs->generation = 1;
    }
 }
 
-static void amdgpu_destroy_cs_context(struct amdgpu_cs *cs)
+static void amdgpu_destroy_cs_context(struct amdgpu_cs_context *cs)
 {
    amdgpu_cs_context_cleanup(cs);
    FREE(cs->flags);
    FREE(cs->buffers);
    FREE(cs->handles);
+   FREE(cs->sparse_buffers);
+   FREE(cs->fence_dependencies);
    FREE(cs->request.dependencies);
 }
 
@@ -351,52 +373,68 @@ amdgpu_cs_create(struct radeon_winsys_ctx *rwctx,
    cs->flush_data = flush_ctx;
    cs->base.ring_type = ring_type;
 
-   if (!amdgpu_init_cs_context(cs, ring_type)) {
+   if (!amdgpu_init_cs_context(&cs->csc1, ring_type)) {
+      FREE(cs);
+      return NULL;
+   }
+
+   if (!amdgpu_init_cs_context(&cs->csc2, ring_type)) {
+      amdgpu_destroy_cs_context(&cs->csc1);
       FREE(cs);
       return NULL;
    }
 
+   /* Set the first command buffer as current. */
+   cs->csc = &cs->csc1;
+   cs->cst = &cs->csc2;
+
    if (!amdgpu_get_new_ib(cs)) {
-      amdgpu_destroy_cs_context(cs);
+      amdgpu_destroy_cs_context(&cs->csc2);
+      amdgpu_destroy_cs_context(&cs->csc1);
       FREE(cs);
       return NULL;
    }
 
+   pipe_semaphore_init(&cs->flush_completed, 1);
+
    p_atomic_inc(&ctx->ws->num_cs);
    return &cs->base;
 }
 
 #define OUT_CS(cs, value) (cs)->buf[(cs)->cdw++] = (value)
 
-int amdgpu_lookup_buffer(struct amdgpu_cs *cs, struct amdgpu_winsys_bo *bo)
+int amdgpu_lookup_buffer(struct amdgpu_cs_context *cs, struct amdgpu_winsys_bo *bo)
 {
-   unsigned hash = bo->unique_id & (Elements(cs->buffer_indices_hashlist)-1);
-   int i = cs->buffer_indices_hashlist[hash];
+   unsigned hash = bo->unique_id & (Elements(cs->buffer_hash)-1);
+   int i;
 
-   /* not found or found */
-   if (i == -1 || cs->buffers[i].bo == bo)
-      return i;
+   /* Entries stamped with an older generation belong to a previous CS. */
+   if (cs->buffer_hash[hash].generation != cs->generation)
+      return -1;
 
-   /* Hash collision, look for the BO in the list of buffers linearly. */
-   for (i = cs->num_buffers - 1; i >= 0; i--) {
-      if (cs->buffers[i].bo == bo) {
-         /* Put this buffer in the hash list.
-          * This will prevent additional hash collisions if there are
-          * several consecutive lookup_buffer calls for the same buffer.
-          *
-          * Example: Assuming buffers A,B,C collide in the hash list,
-          * the following sequence of buffers:
-          *         AAAAAAAAAAABBBBBBBBBBBBBBCCCCCCCC
-          * will collide here: ^ and here:   ^,
-          * meaning that we should get very few collisions in the end. */
-         cs->buffer_indices_hashlist[hash] = i;
+   /* Walk the buffers that share this entry, most recently added first. */
+   for (i = cs->buffer_hash[hash].index; i >= 0;
+        i = cs->buffers[i].next_in_bucket) {
+      if (cs->buffers[i].bo == bo)
          return i;
-      }
    }
    return -1;
 }
 
-static unsigned amdgpu_add_buffer(struct amdgpu_cs *cs,
+struct amdgpu_cs_buffer *
+amdgpu_lookup_sparse_buffer(struct amdgpu_cs_context *cs,
+                            struct amdgpu_winsys_bo *bo)
+{
+   unsigned i;
+
+   for (i = 0; i < cs->num_sparse_buffers; i++) {
+      if (cs->sparse_buffers[i].bo == bo)
+         return &cs->sparse_buffers[i];
+   }
+   return NULL;
+}
+
+static unsigned amdgpu_add_buffer(struct amdgpu_cs_context *cs,
                                  struct amdgpu_winsys_bo *bo,
                                  enum radeon_bo_usage usage,
                                  enum radeon_bo_domain domains,
@@ -404,7 +442,7 @@ static unsigned amdgpu_add_buffer(struct amdgpu_cs *cs,
                                  enum radeon_bo_domain *added_domains)
 {
    struct amdgpu_cs_buffer *buffer;
-   unsigned hash = bo->unique_id & (Elements(cs->buffer_indices_hashlist)-1);
+   unsigned hash = bo->unique_id & (Elements(cs->buffer_hash)-1);
    int i = -1;
 
    assert(priority < 64);
@@ -425,7 +463,7 @@ static unsigned amdgpu_add_buffer(struct amdgpu_cs *cs,
    /* New buffer, check if the backing array is large enough. */
    if (cs->num_buffers >= cs->max_num_buffers) {
       uint32_t size;
-      cs->max_num_buffers += 10;
+      cs->max_num_buffers += MAX2(10, cs->max_num_buffers / 2);
 
       size = cs->max_num_buffers * sizeof(struct amdgpu_cs_buffer);
       cs->buffers = realloc(cs->buffers, size);
@@ -448,12 +486,66 @@ static unsigned amdgpu_add_buffer(struct amdgpu_cs *cs,
    buffer->usage = usage;
    buffer->domains = domains;
 
-   cs->buffer_indices_hashlist[hash] = cs->num_buffers;
+   if (cs->buffer_hash[hash].generation == cs->generation) {
+      buffer->next_in_bucket = cs->buffer_hash[hash].index;
+   } else {
+      buffer->next_in_bucket = -1;
+      cs->buffer_hash[hash].generation = cs->generation;
+   }
+   cs->buffer_hash[hash].index = cs->num_buffers;
 
    *added_domains = domains;
    return cs->num_buffers++;
 }
 
+/* Add a sparse buffer and all of its current backing buffers. Pages that
+ * are committed later aren't seen by this CS, which is why the driver
+ * flushes the CSs that use a buffer before changing its commitment.
+ */
+static unsigned amdgpu_add_sparse_buffer(struct amdgpu_cs_context *cs,
+                                         struct amdgpu_winsys_bo *bo,
+                                         enum radeon_bo_usage usage,
+                                         unsigned priority)
+{
+   struct amdgpu_cs_buffer *buffer = amdgpu_lookup_sparse_buffer(cs, bo);
+   unsigned i;
+
+   if (!buffer) {
+      if (cs->num_sparse_buffers >= cs->max_sparse_buffers) {
+         unsigned size;
+
+         cs->max_sparse_buffers = MAX2(8, cs->max_sparse_buffers * 2);
+         size = cs->max_sparse_buffers * sizeof(struct amdgpu_cs_buffer);
+         cs->sparse_buffers = realloc(cs->sparse_buffers, size);
+      }
+
+      buffer = &cs->sparse_buffers[cs->num_sparse_buffers++];
+      memset(buffer, 0, sizeof(*buffer));
+      amdgpu_winsys_bo_reference(&buffer->bo, bo);
+      p_atomic_inc(&bo->num_cs_references);
+   }
+   buffer->priority_usage |= 1llu << priority;
+   buffer->usage |= usage;
+   buffer->domains |= bo->initial_domain;
+
+   pipe_mutex_lock(bo->commit_lock);
+   for (i = 0; i < bo->num_backings; i++) {
+      struct amdgpu_winsys_bo *backing = bo->backings[i].bo;
+      enum radeon_bo_domain added_domains;
+
+      amdgpu_add_buffer(cs, backing, usage, backing->initial_domain,
+                        priority, &added_domains);
+
+      if (added_domains & RADEON_DOMAIN_GTT)
+         cs->used_gart += backing->base.size;
+      if (added_domains & RADEON_DOMAIN_VRAM)
+         cs->used_vram += backing->base.size;
+   }
+   pipe_mutex_unlock(bo->commit_lock);
+
+   return buffer - cs->sparse_buffers;
+}
+
 static unsigned amdgpu_cs_add_buffer(struct radeon_winsys_cs *rcs,
                                     struct pb_buffer *buf,
                                     enum radeon_bo_usage usage,
@@ -463,11 +555,16 @@ static unsigned amdgpu_cs_add_buffer(struct radeon_winsys_cs *rcs,
    /* Don't use the "domains" parameter. Amdgpu doesn't support changing
     * the buffer placement during command submission.
     */
-   struct amdgpu_cs *cs = amdgpu_cs(rcs);
+   struct amdgpu_cs_context *cs = amdgpu_cs(rcs)->csc;
    struct amdgpu_winsys_bo *bo = (struct amdgpu_winsys_bo*)buf;
    enum radeon_bo_domain added_domains;
-   unsigned index = amdgpu_add_buffer(cs, bo, usage, bo->initial_domain,
-                                     priority, &added_domains);
+   unsigned index;
+
+   if (bo->sparse)
+      return amdgpu_add_sparse_buffer(cs, bo, usage, priority);
+
+   index = amdgpu_add_buffer(cs, bo, usage, bo->initial_domain,
+                             priority, &added_domains);
 
    if (added_domains & RADEON_DOMAIN_GTT)
       cs->used_gart += bo->base.size;
@@ -481,8 +578,15 @@ static int amdgpu_cs_lookup_buffer(struct radeon_winsys_cs *rcs,
                                struct pb_buffer *buf)
 {
    struct amdgpu_cs *cs = amdgpu_cs(rcs);
+   struct amdgpu_winsys_bo *bo = (struct amdgpu_winsys_bo*)buf;
 
-   return amdgpu_lookup_buffer(cs, (struct amdgpu_winsys_bo*)buf);
+   if (bo->sparse) {
+      struct amdgpu_cs_buffer *buffer =
+         amdgpu_lookup_sparse_buffer(cs->csc, bo);
+
+      return buffer ? buffer - cs->csc->sparse_buffers : -1;
+   }
+   return amdgpu_lookup_buffer(cs->csc, bo);
 }
 
 static boolean amdgpu_cs_validate(struct radeon_winsys_cs *rcs)
@@ -493,9 +597,10 @@ static boolean amdgpu_cs_validate(struct radeon_winsys_cs *rcs)
 static boolean amdgpu_cs_memory_below_limit(struct radeon_winsys_cs *rcs, uint64_t vram, uint64_t gtt)
 {
    struct amdgpu_cs *cs = amdgpu_cs(rcs);
+   struct amdgpu_winsys *ws = cs->ctx->ws;
    boolean status =
-         (cs->used_gart + gtt) < cs->ctx->ws->info.gart_size * 0.7 &&
-         (cs->used_vram + vram) < cs->ctx->ws->info.vram_size * 0.7;
+         (cs->csc->used_gart + gtt) < ws->info.gart_size * 0.7 &&
+         (cs->csc->used_vram + vram) < ws->info.vram_size * 0.7;
 
    return status;
 }
@@ -503,7 +608,7 @@ static boolean amdgpu_cs_memory_below_limit(struct radeon_winsys_cs *rcs, uint64
 static unsigned amdgpu_cs_get_buffer_list(struct radeon_winsys_cs *rcs,
                                           struct radeon_bo_list_item *list)
 {
-    struct amdgpu_cs *cs = amdgpu_cs(rcs);
+    struct amdgpu_cs_context *cs = amdgpu_cs(rcs)->csc;
     int i;
 
     if (list) {
@@ -516,65 +621,163 @@ static unsigned amdgpu_cs_get_buffer_list(struct radeon_winsys_cs *rcs,
     return cs->num_buffers;
 }
 
-static void amdgpu_cs_do_submission(struct amdgpu_cs *cs,
-                                    struct pipe_fence_handle **out_fence)
+/* Gather the fences of other rings that the buffers of the CS are still
+ * busy with, and make the CS's own fence the last use of its buffers.
+ * Must be called with bo_fence_lock held. */
+static void amdgpu_cs_add_fence_dependencies(struct amdgpu_cs *acs)
 {
-   struct amdgpu_winsys *ws = cs->ctx->ws;
-   struct pipe_fence_handle *fence;
-   int i, j, r;
-
-   /* Create a fence. */
-   fence = amdgpu_fence_create(cs->ctx,
-                               cs->request.ip_type,
-                               cs->request.ip_instance,
-                               cs->request.ring);
-   if (out_fence)
-      amdgpu_fence_reference(out_fence, fence);
+   struct amdgpu_cs_context *cs = acs->cst;
+   struct amdgpu_fence *fence = (struct amdgpu_fence*)cs->fence;
+   int i, j;
 
-   cs->request.number_of_dependencies = 0;
+   cs->num_fence_dependencies = 0;
 
    /* Since the kernel driver doesn't synchronize execution between different
     * rings automatically, we have to add fence dependencies manually. */
-   pipe_mutex_lock(ws->bo_fence_lock);
    for (i = 0; i < cs->num_buffers; i++) {
+      struct amdgpu_winsys_bo *bo = cs->buffers[i].bo;
+
       for (j = 0; j < RING_LAST; j++) {
-         struct amdgpu_cs_fence *dep;
+         struct amdgpu_fence *bo_fence = (void *)bo->fence[j];
          unsigned idx;
 
-         struct amdgpu_fence *bo_fence = (void *)cs->buffers[i].bo->fence[j];
          if (!bo_fence)
             continue;
 
-         if (bo_fence->ctx == cs->ctx &&
-             bo_fence->fence.ip_type == cs->request.ip_type &&
-             bo_fence->fence.ip_instance == cs->request.ip_instance &&
-             bo_fence->fence.ring == cs->request.ring)
+         if (bo_fence->ctx == fence->ctx &&
+             bo_fence->fence.ip_type == fence->fence.ip_type &&
+             bo_fence->fence.ip_instance == fence->fence.ip_instance &&
+             bo_fence->fence.ring == fence->fence.ring)
             continue;
 
          if (amdgpu_fence_wait((void *)bo_fence, 0, false))
             continue;
 
-         idx = cs->request.number_of_dependencies++;
-         if (idx >= cs->max_dependencies) {
+         idx = cs->num_fence_dependencies++;
+         if (idx >= cs->max_fence_dependencies) {
             unsigned size;
 
-            cs->max_dependencies = idx + 8;
-            size = cs->max_dependencies * sizeof(struct amdgpu_cs_fence);
-            cs->request.dependencies = realloc(cs->request.dependencies, size);
+            cs->max_fence_dependencies = idx + 8;
+            size = cs->max_fence_dependencies *
+                   sizeof(struct pipe_fence_handle*);
+            cs->fence_dependencies = realloc(cs->fence_dependencies, size);
+            /* Clear the newly-allocated elements. */
+            memset(cs->fence_dependencies + idx, 0,
+                   8 * sizeof(struct pipe_fence_handle*));
          }
 
-         dep = &cs->request.dependencies[idx];
-         memcpy(dep, &bo_fence->fence, sizeof(*dep));
+         amdgpu_fence_reference(&cs->fence_dependencies[idx],
+                                (struct pipe_fence_handle*)bo_fence);
+      }
+   }
+
+   for (i = 0; i < cs->num_buffers; i++)
+      amdgpu_fence_reference(&cs->buffers[i].bo->fence[acs->base.ring_type],
+                             cs->fence);
+}
+
+/* Make acs->bo_list describe the buffers of cs. The kernel list of the
+ * previous submission is kept and reused as is if the buffers and their
+ * priorities haven't changed, which is the common case for a CS that is
+ * flushed every frame. Buffers are compared by unique ID, because libdrm
+ * may hand out the handle of a freed buffer again. */
+static int amdgpu_cs_update_bo_list(struct amdgpu_cs *acs,
+                                    struct amdgpu_cs_context *cs)
+{
+   struct amdgpu_winsys *ws = acs->ctx->ws;
+   unsigned i;
+   int r;
+
+   if (acs->bo_list && acs->bo_list_size == cs->num_buffers &&
+       memcmp(acs->bo_list_flags, cs->flags, cs->num_buffers) == 0) {
+      for (i = 0; i < cs->num_buffers; i++) {
+         if (acs->bo_list_ids[i] != cs->buffers[i].bo->unique_id)
+            break;
+      }
+      if (i == cs->num_buffers)
+         return 0;
+   }
+
+   if (acs->bo_list) {
+      r = amdgpu_bo_list_update(acs->bo_list, cs->num_buffers,
+                                cs->handles, cs->flags);
+   } else {
+      r = amdgpu_bo_list_create(ws->dev, cs->num_buffers,
+                                cs->handles, cs->flags, &acs->bo_list);
+   }
+   if (r) {
+      if (acs->bo_list)
+         amdgpu_bo_list_destroy(acs->bo_list);
+      acs->bo_list = NULL;
+      acs->bo_list_size = 0;
+      return r;
+   }
+
+   if (cs->num_buffers > acs->bo_list_max_size) {
+      acs->bo_list_max_size = cs->max_num_buffers;
+      acs->bo_list_ids = realloc(acs->bo_list_ids,
+                                 acs->bo_list_max_size * sizeof(uint32_t));
+      acs->bo_list_flags = realloc(acs->bo_list_flags,
+                                   acs->bo_list_max_size);
+   }
+
+   for (i = 0; i < cs->num_buffers; i++)
+      acs->bo_list_ids[i] = cs->buffers[i].bo->unique_id;
+   memcpy(acs->bo_list_flags, cs->flags, cs->num_buffers);
+   acs->bo_list_size = cs->num_buffers;
+   return 0;
+}
+
+/* Submit the CS that was swapped into cst. This is called from the
+ * submission thread if there is one. */
+void amdgpu_cs_submit_ib(struct amdgpu_cs *acs)
+{
+   struct amdgpu_cs_context *cs = acs->cst;
+   int i, r;
+
+   cs->request.number_of_dependencies = 0;
+
+   for (i = 0; i < cs->num_fence_dependencies; i++) {
+      struct amdgpu_fence *fence =
+         (struct amdgpu_fence*)cs->fence_dependencies[i];
+      unsigned idx;
+
+      /* Fences are queued in the order they become visible to other CSs,
+       * so a dependency is always submitted before us. This only waits when
+       * another thread is submitting without the submission thread. */
+      os_wait_until_zero(&fence->submission_in_progress,
+                         PIPE_TIMEOUT_INFINITE);
+      if (fence->signalled)
+         continue;
+
+      idx = cs->request.number_of_dependencies++;
+      if (idx >= cs->max_dependencies) {
+         unsigned size;
+
+         cs->max_dependencies = idx + 8;
+         size = cs->max_dependencies * sizeof(struct amdgpu_cs_fence);
+         cs->request.dependencies = realloc(cs->request.dependencies, size);
       }
+
+      memcpy(&cs->request.dependencies[idx], &fence->fence,
+             sizeof(struct amdgpu_cs_fence));
+   }
+
+   r = amdgpu_cs_update_bo_list(acs, cs);
+   if (r) {
+      fprintf(stderr, "amdgpu: resource list creation failed (%d)\n", r);
+      amdgpu_fence_signalled(cs->fence);
+      goto cleanup;
    }
+   cs->request.resources = acs->bo_list;
 
    cs->request.fence_info.handle = NULL;
    if (cs->request.ip_type != AMDGPU_HW_IP_UVD && cs->request.ip_type != AMDGPU_HW_IP_VCE) {
-	cs->request.fence_info.handle = cs->ctx->user_fence_bo;
-	cs->request.fence_info.offset = cs->base.ring_type;
+	cs->request.fence_info.handle = acs->ctx->user_fence_bo;
+	cs->request.fence_info.offset = acs->base.ring_type;
    }
 
-   r = amdgpu_cs_submit(cs->ctx->ctx, 0, &cs->request, 1);
+   r = amdgpu_cs_submit(acs->ctx->ctx, 0, &cs->request, 1);
    if (r) {
       if (r == -ENOMEM)
          fprintf(stderr, "amdgpu: Not enough memory for command submission.\n");
@@ -582,26 +785,33 @@ static void amdgpu_cs_do_submission(struct amdgpu_cs *cs,
          fprintf(stderr, "amdgpu: The CS has been rejected, "
                  "see dmesg for more information.\n");
 
-      amdgpu_fence_signalled(fence);
+      amdgpu_fence_signalled(cs->fence);
    } else {
       /* Success. */
       uint64_t *user_fence = NULL;
       if (cs->request.ip_type != AMDGPU_HW_IP_UVD && cs->request.ip_type != AMDGPU_HW_IP_VCE)
-         user_fence = cs->ctx->user_fence_cpu_address_base +
+         user_fence = acs->ctx->user_fence_cpu_address_base +
                       cs->request.fence_info.offset;
-      amdgpu_fence_submitted(fence, &cs->request, user_fence);
-
-      for (i = 0; i < cs->num_buffers; i++)
-         amdgpu_fence_reference(&cs->buffers[i].bo->fence[cs->base.ring_type],
-                                fence);
+      amdgpu_fence_submitted(cs->fence, &cs->request, user_fence);
    }
-   pipe_mutex_unlock(ws->bo_fence_lock);
-   amdgpu_fence_reference(&fence, NULL);
+
+cleanup:
+   for (i = 0; i < cs->num_buffers; i++)
+      p_atomic_dec(&cs->buffers[i].bo->num_active_ioctls);
+
+   amdgpu_cs_context_cleanup(cs);
 }
 
-static void amdgpu_cs_sync_flush(struct radeon_winsys_cs *rcs)
+/* Make sure the previous submission has completed. */
+void amdgpu_cs_sync_flush(struct radeon_winsys_cs *rcs)
 {
-   /* no-op */
+   struct amdgpu_cs *cs = amdgpu_cs(rcs);
+
+   /* Wait for any pending ioctl of this CS to complete. */
+   if (cs->ctx->ws->thread) {
+      pipe_semaphore_wait(&cs->flush_completed);
+      pipe_semaphore_signal(&cs->flush_completed);
+   }
 }
 
 DEBUG_GET_ONCE_BOOL_OPTION(noop, "RADEON_NOOP", FALSE)
@@ -642,30 +852,52 @@ static void amdgpu_cs_flush(struct radeon_winsys_cs *rcs,
 
    /* If the CS is not empty or overflowed.... */
    if (cs->base.cdw && cs->base.cdw <= cs->base.max_dw && !debug_get_option_noop()) {
-      int r;
-
-      r = amdgpu_bo_list_create(ws->dev, cs->num_buffers,
-                                cs->handles, cs->flags,
-                                &cs->request.resources);
-
-      if (r) {
-         fprintf(stderr, "amdgpu: resource list creation failed (%d)\n", r);
-         cs->request.resources = NULL;
-	 goto cleanup;
-      }
+      struct amdgpu_cs_context *cur = cs->csc;
+      unsigned i, num_buffers = cur->num_buffers;
 
-      cs->ib.size = cs->base.cdw;
+      /* Set IB sizes. */
+      cur->ib.size = cs->base.cdw;
       cs->used_ib_space += cs->base.cdw * 4;
 
-      amdgpu_cs_do_submission(cs, fence);
-
-      /* Cleanup. */
-      if (cs->request.resources)
-         amdgpu_bo_list_destroy(cs->request.resources);
+      /* Create a fence. */
+      amdgpu_fence_reference(&cur->fence, NULL);
+      cur->fence = amdgpu_fence_create(cs->ctx,
+                                       cur->request.ip_type,
+                                       cur->request.ip_instance,
+                                       cur->request.ring);
+      if (fence)
+         amdgpu_fence_reference(fence, cur->fence);
+
+      /* Prepare buffers. */
+      for (i = 0; i < num_buffers; i++)
+         p_atomic_inc(&cur->buffers[i].bo->num_active_ioctls);
+
+      amdgpu_cs_sync_flush(rcs);
+
+      /* Swap command streams. "cst" is going to be submitted. */
+      cs->csc = cs->cst;
+      cs->cst = cur;
+
+      /* The fence must become visible on the buffers in the same order
+       * as the CS is queued, so that the submission thread never has
+       * to wait for a dependency queued after it. */
+      pipe_mutex_lock(ws->bo_fence_lock);
+      amdgpu_cs_add_fence_dependencies(cs);
+
+      if (ws->thread) {
+         pipe_semaphore_wait(&cs->flush_completed);
+         amdgpu_ws_queue_cs(ws, cs);
+         pipe_mutex_unlock(ws->bo_fence_lock);
+         if (!(flags & RADEON_FLUSH_ASYNC))
+            amdgpu_cs_sync_flush(rcs);
+      } else {
+         pipe_mutex_unlock(ws->bo_fence_lock);
+         amdgpu_cs_submit_ib(cs);
+      }
+   } else {
+      amdgpu_cs_context_cleanup(cs->csc);
    }
 
-cleanup:
-   amdgpu_cs_context_cleanup(cs);
    amdgpu_get_new_ib(cs);
 
    ws->num_cs_flushes++;
@@ -675,9 +907,16 @@ static void amdgpu_cs_destroy(struct radeon_winsys_cs *rcs)
 {
    struct amdgpu_cs *cs = amdgpu_cs(rcs);
 
-   amdgpu_destroy_cs_context(cs);
+   amdgpu_cs_sync_flush(rcs);
+   pipe_semaphore_destroy(&cs->flush_completed);
+   if (cs->bo_list)
+      amdgpu_bo_list_destroy(cs->bo_list);
+   FREE(cs->bo_list_ids);
+   FREE(cs->bo_list_flags);
    p_atomic_dec(&cs->ctx->ws->num_cs);
    pb_reference(&cs->big_ib_buffer, NULL);
+   amdgpu_destroy_cs_context(&cs->csc1);
+   amdgpu_destroy_cs_context(&cs->csc2);
    FREE(cs);
 }
 
@@ -48,23 +48,16 @@ struct amdgpu_cs_buffer {
    uint64_t priority_usage;
    enum radeon_bo_usage usage;
    enum radeon_bo_domain domains;
+   int next_in_bucket; /* previous buffer with the same hash, or -1 */
 };
 
+struct amdgpu_cs_buffer_hash_entry {
+   unsigned generation;
+   int index; /* the last buffer added with this hash */
+};
 
-struct amdgpu_cs {
-   struct radeon_winsys_cs base;
-   struct amdgpu_ctx *ctx;
-
-   /* Flush CS. */
-   void (*flush_cs)(void *ctx, unsigned flags, struct pipe_fence_handle **fence);
-   void *flush_data;
-
-   /* A buffer out of which new IBs are allocated. */
-   struct pb_buffer *big_ib_buffer; /* for holding the reference */
-   struct amdgpu_winsys_bo *big_ib_winsys_buffer;
-   uint8_t *ib_mapped;
-   unsigned used_ib_space;
 
+struct amdgpu_cs_context {
    /* amdgpu_cs_submit parameters */
    struct amdgpu_cs_request    request;
    struct amdgpu_cs_ib_info    ib;
@@ -76,12 +69,64 @@ struct amdgpu_cs {
    uint8_t                     *flags;
    struct amdgpu_cs_buffer     *buffers;
 
-   int                         buffer_indices_hashlist[512];
+   /* Maps BO unique IDs to buffer indices. Entries are only valid if they
+    * carry the current generation, which is bumped for every new CS. */
+   struct amdgpu_cs_buffer_hash_entry buffer_hash[4096];
+   unsigned                    generation;
+
+   /* Sparse buffers have no kernel BO. They are only kept here to hold
+    * references and track usage, their backing buffers are in "buffers". */
+   unsigned                    num_sparse_buffers;
+   unsigned                    max_sparse_buffers;
+   struct amdgpu_cs_buffer     *sparse_buffers;
 
    uint64_t                    used_vram;
    uint64_t                    used_gart;
 
    unsigned                    max_dependencies;
+
+   /* Fences of other rings this CS must wait for. They are gathered when
+    * the CS is flushed and turned into request.dependencies at submission,
+    * when their sequence numbers are known. */
+   unsigned                    num_fence_dependencies;
+   unsigned                    max_fence_dependencies;
+   struct pipe_fence_handle    **fence_dependencies;
+
+   struct pipe_fence_handle    *fence;
+};
+
+struct amdgpu_cs {
+   struct radeon_winsys_cs base;
+   struct amdgpu_ctx *ctx;
+
+   /* We flip between these two CS. While one is being consumed
+    * by the kernel in another thread, the other one is being filled
+    * by the pipe driver. */
+   struct amdgpu_cs_context csc1;
+   struct amdgpu_cs_context csc2;
+   /* The currently-used CS. */
+   struct amdgpu_cs_context *csc;
+   /* The CS being currently-owned by the other thread. */
+   struct amdgpu_cs_context *cst;
+
+   /* Flush CS. */
+   void (*flush_cs)(void *ctx, unsigned flags, struct pipe_fence_handle **fence);
+   void *flush_data;
+
+   /* A buffer out of which new IBs are allocated. */
+   struct pb_buffer *big_ib_buffer; /* for holding the reference */
+   struct amdgpu_winsys_bo *big_ib_winsys_buffer;
+   uint8_t *ib_mapped;
+   unsigned used_ib_space;
+
+   /* The kernel BO list of the last submission and what it contains. */
+   amdgpu_bo_list_handle bo_list;
+   unsigned bo_list_size;
+   unsigned bo_list_max_size;
+   uint32_t *bo_list_ids;
+   uint8_t *bo_list_flags;
+
+   pipe_semaphore flush_completed;
 };
 
 struct amdgpu_fence {
@@ -91,6 +136,9 @@ struct amdgpu_fence {
    struct amdgpu_cs_fence fence;
    uint64_t *user_fence_cpu_address;
 
+   /* If the fence is unsignalled and was created by a CS that is still
+    * queued for submission, the sequence number isn't known yet. */
+   volatile int submission_in_progress; /* bool (int for atomicity) */
    volatile int signalled;              /* bool (int for atomicity) */
 };
 
@@ -116,7 +164,10 @@ static inline void amdgpu_fence_reference(struct pipe_fence_handle **dst,
    *rdst = rsrc;
 }
 
-int amdgpu_lookup_buffer(struct amdgpu_cs *csc, struct amdgpu_winsys_bo *bo);
+int amdgpu_lookup_buffer(struct amdgpu_cs_context *cs, struct amdgpu_winsys_bo *bo);
+struct amdgpu_cs_buffer *
+amdgpu_lookup_sparse_buffer(struct amdgpu_cs_context *cs,
+                            struct amdgpu_winsys_bo *bo);
 
 static inline struct amdgpu_cs *
 amdgpu_cs(struct radeon_winsys_cs *base)
@@ -129,8 +180,15 @@ amdgpu_bo_is_referenced_by_cs(struct amdgpu_cs *cs,
                               struct amdgpu_winsys_bo *bo)
 {
    int num_refs = bo->num_cs_references;
-   return num_refs == bo->ws->num_cs ||
-         (num_refs && amdgpu_lookup_buffer(cs, bo) != -1);
+
+   if (num_refs == bo->ws->num_cs)
+      return TRUE;
+   if (!num_refs)
+      return FALSE;
+
+   if (bo->sparse)
+      return amdgpu_lookup_sparse_buffer(cs->csc, bo) != NULL;
+   return amdgpu_lookup_buffer(cs->csc, bo) != -1;
 }
 
 static inline boolean
@@ -143,11 +201,18 @@ amdgpu_bo_is_referenced_by_cs_with_usage(struct amdgpu_cs *cs,
    if (!bo->num_cs_references)
       return FALSE;
 
-   index = amdgpu_lookup_buffer(cs, bo);
+   if (bo->sparse) {
+      struct amdgpu_cs_buffer *buffer =
+         amdgpu_lookup_sparse_buffer(cs->csc, bo);
+
+      return buffer && (buffer->usage & usage) != 0;
+   }
+
+   index = amdgpu_lookup_buffer(cs->csc, bo);
    if (index == -1)
       return FALSE;
 
-   return (cs->buffers[index].usage & usage) != 0;
+   return (cs->csc->buffers[index].usage & usage) != 0;
 }
 
 static inline boolean
@@ -158,6 +223,8 @@ amdgpu_bo_is_referenced_by_any_cs(struct amdgpu_winsys_bo *bo)
 
 bool amdgpu_fence_wait(struct pipe_fence_handle *fence, uint64_t timeout,
                        bool absolute);
+void amdgpu_cs_submit_ib(struct amdgpu_cs *cs);
+void amdgpu_cs_sync_flush(struct radeon_winsys_cs *rcs);
 void amdgpu_cs_init_functions(struct amdgpu_winsys *ws);
 
 #endif
@@ -39,6 +39,7 @@
 #include <xf86drm.h>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include "amdgpu_id.h"
 
 #define CIK_TILE_MODE_COLOR_2D			14
@@ -303,6 +304,13 @@ static void amdgpu_winsys_destroy(struct radeon_winsys *rws)
 {
    struct amdgpu_winsys *ws = (struct amdgpu_winsys*)rws;
 
+   if (ws->thread) {
+      ws->kill_thread = 1;
+      pipe_semaphore_signal(&ws->cs_queued);
+      pipe_thread_wait(ws->thread);
+   }
+   pipe_semaphore_destroy(&ws->cs_queued);
+   pipe_mutex_destroy(ws->cs_stack_lock);
    pipe_mutex_destroy(ws->bo_fence_lock);
    pb_cache_deinit(&ws->bo_cache);
    AddrDestroy(ws->addrlib);
@@ -386,6 +394,55 @@ static int compare_dev(void *key1, void *key2)
    return key1 != key2;
 }
 
+void amdgpu_ws_queue_cs(struct amdgpu_winsys *ws, struct amdgpu_cs *cs)
+{
+retry:
+   pipe_mutex_lock(ws->cs_stack_lock);
+   if (ws->ncs >= RING_LAST) {
+      /* no room left for a flush */
+      pipe_mutex_unlock(ws->cs_stack_lock);
+      goto retry;
+   }
+   ws->cs_stack[ws->ncs++] = cs;
+   pipe_mutex_unlock(ws->cs_stack_lock);
+   pipe_semaphore_signal(&ws->cs_queued);
+}
+
+static PIPE_THREAD_ROUTINE(amdgpu_cs_thread_func, param)
+{
+   struct amdgpu_winsys *ws = (struct amdgpu_winsys *)param;
+   struct amdgpu_cs *cs;
+   unsigned i;
+
+   while (1) {
+      pipe_semaphore_wait(&ws->cs_queued);
+      if (ws->kill_thread)
+         break;
+
+      pipe_mutex_lock(ws->cs_stack_lock);
+      cs = ws->cs_stack[0];
+      for (i = 1; i < ws->ncs; i++)
+         ws->cs_stack[i - 1] = ws->cs_stack[i];
+      ws->cs_stack[--ws->ncs] = NULL;
+      pipe_mutex_unlock(ws->cs_stack_lock);
+
+      if (cs) {
+         amdgpu_cs_submit_ib(cs);
+         pipe_semaphore_signal(&cs->flush_completed);
+      }
+   }
+   pipe_mutex_lock(ws->cs_stack_lock);
+   for (i = 0; i < ws->ncs; i++) {
+      pipe_semaphore_signal(&ws->cs_stack[i]->flush_completed);
+      ws->cs_stack[i] = NULL;
+   }
+   ws->ncs = 0;
+   pipe_mutex_unlock(ws->cs_stack_lock);
+   return 0;
+}
+
+DEBUG_GET_ONCE_BOOL_OPTION(thread, "AMDGPU_THREAD", TRUE)
+
 static bool amdgpu_winsys_unref(struct radeon_winsys *rws)
 {
    struct amdgpu_winsys *ws = (struct amdgpu_winsys*)rws;
@@ -478,6 +535,13 @@ amdgpu_winsys_create(int fd, radeon_screen_create_t screen_create)
    amdgpu_surface_init_functions(ws);
 
    pipe_mutex_init(ws->bo_fence_lock);
+   pipe_mutex_init(ws->cs_stack_lock);
+
+   ws->num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+   ws->ncs = 0;
+   pipe_semaphore_init(&ws->cs_queued, 0);
+   if (ws->num_cpus > 1 && debug_get_option_thread())
+      ws->thread = pipe_thread_create(amdgpu_cs_thread_func, ws);
 
    /* Create the screen at the end. The winsys must be initialized
     * completely.
@@ -56,6 +56,15 @@ struct amdgpu_winsys {
    uint64_t buffer_wait_time; /* time spent in buffer_wait in ns */
    uint64_t num_cs_flushes;
    unsigned gart_page_size;
+   uint32_t num_cpus;      /* Number of CPUs. */
+
+   /* rings submission thread */
+   pipe_mutex cs_stack_lock;
+   pipe_semaphore cs_queued;
+   pipe_thread thread;
+   int kill_thread;
+   int ncs;
+   struct amdgpu_cs *cs_stack[RING_LAST];
 
    struct radeon_info info;
 
@@ -71,6 +80,7 @@ amdgpu_winsys(struct radeon_winsys *base)
    return (struct amdgpu_winsys*)base;
 }
 
+void amdgpu_ws_queue_cs(struct amdgpu_winsys *ws, struct amdgpu_cs *cs);
 void amdgpu_surface_init_functions(struct amdgpu_winsys *ws);
 ADDR_HANDLE amdgpu_addr_create(struct amdgpu_winsys *ws);
 
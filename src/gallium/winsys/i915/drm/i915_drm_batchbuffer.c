@@ -163,6 +163,8 @@ i915_drm_batchbuffer_flush(struct i915_winsys_batchbuffer *ibatch,
                            enum i915_winsys_flush_flags flags)
 {
    struct i915_drm_batchbuffer *batch = i915_drm_batchbuffer(ibatch);
+   struct i915_drm_winsys *idws = i915_drm_winsys(ibatch->iws);
+   uint64_t seq = 0;
    unsigned used;
    int ret;
 
@@ -178,8 +180,13 @@ i915_drm_batchbuffer_flush(struct i915_winsys_batchbuffer *ibatch,
 
    /* Do the sending to HW */
    ret = drm_intel_bo_subdata(batch->bo, 0, used, batch->base.map);
-   if (ret == 0 && i915_drm_winsys(ibatch->iws)->send_cmd)
+   if (ret == 0 && idws->send_cmd) {
+      pipe_mutex_lock(idws->fence_mutex);
       ret = drm_intel_bo_exec(batch->bo, used, NULL, 0, 0);
+      if (ret == 0)
+         seq = ++idws->fence_seq;
+      pipe_mutex_unlock(idws->fence_mutex);
+   }
 
    if (flags & I915_FLUSH_END_OF_FRAME)
       i915_drm_throttle(i915_drm_winsys(ibatch->iws));
@@ -206,9 +213,9 @@ i915_drm_batchbuffer_flush(struct i915_winsys_batchbuffer *ibatch,
 
 #ifdef INTEL_RUN_SYNC
       /* we run synced to GPU so just pass null */
-      (*fence) = i915_drm_fence_create(NULL);
+      (*fence) = i915_drm_fence_create(NULL, 0);
 #else
-      (*fence) = i915_drm_fence_create(batch->bo);
+      (*fence) = i915_drm_fence_create(batch->bo, seq);
 #endif
    }
 
@@ -9,20 +9,26 @@
  *
  * They work by keeping the batchbuffer around and checking if that has
  * been idled. If bo is NULL fence has expired.
+ *
+ * Fences also carry the position of their batch on the winsys timeline, so
+ * that once one batch is known to be idle, earlier fences can be checked
+ * without an ioctl.
  */
 struct i915_drm_fence
 {
    struct pipe_reference reference;
    drm_intel_bo *bo;
+   uint64_t seq; /* 0 if the batch wasn't submitted */
 };
 
 
 struct pipe_fence_handle *
-i915_drm_fence_create(drm_intel_bo *bo)
+i915_drm_fence_create(drm_intel_bo *bo, uint64_t seq)
 {
    struct i915_drm_fence *fence = CALLOC_STRUCT(i915_drm_fence);
 
    pipe_reference_init(&fence->reference, 1);
+   fence->seq = seq;
    /* bo is null if fence already expired */
    if (bo) {
       drm_intel_bo_reference(bo);
@@ -48,30 +54,59 @@ i915_drm_fence_reference(struct i915_winsys *iws,
    *ptr = fence;
 }
 
+static boolean
+i915_drm_fence_is_covered(struct i915_drm_winsys *idws,
+                          struct i915_drm_fence *f)
+{
+   return f->seq && f->seq <= p_atomic_read(&idws->fence_signalled);
+}
+
+static void
+i915_drm_fence_mark_signalled(struct i915_drm_winsys *idws,
+                              struct i915_drm_fence *f)
+{
+   uint64_t old;
+
+   if (!f->seq)
+      return;
+
+   while ((old = p_atomic_read(&idws->fence_signalled)) < f->seq &&
+          p_atomic_cmpxchg(&idws->fence_signalled, old, f->seq) != old);
+}
+
 static int
 i915_drm_fence_signalled(struct i915_winsys *iws,
                           struct pipe_fence_handle *fence)
 {
+   struct i915_drm_winsys *idws = i915_drm_winsys(iws);
    struct i915_drm_fence *f = (struct i915_drm_fence *)fence;
 
    /* fence already expired */
-   if (!f->bo)
+   if (!f->bo || i915_drm_fence_is_covered(idws, f))
 	   return 1;
 
-   return !drm_intel_bo_busy(f->bo);
+   if (drm_intel_bo_busy(f->bo))
+      return 0;
+
+   i915_drm_fence_mark_signalled(idws, f);
+   return 1;
 }
 
 static int
 i915_drm_fence_finish(struct i915_winsys *iws,
                        struct pipe_fence_handle *fence)
 {
+   struct i915_drm_winsys *idws = i915_drm_winsys(iws);
    struct i915_drm_fence *f = (struct i915_drm_fence *)fence;
 
    /* fence already expired */
    if (!f->bo)
       return 0;
 
-   drm_intel_bo_wait_rendering(f->bo);
+   if (!i915_drm_fence_is_covered(idws, f)) {
+      drm_intel_bo_wait_rendering(f->bo);
+      i915_drm_fence_mark_signalled(idws, f);
+   }
    drm_intel_bo_unreference(f->bo);
    f->bo = NULL;
 
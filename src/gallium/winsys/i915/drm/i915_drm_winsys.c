@@ -45,6 +45,7 @@ i915_drm_winsys_destroy(struct i915_winsys *iws)
    struct i915_drm_winsys *idws = i915_drm_winsys(iws);
 
    drm_intel_bufmgr_destroy(idws->gem_manager);
+   pipe_mutex_destroy(idws->fence_mutex);
 
    FREE(idws);
 }
@@ -67,6 +68,7 @@ i915_drm_winsys_create(int drmFD)
 
    idws->fd = drmFD;
    idws->base.pci_id = deviceID;
+   pipe_mutex_init(idws->fence_mutex);
    idws->max_batch_size = 1 * 4096;
 
    idws->base.aperture_size = i915_drm_aperture_size;
@@ -3,6 +3,7 @@
 #define INTEL_DRM_WINSYS_H
 
 #include "i915/i915_batchbuffer.h"
+#include "os/os_thread.h"
 
 #include "drm.h"
 #include "intel_bufmgr.h"
@@ -26,6 +27,15 @@ struct i915_drm_winsys
    size_t max_batch_size;
 
    drm_intel_bufmgr *gem_manager;
+
+   /* Fence timeline: the number of the last batch submitted, and the highest
+    * one known to be idle.  Batches execute in order, so a fence is
+    * signalled if its number is not higher.  fence_mutex keeps numbers in
+    * submission order.
+    */
+   pipe_mutex fence_mutex;
+   uint64_t fence_seq;
+   uint64_t fence_signalled;
 };
 
 static inline struct i915_drm_winsys *
@@ -34,7 +44,7 @@ i915_drm_winsys(struct i915_winsys *iws)
    return (struct i915_drm_winsys *)iws;
 }
 
-struct pipe_fence_handle * i915_drm_fence_create(drm_intel_bo *bo);
+struct pipe_fence_handle * i915_drm_fence_create(drm_intel_bo *bo, uint64_t seq);
 
 void i915_drm_winsys_init_batchbuffer_functions(struct i915_drm_winsys *idws);
 void i915_drm_winsys_init_buffer_functions(struct i915_drm_winsys *idws);
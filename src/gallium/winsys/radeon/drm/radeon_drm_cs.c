@@ -75,6 +75,17 @@
 
 #define RELOC_DWORDS (sizeof(struct drm_radeon_cs_reloc) / sizeof(uint32_t))
 
+struct radeon_fence {
+    struct pipe_reference reference;
+
+    /* A dummy BO referenced by the CS, which is idle once the CS is done. */
+    struct pb_buffer *buf;
+
+    enum ring_type ring;
+    /* Position on the ring timeline, 0 until submitted. */
+    volatile uint64_t seq;
+};
+
 static struct pipe_fence_handle *
 radeon_cs_create_fence(struct radeon_winsys_cs *rcs);
 static void radeon_fence_reference(struct pipe_fence_handle **dst,
@@ -149,6 +160,7 @@ static void radeon_cs_context_cleanup(struct radeon_cs_context *csc)
     csc->chunks[1].length_dw = 0;
     csc->used_gart = 0;
     csc->used_vram = 0;
+    radeon_fence_reference(&csc->fence, NULL);
 
     for (i = 0; i < Elements(csc->reloc_indices_hashlist); i++) {
         csc->reloc_indices_hashlist[i] = -1;
@@ -439,6 +451,12 @@ void radeon_drm_cs_emit_ioctl_oneshot(struct radeon_drm_cs *cs, struct radeon_cs
         }
     }
 
+    if (!r && csc->fence && cs->ws->thread) {
+        struct radeon_fence *fence = (struct radeon_fence*)csc->fence;
+
+        fence->seq = ++cs->ws->fence_seq[fence->ring];
+    }
+
     if (cs->trace_buf) {
         radeon_dump_cs_on_lockup(cs, csc);
     }
@@ -511,6 +529,7 @@ static void radeon_drm_cs_flush(struct radeon_winsys_cs *rcs,
     if (fence) {
         radeon_fence_reference(fence, NULL);
         *fence = radeon_cs_create_fence(rcs);
+        radeon_fence_reference(&cs->csc->fence, *fence);
     }
 
     radeon_drm_cs_sync_flush(rcs);
@@ -644,30 +663,69 @@ static struct pipe_fence_handle *
 radeon_cs_create_fence(struct radeon_winsys_cs *rcs)
 {
     struct radeon_drm_cs *cs = radeon_drm_cs(rcs);
-    struct pb_buffer *fence;
+    struct radeon_fence *fence = CALLOC_STRUCT(radeon_fence);
+
+    if (!fence)
+        return NULL;
+
+    pipe_reference_init(&fence->reference, 1);
+    fence->ring = cs->base.ring_type;
 
     /* Create a fence, which is a dummy BO. */
-    fence = cs->ws->base.buffer_create(&cs->ws->base, 1, 1, TRUE,
-                                       RADEON_DOMAIN_GTT, 0);
+    fence->buf = cs->ws->base.buffer_create(&cs->ws->base, 1, 1, TRUE,
+                                            RADEON_DOMAIN_GTT, 0);
+    if (!fence->buf) {
+        FREE(fence);
+        return NULL;
+    }
+
     /* Add the fence as a dummy relocation. */
-    cs->ws->base.cs_add_buffer(rcs, fence,
+    cs->ws->base.cs_add_buffer(rcs, fence->buf,
                               RADEON_USAGE_READWRITE, RADEON_DOMAIN_GTT,
                               RADEON_PRIO_FENCE);
     return (struct pipe_fence_handle*)fence;
 }
 
-static bool radeon_fence_wait(struct radeon_winsys *ws,
+static bool radeon_fence_wait(struct radeon_winsys *rws,
                               struct pipe_fence_handle *fence,
                               uint64_t timeout)
 {
-    return ws->buffer_wait((struct pb_buffer*)fence, timeout,
-                           RADEON_USAGE_READWRITE);
+    struct radeon_drm_winsys *ws = radeon_drm_winsys(rws);
+    struct radeon_fence *rfence = (struct radeon_fence*)fence;
+    uint64_t *signalled = &ws->fence_signalled[rfence->ring];
+    uint64_t seq = rfence->seq;
+    uint64_t old;
+
+    /* A later fence on the same ring has been waited for already, so no
+     * ioctl is needed.  This makes polling a batch of older fences cheap. */
+    if (seq && seq <= p_atomic_read(signalled))
+        return true;
+
+    if (!rws->buffer_wait(rfence->buf, timeout, RADEON_USAGE_READWRITE))
+        return false;
+
+    /* buffer_wait waits for the submission, so the number is set now if the
+     * fence is on a timeline.  Everything before it is done too. */
+    seq = rfence->seq;
+    if (seq) {
+        while ((old = p_atomic_read(signalled)) < seq &&
+               p_atomic_cmpxchg(signalled, old, seq) != old);
+    }
+    return true;
 }
 
 static void radeon_fence_reference(struct pipe_fence_handle **dst,
                                    struct pipe_fence_handle *src)
 {
-    pb_reference((struct pb_buffer**)dst, (struct pb_buffer*)src);
+    struct radeon_fence *old = (struct radeon_fence*)*dst;
+    struct radeon_fence *rsrc = (struct radeon_fence*)src;
+
+    if (pipe_reference(old ? &old->reference : NULL,
+                       rsrc ? &rsrc->reference : NULL)) {
+        pb_reference(&old->buf, NULL);
+        FREE(old);
+    }
+    *dst = src;
 }
 
 void radeon_drm_cs_init_functions(struct radeon_drm_winsys *ws)
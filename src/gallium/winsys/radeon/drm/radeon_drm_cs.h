@@ -57,6 +57,9 @@ struct radeon_cs_context {
 
     uint64_t                    used_vram;
     uint64_t                    used_gart;
+
+    /* The fence returned for this CS, if any. */
+    struct pipe_fence_handle    *fence;
 };
 
 struct radeon_drm_cs {
@@ -111,6 +111,15 @@ struct radeon_drm_winsys {
     int kill_thread;
     int ncs;
     struct radeon_drm_cs *cs_stack[RING_LAST];
+
+    /* Per-ring fence timelines: the sequence number of the last fence
+     * submitted, and the highest one known to be signalled.  Rings execute
+     * in order, so a fence is signalled if its number is not higher.  Only
+     * maintained with the submission thread, which is the only one issuing
+     * CS ioctls and so sees them in submission order.
+     */
+    uint64_t fence_seq[RING_LAST];
+    uint64_t fence_signalled[RING_LAST];
 };
 
 static inline struct radeon_drm_winsys *
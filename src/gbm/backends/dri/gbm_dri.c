@@ -32,6 +32,7 @@
 #include <string.h>
 #include <errno.h>
 #include <limits.h>
+#include <time.h>
 
 #include <sys/types.h>
 #include <unistd.h>
@@ -583,6 +584,88 @@ gbm_dri_bo_get_fd(struct gbm_bo *_bo)
    return fd;
 }
 
+static int64_t
+gbm_dri_get_time_ms(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* Release the pooled buffers that have not been reused in time */
+static void
+gbm_dri_bo_pool_expire(struct gbm_dri_device *dri, int64_t now)
+{
+   unsigned i, count = 0;
+
+   for (i = 0; i < dri->bo_pool_count; i++) {
+      struct gbm_dri_bo *bo = dri->bo_pool[i];
+
+      if (bo->pool_expiry <= now) {
+         dri->image->destroyImage(bo->image);
+         free(bo);
+      } else {
+         dri->bo_pool[count++] = bo;
+      }
+   }
+
+   dri->bo_pool_count = count;
+}
+
+static struct gbm_dri_bo *
+gbm_dri_bo_pool_get(struct gbm_dri_device *dri,
+                    uint32_t width, uint32_t height,
+                    uint32_t format, uint32_t usage)
+{
+   unsigned i;
+
+   gbm_dri_bo_pool_expire(dri, gbm_dri_get_time_ms());
+
+   /* Prefer the most recently freed buffer, it's the most likely to still
+    * be in the caches.
+    */
+   for (i = dri->bo_pool_count; i-- > 0;) {
+      struct gbm_dri_bo *bo = dri->bo_pool[i];
+
+      if (bo->base.base.width != width ||
+          bo->base.base.height != height ||
+          bo->base.base.format != format ||
+          bo->usage != usage)
+         continue;
+
+      memmove(&dri->bo_pool[i], &dri->bo_pool[i + 1],
+              (dri->bo_pool_count - i - 1) * sizeof(dri->bo_pool[0]));
+      dri->bo_pool_count--;
+
+      bo->base.base.user_data = NULL;
+      bo->base.base.destroy_user_data = NULL;
+      return bo;
+   }
+
+   return NULL;
+}
+
+static void
+gbm_dri_bo_pool_put(struct gbm_dri_device *dri, struct gbm_dri_bo *bo)
+{
+   int64_t now = gbm_dri_get_time_ms();
+
+   gbm_dri_bo_pool_expire(dri, now);
+
+   /* Make room by dropping the least recently freed buffer */
+   if (dri->bo_pool_count == GBM_DRI_BO_POOL_SIZE) {
+      dri->image->destroyImage(dri->bo_pool[0]->image);
+      free(dri->bo_pool[0]);
+      memmove(&dri->bo_pool[0], &dri->bo_pool[1],
+              (GBM_DRI_BO_POOL_SIZE - 1) * sizeof(dri->bo_pool[0]));
+      dri->bo_pool_count--;
+   }
+
+   bo->pool_expiry = now + GBM_DRI_BO_POOL_TIMEOUT_MS;
+   dri->bo_pool[dri->bo_pool_count++] = bo;
+}
+
 static void
 gbm_dri_bo_destroy(struct gbm_bo *_bo)
 {
@@ -590,6 +673,11 @@ gbm_dri_bo_destroy(struct gbm_bo *_bo)
    struct gbm_dri_bo *bo = gbm_dri_bo(_bo);
    struct drm_mode_destroy_dumb arg;
 
+   if (bo->image != NULL && (bo->usage & GBM_BO_USE_POOLED)) {
+      gbm_dri_bo_pool_put(dri, bo);
+      return;
+   }
+
    if (bo->image != NULL) {
       dri->image->destroyImage(bo->image);
    } else {
@@ -843,6 +931,12 @@ gbm_dri_bo_create(struct gbm_device *gbm,
    if (usage & GBM_BO_USE_WRITE || dri->image == NULL)
       return create_dumb(gbm, width, height, format, usage);
 
+   if (usage & GBM_BO_USE_POOLED) {
+      bo = gbm_dri_bo_pool_get(dri, width, height, format, usage);
+      if (bo)
+         return &bo->base.base;
+   }
+
    bo = calloc(1, sizeof *bo);
    if (bo == NULL)
       return NULL;
@@ -851,6 +945,7 @@ gbm_dri_bo_create(struct gbm_device *gbm,
    bo->base.base.width = width;
    bo->base.base.height = height;
    bo->base.base.format = format;
+   bo->usage = usage;
 
    switch (format) {
    case GBM_FORMAT_RGB565:
@@ -942,6 +1037,7 @@ dri_destroy(struct gbm_device *gbm)
    struct gbm_dri_device *dri = gbm_dri_device(gbm);
    unsigned i;
 
+   gbm_dri_bo_pool_expire(dri, INT64_MAX);
    dri->core->destroyScreen(dri->screen);
    for (i = 0; dri->driver_configs[i]; i++)
       free((__DRIconfig *) dri->driver_configs[i]);
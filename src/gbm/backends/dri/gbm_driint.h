@@ -39,6 +39,11 @@
 struct gbm_dri_surface;
 struct gbm_dri_bo;
 
+/* Freed GBM_BO_USE_POOLED buffers kept around for reuse */
+#define GBM_DRI_BO_POOL_SIZE 16
+/* Pooled buffers unused for this long are released */
+#define GBM_DRI_BO_POOL_TIMEOUT_MS 1000
+
 struct gbm_dri_device {
    struct gbm_drm_device base;
 
@@ -93,12 +98,19 @@ struct gbm_dri_device {
                             void          *loaderPrivate);
 
    struct wl_drm *wl_drm;
+
+   /* Ordered from the least to the most recently freed buffer */
+   struct gbm_dri_bo *bo_pool[GBM_DRI_BO_POOL_SIZE];
+   unsigned bo_pool_count;
 };
 
 struct gbm_dri_bo {
    struct gbm_drm_bo base;
 
    __DRIimage *image;
+   uint32_t usage;
+   /* Time at which the buffer is released if it sits unused in the pool */
+   int64_t pool_expiry;
 
    /* Used for cursors and the swrast front BO */
    uint32_t handle, size;
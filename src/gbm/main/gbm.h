@@ -214,6 +214,13 @@ enum gbm_bo_flags {
     * Buffer is linear, i.e. not tiled.
     */
    GBM_BO_USE_LINEAR = (1 << 4),
+   /**
+    * Buffer may be taken from, and is returned to on destruction, a
+    * per-device pool of recently freed buffers with the same dimensions,
+    * format and usage flags. The contents of a recycled buffer are
+    * undefined and unused pooled buffers are released after a short delay.
+    */
+   GBM_BO_USE_POOLED = (1 << 5),
 };
 
 int
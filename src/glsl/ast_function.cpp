@@ -579,7 +579,7 @@ match_subroutine_by_name(const char *name,
    ir_variable *var;
    bool is_exact = false;
 
-   new_name = ralloc_asprintf(ctx, "%s_%s", _mesa_shader_stage_to_subroutine_prefix(state->stage), name);
+   new_name = linear_asprintf(state->linalloc, "%s_%s", _mesa_shader_stage_to_subroutine_prefix(state->stage), name);
    var = state->symbols->get_variable(new_name);
    if (!var)
       return NULL;
@@ -658,11 +658,9 @@ no_matching_function_error(const char *name,
 			   exec_list *actual_parameters,
 			   _mesa_glsl_parse_state *state)
 {
-   gl_shader *sh = _mesa_glsl_get_builtin_function_shader();
-
    if (state->symbols->get_function(name) == NULL
       && (!state->uses_builtin_functions
-          || sh->symbols->get_function(name) == NULL)) {
+          || _mesa_glsl_find_builtin_function_by_name(name) == NULL)) {
       _mesa_glsl_error(loc, state, "no function with name '%s'", name);
    } else {
       char *str = prototype_string(NULL, name, actual_parameters);
@@ -674,7 +672,8 @@ no_matching_function_error(const char *name,
       print_function_prototypes(state, loc, state->symbols->get_function(name));
 
       if (state->uses_builtin_functions) {
-         print_function_prototypes(state, loc, sh->symbols->get_function(name));
+         print_function_prototypes(state, loc,
+                                   _mesa_glsl_find_builtin_function_by_name(name));
       }
    }
 }
@@ -296,11 +296,11 @@ ast_type_qualifier::merge_out_qualifier(YYLTYPE *loc,
                                         const ast_type_qualifier &q,
                                         ast_node* &node)
 {
-   void *mem_ctx = state;
+   void *lin_ctx = state->linalloc;
    const bool r = this->merge_qualifier(loc, state, q);
 
    if (state->stage == MESA_SHADER_TESS_CTRL) {
-      node = new(mem_ctx) ast_tcs_output_layout(*loc);
+      node = new(lin_ctx) ast_tcs_output_layout(*loc);
    }
 
    return r;
@@ -312,7 +312,7 @@ ast_type_qualifier::merge_in_qualifier(YYLTYPE *loc,
                                        const ast_type_qualifier &q,
                                        ast_node* &node)
 {
-   void *mem_ctx = state;
+   void *lin_ctx = state->linalloc;
    bool create_gs_ast = false;
    bool create_cs_ast = false;
    ast_type_qualifier valid_in_mask;
@@ -451,9 +451,9 @@ ast_type_qualifier::merge_in_qualifier(YYLTYPE *loc,
    }
 
    if (create_gs_ast) {
-      node = new(mem_ctx) ast_gs_input_layout(*loc, q.prim_type);
+      node = new(lin_ctx) ast_gs_input_layout(*loc, q.prim_type);
    } else if (create_cs_ast) {
-      node = new(mem_ctx) ast_cs_input_layout(*loc, q.local_size);
+      node = new(lin_ctx) ast_cs_input_layout(*loc, q.local_size);
    }
 
    return true;
@@ -39,7 +39,8 @@
  *
  *    The builtin_builder::create_builtins() function contains lists of all
  *    built-in function signatures, where they're available, what types they
- *    take, and so on.
+ *    take, and so on.  The IR for a built-in is only generated the first
+ *    time a shader looks up its name; see builtin_builder::get_function().
  *
  * 4. Implementations of built-in function signatures
  *
@@ -507,8 +508,8 @@ namespace {
  * builtin_builder: A singleton object representing the core of the built-in
  * function module.
  *
- * It generates IR for every built-in function signature, and organizes them
- * into functions.
+ * It generates IR for built-in function signatures as they are looked up,
+ * and organizes them into functions.
  */
 class builtin_builder {
 public:
@@ -521,17 +522,34 @@ public:
                                const char *name, exec_list *actual_parameters);
 
    /**
-    * A shader to hold all the built-in signatures; created by this module.
+    * Look up the built-in or intrinsic function \p name, generating the IR
+    * for all of its signatures if this is the first time it is asked for.
     *
-    * This includes signatures for every built-in, regardless of version or
-    * enabled extensions.  The availability predicate associated with each
-    * signature allows matching_signature() to filter out the irrelevant ones.
+    * \return NULL if there is no built-in with that name.
+    */
+   ir_function *get_function(const char *name);
+
+   /**
+    * A shader to hold the built-in signatures; created by this module.
+    *
+    * This includes the signatures of every built-in looked up so far,
+    * regardless of version or enabled extensions.  The availability
+    * predicate associated with each signature allows matching_signature()
+    * to filter out the irrelevant ones.
     */
    gl_shader *shader;
 
 private:
    void *mem_ctx;
 
+   /**
+    * The function get_function() is generating.  create_intrinsics() and
+    * create_builtins() skip every other function in their lists.
+    */
+   const char *lazy_name;
+
+   bool wants(const char *name) const;
+
    /** Global variables used by built-in functions. */
    ir_variable *gl_ModelViewProjectionMatrix;
    ir_variable *gl_Vertex;
@@ -844,6 +862,7 @@ private:
  */
 builtin_builder::builtin_builder()
    : shader(NULL),
+     lazy_name(NULL),
      gl_ModelViewProjectionMatrix(NULL),
      gl_Vertex(NULL)
 {
@@ -868,7 +887,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = shader->symbols->get_function(name);
+   ir_function *f = get_function(name);
    if (f == NULL)
       return NULL;
 
@@ -889,8 +908,31 @@ builtin_builder::initialize()
 
    mem_ctx = ralloc_context(NULL);
    create_shader();
+}
+
+ir_function *
+builtin_builder::get_function(const char *name)
+{
+   ir_function *f = shader->symbols->get_function(name);
+   if (f != NULL)
+      return f;
+
+   /* Walk the lists of functions, generating only this one.  Generating it
+    * may look up the intrinsics it calls, which nests another walk.
+    */
+   const char *const saved_lazy_name = lazy_name;
+   lazy_name = name;
    create_intrinsics();
    create_builtins();
+   lazy_name = saved_lazy_name;
+
+   return shader->symbols->get_function(name);
+}
+
+bool
+builtin_builder::wants(const char *name) const
+{
+   return strcmp(name, lazy_name) == 0;
 }
 
 void
@@ -926,9 +968,16 @@ builtin_builder::create_shader()
 
 /** @} */
 
+/* Only evaluate the signature generators of the function being looked up. */
+#define add_function(NAME, ...)                 \
+   do {                                         \
+      if (wants(NAME))                          \
+         add_function(NAME, __VA_ARGS__);       \
+   } while (0)
+
 /**
- * Create ir_function and ir_function_signature objects for each
- * intrinsic.
+ * Create ir_function and ir_function_signature objects for the intrinsic
+ * named lazy_name, if there is one.
  */
 void
 builtin_builder::create_intrinsics()
@@ -1020,7 +1069,8 @@ builtin_builder::create_intrinsics()
 }
 
 /**
- * Create ir_function and ir_function_signature objects for each built-in.
+ * Create ir_function and ir_function_signature objects for the built-in
+ * named lazy_name, if there is one.
  *
  * Contains a list of every available built-in.
  */
@@ -2849,6 +2899,8 @@ builtin_builder::create_builtins()
 #undef FIU2_MIXED
 }
 
+#undef add_function
+
 void
 builtin_builder::add_function(const char *name, ...)
 {
@@ -2882,6 +2934,9 @@ builtin_builder::add_image_function(const char *name,
                                     unsigned num_arguments,
                                     unsigned flags)
 {
+   if (!wants(name))
+      return;
+
    static const glsl_type *const types[] = {
       glsl_type::image1D_type,
       glsl_type::image2D_type,
@@ -5138,7 +5193,7 @@ builtin_builder::_atomic_counter_op(const char *intrinsic,
    MAKE_SIG(glsl_type::uint_type, avail, 1, counter);
 
    ir_variable *retval = body.make_temp(glsl_type::uint_type, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(get_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -5154,7 +5209,7 @@ builtin_builder::_atomic_op2(const char *intrinsic,
    MAKE_SIG(type, avail, 2, atomic, data);
 
    ir_variable *retval = body.make_temp(type, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(get_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -5171,7 +5226,7 @@ builtin_builder::_atomic_op3(const char *intrinsic,
    MAKE_SIG(type, avail, 3, atomic, data1, data2);
 
    ir_variable *retval = body.make_temp(type, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(get_function(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -5345,7 +5400,7 @@ builtin_builder::_image(image_prototype_ctr prototype,
 
    if (flags & IMAGE_FUNCTION_EMIT_STUB) {
       ir_factory body(&sig->body, mem_ctx);
-      ir_function *f = shader->symbols->get_function(intrinsic_name);
+      ir_function *f = get_function(intrinsic_name);
 
       if (flags & IMAGE_FUNCTION_RETURNS_VOID) {
          body.emit(call(f, NULL, sig->parameters));
@@ -5377,7 +5432,7 @@ builtin_builder::_memory_barrier(const char *intrinsic_name,
                                  builtin_available_predicate avail)
 {
    MAKE_SIG(glsl_type::void_type, avail, 0);
-   body.emit(call(shader->symbols->get_function(intrinsic_name),
+   body.emit(call(get_function(intrinsic_name),
                   NULL, sig->parameters));
    return sig;
 }
@@ -5398,7 +5453,7 @@ builtin_builder::_shader_clock(builtin_available_predicate avail,
 
    ir_variable *retval = body.make_temp(type, "clock_retval");
 
-   body.emit(call(shader->symbols->get_function("__intrinsic_shader_clock"),
+   body.emit(call(get_function("__intrinsic_shader_clock"),
                   retval, sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -5448,7 +5503,7 @@ _mesa_glsl_find_builtin_function_by_name(const char *name)
 {
    ir_function *f;
    mtx_lock(&builtins_lock);
-   f = builtins.shader->symbols->get_function(name);
+   f = builtins.get_function(name);
    mtx_unlock(&builtins_lock);
    return f;
 }
@@ -5459,6 +5514,18 @@ _mesa_glsl_get_builtin_function_shader()
    return builtins.shader;
 }
 
+void
+_mesa_glsl_lock_builtin_functions()
+{
+   mtx_lock(&builtins_lock);
+}
+
+void
+_mesa_glsl_unlock_builtin_functions()
+{
+   mtx_unlock(&builtins_lock);
+}
+
 
 /**
  * Get the function signature for main from a shader
@@ -105,6 +105,9 @@ _parser_active_list_push (glcpp_parser_t *parser,
 static void
 _parser_active_list_pop (glcpp_parser_t *parser);
 
+static void
+_glcpp_parser_cache_expansion (glcpp_parser_t *parser, macro_t *macro);
+
 static int
 _parser_active_list_contains (glcpp_parser_t *parser, const char *identifier);
 
@@ -212,7 +215,7 @@ line:
 |	SPACE control_line
 |	text_line {
 		_glcpp_parser_print_expanded_token_list (parser, $1);
-		ralloc_asprintf_rewrite_tail (&parser->output, &parser->output_length, "\n");
+		_mesa_string_buffer_append_char(parser->output, '\n');
 		ralloc_free ($1);
 	}
 |	expanded_line
@@ -232,20 +235,18 @@ expanded_line:
 |	LINE_EXPANDED integer_constant NEWLINE {
 		parser->has_new_line_number = 1;
 		parser->new_line_number = $2;
-		ralloc_asprintf_rewrite_tail (&parser->output,
-					      &parser->output_length,
-					      "#line %" PRIiMAX "\n",
-					      $2);
+		_mesa_string_buffer_printf(parser->output,
+					   "#line %" PRIiMAX "\n",
+					   $2);
 	}
 |	LINE_EXPANDED integer_constant integer_constant NEWLINE {
 		parser->has_new_line_number = 1;
 		parser->new_line_number = $2;
 		parser->has_new_source_number = 1;
 		parser->new_source_number = $3;
-		ralloc_asprintf_rewrite_tail (&parser->output,
-					      &parser->output_length,
-					      "#line %" PRIiMAX " %" PRIiMAX "\n",
-					      $2, $3);
+		_mesa_string_buffer_printf(parser->output,
+					   "#line %" PRIiMAX " %" PRIiMAX "\n",
+					   $2, $3);
 	}
 ;
 
@@ -263,7 +264,7 @@ define:
 
 control_line:
 	control_line_success {
-		ralloc_asprintf_rewrite_tail (&parser->output, &parser->output_length, "\n");
+		_mesa_string_buffer_append_char(parser->output, '\n');
 	}
 |	control_line_error
 |	HASH_TOKEN LINE {
@@ -299,6 +300,7 @@ control_line_success:
 		if (macro) {
 			hash_table_remove (parser->defines, $4);
 			ralloc_free (macro);
+			parser->defines_generation++;
 		}
 		ralloc_free ($4);
 	}
@@ -427,7 +429,7 @@ control_line_success:
 		glcpp_parser_resolve_implicit_version(parser);
 	}
 |	HASH_TOKEN PRAGMA NEWLINE {
-		ralloc_asprintf_rewrite_tail (&parser->output, &parser->output_length, "#%s", $2);
+		_mesa_string_buffer_printf(parser->output, "#%s", $2);
 	}
 ;
 
@@ -1111,60 +1113,60 @@ _token_list_equal_ignoring_space (token_list_t *a, token_list_t *b)
 }
 
 static void
-_token_print (char **out, size_t *len, token_t *token)
+_token_print (struct _mesa_string_buffer *out, token_t *token)
 {
 	if (token->type < 256) {
-		ralloc_asprintf_rewrite_tail (out, len, "%c", token->type);
+		_mesa_string_buffer_append_char(out, token->type);
 		return;
 	}
 
 	switch (token->type) {
 	case INTEGER:
-		ralloc_asprintf_rewrite_tail (out, len, "%" PRIiMAX, token->value.ival);
+		_mesa_string_buffer_printf(out, "%" PRIiMAX, token->value.ival);
 		break;
 	case IDENTIFIER:
 	case INTEGER_STRING:
 	case OTHER:
-		ralloc_asprintf_rewrite_tail (out, len, "%s", token->value.str);
+		_mesa_string_buffer_append(out, token->value.str);
 		break;
 	case SPACE:
-		ralloc_asprintf_rewrite_tail (out, len, " ");
+		_mesa_string_buffer_append_char(out, ' ');
 		break;
 	case LEFT_SHIFT:
-		ralloc_asprintf_rewrite_tail (out, len, "<<");
+		_mesa_string_buffer_append(out, "<<");
 		break;
 	case RIGHT_SHIFT:
-		ralloc_asprintf_rewrite_tail (out, len, ">>");
+		_mesa_string_buffer_append(out, ">>");
 		break;
 	case LESS_OR_EQUAL:
-		ralloc_asprintf_rewrite_tail (out, len, "<=");
+		_mesa_string_buffer_append(out, "<=");
 		break;
 	case GREATER_OR_EQUAL:
-		ralloc_asprintf_rewrite_tail (out, len, ">=");
+		_mesa_string_buffer_append(out, ">=");
 		break;
 	case EQUAL:
-		ralloc_asprintf_rewrite_tail (out, len, "==");
+		_mesa_string_buffer_append(out, "==");
 		break;
 	case NOT_EQUAL:
-		ralloc_asprintf_rewrite_tail (out, len, "!=");
+		_mesa_string_buffer_append(out, "!=");
 		break;
 	case AND:
-		ralloc_asprintf_rewrite_tail (out, len, "&&");
+		_mesa_string_buffer_append(out, "&&");
 		break;
 	case OR:
-		ralloc_asprintf_rewrite_tail (out, len, "||");
+		_mesa_string_buffer_append(out, "||");
 		break;
 	case PASTE:
-		ralloc_asprintf_rewrite_tail (out, len, "##");
+		_mesa_string_buffer_append(out, "##");
 		break;
         case PLUS_PLUS:
-		ralloc_asprintf_rewrite_tail (out, len, "++");
+		_mesa_string_buffer_append(out, "++");
 		break;
         case MINUS_MINUS:
-		ralloc_asprintf_rewrite_tail (out, len, "--");
+		_mesa_string_buffer_append(out, "--");
 		break;
 	case DEFINED:
-		ralloc_asprintf_rewrite_tail (out, len, "defined");
+		_mesa_string_buffer_append(out, "defined");
 		break;
 	case PLACEHOLDER:
 		/* Nothing to print. */
@@ -1296,11 +1298,11 @@ _token_paste (glcpp_parser_t *parser, token_t *token, token_t *other)
 
     FAIL:
 	glcpp_error (&token->location, parser, "");
-	ralloc_asprintf_rewrite_tail (&parser->info_log, &parser->info_log_length, "Pasting \"");
-	_token_print (&parser->info_log, &parser->info_log_length, token);
-	ralloc_asprintf_rewrite_tail (&parser->info_log, &parser->info_log_length, "\" and \"");
-	_token_print (&parser->info_log, &parser->info_log_length, other);
-	ralloc_asprintf_rewrite_tail (&parser->info_log, &parser->info_log_length, "\" does not give a valid preprocessing token.\n");
+	_mesa_string_buffer_append(parser->info_log, "Pasting \"");
+	_token_print (parser->info_log, token);
+	_mesa_string_buffer_append(parser->info_log, "\" and \"");
+	_token_print (parser->info_log, other);
+	_mesa_string_buffer_append(parser->info_log, "\" does not give a valid preprocessing token.\n");
 
 	return token;
 }
@@ -1314,7 +1316,7 @@ _token_list_print (glcpp_parser_t *parser, token_list_t *list)
 		return;
 
 	for (node = list->head; node; node = node->next)
-		_token_print (&parser->output, &parser->output_length, node->token);
+		_token_print (parser->output, node->token);
 }
 
 void
@@ -1346,6 +1348,8 @@ glcpp_parser_create (const struct gl_extensions *extensions, gl_api api)
 	glcpp_lex_init_extra (parser, &parser->scanner);
 	parser->defines = hash_table_ctor (32, hash_table_string_hash,
 					   hash_table_string_compare);
+	parser->defines_generation = 1;
+	parser->line_file_expansions = 0;
 	parser->active = NULL;
 	parser->lexing_directive = 0;
 	parser->space_tokens = 1;
@@ -1363,10 +1367,10 @@ glcpp_parser_create (const struct gl_extensions *extensions, gl_api api)
 	parser->lex_from_list = NULL;
 	parser->lex_from_node = NULL;
 
-	parser->output = ralloc_strdup(parser, "");
-	parser->output_length = 0;
-	parser->info_log = ralloc_strdup(parser, "");
-	parser->info_log_length = 0;
+	parser->output = _mesa_string_buffer_create(parser,
+						    INITIAL_PP_OUTPUT_BUF_SIZE);
+	parser->info_log = _mesa_string_buffer_create(parser,
+						      INITIAL_PP_OUTPUT_BUF_SIZE);
 	parser->error = 0;
 
         parser->extensions = extensions;
@@ -1815,6 +1819,72 @@ _glcpp_parser_expand_function (glcpp_parser_t *parser,
 	return substituted;
 }
 
+/* Fully expand the replacement list of the object-like 'macro', as it
+ * would be expanded outside of any other macro, and keep the result in
+ * macro->expansion for the following uses of the macro.
+ *
+ * The result is only kept when it cannot depend on what surrounds the
+ * macro: it must not contain anything that could be expanded further,
+ * (such as the name of a function-like macro whose arguments would follow
+ * the macro), nor DEFINED tokens, nor values of __LINE__ or __FILE__, and
+ * the expansion must not have produced any error or warning. Otherwise
+ * macro->expansion is left NULL and the macro is expanded the usual way
+ * until the set of defined macros changes.
+ */
+static void
+_glcpp_parser_cache_expansion (glcpp_parser_t *parser, macro_t *macro)
+{
+	token_list_t *expansion;
+	token_node_t *node;
+	unsigned line_file_expansions = parser->line_file_expansions;
+	uint32_t info_log_length = parser->info_log->length;
+	int error = parser->error;
+	bool cacheable;
+
+	ralloc_free (macro->expansion);
+	macro->expansion = NULL;
+	macro->expansion_generation = parser->defines_generation;
+
+	expansion = _token_list_copy (parser, macro->replacements);
+	_glcpp_parser_apply_pastes (parser, expansion);
+
+	/* Trailing space would be trimmed here but not in the middle of a
+	 * line. */
+	cacheable = expansion->non_space_tail == expansion->tail;
+
+	if (cacheable) {
+		_parser_active_list_push (parser, macro->identifier, NULL);
+		_glcpp_parser_expand_token_list (parser, expansion,
+						 EXPANSION_MODE_IGNORE_DEFINED);
+		_parser_active_list_pop (parser);
+	}
+
+	cacheable = cacheable &&
+		    parser->line_file_expansions == line_file_expansions &&
+		    parser->info_log->length == info_log_length &&
+		    parser->error == error;
+
+	for (node = expansion->head; cacheable && node; node = node->next) {
+		token_t *token = node->token;
+
+		if (token->type == DEFINED ||
+		    (token->type == IDENTIFIER &&
+		     (hash_table_find (parser->defines, token->value.str) ||
+		      strcmp (token->value.str, "__LINE__") == 0 ||
+		      strcmp (token->value.str, "__FILE__") == 0)))
+			cacheable = false;
+	}
+
+	/* Anything the trial expansion reported is reported again when
+	 * the macro is expanded the usual way. */
+	parser->info_log->length = info_log_length;
+	parser->info_log->buf[info_log_length] = '\0';
+	parser->error = error;
+
+	if (cacheable)
+		macro->expansion = _token_list_copy (macro, expansion);
+}
+
 /* Compute the complete expansion of node, (and subsequent nodes after
  * 'node' in the case that 'node' is a function-like macro and
  * subsequent nodes are arguments).
@@ -1853,11 +1923,15 @@ _glcpp_parser_expand_node (glcpp_parser_t *parser,
 
 	/* Special handling for __LINE__ and __FILE__, (not through
 	 * the hash table). */
-	if (strcmp(identifier, "__LINE__") == 0)
+	if (strcmp(identifier, "__LINE__") == 0) {
+		parser->line_file_expansions++;
 		return _token_list_create_with_one_integer (parser, node->token->location.first_line);
+	}
 
-	if (strcmp(identifier, "__FILE__") == 0)
+	if (strcmp(identifier, "__FILE__") == 0) {
+		parser->line_file_expansions++;
 		return _token_list_create_with_one_integer (parser, node->token->location.source);
+	}
 
 	/* Look up this identifier in the hash table. */
 	macro = hash_table_find (parser->defines, identifier);
@@ -1891,6 +1965,19 @@ _glcpp_parser_expand_node (glcpp_parser_t *parser,
 		if (macro->replacements == NULL)
 			return _token_list_create_with_one_space (parser);
 
+		/* Outside of any other expansion, a previous full
+		 * expansion of this macro can be reused as is. */
+		if (parser->active == NULL &&
+		    mode == EXPANSION_MODE_IGNORE_DEFINED) {
+			if (macro->expansion_generation !=
+			    parser->defines_generation) {
+				_glcpp_parser_cache_expansion (parser, macro);
+			}
+			if (macro->expansion)
+				return _token_list_copy (parser,
+							 macro->expansion);
+		}
+
 		replacement = _token_list_copy (parser, macro->replacements);
 		_glcpp_parser_apply_pastes (parser, replacement);
 		return replacement;
@@ -2134,6 +2221,8 @@ _define_object_macro (glcpp_parser_t *parser,
 	macro->parameters = NULL;
 	macro->identifier = ralloc_strdup (macro, identifier);
 	macro->replacements = replacements;
+	macro->expansion = NULL;
+	macro->expansion_generation = 0;
 	ralloc_steal (macro, replacements);
 
 	previous = hash_table_find (parser->defines, identifier);
@@ -2147,6 +2236,7 @@ _define_object_macro (glcpp_parser_t *parser,
 	}
 
 	hash_table_insert (parser->defines, macro, identifier);
+	parser->defines_generation++;
 }
 
 void
@@ -2175,6 +2265,8 @@ _define_function_macro (glcpp_parser_t *parser,
 	macro->parameters = parameters;
 	macro->identifier = ralloc_strdup (macro, identifier);
 	macro->replacements = replacements;
+	macro->expansion = NULL;
+	macro->expansion_generation = 0;
 	previous = hash_table_find (parser->defines, identifier);
 	if (previous) {
 		if (_macro_equal (macro, previous)) {
@@ -2186,6 +2278,7 @@ _define_function_macro (glcpp_parser_t *parser,
 	}
 
 	hash_table_insert (parser->defines, macro, identifier);
+	parser->defines_generation++;
 }
 
 static int
@@ -2529,10 +2622,10 @@ _glcpp_parser_handle_version_declaration(glcpp_parser_t *parser, intmax_t versio
 		add_builtin_define (parser, "GL_FRAGMENT_PRECISION_HIGH", 1);
 
 	if (explicitly_set) {
-	   ralloc_asprintf_rewrite_tail (&parser->output, &parser->output_length,
-					 "#version %" PRIiMAX "%s%s", version,
-					 es_identifier ? " " : "",
-					 es_identifier ? es_identifier : "");
+	   _mesa_string_buffer_printf(parser->output,
+				      "#version %" PRIiMAX "%s%s", version,
+				      es_identifier ? " " : "",
+				      es_identifier ? es_identifier : "");
 	}
 }
 
@@ -30,11 +30,15 @@
 #include "main/mtypes.h"
 
 #include "util/ralloc.h"
+#include "util/string_buffer.h"
 
 #include "program/hash_table.h"
 
 #define yyscan_t void*
 
+/* Initial size of the output and info log buffers; they grow by doubling. */
+#define INITIAL_PP_OUTPUT_BUF_SIZE 4048
+
 /* Some data types used for parser values. */
 
 typedef struct expression_value {
@@ -144,6 +148,13 @@ typedef struct {
 	string_list_t *parameters;
 	const char *identifier;
 	token_list_t *replacements;
+
+	/* Fully expanded replacement list of an object-like macro, valid
+	 * while expansion_generation matches the parser's
+	 * defines_generation.  NULL with a matching generation means the
+	 * expansion depends on its surroundings and cannot be reused. */
+	token_list_t *expansion;
+	unsigned expansion_generation;
 } macro_t;
 
 typedef struct expansion_node {
@@ -174,6 +185,8 @@ typedef struct active_list {
 struct glcpp_parser {
 	yyscan_t scanner;
 	struct hash_table *defines;
+	unsigned defines_generation;
+	unsigned line_file_expansions;
 	active_list_t *active;
 	int lexing_directive;
 	int space_tokens;
@@ -188,10 +201,8 @@ struct glcpp_parser {
 	int skipping;
 	token_list_t *lex_from_list;
 	token_node_t *lex_from_node;
-	char *output;
-	char *info_log;
-	size_t output_length;
-	size_t info_log_length;
+	struct _mesa_string_buffer *output;
+	struct _mesa_string_buffer *info_log;
 	int error;
 	const struct gl_extensions *extensions;
 	gl_api api;
@@ -0,0 +1,596 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <getopt.h>
+#include <inttypes.h>
+#include <time.h>
+
+/** @file glsl_bench.cpp
+ *
+ * Compile-time benchmark for the GLSL compiler and NIR.
+ *
+ * Each file on the command line is either a shader-db style .shader_test
+ * file, whose stages are compiled and linked together, or a single
+ * .vert/.tesc/.tese/.geom/.frag/.comp shader.  Every linked stage is then
+ * converted to NIR and put through the usual NIR optimization loop.
+ *
+ * The wall time and number of allocations of each compiler stage and pass
+ * are summed over the whole corpus and printed as a table, or as JSON with
+ * --json so results can be compared across Mesa versions.  Times include
+ * nested passes, e.g. the time of link_shaders includes the passes of the
+ * do_common_optimization() calls made by the linker.
+ */
+
+#include "ast.h"
+#include "glsl_parser_extras.h"
+#include "ir_optimization.h"
+#include "program.h"
+#include "program/hash_table.h"
+#include "standalone_scaffolding.h"
+#include "nir/glsl_to_nir.h"
+
+static uint64_t num_allocations;
+
+#if defined(__GLIBC__)
+/* Count allocations by wrapping glibc's allocator.  ralloc and operator
+ * new both end up here.
+ */
+extern "C" {
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *
+malloc(size_t size)
+{
+   num_allocations++;
+   return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+   num_allocations++;
+   return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+   num_allocations++;
+   return __libc_realloc(ptr, size);
+}
+}
+#define HAVE_ALLOCATION_COUNT 1
+#else
+#define HAVE_ALLOCATION_COUNT 0
+#endif
+
+static uint64_t
+get_time_ns(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+struct pass_stats {
+   const char *name;
+   uint64_t calls;
+   uint64_t time_ns;
+   uint64_t allocations;
+};
+
+struct pass_frame {
+   const char *name;
+   uint64_t start_ns;
+   uint64_t start_allocations;
+};
+
+#define MAX_PASSES 128
+#define MAX_PASS_DEPTH 16
+
+static struct pass_stats passes[MAX_PASSES];
+static unsigned num_passes;
+
+static struct pass_frame pass_stack[MAX_PASS_DEPTH];
+static unsigned pass_depth;
+
+static struct pass_stats *
+get_pass_stats(const char *name)
+{
+   for (unsigned i = 0; i < num_passes; i++) {
+      if (strcmp(passes[i].name, name) == 0)
+         return &passes[i];
+   }
+
+   if (num_passes == MAX_PASSES)
+      return NULL;
+
+   passes[num_passes].name = name;
+   return &passes[num_passes++];
+}
+
+static void
+record_pass(const char *name, bool start)
+{
+   if (start) {
+      assert(pass_depth < MAX_PASS_DEPTH);
+      pass_stack[pass_depth].name = name;
+      pass_stack[pass_depth].start_allocations = num_allocations;
+      pass_stack[pass_depth].start_ns = get_time_ns();
+      pass_depth++;
+   } else {
+      const uint64_t end_ns = get_time_ns();
+
+      assert(pass_depth > 0);
+      pass_depth--;
+      assert(strcmp(pass_stack[pass_depth].name, name) == 0);
+
+      struct pass_stats *stats = get_pass_stats(name);
+      if (stats) {
+         stats->calls++;
+         stats->time_ns += end_ns - pass_stack[pass_depth].start_ns;
+         stats->allocations +=
+            num_allocations - pass_stack[pass_depth].start_allocations;
+      }
+   }
+}
+
+#define TIME(name, call) do {                   \
+      record_pass(name, true);                  \
+      call;                                     \
+      record_pass(name, false);                 \
+   } while (0)
+
+#define NIR_OPT(pass, ...) do {                          \
+      record_pass(#pass, true);                          \
+      progress = pass(nir, ##__VA_ARGS__) || progress;   \
+      record_pass(#pass, false);                         \
+   } while (0)
+
+#define NIR_OPT_V(pass) TIME(#pass, pass(nir))
+
+static nir_shader_compiler_options nir_options;
+
+/**
+ * The driver-independent part of the NIR pipeline i965 runs on a freshly
+ * translated shader.
+ */
+static void
+optimize_nir(nir_shader *nir)
+{
+   bool progress;
+
+   NIR_OPT(nir_lower_global_vars_to_local);
+   NIR_OPT(nir_split_var_copies);
+
+   for (unsigned i = 0; i < 2; i++) {
+      do {
+         progress = false;
+         NIR_OPT_V(nir_lower_vars_to_ssa);
+         NIR_OPT(nir_copy_prop);
+         NIR_OPT(nir_opt_dce);
+         NIR_OPT(nir_opt_cse);
+         NIR_OPT(nir_opt_combine_ubo_loads);
+         NIR_OPT(nir_opt_peephole_select, 0);
+         NIR_OPT(nir_opt_algebraic);
+         NIR_OPT(nir_opt_constant_folding);
+         NIR_OPT(nir_opt_dead_cf);
+         NIR_OPT(nir_opt_remove_phis);
+         NIR_OPT(nir_opt_undef);
+      } while (progress);
+
+      /* Get rid of the copies split above and optimize again. */
+      if (i == 0)
+         NIR_OPT_V(nir_lower_var_copies);
+   }
+
+   progress = false;
+   NIR_OPT(nir_remove_dead_variables);
+   NIR_OPT(nir_opt_algebraic_late);
+}
+
+static void
+initialize_context(struct gl_context *ctx)
+{
+   initialize_context_to_defaults(ctx, API_OPENGL_COMPAT);
+
+   /* Claim enough of everything that real-world shaders compile and link. */
+   ctx->Const.GLSLVersion = 450;
+   ctx->Const.NativeIntegers = true;
+   nir_options.native_integers = true;
+   ctx->Extensions.ARB_shader_storage_buffer_object = true;
+   ctx->Extensions.ARB_shader_image_load_store = true;
+   ctx->Extensions.ARB_shader_atomic_counters = true;
+
+   ctx->Const.MaxClipPlanes = 8;
+   ctx->Const.MaxDrawBuffers = 8;
+   ctx->Const.MinProgramTexelOffset = -8;
+   ctx->Const.MaxProgramTexelOffset = 7;
+   ctx->Const.MaxTextureCoordUnits = 8;
+   ctx->Const.MaxTextureUnits = 8;
+   ctx->Const.MaxVarying = 32;
+   ctx->Const.MaxGeometryOutputVertices = 256;
+   ctx->Const.MaxGeometryTotalOutputComponents = 1024;
+   ctx->Const.MaxPatchVertices = 32;
+   ctx->Const.MaxUniformBufferBindings = 84;
+   ctx->Const.MaxUniformBlockSize = 65536;
+   ctx->Const.MaxCombinedUniformBlocks = 84;
+   ctx->Const.MaxShaderStorageBufferBindings = 84;
+   ctx->Const.MaxCombinedShaderStorageBlocks = 84;
+   ctx->Const.MaxShaderStorageBlockSize = 1 << 27;
+   ctx->Const.MaxCombinedTextureImageUnits = 96;
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      struct gl_program_constants *prog = &ctx->Const.Program[i];
+
+      prog->MaxTextureImageUnits = 16;
+      prog->MaxUniformComponents = 4096;
+      prog->MaxCombinedUniformComponents = 4096 + 12 * 16384;
+      prog->MaxInputComponents = 128;
+      prog->MaxOutputComponents = 128;
+      prog->MaxUniformBlocks = 14;
+      prog->MaxShaderStorageBlocks = 14;
+      prog->MaxAtomicBuffers = 8;
+      prog->MaxAtomicCounters = 1024;
+      prog->MaxImageUniforms = 8;
+   }
+   ctx->Const.Program[MESA_SHADER_VERTEX].MaxAttribs = 16;
+
+   ctx->Driver.NewShader = _mesa_new_shader;
+}
+
+/* Returned string will have 'ctx' as its ralloc owner. */
+static char *
+load_text_file(void *ctx, const char *file_name)
+{
+   FILE *fp = fopen(file_name, "rb");
+   if (!fp)
+      return NULL;
+
+   fseek(fp, 0L, SEEK_END);
+   const long size = ftell(fp);
+   fseek(fp, 0L, SEEK_SET);
+
+   char *text = NULL;
+   if (size >= 0) {
+      text = (char *) ralloc_size(ctx, size + 1);
+      if (fread(text, 1, size, fp) != (size_t) size) {
+         ralloc_free(text);
+         text = NULL;
+      } else {
+         text[size] = '\0';
+      }
+   }
+
+   fclose(fp);
+   return text;
+}
+
+static void
+add_shader(struct gl_shader_program *prog, GLenum type, const char *source)
+{
+   prog->Shaders = reralloc(prog, prog->Shaders, struct gl_shader *,
+                            prog->NumShaders + 1);
+
+   struct gl_shader *shader = rzalloc(prog, struct gl_shader);
+   shader->Type = type;
+   shader->Stage = _mesa_shader_enum_to_shader_stage(type);
+   shader->Source = source;
+
+   prog->Shaders[prog->NumShaders++] = shader;
+}
+
+static const struct {
+   const char *name;
+   GLenum type;
+} shader_test_sections[] = {
+   { "vertex shader", GL_VERTEX_SHADER },
+   { "tessellation control shader", GL_TESS_CONTROL_SHADER },
+   { "tessellation evaluation shader", GL_TESS_EVALUATION_SHADER },
+   { "geometry shader", GL_GEOMETRY_SHADER },
+   { "fragment shader", GL_FRAGMENT_SHADER },
+   { "compute shader", GL_COMPUTE_SHADER },
+};
+
+/**
+ * Adds the shaders of a .shader_test file.  Each shader is a section
+ * starting with a line like "[fragment shader]"; other sections such as
+ * "[require]" and "[test]" are skipped.
+ */
+static void
+add_shader_test(struct gl_shader_program *prog, char *text)
+{
+   GLenum type = 0;
+   char *source = NULL;
+
+   for (char *line = text; line != NULL; ) {
+      char *next = strchr(line, '\n');
+      if (next)
+         next++;
+
+      if (line[0] == '[') {
+         if (source) {
+            line[0] = '\0';
+            add_shader(prog, type, source);
+         }
+
+         type = 0;
+         source = NULL;
+         for (unsigned i = 0; i < ARRAY_SIZE(shader_test_sections); i++) {
+            const char *name = shader_test_sections[i].name;
+            const size_t len = strlen(name);
+
+            if (strncmp(line + 1, name, len) == 0 && line[len + 1] == ']') {
+               type = shader_test_sections[i].type;
+               source = next;
+               break;
+            }
+         }
+      }
+
+      line = next;
+   }
+
+   if (source)
+      add_shader(prog, type, source);
+}
+
+static GLenum
+shader_type_for_file_name(const char *file_name)
+{
+   const char *ext = strrchr(file_name, '.');
+
+   if (ext == NULL)
+      return 0;
+   if (strcmp(ext, ".vert") == 0 || strcmp(ext, ".glsl") == 0)
+      return GL_VERTEX_SHADER;
+   if (strcmp(ext, ".tesc") == 0)
+      return GL_TESS_CONTROL_SHADER;
+   if (strcmp(ext, ".tese") == 0)
+      return GL_TESS_EVALUATION_SHADER;
+   if (strcmp(ext, ".geom") == 0)
+      return GL_GEOMETRY_SHADER;
+   if (strcmp(ext, ".frag") == 0)
+      return GL_FRAGMENT_SHADER;
+   if (strcmp(ext, ".comp") == 0)
+      return GL_COMPUTE_SHADER;
+   return 0;
+}
+
+/**
+ * Compiles, links and converts to NIR the shaders of one file.
+ *
+ * \return true on success, false if the file could not be read, failed to
+ *         compile or failed to link
+ */
+static bool
+run_file(struct gl_context *ctx, const char *file_name)
+{
+   struct gl_shader_program *prog = rzalloc(NULL, struct gl_shader_program);
+   bool ok = false;
+
+   prog->InfoLog = ralloc_strdup(prog, "");
+   prog->AttributeBindings = new string_to_uint_map;
+   prog->FragDataBindings = new string_to_uint_map;
+   prog->FragDataIndexBindings = new string_to_uint_map;
+
+   char *text = load_text_file(prog, file_name);
+   if (text == NULL) {
+      fprintf(stderr, "%s: cannot read file\n", file_name);
+      goto done;
+   }
+
+   if (strstr(file_name, ".shader_test")) {
+      add_shader_test(prog, text);
+   } else {
+      const GLenum type = shader_type_for_file_name(file_name);
+      if (type)
+         add_shader(prog, type, text);
+   }
+
+   if (prog->NumShaders == 0) {
+      fprintf(stderr, "%s: no shaders found\n", file_name);
+      goto done;
+   }
+
+   for (unsigned i = 0; i < prog->NumShaders; i++) {
+      struct gl_shader *shader = prog->Shaders[i];
+
+      TIME("_mesa_glsl_compile_shader",
+           _mesa_glsl_compile_shader(ctx, shader, false, false));
+      if (!shader->CompileStatus) {
+         fprintf(stderr, "%s: compile failed:\n%s\n", file_name,
+                 shader->InfoLog);
+         goto done;
+      }
+   }
+
+   _mesa_clear_shader_program_data(prog);
+   TIME("link_shaders", link_shaders(ctx, prog));
+   if (!prog->LinkStatus) {
+      fprintf(stderr, "%s: link failed:\n%s\n", file_name, prog->InfoLog);
+      goto done;
+   }
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      if (prog->_LinkedShaders[i] == NULL)
+         continue;
+
+      nir_shader *nir;
+      TIME("glsl_to_nir",
+           nir = glsl_to_nir(prog, (gl_shader_stage) i, &nir_options));
+      optimize_nir(nir);
+      ralloc_free(nir);
+   }
+
+   ok = true;
+
+done:
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++)
+      ralloc_free(prog->_LinkedShaders[i]);
+
+   delete prog->AttributeBindings;
+   delete prog->FragDataBindings;
+   delete prog->FragDataIndexBindings;
+
+   ralloc_free(prog);
+   return ok;
+}
+
+static void
+print_json_string(const char *str)
+{
+   putchar('"');
+   for (const char *c = str; *c; c++) {
+      if (*c == '"' || *c == '\\')
+         printf("\\%c", *c);
+      else if ((unsigned char) *c < 0x20)
+         printf("\\u%04x", *c);
+      else
+         putchar(*c);
+   }
+   putchar('"');
+}
+
+static void
+print_json(char **files, const bool *file_ok, unsigned num_files,
+           unsigned iterations, uint64_t total_ns)
+{
+   printf("{\n");
+   printf("  \"iterations\": %u,\n", iterations);
+   printf("  \"allocations_counted\": %s,\n",
+          HAVE_ALLOCATION_COUNT ? "true" : "false");
+   printf("  \"total_time_ns\": %" PRIu64 ",\n", total_ns);
+
+   printf("  \"files\": [\n");
+   for (unsigned i = 0; i < num_files; i++) {
+      printf("    { \"name\": ");
+      print_json_string(files[i]);
+      printf(", \"ok\": %s }%s\n", file_ok[i] ? "true" : "false",
+             i + 1 < num_files ? "," : "");
+   }
+   printf("  ],\n");
+
+   printf("  \"passes\": [\n");
+   for (unsigned i = 0; i < num_passes; i++) {
+      printf("    { \"name\": ");
+      print_json_string(passes[i].name);
+      printf(", \"calls\": %" PRIu64 ", \"time_ns\": %" PRIu64
+             ", \"allocations\": %" PRIu64 " }%s\n",
+             passes[i].calls, passes[i].time_ns, passes[i].allocations,
+             i + 1 < num_passes ? "," : "");
+   }
+   printf("  ]\n");
+   printf("}\n");
+}
+
+static void
+print_table(unsigned iterations, uint64_t total_ns)
+{
+   printf("%-40s %10s %12s %12s\n", "pass", "calls", "time (ms)",
+          "allocations");
+   for (unsigned i = 0; i < num_passes; i++) {
+      printf("%-40s %10" PRIu64 " %12.3f %12" PRIu64 "\n",
+             passes[i].name, passes[i].calls, passes[i].time_ns / 1e6,
+             passes[i].allocations);
+   }
+   printf("\ntotal: %.3f ms over %u iteration(s)\n", total_ns / 1e6,
+          iterations);
+}
+
+static int json = 0;
+
+static const struct option bench_opts[] = {
+   { "json",       no_argument,       &json, 1 },
+   { "iterations", required_argument, NULL,  'i' },
+   { NULL, 0, NULL, 0 }
+};
+
+static void
+usage_fail(const char *name)
+{
+   printf("usage: %s [--json] [--iterations N] "
+          "<file.shader_test | file.vert | ...>...\n", name);
+   exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char **argv)
+{
+   struct gl_context local_ctx;
+   struct gl_context *ctx = &local_ctx;
+   unsigned iterations = 1;
+   int status = EXIT_SUCCESS;
+
+   int c;
+   int idx = 0;
+   while ((c = getopt_long(argc, argv, "", bench_opts, &idx)) != -1) {
+      switch (c) {
+      case 'i':
+         iterations = strtoul(optarg, NULL, 10);
+         if (iterations == 0)
+            usage_fail(argv[0]);
+         break;
+      case 0:
+         break;
+      default:
+         usage_fail(argv[0]);
+      }
+   }
+
+   if (argc <= optind)
+      usage_fail(argv[0]);
+
+   initialize_context(ctx);
+   _mesa_glsl_pass_hook = record_pass;
+
+   char **files = &argv[optind];
+   const unsigned num_files = argc - optind;
+   bool *file_ok = new bool[num_files];
+
+   const uint64_t start_ns = get_time_ns();
+   for (unsigned iter = 0; iter < iterations; iter++) {
+      for (unsigned i = 0; i < num_files; i++) {
+         file_ok[i] = run_file(ctx, files[i]);
+         if (!file_ok[i])
+            status = EXIT_FAILURE;
+      }
+   }
+   const uint64_t total_ns = get_time_ns() - start_ns;
+
+   _mesa_glsl_pass_hook = NULL;
+
+   if (json)
+      print_json(files, file_ok, num_files, iterations, total_ns);
+   else
+      print_table(iterations, total_ns);
+
+   delete[] file_ok;
+
+   _mesa_glsl_release_types();
+   _mesa_glsl_release_builtin_functions();
+
+   return status;
+}
@@ -28,7 +28,7 @@
 #include "main/core.h" /* for struct gl_context */
 #include "main/context.h"
 #include "main/shaderobj.h"
-#include "util/u_atomic.h" /* for p_atomic_cmpxchg */
+#include "util/u_atomic.h" /* for p_atomic_cmpxchg, p_atomic_inc_return */
 #include "util/ralloc.h"
 #include "ast.h"
 #include "glsl_parser_extras.h"
@@ -64,6 +64,9 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    this->translation_unit.make_empty();
    this->symbols = new(mem_ctx) glsl_symbol_table;
 
+   this->linalloc = linear_alloc_parent(this, 0);
+   assert(this->linalloc);
+
    this->info_log = ralloc_strdup(mem_ctx, "");
    this->error = false;
    this->loop_nesting_ast = NULL;
@@ -1747,6 +1750,25 @@ set_shader_inout_layout(struct gl_shader *shader,
    }
 }
 
+void (*_mesa_glsl_pass_hook)(const char *pass, bool start) = NULL;
+
+static inline void
+pass_hook(const char *pass, bool start)
+{
+   if (unlikely(_mesa_glsl_pass_hook))
+      _mesa_glsl_pass_hook(pass, start);
+}
+
+/**
+ * Runs an optimization pass, reporting it to _mesa_glsl_pass_hook, and
+ * accumulates its result in the caller's \c progress.
+ */
+#define OPT(PASS, ...) do {                       \
+      pass_hook(#PASS, true);                     \
+      progress = PASS(__VA_ARGS__) || progress;   \
+      pass_hook(#PASS, false);                    \
+   } while (0)
+
 extern "C" {
 
 void
@@ -1756,18 +1778,25 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
    struct _mesa_glsl_parse_state *state =
       new(shader) _mesa_glsl_parse_state(ctx, shader->Stage, shader);
    const char *source = shader->Source;
+   static unsigned compile_serial;
+
+   shader->CompileSerial = p_atomic_inc_return(&compile_serial);
 
    if (ctx->Const.GenerateTemporaryNames)
       (void) p_atomic_cmpxchg(&ir_variable::temporaries_allocate_names,
                               false, true);
 
+   pass_hook("glcpp_preprocess", true);
    state->error = glcpp_preprocess(state, &source, &state->info_log,
                              &ctx->Extensions, ctx);
+   pass_hook("glcpp_preprocess", false);
 
    if (!state->error) {
+     pass_hook("_mesa_glsl_parse", true);
      _mesa_glsl_lexer_ctor(state, source);
      _mesa_glsl_parse(state);
      _mesa_glsl_lexer_dtor(state);
+     pass_hook("_mesa_glsl_parse", false);
    }
 
    if (dump_ast) {
@@ -1779,8 +1808,11 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
 
    ralloc_free(shader->ir);
    shader->ir = new(shader) exec_list;
-   if (!state->error && !state->translation_unit.is_empty())
+   if (!state->error && !state->translation_unit.is_empty()) {
+      pass_hook("_mesa_ast_to_hir", true);
       _mesa_ast_to_hir(shader->ir, state);
+      pass_hook("_mesa_ast_to_hir", false);
+   }
 
    if (!state->error) {
       validate_ir_tree(shader->ir);
@@ -1796,7 +1828,10 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
       struct gl_shader_compiler_options *options =
          &ctx->Const.ShaderCompilerOptions[shader->Stage];
 
+      pass_hook("lower_subroutine", true);
       lower_subroutine(shader->ir, state);
+      pass_hook("lower_subroutine", false);
+
       /* Do some optimization at compile time to reduce shader IR size
        * and reduce later work if the same shader is linked multiple times
        */
@@ -1822,7 +1857,9 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
          break;
       }
 
+      pass_hook("optimize_dead_builtin_variables", true);
       optimize_dead_builtin_variables(shader->ir, other);
+      pass_hook("optimize_dead_builtin_variables", false);
 
       validate_ir_tree(shader->ir);
    }
@@ -1903,56 +1940,62 @@ do_common_optimization(exec_list *ir, bool linked,
 {
    GLboolean progress = GL_FALSE;
 
-   progress = lower_instructions(ir, SUB_TO_ADD_NEG) || progress;
+   OPT(lower_instructions, ir, SUB_TO_ADD_NEG);
 
    if (linked) {
-      progress = do_function_inlining(ir) || progress;
-      progress = do_dead_functions(ir) || progress;
-      progress = do_structure_splitting(ir) || progress;
+      OPT(do_function_inlining, ir);
+      OPT(do_dead_functions, ir);
+      OPT(do_structure_splitting, ir);
    }
-   progress = do_if_simplification(ir) || progress;
-   progress = opt_flatten_nested_if_blocks(ir) || progress;
-   progress = opt_conditional_discard(ir) || progress;
-   progress = do_copy_propagation(ir) || progress;
-   progress = do_copy_propagation_elements(ir) || progress;
+   OPT(do_if_simplification, ir);
+   OPT(opt_flatten_nested_if_blocks, ir);
+   OPT(opt_conditional_discard, ir);
+   OPT(do_copy_propagation, ir);
+   OPT(do_copy_propagation_elements, ir);
 
    if (options->OptimizeForAOS && !linked)
-      progress = opt_flip_matrices(ir) || progress;
+      OPT(opt_flip_matrices, ir);
 
    if (linked && options->OptimizeForAOS) {
-      progress = do_vectorize(ir) || progress;
+      OPT(do_vectorize, ir);
    }
 
    if (linked)
-      progress = do_dead_code(ir, uniform_locations_assigned) || progress;
+      OPT(do_dead_code, ir, uniform_locations_assigned);
    else
-      progress = do_dead_code_unlinked(ir) || progress;
-   progress = do_dead_code_local(ir) || progress;
-   progress = do_tree_grafting(ir) || progress;
-   progress = do_constant_propagation(ir) || progress;
+      OPT(do_dead_code_unlinked, ir);
+   OPT(do_dead_code_local, ir);
+   OPT(do_tree_grafting, ir);
+   OPT(do_constant_propagation, ir);
    if (linked)
-      progress = do_constant_variable(ir) || progress;
+      OPT(do_constant_variable, ir);
    else
-      progress = do_constant_variable_unlinked(ir) || progress;
-   progress = do_constant_folding(ir) || progress;
-   progress = do_minmax_prune(ir) || progress;
-   progress = do_rebalance_tree(ir) || progress;
-   progress = do_algebraic(ir, native_integers, options) || progress;
-   progress = do_lower_jumps(ir) || progress;
-   progress = do_vec_index_to_swizzle(ir) || progress;
-   progress = lower_vector_insert(ir, false) || progress;
-   progress = do_swizzle_swizzle(ir) || progress;
-   progress = do_noop_swizzle(ir) || progress;
-
-   progress = optimize_split_arrays(ir, linked) || progress;
-   progress = optimize_redundant_jumps(ir) || progress;
-
-   loop_state *ls = analyze_loop_variables(ir);
-   if (ls->loop_found) {
-      progress = set_loop_controls(ir, ls) || progress;
-      progress = unroll_loops(ir, ls, options) || progress;
+      OPT(do_constant_variable_unlinked, ir);
+   OPT(do_constant_folding, ir);
+   OPT(do_minmax_prune, ir);
+   OPT(do_rebalance_tree, ir);
+   OPT(do_algebraic, ir, native_integers, options);
+   OPT(do_lower_jumps, ir);
+   OPT(do_vec_index_to_swizzle, ir);
+   OPT(lower_vector_insert, ir, false);
+   OPT(do_swizzle_swizzle, ir);
+   OPT(do_noop_swizzle, ir);
+
+   OPT(optimize_split_arrays, ir, linked);
+   OPT(optimize_redundant_jumps, ir);
+
+   /* Once every loop is unrolled, the remaining iterations of the caller's
+    * optimization loop don't need to analyze them again.
+    */
+   if (contains_loops(ir)) {
+      pass_hook("analyze_loop_variables", true);
+      loop_state *ls = analyze_loop_variables(ir);
+      pass_hook("analyze_loop_variables", false);
+
+      OPT(set_loop_controls, ir, ls);
+      OPT(unroll_loops, ir, ls, options);
+      delete ls;
    }
-   delete ls;
 
    return progress;
 }
@@ -273,6 +273,12 @@ struct _mesa_glsl_parse_state {
    exec_list translation_unit;
    glsl_symbol_table *symbols;
 
+   /**
+    * Linear allocator for the AST and the lexer's strings, which all live
+    * exactly as long as the parser state.
+    */
+   void *linalloc;
+
    unsigned num_supported_versions;
    struct {
       unsigned ver;
@@ -77,6 +77,13 @@ bool do_common_optimization(exec_list *ir, bool linked,
                             const struct gl_shader_compiler_options *options,
                             bool native_integers);
 
+/**
+ * If set, called with \c start true before and false after each stage of
+ * _mesa_glsl_compile_shader() and each pass of do_common_optimization().
+ * Only the compile-time benchmark sets this.
+ */
+extern void (*_mesa_glsl_pass_hook)(const char *pass, bool start);
+
 bool do_rebalance_tree(exec_list *instructions);
 bool do_algebraic(exec_list *instructions, bool native_integers,
                   const struct gl_shader_compiler_options *options);
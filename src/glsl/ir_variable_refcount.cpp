@@ -29,6 +29,8 @@
  * were defined in the scope.
  */
 
+#include <new>
+#include "main/core.h" /* for MAX2 */
 #include "ir.h"
 #include "ir_visitor.h"
 #include "ir_variable_refcount.h"
@@ -38,30 +40,19 @@
 ir_variable_refcount_visitor::ir_variable_refcount_visitor()
 {
    this->mem_ctx = ralloc_context(NULL);
-   this->ht = _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+   this->ht = _mesa_hash_table_create(this->mem_ctx, _mesa_hash_pointer,
                                       _mesa_key_pointer_equal);
-}
-
-static void
-free_entry(struct hash_entry *entry)
-{
-   ir_variable_refcount_entry *ivre = (ir_variable_refcount_entry *) entry->data;
-
-   /* Free assignment list */
-   exec_node *n;
-   while ((n = ivre->assign_list.pop_head()) != NULL) {
-      struct assignment_entry *assignment_entry =
-         exec_node_data(struct assignment_entry, n, link);
-      free(assignment_entry);
-   }
-
-   delete ivre;
+   this->free_entries = NULL;
+   this->num_free_entries = 0;
+   this->num_entries = 0;
+   this->free_assignments = NULL;
+   this->num_free_assignments = 0;
+   this->num_assignments = 0;
 }
 
 ir_variable_refcount_visitor::~ir_variable_refcount_visitor()
 {
    ralloc_free(this->mem_ctx);
-   _mesa_hash_table_destroy(this->ht, free_entry);
 }
 
 // constructor
@@ -83,7 +74,18 @@ ir_variable_refcount_visitor::get_variable_entry(ir_variable *var)
    if (e)
       return (ir_variable_refcount_entry *)e->data;
 
-   ir_variable_refcount_entry *entry = new ir_variable_refcount_entry(var);
+   if (this->num_free_entries == 0) {
+      /* Grow the blocks with the shader, starting at 32 entries. */
+      this->num_free_entries = MAX2(this->num_entries, 32);
+      this->free_entries = (ir_variable_refcount_entry *)
+         ralloc_size(this->mem_ctx,
+                     this->num_free_entries * sizeof(*this->free_entries));
+   }
+
+   ir_variable_refcount_entry *entry =
+      new(this->free_entries++) ir_variable_refcount_entry(var);
+   this->num_free_entries--;
+   this->num_entries++;
    assert(entry->referenced_count == 0);
    _mesa_hash_table_insert(this->ht, var, entry);
 
@@ -91,6 +93,25 @@ ir_variable_refcount_visitor::get_variable_entry(ir_variable *var)
 }
 
 
+struct assignment_entry *
+ir_variable_refcount_visitor::new_assignment_entry(ir_assignment *assign)
+{
+   if (this->num_free_assignments == 0) {
+      this->num_free_assignments = MAX2(this->num_assignments, 32);
+      this->free_assignments = ralloc_array(this->mem_ctx,
+                                            struct assignment_entry,
+                                            this->num_free_assignments);
+   }
+
+   struct assignment_entry *entry = this->free_assignments++;
+   this->num_free_assignments--;
+   this->num_assignments++;
+
+   entry->assign = assign;
+   return entry;
+}
+
+
 ir_visitor_status
 ir_variable_refcount_visitor::visit(ir_variable *ir)
 {
@@ -143,8 +164,7 @@ ir_variable_refcount_visitor::visit_leave(ir_assignment *ir)
       assert(entry->referenced_count >= entry->assigned_count);
       if (entry->referenced_count == entry->assigned_count) {
          struct assignment_entry *assignment_entry =
-            (struct assignment_entry *)calloc(1, sizeof(*assignment_entry));
-         assignment_entry->assign = ir;
+            new_assignment_entry(ir);
          entry->assign_list.push_head(&assignment_entry->link);
       }
    }
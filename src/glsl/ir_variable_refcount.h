@@ -48,7 +48,7 @@ public:
    /**
     * List of assignments to the variable, if any.
     * This is intended to be used for dead code optimisation and may
-    * not be a complete list.
+    * not be a complete list.  The entries belong to the visitor.
     */
    exec_list assign_list;
 
@@ -77,4 +77,24 @@ public:
    struct hash_table *ht;
 
    void *mem_ctx;
+
+private:
+   struct assignment_entry *new_assignment_entry(ir_assignment *assign);
+
+   /**
+    * \name Unused entries of the last blocks allocated from mem_ctx.
+    *
+    * Entries are handed out from blocks that grow with the shader, so
+    * counting takes a few allocations instead of one per variable and per
+    * assignment.  Everything is freed with mem_ctx.
+    */
+   /*@{*/
+   ir_variable_refcount_entry *free_entries;
+   unsigned num_free_entries;
+   unsigned num_entries;
+
+   struct assignment_entry *free_assignments;
+   unsigned num_free_assignments;
+   unsigned num_assignments;
+   /*@}*/
 };
@@ -1329,5 +1329,32 @@ link_assign_uniform_locations(struct gl_shader_program *prog,
 
    link_set_uniform_initializers(prog, boolean_true);
 
+   /* Keep the initial values and block bindings, which a later link of the
+    * program with the same inputs goes back to instead of linking again.
+    */
+   prog->NumUniformDataSlots = num_data_slots;
+   prog->UniformDataSlots = data;
+   prog->UniformDataDefaults =
+      ralloc_array(uniforms, union gl_constant_value, num_data_slots);
+   memcpy(prog->UniformDataDefaults, data,
+          num_data_slots * sizeof(union gl_constant_value));
+
+   for (unsigned i = 0; i < prog->NumBufferInterfaceBlocks; i++) {
+      prog->BufferInterfaceBlocks[i].DefaultBinding =
+         prog->BufferInterfaceBlocks[i].Binding;
+   }
+
+   for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
+      gl_shader *sh = prog->_LinkedShaders[i];
+
+      if (sh == NULL)
+         continue;
+
+      for (unsigned j = 0; j < sh->NumBufferInterfaceBlocks; j++) {
+         sh->BufferInterfaceBlocks[j].DefaultBinding =
+            sh->BufferInterfaceBlocks[j].Binding;
+      }
+   }
+
    return;
 }
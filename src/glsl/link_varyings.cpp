@@ -408,6 +408,28 @@ tfeedback_decl::is_same(const tfeedback_decl &x, const tfeedback_decl &y)
 }
 
 
+/**
+ * Hash and compare functions for a hash_table of tfeedback_decl objects,
+ * keyed the same way as is_same().
+ */
+unsigned
+tfeedback_decl::hash(const void *key)
+{
+   const tfeedback_decl *decl = (const tfeedback_decl *) key;
+   unsigned hash = hash_table_string_hash(decl->var_name);
+
+   if (decl->is_subscripted)
+      hash ^= (decl->array_subscript + 1) * 0x9e3779b1u;
+   return hash;
+}
+
+int
+tfeedback_decl::compare(const void *a, const void *b)
+{
+   return !is_same(*(const tfeedback_decl *) a, *(const tfeedback_decl *) b);
+}
+
+
 /**
  * Assign a location and stream ID for this tfeedback_decl object based on the
  * transform feedback candidate found by find_candidate.
@@ -636,6 +658,9 @@ parse_tfeedback_decls(struct gl_context *ctx, struct gl_shader_program *prog,
                       const void *mem_ctx, unsigned num_names,
                       char **varying_names, tfeedback_decl *decls)
 {
+   hash_table *seen = hash_table_ctor(0, tfeedback_decl::hash,
+                                      tfeedback_decl::compare);
+
    for (unsigned i = 0; i < num_names; ++i) {
       decls[i].init(ctx, mem_ctx, varying_names[i]);
 
@@ -652,17 +677,17 @@ parse_tfeedback_decls(struct gl_context *ctx, struct gl_shader_program *prog,
        * specify the same varying variable and array index", since transform
        * feedback of arrays would be useless otherwise.
        */
-      for (unsigned j = 0; j < i; ++j) {
-         if (!decls[j].is_varying())
-            continue;
-
-         if (tfeedback_decl::is_same(decls[i], decls[j])) {
-            linker_error(prog, "Transform feedback varying %s specified "
-                         "more than once.", varying_names[i]);
-            return false;
-         }
+      if (hash_table_find(seen, &decls[i]) != NULL) {
+         linker_error(prog, "Transform feedback varying %s specified "
+                      "more than once.", varying_names[i]);
+         hash_table_dtor(seen);
+         return false;
       }
+
+      hash_table_insert(seen, &decls[i], &decls[i]);
    }
+
+   hash_table_dtor(seen);
    return true;
 }
 
@@ -1304,8 +1329,8 @@ populate_consumer_input_sets(void *mem_ctx, exec_list *ir,
             hash_table_insert(consumer_interface_inputs, input_var,
                               iface_field_name);
          } else {
-            hash_table_insert(consumer_inputs, input_var,
-                              ralloc_strdup(mem_ctx, input_var->name));
+            /* The variable outlives the table, so its name can be the key. */
+            hash_table_insert(consumer_inputs, input_var, input_var->name);
          }
       }
    }
@@ -1539,6 +1564,17 @@ assign_varying_locations(struct gl_context *ctx,
       return false;
    }
 
+   /* Transform feedback candidates are only looked up for varying
+    * tfeedback_decls, so don't build the table when there are none.
+    */
+   bool has_tfeedback_varyings = false;
+   for (unsigned i = 0; i < num_tfeedback_decls; ++i) {
+      if (tfeedback_decls[i].is_varying()) {
+         has_tfeedback_varyings = true;
+         break;
+      }
+   }
+
    if (producer) {
       foreach_in_list(ir_instruction, node, producer->ir) {
          ir_variable *const output_var = node->as_variable();
@@ -1552,8 +1588,10 @@ assign_varying_locations(struct gl_context *ctx,
                 (output_var->data.stream < MAX_VERTEX_STREAMS &&
                  producer->Stage == MESA_SHADER_GEOMETRY));
 
-         tfeedback_candidate_generator g(mem_ctx, tfeedback_candidates);
-         g.process(output_var);
+         if (has_tfeedback_varyings) {
+            tfeedback_candidate_generator g(mem_ctx, tfeedback_candidates);
+            g.process(output_var);
+         }
 
          ir_variable *const input_var =
             linker::get_matching_input(mem_ctx, output_var, consumer_inputs,
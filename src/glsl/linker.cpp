@@ -2111,7 +2111,10 @@ link_intrastage_shaders(void *mem_ctx,
          memcpy(linking_shaders, shader_list, num_shaders * sizeof(gl_shader *));
          linking_shaders[num_shaders] = _mesa_glsl_get_builtin_function_shader();
 
+         /* Other threads may be adding built-ins to it while compiling. */
+         _mesa_glsl_lock_builtin_functions();
          ok = link_function_calls(prog, linked, linking_shaders, num_shaders + 1);
+         _mesa_glsl_unlock_builtin_functions();
 
          free(linking_shaders);
       } else {
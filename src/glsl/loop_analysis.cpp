@@ -638,3 +638,48 @@ analyze_loop_variables(exec_list *instructions)
    v.run(instructions);
    return v.loops;
 }
+
+
+namespace {
+
+class loop_finder : public ir_hierarchical_visitor {
+public:
+   loop_finder() : found(false)
+   {
+   }
+
+   virtual ir_visitor_status visit_enter(ir_loop *)
+   {
+      found = true;
+      return visit_stop;
+   }
+
+   /* Loops can't be nested in any of these. */
+   virtual ir_visitor_status visit_enter(ir_assignment *)
+   {
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_call *)
+   {
+      return visit_continue_with_parent;
+   }
+
+   virtual ir_visitor_status visit_enter(ir_expression *)
+   {
+      return visit_continue_with_parent;
+   }
+
+   bool found;
+};
+
+} /* anonymous namespace */
+
+bool
+contains_loops(exec_list *instructions)
+{
+   loop_finder v;
+
+   v.run(instructions);
+   return v.found;
+}
@@ -35,6 +35,15 @@
 extern class loop_state *
 analyze_loop_variables(exec_list *instructions);
 
+/**
+ * Whether the instruction list contains any loops
+ *
+ * This stops at the first loop and allocates nothing, so callers can skip
+ * \c analyze_loop_variables once every loop has been unrolled.
+ */
+extern bool
+contains_loops(exec_list *instructions);
+
 
 /**
  * Fill in loop control fields
@@ -60,10 +60,19 @@ is_break(ir_instruction *ir)
 		     && ((ir_loop_jump *) ir)->is_break();
 }
 
+/**
+ * Estimates the size of one unrolled copy of a loop body.
+ *
+ * Instructions that only exist to run the loop, i.e. the limiting terminator
+ * and the updates of the induction variables, are not counted, and neither
+ * are expressions of constants and induction variables, since all of them
+ * fold away once the induction variable has a constant value in each copy.
+ */
 class loop_unroll_count : public ir_hierarchical_visitor {
 public:
    int nodes;
    bool unsupported_variable_indexing;
+   bool array_indexed_by_induction_var;
    bool array_indexed_by_induction_var_with_exact_iterations;
    /* If there are nested loops, the node count will be inaccurate. */
    bool nested_loop;
@@ -75,23 +84,43 @@ public:
       nodes = 0;
       nested_loop = false;
       unsupported_variable_indexing = false;
+      array_indexed_by_induction_var = false;
       array_indexed_by_induction_var_with_exact_iterations = false;
 
       run(list);
    }
 
-   virtual ir_visitor_status visit_enter(ir_assignment *)
+   virtual ir_visitor_status visit_enter(ir_assignment *ir)
    {
+      ir_variable *var = ir->lhs->variable_referenced();
+      loop_variable *lv = var ? ls->get(var) : NULL;
+
+      if (lv && lv->is_induction_var() && ir->condition == NULL &&
+          folds_after_unroll(ir->rhs))
+         return visit_continue_with_parent;
+
       nodes++;
       return visit_continue;
    }
 
-   virtual ir_visitor_status visit_enter(ir_expression *)
+   virtual ir_visitor_status visit_enter(ir_expression *ir)
    {
+      if (folds_after_unroll(ir))
+         return visit_continue_with_parent;
+
       nodes++;
       return visit_continue;
    }
 
+   virtual ir_visitor_status visit_enter(ir_if *ir)
+   {
+      /* The limiting terminator is removed before unrolling. */
+      if (ir == ls->limiting_terminator->ir)
+         return visit_continue_with_parent;
+
+      return visit_continue;
+   }
+
    virtual ir_visitor_status visit_enter(ir_loop *)
    {
       nested_loop = true;
@@ -126,6 +155,8 @@ public:
          ir_variable *array = ir->array->variable_referenced();
          loop_variable *lv = ls->get(ir->array_index->variable_referenced());
          if (array && lv && lv->is_induction_var()) {
+            array_indexed_by_induction_var = true;
+
             /* If an array is indexed by a loop induction variable, and the
              * array size is exactly the number of loop iterations, this is
              * probably a simple for-loop trying to access each element in
@@ -164,6 +195,37 @@ public:
    }
 
 private:
+   /**
+    * Whether \p ir only depends on constants and induction variables, so
+    * that it is constant in each unrolled copy of the body.
+    */
+   bool folds_after_unroll(ir_rvalue *ir)
+   {
+      if (ir->as_constant())
+         return true;
+
+      ir_dereference_variable *deref = ir->as_dereference_variable();
+      if (deref) {
+         loop_variable *lv = ls->get(deref->var);
+         return lv && lv->is_induction_var();
+      }
+
+      ir_swizzle *swiz = ir->as_swizzle();
+      if (swiz)
+         return folds_after_unroll(swiz->val);
+
+      ir_expression *expr = ir->as_expression();
+      if (expr) {
+         for (unsigned i = 0; i < expr->get_num_operands(); i++) {
+            if (!folds_after_unroll(expr->operands[i]))
+               return false;
+         }
+         return true;
+      }
+
+      return false;
+   }
+
    loop_variable_state *ls;
    const struct gl_shader_compiler_options *options;
 };
@@ -330,12 +392,20 @@ loop_unroll_visitor::visit_leave(ir_loop *ir)
    if (iterations > max_iterations)
       return visit_continue;
 
-   /* Don't try to unroll nested loops and loops with a huge body.
+   /* Don't try to unroll nested loops and loops that would unroll to huge
+    * amounts of code.  Unrolling a loop that indexes arrays with its
+    * induction variable turns the accesses into constant indexing, which
+    * pays for twice as much code.
     */
    loop_unroll_count count(&ir->body_instructions, ls, options);
 
-   bool loop_too_large =
-      count.nested_loop || count.nodes * iterations > max_iterations * 5;
+   uint64_t max_instructions = options->MaxUnrollInstructions ?
+      options->MaxUnrollInstructions : (uint64_t) max_iterations * 5;
+   if (count.array_indexed_by_induction_var)
+      max_instructions *= 2;
+
+   bool loop_too_large = count.nested_loop ||
+      (uint64_t) count.nodes * iterations > max_instructions;
 
    if (loop_too_large && !count.unsupported_variable_indexing &&
        !count.array_indexed_by_induction_var_with_exact_iterations)
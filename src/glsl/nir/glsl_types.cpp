@@ -25,16 +25,52 @@
 #include "main/macros.h"
 #include "glsl_parser_extras.h"
 #include "glsl_types.h"
+#include "blob.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
 
 
 mtx_t glsl_type::mutex = _MTX_INITIALIZER_NP;
-hash_table *glsl_type::array_types = NULL;
-hash_table *glsl_type::record_types = NULL;
-hash_table *glsl_type::interface_types = NULL;
-hash_table *glsl_type::subroutine_types = NULL;
 void *glsl_type::mem_ctx = NULL;
 
+/**
+ * \name Table of the array, record, interface and subroutine types
+ *
+ * Every such type is created once and looked up by its contents afterwards,
+ * so that types can be compared by pointer.  All compiles in the process
+ * share the table, so it is searched without a lock: the built-in scalar,
+ * vector, matrix and sampler types are static and never need it, and most
+ * of the remaining lookups find a type that already exists.
+ *
+ * The table is open-addressed and kept at most half full.  Types are only
+ * added, with type_table_mutex held, and published with an atomic
+ * compare-and-swap once they are complete.  A table that gets too full is
+ * replaced by a copy twice as big; the old one stays valid for readers
+ * still in it until _mesa_glsl_release_types().  A reader that misses a
+ * type added to the new copy takes the lock and searches again.
+ */
+/*@{*/
+struct glsl_type_table {
+   unsigned size;                  /**< Number of slots, a power of two */
+   unsigned count;                 /**< Number of types in the slots */
+   volatile uintptr_t *slots;      /**< const glsl_type * or 0 */
+   struct glsl_type_table *prev;   /**< Table this one replaced */
+};
+
+/** Key of a type in the table, to search for it without creating it. */
+struct glsl_type_key {
+   glsl_base_type base_type;
+   const glsl_type *array;             /**< Element type of an array */
+   const glsl_struct_field *fields;    /**< Fields of a record or interface */
+   unsigned length;
+   unsigned packing;
+   const char *name;                   /**< NULL for arrays */
+};
+
+static mtx_t type_table_mutex = _MTX_INITIALIZER_NP;
+static volatile uintptr_t type_table;   /**< struct glsl_type_table * */
+/*@}*/
+
 void
 glsl_type::init_ralloc_type_ctx(void)
 {
@@ -163,6 +199,11 @@ glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
       this->fields.structure[i].sample = fields[i].sample;
       this->fields.structure[i].matrix_layout = fields[i].matrix_layout;
       this->fields.structure[i].patch = fields[i].patch;
+      this->fields.structure[i].image_read_only = fields[i].image_read_only;
+      this->fields.structure[i].image_write_only = fields[i].image_write_only;
+      this->fields.structure[i].image_coherent = fields[i].image_coherent;
+      this->fields.structure[i].image_volatile = fields[i].image_volatile;
+      this->fields.structure[i].image_restrict = fields[i].image_restrict;
       this->fields.structure[i].precision = fields[i].precision;
    }
 
@@ -369,20 +410,17 @@ _mesa_glsl_release_types(void)
     * object, or if process terminates), so no mutex-locking should be
     * necessary.
     */
-   if (glsl_type::array_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::array_types, NULL);
-      glsl_type::array_types = NULL;
-   }
+   struct glsl_type_table *table = (struct glsl_type_table *) type_table;
 
-   if (glsl_type::record_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::record_types, NULL);
-      glsl_type::record_types = NULL;
-   }
+   while (table != NULL) {
+      struct glsl_type_table *prev = table->prev;
 
-   if (glsl_type::interface_types != NULL) {
-      _mesa_hash_table_destroy(glsl_type::interface_types, NULL);
-      glsl_type::interface_types = NULL;
+      free((void *) table->slots);
+      free(table);
+      table = prev;
    }
+
+   type_table = 0;
 }
 
 
@@ -681,41 +719,130 @@ glsl_type::get_sampler_instance(enum glsl_sampler_dim dim,
 }
 
 const glsl_type *
-glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
+glsl_type::get_image_instance(enum glsl_sampler_dim dim,
+                              bool array, glsl_base_type type)
 {
-   /* Generate a name using the base type pointer in the key.  This is
-    * done because the name of the base type may not be unique across
-    * shaders.  For example, two shaders may have different record types
-    * named 'foo'.
-    */
-   char key[128];
-   snprintf(key, sizeof(key), "%p[%u]", (void *) base, array_size);
-
-   mtx_lock(&glsl_type::mutex);
-
-   if (array_types == NULL) {
-      array_types = _mesa_hash_table_create(NULL, _mesa_key_hash_string,
-                                            _mesa_key_string_equal);
+   switch (type) {
+   case GLSL_TYPE_FLOAT:
+      switch (dim) {
+      case GLSL_SAMPLER_DIM_1D:
+         return (array ? image1DArray_type : image1D_type);
+      case GLSL_SAMPLER_DIM_2D:
+         return (array ? image2DArray_type : image2D_type);
+      case GLSL_SAMPLER_DIM_3D:
+         if (array)
+            return error_type;
+         return image3D_type;
+      case GLSL_SAMPLER_DIM_CUBE:
+         return (array ? imageCubeArray_type : imageCube_type);
+      case GLSL_SAMPLER_DIM_RECT:
+         if (array)
+            return error_type;
+         else
+            return image2DRect_type;
+      case GLSL_SAMPLER_DIM_BUF:
+         if (array)
+            return error_type;
+         else
+            return imageBuffer_type;
+      case GLSL_SAMPLER_DIM_MS:
+         return (array ? image2DMSArray_type : image2DMS_type);
+      case GLSL_SAMPLER_DIM_EXTERNAL:
+         return error_type;
+      }
+   case GLSL_TYPE_INT:
+      switch (dim) {
+      case GLSL_SAMPLER_DIM_1D:
+         return (array ? iimage1DArray_type : iimage1D_type);
+      case GLSL_SAMPLER_DIM_2D:
+         return (array ? iimage2DArray_type : iimage2D_type);
+      case GLSL_SAMPLER_DIM_3D:
+         if (array)
+            return error_type;
+         return iimage3D_type;
+      case GLSL_SAMPLER_DIM_CUBE:
+         return (array ? iimageCubeArray_type : iimageCube_type);
+      case GLSL_SAMPLER_DIM_RECT:
+         if (array)
+            return error_type;
+         return iimage2DRect_type;
+      case GLSL_SAMPLER_DIM_BUF:
+         if (array)
+            return error_type;
+         return iimageBuffer_type;
+      case GLSL_SAMPLER_DIM_MS:
+         return (array ? iimage2DMSArray_type : iimage2DMS_type);
+      case GLSL_SAMPLER_DIM_EXTERNAL:
+         return error_type;
+      }
+   case GLSL_TYPE_UINT:
+      switch (dim) {
+      case GLSL_SAMPLER_DIM_1D:
+         return (array ? uimage1DArray_type : uimage1D_type);
+      case GLSL_SAMPLER_DIM_2D:
+         return (array ? uimage2DArray_type : uimage2D_type);
+      case GLSL_SAMPLER_DIM_3D:
+         if (array)
+            return error_type;
+         return uimage3D_type;
+      case GLSL_SAMPLER_DIM_CUBE:
+         return (array ? uimageCubeArray_type : uimageCube_type);
+      case GLSL_SAMPLER_DIM_RECT:
+         if (array)
+            return error_type;
+         return uimage2DRect_type;
+      case GLSL_SAMPLER_DIM_BUF:
+         if (array)
+            return error_type;
+         return uimageBuffer_type;
+      case GLSL_SAMPLER_DIM_MS:
+         return (array ? uimage2DMSArray_type : uimage2DMS_type);
+      case GLSL_SAMPLER_DIM_EXTERNAL:
+         return error_type;
+      }
+   default:
+      return error_type;
    }
 
-   const struct hash_entry *entry = _mesa_hash_table_search(array_types, key);
-   if (entry == NULL) {
-      mtx_unlock(&glsl_type::mutex);
-      const glsl_type *t = new glsl_type(base, array_size);
-      mtx_lock(&glsl_type::mutex);
+   unreachable("switch statement above should be complete");
+}
 
-      entry = _mesa_hash_table_insert(array_types,
-                                      ralloc_strdup(mem_ctx, key),
-                                      (void *) t);
+static bool
+record_fields_equal(const glsl_struct_field *a, const glsl_struct_field *b,
+                    unsigned length)
+{
+   for (unsigned i = 0; i < length; i++) {
+      if (a[i].type != b[i].type)
+         return false;
+      if (strcmp(a[i].name, b[i].name) != 0)
+         return false;
+      if (a[i].matrix_layout != b[i].matrix_layout)
+         return false;
+      if (a[i].location != b[i].location)
+         return false;
+      if (a[i].interpolation != b[i].interpolation)
+         return false;
+      if (a[i].centroid != b[i].centroid)
+         return false;
+      if (a[i].sample != b[i].sample)
+         return false;
+      if (a[i].patch != b[i].patch)
+         return false;
+      if (a[i].image_read_only != b[i].image_read_only)
+         return false;
+      if (a[i].image_write_only != b[i].image_write_only)
+         return false;
+      if (a[i].image_coherent != b[i].image_coherent)
+         return false;
+      if (a[i].image_volatile != b[i].image_volatile)
+         return false;
+      if (a[i].image_restrict != b[i].image_restrict)
+         return false;
+      if (a[i].precision != b[i].precision)
+         return false;
    }
 
-   assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_ARRAY);
-   assert(((glsl_type *) entry->data)->length == array_size);
-   assert(((glsl_type *) entry->data)->fields.array == base);
-
-   mtx_unlock(&glsl_type::mutex);
-
-   return (glsl_type *) entry->data;
+   return true;
 }
 
 
@@ -742,77 +869,47 @@ glsl_type::record_compare(const glsl_type *b) const
       if (strcmp(this->name, b->name) != 0)
          return false;
 
-   for (unsigned i = 0; i < this->length; i++) {
-      if (this->fields.structure[i].type != b->fields.structure[i].type)
-         return false;
-      if (strcmp(this->fields.structure[i].name,
-                 b->fields.structure[i].name) != 0)
-         return false;
-      if (this->fields.structure[i].matrix_layout
-         != b->fields.structure[i].matrix_layout)
-        return false;
-      if (this->fields.structure[i].location
-          != b->fields.structure[i].location)
-         return false;
-      if (this->fields.structure[i].interpolation
-          != b->fields.structure[i].interpolation)
-         return false;
-      if (this->fields.structure[i].centroid
-          != b->fields.structure[i].centroid)
-         return false;
-      if (this->fields.structure[i].sample
-          != b->fields.structure[i].sample)
-         return false;
-      if (this->fields.structure[i].patch
-          != b->fields.structure[i].patch)
-         return false;
-      if (this->fields.structure[i].image_read_only
-          != b->fields.structure[i].image_read_only)
-         return false;
-      if (this->fields.structure[i].image_write_only
-          != b->fields.structure[i].image_write_only)
-         return false;
-      if (this->fields.structure[i].image_coherent
-          != b->fields.structure[i].image_coherent)
-         return false;
-      if (this->fields.structure[i].image_volatile
-          != b->fields.structure[i].image_volatile)
-         return false;
-      if (this->fields.structure[i].image_restrict
-          != b->fields.structure[i].image_restrict)
-         return false;
-      if (this->fields.structure[i].precision
-          != b->fields.structure[i].precision)
-         return false;
-   }
-
-   return true;
+   return record_fields_equal(this->fields.structure, b->fields.structure,
+                              this->length);
 }
 
 
-bool
-glsl_type::record_key_compare(const void *a, const void *b)
+static void
+type_key_from_type(glsl_type_key *key, const glsl_type *type)
 {
-   const glsl_type *const key1 = (glsl_type *) a;
-   const glsl_type *const key2 = (glsl_type *) b;
-
-   return strcmp(key1->name, key2->name) == 0 && key1->record_compare(key2);
+   key->base_type = type->base_type;
+   key->length = type->length;
+   key->packing = type->interface_packing;
+
+   if (type->base_type == GLSL_TYPE_ARRAY) {
+      key->array = type->fields.array;
+      key->fields = NULL;
+      key->name = NULL;
+   } else {
+      key->array = NULL;
+      key->fields = type->fields.structure;
+      key->name = type->name;
+   }
 }
 
 
-/**
- * Generate an integer hash value for a glsl_type structure type.
- */
-unsigned
-glsl_type::record_key_hash(const void *a)
+static unsigned
+type_key_hash(const glsl_type_key *key)
 {
-   const glsl_type *const key = (glsl_type *) a;
-   uintptr_t hash = key->length;
+   uintptr_t hash = key->base_type * 31 + key->length;
    unsigned retval;
 
-   for (unsigned i = 0; i < key->length; i++) {
-      /* casting pointer to uintptr_t */
-      hash = (hash * 13 ) + (uintptr_t) key->fields.structure[i].type;
+   if (key->base_type == GLSL_TYPE_ARRAY) {
+      /* The element type pointer rather than its name, because the name
+       * of a record type is not unique across shaders.
+       */
+      hash = (hash * 13) + (uintptr_t) key->array;
+   } else {
+      for (unsigned i = 0; i < key->length; i++) {
+         /* casting pointer to uintptr_t */
+         hash = (hash * 13) + (uintptr_t) key->fields[i].type;
+      }
+      hash ^= _mesa_hash_string(key->name);
    }
 
    if (sizeof(hash) == 8)
@@ -824,37 +921,169 @@ glsl_type::record_key_hash(const void *a)
 }
 
 
+static bool
+type_key_matches(const glsl_type_key *key, const glsl_type *type)
+{
+   if (type->base_type != key->base_type || type->length != key->length)
+      return false;
+
+   if (key->base_type == GLSL_TYPE_ARRAY)
+      return type->fields.array == key->array;
+
+   return type->interface_packing == key->packing &&
+          strcmp(type->name, key->name) == 0 &&
+          record_fields_equal(type->fields.structure, key->fields,
+                              key->length);
+}
+
+
+/**
+ * Search the current type table.  Doesn't need type_table_mutex.
+ */
+static const glsl_type *
+find_type(const glsl_type_key *key, unsigned hash)
+{
+   const struct glsl_type_table *table =
+      (const struct glsl_type_table *) p_atomic_read(&type_table);
+
+   if (table == NULL)
+      return NULL;
+
+   const unsigned mask = table->size - 1;
+
+   for (unsigned i = hash & mask; ; i = (i + 1) & mask) {
+      const glsl_type *type =
+         (const glsl_type *) p_atomic_read(&table->slots[i]);
+
+      if (type == NULL)
+         return NULL;
+
+      if (type_key_matches(key, type))
+         return type;
+   }
+}
+
+
+static void
+insert_type(struct glsl_type_table *table, const glsl_type *type,
+            unsigned hash)
+{
+   const unsigned mask = table->size - 1;
+   unsigned i = hash & mask;
+
+   while (table->slots[i] != 0)
+      i = (i + 1) & mask;
+
+   p_atomic_cmpxchg(&table->slots[i], (uintptr_t) 0, (uintptr_t) type);
+   table->count++;
+}
+
+
+/**
+ * Add a type that find_type() didn't find.  type_table_mutex must be held.
+ */
+static void
+add_type(const glsl_type *type, unsigned hash)
+{
+   struct glsl_type_table *table = (struct glsl_type_table *) type_table;
+
+   if (table == NULL || (table->count + 1) * 2 > table->size) {
+      struct glsl_type_table *bigger = (struct glsl_type_table *)
+         calloc(1, sizeof(struct glsl_type_table));
+
+      bigger->size = table ? table->size * 2 : 64;
+      bigger->slots = (volatile uintptr_t *)
+         calloc(bigger->size, sizeof(uintptr_t));
+      bigger->prev = table;
+
+      for (unsigned i = 0; table && i < table->size; i++) {
+         const glsl_type *old = (const glsl_type *) table->slots[i];
+         glsl_type_key key;
+
+         if (old == NULL)
+            continue;
+
+         type_key_from_type(&key, old);
+         insert_type(bigger, old, type_key_hash(&key));
+      }
+
+      p_atomic_cmpxchg(&type_table, (uintptr_t) table, (uintptr_t) bigger);
+      table = bigger;
+   }
+
+   insert_type(table, type, hash);
+}
+
+
+const glsl_type *
+glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
+{
+   glsl_type_key key;
+
+   key.base_type = GLSL_TYPE_ARRAY;
+   key.array = base;
+   key.fields = NULL;
+   key.length = array_size;
+   key.packing = 0;
+   key.name = NULL;
+
+   const unsigned hash = type_key_hash(&key);
+   const glsl_type *t = find_type(&key, hash);
+
+   if (t == NULL) {
+      mtx_lock(&type_table_mutex);
+
+      t = find_type(&key, hash);
+      if (t == NULL) {
+         t = new glsl_type(base, array_size);
+         add_type(t, hash);
+      }
+
+      mtx_unlock(&type_table_mutex);
+   }
+
+   assert(t->base_type == GLSL_TYPE_ARRAY);
+   assert(t->length == array_size);
+   assert(t->fields.array == base);
+
+   return t;
+}
+
+
 const glsl_type *
 glsl_type::get_record_instance(const glsl_struct_field *fields,
                                unsigned num_fields,
                                const char *name)
 {
-   const glsl_type key(fields, num_fields, name);
+   glsl_type_key key;
 
-   mtx_lock(&glsl_type::mutex);
+   key.base_type = GLSL_TYPE_STRUCT;
+   key.array = NULL;
+   key.fields = fields;
+   key.length = num_fields;
+   key.packing = 0;
+   key.name = name;
 
-   if (record_types == NULL) {
-      record_types = _mesa_hash_table_create(NULL, record_key_hash,
-                                             record_key_compare);
-   }
+   const unsigned hash = type_key_hash(&key);
+   const glsl_type *t = find_type(&key, hash);
 
-   const struct hash_entry *entry = _mesa_hash_table_search(record_types,
-                                                            &key);
-   if (entry == NULL) {
-      mtx_unlock(&glsl_type::mutex);
-      const glsl_type *t = new glsl_type(fields, num_fields, name);
-      mtx_lock(&glsl_type::mutex);
+   if (t == NULL) {
+      mtx_lock(&type_table_mutex);
 
-      entry = _mesa_hash_table_insert(record_types, t, (void *) t);
-   }
+      t = find_type(&key, hash);
+      if (t == NULL) {
+         t = new glsl_type(fields, num_fields, name);
+         add_type(t, hash);
+      }
 
-   assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_STRUCT);
-   assert(((glsl_type *) entry->data)->length == num_fields);
-   assert(strcmp(((glsl_type *) entry->data)->name, name) == 0);
+      mtx_unlock(&type_table_mutex);
+   }
 
-   mtx_unlock(&glsl_type::mutex);
+   assert(t->base_type == GLSL_TYPE_STRUCT);
+   assert(t->length == num_fields);
+   assert(strcmp(t->name, name) == 0);
 
-   return (glsl_type *) entry->data;
+   return t;
 }
 
 
@@ -864,63 +1093,68 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
                                   enum glsl_interface_packing packing,
                                   const char *block_name)
 {
-   const glsl_type key(fields, num_fields, packing, block_name);
+   glsl_type_key key;
 
-   mtx_lock(&glsl_type::mutex);
+   key.base_type = GLSL_TYPE_INTERFACE;
+   key.array = NULL;
+   key.fields = fields;
+   key.length = num_fields;
+   key.packing = packing;
+   key.name = block_name;
 
-   if (interface_types == NULL) {
-      interface_types = _mesa_hash_table_create(NULL, record_key_hash,
-                                                record_key_compare);
-   }
+   const unsigned hash = type_key_hash(&key);
+   const glsl_type *t = find_type(&key, hash);
 
-   const struct hash_entry *entry = _mesa_hash_table_search(interface_types,
-                                                            &key);
-   if (entry == NULL) {
-      mtx_unlock(&glsl_type::mutex);
-      const glsl_type *t = new glsl_type(fields, num_fields,
-                                         packing, block_name);
-      mtx_lock(&glsl_type::mutex);
+   if (t == NULL) {
+      mtx_lock(&type_table_mutex);
 
-      entry = _mesa_hash_table_insert(interface_types, t, (void *) t);
-   }
+      t = find_type(&key, hash);
+      if (t == NULL) {
+         t = new glsl_type(fields, num_fields, packing, block_name);
+         add_type(t, hash);
+      }
 
-   assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_INTERFACE);
-   assert(((glsl_type *) entry->data)->length == num_fields);
-   assert(strcmp(((glsl_type *) entry->data)->name, block_name) == 0);
+      mtx_unlock(&type_table_mutex);
+   }
 
-   mtx_unlock(&glsl_type::mutex);
+   assert(t->base_type == GLSL_TYPE_INTERFACE);
+   assert(t->length == num_fields);
+   assert(strcmp(t->name, block_name) == 0);
 
-   return (glsl_type *) entry->data;
+   return t;
 }
 
 const glsl_type *
 glsl_type::get_subroutine_instance(const char *subroutine_name)
 {
-   const glsl_type key(subroutine_name);
+   glsl_type_key key;
 
-   mtx_lock(&glsl_type::mutex);
+   key.base_type = GLSL_TYPE_SUBROUTINE;
+   key.array = NULL;
+   key.fields = NULL;
+   key.length = 0;
+   key.packing = 0;
+   key.name = subroutine_name;
 
-   if (subroutine_types == NULL) {
-      subroutine_types = _mesa_hash_table_create(NULL, record_key_hash,
-                                                 record_key_compare);
-   }
+   const unsigned hash = type_key_hash(&key);
+   const glsl_type *t = find_type(&key, hash);
 
-   const struct hash_entry *entry = _mesa_hash_table_search(subroutine_types,
-                                                            &key);
-   if (entry == NULL) {
-      mtx_unlock(&glsl_type::mutex);
-      const glsl_type *t = new glsl_type(subroutine_name);
-      mtx_lock(&glsl_type::mutex);
+   if (t == NULL) {
+      mtx_lock(&type_table_mutex);
 
-      entry = _mesa_hash_table_insert(subroutine_types, t, (void *) t);
-   }
+      t = find_type(&key, hash);
+      if (t == NULL) {
+         t = new glsl_type(subroutine_name);
+         add_type(t, hash);
+      }
 
-   assert(((glsl_type *) entry->data)->base_type == GLSL_TYPE_SUBROUTINE);
-   assert(strcmp(((glsl_type *) entry->data)->name, subroutine_name) == 0);
+      mtx_unlock(&type_table_mutex);
+   }
 
-   mtx_unlock(&glsl_type::mutex);
+   assert(t->base_type == GLSL_TYPE_SUBROUTINE);
+   assert(strcmp(t->name, subroutine_name) == 0);
 
-   return (glsl_type *) entry->data;
+   return t;
 }
 
 
@@ -1743,6 +1977,153 @@ glsl_type::coordinate_components() const
    return size;
 }
 
+void
+encode_type_to_blob(struct blob *blob, const glsl_type *type)
+{
+   blob_write_uint32(blob, type->base_type);
+
+   switch (type->base_type) {
+   case GLSL_TYPE_UINT:
+   case GLSL_TYPE_INT:
+   case GLSL_TYPE_FLOAT:
+   case GLSL_TYPE_DOUBLE:
+   case GLSL_TYPE_BOOL:
+      blob_write_uint32(blob, type->vector_elements);
+      blob_write_uint32(blob, type->matrix_columns);
+      return;
+   case GLSL_TYPE_SAMPLER:
+      blob_write_uint32(blob, type->sampler_dimensionality);
+      blob_write_uint32(blob, type->sampler_shadow);
+      blob_write_uint32(blob, type->sampler_array);
+      blob_write_uint32(blob, type->sampler_type);
+      return;
+   case GLSL_TYPE_IMAGE:
+      blob_write_uint32(blob, type->sampler_dimensionality);
+      blob_write_uint32(blob, type->sampler_array);
+      blob_write_uint32(blob, type->sampler_type);
+      return;
+   case GLSL_TYPE_SUBROUTINE:
+      blob_write_string(blob, type->name);
+      return;
+   case GLSL_TYPE_ARRAY:
+      blob_write_uint32(blob, type->length);
+      encode_type_to_blob(blob, type->fields.array);
+      return;
+   case GLSL_TYPE_STRUCT:
+   case GLSL_TYPE_INTERFACE:
+      blob_write_string(blob, type->name);
+      blob_write_uint32(blob, type->length);
+      blob_write_uint32(blob, type->interface_packing);
+      for (unsigned i = 0; i < type->length; i++) {
+         const glsl_struct_field *field = &type->fields.structure[i];
+
+         encode_type_to_blob(blob, field->type);
+         blob_write_string(blob, field->name);
+         blob_write_uint32(blob, field->location);
+         blob_write_uint32(blob, field->interpolation |
+                                 field->centroid << 2 |
+                                 field->sample << 3 |
+                                 field->matrix_layout << 4 |
+                                 field->patch << 6 |
+                                 field->precision << 7 |
+                                 field->image_read_only << 9 |
+                                 field->image_write_only << 10 |
+                                 field->image_coherent << 11 |
+                                 field->image_volatile << 12 |
+                                 field->image_restrict << 13);
+      }
+      return;
+   case GLSL_TYPE_ATOMIC_UINT:
+   case GLSL_TYPE_VOID:
+   case GLSL_TYPE_ERROR:
+      return;
+   }
+
+   assert(!"Cannot encode type!");
+}
+
+const glsl_type *
+decode_type_from_blob(struct blob_reader *blob)
+{
+   glsl_base_type base_type = (glsl_base_type) blob_read_uint32(blob);
+
+   switch (base_type) {
+   case GLSL_TYPE_UINT:
+   case GLSL_TYPE_INT:
+   case GLSL_TYPE_FLOAT:
+   case GLSL_TYPE_DOUBLE:
+   case GLSL_TYPE_BOOL: {
+      unsigned rows = blob_read_uint32(blob);
+      unsigned columns = blob_read_uint32(blob);
+      return glsl_type::get_instance(base_type, rows, columns);
+   }
+   case GLSL_TYPE_SAMPLER: {
+      glsl_sampler_dim dim = (glsl_sampler_dim) blob_read_uint32(blob);
+      bool shadow = blob_read_uint32(blob);
+      bool array = blob_read_uint32(blob);
+      glsl_base_type type = (glsl_base_type) blob_read_uint32(blob);
+      return glsl_type::get_sampler_instance(dim, shadow, array, type);
+   }
+   case GLSL_TYPE_IMAGE: {
+      glsl_sampler_dim dim = (glsl_sampler_dim) blob_read_uint32(blob);
+      bool array = blob_read_uint32(blob);
+      glsl_base_type type = (glsl_base_type) blob_read_uint32(blob);
+      return glsl_type::get_image_instance(dim, array, type);
+   }
+   case GLSL_TYPE_SUBROUTINE:
+      return glsl_type::get_subroutine_instance(blob_read_string(blob));
+   case GLSL_TYPE_ARRAY: {
+      unsigned length = blob_read_uint32(blob);
+      return glsl_type::get_array_instance(decode_type_from_blob(blob),
+                                           length);
+   }
+   case GLSL_TYPE_STRUCT:
+   case GLSL_TYPE_INTERFACE: {
+      const char *name = blob_read_string(blob);
+      unsigned num_fields = blob_read_uint32(blob);
+      glsl_interface_packing packing =
+         (glsl_interface_packing) blob_read_uint32(blob);
+
+      glsl_struct_field *fields = new glsl_struct_field[num_fields];
+      for (unsigned i = 0; i < num_fields; i++) {
+         fields[i].type = decode_type_from_blob(blob);
+         fields[i].name = blob_read_string(blob);
+         fields[i].location = blob_read_uint32(blob);
+
+         unsigned flags = blob_read_uint32(blob);
+         fields[i].interpolation = flags & 0x3;
+         fields[i].centroid = (flags >> 2) & 0x1;
+         fields[i].sample = (flags >> 3) & 0x1;
+         fields[i].matrix_layout = (flags >> 4) & 0x3;
+         fields[i].patch = (flags >> 6) & 0x1;
+         fields[i].precision = (flags >> 7) & 0x3;
+         fields[i].image_read_only = (flags >> 9) & 0x1;
+         fields[i].image_write_only = (flags >> 10) & 0x1;
+         fields[i].image_coherent = (flags >> 11) & 0x1;
+         fields[i].image_volatile = (flags >> 12) & 0x1;
+         fields[i].image_restrict = (flags >> 13) & 0x1;
+      }
+
+      const glsl_type *t;
+      if (base_type == GLSL_TYPE_INTERFACE)
+         t = glsl_type::get_interface_instance(fields, num_fields, packing,
+                                               name);
+      else
+         t = glsl_type::get_record_instance(fields, num_fields, name);
+
+      delete[] fields;
+      return t;
+   }
+   case GLSL_TYPE_ATOMIC_UINT:
+      return glsl_type::atomic_uint_type;
+   case GLSL_TYPE_VOID:
+      return glsl_type::void_type;
+   case GLSL_TYPE_ERROR:
+   default:
+      return glsl_type::error_type;
+   }
+}
+
 /**
  * Declarations of type flyweights (glsl_type::_foo_type) and
  * convenience pointers (glsl_type::foo_type).
@@ -35,6 +35,9 @@ extern "C" {
 
 struct _mesa_glsl_parse_state;
 struct glsl_symbol_table;
+struct glsl_type;
+struct blob;
+struct blob_reader;
 
 extern void
 _mesa_glsl_initialize_types(struct _mesa_glsl_parse_state *state);
@@ -42,6 +45,17 @@ _mesa_glsl_initialize_types(struct _mesa_glsl_parse_state *state);
 extern void
 _mesa_glsl_release_types(void);
 
+/**
+ * Write a description of \c type to \c blob from which
+ * decode_type_from_blob() can look up the same type again, in this process
+ * or in another one.
+ */
+extern void
+encode_type_to_blob(struct blob *blob, const struct glsl_type *type);
+
+extern const struct glsl_type *
+decode_type_from_blob(struct blob_reader *blob);
+
 #ifdef __cplusplus
 }
 #endif
@@ -250,6 +264,13 @@ struct glsl_type {
                                                 bool array,
                                                 glsl_base_type type);
 
+   /**
+    * Get the instance of an image type
+    */
+   static const glsl_type *get_image_instance(enum glsl_sampler_dim dim,
+                                              bool array,
+                                              glsl_base_type type);
+
 
    /**
     * Get the instance of an array type
@@ -764,21 +785,6 @@ private:
    /** Constructor for subroutine types */
    glsl_type(const char *name);
 
-   /** Hash table containing the known array types. */
-   static struct hash_table *array_types;
-
-   /** Hash table containing the known record types. */
-   static struct hash_table *record_types;
-
-   /** Hash table containing the known interface types. */
-   static struct hash_table *interface_types;
-
-   /** Hash table containing the known subroutine types. */
-   static struct hash_table *subroutine_types;
-
-   static bool record_key_compare(const void *a, const void *b);
-   static unsigned record_key_hash(const void *key);
-
    /**
     * \name Built-in type flyweights
     */
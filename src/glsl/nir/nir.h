@@ -402,12 +402,16 @@ typedef enum {
 
 typedef struct nir_instr {
    struct exec_node node;
-   nir_instr_type type;
    struct nir_block *block;
 
    /** generic instruction index. */
    unsigned index;
 
+   /* Every instruction starts with this header, so it is kept to 32 bytes:
+    * the type only needs a byte and shares a word with pass_flags.
+    */
+   nir_instr_type type:8;
+
    /* A temporary for optimization and analysis passes to use for storing
     * flags.  For instance, DCE uses this to store the "dead/live" info.
     */
@@ -1334,6 +1338,31 @@ typedef enum {
    nir_metadata_dominance = 0x2,
    nir_metadata_live_ssa_defs = 0x4,
    nir_metadata_not_properly_reset = 0x8,
+
+   /**
+    * Set by a pass on an impl where it just ran without making progress.
+    *
+    * Every pass that changes an impl has to call nir_metadata_preserve()
+    * and none of them lists these bits, so they stay set only as long as the
+    * impl is left untouched.  Until then, running the pass again would not
+    * make progress either, and it can return right away.  This keeps
+    * fixed-point optimization loops from re-walking the whole impl with
+    * every pass on every iteration.
+    *
+    * These can't be computed by nir_metadata_require().
+    */
+   nir_metadata_no_progress_copy_prop = 0x10,
+   nir_metadata_no_progress_cse = 0x20,
+   nir_metadata_no_progress_dce = 0x40,
+   nir_metadata_no_progress_gcm = 0x80,
+   nir_metadata_no_progress_constant_folding = 0x200,
+
+   /**
+    * The dominance frontier of each block.  Only passes that place phi nodes
+    * need it, so it isn't computed along with the dominance tree.  It stays
+    * valid as long as nir_metadata_dominance does.
+    */
+   nir_metadata_dom_frontier = 0x100,
 } nir_metadata;
 
 typedef struct {
@@ -1927,6 +1956,8 @@ static inline void nir_metadata_check_validation_flag(nir_shader *shader) { (voi
 
 void nir_calc_dominance_impl(nir_function_impl *impl);
 void nir_calc_dominance(nir_shader *shader);
+void nir_calc_dom_frontier_impl(nir_function_impl *impl);
+void nir_calc_dom_frontier(nir_shader *shader);
 
 nir_block *nir_dominance_lca(nir_block *b1, nir_block *b2);
 bool nir_block_dominates(nir_block *parent, nir_block *child);
@@ -1942,6 +1973,20 @@ void nir_dump_cfg(nir_shader *shader, FILE *fp);
 
 int nir_gs_count_vertices(const nir_shader *shader);
 
+/** Statistics for comparing generated code across drivers */
+typedef struct {
+   unsigned instrs; /** < all instructions, including the ones below */
+   unsigned alu_instrs;
+   unsigned tex_instrs;
+   unsigned intrinsic_instrs;
+   unsigned ssa_defs;
+   unsigned blocks;
+   unsigned ifs;
+   unsigned loops;
+} nir_shader_stats;
+
+void nir_gather_stats(nir_shader *shader, nir_shader_stats *stats);
+
 bool nir_split_var_copies(nir_shader *shader);
 
 void nir_lower_var_copy_instr(nir_intrinsic_instr *copy, void *mem_ctx);
@@ -2057,6 +2102,8 @@ void nir_convert_from_ssa(nir_shader *shader, bool phi_webs_only);
 
 bool nir_opt_algebraic(nir_shader *shader);
 bool nir_opt_algebraic_late(nir_shader *shader);
+bool nir_opt_combine_ubo_loads(nir_shader *shader);
+
 bool nir_opt_constant_folding(nir_shader *shader);
 
 bool nir_opt_global_to_local(nir_shader *shader);
@@ -2069,15 +2116,16 @@ bool nir_opt_dce(nir_shader *shader);
 
 bool nir_opt_dead_cf(nir_shader *shader);
 
-void nir_opt_gcm(nir_shader *shader);
+bool nir_opt_gcm(nir_shader *shader, bool value_number);
 
-bool nir_opt_peephole_select(nir_shader *shader);
+bool nir_opt_peephole_select(nir_shader *shader, unsigned limit);
 
 bool nir_opt_remove_phis(nir_shader *shader);
 
 bool nir_opt_undef(nir_shader *shader);
 
 void nir_sweep(nir_shader *shader);
+nir_shader *nir_shader_compact(nir_shader *shader);
 
 nir_intrinsic_op nir_intrinsic_from_system_value(gl_system_value val);
 gl_system_value nir_system_value_from_intrinsic(nir_intrinsic_op intrin);
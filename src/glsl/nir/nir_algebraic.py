@@ -29,6 +29,7 @@ import struct
 import sys
 import mako.template
 import re
+from nir_opcodes import opcodes
 
 # Represents a set of variables, each with a unique id
 class VarSet(object):
@@ -177,6 +178,85 @@ class SearchAndReplace(object):
       else:
          self.replace = Value.create(replace, "replace{0}".format(self.id), varset)
 
+# The key nir_search_src_key() has to return for a source of the root
+# instruction if it is to match the given search value, or None if the value
+# can match a source with any key.
+def _src_key(value):
+   if isinstance(value, Expression):
+      return 'nir_op_' + value.opcode
+   elif isinstance(value, Constant) or \
+        (isinstance(value, Variable) and value.is_constant):
+      return 'NIR_SEARCH_SRC_LOAD_CONST'
+   else:
+      return None
+
+# A decision tree that picks out the transforms for one root opcode that can
+# match a given instruction, by switching on the key of each of its sources
+# in turn.  Each instruction is then only matched against the transforms
+# that agree with it on the opcodes of its sources, however long the list
+# for its opcode gets.  The leaves are lists of indices into xforms, in the
+# original order, and are shared through the leaves list of the pass.
+class DecisionTree(object):
+   def __init__(self, opcode, xforms, leaves):
+      self.opcode = opcode
+      self.leaves = leaves
+
+      # The ways each transform can match: for commutative opcodes,
+      # match_expression() also tries the sources the other way around.
+      candidates = []
+      for i, xform in enumerate(xforms):
+         keys = [_src_key(src) for src in xform.search.sources]
+         candidates.append((i, keys))
+         if 'commutative' in opcodes[opcode].algebraic_properties:
+            candidates.append((i, keys[::-1]))
+
+      self.num_srcs = opcodes[opcode].num_inputs
+      self.root = self._build(candidates, 0)
+
+   def _leaf(self, candidates):
+      leaf = (self.opcode, tuple(sorted(set(i for i, _ in candidates))))
+      if not leaf[1]:
+         leaf = (None, ())
+      if leaf not in self.leaves:
+         self.leaves.append(leaf)
+      return self.leaves.index(leaf)
+
+   def _build(self, candidates, src):
+      if src == self.num_srcs:
+         return self._leaf(candidates)
+
+      default = self._build([c for c in candidates if c[1][src] is None],
+                            src + 1)
+
+      cases = []
+      for key in sorted(set(c[1][src] for c in candidates) - set([None])):
+         node = self._build([c for c in candidates if c[1][src] in (key, None)],
+                            src + 1)
+         if node != default:
+            cases.append((key, node))
+
+      if not cases:
+         return default
+
+      return (src, cases, default)
+
+   def render(self, pass_name, node=None, indent='   '):
+      if node is None:
+         node = self.root
+
+      if isinstance(node, int):
+         return '{0}return {1}_candidates_{2};'.format(indent, pass_name, node)
+
+      src, cases, default = node
+      lines = ['{0}switch (nir_search_src_key(alu, {1})) {{'.format(indent, src)]
+      for key, child in cases:
+         lines.append('{0}case {1}:'.format(indent, key))
+         lines.append(self.render(pass_name, child, indent + '   '))
+      lines.append('{0}default:'.format(indent))
+      lines.append(self.render(pass_name, default, indent + '   '))
+      lines.append('{0}}}'.format(indent))
+      return '\n'.join(lines)
+
 _algebraic_pass_template = mako.template.Template("""
 #include "nir.h"
 #include "nir_search.h"
@@ -211,6 +291,24 @@ static const struct transform ${pass_name}_${opcode}_xforms[] = {
 };
 % endfor
 
+% for (i, (opcode, xforms)) in enumerate(leaves):
+static const struct transform *const ${pass_name}_candidates_${i}[] = {
+% for xform in xforms:
+   &${pass_name}_${opcode}_xforms[${xform}],
+% endfor
+   NULL
+};
+% endfor
+
+% for (opcode, tree) in trees.iteritems():
+static const struct transform *const *
+${pass_name}_${opcode}_candidates(const nir_alu_instr *alu)
+{
+${tree.render(pass_name)}
+}
+
+% endfor
+
 static bool
 ${pass_name}_block(nir_block *block, void *void_state)
 {
@@ -224,22 +322,25 @@ ${pass_name}_block(nir_block *block, void *void_state)
       if (!alu->dest.dest.is_ssa)
          continue;
 
+      const struct transform *const *xforms;
       switch (alu->op) {
       % for opcode in xform_dict.keys():
       case nir_op_${opcode}:
-         for (unsigned i = 0; i < ARRAY_SIZE(${pass_name}_${opcode}_xforms); i++) {
-            const struct transform *xform = &${pass_name}_${opcode}_xforms[i];
-            if (state->condition_flags[xform->condition_offset] &&
-                nir_replace_instr(alu, xform->search, xform->replace,
-                                  state->mem_ctx)) {
-               state->progress = true;
-               break;
-            }
-         }
+         xforms = ${pass_name}_${opcode}_candidates(alu);
          break;
       % endfor
       default:
-         break;
+         continue;
+      }
+
+      for (; *xforms != NULL; xforms++) {
+         const struct transform *xform = *xforms;
+         if (state->condition_flags[xform->condition_offset] &&
+             nir_replace_instr(alu, xform->search, xform->replace,
+                               state->mem_ctx)) {
+            state->progress = true;
+            break;
+         }
       }
    }
 
@@ -299,7 +400,14 @@ class AlgebraicPass(object):
 
          self.xform_dict[xform.search.opcode].append(xform)
 
+      self.leaves = []
+      self.trees = {}
+      for (opcode, xform_list) in self.xform_dict.iteritems():
+         self.trees[opcode] = DecisionTree(opcode, xform_list, self.leaves)
+
    def render(self):
       return _algebraic_pass_template.render(pass_name=self.pass_name,
                                              xform_dict=self.xform_dict,
+                                             leaves=self.leaves,
+                                             trees=self.trees,
                                              condition_list=condition_list)
@@ -48,11 +48,6 @@ init_block_cb(nir_block *block, void *_state)
       block->imm_dom = NULL;
    block->num_dom_children = 0;
 
-   struct set_entry *entry;
-   set_foreach(block->dom_frontier, entry) {
-      _mesa_set_remove(block->dom_frontier, entry);
-   }
-
    return true;
 }
 
@@ -104,7 +99,20 @@ calc_dominance_cb(nir_block *block, void *_state)
 }
 
 static bool
-calc_dom_frontier_cb(nir_block *block, void *state)
+clear_dom_frontier_cb(nir_block *block, void *state)
+{
+   (void) state;
+
+   struct set_entry *entry;
+   set_foreach(block->dom_frontier, entry) {
+      _mesa_set_remove(block->dom_frontier, entry);
+   }
+
+   return true;
+}
+
+static bool
+add_dom_frontier_cb(nir_block *block, void *state)
 {
    (void) state;
 
@@ -147,10 +155,13 @@ block_count_children(nir_block *block, void *state)
 static bool
 block_alloc_children(nir_block *block, void *state)
 {
-   void *mem_ctx = state;
+   (void) state;
 
-   block->dom_children = ralloc_array(mem_ctx, nir_block *,
-                                      block->num_dom_children);
+   /* Reuse the array from the last time dominance was computed, so that
+    * recomputing it over and over doesn't keep allocating.
+    */
+   block->dom_children = reralloc(block, block->dom_children, nir_block *,
+                                  block->num_dom_children);
    block->num_dom_children = 0;
 
    return true;
@@ -170,10 +181,8 @@ block_add_child(nir_block *block, void *state)
 static void
 calc_dom_children(nir_function_impl* impl)
 {
-   void *mem_ctx = ralloc_parent(impl);
-
    nir_foreach_block(impl, block_count_children, NULL);
-   nir_foreach_block(impl, block_alloc_children, mem_ctx);
+   nir_foreach_block(impl, block_alloc_children, NULL);
    nir_foreach_block(impl, block_add_child, NULL);
 }
 
@@ -207,8 +216,6 @@ nir_calc_dominance_impl(nir_function_impl *impl)
       nir_foreach_block(impl, calc_dominance_cb, &state);
    }
 
-   nir_foreach_block(impl, calc_dom_frontier_cb, &state);
-
    nir_block *start_block = nir_start_block(impl);
    start_block->imm_dom = NULL;
 
@@ -227,6 +234,27 @@ nir_calc_dominance(nir_shader *shader)
    }
 }
 
+void
+nir_calc_dom_frontier_impl(nir_function_impl *impl)
+{
+   if (impl->valid_metadata & nir_metadata_dom_frontier)
+      return;
+
+   nir_metadata_require(impl, nir_metadata_dominance);
+
+   nir_foreach_block(impl, clear_dom_frontier_cb, NULL);
+   nir_foreach_block(impl, add_dom_frontier_cb, NULL);
+}
+
+void
+nir_calc_dom_frontier(nir_shader *shader)
+{
+   nir_foreach_overload(shader, overload) {
+      if (overload->impl)
+         nir_calc_dom_frontier_impl(overload->impl);
+   }
+}
+
 /**
  * Computes the least common anscestor of two blocks.  If one of the blocks
  * is null, the other block is returned.
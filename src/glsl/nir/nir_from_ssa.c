@@ -37,6 +37,7 @@
 struct from_ssa_state {
    void *mem_ctx;
    void *dead_ctx;
+   void *dead_linalloc;
    bool phi_webs_only;
    struct hash_table *merge_node_table;
    nir_instr *instr;
@@ -124,12 +125,14 @@ get_merge_node(nir_ssa_def *def, struct from_ssa_state *state)
    if (entry)
       return entry->data;
 
-   merge_set *set = ralloc(state->dead_ctx, merge_set);
+   merge_set *set = linear_alloc_child(state->dead_linalloc,
+                                       sizeof(merge_set));
    exec_list_make_empty(&set->nodes);
    set->size = 1;
    set->reg = NULL;
 
-   merge_node *node = ralloc(state->dead_ctx, merge_node);
+   merge_node *node = linear_alloc_child(state->dead_linalloc,
+                                         sizeof(merge_node));
    node->set = set;
    node->def = def;
    exec_list_push_head(&set->nodes, &node->node);
@@ -765,6 +768,7 @@ nir_convert_from_ssa_impl(nir_function_impl *impl, bool phi_webs_only)
 
    state.mem_ctx = ralloc_parent(impl);
    state.dead_ctx = ralloc_context(NULL);
+   state.dead_linalloc = linear_alloc_parent(state.dead_ctx, 0);
    state.impl = impl;
    state.phi_webs_only = phi_webs_only;
    state.merge_node_table = _mesa_hash_table_create(NULL, _mesa_hash_pointer,
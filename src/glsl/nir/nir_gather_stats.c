@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "nir.h"
+
+/** @file nir_gather_stats.c
+ *
+ * Counts what a shader is made of, so that every driver can report the
+ * same numbers to shader-db-style tools alongside its backend statistics.
+ */
+
+static bool
+count_ssa_def_cb(nir_ssa_def *def, void *state)
+{
+   nir_shader_stats *stats = state;
+   stats->ssa_defs++;
+   return true;
+}
+
+static bool
+gather_stats_block(nir_block *block, void *state)
+{
+   nir_shader_stats *stats = state;
+
+   stats->blocks++;
+
+   nir_foreach_instr(block, instr) {
+      stats->instrs++;
+
+      switch (instr->type) {
+      case nir_instr_type_alu:
+         stats->alu_instrs++;
+         break;
+      case nir_instr_type_tex:
+         stats->tex_instrs++;
+         break;
+      case nir_instr_type_intrinsic:
+         stats->intrinsic_instrs++;
+         break;
+      default:
+         break;
+      }
+
+      nir_foreach_ssa_def(instr, count_ssa_def_cb, stats);
+   }
+
+   if (nir_block_get_following_if(block))
+      stats->ifs++;
+   if (nir_block_get_following_loop(block))
+      stats->loops++;
+
+   return true;
+}
+
+void
+nir_gather_stats(nir_shader *shader, nir_shader_stats *stats)
+{
+   memset(stats, 0, sizeof(*stats));
+
+   nir_foreach_overload(shader, overload) {
+      if (overload->impl)
+         nir_foreach_block(overload->impl, gather_stats_block, stats);
+   }
+}
@@ -198,6 +198,9 @@ nir_lower_alu_to_scalar_impl(nir_function_impl *impl)
    nir_builder_init(&builder, impl);
 
    nir_foreach_block(impl, lower_alu_to_scalar_block, &builder);
+
+   nir_metadata_preserve(impl, nir_metadata_block_index |
+                               nir_metadata_dominance);
 }
 
 void
@@ -77,6 +77,9 @@ static void
 nir_lower_load_const_to_scalar_impl(nir_function_impl *impl)
 {
    nir_foreach_block(impl, lower_load_const_to_scalar_block, NULL);
+
+   nir_metadata_preserve(impl, nir_metadata_block_index |
+                               nir_metadata_dominance);
 }
 
 void
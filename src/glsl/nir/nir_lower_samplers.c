@@ -174,6 +174,9 @@ lower_impl(nir_function_impl *impl, const struct gl_shader_program *shader_progr
    state.stage = stage;
 
    nir_foreach_block(impl, lower_block_cb, &state);
+
+   nir_metadata_preserve(impl, nir_metadata_block_index |
+                               nir_metadata_dominance);
 }
 
 void
@@ -184,6 +184,9 @@ static void
 nir_lower_to_source_mods_impl(nir_function_impl *impl)
 {
    nir_foreach_block(impl, nir_lower_to_source_mods_block, NULL);
+
+   nir_metadata_preserve(impl, nir_metadata_block_index |
+                               nir_metadata_dominance);
 }
 
 void
@@ -175,6 +175,9 @@ static void
 lower_var_copies_impl(nir_function_impl *impl)
 {
    nir_foreach_block(impl, lower_var_copies_block, ralloc_parent(impl));
+
+   nir_metadata_preserve(impl, nir_metadata_block_index |
+                               nir_metadata_dominance);
 }
 
 /* Lowers every copy_var instruction in the program to a sequence of
@@ -58,6 +58,7 @@ struct deref_node {
 struct lower_variables_state {
    nir_shader *shader;
    void *dead_ctx;
+   void *dead_linalloc;
    nir_function_impl *impl;
 
    /* A hash table mapping variables to deref_node data */
@@ -93,12 +94,12 @@ struct lower_variables_state {
 
 static struct deref_node *
 deref_node_create(struct deref_node *parent,
-                  const struct glsl_type *type, nir_shader *shader)
+                  const struct glsl_type *type, void *lin_ctx)
 {
    size_t size = sizeof(struct deref_node) +
                  glsl_get_length(type) * sizeof(struct deref_node *);
 
-   struct deref_node *node = rzalloc_size(shader, size);
+   struct deref_node *node = linear_zalloc_child(lin_ctx, size);
    node->type = type;
    node->parent = parent;
    node->deref = NULL;
@@ -121,7 +122,7 @@ get_deref_node_for_var(nir_variable *var, struct lower_variables_state *state)
    if (var_entry) {
       return var_entry->data;
    } else {
-      node = deref_node_create(NULL, var->type, state->dead_ctx);
+      node = deref_node_create(NULL, var->type, state->dead_linalloc);
       _mesa_hash_table_insert(state->deref_var_nodes, var, node);
       return node;
    }
@@ -150,7 +151,7 @@ get_deref_node(nir_deref_var *deref, struct lower_variables_state *state)
 
          if (node->children[deref_struct->index] == NULL)
             node->children[deref_struct->index] =
-               deref_node_create(node, tail->type, state->dead_ctx);
+               deref_node_create(node, tail->type, state->dead_linalloc);
 
          node = node->children[deref_struct->index];
          break;
@@ -170,7 +171,7 @@ get_deref_node(nir_deref_var *deref, struct lower_variables_state *state)
 
             if (node->children[arr->base_offset] == NULL)
                node->children[arr->base_offset] =
-                  deref_node_create(node, tail->type, state->dead_ctx);
+                  deref_node_create(node, tail->type, state->dead_linalloc);
 
             node = node->children[arr->base_offset];
             break;
@@ -178,7 +179,7 @@ get_deref_node(nir_deref_var *deref, struct lower_variables_state *state)
          case nir_deref_array_type_indirect:
             if (node->indirect == NULL)
                node->indirect = deref_node_create(node, tail->type,
-                                                  state->dead_ctx);
+                                                  state->dead_linalloc);
 
             node = node->indirect;
             is_direct = false;
@@ -187,7 +188,7 @@ get_deref_node(nir_deref_var *deref, struct lower_variables_state *state)
          case nir_deref_array_type_wildcard:
             if (node->wildcard == NULL)
                node->wildcard = deref_node_create(node, tail->type,
-                                                  state->dead_ctx);
+                                                  state->dead_linalloc);
 
             node = node->wildcard;
             is_direct = false;
@@ -889,6 +890,7 @@ nir_lower_vars_to_ssa_impl(nir_function_impl *impl)
 
    state.shader = impl->overload->function->shader;
    state.dead_ctx = ralloc_context(state.shader);
+   state.dead_linalloc = linear_alloc_parent(state.dead_ctx, 0);
    state.impl = impl;
 
    state.deref_var_nodes = _mesa_hash_table_create(state.dead_ctx,
@@ -942,7 +944,8 @@ nir_lower_vars_to_ssa_impl(nir_function_impl *impl)
    if (!progress)
       return false;
 
-   nir_metadata_require(impl, nir_metadata_dominance);
+   nir_metadata_require(impl, nir_metadata_dominance |
+                              nir_metadata_dom_frontier);
 
    /* We may have lowered some copy instructions to load/store
     * instructions.  The uses from the copy instructions hav already been
@@ -35,10 +35,18 @@ nir_metadata_require(nir_function_impl *impl, nir_metadata required)
 {
 #define NEEDS_UPDATE(X) ((required & ~impl->valid_metadata) & (X))
 
+   assert(!NEEDS_UPDATE(nir_metadata_no_progress_copy_prop |
+                        nir_metadata_no_progress_cse |
+                        nir_metadata_no_progress_dce |
+                        nir_metadata_no_progress_gcm |
+                        nir_metadata_no_progress_constant_folding));
+
    if (NEEDS_UPDATE(nir_metadata_block_index))
       nir_index_blocks(impl);
    if (NEEDS_UPDATE(nir_metadata_dominance))
       nir_calc_dominance_impl(impl);
+   if (NEEDS_UPDATE(nir_metadata_dom_frontier))
+      nir_calc_dom_frontier_impl(impl);
    if (NEEDS_UPDATE(nir_metadata_live_ssa_defs))
       nir_live_ssa_defs_impl(impl);
 
@@ -50,6 +58,10 @@ nir_metadata_require(nir_function_impl *impl, nir_metadata required)
 void
 nir_metadata_preserve(nir_function_impl *impl, nir_metadata preserved)
 {
+   /* Both depend on nothing but the CFG */
+   if (preserved & nir_metadata_dominance)
+      preserved |= nir_metadata_dom_frontier;
+
    impl->valid_metadata &= preserved;
 }
 
@@ -0,0 +1,197 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "nir.h"
+#include "nir_builder.h"
+
+/** @file nir_opt_combine_ubo_loads.c
+ *
+ * Merges load_ubo intrinsics in the same block that read from the same
+ * buffer at constant offsets into a single vector load, so that a shader
+ * reading a struct of scalars gets one message instead of one per member.
+ *
+ * Only loads that fall in the same 16-byte aligned line are merged.  The
+ * std140 rules never let a vector cross such a line, and backends fetch
+ * constant-offset UBO data a line at a time, so the merged load is one the
+ * backend can already handle.  It only covers the bytes between the first
+ * and the last of the loads it replaces, so it never reads past the end of
+ * what the shader was reading anyway.
+ */
+
+struct ubo_load {
+   nir_intrinsic_instr *intrin;
+   unsigned offset;
+   unsigned order;
+};
+
+static int
+compare_ubo_loads(const void *_a, const void *_b)
+{
+   const struct ubo_load *a = _a, *b = _b;
+   unsigned a_buffer = a->intrin->src[0].ssa->index;
+   unsigned b_buffer = b->intrin->src[0].ssa->index;
+
+   if (a_buffer != b_buffer)
+      return a_buffer < b_buffer ? -1 : 1;
+   if (a->offset / 16 != b->offset / 16)
+      return a->offset / 16 < b->offset / 16 ? -1 : 1;
+   return a->order < b->order ? -1 : a->order > b->order;
+}
+
+static bool
+same_line(const struct ubo_load *a, const struct ubo_load *b)
+{
+   return a->intrin->src[0].ssa == b->intrin->src[0].ssa &&
+          a->offset / 16 == b->offset / 16;
+}
+
+/* Replaces loads[0..count), sorted by order, with one load */
+static void
+combine_loads(nir_builder *b, struct ubo_load *loads, unsigned count)
+{
+   unsigned start = loads[0].offset, end = 0;
+   for (unsigned i = 0; i < count; i++) {
+      start = MIN2(start, loads[i].offset);
+      end = MAX2(end, loads[i].offset + loads[i].intrin->num_components * 4);
+   }
+
+   unsigned num_components = (end - start) / 4;
+   assert(num_components <= 4);
+
+   b->cursor = nir_before_instr(&loads[0].intrin->instr);
+
+   nir_intrinsic_instr *load =
+      nir_intrinsic_instr_create(b->shader, nir_intrinsic_load_ubo);
+   load->num_components = num_components;
+   load->src[0] = nir_src_for_ssa(loads[0].intrin->src[0].ssa);
+   load->src[1] = nir_src_for_ssa(nir_imm_int(b, start));
+   nir_ssa_dest_init(&load->instr, &load->dest, num_components, NULL);
+   nir_builder_instr_insert(b, &load->instr);
+
+   for (unsigned i = 0; i < count; i++) {
+      nir_intrinsic_instr *intrin = loads[i].intrin;
+      unsigned swiz[4];
+
+      for (unsigned c = 0; c < 4; c++)
+         swiz[c] = MIN2((loads[i].offset - start) / 4 + c, num_components - 1);
+
+      nir_ssa_def *value = nir_swizzle(b, &load->dest.ssa, swiz,
+                                       intrin->num_components, false);
+      nir_ssa_def_rewrite_uses(&intrin->dest.ssa, nir_src_for_ssa(value));
+      nir_instr_remove(&intrin->instr);
+   }
+}
+
+struct combine_state {
+   nir_builder builder;
+   bool progress;
+};
+
+static bool
+combine_ubo_loads_block(nir_block *block, void *void_state)
+{
+   struct combine_state *state = void_state;
+   unsigned num_loads = 0;
+
+   nir_foreach_instr(block, instr) {
+      if (instr->type == nir_instr_type_intrinsic &&
+          nir_instr_as_intrinsic(instr)->intrinsic == nir_intrinsic_load_ubo)
+         num_loads++;
+   }
+
+   if (num_loads < 2)
+      return true;
+
+   struct ubo_load *loads = ralloc_array(NULL, struct ubo_load, num_loads);
+   unsigned count = 0, order = 0;
+
+   nir_foreach_instr(block, instr) {
+      order++;
+
+      if (instr->type != nir_instr_type_intrinsic)
+         continue;
+
+      nir_intrinsic_instr *intrin = nir_instr_as_intrinsic(instr);
+      if (intrin->intrinsic != nir_intrinsic_load_ubo ||
+          !intrin->src[0].is_ssa || !intrin->dest.is_ssa)
+         continue;
+
+      nir_const_value *offset = nir_src_as_const_value(intrin->src[1]);
+      if (offset == NULL || offset->u[0] % 4 != 0 ||
+          offset->u[0] % 16 + intrin->num_components * 4 > 16)
+         continue;
+
+      loads[count].intrin = intrin;
+      loads[count].offset = offset->u[0];
+      loads[count].order = order;
+      count++;
+   }
+
+   qsort(loads, count, sizeof(*loads), compare_ubo_loads);
+
+   for (unsigned i = 0; i < count; ) {
+      unsigned j = i + 1;
+      while (j < count && same_line(&loads[i], &loads[j]))
+         j++;
+
+      if (j - i > 1) {
+         combine_loads(&state->builder, &loads[i], j - i);
+         state->progress = true;
+      }
+
+      i = j;
+   }
+
+   ralloc_free(loads);
+   return true;
+}
+
+static bool
+combine_ubo_loads_impl(nir_function_impl *impl)
+{
+   struct combine_state state;
+
+   nir_builder_init(&state.builder, impl);
+   state.progress = false;
+
+   nir_foreach_block(impl, combine_ubo_loads_block, &state);
+
+   if (state.progress)
+      nir_metadata_preserve(impl, nir_metadata_block_index |
+                                  nir_metadata_dominance);
+
+   return state.progress;
+}
+
+bool
+nir_opt_combine_ubo_loads(nir_shader *shader)
+{
+   bool progress = false;
+
+   nir_foreach_overload(shader, overload) {
+      if (overload->impl)
+         progress |= combine_ubo_loads_impl(overload->impl);
+   }
+
+   return progress;
+}
@@ -174,6 +174,9 @@ nir_opt_constant_folding_impl(nir_function_impl *impl)
 {
    struct constant_fold_state state;
 
+   if (impl->valid_metadata & nir_metadata_no_progress_constant_folding)
+      return false;
+
    state.mem_ctx = ralloc_parent(impl);
    state.impl = impl;
    state.progress = false;
@@ -183,6 +186,8 @@ nir_opt_constant_folding_impl(nir_function_impl *impl)
    if (state.progress)
       nir_metadata_preserve(impl, nir_metadata_block_index |
                                   nir_metadata_dominance);
+   else
+      impl->valid_metadata |= nir_metadata_no_progress_constant_folding;
 
    return state.progress;
 }
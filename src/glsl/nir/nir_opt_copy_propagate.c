@@ -26,6 +26,7 @@
  */
 
 #include "nir.h"
+#include "nir_worklist.h"
 #include <main/imports.h>
 
 /**
@@ -240,22 +241,45 @@ copy_prop_if(nir_if *if_stmt)
    return copy_prop_src(&if_stmt->condition, NULL, if_stmt);
 }
 
+/* Instead of looking at every source in the function, we only look at the
+ * instructions and ifs that use a move or vec, since those are the only ones
+ * copy propagation can change.  Following a source through a chain of moves
+ * is handled by copy_prop_src() and copy_prop_alu_src() themselves, so
+ * every user only has to be visited once.  An instruction using more than
+ * one copy is pushed once per copy, but revisiting it is cheap since its
+ * sources no longer point at moves.
+ */
+typedef struct {
+   nir_instr_worklist users;
+   struct set *if_users;
+} copy_prop_users;
+
+static bool
+is_copy(nir_instr *instr)
+{
+   if (instr->type != nir_instr_type_alu)
+      return false;
+
+   nir_alu_instr *alu = nir_instr_as_alu(instr);
+   return alu->dest.dest.is_ssa && (is_move(alu) || is_vec(alu));
+}
+
 static bool
-copy_prop_block(nir_block *block, void *_state)
+gather_users_block(nir_block *block, void *_state)
 {
-   bool *progress = (bool *) _state;
+   copy_prop_users *state = (copy_prop_users *) _state;
 
    nir_foreach_instr(block, instr) {
-      if (copy_prop_instr(instr))
-         *progress = true;
-   }
+      if (!is_copy(instr))
+         continue;
+
+      nir_ssa_def *def = &nir_instr_as_alu(instr)->dest.dest.ssa;
+
+      nir_foreach_use(def, use_src)
+         nir_instr_worklist_push_tail(&state->users, use_src->parent_instr);
 
-   if (block->cf_node.node.next != NULL && /* check that we aren't the end node */
-       !nir_cf_node_is_last(&block->cf_node) &&
-       nir_cf_node_next(&block->cf_node)->type == nir_cf_node_if) {
-      nir_if *if_stmt = nir_cf_node_as_if(nir_cf_node_next(&block->cf_node));
-      if (copy_prop_if(if_stmt))
-         *progress = true;
+      nir_foreach_if_use(def, use_src)
+         _mesa_set_add(state->if_users, use_src->parent_if);
    }
 
    return true;
@@ -266,11 +290,35 @@ nir_copy_prop_impl(nir_function_impl *impl)
 {
    bool progress = false;
 
-   nir_foreach_block(impl, copy_prop_block, &progress);
+   if (impl->valid_metadata & nir_metadata_no_progress_copy_prop)
+      return false;
+
+   copy_prop_users state;
+   nir_instr_worklist_init(&state.users, 0, NULL);
+   state.if_users = _mesa_set_create(NULL, _mesa_hash_pointer,
+                                     _mesa_key_pointer_equal);
+
+   nir_foreach_block(impl, gather_users_block, &state);
+
+   while (!nir_instr_worklist_is_empty(&state.users)) {
+      if (copy_prop_instr(nir_instr_worklist_pop_tail(&state.users)))
+         progress = true;
+   }
+
+   struct set_entry *entry;
+   set_foreach(state.if_users, entry) {
+      if (copy_prop_if((nir_if *) entry->key))
+         progress = true;
+   }
+
+   nir_instr_worklist_fini(&state.users);
+   _mesa_set_destroy(state.if_users, NULL);
 
    if (progress) {
       nir_metadata_preserve(impl, nir_metadata_block_index |
                                   nir_metadata_dominance);
+   } else {
+      impl->valid_metadata |= nir_metadata_no_progress_copy_prop;
    }
 
    return progress;
@@ -64,6 +64,9 @@ cse_block(nir_block *block, struct set *instr_set)
 static bool
 nir_opt_cse_impl(nir_function_impl *impl)
 {
+   if (impl->valid_metadata & nir_metadata_no_progress_cse)
+      return false;
+
    struct set *instr_set = nir_instr_set_create(NULL);
 
    nir_metadata_require(impl, nir_metadata_dominance);
@@ -73,6 +76,8 @@ nir_opt_cse_impl(nir_function_impl *impl)
    if (progress)
       nir_metadata_preserve(impl, nir_metadata_block_index |
                                   nir_metadata_dominance);
+   else
+      impl->valid_metadata |= nir_metadata_no_progress_cse;
 
    nir_instr_set_destroy(instr_set);
    return progress;
@@ -26,35 +26,21 @@
  */
 
 #include "nir.h"
+#include "nir_worklist.h"
 
 /* SSA-based mark-and-sweep dead code elimination */
 
-typedef struct {
-   struct exec_node node;
-   nir_instr *instr;
-} worklist_elem;
-
 static void
-worklist_push(struct exec_list *worklist, nir_instr *instr)
+worklist_push(nir_instr_worklist *worklist, nir_instr *instr)
 {
-   worklist_elem *elem = ralloc(worklist, worklist_elem);
-   elem->instr = instr;
    instr->pass_flags = 1;
-   exec_list_push_tail(worklist, &elem->node);
-}
-
-static nir_instr *
-worklist_pop(struct exec_list *worklist)
-{
-   struct exec_node *node = exec_list_pop_head(worklist);
-   worklist_elem *elem = exec_node_data(worklist_elem, node, node);
-   return elem->instr;
+   nir_instr_worklist_push_tail(worklist, instr);
 }
 
 static bool
 mark_live_cb(nir_src *src, void *_state)
 {
-   struct exec_list *worklist = (struct exec_list *) _state;
+   nir_instr_worklist *worklist = (nir_instr_worklist *) _state;
 
    if (src->is_ssa && !src->ssa->parent_instr->pass_flags) {
       worklist_push(worklist, src->ssa->parent_instr);
@@ -64,7 +50,7 @@ mark_live_cb(nir_src *src, void *_state)
 }
 
 static void
-init_instr(nir_instr *instr, struct exec_list *worklist)
+init_instr(nir_instr *instr, nir_instr_worklist *worklist)
 {
    nir_alu_instr *alu_instr;
    nir_intrinsic_instr *intrin_instr;
@@ -115,7 +101,7 @@ init_instr(nir_instr *instr, struct exec_list *worklist)
 static bool
 init_block_cb(nir_block *block, void *_state)
 {
-   struct exec_list *worklist = (struct exec_list *) _state;
+   nir_instr_worklist *worklist = (nir_instr_worklist *) _state;
 
    nir_foreach_instr(block, instr)
       init_instr(instr, worklist);
@@ -148,17 +134,24 @@ delete_block_cb(nir_block *block, void *_state)
 static bool
 nir_opt_dce_impl(nir_function_impl *impl)
 {
-   struct exec_list *worklist = ralloc(NULL, struct exec_list);
-   exec_list_make_empty(worklist);
+   if (impl->valid_metadata & nir_metadata_no_progress_dce)
+      return false;
+
+   /* The worklist is a plain array, so marking an instruction live doesn't
+    * cost an allocation.  impl->ssa_alloc is a good guess at how many
+    * instructions could be on it at once.
+    */
+   nir_instr_worklist worklist;
+   nir_instr_worklist_init(&worklist, impl->ssa_alloc, NULL);
 
-   nir_foreach_block(impl, init_block_cb, worklist);
+   nir_foreach_block(impl, init_block_cb, &worklist);
 
-   while (!exec_list_is_empty(worklist)) {
-      nir_instr *instr = worklist_pop(worklist);
-      nir_foreach_src(instr, mark_live_cb, worklist);
+   while (!nir_instr_worklist_is_empty(&worklist)) {
+      nir_instr *instr = nir_instr_worklist_pop_tail(&worklist);
+      nir_foreach_src(instr, mark_live_cb, &worklist);
    }
 
-   ralloc_free(worklist);
+   nir_instr_worklist_fini(&worklist);
 
    bool progress = false;
    nir_foreach_block(impl, delete_block_cb, &progress);
@@ -166,6 +159,8 @@ nir_opt_dce_impl(nir_function_impl *impl)
    if (progress)
       nir_metadata_preserve(impl, nir_metadata_block_index |
                                   nir_metadata_dominance);
+   else
+      impl->valid_metadata |= nir_metadata_no_progress_dce;
 
    return progress;
 }
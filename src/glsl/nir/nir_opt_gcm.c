@@ -26,6 +26,7 @@
  */
 
 #include "nir.h"
+#include "nir_instr_set.h"
 
 /*
  * Implements Global Code Motion.  A description of GCM can be found in
@@ -34,6 +35,12 @@
  * number of ways.  The algorithm used here differs substantially from the
  * one in the paper but it is, in my opinion, much easier to read and
  * verify correcness.
+ *
+ * If asked to, it also does the paper's global value numbering first: all
+ * the movable instructions go through a single instruction set, regardless
+ * of where they are, and duplicates are merged.  This is safe because the
+ * scheduling below then puts the surviving instruction in a block that
+ * dominates all of its uses.
  */
 
 struct gcm_block_info {
@@ -67,6 +74,9 @@ struct gcm_state {
    struct exec_list instrs;
 
    struct gcm_block_info *blocks;
+
+   /* Set if an instruction was merged or placed in a different block */
+   bool progress;
 };
 
 /* Recursively walks the CFG and builds the block_info structure */
@@ -185,6 +195,9 @@ gcm_pin_instructions_block(nir_block *block, void *void_state)
           */
          exec_node_remove(&instr->node);
          exec_list_push_tail(&state->instrs, &instr->node);
+
+         /* Remember where it was, so that placing it can tell if it moved */
+         instr->index = block->index;
       }
    }
 
@@ -324,15 +337,18 @@ gcm_schedule_late_def(nir_ssa_def *def, void *void_state)
    /* We know have the LCA of all of the uses.  If our invariants hold,
     * this is dominated by the block that we chose when scheduling early.
     * We now walk up the dominance tree and pick the lowest block that is
-    * as far outside loops as we can get.
+    * as far outside loops as we can get.  The early block itself is a
+    * candidate too: for a loop-invariant instruction, it is usually the
+    * one outside the loop.
     */
    nir_block *best = lca;
-   while (lca != def->parent_instr->block) {
-      assert(lca);
-      if (state->blocks[lca->index].loop_depth <
+   for (nir_block *block = lca; ; block = block->imm_dom) {
+      assert(block);
+      if (state->blocks[block->index].loop_depth <
           state->blocks[best->index].loop_depth)
-         best = lca;
-      lca = lca->imm_dom;
+         best = block;
+      if (block == def->parent_instr->block)
+         break;
    }
    def->parent_instr->block = best;
 
@@ -434,6 +450,9 @@ gcm_place_instr(nir_instr *instr, struct gcm_state *state)
 
    struct gcm_block_info *block_info = &state->blocks[instr->block->index];
    if (!(instr->pass_flags & GCM_INSTR_PINNED)) {
+      if (instr->block->index != instr->index)
+         state->progress = true;
+
       exec_node_remove(&instr->node);
 
       if (block_info->last_instr) {
@@ -453,22 +472,39 @@ gcm_place_instr(nir_instr *instr, struct gcm_state *state)
    block_info->last_instr = instr;
 }
 
-static void
-opt_gcm_impl(nir_function_impl *impl)
+static bool
+opt_gcm_impl(nir_function_impl *impl, bool value_number)
 {
    struct gcm_state state;
 
+   if (impl->valid_metadata & nir_metadata_no_progress_gcm)
+      return false;
+
    state.impl = impl;
    state.instr = NULL;
+   state.progress = false;
    exec_list_make_empty(&state.instrs);
-   state.blocks = rzalloc_array(NULL, struct gcm_block_info, impl->num_blocks);
 
+   /* impl->num_blocks is only valid once the blocks are indexed */
    nir_metadata_require(impl, nir_metadata_block_index |
                               nir_metadata_dominance);
 
+   state.blocks = rzalloc_array(NULL, struct gcm_block_info, impl->num_blocks);
+
    gcm_build_block_info(&impl->body, &state, 0);
    nir_foreach_block(impl, gcm_pin_instructions_block, &state);
 
+   if (value_number) {
+      struct set *gvn_set = nir_instr_set_create(NULL);
+      foreach_list_typed_safe(nir_instr, instr, node, &state.instrs) {
+         if (nir_instr_set_add_or_rewrite(gvn_set, instr)) {
+            nir_instr_remove(instr);
+            state.progress = true;
+         }
+      }
+      nir_instr_set_destroy(gvn_set);
+   }
+
    foreach_list_typed(nir_instr, instr, node, &state.instrs)
       gcm_schedule_early_instr(instr, &state);
 
@@ -482,13 +518,28 @@ opt_gcm_impl(nir_function_impl *impl)
    }
 
    ralloc_free(state.blocks);
+
+   /* Instructions may have been reordered within their blocks even if none
+    * moved to another one, so the other passes' results are invalid either
+    * way.
+    */
+   nir_metadata_preserve(impl, nir_metadata_block_index |
+                               nir_metadata_dominance);
+   if (!state.progress)
+      impl->valid_metadata |= nir_metadata_no_progress_gcm;
+
+   return state.progress;
 }
 
-void
-nir_opt_gcm(nir_shader *shader)
+bool
+nir_opt_gcm(nir_shader *shader, bool value_number)
 {
+   bool progress = false;
+
    nir_foreach_overload(shader, overload) {
       if (overload->impl)
-         opt_gcm_impl(overload->impl);
+         progress |= opt_gcm_impl(overload->impl, value_number);
    }
+
+   return progress;
 }
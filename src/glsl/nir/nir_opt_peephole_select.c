@@ -45,15 +45,23 @@
  * whose only use is one of the following phi nodes.  This happens all the
  * time when the SSA form comes from a conditional assignment with a
  * swizzle.
+ *
+ * If the caller passes a non-zero limit, up to that many other ALU
+ * instructions are allowed between the two sides of the if as well.  They
+ * get executed unconditionally after the transformation, so the limit is
+ * how many instructions the driver would rather execute than branch around.
+ * Backends that handle divergent branches poorly (or not at all) want a
+ * high limit; ones with cheap branches want it low.
  */
 
 struct peephole_select_state {
    void *mem_ctx;
+   unsigned limit;
    bool progress;
 };
 
 static bool
-block_check_for_allowed_instrs(nir_block *block)
+block_check_for_allowed_instrs(nir_block *block, unsigned *count, bool alu_ok)
 {
    nir_foreach_instr(block, instr) {
       switch (instr->type) {
@@ -84,6 +92,8 @@ block_check_for_allowed_instrs(nir_block *block)
 
       case nir_instr_type_alu: {
          nir_alu_instr *mov = nir_instr_as_alu(instr);
+         bool movelike = false;
+
          switch (mov->op) {
          case nir_op_fmov:
          case nir_op_imov:
@@ -94,10 +104,13 @@ block_check_for_allowed_instrs(nir_block *block)
          case nir_op_vec2:
          case nir_op_vec3:
          case nir_op_vec4:
-            /* It must be a move-like operation. */
+            movelike = true;
             break;
          default:
-            return false;
+            /* Anything else counts against the limit. */
+            if (!alu_ok)
+               return false;
+            break;
          }
 
          /* Can't handle saturate */
@@ -112,12 +125,20 @@ block_check_for_allowed_instrs(nir_block *block)
          if (!list_empty(&mov->dest.dest.ssa.if_uses))
             return false;
 
-         /* The only uses of this definition must be phi's in the successor */
+         /* The only uses of this definition must be phi's in the successor
+          * or, for anything but a move, other instructions in this block.
+          */
          nir_foreach_use(&mov->dest.dest.ssa, use) {
+            if (!movelike && use->parent_instr->block == block)
+               continue;
+
             if (use->parent_instr->type != nir_instr_type_phi ||
                 use->parent_instr->block != block->successors[0])
                return false;
          }
+
+         if (!movelike)
+            (*count)++;
          break;
       }
 
@@ -161,8 +182,12 @@ nir_opt_peephole_select_block(nir_block *block, void *void_state)
    nir_block *else_block = nir_cf_node_as_block(else_node);
 
    /* ... and those blocks must only contain "allowed" instructions. */
-   if (!block_check_for_allowed_instrs(then_block) ||
-       !block_check_for_allowed_instrs(else_block))
+   unsigned count = 0;
+   if (!block_check_for_allowed_instrs(then_block, &count, state->limit != 0) ||
+       !block_check_for_allowed_instrs(else_block, &count, state->limit != 0))
+      return true;
+
+   if (count > state->limit)
       return true;
 
    /* At this point, we know that the previous CFG node is an if-then
@@ -227,11 +252,12 @@ nir_opt_peephole_select_block(nir_block *block, void *void_state)
 }
 
 static bool
-nir_opt_peephole_select_impl(nir_function_impl *impl)
+nir_opt_peephole_select_impl(nir_function_impl *impl, unsigned limit)
 {
    struct peephole_select_state state;
 
    state.mem_ctx = ralloc_parent(impl);
+   state.limit = limit;
    state.progress = false;
 
    nir_foreach_block(impl, nir_opt_peephole_select_block, &state);
@@ -243,13 +269,13 @@ nir_opt_peephole_select_impl(nir_function_impl *impl)
 }
 
 bool
-nir_opt_peephole_select(nir_shader *shader)
+nir_opt_peephole_select(nir_shader *shader, unsigned limit)
 {
    bool progress = false;
 
    nir_foreach_overload(shader, overload) {
       if (overload->impl)
-         progress |= nir_opt_peephole_select_impl(overload->impl);
+         progress |= nir_opt_peephole_select_impl(overload->impl, limit);
    }
 
    return progress;
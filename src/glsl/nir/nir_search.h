@@ -92,6 +92,35 @@ NIR_DEFINE_CAST(nir_search_value_as_constant, nir_search_value,
 NIR_DEFINE_CAST(nir_search_value_as_expression, nir_search_value,
                 nir_search_expression, value)
 
+/* Keys returned by nir_search_src_key() for sources not produced by an ALU
+ * instruction.
+ */
+#define NIR_SEARCH_SRC_LOAD_CONST nir_num_opcodes
+#define NIR_SEARCH_SRC_OTHER (nir_num_opcodes + 1)
+
+/** Returns what a source of an ALU instruction is produced by
+ *
+ * This is the opcode of the ALU instruction producing it, or one of the
+ * NIR_SEARCH_SRC_* keys above.  The generated algebraic passes switch on
+ * it to pick the transforms worth trying on an instruction.
+ */
+static inline unsigned
+nir_search_src_key(const nir_alu_instr *instr, unsigned src)
+{
+   if (!instr->src[src].src.is_ssa)
+      return NIR_SEARCH_SRC_OTHER;
+
+   nir_instr *parent = instr->src[src].src.ssa->parent_instr;
+   switch (parent->type) {
+   case nir_instr_type_alu:
+      return nir_instr_as_alu(parent)->op;
+   case nir_instr_type_load_const:
+      return NIR_SEARCH_SRC_LOAD_CONST;
+   default:
+      return NIR_SEARCH_SRC_OTHER;
+   }
+}
+
 nir_alu_instr *
 nir_replace_instr(nir_alu_instr *instr, const nir_search_expression *search,
                   const nir_search_value *replace, void *mem_ctx);
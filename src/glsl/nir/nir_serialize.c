@@ -0,0 +1,1190 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "nir_serialize.h"
+#include "nir_control_flow_private.h"
+
+/*
+ * The shader is written out in the same order nir_shader_clone() walks it,
+ * and read back by creating the objects in that order.  Everything that is
+ * referenced from elsewhere in the shader (variables, registers, overloads,
+ * blocks and SSA values) is given an index as it is written, and references
+ * are written as that index.  Index 0 always stands for NULL.
+ *
+ * The only forward references in NIR are the sources of phi instructions,
+ * so the blocks and SSA values of a function_impl are numbered up front by
+ * the writer, in the order the reader is going to create them, and the
+ * reader fixes up phi sources once the whole function_impl has been read.
+ *
+ * glsl_types are numbered in a separate index space.  A type is only
+ * described the first time it is used, after that only its index is written.
+ */
+
+typedef struct {
+   struct blob *blob;
+
+   /* maps object ptr -> index */
+   struct hash_table *remap_table;
+
+   /* maps glsl_type ptr -> index */
+   struct hash_table *type_table;
+
+   /* the index the next object/type will get */
+   uintptr_t next_idx;
+   uintptr_t next_type_idx;
+} write_ctx;
+
+typedef struct {
+   struct blob_reader *blob;
+
+   /* new shader object, used as memctx for just about everything else: */
+   nir_shader *nir;
+
+   /* maps index -> object ptr, sized as recorded by the writer */
+   void **idx_table;
+   uint32_t idx_table_size;
+   uint32_t next_idx;
+
+   /* maps index -> glsl_type */
+   const struct glsl_type **type_table;
+   uint32_t type_table_size;
+   uint32_t next_type_idx;
+
+   /* List of phi sources that still hold indices instead of pointers. */
+   struct list_head phi_srcs;
+} read_ctx;
+
+static void
+write_add_object(write_ctx *ctx, const void *obj)
+{
+   _mesa_hash_table_insert(ctx->remap_table, obj, (void *) ctx->next_idx++);
+}
+
+static uint32_t
+write_lookup_object(write_ctx *ctx, const void *obj)
+{
+   struct hash_entry *entry;
+
+   if (!obj)
+      return 0;
+
+   entry = _mesa_hash_table_search(ctx->remap_table, obj);
+   assert(entry && "Failed to find pointer!");
+   if (!entry)
+      return 0;
+
+   return (uintptr_t) entry->data;
+}
+
+static void
+write_object(write_ctx *ctx, const void *obj)
+{
+   blob_write_uint32(ctx->blob, write_lookup_object(ctx, obj));
+}
+
+static void
+read_add_object(read_ctx *ctx, void *obj)
+{
+   assert(ctx->next_idx < ctx->idx_table_size);
+   if (ctx->next_idx < ctx->idx_table_size)
+      ctx->idx_table[ctx->next_idx] = obj;
+   ctx->next_idx++;
+}
+
+static void *
+read_lookup_object(read_ctx *ctx, uint32_t idx)
+{
+   assert(idx < ctx->next_idx && idx < ctx->idx_table_size);
+   if (idx >= ctx->next_idx || idx >= ctx->idx_table_size)
+      return NULL;
+
+   return ctx->idx_table[idx];
+}
+
+static void *
+read_object(read_ctx *ctx)
+{
+   return read_lookup_object(ctx, blob_read_uint32(ctx->blob));
+}
+
+static void
+write_type(write_ctx *ctx, const struct glsl_type *type)
+{
+   struct hash_entry *entry;
+
+   if (!type) {
+      blob_write_uint32(ctx->blob, 0);
+      return;
+   }
+
+   entry = _mesa_hash_table_search(ctx->type_table, type);
+   if (entry) {
+      blob_write_uint32(ctx->blob, (uintptr_t) entry->data);
+      return;
+   }
+
+   /* First use of this type: hand out the next index and describe it. */
+   blob_write_uint32(ctx->blob, ctx->next_type_idx);
+   _mesa_hash_table_insert(ctx->type_table, type,
+                           (void *) ctx->next_type_idx++);
+   encode_type_to_blob(ctx->blob, type);
+}
+
+static const struct glsl_type *
+read_type(read_ctx *ctx)
+{
+   uint32_t idx = blob_read_uint32(ctx->blob);
+
+   if (idx == 0)
+      return NULL;
+
+   if (idx == ctx->next_type_idx) {
+      const struct glsl_type *type = decode_type_from_blob(ctx->blob);
+
+      assert(idx < ctx->type_table_size);
+      if (idx < ctx->type_table_size)
+         ctx->type_table[idx] = type;
+      ctx->next_type_idx++;
+      return type;
+   }
+
+   assert(idx < ctx->next_type_idx && idx < ctx->type_table_size);
+   if (idx >= ctx->next_type_idx || idx >= ctx->type_table_size)
+      return NULL;
+
+   return ctx->type_table[idx];
+}
+
+/* Names are only there for debugging and may be NULL. */
+static void
+write_name(write_ctx *ctx, const char *name)
+{
+   blob_write_uint32(ctx->blob, name != NULL);
+   if (name)
+      blob_write_string(ctx->blob, name);
+}
+
+static char *
+read_name(read_ctx *ctx, void *mem_ctx)
+{
+   if (!blob_read_uint32(ctx->blob))
+      return NULL;
+
+   return ralloc_strdup(mem_ctx, blob_read_string(ctx->blob));
+}
+
+static void
+write_constant(write_ctx *ctx, const nir_constant *c)
+{
+   blob_write_bytes(ctx->blob, &c->value, sizeof(c->value));
+   blob_write_uint32(ctx->blob, c->num_elements);
+   for (unsigned i = 0; i < c->num_elements; i++)
+      write_constant(ctx, c->elements[i]);
+}
+
+static nir_constant *
+read_constant(read_ctx *ctx, nir_variable *nvar)
+{
+   nir_constant *c = ralloc(nvar, nir_constant);
+
+   blob_copy_bytes(ctx->blob, (uint8_t *) &c->value, sizeof(c->value));
+   c->num_elements = blob_read_uint32(ctx->blob);
+   c->elements = ralloc_array(nvar, nir_constant *, c->num_elements);
+   for (unsigned i = 0; i < c->num_elements; i++)
+      c->elements[i] = read_constant(ctx, nvar);
+
+   return c;
+}
+
+static void
+write_variable(write_ctx *ctx, const nir_variable *var)
+{
+   write_add_object(ctx, var);
+   write_type(ctx, var->type);
+   write_name(ctx, var->name);
+   blob_write_bytes(ctx->blob, &var->data, sizeof(var->data));
+   blob_write_uint32(ctx->blob, var->num_state_slots);
+   if (var->num_state_slots) {
+      blob_write_bytes(ctx->blob, var->state_slots,
+                       var->num_state_slots * sizeof(nir_state_slot));
+   }
+   blob_write_uint32(ctx->blob, var->constant_initializer != NULL);
+   if (var->constant_initializer)
+      write_constant(ctx, var->constant_initializer);
+   write_type(ctx, var->interface_type);
+}
+
+/* NOTE: like nir_shader_clone(), bypass nir_variable_create to avoid
+ * having to deal with locals and globals separately:
+ */
+static nir_variable *
+read_variable(read_ctx *ctx)
+{
+   nir_variable *var = rzalloc(ctx->nir, nir_variable);
+   read_add_object(ctx, var);
+
+   var->type = read_type(ctx);
+   var->name = read_name(ctx, var);
+   blob_copy_bytes(ctx->blob, (uint8_t *) &var->data, sizeof(var->data));
+   var->num_state_slots = blob_read_uint32(ctx->blob);
+   var->state_slots = ralloc_array(var, nir_state_slot, var->num_state_slots);
+   if (var->num_state_slots) {
+      blob_copy_bytes(ctx->blob, (uint8_t *) var->state_slots,
+                      var->num_state_slots * sizeof(nir_state_slot));
+   }
+   if (blob_read_uint32(ctx->blob))
+      var->constant_initializer = read_constant(ctx, var);
+   var->interface_type = read_type(ctx);
+
+   return var;
+}
+
+static void
+write_var_list(write_ctx *ctx, const struct exec_list *list)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(list));
+   foreach_list_typed(nir_variable, var, node, list)
+      write_variable(ctx, var);
+}
+
+static void
+read_var_list(read_ctx *ctx, struct exec_list *dst)
+{
+   exec_list_make_empty(dst);
+   unsigned num_vars = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_vars; i++) {
+      nir_variable *var = read_variable(ctx);
+      exec_list_push_tail(dst, &var->node);
+   }
+}
+
+static void
+write_register(write_ctx *ctx, const nir_register *reg)
+{
+   write_add_object(ctx, reg);
+   blob_write_uint32(ctx->blob, reg->num_components);
+   blob_write_uint32(ctx->blob, reg->num_array_elems);
+   blob_write_uint32(ctx->blob, reg->index);
+   write_name(ctx, reg->name);
+   blob_write_uint32(ctx->blob, reg->is_global | reg->is_packed << 1);
+}
+
+static nir_register *
+read_register(read_ctx *ctx)
+{
+   nir_register *reg = rzalloc(ctx->nir, nir_register);
+   read_add_object(ctx, reg);
+
+   reg->num_components = blob_read_uint32(ctx->blob);
+   reg->num_array_elems = blob_read_uint32(ctx->blob);
+   reg->index = blob_read_uint32(ctx->blob);
+   reg->name = read_name(ctx, reg);
+   unsigned flags = blob_read_uint32(ctx->blob);
+   reg->is_global = flags & 0x1;
+   reg->is_packed = (flags >> 1) & 0x1;
+
+   /* reconstructing uses/defs/if_uses handled by nir_instr_insert() */
+   list_inithead(&reg->uses);
+   list_inithead(&reg->defs);
+   list_inithead(&reg->if_uses);
+
+   return reg;
+}
+
+static void
+write_reg_list(write_ctx *ctx, const struct exec_list *list)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(list));
+   foreach_list_typed(nir_register, reg, node, list)
+      write_register(ctx, reg);
+}
+
+static void
+read_reg_list(read_ctx *ctx, struct exec_list *dst)
+{
+   exec_list_make_empty(dst);
+   unsigned num_regs = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_regs; i++) {
+      nir_register *reg = read_register(ctx);
+      exec_list_push_tail(dst, &reg->node);
+   }
+}
+
+/* Sources and register destinations are a single word holding the index of
+ * the SSA value or register, whether it is SSA in bit 0 and whether an
+ * indirect source follows in bit 1.
+ */
+static void
+write_src(write_ctx *ctx, const nir_src *src)
+{
+   if (src->is_ssa) {
+      blob_write_uint32(ctx->blob, write_lookup_object(ctx, src->ssa) << 2 |
+                                   0x1);
+   } else {
+      blob_write_uint32(ctx->blob, write_lookup_object(ctx, src->reg.reg) << 2 |
+                                   (src->reg.indirect != NULL) << 1);
+      blob_write_uint32(ctx->blob, src->reg.base_offset);
+      if (src->reg.indirect)
+         write_src(ctx, src->reg.indirect);
+   }
+}
+
+static void
+read_src(read_ctx *ctx, void *ninstr_or_if, nir_src *src)
+{
+   uint32_t val = blob_read_uint32(ctx->blob);
+
+   src->is_ssa = val & 0x1;
+   if (src->is_ssa) {
+      src->ssa = read_lookup_object(ctx, val >> 2);
+   } else {
+      src->reg.reg = read_lookup_object(ctx, val >> 2);
+      src->reg.base_offset = blob_read_uint32(ctx->blob);
+      if (val & 0x2) {
+         src->reg.indirect = ralloc(ninstr_or_if, nir_src);
+         read_src(ctx, ninstr_or_if, src->reg.indirect);
+      } else {
+         src->reg.indirect = NULL;
+      }
+   }
+}
+
+/* SSA destinations are numbered by index_function_impl(), so only their
+ * size and name are written.
+ */
+static void
+write_dest(write_ctx *ctx, const nir_dest *dst)
+{
+   if (dst->is_ssa) {
+      blob_write_uint32(ctx->blob, dst->ssa.num_components << 2 | 0x1);
+      write_name(ctx, dst->ssa.name);
+   } else {
+      blob_write_uint32(ctx->blob, write_lookup_object(ctx, dst->reg.reg) << 2 |
+                                   (dst->reg.indirect != NULL) << 1);
+      blob_write_uint32(ctx->blob, dst->reg.base_offset);
+      if (dst->reg.indirect)
+         write_src(ctx, dst->reg.indirect);
+   }
+}
+
+static void
+read_dest(read_ctx *ctx, nir_instr *ninstr, nir_dest *dst)
+{
+   uint32_t val = blob_read_uint32(ctx->blob);
+
+   if (val & 0x1) {
+      char *name = read_name(ctx, ninstr);
+      nir_ssa_dest_init(ninstr, dst, val >> 2, name);
+      read_add_object(ctx, &dst->ssa);
+   } else {
+      dst->is_ssa = false;
+      dst->reg.reg = read_lookup_object(ctx, val >> 2);
+      dst->reg.base_offset = blob_read_uint32(ctx->blob);
+      if (val & 0x2) {
+         dst->reg.indirect = ralloc(ninstr, nir_src);
+         read_src(ctx, ninstr, dst->reg.indirect);
+      } else {
+         dst->reg.indirect = NULL;
+      }
+   }
+}
+
+static void
+write_deref_chain(write_ctx *ctx, const nir_deref_var *dvar)
+{
+   unsigned length = 0;
+   for (const nir_deref *d = dvar->deref.child; d; d = d->child)
+      length++;
+
+   write_object(ctx, dvar->var);
+   blob_write_uint32(ctx->blob, length);
+
+   for (const nir_deref *d = dvar->deref.child; d; d = d->child) {
+      blob_write_uint32(ctx->blob, d->deref_type);
+      write_type(ctx, d->type);
+
+      switch (d->deref_type) {
+      case nir_deref_type_array: {
+         const nir_deref_array *darr = nir_deref_as_array(d);
+         blob_write_uint32(ctx->blob, darr->deref_array_type);
+         blob_write_uint32(ctx->blob, darr->base_offset);
+         if (darr->deref_array_type == nir_deref_array_type_indirect)
+            write_src(ctx, &darr->indirect);
+         break;
+      }
+      case nir_deref_type_struct:
+         blob_write_uint32(ctx->blob, nir_deref_as_struct(d)->index);
+         break;
+      default:
+         unreachable("bad deref type");
+      }
+   }
+}
+
+static nir_deref_var *
+read_deref_chain(read_ctx *ctx, nir_instr *ninstr)
+{
+   nir_variable *var = read_object(ctx);
+   nir_deref_var *dvar = nir_deref_var_create(ninstr, var);
+   unsigned length = blob_read_uint32(ctx->blob);
+
+   nir_deref *tail = &dvar->deref;
+   for (unsigned i = 0; i < length; i++) {
+      nir_deref_type deref_type = blob_read_uint32(ctx->blob);
+      const struct glsl_type *type = read_type(ctx);
+
+      switch (deref_type) {
+      case nir_deref_type_array: {
+         nir_deref_array *darr = nir_deref_array_create(tail);
+         darr->deref_array_type = blob_read_uint32(ctx->blob);
+         darr->base_offset = blob_read_uint32(ctx->blob);
+         if (darr->deref_array_type == nir_deref_array_type_indirect)
+            read_src(ctx, ninstr, &darr->indirect);
+         tail->child = &darr->deref;
+         break;
+      }
+      case nir_deref_type_struct: {
+         unsigned index = blob_read_uint32(ctx->blob);
+         tail->child = &nir_deref_struct_create(tail, index)->deref;
+         break;
+      }
+      default:
+         unreachable("bad deref type");
+      }
+
+      tail = tail->child;
+      tail->type = type;
+   }
+
+   return dvar;
+}
+
+static void
+write_alu(write_ctx *ctx, const nir_alu_instr *alu)
+{
+   blob_write_uint32(ctx->blob, alu->op);
+   blob_write_uint32(ctx->blob, alu->dest.saturate |
+                                alu->dest.write_mask << 1);
+   write_dest(ctx, &alu->dest.dest);
+
+   for (unsigned i = 0; i < nir_op_infos[alu->op].num_inputs; i++) {
+      const nir_alu_src *src = &alu->src[i];
+
+      write_src(ctx, &src->src);
+      blob_write_uint32(ctx->blob, src->negate |
+                                   src->abs << 1 |
+                                   src->swizzle[0] << 2 |
+                                   src->swizzle[1] << 4 |
+                                   src->swizzle[2] << 6 |
+                                   src->swizzle[3] << 8);
+   }
+}
+
+static nir_alu_instr *
+read_alu(read_ctx *ctx)
+{
+   nir_op op = blob_read_uint32(ctx->blob);
+   nir_alu_instr *alu = nir_alu_instr_create(ctx->nir, op);
+
+   unsigned dest_flags = blob_read_uint32(ctx->blob);
+   alu->dest.saturate = dest_flags & 0x1;
+   alu->dest.write_mask = dest_flags >> 1;
+   read_dest(ctx, &alu->instr, &alu->dest.dest);
+
+   for (unsigned i = 0; i < nir_op_infos[op].num_inputs; i++) {
+      nir_alu_src *src = &alu->src[i];
+
+      read_src(ctx, &alu->instr, &src->src);
+      unsigned flags = blob_read_uint32(ctx->blob);
+      src->negate = flags & 0x1;
+      src->abs = (flags >> 1) & 0x1;
+      for (unsigned c = 0; c < 4; c++)
+         src->swizzle[c] = (flags >> (2 + 2 * c)) & 0x3;
+   }
+
+   return alu;
+}
+
+static void
+write_intrinsic(write_ctx *ctx, const nir_intrinsic_instr *intrin)
+{
+   const nir_intrinsic_info *info = &nir_intrinsic_infos[intrin->intrinsic];
+
+   blob_write_uint32(ctx->blob, intrin->intrinsic);
+   blob_write_uint32(ctx->blob, intrin->num_components);
+   for (unsigned i = 0; i < ARRAY_SIZE(intrin->const_index); i++)
+      blob_write_uint32(ctx->blob, intrin->const_index[i]);
+
+   if (info->has_dest)
+      write_dest(ctx, &intrin->dest);
+
+   for (unsigned i = 0; i < info->num_variables; i++)
+      write_deref_chain(ctx, intrin->variables[i]);
+
+   for (unsigned i = 0; i < info->num_srcs; i++)
+      write_src(ctx, &intrin->src[i]);
+}
+
+static nir_intrinsic_instr *
+read_intrinsic(read_ctx *ctx)
+{
+   nir_intrinsic_op op = blob_read_uint32(ctx->blob);
+   const nir_intrinsic_info *info = &nir_intrinsic_infos[op];
+   nir_intrinsic_instr *intrin = nir_intrinsic_instr_create(ctx->nir, op);
+
+   intrin->num_components = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < ARRAY_SIZE(intrin->const_index); i++)
+      intrin->const_index[i] = blob_read_uint32(ctx->blob);
+
+   if (info->has_dest)
+      read_dest(ctx, &intrin->instr, &intrin->dest);
+
+   for (unsigned i = 0; i < info->num_variables; i++)
+      intrin->variables[i] = read_deref_chain(ctx, &intrin->instr);
+
+   for (unsigned i = 0; i < info->num_srcs; i++)
+      read_src(ctx, &intrin->instr, &intrin->src[i]);
+
+   return intrin;
+}
+
+static void
+write_load_const(write_ctx *ctx, const nir_load_const_instr *lc)
+{
+   blob_write_uint32(ctx->blob, lc->def.num_components);
+   blob_write_bytes(ctx->blob, &lc->value, sizeof(lc->value));
+}
+
+static nir_load_const_instr *
+read_load_const(read_ctx *ctx)
+{
+   unsigned num_components = blob_read_uint32(ctx->blob);
+   nir_load_const_instr *lc =
+      nir_load_const_instr_create(ctx->nir, num_components);
+
+   blob_copy_bytes(ctx->blob, (uint8_t *) &lc->value, sizeof(lc->value));
+   read_add_object(ctx, &lc->def);
+
+   return lc;
+}
+
+static void
+write_ssa_undef(write_ctx *ctx, const nir_ssa_undef_instr *undef)
+{
+   blob_write_uint32(ctx->blob, undef->def.num_components);
+}
+
+static nir_ssa_undef_instr *
+read_ssa_undef(read_ctx *ctx)
+{
+   unsigned num_components = blob_read_uint32(ctx->blob);
+   nir_ssa_undef_instr *undef =
+      nir_ssa_undef_instr_create(ctx->nir, num_components);
+
+   read_add_object(ctx, &undef->def);
+
+   return undef;
+}
+
+static void
+write_tex(write_ctx *ctx, const nir_tex_instr *tex)
+{
+   blob_write_uint32(ctx->blob, tex->num_srcs);
+   blob_write_uint32(ctx->blob, tex->sampler_dim);
+   blob_write_uint32(ctx->blob, tex->dest_type);
+   blob_write_uint32(ctx->blob, tex->op);
+   blob_write_uint32(ctx->blob, tex->coord_components);
+   blob_write_uint32(ctx->blob, tex->is_array |
+                                tex->is_shadow << 1 |
+                                tex->is_new_style_shadow << 2 |
+                                tex->component << 3);
+   for (unsigned i = 0; i < ARRAY_SIZE(tex->const_offset); i++)
+      blob_write_uint32(ctx->blob, tex->const_offset[i]);
+   blob_write_uint32(ctx->blob, tex->sampler_index);
+   blob_write_uint32(ctx->blob, tex->sampler_array_size);
+
+   write_dest(ctx, &tex->dest);
+   for (unsigned i = 0; i < tex->num_srcs; i++) {
+      blob_write_uint32(ctx->blob, tex->src[i].src_type);
+      write_src(ctx, &tex->src[i].src);
+   }
+
+   blob_write_uint32(ctx->blob, tex->sampler != NULL);
+   if (tex->sampler)
+      write_deref_chain(ctx, tex->sampler);
+}
+
+static nir_tex_instr *
+read_tex(read_ctx *ctx)
+{
+   unsigned num_srcs = blob_read_uint32(ctx->blob);
+   nir_tex_instr *tex = nir_tex_instr_create(ctx->nir, num_srcs);
+
+   tex->sampler_dim = blob_read_uint32(ctx->blob);
+   tex->dest_type = blob_read_uint32(ctx->blob);
+   tex->op = blob_read_uint32(ctx->blob);
+   tex->coord_components = blob_read_uint32(ctx->blob);
+   unsigned flags = blob_read_uint32(ctx->blob);
+   tex->is_array = flags & 0x1;
+   tex->is_shadow = (flags >> 1) & 0x1;
+   tex->is_new_style_shadow = (flags >> 2) & 0x1;
+   tex->component = (flags >> 3) & 0x3;
+   for (unsigned i = 0; i < ARRAY_SIZE(tex->const_offset); i++)
+      tex->const_offset[i] = blob_read_uint32(ctx->blob);
+   tex->sampler_index = blob_read_uint32(ctx->blob);
+   tex->sampler_array_size = blob_read_uint32(ctx->blob);
+
+   read_dest(ctx, &tex->instr, &tex->dest);
+   for (unsigned i = 0; i < num_srcs; i++) {
+      tex->src[i].src_type = blob_read_uint32(ctx->blob);
+      read_src(ctx, &tex->instr, &tex->src[i].src);
+   }
+
+   if (blob_read_uint32(ctx->blob))
+      tex->sampler = read_deref_chain(ctx, &tex->instr);
+
+   return tex;
+}
+
+static void
+write_phi(write_ctx *ctx, const nir_phi_instr *phi)
+{
+   write_dest(ctx, &phi->dest);
+
+   blob_write_uint32(ctx->blob, exec_list_length(&phi->srcs));
+   nir_foreach_phi_src(phi, src) {
+      assert(src->src.is_ssa);
+      write_object(ctx, src->pred);
+      write_object(ctx, src->src.ssa);
+   }
+}
+
+/* The predecessor block and the SSA value of a phi source may come later in
+ * the shader (loops), so like nir_shader_clone(), the phi is added to the
+ * block before its sources are set up, and the sources are fixed up by
+ * read_function_impl() once every block and instruction is in place.
+ */
+static void
+read_phi(read_ctx *ctx, nir_block *blk)
+{
+   nir_phi_instr *phi = nir_phi_instr_create(ctx->nir);
+
+   read_dest(ctx, &phi->instr, &phi->dest);
+
+   nir_instr_insert_after_block(blk, &phi->instr);
+
+   unsigned num_srcs = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_srcs; i++) {
+      nir_phi_src *src = ralloc(phi, nir_phi_src);
+
+      /* Stash the indices in the pointers until the fixup. */
+      src->pred = (nir_block *) (uintptr_t) blob_read_uint32(ctx->blob);
+      src->src = NIR_SRC_INIT;
+      src->src.is_ssa = true;
+      src->src.ssa = (nir_ssa_def *) (uintptr_t) blob_read_uint32(ctx->blob);
+      src->src.parent_instr = &phi->instr;
+
+      list_add(&src->src.use_link, &ctx->phi_srcs);
+
+      exec_list_push_tail(&phi->srcs, &src->node);
+   }
+}
+
+static void
+write_jump(write_ctx *ctx, const nir_jump_instr *jmp)
+{
+   blob_write_uint32(ctx->blob, jmp->type);
+}
+
+static nir_jump_instr *
+read_jump(read_ctx *ctx)
+{
+   nir_jump_type type = blob_read_uint32(ctx->blob);
+   return nir_jump_instr_create(ctx->nir, type);
+}
+
+static void
+write_call(write_ctx *ctx, const nir_call_instr *call)
+{
+   write_object(ctx, call->callee);
+
+   for (unsigned i = 0; i < call->num_params; i++)
+      write_deref_chain(ctx, call->params[i]);
+
+   blob_write_uint32(ctx->blob, call->return_deref != NULL);
+   if (call->return_deref)
+      write_deref_chain(ctx, call->return_deref);
+}
+
+static nir_call_instr *
+read_call(read_ctx *ctx)
+{
+   nir_function_overload *callee = read_object(ctx);
+   nir_call_instr *call = nir_call_instr_create(ctx->nir, callee);
+
+   for (unsigned i = 0; i < call->num_params; i++)
+      call->params[i] = read_deref_chain(ctx, &call->instr);
+
+   if (blob_read_uint32(ctx->blob))
+      call->return_deref = read_deref_chain(ctx, &call->instr);
+
+   return call;
+}
+
+static void
+write_instr(write_ctx *ctx, const nir_instr *instr)
+{
+   blob_write_uint32(ctx->blob, instr->type);
+
+   switch (instr->type) {
+   case nir_instr_type_alu:
+      write_alu(ctx, nir_instr_as_alu(instr));
+      break;
+   case nir_instr_type_intrinsic:
+      write_intrinsic(ctx, nir_instr_as_intrinsic(instr));
+      break;
+   case nir_instr_type_load_const:
+      write_load_const(ctx, nir_instr_as_load_const(instr));
+      break;
+   case nir_instr_type_ssa_undef:
+      write_ssa_undef(ctx, nir_instr_as_ssa_undef(instr));
+      break;
+   case nir_instr_type_tex:
+      write_tex(ctx, nir_instr_as_tex(instr));
+      break;
+   case nir_instr_type_phi:
+      write_phi(ctx, nir_instr_as_phi(instr));
+      break;
+   case nir_instr_type_jump:
+      write_jump(ctx, nir_instr_as_jump(instr));
+      break;
+   case nir_instr_type_call:
+      write_call(ctx, nir_instr_as_call(instr));
+      break;
+   case nir_instr_type_parallel_copy:
+      unreachable("Cannot serialize parallel copies");
+   default:
+      unreachable("bad instr type");
+   }
+}
+
+static void
+read_instr(read_ctx *ctx, nir_block *blk)
+{
+   nir_instr_type type = blob_read_uint32(ctx->blob);
+   nir_instr *instr;
+
+   switch (type) {
+   case nir_instr_type_alu:
+      instr = &read_alu(ctx)->instr;
+      break;
+   case nir_instr_type_intrinsic:
+      instr = &read_intrinsic(ctx)->instr;
+      break;
+   case nir_instr_type_load_const:
+      instr = &read_load_const(ctx)->instr;
+      break;
+   case nir_instr_type_ssa_undef:
+      instr = &read_ssa_undef(ctx)->instr;
+      break;
+   case nir_instr_type_tex:
+      instr = &read_tex(ctx)->instr;
+      break;
+   case nir_instr_type_phi:
+      /* Phi instructions insert themselves, see read_phi(). */
+      read_phi(ctx, blk);
+      return;
+   case nir_instr_type_jump:
+      instr = &read_jump(ctx)->instr;
+      break;
+   case nir_instr_type_call:
+      instr = &read_call(ctx)->instr;
+      break;
+   case nir_instr_type_parallel_copy:
+      unreachable("Cannot deserialize parallel copies");
+   default:
+      unreachable("bad instr type");
+   }
+
+   nir_instr_insert_after_block(blk, instr);
+}
+
+static void
+write_block(write_ctx *ctx, const nir_block *block)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(&block->instr_list));
+   nir_foreach_instr(block, instr)
+      write_instr(ctx, instr);
+}
+
+static void
+read_block(read_ctx *ctx, struct exec_list *cf_list)
+{
+   /* Don't actually create a new block.  Just use the one from the tail of
+    * the list.  NIR guarantees that the tail of the list is a block and that
+    * no two blocks are side-by-side in the IR;  It should be empty.
+    */
+   nir_block *blk =
+      exec_node_data(nir_block, exec_list_get_tail(cf_list), cf_node.node);
+   assert(blk->cf_node.type == nir_cf_node_block);
+   assert(exec_list_is_empty(&blk->instr_list));
+
+   read_add_object(ctx, blk);
+
+   unsigned num_instrs = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_instrs; i++)
+      read_instr(ctx, blk);
+}
+
+static void write_cf_list(write_ctx *ctx, const struct exec_list *cf_list);
+static void read_cf_list(read_ctx *ctx, struct exec_list *cf_list);
+
+static void
+write_if(write_ctx *ctx, const nir_if *nif)
+{
+   write_src(ctx, &nif->condition);
+   write_cf_list(ctx, &nif->then_list);
+   write_cf_list(ctx, &nif->else_list);
+}
+
+static void
+read_if(read_ctx *ctx, struct exec_list *cf_list)
+{
+   nir_if *nif = nir_if_create(ctx->nir);
+
+   read_src(ctx, nif, &nif->condition);
+
+   nir_cf_node_insert_end(cf_list, &nif->cf_node);
+
+   read_cf_list(ctx, &nif->then_list);
+   read_cf_list(ctx, &nif->else_list);
+}
+
+static void
+write_loop(write_ctx *ctx, const nir_loop *loop)
+{
+   write_cf_list(ctx, &loop->body);
+}
+
+static void
+read_loop(read_ctx *ctx, struct exec_list *cf_list)
+{
+   nir_loop *loop = nir_loop_create(ctx->nir);
+
+   nir_cf_node_insert_end(cf_list, &loop->cf_node);
+
+   read_cf_list(ctx, &loop->body);
+}
+
+static void
+write_cf_list(write_ctx *ctx, const struct exec_list *cf_list)
+{
+   blob_write_uint32(ctx->blob, exec_list_length(cf_list));
+   foreach_list_typed(nir_cf_node, cf, node, cf_list) {
+      blob_write_uint32(ctx->blob, cf->type);
+
+      switch (cf->type) {
+      case nir_cf_node_block:
+         write_block(ctx, nir_cf_node_as_block(cf));
+         break;
+      case nir_cf_node_if:
+         write_if(ctx, nir_cf_node_as_if(cf));
+         break;
+      case nir_cf_node_loop:
+         write_loop(ctx, nir_cf_node_as_loop(cf));
+         break;
+      default:
+         unreachable("bad cf type");
+      }
+   }
+}
+
+static void
+read_cf_list(read_ctx *ctx, struct exec_list *cf_list)
+{
+   unsigned num_cf_nodes = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_cf_nodes; i++) {
+      nir_cf_node_type type = blob_read_uint32(ctx->blob);
+
+      switch (type) {
+      case nir_cf_node_block:
+         read_block(ctx, cf_list);
+         break;
+      case nir_cf_node_if:
+         read_if(ctx, cf_list);
+         break;
+      case nir_cf_node_loop:
+         read_loop(ctx, cf_list);
+         break;
+      default:
+         unreachable("bad cf type");
+      }
+   }
+}
+
+static bool
+index_ssa_def_cb(nir_ssa_def *def, void *state)
+{
+   write_add_object(state, def);
+   return true;
+}
+
+static bool
+index_block_cb(nir_block *block, void *state)
+{
+   /* The end block never has any instructions and is created along with
+    * the function_impl, so read_block() never sees it.
+    */
+   if (block == nir_cf_node_get_function(&block->cf_node)->end_block)
+      return true;
+
+   write_add_object(state, block);
+   nir_foreach_instr(block, instr)
+      nir_foreach_ssa_def(instr, index_ssa_def_cb, state);
+
+   return true;
+}
+
+static void
+write_function_impl(write_ctx *ctx, const nir_function_impl *fi)
+{
+   write_var_list(ctx, &fi->locals);
+   write_reg_list(ctx, &fi->registers);
+   blob_write_uint32(ctx->blob, fi->reg_alloc);
+
+   blob_write_uint32(ctx->blob, fi->num_params);
+   for (unsigned i = 0; i < fi->num_params; i++)
+      write_object(ctx, fi->params[i]);
+   write_object(ctx, fi->return_var);
+
+   /* Number the blocks and SSA values in the order read_function_impl()
+    * is going to create them, so that phi sources can refer to them before
+    * they have been written.
+    */
+   nir_foreach_block((nir_function_impl *) fi, index_block_cb, ctx);
+
+   write_cf_list(ctx, &fi->body);
+}
+
+static void
+read_function_impl(read_ctx *ctx, nir_function_overload *fo)
+{
+   nir_function_impl *fi = nir_function_impl_create(fo);
+
+   read_var_list(ctx, &fi->locals);
+   read_reg_list(ctx, &fi->registers);
+   fi->reg_alloc = blob_read_uint32(ctx->blob);
+
+   fi->num_params = blob_read_uint32(ctx->blob);
+   fi->params = ralloc_array(ctx->nir, nir_variable *, fi->num_params);
+   for (unsigned i = 0; i < fi->num_params; i++)
+      fi->params[i] = read_object(ctx);
+   fi->return_var = read_object(ctx);
+
+   assert(list_empty(&ctx->phi_srcs));
+
+   read_cf_list(ctx, &fi->body);
+
+   list_for_each_entry_safe(nir_phi_src, src, &ctx->phi_srcs, src.use_link) {
+      src->pred = read_lookup_object(ctx, (uintptr_t) src->pred);
+      src->src.ssa = read_lookup_object(ctx, (uintptr_t) src->src.ssa);
+
+      /* Remove from this list and place in the uses of the SSA def */
+      list_del(&src->src.use_link);
+      list_addtail(&src->src.use_link, &src->src.ssa->uses);
+   }
+   assert(list_empty(&ctx->phi_srcs));
+
+   fi->valid_metadata = nir_metadata_none;
+}
+
+static void
+write_function(write_ctx *ctx, const nir_function *fxn)
+{
+   blob_write_string(ctx->blob, fxn->name);
+   blob_write_uint32(ctx->blob, exec_list_length(&fxn->overload_list));
+
+   foreach_list_typed(nir_function_overload, fo, node, &fxn->overload_list) {
+      /* Needed for call instructions */
+      write_add_object(ctx, fo);
+
+      blob_write_uint32(ctx->blob, fo->num_params);
+      for (unsigned i = 0; i < fo->num_params; i++) {
+         blob_write_uint32(ctx->blob, fo->params[i].param_type);
+         write_type(ctx, fo->params[i].type);
+      }
+      write_type(ctx, fo->return_type);
+   }
+}
+
+static void
+read_function(read_ctx *ctx)
+{
+   nir_function *fxn = nir_function_create(ctx->nir,
+                                           blob_read_string(ctx->blob));
+
+   unsigned num_overloads = blob_read_uint32(ctx->blob);
+   for (unsigned i = 0; i < num_overloads; i++) {
+      nir_function_overload *fo = nir_function_overload_create(fxn);
+      read_add_object(ctx, fo);
+
+      fo->num_params = blob_read_uint32(ctx->blob);
+      fo->params = ralloc_array(ctx->nir, nir_parameter, fo->num_params);
+      for (unsigned j = 0; j < fo->num_params; j++) {
+         fo->params[j].param_type = blob_read_uint32(ctx->blob);
+         fo->params[j].type = read_type(ctx);
+      }
+      fo->return_type = read_type(ctx);
+   }
+}
+
+void
+nir_serialize(struct blob *blob, const nir_shader *nir)
+{
+   write_ctx ctx;
+   ctx.blob = blob;
+   ctx.remap_table = _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                                             _mesa_key_pointer_equal);
+   ctx.type_table = _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                                            _mesa_key_pointer_equal);
+   ctx.next_idx = 1;
+   ctx.next_type_idx = 1;
+
+   /* The total size and the sizes of the index tables are only known at
+    * the end.
+    */
+   size_t start = blob->size;
+   blob_write_uint32(blob, 0);
+   size_t idx_table_size_offset = blob->size;
+   blob_write_uint32(blob, 0);
+   size_t type_table_size_offset = blob->size;
+   blob_write_uint32(blob, 0);
+
+   blob_write_uint32(blob, nir->stage);
+
+   struct nir_shader_info info;
+   memcpy(&info, &nir->info, sizeof(info));
+   info.name = NULL;
+   info.label = NULL;
+   blob_write_bytes(blob, &info, sizeof(info));
+   write_name(&ctx, nir->info.name);
+   write_name(&ctx, nir->info.label);
+
+   write_var_list(&ctx, &nir->uniforms);
+   write_var_list(&ctx, &nir->inputs);
+   write_var_list(&ctx, &nir->outputs);
+   write_var_list(&ctx, &nir->globals);
+   write_var_list(&ctx, &nir->system_values);
+
+   write_reg_list(&ctx, &nir->registers);
+   blob_write_uint32(blob, nir->reg_alloc);
+
+   blob_write_uint32(blob, nir->num_inputs);
+   blob_write_uint32(blob, nir->num_uniforms);
+   blob_write_uint32(blob, nir->num_outputs);
+
+   blob_write_uint32(blob, exec_list_length(&nir->functions));
+   foreach_list_typed(nir_function, fxn, node, &nir->functions)
+      write_function(&ctx, fxn);
+
+   /* Only after all overloads are written can we write the actual function
+    * implementations.  This is because nir_call_instr's need to reference
+    * the overloads of other functions and we don't know what order the
+    * functions will have in the list.
+    */
+   nir_foreach_overload(nir, fo) {
+      blob_write_uint32(blob, fo->impl != NULL);
+      if (fo->impl)
+         write_function_impl(&ctx, fo->impl);
+   }
+
+   blob_overwrite_uint32(blob, start, blob->size - start);
+   blob_overwrite_uint32(blob, idx_table_size_offset, ctx.next_idx);
+   blob_overwrite_uint32(blob, type_table_size_offset, ctx.next_type_idx);
+
+   _mesa_hash_table_destroy(ctx.remap_table, NULL);
+   _mesa_hash_table_destroy(ctx.type_table, NULL);
+}
+
+nir_shader *
+nir_deserialize(void *mem_ctx,
+                const struct nir_shader_compiler_options *options,
+                struct blob_reader *blob)
+{
+   read_ctx ctx;
+   ctx.blob = blob;
+   list_inithead(&ctx.phi_srcs);
+
+   /* Check for truncated data before building anything from it. */
+   const uint8_t *start = blob->current;
+   uint32_t size = blob_read_uint32(blob);
+   if (blob->overrun || size > blob->end - start)
+      return NULL;
+
+   ctx.idx_table_size = blob_read_uint32(blob);
+   ctx.type_table_size = blob_read_uint32(blob);
+
+   ctx.idx_table = calloc(ctx.idx_table_size, sizeof(void *));
+   ctx.type_table = calloc(ctx.type_table_size, sizeof(struct glsl_type *));
+   ctx.next_idx = 1;
+   ctx.next_type_idx = 1;
+
+   gl_shader_stage stage = blob_read_uint32(blob);
+   ctx.nir = nir_shader_create(mem_ctx, stage, options);
+
+   blob_copy_bytes(blob, (uint8_t *) &ctx.nir->info, sizeof(ctx.nir->info));
+   ctx.nir->info.name = read_name(&ctx, ctx.nir);
+   ctx.nir->info.label = read_name(&ctx, ctx.nir);
+
+   read_var_list(&ctx, &ctx.nir->uniforms);
+   read_var_list(&ctx, &ctx.nir->inputs);
+   read_var_list(&ctx, &ctx.nir->outputs);
+   read_var_list(&ctx, &ctx.nir->globals);
+   read_var_list(&ctx, &ctx.nir->system_values);
+
+   read_reg_list(&ctx, &ctx.nir->registers);
+   ctx.nir->reg_alloc = blob_read_uint32(blob);
+
+   ctx.nir->num_inputs = blob_read_uint32(blob);
+   ctx.nir->num_uniforms = blob_read_uint32(blob);
+   ctx.nir->num_outputs = blob_read_uint32(blob);
+
+   unsigned num_functions = blob_read_uint32(blob);
+   for (unsigned i = 0; i < num_functions; i++)
+      read_function(&ctx);
+
+   nir_foreach_overload(ctx.nir, fo) {
+      if (blob_read_uint32(blob))
+         read_function_impl(&ctx, fo);
+   }
+
+   free(ctx.idx_table);
+   free(ctx.type_table);
+
+   if (blob->overrun) {
+      ralloc_free(ctx.nir);
+      return NULL;
+   }
+
+   return ctx.nir;
+}
@@ -174,3 +174,23 @@ nir_sweep(nir_shader *nir)
    /* Free everything we didn't steal back. */
    ralloc_free(rubbish);
 }
+
+/**
+ * Replaces \p nir with a copy of itself and frees the original.
+ *
+ * nir_sweep() frees the memory dropped by earlier passes, but everything
+ * that survives stays wherever the pass that created it left it.  Cloning
+ * allocates the whole shader again in program order, so a shader that is
+ * kept around to be cloned for every recompile ends up both smaller and
+ * laid out the way passes walk it.
+ *
+ * The clone is allocated out of the same context as \p nir.  Any pointer
+ * into the old shader is invalid afterwards.
+ */
+nir_shader *
+nir_shader_compact(nir_shader *nir)
+{
+   nir_shader *compact = nir_shader_clone(ralloc_parent(nir), nir);
+   ralloc_free(nir);
+   return compact;
+}
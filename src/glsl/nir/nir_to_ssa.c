@@ -509,7 +509,8 @@ destroy_rewrite_state(rewrite_state *state)
 void
 nir_convert_to_ssa_impl(nir_function_impl *impl)
 {
-   nir_metadata_require(impl, nir_metadata_dominance);
+   nir_metadata_require(impl, nir_metadata_dominance |
+                              nir_metadata_dom_frontier);
 
    insert_phi_nodes(impl);
 
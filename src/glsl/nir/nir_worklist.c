@@ -142,3 +142,38 @@ nir_block_worklist_pop_tail(nir_block_worklist *w)
    BITSET_CLEAR(w->blocks_present, w->blocks[tail]->index);
    return w->blocks[tail];
 }
+
+void
+nir_instr_worklist_init(nir_instr_worklist *w, unsigned initial_size,
+                        void *mem_ctx)
+{
+   w->size = initial_size > 16 ? initial_size : 16;
+   w->count = 0;
+   w->instrs = ralloc_array(mem_ctx, nir_instr *, w->size);
+}
+
+void
+nir_instr_worklist_fini(nir_instr_worklist *w)
+{
+   ralloc_free(w->instrs);
+}
+
+void
+nir_instr_worklist_push_tail(nir_instr_worklist *w, nir_instr *instr)
+{
+   if (w->count == w->size) {
+      w->size *= 2;
+      w->instrs = reralloc(ralloc_parent(w->instrs), w->instrs,
+                           nir_instr *, w->size);
+   }
+
+   w->instrs[w->count++] = instr;
+}
+
+nir_instr *
+nir_instr_worklist_pop_tail(nir_instr_worklist *w)
+{
+   assert(w->count > 0);
+
+   return w->instrs[--w->count];
+}
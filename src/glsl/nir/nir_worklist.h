@@ -84,6 +84,39 @@ nir_block *nir_block_worklist_peek_tail(const nir_block_worklist *w);
 
 nir_block *nir_block_worklist_pop_tail(nir_block_worklist *w);
 
+/** Represents a stack of instructions
+ *
+ * Unlike nir_block_worklist, this does not keep track of which
+ * instructions are present, so pushing an instruction twice puts it on the
+ * stack twice.  Passes that need each instruction at most once usually
+ * already have a per-instruction flag to check before pushing.  The stack
+ * grows as needed.
+ */
+typedef struct {
+   /* The number of instructions the array has room for */
+   unsigned size;
+
+   /* The number of instructions currently in the worklist */
+   unsigned count;
+
+   /* The actual worklist */
+   nir_instr **instrs;
+} nir_instr_worklist;
+
+void nir_instr_worklist_init(nir_instr_worklist *w, unsigned initial_size,
+                             void *mem_ctx);
+void nir_instr_worklist_fini(nir_instr_worklist *w);
+
+static inline bool
+nir_instr_worklist_is_empty(const nir_instr_worklist *w)
+{
+   return w->count == 0;
+}
+
+void nir_instr_worklist_push_tail(nir_instr_worklist *w, nir_instr *instr);
+
+nir_instr *nir_instr_worklist_pop_tail(nir_instr_worklist *w);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,196 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <gtest/gtest.h>
+#include "nir.h"
+#include "nir_builder.h"
+#include "nir_serialize.h"
+
+class nir_serialize_test : public ::testing::Test {
+protected:
+   nir_serialize_test();
+   ~nir_serialize_test();
+
+   /* Serializes shader, reads it back and serializes the copy again. */
+   void round_trip();
+
+   nir_builder b;
+   nir_shader *shader;
+   nir_function_impl *impl;
+
+   struct blob *blob, *copy_blob;
+   nir_shader *copy;
+};
+
+static const nir_shader_compiler_options options = { };
+
+nir_serialize_test::nir_serialize_test()
+{
+   shader = nir_shader_create(NULL, MESA_SHADER_FRAGMENT, &options);
+   nir_function *func = nir_function_create(shader, "main");
+   nir_function_overload *overload = nir_function_overload_create(func);
+   impl = nir_function_impl_create(overload);
+
+   nir_builder_init(&b, impl);
+   b.cursor = nir_after_cf_list(&impl->body);
+
+   blob = blob_create(NULL);
+   copy_blob = blob_create(NULL);
+   copy = NULL;
+}
+
+nir_serialize_test::~nir_serialize_test()
+{
+   ralloc_free(copy);
+   ralloc_free(copy_blob);
+   ralloc_free(blob);
+   ralloc_free(shader);
+}
+
+void
+nir_serialize_test::round_trip()
+{
+   nir_validate_shader(shader);
+   nir_serialize(blob, shader);
+
+   struct blob_reader reader;
+   blob_reader_init(&reader, blob->data, blob->size);
+   copy = nir_deserialize(NULL, &options, &reader);
+   ASSERT_TRUE(copy != NULL);
+   EXPECT_EQ(reader.current, reader.end);
+
+   nir_validate_shader(copy);
+   nir_serialize(copy_blob, copy);
+}
+
+TEST_F(nir_serialize_test, straight_line)
+{
+   nir_variable *in = nir_variable_create(shader, nir_var_shader_in,
+                                          glsl_vec4_type(), "in");
+   nir_variable *out = nir_variable_create(shader, nir_var_shader_out,
+                                           glsl_vec4_type(), "out");
+   nir_variable *dummy = nir_variable_create(shader, nir_var_global,
+                                             glsl_array_type(glsl_float_type(),
+                                                             4), NULL);
+   (void) dummy;
+
+   glsl_struct_field fields[] = {
+      glsl_struct_field(glsl_type::vec4_type, "a"),
+      glsl_struct_field(glsl_type::get_array_instance(glsl_type::sampler2D_type,
+                                                      2), "s"),
+   };
+   const glsl_type *s_type = glsl_type::get_record_instance(fields, 2, "S");
+   nir_variable *u = nir_variable_create(shader, nir_var_uniform, s_type, "u");
+   (void) u;
+
+   nir_ssa_def *val = nir_load_var(&b, in);
+   val = nir_fadd(&b, val, nir_imm_float(&b, 1.0f));
+   nir_store_var(&b, out, val, 0xf);
+
+   round_trip();
+
+   ASSERT_EQ(blob->size, copy_blob->size);
+   EXPECT_EQ(0, memcmp(blob->data, copy_blob->data, blob->size));
+
+   EXPECT_EQ(MESA_SHADER_FRAGMENT, copy->stage);
+   EXPECT_EQ(&options, copy->options);
+   EXPECT_EQ(1u, exec_list_length(&copy->inputs));
+   EXPECT_EQ(1u, exec_list_length(&copy->outputs));
+   EXPECT_EQ(1u, exec_list_length(&copy->globals));
+
+   nir_variable *copy_in = exec_node_data(nir_variable,
+                                          exec_list_get_head(&copy->inputs),
+                                          node);
+   EXPECT_STREQ("in", copy_in->name);
+   EXPECT_EQ(glsl_vec4_type(), copy_in->type);
+
+   nir_variable *copy_u = exec_node_data(nir_variable,
+                                         exec_list_get_head(&copy->uniforms),
+                                         node);
+   EXPECT_EQ(s_type, copy_u->type);
+}
+
+TEST_F(nir_serialize_test, loop_phi)
+{
+   /* Create IR:
+    *
+    * x = 0.0;
+    * while (true) {
+    *    x = phi(x from before the loop, y from the end of the loop)
+    *    y = x + 1.0;
+    *    if (y < 10.0) { } else { break; }
+    * }
+    */
+   nir_ssa_def *zero = nir_imm_float(&b, 0.0f);
+   nir_block *before = nir_cf_node_as_block(exec_node_data(nir_cf_node,
+                                 exec_list_get_head(&impl->body), node));
+
+   nir_loop *loop = nir_loop_create(shader);
+   nir_builder_cf_insert(&b, &loop->cf_node);
+   nir_block *header = nir_cf_node_as_block(nir_loop_first_cf_node(loop));
+
+   nir_phi_instr *phi = nir_phi_instr_create(shader);
+   nir_ssa_dest_init(&phi->instr, &phi->dest, 1, "x");
+   nir_instr_insert(nir_before_block(header), &phi->instr);
+
+   b.cursor = nir_after_instr(&phi->instr);
+   nir_ssa_def *y = nir_fadd(&b, &phi->dest.ssa, nir_imm_float(&b, 1.0f));
+
+   nir_if *nif = nir_if_create(shader);
+   nif->condition = nir_src_for_ssa(nir_flt(&b, y, nir_imm_float(&b, 10.0f)));
+   nir_builder_cf_insert(&b, &nif->cf_node);
+
+   b.cursor = nir_after_cf_list(&nif->else_list);
+   nir_jump_instr *jump = nir_jump_instr_create(shader, nir_jump_break);
+   nir_builder_instr_insert(&b, &jump->instr);
+
+   nir_block *latch = nir_cf_node_as_block(nir_cf_node_next(&nif->cf_node));
+
+   nir_block *preds[] = { before, latch };
+   nir_ssa_def *srcs[] = { zero, y };
+   for (unsigned i = 0; i < 2; i++) {
+      nir_phi_src *src = ralloc(phi, nir_phi_src);
+      src->pred = preds[i];
+      src->src = nir_src_for_ssa(srcs[i]);
+      src->src.parent_instr = &phi->instr;
+      list_addtail(&src->src.use_link, &srcs[i]->uses);
+      exec_list_push_tail(&phi->srcs, &src->node);
+   }
+
+   round_trip();
+
+   ASSERT_EQ(blob->size, copy_blob->size);
+   EXPECT_EQ(0, memcmp(blob->data, copy_blob->data, blob->size));
+}
+
+TEST_F(nir_serialize_test, truncated)
+{
+   nir_store_var(&b, nir_variable_create(shader, nir_var_shader_out,
+                                         glsl_vec4_type(), "out"),
+                 nir_imm_float(&b, 1.0f), 0x1);
+
+   nir_serialize(blob, shader);
+
+   struct blob_reader reader;
+   blob_reader_init(&reader, blob->data, blob->size - 1);
+   EXPECT_TRUE(nir_deserialize(NULL, &options, &reader) == NULL);
+}
@@ -37,45 +37,21 @@
 #include "ir_basic_block.h"
 #include "ir_optimization.h"
 #include "glsl_types.h"
+#include "util/hash_table.h"
+#include "util/set.h"
 
 namespace {
 
-class acp_entry : public exec_node
-{
-public:
-   acp_entry(ir_variable *lhs, ir_variable *rhs)
-   {
-      assert(lhs);
-      assert(rhs);
-      this->lhs = lhs;
-      this->rhs = rhs;
-   }
-
-   ir_variable *lhs;
-   ir_variable *rhs;
-};
-
-
-class kill_entry : public exec_node
-{
-public:
-   kill_entry(ir_variable *var)
-   {
-      assert(var);
-      this->var = var;
-   }
-
-   ir_variable *var;
-};
-
 class ir_copy_propagation_visitor : public ir_hierarchical_visitor {
 public:
    ir_copy_propagation_visitor()
    {
       progress = false;
+      killed_all = false;
       mem_ctx = ralloc_context(0);
-      this->acp = new(mem_ctx) exec_list;
-      this->kills = new(mem_ctx) exec_list;
+      create_acp();
+      this->kills = _mesa_set_create(mem_ctx, _mesa_hash_pointer,
+                                     _mesa_key_pointer_equal);
    }
    ~ir_copy_propagation_visitor()
    {
@@ -94,13 +70,24 @@ public:
    void kill(ir_variable *ir);
    void handle_if_block(exec_list *instructions);
 
-   /** List of acp_entry: The available copies to propagate */
-   exec_list *acp;
+   void create_acp();
+   void destroy_acp();
+   void add_acp_entry(ir_variable *lhs, ir_variable *rhs);
+
    /**
-    * List of kill_entry: The variables whose values were killed in this
-    * block.
+    * The available copies to propagate, as a map from the LHS variable of
+    * each copy to its RHS variable.
     */
-   exec_list *kills;
+   hash_table *acp;
+   /**
+    * Map from each RHS variable in the ACP to the set of LHS variables that
+    * were copied from it, so that kill() doesn't have to walk the whole
+    * ACP.  The sets may still name LHS variables whose copy has since been
+    * removed or replaced.
+    */
+   hash_table *acp_rhs;
+   /** Set of the variables whose values were killed in this block. */
+   set *kills;
 
    bool progress;
 
@@ -111,6 +98,43 @@ public:
 
 } /* unnamed namespace */
 
+void
+ir_copy_propagation_visitor::create_acp()
+{
+   this->acp = _mesa_hash_table_create(mem_ctx, _mesa_hash_pointer,
+                                       _mesa_key_pointer_equal);
+   this->acp_rhs = _mesa_hash_table_create(mem_ctx, _mesa_hash_pointer,
+                                           _mesa_key_pointer_equal);
+}
+
+void
+ir_copy_propagation_visitor::destroy_acp()
+{
+   /* The sets in acp_rhs are allocated out of the table itself. */
+   _mesa_hash_table_destroy(this->acp, NULL);
+   _mesa_hash_table_destroy(this->acp_rhs, NULL);
+}
+
+void
+ir_copy_propagation_visitor::add_acp_entry(ir_variable *lhs, ir_variable *rhs)
+{
+   assert(lhs);
+   assert(rhs);
+
+   _mesa_hash_table_insert(this->acp, lhs, rhs);
+
+   hash_entry *entry = _mesa_hash_table_search(this->acp_rhs, rhs);
+   set *lhs_set;
+   if (entry) {
+      lhs_set = (set *) entry->data;
+   } else {
+      lhs_set = _mesa_set_create(this->acp_rhs, _mesa_hash_pointer,
+                                 _mesa_key_pointer_equal);
+      _mesa_hash_table_insert(this->acp_rhs, rhs, lhs_set);
+   }
+   _mesa_set_add(lhs_set, lhs);
+}
+
 ir_visitor_status
 ir_copy_propagation_visitor::visit_enter(ir_function_signature *ir)
 {
@@ -118,21 +142,24 @@ ir_copy_propagation_visitor::visit_enter(ir_function_signature *ir)
     * block.  Any instructions at global scope will be shuffled into
     * main() at link time, so they're irrelevant to us.
     */
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   hash_table *orig_acp = this->acp;
+   hash_table *orig_acp_rhs = this->acp_rhs;
+   set *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   create_acp();
+   this->kills = _mesa_set_create(mem_ctx, _mesa_hash_pointer,
+                                  _mesa_key_pointer_equal);
    this->killed_all = false;
 
    visit_list_elements(this, &ir->body);
 
-   ralloc_free(this->acp);
-   ralloc_free(this->kills);
+   destroy_acp();
+   _mesa_set_destroy(this->kills, NULL);
 
    this->kills = orig_kills;
    this->acp = orig_acp;
+   this->acp_rhs = orig_acp_rhs;
    this->killed_all = orig_killed_all;
 
    return visit_continue_with_parent;
@@ -168,14 +195,10 @@ ir_copy_propagation_visitor::visit(ir_dereference_variable *ir)
    if (this->in_assignee)
       return visit_continue;
 
-   ir_variable *var = ir->var;
-
-   foreach_in_list(acp_entry, entry, this->acp) {
-      if (var == entry->lhs) {
-	 ir->var = entry->rhs;
-	 this->progress = true;
-	 break;
-      }
+   hash_entry *entry = _mesa_hash_table_search(this->acp, ir->var);
+   if (entry) {
+      ir->var = (ir_variable *) entry->data;
+      this->progress = true;
    }
 
    return visit_continue;
@@ -199,7 +222,8 @@ ir_copy_propagation_visitor::visit_enter(ir_call *ir)
    /* Since we're unlinked, we don't (necessarily) know the side effects of
     * this call.  So kill all copies.
     */
-   acp->make_empty();
+   destroy_acp();
+   create_acp();
    this->killed_all = true;
 
    return visit_continue_with_parent;
@@ -208,36 +232,42 @@ ir_copy_propagation_visitor::visit_enter(ir_call *ir)
 void
 ir_copy_propagation_visitor::handle_if_block(exec_list *instructions)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   hash_table *orig_acp = this->acp;
+   hash_table *orig_acp_rhs = this->acp_rhs;
+   set *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   create_acp();
+   this->kills = _mesa_set_create(mem_ctx, _mesa_hash_pointer,
+                                  _mesa_key_pointer_equal);
    this->killed_all = false;
 
    /* Populate the initial acp with a copy of the original */
-   foreach_in_list(acp_entry, a, orig_acp) {
-      this->acp->push_tail(new(this->acp) acp_entry(a->lhs, a->rhs));
+   struct hash_entry *a;
+   hash_table_foreach(orig_acp, a) {
+      add_acp_entry((ir_variable *) a->key, (ir_variable *) a->data);
    }
 
    visit_list_elements(this, instructions);
 
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
-
-   exec_list *new_kills = this->kills;
+   set *new_kills = this->kills;
    this->kills = orig_kills;
-   ralloc_free(this->acp);
+   destroy_acp();
    this->acp = orig_acp;
+   this->acp_rhs = orig_acp_rhs;
+
+   if (this->killed_all) {
+      destroy_acp();
+      create_acp();
+   }
    this->killed_all = this->killed_all || orig_killed_all;
 
-   foreach_in_list(kill_entry, k, new_kills) {
-      kill(k->var);
+   struct set_entry *k;
+   set_foreach(new_kills, k) {
+      kill((ir_variable *) k->key);
    }
 
-   ralloc_free(new_kills);
+   _mesa_set_destroy(new_kills, NULL);
 }
 
 ir_visitor_status
@@ -255,35 +285,40 @@ ir_copy_propagation_visitor::visit_enter(ir_if *ir)
 ir_visitor_status
 ir_copy_propagation_visitor::visit_enter(ir_loop *ir)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   hash_table *orig_acp = this->acp;
+   hash_table *orig_acp_rhs = this->acp_rhs;
+   set *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
    /* FINISHME: For now, the initial acp for loops is totally empty.
     * We could go through once, then go through again with the acp
     * cloned minus the killed entries after the first run through.
     */
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   create_acp();
+   this->kills = _mesa_set_create(mem_ctx, _mesa_hash_pointer,
+                                  _mesa_key_pointer_equal);
    this->killed_all = false;
 
    visit_list_elements(this, &ir->body_instructions);
 
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
-
-   exec_list *new_kills = this->kills;
+   set *new_kills = this->kills;
    this->kills = orig_kills;
-   ralloc_free(this->acp);
+   destroy_acp();
    this->acp = orig_acp;
+   this->acp_rhs = orig_acp_rhs;
+
+   if (this->killed_all) {
+      destroy_acp();
+      create_acp();
+   }
    this->killed_all = this->killed_all || orig_killed_all;
 
-   foreach_in_list(kill_entry, k, new_kills) {
-      kill(k->var);
+   struct set_entry *k;
+   set_foreach(new_kills, k) {
+      kill((ir_variable *) k->key);
    }
 
-   ralloc_free(new_kills);
+   _mesa_set_destroy(new_kills, NULL);
 
    /* already descended into the children. */
    return visit_continue_with_parent;
@@ -294,16 +329,31 @@ ir_copy_propagation_visitor::kill(ir_variable *var)
 {
    assert(var != NULL);
 
-   /* Remove any entries currently in the ACP for this kill. */
-   foreach_in_list_safe(acp_entry, entry, acp) {
-      if (entry->lhs == var || entry->rhs == var) {
-	 entry->remove();
+   /* Remove any entries currently in the ACP for this kill: the copy to
+    * var, and any copies from var.
+    */
+   hash_entry *entry = _mesa_hash_table_search(this->acp, var);
+   if (entry)
+      _mesa_hash_table_remove(this->acp, entry);
+
+   entry = _mesa_hash_table_search(this->acp_rhs, var);
+   if (entry) {
+      set *lhs_set = (set *) entry->data;
+      struct set_entry *s;
+
+      set_foreach(lhs_set, s) {
+         hash_entry *copy = _mesa_hash_table_search(this->acp, s->key);
+         if (copy && copy->data == var)
+            _mesa_hash_table_remove(this->acp, copy);
       }
+
+      _mesa_set_destroy(lhs_set, NULL);
+      _mesa_hash_table_remove(this->acp_rhs, entry);
    }
 
-   /* Add the LHS variable to the list of killed variables in this block.
+   /* Add the LHS variable to the set of killed variables in this block.
     */
-   this->kills->push_tail(new(this->kills) kill_entry(var));
+   _mesa_set_add(this->kills, var);
 }
 
 /**
@@ -313,8 +363,6 @@ ir_copy_propagation_visitor::kill(ir_variable *var)
 void
 ir_copy_propagation_visitor::add_copy(ir_assignment *ir)
 {
-   acp_entry *entry;
-
    if (ir->condition)
       return;
 
@@ -332,8 +380,7 @@ ir_copy_propagation_visitor::add_copy(ir_assignment *ir)
 	 this->progress = true;
       } else if (lhs_var->data.mode != ir_var_shader_storage &&
                  lhs_var->data.mode != ir_var_shader_shared) {
-	 entry = new(this->acp) acp_entry(lhs_var, rhs_var);
-	 this->acp->push_tail(entry);
+	 add_acp_entry(lhs_var, rhs_var);
       }
    }
 }
@@ -46,48 +46,29 @@
 #include "ir_basic_block.h"
 #include "ir_optimization.h"
 #include "glsl_types.h"
+#include "util/hash_table.h"
+#include "util/set.h"
 
 static bool debug = false;
 
 namespace {
 
-class acp_entry : public exec_node
-{
-public:
-   acp_entry(ir_variable *lhs, ir_variable *rhs, int write_mask, int swizzle[4])
-   {
-      this->lhs = lhs;
-      this->rhs = rhs;
-      this->write_mask = write_mask;
-      memcpy(this->swizzle, swizzle, sizeof(this->swizzle));
-   }
-
-   acp_entry(acp_entry *a)
-   {
-      this->lhs = a->lhs;
-      this->rhs = a->rhs;
-      this->write_mask = a->write_mask;
-      memcpy(this->swizzle, a->swizzle, sizeof(this->swizzle));
-   }
-
-   ir_variable *lhs;
-   ir_variable *rhs;
-   unsigned int write_mask;
-   int swizzle[4];
-};
-
-
-class kill_entry : public exec_node
+/**
+ * The ACP state of one vector or scalar variable: the channels of the
+ * variable that are copies of channels of other variables, and the other
+ * variables that have channels copied from this one.
+ */
+struct acp_entry
 {
-public:
-   kill_entry(ir_variable *var, int write_mask)
-   {
-      this->var = var;
-      this->write_mask = write_mask;
-   }
-
-   ir_variable *var;
-   unsigned int write_mask;
+   /** For each channel, the variable it was copied from, or NULL. */
+   ir_variable *rhs_element[4];
+   /** For each channel, the channel of rhs_element it was copied from. */
+   int rhs_channel[4];
+   /**
+    * Set of the variables with channels copied from this one, or NULL.  It
+    * may still name variables whose copies have since been killed.
+    */
+   set *dsts;
 };
 
 class ir_copy_propagation_elements_visitor : public ir_rvalue_visitor {
@@ -98,8 +79,8 @@ public:
       this->killed_all = false;
       this->mem_ctx = ralloc_context(NULL);
       this->shader_mem_ctx = NULL;
-      this->acp = new(mem_ctx) exec_list;
-      this->kills = new(mem_ctx) exec_list;
+      this->acp = create_acp();
+      this->kills = create_kills();
    }
    ~ir_copy_propagation_elements_visitor()
    {
@@ -116,16 +97,24 @@ public:
    void handle_rvalue(ir_rvalue **rvalue);
 
    void add_copy(ir_assignment *ir);
-   void kill(kill_entry *k);
+   void kill(ir_variable *var, unsigned write_mask);
    void handle_if_block(exec_list *instructions);
 
-   /** List of acp_entry: The available copies to propagate */
-   exec_list *acp;
+   hash_table *create_acp();
+   hash_table *create_kills();
+   acp_entry *get_acp_entry(ir_variable *var);
+   void add_acp_dst(ir_variable *rhs, ir_variable *lhs);
+
+   /**
+    * The available copies to propagate, as a map from each variable to its
+    * acp_entry.
+    */
+   hash_table *acp;
    /**
-    * List of kill_entry: The variables whose values were killed in this
-    * block.
+    * The variables whose values were killed in this block, as a map from
+    * each variable to the write mask of the killed channels.
     */
-   exec_list *kills;
+   hash_table *kills;
 
    bool progress;
 
@@ -139,6 +128,51 @@ public:
 
 } /* unnamed namespace */
 
+hash_table *
+ir_copy_propagation_elements_visitor::create_acp()
+{
+   return _mesa_hash_table_create(mem_ctx, _mesa_hash_pointer,
+                                  _mesa_key_pointer_equal);
+}
+
+hash_table *
+ir_copy_propagation_elements_visitor::create_kills()
+{
+   return _mesa_hash_table_create(mem_ctx, _mesa_hash_pointer,
+                                  _mesa_key_pointer_equal);
+}
+
+/**
+ * Returns the acp_entry of \p var in the current ACP, creating an empty one
+ * if there is none.  Entries are allocated out of the ACP table, so they go
+ * away with it.
+ */
+acp_entry *
+ir_copy_propagation_elements_visitor::get_acp_entry(ir_variable *var)
+{
+   hash_entry *he = _mesa_hash_table_search(this->acp, var);
+   if (he)
+      return (acp_entry *) he->data;
+
+   acp_entry *entry = rzalloc(this->acp, acp_entry);
+   _mesa_hash_table_insert(this->acp, var, entry);
+   return entry;
+}
+
+/** Records that \p lhs has channels copied from \p rhs. */
+void
+ir_copy_propagation_elements_visitor::add_acp_dst(ir_variable *rhs,
+                                                  ir_variable *lhs)
+{
+   acp_entry *entry = get_acp_entry(rhs);
+
+   if (!entry->dsts) {
+      entry->dsts = _mesa_set_create(entry, _mesa_hash_pointer,
+                                     _mesa_key_pointer_equal);
+   }
+   _mesa_set_add(entry->dsts, lhs);
+}
+
 ir_visitor_status
 ir_copy_propagation_elements_visitor::visit_enter(ir_function_signature *ir)
 {
@@ -146,18 +180,18 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_function_signature *ir)
     * block.  Any instructions at global scope will be shuffled into
     * main() at link time, so they're irrelevant to us.
     */
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   hash_table *orig_acp = this->acp;
+   hash_table *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   this->acp = create_acp();
+   this->kills = create_kills();
    this->killed_all = false;
 
    visit_list_elements(this, &ir->body);
 
-   ralloc_free(this->acp);
-   ralloc_free(this->kills);
+   _mesa_hash_table_destroy(this->acp, NULL);
+   _mesa_hash_table_destroy(this->kills, NULL);
 
    this->kills = orig_kills;
    this->acp = orig_acp;
@@ -173,14 +207,10 @@ ir_copy_propagation_elements_visitor::visit_leave(ir_assignment *ir)
    ir_variable *var = ir->lhs->variable_referenced();
 
    if (var->type->is_scalar() || var->type->is_vector()) {
-      kill_entry *k;
-
       if (lhs)
-	 k = new(this->kills) kill_entry(var, ir->write_mask);
+	 kill(var, ir->write_mask);
       else
-	 k = new(this->kills) kill_entry(var, ~0);
-
-      kill(k);
+	 kill(var, ~0);
    }
 
    add_copy(ir);
@@ -248,17 +278,18 @@ ir_copy_propagation_elements_visitor::handle_rvalue(ir_rvalue **ir)
    /* Try to find ACP entries covering swizzle_chan[], hoping they're
     * the same source variable.
     */
-   foreach_in_list(acp_entry, entry, this->acp) {
-      if (var == entry->lhs) {
-	 for (int c = 0; c < chans; c++) {
-	    if (entry->write_mask & (1 << swizzle_chan[c])) {
-	       source[c] = entry->rhs;
-	       source_chan[c] = entry->swizzle[swizzle_chan[c]];
-
-               if (source_chan[c] != swizzle_chan[c])
-                  noop_swizzle = false;
-	    }
-	 }
+   hash_entry *he = _mesa_hash_table_search(this->acp, var);
+   if (!he)
+      return;
+
+   acp_entry *entry = (acp_entry *) he->data;
+   for (int c = 0; c < chans; c++) {
+      if (entry->rhs_element[swizzle_chan[c]]) {
+	 source[c] = entry->rhs_element[swizzle_chan[c]];
+	 source_chan[c] = entry->rhs_channel[swizzle_chan[c]];
+
+	 if (source_chan[c] != swizzle_chan[c])
+	    noop_swizzle = false;
       }
    }
 
@@ -318,7 +349,8 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_call *ir)
    /* Since we're unlinked, we don't (necessarily) know the side effects of
     * this call.  So kill all copies.
     */
-   acp->make_empty();
+   _mesa_hash_table_destroy(this->acp, NULL);
+   this->acp = create_acp();
    this->killed_all = true;
 
    return visit_continue_with_parent;
@@ -327,39 +359,58 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_call *ir)
 void
 ir_copy_propagation_elements_visitor::handle_if_block(exec_list *instructions)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   hash_table *orig_acp = this->acp;
+   hash_table *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   this->acp = create_acp();
+   this->kills = create_kills();
    this->killed_all = false;
 
-   /* Populate the initial acp with a copy of the original */
-   foreach_in_list(acp_entry, a, orig_acp) {
-      this->acp->push_tail(new(this->acp) acp_entry(a));
+   /* Populate the initial acp with a copy of the original.  The dsts sets
+    * are rebuilt from the copied channels rather than cloned, which drops
+    * any stale members.
+    */
+   struct hash_entry *a;
+   hash_table_foreach(orig_acp, a) {
+      ir_variable *var = (ir_variable *) a->key;
+      const acp_entry *orig_entry = (const acp_entry *) a->data;
+      acp_entry *entry = NULL;
+
+      for (int c = 0; c < 4; c++) {
+         if (!orig_entry->rhs_element[c])
+            continue;
+
+         if (!entry)
+            entry = get_acp_entry(var);
+         entry->rhs_element[c] = orig_entry->rhs_element[c];
+         entry->rhs_channel[c] = orig_entry->rhs_channel[c];
+         add_acp_dst(orig_entry->rhs_element[c], var);
+      }
    }
 
    visit_list_elements(this, instructions);
 
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
-
-   exec_list *new_kills = this->kills;
+   hash_table *new_kills = this->kills;
    this->kills = orig_kills;
-   ralloc_free(this->acp);
+   _mesa_hash_table_destroy(this->acp, NULL);
    this->acp = orig_acp;
+
+   if (this->killed_all) {
+      _mesa_hash_table_destroy(this->acp, NULL);
+      this->acp = create_acp();
+   }
    this->killed_all = this->killed_all || orig_killed_all;
 
-   /* Move the new kills into the parent block's list, removing them
-    * from the parent's ACP list in the process.
+   /* Move the new kills into the parent block's table, removing them
+    * from the parent's ACP in the process.
     */
-   foreach_in_list_safe(kill_entry, k, new_kills) {
-      kill(k);
+   struct hash_entry *k;
+   hash_table_foreach(new_kills, k) {
+      kill((ir_variable *) k->key, (uintptr_t) k->data);
    }
 
-   ralloc_free(new_kills);
+   _mesa_hash_table_destroy(new_kills, NULL);
 }
 
 ir_visitor_status
@@ -377,63 +428,87 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_if *ir)
 ir_visitor_status
 ir_copy_propagation_elements_visitor::visit_enter(ir_loop *ir)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
+   hash_table *orig_acp = this->acp;
+   hash_table *orig_kills = this->kills;
    bool orig_killed_all = this->killed_all;
 
    /* FINISHME: For now, the initial acp for loops is totally empty.
     * We could go through once, then go through again with the acp
     * cloned minus the killed entries after the first run through.
     */
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
+   this->acp = create_acp();
+   this->kills = create_kills();
    this->killed_all = false;
 
    visit_list_elements(this, &ir->body_instructions);
 
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
-
-   exec_list *new_kills = this->kills;
+   hash_table *new_kills = this->kills;
    this->kills = orig_kills;
-   ralloc_free(this->acp);
+   _mesa_hash_table_destroy(this->acp, NULL);
    this->acp = orig_acp;
+
+   if (this->killed_all) {
+      _mesa_hash_table_destroy(this->acp, NULL);
+      this->acp = create_acp();
+   }
    this->killed_all = this->killed_all || orig_killed_all;
 
-   foreach_in_list_safe(kill_entry, k, new_kills) {
-      kill(k);
+   struct hash_entry *k;
+   hash_table_foreach(new_kills, k) {
+      kill((ir_variable *) k->key, (uintptr_t) k->data);
    }
 
-   ralloc_free(new_kills);
+   _mesa_hash_table_destroy(new_kills, NULL);
 
    /* already descended into the children. */
    return visit_continue_with_parent;
 }
 
-/* Remove any entries currently in the ACP for this kill. */
+/**
+ * Removes the channels in \p write_mask of \p var from the ACP, along with
+ * every channel copied from any channel of \p var, and records the kill for
+ * the parent block.
+ */
 void
-ir_copy_propagation_elements_visitor::kill(kill_entry *k)
+ir_copy_propagation_elements_visitor::kill(ir_variable *var,
+                                           unsigned write_mask)
 {
-   foreach_in_list_safe(acp_entry, entry, acp) {
-      if (entry->lhs == k->var) {
-	 entry->write_mask = entry->write_mask & ~k->write_mask;
-	 if (entry->write_mask == 0) {
-	    entry->remove();
-	    continue;
-	 }
+   hash_entry *he = _mesa_hash_table_search(this->acp, var);
+   if (he) {
+      acp_entry *entry = (acp_entry *) he->data;
+
+      for (int c = 0; c < 4; c++) {
+         if (write_mask & (1 << c))
+            entry->rhs_element[c] = NULL;
       }
-      if (entry->rhs == k->var) {
-	 entry->remove();
+
+      if (entry->dsts) {
+         struct set_entry *s;
+         set_foreach(entry->dsts, s) {
+            hash_entry *dst_he = _mesa_hash_table_search(this->acp, s->key);
+            if (!dst_he)
+               continue;
+
+            acp_entry *dst = (acp_entry *) dst_he->data;
+            for (int c = 0; c < 4; c++) {
+               if (dst->rhs_element[c] == var)
+                  dst->rhs_element[c] = NULL;
+            }
+         }
+
+         _mesa_set_destroy(entry->dsts, NULL);
+         entry->dsts = NULL;
       }
    }
 
-   /* If we were on a list, remove ourselves before inserting */
-   if (k->next)
-      k->remove();
-
-   ralloc_steal(this->kills, k);
-   this->kills->push_tail(k);
+   /* Kills of the same variable within a block combine into one. */
+   he = _mesa_hash_table_search(this->kills, var);
+   if (he) {
+      he->data = (void *) ((uintptr_t) he->data | write_mask);
+   } else {
+      _mesa_hash_table_insert(this->kills, var,
+                              (void *) (uintptr_t) write_mask);
+   }
 }
 
 /**
@@ -493,9 +568,17 @@ ir_copy_propagation_elements_visitor::add_copy(ir_assignment *ir)
       }
    }
 
-   entry = new(this->mem_ctx) acp_entry(lhs->var, rhs->var, write_mask,
-					swizzle);
-   this->acp->push_tail(entry);
+   if (!write_mask)
+      return;
+
+   entry = get_acp_entry(lhs->var);
+   for (int i = 0; i < 4; i++) {
+      if (write_mask & (1 << i)) {
+	 entry->rhs_element[i] = rhs->var;
+	 entry->rhs_channel[i] = swizzle[i];
+      }
+   }
+   add_acp_dst(rhs->var, lhs->var);
 }
 
 bool
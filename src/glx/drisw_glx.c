@@ -29,6 +29,95 @@
 #include "dri_common.h"
 #include "drisw_priv.h"
 
+static int xshm_error = 0;
+static int xshm_opcode = -1;
+
+/**
+ * Catches the errors of the MIT-SHM requests, which are expected when the
+ * server can't attach our segments, e.g. on a remote display.
+ */
+static int
+handle_xerror(Display *dpy, XErrorEvent *event)
+{
+   (void) dpy;
+
+   assert(xshm_opcode != -1);
+   if (event->request_code != xshm_opcode)
+      return 0;
+
+   xshm_error = event->error_code;
+   return 0;
+}
+
+/**
+ * (Re)creates the XImage of a drawable, backed by the shared memory segment
+ * \p shmid if it is not -1 and the server can attach it.
+ */
+static Bool
+XCreateDrawableImage(struct drisw_drawable * pdp, Display * dpy, int shmid)
+{
+   if (pdp->ximage) {
+      if (pdp->shminfo.shmid >= 0)
+         XShmDetach(dpy, &pdp->shminfo);
+      XDestroyImage(pdp->ximage);
+      pdp->ximage = NULL;
+   }
+
+   if (!xshm_error && shmid >= 0) {
+      pdp->shminfo.shmid = shmid;
+      pdp->shminfo.readOnly = False;
+      pdp->ximage = XShmCreateImage(dpy,
+                                    pdp->visinfo->visual,
+                                    pdp->visinfo->depth,
+                                    ZPixmap,              /* format */
+                                    NULL,                 /* data */
+                                    &pdp->shminfo,        /* shminfo */
+                                    0, 0);                /* width, height */
+      if (pdp->ximage != NULL) {
+         int (*old_handler)(Display *, XErrorEvent *);
+
+         /* dispatch pending errors */
+         XSync(dpy, False);
+
+         old_handler = XSetErrorHandler(handle_xerror);
+         /* This may trigger the X protocol error we're ready to catch: */
+         XShmAttach(dpy, &pdp->shminfo);
+         XSync(dpy, False);
+
+         if (xshm_error) {
+            /* we are on a remote display, this error is normal, don't print it */
+            XDestroyImage(pdp->ximage);
+            pdp->ximage = NULL;
+         }
+
+         (void) XSetErrorHandler(old_handler);
+      }
+   }
+
+   if (pdp->ximage == NULL) {
+      pdp->shminfo.shmid = -1;
+      pdp->ximage = XCreateImage(dpy,
+                                 pdp->visinfo->visual,
+                                 pdp->visinfo->depth,
+                                 ZPixmap, 0,             /* format, offset */
+                                 NULL,                   /* data */
+                                 0, 0,                   /* width, height */
+                                 32,                     /* bitmap_pad */
+                                 0);                     /* bytes_per_line */
+      if (pdp->ximage == NULL)
+         return False;
+   }
+
+  /**
+   * swrast does not handle 24-bit depth with 24 bpp, so let X do the
+   * the conversion for us.
+   */
+  if (pdp->ximage->bits_per_pixel == 24)
+     pdp->ximage->bits_per_pixel = 32;
+
+   return True;
+}
+
 static Bool
 XCreateDrawable(struct drisw_drawable * pdp,
                 Display * dpy, XID drawable, int visualid)
@@ -56,30 +145,17 @@ XCreateDrawable(struct drisw_drawable * pdp,
    if (!pdp->visinfo || num_visuals == 0)
       return False;
 
-   /* create XImage */
-   pdp->ximage = XCreateImage(dpy,
-                              pdp->visinfo->visual,
-                              pdp->visinfo->depth,
-                              ZPixmap, 0,             /* format, offset */
-                              NULL,                   /* data */
-                              0, 0,                   /* width, height */
-                              32,                     /* bitmap_pad */
-                              0);                     /* bytes_per_line */
-
-  /**
-   * swrast does not handle 24-bit depth with 24 bpp, so let X do the
-   * the conversion for us.
-   */
-  if (pdp->ximage->bits_per_pixel == 24)
-     pdp->ximage->bits_per_pixel = 32;
-
-   return True;
+   /* create XImage, the shared memory one is created on the first put */
+   return XCreateDrawableImage(pdp, dpy, -1);
 }
 
 static void
 XDestroyDrawable(struct drisw_drawable * pdp, Display * dpy, XID drawable)
 {
-   XDestroyImage(pdp->ximage);
+   if (pdp->ximage && pdp->shminfo.shmid >= 0)
+      XShmDetach(dpy, &pdp->shminfo);
+   if (pdp->ximage)
+      XDestroyImage(pdp->ximage);
    free(pdp->visinfo);
 
    XFreeGC(dpy, pdp->gc);
@@ -133,9 +209,9 @@ bytes_per_line(unsigned pitch_bits, unsigned mul)
 }
 
 static void
-swrastPutImage2(__DRIdrawable * draw, int op,
-                int x, int y, int w, int h, int stride,
-                char *data, void *loaderPrivate)
+swrastXPutImage(__DRIdrawable * draw, int op,
+                int srcx, int srcy, int x, int y, int w, int h, int stride,
+                int shmid, char *data, void *loaderPrivate)
 {
    struct drisw_drawable *pdp = loaderPrivate;
    __GLXDRIdrawable *pdraw = &(pdp->base);
@@ -144,6 +220,15 @@ swrastPutImage2(__DRIdrawable * draw, int op,
    XImage *ximage;
    GC gc;
 
+   /* Switch between the shared memory and the plain image as needed; if the
+    * segment can't be attached, the plain image is used from then on.
+    */
+   if (pdp->ximage == NULL || (shmid != pdp->shminfo.shmid &&
+                               (shmid == -1 || !xshm_error))) {
+      if (!XCreateDrawableImage(pdp, dpy, shmid))
+         return;
+   }
+
    switch (op) {
    case __DRI_SWRAST_IMAGE_OP_DRAW:
       gc = pdp->gc;
@@ -158,22 +243,58 @@ swrastPutImage2(__DRIdrawable * draw, int op,
    drawable = pdraw->xDrawable;
 
    ximage = pdp->ximage;
-   ximage->data = data;
-   ximage->width = w;
-   ximage->height = h;
    ximage->bytes_per_line = stride ? stride : bytes_per_line(w * ximage->bits_per_pixel, 32);
+   ximage->data = data;
 
-   XPutImage(dpy, drawable, gc, ximage, 0, 0, x, y, w, h);
+   if (pdp->shminfo.shmid >= 0) {
+      /* The server reads the pixels straight from the segment, at the
+       * offset of data from shmaddr.  Wait for it to be done, as the
+       * driver renders the next frame into the same memory.
+       */
+      ximage->width = ximage->bytes_per_line / ((ximage->bits_per_pixel + 7) / 8);
+      ximage->height = srcy + h;
+
+      XShmPutImage(dpy, drawable, gc, ximage, srcx, srcy, x, y, w, h, False);
+      XSync(dpy, False);
+   } else {
+      ximage->width = w;
+      ximage->height = h;
+
+      XPutImage(dpy, drawable, gc, ximage, srcx, srcy, x, y, w, h);
+   }
 
    ximage->data = NULL;
 }
 
+static void
+swrastPutImageShm(__DRIdrawable * draw, int op,
+                  int x, int y, int w, int h, int stride,
+                  int shmid, char *shmaddr, unsigned offset,
+                  void *loaderPrivate)
+{
+   struct drisw_drawable *pdp = loaderPrivate;
+
+   pdp->shminfo.shmaddr = shmaddr;
+   swrastXPutImage(draw, op, 0, 0, x, y, w, h, stride, shmid,
+                   shmaddr + offset, loaderPrivate);
+}
+
+static void
+swrastPutImage2(__DRIdrawable * draw, int op,
+                int x, int y, int w, int h, int stride,
+                char *data, void *loaderPrivate)
+{
+   swrastXPutImage(draw, op, 0, 0, x, y, w, h, stride, -1,
+                   data, loaderPrivate);
+}
+
 static void
 swrastPutImage(__DRIdrawable * draw, int op,
                int x, int y, int w, int h,
                char *data, void *loaderPrivate)
 {
-   swrastPutImage2(draw, op, x, y, w, h, 0, data, loaderPrivate);
+   swrastXPutImage(draw, op, 0, 0, x, y, w, h, 0, -1,
+                   data, loaderPrivate);
 }
 
 static void
@@ -208,6 +329,23 @@ swrastGetImage(__DRIdrawable * read,
    swrastGetImage2(read, x, y, w, h, 0, data, loaderPrivate);
 }
 
+static const __DRIswrastLoaderExtension swrastLoaderExtension_shm = {
+   .base = {__DRI_SWRAST_LOADER, 4 },
+
+   .getDrawableInfo     = swrastGetDrawableInfo,
+   .putImage            = swrastPutImage,
+   .getImage            = swrastGetImage,
+   .putImage2           = swrastPutImage2,
+   .getImage2           = swrastGetImage2,
+   .putImageShm         = swrastPutImageShm,
+};
+
+static const __DRIextension *loader_extensions_shm[] = {
+   &systemTimeExtension.base,
+   &swrastLoaderExtension_shm.base,
+   NULL
+};
+
 static const __DRIswrastLoaderExtension swrastLoaderExtension = {
    .base = {__DRI_SWRAST_LOADER, 3 },
 
@@ -218,7 +356,7 @@ static const __DRIswrastLoaderExtension swrastLoaderExtension = {
    .getImage2           = swrastGetImage2,
 };
 
-static const __DRIextension *loader_extensions[] = {
+static const __DRIextension *loader_extensions_noshm[] = {
    &systemTimeExtension.base,
    &swrastLoaderExtension.base,
    NULL
@@ -655,6 +793,7 @@ driswCreateScreen(int screen, struct glx_display *priv)
    __GLXDRIscreen *psp;
    const __DRIconfig **driver_configs;
    const __DRIextension **extensions;
+   const __DRIextension **loader_extensions;
    struct drisw_screen *psc;
    struct glx_config *configs = NULL, *visuals = NULL;
    int i;
@@ -690,6 +829,19 @@ driswCreateScreen(int screen, struct glx_display *priv)
       goto handle_error;
    }
 
+   /* Offer the driver to present from shared memory if the server can
+    * attach the segments; a remote server can't, which shows on the first
+    * attach.
+    */
+   if (xshm_opcode == -1) {
+      int event, error;
+
+      if (!XQueryExtension(priv->dpy, "MIT-SHM", &xshm_opcode, &event, &error))
+         xshm_opcode = -1;
+   }
+   loader_extensions = xshm_opcode != -1 ? loader_extensions_shm
+                                         : loader_extensions_noshm;
+
    if (psc->swrast->base.version >= 4) {
       psc->driScreen =
          psc->swrast->createNewScreen2(screen, loader_extensions,
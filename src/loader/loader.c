@@ -70,6 +70,8 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include "c11/threads.h"
 #ifdef HAVE_LIBUDEV
 #include <assert.h>
 #include <dlfcn.h>
@@ -577,8 +579,56 @@ drm_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
 #endif
 
 
-int
-loader_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
+/**
+ * PCI ids already looked up in this process, keyed by device number, so
+ * that opening the same device again (a second EGLDisplay, a GLX screen
+ * plus a DRI3 reopen, ...) does not go through udev or sysfs again.
+ */
+#define PCI_ID_CACHE_SIZE 8
+
+static struct {
+   dev_t rdev;
+   int vendor_id;
+   int chip_id;
+} pci_id_cache[PCI_ID_CACHE_SIZE];
+static unsigned pci_id_cache_count;
+static mtx_t pci_id_cache_mutex = _MTX_INITIALIZER_NP;
+
+static int
+pci_id_cache_lookup(dev_t rdev, int *vendor_id, int *chip_id)
+{
+   unsigned i;
+   int found = 0;
+
+   mtx_lock(&pci_id_cache_mutex);
+   for (i = 0; i < pci_id_cache_count; i++) {
+      if (pci_id_cache[i].rdev == rdev) {
+         *vendor_id = pci_id_cache[i].vendor_id;
+         *chip_id = pci_id_cache[i].chip_id;
+         found = 1;
+         break;
+      }
+   }
+   mtx_unlock(&pci_id_cache_mutex);
+
+   return found;
+}
+
+static void
+pci_id_cache_insert(dev_t rdev, int vendor_id, int chip_id)
+{
+   mtx_lock(&pci_id_cache_mutex);
+   if (pci_id_cache_count < PCI_ID_CACHE_SIZE) {
+      pci_id_cache[pci_id_cache_count].rdev = rdev;
+      pci_id_cache[pci_id_cache_count].vendor_id = vendor_id;
+      pci_id_cache[pci_id_cache_count].chip_id = chip_id;
+      pci_id_cache_count++;
+   }
+   mtx_unlock(&pci_id_cache_mutex);
+}
+
+static int
+probe_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
 {
 #if HAVE_LIBUDEV
    if (libudev_get_pci_id_for_fd(fd, vendor_id, chip_id))
@@ -595,6 +645,24 @@ loader_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
    return 0;
 }
 
+int
+loader_get_pci_id_for_fd(int fd, int *vendor_id, int *chip_id)
+{
+   struct stat sbuf;
+
+   if (fstat(fd, &sbuf) != 0 || !S_ISCHR(sbuf.st_mode))
+      return probe_pci_id_for_fd(fd, vendor_id, chip_id);
+
+   if (pci_id_cache_lookup(sbuf.st_rdev, vendor_id, chip_id))
+      return 1;
+
+   if (!probe_pci_id_for_fd(fd, vendor_id, chip_id))
+      return 0;
+
+   pci_id_cache_insert(sbuf.st_rdev, *vendor_id, *chip_id);
+   return 1;
+}
+
 
 #ifdef HAVE_LIBUDEV
 static char *
@@ -688,11 +756,21 @@ loader_get_device_name_for_fd(int fd)
    return result;
 }
 
+static int64_t
+loader_get_time_us(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (int64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 char *
 loader_get_driver_for_fd(int fd, unsigned driver_types)
 {
    int vendor_id, chip_id, i, j;
    char *driver = NULL;
+   int64_t start = loader_get_time_us();
 
    if (!driver_types)
       driver_types = _LOADER_GALLIUM | _LOADER_DRI;
@@ -741,8 +819,9 @@ loader_get_driver_for_fd(int fd, unsigned driver_types)
 
 out:
    log_(driver ? _LOADER_DEBUG : _LOADER_WARNING,
-         "pci id for fd %d: %04x:%04x, driver %s\n",
-         fd, vendor_id, chip_id, driver);
+         "pci id for fd %d: %04x:%04x, driver %s (probed in %d us)\n",
+         fd, vendor_id, chip_id, driver,
+         (int) (loader_get_time_us() - start));
    return driver;
 }
 
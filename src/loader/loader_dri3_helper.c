@@ -22,7 +22,10 @@
  */
 
 #include <fcntl.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <X11/xshmfence.h>
@@ -40,6 +43,21 @@
 #define DRI_CONF_VBLANK_DEF_INTERVAL_1 2
 #define DRI_CONF_VBLANK_ALWAYS_SYNC 3
 
+#define MIN2(A, B)  (((A) < (B)) ? (A) : (B))
+#define MAX2(A, B)  (((A) > (B)) ? (A) : (B))
+
+/* Current time in UST units, matching what the X server reports */
+static uint64_t
+dri3_get_ust(void)
+{
+   struct timespec ts;
+
+   if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+      return 0;
+
+   return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
 static inline void
 dri3_fence_reset(xcb_connection_t *c, struct loader_dri3_buffer *buffer)
 {
@@ -87,6 +105,88 @@ loader_dri3_set_swap_interval(struct loader_dri3_drawable *draw, int interval)
    dri3_update_num_back(draw);
 }
 
+static inline void
+dri3_damage_set_full(int *damage)
+{
+   damage[0] = damage[1] = 0;
+   damage[2] = damage[3] = INT_MAX;
+}
+
+static inline void
+dri3_damage_union(int *damage, const int *box)
+{
+   if (box[0] >= box[2] || box[1] >= box[3])
+      return;
+
+   if (damage[0] >= damage[2] || damage[1] >= damage[3]) {
+      memcpy(damage, box, 4 * sizeof(int));
+      return;
+   }
+
+   damage[0] = MIN2(damage[0], box[0]);
+   damage[1] = MIN2(damage[1], box[1]);
+   damage[2] = MAX2(damage[2], box[2]);
+   damage[3] = MAX2(damage[3], box[3]);
+}
+
+/** dri3_update_linear_buffer
+ *
+ * Copy the parts of the back buffer that changed since its linear buffer
+ * was last updated, given the damage of the frame being swapped. Every
+ * other back buffer accumulates the frame damage for its next swap.
+ */
+static void
+dri3_update_linear_buffer(struct loader_dri3_drawable *draw,
+                          __DRIcontext *dri_context,
+                          struct loader_dri3_buffer *back,
+                          const int *rects, int n_rects)
+{
+   int box[4] = { INT_MAX, INT_MAX, 0, 0 };
+   int b, x1, y1, x2, y2;
+
+   /* Nothing to copy when rendering straight into the shared buffer */
+   if (!back->linear_buffer)
+      return;
+
+   if (n_rects == 0) {
+      dri3_damage_set_full(box);
+   } else {
+      /* Damage rectangles have their origin at the bottom left */
+      for (b = 0; b < n_rects; b++) {
+         const int *rect = &rects[b * 4];
+
+         box[0] = MIN2(box[0], rect[0]);
+         box[1] = MIN2(box[1], draw->height - rect[1] - rect[3]);
+         box[2] = MAX2(box[2], rect[0] + rect[2]);
+         box[3] = MAX2(box[3], draw->height - rect[1]);
+      }
+   }
+
+   for (b = 0; b < LOADER_DRI3_MAX_BACK; b++) {
+      struct loader_dri3_buffer *buffer = draw->buffers[LOADER_DRI3_BACK_ID(b)];
+
+      if (buffer && buffer != back)
+         dri3_damage_union(buffer->damage, box);
+   }
+
+   dri3_damage_union(back->damage, box);
+   x1 = MAX2(back->damage[0], 0);
+   y1 = MAX2(back->damage[1], 0);
+   x2 = MIN2(back->damage[2], back->width);
+   y2 = MIN2(back->damage[3], back->height);
+   back->damage[0] = back->damage[1] = back->damage[2] = back->damage[3] = 0;
+
+   if (x2 <= x1 || y2 <= y1)
+      return;
+
+   draw->ext->image->blitImage(dri_context,
+                               back->linear_buffer,
+                               back->image,
+                               x1, y1, x2 - x1, y2 - y1,
+                               x1, y1, x2 - x1, y2 - y1,
+                               __BLIT_FLAG_FLUSH);
+}
+
 /** dri3_free_render_buffer
  *
  * Free everything associated with one render buffer including pixmap, fence
@@ -136,6 +236,8 @@ loader_dri3_drawable_init(xcb_connection_t *conn,
    xcb_get_geometry_reply_t *reply;
    xcb_generic_error_t *error;
    GLint vblank_mode = DRI_CONF_VBLANK_DEF_INTERVAL_1;
+   GLint max_queued = 0;
+   unsigned char prime_render_linear = 0;
    int swap_interval;
 
    draw->conn = conn;
@@ -149,9 +251,19 @@ loader_dri3_drawable_init(xcb_connection_t *conn,
    draw->have_fake_front = 0;
    draw->first_init = true;
 
-   if (draw->ext->config)
+   if (draw->ext->config) {
       draw->ext->config->configQueryi(draw->dri_screen,
                                       "vblank_mode", &vblank_mode);
+      draw->ext->config->configQueryi(draw->dri_screen,
+                                      "max_queued_frames", &max_queued);
+      draw->ext->config->configQueryb(draw->dri_screen,
+                                      "prime_render_linear",
+                                      &prime_render_linear);
+   }
+   draw->prime_render_linear = is_different_gpu && prime_render_linear;
+   draw->max_queued = max_queued > 0 ? max_queued : 0;
+   memset(draw->swap_history, 0, sizeof(draw->swap_history));
+   memset(&draw->stats, 0, sizeof(draw->stats));
 
    switch (vblank_mode) {
    case DRI_CONF_VBLANK_NEVER:
@@ -199,6 +311,38 @@ loader_dri3_drawable_init(xcb_connection_t *conn,
    return 0;
 }
 
+/*
+ * Account a completed pixmap present in the drawable's timing statistics
+ */
+static void
+dri3_update_present_stats(struct loader_dri3_drawable *draw,
+                          const xcb_present_complete_notify_event_t *ce)
+{
+   unsigned slot = draw->recv_sbc % LOADER_DRI3_SWAP_HISTORY;
+   uint64_t latency;
+
+   /* Skipped or aborted presents don't tell us anything useful */
+   if (ce->mode == XCB_PRESENT_COMPLETE_MODE_SKIP)
+      return;
+
+   draw->stats.presents++;
+
+   if (draw->swap_history[slot].sbc != draw->recv_sbc)
+      return;
+
+   if (draw->swap_history[slot].ust && ce->ust > draw->swap_history[slot].ust) {
+      latency = ce->ust - draw->swap_history[slot].ust;
+      draw->stats.last_latency = latency;
+      draw->stats.total_latency += latency;
+      if (latency > draw->stats.max_latency)
+         draw->stats.max_latency = latency;
+   }
+
+   if (draw->swap_history[slot].target_msc &&
+       ce->msc > draw->swap_history[slot].target_msc)
+      draw->stats.missed_vblanks += ce->msc - draw->swap_history[slot].target_msc;
+}
+
 /*
  * Process one Present event
  */
@@ -236,6 +380,8 @@ dri3_handle_present_event(struct loader_dri3_drawable *draw,
          }
          dri3_update_num_back(draw);
 
+         dri3_update_present_stats(draw, ce);
+
          if (draw->vtable->show_fps)
             draw->vtable->show_fps(draw, ce->ust);
 
@@ -486,13 +632,14 @@ loader_dri3_copy_sub_buffer(struct loader_dri3_drawable *draw,
       /* Update the linear buffer part of the back buffer
        * for the dri3_copy_area operation
        */
-      draw->ext->image->blitImage(dri_context,
-                                  back->linear_buffer,
-                                  back->image,
-                                  0, 0, back->width,
-                                  back->height,
-                                  0, 0, back->width,
-                                  back->height, __BLIT_FLAG_FLUSH);
+      if (back->linear_buffer)
+         draw->ext->image->blitImage(dri_context,
+                                     back->linear_buffer,
+                                     back->image,
+                                     0, 0, back->width,
+                                     back->height,
+                                     0, 0, back->width,
+                                     back->height, __BLIT_FLAG_FLUSH);
       /* We use blitImage to update our fake front,
        */
       if (draw->have_fake_front)
@@ -561,7 +708,8 @@ loader_dri3_wait_x(struct loader_dri3_drawable *draw)
     * Copy back to the tiled buffer we use for rendering.
     * Note that we don't need flushing.
     */
-   if (draw->is_different_gpu && draw->vtable->in_current_context(draw))
+   if (draw->is_different_gpu && front->linear_buffer &&
+       draw->vtable->in_current_context(draw))
       draw->ext->image->blitImage(dri_context,
                                   front->image,
                                   front->linear_buffer,
@@ -586,7 +734,8 @@ loader_dri3_wait_gl(struct loader_dri3_drawable *draw)
    /* In the psc->is_different_gpu case, we update the linear_buffer
     * before updating the real front.
     */
-   if (draw->is_different_gpu && draw->vtable->in_current_context(draw))
+   if (draw->is_different_gpu && front->linear_buffer &&
+       draw->vtable->in_current_context(draw))
       draw->ext->image->blitImage(dri_context,
                                   front->linear_buffer,
                                   front->image,
@@ -627,6 +776,24 @@ loader_dri3_swap_buffers_msc(struct loader_dri3_drawable *draw,
                              int64_t target_msc, int64_t divisor,
                              int64_t remainder, unsigned flush_flags,
                              bool force_copy)
+{
+   return loader_dri3_swap_buffers_with_damage(draw, target_msc, divisor,
+                                               remainder, flush_flags,
+                                               force_copy, NULL, 0);
+}
+
+/** loader_dri3_swap_buffers_with_damage
+ *
+ * Like loader_dri3_swap_buffers_msc, with the rectangles (x, y, width,
+ * height, origin at the bottom left) that changed since the previous frame.
+ * No rectangles means the whole drawable changed.
+ */
+int64_t
+loader_dri3_swap_buffers_with_damage(struct loader_dri3_drawable *draw,
+                                     int64_t target_msc, int64_t divisor,
+                                     int64_t remainder, unsigned flush_flags,
+                                     bool force_copy,
+                                     const int *rects, int n_rects)
 {
    struct loader_dri3_buffer *back;
    __DRIcontext *dri_context;
@@ -642,13 +809,7 @@ loader_dri3_swap_buffers_msc(struct loader_dri3_drawable *draw,
    back = draw->buffers[LOADER_DRI3_BACK_ID(draw->cur_back)];
    if (draw->is_different_gpu && back) {
       /* Update the linear buffer before presenting the pixmap */
-      draw->ext->image->blitImage(dri_context,
-                                  back->linear_buffer,
-                                  back->image,
-                                  0, 0, back->width,
-                                  back->height,
-                                  0, 0, back->width,
-                                  back->height, __BLIT_FLAG_FLUSH);
+      dri3_update_linear_buffer(draw, dri_context, back, rects, n_rects);
       /* Update the fake front */
       if (draw->have_fake_front)
          draw->ext->image->blitImage(dri_context,
@@ -661,7 +822,19 @@ loader_dri3_swap_buffers_msc(struct loader_dri3_drawable *draw,
 
    dri3_flush_present_events(draw);
 
+   /* Keep the number of swaps queued to the server within the configured
+    * limit; a limit of 1 gives the lowest latency at the cost of throughput.
+    */
+   if (back && !draw->is_pixmap && draw->max_queued > 0) {
+      while (draw->send_sbc - draw->recv_sbc >= draw->max_queued) {
+         if (!dri3_wait_for_event(draw))
+            break;
+      }
+   }
+
    if (back && !draw->is_pixmap) {
+      unsigned slot;
+
       dri3_fence_reset(draw->conn, back);
 
       /* Compute when we want the frame shown by taking the last known
@@ -700,6 +873,12 @@ loader_dri3_swap_buffers_msc(struct loader_dri3_drawable *draw,
       if (force_copy)
           options |= XCB_PRESENT_OPTION_COPY;
 
+      slot = draw->send_sbc % LOADER_DRI3_SWAP_HISTORY;
+      draw->swap_history[slot].sbc = draw->send_sbc;
+      draw->swap_history[slot].ust = dri3_get_ust();
+      draw->swap_history[slot].target_msc =
+         (options & XCB_PRESENT_OPTION_ASYNC) || divisor ? 0 : target_msc;
+
       back->busy = 1;
       back->last_swap = draw->send_sbc;
       xcb_present_pixmap(draw->conn,
@@ -744,6 +923,19 @@ loader_dri3_swap_buffers_msc(struct loader_dri3_drawable *draw,
    return ret;
 }
 
+/** loader_dri3_get_present_stats
+ *
+ * Return the presentation timing statistics gathered so far, after
+ * processing any pending Present events.
+ */
+void
+loader_dri3_get_present_stats(struct loader_dri3_drawable *draw,
+                              struct loader_dri3_present_stats *stats)
+{
+   dri3_flush_present_events(draw);
+   *stats = draw->stats;
+}
+
 int
 loader_dri3_query_buffer_age(struct loader_dri3_drawable *draw)
 {
@@ -864,6 +1056,17 @@ dri3_alloc_render_buffer(struct loader_dri3_drawable *draw, unsigned int format,
 
       if (!buffer->image)
          goto no_image;
+   } else if (draw->prime_render_linear &&
+              (buffer->image =
+                  (draw->ext->image->createImage)(draw->dri_screen,
+                                                  width, height, format,
+                                                  __DRI_IMAGE_USE_SHARE |
+                                                     __DRI_IMAGE_USE_LINEAR,
+                                                  buffer))) {
+      /* The display GPU can use a linear buffer as is, so render into it
+       * directly and skip the per-frame copy.
+       */
+      pixmap_buffer = buffer->image;
    } else {
       buffer->image = (draw->ext->image->createImage)(draw->dri_screen,
                                                       width, height,
@@ -918,6 +1121,7 @@ dri3_alloc_render_buffer(struct loader_dri3_drawable *draw, unsigned int format,
    buffer->shm_fence = shm_fence;
    buffer->width = width;
    buffer->height = height;
+   dri3_damage_set_full(buffer->damage);
 
    /* Mark the buffer as idle
     */
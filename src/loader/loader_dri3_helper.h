@@ -68,6 +68,11 @@ struct loader_dri3_buffer {
    uint32_t     width, height;
    uint64_t     last_swap;
 
+   /* Box (x1, y1, x2, y2) of the image that changed since the linear
+    * buffer was last updated, for the is_different_gpu case
+    */
+   int          damage[4];
+
    enum loader_dri3_buffer_type        buffer_type;
 };
 
@@ -109,6 +114,21 @@ struct loader_dri3_vtable {
 
 #define LOADER_DRI3_NUM_BUFFERS (1 + LOADER_DRI3_MAX_BACK)
 
+/* Number of in-flight swaps we remember submission data for */
+#define LOADER_DRI3_SWAP_HISTORY 16
+
+/* Presentation timing gathered from PresentCompleteNotify events.
+ * Latencies are in UST units (microseconds), measured from the
+ * PresentPixmap request to the completion reported by the server.
+ */
+struct loader_dri3_present_stats {
+   uint64_t presents;           /* completed pixmap presents */
+   uint64_t last_latency;
+   uint64_t max_latency;
+   uint64_t total_latency;
+   uint64_t missed_vblanks;     /* frames shown after their target MSC */
+};
+
 struct loader_dri3_drawable {
    xcb_connection_t *conn;
    __DRIdrawable *dri_drawable;
@@ -124,6 +144,8 @@ struct loader_dri3_drawable {
    /* Information about the GPU owning the buffer */
    __DRIscreen *dri_screen;
    bool is_different_gpu;
+   /* Render into the shared linear buffer rather than blitting to it */
+   bool prime_render_linear;
 
    /* Present extension capabilities
     */
@@ -138,6 +160,18 @@ struct loader_dri3_drawable {
    /* Last received UST/MSC values for pixmap present complete */
    uint64_t ust, msc;
 
+   /* Maximum number of swaps queued to the server, 0 means no limit */
+   int max_queued;
+
+   /* Submission UST and target MSC of recent swaps, indexed by SBC */
+   struct {
+      uint64_t sbc;
+      uint64_t ust;
+      uint64_t target_msc;
+   } swap_history[LOADER_DRI3_SWAP_HISTORY];
+
+   struct loader_dri3_present_stats stats;
+
    /* Last received UST/MSC values from present notify msc event */
    uint64_t notify_ust, notify_msc;
 
@@ -189,6 +223,13 @@ loader_dri3_swap_buffers_msc(struct loader_dri3_drawable *draw,
                              int64_t remainder, unsigned flush_flags,
                              bool force_copy);
 
+int64_t
+loader_dri3_swap_buffers_with_damage(struct loader_dri3_drawable *draw,
+                                     int64_t target_msc, int64_t divisor,
+                                     int64_t remainder, unsigned flush_flags,
+                                     bool force_copy,
+                                     const int *rects, int n_rects);
+
 int
 loader_dri3_wait_for_sbc(struct loader_dri3_drawable *draw,
                          int64_t target_sbc, int64_t *ust,
@@ -196,6 +237,10 @@ loader_dri3_wait_for_sbc(struct loader_dri3_drawable *draw,
 
 int loader_dri3_query_buffer_age(struct loader_dri3_drawable *draw);
 
+void
+loader_dri3_get_present_stats(struct loader_dri3_drawable *draw,
+                              struct loader_dri3_present_stats *stats);
+
 void
 loader_dri3_flush(struct loader_dri3_drawable *draw,
                   unsigned flags,
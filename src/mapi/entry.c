@@ -49,6 +49,8 @@
 #   endif
 #elif defined(USE_X86_64_ASM) && defined(__GNUC__) && defined(GLX_USE_TLS)
 #   include "entry_x86-64_tls.h"
+#elif defined(USE_AARCH64_ASM) && defined(__GNUC__) && defined(GLX_USE_TLS)
+#   include "entry_aarch64_tls.h"
 #else
 
 #include <stdlib.h>
@@ -0,0 +1,112 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+
+__asm__(".text\n"
+        ".balign 32\n"
+        "aarch64_entry_start:");
+
+#define STUB_ASM_ENTRY(func)                             \
+   ".globl " func "\n"                                   \
+   ".type " func ", %function\n"                         \
+   ".balign 32\n"                                        \
+   func ":"
+
+/*
+ * x16/x17 are the intra-procedure-call scratch registers, so the stubs can
+ * use them freely without touching any argument register.
+ */
+#define STUB_ASM_CODE(slot)                                          \
+   "adrp x16, :gottprel:" ENTRY_CURRENT_TABLE "\n\t"                  \
+   "ldr x16, [x16, #:gottprel_lo12:" ENTRY_CURRENT_TABLE "]\n\t"      \
+   "mrs x17, tpidr_el0\n\t"                                          \
+   "ldr x16, [x17, x16]\n\t"                                         \
+   "ldr x16, [x16, #(8 * " slot ")]\n\t"                             \
+   "br x16"
+
+#define MAPI_TMP_STUB_ASM_GCC
+#include "mapi_tmp.h"
+
+#ifndef MAPI_MODE_BRIDGE
+
+#include <string.h>
+#include "u_execmem.h"
+
+void
+entry_patch_public(void)
+{
+}
+
+static char
+aarch64_entry_start[];
+
+mapi_func
+entry_get_public(int slot)
+{
+   return (mapi_func) (aarch64_entry_start + slot * 32);
+}
+
+void
+entry_patch(mapi_func entry, int slot)
+{
+   char *code = (char *) entry;
+
+   /* ldr x16, [x16, #(8 * slot)] */
+   *((unsigned int *) (code + 12)) = 0xf9400210 | (slot << 10);
+   __builtin___clear_cache(code, code + 32);
+}
+
+mapi_func
+entry_generate(int slot)
+{
+   const unsigned int code_templ[8] = {
+      0xd53bd051, /* mrs x17, tpidr_el0 */
+      0x580000b0, /* ldr x16, <tp offset below> */
+      0xf8706a30, /* ldr x16, [x17, x16] */
+      0xf9400210, /* ldr x16, [x16, #(8 * slot)] */
+      0xd61f0200, /* br x16 */
+      0xd503201f, /* nop */
+      0x00000000, /* tp offset of the current table, low */
+      0x00000000, /* tp offset of the current table, high */
+   };
+   unsigned long addr;
+   char *code;
+   mapi_func entry;
+
+   __asm__("adrp %0, :gottprel:" ENTRY_CURRENT_TABLE "\n\t"
+           "ldr %0, [%0, #:gottprel_lo12:" ENTRY_CURRENT_TABLE "]"
+           : "=r" (addr));
+
+   code = u_execmem_alloc(sizeof(code_templ));
+   if (!code)
+      return NULL;
+
+   memcpy(code, code_templ, sizeof(code_templ));
+
+   *((unsigned long *) (code + 24)) = addr;
+   entry = (mapi_func) code;
+   entry_patch(entry, slot);
+
+   return entry;
+}
+
+#endif /* MAPI_MODE_BRIDGE */
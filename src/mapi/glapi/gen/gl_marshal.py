@@ -0,0 +1,252 @@
+#!/usr/bin/env python
+
+# Copyright (C) 2012 Intel Corporation
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice (including the next
+# paragraph) shall be included in all copies or substantial portions of the
+# Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+
+# This script generates the file marshal_generated.c, which contains the
+# command marshalling and unmarshalling functions used by glthread (see
+# src/mesa/main/glthread.c), along with _mesa_create_marshal_table().
+#
+# Every function whose parameters can be copied by value (including
+# pointers to a fixed number of input elements) and which returns nothing
+# is marshalled asynchronously into the current command batch.  All other
+# functions synchronize with the worker thread and are then executed
+# directly on the calling thread.
+
+import argparse
+import license
+import gl_XML
+
+
+header = """/**
+ * \\file marshal_generated.c
+ * Marshalling and unmarshalling of GL commands for glthread.
+ */
+
+
+#include "main/context.h"
+#include "main/dispatch.h"
+#include "main/glthread.h"
+#include "main/marshal.h"
+
+#include <string.h>
+"""
+
+
+# Functions that return no data to the application, but still have to be
+# executed synchronously.
+sync_functions = frozenset([
+    # glFinish has to block until all previous commands have completed.
+    'Finish',
+])
+
+# Functions that are marshalled asynchronously, but after which the current
+# batch is submitted right away rather than when it is full.
+flush_functions = frozenset([
+    'Flush',
+])
+
+
+def is_fixed_param(p):
+    """Return true if the parameter can be copied into a command."""
+    if p.is_padding:
+        return True
+    if not p.is_pointer():
+        return True
+    return (not p.is_output and not p.is_image() and
+            not p.is_variable_length() and p.count > 0 and
+            p.get_base_type_string() not in ('void', 'GLvoid'))
+
+
+def marshal_async(f):
+    if f.return_type != 'void' or f.name in sync_functions:
+        return False
+    for p in f.parameterIterator():
+        if not is_fixed_param(p):
+            return False
+    return True
+
+
+class PrintCode(gl_XML.gl_print_base):
+    def __init__(self):
+        gl_XML.gl_print_base.__init__(self)
+
+        self.name = 'gl_marshal.py'
+        self.license = license.bsd_license_template % (
+            'Copyright (C) 2012 Intel Corporation', 'INTEL CORPORATION')
+
+    def printRealHeader(self):
+        print header
+        print ''
+
+    def printRealFooter(self):
+        pass
+
+    def print_async_struct(self, f):
+        print 'struct marshal_cmd_{0}'.format(f.name)
+        print '{'
+        print '   struct marshal_cmd_base cmd_base;'
+        for p in f.parameterIterator():
+            if p.is_padding:
+                continue
+            if p.is_pointer():
+                print '   {0} {1}[{2}];'.format(
+                    p.get_base_type_string(), p.name,
+                    p.type_expr.get_element_count())
+            else:
+                print '   {0} {1};'.format(p.type_string(), p.name)
+        print '};'
+
+    def print_unmarshal_func(self, f):
+        args = []
+        for p in f.parameterIterator():
+            if p.is_padding:
+                continue
+            if p.is_pointer():
+                args.append('({0}) cmd->{1}'.format(p.type_string(), p.name))
+            else:
+                args.append('cmd->{0}'.format(p.name))
+        print 'static inline void'
+        print ('_mesa_unmarshal_{0}(struct gl_context *ctx, '
+               'const struct marshal_cmd_{0} *cmd)').format(f.name)
+        print '{'
+        print '   CALL_{0}(ctx->CurrentDispatch, ({1}));'.format(
+            f.name, ', '.join(args))
+        print '}'
+
+    def print_async_marshal(self, f):
+        print 'static void GLAPIENTRY'
+        print '_mesa_marshal_{0}({1})'.format(
+            f.name, f.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+        print '   struct marshal_cmd_{0} *cmd;'.format(f.name)
+        print '   cmd = _mesa_glthread_allocate_command(ctx, DISPATCH_CMD_{0},'.format(f.name)
+        print '                                         sizeof(*cmd));'
+        for p in f.parameterIterator():
+            if p.is_padding:
+                continue
+            if p.is_pointer():
+                print '   memcpy(cmd->{0}, {0}, {1});'.format(
+                    p.name, p.size_string())
+            else:
+                print '   cmd->{0} = {0};'.format(p.name)
+        if f.name in flush_functions:
+            print '   _mesa_glthread_flush_batch(ctx);'
+        print '}'
+
+    def print_sync_marshal(self, f):
+        print 'static {0} GLAPIENTRY'.format(f.return_type)
+        print '_mesa_marshal_{0}({1})'.format(
+            f.name, f.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+        print '   _mesa_glthread_finish(ctx);'
+        call = 'CALL_{0}(ctx->CurrentDispatch, ({1}));'.format(
+            f.name, f.get_called_parameter_string())
+        if f.return_type == 'void':
+            print '   {0}'.format(call)
+        else:
+            print '   return {0}'.format(call)
+        print '}'
+
+    def printBody(self, api):
+        async_funcs = []
+        all_funcs = []
+        for f in api.functionIterateByOffset():
+            all_funcs.append(f)
+            if marshal_async(f):
+                async_funcs.append(f)
+
+        print 'enum marshal_dispatch_cmd_id'
+        print '{'
+        for f in async_funcs:
+            print '   DISPATCH_CMD_{0},'.format(f.name)
+        print '};'
+        print ''
+
+        for f in all_funcs:
+            print '/* {0}: marshalled {1} */'.format(
+                f.name, 'asynchronously' if f in async_funcs else 'synchronously')
+            if f in async_funcs:
+                self.print_async_struct(f)
+                self.print_unmarshal_func(f)
+                self.print_async_marshal(f)
+            else:
+                self.print_sync_marshal(f)
+            print ''
+            print ''
+
+        print 'size_t'
+        print '_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx, const void *cmd)'
+        print '{'
+        print '   const struct marshal_cmd_base *cmd_base = cmd;'
+        print '   switch (cmd_base->cmd_id) {'
+        for f in async_funcs:
+            print '   case DISPATCH_CMD_{0}:'.format(f.name)
+            print '      _mesa_unmarshal_{0}(ctx, (const struct marshal_cmd_{0} *) cmd);'.format(f.name)
+            print '      break;'
+        print '   default:'
+        print '      assert(!"Unrecognized command ID");'
+        print '      break;'
+        print '   }'
+        print ''
+        print '   return cmd_base->cmd_size;'
+        print '}'
+        print ''
+        print ''
+
+        print 'struct _glapi_table *'
+        print '_mesa_create_marshal_table(const struct gl_context *ctx)'
+        print '{'
+        print '   struct _glapi_table *table;'
+        print ''
+        print '   table = _mesa_alloc_dispatch_table();'
+        print '   if (table == NULL)'
+        print '      return NULL;'
+        print ''
+        for f in all_funcs:
+            print '   SET_{0}(table, _mesa_marshal_{0});'.format(f.name)
+        print ''
+        print '   return table;'
+        print '}'
+
+
+def _parser():
+    """Parse arguments and return namespace."""
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-f',
+                        dest='filename',
+                        default='gl_and_es_API.xml',
+                        help='an xml file describing an API')
+    return parser.parse_args()
+
+
+def main():
+    """Main function."""
+    args = _parser()
+    printer = PrintCode()
+    api = gl_XML.parse_GL_API(args.filename)
+    printer.Print(api)
+
+
+if __name__ == '__main__':
+    main()
@@ -32,6 +32,55 @@ import gl_XML
 import glX_XML
 
 
+def proc_hash(name, seed):
+    """Python twin of static_proc_hash() in the generated header."""
+    h = (2166136261 ^ seed) & 0xffffffff
+    for c in name:
+        h ^= ord(c)
+        h = (h * 16777619) & 0xffffffff
+    return h
+
+
+def build_perfect_hash(names):
+    """Build a hash-and-displace perfect hash over the given names.
+
+    Each name first picks a bucket with seed 0.  Buckets are then placed
+    largest first by searching for a displacement seed that sends all of
+    their names to free slots of the final table.  Returns the bucket
+    displacements and the slot table, which holds index + 1 of the name
+    or 0 for an empty slot.
+    """
+    size = 1
+    while size < len(names) * 2:
+        size *= 2
+    num_buckets = size // 4
+
+    buckets = [[] for i in range(num_buckets)]
+    for i, name in enumerate(names):
+        buckets[proc_hash(name, 0) & (num_buckets - 1)].append(i)
+
+    disp = [0] * num_buckets
+    slots = [0] * size
+    order = sorted(range(num_buckets), key=lambda b: -len(buckets[b]))
+    for b in order:
+        if not buckets[b]:
+            break
+        seed = 1
+        while True:
+            placed = [proc_hash(names[i], seed) & (size - 1)
+                      for i in buckets[b]]
+            if len(set(placed)) == len(placed) and \
+               all(slots[s] == 0 for s in placed):
+                break
+            seed += 1
+            assert seed < 0x10000
+        disp[b] = seed
+        for i, s in zip(buckets[b], placed):
+            slots[s] = i + 1
+
+    return disp, slots
+
+
 class PrintGlProcs(gl_XML.gl_print_base):
     def __init__(self, es=False):
         gl_XML.gl_print_base.__init__(self)
@@ -66,6 +115,21 @@ typedef struct {
 #  define NAME_FUNC_OFFSET(n,f1,f2,f3,o) { n , (_glapi_proc) f3 , o }
 #endif
 
+/**
+ * FNV-1a with the seed folded into the offset basis.  Must match
+ * proc_hash() in gl_procs.py.
+ */
+static inline GLuint
+static_proc_hash(const char *name, GLuint seed)
+{
+    GLuint h = 2166136261u ^ seed;
+    while (*name) {
+        h ^= (unsigned char) *name++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
 """
         return
 
@@ -83,10 +147,12 @@ typedef struct {
 
         base_offset = 0
         table = []
+        names = []
         for func in api.functionIterateByOffset():
             name = func.dispatch_name()
             self.printFunctionString(func.name)
             table.append((base_offset, "gl" + name, "gl" + name, "NULL", func.offset))
+            names.append("gl" + func.name)
 
             # The length of the function's name, plus 2 for "gl",
             # plus 1 for the NUL.
@@ -106,6 +172,7 @@ typedef struct {
                     else:
                         table.append((base_offset, "gl" + name, "gl" + name, "NULL", func.offset))
 
+                    names.append("gl" + n)
                     base_offset += len(n) + 3
 
 
@@ -160,8 +227,31 @@ typedef struct {
 
         print '    NAME_FUNC_OFFSET(-1, NULL, NULL, NULL, 0)'
         print '};'
+
+        self.printPerfectHash(names)
         return
 
+    def printPerfectHash(self, names):
+        disp, slots = build_perfect_hash(names)
+
+        print ''
+        print '/* Perfect hash of the names in static_functions[].  A name hashed'
+        print ' * with seed 0 selects a displacement, and hashing it again with that'
+        print ' * displacement gives its slot.  Slots hold index + 1, 0 is empty.'
+        print ' */'
+        print '#define STATIC_FUNCTIONS_HASH_BUCKETS %u' % len(disp)
+        print '#define STATIC_FUNCTIONS_HASH_SIZE %u' % len(slots)
+        print ''
+        print 'static const GLushort static_functions_hash_disp[] = {'
+        for i in range(0, len(disp), 12):
+            print '   ' + ''.join(' %5u,' % d for d in disp[i:i + 12])
+        print '};'
+        print ''
+        print 'static const GLushort static_functions_hash[] = {'
+        for i in range(0, len(slots), 12):
+            print '   ' + ''.join(' %5u,' % d for d in slots[i:i + 12])
+        print '};'
+
 
 def _parser():
     """Parse arguments and return a namepsace."""
@@ -53,26 +53,30 @@
 
 
 /**
- * Search the table of static entrypoint functions for the named function
- * and return the corresponding glprocs_table_t entry.
+ * Look up the named function in the generated perfect hash of static
+ * entrypoint functions and return the corresponding glprocs_table_t entry.
  */
 static const glprocs_table_t *
 get_static_proc( const char * n )
 {
-   GLuint i;
-   for (i = 0; static_functions[i].Name_offset >= 0; i++) {
-      const char *testName = gl_string_table + static_functions[i].Name_offset;
+   GLuint bucket, slot, index;
+
 #ifdef MANGLE
-      /* skip the prefix on the name */
-      if (strcmp(testName, n + 1) == 0)
-#else
-      if (strcmp(testName, n) == 0)
+   /* skip the prefix on the name */
+   n++;
 #endif
-      {
-	 return &static_functions[i];
-      }
-   }
-   return NULL;
+
+   bucket = static_proc_hash(n, 0) & (STATIC_FUNCTIONS_HASH_BUCKETS - 1);
+   slot = static_proc_hash(n, static_functions_hash_disp[bucket]) &
+          (STATIC_FUNCTIONS_HASH_SIZE - 1);
+   index = static_functions_hash[slot];
+   if (index == 0)
+      return NULL;
+
+   if (strcmp(gl_string_table + static_functions[index - 1].Name_offset, n) != 0)
+      return NULL;
+
+   return &static_functions[index - 1];
 }
 
 
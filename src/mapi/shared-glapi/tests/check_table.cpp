@@ -22,6 +22,9 @@
  */
 
 #include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 #include "../../../mesa/main/glheader.h"
 
 #include "glapi/glapi.h"
@@ -56,6 +59,50 @@ TEST(GetProcAddress, TableBigEnoughForABI)
    EXPECT_LT(408u, _glapi_get_dispatch_table_size());
 }
 
+static unsigned flush_calls;
+
+static void GLAPIENTRY
+count_flush(void)
+{
+   flush_calls++;
+}
+
+TEST(Dispatch, PublicEntryReachesCurrentTable)
+{
+   /* Call through the public glFlush entry point enough times to give a
+    * rough per-call cost of the dispatch stubs.
+    */
+   const unsigned iterations = 1000000;
+   const unsigned size = _glapi_get_dispatch_table_size();
+   _glapi_proc *table = (_glapi_proc *) calloc(size, sizeof(_glapi_proc));
+   int offset = _glapi_get_proc_offset("glFlush");
+   void (GLAPIENTRY *flush)(void) =
+      (void (GLAPIENTRY *)(void)) _glapi_get_proc_address("glFlush");
+   struct timespec start, end;
+
+   ASSERT_NE((void *) NULL, table);
+   ASSERT_LE(0, offset);
+   ASSERT_NE((void *) NULL, (void *) flush);
+
+   table[offset] = (_glapi_proc) count_flush;
+   _glapi_set_dispatch((struct _glapi_table *) table);
+
+   flush_calls = 0;
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   for (unsigned i = 0; i < iterations; i++)
+      flush();
+   clock_gettime(CLOCK_MONOTONIC, &end);
+
+   _glapi_set_dispatch(NULL);
+   free(table);
+
+   EXPECT_EQ(iterations, flush_calls);
+
+   double ns = (end.tv_sec - start.tv_sec) * 1e9 +
+               (end.tv_nsec - start.tv_nsec);
+   printf("glFlush dispatch: %.2f ns/call\n", ns / iterations);
+}
+
 const struct name_offset linux_gl_abi[] = {
    { "glNewList", 0 },
    { "glEndList", 1 },
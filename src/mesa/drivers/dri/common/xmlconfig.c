@@ -36,6 +36,7 @@
 #include <math.h>
 #include <unistd.h>
 #include <errno.h>
+#include "c11/threads.h"
 #include "main/imports.h"
 #include "utils.h"
 #include "xmlconfig.h"
@@ -691,12 +692,97 @@ static void optInfoEndElem (void *userData, const XML_Char *name) {
     }
 }
 
+/** \brief Number of parsed option descriptions kept around
+ *
+ * A process typically sees the common dri2 options, the loader options and
+ * the options of one driver.  Every screen and every display
+ * initialization parses the same XML again, which is dominated by the
+ * translated descriptions, so keep the results for the process lifetime. */
+#define OPTION_INFO_CACHE_SIZE 4
+
+static struct {
+    char *configOptions;
+    driOptionCache info;
+} optionInfoCache[OPTION_INFO_CACHE_SIZE];
+static uint32_t optionInfoCacheCount;
+static mtx_t optionInfoCacheMutex = _MTX_INITIALIZER_NP;
+
+/** \brief Deep copy of the option info and default values in src */
+static void copyOptionInfo (driOptionCache *dst, const driOptionCache *src) {
+    uint32_t i, size = 1 << src->tableSize;
+
+    dst->tableSize = src->tableSize;
+    dst->info = calloc(size, sizeof (driOptionInfo));
+    dst->values = malloc(size * sizeof (driOptionValue));
+    if (dst->info == NULL || dst->values == NULL) {
+	fprintf (stderr, "%s: %d: out of memory.\n", __FILE__, __LINE__);
+	abort();
+    }
+    memcpy (dst->values, src->values, size * sizeof (driOptionValue));
+
+    for (i = 0; i < size; ++i) {
+	if (!src->info[i].name)
+	    continue;
+	XSTRDUP(dst->info[i].name, src->info[i].name);
+	dst->info[i].type = src->info[i].type;
+	dst->info[i].nRanges = src->info[i].nRanges;
+	if (src->info[i].nRanges) {
+	    dst->info[i].ranges =
+		malloc(src->info[i].nRanges * sizeof (driOptionRange));
+	    if (dst->info[i].ranges == NULL) {
+		fprintf (stderr, "%s: %d: out of memory.\n", __FILE__, __LINE__);
+		abort();
+	    }
+	    memcpy (dst->info[i].ranges, src->info[i].ranges,
+		    src->info[i].nRanges * sizeof (driOptionRange));
+	}
+	if (src->info[i].type == DRI_STRING)
+	    XSTRDUP(dst->values[i]._string, src->values[i]._string);
+    }
+}
+
+/** \brief Look up configOptions in the option info cache
+ *
+ * Returns true and fills in info if it was parsed before. */
+static bool lookupOptionInfo (driOptionCache *info, const char *configOptions) {
+    uint32_t i;
+    bool found = false;
+
+    mtx_lock(&optionInfoCacheMutex);
+    for (i = 0; i < optionInfoCacheCount; ++i) {
+	if (!strcmp (optionInfoCache[i].configOptions, configOptions)) {
+	    copyOptionInfo (info, &optionInfoCache[i].info);
+	    found = true;
+	    break;
+	}
+    }
+    mtx_unlock(&optionInfoCacheMutex);
+
+    return found;
+}
+
+/** \brief Add a freshly parsed option info to the cache if there is room */
+static void cacheOptionInfo (const driOptionCache *info,
+			     const char *configOptions) {
+    mtx_lock(&optionInfoCacheMutex);
+    if (optionInfoCacheCount < OPTION_INFO_CACHE_SIZE) {
+	XSTRDUP(optionInfoCache[optionInfoCacheCount].configOptions,
+		configOptions);
+	copyOptionInfo (&optionInfoCache[optionInfoCacheCount].info, info);
+	optionInfoCacheCount++;
+    }
+    mtx_unlock(&optionInfoCacheMutex);
+}
+
 void driParseOptionInfo (driOptionCache *info, const char *configOptions) {
     XML_Parser p;
     int status;
     struct OptInfoData userData;
     struct OptInfoData *data = &userData;
 
+    if (lookupOptionInfo (info, configOptions))
+	return;
+
     /* Make the hash table big enough to fit more than the maximum number of
      * config options we've ever seen in a driver.
      */
@@ -727,6 +813,8 @@ void driParseOptionInfo (driOptionCache *info, const char *configOptions) {
 	XML_FATAL ("%s.", XML_ErrorString(XML_GetErrorCode(p)));
 
     XML_ParserFree (p);
+
+    cacheOptionInfo (info, configOptions);
 }
 
 /** \brief Parser context for configuration files. */
@@ -269,6 +269,31 @@ DRI_CONF_OPT_BEGIN_V(vblank_mode,enum,def,"0:3") \
         DRI_CONF_DESC_END \
 DRI_CONF_OPT_END
 
+#define DRI_CONF_MAX_QUEUED_FRAMES(def) \
+DRI_CONF_OPT_BEGIN_V(max_queued_frames,int,def,"0:16") \
+        DRI_CONF_DESC(en,gettext("Maximum number of frames queued for presentation, 0 means no limit")) \
+DRI_CONF_OPT_END
+
+#define DRI_CONF_PRIME_RENDER_LINEAR(def) \
+DRI_CONF_OPT_BEGIN_B(prime_render_linear, def) \
+        DRI_CONF_DESC(en,gettext("With render offload, render directly into the linear buffer shared with the display GPU instead of copying to it")) \
+DRI_CONF_OPT_END
+
+#define DRI_CONF_WL_COLOR_BUFFERS(def) \
+DRI_CONF_OPT_BEGIN_V(wl_color_buffers,int,def,"2:8") \
+        DRI_CONF_DESC(en,gettext("Maximum number of color buffers of a Wayland EGL surface")) \
+DRI_CONF_OPT_END
+
+#define DRI_CONF_MESA_GLTHREAD(def) \
+DRI_CONF_OPT_BEGIN_B(mesa_glthread, def) \
+        DRI_CONF_DESC(en,gettext("Enable offloading GL driver work to a separate thread")) \
+DRI_CONF_OPT_END
+
+#define DRI_CONF_MAX_FRAMES_IN_FLIGHT(def) \
+DRI_CONF_OPT_BEGIN_V(max_frames_in_flight, int, def, "-1:4") \
+        DRI_CONF_DESC(en,gettext("Maximum number of frames the CPU may queue ahead of the GPU, -1 for the driver default, 0 for no limit")) \
+DRI_CONF_OPT_END
+
 #define DRI_CONF_HYPERZ_DISABLED 0
 #define DRI_CONF_HYPERZ_ENABLED 1
 #define DRI_CONF_HYPERZ(def) \
@@ -49,7 +49,16 @@ LOCAL_C_INCLUDES := \
 
 LOCAL_SRC_FILES := \
 	$(i965_compiler_FILES) \
-	$(i965_FILES)
+	$(i965_FILES) \
+	$(i965_TILED_MEMCPY_FILES)
+
+# The whole module is built for the target's instruction set, so the SSE4.1
+# walkers can only be added when the target has it anyway.  There is no
+# AVX2 build on Android.
+ifeq ($(ARCH_X86_HAVE_SSE4_1),true)
+LOCAL_SRC_FILES += \
+	$(i965_TILED_MEMCPY_SSE41_FILES)
+endif
 
 LOCAL_WHOLE_STATIC_LIBRARIES := \
 	$(MESA_DRI_WHOLE_STATIC_LIBRARIES)
@@ -276,6 +276,7 @@ retry:
     * rendering tracks for GL.
     */
    brw->ctx.NewDriverState = ~0ull;
+   intel_batchbuffer_forget_packets(brw);
    brw->no_depth_or_stencil = false;
    brw->ib.type = -1;
 
@@ -70,10 +70,31 @@ brw_blorp_blit_miptrees(struct brw_context *brw,
     * the destination buffer because we use the standard render path to render
     * to destination color buffers, and the standard render path is
     * fast-color-aware.
+    *
+    * Only the part of the source the blit reads gets color resolved, with a
+    * pixel of slack for bilinear filtering.  A destination slice that gets
+    * entirely overwritten doesn't need its depth resolved first.
     */
-   intel_miptree_resolve_color(brw, src_mt);
+   const unsigned src_slack = filter == GL_LINEAR ? 1 : 0;
+   const float src_min_x = MIN2(src_x0, src_x1) - src_slack;
+   const float src_min_y = MIN2(src_y0, src_y1) - src_slack;
+   intel_miptree_resolve_color_rect(brw, src_mt,
+                                    src_min_x > 0 ? (uint32_t) src_min_x : 0,
+                                    src_min_y > 0 ? (uint32_t) src_min_y : 0,
+                                    ceilf(MAX2(src_x0, src_x1)) + src_slack,
+                                    ceilf(MAX2(src_y0, src_y1)) + src_slack);
    intel_miptree_slice_resolve_depth(brw, src_mt, src_level, src_layer);
-   intel_miptree_slice_resolve_depth(brw, dst_mt, dst_level, dst_layer);
+
+   const unsigned dst_width =
+      minify(dst_mt->logical_width0, dst_level - dst_mt->first_level);
+   const unsigned dst_height =
+      minify(dst_mt->logical_height0, dst_level - dst_mt->first_level);
+   if (MIN2(dst_x0, dst_x1) <= 0 && MIN2(dst_y0, dst_y1) <= 0 &&
+       MAX2(dst_x0, dst_x1) >= dst_width &&
+       MAX2(dst_y0, dst_y1) >= dst_height)
+      intel_miptree_slice_discard_depth_resolve(dst_mt, dst_level, dst_layer);
+   else
+      intel_miptree_slice_resolve_depth(brw, dst_mt, dst_level, dst_layer);
 
    DBG("%s from %dx %s mt %p %d %d (%f,%f) (%f,%f)"
        "to %dx %s mt %p %d %d (%f,%f) (%f,%f) (flip %d,%d)\n",
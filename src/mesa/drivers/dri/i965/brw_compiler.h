@@ -751,6 +751,10 @@ brw_compile_gs(const struct brw_compiler *compiler, void *log_data,
 /**
  * Compile a fragment shader.
  *
+ * If \p allow_simd16 is false, only the SIMD8 program is built, so that the
+ * caller can get a usable program quickly and compile the SIMD16 one later.
+ * \p use_rep_send needs SIMD16 and so requires \p allow_simd16.
+ *
  * Returns the final assembly and the program's size.
  */
 const unsigned *
@@ -763,6 +767,7 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
                int shader_time_index8,
                int shader_time_index16,
                bool use_rep_send,
+               bool allow_simd16,
                unsigned *final_assembly_size,
                char **error_str);
 
@@ -54,6 +54,7 @@
 #include "brw_compiler.h"
 #include "brw_draw.h"
 #include "brw_state.h"
+#include "brw_wm.h"
 
 #include "intel_batchbuffer.h"
 #include "intel_buffer_objects.h"
@@ -773,7 +774,8 @@ brwCreateContext(gl_api api,
     * provides us with context reset notifications.
     */
    uint32_t allowed_flags = __DRI_CTX_FLAG_DEBUG
-      | __DRI_CTX_FLAG_FORWARD_COMPATIBLE;
+      | __DRI_CTX_FLAG_FORWARD_COMPATIBLE
+      | __DRI_CTX_FLAG_NO_ERROR;
 
    if (screen->has_context_reset_notification)
       allowed_flags |= __DRI_CTX_FLAG_ROBUST_BUFFER_ACCESS;
@@ -962,6 +964,8 @@ brwCreateContext(gl_api api,
       (env_var_as_boolean("INTEL_USE_HW_BT", false) ||
        env_var_as_boolean("INTEL_USE_GATHER", false));
 
+   brw->async_simd16 = env_var_as_boolean("INTEL_ASYNC_SIMD16", true);
+
    ctx->VertexProgram._MaintainTnlProgram = true;
    ctx->FragmentProgram._MaintainTexEnvProgram = true;
 
@@ -978,6 +982,9 @@ brwCreateContext(gl_api api,
    if (INTEL_DEBUG & DEBUG_SHADER_TIME)
       brw_init_shader_time(brw);
 
+   if (INTEL_DEBUG & DEBUG_DRAW_TIME)
+      brw_init_draw_time(brw);
+
    _mesa_compute_version(ctx);
 
    _mesa_initialize_dispatch_tables(ctx);
@@ -1017,6 +1024,11 @@ intelDestroyContext(__DRIcontext * driContextPriv)
       brw_destroy_shader_time(brw);
    }
 
+   if (INTEL_DEBUG & DEBUG_DRAW_TIME)
+      brw_destroy_draw_time(brw);
+
+   brw_wm_async_destroy(brw);
+   brw_fini_performance_monitors(brw);
    brw_destroy_state(brw);
    brw_draw_destroy(brw);
 
@@ -548,6 +548,36 @@ struct brw_cache {
 struct brw_tracked_state {
    struct brw_state_flags dirty;
    void (*emit)( struct brw_context *brw );
+
+   /**
+    * Set if emit() only emits packets that no other atom emits, with no
+    * relocations or indirect state.  Emitting exactly the same dwords as
+    * the last time in the same batch then doesn't change anything, so they
+    * are dropped from the batch again (see intel_batchbuffer_repeats()).
+    */
+   bool dedup;
+};
+
+#define BRW_MAX_RENDER_ATOMS 76
+#define BRW_MAX_COMPUTE_ATOMS 10
+#define BRW_MAX_ATOMS (BRW_MAX_RENDER_ATOMS + BRW_MAX_COMPUTE_ATOMS)
+
+/**
+ * Counters for each state atom, for INTEL_DEBUG=packets.
+ */
+struct brw_atom_stats {
+   /** Number of times the atom was emitted, and the dwords it emitted. */
+   uint32_t emits;
+   uint64_t bytes;
+
+   /** Emissions identical to the previous one in the same batch. */
+   uint32_t repeated;
+
+   /** Repeated emissions which were dropped from the batch. */
+   uint32_t dropped;
+
+   /** Opcode of the first packet of the last emission. */
+   uint16_t opcode;
 };
 
 enum shader_time_shader_type {
@@ -620,6 +650,17 @@ struct intel_batchbuffer {
       uint32_t *map_next;
       int reloc_count;
    } saved;
+
+   /**
+    * The last dwords emitted by each state atom in this batch, indexed by
+    * the atom's slot (see intel_batchbuffer_repeats()).  A size of 0 means
+    * there are none.
+    */
+   struct {
+      uint32_t offset;
+      uint32_t size;
+      uint32_t hash;
+   } packets[BRW_MAX_ATOMS];
 };
 
 #define MAX_GS_INPUT_VERTICES 6
@@ -705,6 +746,7 @@ enum brw_predicate_state {
 };
 
 struct shader_times;
+struct brw_draw_time_entry;
 
 struct brw_l3_config;
 
@@ -835,6 +877,12 @@ struct brw_context
    bool disable_throttling;
    bool precompile;
 
+   /**
+    * Whether fragment shaders are compiled SIMD8 first, with the SIMD16
+    * program built on a worker thread (INTEL_ASYNC_SIMD16, on by default).
+    */
+   bool async_simd16;
+
    driOptionCache optionCache;
    /** @} */
 
@@ -1179,6 +1227,9 @@ struct brw_context
       uint32_t fast_clear_op;
 
       float offset_clamp;
+
+      /** Background SIMD16 compiles, NULL until the first one is queued. */
+      struct brw_wm_async *async;
    } wm;
 
    struct {
@@ -1244,11 +1295,26 @@ struct brw_context
 
       /** Number of 32-bit entries in a hardware counter snapshot. */
       int entries_per_oa_snapshot;
+
+      /** Whether oa_stream_fd is an open i915 perf stream for OA reports. */
+      bool oa_stream;
+      bool oa_stream_tried;
+      int oa_stream_fd;
+
+      /**
+       * Periodic OA reports read from the stream, oldest first, which are
+       * still needed to gather the results of unresolved monitors.
+       */
+      uint32_t *oa_samples;
+      int oa_sample_count;
    } perfmon;
 
    int num_atoms[BRW_NUM_PIPELINES];
-   const struct brw_tracked_state render_atoms[76];
-   const struct brw_tracked_state compute_atoms[10];
+   const struct brw_tracked_state render_atoms[BRW_MAX_RENDER_ATOMS];
+   const struct brw_tracked_state compute_atoms[BRW_MAX_COMPUTE_ATOMS];
+
+   /* If (INTEL_DEBUG & DEBUG_PACKETS), indexed like batch.packets */
+   struct brw_atom_stats *atom_stats;
 
    /* If (INTEL_DEBUG & DEBUG_BATCH) */
    struct {
@@ -1305,6 +1371,20 @@ struct brw_context
       double report_time;
    } shader_time;
 
+   struct {
+      /** Timestamp pairs of sampled draws, written to each buffer in turn. */
+      drm_intel_bo *bo[2];
+      unsigned num_samples[2];
+      unsigned *sample_entry[2];
+      int cur;
+      unsigned draw_count;
+      struct brw_draw_time_entry *entries;
+      unsigned num_entries;
+      unsigned max_entries;
+      unsigned last_entry;
+      double report_time;
+   } draw_time;
+
    struct brw_fast_clear_state *fast_clear_state;
 
    __DRIcontext *driContext;
@@ -1380,6 +1460,11 @@ void
 brw_meta_resolve_color(struct brw_context *brw,
                        struct intel_mipmap_tree *mt);
 void
+brw_meta_resolve_color_rect(struct brw_context *brw,
+                            struct intel_mipmap_tree *mt,
+                            unsigned x0, unsigned y0,
+                            unsigned x1, unsigned y1);
+void
 brw_meta_fast_clear_free(struct brw_context *brw);
 
 
@@ -1472,6 +1557,15 @@ int brw_get_shader_time_index(struct brw_context *brw,
 void brw_collect_and_report_shader_time(struct brw_context *brw);
 void brw_destroy_shader_time(struct brw_context *brw);
 
+/* brw_draw_time.c
+ */
+void brw_init_draw_time(struct brw_context *brw);
+bool brw_draw_time_sample(struct brw_context *brw);
+void brw_draw_time_emit(struct brw_context *brw, bool end);
+void brw_draw_time_commit(struct brw_context *brw);
+void brw_collect_and_report_draw_time(struct brw_context *brw);
+void brw_destroy_draw_time(struct brw_context *brw);
+
 /* brw_urb.c
  */
 void brw_upload_urb_fence(struct brw_context *brw);
@@ -1564,6 +1658,7 @@ mesa_format brw_lower_mesa_image_format(const struct brw_device_info *devinfo,
 
 /* brw_performance_monitor.c */
 void brw_init_performance_monitors(struct brw_context *brw);
+void brw_fini_performance_monitors(struct brw_context *brw);
 void brw_dump_perf_monitors(struct brw_context *brw);
 void brw_perf_monitor_new_batch(struct brw_context *brw);
 void brw_perf_monitor_finish_batch(struct brw_context *brw);
@@ -120,17 +120,30 @@ brw_codegen_cs_prog(struct brw_context *brw,
    if (INTEL_DEBUG & DEBUG_SHADER_TIME)
       st_index = brw_get_shader_time_index(brw, prog, &cp->program.Base, ST_CS);
 
-   char *error_str;
-   program = brw_compile_cs(brw->intelScreen->compiler, brw, mem_ctx,
-                            key, &prog_data, cp->program.Base.nir,
-                            st_index, &program_size, &error_str);
-   if (program == NULL) {
-      prog->LinkStatus = false;
-      ralloc_strcat(&prog->InfoLog, error_str);
-      _mesa_problem(NULL, "Failed to compile compute shader: %s\n", error_str);
+   struct brw_disk_cache_prog disk_cache;
+   if (!brw_disk_cache_load_prog(brw, mem_ctx, &disk_cache, BRW_CACHE_CS_PROG,
+                                 key, sizeof(*key),
+                                 offsetof(struct brw_cs_prog_key,
+                                          program_string_id),
+                                 prog->Comp.SharedSize, &cp->program.Base,
+                                 &prog_data.base, sizeof(prog_data),
+                                 &program, &program_size)) {
+      char *error_str;
+      program = brw_compile_cs(brw->intelScreen->compiler, brw, mem_ctx,
+                               key, &prog_data, cp->program.Base.nir,
+                               st_index, &program_size, &error_str);
+      if (program == NULL) {
+         prog->LinkStatus = false;
+         ralloc_strcat(&prog->InfoLog, error_str);
+         _mesa_problem(NULL, "Failed to compile compute shader: %s\n",
+                       error_str);
+
+         ralloc_free(mem_ctx);
+         return false;
+      }
 
-      ralloc_free(mem_ctx);
-      return false;
+      brw_disk_cache_store_prog(brw, &disk_cache, program, program_size,
+                                &prog_data.base, sizeof(prog_data));
    }
 
    if (unlikely(brw->perf_debug) && cs) {
@@ -466,6 +466,8 @@ brw_try_draw_prims(struct gl_context *ctx,
    for (i = 0; i < nr_prims; i++) {
       int estimated_max_prim_size;
       const int sampler_state_size = 16;
+      const bool timed = unlikely(INTEL_DEBUG & DEBUG_DRAW_TIME) &&
+                         brw_draw_time_sample(brw);
 
       estimated_max_prim_size = 512; /* batchbuffer commands */
       estimated_max_prim_size += BRW_MAX_TEX_UNIT *
@@ -528,8 +530,14 @@ retry:
 	 brw_upload_render_state(brw);
       }
 
+      if (timed)
+         brw_draw_time_emit(brw, false);
+
       brw_emit_prim(brw, &prims[i], brw->primitive);
 
+      if (timed)
+         brw_draw_time_emit(brw, true);
+
       brw->no_batch_wrap = false;
 
       if (dri_bufmgr_check_aperture_space(&brw->batch.bo, 1)) {
@@ -551,6 +559,9 @@ retry:
        */
       if (brw->ctx.NewDriverState)
          brw_render_state_finished(brw);
+
+      if (timed)
+         brw_draw_time_commit(brw);
    }
 
    if (brw->always_flush_batch)
@@ -0,0 +1,286 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ *
+ */
+
+/** @file brw_draw_time.c
+ *
+ * Sampled per-draw GPU timing (INTEL_DEBUG=draw_time).
+ *
+ * Unlike shader_time, shaders are not instrumented.  Instead, one draw out
+ * of every DRAW_TIME_INTERVAL is bracketed by a pipeline flush and a read
+ * of the TIMESTAMP register, and its duration is charged to the bound
+ * programs and draw framebuffer.  The other draws run untouched, so the
+ * cost stays low enough to profile release builds on real workloads.
+ *
+ * Results are written to two buffers used in turn, and a buffer is only
+ * read back once the GPU is done with it, so collecting never stalls in
+ * the common case.
+ */
+
+#include "util/ralloc.h"
+
+#include "brw_context.h"
+#include "intel_batchbuffer.h"
+#include "intel_reg.h"
+
+#define DRAW_TIME_INTERVAL 32
+#define DRAW_TIME_MAX_SAMPLES 512
+
+struct brw_draw_time_key {
+   /** Names of the bound GLSL programs, or 0 for fixed function/ARB. */
+   GLuint programs[MESA_SHADER_COMPUTE];
+   /** Name of the draw framebuffer, which identifies the pass. */
+   GLuint framebuffer;
+};
+
+struct brw_draw_time_entry {
+   struct brw_draw_time_key key;
+   uint64_t time;
+   unsigned samples;
+};
+
+void
+brw_init_draw_time(struct brw_context *brw)
+{
+   if (brw->gen < 6) {
+      fprintf(stderr, "INTEL_DEBUG=draw_time requires gen6+\n");
+      return;
+   }
+
+   for (int i = 0; i < 2; i++) {
+      brw->draw_time.bo[i] =
+         drm_intel_bo_alloc(brw->bufmgr, "draw time",
+                            DRAW_TIME_MAX_SAMPLES * 2 * sizeof(uint64_t),
+                            4096);
+      brw->draw_time.sample_entry[i] =
+         ralloc_array(brw, unsigned, DRAW_TIME_MAX_SAMPLES);
+   }
+}
+
+static unsigned
+get_draw_time_entry(struct brw_context *brw)
+{
+   const struct gl_context *ctx = &brw->ctx;
+   struct brw_draw_time_key key;
+
+   memset(&key, 0, sizeof(key));
+   for (int s = 0; s < MESA_SHADER_COMPUTE; s++) {
+      if (ctx->_Shader->CurrentProgram[s])
+         key.programs[s] = ctx->_Shader->CurrentProgram[s]->Name;
+   }
+   key.framebuffer = ctx->DrawBuffer->Name;
+
+   /* Consecutive draws mostly share programs, so check the last hit first. */
+   unsigned last = brw->draw_time.last_entry;
+   if (last < brw->draw_time.num_entries &&
+       memcmp(&brw->draw_time.entries[last].key, &key, sizeof(key)) == 0)
+      return last;
+
+   for (unsigned i = 0; i < brw->draw_time.num_entries; i++) {
+      if (memcmp(&brw->draw_time.entries[i].key, &key, sizeof(key)) == 0) {
+         brw->draw_time.last_entry = i;
+         return i;
+      }
+   }
+
+   if (brw->draw_time.num_entries == brw->draw_time.max_entries) {
+      brw->draw_time.max_entries = MAX2(16, brw->draw_time.max_entries * 2);
+      brw->draw_time.entries =
+         reralloc(brw, brw->draw_time.entries, struct brw_draw_time_entry,
+                  brw->draw_time.max_entries);
+   }
+
+   unsigned i = brw->draw_time.num_entries++;
+   brw->draw_time.entries[i].key = key;
+   brw->draw_time.entries[i].time = 0;
+   brw->draw_time.entries[i].samples = 0;
+   brw->draw_time.last_entry = i;
+
+   return i;
+}
+
+static void
+collect_draw_time_bo(struct brw_context *brw, int b)
+{
+   if (brw->draw_time.num_samples[b] == 0)
+      return;
+
+   if (drm_intel_bo_references(brw->batch.bo, brw->draw_time.bo[b]))
+      intel_batchbuffer_flush(brw);
+
+   brw_bo_map(brw, brw->draw_time.bo[b], false, "draw time");
+   const uint64_t *ts = brw->draw_time.bo[b]->virtual;
+
+   for (unsigned s = 0; s < brw->draw_time.num_samples[b]; s++) {
+      struct brw_draw_time_entry *entry =
+         &brw->draw_time.entries[brw->draw_time.sample_entry[b][s]];
+
+      /* The TIMESTAMP register is 36 bits wide and ticks every 80ns. */
+      entry->time += 80 * ((ts[2 * s + 1] - ts[2 * s]) & ((1ull << 36) - 1));
+      entry->samples++;
+   }
+
+   drm_intel_bo_unmap(brw->draw_time.bo[b]);
+   brw->draw_time.num_samples[b] = 0;
+}
+
+/**
+ * Decide whether the next primitive is timed.  Must be called before
+ * space is reserved for it, as it may flush the batch.
+ */
+bool
+brw_draw_time_sample(struct brw_context *brw)
+{
+   if (!brw->draw_time.bo[0])
+      return false;
+
+   if (++brw->draw_time.draw_count % DRAW_TIME_INTERVAL != 0)
+      return false;
+
+   int cur = brw->draw_time.cur;
+   if (brw->draw_time.num_samples[cur] == DRAW_TIME_MAX_SAMPLES) {
+      collect_draw_time_bo(brw, !cur);
+      brw->draw_time.cur = !cur;
+   }
+
+   return true;
+}
+
+/**
+ * Emit the start or end timestamp of a sampled primitive.  The flush makes
+ * sure that the timestamps bracket exactly the work of the primitive.
+ */
+void
+brw_draw_time_emit(struct brw_context *brw, bool end)
+{
+   int cur = brw->draw_time.cur;
+
+   brw_emit_mi_flush(brw);
+   brw_store_register_mem64(brw, brw->draw_time.bo[cur], TIMESTAMP,
+                            2 * brw->draw_time.num_samples[cur] + end);
+}
+
+/**
+ * Record a sampled primitive once it is known to stay in the batch.
+ */
+void
+brw_draw_time_commit(struct brw_context *brw)
+{
+   int cur = brw->draw_time.cur;
+
+   brw->draw_time.sample_entry[cur][brw->draw_time.num_samples[cur]++] =
+      get_draw_time_entry(brw);
+}
+
+static int
+compare_entry_time(const void *a, const void *b)
+{
+   const struct brw_draw_time_entry *ea = a, *eb = b;
+
+   if (ea->time < eb->time)
+      return 1;
+   else if (ea->time == eb->time)
+      return 0;
+   else
+      return -1;
+}
+
+static void
+brw_report_draw_time(struct brw_context *brw)
+{
+   const unsigned n = brw->draw_time.num_entries;
+   struct brw_draw_time_entry sorted[n];
+   uint64_t total = 0;
+
+   if (n == 0)
+      return;
+
+   memcpy(sorted, brw->draw_time.entries, n * sizeof(sorted[0]));
+   qsort(sorted, n, sizeof(sorted[0]), compare_entry_time);
+
+   for (unsigned i = 0; i < n; i++)
+      total += sorted[i].time;
+   if (total == 0)
+      return;
+
+   fprintf(stderr, "\n");
+   fprintf(stderr, "draw time (1 in %d draws sampled, scaled up):\n",
+           DRAW_TIME_INTERVAL);
+   fprintf(stderr, "  vs   tcs   tes    gs    fs   fbo  samples"
+           "         time (ms)\n");
+
+   for (unsigned i = 0; i < n; i++) {
+      const struct brw_draw_time_entry *e = &sorted[i];
+
+      if (e->time == 0)
+         continue;
+
+      for (int s = 0; s < MESA_SHADER_COMPUTE; s++)
+         fprintf(stderr, "%5u ", e->key.programs[s]);
+      fprintf(stderr, "%5u %8u %12.3f %5.1f%%\n", e->key.framebuffer,
+              e->samples, e->time * DRAW_TIME_INTERVAL / 1000000.0,
+              (double) e->time / total * 100.0);
+   }
+}
+
+/**
+ * Read back whatever the GPU is done with, and print a report every second.
+ * Called at the start of each batch.
+ */
+void
+brw_collect_and_report_draw_time(struct brw_context *brw)
+{
+   if (!brw->draw_time.bo[0])
+      return;
+
+   int cur = brw->draw_time.cur;
+   if (brw->draw_time.num_samples[!cur] &&
+       !drm_intel_bo_busy(brw->draw_time.bo[!cur]))
+      collect_draw_time_bo(brw, !cur);
+
+   /* Retire the current buffer with the batch that just went out. */
+   if (brw->draw_time.num_samples[cur] && !brw->draw_time.num_samples[!cur])
+      brw->draw_time.cur = !cur;
+
+   if (brw->draw_time.report_time == 0 ||
+       get_time() - brw->draw_time.report_time >= 1.0) {
+      brw_report_draw_time(brw);
+      brw->draw_time.report_time = get_time();
+   }
+}
+
+void
+brw_destroy_draw_time(struct brw_context *brw)
+{
+   if (!brw->draw_time.bo[0])
+      return;
+
+   collect_draw_time_bo(brw, 0);
+   collect_draw_time_bo(brw, 1);
+   brw_report_draw_time(brw);
+
+   for (int i = 0; i < 2; i++) {
+      drm_intel_bo_unreference(brw->draw_time.bo[i]);
+      brw->draw_time.bo[i] = NULL;
+   }
+}
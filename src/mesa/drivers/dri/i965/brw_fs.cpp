@@ -1468,6 +1468,82 @@ fs_visitor::emit_gs_thread_end()
    inst->offset = 0;
 }
 
+/**
+ * Emit the automatically generated passthrough TCS used when the application
+ * doesn't supply one: it copies the VS outputs of this invocation's input
+ * vertex to its output vertex, and writes the API default tessellation
+ * levels, which brw_tcs.c uploads as uniforms 0-7 in patch header order.
+ */
+void
+fs_visitor::emit_tcs_passthrough()
+{
+   assert(stage == MESA_SHADER_TESS_CTRL);
+
+   const struct brw_tcs_prog_key *tcs_key =
+      (const struct brw_tcs_prog_key *) key;
+   const struct brw_vue_prog_data *vue_prog_data =
+      (const struct brw_vue_prog_data *) prog_data;
+   const fs_builder abld = bld.annotate("passthrough");
+
+   fs_reg icp_handle = get_tcs_icp_handle(abld, invocation_id);
+   fs_reg vertex_offset = abld.vgrf(BRW_REGISTER_TYPE_UD, 1);
+   abld.MUL(vertex_offset, invocation_id,
+            brw_imm_ud(vue_prog_data->vue_map.num_per_vertex_slots));
+
+   uint64_t varyings = tcs_key->outputs_written;
+   while (varyings != 0) {
+      const int varying = ffsll(varyings) - 1;
+
+      unsigned in_offset = input_vue_map->varying_to_slot[varying];
+      unsigned out_offset = vue_prog_data->vue_map.varying_to_slot[varying];
+      assert(out_offset >= 2);
+
+      fs_reg srcs[6];
+      srcs[0] = retype(brw_vec1_grf(0, 0), BRW_REGISTER_TYPE_UD);
+      srcs[1] = vertex_offset;
+      fs_reg val = abld.vgrf(BRW_REGISTER_TYPE_F, 4);
+      fs_inst *inst = abld.emit(SHADER_OPCODE_URB_READ_SIMD8, val, icp_handle);
+      inst->offset = in_offset;
+      inst->mlen = 1;
+      inst->base_mrf = -1;
+      inst->regs_written = 4;
+      for (unsigned i = 0; i < 4; i++)
+         srcs[2 + i] = offset(val, abld, i);
+
+      fs_reg payload = abld.vgrf(BRW_REGISTER_TYPE_UD, 6);
+      abld.LOAD_PAYLOAD(payload, srcs, 6, 2);
+      inst = abld.emit(SHADER_OPCODE_URB_WRITE_SIMD8_PER_SLOT,
+                       abld.null_reg_ud(), payload);
+      inst->offset = out_offset;
+      inst->mlen = 6;
+      inst->base_mrf = -1;
+
+      varyings &= ~BITFIELD64_BIT(varying);
+   }
+
+   /* Only write the tessellation factors from invocation 0.
+    * There's no point in making other threads do redundant work.
+    */
+   abld.CMP(abld.null_reg_ud(), invocation_id, brw_imm_ud(0u),
+            BRW_CONDITIONAL_EQ);
+   abld.IF(BRW_PREDICATE_NORMAL);
+   for (unsigned slot = 0; slot < 2; slot++) {
+      fs_reg srcs[5];
+      srcs[0] = retype(brw_vec1_grf(0, 0), BRW_REGISTER_TYPE_UD);
+      for (unsigned i = 0; i < 4; i++)
+         srcs[1 + i] = fs_reg(UNIFORM, 4 * slot + i, BRW_REGISTER_TYPE_F);
+
+      fs_reg payload = abld.vgrf(BRW_REGISTER_TYPE_UD, 5);
+      abld.LOAD_PAYLOAD(payload, srcs, 5, 1);
+      fs_inst *inst = abld.emit(SHADER_OPCODE_URB_WRITE_SIMD8,
+                                abld.null_reg_ud(), payload);
+      inst->offset = slot;
+      inst->mlen = 5;
+      inst->base_mrf = -1;
+   }
+   abld.emit(BRW_OPCODE_ENDIF);
+}
+
 void
 fs_visitor::assign_curb_setup()
 {
@@ -1685,6 +1761,17 @@ fs_visitor::assign_vs_urb_setup()
    }
 }
 
+void
+fs_visitor::assign_tcs_single_patch_urb_setup()
+{
+   assert(stage == MESA_SHADER_TESS_CTRL);
+
+   /* Rewrite all ATTR file references to HW_REGs. */
+   foreach_block_and_inst(block, fs_inst, inst, cfg) {
+      convert_attr_sources_to_hw_regs(inst);
+   }
+}
+
 void
 fs_visitor::assign_tes_urb_setup()
 {
@@ -5246,6 +5333,103 @@ fs_visitor::run_vs(gl_clip_plane *clip_planes)
    return !failed;
 }
 
+bool
+fs_visitor::run_tcs_single_patch()
+{
+   assert(stage == MESA_SHADER_TESS_CTRL);
+
+   struct brw_tcs_prog_data *tcs_prog_data =
+      (struct brw_tcs_prog_data *) prog_data;
+   const struct brw_tcs_prog_key *tcs_key =
+      (const struct brw_tcs_prog_key *) key;
+
+   /* R0: thread header, R1-4: ICP handles */
+   payload.num_regs = 5;
+
+   if (shader_time_index >= 0)
+      emit_shader_time_begin();
+
+   /* Each SIMD8 channel handles one output vertex, so gl_InvocationID is
+    * the channel number plus 8 times the HS instance number.
+    */
+   fs_reg channels_uw = bld.vgrf(BRW_REGISTER_TYPE_UW, 1);
+   fs_reg channels_ud = bld.vgrf(BRW_REGISTER_TYPE_UD, 1);
+   bld.MOV(channels_uw, fs_reg(brw_imm_uv(0x76543210)));
+   bld.MOV(channels_ud, channels_uw);
+
+   if (tcs_prog_data->instances == 1) {
+      invocation_id = channels_ud;
+   } else {
+      invocation_id = bld.vgrf(BRW_REGISTER_TYPE_UD, 1);
+
+      /* "Instance Count" comes as part of the payload in r0.2 bits 23:17.
+       * Shifting right by 3 less than that multiplies it by 8.
+       */
+      fs_reg t = bld.vgrf(BRW_REGISTER_TYPE_UD, 1);
+      fs_reg instance_times_8 = bld.vgrf(BRW_REGISTER_TYPE_UD, 1);
+      bld.AND(t, fs_reg(retype(brw_vec1_grf(0, 2), BRW_REGISTER_TYPE_UD)),
+              brw_imm_ud(INTEL_MASK(23, 17)));
+      bld.SHR(instance_times_8, t, brw_imm_ud(17 - 3));
+
+      bld.ADD(invocation_id, instance_times_8, channels_ud);
+   }
+
+   /* HS threads are dispatched with the dispatch mask set to 0xFF.  If
+    * the number of output vertices isn't a multiple of 8, the channels of
+    * the last instance past the final vertex need to be disabled.
+    */
+   if (nir->info.tcs.vertices_out % 8) {
+      bld.CMP(bld.null_reg_ud(), invocation_id,
+              brw_imm_ud(nir->info.tcs.vertices_out), BRW_CONDITIONAL_L);
+      bld.IF(BRW_PREDICATE_NORMAL);
+   }
+
+   if (tcs_key->program_string_id != 0) {
+      /* We have a real application-supplied TCS, emit real code. */
+      emit_nir_code();
+   } else {
+      /* There is no TCS; automatically generate a passthrough shader. */
+      emit_tcs_passthrough();
+   }
+
+   if (nir->info.tcs.vertices_out % 8) {
+      bld.emit(BRW_OPCODE_ENDIF);
+   }
+
+   if (failed)
+      return false;
+
+   /* Emit EOT write; set TR DS Cache bit */
+   fs_reg srcs[3] = {
+      fs_reg(retype(brw_vec1_grf(0, 0), BRW_REGISTER_TYPE_UD)),
+      fs_reg(brw_imm_ud(WRITEMASK_X << 16)),
+      fs_reg(brw_imm_ud(0)),
+   };
+   fs_reg payload = bld.vgrf(BRW_REGISTER_TYPE_UD, 3);
+   bld.LOAD_PAYLOAD(payload, srcs, 3, 2);
+
+   fs_inst *inst = bld.exec_all().emit(SHADER_OPCODE_URB_WRITE_SIMD8_MASKED,
+                                       bld.null_reg_ud(), payload);
+   inst->mlen = 3;
+   inst->base_mrf = -1;
+   inst->eot = true;
+
+   if (shader_time_index >= 0)
+      emit_shader_time_end();
+
+   calculate_cfg();
+
+   optimize();
+
+   assign_curb_setup();
+   assign_tcs_single_patch_urb_setup();
+
+   fixup_3src_null_dest();
+   allocate_registers();
+
+   return !failed;
+}
+
 bool
 fs_visitor::run_tes()
 {
@@ -5536,13 +5720,17 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
                struct gl_program *prog,
                int shader_time_index8, int shader_time_index16,
                bool use_rep_send,
+               bool allow_simd16,
                unsigned *final_assembly_size,
                char **error_str)
 {
+   assert(allow_simd16 || !use_rep_send);
+
    nir_shader *shader = nir_shader_clone(mem_ctx, src_shader);
    shader = brw_nir_apply_sampler_key(shader, compiler->devinfo, &key->tex,
                                       true);
    shader = brw_postprocess_nir(shader, compiler->devinfo, true);
+   brw_nir_log_stats(compiler, log_data, shader);
 
    /* key->alpha_test_func means simulating alpha testing via discards,
     * so the shader definitely kills pixels.
@@ -5576,7 +5764,7 @@ brw_compile_fs(const struct brw_compiler *compiler, void *log_data,
    fs_visitor v2(compiler, log_data, mem_ctx, key,
                  &prog_data->base, prog, shader, 16,
                  shader_time_index16);
-   if (likely(!(INTEL_DEBUG & DEBUG_NO16) || use_rep_send)) {
+   if (likely(!(INTEL_DEBUG & DEBUG_NO16) || use_rep_send) && allow_simd16) {
       if (!v.simd16_unsupported) {
          /* Try a SIMD16 compile */
          v2.import_uniforms(&v);
@@ -5669,6 +5857,7 @@ brw_compile_cs(const struct brw_compiler *compiler, void *log_data,
    shader = brw_nir_apply_sampler_key(shader, compiler->devinfo, &key->tex,
                                       true);
    shader = brw_postprocess_nir(shader, compiler->devinfo, true);
+   brw_nir_log_stats(compiler, log_data, shader);
 
    prog_data->local_size[0] = shader->info.cs.local_size[0];
    prog_data->local_size[1] = shader->info.cs.local_size[1];
@@ -159,6 +159,7 @@ brw_alloc_reg_set(struct brw_compiler *compiler, int dispatch_width)
    struct ra_regs *regs = ra_alloc_reg_set(compiler, ra_reg_count, false);
    if (devinfo->gen >= 6)
       ra_set_allocate_round_robin(regs);
+   ra_set_parallel_interference(regs, 0);
    int *classes = ralloc_array(compiler, int, class_count);
    int aligned_pairs_class = -1;
 
@@ -589,14 +590,14 @@ fs_visitor::assign_regs(bool allow_spilling)
       }
 
       ra_set_node_class(g, i, c);
-
-      for (unsigned j = 0; j < i; j++) {
-	 if (virtual_grf_interferes(i, j)) {
-	    ra_add_node_interference(g, i, j);
-	 }
-      }
    }
 
+   /* Same test as virtual_grf_interferes(), without going through every
+    * pair of VGRFs.
+    */
+   ra_add_live_range_interference(g, 0, this->alloc.count,
+                                  virtual_grf_start, virtual_grf_end);
+
    /* Certain instructions can't safely use the same register for their
     * sources and destination.  Add interference.
     */
@@ -156,14 +156,34 @@ brw_codegen_gs_prog(struct brw_context *brw,
 
    void *mem_ctx = ralloc_context(NULL);
    unsigned program_size;
-   char *error_str;
-   const unsigned *program =
-      brw_compile_gs(brw->intelScreen->compiler, brw, mem_ctx, key,
-                     &prog_data, shader->Program->nir, prog,
-                     st_index, &program_size, &error_str);
-   if (program == NULL) {
-      ralloc_free(mem_ctx);
-      return false;
+   const unsigned *program;
+
+   /* The gen6 GS also handles transform feedback, which isn't part of the
+    * key, so leave it out of the disk cache.
+    */
+   struct brw_disk_cache_prog disk_cache;
+   disk_cache.enabled = false;
+   if (brw->gen < 7 ||
+       !brw_disk_cache_load_prog(brw, mem_ctx, &disk_cache, BRW_CACHE_GS_PROG,
+                                 key, sizeof(*key),
+                                 offsetof(struct brw_gs_prog_key,
+                                          program_string_id),
+                                 prog->SeparateShader |
+                                 prog->Geom.UsesStreams << 1,
+                                 &gp->program.Base, &prog_data.base.base,
+                                 sizeof(prog_data),
+                                 &program, &program_size)) {
+      char *error_str;
+      program = brw_compile_gs(brw->intelScreen->compiler, brw, mem_ctx, key,
+                               &prog_data, shader->Program->nir, prog,
+                               st_index, &program_size, &error_str);
+      if (program == NULL) {
+         ralloc_free(mem_ctx);
+         return false;
+      }
+
+      brw_disk_cache_store_prog(brw, &disk_cache, program, program_size,
+                                &prog_data.base.base, sizeof(prog_data));
    }
 
    if (unlikely(brw->perf_debug)) {
@@ -106,10 +106,17 @@ brw_lower_packing_builtins(struct brw_context *brw,
    lower_packing_builtins(ir, ops);
 }
 
-static void
+/**
+ * Lowers and optimizes the linked GLSL IR of one stage.  This only touches
+ * the stage's own IR, so brw_link_shader() runs it for several stages at
+ * once on different threads.
+ *
+ * \return  whether variable indexing had to be lowered to conditional
+ *          assignments
+ */
+static bool
 process_glsl_ir(gl_shader_stage stage,
                 struct brw_context *brw,
-                struct gl_shader_program *shader_prog,
                 struct gl_shader *shader)
 {
    struct gl_context *ctx = &brw->ctx;
@@ -162,12 +169,6 @@ process_glsl_ir(gl_shader_stage stage,
                                           options->EmitNoIndirectTemp,
                                           options->EmitNoIndirectUniform);
 
-   if (unlikely(brw->perf_debug && lowered_variable_indexing)) {
-      perf_debug("Unsupported form of variable indexing in %s; falling "
-                 "back to very inefficient code generation\n",
-                 _mesa_shader_stage_to_abbrev(shader->Stage));
-   }
-
    bool progress;
    do {
       progress = false;
@@ -196,13 +197,26 @@ process_glsl_ir(gl_shader_stage stage,
    reparent_ir(shader->ir, shader->ir);
    ralloc_free(mem_ctx);
 
-   if (ctx->_Shader->Flags & GLSL_DUMP) {
-      fprintf(stderr, "\n");
-      fprintf(stderr, "GLSL IR for linked %s program %d:\n",
-              _mesa_shader_stage_to_string(shader->Stage),
-              shader_prog->Name);
-      _mesa_print_ir(stderr, shader->ir, NULL);
-      fprintf(stderr, "\n");
+   return lowered_variable_indexing;
+}
+
+struct process_glsl_ir_job {
+   struct brw_context *brw;
+   unsigned num_shaders;
+   struct gl_shader *shaders[MESA_SHADER_STAGES];
+   bool lowered_variable_indexing[MESA_SHADER_STAGES];
+};
+
+static void
+process_glsl_ir_stages(void *data, unsigned first, unsigned end)
+{
+   struct process_glsl_ir_job *job = (struct process_glsl_ir_job *) data;
+
+   for (unsigned i = first; i < end; i++) {
+      struct gl_shader *shader = job->shaders[i];
+
+      job->lowered_variable_indexing[i] =
+         process_glsl_ir(shader->Stage, job->brw, shader);
    }
 }
 
@@ -211,12 +225,41 @@ brw_link_shader(struct gl_context *ctx, struct gl_shader_program *shProg)
 {
    struct brw_context *brw = brw_context(ctx);
    const struct brw_compiler *compiler = brw->intelScreen->compiler;
+   struct process_glsl_ir_job job;
    unsigned int stage;
 
+   /* The stages are linked with each other by now, so their GLSL IR can be
+    * lowered and optimized independently.
+    */
+   job.brw = brw;
+   job.num_shaders = 0;
    for (stage = 0; stage < ARRAY_SIZE(shProg->_LinkedShaders); stage++) {
-      struct gl_shader *shader = shProg->_LinkedShaders[stage];
-      if (!shader)
-	 continue;
+      if (shProg->_LinkedShaders[stage])
+         job.shaders[job.num_shaders++] = shProg->_LinkedShaders[stage];
+   }
+
+   _mesa_parallel_link_stages(ctx, process_glsl_ir_stages, &job,
+                              job.num_shaders);
+
+   for (unsigned i = 0; i < job.num_shaders; i++) {
+      struct gl_shader *shader = job.shaders[i];
+
+      stage = shader->Stage;
+
+      if (unlikely(brw->perf_debug && job.lowered_variable_indexing[i])) {
+         perf_debug("Unsupported form of variable indexing in %s; falling "
+                    "back to very inefficient code generation\n",
+                    _mesa_shader_stage_to_abbrev(shader->Stage));
+      }
+
+      if (ctx->_Shader->Flags & GLSL_DUMP) {
+         fprintf(stderr, "\n");
+         fprintf(stderr, "GLSL IR for linked %s program %d:\n",
+                 _mesa_shader_stage_to_string(shader->Stage),
+                 shProg->Name);
+         _mesa_print_ir(stderr, shader->ir, NULL);
+         fprintf(stderr, "\n");
+      }
 
       struct gl_program *prog =
 	 ctx->Driver.NewProgram(ctx, _mesa_shader_stage_to_program(stage),
@@ -227,8 +270,6 @@ brw_link_shader(struct gl_context *ctx, struct gl_shader_program *shProg)
 
       _mesa_copy_linked_program_data((gl_shader_stage) stage, shProg, prog);
 
-      process_glsl_ir((gl_shader_stage) stage, brw, shProg, shader);
-
       /* Make a pass over the IR to add state references for any built-in
        * uniforms that are used.  This has to be done now (during linking).
        * Code generation doesn't happen until the first time this shader is
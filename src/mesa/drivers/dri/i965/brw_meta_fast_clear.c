@@ -806,11 +806,10 @@ brw_meta_fast_clear(struct brw_context *brw, struct gl_framebuffer *fb,
 }
 
 static void
-get_resolve_rect(struct brw_context *brw,
-                 struct intel_mipmap_tree *mt, struct rect *rect)
+get_resolve_scaledown(struct brw_context *brw, struct intel_mipmap_tree *mt,
+                      unsigned *x_scaledown, unsigned *y_scaledown)
 {
    unsigned x_align, y_align;
-   unsigned x_scaledown, y_scaledown;
 
    /* From the Ivy Bridge PRM, Vol2 Part1 11.9 "Render Target Resolve":
     *
@@ -826,27 +825,39 @@ get_resolve_rect(struct brw_context *brw,
 
    intel_get_non_msrt_mcs_alignment(mt, &x_align, &y_align);
    if (brw->gen >= 9) {
-      x_scaledown = x_align * 8;
-      y_scaledown = y_align * 8;
+      *x_scaledown = x_align * 8;
+      *y_scaledown = y_align * 8;
    } else if (brw->gen >= 8) {
-      x_scaledown = x_align * 8;
-      y_scaledown = y_align * 16;
+      *x_scaledown = x_align * 8;
+      *y_scaledown = y_align * 16;
    } else {
-      x_scaledown = x_align / 2;
-      y_scaledown = y_align / 2;
+      *x_scaledown = x_align / 2;
+      *y_scaledown = y_align / 2;
    }
+}
+
+static void
+get_resolve_rect(struct brw_context *brw,
+                 struct intel_mipmap_tree *mt, struct rect *rect)
+{
+   unsigned x_scaledown, y_scaledown;
+
+   get_resolve_scaledown(brw, mt, &x_scaledown, &y_scaledown);
    rect->x0 = rect->y0 = 0;
    rect->x1 = ALIGN(mt->logical_width0, x_scaledown) / x_scaledown;
    rect->y1 = ALIGN(mt->logical_height0, y_scaledown) / y_scaledown;
 }
 
-void
-brw_meta_resolve_color(struct brw_context *brw,
-                       struct intel_mipmap_tree *mt)
+/**
+ * Draws the render target resolve of \p rect, given in the scaled down
+ * coordinates of get_resolve_rect().
+ */
+static void
+draw_resolve_rect(struct brw_context *brw, struct intel_mipmap_tree *mt,
+                  struct rect *rect)
 {
    struct gl_context *ctx = &brw->ctx;
    GLuint fbo, rbo;
-   struct rect rect;
 
    brw_emit_mi_flush(brw);
 
@@ -873,10 +884,7 @@ brw_meta_resolve_color(struct brw_context *brw,
     */
    set_fast_clear_op(brw, GEN7_PS_RENDER_TARGET_RESOLVE_ENABLE);
 
-   mt->fast_clear_state = INTEL_FAST_CLEAR_STATE_RESOLVED;
-   get_resolve_rect(brw, mt, &rect);
-
-   brw_draw_rectlist(brw, &rect, 1);
+   brw_draw_rectlist(brw, rect, 1);
 
    set_fast_clear_op(brw, 0);
    use_rectlist(brw, false);
@@ -895,3 +903,63 @@ brw_meta_resolve_color(struct brw_context *brw,
    if (ctx->NewState)
       _mesa_update_state(ctx);
 }
+
+void
+brw_meta_resolve_color(struct brw_context *brw,
+                       struct intel_mipmap_tree *mt)
+{
+   struct rect rect;
+
+   mt->fast_clear_state = INTEL_FAST_CLEAR_STATE_RESOLVED;
+   get_resolve_rect(brw, mt, &rect);
+
+   draw_resolve_rect(brw, mt, &rect);
+}
+
+/**
+ * Resolves only the blocks of \p mt covering the given pixel rectangle.
+ *
+ * The rest of the buffer keeps its pending fast clears, so \p mt stays in
+ * INTEL_FAST_CLEAR_STATE_UNRESOLVED and records the resolved blocks in
+ * fast_clear_resolved_rect until it's rendered to again.  When the blocks
+ * cover the whole buffer, this is a full resolve.
+ */
+void
+brw_meta_resolve_color_rect(struct brw_context *brw,
+                            struct intel_mipmap_tree *mt,
+                            unsigned x0, unsigned y0,
+                            unsigned x1, unsigned y1)
+{
+   unsigned x_scaledown, y_scaledown;
+   struct rect full, rect;
+
+   get_resolve_scaledown(brw, mt, &x_scaledown, &y_scaledown);
+   get_resolve_rect(brw, mt, &full);
+
+   rect.x0 = x0 / x_scaledown;
+   rect.y0 = y0 / y_scaledown;
+   rect.x1 = MIN2(DIV_ROUND_UP(x1, x_scaledown), (unsigned) full.x1);
+   rect.y1 = MIN2(DIV_ROUND_UP(y1, y_scaledown), (unsigned) full.y1);
+
+   if (rect.x0 >= rect.x1 || rect.y0 >= rect.y1)
+      return;
+
+   if (rect.x0 == 0 && rect.y0 == 0 &&
+       rect.x1 == full.x1 && rect.y1 == full.y1) {
+      brw_meta_resolve_color(brw, mt);
+      return;
+   }
+
+   draw_resolve_rect(brw, mt, &rect);
+
+   /* Drawing the resolve counts as rendering to mt, which drops any
+    * previously resolved rectangle, so only record ours afterwards.
+    */
+   mt->fast_clear_state = INTEL_FAST_CLEAR_STATE_UNRESOLVED;
+   mt->fast_clear_resolved_rect.x0 = rect.x0 * x_scaledown;
+   mt->fast_clear_resolved_rect.y0 = rect.y0 * y_scaledown;
+   mt->fast_clear_resolved_rect.x1 = MIN2(rect.x1 * x_scaledown,
+                                          mt->logical_width0);
+   mt->fast_clear_resolved_rect.y1 = MIN2(rect.y1 * y_scaledown,
+                                          mt->logical_height0);
+}
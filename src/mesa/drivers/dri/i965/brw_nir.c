@@ -229,6 +229,9 @@ brw_nir_lower_inputs(nir_shader *nir,
                nir_builder_init(&params.b, overload->impl);
                nir_foreach_block(overload->impl, add_const_offset_to_base, &params);
                nir_foreach_block(overload->impl, remap_vs_attrs, &inputs_read);
+               nir_metadata_preserve(overload->impl,
+                                     nir_metadata_block_index |
+                                     nir_metadata_dominance);
             }
          }
       }
@@ -276,6 +279,9 @@ brw_nir_lower_inputs(nir_shader *nir,
                nir_foreach_block(overload->impl, add_const_offset_to_base, &params);
                nir_foreach_block(overload->impl, remap_inputs_with_vue_map,
                                  &input_vue_map);
+               nir_metadata_preserve(overload->impl,
+                                     nir_metadata_block_index |
+                                     nir_metadata_dominance);
             }
          }
       }
@@ -302,6 +308,9 @@ brw_nir_lower_inputs(nir_shader *nir,
             nir_foreach_block(overload->impl, add_const_offset_to_base, &params);
             nir_builder_init(&state.b, overload->impl);
             nir_foreach_block(overload->impl, remap_patch_urb_offsets, &state);
+            nir_metadata_preserve(overload->impl,
+                                  nir_metadata_block_index |
+                                  nir_metadata_dominance);
          }
       }
       break;
@@ -362,6 +371,9 @@ brw_nir_lower_outputs(nir_shader *nir,
             nir_foreach_block(overload->impl, add_const_offset_to_base, &params);
             nir_builder_init(&state.b, overload->impl);
             nir_foreach_block(overload->impl, remap_patch_urb_offsets, &state);
+            nir_metadata_preserve(overload->impl,
+                                  nir_metadata_block_index |
+                                  nir_metadata_dominance);
          }
       }
       break;
@@ -463,7 +475,11 @@ nir_optimize(nir_shader *nir, bool is_scalar)
       OPT(nir_copy_prop);
       OPT(nir_opt_dce);
       OPT(nir_opt_cse);
-      OPT(nir_opt_peephole_select);
+      OPT(nir_opt_combine_ubo_loads);
+      /* In SIMD8/16 a divergent if costs both sides plus the jumps, so
+       * executing a few ALU instructions unconditionally is cheaper.
+       */
+      OPT(nir_opt_peephole_select, is_scalar ? 8 : 0);
       OPT(nir_opt_algebraic);
       OPT(nir_opt_constant_folding);
       OPT(nir_opt_dead_cf);
@@ -601,6 +617,25 @@ brw_postprocess_nir(nir_shader *nir,
    return nir;
 }
 
+/* Reports the NIR a backend is about to consume through the same channel
+ * as the backend's own statistics, so shader-db can track both.
+ */
+void
+brw_nir_log_stats(const struct brw_compiler *compiler, void *log_data,
+                  nir_shader *nir)
+{
+   nir_shader_stats stats;
+   nir_gather_stats(nir, &stats);
+
+   compiler->shader_debug_log(log_data,
+                              "%s NIR: %u inst, %u alu, %u tex, "
+                              "%u ssa defs, %u ifs, %u loops.\n",
+                              _mesa_shader_stage_to_abbrev(nir->stage),
+                              stats.instrs, stats.alu_instrs,
+                              stats.tex_instrs, stats.ssa_defs,
+                              stats.ifs, stats.loops);
+}
+
 nir_shader *
 brw_create_nir(struct brw_context *brw,
                const struct gl_shader_program *shader_prog,
@@ -641,6 +676,11 @@ brw_create_nir(struct brw_context *brw,
       nir = brw_nir_lower_io(nir, devinfo, is_scalar);
    }
 
+   /* This is the copy that stays on the gl_program and gets cloned for
+    * every recompile, so don't keep what the passes above threw away.
+    */
+   nir = nir_shader_compact(nir);
+
    return nir;
 }
 
@@ -88,6 +88,8 @@ nir_shader *brw_nir_lower_io(nir_shader *nir,
 nir_shader *brw_postprocess_nir(nir_shader *nir,
                                 const struct brw_device_info *devinfo,
                                 bool is_scalar);
+void brw_nir_log_stats(const struct brw_compiler *compiler, void *log_data,
+                       nir_shader *nir);
 
 
 nir_shader *brw_nir_apply_sampler_key(nir_shader *nir,
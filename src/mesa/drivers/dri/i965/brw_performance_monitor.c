@@ -40,9 +40,25 @@
  * On Ironlake, the OA counters were called "CHAPS" counters.  Sadly, no public
  * documentation exists; our implementation is based on the source code for the
  * intel_perf_counters utility (which is available as part of intel-gpu-tools).
+ *
+ * On Haswell, kernels with i915 perf support refuse OACONTROL writes from the
+ * batch.  Instead, we open an OA stream, which has the kernel program and
+ * enable the OA unit, and also read its periodic reports to account for
+ * counters wrapping around during long measurements.  The GL interface is
+ * the same either way, including INTEL_performance_query, which the core
+ * implements on top of these monitors.
  */
 
+#include <dirent.h>
+#include <errno.h>
 #include <limits.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <xf86drm.h>
+#include <i915_drm.h>
 
 #include "util/bitset.h"
 #include "main/hash.h"
@@ -629,6 +645,223 @@ gather_statistics_results(struct brw_context *brw,
 
 /******************************************************************************/
 
+/**
+ * i915 perf interface, for i915_drm.h versions which predate it.
+ *  @{
+ */
+#ifndef DRM_I915_PERF_OPEN
+#define DRM_I915_PERF_OPEN 0x36
+#define DRM_IOCTL_I915_PERF_OPEN \
+   DRM_IOW(DRM_COMMAND_BASE + DRM_I915_PERF_OPEN, struct drm_i915_perf_open_param)
+
+#define I915_OA_FORMAT_A45_B8_C8 5
+
+enum drm_i915_perf_property_id {
+   DRM_I915_PERF_PROP_CTX_HANDLE = 1,
+   DRM_I915_PERF_PROP_SAMPLE_OA,
+   DRM_I915_PERF_PROP_OA_METRICS_SET,
+   DRM_I915_PERF_PROP_OA_FORMAT,
+   DRM_I915_PERF_PROP_OA_EXPONENT,
+};
+
+struct drm_i915_perf_open_param {
+   __u32 flags;
+#define I915_PERF_FLAG_FD_CLOEXEC   (1 << 0)
+#define I915_PERF_FLAG_FD_NONBLOCK  (1 << 1)
+#define I915_PERF_FLAG_DISABLED     (1 << 2)
+   __u32 num_properties;
+   __u64 properties_ptr;
+};
+
+struct drm_i915_perf_record_header {
+   __u32 type;
+   __u16 pad;
+   __u16 size;
+};
+
+enum drm_i915_perf_record_type {
+   DRM_I915_PERF_RECORD_SAMPLE = 1,
+   DRM_I915_PERF_RECORD_OA_REPORT_LOST = 2,
+   DRM_I915_PERF_RECORD_OA_BUFFER_LOST = 3,
+};
+#endif
+/** @} */
+
+/**
+ * The kernel's "Render Basic" metric set for Haswell, which uses the same
+ * report format (A45_B8_C8, or counter select 101) as gen7_oa_snapshot_layout.
+ */
+#define HSW_RENDER_BASIC_GUID "403d8832-1a27-4aa6-a64e-f5389ce7b212"
+
+/**
+ * Periodic reports are taken every 80ns * 2^(OA_EXPONENT + 1), or about every
+ * 42ms.  The fastest A counters wrap around after a bit less than 200ms.
+ */
+#define OA_EXPONENT 18
+
+/** The most periodic reports we hold on to. */
+#define MAX_OA_SAMPLES 4096
+
+/**
+ * Look up the ID the kernel gave to the metric set \p guid in sysfs.
+ */
+static bool
+read_metrics_set_id(struct brw_context *brw, const char *guid, uint64_t *id)
+{
+   const int fd = brw->intelScreen->driScrnPriv->fd;
+   char path[PATH_MAX], id_path[PATH_MAX];
+   struct dirent *entry;
+   struct stat sb;
+   bool found = false;
+
+   if (fstat(fd, &sb) != 0 || !S_ISCHR(sb.st_mode))
+      return false;
+
+   snprintf(path, sizeof(path), "/sys/dev/char/%u:%u/device/drm",
+            major(sb.st_rdev), minor(sb.st_rdev));
+
+   DIR *drm_dir = opendir(path);
+   if (drm_dir == NULL)
+      return false;
+
+   while (!found && (entry = readdir(drm_dir)) != NULL) {
+      if (strncmp(entry->d_name, "card", 4) != 0)
+         continue;
+
+      snprintf(id_path, sizeof(id_path), "%s/%s/metrics/%s/id",
+               path, entry->d_name, guid);
+
+      FILE *file = fopen(id_path, "r");
+      if (file) {
+         found = fscanf(file, "%"SCNu64, id) == 1;
+         fclose(file);
+      }
+   }
+
+   closedir(drm_dir);
+   return found;
+}
+
+/**
+ * Try to open an OA stream, so that the kernel sets up the OA counters.
+ *
+ * The stream is opened the first time a monitor needs OA counters, and is
+ * then kept open until the context is destroyed.  It isn't tied to our
+ * hardware context, so this may need root or dev.i915.perf_stream_paranoid=0;
+ * if it can't be opened we fall back to programming OACONTROL directly.
+ */
+static void
+open_oa_stream(struct brw_context *brw)
+{
+   uint64_t metrics_set;
+
+   if (brw->perfmon.oa_stream_tried)
+      return;
+   brw->perfmon.oa_stream_tried = true;
+
+   if (!brw->is_haswell ||
+       !read_metrics_set_id(brw, HSW_RENDER_BASIC_GUID, &metrics_set))
+      return;
+
+   uint64_t properties[] = {
+      DRM_I915_PERF_PROP_SAMPLE_OA, true,
+      DRM_I915_PERF_PROP_OA_METRICS_SET, metrics_set,
+      DRM_I915_PERF_PROP_OA_FORMAT, I915_OA_FORMAT_A45_B8_C8,
+      DRM_I915_PERF_PROP_OA_EXPONENT, OA_EXPONENT,
+   };
+   struct drm_i915_perf_open_param param = {
+      .flags = I915_PERF_FLAG_FD_CLOEXEC | I915_PERF_FLAG_FD_NONBLOCK,
+      .num_properties = ARRAY_SIZE(properties) / 2,
+      .properties_ptr = (uintptr_t) properties,
+   };
+
+   int fd = drmIoctl(brw->intelScreen->driScrnPriv->fd,
+                     DRM_IOCTL_I915_PERF_OPEN, &param);
+   if (fd < 0) {
+      DBG("Couldn't open an OA stream (%s), using OACONTROL\n",
+          strerror(errno));
+      return;
+   }
+
+   brw->perfmon.oa_samples =
+      malloc(MAX_OA_SAMPLES * brw->perfmon.entries_per_oa_snapshot *
+             sizeof(uint32_t));
+   if (brw->perfmon.oa_samples == NULL) {
+      close(fd);
+      return;
+   }
+
+   brw->perfmon.oa_stream_fd = fd;
+   brw->perfmon.oa_stream = true;
+   brw->perfmon.oa_sample_count = 0;
+}
+
+/**
+ * Read the periodic reports the kernel has for us so far.
+ */
+static void
+read_oa_stream(struct brw_context *brw)
+{
+   const int entries = brw->perfmon.entries_per_oa_snapshot;
+   uint8_t buf[4096];
+
+   if (!brw->perfmon.oa_stream)
+      return;
+
+   while (true) {
+      ssize_t len = read(brw->perfmon.oa_stream_fd, buf, sizeof(buf));
+
+      if (len < 0 && errno == EINTR)
+         continue;
+
+      if (len <= 0) {
+         if (len < 0 && errno != EAGAIN)
+            DBG("Reading the OA stream failed: %s\n", strerror(errno));
+         return;
+      }
+
+      for (ssize_t offset = 0; offset < len;) {
+         const struct drm_i915_perf_record_header *header =
+            (const struct drm_i915_perf_record_header *) (buf + offset);
+
+         if (header->size == 0)
+            break;
+
+         switch (header->type) {
+         case DRM_I915_PERF_RECORD_SAMPLE:
+            if (header->size < sizeof(*header) + entries * sizeof(uint32_t))
+               break;
+
+            /* Drop the oldest half when full; only reports taken while
+             * some monitor is active are needed anyway.
+             */
+            if (brw->perfmon.oa_sample_count == MAX_OA_SAMPLES) {
+               memmove(brw->perfmon.oa_samples,
+                       brw->perfmon.oa_samples +
+                       MAX_OA_SAMPLES / 2 * entries,
+                       MAX_OA_SAMPLES / 2 * entries * sizeof(uint32_t));
+               brw->perfmon.oa_sample_count = MAX_OA_SAMPLES / 2;
+            }
+
+            memcpy(brw->perfmon.oa_samples +
+                   brw->perfmon.oa_sample_count * entries,
+                   header + 1, entries * sizeof(uint32_t));
+            brw->perfmon.oa_sample_count++;
+            break;
+         case DRM_I915_PERF_RECORD_OA_REPORT_LOST:
+         case DRM_I915_PERF_RECORD_OA_BUFFER_LOST:
+            DBG("WARNING: OA reports were lost; counters wrapping around "
+                "more than once may be undercounted\n");
+            break;
+         }
+
+         offset += header->size;
+      }
+   }
+}
+
+/******************************************************************************/
+
 static bool
 monitor_needs_oa(struct brw_context *brw,
                  struct gl_perf_monitor_object *m)
@@ -644,6 +877,10 @@ start_oa_counters(struct brw_context *brw)
 {
    unsigned counter_format;
 
+   /* The kernel runs the counters for the stream. */
+   if (brw->perfmon.oa_stream)
+      return;
+
    /* Pick the counter format which gives us all the counters. */
    switch (brw->gen) {
    case 5:
@@ -672,8 +909,8 @@ start_oa_counters(struct brw_context *brw)
 static void
 stop_oa_counters(struct brw_context *brw)
 {
-   /* Ironlake counters never stop. */
-   if (brw->gen == 5)
+   /* Ironlake counters never stop, and the kernel stops the stream's. */
+   if (brw->gen == 5 || brw->perfmon.oa_stream)
       return;
 
    BEGIN_BATCH(3);
@@ -792,6 +1029,9 @@ clean_bookend_bo(struct brw_context *brw)
    if (brw->perfmon.unresolved_elements == 0) {
       DBG("***Resetting bookend snapshots to 0\n");
       brw->perfmon.bookend_snapshots = 0;
+
+      if (brw->perfmon.oa_users == 0)
+         brw->perfmon.oa_sample_count = 0;
    }
 }
 
@@ -824,18 +1064,13 @@ drop_from_unresolved_monitor_list(struct brw_context *brw,
 }
 
 /**
- * Given pointers to starting and ending OA snapshots, add the deltas for each
- * counter to the results.
+ * Add the difference between two OA reports for each counter to the results.
  */
 static void
-add_deltas(struct brw_context *brw,
-           struct brw_perf_monitor_object *monitor,
-           uint32_t *start, uint32_t *end)
+add_report_deltas(struct brw_context *brw,
+                  struct brw_perf_monitor_object *monitor,
+                  const uint32_t *start, const uint32_t *end)
 {
-   /* Look for expected report ID values to ensure data is present. */
-   assert(start[0] == REPORT_ID);
-   assert(end[0] == REPORT_ID);
-
    /* Subtract each counter's ending and starting values, then add the
     * difference to the counter's value so far.
     */
@@ -860,6 +1095,42 @@ add_deltas(struct brw_context *brw,
    }
 }
 
+/**
+ * Given pointers to starting and ending OA snapshots, add the deltas for each
+ * counter to the results.
+ *
+ * With an OA stream, the periodic reports taken in between are accounted for
+ * one after the other, so that counters wrapping around more than once don't
+ * lose counts.
+ */
+static void
+add_deltas(struct brw_context *brw,
+           struct brw_perf_monitor_object *monitor,
+           uint32_t *start, uint32_t *end)
+{
+   const int entries = brw->perfmon.entries_per_oa_snapshot;
+   const uint32_t *prev = start;
+
+   /* Look for expected report ID values to ensure data is present. */
+   assert(start[0] == REPORT_ID);
+   assert(end[0] == REPORT_ID);
+
+   /* The second dword of a report is the low half of its timestamp. */
+   for (int s = 0; s < brw->perfmon.oa_sample_count; s++) {
+      const uint32_t *sample = brw->perfmon.oa_samples + s * entries;
+
+      if ((int32_t) (sample[1] - start[1]) <= 0)
+         continue;
+      if ((int32_t) (end[1] - sample[1]) <= 0)
+         break;
+
+      add_report_deltas(brw, monitor, prev, sample);
+      prev = sample;
+   }
+
+   add_report_deltas(brw, monitor, prev, end);
+}
+
 /**
  * Gather OA counter results (partial or full) from a series of snapshots.
  *
@@ -989,6 +1260,8 @@ wrap_bookend_bo(struct brw_context *brw)
     */
    assert(brw->perfmon.oa_users > 0);
 
+   read_oa_stream(brw);
+
    drm_intel_bo_map(brw->perfmon.bookend_bo, false);
    uint32_t *bookend_buffer = brw->perfmon.bookend_bo->virtual;
    for (int i = 0; i < brw->perfmon.unresolved_elements; i++) {
@@ -1125,6 +1398,8 @@ brw_begin_perf_monitor(struct gl_context *ctx,
 
       /* If the OA counters aren't already on, enable them. */
       if (brw->perfmon.oa_users == 0) {
+         open_oa_stream(brw);
+
          /* Ensure the OACONTROL enable and snapshot land in the same batch. */
          int space = (MI_REPORT_PERF_COUNT_BATCH_DWORDS + 3) * 4;
          intel_batchbuffer_require_space(brw, space, RENDER_RING);
@@ -1295,6 +1570,7 @@ brw_get_perf_monitor_result(struct gl_context *ctx,
           */
          drm_intel_gem_bo_map_unsynchronized(brw->perfmon.bookend_bo);
 
+         read_oa_stream(brw);
          gather_oa_results(brw, monitor, brw->perfmon.bookend_bo->virtual);
 
          drm_intel_bo_unmap(brw->perfmon.bookend_bo);
@@ -1391,6 +1667,9 @@ brw_perf_monitor_new_batch(struct brw_context *brw)
    if (brw->perfmon.oa_users == 0)
       return;
 
+   /* Keep the kernel's buffer of periodic reports from filling up. */
+   read_oa_stream(brw);
+
    start_oa_counters(brw);
 
    /* Make sure bookend_bo has enough space for a pair of snapshots.
@@ -1470,3 +1749,15 @@ brw_init_performance_monitors(struct brw_context *brw)
    brw->perfmon.unresolved_elements = 0;
    brw->perfmon.unresolved_array_size = 1;
 }
+
+void
+brw_fini_performance_monitors(struct brw_context *brw)
+{
+   if (brw->perfmon.oa_stream) {
+      close(brw->perfmon.oa_stream_fd);
+      brw->perfmon.oa_stream = false;
+   }
+
+   free(brw->perfmon.oa_samples);
+   brw->perfmon.oa_samples = NULL;
+}
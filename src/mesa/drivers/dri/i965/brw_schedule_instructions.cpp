@@ -86,6 +86,20 @@ public:
     * its children, or just the issue_time if it's a leaf node.
     */
    int delay;
+
+   /**
+    * Whether this node has to stay ordered against every other node in the
+    * block.  See add_barrier_deps().
+    */
+   bool is_barrier;
+
+   /**
+    * The node add_dep() last made a parent of this one, and the index of
+    * this node in its children array, so that adding the same dependency
+    * again doesn't need to search the array.
+    */
+   schedule_node *last_parent;
+   int last_parent_child;
 };
 
 void
@@ -450,6 +464,7 @@ public:
       ralloc_free(this->mem_ctx);
    }
    void add_barrier_deps(schedule_node *n);
+   void calculate_barrier_deps();
    void add_dep(schedule_node *before, schedule_node *after, int latency);
    void add_dep(schedule_node *before, schedule_node *after);
 
@@ -539,11 +554,22 @@ public:
                             int block_count,
                             instruction_scheduler_mode mode);
    void calculate_deps();
+   void clear_last_grf_write();
    bool is_compressed(fs_inst *inst);
    schedule_node *choose_instruction_to_schedule();
    int issue_time(backend_instruction *inst);
    fs_visitor *v;
 
+   /**
+    * Pre-register-allocation, this tracks the last write per VGRF offset.
+    * After register allocation, reg_offsets are gone and we track individual
+    * GRF registers.
+    *
+    * This is allocated once for the whole program rather than for each
+    * block, and is all NULL between calls to calculate_deps().
+    */
+   schedule_node **last_grf_write;
+
    void count_reads_remaining(backend_instruction *inst);
    void setup_liveness(cfg_t *cfg);
    void update_register_pressure(backend_instruction *inst);
@@ -557,6 +583,8 @@ fs_instruction_scheduler::fs_instruction_scheduler(fs_visitor *v,
    : instruction_scheduler(v, grf_count, hw_reg_count, block_count, mode),
      v(v)
 {
+   this->last_grf_write = rzalloc_array(mem_ctx, schedule_node *,
+                                        grf_count * 16);
 }
 
 static bool
@@ -768,6 +796,9 @@ schedule_node::schedule_node(backend_instruction *inst,
    this->unblocked_time = 0;
    this->cand_generation = 0;
    this->delay = 0;
+   this->is_barrier = false;
+   this->last_parent = NULL;
+   this->last_parent_child = 0;
 
    /* We can't measure Gen6 timings directly but expect them to be much
     * closer to Gen7 than Gen4.
@@ -835,11 +866,15 @@ instruction_scheduler::add_dep(schedule_node *before, schedule_node *after,
 
    assert(before != after);
 
-   for (int i = 0; i < before->child_count; i++) {
-      if (before->children[i] == after) {
-         before->child_latency[i] = MAX2(before->child_latency[i], latency);
-         return;
-      }
+   /* The same dependency tends to be added several times in a row, once for
+    * each register or source the two instructions have in common.  Any
+    * duplicate edge this misses is harmless: it has the same effect on
+    * scheduling as a single edge with the larger latency.
+    */
+   if (after->last_parent == before) {
+      int i = after->last_parent_child;
+      before->child_latency[i] = MAX2(before->child_latency[i], latency);
+      return;
    }
 
    if (before->child_array_size <= before->child_count) {
@@ -857,6 +892,8 @@ instruction_scheduler::add_dep(schedule_node *before, schedule_node *after,
 
    before->children[before->child_count] = after;
    before->child_latency[before->child_count] = latency;
+   after->last_parent = before;
+   after->last_parent_child = before->child_count;
    before->child_count++;
    after->parent_count++;
 }
@@ -872,26 +909,41 @@ instruction_scheduler::add_dep(schedule_node *before, schedule_node *after)
 
 /**
  * Sometimes we really want this node to execute after everything that
- * was before it and before everything that followed it.  This adds
- * the deps to do so.
+ * was before it and before everything that followed it.  This marks it
+ * so that calculate_barrier_deps() adds the deps to do so.
  */
 void
 instruction_scheduler::add_barrier_deps(schedule_node *n)
 {
-   schedule_node *prev = (schedule_node *)n->prev;
-   schedule_node *next = (schedule_node *)n->next;
+   n->is_barrier = true;
+}
 
-   if (prev) {
-      while (!prev->is_head_sentinel()) {
-         add_dep(prev, n, 0);
-         prev = (schedule_node *)prev->prev;
-      }
-   }
+/**
+ * Add the deps for the nodes marked by add_barrier_deps().
+ *
+ * Each barrier is ordered after everything since the previous barrier and
+ * before everything up to the next one.  Because the barriers themselves
+ * end up in a chain, that orders each of them against the whole block,
+ * with a number of deps linear in the size of the block rather than
+ * proportional to the size of the block times the number of barriers.
+ */
+void
+instruction_scheduler::calculate_barrier_deps()
+{
+   schedule_node *prev_barrier = NULL;
 
-   if (next) {
-      while (!next->is_tail_sentinel()) {
-         add_dep(n, next, 0);
-         next = (schedule_node *)next->next;
+   foreach_in_list(schedule_node, n, &instructions) {
+      if (n->is_barrier) {
+         for (schedule_node *prev = (schedule_node *)n->prev;
+              !prev->is_head_sentinel();
+              prev = (schedule_node *)prev->prev) {
+            add_dep(prev, n, 0);
+            if (prev == prev_barrier)
+               break;
+         }
+         prev_barrier = n;
+      } else if (prev_barrier) {
+         add_dep(prev_barrier, n, 0);
       }
    }
 }
@@ -905,14 +957,36 @@ fs_instruction_scheduler::is_compressed(fs_inst *inst)
    return inst->exec_size == 16;
 }
 
+/**
+ * Reset the entries of last_grf_write that the instructions of the block
+ * can have set.  Clearing the whole array instead would cost as much as the
+ * number of VGRFs in the program for each pass over each block.
+ */
+void
+fs_instruction_scheduler::clear_last_grf_write()
+{
+   foreach_in_list(schedule_node, n, &instructions) {
+      fs_inst *inst = (fs_inst *)n->inst;
+
+      if (inst->dst.file == VGRF) {
+         if (post_reg_alloc) {
+            for (int r = 0; r < inst->regs_written; r++)
+               last_grf_write[inst->dst.nr + r] = NULL;
+         } else {
+            for (int r = 0; r < inst->regs_written; r++) {
+               last_grf_write[inst->dst.nr * 16 + inst->dst.reg_offset + r] = NULL;
+            }
+         }
+      } else if (inst->dst.file == FIXED_GRF && post_reg_alloc) {
+         for (int r = 0; r < inst->regs_written; r++)
+            last_grf_write[inst->dst.nr + r] = NULL;
+      }
+   }
+}
+
 void
 fs_instruction_scheduler::calculate_deps()
 {
-   /* Pre-register-allocation, this tracks the last write per VGRF offset.
-    * After register allocation, reg_offsets are gone and we track individual
-    * GRF registers.
-    */
-   schedule_node *last_grf_write[grf_count * 16];
    schedule_node *last_mrf_write[BRW_MAX_MRF(v->devinfo->gen)];
    schedule_node *last_conditional_mod[2] = { NULL, NULL };
    schedule_node *last_accumulator_write = NULL;
@@ -932,7 +1006,6 @@ fs_instruction_scheduler::calculate_deps()
    schedule_node *last = (schedule_node *)instructions.get_tail();
    add_barrier_deps(last);
 
-   memset(last_grf_write, 0, sizeof(last_grf_write));
    memset(last_mrf_write, 0, sizeof(last_mrf_write));
 
    /* top-to-bottom dependencies: RAW and WAW. */
@@ -1050,7 +1123,7 @@ fs_instruction_scheduler::calculate_deps()
    }
 
    /* bottom-to-top dependencies: WAR */
-   memset(last_grf_write, 0, sizeof(last_grf_write));
+   clear_last_grf_write();
    memset(last_mrf_write, 0, sizeof(last_mrf_write));
    memset(last_conditional_mod, 0, sizeof(last_conditional_mod));
    last_accumulator_write = NULL;
@@ -1163,6 +1236,9 @@ fs_instruction_scheduler::calculate_deps()
          last_accumulator_write = n;
       }
    }
+
+   clear_last_grf_write();
+   calculate_barrier_deps();
 }
 
 void
@@ -1358,6 +1434,8 @@ vec4_instruction_scheduler::calculate_deps()
          last_accumulator_write = n;
       }
    }
+
+   calculate_barrier_deps();
 }
 
 schedule_node *
@@ -1384,24 +1462,26 @@ fs_instruction_scheduler::choose_instruction_to_schedule()
        * shaders which naturally do a better job of hiding instruction
        * latency.
        */
+      int chosen_register_pressure_benefit = 0;
+
       foreach_in_list(schedule_node, n, &instructions) {
          fs_inst *inst = (fs_inst *)n->inst;
 
-         if (!chosen) {
-            chosen = n;
-            continue;
-         }
-
          /* Most important: If we can definitely reduce register pressure, do
           * so immediately.
           */
          int register_pressure_benefit = get_register_pressure_benefit(n->inst);
-         int chosen_register_pressure_benefit =
-            get_register_pressure_benefit(chosen->inst);
+
+         if (!chosen) {
+            chosen = n;
+            chosen_register_pressure_benefit = register_pressure_benefit;
+            continue;
+         }
 
          if (register_pressure_benefit > 0 &&
              register_pressure_benefit > chosen_register_pressure_benefit) {
             chosen = n;
+            chosen_register_pressure_benefit = register_pressure_benefit;
             continue;
          } else if (chosen_register_pressure_benefit > 0 &&
                     (register_pressure_benefit <
@@ -1419,6 +1499,7 @@ fs_instruction_scheduler::choose_instruction_to_schedule()
              */
             if (n->cand_generation > chosen->cand_generation) {
                chosen = n;
+               chosen_register_pressure_benefit = register_pressure_benefit;
                continue;
             } else if (n->cand_generation < chosen->cand_generation) {
                continue;
@@ -1441,6 +1522,7 @@ fs_instruction_scheduler::choose_instruction_to_schedule()
                if (inst->regs_written <= inst->exec_size / 8 &&
                    chosen_inst->regs_written > chosen_inst->exec_size / 8) {
                   chosen = n;
+                  chosen_register_pressure_benefit = register_pressure_benefit;
                   continue;
                } else if (inst->regs_written > chosen_inst->regs_written) {
                   continue;
@@ -1456,6 +1538,7 @@ fs_instruction_scheduler::choose_instruction_to_schedule()
           */
          if (n->delay > chosen->delay) {
             chosen = n;
+            chosen_register_pressure_benefit = register_pressure_benefit;
             continue;
          } else if (n->delay < chosen->delay) {
             continue;
@@ -37,6 +37,10 @@ shader_debug_log_mesa(void *data, const char *fmt, ...)
    struct brw_context *brw = (struct brw_context *)data;
    va_list args;
 
+   /* Compiles on a worker thread have no context to report to. */
+   if (brw == NULL)
+      return;
+
    va_start(args, fmt);
    GLuint msg_id = 0;
    _mesa_gl_vdebug(&brw->ctx, &msg_id,
@@ -61,7 +65,7 @@ shader_perf_log_mesa(void *data, const char *fmt, ...)
       va_end(args_copy);
    }
 
-   if (brw->perf_debug) {
+   if (brw && brw->perf_debug) {
       GLuint msg_id = 0;
       _mesa_gl_vdebug(&brw->ctx, &msg_id,
                       MESA_DEBUG_SOURCE_SHADER_COMPILER,
@@ -85,10 +89,11 @@ brw_compiler_create(void *mem_ctx, const struct brw_device_info *devinfo)
 
    compiler->scalar_stage[MESA_SHADER_VERTEX] =
       devinfo->gen >= 8 && !(INTEL_DEBUG & DEBUG_VEC4VS);
-   compiler->scalar_stage[MESA_SHADER_TESS_CTRL] = false;
+   compiler->scalar_stage[MESA_SHADER_TESS_CTRL] =
+      devinfo->gen >= 8 && env_var_as_boolean("INTEL_SCALAR_TCS", true);
    compiler->scalar_stage[MESA_SHADER_TESS_EVAL] = true;
    compiler->scalar_stage[MESA_SHADER_GEOMETRY] =
-      devinfo->gen >= 8 && env_var_as_boolean("INTEL_SCALAR_GS", false);
+      devinfo->gen >= 8 && env_var_as_boolean("INTEL_SCALAR_GS", true);
    compiler->scalar_stage[MESA_SHADER_FRAGMENT] = true;
    compiler->scalar_stage[MESA_SHADER_COMPUTE] = true;
 
@@ -139,6 +144,10 @@ brw_compiler_create(void *mem_ctx, const struct brw_device_info *devinfo)
    }
 
    compiler->glsl_compiler_options[MESA_SHADER_TESS_CTRL].EmitNoIndirectInput = false;
+   /* TCS outputs live in the URB, which we can address indirectly even in
+    * the scalar backend.
+    */
+   compiler->glsl_compiler_options[MESA_SHADER_TESS_CTRL].EmitNoIndirectOutput = false;
    compiler->glsl_compiler_options[MESA_SHADER_TESS_EVAL].EmitNoIndirectInput = false;
 
    if (compiler->scalar_stage[MESA_SHADER_GEOMETRY])
@@ -1285,6 +1294,53 @@ brw_setup_image_uniform_values(gl_shader_stage stage,
    }
 }
 
+unsigned
+tesslevel_outer_components(GLenum tes_primitive_mode)
+{
+   switch (tes_primitive_mode) {
+   case GL_QUADS:
+      return 4;
+   case GL_TRIANGLES:
+      return 3;
+   case GL_ISOLINES:
+      return 2;
+   default:
+      unreachable("Bogus tessellation domain");
+   }
+   return 0;
+}
+
+unsigned
+tesslevel_inner_components(GLenum tes_primitive_mode)
+{
+   switch (tes_primitive_mode) {
+   case GL_QUADS:
+      return 2;
+   case GL_TRIANGLES:
+      return 1;
+   case GL_ISOLINES:
+      return 0;
+   default:
+      unreachable("Bogus tessellation domain");
+   }
+   return 0;
+}
+
+/**
+ * Given a normal .xyzw writemask, convert it to a writemask for a vector
+ * that's stored backwards, i.e. .wzyx.
+ */
+unsigned
+writemask_for_backwards_vector(unsigned mask)
+{
+   unsigned new_mask = 0;
+
+   for (int i = 0; i < 4; i++)
+      new_mask |= ((mask >> i) & 1) << (3 - i);
+
+   return new_mask;
+}
+
 /**
  * Decide which set of clip planes should be used when clipping via
  * gl_Position or gl_ClipVertex.
@@ -1333,6 +1389,7 @@ brw_compile_tes(const struct brw_compiler *compiler,
    nir->info.patch_inputs_read = key->patch_inputs_read;
    nir = brw_nir_lower_io(nir, compiler->devinfo, is_scalar);
    nir = brw_postprocess_nir(nir, compiler->devinfo, is_scalar);
+   brw_nir_log_stats(compiler, log_data, nir);
 
    brw_compute_vue_map(devinfo, &prog_data->base.vue_map,
                        nir->info.outputs_written,
@@ -229,6 +229,10 @@ void brw_setup_image_uniform_values(gl_shader_stage stage,
                                     unsigned param_start_index,
                                     const gl_uniform_storage *storage);
 
+unsigned tesslevel_outer_components(GLenum tes_primitive_mode);
+unsigned tesslevel_inner_components(GLenum tes_primitive_mode);
+unsigned writemask_for_backwards_vector(unsigned mask);
+
 #else
 struct backend_shader;
 #endif /* __cplusplus */
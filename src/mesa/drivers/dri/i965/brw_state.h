@@ -34,6 +34,7 @@
 #define BRW_STATE_H
 
 #include "brw_context.h"
+#include "util/disk_cache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -242,8 +243,50 @@ bool brw_search_cache(struct brw_cache *cache,
 		      const void *key,
 		      GLuint key_size,
 		      uint32_t *inout_offset, void *inout_aux);
+bool brw_replace_cache(struct brw_cache *cache,
+                       enum brw_cache_id cache_id,
+                       const void *key,
+                       GLuint key_size,
+                       const void *data,
+                       GLuint data_size,
+                       const void *aux,
+                       GLuint aux_size,
+                       uint32_t *inout_offset, void *inout_aux);
 void brw_state_cache_check_size( struct brw_context *brw );
 
+/**
+ * State carried from brw_disk_cache_load_prog() to
+ * brw_disk_cache_store_prog() across a compile.
+ */
+struct brw_disk_cache_prog {
+   /** Whether the compiled program should be written to the disk cache. */
+   bool enabled;
+
+   cache_key key;
+
+   /** prog_data->param as set up before compiling. */
+   const union gl_constant_value **params;
+   GLuint nr_params;
+};
+
+bool brw_disk_cache_load_prog(struct brw_context *brw, void *mem_ctx,
+                              struct brw_disk_cache_prog *dc,
+                              enum brw_cache_id cache_id,
+                              const void *key, GLuint key_size,
+                              GLuint program_string_id_offset,
+                              uint32_t flags,
+                              const struct gl_program *prog,
+                              struct brw_stage_prog_data *prog_data,
+                              GLuint prog_data_size,
+                              const GLuint **program,
+                              GLuint *program_size);
+void brw_disk_cache_store_prog(struct brw_context *brw,
+                               const struct brw_disk_cache_prog *dc,
+                               const GLuint *program,
+                               GLuint program_size,
+                               const struct brw_stage_prog_data *prog_data,
+                               GLuint prog_data_size);
+
 void brw_init_caches( struct brw_context *brw );
 void brw_destroy_caches( struct brw_context *brw );
 
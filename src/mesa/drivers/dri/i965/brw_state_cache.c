@@ -52,6 +52,9 @@
 #include "brw_gs.h"
 #include "brw_cs.h"
 #include "brw_program.h"
+#include "glsl/nir/nir_serialize.h"
+#include "util/hash_table.h"
+#include "util/mesa-sha1.h"
 
 #define FILE_DEBUG_FLAG DEBUG_STATE
 
@@ -267,6 +270,20 @@ brw_alloc_item_data(struct brw_cache *cache, uint32_t size)
    return offset;
 }
 
+static void
+brw_upload_item_data(struct brw_cache *cache, struct brw_cache_item *item,
+                     const void *data)
+{
+   struct brw_context *brw = cache->brw;
+
+   /* Copy data to the buffer */
+   if (brw->has_llc) {
+      memcpy((char *)cache->bo->virtual + item->offset, data, item->size);
+   } else {
+      drm_intel_bo_subdata(cache->bo, item->offset, item->size, data);
+   }
+}
+
 void
 brw_upload_cache(struct brw_cache *cache,
 		 enum brw_cache_id cache_id,
@@ -279,7 +296,6 @@ brw_upload_cache(struct brw_cache *cache,
 		 uint32_t *out_offset,
 		 void *out_aux)
 {
-   struct brw_context *brw = cache->brw;
    struct brw_cache_item *item = CALLOC_STRUCT(brw_cache_item);
    const struct brw_cache_item *matching_data =
       brw_lookup_prog(cache, cache_id, data, data_size);
@@ -304,13 +320,7 @@ brw_upload_cache(struct brw_cache *cache,
       item->offset = matching_data->offset;
    } else {
       item->offset = brw_alloc_item_data(cache, data_size);
-
-      /* Copy data to the buffer */
-      if (brw->has_llc) {
-         memcpy((char *)cache->bo->virtual + item->offset, data, data_size);
-      } else {
-         drm_intel_bo_subdata(cache->bo, item->offset, data_size, data);
-      }
+      brw_upload_item_data(cache, item, data);
    }
 
    /* Set up the memory containing the key and aux_data */
@@ -334,6 +344,381 @@ brw_upload_cache(struct brw_cache *cache,
    cache->brw->ctx.NewDriverState |= 1 << cache_id;
 }
 
+/**
+ * Replace the program stored under \p key with a new one, such as a better
+ * variant of it that was compiled in the background.
+ *
+ * Only for program caches, whose aux data is a brw_stage_prog_data.  The old
+ * aux data is freed and overwritten in place, so pointers to it stay valid;
+ * if \p inout_aux points to it, \p inout_offset is updated to the new
+ * program.
+ *
+ * \return false if there is nothing stored under \p key (for example because
+ * the cache was cleared since), in which case nothing is uploaded.
+ */
+bool
+brw_replace_cache(struct brw_cache *cache,
+                  enum brw_cache_id cache_id,
+                  const void *key,
+                  GLuint key_size,
+                  const void *data,
+                  GLuint data_size,
+                  const void *aux,
+                  GLuint aux_size,
+                  uint32_t *inout_offset,
+                  void *inout_aux)
+{
+   struct brw_cache_item *item;
+   struct brw_cache_item lookup;
+   GLuint hash;
+
+   lookup.cache_id = cache_id;
+   lookup.key = key;
+   lookup.key_size = key_size;
+   hash = hash_key(&lookup);
+   lookup.hash = hash;
+
+   item = search_cache(cache, hash, &lookup);
+
+   if (item == NULL)
+      return false;
+
+   assert(item->aux_size == aux_size);
+
+   item->size = data_size;
+   item->offset = brw_alloc_item_data(cache, data_size);
+   brw_upload_item_data(cache, item, data);
+
+   void *item_aux = ((char *) item->key) + item->key_size;
+   brw_stage_prog_data_free(item_aux);
+   memcpy(item_aux, aux, aux_size);
+
+   if (*((void **) inout_aux) == item_aux) {
+      *inout_offset = item->offset;
+      cache->brw->ctx.NewDriverState |= 1 << cache_id;
+   }
+
+   return true;
+}
+
+/**
+ * \name On-disk program cache
+ *
+ * Compiled programs are also written to the shader cache in util/disk_cache,
+ * so that they outlive the context.  Entries are named by a SHA-1 of the
+ * stage's prog key, the serialized NIR of the program and the rest of the
+ * state the compile depends on.  program_string_id is left out of the name
+ * since it is only unique within one run.
+ *
+ * An entry holds the prog_data and the kernel.  prog_data->param and
+ * pull_param point into uniform storage, which moves from run to run, so
+ * they are stored as indices into the param array that
+ * brw_nir_setup_*_uniforms() built before compiling.  That array is built
+ * the same way again before a lookup.  A program whose params point
+ * anywhere else (user clip planes, for example) isn't stored.
+ * @{
+ */
+
+#ifdef ENABLE_SHADER_CACHE
+
+static bool
+brw_disk_cache_enabled(struct brw_context *brw)
+{
+   /* Shader time indices are per context, and anyone asking for a dump
+    * wants to see the compile happen.
+    */
+   const uint64_t no_cache_flags = DEBUG_SHADER_TIME | DEBUG_VS | DEBUG_TCS |
+                                   DEBUG_TES | DEBUG_GS | DEBUG_WM | DEBUG_CS;
+
+   return brw->intelScreen->disk_cache != NULL &&
+          !(INTEL_DEBUG & no_cache_flags);
+}
+
+static bool
+brw_disk_cache_compute_key(struct brw_context *brw, void *mem_ctx,
+                           enum brw_cache_id cache_id,
+                           const void *key, GLuint key_size,
+                           GLuint program_string_id_offset,
+                           uint32_t flags,
+                           const struct gl_program *prog,
+                           const struct brw_stage_prog_data *prog_data,
+                           cache_key result)
+{
+   static const char build_id[] = PACKAGE_VERSION;
+   const struct intel_screen *screen = brw->intelScreen;
+
+   uint8_t *stable_key = ralloc_size(mem_ctx, key_size);
+   memcpy(stable_key, key, key_size);
+   memset(stable_key + program_string_id_offset, 0, sizeof(uint32_t));
+
+   struct blob *nir = blob_create(mem_ctx);
+   nir_serialize(nir, prog->nir);
+
+   struct mesa_sha1 *ctx = _mesa_sha1_init();
+   if (ctx == NULL)
+      return false;
+
+   _mesa_sha1_update(ctx, build_id, sizeof(build_id));
+   _mesa_sha1_update(ctx, &screen->deviceID, sizeof(screen->deviceID));
+   _mesa_sha1_update(ctx, screen->compiler->scalar_stage,
+                     sizeof(screen->compiler->scalar_stage));
+   _mesa_sha1_update(ctx, &INTEL_DEBUG, sizeof(INTEL_DEBUG));
+   _mesa_sha1_update(ctx, &cache_id, sizeof(cache_id));
+   _mesa_sha1_update(ctx, &flags, sizeof(flags));
+   _mesa_sha1_update(ctx, &prog_data->nr_params, sizeof(prog_data->nr_params));
+   _mesa_sha1_update(ctx, &prog_data->nr_image_params,
+                     sizeof(prog_data->nr_image_params));
+   _mesa_sha1_update(ctx, stable_key, key_size);
+   _mesa_sha1_update(ctx, nir->data, nir->size);
+   return _mesa_sha1_final(ctx, result);
+}
+
+static const union gl_constant_value *
+brw_disk_cache_decode_param(const struct brw_disk_cache_prog *dc,
+                            uint32_t index)
+{
+   return index == 0 ? NULL : dc->params[index - 1];
+}
+
+/**
+ * Look up the program about to be compiled in the disk cache.
+ *
+ * Must be called once prog_data has been set up for compiling, that is with
+ * the binding table assigned and the uniforms set up.  On a hit, the rest of
+ * prog_data is filled in, the kernel is returned in \p program (allocated
+ * out of \p mem_ctx) and true is returned.  Otherwise \p dc is set up for
+ * brw_disk_cache_store_prog() to be called after the compile.
+ *
+ * \p flags should hold anything besides the key and the NIR that the
+ * compile depends on.
+ */
+bool
+brw_disk_cache_load_prog(struct brw_context *brw, void *mem_ctx,
+                         struct brw_disk_cache_prog *dc,
+                         enum brw_cache_id cache_id,
+                         const void *key, GLuint key_size,
+                         GLuint program_string_id_offset,
+                         uint32_t flags,
+                         const struct gl_program *prog,
+                         struct brw_stage_prog_data *prog_data,
+                         GLuint prog_data_size,
+                         const GLuint **program,
+                         GLuint *program_size)
+{
+   struct intel_screen *screen = brw->intelScreen;
+
+   dc->enabled = false;
+
+   if (!brw_disk_cache_enabled(brw) || prog->nir == NULL)
+      return false;
+
+   if (!brw_disk_cache_compute_key(brw, mem_ctx, cache_id, key, key_size,
+                                   program_string_id_offset, flags, prog,
+                                   prog_data, dc->key))
+      return false;
+
+   dc->nr_params = prog_data->nr_params;
+   dc->params = ralloc_array(mem_ctx, const union gl_constant_value *,
+                             dc->nr_params);
+   memcpy(dc->params, prog_data->param,
+          dc->nr_params * sizeof(*dc->params));
+   dc->enabled = true;
+
+   size_t size;
+   pthread_mutex_lock(&screen->disk_cache_mutex);
+   uint8_t *data = disk_cache_get(screen->disk_cache, dc->key, &size);
+   pthread_mutex_unlock(&screen->disk_cache_mutex);
+
+   if (data == NULL)
+      return false;
+
+   struct blob_reader blob;
+   blob_reader_init(&blob, data, size);
+
+   uint32_t stored_program_size = blob_read_uint32(&blob);
+   uint32_t stored_prog_data_size = blob_read_uint32(&blob);
+   uint32_t nr_params = blob_read_uint32(&blob);
+   uint32_t nr_pull_params = blob_read_uint32(&blob);
+
+   bool valid = !blob.overrun &&
+                stored_prog_data_size == prog_data_size &&
+                nr_params <= dc->nr_params &&
+                nr_pull_params <= dc->nr_params;
+
+   const struct brw_stage_prog_data *stored_prog_data = NULL;
+   const uint32_t *param = NULL, *pull_param = NULL;
+   const void *kernel = NULL;
+   if (valid) {
+      stored_prog_data = blob_read_bytes(&blob, prog_data_size);
+      param = blob_read_bytes(&blob, nr_params * sizeof(uint32_t));
+      pull_param = blob_read_bytes(&blob, nr_pull_params * sizeof(uint32_t));
+      kernel = blob_read_bytes(&blob, stored_program_size);
+      valid = !blob.overrun && blob.current == blob.end;
+   }
+
+   for (unsigned i = 0; valid && i < nr_params; i++)
+      valid = param[i] <= dc->nr_params;
+   for (unsigned i = 0; valid && i < nr_pull_params; i++)
+      valid = pull_param[i] <= dc->nr_params;
+
+   if (!valid) {
+      perf_debug("Dropping corrupt program from the disk cache.\n");
+      pthread_mutex_lock(&screen->disk_cache_mutex);
+      disk_cache_remove(screen->disk_cache, dc->key);
+      pthread_mutex_unlock(&screen->disk_cache_mutex);
+      free(data);
+      return false;
+   }
+
+   /* The arrays were allocated by the caller and belong to the state cache
+    * from here on, so keep them and only take the rest of the prog_data.
+    */
+   const union gl_constant_value **params = prog_data->param;
+   const union gl_constant_value **pull_params = prog_data->pull_param;
+   struct brw_image_param *image_param = prog_data->image_param;
+   unsigned nr_image_params = prog_data->nr_image_params;
+
+   memcpy(prog_data, stored_prog_data, prog_data_size);
+
+   prog_data->param = params;
+   prog_data->pull_param = pull_params;
+   prog_data->image_param = image_param;
+   prog_data->nr_params = nr_params;
+   prog_data->nr_pull_params = nr_pull_params;
+   prog_data->nr_image_params = nr_image_params;
+
+   for (unsigned i = 0; i < nr_params; i++)
+      params[i] = brw_disk_cache_decode_param(dc, param[i]);
+   for (unsigned i = 0; i < nr_pull_params; i++)
+      pull_params[i] = brw_disk_cache_decode_param(dc, pull_param[i]);
+
+   GLuint *copy = ralloc_size(mem_ctx, stored_program_size);
+   memcpy(copy, kernel, stored_program_size);
+   *program = copy;
+   *program_size = stored_program_size;
+
+   free(data);
+
+   dc->enabled = false;
+   return true;
+}
+
+static bool
+brw_disk_cache_write_params(struct blob *blob, struct hash_table *indices,
+                            const union gl_constant_value **params,
+                            GLuint count)
+{
+   for (unsigned i = 0; i < count; i++) {
+      uint32_t index = 0;
+
+      if (params[i] != NULL) {
+         struct hash_entry *entry =
+            _mesa_hash_table_search(indices, params[i]);
+         if (entry == NULL)
+            return false;
+         index = (uintptr_t) entry->data;
+      }
+
+      blob_write_uint32(blob, index);
+   }
+
+   return true;
+}
+
+/**
+ * Write a program that brw_disk_cache_load_prog() didn't find to the disk
+ * cache, once it has been compiled.
+ */
+void
+brw_disk_cache_store_prog(struct brw_context *brw,
+                          const struct brw_disk_cache_prog *dc,
+                          const GLuint *program,
+                          GLuint program_size,
+                          const struct brw_stage_prog_data *prog_data,
+                          GLuint prog_data_size)
+{
+   struct intel_screen *screen = brw->intelScreen;
+
+   if (!dc->enabled)
+      return;
+
+   /* Index 0 stands for NULL, so setup param i is stored as i + 1. */
+   struct hash_table *indices =
+      _mesa_hash_table_create(NULL, _mesa_hash_pointer,
+                              _mesa_key_pointer_equal);
+   for (unsigned i = 0; i < dc->nr_params; i++) {
+      if (dc->params[i] != NULL &&
+          _mesa_hash_table_search(indices, dc->params[i]) == NULL) {
+         _mesa_hash_table_insert(indices, dc->params[i],
+                                 (void *) (uintptr_t) (i + 1));
+      }
+   }
+
+   struct brw_stage_prog_data *stored_prog_data = malloc(prog_data_size);
+   memcpy(stored_prog_data, prog_data, prog_data_size);
+   stored_prog_data->param = NULL;
+   stored_prog_data->pull_param = NULL;
+   stored_prog_data->image_param = NULL;
+
+   struct blob *blob = blob_create(NULL);
+   blob_write_uint32(blob, program_size);
+   blob_write_uint32(blob, prog_data_size);
+   blob_write_uint32(blob, prog_data->nr_params);
+   blob_write_uint32(blob, prog_data->nr_pull_params);
+   blob_write_bytes(blob, stored_prog_data, prog_data_size);
+
+   if (brw_disk_cache_write_params(blob, indices, prog_data->param,
+                                   prog_data->nr_params) &&
+       brw_disk_cache_write_params(blob, indices, prog_data->pull_param,
+                                   prog_data->nr_pull_params)) {
+      blob_write_bytes(blob, program, program_size);
+
+      pthread_mutex_lock(&screen->disk_cache_mutex);
+      disk_cache_put(screen->disk_cache, dc->key, blob->data, blob->size);
+      pthread_mutex_unlock(&screen->disk_cache_mutex);
+   } else {
+      perf_debug("Not writing program with params outside uniform storage "
+                 "to the disk cache.\n");
+   }
+
+   ralloc_free(blob);
+   free(stored_prog_data);
+   _mesa_hash_table_destroy(indices, NULL);
+}
+
+#else
+
+bool
+brw_disk_cache_load_prog(struct brw_context *brw, void *mem_ctx,
+                         struct brw_disk_cache_prog *dc,
+                         enum brw_cache_id cache_id,
+                         const void *key, GLuint key_size,
+                         GLuint program_string_id_offset,
+                         uint32_t flags,
+                         const struct gl_program *prog,
+                         struct brw_stage_prog_data *prog_data,
+                         GLuint prog_data_size,
+                         const GLuint **program,
+                         GLuint *program_size)
+{
+   dc->enabled = false;
+   return false;
+}
+
+void
+brw_disk_cache_store_prog(struct brw_context *brw,
+                          const struct brw_disk_cache_prog *dc,
+                          const GLuint *program,
+                          GLuint program_size,
+                          const struct brw_stage_prog_data *prog_data,
+                          GLuint prog_data_size)
+{
+}
+
+#endif /* ENABLE_SHADER_CACHE */
+
+/** @} */
+
 void
 brw_init_caches(struct brw_context *brw)
 {
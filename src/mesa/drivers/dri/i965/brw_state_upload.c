@@ -472,6 +472,9 @@ void brw_init_state( struct brw_context *brw )
 
    brw_init_caches(brw);
 
+   if (INTEL_DEBUG & DEBUG_PACKETS)
+      brw->atom_stats = calloc(BRW_MAX_ATOMS, sizeof(*brw->atom_stats));
+
    if (brw->gen >= 8) {
       brw_copy_pipeline_atoms(brw, BRW_RENDER_PIPELINE,
                               gen8_render_atoms,
@@ -524,6 +527,7 @@ void brw_init_state( struct brw_context *brw )
 void brw_destroy_state( struct brw_context *brw )
 {
    brw_destroy_caches(brw);
+   free(brw->atom_stats);
 }
 
 /***********************************************************************
@@ -745,17 +749,97 @@ merge_ctx_state(struct brw_context *brw,
    state->brw |= brw->ctx.NewDriverState;
 }
 
+/**
+ * Emit an atom, dropping what it emitted again if it's the same as the last
+ * time in this batch, and keep count for INTEL_DEBUG=packets.
+ */
+static void
+emit_atom_dedup(struct brw_context *brw,
+                const struct brw_tracked_state *atom,
+                unsigned slot)
+{
+   const drm_intel_bo *bo = brw->batch.bo;
+   const uint32_t start = USED_BATCH(brw->batch);
+#ifndef NDEBUG
+   const int reloc_count = drm_intel_gem_bo_get_reloc_count(brw->batch.bo);
+#endif
+
+   atom->emit(brw);
+
+   /* If the batch was flushed in the middle, the start of what was emitted
+    * is gone.
+    */
+   if (brw->batch.bo != bo)
+      return;
+
+   assert(!atom->dedup ||
+          drm_intel_gem_bo_get_reloc_count(brw->batch.bo) == reloc_count);
+
+   const uint32_t size = USED_BATCH(brw->batch) - start;
+   const bool repeated = intel_batchbuffer_repeats(brw, slot, start);
+   const bool drop = repeated && atom->dedup &&
+                     !(INTEL_DEBUG & DEBUG_NO_DEDUP);
+
+   if (unlikely(INTEL_DEBUG & DEBUG_PACKETS)) {
+      struct brw_atom_stats *stats = &brw->atom_stats[slot];
+
+      stats->emits++;
+      stats->bytes += size * 4;
+      stats->repeated += repeated;
+      stats->dropped += drop;
+      if (size > 0)
+         stats->opcode = brw->batch.map[start] >> 16;
+   }
+
+   if (drop)
+      brw->batch.map_next = brw->batch.map + start;
+}
+
 static inline void
 check_and_emit_atom(struct brw_context *brw,
                     struct brw_state_flags *state,
-                    const struct brw_tracked_state *atom)
+                    const struct brw_tracked_state *atom,
+                    unsigned slot)
 {
    if (check_state(state, &atom->dirty)) {
-      atom->emit(brw);
+      if (atom->dedup || unlikely(INTEL_DEBUG & DEBUG_PACKETS))
+         emit_atom_dedup(brw, atom, slot);
+      else
+         atom->emit(brw);
       merge_ctx_state(brw, state);
    }
 }
 
+static void
+brw_print_atom_stats(struct brw_context *brw)
+{
+   uint64_t bytes = 0;
+   uint32_t emits = 0, repeated = 0, dropped = 0;
+
+   for (unsigned i = 0; i < BRW_MAX_ATOMS; i++) {
+      const struct brw_atom_stats *stats = &brw->atom_stats[i];
+
+      if (stats->emits == 0)
+         continue;
+
+      fprintf(stderr, "%s atom %2u (0x%04x): %10u emits, %12"PRIu64" bytes, "
+              "%10u repeated, %10u dropped\n",
+              i < BRW_MAX_RENDER_ATOMS ? "render " : "compute",
+              i < BRW_MAX_RENDER_ATOMS ? i : i - BRW_MAX_RENDER_ATOMS,
+              stats->opcode, stats->emits, stats->bytes,
+              stats->repeated, stats->dropped);
+
+      emits += stats->emits;
+      bytes += stats->bytes;
+      repeated += stats->repeated;
+      dropped += stats->dropped;
+   }
+
+   fprintf(stderr, "total:                %10u emits, %12"PRIu64" bytes, "
+           "%10u repeated, %10u dropped\n\n",
+           emits, bytes, repeated, dropped);
+}
+
 static inline void
 brw_upload_pipeline_state(struct brw_context *brw,
                           enum brw_pipeline pipeline)
@@ -775,6 +859,8 @@ brw_upload_pipeline_state(struct brw_context *brw,
    }
 
    if (pipeline == BRW_RENDER_PIPELINE) {
+      brw_wm_async_collect(brw);
+
       if (brw->fragment_program != ctx->FragmentProgram._Current) {
          brw->fragment_program = ctx->FragmentProgram._Current;
          brw->ctx.NewDriverState |= BRW_NEW_FRAGMENT_PROGRAM;
@@ -831,6 +917,8 @@ brw_upload_pipeline_state(struct brw_context *brw,
    const struct brw_tracked_state *atoms =
       brw_get_pipeline_atoms(brw, pipeline);
    const int num_atoms = brw->num_atoms[pipeline];
+   const unsigned first_slot =
+      pipeline == BRW_RENDER_PIPELINE ? 0 : BRW_MAX_RENDER_ATOMS;
 
    if (unlikely(INTEL_DEBUG)) {
       /* Debug version which enforces various sanity checks on the
@@ -845,7 +933,7 @@ brw_upload_pipeline_state(struct brw_context *brw,
 	 const struct brw_tracked_state *atom = &atoms[i];
 	 struct brw_state_flags generated;
 
-         check_and_emit_atom(brw, &state, atom);
+         check_and_emit_atom(brw, &state, atom, first_slot + i);
 
 	 accumulate_state(&examined, &atom->dirty);
 
@@ -862,7 +950,7 @@ brw_upload_pipeline_state(struct brw_context *brw,
       for (i = 0; i < num_atoms; i++) {
 	 const struct brw_tracked_state *atom = &atoms[i];
 
-         check_and_emit_atom(brw, &state, atom);
+         check_and_emit_atom(brw, &state, atom, first_slot + i);
       }
    }
 
@@ -877,6 +965,13 @@ brw_upload_pipeline_state(struct brw_context *brw,
 	 fprintf(stderr, "\n");
       }
    }
+
+   if (unlikely(INTEL_DEBUG & DEBUG_PACKETS)) {
+      static int upload_count = 0;
+
+      if (upload_count++ % 1000 == 0)
+         brw_print_atom_stats(brw);
+   }
 }
 
 /***********************************************************************
@@ -104,7 +104,9 @@ brw_codegen_tcs_prog(struct brw_context *brw,
       const nir_shader_compiler_options *options =
          ctx->Const.ShaderCompilerOptions[MESA_SHADER_TESS_CTRL].NirOptions;
       nir = nir_shader_create(NULL, MESA_SHADER_TESS_CTRL, options);
-      nir->num_uniforms = 2; /* both halves of the patch header */
+      /* both halves of the patch header; the scalar backend counts bytes */
+      nir->num_uniforms =
+         compiler->scalar_stage[MESA_SHADER_TESS_CTRL] ? 8 * 4 : 2;
       nir->info.outputs_written = key->outputs_written;
       nir->info.inputs_read = key->outputs_written;
       nir->info.tcs.vertices_out = key->input_vertices;
@@ -139,7 +141,8 @@ brw_codegen_tcs_prog(struct brw_context *brw,
       prog_data.base.base.nr_image_params = tcs->NumImages;
 
       brw_nir_setup_glsl_uniforms(nir, shader_prog, &tcp->program.Base,
-                                  &prog_data.base.base, false);
+                                  &prog_data.base.base,
+                                  compiler->scalar_stage[MESA_SHADER_TESS_CTRL]);
    } else {
       /* Upload the Patch URB Header as the first two uniforms.
        * Do the annoying scrambling so the shader doesn't have to.
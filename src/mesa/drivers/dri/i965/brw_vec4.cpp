@@ -1970,6 +1970,7 @@ brw_compile_vs(const struct brw_compiler *compiler, void *log_data,
                                       compiler->scalar_stage[MESA_SHADER_VERTEX]);
    shader = brw_postprocess_nir(shader, compiler->devinfo,
                                 compiler->scalar_stage[MESA_SHADER_VERTEX]);
+   brw_nir_log_stats(compiler, log_data, shader);
 
    const unsigned *assembly = NULL;
 
@@ -622,6 +622,7 @@ brw_compile_gs(const struct brw_compiler *compiler, void *log_data,
                                       compiler->scalar_stage[MESA_SHADER_GEOMETRY]);
    shader = brw_postprocess_nir(shader, compiler->devinfo,
                                 compiler->scalar_stage[MESA_SHADER_GEOMETRY]);
+   brw_nir_log_stats(compiler, log_data, shader);
 
    prog_data->include_primitive_id =
       (shader->info.inputs_read & VARYING_BIT_PRIMITIVE_ID) != 0;
@@ -829,9 +830,6 @@ brw_compile_gs(const struct brw_compiler *compiler, void *log_data,
    }
 
    if (compiler->scalar_stage[MESA_SHADER_GEOMETRY]) {
-      /* TODO: Support instanced GS.  We have basically no tests... */
-      assert(prog_data->invocations == 1);
-
       fs_visitor v(compiler, log_data, mem_ctx, &c, prog_data, shader,
                    shader_time_index);
       if (v.run_gs()) {
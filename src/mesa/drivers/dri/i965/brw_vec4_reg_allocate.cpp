@@ -116,6 +116,7 @@ brw_vec4_alloc_reg_set(struct brw_compiler *compiler)
    compiler->vec4_reg_set.regs = ra_alloc_reg_set(compiler, ra_reg_count, false);
    if (compiler->devinfo->gen >= 6)
       ra_set_allocate_round_robin(compiler->vec4_reg_set.regs);
+   ra_set_parallel_interference(compiler->vec4_reg_set.regs, 0);
    ralloc_free(compiler->vec4_reg_set.classes);
    compiler->vec4_reg_set.classes = ralloc_array(compiler, int, class_count);
 
@@ -213,13 +214,20 @@ vec4_visitor::reg_allocate()
       int size = this->alloc.sizes[i];
       assert(size >= 1 && size <= MAX_VGRF_SIZE);
       ra_set_node_class(g, i, compiler->vec4_reg_set.classes[size - 1]);
+   }
 
-      for (unsigned j = 0; j < i; j++) {
-	 if (virtual_grf_interferes(i, j)) {
-	    ra_add_node_interference(g, i, j);
-	 }
-      }
+   /* The same ranges virtual_grf_interferes() compares, but without going
+    * through every pair of VGRFs.
+    */
+   int *start = ralloc_array(mem_ctx, int, alloc.count);
+   int *end = ralloc_array(mem_ctx, int, alloc.count);
+   for (unsigned i = 0; i < alloc.count; i++) {
+      start[i] = var_range_start(4 * alloc.offsets[i], 4 * alloc.sizes[i]);
+      end[i] = var_range_end(4 * alloc.offsets[i], 4 * alloc.sizes[i]);
    }
+   ra_add_live_range_interference(g, 0, alloc.count, start, end);
+   ralloc_free(start);
+   ralloc_free(end);
 
    /* Certain instructions can't safely use the same register for their
     * sources and destination.  Add interference.
@@ -146,11 +146,11 @@ brw_codegen_vs_prog(struct brw_context *brw,
       outputs_written |= BITFIELD64_BIT(VARYING_SLOT_CLIP_DIST1);
    }
 
+   const bool separate = prog ? prog->SeparateShader ||
+                                prog->_LinkedShaders[MESA_SHADER_TESS_EVAL]
+                              : false;
    brw_compute_vue_map(brw->intelScreen->devinfo,
-                       &prog_data.base.vue_map, outputs_written,
-                       prog ? prog->SeparateShader ||
-                              prog->_LinkedShaders[MESA_SHADER_TESS_EVAL]
-                            : false);
+                       &prog_data.base.vue_map, outputs_written, separate);
 
    if (0) {
       _mesa_fprint_program_opt(stderr, &vp->program.Base, PROG_PRINT_DEBUG,
@@ -176,22 +176,36 @@ brw_codegen_vs_prog(struct brw_context *brw,
 
    /* Emit GEN4 code.
     */
-   char *error_str;
-   program = brw_compile_vs(compiler, brw, mem_ctx, key,
-                            &prog_data, vp->program.Base.nir,
-                            brw_select_clip_planes(&brw->ctx),
-                            !_mesa_is_gles3(&brw->ctx),
-                            st_index, &program_size, &error_str);
-   if (program == NULL) {
-      if (prog) {
-         prog->LinkStatus = false;
-         ralloc_strcat(&prog->InfoLog, error_str);
-      }
+   struct brw_disk_cache_prog disk_cache;
+   if (!brw_disk_cache_load_prog(brw, mem_ctx, &disk_cache, BRW_CACHE_VS_PROG,
+                                 key, sizeof(struct brw_vs_prog_key),
+                                 offsetof(struct brw_vs_prog_key,
+                                          program_string_id),
+                                 !_mesa_is_gles3(&brw->ctx) | separate << 1,
+                                 &vp->program.Base, stage_prog_data,
+                                 sizeof(prog_data),
+                                 &program, &program_size)) {
+      char *error_str;
+      program = brw_compile_vs(compiler, brw, mem_ctx, key,
+                               &prog_data, vp->program.Base.nir,
+                               brw_select_clip_planes(&brw->ctx),
+                               !_mesa_is_gles3(&brw->ctx),
+                               st_index, &program_size, &error_str);
+      if (program == NULL) {
+         if (prog) {
+            prog->LinkStatus = false;
+            ralloc_strcat(&prog->InfoLog, error_str);
+         }
 
-      _mesa_problem(NULL, "Failed to compile vertex shader: %s\n", error_str);
+         _mesa_problem(NULL, "Failed to compile vertex shader: %s\n",
+                       error_str);
+
+         ralloc_free(mem_ctx);
+         return false;
+      }
 
-      ralloc_free(mem_ctx);
-      return false;
+      brw_disk_cache_store_prog(brw, &disk_cache, program, program_size,
+                                stage_prog_data, sizeof(prog_data));
    }
 
    if (unlikely(brw->perf_debug) && vs) {
@@ -133,21 +133,42 @@ brw_codegen_wm_prog(struct brw_context *brw,
       st_index16 = brw_get_shader_time_index(brw, prog, &fp->program.Base, ST_FS16);
    }
 
-   char *error_str = NULL;
-   program = brw_compile_fs(brw->intelScreen->compiler, brw, mem_ctx,
-                            key, &prog_data, fp->program.Base.nir,
-                            &fp->program.Base, st_index8, st_index16,
-                            brw->use_rep_send, &program_size, &error_str);
-   if (program == NULL) {
-      if (prog) {
-         prog->LinkStatus = false;
-         ralloc_strcat(&prog->InfoLog, error_str);
-      }
+   struct brw_disk_cache_prog disk_cache;
+   if (!brw_disk_cache_load_prog(brw, mem_ctx, &disk_cache, BRW_CACHE_FS_PROG,
+                                 key, sizeof(struct brw_wm_prog_key),
+                                 offsetof(struct brw_wm_prog_key,
+                                          program_string_id),
+                                 brw->use_rep_send, &fp->program.Base,
+                                 &prog_data.base, sizeof(prog_data),
+                                 &program, &program_size)) {
+      /* Get a SIMD8 program out quickly and build SIMD16 in the
+       * background when we can.
+       */
+      const bool deferred =
+         brw_wm_async_queue(brw, key, &prog_data, fp->program.Base.nir,
+                            &disk_cache);
+
+      char *error_str = NULL;
+      program = brw_compile_fs(brw->intelScreen->compiler, brw, mem_ctx,
+                               key, &prog_data, fp->program.Base.nir,
+                               &fp->program.Base, st_index8, st_index16,
+                               brw->use_rep_send, !deferred,
+                               &program_size, &error_str);
+      if (program == NULL) {
+         if (prog) {
+            prog->LinkStatus = false;
+            ralloc_strcat(&prog->InfoLog, error_str);
+         }
 
-      _mesa_problem(NULL, "Failed to compile fragment shader: %s\n", error_str);
+         _mesa_problem(NULL, "Failed to compile fragment shader: %s\n",
+                       error_str);
+
+         ralloc_free(mem_ctx);
+         return false;
+      }
 
-      ralloc_free(mem_ctx);
-      return false;
+      brw_disk_cache_store_prog(brw, &disk_cache, program, program_size,
+                                &prog_data.base, sizeof(prog_data));
    }
 
    if (unlikely(brw->perf_debug) && fs) {
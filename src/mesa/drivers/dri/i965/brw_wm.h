@@ -68,6 +68,16 @@ void brw_wm_debug_recompile(struct brw_context *brw,
                             struct gl_shader_program *prog,
                             const struct brw_wm_prog_key *key);
 
+/* brw_wm_async.c */
+struct brw_disk_cache_prog;
+bool brw_wm_async_queue(struct brw_context *brw,
+                        const struct brw_wm_prog_key *key,
+                        const struct brw_wm_prog_data *prog_data,
+                        const struct nir_shader *nir,
+                        struct brw_disk_cache_prog *disk_cache);
+void brw_wm_async_collect(struct brw_context *brw);
+void brw_wm_async_destroy(struct brw_context *brw);
+
 void
 brw_upload_wm_prog(struct brw_context *brw);
 
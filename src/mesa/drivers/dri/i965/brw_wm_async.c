@@ -0,0 +1,327 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file brw_wm_async.c
+ *
+ * Building the SIMD16 program of a fragment shader roughly doubles the time
+ * it takes before the shader can be used for its first draw.  To avoid that,
+ * brw_codegen_wm_prog() can build only the SIMD8 program and queue a job
+ * here that compiles the full SIMD8 + SIMD16 program on a worker thread.
+ * Once the job is done, brw_wm_async_collect() replaces the SIMD8 program in
+ * the program cache with the full one.
+ *
+ * The worker only runs the backend compiler, which doesn't use the context:
+ * a job has its own copies of the key, the NIR and the prog_data, and its own
+ * ralloc context.  Everything involving the context (the program cache,
+ * scratch space, the disk cache) happens in brw_wm_async_collect() on the
+ * context's thread.
+ */
+
+#include <pthread.h>
+
+#include "util/list.h"
+#include "util/ralloc.h"
+#include "util/u_atomic.h"
+#include "glsl/nir/nir.h"
+#include "brw_context.h"
+#include "brw_state.h"
+#include "brw_wm.h"
+#include "brw_program.h"
+
+struct brw_wm_async_job {
+   struct list_head link;
+   void *mem_ctx;
+
+   struct brw_wm_prog_key key;
+   struct brw_wm_prog_data prog_data;
+   nir_shader *nir;
+   struct brw_disk_cache_prog disk_cache;
+
+   /** The full program, or NULL if compiling it failed. */
+   const unsigned *program;
+   unsigned program_size;
+};
+
+struct brw_wm_async {
+   const struct brw_compiler *compiler;
+
+   pthread_t thread;
+   pthread_mutex_t mutex;
+   pthread_cond_t cond;
+
+   /** Jobs waiting for the worker, protected by mutex. */
+   struct list_head pending;
+
+   /** Jobs waiting for brw_wm_async_collect(), protected by mutex. */
+   struct list_head done;
+   int num_done;
+
+   bool shutdown;
+};
+
+static void *
+brw_wm_async_thread(void *data)
+{
+   struct brw_wm_async *async = data;
+
+   pthread_mutex_lock(&async->mutex);
+   while (true) {
+      while (!async->shutdown && list_empty(&async->pending))
+         pthread_cond_wait(&async->cond, &async->mutex);
+
+      if (async->shutdown)
+         break;
+
+      struct brw_wm_async_job *job =
+         LIST_ENTRY(struct brw_wm_async_job, async->pending.next, link);
+      list_del(&job->link);
+      pthread_mutex_unlock(&async->mutex);
+
+      /* There's no context to send shader debug messages to from here, so
+       * log_data is NULL.
+       */
+      job->program = brw_compile_fs(async->compiler, NULL, job->mem_ctx,
+                                    &job->key, &job->prog_data, job->nir,
+                                    NULL, -1, -1, false, true,
+                                    &job->program_size, NULL);
+
+      pthread_mutex_lock(&async->mutex);
+      list_addtail(&job->link, &async->done);
+      p_atomic_inc(&async->num_done);
+   }
+   pthread_mutex_unlock(&async->mutex);
+
+   return NULL;
+}
+
+static struct brw_wm_async *
+brw_wm_async_create(struct brw_context *brw)
+{
+   struct brw_wm_async *async = calloc(1, sizeof(*async));
+   if (async == NULL)
+      return NULL;
+
+   async->compiler = brw->intelScreen->compiler;
+   pthread_mutex_init(&async->mutex, NULL);
+   pthread_cond_init(&async->cond, NULL);
+   list_inithead(&async->pending);
+   list_inithead(&async->done);
+
+   if (pthread_create(&async->thread, NULL, brw_wm_async_thread, async)) {
+      pthread_cond_destroy(&async->cond);
+      pthread_mutex_destroy(&async->mutex);
+      free(async);
+      return NULL;
+   }
+
+   return async;
+}
+
+static void
+brw_wm_async_free_job(struct brw_wm_async_job *job)
+{
+   brw_stage_prog_data_free(&job->prog_data);
+   ralloc_free(job->mem_ctx);
+}
+
+/**
+ * Make the params of image uniforms, which point into \p old_image_param,
+ * point to the same place in \p new_image_param instead.
+ */
+static void
+brw_wm_async_remap_image_params(const union gl_constant_value **params,
+                                unsigned nr_params,
+                                const struct brw_image_param *old_image_param,
+                                const struct brw_image_param *new_image_param,
+                                unsigned nr_image_params)
+{
+   const uintptr_t start = (uintptr_t) old_image_param;
+   const uintptr_t end = (uintptr_t) (old_image_param + nr_image_params);
+
+   for (unsigned i = 0; i < nr_params; i++) {
+      const uintptr_t p = (uintptr_t) params[i];
+      if (p >= start && p < end) {
+         params[i] = (const union gl_constant_value *)
+            ((const char *) new_image_param + (p - start));
+      }
+   }
+}
+
+/**
+ * Queue a background compile of the full program for \p key.
+ *
+ * Called by brw_codegen_wm_prog() before compiling, with \p prog_data as set
+ * up for the compile.  If this returns true, the caller is expected to build
+ * only the SIMD8 program; \p disk_cache is then handed over to the job, so
+ * that the full program is what ends up in the disk cache.
+ */
+bool
+brw_wm_async_queue(struct brw_context *brw,
+                   const struct brw_wm_prog_key *key,
+                   const struct brw_wm_prog_data *prog_data,
+                   const nir_shader *nir,
+                   struct brw_disk_cache_prog *disk_cache)
+{
+   /* Shader time gives each SIMD width its own index, which is per context,
+    * and dumps should show both programs together.
+    */
+   const uint64_t sync_flags = DEBUG_NO8 | DEBUG_NO16 | DEBUG_WM |
+                               DEBUG_SHADER_TIME;
+
+   if (!brw->async_simd16 || brw->use_rep_send ||
+       (INTEL_DEBUG & sync_flags))
+      return false;
+
+   if (brw->wm.async == NULL) {
+      brw->wm.async = brw_wm_async_create(brw);
+      if (brw->wm.async == NULL) {
+         brw->async_simd16 = false;
+         return false;
+      }
+   }
+
+   struct brw_wm_async *async = brw->wm.async;
+   void *mem_ctx = ralloc_context(NULL);
+   struct brw_wm_async_job *job = rzalloc(mem_ctx, struct brw_wm_async_job);
+
+   job->mem_ctx = mem_ctx;
+   job->key = *key;
+   job->nir = nir_shader_clone(mem_ctx, nir);
+
+   /* The param arrays end up owned by the state cache like those of any
+    * other program, so they aren't allocated out of the job's context.
+    */
+   const struct brw_stage_prog_data *src = &prog_data->base;
+   struct brw_stage_prog_data *dst = &job->prog_data.base;
+
+   job->prog_data = *prog_data;
+   dst->param =
+      ralloc_array(NULL, const union gl_constant_value *, src->nr_params);
+   memcpy(dst->param, src->param, src->nr_params * sizeof(*dst->param));
+   dst->pull_param =
+      rzalloc_array(NULL, const union gl_constant_value *, src->nr_params);
+   dst->image_param =
+      ralloc_array(NULL, struct brw_image_param, src->nr_image_params);
+   memcpy(dst->image_param, src->image_param,
+          src->nr_image_params * sizeof(*dst->image_param));
+   brw_wm_async_remap_image_params(dst->param, dst->nr_params,
+                                   src->image_param, dst->image_param,
+                                   src->nr_image_params);
+
+   job->disk_cache = *disk_cache;
+   if (disk_cache->enabled) {
+      job->disk_cache.params =
+         ralloc_array(mem_ctx, const union gl_constant_value *,
+                      disk_cache->nr_params);
+      memcpy(job->disk_cache.params, disk_cache->params,
+             disk_cache->nr_params * sizeof(*disk_cache->params));
+      brw_wm_async_remap_image_params(job->disk_cache.params,
+                                      job->disk_cache.nr_params,
+                                      src->image_param, dst->image_param,
+                                      src->nr_image_params);
+      disk_cache->enabled = false;
+   }
+
+   pthread_mutex_lock(&async->mutex);
+   list_addtail(&job->link, &async->pending);
+   pthread_cond_signal(&async->cond);
+   pthread_mutex_unlock(&async->mutex);
+
+   return true;
+}
+
+/**
+ * Swap the programs finished by the worker into the program cache.
+ *
+ * Called before each state upload.  Programs that were dropped from the
+ * cache while being compiled are thrown away.
+ */
+void
+brw_wm_async_collect(struct brw_context *brw)
+{
+   struct brw_wm_async *async = brw->wm.async;
+
+   if (likely(async == NULL || p_atomic_read(&async->num_done) == 0))
+      return;
+
+   struct list_head done;
+   pthread_mutex_lock(&async->mutex);
+   list_replace(&async->done, &done);
+   list_inithead(&async->done);
+   async->num_done = 0;
+   pthread_mutex_unlock(&async->mutex);
+
+   list_for_each_entry_safe(struct brw_wm_async_job, job, &done, link) {
+      list_del(&job->link);
+
+      if (job->program == NULL ||
+          !brw_replace_cache(&brw->cache, BRW_CACHE_FS_PROG,
+                             &job->key, sizeof(job->key),
+                             job->program, job->program_size,
+                             &job->prog_data, sizeof(job->prog_data),
+                             &brw->wm.base.prog_offset, &brw->wm.prog_data)) {
+         brw_wm_async_free_job(job);
+         continue;
+      }
+
+      if (job->prog_data.base.total_scratch) {
+         brw_get_scratch_bo(brw, &brw->wm.base.scratch_bo,
+                            job->prog_data.base.total_scratch *
+                            brw->max_wm_threads);
+      }
+
+      brw_disk_cache_store_prog(brw, &job->disk_cache,
+                                job->program, job->program_size,
+                                &job->prog_data.base, sizeof(job->prog_data));
+
+      /* The prog_data now belongs to the state cache. */
+      ralloc_free(job->mem_ctx);
+   }
+}
+
+void
+brw_wm_async_destroy(struct brw_context *brw)
+{
+   struct brw_wm_async *async = brw->wm.async;
+
+   if (async == NULL)
+      return;
+
+   pthread_mutex_lock(&async->mutex);
+   async->shutdown = true;
+   pthread_cond_signal(&async->cond);
+   pthread_mutex_unlock(&async->mutex);
+
+   pthread_join(async->thread, NULL);
+
+   list_for_each_entry_safe(struct brw_wm_async_job, job,
+                            &async->pending, link)
+      brw_wm_async_free_job(job);
+   list_for_each_entry_safe(struct brw_wm_async_job, job, &async->done, link)
+      brw_wm_async_free_job(job);
+
+   pthread_cond_destroy(&async->cond);
+   pthread_mutex_destroy(&async->mutex);
+   free(async);
+   brw->wm.async = NULL;
+}
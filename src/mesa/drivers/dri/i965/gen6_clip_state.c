@@ -199,6 +199,7 @@ const struct brw_tracked_state gen6_clip_state = {
                BRW_NEW_RASTERIZER_DISCARD,
    },
    .emit = upload_clip_state,
+   .dedup = true,
 };
 
 const struct brw_tracked_state gen7_clip_state = {
@@ -213,4 +214,5 @@ const struct brw_tracked_state gen7_clip_state = {
                BRW_NEW_RASTERIZER_DISCARD,
    },
    .emit = upload_clip_state,
+   .dedup = true,
 };
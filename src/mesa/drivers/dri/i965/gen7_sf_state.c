@@ -101,6 +101,7 @@ const struct brw_tracked_state gen7_sbe_state = {
                BRW_NEW_VUE_MAP_GEOM_OUT,
    },
    .emit = upload_sbe_state,
+   .dedup = true,
 };
 
 static void
@@ -257,4 +258,5 @@ const struct brw_tracked_state gen7_sf_state = {
       .brw   = BRW_NEW_CONTEXT,
    },
    .emit = upload_sf_state,
+   .dedup = true,
 };
@@ -142,6 +142,7 @@ const struct brw_tracked_state gen7_wm_state = {
                BRW_NEW_FS_PROG_DATA,
    },
    .emit = upload_wm_state,
+   .dedup = true,
 };
 
 static void
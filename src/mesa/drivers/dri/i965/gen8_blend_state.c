@@ -297,5 +297,6 @@ const struct brw_tracked_state gen8_ps_blend = {
       .brw = BRW_NEW_CONTEXT |
              BRW_NEW_FRAGMENT_PROGRAM,
    },
-   .emit = gen8_upload_ps_blend
+   .emit = gen8_upload_ps_blend,
+   .dedup = true,
 };
@@ -128,6 +128,7 @@ const struct brw_tracked_state gen8_ps_extra = {
                BRW_NEW_NUM_SAMPLES,
    },
    .emit = upload_ps_extra,
+   .dedup = true,
 };
 
 static void
@@ -173,6 +174,7 @@ const struct brw_tracked_state gen8_wm_state = {
                BRW_NEW_FS_PROG_DATA,
    },
    .emit = upload_wm_state,
+   .dedup = true,
 };
 
 void
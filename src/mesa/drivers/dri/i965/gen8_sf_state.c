@@ -141,6 +141,7 @@ const struct brw_tracked_state gen8_sbe_state = {
                BRW_NEW_VUE_MAP_GEOM_OUT,
    },
    .emit = upload_sbe,
+   .dedup = true,
 };
 
 static void
@@ -212,6 +213,7 @@ const struct brw_tracked_state gen8_sf_state = {
       .brw   = BRW_NEW_CONTEXT,
    },
    .emit = upload_sf,
+   .dedup = true,
 };
 
 static void
@@ -329,4 +331,5 @@ const struct brw_tracked_state gen8_raster_state = {
       .brw   = BRW_NEW_CONTEXT,
    },
    .emit = upload_raster,
+   .dedup = true,
 };
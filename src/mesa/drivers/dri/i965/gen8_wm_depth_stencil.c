@@ -114,4 +114,5 @@ const struct brw_tracked_state gen8_wm_depth_stencil = {
       .brw  = BRW_NEW_CONTEXT,
    },
    .emit = gen8_upload_wm_depth_stencil,
+   .dedup = true,
 };
@@ -32,6 +32,7 @@
 #include "brw_context.h"
 #include "brw_defines.h"
 #include "brw_state.h"
+#include "util/hash_table.h"
 
 #include <xf86drm.h>
 #include <i915_drm.h>
@@ -73,6 +74,7 @@ intel_batchbuffer_reset(struct brw_context *brw)
    brw->batch.reserved_space = BATCH_RESERVED;
    brw->batch.state_batch_offset = brw->batch.bo->size;
    brw->batch.needs_sol_reset = false;
+   intel_batchbuffer_forget_packets(brw);
 
    /* We don't know what ring the new batch will be sent to until we see the
     * first BEGIN_BATCH or BEGIN_BATCH_BLT.  Mark it as unknown.
@@ -96,6 +98,59 @@ intel_batchbuffer_reset_to_saved(struct brw_context *brw)
    brw->batch.map_next = brw->batch.saved.map_next;
    if (USED_BATCH(brw->batch) == 0)
       brw->batch.ring = UNKNOWN_RING;
+
+   /* Forget the packets which were just thrown away. */
+   for (unsigned i = 0; i < ARRAY_SIZE(brw->batch.packets); i++) {
+      if (brw->batch.packets[i].offset >= USED_BATCH(brw->batch))
+         brw->batch.packets[i].size = 0;
+   }
+}
+
+/**
+ * Check whether the dwords emitted since offset \p start (in dwords) are
+ * the same as the ones last emitted for \p slot in this batch, and remember
+ * them for the next time otherwise.
+ *
+ * The previous emission is found by hash, then compared in full.
+ */
+bool
+intel_batchbuffer_repeats(struct brw_context *brw, unsigned slot,
+                          uint32_t start)
+{
+   struct intel_batchbuffer *batch = &brw->batch;
+   const uint32_t size = USED_BATCH(*batch) - start;
+
+   assert(slot < ARRAY_SIZE(batch->packets));
+
+   /* Nothing was emitted, so the previous packets are still current. */
+   if (size == 0)
+      return false;
+
+   const uint32_t hash = _mesa_hash_data(batch->map + start, size * 4);
+
+   if (batch->packets[slot].size == size &&
+       batch->packets[slot].hash == hash &&
+       memcmp(batch->map + batch->packets[slot].offset, batch->map + start,
+              size * 4) == 0)
+      return true;
+
+   batch->packets[slot].offset = start;
+   batch->packets[slot].size = size;
+   batch->packets[slot].hash = hash;
+   return false;
+}
+
+/**
+ * Forget about all the packets intel_batchbuffer_repeats() has seen.
+ *
+ * Must be called by anything which emits packets owned by state atoms
+ * outside of the state upload, like BLORP.
+ */
+void
+intel_batchbuffer_forget_packets(struct brw_context *brw)
+{
+   for (unsigned i = 0; i < ARRAY_SIZE(brw->batch.packets); i++)
+      brw->batch.packets[i].size = 0;
 }
 
 void
@@ -186,6 +241,9 @@ brw_new_batch(struct brw_context *brw)
    if (INTEL_DEBUG & DEBUG_SHADER_TIME)
       brw_collect_and_report_shader_time(brw);
 
+   if (INTEL_DEBUG & DEBUG_DRAW_TIME)
+      brw_collect_and_report_draw_time(brw);
+
    if (INTEL_DEBUG & DEBUG_PERFMON)
       brw_dump_perf_monitors(brw);
 }
@@ -44,6 +44,9 @@ void intel_batchbuffer_init(struct brw_context *brw);
 void intel_batchbuffer_free(struct brw_context *brw);
 void intel_batchbuffer_save_state(struct brw_context *brw);
 void intel_batchbuffer_reset_to_saved(struct brw_context *brw);
+bool intel_batchbuffer_repeats(struct brw_context *brw, unsigned slot,
+                               uint32_t start);
+void intel_batchbuffer_forget_packets(struct brw_context *brw);
 
 int _intel_batchbuffer_flush(struct brw_context *brw,
 			     const char *file, int line);
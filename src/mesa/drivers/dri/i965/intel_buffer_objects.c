@@ -29,6 +29,9 @@
  * This provides core GL buffer object functionality.
  */
 
+#include <sys/mman.h>
+#include <xf86drm.h>
+
 #include "main/imports.h"
 #include "main/mtypes.h"
 #include "main/macros.h"
@@ -79,19 +82,135 @@ brw_bo_map_gtt(struct brw_context *brw, drm_intel_bo *bo, const char *bo_name)
    return ret;
 }
 
+/* Drop when libdrm's i915_drm.h has the mmap flags */
+#ifndef I915_MMAP_WC
+#define I915_MMAP_WC 0x1
+
+struct brw_gem_mmap {
+   uint32_t handle;
+   uint32_t pad;
+   uint64_t offset;
+   uint64_t size;
+   uint64_t addr_ptr;
+   uint64_t flags;
+};
+
+#define BRW_IOCTL_I915_GEM_MMAP \
+   DRM_IOWR(DRM_COMMAND_BASE + DRM_I915_GEM_MMAP, struct brw_gem_mmap)
+#else
+#define brw_gem_mmap drm_i915_gem_mmap
+#define BRW_IOCTL_I915_GEM_MMAP DRM_IOCTL_I915_GEM_MMAP
+#endif
+
+/**
+ * Returns a write-combined CPU mapping of the whole buffer, or NULL if the
+ * kernel can't provide one.
+ *
+ * Synchronized maps move the BO to the GTT domain, which covers WC mappings
+ * too: that waits for rendering and flushes whatever the CPU cache held.
+ */
+static void *
+map_wc(struct brw_context *brw, struct intel_buffer_object *intel_obj,
+       bool synchronized, bool write)
+{
+   if (!brw->intelScreen->has_mmap_wc)
+      return NULL;
+
+   if (!intel_obj->map_wc) {
+      struct brw_gem_mmap mmap_arg;
+
+      memset(&mmap_arg, 0, sizeof(mmap_arg));
+      mmap_arg.handle = intel_obj->buffer->handle;
+      mmap_arg.size = intel_obj->buffer->size;
+      mmap_arg.flags = I915_MMAP_WC;
+      if (drmIoctl(brw->intelScreen->driScrnPriv->fd, BRW_IOCTL_I915_GEM_MMAP,
+                   &mmap_arg) != 0)
+         return NULL;
+
+      intel_obj->map_wc = (void *) (uintptr_t) mmap_arg.addr_ptr;
+   }
+
+   if (synchronized) {
+      if (unlikely(brw->perf_debug) && drm_intel_bo_busy(intel_obj->buffer))
+         perf_debug("WC mapping a busy buffer object stalled.\n");
+      drm_intel_gem_bo_start_gtt_access(intel_obj->buffer, write);
+   }
+
+   return intel_obj->map_wc;
+}
+
 static void
 mark_buffer_gpu_usage(struct intel_buffer_object *intel_obj,
                                uint32_t offset, uint32_t size)
 {
-   intel_obj->gpu_active_start = MIN2(intel_obj->gpu_active_start, offset);
-   intel_obj->gpu_active_end = MAX2(intel_obj->gpu_active_end, offset + size);
+   const struct intel_buffer_range *active = intel_obj->gpu_active;
+   const unsigned count = intel_obj->num_gpu_active_ranges;
+   struct intel_buffer_range ranges[INTEL_BUFFER_MAX_ACTIVE_RANGES + 1];
+   uint32_t start = offset, end = offset + size;
+   unsigned i = 0, n = 0;
+
+   /* Keep the ranges before the new one, fold in the ones it overlaps or
+    * touches, and keep the ones after it.
+    */
+   while (i < count && active[i].end < start)
+      ranges[n++] = active[i++];
+   while (i < count && active[i].start <= end) {
+      start = MIN2(start, active[i].start);
+      end = MAX2(end, active[i].end);
+      i++;
+   }
+   ranges[n].start = start;
+   ranges[n].end = end;
+   n++;
+   while (i < count)
+      ranges[n++] = active[i++];
+
+   /* Out of slots: merge the pair with the smallest gap between them, which
+    * marks the fewest idle bytes as busy.
+    */
+   if (n > INTEL_BUFFER_MAX_ACTIVE_RANGES) {
+      unsigned closest = 0;
+
+      for (i = 1; i < n - 1; i++) {
+         if (ranges[i + 1].start - ranges[i].end <
+             ranges[closest + 1].start - ranges[closest].end)
+            closest = i;
+      }
+
+      ranges[closest].end = ranges[closest + 1].end;
+      for (i = closest + 1; i < n - 1; i++)
+         ranges[i] = ranges[i + 1];
+      n--;
+   }
+
+   memcpy(intel_obj->gpu_active, ranges, n * sizeof(ranges[0]));
+   intel_obj->num_gpu_active_ranges = n;
 }
 
 static void
 mark_buffer_inactive(struct intel_buffer_object *intel_obj)
 {
-   intel_obj->gpu_active_start = ~0;
-   intel_obj->gpu_active_end = 0;
+   intel_obj->num_gpu_active_ranges = 0;
+}
+
+/**
+ * Returns whether [offset, offset + size) overlaps a range the GPU may be
+ * accessing.
+ */
+static bool
+buffer_range_is_gpu_active(const struct intel_buffer_object *intel_obj,
+                           uint32_t offset, uint32_t size)
+{
+   for (unsigned i = 0; i < intel_obj->num_gpu_active_ranges; i++) {
+      const struct intel_buffer_range *range = &intel_obj->gpu_active[i];
+
+      if (offset + size <= range->start)
+         break;
+      if (offset < range->end)
+         return true;
+   }
+
+   return false;
 }
 
 /** Allocates a new drm_intel_bo to store the data for the buffer object. */
@@ -119,6 +238,10 @@ alloc_buffer_object(struct brw_context *brw,
 static void
 release_buffer(struct intel_buffer_object *intel_obj)
 {
+   if (intel_obj->map_wc) {
+      munmap(intel_obj->map_wc, intel_obj->buffer->size);
+      intel_obj->map_wc = NULL;
+   }
    drm_intel_bo_unreference(intel_obj->buffer);
    intel_obj->buffer = NULL;
 }
@@ -166,7 +289,8 @@ brw_delete_buffer(struct gl_context * ctx, struct gl_buffer_object *obj)
     */
    _mesa_buffer_unmap_all_mappings(ctx, obj);
 
-   drm_intel_bo_unreference(intel_obj->buffer);
+   if (intel_obj->buffer)
+      release_buffer(intel_obj);
    free(intel_obj);
 }
 
@@ -254,18 +378,25 @@ brw_buffer_subdata(struct gl_context *ctx,
     * (otherwise, an app that might occasionally stall but mostly not will end
     * up with blitting all the time, at the cost of bandwidth)
     */
-   if (offset + size <= intel_obj->gpu_active_start ||
-       intel_obj->gpu_active_end <= offset) {
+   if (!buffer_range_is_gpu_active(intel_obj, offset, size)) {
+      void *map;
+
       if (brw->has_llc) {
          drm_intel_gem_bo_map_unsynchronized(intel_obj->buffer);
          memcpy(intel_obj->buffer->virtual + offset, data, size);
          drm_intel_bo_unmap(intel_obj->buffer);
 
-         if (intel_obj->gpu_active_end > intel_obj->gpu_active_start)
+         if (intel_obj->num_gpu_active_ranges > 0)
+            intel_obj->prefer_stall_to_blit = true;
+         return;
+      } else if ((map = map_wc(brw, intel_obj, false, true))) {
+         memcpy(map + offset, data, size);
+
+         if (intel_obj->num_gpu_active_ranges > 0)
             intel_obj->prefer_stall_to_blit = true;
          return;
       } else {
-         perf_debug("BufferSubData could be unsynchronized, but !LLC doesn't support it yet\n");
+         perf_debug("BufferSubData could be unsynchronized, but !LLC doesn't support it without WC mappings\n");
       }
    }
 
@@ -274,17 +405,19 @@ brw_buffer_subdata(struct gl_context *ctx,
       drm_intel_bo_references(brw->batch.bo, intel_obj->buffer);
 
    if (busy) {
-      if (size == intel_obj->Base.Size) {
-	 /* Replace the current busy bo so the subdata doesn't stall. */
-	 drm_intel_bo_unreference(intel_obj->buffer);
+      if (size == intel_obj->Base.Size &&
+          !_mesa_bufferobj_mapped(obj, MAP_USER)) {
+	 /* Replace the current busy bo so the subdata doesn't stall.  A
+	  * persistent mapping has to keep pointing at the buffer, though.
+	  */
+	 release_buffer(intel_obj);
 	 alloc_buffer_object(brw, intel_obj);
       } else if (!intel_obj->prefer_stall_to_blit) {
          perf_debug("Using a blit copy to avoid stalling on "
                     "glBufferSubData(%ld, %ld) (%ldkb) to a busy "
-                    "(%d-%d) buffer object.\n",
+                    "buffer object (%u active ranges).\n",
                     (long)offset, (long)offset + size, (long)(size/1024),
-                    intel_obj->gpu_active_start,
-                    intel_obj->gpu_active_end);
+                    intel_obj->num_gpu_active_ranges);
 	 drm_intel_bo *temp_bo =
 	    drm_intel_bo_alloc(brw->bufmgr, "subdata temp", size, 64);
 
@@ -294,16 +427,16 @@ brw_buffer_subdata(struct gl_context *ctx,
 				intel_obj->buffer, offset,
 				temp_bo, 0,
 				size);
+         mark_buffer_gpu_usage(intel_obj, offset, size);
 
 	 drm_intel_bo_unreference(temp_bo);
          return;
       } else {
          perf_debug("Stalling on glBufferSubData(%ld, %ld) (%ldkb) to a busy "
-                    "(%d-%d) buffer object.  Use glMapBufferRange() to "
+                    "buffer object (%u active ranges).  Use glMapBufferRange() to "
                     "avoid this.\n",
                     (long)offset, (long)offset + size, (long)(size/1024),
-                    intel_obj->gpu_active_start,
-                    intel_obj->gpu_active_end);
+                    intel_obj->num_gpu_active_ranges);
          intel_batchbuffer_flush(brw);
       }
    }
@@ -380,6 +513,35 @@ brw_map_buffer_range(struct gl_context *ctx,
       return NULL;
    }
 
+   /* A write-only mapping of a range the GPU isn't using can be handed out
+    * directly, without flushing the batch or waiting for the rest of the
+    * buffer to go idle.  This is what the subdata path does too, and catches
+    * apps streaming vertex data into a buffer without UNSYNCHRONIZED.  Reads
+    * through the unsynchronized (GTT) mapping would be uncached, so they
+    * keep going through the synchronized path, as do buffers the GPU isn't
+    * using at all, which map without stalling anyway.
+    *
+    * Without LLC, this takes a WC mapping, which is truly unsynchronized.
+    */
+   if ((brw->has_llc || brw->intelScreen->has_mmap_wc) &&
+       intel_obj->num_gpu_active_ranges > 0 &&
+       !(access & (GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_READ_BIT |
+                   GL_MAP_INVALIDATE_BUFFER_BIT)) &&
+       !buffer_range_is_gpu_active(intel_obj, offset, length)) {
+      if (brw->has_llc) {
+         drm_intel_gem_bo_map_unsynchronized(intel_obj->buffer);
+         obj->Mappings[index].Pointer = intel_obj->buffer->virtual + offset;
+         return obj->Mappings[index].Pointer;
+      } else {
+         void *map = map_wc(brw, intel_obj, false, true);
+         if (map) {
+            intel_obj->map_is_wc[index] = true;
+            obj->Mappings[index].Pointer = map + offset;
+            return obj->Mappings[index].Pointer;
+         }
+      }
+   }
+
    /* If the access is synchronized (like a normal buffer mapping), then get
     * things flushed out so the later mapping syncs appropriately through GEM.
     * If the user doesn't care about existing buffer contents and mapping would
@@ -391,7 +553,7 @@ brw_map_buffer_range(struct gl_context *ctx,
    if (!(access & GL_MAP_UNSYNCHRONIZED_BIT)) {
       if (drm_intel_bo_references(brw->batch.bo, intel_obj->buffer)) {
 	 if (access & GL_MAP_INVALIDATE_BUFFER_BIT) {
-	    drm_intel_bo_unreference(intel_obj->buffer);
+	    release_buffer(intel_obj);
 	    alloc_buffer_object(brw, intel_obj);
 	 } else {
             perf_debug("Stalling on the GPU for mapping a busy buffer "
@@ -400,15 +562,14 @@ brw_map_buffer_range(struct gl_context *ctx,
 	 }
       } else if (drm_intel_bo_busy(intel_obj->buffer) &&
 		 (access & GL_MAP_INVALIDATE_BUFFER_BIT)) {
-	 drm_intel_bo_unreference(intel_obj->buffer);
+	 release_buffer(intel_obj);
 	 alloc_buffer_object(brw, intel_obj);
       }
    }
 
    /* If the user is mapping a range of an active buffer object but
     * doesn't require the current contents of that range, make a new
-    * BO, and we'll copy what they put in there out at unmap or
-    * FlushRange time.
+    * BO, and we'll copy what they put in there out at unmap time.
     *
     * That is, unless they're looking for a persistent mapping -- we would
     * need to do blits in the MemoryBarrier call, and it's easier to just do a
@@ -428,6 +589,8 @@ brw_map_buffer_range(struct gl_context *ctx,
                                                           length +
                                                           intel_obj->map_extra[index],
                                                           alignment);
+      intel_obj->map_flushed[index].start = length;
+      intel_obj->map_flushed[index].end = 0;
       if (brw->has_llc) {
          brw_bo_map(brw, intel_obj->range_map_bo[index],
                     (access & GL_MAP_WRITE_BIT) != 0, "range-map");
@@ -439,10 +602,31 @@ brw_map_buffer_range(struct gl_context *ctx,
       return obj->Mappings[index].Pointer;
    }
 
+   /* Without LLC, write-only and persistent mappings would be uncached
+    * anyway, so they take a WC mapping if the kernel supports it, and a GTT
+    * one otherwise.  WC mappings need neither aperture space nor a fence
+    * register, and are the only way to map unsynchronized on these parts.
+    */
+   if (!brw->has_llc &&
+       (access & (GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_PERSISTENT_BIT) ||
+        !(access & GL_MAP_READ_BIT))) {
+      const bool sync = !(access & GL_MAP_UNSYNCHRONIZED_BIT);
+      void *map = map_wc(brw, intel_obj, sync,
+                         (access & GL_MAP_WRITE_BIT) != 0);
+
+      if (map) {
+         if (sync)
+            mark_buffer_inactive(intel_obj);
+         intel_obj->map_is_wc[index] = true;
+         obj->Mappings[index].Pointer = map + offset;
+         return obj->Mappings[index].Pointer;
+      }
+   }
+
    if (access & GL_MAP_UNSYNCHRONIZED_BIT) {
       if (!brw->has_llc && brw->perf_debug &&
           drm_intel_bo_busy(intel_obj->buffer)) {
-         perf_debug("MapBufferRange with GL_MAP_UNSYNCHRONIZED_BIT stalling (it's actually synchronized on non-LLC platforms)\n");
+         perf_debug("MapBufferRange with GL_MAP_UNSYNCHRONIZED_BIT stalling (it's actually synchronized on non-LLC platforms without WC mappings)\n");
       }
       drm_intel_gem_bo_map_unsynchronized(intel_obj->buffer);
    } else if (!brw->has_llc && (!(access & GL_MAP_READ_BIT) ||
@@ -467,10 +651,10 @@ brw_map_buffer_range(struct gl_context *ctx,
  *
  * This is only used for buffers mapped with GL_MAP_FLUSH_EXPLICIT_BIT.
  *
- * Ideally we'd use a BO to avoid taking up cache space for the temporary
- * data, but FlushMappedBufferRange may be followed by further writes to
- * the pointer, so we would have to re-map after emitting our blit, which
- * would defeat the point.
+ * When the mapping is a temporary BO, the flushed ranges are only recorded
+ * and blitted together at unmap time: temporaries are never used for
+ * persistent mappings, so the GPU can't read the buffer before then anyway,
+ * and one blit is much cheaper than a blit per flush.
  */
 static void
 brw_flush_mapped_buffer_range(struct gl_context *ctx,
@@ -478,8 +662,8 @@ brw_flush_mapped_buffer_range(struct gl_context *ctx,
                               struct gl_buffer_object *obj,
                               gl_map_buffer_index index)
 {
-   struct brw_context *brw = brw_context(ctx);
    struct intel_buffer_object *intel_obj = intel_buffer_object(obj);
+   struct intel_buffer_range *flushed = &intel_obj->map_flushed[index];
 
    assert(obj->Mappings[index].AccessFlags & GL_MAP_FLUSH_EXPLICIT_BIT);
 
@@ -492,38 +676,8 @@ brw_flush_mapped_buffer_range(struct gl_context *ctx,
    if (length == 0)
       return;
 
-   /* Note that we're not unmapping our buffer while executing the blit.  We
-    * need to have a mapping still at the end of this call, since the user
-    * gets to make further modifications and glFlushMappedBufferRange() calls.
-    * This is safe, because:
-    *
-    * - On LLC platforms, we're using a CPU mapping that's coherent with the
-    *   GPU (except for the render caches), so the kernel doesn't need to do
-    *   any flushing work for us except for what happens at batch exec time
-    *   anyway.
-    *
-    * - On non-LLC platforms, we're using a GTT mapping that writes directly
-    *   to system memory (except for the chipset cache that gets flushed at
-    *   batch exec time).
-    *
-    * In both cases we don't need to stall for the previous blit to complete
-    * so we can re-map (and we definitely don't want to, since that would be
-    * slow): If the user edits a part of their buffer that's previously been
-    * blitted, then our lack of synchoronization is fine, because either
-    * they'll get some too-new data in the first blit and not do another blit
-    * of that area (but in that case the results are undefined), or they'll do
-    * another blit of that area and the complete newer data will land the
-    * second time.
-    */
-   intel_emit_linear_blit(brw,
-			  intel_obj->buffer,
-                          obj->Mappings[index].Offset + offset,
-			  intel_obj->range_map_bo[index],
-                          intel_obj->map_extra[index] + offset,
-			  length);
-   mark_buffer_gpu_usage(intel_obj,
-                         obj->Mappings[index].Offset + offset,
-                         length);
+   flushed->start = MIN2(flushed->start, offset);
+   flushed->end = MAX2(flushed->end, offset + length);
 }
 
 
@@ -543,16 +697,24 @@ brw_unmap_buffer(struct gl_context *ctx,
    assert(intel_obj);
    assert(obj->Mappings[index].Pointer);
    if (intel_obj->range_map_bo[index] != NULL) {
+      uint32_t start = 0, end = obj->Mappings[index].Length;
+
       drm_intel_bo_unmap(intel_obj->range_map_bo[index]);
 
-      if (!(obj->Mappings[index].AccessFlags & GL_MAP_FLUSH_EXPLICIT_BIT)) {
+      if (obj->Mappings[index].AccessFlags & GL_MAP_FLUSH_EXPLICIT_BIT) {
+         start = intel_obj->map_flushed[index].start;
+         end = intel_obj->map_flushed[index].end;
+      }
+
+      if (end > start) {
          intel_emit_linear_blit(brw,
-                                intel_obj->buffer, obj->Mappings[index].Offset,
+                                intel_obj->buffer,
+                                obj->Mappings[index].Offset + start,
                                 intel_obj->range_map_bo[index],
-                                intel_obj->map_extra[index],
-                                obj->Mappings[index].Length);
-         mark_buffer_gpu_usage(intel_obj, obj->Mappings[index].Offset,
-                               obj->Mappings[index].Length);
+                                intel_obj->map_extra[index] + start,
+                                end - start);
+         mark_buffer_gpu_usage(intel_obj, obj->Mappings[index].Offset + start,
+                               end - start);
       }
 
       /* Since we've emitted some blits to buffers that will (likely) be used
@@ -564,6 +726,9 @@ brw_unmap_buffer(struct gl_context *ctx,
 
       drm_intel_bo_unreference(intel_obj->range_map_bo[index]);
       intel_obj->range_map_bo[index] = NULL;
+   } else if (intel_obj->map_is_wc[index]) {
+      /* The WC mapping stays around for the next map. */
+      intel_obj->map_is_wc[index] = false;
    } else if (intel_obj->buffer != NULL) {
       drm_intel_bo_unmap(intel_obj->buffer);
    }
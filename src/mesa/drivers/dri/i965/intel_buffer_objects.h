@@ -31,6 +31,18 @@
 struct brw_context;
 struct gl_buffer_object;
 
+/**
+ * Maximum number of disjoint GPU-active ranges tracked per buffer object.
+ * Past that, the two closest ranges get merged.
+ */
+#define INTEL_BUFFER_MAX_ACTIVE_RANGES 4
+
+/** A [start, end) byte range of a buffer object. */
+struct intel_buffer_range
+{
+   uint32_t start;
+   uint32_t end;
+};
 
 /**
  * Intel vertex/pixel buffer object, derived from Mesa's gl_buffer_object.
@@ -48,6 +60,24 @@ struct intel_buffer_object
     */
    unsigned map_extra[MAP_COUNT];
 
+   /**
+    * Ranges of range_map_bo flushed with glFlushMappedBufferRange(), relative
+    * to the mapping.  They're blitted as one at unmap time: the buffer can't
+    * be used while it has a non-persistent mapping, and only those get a
+    * temporary BO.
+    */
+   struct intel_buffer_range map_flushed[MAP_COUNT];
+
+   /**
+    * Write-combined CPU mapping of the whole BO on non-LLC platforms, kept
+    * until the BO is released.  Unlike GTT mappings it needs no aperture
+    * space or fence register.
+    */
+   void *map_wc;
+
+   /** Whether mapping \c index points into map_wc. */
+   bool map_is_wc[MAP_COUNT];
+
    /** @{
     * Tracking for what range of the BO may currently be in use by the GPU.
     *
@@ -59,16 +89,21 @@ struct intel_buffer_object
     * UNSYNC|INVALIDATE_RANGE flag or the INVALIDATE_BUFFER flag, but lots
     * don't.
     *
-    * To work around apps, we track what range of the BO we might have used on
-    * the GPU as vertex data, tranform feedback output, buffer textures, etc.,
-    * and just do glBufferSubData() with an unsynchronized map when they're
-    * outside of that range.
+    * To work around apps, we track what ranges of the BO we might have used
+    * on the GPU as vertex data, tranform feedback output, buffer textures,
+    * etc., and just do glBufferSubData() or a write-only glMapBufferRange()
+    * with an unsynchronized map when they're outside of those ranges.
+    *
+    * The ranges are disjoint and sorted by start offset.  A single range
+    * covering everything between the first and last use would lose the gaps
+    * that streaming apps write into, e.g. the free space between the two
+    * ends of a ring buffer that has wrapped around.
     *
-    * If gpu_active_start > gpu_active_end, then the GPU is not currently
-    * accessing the BO (and we can map it without synchronization).
+    * If num_gpu_active_ranges is 0, then the GPU is not currently accessing
+    * the BO (and we can map it without synchronization).
     */
-   uint32_t gpu_active_start;
-   uint32_t gpu_active_end;
+   struct intel_buffer_range gpu_active[INTEL_BUFFER_MAX_ACTIVE_RANGES];
+   unsigned num_gpu_active_ranges;
 
    /**
     * If we've avoided stalls/blits using the active tracking, flag the buffer
@@ -265,15 +265,17 @@ intel_copy_image_sub_data(struct gl_context *ctx,
 
    /* We are now going to try and copy the texture using the blitter.  If
     * that fails, we will fall back mapping the texture and using memcpy.
-    * In either case, we need to do a full resolve.
+    * In either case, we need to resolve the slices and rectangles involved.
     */
-   intel_miptree_all_slices_resolve_hiz(brw, src_mt);
-   intel_miptree_all_slices_resolve_depth(brw, src_mt);
-   intel_miptree_resolve_color(brw, src_mt);
-
-   intel_miptree_all_slices_resolve_hiz(brw, dst_mt);
-   intel_miptree_all_slices_resolve_depth(brw, dst_mt);
-   intel_miptree_resolve_color(brw, dst_mt);
+   intel_miptree_slice_resolve_hiz(brw, src_mt, src_level, src_z);
+   intel_miptree_slice_resolve_depth(brw, src_mt, src_level, src_z);
+   intel_miptree_resolve_color_rect(brw, src_mt, src_x, src_y,
+                                    src_x + src_width, src_y + src_height);
+
+   intel_miptree_slice_resolve_hiz(brw, dst_mt, dst_level, dst_z);
+   intel_miptree_slice_resolve_depth(brw, dst_mt, dst_level, dst_z);
+   intel_miptree_resolve_color_rect(brw, dst_mt, dst_x, dst_y,
+                                    dst_x + src_width, dst_y + src_height);
 
    if (copy_image_with_blitter(brw, src_mt, src_level,
                                src_x, src_y, src_z,
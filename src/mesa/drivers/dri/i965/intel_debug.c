@@ -79,6 +79,9 @@ static const struct debug_control debug_control[] = {
    { "ds",          DEBUG_TES },
    { "tes",         DEBUG_TES },
    { "l3",          DEBUG_L3 },
+   { "packets",     DEBUG_PACKETS },
+   { "nodedup",     DEBUG_NO_DEDUP },
+   { "draw_time",   DEBUG_DRAW_TIME },
    { NULL,    0 }
 };
 
@@ -1953,6 +1953,23 @@ intel_miptree_slice_resolve_depth(struct brw_context *brw,
 				      GEN6_HIZ_OP_DEPTH_RESOLVE);
 }
 
+bool
+intel_miptree_slice_discard_depth_resolve(struct intel_mipmap_tree *mt,
+                                          uint32_t level,
+                                          uint32_t layer)
+{
+   intel_miptree_check_level_layer(mt, level, layer);
+
+   struct intel_resolve_map *item =
+      intel_resolve_map_get(&mt->hiz_map, level, layer);
+
+   if (!item || item->need != GEN6_HIZ_OP_DEPTH_RESOLVE)
+      return false;
+
+   intel_resolve_map_remove(item);
+   return true;
+}
+
 static bool
 intel_miptree_all_slices_resolve(struct brw_context *brw,
 				 struct intel_mipmap_tree *mt,
@@ -2007,6 +2024,43 @@ intel_miptree_resolve_color(struct brw_context *brw,
    }
 }
 
+/**
+ * Like intel_miptree_resolve_color(), but only guarantees correct contents
+ * for the given pixel rectangle, so that small reads out of a big
+ * fast-cleared buffer don't resolve all of it.
+ *
+ * Only level 0, layer 0 miptrees get fast cleared, so the rectangle is all
+ * that's needed to pick the region.
+ */
+void
+intel_miptree_resolve_color_rect(struct brw_context *brw,
+                                 struct intel_mipmap_tree *mt,
+                                 uint32_t x0, uint32_t y0,
+                                 uint32_t x1, uint32_t y1)
+{
+   switch (mt->fast_clear_state) {
+   case INTEL_FAST_CLEAR_STATE_NO_MCS:
+   case INTEL_FAST_CLEAR_STATE_RESOLVED:
+      /* No resolve needed */
+      return;
+   case INTEL_FAST_CLEAR_STATE_UNRESOLVED:
+   case INTEL_FAST_CLEAR_STATE_CLEAR:
+      break;
+   }
+
+   if (mt->msaa_layout != INTEL_MSAA_LAYOUT_NONE)
+      return;
+
+   if (mt->fast_clear_state == INTEL_FAST_CLEAR_STATE_UNRESOLVED &&
+       x0 >= mt->fast_clear_resolved_rect.x0 &&
+       y0 >= mt->fast_clear_resolved_rect.y0 &&
+       x1 <= mt->fast_clear_resolved_rect.x1 &&
+       y1 <= mt->fast_clear_resolved_rect.y1)
+      return;
+
+   brw_meta_resolve_color_rect(brw, mt, x0, y0, x1, y1);
+}
+
 
 /**
  * Make it possible to share the BO backing the given miptree with another
@@ -629,6 +629,20 @@ struct intel_mipmap_tree
     */
    enum intel_fast_clear_state fast_clear_state;
 
+   /**
+    * Pixels of a single-sample buffer in INTEL_FAST_CLEAR_STATE_UNRESOLVED
+    * that a partial render target resolve has left with correct contents,
+    * so that reading them again doesn't need another resolve.  Empty when
+    * x0 >= x1.
+    *
+    * Rendering to the miptree resets it.
+    *
+    * \see intel_miptree_resolve_color_rect()
+    */
+   struct {
+      uint32_t x0, y0, x1, y1;
+   } fast_clear_resolved_rect;
+
    /**
     * The SURFACE_STATE bits associated with the last fast color clear to this
     * color mipmap tree, if any.
@@ -853,6 +867,17 @@ intel_miptree_slice_resolve_depth(struct brw_context *brw,
 				  unsigned int level,
 				  unsigned int depth);
 
+/**
+ * Drops a pending depth resolve of the slice without doing it, for when the
+ * whole slice is about to be overwritten without HiZ.
+ *
+ * \return false if no resolve was pending
+ */
+bool
+intel_miptree_slice_discard_depth_resolve(struct intel_mipmap_tree *mt,
+                                          uint32_t level,
+                                          uint32_t layer);
+
 /**
  * \return false if no resolve was needed
  */
@@ -882,12 +907,21 @@ intel_miptree_used_for_rendering(struct intel_mipmap_tree *mt)
     */
    if (mt->fast_clear_state == INTEL_FAST_CLEAR_STATE_CLEAR)
       mt->fast_clear_state = INTEL_FAST_CLEAR_STATE_UNRESOLVED;
+
+   mt->fast_clear_resolved_rect.x0 = 0;
+   mt->fast_clear_resolved_rect.x1 = 0;
 }
 
 void
 intel_miptree_resolve_color(struct brw_context *brw,
                             struct intel_mipmap_tree *mt);
 
+void
+intel_miptree_resolve_color_rect(struct brw_context *brw,
+                                 struct intel_mipmap_tree *mt,
+                                 uint32_t x0, uint32_t y0,
+                                 uint32_t x1, uint32_t y1);
+
 void
 intel_miptree_make_shareable(struct brw_context *brw,
                              struct intel_mipmap_tree *mt);
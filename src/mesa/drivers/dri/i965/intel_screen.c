@@ -34,6 +34,7 @@
 #include "main/fbobject.h"
 #include "main/version.h"
 #include "swrast/s_renderbuffer.h"
+#include "util/disk_cache.h"
 #include "util/ralloc.h"
 #include "brw_shader.h"
 #include "glsl/nir/nir.h"
@@ -966,6 +967,10 @@ intelDestroyScreen(__DRIscreen * sPriv)
    dri_bufmgr_destroy(intelScreen->bufmgr);
    driDestroyOptionInfo(&intelScreen->optionCache);
 
+   if (intelScreen->disk_cache)
+      disk_cache_destroy(intelScreen->disk_cache);
+   pthread_mutex_destroy(&intelScreen->disk_cache_mutex);
+
    ralloc_free(intelScreen);
    sPriv->driverPrivate = NULL;
 }
@@ -1395,6 +1400,10 @@ brw_get_revision(int fd)
 #define I915_PARAM_HAS_RESOURCE_STREAMER 36
 #endif
 
+#ifndef I915_PARAM_MMAP_VERSION
+#define I915_PARAM_MMAP_VERSION 30
+#endif
+
 /**
  * This is the driver specific part of the createNewScreen entry point.
  * Called when using DRI2.
@@ -1492,6 +1501,13 @@ __DRIconfig **intelInitScreen2(__DRIscreen *psp)
    if (ret == -1)
       intelScreen->cmd_parser_version = 0;
 
+   /* Version 1 added write-combined CPU mappings. */
+   int mmap_version = 0;
+   getparam.param = I915_PARAM_MMAP_VERSION;
+   getparam.value = &mmap_version;
+   if (drmIoctl(psp->fd, DRM_IOCTL_I915_GETPARAM, &getparam) == 0)
+      intelScreen->has_mmap_wc = mmap_version >= 1;
+
    psp->extensions = !intelScreen->has_context_reset_notification
       ? intelScreenExtensions : intelRobustScreenExtensions;
 
@@ -1499,6 +1515,9 @@ __DRIconfig **intelInitScreen2(__DRIscreen *psp)
                                                intelScreen->devinfo);
    intelScreen->program_id = 1;
 
+   intelScreen->disk_cache = disk_cache_create();
+   pthread_mutex_init(&intelScreen->disk_cache_mutex, NULL);
+
    if (intelScreen->devinfo->has_resource_streamer) {
       int val = -1;
       getparam.param = I915_PARAM_HAS_RESOURCE_STREAMER;
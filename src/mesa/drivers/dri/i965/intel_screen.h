@@ -26,6 +26,7 @@
 #ifndef _INTEL_INIT_H_
 #define _INTEL_INIT_H_
 
+#include <pthread.h>
 #include <stdbool.h>
 #include <sys/time.h>
 
@@ -62,6 +63,12 @@ struct intel_screen
     */
    bool has_context_reset_notification;
 
+   /**
+    * Can buffers be mapped write-combined through the CPU, instead of through
+    * the GTT (I915_MMAP_WC)?
+    */
+   bool has_mmap_wc;
+
    dri_bufmgr *bufmgr;
 
    /**
@@ -73,6 +80,14 @@ struct intel_screen
 
    struct brw_compiler *compiler;
 
+   /**
+    * On-disk cache of compiled programs, shared by all contexts.  NULL if
+    * the cache is disabled.  disk_cache isn't thread-safe, so all accesses
+    * take disk_cache_mutex.
+    */
+   struct disk_cache *disk_cache;
+   pthread_mutex_t disk_cache_mutex;
+
    /**
    * Configuration cache with default values for all contexts
    */
@@ -43,13 +43,71 @@
 
 #define FILE_DEBUG_FLAG DEBUG_TEXTURE
 
+/**
+ * Uploads a rectangle of a busy miptree through a linear staging miptree,
+ * which the blitter then copies into place after the rendering already
+ * queued, instead of stalling until the GPU is done with the texture.
+ *
+ * \return false if the blitter can't do the copy
+ */
+static bool
+intel_texsubimage_staged_memcpy(struct brw_context *brw,
+                                struct intel_mipmap_tree *mt, int level,
+                                GLint xoffset, GLint yoffset,
+                                GLsizei width, GLsizei height,
+                                const GLvoid *pixels, int src_pitch,
+                                uint32_t cpp, mem_copy_fn mem_copy)
+{
+   struct intel_mipmap_tree *staging;
+   const char *src = pixels;
+   char *dst;
+   int y;
+
+   staging = intel_miptree_create(brw, GL_TEXTURE_2D, mt->format,
+                                  0, 0, width, height, 1, 0,
+                                  MIPTREE_LAYOUT_TILING_NONE |
+                                  MIPTREE_LAYOUT_DISABLE_AUX);
+   if (!staging)
+      return false;
+
+   if (brw_bo_map(brw, staging->bo, true /* write enable */, "staging")) {
+      intel_miptree_release(&staging);
+      return false;
+   }
+
+   dst = (char *) staging->bo->virtual + staging->offset;
+   for (y = 0; y < height; y++) {
+      mem_copy(dst, src, width * cpp);
+      dst += staging->pitch;
+      src += src_pitch;
+   }
+
+   drm_intel_bo_unmap(staging->bo);
+
+   if (!intel_miptree_blit(brw,
+                           staging, 0, 0, 0, 0, false,
+                           mt, level, 0, xoffset, yoffset, false,
+                           width, height, GL_COPY)) {
+      intel_miptree_release(&staging);
+      return false;
+   }
+
+   DBG("%s: staged upload level=%d offset=(%d,%d) (w,h)=(%d,%d)\n",
+       __func__, level, xoffset, yoffset, width, height);
+
+   intel_miptree_release(&staging);
+   return true;
+}
+
 /**
  * \brief A fast path for glTexImage and glTexSubImage.
  *
  * \param for_glTexImage Was this called from glTexImage or glTexSubImage?
  *
- * This fast path is taken when the texture format is BGRA, RGBA,
- * A or L and when the texture memory is X- or Y-tiled.  It uploads
+ * This fast path is taken when intel_get_memcpy() supports the texture
+ * format and the client data, and when the texture memory is X- or Y-tiled.
+ * If the texture is busy, the data goes through a staging buffer and a
+ * blit instead, when the blitter can handle the format.  Otherwise it uploads
  * the texture data by mapping the texture memory without a GTT fence, thus
  * acquiring a tiled view of the memory, and then copying sucessive
  * spans within each tile.
@@ -91,9 +149,8 @@ intel_texsubimage_tiled_memcpy(struct gl_context * ctx,
    uint32_t cpp;
    mem_copy_fn mem_copy = NULL;
 
-   /* This fastpath is restricted to specific texture types:
-    * a 2D BGRA, RGBA, L8 or A8 texture. It could be generalized to support
-    * more types.
+   /* This fastpath is restricted to 2D textures whose format is handled by
+    * intel_get_memcpy().
     *
     * FINISHME: The restrictions below on packing alignment and packing row
     * length are likely unneeded now because we calculate the source stride
@@ -101,7 +158,6 @@ intel_texsubimage_tiled_memcpy(struct gl_context * ctx,
     * we need tests.
     */
    if (!brw->has_llc ||
-       !(type == GL_UNSIGNED_BYTE || type == GL_UNSIGNED_INT_8_8_8_8_REV) ||
        !(texImage->TexObject->Target == GL_TEXTURE_2D ||
          texImage->TexObject->Target == GL_TEXTURE_RECTANGLE) ||
        pixels == NULL ||
@@ -137,6 +193,19 @@ intel_texsubimage_tiled_memcpy(struct gl_context * ctx,
       return false;
    }
 
+   src_pitch = _mesa_image_row_stride(packing, width, format, type);
+
+   int level = texImage->Level + texImage->TexObject->MinLevel;
+
+   /* Don't wait for the GPU to be done with the texture, copy the data to a
+    * new buffer and blit it from there.
+    */
+   if (!for_glTexImage && drm_intel_bo_busy(image->mt->bo) &&
+       intel_texsubimage_staged_memcpy(brw, image->mt, level,
+                                       xoffset, yoffset, width, height,
+                                       pixels, src_pitch, cpp, mem_copy))
+      return true;
+
    /* Since we are going to write raw data to the miptree, we need to resolve
     * any pending fast color clears before we start.
     */
@@ -155,8 +224,6 @@ intel_texsubimage_tiled_memcpy(struct gl_context * ctx,
       return false;
    }
 
-   src_pitch = _mesa_image_row_stride(packing, width, format, type);
-
    /* We postponed printing this message until having committed to executing
     * the function.
     */
@@ -169,8 +236,6 @@ intel_texsubimage_tiled_memcpy(struct gl_context * ctx,
        packing->Alignment, packing->RowLength, packing->SkipPixels,
        packing->SkipRows, for_glTexImage);
 
-   int level = texImage->Level + texImage->TexObject->MinLevel;
-
    /* Adjust x and y offset based on miplevel */
    xoffset += image->mt->level[level].level_x;
    yoffset += image->mt->level[level].level_y;
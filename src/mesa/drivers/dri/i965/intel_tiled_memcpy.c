@@ -29,17 +29,48 @@
  *    Frank Henigman <fjhenigman@google.com>
  */
 
+/* This file is also built with SSE4.1 and AVX2 enabled, by
+ * intel_tiled_memcpy_sse41.c and intel_tiled_memcpy_avx2.c, which define
+ * INLINE_SSE41 or INLINE_AVX2 and include it.  Those builds only provide the
+ * tile walkers, named with a _sse41 or _avx2 suffix; linear_to_tiled() and
+ * tiled_to_linear() pick one at runtime.
+ */
+
 #include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 #include "util/macros.h"
 
 #include "brw_context.h"
 #include "intel_tiled_memcpy.h"
 
+#if defined(INLINE_AVX2)
+#include <immintrin.h>
+#define FUNC(name) name##_avx2
+#define TILED_MEMCPY_VARIANT
+#elif defined(INLINE_SSE41)
+#include <smmintrin.h>
+#define FUNC(name) name##_sse41
+#define TILED_MEMCPY_VARIANT
+#else
+#include "c11/threads.h"
+#include "x86/common_x86_asm.h"
+#define FUNC(name) name##_generic
+#endif
+
 #ifdef __SSSE3__
 #include <tmmintrin.h>
 #endif
 
+/* Non-temporal stores only need SSE2, but keeping them out of the generic
+ * build leaves that one exactly as portable as it was.
+ */
+#if defined(TILED_MEMCPY_VARIANT) && defined(__SSE4_1__)
+#define HAVE_STREAMING_STORES
+#endif
+
 #define FILE_DEBUG_FLAG DEBUG_TEXTURE
 
 #define ALIGN_DOWN(a, b) ROUND_DOWN_TO(a, b)
@@ -73,6 +104,20 @@ static const uint8_t rgba8_permutation[16] =
                                      *(__m128i *) rgba8_permutation))
 #endif
 
+#ifdef __AVX2__
+/* The byte shuffle works within each 16-byte lane, so the permutation is
+ * the same one twice.
+ */
+#define rgba8_permutation_32                                           \
+   _mm256_broadcastsi128_si256(_mm_loadu_si128((__m128i *) rgba8_permutation))
+
+#define rgba8_copy_32_unaligned(dst, src)                              \
+   _mm256_storeu_si256((__m256i *)(dst),                               \
+                       _mm256_shuffle_epi8(                            \
+                          _mm256_loadu_si256((__m256i *)(src)),        \
+                          rgba8_permutation_32))
+#endif
+
 /**
  * Copy RGBA to BGRA - swap R and B, with the destination 16-byte aligned.
  */
@@ -91,10 +136,15 @@ rgba8_copy_aligned_dst(void *dst, const void *src, size_t bytes)
 
    if (bytes == 64) {
       assert(!(((uintptr_t)dst) & 0xf));
+#ifdef __AVX2__
+      rgba8_copy_32_unaligned(d+ 0, s+ 0);
+      rgba8_copy_32_unaligned(d+32, s+32);
+#else
       rgba8_copy_16_aligned_dst(d+ 0, s+ 0);
       rgba8_copy_16_aligned_dst(d+16, s+16);
       rgba8_copy_16_aligned_dst(d+32, s+32);
       rgba8_copy_16_aligned_dst(d+48, s+48);
+#endif
       return dst;
    }
 #endif
@@ -129,10 +179,15 @@ rgba8_copy_aligned_src(void *dst, const void *src, size_t bytes)
 
    if (bytes == 64) {
       assert(!(((uintptr_t)src) & 0xf));
+#ifdef __AVX2__
+      rgba8_copy_32_unaligned(d+ 0, s+ 0);
+      rgba8_copy_32_unaligned(d+32, s+32);
+#else
       rgba8_copy_16_aligned_src(d+ 0, s+ 0);
       rgba8_copy_16_aligned_src(d+16, s+16);
       rgba8_copy_16_aligned_src(d+32, s+32);
       rgba8_copy_16_aligned_src(d+48, s+48);
+#endif
       return dst;
    }
 #endif
@@ -149,6 +204,81 @@ rgba8_copy_aligned_src(void *dst, const void *src, size_t bytes)
    return dst;
 }
 
+#ifdef HAVE_STREAMING_STORES
+/**
+ * Store 16 bytes at the 16-byte aligned \p dst, bypassing the cache.
+ */
+static inline void
+stream_16(char *dst, __m128i data)
+{
+   assert(!(((uintptr_t)dst) & 0xf));
+   _mm_stream_si128((__m128i *) dst, data);
+}
+
+/**
+ * memcpy() with non-temporal stores, with the destination 16-byte aligned.
+ *
+ * Only whole spans (16 or 64 bytes) are streamed; the partial spans at the
+ * edges of the copy go through the cache as usual.  The caller has to
+ * _mm_sfence() once it's done.
+ */
+static inline void *
+memcpy_streaming_aligned_dst(void *dst, const void *src, size_t bytes)
+{
+   char *d = dst;
+   const char *s = src;
+
+   if (bytes == 16) {
+      stream_16(d, _mm_loadu_si128((__m128i *) s));
+      return dst;
+   }
+
+   if (bytes == 64) {
+#ifdef __AVX2__
+      if (!(((uintptr_t)d) & 0x1f)) {
+         _mm256_stream_si256((__m256i *) (d +  0),
+                             _mm256_loadu_si256((__m256i *) (s +  0)));
+         _mm256_stream_si256((__m256i *) (d + 32),
+                             _mm256_loadu_si256((__m256i *) (s + 32)));
+         return dst;
+      }
+#endif
+      stream_16(d +  0, _mm_loadu_si128((__m128i *) (s +  0)));
+      stream_16(d + 16, _mm_loadu_si128((__m128i *) (s + 16)));
+      stream_16(d + 32, _mm_loadu_si128((__m128i *) (s + 32)));
+      stream_16(d + 48, _mm_loadu_si128((__m128i *) (s + 48)));
+      return dst;
+   }
+
+   return memcpy(dst, src, bytes);
+}
+
+/**
+ * rgba8_copy_aligned_dst() with non-temporal stores.
+ *
+ * \copydetails memcpy_streaming_aligned_dst
+ */
+static inline void *
+rgba8_copy_streaming_aligned_dst(void *dst, const void *src, size_t bytes)
+{
+   const __m128i permutation = _mm_loadu_si128((__m128i *) rgba8_permutation);
+   char *d = dst;
+   const char *s = src;
+   unsigned i;
+
+   if (bytes != 16 && bytes != 64)
+      return rgba8_copy_aligned_dst(dst, src, bytes);
+
+   for (i = 0; i < bytes; i += 16) {
+      stream_16(d + i,
+                _mm_shuffle_epi8(_mm_loadu_si128((__m128i *) (s + i)),
+                                 permutation));
+   }
+
+   return dst;
+}
+#endif
+
 /**
  * Each row from y0 to y1 is copied in three parts: [x0,x1), [x1,x2), [x2,x3).
  * These ranges are in bytes, i.e. pixels * bytes-per-pixel.
@@ -275,6 +405,40 @@ linear_to_ytiled(uint32_t x0, uint32_t x1, uint32_t x2, uint32_t x3,
  *
  * \copydoc tile_copy_fn
  */
+#ifdef HAVE_STREAMING_STORES
+/**
+ * Copy a whole Y tile from linear, writing the tile in order.
+ *
+ * linear_to_ytiled() walks the source in order, which stores 16 bytes into
+ * each of the tile's columns per row.  Non-temporal stores work best when
+ * each cache line is filled before moving to the next one, so this goes
+ * down each column instead, reading the source with a stride.
+ */
+static inline void
+linear_to_ytiled_columns(char *dst, const char *src,
+                         int32_t src_pitch,
+                         uint32_t swizzle_bit,
+                         mem_copy_fn mem_copy)
+{
+   const uint32_t bytes_per_column = ytile_span * ytile_height;
+   uint32_t x, y;
+
+   for (x = 0; x < ytile_width; x += ytile_span) {
+      /* Only the column contributes to bit 9 of the offset, see
+       * linear_to_ytiled().
+       */
+      const uint32_t xo = (x / ytile_span) * bytes_per_column;
+      const uint32_t swizzle = (xo >> 3) & swizzle_bit;
+      const char *s = src + x;
+
+      for (y = 0; y < ytile_height; y++) {
+         mem_copy(dst + ((xo + y * ytile_span) ^ swizzle), s, ytile_span);
+         s += src_pitch;
+      }
+   }
+}
+#endif
+
 static inline void
 xtiled_to_linear(uint32_t x0, uint32_t x1, uint32_t x2, uint32_t x3,
                  uint32_t y0, uint32_t y1,
@@ -398,6 +562,16 @@ linear_to_xtiled_faster(uint32_t x0, uint32_t x1, uint32_t x2, uint32_t x3,
          return linear_to_xtiled(0, 0, xtile_width, xtile_width, 0, xtile_height,
                                  dst, src, src_pitch, swizzle_bit,
                                  rgba8_copy_aligned_dst);
+#ifdef HAVE_STREAMING_STORES
+      else if (mem_copy == memcpy_streaming_aligned_dst)
+         return linear_to_xtiled(0, 0, xtile_width, xtile_width, 0, xtile_height,
+                                 dst, src, src_pitch, swizzle_bit,
+                                 memcpy_streaming_aligned_dst);
+      else if (mem_copy == rgba8_copy_streaming_aligned_dst)
+         return linear_to_xtiled(0, 0, xtile_width, xtile_width, 0, xtile_height,
+                                 dst, src, src_pitch, swizzle_bit,
+                                 rgba8_copy_streaming_aligned_dst);
+#endif
       else
          unreachable("not reached");
    } else {
@@ -408,6 +582,16 @@ linear_to_xtiled_faster(uint32_t x0, uint32_t x1, uint32_t x2, uint32_t x3,
          return linear_to_xtiled(x0, x1, x2, x3, y0, y1,
                                  dst, src, src_pitch, swizzle_bit,
                                  rgba8_copy_aligned_dst);
+#ifdef HAVE_STREAMING_STORES
+      else if (mem_copy == memcpy_streaming_aligned_dst)
+         return linear_to_xtiled(x0, x1, x2, x3, y0, y1,
+                                 dst, src, src_pitch, swizzle_bit,
+                                 memcpy_streaming_aligned_dst);
+      else if (mem_copy == rgba8_copy_streaming_aligned_dst)
+         return linear_to_xtiled(x0, x1, x2, x3, y0, y1,
+                                 dst, src, src_pitch, swizzle_bit,
+                                 rgba8_copy_streaming_aligned_dst);
+#endif
       else
          unreachable("not reached");
    }
@@ -440,6 +624,14 @@ linear_to_ytiled_faster(uint32_t x0, uint32_t x1, uint32_t x2, uint32_t x3,
          return linear_to_ytiled(0, 0, ytile_width, ytile_width, 0, ytile_height,
                                  dst, src, src_pitch, swizzle_bit,
                                  rgba8_copy_aligned_dst);
+#ifdef HAVE_STREAMING_STORES
+      else if (mem_copy == memcpy_streaming_aligned_dst)
+         return linear_to_ytiled_columns(dst, src, src_pitch, swizzle_bit,
+                                         memcpy_streaming_aligned_dst);
+      else if (mem_copy == rgba8_copy_streaming_aligned_dst)
+         return linear_to_ytiled_columns(dst, src, src_pitch, swizzle_bit,
+                                         rgba8_copy_streaming_aligned_dst);
+#endif
       else
          unreachable("not reached");
    } else {
@@ -450,6 +642,16 @@ linear_to_ytiled_faster(uint32_t x0, uint32_t x1, uint32_t x2, uint32_t x3,
          return linear_to_ytiled(x0, x1, x2, x3, y0, y1,
                                  dst, src, src_pitch, swizzle_bit,
                                  rgba8_copy_aligned_dst);
+#ifdef HAVE_STREAMING_STORES
+      else if (mem_copy == memcpy_streaming_aligned_dst)
+         return linear_to_ytiled(x0, x1, x2, x3, y0, y1,
+                                 dst, src, src_pitch, swizzle_bit,
+                                 memcpy_streaming_aligned_dst);
+      else if (mem_copy == rgba8_copy_streaming_aligned_dst)
+         return linear_to_ytiled(x0, x1, x2, x3, y0, y1,
+                                 dst, src, src_pitch, swizzle_bit,
+                                 rgba8_copy_streaming_aligned_dst);
+#endif
       else
          unreachable("not reached");
    }
@@ -551,16 +753,21 @@ ytiled_to_linear_faster(uint32_t x0, uint32_t x1, uint32_t x2, uint32_t x3,
  * The Y range is in pixels (i.e. unitless).
  * 'dst' is the start of the texture and 'src' is the corresponding
  * address to copy from, though copying begins at (xt1, yt1).
+ * If 'streaming' is set, whole spans are written with non-temporal stores
+ * where the build supports them.
  */
 void
-linear_to_tiled(uint32_t xt1, uint32_t xt2,
-                uint32_t yt1, uint32_t yt2,
-                char *dst, const char *src,
-                uint32_t dst_pitch, int32_t src_pitch,
-                bool has_swizzling,
-                uint32_t tiling,
-                mem_copy_fn mem_copy)
+FUNC(linear_to_tiled)(uint32_t xt1, uint32_t xt2,
+                      uint32_t yt1, uint32_t yt2,
+                      char *dst, const char *src,
+                      uint32_t dst_pitch, int32_t src_pitch,
+                      bool has_swizzling,
+                      uint32_t tiling,
+                      enum intel_memcpy_type copy_type,
+                      bool streaming)
 {
+   mem_copy_fn mem_copy = copy_type == INTEL_MEMCPY_BGRA8 ?
+                          rgba8_copy_aligned_dst : memcpy;
    tile_copy_fn tile_copy;
    uint32_t xt0, xt3;
    uint32_t yt0, yt3;
@@ -582,6 +789,16 @@ linear_to_tiled(uint32_t xt1, uint32_t xt2,
       unreachable("unsupported tiling");
    }
 
+#ifdef HAVE_STREAMING_STORES
+   if (streaming) {
+      mem_copy = copy_type == INTEL_MEMCPY_BGRA8 ?
+                 rgba8_copy_streaming_aligned_dst :
+                 memcpy_streaming_aligned_dst;
+   }
+#else
+   (void) streaming;
+#endif
+
    /* Round out to tile boundaries. */
    xt0 = ALIGN_DOWN(xt1, tw);
    xt3 = ALIGN_UP  (xt2, tw);
@@ -630,6 +847,11 @@ linear_to_tiled(uint32_t xt1, uint32_t xt2,
                    mem_copy);
       }
    }
+
+#ifdef HAVE_STREAMING_STORES
+   if (streaming)
+      _mm_sfence();
+#endif
 }
 
 /**
@@ -644,14 +866,16 @@ linear_to_tiled(uint32_t xt1, uint32_t xt2,
  * address to copy from, though copying begins at (xt1, yt1).
  */
 void
-tiled_to_linear(uint32_t xt1, uint32_t xt2,
-                uint32_t yt1, uint32_t yt2,
-                char *dst, const char *src,
-                int32_t dst_pitch, uint32_t src_pitch,
-                bool has_swizzling,
-                uint32_t tiling,
-                mem_copy_fn mem_copy)
+FUNC(tiled_to_linear)(uint32_t xt1, uint32_t xt2,
+                      uint32_t yt1, uint32_t yt2,
+                      char *dst, const char *src,
+                      int32_t dst_pitch, uint32_t src_pitch,
+                      bool has_swizzling,
+                      uint32_t tiling,
+                      enum intel_memcpy_type copy_type)
 {
+   mem_copy_fn mem_copy = copy_type == INTEL_MEMCPY_BGRA8 ?
+                          rgba8_copy_aligned_src : memcpy;
    tile_copy_fn tile_copy;
    uint32_t xt0, xt3;
    uint32_t yt0, yt3;
@@ -723,6 +947,226 @@ tiled_to_linear(uint32_t xt1, uint32_t xt2,
    }
 }
 
+#ifndef TILED_MEMCPY_VARIANT
+
+/* Copies at least this large write the tiled image with non-temporal
+ * stores.  They'd push everything else out of the cache and then thrash it
+ * themselves, and the GPU is what reads the data next anyway.
+ */
+#define STREAMING_MIN_BYTES (2 * 1024 * 1024)
+
+/* Copies at least this large are split across threads, with at least this
+ * much per thread.
+ */
+#define THREADED_MIN_BYTES (1024 * 1024)
+#define MAX_THREADS 4
+
+typedef void (*linear_to_tiled_fn)(uint32_t xt1, uint32_t xt2,
+                                   uint32_t yt1, uint32_t yt2,
+                                   char *dst, const char *src,
+                                   uint32_t dst_pitch, int32_t src_pitch,
+                                   bool has_swizzling,
+                                   uint32_t tiling,
+                                   enum intel_memcpy_type copy_type,
+                                   bool streaming);
+
+typedef void (*tiled_to_linear_fn)(uint32_t xt1, uint32_t xt2,
+                                   uint32_t yt1, uint32_t yt2,
+                                   char *dst, const char *src,
+                                   int32_t dst_pitch, uint32_t src_pitch,
+                                   bool has_swizzling,
+                                   uint32_t tiling,
+                                   enum intel_memcpy_type copy_type);
+
+/**
+ * A band of tile rows of a copy, for one thread.
+ */
+struct tiled_memcpy_band {
+   linear_to_tiled_fn linear_to_tiled;
+   tiled_to_linear_fn tiled_to_linear;
+
+   uint32_t xt1, xt2, yt1, yt2;
+   char *dst;
+   const char *src;
+   /* The pitch of the tiled image comes first, as in linear_to_tiled(). */
+   uint32_t tiled_pitch;
+   int32_t linear_pitch;
+   bool has_swizzling;
+   uint32_t tiling;
+   enum intel_memcpy_type copy_type;
+   bool streaming;
+};
+
+static int
+tiled_memcpy_band_run(void *data)
+{
+   const struct tiled_memcpy_band *b = data;
+
+   if (b->linear_to_tiled) {
+      b->linear_to_tiled(b->xt1, b->xt2, b->yt1, b->yt2, b->dst, b->src,
+                         b->tiled_pitch, b->linear_pitch,
+                         b->has_swizzling, b->tiling, b->copy_type,
+                         b->streaming);
+   } else {
+      b->tiled_to_linear(b->xt1, b->xt2, b->yt1, b->yt2, b->dst, b->src,
+                         b->linear_pitch, b->tiled_pitch,
+                         b->has_swizzling, b->tiling, b->copy_type);
+   }
+
+   return 0;
+}
+
+static unsigned cpu_count = 1;
+
+static void
+tiled_memcpy_init_cpu_count(void)
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+   long count = sysconf(_SC_NPROCESSORS_ONLN);
+   if (count > 0)
+      cpu_count = count;
+#endif
+}
+
+/**
+ * Run the copy described by \p copy on up to MAX_THREADS threads, each
+ * taking a band of whole tile rows.  Tiles don't straddle bands, so the
+ * threads never write the same bytes.
+ */
+static void
+tiled_memcpy_split(const struct tiled_memcpy_band *copy)
+{
+   static once_flag once = ONCE_FLAG_INIT;
+   const uint32_t th = copy->tiling == I915_TILING_X ? xtile_height
+                                                     : ytile_height;
+   const uint64_t bytes = (uint64_t) (copy->xt2 - copy->xt1) *
+                          (copy->yt2 - copy->yt1);
+   struct tiled_memcpy_band bands[MAX_THREADS];
+   bool started[MAX_THREADS];
+   thrd_t threads[MAX_THREADS];
+   unsigned num_bands, i;
+   uint32_t yt0, rows_per_band;
+
+   call_once(&once, tiled_memcpy_init_cpu_count);
+
+   num_bands = MIN3(cpu_count, MAX_THREADS, bytes / THREADED_MIN_BYTES);
+   if (num_bands <= 1) {
+      tiled_memcpy_band_run((void *) copy);
+      return;
+   }
+
+   yt0 = ALIGN_DOWN(copy->yt1, th);
+   rows_per_band = ALIGN_UP(DIV_ROUND_UP(copy->yt2 - yt0, num_bands), th);
+
+   for (i = 0; i < num_bands; i++) {
+      bands[i] = *copy;
+      bands[i].yt1 = MAX2(copy->yt1, MIN2(copy->yt2, yt0 + i * rows_per_band));
+      bands[i].yt2 = MIN2(copy->yt2, yt0 + (i + 1) * rows_per_band);
+   }
+
+   /* This thread copies the first band.  If a thread can't be started, its
+    * band is copied here too.
+    */
+   for (i = 1; i < num_bands; i++) {
+      started[i] = bands[i].yt1 < bands[i].yt2 &&
+                   thrd_create(&threads[i], tiled_memcpy_band_run,
+                               &bands[i]) == thrd_success;
+   }
+
+   tiled_memcpy_band_run(&bands[0]);
+
+   for (i = 1; i < num_bands; i++) {
+      if (started[i])
+         thrd_join(threads[i], NULL);
+      else if (bands[i].yt1 < bands[i].yt2)
+         tiled_memcpy_band_run(&bands[i]);
+   }
+}
+
+/**
+ * Copy from linear to tiled texture.
+ *
+ * This picks the fastest tile walker the CPU supports, uses non-temporal
+ * stores for large copies and spreads large copies over multiple threads.
+ * See linear_to_tiled_generic() for the parameters.
+ */
+void
+linear_to_tiled(uint32_t xt1, uint32_t xt2,
+                uint32_t yt1, uint32_t yt2,
+                char *dst, const char *src,
+                uint32_t dst_pitch, int32_t src_pitch,
+                bool has_swizzling,
+                uint32_t tiling,
+                mem_copy_fn mem_copy)
+{
+   struct tiled_memcpy_band copy = {
+      .linear_to_tiled = linear_to_tiled_generic,
+      .xt1 = xt1, .xt2 = xt2, .yt1 = yt1, .yt2 = yt2,
+      .dst = dst, .src = src,
+      .tiled_pitch = dst_pitch, .linear_pitch = src_pitch,
+      .has_swizzling = has_swizzling,
+      .tiling = tiling,
+      .copy_type = mem_copy == memcpy ? INTEL_MEMCPY : INTEL_MEMCPY_BGRA8,
+   };
+
+   assert(mem_copy == memcpy || mem_copy == rgba8_copy_aligned_dst);
+
+   copy.streaming = (uint64_t) (xt2 - xt1) * (yt2 - yt1) >=
+                    STREAMING_MIN_BYTES;
+
+#if defined(USE_AVX2)
+   if (cpu_has_avx2)
+      copy.linear_to_tiled = linear_to_tiled_avx2;
+   else
+#endif
+#if defined(USE_SSE41)
+   if (cpu_has_sse4_1)
+      copy.linear_to_tiled = linear_to_tiled_sse41;
+#endif
+
+   tiled_memcpy_split(&copy);
+}
+
+/**
+ * Copy from tiled to linear texture.
+ *
+ * This picks the fastest tile walker the CPU supports and spreads large
+ * copies over multiple threads.  See tiled_to_linear_generic() for the
+ * parameters.
+ */
+void
+tiled_to_linear(uint32_t xt1, uint32_t xt2,
+                uint32_t yt1, uint32_t yt2,
+                char *dst, const char *src,
+                int32_t dst_pitch, uint32_t src_pitch,
+                bool has_swizzling,
+                uint32_t tiling,
+                mem_copy_fn mem_copy)
+{
+   struct tiled_memcpy_band copy = {
+      .tiled_to_linear = tiled_to_linear_generic,
+      .xt1 = xt1, .xt2 = xt2, .yt1 = yt1, .yt2 = yt2,
+      .dst = dst, .src = src,
+      .tiled_pitch = src_pitch, .linear_pitch = dst_pitch,
+      .has_swizzling = has_swizzling,
+      .tiling = tiling,
+      .copy_type = mem_copy == memcpy ? INTEL_MEMCPY : INTEL_MEMCPY_BGRA8,
+   };
+
+   assert(mem_copy == memcpy || mem_copy == rgba8_copy_aligned_src);
+
+#if defined(USE_AVX2)
+   if (cpu_has_avx2)
+      copy.tiled_to_linear = tiled_to_linear_avx2;
+   else
+#endif
+#if defined(USE_SSE41)
+   if (cpu_has_sse4_1)
+      copy.tiled_to_linear = tiled_to_linear_sse41;
+#endif
+
+   tiled_memcpy_split(&copy);
+}
 
 /**
  * Determine which copy function to use for the given format combination
@@ -734,6 +1178,10 @@ tiled_to_linear(uint32_t xt1, uint32_t xt2,
  * to the untiled or vice versa.  The copy function required is the same in
  * either case so this function can be used.
  *
+ * For uploads, any other color format whose layout matches the client data
+ * exactly (half and single float, 16-bit, integer and packed formats) is
+ * copied with memcpy as well.
+ *
  * \param[in]  tiledFormat The format of the tiled image
  * \param[in]  format      The GL format of the client data
  * \param[in]  type        The GL type of the client data
@@ -777,6 +1225,13 @@ bool intel_get_memcpy(mesa_format tiledFormat, GLenum format,
       } else if (format == GL_RGBA) {
          *mem_copy = memcpy;
       }
+   } else if (direction == INTEL_UPLOAD &&
+              _mesa_is_format_color_format(tiledFormat) &&
+              _mesa_is_pow_two(_mesa_get_format_bytes(tiledFormat)) &&
+              _mesa_format_matches_format_and_type(tiledFormat, format, type,
+                                                   false, NULL)) {
+      *cpp = _mesa_get_format_bytes(tiledFormat);
+      *mem_copy = memcpy;
    }
 
    if (!(*mem_copy))
@@ -784,3 +1239,5 @@ bool intel_get_memcpy(mesa_format tiledFormat, GLenum format,
 
    return true;
 }
+
+#endif /* TILED_MEMCPY_VARIANT */
@@ -71,4 +71,71 @@ bool intel_get_memcpy(mesa_format tiledFormat, GLenum format,
                       GLenum type, mem_copy_fn *mem_copy, uint32_t *cpp,
                       enum intel_memcpy_direction direction);
 
+/* The tile walkers behind linear_to_tiled() and tiled_to_linear(), built
+ * once as is and once for each of SSE4.1 and AVX2 when the compiler supports
+ * them.  The copy functions intel_get_memcpy() returns are private to each
+ * build, so the walkers take the kind of copy instead.
+ */
+enum intel_memcpy_type {
+   INTEL_MEMCPY,
+   INTEL_MEMCPY_BGRA8,
+};
+
+void
+linear_to_tiled_generic(uint32_t xt1, uint32_t xt2,
+                        uint32_t yt1, uint32_t yt2,
+                        char *dst, const char *src,
+                        uint32_t dst_pitch, int32_t src_pitch,
+                        bool has_swizzling,
+                        uint32_t tiling,
+                        enum intel_memcpy_type copy_type,
+                        bool streaming);
+
+void
+tiled_to_linear_generic(uint32_t xt1, uint32_t xt2,
+                        uint32_t yt1, uint32_t yt2,
+                        char *dst, const char *src,
+                        int32_t dst_pitch, uint32_t src_pitch,
+                        bool has_swizzling,
+                        uint32_t tiling,
+                        enum intel_memcpy_type copy_type);
+
+void
+linear_to_tiled_sse41(uint32_t xt1, uint32_t xt2,
+                      uint32_t yt1, uint32_t yt2,
+                      char *dst, const char *src,
+                      uint32_t dst_pitch, int32_t src_pitch,
+                      bool has_swizzling,
+                      uint32_t tiling,
+                      enum intel_memcpy_type copy_type,
+                      bool streaming);
+
+void
+tiled_to_linear_sse41(uint32_t xt1, uint32_t xt2,
+                      uint32_t yt1, uint32_t yt2,
+                      char *dst, const char *src,
+                      int32_t dst_pitch, uint32_t src_pitch,
+                      bool has_swizzling,
+                      uint32_t tiling,
+                      enum intel_memcpy_type copy_type);
+
+void
+linear_to_tiled_avx2(uint32_t xt1, uint32_t xt2,
+                     uint32_t yt1, uint32_t yt2,
+                     char *dst, const char *src,
+                     uint32_t dst_pitch, int32_t src_pitch,
+                     bool has_swizzling,
+                     uint32_t tiling,
+                     enum intel_memcpy_type copy_type,
+                     bool streaming);
+
+void
+tiled_to_linear_avx2(uint32_t xt1, uint32_t xt2,
+                     uint32_t yt1, uint32_t yt2,
+                     char *dst, const char *src,
+                     int32_t dst_pitch, uint32_t src_pitch,
+                     bool has_swizzling,
+                     uint32_t tiling,
+                     enum intel_memcpy_type copy_type);
+
 #endif /* INTEL_TILED_MEMCPY */
@@ -0,0 +1,340 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file test_fs_scheduling.cpp
+ *
+ * Runs large generated shaders through the pre- and post-register-allocation
+ * instruction schedulers, printing how long each took, and checks that
+ * scheduling preserved the meaning of the program: each register read still
+ * sees the same write, the same writes are left last, and instructions with
+ * side effects stay in order.
+ *
+ * The shaders are made of long blocks of ALU instructions reading recent
+ * results, with message sends returning several registers and surface writes
+ * mixed in, which is roughly what the large shaders that make scheduling slow
+ * look like.
+ */
+
+#include <gtest/gtest.h>
+#include <map>
+#include <vector>
+#include <time.h>
+#include "brw_fs.h"
+#include "brw_cfg.h"
+#include "program/program.h"
+
+using namespace brw;
+
+class scheduling_test : public ::testing::Test {
+   virtual void SetUp();
+
+public:
+   struct brw_compiler *compiler;
+   struct brw_device_info *devinfo;
+   struct gl_context *ctx;
+   struct brw_wm_prog_data *prog_data;
+   struct gl_shader_program *shader_prog;
+   struct brw_fragment_program *fp;
+   fs_visitor *v;
+};
+
+class scheduling_fs_visitor : public fs_visitor
+{
+public:
+   scheduling_fs_visitor(struct brw_compiler *compiler,
+                         struct brw_wm_prog_data *prog_data,
+                         nir_shader *shader)
+      : fs_visitor(compiler, NULL, NULL, NULL,
+                   &prog_data->base, (struct gl_program *) NULL,
+                   shader, 8, -1) {}
+};
+
+
+void scheduling_test::SetUp()
+{
+   ctx = (struct gl_context *)calloc(1, sizeof(*ctx));
+   compiler = (struct brw_compiler *)calloc(1, sizeof(*compiler));
+   devinfo = (struct brw_device_info *)calloc(1, sizeof(*devinfo));
+   compiler->devinfo = devinfo;
+
+   fp = ralloc(NULL, struct brw_fragment_program);
+   prog_data = ralloc(NULL, struct brw_wm_prog_data);
+   nir_shader *shader = nir_shader_create(NULL, MESA_SHADER_FRAGMENT, NULL);
+
+   v = new scheduling_fs_visitor(compiler, prog_data, shader);
+
+   _mesa_init_gl_program(&fp->program.Base, GL_FRAGMENT_SHADER, 0);
+
+   devinfo->gen = 8;
+}
+
+static uint32_t seed = 1;
+
+static unsigned
+next_random(unsigned n)
+{
+   seed = seed * 1103515245 + 12345;
+   return (seed >> 8) % n;
+}
+
+static double
+now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define WINDOW 16
+
+/**
+ * Emits \p num_blocks blocks of \p block_size instructions, alternating
+ * between the top level and the inside of an IF.  One in \p send_interval
+ * instructions is a send and one in \p write_interval a surface write.
+ */
+static void
+generate_shader(fs_visitor *v, int num_blocks, int block_size,
+                int send_interval, int write_interval)
+{
+   const fs_builder &bld = v->bld;
+   fs_reg window[WINDOW];
+
+   for (int i = 0; i < WINDOW; i++) {
+      window[i] = v->vgrf(glsl_type::float_type);
+      bld.MOV(window[i], brw_imm_f(i));
+   }
+
+   for (int b = 0; b < num_blocks; b++) {
+      if (b % 2 == 1) {
+         bld.CMP(bld.null_reg_f(), window[next_random(WINDOW)],
+                 brw_imm_f(0.0f), BRW_CONDITIONAL_GE);
+         bld.IF(BRW_PREDICATE_NORMAL);
+      }
+
+      for (int i = 0; i < block_size; i++) {
+         fs_reg a = window[next_random(WINDOW)];
+         fs_reg c = window[next_random(WINDOW)];
+         fs_reg dst;
+
+         if (next_random(write_interval) == 0) {
+            fs_inst *inst = bld.emit(SHADER_OPCODE_UNTYPED_SURFACE_WRITE,
+                                     bld.null_reg_ud(), a,
+                                     brw_imm_ud(0), brw_imm_ud(1));
+            inst->mlen = 1;
+            continue;
+         } else if (next_random(send_interval) == 0) {
+            fs_reg result = v->vgrf(glsl_type::vec4_type);
+            fs_inst *inst = bld.emit(SHADER_OPCODE_UNTYPED_SURFACE_READ,
+                                     result, a,
+                                     brw_imm_ud(0), brw_imm_ud(4));
+            inst->mlen = 1;
+            inst->regs_written = 4;
+            dst = offset(result, bld, next_random(4));
+         } else {
+            dst = v->vgrf(glsl_type::float_type);
+            switch (next_random(3)) {
+            case 0:
+               bld.ADD(dst, a, c);
+               break;
+            case 1:
+               bld.MUL(dst, a, c);
+               break;
+            case 2:
+               bld.MAD(dst, a, c, window[next_random(WINDOW)]);
+               break;
+            }
+         }
+
+         window[next_random(WINDOW)] = dst;
+      }
+
+      if (b % 2 == 1)
+         bld.emit(BRW_OPCODE_ENDIF);
+   }
+
+   v->calculate_cfg();
+}
+
+/**
+ * Gives each VGRF a range of hardware registers, reusing them round robin
+ * the way register allocation of a program under pressure would, and makes
+ * the program look like it was register allocated.
+ */
+static void
+fake_register_allocation(fs_visitor *v)
+{
+   const int reg_count = 128;
+   int *hw_reg = new int[v->alloc.count];
+   int next = 0;
+
+   for (unsigned i = 0; i < v->alloc.count; i++) {
+      if (next + v->alloc.sizes[i] > reg_count)
+         next = 0;
+      hw_reg[i] = next;
+      next += v->alloc.sizes[i];
+   }
+
+   foreach_block_and_inst(block, fs_inst, inst, v->cfg) {
+      if (inst->dst.file == VGRF) {
+         inst->dst.nr = hw_reg[inst->dst.nr] + inst->dst.reg_offset;
+         inst->dst.reg_offset = 0;
+      }
+
+      for (int i = 0; i < inst->sources; i++) {
+         if (inst->src[i].file == VGRF) {
+            inst->src[i].nr = hw_reg[inst->src[i].nr] +
+                              inst->src[i].reg_offset;
+            inst->src[i].reg_offset = 0;
+         }
+      }
+   }
+
+   v->grf_used = reg_count;
+   delete[] hw_reg;
+}
+
+/**
+ * What scheduling has to preserve, in terms of the positions instructions
+ * had in the program before scheduling.
+ */
+struct program_order {
+   /** For each instruction, the writer of each register it reads. */
+   std::vector<std::vector<int> > reaching_writes;
+   /** The last writer of each register. */
+   std::map<unsigned, int> last_writes;
+   /** Instructions with side effects, in program order. */
+   std::vector<int> side_effects;
+};
+
+static unsigned
+reg_key(const fs_reg &reg, bool post_reg_alloc, int r)
+{
+   if (post_reg_alloc)
+      return reg.nr + r;
+   else
+      return reg.nr * 16 + reg.reg_offset + r;
+}
+
+/**
+ * Numbers the instructions of the program in \p ip.  The scheduler adds
+ * NOPs, which have no number.
+ */
+static void
+number_instructions(fs_visitor *v, std::map<const fs_inst *, int> &ip)
+{
+   int n = 0;
+
+   ip.clear();
+   foreach_block_and_inst(block, fs_inst, inst, v->cfg) {
+      if (inst->opcode != BRW_OPCODE_NOP)
+         ip[inst] = n++;
+   }
+}
+
+/**
+ * Instructions never move between blocks, so walking the program linearly
+ * is enough to find which write each read sees.
+ */
+static void
+get_program_order(fs_visitor *v, const std::map<const fs_inst *, int> &ip,
+                  bool post_reg_alloc, program_order *order)
+{
+   order->reaching_writes.assign(ip.size(), std::vector<int>());
+   order->last_writes.clear();
+   order->side_effects.clear();
+
+   foreach_block_and_inst(block, fs_inst, inst, v->cfg) {
+      std::map<const fs_inst *, int>::const_iterator it = ip.find(inst);
+      if (it == ip.end())
+         continue;
+
+      for (int i = 0; i < inst->sources; i++) {
+         if (inst->src[i].file != VGRF)
+            continue;
+
+         for (int r = 0; r < inst->regs_read(i); r++) {
+            std::map<unsigned, int>::const_iterator w =
+               order->last_writes.find(reg_key(inst->src[i],
+                                               post_reg_alloc, r));
+            order->reaching_writes[it->second].push_back(
+               w == order->last_writes.end() ? -1 : w->second);
+         }
+      }
+
+      if (inst->dst.file == VGRF) {
+         for (int r = 0; r < inst->regs_written; r++)
+            order->last_writes[reg_key(inst->dst, post_reg_alloc, r)] =
+               it->second;
+      }
+
+      if (inst->has_side_effects())
+         order->side_effects.push_back(it->second);
+   }
+}
+
+static double
+schedule(fs_visitor *v, instruction_scheduler_mode mode)
+{
+   const bool post_reg_alloc = mode == SCHEDULE_POST;
+   std::map<const fs_inst *, int> ip;
+   program_order before, after;
+
+   number_instructions(v, ip);
+   get_program_order(v, ip, post_reg_alloc, &before);
+
+   double start = now();
+   v->schedule_instructions(mode);
+   double time = now() - start;
+
+   get_program_order(v, ip, post_reg_alloc, &after);
+
+   EXPECT_TRUE(before.reaching_writes == after.reaching_writes);
+   EXPECT_TRUE(before.last_writes == after.last_writes);
+   EXPECT_TRUE(before.side_effects == after.side_effects);
+
+   return time;
+}
+
+static void
+run(fs_visitor *v, const char *name, int num_blocks, int block_size,
+    int send_interval, int write_interval)
+{
+   generate_shader(v, num_blocks, block_size, send_interval, write_interval);
+
+   double pre = schedule(v, SCHEDULE_PRE);
+   fake_register_allocation(v);
+   double post = schedule(v, SCHEDULE_POST);
+
+   printf("%s: %d instructions, pre-RA %8.3f ms, post-RA %8.3f ms\n",
+          name, num_blocks * block_size, pre * 1000, post * 1000);
+}
+
+TEST_F(scheduling_test, large_shader)
+{
+   run(v, "large_shader", 16, 1000, 16, 256);
+}
+
+TEST_F(scheduling_test, many_side_effects)
+{
+   run(v, "many_side_effects", 4, 2000, 16, 8);
+}
@@ -0,0 +1,432 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file test_tiled_memcpy.c
+ *
+ * Checks every build of the tiled memcpy the CPU can run against a plain
+ * per-byte tiling, then measures the throughput of each on a 1920x1080
+ * RGBA frame.  Pass --no-bench to only run the checks.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "main/imports.h"
+#include "main/macros.h"
+#include "x86/common_x86_asm.h"
+#include "i915_drm.h"
+#include "intel_tiled_memcpy.h"
+
+#define MARKER 0xcd
+
+struct walker {
+   const char *name;
+   bool supported;
+
+   /* NULL for the public entry points. */
+   void (*linear_to_tiled)(uint32_t xt1, uint32_t xt2,
+                           uint32_t yt1, uint32_t yt2,
+                           char *dst, const char *src,
+                           uint32_t dst_pitch, int32_t src_pitch,
+                           bool has_swizzling,
+                           uint32_t tiling,
+                           enum intel_memcpy_type copy_type,
+                           bool streaming);
+   void (*tiled_to_linear)(uint32_t xt1, uint32_t xt2,
+                           uint32_t yt1, uint32_t yt2,
+                           char *dst, const char *src,
+                           int32_t dst_pitch, uint32_t src_pitch,
+                           bool has_swizzling,
+                           uint32_t tiling,
+                           enum intel_memcpy_type copy_type);
+};
+
+static struct walker walkers[] = {
+   { "generic", true, linear_to_tiled_generic, tiled_to_linear_generic },
+#if defined(USE_SSE41)
+   { "sse41", false, linear_to_tiled_sse41, tiled_to_linear_sse41 },
+#endif
+#if defined(USE_AVX2)
+   { "avx2", false, linear_to_tiled_avx2, tiled_to_linear_avx2 },
+#endif
+   { "dispatch", true, NULL, NULL },
+};
+
+static mem_copy_fn bgra8_upload, bgra8_download;
+
+struct image {
+   uint32_t tiling;
+   bool swizzling;
+   uint32_t width;   /* in bytes */
+   uint32_t height;
+   uint32_t tiled_pitch;
+   uint32_t tiled_size;
+   int32_t linear_pitch;
+   char *tiled;
+   char *linear;
+};
+
+/**
+ * The offset of byte (x, y) in a tiled image, computed the long way.
+ */
+static uint32_t
+tiled_offset(const struct image *img, uint32_t x, uint32_t y)
+{
+   uint32_t offset;
+
+   if (img->tiling == I915_TILING_X) {
+      offset = (y / 8) * 8 * img->tiled_pitch + (x / 512) * 4096 +
+               (y % 8) * 512 + x % 512;
+      if (img->swizzling)
+         offset ^= ((offset >> 3) ^ (offset >> 4)) & 64;
+   } else {
+      offset = (y / 32) * 32 * img->tiled_pitch + (x / 128) * 4096 +
+               (x % 128 / 16) * 512 + (y % 32) * 16 + x % 16;
+      if (img->swizzling)
+         offset ^= (offset >> 3) & 64;
+   }
+
+   return offset;
+}
+
+/**
+ * The byte of the other image's pixel that ends up at byte x.
+ */
+static uint32_t
+source_byte(bool bgra8, uint32_t x)
+{
+   static const uint32_t swap[4] = { 2, 1, 0, 3 };
+   return bgra8 ? x - x % 4 + swap[x % 4] : x;
+}
+
+static void
+create_image(struct image *img, uint32_t tiling, bool swizzling,
+             uint32_t width, uint32_t height)
+{
+   const uint32_t tw = tiling == I915_TILING_X ? 512 : 128;
+   const uint32_t th = tiling == I915_TILING_X ? 8 : 32;
+
+   img->tiling = tiling;
+   img->swizzling = swizzling;
+   img->width = width;
+   img->height = height;
+   img->tiled_pitch = ALIGN(width, tw);
+   img->tiled_size = img->tiled_pitch * ALIGN(height, th);
+   /* Not 16-byte aligned, so that the linear side is unaligned. */
+   img->linear_pitch = width + 4;
+   img->tiled = _mesa_align_malloc(img->tiled_size, 4096);
+   img->linear = _mesa_align_malloc(img->linear_pitch * height + 4, 64) + 4;
+}
+
+static void
+destroy_image(struct image *img)
+{
+   _mesa_align_free(img->tiled);
+   _mesa_align_free(img->linear - 4);
+}
+
+static void
+run_linear_to_tiled(const struct walker *w, const struct image *img,
+                    uint32_t x1, uint32_t x2, uint32_t y1, uint32_t y2,
+                    bool bgra8, bool streaming)
+{
+   if (w->linear_to_tiled) {
+      w->linear_to_tiled(x1, x2, y1, y2, img->tiled, img->linear,
+                         img->tiled_pitch, img->linear_pitch,
+                         img->swizzling, img->tiling,
+                         bgra8 ? INTEL_MEMCPY_BGRA8 : INTEL_MEMCPY,
+                         streaming);
+   } else {
+      linear_to_tiled(x1, x2, y1, y2, img->tiled, img->linear,
+                      img->tiled_pitch, img->linear_pitch,
+                      img->swizzling, img->tiling,
+                      bgra8 ? bgra8_upload : memcpy);
+   }
+}
+
+static void
+run_tiled_to_linear(const struct walker *w, const struct image *img,
+                    uint32_t x1, uint32_t x2, uint32_t y1, uint32_t y2,
+                    bool bgra8)
+{
+   if (w->tiled_to_linear) {
+      w->tiled_to_linear(x1, x2, y1, y2, img->linear, img->tiled,
+                         img->linear_pitch, img->tiled_pitch,
+                         img->swizzling, img->tiling,
+                         bgra8 ? INTEL_MEMCPY_BGRA8 : INTEL_MEMCPY);
+   } else {
+      tiled_to_linear(x1, x2, y1, y2, img->linear, img->tiled,
+                      img->linear_pitch, img->tiled_pitch,
+                      img->swizzling, img->tiling,
+                      bgra8 ? bgra8_download : memcpy);
+   }
+}
+
+static bool
+check(const struct walker *w, uint32_t tiling, bool swizzling,
+      uint32_t width, uint32_t height,
+      uint32_t x1, uint32_t x2, uint32_t y1, uint32_t y2,
+      bool bgra8, bool streaming)
+{
+   struct image img;
+   bool pass = true;
+   uint32_t x, y;
+
+   create_image(&img, tiling, swizzling, width, height);
+
+   for (y = 0; y < height; y++) {
+      for (x = 0; x < width; x++)
+         img.linear[y * img.linear_pitch + x] = x * 7 + y * 13;
+   }
+   memset(img.tiled, MARKER, img.tiled_size);
+
+   run_linear_to_tiled(w, &img, x1, x2, y1, y2, bgra8, streaming);
+
+   for (y = 0; y < height && pass; y++) {
+      for (x = 0; x < width && pass; x++) {
+         const bool inside = x >= x1 && x < x2 && y >= y1 && y < y2;
+         const uint8_t expected = inside ?
+            img.linear[y * img.linear_pitch + source_byte(bgra8, x)] : MARKER;
+         const uint8_t actual = img.tiled[tiled_offset(&img, x, y)];
+
+         if (actual != expected) {
+            fprintf(stderr, "%s linear_to_tiled: byte (%u, %u) is 0x%02x "
+                    "instead of 0x%02x\n", w->name, x, y, actual, expected);
+            pass = false;
+         }
+      }
+   }
+
+   for (y = 0; y < height; y++) {
+      for (x = 0; x < width; x++)
+         img.tiled[tiled_offset(&img, x, y)] = x * 11 + y * 3;
+   }
+   memset(img.linear, MARKER, img.linear_pitch * height);
+
+   run_tiled_to_linear(w, &img, x1, x2, y1, y2, bgra8);
+
+   for (y = 0; y < height && pass; y++) {
+      for (x = 0; x < width && pass; x++) {
+         const bool inside = x >= x1 && x < x2 && y >= y1 && y < y2;
+         const uint8_t expected = inside ?
+            img.tiled[tiled_offset(&img, source_byte(bgra8, x), y)] : MARKER;
+         const uint8_t actual = img.linear[y * img.linear_pitch + x];
+
+         if (actual != expected) {
+            fprintf(stderr, "%s tiled_to_linear: byte (%u, %u) is 0x%02x "
+                    "instead of 0x%02x\n", w->name, x, y, actual, expected);
+            pass = false;
+         }
+      }
+   }
+
+   if (!pass) {
+      fprintf(stderr, "  %s tiling, swizzling %s, %s%s, "
+              "[%u, %u) x [%u, %u) of %ux%u\n",
+              tiling == I915_TILING_X ? "X" : "Y", swizzling ? "on" : "off",
+              bgra8 ? "bgra8" : "memcpy", streaming ? ", streaming" : "",
+              x1, x2, y1, y2, width, height);
+   }
+
+   destroy_image(&img);
+   return pass;
+}
+
+static bool
+check_walker(const struct walker *w)
+{
+   static const uint32_t tilings[] = { I915_TILING_X, I915_TILING_Y };
+   bool pass = true;
+   unsigned t, swizzling, bgra8, streaming;
+
+   for (t = 0; t < ARRAY_SIZE(tilings); t++) {
+      for (swizzling = 0; swizzling < 2; swizzling++) {
+         for (bgra8 = 0; bgra8 < 2; bgra8++) {
+            for (streaming = 0; streaming < 2; streaming++) {
+               /* Whole tiles, then a rectangle with partial tiles and
+                * spans on every side.
+                */
+               pass &= check(w, tilings[t], swizzling, 2048, 64,
+                             0, 2048, 0, 64, bgra8, streaming);
+               pass &= check(w, tilings[t], swizzling, 2048, 80,
+                             52, 1900, 5, 77, bgra8, streaming);
+            }
+         }
+
+         /* Big enough for the threads and the non-temporal stores. */
+         pass &= check(w, tilings[t], swizzling, 4096, 1024,
+                       0, 4096, 0, 1024, true, true);
+      }
+   }
+
+   return pass;
+}
+
+static double
+now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench_walker(const struct walker *w)
+{
+   static const uint32_t tilings[] = { I915_TILING_X, I915_TILING_Y };
+   const uint32_t width = 1920 * 4, height = 1080;
+   unsigned t, bgra8, mode;
+
+   for (t = 0; t < ARRAY_SIZE(tilings); t++) {
+      struct image img;
+
+      create_image(&img, tilings[t], false, width, height);
+      memset(img.linear, 1, img.linear_pitch * height);
+      memset(img.tiled, 2, img.tiled_size);
+
+      for (bgra8 = 0; bgra8 < 2; bgra8++) {
+         /* Uploads without and with non-temporal stores, then downloads. */
+         for (mode = 0; mode < 3; mode++) {
+            double start = now(), elapsed;
+            unsigned iterations = 0;
+
+            if (mode == 1 && !w->linear_to_tiled)
+               continue;
+
+            do {
+               if (mode < 2) {
+                  run_linear_to_tiled(w, &img, 0, width, 0, height,
+                                      bgra8, mode == 1);
+               } else {
+                  run_tiled_to_linear(w, &img, 0, width, 0, height, bgra8);
+               }
+               iterations++;
+               elapsed = now() - start;
+            } while (elapsed < 0.05);
+
+            printf("%-8s %s-tiled %-6s %-24s %8.1f MB/s\n", w->name,
+                   tilings[t] == I915_TILING_X ? "X" : "Y",
+                   bgra8 ? "bgra8" : "memcpy",
+                   mode == 0 ? "linear_to_tiled" :
+                   mode == 1 ? "linear_to_tiled (stream)" : "tiled_to_linear",
+                   (double) width * height * iterations / elapsed / 1e6);
+         }
+      }
+
+      destroy_image(&img);
+   }
+}
+
+/**
+ * Checks which copy function intel_get_memcpy() picks for formats other than
+ * the 8-bit RGBA ones.
+ */
+static bool
+check_formats(void)
+{
+   static const struct {
+      mesa_format tiled_format;
+      GLenum format, type;
+      enum intel_memcpy_direction direction;
+      uint32_t cpp; /* 0 if the combination must be rejected */
+   } cases[] = {
+      { MESA_FORMAT_RGBA_FLOAT16, GL_RGBA, GL_HALF_FLOAT, INTEL_UPLOAD, 8 },
+      { MESA_FORMAT_RGBA_FLOAT32, GL_RGBA, GL_FLOAT, INTEL_UPLOAD, 16 },
+      { MESA_FORMAT_R_FLOAT32, GL_RED, GL_FLOAT, INTEL_UPLOAD, 4 },
+      { MESA_FORMAT_B5G6R5_UNORM, GL_RGB, GL_UNSIGNED_SHORT_5_6_5,
+        INTEL_UPLOAD, 2 },
+      { MESA_FORMAT_RGBA_FLOAT16, GL_RGBA, GL_FLOAT, INTEL_UPLOAD, 0 },
+      { MESA_FORMAT_RGBA_FLOAT16, GL_RGBA, GL_HALF_FLOAT, INTEL_DOWNLOAD, 0 },
+      { MESA_FORMAT_BGR_UNORM8, GL_BGR, GL_UNSIGNED_BYTE, INTEL_UPLOAD, 0 },
+   };
+   bool pass = true;
+   unsigned i;
+
+   for (i = 0; i < ARRAY_SIZE(cases); i++) {
+      mem_copy_fn mem_copy = NULL;
+      uint32_t cpp = 0;
+      bool ok = intel_get_memcpy(cases[i].tiled_format, cases[i].format,
+                                 cases[i].type, &mem_copy, &cpp,
+                                 cases[i].direction);
+
+      if (cases[i].cpp ? !ok || mem_copy != memcpy || cpp != cases[i].cpp
+                       : ok) {
+         printf("intel_get_memcpy: wrong result for %s, %s, %s\n",
+                _mesa_get_format_name(cases[i].tiled_format),
+                cases[i].direction == INTEL_UPLOAD ? "upload" : "download",
+                cases[i].cpp ? "expected memcpy" : "expected no copy");
+         pass = false;
+      }
+   }
+
+   return pass;
+}
+
+int
+main(int argc, char **argv)
+{
+   bool bench = !(argc > 1 && strcmp(argv[1], "--no-bench") == 0);
+   bool pass = true;
+   unsigned i;
+   uint32_t cpp;
+
+   _mesa_get_x86_features();
+
+   for (i = 0; i < ARRAY_SIZE(walkers); i++) {
+#if defined(USE_SSE41)
+      if (walkers[i].linear_to_tiled == linear_to_tiled_sse41)
+         walkers[i].supported = cpu_has_sse4_1;
+#endif
+#if defined(USE_AVX2)
+      if (walkers[i].linear_to_tiled == linear_to_tiled_avx2)
+         walkers[i].supported = cpu_has_avx2;
+#endif
+   }
+
+   intel_get_memcpy(MESA_FORMAT_B8G8R8A8_UNORM, GL_RGBA, GL_UNSIGNED_BYTE,
+                    &bgra8_upload, &cpp, INTEL_UPLOAD);
+   intel_get_memcpy(MESA_FORMAT_B8G8R8A8_UNORM, GL_RGBA, GL_UNSIGNED_BYTE,
+                    &bgra8_download, &cpp, INTEL_DOWNLOAD);
+
+   for (i = 0; i < ARRAY_SIZE(walkers); i++) {
+      if (!walkers[i].supported) {
+         printf("%s: not supported by this CPU, skipped\n", walkers[i].name);
+         continue;
+      }
+
+      pass &= check_walker(&walkers[i]);
+   }
+
+   pass &= check_formats();
+
+   if (bench && pass) {
+      for (i = 0; i < ARRAY_SIZE(walkers); i++) {
+         if (walkers[i].supported)
+            bench_walker(&walkers[i]);
+      }
+   }
+
+   return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1229,6 +1229,10 @@ static struct name_function functions[] = {
    { "OSMesaGetProcAddress", (OSMESAproc) OSMesaGetProcAddress },
    { "OSMesaColorClamp", (OSMESAproc) OSMesaColorClamp },
    { "OSMesaPostprocess", (OSMESAproc) OSMesaPostprocess },
+   { "OSMesaCreateContextPool", (OSMESAproc) OSMesaCreateContextPool },
+   { "OSMesaDestroyContextPool", (OSMESAproc) OSMesaDestroyContextPool },
+   { "OSMesaAcquireContext", (OSMESAproc) OSMesaAcquireContext },
+   { "OSMesaReleaseContext", (OSMESAproc) OSMesaReleaseContext },
    { NULL, NULL }
 };
 
@@ -1268,6 +1272,35 @@ OSMesaPostprocess(OSMesaContext osmesa, const char *filter,
 }
 
 
+GLAPI OSMesaContextPool GLAPIENTRY
+OSMesaCreateContextPool(const int *attribList, OSMesaContext sharelist,
+                        GLint numContexts)
+{
+   fprintf(stderr,
+           "OSMesaCreateContextPool() is only available with gallium drivers\n");
+   return NULL;
+}
+
+
+GLAPI void GLAPIENTRY
+OSMesaDestroyContextPool(OSMesaContextPool pool)
+{
+}
+
+
+GLAPI OSMesaContext GLAPIENTRY
+OSMesaAcquireContext(OSMesaContextPool pool)
+{
+   return NULL;
+}
+
+
+GLAPI void GLAPIENTRY
+OSMesaReleaseContext(OSMesaContext osmesa)
+{
+}
+
+
 
 /**
  * When GLX_INDIRECT_RENDERING is defined, some symbols are missing in
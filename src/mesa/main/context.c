@@ -98,6 +98,7 @@
 #include "fog.h"
 #include "formats.h"
 #include "framebuffer.h"
+#include "glthread.h"
 #include "hint.h"
 #include "hash.h"
 #include "light.h"
@@ -124,6 +125,7 @@
 #include "state.h"
 #include "stencil.h"
 #include "texcompress_s3tc.h"
+#include "teximage.h"
 #include "texstate.h"
 #include "transformfeedback.h"
 #include "mtypes.h"
@@ -987,8 +989,8 @@ _mesa_new_nop_table(unsigned numEntries)
  * populated with pointers to "no-op" functions.  In turn, the no-op
  * functions will call nop_handler() above.
  */
-static struct _glapi_table *
-alloc_dispatch_table(void)
+struct _glapi_table *
+_mesa_alloc_dispatch_table(void)
 {
    /* Find the larger of Mesa's dispatch table and libGL's dispatch table.
     * In practice, this'll be the same for stand-alone Mesa.  But for DRI
@@ -1060,7 +1062,7 @@ create_beginend_table(const struct gl_context *ctx)
 {
    struct _glapi_table *table;
 
-   table = alloc_dispatch_table();
+   table = _mesa_alloc_dispatch_table();
    if (!table)
       return NULL;
 
@@ -1103,12 +1105,38 @@ create_beginend_table(const struct gl_context *ctx)
    return table;
 }
 
+/**
+ * For KHR_no_error contexts, replace the entrypoints which are both
+ * frequently called and expensive to validate with variants that skip the
+ * error checking.  The drawing functions are handled by the VBO module.
+ * Only the functions that are exposed in this API are replaced.
+ */
+static void
+initialize_no_error_exec_table(struct _glapi_table *exec)
+{
+   if (GET_BufferSubData(exec) == _mesa_BufferSubData)
+      SET_BufferSubData(exec, _mesa_BufferSubData_no_error);
+   if (GET_NamedBufferSubData(exec) == _mesa_NamedBufferSubData)
+      SET_NamedBufferSubData(exec, _mesa_NamedBufferSubData_no_error);
+   if (GET_VertexAttribPointer(exec) == _mesa_VertexAttribPointer)
+      SET_VertexAttribPointer(exec, _mesa_VertexAttribPointer_no_error);
+   if (GET_TexSubImage1D(exec) == _mesa_TexSubImage1D)
+      SET_TexSubImage1D(exec, _mesa_TexSubImage1D_no_error);
+   if (GET_TexSubImage2D(exec) == _mesa_TexSubImage2D)
+      SET_TexSubImage2D(exec, _mesa_TexSubImage2D_no_error);
+   if (GET_TexSubImage3D(exec) == _mesa_TexSubImage3D)
+      SET_TexSubImage3D(exec, _mesa_TexSubImage3D_no_error);
+}
+
 void
 _mesa_initialize_dispatch_tables(struct gl_context *ctx)
 {
    /* Do the code-generated setup of the exec table in api_exec.c. */
    _mesa_initialize_exec_table(ctx);
 
+   if (_mesa_is_no_error_enabled(ctx))
+      initialize_no_error_exec_table(ctx->Exec);
+
    if (ctx->Save)
       _mesa_initialize_save_table(ctx);
 }
@@ -1197,7 +1225,7 @@ _mesa_initialize_context(struct gl_context *ctx,
       goto fail;
 
    /* setup the API dispatch tables with all nop functions */
-   ctx->OutsideBeginEnd = alloc_dispatch_table();
+   ctx->OutsideBeginEnd = _mesa_alloc_dispatch_table();
    if (!ctx->OutsideBeginEnd)
       goto fail;
    ctx->Exec = ctx->OutsideBeginEnd;
@@ -1224,7 +1252,7 @@ _mesa_initialize_context(struct gl_context *ctx,
    switch (ctx->API) {
    case API_OPENGL_COMPAT:
       ctx->BeginEnd = create_beginend_table(ctx);
-      ctx->Save = alloc_dispatch_table();
+      ctx->Save = _mesa_alloc_dispatch_table();
       if (!ctx->BeginEnd || !ctx->Save)
          goto fail;
 
@@ -1313,6 +1341,9 @@ _mesa_create_context(gl_api api,
 void
 _mesa_free_context_data( struct gl_context *ctx )
 {
+   /* Stop the worker thread first; it may still be executing commands. */
+   _mesa_glthread_destroy(ctx);
+
    if (!_mesa_get_current_context()){
       /* No current context, but we may need one in order to delete
        * texture objs, etc.  So temporarily bind the context now.
@@ -1607,7 +1638,7 @@ handle_first_current(struct gl_context *ctx)
       return;
    }
 
-   ctx->Extensions.String = _mesa_make_extension_string(ctx);
+   _mesa_override_extensions(ctx);
 
    check_context_limits(ctx);
 
@@ -1690,6 +1721,12 @@ _mesa_make_current( struct gl_context *newCtx,
       }
    }
 
+   /* Anything marshalled to the old context's worker thread has to be
+    * executed before the context can be unbound from this thread.
+    */
+   if (curCtx && curCtx != newCtx)
+      _mesa_glthread_finish(curCtx);
+
    if (curCtx && 
        (curCtx->WinSysDrawBuffer || curCtx->WinSysReadBuffer) &&
        /* make sure this context is valid for flushing */
@@ -1706,7 +1743,8 @@ _mesa_make_current( struct gl_context *newCtx,
       _glapi_set_dispatch(NULL);  /* none current */
    }
    else {
-      _glapi_set_dispatch(newCtx->CurrentDispatch);
+      _glapi_set_dispatch(newCtx->GLThread ? newCtx->MarshalExec
+                                           : newCtx->CurrentDispatch);
 
       if (drawBuffer && readBuffer) {
          assert(_mesa_is_winsys_fbo(drawBuffer));
@@ -1815,6 +1853,23 @@ _mesa_get_dispatch(struct gl_context *ctx)
    return ctx->CurrentDispatch;
 }
 
+/**
+ * Make ctx->CurrentDispatch the dispatch table of the calling thread.
+ *
+ * This is used after switching between the immediate-mode, begin/end and
+ * display list compile tables.  While glthread is active the application
+ * thread has to keep the marshalling table installed, so only the worker
+ * thread follows the switch.
+ */
+void
+_mesa_install_current_dispatch(struct gl_context *ctx)
+{
+   if (ctx->GLThread && !_mesa_glthread_is_worker_thread(ctx))
+      return;
+
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+}
+
 /*@}*/
 
 
@@ -158,6 +158,12 @@ _mesa_notifySwapBuffers(struct gl_context *gc);
 extern struct _glapi_table *
 _mesa_get_dispatch(struct gl_context *ctx);
 
+extern struct _glapi_table *
+_mesa_alloc_dispatch_table(void);
+
+extern void
+_mesa_install_current_dispatch(struct gl_context *ctx);
+
 
 extern GLboolean
 _mesa_valid_to_render(struct gl_context *ctx, const char *where);
@@ -324,6 +330,18 @@ _mesa_is_gles31(const struct gl_context *ctx)
 }
 
 
+/**
+ * Checks if the context was created with KHR_no_error, in which case the
+ * application promises not to generate any GL errors and the error checking
+ * may be skipped.
+ */
+static inline bool
+_mesa_is_no_error_enabled(const struct gl_context *ctx)
+{
+   return ctx->Const.ContextFlags & GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR;
+}
+
+
 /**
  * Checks if the context supports geometry shaders.
  */
@@ -650,6 +650,15 @@ struct dd_function_table {
    GLboolean (*UnmapBuffer)( struct gl_context *ctx,
 			     struct gl_buffer_object *obj,
                              gl_map_buffer_index index);
+
+   /**
+    * Commit or decommit the pages of a sparse buffer that intersect
+    * [offset, offset + size).  For GL_ARB_sparse_buffer.
+    */
+   void (*BufferPageCommitment)(struct gl_context *ctx,
+                                struct gl_buffer_object *obj,
+                                GLintptr offset, GLsizeiptr size,
+                                GLboolean commit);
    /*@}*/
 
    /**
@@ -721,6 +730,18 @@ struct dd_function_table {
    void (*EndQuery)(struct gl_context *ctx, struct gl_query_object *q);
    void (*CheckQuery)(struct gl_context *ctx, struct gl_query_object *q);
    void (*WaitQuery)(struct gl_context *ctx, struct gl_query_object *q);
+   /**
+    * Store the value of a query into a buffer object without waiting for
+    * it on the CPU (GL_ARB_query_buffer_object).
+    *
+    * \param pname  GL_QUERY_RESULT, GL_QUERY_RESULT_NO_WAIT,
+    *               GL_QUERY_RESULT_AVAILABLE or GL_QUERY_TARGET
+    * \param ptype  GL_INT, GL_UNSIGNED_INT, GL_INT64_ARB or
+    *               GL_UNSIGNED_INT64_ARB
+    */
+   void (*StoreQueryResult)(struct gl_context *ctx, struct gl_query_object *q,
+                            struct gl_buffer_object *buf, intptr_t offset,
+                            GLenum pname, GLenum ptype);
    /*@}*/
 
    /**
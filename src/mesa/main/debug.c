@@ -27,6 +27,7 @@
 #include "mtypes.h"
 #include "attrib.h"
 #include "enums.h"
+#include "extensions.h"
 #include "formats.h"
 #include "hash.h"
 #include "imports.h"
@@ -116,7 +117,8 @@ void _mesa_print_info( struct gl_context *ctx )
    /* use ctx as GL_EXTENSIONS will not work on 3.0 or higher
     * core contexts.
     */
-   _mesa_debug(NULL, "Mesa GL_EXTENSIONS = %s\n", ctx->Extensions.String);
+   _mesa_debug(NULL, "Mesa GL_EXTENSIONS = %s\n",
+               (char *) _mesa_get_extension_string(ctx));
 
 #if defined(USE_X86_ASM)
    _mesa_debug(NULL, "Mesa x86-optimized: YES\n");
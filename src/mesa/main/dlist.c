@@ -1537,11 +1537,91 @@ invalidate_saved_current_state(struct gl_context *ctx)
       ctx->ListState.ActiveMaterialSize[i] = 0;
 
    memset(&ctx->ListState.Current, 0, sizeof ctx->ListState.Current);
+   ctx->ListState.LastMatrixBlock = NULL;
 
    ctx->Driver.CurrentSavePrimitive = PRIM_UNKNOWN;
 }
 
 
+/**
+ * Applies the matrix operation compiled at \p n to \p m.
+ * \return whether the operation replaces the matrix rather than
+ *         multiplying it
+ */
+static bool
+apply_matrix_op(const Node *n, GLmatrix *m)
+{
+   switch (n[0].opcode) {
+   case OPCODE_LOAD_IDENTITY:
+      _math_matrix_set_identity(m);
+      return true;
+   case OPCODE_LOAD_MATRIX:
+      _math_matrix_loadf(m, &n[1].f);
+      return true;
+   case OPCODE_MULT_MATRIX:
+      _math_matrix_mul_floats(m, &n[1].f);
+      return false;
+   case OPCODE_ROTATE:
+      _math_matrix_rotate(m, n[1].f, n[2].f, n[3].f, n[4].f);
+      return false;
+   case OPCODE_SCALE:
+      _math_matrix_scale(m, n[1].f, n[2].f, n[3].f);
+      return false;
+   case OPCODE_TRANSLATE:
+      _math_matrix_translate(m, n[1].f, n[2].f, n[3].f);
+      return false;
+   default:
+      unreachable("not a matrix operation");
+   }
+}
+
+
+/**
+ * Called after compiling a matrix operation at \p n.  If it directly
+ * follows another one, both are replaced by a single glLoadMatrix or
+ * glMultMatrix of the combined matrix, so that transform sequences like
+ * glLoadIdentity, glTranslate, glRotate, glScale cost one call on replay.
+ * Nothing else can affect the current matrix between two adjacent nodes,
+ * and glMatrixMode calls compile to nodes of their own.
+ */
+static void
+compile_matrix_op(struct gl_context *ctx, Node *n)
+{
+   struct gl_dlist_state *list = &ctx->ListState;
+
+   if (list->LastMatrixBlock == list->CurrentBlock &&
+       list->LastMatrixEnd == n - list->CurrentBlock) {
+      GLmatrix m;
+      bool load;
+      GLuint i;
+
+      _math_matrix_ctr(&m);
+      load = apply_matrix_op(list->CurrentBlock + list->LastMatrixPos, &m);
+      if (apply_matrix_op(n, &m))
+         load = true;
+
+      /* Both nodes are at the end of the current block: drop them. */
+      list->CurrentPos = list->LastMatrixPos;
+      n = alloc_instruction(ctx, load ? OPCODE_LOAD_MATRIX :
+                                        OPCODE_MULT_MATRIX, 16);
+      if (n) {
+         for (i = 0; i < 16; i++)
+            n[1 + i].f = m.m[i];
+      }
+      _math_matrix_dtr(&m);
+
+      if (!n) {
+         list->LastMatrixBlock = NULL;
+         return;
+      }
+   }
+
+   list->LastMatrixBlock = list->CurrentBlock;
+   list->LastMatrixPos = n - list->CurrentBlock;
+   list->LastMatrixEnd = list->CurrentPos;
+}
+
+
 static void GLAPIENTRY
 save_CallList(GLuint list)
 {
@@ -2648,8 +2728,12 @@ static void GLAPIENTRY
 save_LoadIdentity(void)
 {
    GET_CURRENT_CONTEXT(ctx);
+   Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
-   (void) alloc_instruction(ctx, OPCODE_LOAD_IDENTITY, 0);
+   n = alloc_instruction(ctx, OPCODE_LOAD_IDENTITY, 0);
+   if (n) {
+      compile_matrix_op(ctx, n);
+   }
    if (ctx->ExecuteFlag) {
       CALL_LoadIdentity(ctx->Exec, ());
    }
@@ -2668,6 +2752,7 @@ save_LoadMatrixf(const GLfloat * m)
       for (i = 0; i < 16; i++) {
          n[1 + i].f = m[i];
       }
+      compile_matrix_op(ctx, n);
    }
    if (ctx->ExecuteFlag) {
       CALL_LoadMatrixf(ctx->Exec, (m));
@@ -2891,14 +2976,24 @@ save_MatrixMode(GLenum mode)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
-   ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   ASSERT_OUTSIDE_SAVE_BEGIN_END(ctx);
+
+   if (ctx->ExecuteFlag) {
+      CALL_MatrixMode(ctx->Exec, (mode));
+   }
+
+   /* Don't compile this call if it's a no-op. */
+   if (ctx->ListState.Current.MatrixMode == mode)
+      return;
+
+   SAVE_FLUSH_VERTICES(ctx);
+
+   ctx->ListState.Current.MatrixMode = mode;
+
    n = alloc_instruction(ctx, OPCODE_MATRIX_MODE, 1);
    if (n) {
       n[1].e = mode;
    }
-   if (ctx->ExecuteFlag) {
-      CALL_MatrixMode(ctx->Exec, (mode));
-   }
 }
 
 
@@ -2914,6 +3009,7 @@ save_MultMatrixf(const GLfloat * m)
       for (i = 0; i < 16; i++) {
          n[1 + i].f = m[i];
       }
+      compile_matrix_op(ctx, n);
    }
    if (ctx->ExecuteFlag) {
       CALL_MultMatrixf(ctx->Exec, (m));
@@ -3212,6 +3308,10 @@ save_PopAttrib(void)
    GET_CURRENT_CONTEXT(ctx);
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
    (void) alloc_instruction(ctx, OPCODE_POP_ATTRIB, 0);
+
+   /* The restored state may differ from what we cached. */
+   invalidate_saved_current_state( ctx );
+
    if (ctx->ExecuteFlag) {
       CALL_PopAttrib(ctx->Exec, ());
    }
@@ -3511,6 +3611,7 @@ save_Rotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z)
       n[2].f = x;
       n[3].f = y;
       n[4].f = z;
+      compile_matrix_op(ctx, n);
    }
    if (ctx->ExecuteFlag) {
       CALL_Rotatef(ctx->Exec, (angle, x, y, z));
@@ -3536,6 +3637,7 @@ save_Scalef(GLfloat x, GLfloat y, GLfloat z)
       n[1].f = x;
       n[2].f = y;
       n[3].f = z;
+      compile_matrix_op(ctx, n);
    }
    if (ctx->ExecuteFlag) {
       CALL_Scalef(ctx->Exec, (x, y, z));
@@ -4148,6 +4250,7 @@ save_Translatef(GLfloat x, GLfloat y, GLfloat z)
       n[1].f = x;
       n[2].f = y;
       n[3].f = z;
+      compile_matrix_op(ctx, n);
    }
    if (ctx->ExecuteFlag) {
       CALL_Translatef(ctx->Exec, (x, y, z));
@@ -7685,7 +7788,7 @@ execute_list(struct gl_context *ctx, GLuint list)
    Node *n;
    GLboolean done;
 
-   if (list == 0 || !islist(ctx, list))
+   if (list == 0)
       return;
 
    if (ctx->ListState.CallDepth == MAX_LIST_NESTING) {
@@ -8978,7 +9081,7 @@ _mesa_NewList(GLuint name, GLenum mode)
    vbo_save_NewList(ctx, name, mode);
 
    ctx->CurrentDispatch = ctx->Save;
-   _glapi_set_dispatch(ctx->CurrentDispatch);
+   _mesa_install_current_dispatch(ctx);
 }
 
 
@@ -9034,7 +9137,7 @@ _mesa_EndList(void)
    ctx->CompileFlag = GL_FALSE;
 
    ctx->CurrentDispatch = ctx->Exec;
-   _glapi_set_dispatch(ctx->CurrentDispatch);
+   _mesa_install_current_dispatch(ctx);
 }
 
 
@@ -9070,7 +9173,7 @@ _mesa_CallList(GLuint list)
    /* also restore API function pointers to point to "save" versions */
    if (save_compile_flag) {
       ctx->CurrentDispatch = ctx->Save;
-      _glapi_set_dispatch(ctx->CurrentDispatch);
+      _mesa_install_current_dispatch(ctx);
    }
 }
 
@@ -9122,7 +9225,7 @@ _mesa_CallLists(GLsizei n, GLenum type, const GLvoid * lists)
    /* also restore API function pointers to point to "save" versions */
    if (save_compile_flag) {
       ctx->CurrentDispatch = ctx->Save;
-      _glapi_set_dispatch(ctx->CurrentDispatch);
+      _mesa_install_current_dispatch(ctx);
    }
 }
 
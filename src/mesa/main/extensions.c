@@ -504,6 +504,29 @@ _mesa_make_extension_string(struct gl_context *ctx)
    return (GLubyte *) exts;
 }
 
+/**
+ * Apply MESA_EXTENSION_OVERRIDE to the context.  Called when the context is
+ * first made current; the extension string itself is only built when it is
+ * first queried.
+ */
+void
+_mesa_override_extensions(struct gl_context *ctx)
+{
+   override_extensions_in_context(ctx);
+}
+
+/**
+ * Return the GL_EXTENSIONS string, building it on first use.
+ */
+const GLubyte *
+_mesa_get_extension_string(struct gl_context *ctx)
+{
+   if (ctx->Extensions.String == NULL)
+      ctx->Extensions.String = _mesa_make_extension_string(ctx);
+
+   return ctx->Extensions.String;
+}
+
 /**
  * Return number of enabled extensions.
  */
@@ -451,6 +451,7 @@ _mesa_update_texture_renderbuffer(struct gl_context *ctx,
    rb->Depth = texImage->Depth2;
    rb->NumSamples = texImage->NumSamples;
    rb->TexImage = texImage;
+   att->Generation = texImage->Generation;
 
    if (driver_RenderTexture_is_safe(att))
       ctx->Driver.RenderTexture(ctx, fb, att);
@@ -920,6 +921,58 @@ test_attachment_completeness(const struct gl_context *ctx, GLenum format,
 }
 
 
+/**
+ * Has the image attached at \p att been respecified since the framebuffer
+ * completeness was last tested?
+ */
+static bool
+attachment_changed(const struct gl_renderbuffer_attachment *att)
+{
+   if (att->Type == GL_TEXTURE) {
+      const struct gl_texture_image *texImage =
+         att->Texture->Image[att->CubeMapFace][att->TextureLevel];
+
+      return !att->Renderbuffer ||
+             att->Renderbuffer->TexImage != texImage ||
+             (texImage && texImage->Generation != att->Generation);
+   }
+   else if (att->Type == GL_RENDERBUFFER) {
+      return att->Renderbuffer->Generation != att->Generation;
+   }
+
+   return false;
+}
+
+
+/**
+ * Test the completeness of a user framebuffer object, unless it was found
+ * complete before and none of the images attached to it has changed since.
+ *
+ * Respecifying a texture image or reallocating a renderbuffer only bumps
+ * its generation (see _mesa_update_fbo_texture()), so the framebuffers
+ * using it are revalidated here, the next time they're used.
+ */
+void
+_mesa_update_framebuffer_completeness(struct gl_context *ctx,
+                                      struct gl_framebuffer *fb)
+{
+   GLuint i;
+
+   assert(_mesa_is_user_fbo(fb));
+
+   if (fb->_Status == GL_FRAMEBUFFER_COMPLETE_EXT) {
+      for (i = 0; i < BUFFER_COUNT; i++) {
+         if (attachment_changed(&fb->Attachment[i]))
+            break;
+      }
+      if (i == BUFFER_COUNT)
+         return;
+   }
+
+   _mesa_test_framebuffer_completeness(ctx, fb);
+}
+
+
 /**
  * Test if the given framebuffer object is complete and update its
  * Status field with the results.
@@ -952,6 +1005,19 @@ _mesa_test_framebuffer_completeness(struct gl_context *ctx,
    /* we're changing framebuffer fields here */
    FLUSH_VERTICES(ctx, _NEW_BUFFERS);
 
+   /* Catch up with the images respecified since the last test */
+   for (i = 0; i < BUFFER_COUNT; i++) {
+      struct gl_renderbuffer_attachment *att = &fb->Attachment[i];
+
+      if (!attachment_changed(att))
+         continue;
+
+      if (att->Type == GL_TEXTURE)
+         _mesa_update_texture_renderbuffer(ctx, fb, att);
+      else
+         att->Generation = att->Renderbuffer->Generation;
+   }
+
    numImages = 0;
    fb->Width = 0;
    fb->Height = 0;
@@ -1978,31 +2044,6 @@ _mesa_base_fbo_format(struct gl_context *ctx, GLenum internalFormat)
 }
 
 
-/**
- * Invalidate a renderbuffer attachment.  Called from _mesa_HashWalk().
- */
-static void
-invalidate_rb(GLuint key, void *data, void *userData)
-{
-   struct gl_framebuffer *fb = (struct gl_framebuffer *) data;
-   struct gl_renderbuffer *rb = (struct gl_renderbuffer *) userData;
-
-   /* If this is a user-created FBO */
-   if (_mesa_is_user_fbo(fb)) {
-      GLuint i;
-      for (i = 0; i < BUFFER_COUNT; i++) {
-         struct gl_renderbuffer_attachment *att = fb->Attachment + i;
-         if (att->Type == GL_RENDERBUFFER &&
-             att->Renderbuffer == rb) {
-            /* Mark fb status as indeterminate to force re-validation */
-            fb->_Status = 0;
-            return;
-         }
-      }
-   }
-}
-
-
 /** sentinal value, see below */
 #define NO_SAMPLES 1000
 
@@ -2100,10 +2141,10 @@ renderbuffer_storage(struct gl_context *ctx, struct gl_renderbuffer *rb,
       rb->NumSamples = 0;
    }
 
-   /* Invalidate the framebuffers the renderbuffer is attached in. */
-   if (rb->AttachedAnytime) {
-      _mesa_HashWalk(ctx->Shared->FrameBuffers, invalidate_rb, rb);
-   }
+   /* The framebuffers the renderbuffer is attached in notice the new
+    * generation and get revalidated when they're next used.
+    */
+   rb->Generation++;
 }
 
 /**
@@ -2704,9 +2745,7 @@ _mesa_check_framebuffer_status(struct gl_context *ctx,
 
    /* No need to flush here */
 
-   if (buffer->_Status != GL_FRAMEBUFFER_COMPLETE) {
-      _mesa_test_framebuffer_completeness(ctx, buffer);
-   }
+   _mesa_update_framebuffer_completeness(ctx, buffer);
 
    return buffer->_Status;
 }
@@ -104,6 +104,10 @@ extern void
 _mesa_test_framebuffer_completeness(struct gl_context *ctx,
                                     struct gl_framebuffer *fb);
 
+extern void
+_mesa_update_framebuffer_completeness(struct gl_context *ctx,
+                                      struct gl_framebuffer *fb);
+
 extern GLboolean
 _mesa_is_legal_color_format(const struct gl_context *ctx, GLenum baseFormat);
 
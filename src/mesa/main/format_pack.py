@@ -414,10 +414,14 @@ _mesa_pack_float_rgba_row(mesa_format format, GLuint n,
    %endif
 
    case ${f.name}:
+   %if f.name == 'MESA_FORMAT_RGBA_FLOAT16':
+      _mesa_float_to_half_array((uint16_t *) d, &src[0][0], 4 * n);
+   %else:
       for (i = 0; i < n; ++i) {
          pack_float_${f.short_name()}(src[i], d);
          d += ${f.block_size() / 8};
       }
+   %endif
       break;
 %endfor
    default:
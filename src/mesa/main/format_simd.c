@@ -0,0 +1,522 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file format_simd.c
+ *
+ * SIMD kernels for the swizzle-and-convert operations that texture uploads
+ * and glReadPixels hit the most:
+ *
+ *  - swizzles between 4-channel 8-bit formats (RGBA8 <-> BGRA8 etc.)
+ *  - UNORM8 <-> float
+ *  - half-float <-> float
+ *  - 16-bit depth <-> float
+ *
+ * All of them give the same results as the generic code in format_utils.c,
+ * bit for bit.  Swizzles other than the identity need SSSE3's pshufb, so
+ * they are only done by the SSE4.1 and AVX2 builds (see
+ * format_simd_sse41.c and format_simd_avx2.c).
+ */
+
+#include "format_simd.h"
+#include "format_utils.h"
+
+#if defined(FORMAT_SIMD_AVX2)
+#define FUNC(name) name##_avx2
+#elif defined(FORMAT_SIMD_SSE41)
+#define FUNC(name) name##_sse41
+#else
+#define FUNC(name) name##_sse2
+#endif
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+static inline __m128i
+select_si128(__m128i mask, __m128i a, __m128i b)
+{
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/* Packs 8 values in [0, 0xffff] held in two vectors of 32-bit integers into
+ * 16 bits.  SSE2 only has a signed saturating pack, so sign-extend the low
+ * halves first.
+ */
+static inline __m128i
+pack_u32_to_u16(__m128i lo, __m128i hi)
+{
+   lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+   hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+   return _mm_packs_epi32(lo, hi);
+}
+
+/**
+ * A swizzle of 4-channel 8-bit pixels, as a pshufb control and a mask to OR
+ * in the channels that are MESA_FORMAT_SWIZZLE_ONE.
+ */
+struct rgba8_swizzle {
+   __m128i shuffle;
+   __m128i ones;
+   uint8_t swizzle[4];
+   uint8_t one;
+};
+
+static bool
+is_identity_swizzle(const uint8_t swizzle[4], int num_channels)
+{
+   int i;
+
+   for (i = 0; i < num_channels; ++i)
+      if (swizzle[i] != i)
+         return false;
+
+   return true;
+}
+
+#ifdef __SSSE3__
+static bool
+init_rgba8_swizzle(struct rgba8_swizzle *swz, const uint8_t swizzle[4],
+                   uint8_t one)
+{
+   uint8_t shuffle[16], ones[16];
+   int p, c;
+
+   for (c = 0; c < 4; ++c)
+      if (swizzle[c] > MESA_FORMAT_SWIZZLE_ONE)
+         return false;
+
+   for (p = 0; p < 4; ++p) {
+      for (c = 0; c < 4; ++c) {
+         const uint8_t s = swizzle[c];
+
+         shuffle[p * 4 + c] = s < 4 ? p * 4 + s : 0x80;
+         ones[p * 4 + c] = s == MESA_FORMAT_SWIZZLE_ONE ? one : 0;
+      }
+   }
+
+   swz->shuffle = _mm_loadu_si128((const __m128i *) shuffle);
+   swz->ones = _mm_loadu_si128((const __m128i *) ones);
+   memcpy(swz->swizzle, swizzle, 4);
+   swz->one = one;
+   return true;
+}
+#endif
+
+/* Applies the swizzle, if any, to four pixels. */
+static inline __m128i
+rgba8_swizzle_16(__m128i v, const struct rgba8_swizzle *swz)
+{
+#ifdef __SSSE3__
+   if (swz)
+      v = _mm_or_si128(_mm_shuffle_epi8(v, swz->shuffle), swz->ones);
+#else
+   assert(!swz);
+#endif
+   return v;
+}
+
+/* Applies the swizzle to a single pixel.  dst may be src. */
+static inline void
+rgba8_swizzle_pixel(uint8_t *dst, const uint8_t *src,
+                    const struct rgba8_swizzle *swz)
+{
+   const uint8_t tmp[6] = { src[0], src[1], src[2], src[3], 0, swz->one };
+
+   dst[0] = tmp[swz->swizzle[0]];
+   dst[1] = tmp[swz->swizzle[1]];
+   dst[2] = tmp[swz->swizzle[2]];
+   dst[3] = tmp[swz->swizzle[3]];
+}
+
+#ifdef __SSSE3__
+static void
+swizzle_rgba8(uint8_t *dst, const uint8_t *src, int count,
+              const struct rgba8_swizzle *swz)
+{
+   int i = 0;
+
+#ifdef __AVX2__
+   const __m256i shuffle =
+      _mm256_inserti128_si256(_mm256_castsi128_si256(swz->shuffle),
+                              swz->shuffle, 1);
+   const __m256i ones =
+      _mm256_inserti128_si256(_mm256_castsi128_si256(swz->ones),
+                              swz->ones, 1);
+
+   for (; i + 8 <= count; i += 8) {
+      __m256i v = _mm256_loadu_si256((const __m256i *) (src + i * 4));
+      v = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), ones);
+      _mm256_storeu_si256((__m256i *) (dst + i * 4), v);
+   }
+#endif
+
+   for (; i + 4 <= count; i += 4) {
+      __m128i v = _mm_loadu_si128((const __m128i *) (src + i * 4));
+      _mm_storeu_si128((__m128i *) (dst + i * 4), rgba8_swizzle_16(v, swz));
+   }
+
+   for (; i < count; ++i)
+      rgba8_swizzle_pixel(dst + i * 4, src + i * 4, swz);
+}
+#endif
+
+/* Converts n UNORM8 values to float.  With a swizzle, n is a multiple of 4
+ * and the bytes are swizzled as 4-channel pixels first.
+ */
+static void
+unorm8_to_float(float *dst, const uint8_t *src, int n,
+                const struct rgba8_swizzle *swz)
+{
+   const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+   const __m128i zero = _mm_setzero_si128();
+   int i = 0;
+
+#ifdef __AVX2__
+   const __m256 scale8 = _mm256_set1_ps(1.0f / 255.0f);
+
+   for (; i + 16 <= n; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+      v = rgba8_swizzle_16(v, swz);
+      _mm256_storeu_ps(dst + i,
+                       _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v)),
+                                     scale8));
+      v = _mm_srli_si128(v, 8);
+      _mm256_storeu_ps(dst + i + 8,
+                       _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v)),
+                                     scale8));
+   }
+#endif
+
+   for (; i + 16 <= n; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+      __m128i lo, hi;
+
+      v = rgba8_swizzle_16(v, swz);
+      lo = _mm_unpacklo_epi8(v, zero);
+      hi = _mm_unpackhi_epi8(v, zero);
+      _mm_storeu_ps(dst + i + 0,
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)),
+                               scale));
+      _mm_storeu_ps(dst + i + 4,
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)),
+                               scale));
+      _mm_storeu_ps(dst + i + 8,
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)),
+                               scale));
+      _mm_storeu_ps(dst + i + 12,
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)),
+                               scale));
+   }
+
+   if (swz) {
+      for (; i < n; i += 4) {
+         uint8_t pixel[4];
+         int c;
+
+         rgba8_swizzle_pixel(pixel, src + i, swz);
+         for (c = 0; c < 4; ++c)
+            dst[i + c] = _mesa_unorm_to_float(pixel[c], 8);
+      }
+   } else {
+      for (; i < n; ++i)
+         dst[i] = _mesa_unorm_to_float(src[i], 8);
+   }
+}
+
+/* Clamps 4 floats to [0, 1] and converts them to UNORM8, rounding to the
+ * nearest even like _mesa_float_to_unorm().  NaN becomes 0.
+ */
+static inline __m128i
+float_to_unorm8_4(__m128 f)
+{
+   f = _mm_max_ps(f, _mm_setzero_ps());
+   f = _mm_min_ps(f, _mm_set1_ps(1.0f));
+   return _mm_cvtps_epi32(_mm_mul_ps(f, _mm_set1_ps(255.0f)));
+}
+
+/* Converts n floats to UNORM8.  With a swizzle, n is a multiple of 4 and
+ * the result is swizzled as 4-channel pixels.
+ */
+static void
+float_to_unorm8(uint8_t *dst, const float *src, int n,
+                const struct rgba8_swizzle *swz)
+{
+   int i = 0;
+
+   for (; i + 16 <= n; i += 16) {
+      const __m128i a = float_to_unorm8_4(_mm_loadu_ps(src + i + 0));
+      const __m128i b = float_to_unorm8_4(_mm_loadu_ps(src + i + 4));
+      const __m128i c = float_to_unorm8_4(_mm_loadu_ps(src + i + 8));
+      const __m128i d = float_to_unorm8_4(_mm_loadu_ps(src + i + 12));
+      __m128i v = _mm_packus_epi16(_mm_packs_epi32(a, b),
+                                   _mm_packs_epi32(c, d));
+
+      _mm_storeu_si128((__m128i *) (dst + i), rgba8_swizzle_16(v, swz));
+   }
+
+   if (swz) {
+      for (; i < n; i += 4) {
+         uint8_t pixel[4];
+         int c;
+
+         for (c = 0; c < 4; ++c)
+            pixel[c] = _mesa_float_to_unorm(src[i + c], 8);
+         rgba8_swizzle_pixel(dst + i, pixel, swz);
+      }
+   } else {
+      for (; i < n; ++i)
+         dst[i] = _mesa_float_to_unorm(src[i], 8);
+   }
+}
+
+/* Converts 4 halves in the low 16 bits of each 32-bit lane to floats, the
+ * way _mesa_half_to_float() does: denormals are exact and all NaNs become
+ * the same float NaN.
+ */
+static inline __m128
+half_to_float_4(__m128i h)
+{
+   const __m128i exp_mask = _mm_set1_epi32(0x7c00);
+   const __m128i mag = _mm_and_si128(h, _mm_set1_epi32(0x7fff));
+   const __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, mag), 16);
+   const __m128i exp = _mm_and_si128(mag, exp_mask);
+   const __m128i is_infnan = _mm_cmpeq_epi32(exp, exp_mask);
+   const __m128i is_denorm = _mm_cmpeq_epi32(exp, _mm_setzero_si128());
+   const __m128i is_nan = _mm_cmpgt_epi32(mag, exp_mask);
+   __m128i o;
+   __m128 denorm;
+
+   /* Rebias the exponent, all the way to 255 for infinity and NaN. */
+   o = _mm_add_epi32(_mm_slli_epi32(mag, 13), _mm_set1_epi32(112 << 23));
+   o = _mm_add_epi32(o, _mm_and_si128(is_infnan, _mm_set1_epi32(112 << 23)));
+
+   /* Denormals (and zero) get an implicit one at 2^-14, which is then
+    * subtracted again.
+    */
+   denorm = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(o, _mm_set1_epi32(1 << 23))),
+                       _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+   o = select_si128(is_denorm, _mm_castps_si128(denorm), o);
+   o = select_si128(is_nan, _mm_set1_epi32(0x7f800001), o);
+
+   return _mm_castsi128_ps(_mm_or_si128(o, sign));
+}
+
+static void
+half_to_float(float *dst, const uint16_t *src, int n)
+{
+   const __m128i zero = _mm_setzero_si128();
+   int i = 0;
+
+   for (; i + 8 <= n; i += 8) {
+      const __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+
+      _mm_storeu_ps(dst + i, half_to_float_4(_mm_unpacklo_epi16(v, zero)));
+      _mm_storeu_ps(dst + i + 4, half_to_float_4(_mm_unpackhi_epi16(v, zero)));
+   }
+
+   for (; i < n; ++i)
+      dst[i] = _mesa_half_to_float(src[i]);
+}
+
+/* Converts 4 floats to halves in the low 16 bits of each 32-bit lane, the
+ * way _mesa_float_to_half() does: round to nearest even, overflow to
+ * infinity and all NaNs to the same half NaN.
+ */
+static inline __m128i
+float_to_half_4(__m128 f)
+{
+   const __m128i sign_mask = _mm_set1_epi32(0x80000000);
+   const __m128i x = _mm_andnot_si128(sign_mask, _mm_castps_si128(f));
+   const __m128i sign = _mm_srli_epi32(_mm_and_si128(_mm_castps_si128(f),
+                                                     sign_mask), 16);
+   const __m128i is_nan = _mm_cmpgt_epi32(x, _mm_set1_epi32(0x7f800000));
+   const __m128i is_inf = _mm_cmpgt_epi32(x, _mm_set1_epi32((143 << 23) - 1));
+   const __m128i is_small = _mm_cmplt_epi32(x, _mm_set1_epi32(113 << 23));
+   const __m128i magic = _mm_set1_epi32(126 << 23);
+   __m128i small, normal, odd, h;
+
+   /* Below 2^-14 the result is a half denormal (or zero, or the smallest
+    * normal).  Adding 0.5 lines the half mantissa up with the float one,
+    * and the FPU does the rounding.
+    */
+   small = _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(x),
+                                       _mm_castsi128_ps(magic)));
+   small = _mm_sub_epi32(small, magic);
+
+   /* Rebias the exponent and round the mantissa to nearest even.  A carry
+    * out of the mantissa correctly bumps the exponent, up to infinity.
+    */
+   odd = _mm_and_si128(_mm_srli_epi32(x, 13), _mm_set1_epi32(1));
+   normal = _mm_add_epi32(x, _mm_set1_epi32(0xfff - (112 << 23)));
+   normal = _mm_srli_epi32(_mm_add_epi32(normal, odd), 13);
+
+   h = select_si128(is_small, small, normal);
+   h = select_si128(is_inf, _mm_set1_epi32(0x7c00), h);
+   h = select_si128(is_nan, _mm_set1_epi32(0x7c01), h);
+
+   return _mm_or_si128(h, sign);
+}
+
+static void
+float_to_half(uint16_t *dst, const float *src, int n)
+{
+   int i = 0;
+
+   for (; i + 8 <= n; i += 8) {
+      const __m128i lo = float_to_half_4(_mm_loadu_ps(src + i));
+      const __m128i hi = float_to_half_4(_mm_loadu_ps(src + i + 4));
+
+      _mm_storeu_si128((__m128i *) (dst + i), pack_u32_to_u16(lo, hi));
+   }
+
+   for (; i < n; ++i)
+      dst[i] = _mesa_float_to_half(src[i]);
+}
+
+bool
+FUNC(_mesa_swizzle_and_convert)(void *void_dst,
+                                enum mesa_array_format_datatype dst_type,
+                                int num_dst_channels,
+                                const void *void_src,
+                                enum mesa_array_format_datatype src_type,
+                                int num_src_channels,
+                                const uint8_t swizzle[4], bool normalized,
+                                int count)
+{
+   const int n = count * num_dst_channels;
+   struct rgba8_swizzle rgba8_swz;
+   const struct rgba8_swizzle *swz = NULL;
+
+   if (num_src_channels != num_dst_channels)
+      return false;
+
+   if (!is_identity_swizzle(swizzle, num_dst_channels)) {
+#ifdef __SSSE3__
+      if (num_dst_channels != 4 ||
+          !init_rgba8_swizzle(&rgba8_swz, swizzle, normalized ? UINT8_MAX : 1))
+         return false;
+      swz = &rgba8_swz;
+#else
+      (void) rgba8_swz;
+      return false;
+#endif
+   }
+
+   switch (dst_type) {
+   case MESA_ARRAY_FORMAT_TYPE_UBYTE:
+#ifdef __SSSE3__
+      if (src_type == MESA_ARRAY_FORMAT_TYPE_UBYTE && swz) {
+         swizzle_rgba8(void_dst, void_src, count, swz);
+         return true;
+      }
+#endif
+      if (src_type == MESA_ARRAY_FORMAT_TYPE_FLOAT && normalized) {
+         float_to_unorm8(void_dst, void_src, n, swz);
+         return true;
+      }
+      break;
+   case MESA_ARRAY_FORMAT_TYPE_FLOAT:
+      if (src_type == MESA_ARRAY_FORMAT_TYPE_UBYTE && normalized) {
+         unorm8_to_float(void_dst, void_src, n, swz);
+         return true;
+      }
+      if (src_type == MESA_ARRAY_FORMAT_TYPE_HALF && !swz) {
+         half_to_float(void_dst, void_src, n);
+         return true;
+      }
+      break;
+   case MESA_ARRAY_FORMAT_TYPE_HALF:
+      if (src_type == MESA_ARRAY_FORMAT_TYPE_FLOAT && !swz) {
+         float_to_half(void_dst, void_src, n);
+         return true;
+      }
+      break;
+   default:
+      break;
+   }
+
+   return false;
+}
+
+#if !defined(FORMAT_SIMD_SSE41) && !defined(FORMAT_SIMD_AVX2)
+
+/* The depth conversions are bound by memory bandwidth, so only the SSE2
+ * build has them.
+ */
+
+void
+_mesa_float_to_z16_row_sse2(uint16_t *dst, const float *src, unsigned n)
+{
+   const __m128 zero = _mm_setzero_ps();
+   const __m128 one = _mm_set1_ps(1.0f);
+   const __m128 scale = _mm_set1_ps((float) 0xffff);
+   unsigned i = 0;
+
+   for (; i + 8 <= n; i += 8) {
+      __m128 lo = _mm_loadu_ps(src + i);
+      __m128 hi = _mm_loadu_ps(src + i + 4);
+
+      lo = _mm_mul_ps(_mm_min_ps(_mm_max_ps(lo, zero), one), scale);
+      hi = _mm_mul_ps(_mm_min_ps(_mm_max_ps(hi, zero), one), scale);
+      _mm_storeu_si128((__m128i *) (dst + i),
+                       pack_u32_to_u16(_mm_cvttps_epi32(lo),
+                                       _mm_cvttps_epi32(hi)));
+   }
+
+   for (; i < n; ++i) {
+      const float z = src[i] > 0.0f ? MIN2(src[i], 1.0f) : 0.0f;
+      dst[i] = (uint16_t) (z * (float) 0xffff);
+   }
+}
+
+void
+_mesa_z16_to_float_row_sse2(float *dst, const uint16_t *src, unsigned n)
+{
+   const __m128 scale = _mm_set1_ps(1.0f / 65535.0f);
+   const __m128i zero = _mm_setzero_si128();
+   unsigned i = 0;
+
+   for (; i + 8 <= n; i += 8) {
+      const __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+
+      _mm_storeu_ps(dst + i,
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)),
+                               scale));
+      _mm_storeu_ps(dst + i + 4,
+                    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)),
+                               scale));
+   }
+
+   for (; i < n; ++i)
+      dst[i] = src[i] * (1.0f / 65535.0f);
+}
+
+#endif
+
+#endif /* __SSE2__ */
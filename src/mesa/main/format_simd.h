@@ -0,0 +1,98 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file format_simd.h
+ *
+ * SIMD versions of the most common _mesa_swizzle_and_convert() cases.
+ *
+ * format_simd.c is built once as is, which gives the SSE2 kernels, and
+ * once for each of SSE4.1 and AVX2 when the compiler supports them.  The
+ * SSE4.1 build is where the SSSE3 byte shuffles live.
+ */
+
+#ifndef FORMAT_SIMD_H
+#define FORMAT_SIMD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "formats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Performs the swizzle-and-convert operation if the kernels of this build
+ * handle it.  The arguments are those of _mesa_swizzle_and_convert().
+ *
+ * \return  true if the conversion was done, false if the caller has to
+ *          fall back to the generic code
+ */
+bool
+_mesa_swizzle_and_convert_sse2(void *dst,
+                               enum mesa_array_format_datatype dst_type,
+                               int num_dst_channels,
+                               const void *src,
+                               enum mesa_array_format_datatype src_type,
+                               int num_src_channels,
+                               const uint8_t swizzle[4], bool normalized,
+                               int count);
+
+bool
+_mesa_swizzle_and_convert_sse41(void *dst,
+                                enum mesa_array_format_datatype dst_type,
+                                int num_dst_channels,
+                                const void *src,
+                                enum mesa_array_format_datatype src_type,
+                                int num_src_channels,
+                                const uint8_t swizzle[4], bool normalized,
+                                int count);
+
+bool
+_mesa_swizzle_and_convert_avx2(void *dst,
+                               enum mesa_array_format_datatype dst_type,
+                               int num_dst_channels,
+                               const void *src,
+                               enum mesa_array_format_datatype src_type,
+                               int num_src_channels,
+                               const uint8_t swizzle[4], bool normalized,
+                               int count);
+
+/**
+ * Clamps depth values to [0, 1] and converts them to 16-bit depth,
+ * truncating like _mesa_unpack_depth_span() does.
+ */
+void
+_mesa_float_to_z16_row_sse2(uint16_t *dst, const float *src, unsigned n);
+
+/**
+ * Converts 16-bit depth values to floats, like unpack_float_Z_UNORM16().
+ */
+void
+_mesa_z16_to_float_row_sse2(float *dst, const uint16_t *src, unsigned n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FORMAT_SIMD_H */
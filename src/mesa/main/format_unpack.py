@@ -45,6 +45,7 @@ string = """/*
 
 #include "format_unpack.h"
 #include "format_utils.h"
+#include "format_simd.h"
 #include "macros.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
@@ -319,10 +320,14 @@ _mesa_unpack_rgba_row(mesa_format format, GLuint n,
       <% continue %>
    %endif
    case ${f.name}:
+   %if f.name == 'MESA_FORMAT_RGBA_FLOAT16':
+      _mesa_half_to_float_array(&dst[0][0], (const uint16_t *) s, 4 * n);
+   %else:
       for (i = 0; i < n; ++i) {
          unpack_float_${f.short_name()}(s, dst[i]);
          s += ${f.block_size() / 8};
       }
+   %endif
       break;
 %endfor
    case MESA_FORMAT_YCBCR:
@@ -484,11 +489,15 @@ unpack_float_z_Z24_UNORM_X8_UINT(GLuint n, const void *src, GLfloat *dst)
 static void
 unpack_float_Z_UNORM16(GLuint n, const void *src, GLfloat *dst)
 {
+#if defined(__SSE2__)
+   _mesa_z16_to_float_row_sse2(dst, (const GLushort *) src, n);
+#else
    const GLushort *s = ((const GLushort *) src);
    GLuint i;
    for (i = 0; i < n; i++) {
       dst[i] = s[i] * (1.0F / 65535.0F);
    }
+#endif
 }
 
 static void
@@ -26,6 +26,8 @@
 #include "glformats.h"
 #include "format_pack.h"
 #include "format_unpack.h"
+#include "format_simd.h"
+#include "cpuinfo.h"
 
 const mesa_array_format RGBA32_FLOAT =
    MESA_ARRAY_FORMAT(4, 1, 1, 1, 4, 0, 1, 2, 3);
@@ -713,6 +715,44 @@ swizzle_convert_try_memcpy(void *dst,
    return true;
 }
 
+/**
+ * Performs the swizzle-and-convert operation with the SIMD kernels of
+ * format_simd.c, if the CPU has them and they handle it.
+ *
+ * The arguments are exactly the same as for _mesa_swizzle_and_convert
+ *
+ * \return  true if the SIMD kernels did the conversion, false otherwise
+ */
+static bool
+swizzle_convert_try_simd(void *dst,
+                         enum mesa_array_format_datatype dst_type,
+                         int num_dst_channels,
+                         const void *src,
+                         enum mesa_array_format_datatype src_type,
+                         int num_src_channels,
+                         const uint8_t swizzle[4], bool normalized, int count)
+{
+#if defined(USE_AVX2)
+   if (cpu_has_avx2)
+      return _mesa_swizzle_and_convert_avx2(dst, dst_type, num_dst_channels,
+                                            src, src_type, num_src_channels,
+                                            swizzle, normalized, count);
+#endif
+#if defined(USE_SSE41)
+   if (cpu_has_sse4_1)
+      return _mesa_swizzle_and_convert_sse41(dst, dst_type, num_dst_channels,
+                                             src, src_type, num_src_channels,
+                                             swizzle, normalized, count);
+#endif
+#if defined(__SSE2__)
+   return _mesa_swizzle_and_convert_sse2(dst, dst_type, num_dst_channels,
+                                         src, src_type, num_src_channels,
+                                         swizzle, normalized, count);
+#else
+   return false;
+#endif
+}
+
 /**
  * Represents a single instance of the standard swizzle-and-convert loop
  *
@@ -1432,6 +1472,11 @@ _mesa_swizzle_and_convert(void *void_dst, enum mesa_array_format_datatype dst_ty
                                   swizzle, normalized, count))
       return;
 
+   if (swizzle_convert_try_simd(void_dst, dst_type, num_dst_channels,
+                                void_src, src_type, num_src_channels,
+                                swizzle, normalized, count))
+      return;
+
    switch (dst_type) {
    case MESA_ARRAY_FORMAT_TYPE_FLOAT:
       convert_float(void_dst, num_dst_channels, void_src, src_type,
@@ -677,9 +677,7 @@ update_framebuffer(struct gl_context *ctx, struct gl_framebuffer *fb)
       /* This is a user-created framebuffer.
        * Completeness only matters for user-created framebuffers.
        */
-      if (fb->_Status != GL_FRAMEBUFFER_COMPLETE) {
-         _mesa_test_framebuffer_completeness(ctx, fb);
-      }
+      _mesa_update_framebuffer_completeness(ctx, fb);
    }
 
    /* Strictly speaking, we don't need to update the draw-state
@@ -730,9 +728,8 @@ renderbuffer_exists(struct gl_context *ctx,
    const struct gl_renderbuffer_attachment *att = fb->Attachment;
 
    /* If we don't know the framebuffer status, update it now */
-   if (fb->_Status == 0) {
-      _mesa_test_framebuffer_completeness(ctx, fb);
-   }
+   if (_mesa_is_user_fbo(fb))
+      _mesa_update_framebuffer_completeness(ctx, fb);
 
    if (fb->_Status != GL_FRAMEBUFFER_COMPLETE_EXT) {
       return GL_FALSE;
@@ -423,6 +423,8 @@ EXTRA_EXT(ARB_framebuffer_no_attachments);
 EXTRA_EXT(ARB_tessellation_shader);
 EXTRA_EXT(ARB_shader_subroutine);
 EXTRA_EXT(ARB_shader_storage_buffer_object);
+EXTRA_EXT(ARB_query_buffer_object);
+EXTRA_EXT(ARB_sparse_buffer);
 
 static const int
 extra_ARB_color_buffer_float_or_glcore[] = {
@@ -555,6 +557,118 @@ print_table_stats(int api)
 }
 #endif
 
+/**
+ * Return the index of the hash table in table_set[] for the context's API.
+ *
+ * GLES 3 doesn't have an API_OPENGL* enum value since it's compatible with
+ * GLES2, so the GLES 3 and 3.1 entries in table_set[] are at the end.
+ */
+static inline int
+get_table_api(const struct gl_context *ctx)
+{
+   STATIC_ASSERT(ARRAY_SIZE(table_set) == API_OPENGL_LAST + 3);
+   if (_mesa_is_gles31(ctx))
+      return API_OPENGL_LAST + 2;
+   if (_mesa_is_gles3(ctx))
+      return API_OPENGL_LAST + 1;
+   return ctx->API;
+}
+
+/**
+ * Walk the hash table of the given API for 'pname'.
+ *
+ * \return the struct value_desc of the enum, or NULL if the enum isn't
+ *     valid in this API.
+ */
+static const struct value_desc *
+lookup_value(int api, GLenum pname)
+{
+   const int mask = ARRAY_SIZE(table(api)) - 1;
+   int hash = (pname * prime_factor);
+
+   while (1) {
+      int idx = table(api)[hash & mask];
+
+      /* If the enum isn't valid, the hash walk ends with index 0,
+       * pointing to the first entry of values[] which doesn't hold
+       * any valid enum. */
+      if (unlikely(idx == 0))
+         return NULL;
+
+      if (likely(values[idx].pname == pname))
+         return &values[idx];
+
+      hash += prime_step;
+   }
+}
+
+/**
+ * The state applications query the most, often every frame: the object
+ * bindings, the viewport and the fixed function matrices.
+ *
+ * glGetIntegerv() and glGetFloatv() read these directly in get_fast_value()
+ * instead of going through find_value(), check_extra(), find_custom_value()
+ * and the generic type conversion.  None of them has extra checks, but not
+ * all of them are valid in every API, so fast_valid_mask[] records, per
+ * hash table, which of them the table holds.
+ */
+enum fast_value {
+   FAST_ACTIVE_TEXTURE,
+   FAST_ARRAY_BUFFER_BINDING,
+   FAST_ELEMENT_ARRAY_BUFFER_BINDING,
+   FAST_VERTEX_ARRAY_BINDING,
+   FAST_TEXTURE_BINDING_2D,
+   FAST_CURRENT_PROGRAM,
+   FAST_DRAW_FRAMEBUFFER_BINDING,
+   FAST_READ_FRAMEBUFFER_BINDING,
+   FAST_RENDERBUFFER_BINDING,
+   FAST_VIEWPORT,
+   FAST_MATRIX_MODE,
+   FAST_MODELVIEW_MATRIX,
+   FAST_PROJECTION_MATRIX,
+   FAST_VALUE_COUNT
+};
+
+static const GLenum fast_pnames[FAST_VALUE_COUNT] = {
+   [FAST_ACTIVE_TEXTURE] = GL_ACTIVE_TEXTURE,
+   [FAST_ARRAY_BUFFER_BINDING] = GL_ARRAY_BUFFER_BINDING,
+   [FAST_ELEMENT_ARRAY_BUFFER_BINDING] = GL_ELEMENT_ARRAY_BUFFER_BINDING,
+   [FAST_VERTEX_ARRAY_BINDING] = GL_VERTEX_ARRAY_BINDING,
+   [FAST_TEXTURE_BINDING_2D] = GL_TEXTURE_BINDING_2D,
+   [FAST_CURRENT_PROGRAM] = GL_CURRENT_PROGRAM,
+   [FAST_DRAW_FRAMEBUFFER_BINDING] = GL_DRAW_FRAMEBUFFER_BINDING,
+   [FAST_READ_FRAMEBUFFER_BINDING] = GL_READ_FRAMEBUFFER_BINDING,
+   [FAST_RENDERBUFFER_BINDING] = GL_RENDERBUFFER_BINDING,
+   [FAST_VIEWPORT] = GL_VIEWPORT,
+   [FAST_MATRIX_MODE] = GL_MATRIX_MODE,
+   [FAST_MODELVIEW_MATRIX] = GL_MODELVIEW_MATRIX,
+   [FAST_PROJECTION_MATRIX] = GL_PROJECTION_MATRIX,
+};
+
+/** Bitmask of the fast values held by each hash table in table_set[]. */
+static GLbitfield fast_valid_mask[API_OPENGL_LAST + 3];
+
+static void
+init_fast_valid_mask(void)
+{
+   int api, i;
+
+   for (api = 0; api < ARRAY_SIZE(fast_valid_mask); api++) {
+      GLbitfield mask = 0;
+
+      for (i = 0; i < FAST_VALUE_COUNT; i++) {
+         const struct value_desc *d = lookup_value(api, fast_pnames[i]);
+
+         /* get_fast_value() doesn't do the extra checks. */
+         assert(!d || !d->extra);
+         if (d && !d->extra)
+            mask |= 1u << i;
+      }
+
+      fast_valid_mask[api] = mask;
+   }
+}
+
 /**
  * Initialize the enum hash for a given API 
  *
@@ -570,6 +684,11 @@ void _mesa_init_get_hash(struct gl_context *ctx)
 #else
    (void) ctx;
 #endif
+
+   /* This covers the tables of all APIs, but it's cheap and the result
+    * is always the same.
+    */
+   init_fast_valid_mask();
 }
 
 /**
@@ -1044,6 +1163,10 @@ find_custom_value(struct gl_context *ctx, const struct value_desc *d, union valu
    case GL_DISPATCH_INDIRECT_BUFFER_BINDING:
       v->value_int = ctx->DispatchIndirectBuffer->Name;
       break;
+   /* GL_ARB_query_buffer_object */
+   case GL_QUERY_BUFFER_BINDING:
+      v->value_int = ctx->QueryBuffer->Name;
+      break;
    }
 }
 
@@ -1223,42 +1346,16 @@ find_value(const char *func, GLenum pname, void **p, union value *v)
 {
    GET_CURRENT_CONTEXT(ctx);
    struct gl_texture_unit *unit;
-   int mask, hash;
    const struct value_desc *d;
-   int api;
 
-   api = ctx->API;
    /* We index into the table_set[] list of per-API hash tables using the API's
-    * value in the gl_api enum. Since GLES 3 doesn't have an API_OPENGL* enum
-    * value since it's compatible with GLES2 its entry in table_set[] is at the
-    * end.
+    * value in the gl_api enum.
     */
-   STATIC_ASSERT(ARRAY_SIZE(table_set) == API_OPENGL_LAST + 3);
-   if (_mesa_is_gles3(ctx)) {
-      api = API_OPENGL_LAST + 1;
-   }
-   if (_mesa_is_gles31(ctx)) {
-      api = API_OPENGL_LAST + 2;
-   }
-   mask = ARRAY_SIZE(table(api)) - 1;
-   hash = (pname * prime_factor);
-   while (1) {
-      int idx = table(api)[hash & mask];
-
-      /* If the enum isn't valid, the hash walk ends with index 0,
-       * pointing to the first entry of values[] which doesn't hold
-       * any valid enum. */
-      if (unlikely(idx == 0)) {
-         _mesa_error(ctx, GL_INVALID_ENUM, "%s(pname=%s)", func,
-               _mesa_enum_to_string(pname));
-         return &error_value;
-      }
-
-      d = &values[idx];
-      if (likely(d->pname == pname))
-         break;
-
-      hash += prime_step;
+   d = lookup_value(get_table_api(ctx), pname);
+   if (unlikely(!d)) {
+      _mesa_error(ctx, GL_INVALID_ENUM, "%s(pname=%s)", func,
+                  _mesa_enum_to_string(pname));
+      return &error_value;
    }
 
    if (unlikely(d->extra && !check_extra(ctx, func, d)))
@@ -1291,6 +1388,76 @@ find_value(const char *func, GLenum pname, void **p, union value *v)
    return &error_value;
 }
 
+/**
+ * Look up one of the fast values (see enum fast_value).
+ *
+ * \return the type of the value stored in 'v': TYPE_INT, TYPE_FLOAT_4 or
+ *     TYPE_MATRIX, or TYPE_INVALID if 'pname' isn't one of the fast values
+ *     in this API and has to go through find_value().
+ */
+static inline enum value_type
+get_fast_value(struct gl_context *ctx, GLenum pname, union value *v)
+{
+   const GLbitfield valid = fast_valid_mask[get_table_api(ctx)];
+
+#define FAST_CASE(name)                                 \
+   case GL_##name:                                      \
+      if (!(valid & (1u << FAST_##name)))               \
+         return TYPE_INVALID;
+
+   switch (pname) {
+   FAST_CASE(ACTIVE_TEXTURE)
+      v->value_int = GL_TEXTURE0 + ctx->Texture.CurrentUnit;
+      return TYPE_INT;
+   FAST_CASE(ARRAY_BUFFER_BINDING)
+      v->value_int = ctx->Array.ArrayBufferObj->Name;
+      return TYPE_INT;
+   FAST_CASE(ELEMENT_ARRAY_BUFFER_BINDING)
+      v->value_int = ctx->Array.VAO->IndexBufferObj->Name;
+      return TYPE_INT;
+   FAST_CASE(VERTEX_ARRAY_BINDING)
+      v->value_int = ctx->Array.VAO->Name;
+      return TYPE_INT;
+   FAST_CASE(TEXTURE_BINDING_2D)
+      v->value_int = ctx->Texture.Unit[ctx->Texture.CurrentUnit]
+         .CurrentTex[TEXTURE_2D_INDEX]->Name;
+      return TYPE_INT;
+   FAST_CASE(CURRENT_PROGRAM)
+      v->value_int =
+         ctx->Shader.ActiveProgram ? ctx->Shader.ActiveProgram->Name : 0;
+      return TYPE_INT;
+   FAST_CASE(DRAW_FRAMEBUFFER_BINDING)
+      v->value_int = ctx->DrawBuffer->Name;
+      return TYPE_INT;
+   FAST_CASE(READ_FRAMEBUFFER_BINDING)
+      v->value_int = ctx->ReadBuffer->Name;
+      return TYPE_INT;
+   FAST_CASE(RENDERBUFFER_BINDING)
+      v->value_int =
+         ctx->CurrentRenderbuffer ? ctx->CurrentRenderbuffer->Name : 0;
+      return TYPE_INT;
+   FAST_CASE(VIEWPORT)
+      v->value_float_4[0] = ctx->ViewportArray[0].X;
+      v->value_float_4[1] = ctx->ViewportArray[0].Y;
+      v->value_float_4[2] = ctx->ViewportArray[0].Width;
+      v->value_float_4[3] = ctx->ViewportArray[0].Height;
+      return TYPE_FLOAT_4;
+   FAST_CASE(MATRIX_MODE)
+      v->value_int = ctx->Transform.MatrixMode;
+      return TYPE_INT;
+   FAST_CASE(MODELVIEW_MATRIX)
+      v->value_matrix = ctx->ModelviewMatrixStack.Top;
+      return TYPE_MATRIX;
+   FAST_CASE(PROJECTION_MATRIX)
+      v->value_matrix = ctx->ProjectionMatrixStack.Top;
+      return TYPE_MATRIX;
+   default:
+      return TYPE_INVALID;
+   }
+
+#undef FAST_CASE
+}
+
 static const int transpose[] = {
    0, 4,  8, 12,
    1, 5,  9, 13,
@@ -1389,12 +1556,27 @@ _mesa_GetBooleanv(GLenum pname, GLboolean *params)
 void GLAPIENTRY
 _mesa_GetFloatv(GLenum pname, GLfloat *params)
 {
+   GET_CURRENT_CONTEXT(ctx);
    const struct value_desc *d;
    union value v;
    GLmatrix *m;
    int shift, i;
    void *p;
 
+   switch (get_fast_value(ctx, pname, &v)) {
+   case TYPE_INT:
+      params[0] = (GLfloat) v.value_int;
+      return;
+   case TYPE_FLOAT_4:
+      COPY_4FV(params, v.value_float_4);
+      return;
+   case TYPE_MATRIX:
+      memcpy(params, v.value_matrix->m, 16 * sizeof(GLfloat));
+      return;
+   default:
+      break;
+   }
+
    d = find_value("glGetFloatv", pname, &p, &v);
    switch (d->type) {
    case TYPE_INVALID:
@@ -1477,12 +1659,29 @@ _mesa_GetFloatv(GLenum pname, GLfloat *params)
 void GLAPIENTRY
 _mesa_GetIntegerv(GLenum pname, GLint *params)
 {
+   GET_CURRENT_CONTEXT(ctx);
    const struct value_desc *d;
    union value v;
    GLmatrix *m;
    int shift, i;
    void *p;
 
+   switch (get_fast_value(ctx, pname, &v)) {
+   case TYPE_INT:
+      params[0] = v.value_int;
+      return;
+   case TYPE_FLOAT_4:
+      for (i = 0; i < 4; i++)
+         params[i] = IROUND(v.value_float_4[i]);
+      return;
+   case TYPE_MATRIX:
+      for (i = 0; i < 16; i++)
+         params[i] = FLOAT_TO_INT(v.value_matrix->m[i]);
+      return;
+   default:
+      break;
+   }
+
    d = find_value("glGetIntegerv", pname, &p, &v);
    switch (d->type) {
    case TYPE_INVALID:
@@ -138,7 +138,7 @@ _mesa_GetString( GLenum name )
             _mesa_error(ctx, GL_INVALID_ENUM, "glGetString(GL_EXTENSIONS)");
             return (const GLubyte *) 0;
          }
-         return (const GLubyte *) ctx->Extensions.String;
+         return _mesa_get_extension_string(ctx);
       case GL_SHADING_LANGUAGE_VERSION:
          if (ctx->API == API_OPENGLES)
             break;
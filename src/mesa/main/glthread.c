@@ -0,0 +1,219 @@
+/*
+ * Copyright © 2012 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file glthread.c
+ *
+ * Support functions for the glthread feature of Mesa.
+ *
+ * In multicore systems, many applications end up CPU-bound with about half
+ * their time spent inside their rendering thread and half inside Mesa.  To
+ * alleviate this, we put a shim layer in Mesa at the GL dispatch level that
+ * quickly logs the GL commands to a buffer to be processed by a worker
+ * thread.
+ */
+
+#include "main/mtypes.h"
+#include "main/glthread.h"
+#include "main/marshal.h"
+#include "main/context.h"
+#include "main/imports.h"
+#include "glapi/glapi.h"
+
+
+static void
+glthread_unmarshal_batch(struct gl_context *ctx, struct glthread_batch *batch)
+{
+   size_t pos = 0;
+
+   /* Commands executed by the worker may have switched the dispatch table
+    * (glBegin, glNewList, ...) while the application thread was executing
+    * synchronous calls, so pick up the current one for functions that call
+    * back into GET_DISPATCH().
+    */
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   while (pos < batch->used)
+      pos += _mesa_unmarshal_dispatch_cmd(ctx, (uint8_t *) batch->buffer + pos);
+
+   assert(pos == batch->used);
+   batch->used = 0;
+}
+
+static int
+glthread_worker(void *data)
+{
+   struct gl_context *ctx = data;
+   struct glthread_state *glthread = ctx->GLThread;
+
+   /* GL entrypoints executed by the worker look up the context the same way
+    * they would on the application thread.
+    */
+   _glapi_set_context(ctx);
+
+   mtx_lock(&glthread->mutex);
+   while (true) {
+      struct glthread_batch *batch;
+
+      while (glthread->completed == glthread->submitted && !glthread->shutdown)
+         cnd_wait(&glthread->new_work, &glthread->mutex);
+
+      if (glthread->completed == glthread->submitted)
+         break; /* shutdown with nothing left to do */
+
+      batch = &glthread->batches[glthread->completed % MARSHAL_MAX_BATCHES];
+      mtx_unlock(&glthread->mutex);
+
+      glthread_unmarshal_batch(ctx, batch);
+
+      mtx_lock(&glthread->mutex);
+      glthread->completed++;
+      cnd_broadcast(&glthread->work_done);
+   }
+   mtx_unlock(&glthread->mutex);
+
+   return 0;
+}
+
+void
+_mesa_glthread_init(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = calloc(1, sizeof(*glthread));
+
+   if (!glthread)
+      return;
+
+   ctx->MarshalExec = _mesa_create_marshal_table(ctx);
+   if (!ctx->MarshalExec) {
+      free(glthread);
+      return;
+   }
+
+   mtx_init(&glthread->mutex, mtx_plain);
+   cnd_init(&glthread->new_work);
+   cnd_init(&glthread->work_done);
+   glthread->batch = &glthread->batches[0];
+
+   ctx->GLThread = glthread;
+
+   if (thrd_create(&glthread->thread, glthread_worker, ctx) != thrd_success) {
+      ctx->GLThread = NULL;
+      cnd_destroy(&glthread->work_done);
+      cnd_destroy(&glthread->new_work);
+      mtx_destroy(&glthread->mutex);
+      free(glthread);
+      free(ctx->MarshalExec);
+      ctx->MarshalExec = NULL;
+      return;
+   }
+
+   /* If the context is already current, start marshalling right away. */
+   if (_mesa_get_current_context() == ctx)
+      _glapi_set_dispatch(ctx->MarshalExec);
+}
+
+void
+_mesa_glthread_destroy(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (!glthread)
+      return;
+
+   _mesa_glthread_finish(ctx);
+
+   mtx_lock(&glthread->mutex);
+   glthread->shutdown = true;
+   cnd_broadcast(&glthread->new_work);
+   mtx_unlock(&glthread->mutex);
+
+   thrd_join(glthread->thread, NULL);
+
+   cnd_destroy(&glthread->work_done);
+   cnd_destroy(&glthread->new_work);
+   mtx_destroy(&glthread->mutex);
+   free(glthread);
+   ctx->GLThread = NULL;
+
+   /* Stop marshalling if this context is still current. */
+   if (_mesa_get_current_context() == ctx)
+      _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   free(ctx->MarshalExec);
+   ctx->MarshalExec = NULL;
+}
+
+/**
+ * Submit the batch being filled by the application thread to the worker and
+ * switch to the next batch, waiting for the worker to release it if every
+ * batch is in flight.
+ */
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (!glthread || glthread->batch->used == 0)
+      return;
+
+   mtx_lock(&glthread->mutex);
+   glthread->submitted++;
+   cnd_signal(&glthread->new_work);
+
+   while (glthread->submitted - glthread->completed >= MARSHAL_MAX_BATCHES)
+      cnd_wait(&glthread->work_done, &glthread->mutex);
+   mtx_unlock(&glthread->mutex);
+
+   glthread->batch =
+      &glthread->batches[glthread->submitted % MARSHAL_MAX_BATCHES];
+   assert(glthread->batch->used == 0);
+}
+
+/**
+ * Wait for the worker thread to execute every marshalled command.
+ *
+ * This is called before executing a command synchronously on the
+ * application thread, and before anything outside of GL (SwapBuffers,
+ * MakeCurrent, ...) looks at the context state.  Calling it on the worker
+ * thread itself is a no-op.
+ */
+void
+_mesa_glthread_finish(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (!glthread || _mesa_glthread_is_worker_thread(ctx))
+      return;
+
+   _mesa_glthread_flush_batch(ctx);
+
+   mtx_lock(&glthread->mutex);
+   while (glthread->completed != glthread->submitted)
+      cnd_wait(&glthread->work_done, &glthread->mutex);
+   mtx_unlock(&glthread->mutex);
+}
+
+bool
+_mesa_glthread_is_worker_thread(const struct gl_context *ctx)
+{
+   return ctx->GLThread && thrd_equal(thrd_current(), ctx->GLThread->thread);
+}
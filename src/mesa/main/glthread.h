@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2012 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _GLTHREAD_H
+#define _GLTHREAD_H
+
+#include "main/mtypes.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "c11/threads.h"
+
+/**
+ * Size of one batch of marshalled commands.  Individual commands are always
+ * much smaller than this; a command that doesn't fit in the remaining space
+ * of the current batch causes the batch to be submitted.
+ */
+#define MARSHAL_MAX_CMD_SIZE (8 * 1024)
+
+/**
+ * Number of batches that can be in flight at once.  When all of them are
+ * queued or executing, the application thread waits for the worker to
+ * release the oldest one, which bounds both memory use and latency.
+ */
+#define MARSHAL_MAX_BATCHES 4
+
+struct glthread_batch
+{
+   /** Number of bytes of \c buffer that contain commands. */
+   size_t used;
+
+   /** Marshalled commands, aligned so that any GL type can be stored. */
+   uint64_t buffer[MARSHAL_MAX_CMD_SIZE / 8];
+};
+
+struct glthread_state
+{
+   /** The worker thread that unmarshals and executes the commands. */
+   thrd_t thread;
+
+   /** Protects \c submitted, \c completed and \c shutdown. */
+   mtx_t mutex;
+
+   /** Signalled when a batch is submitted, or on shutdown. */
+   cnd_t new_work;
+
+   /** Signalled whenever the worker finishes executing a batch. */
+   cnd_t work_done;
+
+   /** Set when the worker thread should exit. */
+   bool shutdown;
+
+   /**
+    * Batches are used round-robin: the n-th batch lives in
+    * batches[n % MARSHAL_MAX_BATCHES].  Every batch numbered from
+    * \c completed up to, but not including, \c submitted is owned by the
+    * worker thread; batch number \c submitted is being filled by the
+    * application thread.
+    */
+   struct glthread_batch batches[MARSHAL_MAX_BATCHES];
+   unsigned submitted;
+   unsigned completed;
+
+   /** Batch currently being filled by the application thread. */
+   struct glthread_batch *batch;
+};
+
+void _mesa_glthread_init(struct gl_context *ctx);
+void _mesa_glthread_destroy(struct gl_context *ctx);
+
+void _mesa_glthread_flush_batch(struct gl_context *ctx);
+void _mesa_glthread_finish(struct gl_context *ctx);
+
+bool _mesa_glthread_is_worker_thread(const struct gl_context *ctx);
+
+#endif /* _GLTHREAD_H*/
@@ -38,31 +38,47 @@
 #include "imports.h"
 #include "hash.h"
 #include "util/hash_table.h"
+#include "util/u_atomic.h"
 
 /**
- * Magic GLuint object name that gets stored outside of the struct hash_table.
+ * Magic GLuint object name used as the deleted-key marker of the struct
+ * hash_table.
  *
  * The hash table needs a particular pointer to be the marker for a key that
  * was deleted from the table, along with NULL for the "never allocated in the
  * table" marker.  Legacy GL allows any GLuint to be used as a GL object name,
- * and we use a 1:1 mapping from GLuints to key pointers, so we need to be
- * able to track a GLuint that happens to match the deleted key outside of
- * struct hash_table.  We tell the hash table to use "1" as the deleted key
- * value, so that we test the deleted-key-in-the-table path as best we can.
+ * and we use a 1:1 mapping from GLuints to key pointers.  Key 1 is below
+ * DIRECT_MAX_KEY, so it is always stored in the direct array and never
+ * reaches the hash table.
  */
 #define DELETED_KEY_VALUE 1
 
+/** @{
+ * Keys below DIRECT_MAX_KEY, which is where glGen*() names end up in all
+ * but the largest applications, are stored in a two-level array indexed by
+ * the key instead of in the hash table.  The chunks of the array are
+ * allocated on first use and only freed with the table, so lookups in it
+ * don't need the mutex.  Inserts and removes still take the mutex, and
+ * publish the new value with an atomic compare-and-swap so that a reader
+ * never sees a chunk or object before its contents.
+ */
+#define DIRECT_CHUNK_BITS 10
+#define DIRECT_CHUNK_SIZE (1 << DIRECT_CHUNK_BITS)
+#define DIRECT_NUM_CHUNKS 64
+#define DIRECT_MAX_KEY (DIRECT_CHUNK_SIZE * DIRECT_NUM_CHUNKS)
+/** @} */
+
 /**
  * The hash table data structure.  
  */
 struct _mesa_HashTable {
-   struct hash_table *ht;
+   struct hash_table *ht;                /**< keys >= DIRECT_MAX_KEY */
+   /** Chunks of DIRECT_CHUNK_SIZE values for keys < DIRECT_MAX_KEY */
+   volatile uintptr_t Direct[DIRECT_NUM_CHUNKS];
    GLuint MaxKey;                        /**< highest key inserted so far */
    mtx_t Mutex;                /**< mutual exclusion lock */
    mtx_t WalkMutex;            /**< for _mesa_HashWalk() */
    GLboolean InDeleteAll;                /**< Debug check */
-   /** Value that would be in the table for DELETED_KEY_VALUE. */
-   void *deleted_key_data;
 };
 
 /** @{
@@ -109,6 +125,62 @@ uint_key(GLuint id)
 }
 /** @} */
 
+
+/**
+ * Return the slot of \p key in the direct array, or NULL if its chunk
+ * hasn't been allocated yet.  Doesn't need the mutex.
+ */
+static inline volatile uintptr_t *
+direct_slot(const struct _mesa_HashTable *table, GLuint key)
+{
+   volatile uintptr_t *chunk = (volatile uintptr_t *)
+      p_atomic_read(&table->Direct[key >> DIRECT_CHUNK_BITS]);
+
+   if (!chunk)
+      return NULL;
+
+   return &chunk[key & (DIRECT_CHUNK_SIZE - 1)];
+}
+
+
+/**
+ * Return one past the highest key that can be in the direct array.
+ */
+static inline GLuint
+direct_end(const struct _mesa_HashTable *table)
+{
+   return table->MaxKey < DIRECT_MAX_KEY ? table->MaxKey + 1 : DIRECT_MAX_KEY;
+}
+
+
+/**
+ * Store \p data in the direct array slot of \p key, allocating its chunk
+ * if needed.  The mutex must be held.
+ */
+static void
+direct_store(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+   const GLuint c = key >> DIRECT_CHUNK_BITS;
+   volatile uintptr_t *slot;
+
+   if (!table->Direct[c]) {
+      uintptr_t *chunk;
+
+      if (!data)
+         return;
+
+      chunk = calloc(DIRECT_CHUNK_SIZE, sizeof(uintptr_t));
+      if (!chunk) {
+         _mesa_error_no_memory(__func__);
+         return;
+      }
+      p_atomic_cmpxchg(&table->Direct[c], (uintptr_t) 0, (uintptr_t) chunk);
+   }
+
+   slot = direct_slot(table, key);
+   p_atomic_cmpxchg(slot, *slot, (uintptr_t) data);
+}
+
 /**
  * Create a new hash table.
  * 
@@ -152,14 +224,19 @@ _mesa_NewHashTable(void)
 void
 _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 {
+   GLuint i;
+
    assert(table);
 
-   if (_mesa_hash_table_next_entry(table->ht, NULL) != NULL) {
+   if (_mesa_HashNumEntries(table) != 0) {
       _mesa_problem(NULL, "In _mesa_DeleteHashTable, found non-freed data");
    }
 
    _mesa_hash_table_destroy(table->ht, NULL);
 
+   for (i = 0; i < DIRECT_NUM_CHUNKS; i++)
+      free((void *) table->Direct[i]);
+
    mtx_destroy(&table->Mutex);
    mtx_destroy(&table->WalkMutex);
    free(table);
@@ -179,8 +256,10 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
    assert(table);
    assert(key);
 
-   if (key == DELETED_KEY_VALUE)
-      return table->deleted_key_data;
+   if (key < DIRECT_MAX_KEY) {
+      volatile uintptr_t *slot = direct_slot(table, key);
+      return slot ? (void *) p_atomic_read(slot) : NULL;
+   }
 
    entry = _mesa_hash_table_search(table->ht, uint_key(key));
    if (!entry)
@@ -192,6 +271,9 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
 
 /**
  * Lookup an entry in the hash table.
+ *
+ * Keys in the direct array are looked up without taking the mutex, so
+ * concurrent binds of shared objects from several contexts don't contend.
  * 
  * \param table the hash table.
  * \param key the key.
@@ -203,6 +285,8 @@ _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
    void *res;
    assert(table);
+   if (key < DIRECT_MAX_KEY)
+      return _mesa_HashLookup_unlocked(table, key);
    mtx_lock(&table->Mutex);
    res = _mesa_HashLookup_unlocked(table, key);
    mtx_unlock(&table->Mutex);
@@ -270,8 +354,8 @@ _mesa_HashInsert_unlocked(struct _mesa_HashTable *table, GLuint key, void *data)
    if (key > table->MaxKey)
       table->MaxKey = key;
 
-   if (key == DELETED_KEY_VALUE) {
-      table->deleted_key_data = data;
+   if (key < DIRECT_MAX_KEY) {
+      direct_store(table, key, data);
    } else {
       entry = _mesa_hash_table_search_pre_hashed(table->ht, hash, uint_key(key));
       if (entry) {
@@ -344,8 +428,8 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
    }
 
    mtx_lock(&table->Mutex);
-   if (key == DELETED_KEY_VALUE) {
-      table->deleted_key_data = NULL;
+   if (key < DIRECT_MAX_KEY) {
+      direct_store(table, key, NULL);
    } else {
       entry = _mesa_hash_table_search(table->ht, uint_key(key));
       _mesa_hash_table_remove(table->ht, entry);
@@ -370,19 +454,23 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
                     void *userData)
 {
    struct hash_entry *entry;
+   GLuint key;
 
    assert(table);
    assert(callback);
    mtx_lock(&table->Mutex);
    table->InDeleteAll = GL_TRUE;
+   for (key = 1; key < direct_end(table); key++) {
+      void *data = _mesa_HashLookup_unlocked(table, key);
+      if (data) {
+         callback(key, data, userData);
+         direct_store(table, key, NULL);
+      }
+   }
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
       _mesa_hash_table_remove(table->ht, entry);
    }
-   if (table->deleted_key_data) {
-      callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
-      table->deleted_key_data = NULL;
-   }
    table->InDeleteAll = GL_FALSE;
    mtx_unlock(&table->Mutex);
 }
@@ -408,15 +496,19 @@ _mesa_HashWalk(const struct _mesa_HashTable *table,
    /* cast-away const */
    struct _mesa_HashTable *table2 = (struct _mesa_HashTable *) table;
    struct hash_entry *entry;
+   GLuint key;
 
    assert(table);
    assert(callback);
    mtx_lock(&table2->WalkMutex);
+   for (key = 1; key < direct_end(table); key++) {
+      void *data = _mesa_HashLookup_unlocked(table2, key);
+      if (data)
+         callback(key, data, userData);
+   }
    hash_table_foreach(table->ht, entry) {
       callback((uintptr_t)entry->key, entry->data, userData);
    }
-   if (table->deleted_key_data)
-      callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
    mtx_unlock(&table2->WalkMutex);
 }
 
@@ -434,8 +526,6 @@ debug_print_entry(GLuint key, void *data, void *userData)
 void
 _mesa_HashPrint(const struct _mesa_HashTable *table)
 {
-   if (table->deleted_key_data)
-      debug_print_entry(DELETED_KEY_VALUE, table->deleted_key_data, NULL);
    _mesa_HashWalk(table, debug_print_entry, NULL);
 }
 
@@ -498,9 +588,12 @@ _mesa_HashNumEntries(const struct _mesa_HashTable *table)
 {
    struct hash_entry *entry;
    GLuint count = 0;
+   GLuint key;
 
-   if (table->deleted_key_data)
-      count++;
+   for (key = 1; key < direct_end(table); key++) {
+      if (_mesa_HashLookup_unlocked((struct _mesa_HashTable *) table, key))
+         count++;
+   }
 
    hash_table_foreach(table->ht, entry)
       count++;
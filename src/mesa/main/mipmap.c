@@ -40,6 +40,11 @@
 #include "util/half_float.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
 #include "../../gallium/auxiliary/util/u_format_r11g11b10f.h"
+#include "parallel_rows.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 
@@ -138,6 +143,125 @@ bytes_per_pixel(GLenum datatype, GLuint comps)
 /*@}*/
 
 
+#ifdef __SSE2__
+/**
+ * Sums 2x2 blocks of RGBA8 pixels: \p a and \p b hold four pixels of two
+ * source rows, the result the sums for two dest pixels in 16-bit lanes.
+ */
+static inline __m128i
+sum_rgba8_blocks(__m128i a, __m128i b)
+{
+   const __m128i zero = _mm_setzero_si128();
+   const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero),
+                                    _mm_unpacklo_epi8(b, zero));
+   const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero),
+                                    _mm_unpackhi_epi8(b, zero));
+
+   return _mm_add_epi16(_mm_unpacklo_epi64(lo, hi),
+                        _mm_unpackhi_epi64(lo, hi));
+}
+
+/**
+ * Sums 2x1 blocks of 8-bit texels: \p a and \p b hold 16 texels of two
+ * source rows, the result the sums for 8 dest texels in 16-bit lanes.
+ */
+static inline __m128i
+sum_r8_blocks(__m128i a, __m128i b)
+{
+   const __m128i mask = _mm_set1_epi16(0xff);
+
+   return _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, mask),
+                                      _mm_srli_epi16(a, 8)),
+                        _mm_add_epi16(_mm_and_si128(b, mask),
+                                      _mm_srli_epi16(b, 8)));
+}
+
+/**
+ * The SSE2 version of do_row() for the common formats, when the width is
+ * halved.  The results are the same as do_row()'s, bit for bit; the floats
+ * are even summed in the same order.
+ *
+ * \return the number of dest pixels done; do_row() does the rest
+ */
+static GLint
+do_row_sse2(GLenum datatype, GLuint comps,
+            const GLvoid *srcRowA, const GLvoid *srcRowB,
+            GLint dstWidth, GLvoid *dstRow)
+{
+   GLint i = 0;
+
+   if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
+      const GLubyte *rowA = (const GLubyte *) srcRowA;
+      const GLubyte *rowB = (const GLubyte *) srcRowB;
+      GLubyte *dst = (GLubyte *) dstRow;
+
+      for (; i + 4 <= dstWidth; i += 4) {
+         const __m128i a0 = _mm_loadu_si128((const __m128i *) (rowA + i * 8));
+         const __m128i a1 = _mm_loadu_si128((const __m128i *) (rowA + i * 8 + 16));
+         const __m128i b0 = _mm_loadu_si128((const __m128i *) (rowB + i * 8));
+         const __m128i b1 = _mm_loadu_si128((const __m128i *) (rowB + i * 8 + 16));
+         const __m128i lo = _mm_srli_epi16(sum_rgba8_blocks(a0, b0), 2);
+         const __m128i hi = _mm_srli_epi16(sum_rgba8_blocks(a1, b1), 2);
+
+         _mm_storeu_si128((__m128i *) (dst + i * 4), _mm_packus_epi16(lo, hi));
+      }
+   }
+   else if (datatype == GL_UNSIGNED_BYTE && comps == 1) {
+      const GLubyte *rowA = (const GLubyte *) srcRowA;
+      const GLubyte *rowB = (const GLubyte *) srcRowB;
+      GLubyte *dst = (GLubyte *) dstRow;
+
+      for (; i + 16 <= dstWidth; i += 16) {
+         const __m128i a0 = _mm_loadu_si128((const __m128i *) (rowA + i * 2));
+         const __m128i a1 = _mm_loadu_si128((const __m128i *) (rowA + i * 2 + 16));
+         const __m128i b0 = _mm_loadu_si128((const __m128i *) (rowB + i * 2));
+         const __m128i b1 = _mm_loadu_si128((const __m128i *) (rowB + i * 2 + 16));
+         const __m128i lo = _mm_srli_epi16(sum_r8_blocks(a0, b0), 2);
+         const __m128i hi = _mm_srli_epi16(sum_r8_blocks(a1, b1), 2);
+
+         _mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(lo, hi));
+      }
+   }
+   else if (datatype == GL_FLOAT && comps == 4) {
+      const GLfloat *rowA = (const GLfloat *) srcRowA;
+      const GLfloat *rowB = (const GLfloat *) srcRowB;
+      GLfloat *dst = (GLfloat *) dstRow;
+      const __m128 quarter = _mm_set1_ps(0.25F);
+
+      for (; i < dstWidth; i++) {
+         __m128 sum = _mm_add_ps(_mm_loadu_ps(rowA + i * 8),
+                                 _mm_loadu_ps(rowA + i * 8 + 4));
+         sum = _mm_add_ps(sum, _mm_loadu_ps(rowB + i * 8));
+         sum = _mm_add_ps(sum, _mm_loadu_ps(rowB + i * 8 + 4));
+         _mm_storeu_ps(dst + i * 4, _mm_mul_ps(sum, quarter));
+      }
+   }
+   else if (datatype == GL_FLOAT && comps == 1) {
+      const GLfloat *rowA = (const GLfloat *) srcRowA;
+      const GLfloat *rowB = (const GLfloat *) srcRowB;
+      GLfloat *dst = (GLfloat *) dstRow;
+      const __m128 quarter = _mm_set1_ps(0.25F);
+
+      for (; i + 4 <= dstWidth; i += 4) {
+         const __m128 a0 = _mm_loadu_ps(rowA + i * 2);
+         const __m128 a1 = _mm_loadu_ps(rowA + i * 2 + 4);
+         const __m128 b0 = _mm_loadu_ps(rowB + i * 2);
+         const __m128 b1 = _mm_loadu_ps(rowB + i * 2 + 4);
+         __m128 sum;
+
+         sum = _mm_add_ps(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0)),
+                          _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1)));
+         sum = _mm_add_ps(sum, _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(2, 0, 2, 0)));
+         sum = _mm_add_ps(sum, _mm_shuffle_ps(b0, b1, _MM_SHUFFLE(3, 1, 3, 1)));
+         _mm_storeu_ps(dst + i, _mm_mul_ps(sum, quarter));
+      }
+   }
+
+   return i;
+}
+#endif
+
+
 /**
  * Average together two rows of a source image to produce a single new
  * row in the dest image.  It's legal for the two source rows to point
@@ -161,6 +285,24 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
    assert(srcWidth == dstWidth || srcWidth == 2 * dstWidth);
    */
 
+#ifdef __SSE2__
+   if (colStride == 2) {
+      const GLint done = do_row_sse2(datatype, comps, srcRowA, srcRowB,
+                                     dstWidth, dstRow);
+      if (done > 0) {
+         const GLint bpt = bytes_per_pixel(datatype, comps);
+
+         if (done < dstWidth) {
+            do_row(datatype, comps, srcWidth - 2 * done,
+                   (const GLubyte *) srcRowA + 2 * done * bpt,
+                   (const GLubyte *) srcRowB + 2 * done * bpt,
+                   dstWidth - done, (GLubyte *) dstRow + done * bpt);
+         }
+         return;
+      }
+   }
+#endif
+
    if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
       GLuint i, j, k;
       const GLubyte(*rowA)[4] = (const GLubyte(*)[4]) srcRowA;
@@ -1406,6 +1548,90 @@ do_row_3D(GLenum datatype, GLuint comps, GLint srcWidth,
 }
 
 
+/* Levels at least this large are split across threads, with at least this
+ * much of the dest image per thread.
+ */
+#define THREADED_MIN_BYTES (256 * 1024)
+
+/**
+ * The rows of a 2D level, or of all the slices of an array or 3D level,
+ * without the border.  Dest row \c r is row <tt>r % dstHeightNB</tt> of
+ * slice <tt>r / dstHeightNB</tt>.  No two dest rows share any bytes, so
+ * ranges of them can be done by different threads.
+ */
+struct mipmap_rows {
+   GLenum datatype;
+   GLuint comps;
+   GLint srcWidthNB, dstWidthNB, dstHeightNB;
+
+   const GLubyte **srcData;
+   GLubyte **dstData;
+   /* Offset of the first row in each slice, past the border. */
+   GLint srcOffset, dstOffset;
+   /* Offset from the first to the second source row of a dest row, and
+    * between the source rows of consecutive dest rows.
+    */
+   GLint srcRowOffset, srcRowStep;
+   GLint dstRowStride;
+
+   /* 3D only: which source slices make up dest slice i, as in
+    * make_3d_mipmap().
+    */
+   GLboolean is3D;
+   GLint border, srcImageOffset;
+};
+
+static void
+mipmap_rows_run(void *data, unsigned first, unsigned end)
+{
+   const struct mipmap_rows *m = data;
+   GLint r;
+
+   for (r = first; r < (GLint) end; r++) {
+      const GLint slice = r / m->dstHeightNB;
+      const GLint row = r % m->dstHeightNB;
+      GLubyte *dst = m->dstData[slice + (m->is3D ? m->border : 0)] +
+                     m->dstOffset + row * m->dstRowStride;
+
+      if (m->is3D) {
+         const GLubyte *srcA = m->srcData[slice * 2 + m->border] +
+                               m->srcOffset + row * m->srcRowStep;
+         const GLubyte *srcB = m->srcData[slice * 2 + m->srcImageOffset +
+                                          m->border] +
+                               m->srcOffset + row * m->srcRowStep;
+
+         do_row_3D(m->datatype, m->comps, m->srcWidthNB,
+                   srcA, srcA + m->srcRowOffset,
+                   srcB, srcB + m->srcRowOffset,
+                   m->dstWidthNB, dst);
+      }
+      else {
+         const GLubyte *src = m->srcData[slice] +
+                              m->srcOffset + row * m->srcRowStep;
+
+         do_row(m->datatype, m->comps, m->srcWidthNB,
+                src, src + m->srcRowOffset,
+                m->dstWidthNB, dst);
+      }
+   }
+}
+
+/**
+ * Do the \p numSlices slices of rows described by \p rows, split into bands
+ * on several threads if the level is large.
+ */
+static void
+mipmap_rows_split(struct mipmap_rows *rows, GLint numSlices)
+{
+   const GLint rowBytes = rows->dstWidthNB *
+                          bytes_per_pixel(rows->datatype, rows->comps);
+
+   _mesa_parallel_rows(mipmap_rows_run, rows,
+                       rows->dstHeightNB * numSlices, 1,
+                       DIV_ROUND_UP(THREADED_MIN_BYTES, MAX2(rowBytes, 1)));
+}
+
+
 /*
  * These functions generate a 1/2-size mipmap image from a source image.
  * Texture borders are handled by copying or averaging the source image's
@@ -1442,43 +1668,66 @@ make_1d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+/**
+ * Generate the rows of \p numSlices 2D images, without their borders.
+ * Large levels are split across threads.
+ */
 static void
-make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
-               GLint srcWidth, GLint srcHeight,
-	       const GLubyte *srcPtr, GLint srcRowStride,
-               GLint dstWidth, GLint dstHeight,
-	       GLubyte *dstPtr, GLint dstRowStride)
+make_2d_mipmap_rows(GLenum datatype, GLuint comps, GLint border,
+                    GLint srcWidth, GLint srcHeight,
+                    const GLubyte **srcData, GLint srcRowStride,
+                    GLint dstWidth, GLint dstHeight,
+                    GLubyte **dstData, GLint dstRowStride,
+                    GLint numSlices)
 {
    const GLint bpt = bytes_per_pixel(datatype, comps);
-   const GLint srcWidthNB = srcWidth - 2 * border;  /* sizes w/out border */
-   const GLint dstWidthNB = dstWidth - 2 * border;
-   const GLint dstHeightNB = dstHeight - 2 * border;
-   const GLubyte *srcA, *srcB;
-   GLubyte *dst;
-   GLint row, srcRowStep;
+   struct mipmap_rows rows;
+
+   memset(&rows, 0, sizeof(rows));
+   rows.datatype = datatype;
+   rows.comps = comps;
+   rows.srcWidthNB = srcWidth - 2 * border;  /* sizes w/out border */
+   rows.dstWidthNB = dstWidth - 2 * border;
+   rows.dstHeightNB = dstHeight - 2 * border;
+   rows.srcData = srcData;
+   rows.dstData = dstData;
+   rows.dstRowStride = dstRowStride;
+
+   /* Compute src and dst offsets, skipping any border */
+   rows.srcOffset = border * ((srcWidth + 1) * bpt);
+   rows.dstOffset = border * ((dstWidth + 1) * bpt);
 
-   /* Compute src and dst pointers, skipping any border */
-   srcA = srcPtr + border * ((srcWidth + 1) * bpt);
    if (srcHeight > 1 && srcHeight > dstHeight) {
       /* sample from two source rows */
-      srcB = srcA + srcRowStride;
-      srcRowStep = 2;
+      rows.srcRowOffset = srcRowStride;
+      rows.srcRowStep = 2 * srcRowStride;
    }
    else {
       /* sample from one source row */
-      srcB = srcA;
-      srcRowStep = 1;
+      rows.srcRowOffset = 0;
+      rows.srcRowStep = srcRowStride;
    }
 
-   dst = dstPtr + border * ((dstWidth + 1) * bpt);
+   if (rows.dstHeightNB > 0)
+      mipmap_rows_split(&rows, numSlices);
+}
 
-   for (row = 0; row < dstHeightNB; row++) {
-      do_row(datatype, comps, srcWidthNB, srcA, srcB,
-             dstWidthNB, dst);
-      srcA += srcRowStep * srcRowStride;
-      srcB += srcRowStep * srcRowStride;
-      dst += dstRowStride;
-   }
+
+/**
+ * Fill in the border of a 2D mipmap image made by make_2d_mipmap_rows().
+ */
+static void
+make_2d_mipmap_border(GLenum datatype, GLuint comps, GLint border,
+                      GLint srcWidth, GLint srcHeight,
+                      const GLubyte *srcPtr, GLint srcRowStride,
+                      GLint dstWidth, GLint dstHeight,
+                      GLubyte *dstPtr, GLint dstRowStride)
+{
+   const GLint bpt = bytes_per_pixel(datatype, comps);
+   const GLint srcWidthNB = srcWidth - 2 * border;  /* sizes w/out border */
+   const GLint dstWidthNB = dstWidth - 2 * border;
+   const GLint dstHeightNB = dstHeight - 2 * border;
+   GLint row;
 
    /* This is ugly but probably won't be used much */
    if (border > 0) {
@@ -1534,6 +1783,22 @@ make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
 }
 
 
+static void
+make_2d_mipmap(GLenum datatype, GLuint comps, GLint border,
+               GLint srcWidth, GLint srcHeight,
+	       const GLubyte *srcPtr, GLint srcRowStride,
+               GLint dstWidth, GLint dstHeight,
+	       GLubyte *dstPtr, GLint dstRowStride)
+{
+   make_2d_mipmap_rows(datatype, comps, border,
+                       srcWidth, srcHeight, &srcPtr, srcRowStride,
+                       dstWidth, dstHeight, &dstPtr, dstRowStride, 1);
+   make_2d_mipmap_border(datatype, comps, border,
+                         srcWidth, srcHeight, srcPtr, srcRowStride,
+                         dstWidth, dstHeight, dstPtr, dstRowStride);
+}
+
+
 static void
 make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
                GLint srcWidth, GLint srcHeight, GLint srcDepth,
@@ -1547,7 +1812,7 @@ make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
    const GLint dstWidthNB = dstWidth - 2 * border;
    const GLint dstHeightNB = dstHeight - 2 * border;
    const GLint dstDepthNB = dstDepth - 2 * border;
-   GLint img, row;
+   GLint img;
    GLint bytesPerSrcImage, bytesPerDstImage;
    GLint srcImageOffset, srcRowOffset;
 
@@ -1575,38 +1840,29 @@ make_3d_mipmap(GLenum datatype, GLuint comps, GLint border,
           srcWidth, srcHeight, srcDepth, dstWidth, dstHeight, dstDepth);
    */
 
-   for (img = 0; img < dstDepthNB; img++) {
-      /* first source image pointer, skipping border */
-      const GLubyte *imgSrcA = srcPtr[img * 2 + border]
-         + srcRowStride * border + bpt * border;
-      /* second source image pointer, skipping border */
-      const GLubyte *imgSrcB = srcPtr[img * 2 + srcImageOffset + border]
-         + srcRowStride * border + bpt * border;
+   /* The images are split into rows across threads, like 2D levels. */
+   if (dstHeightNB > 0 && dstDepthNB > 0) {
+      struct mipmap_rows rows;
 
-      /* address of the dest image, skipping border */
-      GLubyte *imgDst = dstPtr[img + border]
-         + dstRowStride * border + bpt * border;
+      memset(&rows, 0, sizeof(rows));
+      rows.datatype = datatype;
+      rows.comps = comps;
+      rows.srcWidthNB = srcWidthNB;
+      rows.dstWidthNB = dstWidthNB;
+      rows.dstHeightNB = dstHeightNB;
+      rows.srcData = srcPtr;
+      rows.dstData = dstPtr;
+      /* source and dest image pointers, skipping border */
+      rows.srcOffset = srcRowStride * border + bpt * border;
+      rows.dstOffset = dstRowStride * border + bpt * border;
+      rows.srcRowOffset = srcRowOffset;
+      rows.srcRowStep = srcRowStride + srcRowOffset;
+      rows.dstRowStride = dstRowStride;
+      rows.is3D = GL_TRUE;
+      rows.border = border;
+      rows.srcImageOffset = srcImageOffset;
 
-      /* setup the four source row pointers and the dest row pointer */
-      const GLubyte *srcImgARowA = imgSrcA;
-      const GLubyte *srcImgARowB = imgSrcA + srcRowOffset;
-      const GLubyte *srcImgBRowA = imgSrcB;
-      const GLubyte *srcImgBRowB = imgSrcB + srcRowOffset;
-      GLubyte *dstImgRow = imgDst;
-
-      for (row = 0; row < dstHeightNB; row++) {
-         do_row_3D(datatype, comps, srcWidthNB, 
-                   srcImgARowA, srcImgARowB,
-                   srcImgBRowA, srcImgBRowB,
-                   dstWidthNB, dstImgRow);
-
-         /* advance to next rows */
-         srcImgARowA += srcRowStride + srcRowOffset;
-         srcImgARowB += srcRowStride + srcRowOffset;
-         srcImgBRowA += srcRowStride + srcRowOffset;
-         srcImgBRowB += srcRowStride + srcRowOffset;
-         dstImgRow += dstRowStride;
-      }
+      mipmap_rows_split(&rows, dstDepthNB);
    }
 
 
@@ -1743,10 +1999,15 @@ _mesa_generate_mipmap_level(GLenum target,
       break;
    case GL_TEXTURE_2D_ARRAY_EXT:
    case GL_TEXTURE_CUBE_MAP_ARRAY:
+      /* All the layers are split across threads at once. */
+      make_2d_mipmap_rows(datatype, comps, border,
+                          srcWidth, srcHeight, srcData, srcRowStride,
+                          dstWidth, dstHeight, dstData, dstRowStride,
+                          dstDepth);
       for (i = 0; i < dstDepth; i++) {
-	 make_2d_mipmap(datatype, comps, border,
-			srcWidth, srcHeight, srcData[i], srcRowStride,
-			dstWidth, dstHeight, dstData[i], dstRowStride);
+	 make_2d_mipmap_border(datatype, comps, border,
+			       srcWidth, srcHeight, srcData[i], srcRowStride,
+			       dstWidth, dstHeight, dstData[i], dstRowStride);
       }
       break;
    case GL_TEXTURE_RECTANGLE_NV:
@@ -72,6 +72,7 @@ typedef GLuint64 GLbitfield64;
  */
 /*@{*/
 struct _mesa_HashTable;
+struct blob;
 struct gl_attrib_node;
 struct gl_list_extensions;
 struct gl_meta_state;
@@ -81,11 +82,13 @@ struct gl_debug_state;
 struct gl_context;
 struct st_context;
 struct gl_uniform_storage;
+struct glthread_state;
 struct prog_instruction;
 struct gl_program_parameter_list;
 struct set;
 struct set_entry;
 struct vbo_context;
+union gl_constant_value;
 /*@}*/
 
 
@@ -595,6 +598,7 @@ struct gl_hint_attrib
    GLenum TextureCompression;   /**< GL_ARB_texture_compression */
    GLenum GenerateMipmap;       /**< GL_SGIS_generate_mipmap */
    GLenum FragmentShaderDerivative; /**< GL_ARB_fragment_shader */
+   GLuint MaxShaderCompilerThreads; /**< GL_ARB_parallel_shader_compile */
 };
 
 
@@ -913,6 +917,9 @@ struct gl_texture_image
    /** GL_ARB_texture_multisample */
    GLuint NumSamples;            /**< Sample count, or 0 for non-multisample */
    GLboolean FixedSampleLocations; /**< Same sample locations for all pixels? */
+
+   /** Bumped when the image is respecified, see _mesa_update_fbo_texture() */
+   GLuint Generation;
 };
 
 
@@ -990,6 +997,7 @@ struct gl_texture_object
    GLboolean GenerateMipmap;   /**< GL_SGIS_generate_mipmap */
    GLboolean _BaseComplete;    /**< Is the base texture level valid? */
    GLboolean _MipmapComplete;  /**< Is the whole mipmap valid? */
+   GLboolean _CompletenessValid; /**< Are the two flags above up to date? */
    GLboolean _IsIntegerFormat; /**< Does the texture store integer values? */
    GLboolean _RenderToTexture; /**< Any rendering to this texture? */
    GLboolean Purgeable;        /**< Is the buffer purgeable under memory
@@ -2223,6 +2231,7 @@ struct gl_shader
 
    GLuint SourceChecksum;       /**< for debug/logging purposes */
    const GLchar *Source;  /**< Source code string */
+   GLuint CompileSerial;  /**< Different for every glCompileShader */
 
    struct gl_program *Program;  /**< Post-compile assembly code */
    GLchar *InfoLog;
@@ -2484,6 +2493,9 @@ struct gl_uniform_block
     */
    GLuint Binding;
 
+   /** Binding given to the block by the linker. */
+   GLuint DefaultBinding;
+
    /**
     * Minimum size (in bytes) of a buffer object to back this uniform buffer
     * (GL_UNIFORM_BLOCK_DATA_SIZE).
@@ -2560,6 +2572,12 @@ struct gl_shader_program
    GLuint NumShaders;          /**< number of attached shaders */
    struct gl_shader **Shaders; /**< List of attached the shaders */
 
+   /**
+    * Everything the last link of this program depended on, or NULL if it
+    * was never linked.  See _mesa_glsl_link_shader().
+    */
+   struct blob *LinkInputs;
+
    /**
     * User-defined attribute bindings
     *
@@ -2683,6 +2701,14 @@ struct gl_shader_program
    unsigned NumHiddenUniforms;
    struct gl_uniform_storage *UniformStorage;
 
+   /**
+    * Backing store of all the UniformStorage entries, and its values right
+    * after linking.
+    */
+   unsigned NumUniformDataSlots;
+   union gl_constant_value *UniformDataSlots;
+   union gl_constant_value *UniformDataDefaults;
+
    /**
     * Mapping from GL uniform locations returned by \c glUniformLocation to
     * UniformStorage entries. Arrays will have multiple contiguous slots
@@ -2876,6 +2902,14 @@ struct gl_shader_compiler_options
    GLuint MaxIfDepth;               /**< Maximum nested IF blocks */
    GLuint MaxUnrollIterations;
 
+   /**
+    * Maximum estimated number of IR instructions a loop may unroll to.  The
+    * estimate leaves out the loop control and any code that becomes
+    * constant once the induction variable is.  0 means five times
+    * MaxUnrollIterations.
+    */
+   GLuint MaxUnrollInstructions;
+
    /**
     * Optimize code for array of structures backends.
     *
@@ -3063,6 +3097,9 @@ struct gl_renderbuffer
     */
    struct gl_texture_image *TexImage;
 
+   /** Bumped when glRenderbufferStorage() reallocates the storage */
+   GLuint Generation;
+
    /** Delete this renderbuffer */
    void (*Delete)(struct gl_context *ctx, struct gl_renderbuffer *rb);
 
@@ -3099,6 +3136,12 @@ struct gl_renderbuffer_attachment
    GLuint Zoffset;      /**< Slice for 3D textures,  or layer for both 1D
                          * and 2D array textures */
    GLboolean Layered;
+
+   /**
+    * Generation of the attached renderbuffer or texture image when the
+    * framebuffer completeness was last tested.
+    */
+   GLuint Generation;
 };
 
 
@@ -3524,6 +3567,9 @@ struct gl_constants
    /** GL_ARB_map_buffer_alignment */
    GLuint MinMapBufferAlignment;
 
+   /** GL_ARB_sparse_buffer */
+   GLuint SparseBufferPageSize;
+
    /**
     * Disable varying packing.  This is out of spec, but potentially useful
     * for older platforms that supports a limited number of texture
@@ -3707,6 +3753,7 @@ struct gl_extensions
    GLboolean ARB_occlusion_query2;
    GLboolean ARB_pipeline_statistics_query;
    GLboolean ARB_point_sprite;
+   GLboolean ARB_query_buffer_object;
    GLboolean ARB_sample_shading;
    GLboolean ARB_seamless_cube_map;
    GLboolean ARB_shader_atomic_counters;
@@ -3723,6 +3770,7 @@ struct gl_extensions
    GLboolean ARB_shading_language_packing;
    GLboolean ARB_shading_language_420pack;
    GLboolean ARB_shadow;
+   GLboolean ARB_sparse_buffer;
    GLboolean ARB_stencil_texturing;
    GLboolean ARB_sync;
    GLboolean ARB_tessellation_shader;
@@ -3989,7 +4037,15 @@ struct gl_dlist_state
        * list.  Used to eliminate some redundant state changes.
        */
       GLenum ShadeModel;
+      GLenum MatrixMode;
    } Current;
+
+   /**
+    * The last matrix operation compiled (block and node range), so that a
+    * directly following one can be folded into it.
+    */
+   union gl_dlist_node *LastMatrixBlock;
+   GLuint LastMatrixPos, LastMatrixEnd;
 };
 
 /** @{
@@ -4212,8 +4268,16 @@ struct gl_context
     * re-set on glXMakeCurrent().
     */
    struct _glapi_table *CurrentDispatch;
+   /**
+    * Dispatch table installed on the application thread while glthread is
+    * marshalling calls to its worker thread.
+    */
+   struct _glapi_table *MarshalExec;
    /*@}*/
 
+   /** State of the glthread worker, or NULL when glthread is not in use. */
+   struct glthread_state *GLThread;
+
    struct gl_config Visual;
    struct gl_framebuffer *DrawBuffer;	/**< buffer for writing */
    struct gl_framebuffer *ReadBuffer;	/**< buffer for reading */
@@ -4348,6 +4412,7 @@ struct gl_context
 
    struct gl_buffer_object *DrawIndirectBuffer; /** < GL_ARB_draw_indirect */
    struct gl_buffer_object *DispatchIndirectBuffer; /** < GL_ARB_compute_shader */
+   struct gl_buffer_object *QueryBuffer; /**< GL_ARB_query_buffer_object */
 
    struct gl_buffer_object *CopyReadBuffer; /**< GL_ARB_copy_buffer */
    struct gl_buffer_object *CopyWriteBuffer; /**< GL_ARB_copy_buffer */
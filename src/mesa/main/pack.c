@@ -54,6 +54,7 @@
 #include "glformats.h"
 #include "format_utils.h"
 #include "format_pack.h"
+#include "format_simd.h"
 
 
 /**
@@ -827,6 +828,16 @@ _mesa_unpack_depth_span( struct gl_context *ctx, GLuint n,
          }
          return;
       }
+#if defined(__SSE2__)
+      if (srcType == GL_FLOAT
+          && dstType == GL_UNSIGNED_SHORT
+          && depthMax == 0xffff
+          && !srcPacking->SwapBytes) {
+         _mesa_float_to_z16_row_sse2((GLushort *) dest,
+                                     (const GLfloat *) source, n);
+         return;
+      }
+#endif
       /* XXX may want to add additional cases here someday */
    }
 
@@ -0,0 +1,113 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file parallel_rows.c
+ *
+ * Threads are started for each job and joined before returning, the way
+ * intel_tiled_memcpy does it.  The jobs are whole texture images, so the
+ * cost of starting a thread is small next to the work it takes over.
+ */
+
+#include <stdbool.h>
+#include "c11/threads.h"
+#include "macros.h"
+#include "parallel_rows.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#define MAX_THREADS 4
+
+struct rows_band {
+   mesa_rows_func func;
+   void *data;
+   unsigned first, end;
+};
+
+static int
+rows_band_run(void *data)
+{
+   const struct rows_band *band = data;
+
+   band->func(band->data, band->first, band->end);
+   return 0;
+}
+
+static unsigned cpu_count = 1;
+
+static void
+init_cpu_count(void)
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+   long count = sysconf(_SC_NPROCESSORS_ONLN);
+   if (count > 0)
+      cpu_count = count;
+#endif
+}
+
+void
+_mesa_parallel_rows(mesa_rows_func func, void *data,
+                    unsigned num_rows, unsigned row_align,
+                    unsigned min_rows)
+{
+   static once_flag once = ONCE_FLAG_INIT;
+   struct rows_band bands[MAX_THREADS];
+   bool started[MAX_THREADS];
+   thrd_t threads[MAX_THREADS];
+   unsigned num_bands, rows_per_band, i;
+
+   call_once(&once, init_cpu_count);
+
+   num_bands = MIN3(cpu_count, MAX_THREADS, num_rows / MAX2(min_rows, 1));
+   if (num_bands <= 1) {
+      func(data, 0, num_rows);
+      return;
+   }
+
+   row_align = MAX2(row_align, 1);
+   rows_per_band = DIV_ROUND_UP(num_rows, num_bands);
+   rows_per_band = DIV_ROUND_UP(rows_per_band, row_align) * row_align;
+
+   for (i = 0; i < num_bands; i++) {
+      bands[i].func = func;
+      bands[i].data = data;
+      bands[i].first = MIN2(i * rows_per_band, num_rows);
+      bands[i].end = MIN2((i + 1) * rows_per_band, num_rows);
+   }
+
+   for (i = 1; i < num_bands; i++) {
+      started[i] = bands[i].first < bands[i].end &&
+                   thrd_create(&threads[i], rows_band_run,
+                               &bands[i]) == thrd_success;
+   }
+
+   rows_band_run(&bands[0]);
+
+   for (i = 1; i < num_bands; i++) {
+      if (started[i])
+         thrd_join(threads[i], NULL);
+      else
+         rows_band_run(&bands[i]);
+   }
+}
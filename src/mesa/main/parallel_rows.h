@@ -0,0 +1,61 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file parallel_rows.h
+ *
+ * Splits CPU-side image work (mipmap generation, texture compression and
+ * decompression) into bands of rows that run on a few threads.
+ */
+
+#ifndef PARALLEL_ROWS_H
+#define PARALLEL_ROWS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Does rows [first, end) of the job described by \p data.  Different
+ * ranges of rows must not write to the same memory.
+ */
+typedef void (*mesa_rows_func)(void *data, unsigned first, unsigned end);
+
+/**
+ * Runs \p func over rows [0, num_rows) of a job, split into bands on up to
+ * four threads.  Each thread gets at least \p min_rows rows, so small jobs
+ * stay on the calling thread.  The calling thread always does the first
+ * band, and does the band of any thread that could not be started.
+ *
+ * \param row_align  bands start on a multiple of this many rows, e.g. 4 to
+ *                   keep the rows of a compressed block together
+ */
+void
+_mesa_parallel_rows(mesa_rows_func func, void *data,
+                    unsigned num_rows, unsigned row_align,
+                    unsigned min_rows);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PARALLEL_ROWS_H */
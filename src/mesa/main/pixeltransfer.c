@@ -31,6 +31,7 @@
 
 
 #include "glheader.h"
+#include "format_utils.h"
 #include "macros.h"
 #include "pixeltransfer.h"
 #include "imports.h"
@@ -159,33 +160,101 @@ _mesa_scale_and_bias_depth_uint(const struct gl_context *ctx, GLuint n,
 /**
  * Apply various pixel transfer operations to an array of RGBA pixels
  * as indicated by the transferOps bitmask
+ *
+ * All the operations are done in a single pass over the pixels.
  */
 void
 _mesa_apply_rgba_transfer_ops(struct gl_context *ctx, GLbitfield transferOps,
                               GLuint n, GLfloat rgba[][4])
 {
-   /* scale & bias */
-   if (transferOps & IMAGE_SCALE_BIAS_BIT) {
-      _mesa_scale_and_bias_rgba(n, rgba,
-                                ctx->Pixel.RedScale, ctx->Pixel.GreenScale,
-                                ctx->Pixel.BlueScale, ctx->Pixel.AlphaScale,
-                                ctx->Pixel.RedBias, ctx->Pixel.GreenBias,
-                                ctx->Pixel.BlueBias, ctx->Pixel.AlphaBias);
-   }
-   /* color map lookup */
+   const GLfloat scale[4] = { ctx->Pixel.RedScale, ctx->Pixel.GreenScale,
+                              ctx->Pixel.BlueScale, ctx->Pixel.AlphaScale };
+   const GLfloat bias[4] = { ctx->Pixel.RedBias, ctx->Pixel.GreenBias,
+                             ctx->Pixel.BlueBias, ctx->Pixel.AlphaBias };
+   GLuint i, c;
+
    if (transferOps & IMAGE_MAP_COLOR_BIT) {
-      _mesa_map_rgba( ctx, n, rgba );
-   }
+      const struct gl_pixelmap *maps[4] = {
+         &ctx->PixelMaps.RtoR, &ctx->PixelMaps.GtoG,
+         &ctx->PixelMaps.BtoB, &ctx->PixelMaps.AtoA
+      };
+      const GLboolean scale_bias = (transferOps & IMAGE_SCALE_BIAS_BIT) != 0;
 
-   /* clamping to [0,1] */
-   if (transferOps & IMAGE_CLAMP_BIT) {
-      GLuint i;
+      /* The map values are clamped to [0,1] by glPixelMap, so there is no
+       * need to clamp the results.
+       */
       for (i = 0; i < n; i++) {
-         rgba[i][RCOMP] = CLAMP(rgba[i][RCOMP], 0.0F, 1.0F);
-         rgba[i][GCOMP] = CLAMP(rgba[i][GCOMP], 0.0F, 1.0F);
-         rgba[i][BCOMP] = CLAMP(rgba[i][BCOMP], 0.0F, 1.0F);
-         rgba[i][ACOMP] = CLAMP(rgba[i][ACOMP], 0.0F, 1.0F);
+         for (c = 0; c < 4; c++) {
+            GLfloat v = rgba[i][c];
+            if (scale_bias)
+               v = v * scale[c] + bias[c];
+            v = CLAMP(v, 0.0F, 1.0F);
+            rgba[i][c] = maps[c]->Map[(int)
+               _mesa_lroundevenf(v * (GLfloat) (maps[c]->Size - 1))];
+         }
+      }
+   }
+   else if (transferOps & IMAGE_SCALE_BIAS_BIT) {
+      /* Straight-line loops over the components which the compiler can
+       * vectorize.
+       */
+      GLfloat *v = &rgba[0][0];
+
+      if (transferOps & IMAGE_CLAMP_BIT) {
+         for (i = 0; i < n * 4; i++) {
+            GLfloat f = v[i] * scale[i % 4] + bias[i % 4];
+            v[i] = CLAMP(f, 0.0F, 1.0F);
+         }
+      }
+      else {
+         for (i = 0; i < n * 4; i++)
+            v[i] = v[i] * scale[i % 4] + bias[i % 4];
+      }
+   }
+   else if (transferOps & IMAGE_CLAMP_BIT) {
+      GLfloat *v = &rgba[0][0];
+
+      for (i = 0; i < n * 4; i++)
+         v[i] = CLAMP(v[i], 0.0F, 1.0F);
+   }
+}
+
+
+/**
+ * Convert a 2D image of RGBA GLubyte pixels to tightly packed RGBA float
+ * and apply the pixel transfer operations in transferOps, in a single pass.
+ *
+ * Each component only takes 256 values, so the operations are first
+ * applied to a table of all of them, which is then used to look up the
+ * results.  This is only worthwhile for more than a few hundred pixels.
+ */
+void
+_mesa_apply_rgba_transfer_ops_ubyte(struct gl_context *ctx,
+                                    GLbitfield transferOps,
+                                    GLuint width, GLuint height,
+                                    const GLubyte *src, GLint srcRowStride,
+                                    GLfloat dst[][4])
+{
+   GLfloat table[256][4];
+   GLuint i, j;
+
+   for (i = 0; i < 256; i++) {
+      table[i][RCOMP] = table[i][GCOMP] =
+      table[i][BCOMP] = table[i][ACOMP] = _mesa_unorm_to_float(i, 8);
+   }
+   _mesa_apply_rgba_transfer_ops(ctx, transferOps, 256, table);
+
+   for (j = 0; j < height; j++) {
+      const GLubyte (*row)[4] = (const GLubyte (*)[4]) src;
+
+      for (i = 0; i < width; i++) {
+         dst[i][RCOMP] = table[row[i][RCOMP]][RCOMP];
+         dst[i][GCOMP] = table[row[i][GCOMP]][GCOMP];
+         dst[i][BCOMP] = table[row[i][BCOMP]][BCOMP];
+         dst[i][ACOMP] = table[row[i][ACOMP]][ACOMP];
       }
+      src += srcRowStride;
+      dst += width;
    }
 }
 
@@ -58,6 +58,13 @@ extern void
 _mesa_apply_rgba_transfer_ops(struct gl_context *ctx, GLbitfield transferOps,
                               GLuint n, GLfloat rgba[][4]);
 
+extern void
+_mesa_apply_rgba_transfer_ops_ubyte(struct gl_context *ctx,
+                                    GLbitfield transferOps,
+                                    GLuint width, GLuint height,
+                                    const GLubyte *src, GLint srcRowStride,
+                                    GLfloat dst[][4]);
+
 extern void
 _mesa_shift_and_offset_ci(const struct gl_context *ctx,
                           GLuint n, GLuint indexes[]);
@@ -756,6 +756,13 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname,
    case GL_PROGRAM_BINARY_LENGTH:
       *params = 0;
       return;
+   case GL_COMPLETION_STATUS_ARB:
+      if (!_mesa_is_desktop_gl(ctx))
+         break;
+
+      /* glLinkProgram doesn't return until the link is done. */
+      *params = GL_TRUE;
+      return;
    case GL_ACTIVE_ATOMIC_COUNTER_BUFFERS:
       if (!ctx->Extensions.ARB_shader_atomic_counters)
          break;
@@ -854,6 +861,13 @@ get_shaderiv(struct gl_context *ctx, GLuint name, GLenum pname, GLint *params)
    case GL_SHADER_SOURCE_LENGTH:
       *params = shader->Source ? strlen((char *) shader->Source) + 1 : 0;
       break;
+   case GL_COMPLETION_STATUS_ARB:
+      /* glCompileShader doesn't return until the compile is done. */
+      if (_mesa_is_desktop_gl(ctx)) {
+         *params = GL_TRUE;
+         break;
+      }
+      /* fallthrough */
    default:
       _mesa_error(ctx, GL_INVALID_ENUM, "glGetShaderiv(pname)");
       return;
@@ -1019,6 +1033,24 @@ compile_shader(struct gl_context *ctx, GLuint shaderObj)
 }
 
 
+/**
+ * Runs the per-stage part of a driver's LinkShader hook, one call of \p func
+ * per range of stages, on several threads unless the application asked for
+ * no compiler threads with glMaxShaderCompilerThreadsARB(0).
+ */
+void
+_mesa_parallel_link_stages(struct gl_context *ctx, mesa_rows_func func,
+                           void *data, unsigned num_stages)
+{
+   if (ctx->Hint.MaxShaderCompilerThreads == 0) {
+      func(data, 0, num_stages);
+      return;
+   }
+
+   _mesa_parallel_rows(func, data, num_stages, 1, 1);
+}
+
+
 /**
  * Link a program's shaders.
  */
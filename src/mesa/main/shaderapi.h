@@ -29,6 +29,7 @@
 
 
 #include "glheader.h"
+#include "parallel_rows.h"
 
 
 #ifdef __cplusplus
@@ -60,6 +61,10 @@ _mesa_count_active_attribs(struct gl_shader_program *shProg);
 extern size_t
 _mesa_longest_attribute_name_length(struct gl_shader_program *shProg);
 
+extern void
+_mesa_parallel_link_stages(struct gl_context *ctx, mesa_rows_func func,
+                           void *data, unsigned num_stages);
+
 extern void GLAPIENTRY
 _mesa_AttachObjectARB(GLhandleARB, GLhandleARB);
 
@@ -0,0 +1,448 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \name format_simd.cpp
+ *
+ * Check the SIMD swizzle-and-convert kernels that the CPU can run against
+ * the scalar conversions of format_utils.h, bit for bit, and print their
+ * throughput next to that of a plain C loop.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+#include "main/format_simd.h"
+#include "util/half_float.h"
+
+extern "C" {
+#include "main/cpuinfo.h"
+}
+
+namespace {
+
+typedef bool (*swizzle_and_convert_fn)(void *dst,
+                                       enum mesa_array_format_datatype dst_type,
+                                       int num_dst_channels,
+                                       const void *src,
+                                       enum mesa_array_format_datatype src_type,
+                                       int num_src_channels,
+                                       const uint8_t swizzle[4],
+                                       bool normalized, int count);
+
+struct variant {
+   const char *name;
+   swizzle_and_convert_fn convert;
+};
+
+void
+add_variant(std::vector<variant> &variants, const char *name,
+            swizzle_and_convert_fn convert)
+{
+   variant v;
+   v.name = name;
+   v.convert = convert;
+   variants.push_back(v);
+}
+
+std::vector<variant>
+supported_variants()
+{
+   std::vector<variant> variants;
+
+   _mesa_get_cpu_features();
+
+#if defined(__SSE2__)
+   add_variant(variants, "sse2", _mesa_swizzle_and_convert_sse2);
+#endif
+#if defined(USE_SSE41)
+   if (cpu_has_sse4_1)
+      add_variant(variants, "sse41", _mesa_swizzle_and_convert_sse41);
+#endif
+#if defined(USE_AVX2)
+   if (cpu_has_avx2)
+      add_variant(variants, "avx2", _mesa_swizzle_and_convert_avx2);
+#endif
+
+   return variants;
+}
+
+const uint8_t X = MESA_FORMAT_SWIZZLE_X;
+const uint8_t Y = MESA_FORMAT_SWIZZLE_Y;
+const uint8_t Z = MESA_FORMAT_SWIZZLE_Z;
+const uint8_t W = MESA_FORMAT_SWIZZLE_W;
+const uint8_t ZERO = MESA_FORMAT_SWIZZLE_ZERO;
+const uint8_t ONE = MESA_FORMAT_SWIZZLE_ONE;
+
+const uint8_t swizzles[][4] = {
+   { X, Y, Z, W },
+   { Z, Y, X, W },
+   { W, Z, Y, X },
+   { Y, Z, W, X },
+   { Z, Y, X, ONE },
+   { X, X, X, ONE },
+   { ZERO, ZERO, ZERO, X },
+};
+
+/* Odd, so that every variant also runs its scalar tail. */
+const int count = 4 * 64 + 3;
+const int num_swizzles = sizeof(swizzles) / sizeof(swizzles[0]);
+
+float
+unorm8_to_float(uint8_t x)
+{
+   return x * (1.0f / 255.0f);
+}
+
+uint8_t
+float_to_unorm8(float x)
+{
+   if (!(x > 0.0f))
+      return 0;
+   else if (x > 1.0f)
+      return 255;
+   else
+      return lrintf(x * 255.0f);
+}
+
+uint32_t
+float_bits(float f)
+{
+   uint32_t u;
+   memcpy(&u, &f, sizeof(u));
+   return u;
+}
+
+float
+bits_float(uint32_t u)
+{
+   float f;
+   memcpy(&f, &u, sizeof(f));
+   return f;
+}
+
+std::vector<float>
+float_test_values()
+{
+   std::vector<float> values;
+
+   for (int i = -300; i < 255 * 8 + 300; i++)
+      values.push_back(i / (255.0f * 8.0f));
+   values.push_back(INFINITY);
+   values.push_back(-INFINITY);
+   values.push_back(NAN);
+   values.push_back(-0.0f);
+
+   while (values.size() % 4)
+      values.push_back(0.5f);
+
+   return values;
+}
+
+double
+now()
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+} /* anonymous namespace */
+
+TEST(FormatSimdTest, SwizzleRGBA8)
+{
+   std::vector<uint8_t> src(count * 4), dst(count * 4);
+
+   for (unsigned i = 0; i < src.size(); i++)
+      src[i] = i * 7 + 3;
+
+   const std::vector<variant> variants = supported_variants();
+   for (unsigned vi = 0; vi < variants.size(); vi++) {
+      const variant &v = variants[vi];
+      for (int si = 0; si < num_swizzles; si++) {
+         const uint8_t *swizzle = swizzles[si];
+         for (int normalized = 0; normalized < 2; normalized++) {
+            SCOPED_TRACE(v.name);
+            const uint8_t one = normalized ? 255 : 1;
+
+            if (!v.convert(&dst[0], MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                           &src[0], MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                           swizzle, normalized, count))
+               continue;
+
+            for (int p = 0; p < count; p++) {
+               const uint8_t tmp[6] = {
+                  src[p * 4 + 0], src[p * 4 + 1], src[p * 4 + 2],
+                  src[p * 4 + 3], 0, one
+               };
+               for (int c = 0; c < 4; c++)
+                  ASSERT_EQ(tmp[swizzle[c]], dst[p * 4 + c]);
+            }
+         }
+      }
+   }
+}
+
+TEST(FormatSimdTest, Unorm8ToFloat)
+{
+   std::vector<uint8_t> src(count * 4);
+   std::vector<float> dst(count * 4);
+
+   for (unsigned i = 0; i < src.size(); i++)
+      src[i] = i;
+
+   const std::vector<variant> variants = supported_variants();
+   for (unsigned vi = 0; vi < variants.size(); vi++) {
+      const variant &v = variants[vi];
+      SCOPED_TRACE(v.name);
+
+      for (int chans = 1; chans <= 4; chans++) {
+         const uint8_t identity[4] = { X, Y, Z, W };
+
+         ASSERT_TRUE(v.convert(&dst[0], MESA_ARRAY_FORMAT_TYPE_FLOAT, chans,
+                               &src[0], MESA_ARRAY_FORMAT_TYPE_UBYTE, chans,
+                               identity, true, count));
+         for (int i = 0; i < count * chans; i++)
+            ASSERT_EQ(float_bits(unorm8_to_float(src[i])), float_bits(dst[i]));
+      }
+
+      for (int si = 0; si < num_swizzles; si++) {
+         const uint8_t *swizzle = swizzles[si];
+         if (!v.convert(&dst[0], MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                        &src[0], MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                        swizzle, true, count))
+            continue;
+
+         for (int p = 0; p < count; p++) {
+            const float tmp[6] = {
+               unorm8_to_float(src[p * 4 + 0]), unorm8_to_float(src[p * 4 + 1]),
+               unorm8_to_float(src[p * 4 + 2]), unorm8_to_float(src[p * 4 + 3]),
+               0.0f, 1.0f
+            };
+            for (int c = 0; c < 4; c++)
+               ASSERT_EQ(float_bits(tmp[swizzle[c]]), float_bits(dst[p * 4 + c]));
+         }
+      }
+   }
+}
+
+TEST(FormatSimdTest, FloatToUnorm8)
+{
+   const std::vector<float> src = float_test_values();
+   std::vector<uint8_t> dst(src.size());
+   const int n = src.size() / 4;
+
+   const std::vector<variant> variants = supported_variants();
+   for (unsigned vi = 0; vi < variants.size(); vi++) {
+      const variant &v = variants[vi];
+      SCOPED_TRACE(v.name);
+
+      for (int si = 0; si < num_swizzles; si++) {
+         const uint8_t *swizzle = swizzles[si];
+         if (!v.convert(&dst[0], MESA_ARRAY_FORMAT_TYPE_UBYTE, 4,
+                        &src[0], MESA_ARRAY_FORMAT_TYPE_FLOAT, 4,
+                        swizzle, true, n))
+            continue;
+
+         for (int p = 0; p < n; p++) {
+            const uint8_t tmp[6] = {
+               float_to_unorm8(src[p * 4 + 0]), float_to_unorm8(src[p * 4 + 1]),
+               float_to_unorm8(src[p * 4 + 2]), float_to_unorm8(src[p * 4 + 3]),
+               0, 255
+            };
+            for (int c = 0; c < 4; c++)
+               ASSERT_EQ(tmp[swizzle[c]], dst[p * 4 + c]) << src[p * 4 + c];
+         }
+      }
+   }
+}
+
+TEST(FormatSimdTest, HalfToFloat)
+{
+   std::vector<uint16_t> src(0x10000);
+   std::vector<float> dst(0x10000);
+   const uint8_t swizzle[4] = { X, Y, Z, W };
+
+   for (unsigned i = 0; i < src.size(); i++)
+      src[i] = i;
+
+   const std::vector<variant> variants = supported_variants();
+   for (unsigned vi = 0; vi < variants.size(); vi++) {
+      const variant &v = variants[vi];
+      SCOPED_TRACE(v.name);
+
+      ASSERT_TRUE(v.convert(&dst[0], MESA_ARRAY_FORMAT_TYPE_FLOAT, 1,
+                            &src[0], MESA_ARRAY_FORMAT_TYPE_HALF, 1,
+                            swizzle, false, src.size()));
+      for (unsigned i = 0; i < src.size(); i++)
+         ASSERT_EQ(float_bits(_mesa_half_to_float(src[i])),
+                   float_bits(dst[i])) << std::hex << src[i];
+   }
+}
+
+TEST(FormatSimdTest, FloatToHalf)
+{
+   std::vector<float> src;
+   const uint8_t swizzle[4] = { X, Y, Z, W };
+
+   /* Every exponent with a spread of mantissas, including the ones that
+    * round to even, and both signs.
+    */
+   for (uint32_t e = 0; e < 256; e++) {
+      for (uint32_t m = 0; m < (1 << 23); m += 0xfff + (m & 0x3)) {
+         src.push_back(bits_float(e << 23 | m));
+         src.push_back(bits_float(e << 23 | m | 0x1000));
+         src.push_back(bits_float(0x80000000 | e << 23 | m | 0x2000));
+      }
+   }
+   std::vector<uint16_t> dst(src.size());
+
+   const std::vector<variant> variants = supported_variants();
+   for (unsigned vi = 0; vi < variants.size(); vi++) {
+      const variant &v = variants[vi];
+      SCOPED_TRACE(v.name);
+
+      ASSERT_TRUE(v.convert(&dst[0], MESA_ARRAY_FORMAT_TYPE_HALF, 1,
+                            &src[0], MESA_ARRAY_FORMAT_TYPE_FLOAT, 1,
+                            swizzle, false, src.size()));
+      for (unsigned i = 0; i < src.size(); i++)
+         ASSERT_EQ(_mesa_float_to_half(src[i]), dst[i])
+            << std::hex << float_bits(src[i]);
+   }
+}
+
+#if defined(__SSE2__)
+TEST(FormatSimdTest, Depth16)
+{
+   const std::vector<float> src = float_test_values();
+   std::vector<uint16_t> z16(src.size());
+   std::vector<uint16_t> all(0x10000);
+   std::vector<float> f(0x10000);
+
+   _mesa_float_to_z16_row_sse2(&z16[0], &src[0], src.size());
+   for (unsigned i = 0; i < src.size(); i++) {
+      if (isnan(src[i]))
+         continue;
+      const float z = src[i] < 0.0f ? 0.0f : src[i] > 1.0f ? 1.0f : src[i];
+      ASSERT_EQ((uint16_t) (z * (float) 0xffff), z16[i]) << src[i];
+   }
+
+   for (unsigned i = 0; i < all.size(); i++)
+      all[i] = i;
+   _mesa_z16_to_float_row_sse2(&f[0], &all[0], all.size());
+   for (unsigned i = 0; i < all.size(); i++)
+      ASSERT_EQ(float_bits(all[i] * (1.0f / 65535.0f)), float_bits(f[i]));
+}
+#endif
+
+/**
+ * Not a test as such: prints the throughput of each variant on a 1024x1024
+ * RGBA image, next to a plain C loop doing the same.
+ */
+TEST(FormatSimdTest, Benchmark)
+{
+   const int pixels = 1024 * 1024;
+   const int iterations = 10;
+   const uint8_t bgra[4] = { Z, Y, X, W };
+   const uint8_t identity[4] = { X, Y, Z, W };
+   std::vector<uint8_t> u8(pixels * 4), u8_out(pixels * 4);
+   std::vector<float> f(pixels * 4);
+   std::vector<uint16_t> h(pixels * 4);
+
+   for (unsigned i = 0; i < u8.size(); i++)
+      u8[i] = i;
+
+   struct case_info {
+      const char *name;
+      enum mesa_array_format_datatype dst_type, src_type;
+      const uint8_t *swizzle;
+   };
+   const case_info cases[] = {
+      { "rgba8 -> bgra8", MESA_ARRAY_FORMAT_TYPE_UBYTE,
+        MESA_ARRAY_FORMAT_TYPE_UBYTE, bgra },
+      { "unorm8 -> float", MESA_ARRAY_FORMAT_TYPE_FLOAT,
+        MESA_ARRAY_FORMAT_TYPE_UBYTE, identity },
+      { "float -> unorm8", MESA_ARRAY_FORMAT_TYPE_UBYTE,
+        MESA_ARRAY_FORMAT_TYPE_FLOAT, identity },
+      { "float -> half", MESA_ARRAY_FORMAT_TYPE_HALF,
+        MESA_ARRAY_FORMAT_TYPE_FLOAT, identity },
+      { "half -> float", MESA_ARRAY_FORMAT_TYPE_FLOAT,
+        MESA_ARRAY_FORMAT_TYPE_HALF, identity },
+   };
+
+   const std::vector<variant> variants = supported_variants();
+
+   for (unsigned ci = 0; ci < sizeof(cases) / sizeof(cases[0]); ci++) {
+      const case_info &c = cases[ci];
+      void *dst = c.dst_type == MESA_ARRAY_FORMAT_TYPE_FLOAT ? (void *) &f[0] :
+                  c.dst_type == MESA_ARRAY_FORMAT_TYPE_HALF ? (void *) &h[0] :
+                  (void *) &u8_out[0];
+      const void *src = c.src_type == MESA_ARRAY_FORMAT_TYPE_FLOAT ? (void *) &f[0] :
+                        c.src_type == MESA_ARRAY_FORMAT_TYPE_HALF ? (void *) &h[0] :
+                        (void *) &u8[0];
+      double start = now();
+
+      for (int it = 0; it < iterations; it++) {
+         for (int i = 0; i < pixels * 4; i++) {
+            switch (c.dst_type) {
+            case MESA_ARRAY_FORMAT_TYPE_UBYTE:
+               if (c.src_type == MESA_ARRAY_FORMAT_TYPE_UBYTE)
+                  u8_out[i] = u8[(i & ~3) + c.swizzle[i & 3]];
+               else
+                  u8_out[i] = float_to_unorm8(f[i]);
+               break;
+            case MESA_ARRAY_FORMAT_TYPE_HALF:
+               h[i] = _mesa_float_to_half(f[i]);
+               break;
+            default:
+               if (c.src_type == MESA_ARRAY_FORMAT_TYPE_UBYTE)
+                  f[i] = unorm8_to_float(u8[i]);
+               else
+                  f[i] = _mesa_half_to_float(h[i]);
+               break;
+            }
+         }
+      }
+      printf("%-16s %-6s %8.1f Mpixels/s\n", c.name, "C",
+             pixels * (double) iterations / (now() - start) / 1e6);
+
+      for (unsigned vi = 0; vi < variants.size(); vi++) {
+         const variant &v = variants[vi];
+
+         if (!v.convert(dst, c.dst_type, 4, src, c.src_type, 4,
+                        c.swizzle, true, pixels)) {
+            printf("%-16s %-6s not handled\n", c.name, v.name);
+            continue;
+         }
+
+         start = now();
+         for (int it = 0; it < iterations; it++) {
+            v.convert(dst, c.dst_type, 4, src, c.src_type, 4,
+                      c.swizzle, true, pixels);
+         }
+         printf("%-16s %-6s %8.1f Mpixels/s\n", c.name, v.name,
+                pixels * (double) iterations / (now() - start) / 1e6);
+      }
+   }
+}
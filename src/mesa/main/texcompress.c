@@ -34,8 +34,10 @@
 #include "imports.h"
 #include "context.h"
 #include "formats.h"
+#include "macros.h"
 #include "mtypes.h"
 #include "context.h"
+#include "parallel_rows.h"
 #include "texcompress.h"
 #include "texcompress_fxt1.h"
 #include "texcompress_rgtc.h"
@@ -796,6 +798,34 @@ _mesa_get_compressed_fetch_func(mesa_format format)
 }
 
 
+struct decompress_job {
+   compressed_fetch_func fetch;
+   const GLubyte *src;
+   GLint stride;
+   GLuint width;
+   GLfloat *dest;
+};
+
+static void
+decompress_rows(void *data, unsigned first, unsigned end)
+{
+   const struct decompress_job *job = data;
+   GLfloat *dest = job->dest + first * job->width * 4;
+   GLuint i, j;
+
+   for (j = first; j < end; j++) {
+      for (i = 0; i < job->width; i++) {
+         job->fetch(job->src, job->stride, i, j, dest);
+         dest += 4;
+      }
+   }
+}
+
+/* Images with at least this many texels per thread are decompressed on
+ * several threads.
+ */
+#define DECOMPRESS_MIN_TEXELS_PER_THREAD (64 * 1024)
+
 /**
  * Decompress a compressed texture image, returning a GL_RGBA/GL_FLOAT image.
  * \param srcRowStride  stride in bytes between rows of blocks in the
@@ -806,26 +836,24 @@ _mesa_decompress_image(mesa_format format, GLuint width, GLuint height,
                        const GLubyte *src, GLint srcRowStride,
                        GLfloat *dest)
 {
-   compressed_fetch_func fetch;
-   GLuint i, j;
+   struct decompress_job job;
    GLuint bytes, bw, bh;
-   GLint stride;
 
    bytes = _mesa_get_format_bytes(format);
    _mesa_get_format_block_size(format, &bw, &bh);
 
-   fetch = _mesa_get_compressed_fetch_func(format);
-   if (!fetch) {
+   job.fetch = _mesa_get_compressed_fetch_func(format);
+   if (!job.fetch) {
       _mesa_problem(NULL, "Unexpected format in _mesa_decompress_image()");
       return;
    }
- 
-   stride = srcRowStride * bh / bytes;
 
-   for (j = 0; j < height; j++) {
-      for (i = 0; i < width; i++) {
-         fetch(src, stride, i, j, dest);
-         dest += 4;
-      }
-   }
+   job.src = src;
+   job.stride = srcRowStride * bh / bytes;
+   job.width = width;
+   job.dest = dest;
+
+   _mesa_parallel_rows(decompress_rows, &job, height, bh,
+                       DIV_ROUND_UP(DECOMPRESS_MIN_TEXELS_PER_THREAD,
+                                    MAX2(width, 1)));
 }
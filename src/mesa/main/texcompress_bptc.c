@@ -34,11 +34,17 @@
 #include "texstore.h"
 #include "macros.h"
 #include "image.h"
+#include "parallel_rows.h"
 
 #define BLOCK_SIZE 4
 #define N_PARTITIONS 64
 #define BLOCK_BYTES 16
 
+/* Images with at least this many block rows per thread are compressed on
+ * several threads.
+ */
+#define MIN_BLOCK_ROWS_PER_THREAD 2
+
 struct bptc_unorm_mode {
    int n_subsets;
    int n_partition_bits;
@@ -1272,6 +1278,69 @@ compress_rgba_unorm(int width, int height,
    }
 }
 
+static void
+compress_rgb_float(int width, int height,
+                   const float *src, int src_rowstride,
+                   uint8_t *dst, int dst_rowstride,
+                   bool is_signed);
+
+struct compress_job {
+   int width;
+   const uint8_t *src;
+   int src_rowstride;
+   uint8_t *dst;
+   int dst_rowstride;
+   bool is_float, is_signed;
+};
+
+static void
+compress_rows(void *data, unsigned first, unsigned end)
+{
+   const struct compress_job *job = data;
+   /* Dest block rows are laid out the way compress_rgba_unorm() and
+    * compress_rgb_float() walk them.
+    */
+   const int dst_block_row_stride = job->dst_rowstride >= job->width * 4 ?
+      job->dst_rowstride : ((job->width + 3) & ~3) * 4;
+   const uint8_t *src = job->src + first * job->src_rowstride;
+   uint8_t *dst = job->dst + first / BLOCK_SIZE * dst_block_row_stride;
+
+   /* first is a multiple of the block height. */
+   if (job->is_float) {
+      compress_rgb_float(job->width, end - first,
+                         (const float *) src, job->src_rowstride,
+                         dst, job->dst_rowstride,
+                         job->is_signed);
+   } else {
+      compress_rgba_unorm(job->width, end - first,
+                          src, job->src_rowstride,
+                          dst, job->dst_rowstride);
+   }
+}
+
+/**
+ * Compresses the image giving each thread a band of block rows.
+ */
+static void
+compress_parallel(int width, int height,
+                  const void *src, int src_rowstride,
+                  uint8_t *dst, int dst_rowstride,
+                  bool is_float, bool is_signed)
+{
+   struct compress_job job;
+
+   job.width = width;
+   job.src = src;
+   job.src_rowstride = src_rowstride;
+   job.dst = dst;
+   job.dst_rowstride = dst_rowstride;
+   job.is_float = is_float;
+   job.is_signed = is_signed;
+
+   _mesa_parallel_rows(compress_rows, &job, height, BLOCK_SIZE,
+                       BLOCK_SIZE * MIN_BLOCK_ROWS_PER_THREAD);
+}
+
 GLboolean
 _mesa_texstore_bptc_rgba_unorm(TEXSTORE_PARAMS)
 {
@@ -1308,9 +1377,10 @@ _mesa_texstore_bptc_rgba_unorm(TEXSTORE_PARAMS)
                                          srcFormat, srcType);
    }
 
-   compress_rgba_unorm(srcWidth, srcHeight,
-                       pixels, rowstride,
-                       dstSlices[0], dstRowStride);
+   compress_parallel(srcWidth, srcHeight,
+                     pixels, rowstride,
+                     dstSlices[0], dstRowStride,
+                     false /* float */, false /* signed */);
 
    free((void *) tempImage);
 
@@ -1619,10 +1689,10 @@ texstore_bptc_rgb_float(TEXSTORE_PARAMS,
                                          srcFormat, srcType);
    }
 
-   compress_rgb_float(srcWidth, srcHeight,
-                      pixels, rowstride,
-                      dstSlices[0], dstRowStride,
-                      is_signed);
+   compress_parallel(srcWidth, srcHeight,
+                     pixels, rowstride,
+                     dstSlices[0], dstRowStride,
+                     true /* float */, is_signed);
 
    free((void *) tempImage);
 
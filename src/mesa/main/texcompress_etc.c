@@ -43,6 +43,7 @@
 #include "texstore.h"
 #include "macros.h"
 #include "format_unpack.h"
+#include "parallel_rows.h"
 #include "util/format_srgb.h"
 
 
@@ -104,6 +105,61 @@ static const int etc2_modifier_tables_non_opaque[8][4] = {
 #undef TAG
 #undef UINT8_TYPE
 
+typedef void (*etc_unpack_func)(uint8_t *dst_row,
+                                unsigned dst_stride,
+                                const uint8_t *src_row,
+                                unsigned src_stride,
+                                unsigned width,
+                                unsigned height);
+
+/* Images with at least this many block rows per thread are decoded on
+ * several threads.
+ */
+#define ETC_MIN_BLOCK_ROWS_PER_THREAD 16
+
+struct etc_unpack_job {
+   etc_unpack_func unpack;
+   uint8_t *dst_row;
+   unsigned dst_stride;
+   const uint8_t *src_row;
+   unsigned src_stride;
+   unsigned width;
+};
+
+static void
+etc_unpack_rows(void *data, unsigned first, unsigned end)
+{
+   const struct etc_unpack_job *job = data;
+
+   /* first is a multiple of the block height. */
+   job->unpack(job->dst_row + first * job->dst_stride, job->dst_stride,
+               job->src_row + first / 4 * job->src_stride, job->src_stride,
+               job->width, end - first);
+}
+
+/**
+ * Decodes the image with \p unpack, giving each thread a band of block
+ * rows.
+ */
+static void
+etc_unpack_parallel(etc_unpack_func unpack,
+                    uint8_t *dst_row, unsigned dst_stride,
+                    const uint8_t *src_row, unsigned src_stride,
+                    unsigned width, unsigned height)
+{
+   struct etc_unpack_job job;
+
+   job.unpack = unpack;
+   job.dst_row = dst_row;
+   job.dst_stride = dst_stride;
+   job.src_row = src_row;
+   job.src_stride = src_stride;
+   job.width = width;
+
+   _mesa_parallel_rows(etc_unpack_rows, &job, height, 4,
+                       4 * ETC_MIN_BLOCK_ROWS_PER_THREAD);
+}
+
 GLboolean
 _mesa_texstore_etc1_rgb8(TEXSTORE_PARAMS)
 {
@@ -141,9 +197,8 @@ _mesa_etc1_unpack_rgba8888(uint8_t *dst_row,
                            unsigned src_width,
                            unsigned src_height)
 {
-   etc1_unpack_rgba8888(dst_row, dst_stride,
-                        src_row, src_stride,
-                        src_width, src_height);
+   etc_unpack_parallel(etc1_unpack_rgba8888, dst_row, dst_stride,
+                       src_row, src_stride, src_width, src_height);
 }
 
 static uint8_t
@@ -1207,46 +1262,33 @@ _mesa_unpack_etc2_format(uint8_t *dst_row,
                          unsigned src_height,
                          mesa_format format)
 {
+   etc_unpack_func unpack;
+
    if (format == MESA_FORMAT_ETC2_RGB8)
-      etc2_unpack_rgb8(dst_row, dst_stride,
-                       src_row, src_stride,
-                       src_width, src_height);
+      unpack = etc2_unpack_rgb8;
    else if (format == MESA_FORMAT_ETC2_SRGB8)
-      etc2_unpack_srgb8(dst_row, dst_stride,
-                        src_row, src_stride,
-                        src_width, src_height);
+      unpack = etc2_unpack_srgb8;
    else if (format == MESA_FORMAT_ETC2_RGBA8_EAC)
-      etc2_unpack_rgba8(dst_row, dst_stride,
-                        src_row, src_stride,
-                        src_width, src_height);
+      unpack = etc2_unpack_rgba8;
    else if (format == MESA_FORMAT_ETC2_SRGB8_ALPHA8_EAC)
-      etc2_unpack_srgb8_alpha8(dst_row, dst_stride,
-                               src_row, src_stride,
-                               src_width, src_height);
+      unpack = etc2_unpack_srgb8_alpha8;
    else if (format == MESA_FORMAT_ETC2_R11_EAC)
-      etc2_unpack_r11(dst_row, dst_stride,
-                      src_row, src_stride,
-                      src_width, src_height);
+      unpack = etc2_unpack_r11;
    else if (format == MESA_FORMAT_ETC2_RG11_EAC)
-      etc2_unpack_rg11(dst_row, dst_stride,
-                       src_row, src_stride,
-                       src_width, src_height);
+      unpack = etc2_unpack_rg11;
    else if (format == MESA_FORMAT_ETC2_SIGNED_R11_EAC)
-      etc2_unpack_signed_r11(dst_row, dst_stride,
-                             src_row, src_stride,
-                             src_width, src_height);
+      unpack = etc2_unpack_signed_r11;
    else if (format == MESA_FORMAT_ETC2_SIGNED_RG11_EAC)
-      etc2_unpack_signed_rg11(dst_row, dst_stride,
-                              src_row, src_stride,
-                              src_width, src_height);
+      unpack = etc2_unpack_signed_rg11;
    else if (format == MESA_FORMAT_ETC2_RGB8_PUNCHTHROUGH_ALPHA1)
-      etc2_unpack_rgb8_punchthrough_alpha1(dst_row, dst_stride,
-                                           src_row, src_stride,
-                                           src_width, src_height);
+      unpack = etc2_unpack_rgb8_punchthrough_alpha1;
    else if (format == MESA_FORMAT_ETC2_SRGB8_PUNCHTHROUGH_ALPHA1)
-      etc2_unpack_srgb8_punchthrough_alpha1(dst_row, dst_stride,
-                                            src_row, src_stride,
-                                            src_width, src_height);
+      unpack = etc2_unpack_srgb8_punchthrough_alpha1;
+   else
+      return;
+
+   etc_unpack_parallel(unpack, dst_row, dst_stride, src_row, src_stride,
+                       src_width, src_height);
 }
 
 
@@ -39,6 +39,7 @@
 #include "texcompress_s3tc.h"
 #include "texstore.h"
 #include "format_unpack.h"
+#include "parallel_rows.h"
 #include "util/format_srgb.h"
 
 
@@ -114,6 +115,61 @@ _mesa_init_texture_s3tc( struct gl_context *ctx )
    }
 }
 
+/* Images with at least this many block rows per thread are compressed on
+ * several threads.
+ */
+#define DXTN_MIN_BLOCK_ROWS_PER_THREAD 4
+
+struct compress_dxtn_job {
+   GLint srccomps, width;
+   const GLubyte *pixels;
+   GLenum destformat;
+   GLubyte *dst;
+   GLint dstRowStride, blockRowStride;
+};
+
+static void
+compress_dxtn_rows(void *data, unsigned first, unsigned end)
+{
+   const struct compress_dxtn_job *job = data;
+
+   /* first is a multiple of the block height. */
+   (*ext_tx_compress_dxtn)(job->srccomps, job->width, end - first,
+                           job->pixels + first * job->width * job->srccomps,
+                           job->destformat,
+                           job->dst + first / 4 * job->blockRowStride,
+                           job->dstRowStride);
+}
+
+/**
+ * Compresses the tightly packed image \p pixels with the external library,
+ * giving each thread a band of block rows.  The library keeps no state
+ * between blocks, so bands can be compressed independently.
+ */
+static void
+compress_dxtn(GLint srccomps, GLint width, GLint height,
+              const GLubyte *pixels, GLenum destformat,
+              GLubyte *dst, GLint dstRowStride)
+{
+   const GLint blockBytes =
+      destformat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ||
+      destformat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16;
+   struct compress_dxtn_job job;
+
+   job.srccomps = srccomps;
+   job.width = width;
+   job.pixels = pixels;
+   job.destformat = destformat;
+   job.dst = dst;
+   job.dstRowStride = dstRowStride;
+   /* Like the library, ignore dstRowStride if it is too small. */
+   job.blockRowStride = dstRowStride >= width * blockBytes / 4 ?
+      dstRowStride : DIV_ROUND_UP(width, 4) * blockBytes;
+
+   _mesa_parallel_rows(compress_dxtn_rows, &job, height, 4,
+                       4 * DXTN_MIN_BLOCK_ROWS_PER_THREAD);
+}
+
 /**
  * Store user's image in rgb_dxt1 format.
  */
@@ -157,9 +213,9 @@ _mesa_texstore_rgb_dxt1(TEXSTORE_PARAMS)
    dst = dstSlices[0];
 
    if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(3, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
-                              dst, dstRowStride);
+      compress_dxtn(3, srcWidth, srcHeight, pixels,
+                    GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                    dst, dstRowStride);
    }
    else {
       _mesa_warning(ctx, "external dxt library not available: texstore_rgb_dxt1");
@@ -215,9 +271,9 @@ _mesa_texstore_rgba_dxt1(TEXSTORE_PARAMS)
    dst = dstSlices[0];
 
    if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(4, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
-                              dst, dstRowStride);
+      compress_dxtn(4, srcWidth, srcHeight, pixels,
+                    GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
+                    dst, dstRowStride);
    }
    else {
       _mesa_warning(ctx, "external dxt library not available: texstore_rgba_dxt1");
@@ -272,9 +328,9 @@ _mesa_texstore_rgba_dxt3(TEXSTORE_PARAMS)
    dst = dstSlices[0];
 
    if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(4, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,
-                              dst, dstRowStride);
+      compress_dxtn(4, srcWidth, srcHeight, pixels,
+                    GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,
+                    dst, dstRowStride);
    }
    else {
       _mesa_warning(ctx, "external dxt library not available: texstore_rgba_dxt3");
@@ -329,9 +385,9 @@ _mesa_texstore_rgba_dxt5(TEXSTORE_PARAMS)
    dst = dstSlices[0];
 
    if (ext_tx_compress_dxtn) {
-      (*ext_tx_compress_dxtn)(4, srcWidth, srcHeight, pixels,
-                              GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
-                              dst, dstRowStride);
+      compress_dxtn(4, srcWidth, srcHeight, pixels,
+                    GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+                    dst, dstRowStride);
    }
    else {
       _mesa_warning(ctx, "external dxt library not available: texstore_rgba_dxt5");
@@ -759,6 +759,8 @@ static void
 clear_teximage_fields(struct gl_texture_image *img)
 {
    assert(img);
+   if (img->TexObject)
+      img->TexObject->_CompletenessValid = GL_FALSE;
    img->_BaseFormat = 0;
    img->InternalFormat = 0;
    img->Border = 0;
@@ -809,6 +811,7 @@ init_teximage_fields_ms(struct gl_context *ctx,
    assert(depth >= 0);
 
    target = img->TexObject->Target;
+   img->TexObject->_CompletenessValid = GL_FALSE;
    img->_BaseFormat = _mesa_base_tex_format( ctx, internalFormat );
    assert(img->_BaseFormat != -1);
    img->InternalFormat = internalFormat;
@@ -2204,9 +2207,7 @@ copytexture_error_check( struct gl_context *ctx, GLuint dimensions,
 
    /* Check that the source buffer is complete */
    if (_mesa_is_user_fbo(ctx->ReadBuffer)) {
-      if (ctx->ReadBuffer->_Status == 0) {
-         _mesa_test_framebuffer_completeness(ctx, ctx->ReadBuffer);
-      }
+      _mesa_update_framebuffer_completeness(ctx, ctx->ReadBuffer);
       if (ctx->ReadBuffer->_Status != GL_FRAMEBUFFER_COMPLETE_EXT) {
          _mesa_error(ctx, GL_INVALID_FRAMEBUFFER_OPERATION_EXT,
                      "glCopyTexImage%dD(invalid readbuffer)", dimensions);
@@ -2435,9 +2436,7 @@ copytexsubimage_error_check(struct gl_context *ctx, GLuint dimensions,
 
    /* Check that the source buffer is complete */
    if (_mesa_is_user_fbo(ctx->ReadBuffer)) {
-      if (ctx->ReadBuffer->_Status == 0) {
-         _mesa_test_framebuffer_completeness(ctx, ctx->ReadBuffer);
-      }
+      _mesa_update_framebuffer_completeness(ctx, ctx->ReadBuffer);
       if (ctx->ReadBuffer->_Status != GL_FRAMEBUFFER_COMPLETE_EXT) {
          _mesa_error(ctx, GL_INVALID_FRAMEBUFFER_OPERATION_EXT,
                      "%s(invalid readbuffer)", caller);
@@ -2521,52 +2520,13 @@ copytexsubimage_error_check(struct gl_context *ctx, GLuint dimensions,
 }
 
 
-/** Callback info for walking over FBO hash table */
-struct cb_info
-{
-   struct gl_context *ctx;
-   struct gl_texture_object *texObj;
-   GLuint level, face;
-};
-
-
-/**
- * Check render to texture callback.  Called from _mesa_HashWalk().
- */
-static void
-check_rtt_cb(GLuint key, void *data, void *userData)
-{
-   struct gl_framebuffer *fb = (struct gl_framebuffer *) data;
-   const struct cb_info *info = (struct cb_info *) userData;
-   struct gl_context *ctx = info->ctx;
-   const struct gl_texture_object *texObj = info->texObj;
-   const GLuint level = info->level, face = info->face;
-
-   /* If this is a user-created FBO */
-   if (_mesa_is_user_fbo(fb)) {
-      GLuint i;
-      /* check if any of the FBO's attachments point to 'texObj' */
-      for (i = 0; i < BUFFER_COUNT; i++) {
-         struct gl_renderbuffer_attachment *att = fb->Attachment + i;
-         if (att->Type == GL_TEXTURE &&
-             att->Texture == texObj &&
-             att->TextureLevel == level &&
-             att->CubeMapFace == face) {
-            _mesa_update_texture_renderbuffer(ctx, ctx->DrawBuffer, att);
-            assert(att->Renderbuffer->TexImage);
-            /* Mark fb status as indeterminate to force re-validation */
-            fb->_Status = 0;
-         }
-      }
-   }
-}
-
-
 /**
  * When a texture image is specified we have to check if it's bound to
  * any framebuffer objects (render to texture) in order to detect changes
  * in size or format since that effects FBO completeness.
- * Any FBOs rendering into the texture must be re-validated.
+ * Bumping the image generation makes any FBO rendering into the texture
+ * update its renderbuffer wrapper and get re-validated the next time it's
+ * used, see _mesa_update_framebuffer_completeness().
  */
 void
 _mesa_update_fbo_texture(struct gl_context *ctx,
@@ -2575,12 +2535,13 @@ _mesa_update_fbo_texture(struct gl_context *ctx,
 {
    /* Only check this texture if it's been marked as RenderToTexture */
    if (texObj->_RenderToTexture) {
-      struct cb_info info;
-      info.ctx = ctx;
-      info.texObj = texObj;
-      info.level = level;
-      info.face = face;
-      _mesa_HashWalk(ctx->Shared->FrameBuffers, check_rtt_cb, &info);
+      struct gl_texture_image *texImage = texObj->Image[face][level];
+
+      if (texImage)
+         texImage->Generation++;
+
+      /* The bound framebuffers may be rendering into it */
+      ctx->NewState |= _NEW_BUFFERS;
    }
 }
 
@@ -3200,6 +3161,26 @@ texsubimage(struct gl_context *ctx, GLuint dims, GLenum target, GLint level,
 }
 
 
+/**
+ * glTexSubImage1/2/3D() for KHR_no_error contexts.
+ */
+static void
+texsubimage_no_error(struct gl_context *ctx, GLuint dims, GLenum target,
+                     GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                     GLsizei width, GLsizei height, GLsizei depth,
+                     GLenum format, GLenum type, const GLvoid *pixels)
+{
+   struct gl_texture_object *texObj =
+      _mesa_get_current_tex_object(ctx, target);
+   struct gl_texture_image *texImage =
+      _mesa_select_tex_image(texObj, target, level);
+
+   _mesa_texture_sub_image(ctx, dims, texObj, texImage, target, level,
+                           xoffset, yoffset, zoffset, width, height, depth,
+                           format, type, pixels, false);
+}
+
+
 /**
  * Implement all the glTextureSubImage1/2/3D() functions.
  * Must split this out this way because of GL_TEXTURE_CUBE_MAP.
@@ -3357,6 +3338,43 @@ _mesa_TexSubImage3D( GLenum target, GLint level,
                format, type, pixels, "glTexSubImage3D");
 }
 
+
+void GLAPIENTRY
+_mesa_TexSubImage1D_no_error(GLenum target, GLint level, GLint xoffset,
+                             GLsizei width, GLenum format, GLenum type,
+                             const GLvoid *pixels)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   texsubimage_no_error(ctx, 1, target, level, xoffset, 0, 0,
+                        width, 1, 1, format, type, pixels);
+}
+
+
+void GLAPIENTRY
+_mesa_TexSubImage2D_no_error(GLenum target, GLint level,
+                             GLint xoffset, GLint yoffset,
+                             GLsizei width, GLsizei height,
+                             GLenum format, GLenum type,
+                             const GLvoid *pixels)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   texsubimage_no_error(ctx, 2, target, level, xoffset, yoffset, 0,
+                        width, height, 1, format, type, pixels);
+}
+
+
+void GLAPIENTRY
+_mesa_TexSubImage3D_no_error(GLenum target, GLint level,
+                             GLint xoffset, GLint yoffset, GLint zoffset,
+                             GLsizei width, GLsizei height, GLsizei depth,
+                             GLenum format, GLenum type,
+                             const GLvoid *pixels)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   texsubimage_no_error(ctx, 3, target, level, xoffset, yoffset, zoffset,
+                        width, height, depth, format, type, pixels);
+}
+
 void GLAPIENTRY
 _mesa_TextureSubImage1D(GLuint texture, GLint level,
                         GLint xoffset, GLsizei width,
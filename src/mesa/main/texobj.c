@@ -465,6 +465,7 @@ _mesa_copy_texture_object( struct gl_texture_object *dest,
    dest->GenerateMipmap = src->GenerateMipmap;
    dest->_BaseComplete = src->_BaseComplete;
    dest->_MipmapComplete = src->_MipmapComplete;
+   dest->_CompletenessValid = src->_CompletenessValid;
    COPY_4V(dest->Swizzle, src->Swizzle);
    dest->_Swizzle = src->_Swizzle;
    dest->_IsHalfFloat = src->_IsHalfFloat;
@@ -637,8 +638,10 @@ incomplete(struct gl_texture_object *t, enum base_mipmap bm,
 /**
  * Examine a texture object to determine if it is complete.
  *
- * The gl_texture_object::Complete flag will be set to GL_TRUE or GL_FALSE
- * accordingly.
+ * The gl_texture_object::_BaseComplete and _MipmapComplete flags will be set
+ * to GL_TRUE or GL_FALSE accordingly, and stay valid until the texture is
+ * changed.  Use _mesa_update_texobj_completeness() to only test textures
+ * which changed.
  *
  * \param ctx GL context.
  * \param t texture object.
@@ -657,6 +660,7 @@ _mesa_test_texobj_completeness( const struct gl_context *ctx,
    /* We'll set these to FALSE if tests fail below */
    t->_BaseComplete = GL_TRUE;
    t->_MipmapComplete = GL_TRUE;
+   t->_CompletenessValid = GL_TRUE;
 
    if (t->Target == GL_TEXTURE_BUFFER) {
       /* Buffer textures are always considered complete.  The obvious case where
@@ -934,6 +938,7 @@ _mesa_dirty_texobj(struct gl_context *ctx, struct gl_texture_object *texObj)
 {
    texObj->_BaseComplete = GL_FALSE;
    texObj->_MipmapComplete = GL_FALSE;
+   texObj->_CompletenessValid = GL_FALSE;
    ctx->NewState |= _NEW_TEXTURE;
 }
 
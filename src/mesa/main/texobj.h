@@ -177,6 +177,19 @@ extern void
 _mesa_test_texobj_completeness( const struct gl_context *ctx,
                                 struct gl_texture_object *obj );
 
+/**
+ * Test the completeness of a texture object, unless it hasn't changed since
+ * it was last tested.  Textures which are incomplete on their own stay so
+ * until they are changed, so they aren't tested again at each validation.
+ */
+static inline void
+_mesa_update_texobj_completeness(const struct gl_context *ctx,
+                                 struct gl_texture_object *obj)
+{
+   if (!obj->_CompletenessValid)
+      _mesa_test_texobj_completeness(ctx, obj);
+}
+
 extern GLboolean
 _mesa_cube_level_complete(const struct gl_texture_object *texObj,
                           const GLint level);
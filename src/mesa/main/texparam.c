@@ -252,6 +252,21 @@ incomplete(struct gl_context *ctx, struct gl_texture_object *texObj)
 }
 
 
+/**
+ * This is called just prior to changing the min or mag filter of a texture
+ * object.  Only the completeness of GLES float textures depends on the
+ * filters (see valid_filter_for_float()), so it's tested again without
+ * making all other textures incomplete.
+ */
+static inline void
+filter_changed(struct gl_context *ctx, struct gl_texture_object *texObj)
+{
+   flush(ctx);
+   if (_mesa_is_gles(ctx))
+      texObj->_CompletenessValid = GL_FALSE;
+}
+
+
 static GLboolean
 target_allows_setting_sampler_parameters(GLenum target)
 {
@@ -287,7 +302,7 @@ set_tex_parameteri(struct gl_context *ctx,
       switch (params[0]) {
       case GL_NEAREST:
       case GL_LINEAR:
-         flush(ctx);
+         filter_changed(ctx, texObj);
          texObj->Sampler.MinFilter = params[0];
          return GL_TRUE;
       case GL_NEAREST_MIPMAP_NEAREST:
@@ -296,7 +311,7 @@ set_tex_parameteri(struct gl_context *ctx,
       case GL_LINEAR_MIPMAP_LINEAR:
          if (texObj->Target != GL_TEXTURE_RECTANGLE_NV &&
              texObj->Target != GL_TEXTURE_EXTERNAL_OES) {
-            flush(ctx);
+            filter_changed(ctx, texObj);
             texObj->Sampler.MinFilter = params[0];
             return GL_TRUE;
          }
@@ -315,7 +330,7 @@ set_tex_parameteri(struct gl_context *ctx,
       switch (params[0]) {
       case GL_NEAREST:
       case GL_LINEAR:
-         flush(ctx); /* does not effect completeness */
+         filter_changed(ctx, texObj);
          texObj->Sampler.MagFilter = params[0];
          return GL_TRUE;
       default:
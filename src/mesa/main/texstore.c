@@ -773,17 +773,29 @@ texstore_rgba(TEXSTORE_PARAMS)
       /* Convert from src to RGBA float */
       src = (GLubyte *) srcAddr;
       dst = (GLubyte *) tempRGBA;
-      for (img = 0; img < srcDepth; img++) {
-         _mesa_format_convert(dst, RGBA32_FLOAT, 4 * srcWidth * sizeof(float),
-                              src, srcMesaFormat, srcRowStride,
-                              srcWidth, srcHeight, NULL);
-         src += srcHeight * srcRowStride;
-         dst += srcHeight * 4 * srcWidth * sizeof(float);
-      }
+      if (srcMesaFormat == RGBA8_UBYTE && elementCount > 256) {
+         /* Convert and apply transferOps in one pass */
+         for (img = 0; img < srcDepth; img++) {
+            _mesa_apply_rgba_transfer_ops_ubyte(ctx, ctx->_ImageTransferState,
+                                                srcWidth, srcHeight,
+                                                src, srcRowStride,
+                                                (float(*)[4]) dst);
+            src += srcHeight * srcRowStride;
+            dst += srcHeight * 4 * srcWidth * sizeof(float);
+         }
+      } else {
+         for (img = 0; img < srcDepth; img++) {
+            _mesa_format_convert(dst, RGBA32_FLOAT, 4 * srcWidth * sizeof(float),
+                                 src, srcMesaFormat, srcRowStride,
+                                 srcWidth, srcHeight, NULL);
+            src += srcHeight * srcRowStride;
+            dst += srcHeight * 4 * srcWidth * sizeof(float);
+         }
 
-      /* Apply transferOps */
-      _mesa_apply_rgba_transfer_ops(ctx, ctx->_ImageTransferState, elementCount,
-                                    (float(*)[4]) tempRGBA);
+         /* Apply transferOps */
+         _mesa_apply_rgba_transfer_ops(ctx, ctx->_ImageTransferState,
+                                       elementCount, (float(*)[4]) tempRGBA);
+      }
 
       /* Now we have to adjust our src info for a conversion from
        * the RGBA float image and then we continue as usual.
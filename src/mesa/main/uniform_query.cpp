@@ -793,6 +793,18 @@ _mesa_uniform(struct gl_context *ctx, struct gl_shader_program *shProg,
       count = MIN2(count, (int) (uni->array_elements - offset));
    }
 
+   /* Applications tend to set uniforms to the values they already have.
+    * Skip those, so that the constants don't get flagged as changed and
+    * uploaded again.  Opaque types have more state derived from their
+    * values, and booleans are stored converted, so they always go the
+    * long way.
+    */
+   if (uni->initialized && !uni->type->is_boolean() &&
+       !uni->type->contains_opaque() &&
+       memcmp(&uni->storage[size_mul * components * offset], values,
+              sizeof(uni->storage[0]) * components * count * size_mul) == 0)
+      return;
+
    FLUSH_VERTICES(ctx, _NEW_PROGRAM_CONSTANTS);
 
    /* Store the data in the "actual type" backing storage for the uniform.
@@ -988,11 +1000,18 @@ _mesa_uniform_matrix(struct gl_context *ctx, struct gl_shader_program *shProg,
       count = MIN2(count, (int) (uni->array_elements - offset));
    }
 
+   elements = components * vectors;
+
+   /* Skip setting the values the uniform already has, see _mesa_uniform(). */
+   if (uni->initialized && !transpose &&
+       memcmp(&uni->storage[elements * offset], values,
+              sizeof(uni->storage[0]) * elements * count * size_mul) == 0)
+      return;
+
    FLUSH_VERTICES(ctx, _NEW_PROGRAM_CONSTANTS);
 
    /* Store the data in the "actual type" backing storage for the uniform.
     */
-   elements = components * vectors;
 
    if (!transpose) {
       memcpy(&uni->storage[elements * offset], values,
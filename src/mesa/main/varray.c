@@ -439,6 +439,33 @@ update_array_format(struct gl_context *ctx,
 }
 
 
+/**
+ * Update the pointer, stride and buffer of an attrib array whose format was
+ * just set, and reset its vertex buffer binding.
+ */
+static void
+update_array_pointer(struct gl_context *ctx, GLuint attrib, GLsizei stride,
+                     const GLvoid *ptr)
+{
+   struct gl_vertex_attrib_array *array;
+   GLsizei effectiveStride;
+
+   /* Reset the vertex attrib binding */
+   vertex_attrib_binding(ctx, ctx->Array.VAO, attrib, attrib);
+
+   /* The Stride and Ptr fields are not set by update_array_format() */
+   array = &ctx->Array.VAO->VertexAttrib[attrib];
+   array->Stride = stride;
+   array->Ptr = (const GLvoid *) ptr;
+
+   /* Update the vertex buffer binding */
+   effectiveStride = stride != 0 ? stride : array->_ElementSize;
+   _mesa_bind_vertex_buffer(ctx, ctx->Array.VAO, attrib,
+                            ctx->Array.ArrayBufferObj, (GLintptr) ptr,
+                            effectiveStride);
+}
+
+
 /**
  * Do error checking and update state for glVertex/Color/TexCoord/...Pointer
  * functions.
@@ -465,9 +492,6 @@ update_array(struct gl_context *ctx,
              GLboolean normalized, GLboolean integer, GLboolean doubles,
              const GLvoid *ptr)
 {
-   struct gl_vertex_attrib_array *array;
-   GLsizei effectiveStride;
-
    /* Page 407 (page 423 of the PDF) of the OpenGL 3.0 spec says:
     *
     *     "Client vertex arrays - all vertex array attribute pointers must
@@ -521,19 +545,7 @@ update_array(struct gl_context *ctx,
       return;
    }
 
-   /* Reset the vertex attrib binding */
-   vertex_attrib_binding(ctx, ctx->Array.VAO, attrib, attrib);
-
-   /* The Stride and Ptr fields are not set by update_array_format() */
-   array = &ctx->Array.VAO->VertexAttrib[attrib];
-   array->Stride = stride;
-   array->Ptr = (const GLvoid *) ptr;
-
-   /* Update the vertex buffer binding */
-   effectiveStride = stride != 0 ? stride : array->_ElementSize;
-   _mesa_bind_vertex_buffer(ctx, ctx->Array.VAO, attrib,
-                            ctx->Array.ArrayBufferObj, (GLintptr) ptr,
-                            effectiveStride);
+   update_array_pointer(ctx, attrib, stride, ptr);
 }
 
 
@@ -736,6 +748,29 @@ _mesa_VertexAttribPointer(GLuint index, GLint size, GLenum type,
 }
 
 
+/**
+ * glVertexAttribPointer for KHR_no_error contexts.
+ */
+void GLAPIENTRY
+_mesa_VertexAttribPointer_no_error(GLuint index, GLint size, GLenum type,
+                                   GLboolean normalized,
+                                   GLsizei stride, const GLvoid *ptr)
+{
+   GET_CURRENT_CONTEXT(ctx);
+   GLenum format = GL_RGBA;
+
+   if (size == GL_BGRA) {
+      format = GL_BGRA;
+      size = 4;
+   }
+
+   _mesa_update_array_format(ctx, ctx->Array.VAO, VERT_ATTRIB_GENERIC(index),
+                             size, type, format, normalized, GL_FALSE,
+                             GL_FALSE, 0, false);
+   update_array_pointer(ctx, VERT_ATTRIB_GENERIC(index), stride, ptr);
+}
+
+
 /**
  * GL_EXT_gpu_shader4 / GL 3.0.
  * Set an integer-valued vertex attribute array.
@@ -31,11 +31,13 @@
 
 #include <stdio.h>
 #include "main/compiler.h"
+#include "main/context.h"
 #include "main/mtypes.h"
 #include "main/shaderapi.h"
 #include "main/shaderobj.h"
 #include "main/uniforms.h"
 #include "glsl/ast.h"
+#include "glsl/blob.h"
 #include "glsl/ir.h"
 #include "glsl/ir_expression_flattening.h"
 #include "glsl/ir_visitor.h"
@@ -2938,13 +2940,150 @@ _mesa_ir_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
    return prog->LinkStatus;
 }
 
+static void
+write_binding(const char *name, unsigned value, void *closure)
+{
+   struct blob *blob = (struct blob *) closure;
+
+   blob_write_string(blob, name);
+   blob_write_uint32(blob, value);
+}
+
+static void
+write_bindings(struct blob *blob, struct string_to_uint_map *bindings)
+{
+   if (bindings)
+      bindings->iterate(write_binding, blob);
+   blob_write_string(blob, "");
+}
+
+/**
+ * Serialize everything a link of \c prog depends on: the compiled shaders
+ * and the state set by glBindAttribLocation, glBindFragDataLocation*,
+ * glTransformFeedbackVaryings and glProgramParameteri.
+ */
+static struct blob *
+get_link_inputs(struct gl_shader_program *prog)
+{
+   struct blob *blob = blob_create(prog);
+
+   if (blob == NULL)
+      return NULL;
+
+   blob_write_uint32(blob, prog->NumShaders);
+   for (unsigned i = 0; i < prog->NumShaders; i++)
+      blob_write_uint32(blob, prog->Shaders[i]->CompileSerial);
+
+   write_bindings(blob, prog->AttributeBindings);
+   write_bindings(blob, prog->FragDataBindings);
+   write_bindings(blob, prog->FragDataIndexBindings);
+
+   blob_write_uint32(blob, prog->TransformFeedback.BufferMode);
+   blob_write_uint32(blob, prog->TransformFeedback.NumVarying);
+   for (unsigned i = 0; i < prog->TransformFeedback.NumVarying; i++)
+      blob_write_string(blob, prog->TransformFeedback.VaryingNames[i]);
+
+   blob_write_uint32(blob, prog->SeparateShader);
+
+   return blob;
+}
+
+/**
+ * Put back the uniform values, sampler and image units and block bindings
+ * that the last link of \c prog left, as linking it again would.
+ */
+static void
+restore_link_defaults(struct gl_context *ctx, struct gl_shader_program *prog)
+{
+   FLUSH_VERTICES(ctx, _NEW_PROGRAM_CONSTANTS | _NEW_TEXTURE | _NEW_PROGRAM);
+   ctx->NewDriverState |= ctx->DriverFlags.NewUniformBuffer |
+                          ctx->DriverFlags.NewShaderStorageBuffer |
+                          ctx->DriverFlags.NewImageUnits;
+
+   if (prog->NumUniformDataSlots) {
+      memcpy(prog->UniformDataSlots, prog->UniformDataDefaults,
+             prog->NumUniformDataSlots * sizeof(union gl_constant_value));
+   }
+
+   for (unsigned i = 0; i < prog->NumUniformStorage; i++) {
+      struct gl_uniform_storage *uni = &prog->UniformStorage[i];
+      const unsigned count = MAX2(1, uni->array_elements);
+
+      if (uni->storage == NULL)
+         continue;
+
+      _mesa_propagate_uniforms_to_driver_storage(uni, 0, count);
+
+      for (unsigned stage = 0; stage < MESA_SHADER_STAGES; stage++) {
+         struct gl_shader *sh = prog->_LinkedShaders[stage];
+
+         if (sh == NULL || !uni->opaque[stage].active)
+            continue;
+
+         for (unsigned j = 0; j < count; j++) {
+            if (uni->type->is_sampler()) {
+               sh->SamplerUnits[uni->opaque[stage].index + j] =
+                  uni->storage[j].i;
+            } else if (uni->type->is_image()) {
+               sh->ImageUnits[uni->opaque[stage].index + j] =
+                  uni->storage[j].i;
+            }
+         }
+      }
+   }
+
+   for (unsigned stage = 0; stage < MESA_SHADER_STAGES; stage++) {
+      struct gl_shader *sh = prog->_LinkedShaders[stage];
+
+      if (sh == NULL)
+         continue;
+
+      for (unsigned i = 0; i < sh->NumBufferInterfaceBlocks; i++) {
+         sh->BufferInterfaceBlocks[i].Binding =
+            sh->BufferInterfaceBlocks[i].DefaultBinding;
+      }
+
+      if (sh->Program) {
+         memcpy(sh->Program->SamplerUnits, sh->SamplerUnits,
+                sizeof(sh->SamplerUnits));
+         _mesa_update_shader_textures_used(prog, sh->Program);
+         if (ctx->Driver.SamplerUniformChange)
+            ctx->Driver.SamplerUniformChange(ctx, sh->Program->Target,
+                                             sh->Program);
+      }
+   }
+
+   for (unsigned i = 0; i < prog->NumBufferInterfaceBlocks; i++) {
+      prog->BufferInterfaceBlocks[i].Binding =
+         prog->BufferInterfaceBlocks[i].DefaultBinding;
+   }
+}
+
 /**
  * Link a GLSL shader program.  Called via glLinkProgram().
+ *
+ * If nothing the link depends on changed since the last link of the
+ * program, the result of that link is kept and only the state a link
+ * resets is reset.  Applications commonly link again after setting
+ * bindings to the values they already had.
  */
 void
 _mesa_glsl_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
 {
    unsigned int i;
+   struct blob *inputs = get_link_inputs(prog);
+
+   if (inputs && prog->LinkInputs &&
+       inputs->size == prog->LinkInputs->size &&
+       memcmp(inputs->data, prog->LinkInputs->data, inputs->size) == 0) {
+      ralloc_free(inputs);
+      if (prog->LinkStatus)
+         restore_link_defaults(ctx, prog);
+      return;
+   }
+
+   ralloc_free(prog->LinkInputs);
+   prog->LinkInputs = inputs;
 
    _mesa_clear_shader_program_data(prog);
 
@@ -1441,3 +1441,663 @@ _mesa_execute_program(struct gl_context * ctx,
 
    return GL_TRUE;
 }
+
+
+/*
+ * Span interpreter.
+ *
+ * Straight-line fragment programs can be run for several fragments at
+ * once.  The registers hold one channel of PROG_SPAN_WIDTH fragments after
+ * another and every instruction is a simple loop over them, which the
+ * compiler turns into SIMD code.  The results are the same as those of
+ * _mesa_execute_program() for each fragment.
+ */
+
+typedef GLfloat span_vec4[4][PROG_SPAN_WIDTH];
+
+
+/**
+ * Can the given source register be read by the span interpreter?
+ */
+static GLboolean
+span_src_supported(const struct prog_instruction *inst,
+                   const struct prog_src_register *source)
+{
+   GLuint i;
+
+   if (source->RelAddr)
+      return GL_FALSE;
+
+   /* Only SWZ has the 0 and 1 swizzles */
+   if (inst->Opcode != OPCODE_SWZ) {
+      for (i = 0; i < 4; i++) {
+         if (GET_SWZ(source->Swizzle, i) > SWIZZLE_W)
+            return GL_FALSE;
+      }
+   }
+
+   switch (source->File) {
+   case PROGRAM_TEMPORARY:
+      return source->Index >= 0 && source->Index < MAX_PROGRAM_TEMPS;
+   case PROGRAM_INPUT:
+      return source->Index >= 0 && source->Index < VARYING_SLOT_MAX;
+   case PROGRAM_OUTPUT:
+      return source->Index >= 0 && source->Index < MAX_PROGRAM_OUTPUTS;
+   case PROGRAM_STATE_VAR:
+   case PROGRAM_CONSTANT:
+   case PROGRAM_UNIFORM:
+      return source->Index >= 0;
+   default:
+      return GL_FALSE;
+   }
+}
+
+
+/**
+ * Can the given program be run by _mesa_execute_program_span()?  This is
+ * the case for fragment programs without flow control, condition codes,
+ * address registers and the rarely used instructions.
+ */
+GLboolean
+_mesa_can_execute_program_span(const struct gl_program *program)
+{
+   GLuint pc, i;
+
+   if (program->Target != GL_FRAGMENT_PROGRAM_ARB)
+      return GL_FALSE;
+
+   for (pc = 0; pc < program->NumInstructions; pc++) {
+      const struct prog_instruction *inst = program->Instructions + pc;
+
+      switch (inst->Opcode) {
+      case OPCODE_ABS:
+      case OPCODE_ADD:
+      case OPCODE_CMP:
+      case OPCODE_COS:
+      case OPCODE_DDX:
+      case OPCODE_DDY:
+      case OPCODE_DP2:
+      case OPCODE_DP3:
+      case OPCODE_DP4:
+      case OPCODE_DPH:
+      case OPCODE_DST:
+      case OPCODE_EX2:
+      case OPCODE_FLR:
+      case OPCODE_FRC:
+      case OPCODE_KIL:
+      case OPCODE_LG2:
+      case OPCODE_LRP:
+      case OPCODE_MAD:
+      case OPCODE_MAX:
+      case OPCODE_MIN:
+      case OPCODE_MOV:
+      case OPCODE_MUL:
+      case OPCODE_NOP:
+      case OPCODE_POW:
+      case OPCODE_RCP:
+      case OPCODE_RSQ:
+      case OPCODE_SCS:
+      case OPCODE_SEQ:
+      case OPCODE_SGE:
+      case OPCODE_SGT:
+      case OPCODE_SIN:
+      case OPCODE_SLE:
+      case OPCODE_SLT:
+      case OPCODE_SNE:
+      case OPCODE_SSG:
+      case OPCODE_SUB:
+      case OPCODE_SWZ:
+      case OPCODE_TEX:
+      case OPCODE_TXB:
+      case OPCODE_TXP:
+      case OPCODE_XPD:
+      case OPCODE_END:
+         break;
+      default:
+         return GL_FALSE;
+      }
+
+      for (i = 0; i < _mesa_num_inst_src_regs(inst->Opcode); i++) {
+         if (!span_src_supported(inst, &inst->SrcReg[i]))
+            return GL_FALSE;
+      }
+
+      if (_mesa_num_inst_dst_regs(inst->Opcode)) {
+         const struct prog_dst_register *dest = &inst->DstReg;
+         if (inst->CondUpdate || dest->CondMask != COND_TR)
+            return GL_FALSE;
+         if (dest->RelAddr || dest->Index < 0)
+            return GL_FALSE;
+         if (dest->File == PROGRAM_TEMPORARY) {
+            if (dest->Index >= MAX_PROGRAM_TEMPS)
+               return GL_FALSE;
+         }
+         else if (dest->File == PROGRAM_OUTPUT) {
+            if (dest->Index >= MAX_PROGRAM_OUTPUTS)
+               return GL_FALSE;
+         }
+         else {
+            return GL_FALSE;
+         }
+      }
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Fetch the first 'size' channels of a source register for all the
+ * fragments, like fetch_vector4() and fetch_vector1().
+ */
+static void
+span_fetch(const struct prog_src_register *source,
+           const struct gl_program_machine *machine,
+           const struct gl_program_span_machine *span,
+           GLuint size, span_vec4 result)
+{
+   const struct gl_program *prog = machine->CurProgram;
+   const GLint reg = source->Index;
+   const GLfloat (*regs)[PROG_SPAN_WIDTH];
+   GLuint i, k;
+
+   switch (source->File) {
+   case PROGRAM_TEMPORARY:
+      regs = span->Temporaries[reg];
+      break;
+   case PROGRAM_INPUT:
+      regs = span->Inputs[reg];
+      break;
+   case PROGRAM_OUTPUT:
+      regs = span->Outputs[reg];
+      break;
+   default:
+      {
+         /* the same value for all the fragments */
+         const GLfloat *src = reg < (GLint) prog->Parameters->NumParameters ?
+            (GLfloat *) prog->Parameters->ParameterValues[reg] : ZeroVec;
+
+         for (i = 0; i < size; i++) {
+            GLfloat value = src[GET_SWZ(source->Swizzle, i)];
+            if (source->Abs)
+               value = fabsf(value);
+            if (source->Negate)
+               value = -value;
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               result[i][k] = value;
+         }
+      }
+      return;
+   }
+
+   for (i = 0; i < size; i++) {
+      const GLfloat *src = regs[GET_SWZ(source->Swizzle, i)];
+
+      if (source->Abs && source->Negate) {
+         for (k = 0; k < PROG_SPAN_WIDTH; k++)
+            result[i][k] = -fabsf(src[k]);
+      }
+      else if (source->Abs) {
+         for (k = 0; k < PROG_SPAN_WIDTH; k++)
+            result[i][k] = fabsf(src[k]);
+      }
+      else if (source->Negate) {
+         for (k = 0; k < PROG_SPAN_WIDTH; k++)
+            result[i][k] = -src[k];
+      }
+      else {
+         memcpy(result[i], src, sizeof(result[i]));
+      }
+   }
+}
+
+
+/**
+ * Store a result for all the fragments, like store_vector4().
+ */
+static void
+span_store(const struct prog_instruction *inst,
+           struct gl_program_span_machine *span, const span_vec4 value)
+{
+   const struct prog_dst_register *dstReg = &inst->DstReg;
+   GLfloat (*dst)[PROG_SPAN_WIDTH] = dstReg->File == PROGRAM_TEMPORARY ?
+      span->Temporaries[dstReg->Index] : span->Outputs[dstReg->Index];
+   GLuint i, k;
+
+   for (i = 0; i < 4; i++) {
+      if (!(dstReg->WriteMask & (1 << i)))
+         continue;
+
+      if (inst->Saturate) {
+         for (k = 0; k < PROG_SPAN_WIDTH; k++)
+            dst[i][k] = CLAMP(value[i][k], 0.0F, 1.0F);
+      }
+      else {
+         memcpy(dst[i], value[i], sizeof(dst[i]));
+      }
+   }
+}
+
+
+/**
+ * Store the scalar result in the x channel of 'value' to all the channels.
+ */
+static void
+span_store_scalar(const struct prog_instruction *inst,
+                  struct gl_program_span_machine *span, span_vec4 value)
+{
+   memcpy(value[1], value[0], sizeof(value[0]));
+   memcpy(value[2], value[0], sizeof(value[0]));
+   memcpy(value[3], value[0], sizeof(value[0]));
+   span_store(inst, span, value);
+}
+
+
+/**
+ * Run a fragment program on several fragments at once.  The gl_program_
+ * machine must have been set up as for _mesa_execute_program() with the
+ * first fragment as the current element; the others follow it in the
+ * attribute arrays.
+ * \param span  register storage
+ * \param count  number of fragments, at most PROG_SPAN_WIDTH
+ * \param mask  which fragments are alive; killed ones are cleared
+ */
+void
+_mesa_execute_program_span(struct gl_context *ctx,
+                           const struct gl_program *program,
+                           struct gl_program_machine *machine,
+                           struct gl_program_span_machine *span,
+                           GLuint count, GLubyte mask[])
+{
+   const GLuint numInst = program->NumInstructions;
+   const GLuint start = machine->CurElement;
+   GLbitfield64 inputs = program->InputsRead;
+   span_vec4 a, b, c, r;
+   GLuint pc, i, k;
+
+   assert(count <= PROG_SPAN_WIDTH);
+
+   machine->CurProgram = program;
+   machine->EnvParams = ctx->FragmentProgram.Parameters;
+
+   /* the per-fragment instructions only set the first 'count' results */
+   memset(r, 0, sizeof(r));
+
+   while (inputs) {
+      const GLuint attr = u_bit_scan64(&inputs);
+      for (k = 0; k < count; k++) {
+         const GLfloat *attrib = machine->Attribs[attr][start + k];
+         span->Inputs[attr][0][k] = attrib[0];
+         span->Inputs[attr][1][k] = attrib[1];
+         span->Inputs[attr][2][k] = attrib[2];
+         span->Inputs[attr][3][k] = attrib[3];
+      }
+   }
+
+   for (pc = 0; pc < numInst; pc++) {
+      const struct prog_instruction *inst = program->Instructions + pc;
+
+      switch (inst->Opcode) {
+      case OPCODE_ABS:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = fabsf(a[i][k]);
+         span_store(inst, span, r);
+         break;
+      case OPCODE_ADD:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = a[i][k] + b[i][k];
+         span_store(inst, span, r);
+         break;
+      case OPCODE_CMP:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         span_fetch(&inst->SrcReg[2], machine, span, 4, c);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = a[i][k] < 0.0F ? b[i][k] : c[i][k];
+         span_store(inst, span, r);
+         break;
+      case OPCODE_COS:
+         span_fetch(&inst->SrcReg[0], machine, span, 1, a);
+         for (k = 0; k < count; k++)
+            r[0][k] = cosf(a[0][k]);
+         span_store_scalar(inst, span, r);
+         break;
+      case OPCODE_DDX:
+      case OPCODE_DDY:
+         for (k = 0; k < count; k++) {
+            GLfloat result[4];
+            machine->CurElement = start + k;
+            fetch_vector4_deriv(ctx, &inst->SrcReg[0], machine,
+                                inst->Opcode == OPCODE_DDX ? 'X' : 'Y',
+                                result);
+            for (i = 0; i < 4; i++)
+               r[i][k] = result[i];
+         }
+         machine->CurElement = start;
+         span_store(inst, span, r);
+         break;
+      case OPCODE_DP2:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (k = 0; k < PROG_SPAN_WIDTH; k++)
+            r[0][k] = a[0][k] * b[0][k] + a[1][k] * b[1][k];
+         span_store_scalar(inst, span, r);
+         break;
+      case OPCODE_DP3:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (k = 0; k < PROG_SPAN_WIDTH; k++)
+            r[0][k] = a[0][k] * b[0][k] + a[1][k] * b[1][k]
+                    + a[2][k] * b[2][k];
+         span_store_scalar(inst, span, r);
+         break;
+      case OPCODE_DP4:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (k = 0; k < PROG_SPAN_WIDTH; k++)
+            r[0][k] = a[0][k] * b[0][k] + a[1][k] * b[1][k]
+                    + a[2][k] * b[2][k] + a[3][k] * b[3][k];
+         span_store_scalar(inst, span, r);
+         break;
+      case OPCODE_DPH:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (k = 0; k < PROG_SPAN_WIDTH; k++)
+            r[0][k] = a[0][k] * b[0][k] + a[1][k] * b[1][k]
+                    + a[2][k] * b[2][k] + b[3][k];
+         span_store_scalar(inst, span, r);
+         break;
+      case OPCODE_DST:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (k = 0; k < PROG_SPAN_WIDTH; k++) {
+            r[0][k] = 1.0F;
+            r[1][k] = a[1][k] * b[1][k];
+            r[2][k] = a[2][k];
+            r[3][k] = b[3][k];
+         }
+         span_store(inst, span, r);
+         break;
+      case OPCODE_EX2:
+         span_fetch(&inst->SrcReg[0], machine, span, 1, a);
+         for (k = 0; k < count; k++)
+            r[0][k] = exp2f(a[0][k]);
+         span_store_scalar(inst, span, r);
+         break;
+      case OPCODE_FLR:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = floorf(a[i][k]);
+         span_store(inst, span, r);
+         break;
+      case OPCODE_FRC:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = a[i][k] - floorf(a[i][k]);
+         span_store(inst, span, r);
+         break;
+      case OPCODE_KIL:
+         {
+            GLboolean alive = GL_FALSE;
+
+            span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+            for (k = 0; k < count; k++) {
+               if (a[0][k] < 0.0F || a[1][k] < 0.0F ||
+                   a[2][k] < 0.0F || a[3][k] < 0.0F)
+                  mask[k] = GL_FALSE;
+               alive |= mask[k];
+            }
+            if (!alive)
+               return;
+         }
+         break;
+      case OPCODE_LG2:
+         span_fetch(&inst->SrcReg[0], machine, span, 1, a);
+         for (k = 0; k < count; k++) {
+            if (a[0][k] == 0.0F)
+               r[0][k] = -FLT_MAX;
+            else
+               r[0][k] = logf(a[0][k]) * 1.442695F;
+         }
+         span_store_scalar(inst, span, r);
+         break;
+      case OPCODE_LRP:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         span_fetch(&inst->SrcReg[2], machine, span, 4, c);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = a[i][k] * b[i][k] + (1.0F - a[i][k]) * c[i][k];
+         span_store(inst, span, r);
+         break;
+      case OPCODE_MAD:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         span_fetch(&inst->SrcReg[2], machine, span, 4, c);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = a[i][k] * b[i][k] + c[i][k];
+         span_store(inst, span, r);
+         break;
+      case OPCODE_MAX:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = MAX2(a[i][k], b[i][k]);
+         span_store(inst, span, r);
+         break;
+      case OPCODE_MIN:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = MIN2(a[i][k], b[i][k]);
+         span_store(inst, span, r);
+         break;
+      case OPCODE_MOV:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, r);
+         span_store(inst, span, r);
+         break;
+      case OPCODE_MUL:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = a[i][k] * b[i][k];
+         span_store(inst, span, r);
+         break;
+      case OPCODE_NOP:
+         break;
+      case OPCODE_POW:
+         span_fetch(&inst->SrcReg[0], machine, span, 1, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 1, b);
+         for (k = 0; k < count; k++)
+            r[0][k] = powf(a[0][k], b[0][k]);
+         span_store_scalar(inst, span, r);
+         break;
+      case OPCODE_RCP:
+         span_fetch(&inst->SrcReg[0], machine, span, 1, a);
+         for (k = 0; k < PROG_SPAN_WIDTH; k++)
+            r[0][k] = 1.0F / a[0][k];
+         span_store_scalar(inst, span, r);
+         break;
+      case OPCODE_RSQ:
+         span_fetch(&inst->SrcReg[0], machine, span, 1, a);
+         for (k = 0; k < PROG_SPAN_WIDTH; k++)
+            r[0][k] = 1.0f / sqrtf(fabsf(a[0][k]));
+         span_store_scalar(inst, span, r);
+         break;
+      case OPCODE_SCS:
+         span_fetch(&inst->SrcReg[0], machine, span, 1, a);
+         for (k = 0; k < count; k++) {
+            r[0][k] = cosf(a[0][k]);
+            r[1][k] = sinf(a[0][k]);
+            r[2][k] = 0.0F;
+            r[3][k] = 0.0F;
+         }
+         span_store(inst, span, r);
+         break;
+      case OPCODE_SEQ:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = (a[i][k] == b[i][k]) ? 1.0F : 0.0F;
+         span_store(inst, span, r);
+         break;
+      case OPCODE_SGE:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = (a[i][k] >= b[i][k]) ? 1.0F : 0.0F;
+         span_store(inst, span, r);
+         break;
+      case OPCODE_SGT:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = (a[i][k] > b[i][k]) ? 1.0F : 0.0F;
+         span_store(inst, span, r);
+         break;
+      case OPCODE_SIN:
+         span_fetch(&inst->SrcReg[0], machine, span, 1, a);
+         for (k = 0; k < count; k++)
+            r[0][k] = sinf(a[0][k]);
+         span_store_scalar(inst, span, r);
+         break;
+      case OPCODE_SLE:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = (a[i][k] <= b[i][k]) ? 1.0F : 0.0F;
+         span_store(inst, span, r);
+         break;
+      case OPCODE_SLT:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = (a[i][k] < b[i][k]) ? 1.0F : 0.0F;
+         span_store(inst, span, r);
+         break;
+      case OPCODE_SNE:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = (a[i][k] != b[i][k]) ? 1.0F : 0.0F;
+         span_store(inst, span, r);
+         break;
+      case OPCODE_SSG:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = (GLfloat) ((a[i][k] > 0.0F) - (a[i][k] < 0.0F));
+         span_store(inst, span, r);
+         break;
+      case OPCODE_SUB:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (i = 0; i < 4; i++)
+            for (k = 0; k < PROG_SPAN_WIDTH; k++)
+               r[i][k] = a[i][k] - b[i][k];
+         span_store(inst, span, r);
+         break;
+      case OPCODE_SWZ:
+         {
+            const struct prog_src_register *source = &inst->SrcReg[0];
+            struct prog_src_register xyzw = *source;
+
+            /* fetch the register as is, then pick the channels */
+            xyzw.Swizzle = SWIZZLE_NOOP;
+            xyzw.Abs = GL_FALSE;
+            xyzw.Negate = NEGATE_NONE;
+            span_fetch(&xyzw, machine, span, 4, a);
+
+            for (i = 0; i < 4; i++) {
+               const GLuint swz = GET_SWZ(source->Swizzle, i);
+               const GLfloat sign = (source->Negate & (1 << i)) ? -1.0F : 1.0F;
+
+               for (k = 0; k < PROG_SPAN_WIDTH; k++) {
+                  if (swz == SWIZZLE_ZERO)
+                     r[i][k] = 0.0F;
+                  else if (swz == SWIZZLE_ONE)
+                     r[i][k] = 1.0F;
+                  else
+                     r[i][k] = a[swz][k];
+                  if (sign < 0.0F)
+                     r[i][k] = -r[i][k];
+               }
+            }
+            span_store(inst, span, r);
+         }
+         break;
+      case OPCODE_TEX:
+      case OPCODE_TXB:
+      case OPCODE_TXP:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         for (k = 0; k < PROG_SPAN_WIDTH; k++) {
+            GLfloat texcoord[4], color[4], lodBias = 0.0F;
+
+            if (k >= count || !mask[k]) {
+               r[0][k] = r[1][k] = r[2][k] = r[3][k] = 0.0F;
+               continue;
+            }
+
+            texcoord[0] = a[0][k];
+            texcoord[1] = a[1][k];
+            texcoord[2] = a[2][k];
+            texcoord[3] = a[3][k];
+
+            if (inst->Opcode == OPCODE_TEX) {
+               texcoord[3] = 1.0f;
+            }
+            else if (inst->Opcode == OPCODE_TXB) {
+               lodBias = texcoord[3];
+            }
+            else if (texcoord[3] != 0.0F) {
+               texcoord[0] /= texcoord[3];
+               texcoord[1] /= texcoord[3];
+               texcoord[2] /= texcoord[3];
+            }
+
+            fetch_texel(ctx, machine, inst, texcoord, lodBias, color);
+            r[0][k] = color[0];
+            r[1][k] = color[1];
+            r[2][k] = color[2];
+            r[3][k] = color[3];
+         }
+         span_store(inst, span, r);
+         break;
+      case OPCODE_XPD:
+         span_fetch(&inst->SrcReg[0], machine, span, 4, a);
+         span_fetch(&inst->SrcReg[1], machine, span, 4, b);
+         for (k = 0; k < PROG_SPAN_WIDTH; k++) {
+            r[0][k] = a[1][k] * b[2][k] - a[2][k] * b[1][k];
+            r[1][k] = a[2][k] * b[0][k] - a[0][k] * b[2][k];
+            r[2][k] = a[0][k] * b[1][k] - a[1][k] * b[0][k];
+            r[3][k] = 1.0F;
+         }
+         span_store(inst, span, r);
+         break;
+      case OPCODE_END:
+         return;
+      default:
+         _mesa_problem(ctx, "Bad opcode %d in _mesa_execute_program_span",
+                       inst->Opcode);
+         return;
+      }
+   }
+}
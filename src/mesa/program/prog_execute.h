@@ -84,4 +84,32 @@ _mesa_execute_program(struct gl_context *ctx,
                       struct gl_program_machine *machine);
 
 
+/** Number of fragments run together by _mesa_execute_program_span() */
+#define PROG_SPAN_WIDTH 16
+
+
+/**
+ * Registers used by _mesa_execute_program_span().  Each register holds
+ * one channel of PROG_SPAN_WIDTH fragments after another, so that every
+ * instruction is a loop over contiguous floats.
+ */
+struct gl_program_span_machine
+{
+   GLfloat Inputs[VARYING_SLOT_MAX][4][PROG_SPAN_WIDTH];
+   GLfloat Temporaries[MAX_PROGRAM_TEMPS][4][PROG_SPAN_WIDTH];
+   GLfloat Outputs[MAX_PROGRAM_OUTPUTS][4][PROG_SPAN_WIDTH];
+};
+
+
+extern GLboolean
+_mesa_can_execute_program_span(const struct gl_program *program);
+
+extern void
+_mesa_execute_program_span(struct gl_context *ctx,
+                           const struct gl_program *program,
+                           struct gl_program_machine *machine,
+                           struct gl_program_span_machine *span,
+                           GLuint count, GLubyte mask[]);
+
+
 #endif /* PROG_EXECUTE_H */
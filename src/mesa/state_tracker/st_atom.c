@@ -31,9 +31,11 @@
 #include "main/context.h"
 
 #include "pipe/p_defines.h"
+#include "util/u_math.h"
 #include "st_context.h"
 #include "st_atom.h"
 #include "st_cb_bitmap.h"
+#include "st_debug.h"
 #include "st_program.h"
 #include "st_manager.h"
 
@@ -84,15 +86,42 @@ static const struct st_tracked_state *atoms[] =
 };
 
 
+/**
+ * Build the masks of atoms depending on each state flag, so that
+ * st_validate_state() only has to look at the flags which are set.
+ */
 void st_init_atoms( struct st_context *st )
 {
-   /* no-op */
+   unsigned i, bit;
+
+   STATIC_ASSERT(ARRAY_SIZE(atoms) <= ST_MAX_ATOMS);
+
+   for (i = 0; i < ARRAY_SIZE(atoms); i++) {
+      for (bit = 0; bit < 32; bit++) {
+         if (atoms[i]->dirty.mesa & (1u << bit))
+            st->atoms_for_mesa_flag[bit] |= 1ull << i;
+      }
+      for (bit = 0; bit < 64; bit++) {
+         if (atoms[i]->dirty.st & (1ull << bit))
+            st->atoms_for_st_flag[bit] |= 1ull << i;
+      }
+   }
+
+   memset(&st->last_dirty, 0, sizeof(st->last_dirty));
+   st->last_atoms = 0;
 }
 
 
 void st_destroy_atoms( struct st_context *st )
 {
-   /* no-op */
+   GLuint i;
+
+   if (ST_DEBUG & DEBUG_ATOMS) {
+      debug_printf("st: %u state validations\n", st->num_validations);
+      for (i = 0; i < ARRAY_SIZE(atoms); i++)
+         debug_printf("st:   %-30s %u\n", atoms[i]->name,
+                      st->atom_invocations[i]);
+   }
 }
 
 
@@ -106,6 +135,27 @@ static GLboolean check_state( const struct st_state_flags *a,
 	   (a->st & b->st));
 }
 
+/**
+ * Return the mask of atoms which need to run for the given dirty flags.
+ */
+static uint64_t get_dirty_atoms( const struct st_context *st,
+                                 const struct st_state_flags *state )
+{
+   uint64_t dirty_atoms = 0;
+   unsigned mesa = state->mesa;
+   uint64_t flags = state->st;
+
+   while (mesa)
+      dirty_atoms |= st->atoms_for_mesa_flag[u_bit_scan(&mesa)];
+
+   while (flags) {
+      dirty_atoms |= st->atoms_for_st_flag[ffsll(flags) - 1];
+      flags &= flags - 1;
+   }
+
+   return dirty_atoms;
+}
+
 static void accumulate_state( struct st_state_flags *a,
 			      const struct st_state_flags *b )
 {
@@ -173,6 +223,7 @@ static void check_attrib_edgeflag(struct st_context *st)
 void st_validate_state( struct st_context *st )
 {
    struct st_state_flags *state = &st->dirty;
+   uint64_t dirty_atoms;
    GLuint i;
 
    /* Get Mesa driver state. */
@@ -193,6 +244,17 @@ void st_validate_state( struct st_context *st )
 
    /*printf("%s %x/%x\n", __func__, state->mesa, state->st);*/
 
+   /* Applications tend to change the same state between draws over and
+    * over, so remember the atoms needed for the last set of flags.
+    */
+   if (state->mesa != st->last_dirty.mesa ||
+       state->st != st->last_dirty.st) {
+      st->last_dirty = *state;
+      st->last_atoms = get_dirty_atoms(st, state);
+   }
+   dirty_atoms = st->last_atoms;
+   st->num_validations++;
+
 #ifdef DEBUG
    if (1) {
 #else
@@ -218,7 +280,12 @@ void st_validate_state( struct st_context *st )
 	    assert(0);
 	 }
 
+	 /* The precomputed masks have to agree with the atom's flags. */
+	 assert(check_state(state, &atom->dirty) ==
+		!!(get_dirty_atoms(st, state) & (1ull << i)));
+
 	 if (check_state(state, &atom->dirty)) {
+	    st->atom_invocations[i]++;
 	    atoms[i]->update( st );
 	    /*printf("after: %x\n", atom->dirty.mesa);*/
 	 }
@@ -237,9 +304,18 @@ void st_validate_state( struct st_context *st )
 
    }
    else {
-      for (i = 0; i < ARRAY_SIZE(atoms); i++) {	 
-	 if (check_state(state, &atoms[i]->dirty))
-	    atoms[i]->update( st );
+      while (dirty_atoms) {
+         const struct st_state_flags prev = *state;
+
+         i = ffsll(dirty_atoms) - 1;
+         dirty_atoms &= dirty_atoms - 1;
+
+         st->atom_invocations[i]++;
+         atoms[i]->update( st );
+
+         /* An atom may flag state for the atoms after it. */
+         if (state->mesa != prev.mesa || state->st != prev.st)
+            dirty_atoms |= get_dirty_atoms(st, state) & ~((2ull << i) - 1);
       }
    }
 
@@ -43,6 +43,7 @@
 #include "st_program.h"
 
 #include "cso_cache/cso_context.h"
+#include "util/u_inlines.h"
 #include "util/u_math.h"
 #include "main/bufferobj.h"
 #include "main/glformats.h"
@@ -571,6 +572,7 @@ setup_non_interleaved_attribs(struct st_context *st,
          vbuffer[attr].buffer = NULL;
          vbuffer[attr].user_buffer = NULL;
          vbuffer[attr].buffer_offset = 0;
+         vbuffer[attr].stride = 0;
          continue;
       }
 
@@ -633,6 +635,85 @@ setup_non_interleaved_attribs(struct st_context *st,
    return TRUE;
 }
 
+static bool
+vertex_buffers_equal(const struct pipe_vertex_buffer *a,
+                     const struct pipe_vertex_buffer *b)
+{
+   /* User buffers may have new contents behind the same pointer, so they
+    * always have to be set again.
+    */
+   return !a->user_buffer && !b->user_buffer &&
+          a->buffer == b->buffer &&
+          a->buffer_offset == b->buffer_offset &&
+          a->stride == b->stride;
+}
+
+/**
+ * Binds the vertex buffers, skipping the slots that already have the same
+ * buffer bound from the last call, and unbinds the slots no longer used.
+ */
+static void
+set_vertex_buffers(struct st_context *st,
+                   const struct pipe_vertex_buffer *vbuffer,
+                   unsigned num_vbuffers)
+{
+   unsigned first = num_vbuffers, end = 0;
+   unsigned i;
+
+   for (i = 0; i < num_vbuffers; i++) {
+      if (i < st->last_num_vbuffers &&
+          vertex_buffers_equal(&vbuffer[i], &st->last_vbuffers[i]))
+         continue;
+
+      first = MIN2(first, i);
+      end = i + 1;
+   }
+
+   if (first < end)
+      cso_set_vertex_buffers(st->cso_context, first, end - first,
+                             vbuffer + first);
+
+   if (st->last_num_vbuffers > num_vbuffers) {
+      /* Unbind remaining buffers, if any. */
+      cso_set_vertex_buffers(st->cso_context, num_vbuffers,
+                             st->last_num_vbuffers - num_vbuffers, NULL);
+   }
+
+   for (i = first; i < end; i++) {
+      pipe_resource_reference(&st->last_vbuffers[i].buffer,
+                              vbuffer[i].buffer);
+      st->last_vbuffers[i].user_buffer = vbuffer[i].user_buffer;
+      st->last_vbuffers[i].buffer_offset = vbuffer[i].buffer_offset;
+      st->last_vbuffers[i].stride = vbuffer[i].stride;
+   }
+   for (i = num_vbuffers; i < st->last_num_vbuffers; i++)
+      pipe_resource_reference(&st->last_vbuffers[i].buffer, NULL);
+
+   st->last_num_vbuffers = num_vbuffers;
+}
+
+/**
+ * Binds the vertex elements, unless they are the ones bound by the last
+ * call.  Meta operations in the state tracker save and restore the vertex
+ * elements around their own, so this avoids hashing the same layout for
+ * the CSO cache on every array or program change.
+ */
+static void
+set_vertex_elements(struct st_context *st,
+                    const struct pipe_vertex_element *velements,
+                    unsigned num_velements)
+{
+   if (num_velements == st->last_num_velements &&
+       memcmp(velements, st->last_velements,
+              num_velements * sizeof(velements[0])) == 0)
+      return;
+
+   cso_set_vertex_elements(st->cso_context, num_velements, velements);
+   memcpy(st->last_velements, velements,
+          num_velements * sizeof(velements[0]));
+   st->last_num_velements = num_velements;
+}
+
 static void update_array(struct st_context *st)
 {
    struct gl_context *ctx = st->ctx;
@@ -678,14 +759,8 @@ static void update_array(struct st_context *st)
       num_vbuffers = vpv->num_inputs;
    }
 
-   cso_set_vertex_buffers(st->cso_context, 0, num_vbuffers, vbuffer);
-   if (st->last_num_vbuffers > num_vbuffers) {
-      /* Unbind remaining buffers, if any. */
-      cso_set_vertex_buffers(st->cso_context, num_vbuffers,
-                             st->last_num_vbuffers - num_vbuffers, NULL);
-   }
-   st->last_num_vbuffers = num_vbuffers;
-   cso_set_vertex_elements(st->cso_context, num_velements, velements);
+   set_vertex_buffers(st, vbuffer, num_vbuffers);
+   set_vertex_elements(st, velements, num_velements);
 }
 
 
@@ -38,6 +38,7 @@
 #include "pipe/p_context.h"
 #include "pipe/p_defines.h"
 #include "util/u_inlines.h"
+#include "util/u_memory.h"
 #include "util/u_upload_mgr.h"
 #include "cso_cache/cso_context.h"
 
@@ -48,6 +49,37 @@
 #include "st_program.h"
 #include "st_cb_bufferobjects.h"
 
+/**
+ * Return whether the parameters are the same as the constants bound for the
+ * shader stage, and otherwise remember them as the bound ones.
+ */
+static boolean
+constants_unchanged(struct st_context *st,
+                    const struct gl_program_parameter_list *params,
+                    unsigned shader_type, unsigned size)
+{
+   void **shadow = &st->state.constants[shader_type].shadow;
+   unsigned *shadow_size = &st->state.constants[shader_type].shadow_size;
+
+   /* Without an uploader the driver may keep pointing at the values. */
+   if (st->state.constants[shader_type].ptr == params->ParameterValues &&
+       st->state.constants[shader_type].size == size &&
+       *shadow_size >= size &&
+       memcmp(*shadow, params->ParameterValues, size) == 0)
+      return TRUE;
+
+   if (*shadow_size < size) {
+      FREE(*shadow);
+      *shadow = MALLOC(size);
+      *shadow_size = *shadow ? size : 0;
+   }
+   if (*shadow)
+      memcpy(*shadow, params->ParameterValues, size);
+
+   return FALSE;
+}
+
+
 /**
  * Pass the given program parameters to the graphics pipe as a
  * constant buffer.
@@ -76,6 +108,17 @@ void st_upload_constants( struct st_context *st,
       if (params->StateFlags)
          _mesa_load_state_parameters(st->ctx, params);
 
+      /* Applications often set the same uniforms over and over, and any
+       * change of a program's constants flags the constants of all the
+       * stages.  Don't upload and rebind the constants if they're the same
+       * as those bound.
+       */
+      if (constants_unchanged(st, params, shader_type, paramBytes)) {
+         if (ST_DEBUG & DEBUG_CONSTANTS)
+            debug_printf("%s(shader=%d): unchanged\n", __func__, shader_type);
+         return;
+      }
+
       /* We always need to get a new buffer, to keep the drivers simple and
        * avoid gratuitous rendering synchronization.
        * Let's use a user buffer to avoid an unnecessary copy.
@@ -36,6 +36,7 @@
 #include "st_context.h"
 #include "st_atom.h"
 #include "st_cb_bitmap.h"
+#include "st_cb_clear.h"
 #include "st_cb_fbo.h"
 #include "st_texture.h"
 #include "pipe/p_context.h"
@@ -77,6 +78,7 @@ update_framebuffer_state( struct st_context *st )
    GLuint i;
 
    st_flush_bitmap_cache(st);
+   st_flush_clear(st);
 
    st->state.fb_orientation = st_fb_orientation(fb);
    framebuffer->width  = UINT_MAX;
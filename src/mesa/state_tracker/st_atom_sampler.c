@@ -240,12 +240,15 @@ update_shader_samplers(struct st_context *st,
                        const struct gl_program *prog,
                        unsigned max_units,
                        struct pipe_sampler_state *samplers,
-                       unsigned *num_samplers)
+                       unsigned *num_samplers,
+                       GLbitfield *samplers_bound)
 {
    GLuint unit;
    GLbitfield samplers_used;
    const GLuint old_max = *num_samplers;
    const struct pipe_sampler_state *states[PIPE_MAX_SAMPLERS];
+   GLbitfield bound = 0x0;
+   boolean changed = FALSE;
 
    samplers_used = prog->SamplersUsed;
 
@@ -260,13 +263,21 @@ update_shader_samplers(struct st_context *st,
 
       if (samplers_used & 1) {
          const GLuint texUnit = prog->SamplerUnits[unit];
+         struct pipe_sampler_state new_sampler;
 
-         convert_sampler(st, sampler, texUnit);
+         convert_sampler(st, &new_sampler, texUnit);
+         if (!(*samplers_bound & (1u << unit)) ||
+             memcmp(sampler, &new_sampler, sizeof(new_sampler)) != 0) {
+            *sampler = new_sampler;
+            changed = TRUE;
+         }
          states[unit] = sampler;
+         bound |= 1u << unit;
          *num_samplers = unit + 1;
       }
       else if (samplers_used != 0 || unit < old_max) {
          states[unit] = NULL;
+         changed |= (*samplers_bound & (1u << unit)) != 0;
       }
       else {
          /* if we've reset all the old samplers and we have no more new ones */
@@ -274,6 +285,14 @@ update_shader_samplers(struct st_context *st,
       }
    }
 
+   /* Looking up the sampler CSOs is the expensive part, skip it if no unit
+    * changed.  Anything else binding samplers through the CSO context
+    * restores ours.
+    */
+   *samplers_bound = bound;
+   if (!changed && *num_samplers == old_max)
+      return;
+
    cso_set_samplers(st->cso_context, shader_stage, *num_samplers, states);
 }
 
@@ -288,14 +307,16 @@ update_samplers(struct st_context *st)
                           &ctx->FragmentProgram._Current->Base,
                           ctx->Const.Program[MESA_SHADER_FRAGMENT].MaxTextureImageUnits,
                           st->state.samplers[PIPE_SHADER_FRAGMENT],
-                          &st->state.num_samplers[PIPE_SHADER_FRAGMENT]);
+                          &st->state.num_samplers[PIPE_SHADER_FRAGMENT],
+                          &st->state.samplers_bound[PIPE_SHADER_FRAGMENT]);
 
    update_shader_samplers(st,
                           PIPE_SHADER_VERTEX,
                           &ctx->VertexProgram._Current->Base,
                           ctx->Const.Program[MESA_SHADER_VERTEX].MaxTextureImageUnits,
                           st->state.samplers[PIPE_SHADER_VERTEX],
-                          &st->state.num_samplers[PIPE_SHADER_VERTEX]);
+                          &st->state.num_samplers[PIPE_SHADER_VERTEX],
+                          &st->state.samplers_bound[PIPE_SHADER_VERTEX]);
 
    if (ctx->GeometryProgram._Current) {
       update_shader_samplers(st,
@@ -303,7 +324,8 @@ update_samplers(struct st_context *st)
                              &ctx->GeometryProgram._Current->Base,
                              ctx->Const.Program[MESA_SHADER_GEOMETRY].MaxTextureImageUnits,
                              st->state.samplers[PIPE_SHADER_GEOMETRY],
-                             &st->state.num_samplers[PIPE_SHADER_GEOMETRY]);
+                             &st->state.num_samplers[PIPE_SHADER_GEOMETRY],
+                             &st->state.samplers_bound[PIPE_SHADER_GEOMETRY]);
    }
    if (ctx->TessCtrlProgram._Current) {
       update_shader_samplers(st,
@@ -311,7 +333,8 @@ update_samplers(struct st_context *st)
                              &ctx->TessCtrlProgram._Current->Base,
                              ctx->Const.Program[MESA_SHADER_TESS_CTRL].MaxTextureImageUnits,
                              st->state.samplers[PIPE_SHADER_TESS_CTRL],
-                             &st->state.num_samplers[PIPE_SHADER_TESS_CTRL]);
+                             &st->state.num_samplers[PIPE_SHADER_TESS_CTRL],
+                             &st->state.samplers_bound[PIPE_SHADER_TESS_CTRL]);
    }
    if (ctx->TessEvalProgram._Current) {
       update_shader_samplers(st,
@@ -319,7 +342,8 @@ update_samplers(struct st_context *st)
                              &ctx->TessEvalProgram._Current->Base,
                              ctx->Const.Program[MESA_SHADER_TESS_EVAL].MaxTextureImageUnits,
                              st->state.samplers[PIPE_SHADER_TESS_EVAL],
-                             &st->state.num_samplers[PIPE_SHADER_TESS_EVAL]);
+                             &st->state.num_samplers[PIPE_SHADER_TESS_EVAL],
+                             &st->state.samplers_bound[PIPE_SHADER_TESS_EVAL]);
    }
 }
 
@@ -214,25 +214,6 @@ get_texture_format_swizzle(const struct st_texture_object *stObj,
 }
 
 
-/**
- * Return TRUE if the texture's sampler view swizzle is not equal to
- * the texture's swizzle.
- *
- * \param stObj  the st texture object,
- */
-static boolean
-check_sampler_swizzle(const struct st_texture_object *stObj,
-		      struct pipe_sampler_view *sv, unsigned glsl_version)
-{
-   unsigned swizzle = get_texture_format_swizzle(stObj, glsl_version);
-
-   return ((sv->swizzle_r != GET_SWZ(swizzle, 0)) ||
-           (sv->swizzle_g != GET_SWZ(swizzle, 1)) ||
-           (sv->swizzle_b != GET_SWZ(swizzle, 2)) ||
-           (sv->swizzle_a != GET_SWZ(swizzle, 3)));
-}
-
-
 static unsigned last_level(struct st_texture_object *stObj)
 {
    unsigned ret = MIN2(stObj->base.MinLevel + stObj->base._MaxLevel,
@@ -250,16 +231,20 @@ static unsigned last_layer(struct st_texture_object *stObj)
    return stObj->pt->array_size - 1;
 }
 
-static struct pipe_sampler_view *
-st_create_texture_sampler_view_from_stobj(struct pipe_context *pipe,
-					  struct st_texture_object *stObj,
-					  enum pipe_format format,
-                                          unsigned glsl_version)
+/**
+ * Set up the template of the sampler view needed to sample the texture with
+ * the given format.  Returns FALSE if the texture can't be sampled (an empty
+ * buffer range).
+ */
+static boolean
+st_init_sampler_view_template_from_stobj(struct st_texture_object *stObj,
+                                         enum pipe_format format,
+                                         unsigned glsl_version,
+                                         struct pipe_sampler_view *templ)
 {
-   struct pipe_sampler_view templ;
    unsigned swizzle = get_texture_format_swizzle(stObj, glsl_version);
 
-   u_sampler_view_default_template(&templ,
+   u_sampler_view_default_template(templ,
                                    stObj->pt,
                                    format);
 
@@ -267,37 +252,37 @@ st_create_texture_sampler_view_from_stobj(struct pipe_context *pipe,
       unsigned base, size;
       unsigned f, n;
       const struct util_format_description *desc
-         = util_format_description(templ.format);
+         = util_format_description(templ->format);
 
       base = stObj->base.BufferOffset;
       if (base >= stObj->pt->width0)
-         return NULL;
+         return FALSE;
       size = MIN2(stObj->pt->width0 - base, (unsigned)stObj->base.BufferSize);
 
       f = (base / (desc->block.bits / 8)) * desc->block.width;
       n = (size / (desc->block.bits / 8)) * desc->block.width;
       if (!n)
-         return NULL;
-      templ.u.buf.first_element = f;
-      templ.u.buf.last_element  = f + (n - 1);
+         return FALSE;
+      templ->u.buf.first_element = f;
+      templ->u.buf.last_element  = f + (n - 1);
    } else {
-      templ.u.tex.first_level = stObj->base.MinLevel + stObj->base.BaseLevel;
-      templ.u.tex.last_level = last_level(stObj);
-      assert(templ.u.tex.first_level <= templ.u.tex.last_level);
-      templ.u.tex.first_layer = stObj->base.MinLayer;
-      templ.u.tex.last_layer = last_layer(stObj);
-      assert(templ.u.tex.first_layer <= templ.u.tex.last_layer);
-      templ.target = gl_target_to_pipe(stObj->base.Target);
+      templ->u.tex.first_level = stObj->base.MinLevel + stObj->base.BaseLevel;
+      templ->u.tex.last_level = last_level(stObj);
+      assert(templ->u.tex.first_level <= templ->u.tex.last_level);
+      templ->u.tex.first_layer = stObj->base.MinLayer;
+      templ->u.tex.last_layer = last_layer(stObj);
+      assert(templ->u.tex.first_layer <= templ->u.tex.last_layer);
+      templ->target = gl_target_to_pipe(stObj->base.Target);
    }
 
    if (swizzle != SWIZZLE_NOOP) {
-      templ.swizzle_r = GET_SWZ(swizzle, 0);
-      templ.swizzle_g = GET_SWZ(swizzle, 1);
-      templ.swizzle_b = GET_SWZ(swizzle, 2);
-      templ.swizzle_a = GET_SWZ(swizzle, 3);
+      templ->swizzle_r = GET_SWZ(swizzle, 0);
+      templ->swizzle_g = GET_SWZ(swizzle, 1);
+      templ->swizzle_b = GET_SWZ(swizzle, 2);
+      templ->swizzle_a = GET_SWZ(swizzle, 3);
    }
 
-   return pipe->create_sampler_view(pipe, stObj->pt, &templ);
+   return TRUE;
 }
 
 
@@ -307,14 +292,12 @@ st_get_texture_sampler_view_from_stobj(struct st_context *st,
 				       enum pipe_format format,
                                        unsigned glsl_version)
 {
-   struct pipe_sampler_view **sv;
+   struct pipe_sampler_view templ;
    const struct st_texture_image *firstImage;
    if (!stObj || !stObj->pt) {
       return NULL;
    }
 
-   sv = st_texture_get_sampler_view(st, stObj);
-
    if (util_format_is_depth_and_stencil(format)) {
       if (stObj->base.StencilSampling)
          format = util_format_stencil_only(format);
@@ -325,32 +308,14 @@ st_get_texture_sampler_view_from_stobj(struct st_context *st,
       }
    }
 
-   /* if sampler view has changed dereference it */
-   if (*sv) {
-      if (check_sampler_swizzle(stObj, *sv, glsl_version) ||
-	  (format != (*sv)->format) ||
-          gl_target_to_pipe(stObj->base.Target) != (*sv)->target ||
-          stObj->base.MinLevel + stObj->base.BaseLevel != (*sv)->u.tex.first_level ||
-          last_level(stObj) != (*sv)->u.tex.last_level ||
-          stObj->base.MinLayer != (*sv)->u.tex.first_layer ||
-          last_layer(stObj) != (*sv)->u.tex.last_layer) {
-	 pipe_sampler_view_reference(sv, NULL);
-      }
-   }
-
-   if (!*sv) {
-      *sv = st_create_texture_sampler_view_from_stobj(st->pipe, stObj,
-                                                      format, glsl_version);
-
-   } else if ((*sv)->context != st->pipe) {
-      /* Recreate view in correct context, use existing view as template */
-      struct pipe_sampler_view *new_sv =
-         st->pipe->create_sampler_view(st->pipe, stObj->pt, *sv);
-      pipe_sampler_view_reference(sv, NULL);
-      *sv = new_sv;
-   }
+   if (!st_init_sampler_view_template_from_stobj(stObj, format, glsl_version,
+                                                 &templ))
+      return NULL;
 
-   return *sv;
+   /* Views are cached by everything that goes into the template, so
+    * switching back and forth between views of the texture is cheap.
+    */
+   return st_texture_get_sampler_view_for_template(st, stObj, &templ);
 }
 
 static GLboolean
@@ -414,6 +379,7 @@ update_textures(struct st_context *st,
 {
    const GLuint old_max = *num_textures;
    GLbitfield samplers_used = prog->SamplersUsed;
+   boolean changed = FALSE;
    GLuint unit;
    struct gl_shader_program *shader =
       st->ctx->_Shader->CurrentProgram[mesa_shader];
@@ -445,9 +411,18 @@ update_textures(struct st_context *st,
          break;
       }
 
-      pipe_sampler_view_reference(&(sampler_views[unit]), sampler_view);
+      if (sampler_views[unit] != sampler_view) {
+         pipe_sampler_view_reference(&(sampler_views[unit]), sampler_view);
+         changed = TRUE;
+      }
    }
 
+   /* Don't rebind the views if none of the units changed.  Anything else
+    * binding sampler views through the CSO context restores ours.
+    */
+   if (!changed && *num_textures == old_max)
+      return;
+
    cso_set_sampler_views(st->cso_context,
                          shader_stage,
                          *num_textures,
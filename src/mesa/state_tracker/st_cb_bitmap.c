@@ -43,6 +43,7 @@
 #include "st_atom_constbuf.h"
 #include "st_program.h"
 #include "st_cb_bitmap.h"
+#include "st_cb_clear.h"
 #include "st_texture.h"
 
 #include "pipe/p_context.h"
@@ -52,6 +53,8 @@
 #include "util/u_draw_quad.h"
 #include "util/u_simple_shaders.h"
 #include "util/u_upload_mgr.h"
+#include "util/hash_table.h"
+#include "util/ralloc.h"
 #include "program/prog_instruction.h"
 #include "cso_cache/cso_context.h"
 
@@ -70,43 +73,55 @@
 
 
 /**
- * The bitmap cache attempts to accumulate multiple glBitmap calls in a
- * buffer which is then rendered en mass upon a flush, state change, etc.
- * A wide, short buffer is used to target the common case of a series
- * of glBitmap calls being used to draw text.
+ * The bitmap cache accumulates glBitmap calls, which are then rendered en
+ * mass upon a flush, state change, etc.
+ *
+ * Bitmaps are stored in an atlas texture, keyed by their expanded image,
+ * so the glyphs of legacy text rendering are only uploaded once.  Each
+ * glBitmap call just adds a quad sampling its glyph in the atlas, and all
+ * the quads of a batch are drawn at once.  A batch only has to be flushed
+ * when the raster color changes, as the bitmap color comes from a constant.
  */
 static GLboolean UseBitmapCache = GL_TRUE;
 
 
-#define BITMAP_CACHE_WIDTH  512
-#define BITMAP_CACHE_HEIGHT 32
+#define BITMAP_ATLAS_SIZE    512  /**< width and height of the atlas */
+#define BITMAP_GLYPH_MAX     64   /**< larger bitmaps aren't cached */
+#define BITMAP_BATCH_QUADS   256  /**< quads drawn by one flush at most */
+
+/** A bitmap image in the atlas, and the hash table key for it */
+struct bitmap_glyph
+{
+   GLsizei width, height;
+   /** Position in the atlas */
+   GLint x, y;
+   /** The expanded image, width * height texels */
+   ubyte image[];
+};
 
 struct bitmap_cache
 {
-   /** Window pos to render the cached image */
-   GLint xpos, ypos;
-   /** Bounds of region used in window coords */
-   GLint xmin, ymin, xmax, ymax;
+   /** The atlas, created on first use */
+   struct pipe_resource *texture;
+   struct pipe_sampler_view *view;
 
-   GLfloat color[4];
+   /** The glyphs in the atlas, allocated out of the table */
+   struct hash_table *glyphs;
 
-   /** Bitmap's Z position */
-   GLfloat zpos;
+   /** Free space of the atlas: the current shelf and the ones above it */
+   GLint shelf_x, shelf_y, shelf_height;
 
-   struct pipe_resource *texture;
-   struct pipe_transfer *trans;
+   /** The glyph being looked up, BITMAP_GLYPH_MAX^2 texels */
+   struct bitmap_glyph *scratch;
 
-   GLboolean empty;
+   /** Quads of the pending batch: 6 vertices of pos + color + texcoord */
+   GLfloat (*vertices)[3][4];
+   unsigned num_quads;
 
-   /** An I8 texture image: */
-   ubyte *buffer;
+   GLfloat color[4];
 };
 
 
-/** Epsilon for Z comparisons */
-#define Z_EPSILON 1e-06
-
-
 /**
  * Copy user-provide bitmap bits into texture buffer, expanding
  * bits into texels.
@@ -251,22 +266,19 @@ setup_bitmap_vertex_data(struct st_context *st, bool normalized,
 
 
 /**
- * Render a glBitmap by drawing a textured quad
+ * Bind the state for drawing bitmap quads sampling \p sv, with \p color.
+ * This saves the state which is changed, restore_render_state() puts it
+ * back.
  */
 static void
-draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
-                 GLsizei width, GLsizei height,
-                 struct pipe_sampler_view *sv,
-                 const GLfloat *color)
+setup_render_state(struct gl_context *ctx,
+                   struct pipe_sampler_view *sv,
+                   const GLfloat *color)
 {
    struct st_context *st = st_context(ctx);
-   struct pipe_context *pipe = st->pipe;
    struct cso_context *cso = st->cso_context;
    struct st_fp_variant *fpv;
    struct st_fp_variant_key key;
-   GLuint maxSize;
-   GLuint offset;
-   struct pipe_resource *vbuf = NULL;
 
    memset(&key, 0, sizeof(key));
    key.st = st->has_shareable_shaders ? NULL : st;
@@ -291,16 +303,6 @@ draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
       COPY_4V(ctx->Current.Attrib[VERT_ATTRIB_COLOR0], colorSave);
    }
 
-
-   /* limit checks */
-   /* XXX if the bitmap is larger than the max texture size, break
-    * it up into chunks.
-    */
-   maxSize = 1 << (pipe->screen->get_param(pipe->screen,
-                                    PIPE_CAP_MAX_TEXTURE_2D_LEVELS) - 1);
-   assert(width <= (GLsizei)maxSize);
-   assert(height <= (GLsizei)maxSize);
-
    cso_save_rasterizer(cso);
    cso_save_fragment_samplers(cso);
    cso_save_fragment_sampler_views(cso);
@@ -372,6 +374,54 @@ draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
 
    cso_set_vertex_elements(cso, 3, st->velems_util_draw);
    cso_set_stream_outputs(st->cso_context, 0, NULL, NULL);
+}
+
+
+static void
+restore_render_state(struct gl_context *ctx)
+{
+   struct cso_context *cso = st_context(ctx)->cso_context;
+
+   cso_restore_rasterizer(cso);
+   cso_restore_fragment_samplers(cso);
+   cso_restore_fragment_sampler_views(cso);
+   cso_restore_viewport(cso);
+   cso_restore_fragment_shader(cso);
+   cso_restore_vertex_shader(cso);
+   cso_restore_tessctrl_shader(cso);
+   cso_restore_tesseval_shader(cso);
+   cso_restore_geometry_shader(cso);
+   cso_restore_vertex_elements(cso);
+   cso_restore_aux_vertex_buffer_slot(cso);
+   cso_restore_stream_outputs(cso);
+}
+
+
+/**
+ * Render a glBitmap by drawing a textured quad
+ */
+static void
+draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
+                 GLsizei width, GLsizei height,
+                 struct pipe_sampler_view *sv,
+                 const GLfloat *color)
+{
+   struct st_context *st = st_context(ctx);
+   struct pipe_context *pipe = st->pipe;
+   GLuint maxSize;
+   GLuint offset;
+   struct pipe_resource *vbuf = NULL;
+
+   /* limit checks */
+   /* XXX if the bitmap is larger than the max texture size, break
+    * it up into chunks.
+    */
+   maxSize = 1 << (pipe->screen->get_param(pipe->screen,
+                                    PIPE_CAP_MAX_TEXTURE_2D_LEVELS) - 1);
+   assert(width <= (GLsizei)maxSize);
+   assert(height <= (GLsizei)maxSize);
+
+   setup_render_state(ctx, sv, color);
 
    /* convert Z from [0,1] to [-1,-1] to match viewport Z scale/bias */
    z = z * 2.0f - 1.0f;
@@ -389,142 +439,218 @@ draw_bitmap_quad(struct gl_context *ctx, GLint x, GLint y, GLfloat z,
                               3); /* attribs/vert */
    }
 
-   /* restore state */
-   cso_restore_rasterizer(cso);
-   cso_restore_fragment_samplers(cso);
-   cso_restore_fragment_sampler_views(cso);
-   cso_restore_viewport(cso);
-   cso_restore_fragment_shader(cso);
-   cso_restore_vertex_shader(cso);
-   cso_restore_tessctrl_shader(cso);
-   cso_restore_tesseval_shader(cso);
-   cso_restore_geometry_shader(cso);
-   cso_restore_vertex_elements(cso);
-   cso_restore_aux_vertex_buffer_slot(cso);
-   cso_restore_stream_outputs(cso);
+   restore_render_state(ctx);
 
    pipe_resource_reference(&vbuf, NULL);
 }
 
 
+static uint32_t
+hash_glyph(const void *key)
+{
+   const struct bitmap_glyph *glyph = key;
+   uint32_t hash = _mesa_fnv32_1a_offset_bias;
+
+   hash = _mesa_fnv32_1a_accumulate(hash, glyph->width);
+   hash = _mesa_fnv32_1a_accumulate(hash, glyph->height);
+   return _mesa_fnv32_1a_accumulate_block(hash, glyph->image,
+                                          glyph->width * glyph->height);
+}
+
+
+static bool
+glyphs_equal(const void *a, const void *b)
+{
+   const struct bitmap_glyph *ga = a, *gb = b;
+
+   return ga->width == gb->width && ga->height == gb->height &&
+          memcmp(ga->image, gb->image, ga->width * ga->height) == 0;
+}
+
+
+/**
+ * Start over with an empty atlas.  A new texture is created, as the
+ * previous one may still be used by queued draws.
+ */
 static void
-reset_cache(struct st_context *st)
+reset_atlas(struct st_context *st)
 {
    struct bitmap_cache *cache = st->bitmap.cache;
 
-   /*memset(cache->buffer, 0xff, sizeof(cache->buffer));*/
-   cache->empty = GL_TRUE;
-
-   cache->xmin = 1000000;
-   cache->xmax = -1000000;
-   cache->ymin = 1000000;
-   cache->ymax = -1000000;
+   pipe_sampler_view_reference(&cache->view, NULL);
+   pipe_resource_reference(&cache->texture, NULL);
+   _mesa_hash_table_destroy(cache->glyphs, NULL);
 
-   assert(!cache->texture);
+   cache->glyphs = _mesa_hash_table_create(NULL, hash_glyph, glyphs_equal);
+   cache->shelf_x = 0;
+   cache->shelf_y = 0;
+   cache->shelf_height = 0;
 
-   /* allocate a new texture */
    cache->texture = st_texture_create(st, PIPE_TEXTURE_2D,
                                       st->bitmap.tex_format, 0,
-                                      BITMAP_CACHE_WIDTH, BITMAP_CACHE_HEIGHT,
+                                      BITMAP_ATLAS_SIZE, BITMAP_ATLAS_SIZE,
                                       1, 1, 0,
-				      PIPE_BIND_SAMPLER_VIEW);
+                                      PIPE_BIND_SAMPLER_VIEW);
+   if (cache->texture)
+      cache->view = st_create_texture_sampler_view(st->pipe, cache->texture);
 }
 
 
-/** Print bitmap image to stdout (debug) */
-static void
-print_cache(const struct bitmap_cache *cache)
+/**
+ * If there's anything in the bitmap cache, draw/flush it now.
+ */
+void
+st_flush_bitmap_cache(struct st_context *st)
 {
-   int i, j, k;
-
-   for (i = 0; i < BITMAP_CACHE_HEIGHT; i++) {
-      k = BITMAP_CACHE_WIDTH * (BITMAP_CACHE_HEIGHT - i - 1);
-      for (j = 0; j < BITMAP_CACHE_WIDTH; j++) {
-         if (cache->buffer[k])
-            printf("X");
-         else
-            printf(" ");
-         k++;
-      }
-      printf("\n");
+   struct bitmap_cache *cache = st->bitmap.cache;
+   struct pipe_resource *vbuf = NULL;
+   GLuint offset;
+
+   if (!cache->num_quads)
+      return;
+
+   u_upload_data(st->uploader, 0,
+                 cache->num_quads * 6 * sizeof(cache->vertices[0]),
+                 cache->vertices, &offset, &vbuf);
+
+   if (vbuf) {
+      setup_render_state(st->ctx, cache->view, cache->color);
+
+      util_draw_vertex_buffer(st->pipe, st->cso_context, vbuf,
+                              cso_get_aux_vertex_buffer_slot(st->cso_context),
+                              offset,
+                              PIPE_PRIM_TRIANGLES,
+                              cache->num_quads * 6,  /* verts */
+                              3); /* attribs/vert */
+
+      restore_render_state(st->ctx);
+      pipe_resource_reference(&vbuf, NULL);
    }
+
+   cache->num_quads = 0;
 }
 
 
 /**
- * Create gallium pipe_transfer object for the bitmap cache.
+ * Find room for a glyph in the atlas, shelf by shelf.
+ * \return  GL_FALSE if the atlas is full
  */
-static void
-create_cache_trans(struct st_context *st)
+static GLboolean
+alloc_glyph(struct bitmap_cache *cache, struct bitmap_glyph *glyph)
 {
-   struct pipe_context *pipe = st->pipe;
-   struct bitmap_cache *cache = st->bitmap.cache;
+   if (cache->shelf_x + glyph->width > BITMAP_ATLAS_SIZE) {
+      cache->shelf_x = 0;
+      cache->shelf_y += cache->shelf_height;
+      cache->shelf_height = 0;
+   }
+   if (cache->shelf_y + glyph->height > BITMAP_ATLAS_SIZE)
+      return GL_FALSE;
+
+   glyph->x = cache->shelf_x;
+   glyph->y = cache->shelf_y;
+   cache->shelf_x += glyph->width;
+   cache->shelf_height = MAX2(cache->shelf_height, glyph->height);
+   return GL_TRUE;
+}
 
-   if (cache->trans)
-      return;
 
-   /* Map the texture transfer.
-    * Subsequent glBitmap calls will write into the texture image.
+/**
+ * Return the atlas entry for the glyph in the scratch buffer, adding and
+ * uploading it if it's new.
+ */
+static const struct bitmap_glyph *
+get_glyph(struct st_context *st)
+{
+   struct bitmap_cache *cache = st->bitmap.cache;
+   struct bitmap_glyph *glyph = cache->scratch;
+   const unsigned size = glyph->width * glyph->height;
+   const uint32_t hash = hash_glyph(glyph);
+   struct hash_entry *entry;
+   struct pipe_transfer *transfer;
+   ubyte *dest;
+   GLsizei row;
+
+   entry = _mesa_hash_table_search_pre_hashed(cache->glyphs, hash, glyph);
+   if (entry)
+      return entry->key;
+
+   if (!cache->texture || !alloc_glyph(cache, glyph)) {
+      /* The pending quads use the old atlas. */
+      st_flush_bitmap_cache(st);
+      reset_atlas(st);
+      if (!cache->view || !alloc_glyph(cache, glyph))
+         return NULL;
+   }
+
+   /* This part of the atlas has never been used, so don't wait for the
+    * draws using the texture.
     */
-   cache->buffer = pipe_transfer_map(pipe, cache->texture, 0, 0,
-                                     PIPE_TRANSFER_WRITE, 0, 0,
-                                     BITMAP_CACHE_WIDTH,
-                                     BITMAP_CACHE_HEIGHT, &cache->trans);
+   dest = pipe_transfer_map(st->pipe, cache->texture, 0, 0,
+                            PIPE_TRANSFER_WRITE |
+                            PIPE_TRANSFER_UNSYNCHRONIZED,
+                            glyph->x, glyph->y,
+                            glyph->width, glyph->height, &transfer);
+   if (!dest)
+      return NULL;
+
+   for (row = 0; row < glyph->height; row++) {
+      memcpy(dest + row * transfer->stride,
+             glyph->image + row * glyph->width, glyph->width);
+   }
+   pipe_transfer_unmap(st->pipe, transfer);
 
-   /* init image to all 0xff */
-   memset(cache->buffer, 0xff, cache->trans->stride * BITMAP_CACHE_HEIGHT);
+   glyph = ralloc_size(cache->glyphs, sizeof(*glyph) + size);
+   if (!glyph)
+      return NULL;
+   memcpy(glyph, cache->scratch, sizeof(*glyph) + size);
+   _mesa_hash_table_insert_pre_hashed(cache->glyphs, hash, glyph, NULL);
+   return glyph;
 }
 
 
 /**
- * If there's anything in the bitmap cache, draw/flush it now.
+ * Add a quad drawing a glyph of the atlas to the pending batch.
  */
-void
-st_flush_bitmap_cache(struct st_context *st)
+static void
+add_glyph_quad(struct st_context *st, const struct bitmap_glyph *glyph,
+               GLint x, GLint y, GLfloat z)
 {
-   if (!st->bitmap.cache->empty) {
-      struct bitmap_cache *cache = st->bitmap.cache;
-
-      struct pipe_context *pipe = st->pipe;
-      struct pipe_sampler_view *sv;
-
-      assert(cache->xmin <= cache->xmax);
-
-/*    printf("flush size %d x %d  at %d, %d\n",
-             cache->xmax - cache->xmin,
-             cache->ymax - cache->ymin,
-             cache->xpos, cache->ypos);
-*/
-
-      /* The texture transfer has been mapped until now.
-          * So unmap and release the texture transfer before drawing.
-          */
-      if (cache->trans && cache->buffer) {
-         if (0)
-            print_cache(cache);
-         pipe_transfer_unmap(pipe, cache->trans);
-         cache->buffer = NULL;
-         cache->trans = NULL;
-      }
-
-      sv = st_create_texture_sampler_view(st->pipe, cache->texture);
-      if (sv) {
-         draw_bitmap_quad(st->ctx,
-                          cache->xpos,
-                          cache->ypos,
-                          cache->zpos,
-                          BITMAP_CACHE_WIDTH, BITMAP_CACHE_HEIGHT,
-                          sv,
-                          cache->color);
+   struct bitmap_cache *cache = st->bitmap.cache;
+   const GLfloat fb_width = (GLfloat)st->state.framebuffer.width;
+   const GLfloat fb_height = (GLfloat)st->state.framebuffer.height;
+   const GLfloat clip_x0 = x / fb_width * 2.0f - 1.0f;
+   const GLfloat clip_y0 = y / fb_height * 2.0f - 1.0f;
+   const GLfloat clip_x1 = (x + glyph->width) / fb_width * 2.0f - 1.0f;
+   const GLfloat clip_y1 = (y + glyph->height) / fb_height * 2.0f - 1.0f;
+   const GLfloat s0 = (GLfloat) glyph->x / BITMAP_ATLAS_SIZE;
+   const GLfloat t0 = (GLfloat) glyph->y / BITMAP_ATLAS_SIZE;
+   const GLfloat s1 = (GLfloat) (glyph->x + glyph->width) / BITMAP_ATLAS_SIZE;
+   const GLfloat t1 = (GLfloat) (glyph->y + glyph->height) / BITMAP_ATLAS_SIZE;
+   /* two triangles: 0-1-2 and 0-2-3 of the quad */
+   static const unsigned corners[6] = { 0, 1, 2, 0, 2, 3 };
+   GLfloat (*vertices)[3][4] = cache->vertices + cache->num_quads * 6;
+   unsigned i;
 
-         pipe_sampler_view_reference(&sv, NULL);
-      }
+   /* convert Z from [0,1] to [-1,-1] to match viewport Z scale/bias */
+   z = z * 2.0f - 1.0f;
 
-      /* release/free the texture */
-      pipe_resource_reference(&cache->texture, NULL);
+   for (i = 0; i < 6; i++) {
+      const unsigned c = corners[i];
+      const GLboolean right = c == 1 || c == 2;
+      const GLboolean top = c >= 2;
 
-      reset_cache(st);
+      vertices[i][0][0] = right ? clip_x1 : clip_x0;
+      vertices[i][0][1] = top ? clip_y1 : clip_y0;
+      vertices[i][0][2] = z;
+      vertices[i][0][3] = 1.0f;
+      COPY_4V(vertices[i][1], cache->color);
+      vertices[i][2][0] = right ? s1 : s0;
+      vertices[i][2][1] = top ? t1 : t0;
+      vertices[i][2][2] = 0.0f; /*R*/
+      vertices[i][2][3] = 1.0f; /*Q*/
    }
+
+   cache->num_quads++;
 }
 
 
@@ -540,65 +666,43 @@ accum_bitmap(struct gl_context *ctx,
 {
    struct st_context *st = ctx->st;
    struct bitmap_cache *cache = st->bitmap.cache;
-   int px = -999, py = -999;
-   const GLfloat z = st->ctx->Current.RasterPos[2];
+   struct bitmap_glyph *scratch = cache->scratch;
+   const struct bitmap_glyph *glyph;
 
-   if (width > BITMAP_CACHE_WIDTH ||
-       height > BITMAP_CACHE_HEIGHT)
+   if (width > BITMAP_GLYPH_MAX ||
+       height > BITMAP_GLYPH_MAX)
       return GL_FALSE; /* too big to cache */
 
-   if (!cache->empty) {
-      px = x - cache->xpos;  /* pos in buffer */
-      py = y - cache->ypos;
-      if (px < 0 || px + width > BITMAP_CACHE_WIDTH ||
-          py < 0 || py + height > BITMAP_CACHE_HEIGHT ||
-          !TEST_EQ_4V(st->ctx->Current.RasterColor, cache->color) ||
-          ((fabs(z - cache->zpos) > Z_EPSILON))) {
-         /* This bitmap would extend beyond cache bounds, or the bitmap
-          * color is changing
-          * so flush and continue.
-          */
-         st_flush_bitmap_cache(st);
-      }
-   }
+   if (!cache->scratch || !cache->vertices)
+      return GL_FALSE;
 
-   if (cache->empty) {
-      /* Initialize.  Center bitmap vertically in the buffer. */
-      px = 0;
-      py = (BITMAP_CACHE_HEIGHT - height) / 2;
-      cache->xpos = x;
-      cache->ypos = y - py;
-      cache->zpos = z;
-      cache->empty = GL_FALSE;
-      COPY_4FV(cache->color, st->ctx->Current.RasterColor);
+   if (cache->num_quads == BITMAP_BATCH_QUADS ||
+       (cache->num_quads &&
+        !TEST_EQ_4V(st->ctx->Current.RasterColor, cache->color))) {
+      st_flush_bitmap_cache(st);
    }
 
-   assert(px != -999);
-   assert(py != -999);
-
-   if (x < cache->xmin)
-      cache->xmin = x;
-   if (y < cache->ymin)
-      cache->ymin = y;
-   if (x + width > cache->xmax)
-      cache->xmax = x + width;
-   if (y + height > cache->ymax)
-      cache->ymax = y + height;
-
-   /* create the transfer if needed */
-   create_cache_trans(st);
-
    /* PBO source... */
    bitmap = _mesa_map_pbo_source(ctx, unpack, bitmap);
    if (!bitmap) {
-      return FALSE;
+      return GL_FALSE;
    }
 
-   unpack_bitmap(st, px, py, width, height, unpack, bitmap,
-                 cache->buffer, BITMAP_CACHE_WIDTH);
+   scratch->width = width;
+   scratch->height = height;
+   memset(scratch->image, 0xff, width * height);
+   unpack_bitmap(st, 0, 0, width, height, unpack, bitmap,
+                 scratch->image, width);
 
    _mesa_unmap_pbo_source(ctx, unpack);
 
+   glyph = get_glyph(st);
+   if (!glyph)
+      return GL_FALSE;
+
+   COPY_4V(cache->color, st->ctx->Current.RasterColor);
+   add_glyph_quad(st, glyph, x, y, st->ctx->Current.RasterPos[2]);
+
    return GL_TRUE; /* accumulated */
 }
 
@@ -619,6 +723,7 @@ st_Bitmap(struct gl_context *ctx, GLint x, GLint y,
       return;
 
    st_validate_state(st);
+   st_flush_clear(st);
 
    if (!st->bitmap.vs) {
       /* create pass-through vertex shader now */
@@ -636,6 +741,9 @@ st_Bitmap(struct gl_context *ctx, GLint x, GLint y,
    if (UseBitmapCache && accum_bitmap(ctx, x, y, width, height, unpack, bitmap))
       return;
 
+   /* Keep the order of the bitmaps. */
+   st_flush_bitmap_cache(st);
+
    pt = make_bitmap_texture(ctx, width, height, unpack, bitmap);
    if (pt) {
       struct pipe_sampler_view *sv =
@@ -711,10 +819,13 @@ st_init_bitmap(struct st_context *st)
       assert(0);
    }
 
-   /* alloc bitmap cache object */
+   /* alloc bitmap cache object, the atlas is created on first use */
    st->bitmap.cache = ST_CALLOC_STRUCT(bitmap_cache);
-
-   reset_cache(st);
+   st->bitmap.cache->scratch =
+      malloc(sizeof(struct bitmap_glyph) +
+             BITMAP_GLYPH_MAX * BITMAP_GLYPH_MAX);
+   st->bitmap.cache->vertices =
+      malloc(BITMAP_BATCH_QUADS * 6 * sizeof(st->bitmap.cache->vertices[0]));
 }
 
 
@@ -722,7 +833,6 @@ st_init_bitmap(struct st_context *st)
 void
 st_destroy_bitmap(struct st_context *st)
 {
-   struct pipe_context *pipe = st->pipe;
    struct bitmap_cache *cache = st->bitmap.cache;
 
    if (st->bitmap.vs) {
@@ -731,10 +841,11 @@ st_destroy_bitmap(struct st_context *st)
    }
 
    if (cache) {
-      if (cache->trans && cache->buffer) {
-         pipe_transfer_unmap(pipe, cache->trans);
-      }
-      pipe_resource_reference(&st->bitmap.cache->texture, NULL);
+      pipe_sampler_view_reference(&cache->view, NULL);
+      pipe_resource_reference(&cache->texture, NULL);
+      _mesa_hash_table_destroy(cache->glyphs, NULL);
+      free(cache->scratch);
+      free(cache->vertices);
       free(st->bitmap.cache);
       st->bitmap.cache = NULL;
    }
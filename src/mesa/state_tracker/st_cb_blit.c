@@ -37,6 +37,7 @@
 #include "st_context.h"
 #include "st_texture.h"
 #include "st_cb_bitmap.h"
+#include "st_cb_clear.h"
 #include "st_cb_blit.h"
 #include "st_cb_fbo.h"
 #include "st_manager.h"
@@ -94,8 +95,9 @@ st_BlitFramebuffer(struct gl_context *ctx,
 
    st_manager_validate_framebuffers(st);
 
-   /* Make sure bitmap rendering has landed in the framebuffers */
+   /* Make sure bitmap rendering and clears have landed in the framebuffers */
    st_flush_bitmap_cache(st);
+   st_flush_clear(st);
 
    clip.srcX0 = srcX0;
    clip.srcY0 = srcY0;
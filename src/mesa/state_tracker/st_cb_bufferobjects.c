@@ -40,11 +40,13 @@
 
 #include "st_context.h"
 #include "st_cb_bufferobjects.h"
+#include "st_cb_readpixels.h"
 #include "st_debug.h"
 
 #include "pipe/p_context.h"
 #include "pipe/p_defines.h"
 #include "util/u_inlines.h"
+#include "hud/hud_counters.h"
 
 
 /**
@@ -79,6 +81,7 @@ st_bufferobj_free(struct gl_context *ctx, struct gl_buffer_object *obj)
 
    assert(obj->RefCount == 0);
    _mesa_buffer_unmap_all_mappings(ctx, obj);
+   st_discard_pbo_download(st_obj);
 
    if (st_obj->buffer)
       pipe_resource_reference(&st_obj->buffer, NULL);
@@ -125,6 +128,8 @@ st_bufferobj_subdata(struct gl_context *ctx,
       return;
    }
 
+   st_complete_pbo_download(st_context(ctx), st_obj);
+
    /* Now that transfers are per-context, we don't have to figure out
     * flushing here.  Usually drivers won't need to flush in this case
     * even if the buffer is currently referenced by hardware - they
@@ -161,6 +166,8 @@ st_bufferobj_get_subdata(struct gl_context *ctx,
       return;
    }
 
+   st_complete_pbo_download(st_context(ctx), st_obj);
+
    pipe_buffer_read(st_context(ctx)->pipe, st_obj->buffer,
                     offset, size, data);
 }
@@ -187,6 +194,9 @@ st_bufferobj_data(struct gl_context *ctx,
    struct st_buffer_object *st_obj = st_buffer_object(obj);
    unsigned bind, pipe_usage, pipe_flags = 0;
 
+   /* The old contents are lost either way. */
+   st_discard_pbo_download(st_obj);
+
    if (target != GL_EXTERNAL_VIRTUAL_MEMORY_BUFFER_AMD &&
        size && data && st_obj->buffer &&
        st_obj->Base.Size == size &&
@@ -280,6 +290,8 @@ st_bufferobj_data(struct gl_context *ctx,
       pipe_flags |= PIPE_RESOURCE_FLAG_MAP_PERSISTENT;
    if (storageFlags & GL_MAP_COHERENT_BIT)
       pipe_flags |= PIPE_RESOURCE_FLAG_MAP_COHERENT;
+   if (storageFlags & GL_SPARSE_STORAGE_BIT_ARB)
+      pipe_flags |= PIPE_RESOURCE_FLAG_SPARSE;
 
    pipe_resource_reference( &st_obj->buffer, NULL );
 
@@ -309,6 +321,7 @@ st_bufferobj_data(struct gl_context *ctx,
       }
       else {
          st_obj->buffer = screen->resource_create(screen, &buffer);
+         hud_counter_add(HUD_COUNTER_BUFFER_REALLOCS, 1);
 
          if (st_obj->buffer && data)
             pipe_buffer_write(pipe, st_obj->buffer, 0, size, data);
@@ -321,8 +334,13 @@ st_bufferobj_data(struct gl_context *ctx,
       }
    }
 
-   /* BufferData may change an array or uniform buffer, need to update it */
-   st->dirty.st |= ST_NEW_VERTEX_ARRAYS | ST_NEW_UNIFORM_BUFFER;
+   /* BufferData may change an array or uniform buffer, need to update it.
+    * A buffer only gets bound as a uniform buffer after being marked as
+    * one, so the uniform buffer atoms can be skipped for the others.
+    */
+   st->dirty.st |= ST_NEW_VERTEX_ARRAYS;
+   if (st_obj->Base.UsageHistory & USAGE_UNIFORM_BUFFER)
+      st->dirty.st |= ST_NEW_UNIFORM_BUFFER;
 
    return GL_TRUE;
 }
@@ -380,6 +398,11 @@ st_bufferobj_map_range(struct gl_context *ctx,
    assert(offset < obj->Size);
    assert(offset + length <= obj->Size);
 
+   if (access & GL_MAP_INVALIDATE_BUFFER_BIT)
+      st_discard_pbo_download(st_obj);
+   else
+      st_complete_pbo_download(st_context(ctx), st_obj);
+
    obj->Mappings[index].Pointer = pipe_buffer_map_range(pipe,
                                         st_obj->buffer,
                                         offset, length,
@@ -465,6 +488,9 @@ st_copy_buffer_subdata(struct gl_context *ctx,
    assert(!_mesa_check_disallowed_mapping(src));
    assert(!_mesa_check_disallowed_mapping(dst));
 
+   st_complete_pbo_download(st_context(ctx), srcObj);
+   st_complete_pbo_download(st_context(ctx), dstObj);
+
    u_box_1d(readOffset, size, &box);
 
    pipe->resource_copy_region(pipe, dstObj->buffer, 0, writeOffset, 0, 0,
@@ -485,6 +511,8 @@ st_clear_buffer_subdata(struct gl_context *ctx,
    struct st_buffer_object *buf = st_buffer_object(bufObj);
    static const char zeros[16] = {0};
 
+   st_complete_pbo_download(st_context(ctx), buf);
+
    if (!pipe->clear_buffer) {
       _mesa_ClearBufferSubData_sw(ctx, offset, size,
                                   clearValue, clearValueSize, bufObj);
@@ -499,6 +527,28 @@ st_clear_buffer_subdata(struct gl_context *ctx,
 }
 
 
+/**
+ * Called via glBufferPageCommitmentARB() and friends.
+ */
+static void
+st_bufferobj_page_commitment(struct gl_context *ctx,
+                             struct gl_buffer_object *bufObj,
+                             GLintptr offset, GLsizeiptr size,
+                             GLboolean commit)
+{
+   struct pipe_context *pipe = st_context(ctx)->pipe;
+   struct st_buffer_object *buf = st_buffer_object(bufObj);
+   struct pipe_box box;
+
+   st_complete_pbo_download(st_context(ctx), buf);
+
+   u_box_1d(offset, size, &box);
+
+   if (!pipe->resource_commit(pipe, buf->buffer, 0, &box, commit))
+      _mesa_error(ctx, GL_OUT_OF_MEMORY, "glBufferPageCommitmentARB");
+}
+
+
 /* TODO: if buffer wasn't created with appropriate usage flags, need
  * to recreate it now and copy contents -- or possibly create a
  * gallium entrypoint to extend the usage flags and let the driver
@@ -528,4 +578,5 @@ st_init_bufferobject_functions(struct dd_function_table *functions)
    functions->UnmapBuffer = st_bufferobj_unmap;
    functions->CopyBufferSubData = st_copy_buffer_subdata;
    functions->ClearBufferSubData = st_clear_buffer_subdata;
+   functions->BufferPageCommitment = st_bufferobj_page_commitment;
 }
@@ -451,6 +451,93 @@ is_stencil_masked(struct gl_context *ctx, struct gl_renderbuffer *rb)
 }
 
 
+/**
+ * Pass the deferred full-surface clear, if any, to the driver.
+ *
+ * This must be called before anything else reads or writes the current
+ * framebuffer, and before the framebuffer state changes.
+ */
+void
+st_flush_clear(struct st_context *st)
+{
+   if (!st->clear.pending_buffers)
+      return;
+
+   st->pipe->clear(st->pipe, st->clear.pending_buffers,
+                   &st->clear.pending_color,
+                   st->clear.pending_depth, st->clear.pending_stencil);
+   st->clear.pending_buffers = 0;
+}
+
+
+/**
+ * Defer a full-surface clear, merging it with the pending one.
+ *
+ * Back-to-back clears of different buffers (glClear(COLOR) followed by
+ * glClear(DEPTH), or clears of the draw buffers one by one) then reach the
+ * driver as a single pipe->clear, which most drivers handle as a fast clear.
+ */
+static void
+queue_clear(struct st_context *st, unsigned buffers,
+            const union pipe_color_union *color,
+            double depth, unsigned stencil)
+{
+   /* pipe->clear takes a single color.  A different color can only be
+    * merged if it overwrites all the pending color buffers.
+    */
+   if (buffers & PIPE_CLEAR_COLOR &&
+       st->clear.pending_buffers & PIPE_CLEAR_COLOR & ~buffers &&
+       memcmp(color, &st->clear.pending_color, sizeof(*color)) != 0)
+      st_flush_clear(st);
+
+   if (buffers & PIPE_CLEAR_COLOR)
+      st->clear.pending_color = *color;
+   if (buffers & PIPE_CLEAR_DEPTH)
+      st->clear.pending_depth = depth;
+   if (buffers & PIPE_CLEAR_STENCIL)
+      st->clear.pending_stencil = stencil;
+   st->clear.pending_buffers |= buffers;
+}
+
+
+/**
+ * Clear the scissor rectangle of the given buffers with the region clear
+ * functions instead of drawing a quad.  Only valid without write masks.
+ */
+static void
+clear_with_region(struct gl_context *ctx, unsigned clear_buffers)
+{
+   struct st_context *st = st_context(ctx);
+   struct pipe_context *pipe = st->pipe;
+   const struct gl_framebuffer *fb = ctx->DrawBuffer;
+   const struct pipe_framebuffer_state *state = &st->state.framebuffer;
+   const union pipe_color_union *color =
+      (union pipe_color_union*)&ctx->Color.ClearColor;
+   const unsigned x = fb->_Xmin;
+   const unsigned width = fb->_Xmax - fb->_Xmin;
+   const unsigned height = fb->_Ymax - fb->_Ymin;
+   unsigned y = fb->_Ymin;
+   unsigned i;
+
+   if (st_fb_orientation(fb) == Y_0_TOP)
+      y = fb->Height - fb->_Ymax;
+
+   for (i = 0; i < state->nr_cbufs; i++) {
+      if (clear_buffers & (PIPE_CLEAR_COLOR0 << i) && state->cbufs[i]) {
+         pipe->clear_render_target(pipe, state->cbufs[i], color,
+                                   x, y, width, height);
+      }
+   }
+
+   if (clear_buffers & PIPE_CLEAR_DEPTHSTENCIL && state->zsbuf) {
+      pipe->clear_depth_stencil(pipe, state->zsbuf,
+                                clear_buffers & PIPE_CLEAR_DEPTHSTENCIL,
+                                ctx->Depth.Clear, ctx->Stencil.Clear,
+                                x, y, width, height);
+   }
+}
+
+
 /**
  * Called via ctx->Driver.Clear()
  */
@@ -458,11 +545,15 @@ static void
 st_Clear(struct gl_context *ctx, GLbitfield mask)
 {
    struct st_context *st = st_context(ctx);
+   struct pipe_context *pipe = st->pipe;
    struct gl_renderbuffer *depthRb
       = ctx->DrawBuffer->Attachment[BUFFER_DEPTH].Renderbuffer;
    struct gl_renderbuffer *stencilRb
       = ctx->DrawBuffer->Attachment[BUFFER_STENCIL].Renderbuffer;
+   const bool have_region_clear = pipe->clear_render_target &&
+                                  pipe->clear_depth_stencil;
    GLbitfield quad_buffers = 0x0;
+   GLbitfield region_buffers = 0x0;
    GLbitfield clear_buffers = 0x0;
    GLuint i;
 
@@ -485,9 +576,10 @@ st_Clear(struct gl_context *ctx, GLbitfield mask)
             if (is_color_disabled(ctx, colormask_index))
                continue;
 
-            if (is_scissor_enabled(ctx, rb) ||
-                is_color_masked(ctx, colormask_index))
+            if (is_color_masked(ctx, colormask_index))
                quad_buffers |= PIPE_CLEAR_COLOR0 << i;
+            else if (is_scissor_enabled(ctx, rb))
+               region_buffers |= PIPE_CLEAR_COLOR0 << i;
             else
                clear_buffers |= PIPE_CLEAR_COLOR0 << i;
          }
@@ -499,7 +591,7 @@ st_Clear(struct gl_context *ctx, GLbitfield mask)
 
       if (strb->surface && ctx->Depth.Mask) {
          if (is_scissor_enabled(ctx, depthRb))
-            quad_buffers |= PIPE_CLEAR_DEPTH;
+            region_buffers |= PIPE_CLEAR_DEPTH;
          else
             clear_buffers |= PIPE_CLEAR_DEPTH;
       }
@@ -508,37 +600,55 @@ st_Clear(struct gl_context *ctx, GLbitfield mask)
       struct st_renderbuffer *strb = st_renderbuffer(stencilRb);
 
       if (strb->surface && !is_stencil_disabled(ctx, stencilRb)) {
-         if (is_scissor_enabled(ctx, stencilRb) ||
-             is_stencil_masked(ctx, stencilRb))
+         if (is_stencil_masked(ctx, stencilRb))
             quad_buffers |= PIPE_CLEAR_STENCIL;
+         else if (is_scissor_enabled(ctx, stencilRb))
+            region_buffers |= PIPE_CLEAR_STENCIL;
          else
             clear_buffers |= PIPE_CLEAR_STENCIL;
       }
    }
 
+   if (!have_region_clear) {
+      quad_buffers |= region_buffers;
+      region_buffers = 0;
+   }
+
    /* Always clear depth and stencil together.
-    * This can only happen when the stencil writemask is not a full mask.
+    * This can only happen when the stencil writemask is not a full mask,
+    * or when the depth and stencil buffers have different sizes.
     */
-   if (quad_buffers & PIPE_CLEAR_DEPTHSTENCIL &&
-       clear_buffers & PIPE_CLEAR_DEPTHSTENCIL) {
-      quad_buffers |= clear_buffers & PIPE_CLEAR_DEPTHSTENCIL;
+   if ((quad_buffers & PIPE_CLEAR_DEPTHSTENCIL &&
+        (region_buffers | clear_buffers) & PIPE_CLEAR_DEPTHSTENCIL) ||
+       (region_buffers & PIPE_CLEAR_DEPTHSTENCIL &&
+        clear_buffers & PIPE_CLEAR_DEPTHSTENCIL)) {
+      quad_buffers |= (region_buffers | clear_buffers) &
+                      PIPE_CLEAR_DEPTHSTENCIL;
+      region_buffers &= ~PIPE_CLEAR_DEPTHSTENCIL;
       clear_buffers &= ~PIPE_CLEAR_DEPTHSTENCIL;
    }
 
    /* Only use quad-based clearing for the renderbuffers which cannot
-    * use pipe->clear. We want to always use pipe->clear for the other
-    * renderbuffers, because it's likely to be faster.
+    * use pipe->clear or the region clears. We want to always use
+    * pipe->clear for the other renderbuffers, because it's likely to be
+    * faster.
     */
+   if (quad_buffers || region_buffers)
+      st_flush_clear(st);
+
    if (quad_buffers) {
       clear_with_quad(ctx, quad_buffers);
    }
+   if (region_buffers) {
+      clear_with_region(ctx, region_buffers);
+   }
    if (clear_buffers) {
       /* We can't translate the clear color to the colorbuffer format,
        * because different colorbuffers may have different formats.
        */
-      st->pipe->clear(st->pipe, clear_buffers,
-                      (union pipe_color_union*)&ctx->Color.ClearColor,
-                      ctx->Depth.Clear, ctx->Stencil.Clear);
+      queue_clear(st, clear_buffers,
+                  (union pipe_color_union*)&ctx->Color.ClearColor,
+                  ctx->Depth.Clear, ctx->Stencil.Clear);
    }
    if (mask & BUFFER_BIT_ACCUM)
       _mesa_clear_accum_buffer(ctx);
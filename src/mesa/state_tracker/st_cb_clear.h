@@ -45,5 +45,9 @@ extern void
 st_init_clear_functions(struct dd_function_table *functions);
 
 
+extern void
+st_flush_clear(struct st_context *st);
+
+
 #endif /* ST_CB_CLEAR_H */
 
@@ -43,6 +43,7 @@
 #include "st_cb_queryobj.h"
 #include "st_cb_condrender.h"
 #include "st_cb_bitmap.h"
+#include "st_cb_clear.h"
 
 
 /**
@@ -59,6 +60,7 @@ st_BeginConditionalRender(struct gl_context *ctx, struct gl_query_object *q,
    boolean inverted = FALSE;
 
    st_flush_bitmap_cache(st);
+   st_flush_clear(st);
 
    switch (mode) {
    case GL_QUERY_WAIT:
@@ -108,6 +110,7 @@ st_EndConditionalRender(struct gl_context *ctx, struct gl_query_object *q)
    (void) q;
 
    st_flush_bitmap_cache(st);
+   st_flush_clear(st);
 
    cso_set_render_condition(st->cso_context, NULL, FALSE, 0);
 }
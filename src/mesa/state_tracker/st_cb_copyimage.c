@@ -23,6 +23,7 @@
  */
 
 #include "state_tracker/st_context.h"
+#include "state_tracker/st_cb_clear.h"
 #include "state_tracker/st_cb_copyimage.h"
 #include "state_tracker/st_cb_fbo.h"
 #include "state_tracker/st_texture.h"
@@ -48,8 +49,8 @@
  * component size always return the same component type.
  *
  * X returns A.
- * Luminance, intensity, alpha, depth, stencil, and 8-bit and 16-bit packed
- * formats are not supported. (same as ARB_copy_image)
+ * Alpha, depth, stencil, and 8-bit and 16-bit packed formats have no such
+ * equivalent, PIPE_FORMAT_NONE is returned and they are copied as raw bits.
  */
 static enum pipe_format
 get_canonical_format(enum pipe_format format)
@@ -178,11 +179,9 @@ get_canonical_format(enum pipe_format format)
          }
       }
 
-      assert(!"unknown array format");
       return PIPE_FORMAT_NONE;
    }
 
-   assert(!"unknown packed format");
    return PIPE_FORMAT_NONE;
 }
 
@@ -297,8 +296,28 @@ swizzled_copy(struct pipe_context *pipe,
    blit_src_format = get_canonical_format(src->format);
    blit_dst_format = get_canonical_format(dst->format);
 
-   assert(blit_src_format != PIPE_FORMAT_NONE);
-   assert(blit_dst_format != PIPE_FORMAT_NONE);
+   /* Formats without a canonical equivalent (e.g. A8, B5G6R5) have no
+    * swizzle to honor, so they are typecast to an unswizzled format of the
+    * same size that matches the other side, which keeps this a GPU blit.
+    */
+   if (blit_src_format == PIPE_FORMAT_NONE ||
+       blit_dst_format == PIPE_FORMAT_NONE) {
+      bits = util_format_get_blocksizebits(src->format);
+      assert(bits == util_format_get_blocksizebits(dst->format));
+
+      if (blit_src_format != PIPE_FORMAT_NONE) {
+         src_desc = util_format_description(blit_src_format);
+         blit_dst_format =
+            canonical_format_from_bits(bits, src_desc->channel[0].size);
+      } else if (blit_dst_format != PIPE_FORMAT_NONE) {
+         dst_desc = util_format_description(blit_dst_format);
+         blit_src_format =
+            canonical_format_from_bits(bits, dst_desc->channel[0].size);
+      } else {
+         blit_src_format = blit_dst_format =
+            canonical_format_from_bits(bits, MIN2(bits, 32));
+      }
+   }
 
    src_desc = util_format_description(blit_src_format);
    dst_desc = util_format_description(blit_dst_format);
@@ -547,6 +566,8 @@ st_CopyImageSubData(struct gl_context *ctx,
    struct pipe_box box;
    int src_level, dst_level;
 
+   st_flush_clear(st);
+
    if (src_image) {
       struct st_texture_image *src = st_texture_image(src_image);
       src_res = src->pt;
@@ -45,6 +45,7 @@
 #include "pipe/p_defines.h"
 #include "pipe/p_screen.h"
 #include "st_context.h"
+#include "st_cb_clear.h"
 #include "st_cb_fbo.h"
 #include "st_cb_flush.h"
 #include "st_cb_texture.h"
@@ -736,6 +737,8 @@ st_MapRenderbuffer(struct gl_context *ctx,
    GLuint y2;
    GLubyte *map;
 
+   st_flush_clear(st);
+
    if (strb->software) {
       /* software-allocated renderbuffer (probably an accum buffer) */
       if (strb->data) {
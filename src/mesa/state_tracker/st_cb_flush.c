@@ -44,6 +44,8 @@
 #include "pipe/p_defines.h"
 #include "pipe/p_screen.h"
 #include "util/u_gen_mipmap.h"
+#include "hud/hud_counters.h"
+#include "util/u_upload_mgr.h"
 
 
 /** Check if we have a front color buffer and if it's been drawn to. */
@@ -79,12 +81,35 @@ void st_flush(struct st_context *st,
               struct pipe_fence_handle **fence,
               unsigned flags)
 {
+   struct pipe_fence_handle *local_fence = NULL;
+   int64_t start;
+
    FLUSH_VERTICES(st->ctx, 0);
    FLUSH_CURRENT(st->ctx, 0);
 
    st_flush_bitmap_cache(st);
+   st_flush_clear(st);
+
+   /* Always get a fence, so that the uploaders can reuse their full
+    * buffers once it signals.
+    */
+   if (!fence)
+      fence = &local_fence;
 
+   start = hud_counter_begin_time();
    st->pipe->flush(st->pipe, fence, flags);
+   hud_counter_end_time(HUD_COUNTER_FLUSH_TIME, start);
+   hud_counter_add(HUD_COUNTER_FLUSHES, 1);
+   st->num_flushes++;
+
+   u_upload_fence(st->uploader, *fence);
+   if (st->indexbuf_uploader)
+      u_upload_fence(st->indexbuf_uploader, *fence);
+   if (st->constbuf_uploader)
+      u_upload_fence(st->constbuf_uploader, *fence);
+
+   if (local_fence)
+      st->pipe->screen->fence_reference(st->pipe->screen, &local_fence, NULL);
 }
 
 
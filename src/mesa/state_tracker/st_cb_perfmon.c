@@ -28,6 +28,7 @@
 #include "st_debug.h"
 #include "st_context.h"
 #include "st_cb_bitmap.h"
+#include "st_cb_clear.h"
 #include "st_cb_perfmon.h"
 
 #include "util/bitset.h"
@@ -49,6 +50,7 @@ init_perf_monitor(struct gl_context *ctx, struct gl_perf_monitor_object *m)
    int gid, cid;
 
    st_flush_bitmap_cache(st);
+   st_flush_clear(st);
 
    /* Determine the number of active counters. */
    for (gid = 0; gid < ctx->PerfMonitor.NumGroups; gid++) {
@@ -39,9 +39,12 @@
 #include "pipe/p_context.h"
 #include "pipe/p_defines.h"
 #include "pipe/p_screen.h"
+#include "util/u_inlines.h"
 #include "st_context.h"
 #include "st_cb_queryobj.h"
 #include "st_cb_bitmap.h"
+#include "st_cb_clear.h"
+#include "st_cb_bufferobjects.h"
 
 
 static struct gl_query_object *
@@ -89,11 +92,17 @@ st_BeginQuery(struct gl_context *ctx, struct gl_query_object *q)
    unsigned type;
 
    st_flush_bitmap_cache(st_context(ctx));
+   st_flush_clear(st_context(ctx));
 
    /* convert GL query type to Gallium query type */
    switch (q->Target) {
    case GL_ANY_SAMPLES_PASSED:
    case GL_ANY_SAMPLES_PASSED_CONSERVATIVE:
+      /* The result stored into a query buffer must be a boolean. */
+      if (ctx->Extensions.ARB_query_buffer_object) {
+         type = PIPE_QUERY_OCCLUSION_PREDICATE;
+         break;
+      }
       /* fall-through */
    case GL_SAMPLES_PASSED_ARB:
       type = PIPE_QUERY_OCCLUSION_COUNTER;
@@ -169,10 +178,12 @@ st_BeginQuery(struct gl_context *ctx, struct gl_query_object *q)
 static void
 st_EndQuery(struct gl_context *ctx, struct gl_query_object *q)
 {
-   struct pipe_context *pipe = st_context(ctx)->pipe;
+   struct st_context *st = st_context(ctx);
+   struct pipe_context *pipe = st->pipe;
    struct st_query_object *stq = st_query_object(q);
 
-   st_flush_bitmap_cache(st_context(ctx));
+   st_flush_bitmap_cache(st);
+   st_flush_clear(st);
 
    if ((q->Target == GL_TIMESTAMP ||
         q->Target == GL_TIME_ELAPSED) &&
@@ -183,6 +194,9 @@ st_EndQuery(struct gl_context *ctx, struct gl_query_object *q)
 
    if (stq->pq)
       pipe->end_query(pipe, stq->pq);
+
+   stq->flushes_at_end = st->num_flushes;
+   stq->polled = FALSE;
 }
 
 
@@ -204,6 +218,13 @@ get_query_result(struct pipe_context *pipe,
       return FALSE;
 
    switch (stq->base.Target) {
+   case GL_ANY_SAMPLES_PASSED:
+   case GL_ANY_SAMPLES_PASSED_CONSERVATIVE:
+      if (stq->type == PIPE_QUERY_OCCLUSION_PREDICATE)
+         stq->base.Result = data.b;
+      else
+         stq->base.Result = data.u64;
+      break;
    case GL_VERTICES_SUBMITTED_ARB:
       stq->base.Result = data.pipeline_statistics.ia_vertices;
       break;
@@ -279,10 +300,172 @@ st_WaitQuery(struct gl_context *ctx, struct gl_query_object *q)
 static void
 st_CheckQuery(struct gl_context *ctx, struct gl_query_object *q)
 {
-   struct pipe_context *pipe = st_context(ctx)->pipe;
+   struct st_context *st = st_context(ctx);
    struct st_query_object *stq = st_query_object(q);
    assert(!q->Ready);   /* we should not get called if Ready is TRUE */
-   q->Ready = get_query_result(pipe, stq, FALSE);
+
+   /* Nothing was flushed since the query ended, so the result can't be
+    * there yet, and asking the driver may make it flush just for this
+    * query.  That is expensive for apps polling many queries each frame,
+    * so report the query as not ready instead.  Only if it's polled again
+    * before anything else flushed is the driver asked, so that polling is
+    * still guaranteed to finish.
+    */
+   if (stq->flushes_at_end == st->num_flushes && !stq->polled) {
+      stq->polled = TRUE;
+      return;
+   }
+
+   q->Ready = get_query_result(st->pipe, stq, FALSE);
+}
+
+
+/**
+ * Write a query value into a buffer, clamped to the range of ptype.
+ */
+static void
+store_query_value(struct pipe_context *pipe, struct pipe_resource *buffer,
+                  intptr_t offset, GLenum ptype, uint64_t value)
+{
+   union {
+      int32_t i32;
+      uint32_t u32;
+      uint64_t u64;
+   } data;
+   unsigned size;
+
+   switch (ptype) {
+   case GL_INT:
+      data.i32 = MIN2(value, INT32_MAX);
+      size = 4;
+      break;
+   case GL_UNSIGNED_INT:
+      data.u32 = MIN2(value, UINT32_MAX);
+      size = 4;
+      break;
+   case GL_INT64_ARB:
+   case GL_UNSIGNED_INT64_ARB:
+      data.u64 = value;
+      size = 8;
+      break;
+   default:
+      unreachable("unexpected ptype");
+   }
+
+   pipe_buffer_write(pipe, buffer, offset, size, &data);
+}
+
+
+/**
+ * Index of the value of a pipeline statistics query target in
+ * pipe_query_data_pipeline_statistics.
+ */
+static int
+pipeline_statistics_index(GLenum target)
+{
+   switch (target) {
+   case GL_VERTICES_SUBMITTED_ARB:
+      return 0;
+   case GL_PRIMITIVES_SUBMITTED_ARB:
+      return 1;
+   case GL_VERTEX_SHADER_INVOCATIONS_ARB:
+      return 2;
+   case GL_GEOMETRY_SHADER_INVOCATIONS:
+      return 3;
+   case GL_GEOMETRY_SHADER_PRIMITIVES_EMITTED_ARB:
+      return 4;
+   case GL_CLIPPING_INPUT_PRIMITIVES_ARB:
+      return 5;
+   case GL_CLIPPING_OUTPUT_PRIMITIVES_ARB:
+      return 6;
+   case GL_FRAGMENT_SHADER_INVOCATIONS_ARB:
+      return 7;
+   case GL_TESS_CONTROL_SHADER_PATCHES_ARB:
+      return 8;
+   case GL_TESS_EVALUATION_SHADER_INVOCATIONS_ARB:
+      return 9;
+   case GL_COMPUTE_SHADER_INVOCATIONS_ARB:
+      return 10;
+   default:
+      unreachable("unexpected pipeline statistics target");
+   }
+}
+
+
+/**
+ * Called via ctx->Driver.StoreQueryResult() for GL_ARB_query_buffer_object.
+ * The driver writes the result into the buffer on the GPU, so the CPU never
+ * waits for it; many queries can be resolved this way and consumed by
+ * later commands without a round trip.
+ */
+static void
+st_StoreQueryResult(struct gl_context *ctx, struct gl_query_object *q,
+                    struct gl_buffer_object *buf, intptr_t offset,
+                    GLenum pname, GLenum ptype)
+{
+   struct pipe_context *pipe = st_context(ctx)->pipe;
+   struct st_query_object *stq = st_query_object(q);
+   struct st_buffer_object *stObj = st_buffer_object(buf);
+   enum pipe_query_value_type result_type;
+   int index = 0;
+
+   /* The target isn't known to the driver, write it from here. */
+   if (pname == GL_QUERY_TARGET) {
+      store_query_value(pipe, stObj->buffer, offset, ptype, q->Target);
+      return;
+   }
+
+   /* Time elapsed emulated with two timestamps, or a query that failed to
+    * be created: get the result on the CPU.
+    */
+   if (!stq->pq || stq->pq_begin) {
+      switch (pname) {
+      case GL_QUERY_RESULT:
+         if (!q->Ready)
+            st_WaitQuery(ctx, q);
+         break;
+      case GL_QUERY_RESULT_NO_WAIT:
+      case GL_QUERY_RESULT_AVAILABLE:
+         if (!q->Ready)
+            q->Ready = get_query_result(pipe, stq, FALSE);
+         if (pname == GL_QUERY_RESULT_AVAILABLE) {
+            store_query_value(pipe, stObj->buffer, offset, ptype, q->Ready);
+            return;
+         }
+         if (!q->Ready)
+            return;
+         break;
+      default:
+         unreachable("unexpected pname");
+      }
+      store_query_value(pipe, stObj->buffer, offset, ptype, q->Result);
+      return;
+   }
+
+   switch (ptype) {
+   case GL_INT:
+      result_type = PIPE_QUERY_TYPE_I32;
+      break;
+   case GL_UNSIGNED_INT:
+      result_type = PIPE_QUERY_TYPE_U32;
+      break;
+   case GL_INT64_ARB:
+      result_type = PIPE_QUERY_TYPE_I64;
+      break;
+   case GL_UNSIGNED_INT64_ARB:
+      result_type = PIPE_QUERY_TYPE_U64;
+      break;
+   default:
+      unreachable("unexpected ptype");
+   }
+
+   if (pname == GL_QUERY_RESULT_AVAILABLE)
+      index = -1;
+   else if (stq->type == PIPE_QUERY_PIPELINE_STATISTICS)
+      index = pipeline_statistics_index(q->Target);
+
+   pipe->get_query_result_resource(pipe, stq->pq, pname == GL_QUERY_RESULT,
+                                   result_type, index, stObj->buffer, offset);
 }
 
 
@@ -312,5 +495,6 @@ void st_init_query_functions(struct dd_function_table *functions)
    functions->EndQuery = st_EndQuery;
    functions->WaitQuery = st_WaitQuery;
    functions->CheckQuery = st_CheckQuery;
+   functions->StoreQueryResult = st_StoreQueryResult;
    functions->GetTimestamp = st_GetTimestamp;
 }
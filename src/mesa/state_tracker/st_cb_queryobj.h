@@ -43,6 +43,11 @@ struct st_query_object
    struct pipe_query *pq_begin;
 
    unsigned type;  /**< PIPE_QUERY_x */
+
+   /** st_context::num_flushes when the query ended */
+   unsigned flushes_at_end;
+   /** Whether the availability was checked since the query ended */
+   boolean polled;
 };
 
 
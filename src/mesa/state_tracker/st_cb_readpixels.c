@@ -31,13 +31,19 @@
 #include "main/readpix.h"
 #include "main/enums.h"
 #include "main/framebuffer.h"
+#include "main/bufferobj.h"
+#include "util/u_atomic.h"
 #include "util/u_inlines.h"
 #include "util/u_format.h"
+#include "util/u_memory.h"
+#include "vbo/vbo.h"
 
+#include "st_cb_bufferobjects.h"
 #include "st_cb_fbo.h"
 #include "st_atom.h"
 #include "st_context.h"
 #include "st_cb_bitmap.h"
+#include "st_cb_clear.h"
 #include "st_cb_readpixels.h"
 #include "state_tracker/st_cb_texture.h"
 #include "state_tracker/st_format.h"
@@ -68,6 +74,226 @@ needs_integer_signed_unsigned_conversion(const struct gl_context *ctx,
    return FALSE;
 }
 
+
+/**
+ * Pixels which were blitted to a staging texture by glReadPixels or
+ * glGetTexImage, but not yet copied into the pixel pack buffer.
+ *
+ * Mapping the staging texture waits for the blit to finish, so when the
+ * pixels go to a PBO, the copy is left until the buffer contents are
+ * needed: when the buffer is mapped, read, written or used by a draw.
+ * This lets the application queue more work before the GPU has to catch
+ * up, which is what PBO readbacks are used for.
+ */
+struct st_pbo_download
+{
+   struct pipe_resource *staging;
+
+   /** Packing with BufferObj cleared, and the start of the image in the PBO */
+   struct gl_pixelstore_attrib pack;
+   uintptr_t offset;
+
+   /** In gallium terms: a 1D array has a height of 1 and depth layers */
+   GLsizei width, height, depth;
+   GLenum format, type;
+
+   /** Whether the layers of the staging texture are rows of a 1D array */
+   boolean array_1d;
+};
+
+int st_num_pbo_downloads = 0;
+
+
+/**
+ * Have the pixels in \p staging copied into the pixel pack buffer of
+ * \p pack later, instead of mapping \p staging now.  The blit to \p staging
+ * must have been done already.
+ *
+ * \return FALSE if the pixels have to be copied now by the caller.
+ */
+boolean
+st_queue_pbo_download(struct st_context *st, struct pipe_resource *staging,
+                      const struct gl_pixelstore_attrib *pack,
+                      const GLvoid *pixels,
+                      GLsizei width, GLsizei height, GLsizei depth,
+                      GLenum format, GLenum type, boolean array_1d)
+{
+   struct st_buffer_object *obj;
+   struct st_pbo_download *download;
+
+   if (!_mesa_is_bufferobj(pack->BufferObj))
+      return FALSE;
+
+   obj = st_buffer_object(pack->BufferObj);
+
+   /* A persistent mapping could be read at any time. */
+   if (!obj->buffer || _mesa_bufferobj_mapped(&obj->Base, MAP_USER))
+      return FALSE;
+
+   download = CALLOC_STRUCT(st_pbo_download);
+   if (!download)
+      return FALSE;
+
+   /* The previous download may overlap this one. */
+   st_complete_pbo_download(st, obj);
+
+   pipe_resource_reference(&download->staging, staging);
+   download->pack = *pack;
+   download->pack.BufferObj = NULL;
+   download->offset = (uintptr_t) pixels;
+   download->width = width;
+   download->height = height;
+   download->depth = depth;
+   download->format = format;
+   download->type = type;
+   download->array_1d = array_1d;
+
+   obj->download = download;
+   p_atomic_inc(&st_num_pbo_downloads);
+
+   /* Get the blit going. */
+   st->pipe->flush(st->pipe, NULL, 0);
+   return TRUE;
+}
+
+
+static void
+free_pbo_download(struct st_buffer_object *obj)
+{
+   pipe_resource_reference(&obj->download->staging, NULL);
+   FREE(obj->download);
+   obj->download = NULL;
+   p_atomic_dec(&st_num_pbo_downloads);
+}
+
+
+/**
+ * Drop the pending download of \p obj, for when its contents are replaced.
+ */
+void
+st_discard_pbo_download(struct st_buffer_object *obj)
+{
+   if (obj->download)
+      free_pbo_download(obj);
+}
+
+
+/**
+ * Copy the pixels of the pending download of \p obj, if any, into it.
+ */
+void
+st_complete_pbo_download(struct st_context *st, struct st_buffer_object *obj)
+{
+   struct st_pbo_download *download = obj->download;
+   struct pipe_context *pipe = st->pipe;
+   struct pipe_transfer *tex_xfer, *buf_xfer;
+   ubyte *map, *base;
+
+   if (!download)
+      return;
+
+   map = pipe_transfer_map_3d(pipe, download->staging, 0, PIPE_TRANSFER_READ,
+                              0, 0, 0, download->width, download->height,
+                              download->depth, &tex_xfer);
+   if (!map) {
+      free_pbo_download(obj);
+      return;
+   }
+
+   base = pipe_buffer_map(pipe, obj->buffer, PIPE_TRANSFER_WRITE, &buf_xfer);
+   if (base) {
+      const struct gl_pixelstore_attrib *pack = &download->pack;
+      const GLvoid *pixels = base + download->offset;
+      const uint bytesPerRow =
+         download->width * util_format_get_blocksize(download->staging->format);
+      GLint slice, row;
+
+      for (slice = 0; slice < download->depth; slice++) {
+         ubyte *src = map + slice * tex_xfer->layer_stride;
+
+         if (download->array_1d) {
+            GLvoid *dest = _mesa_image_address3d(pack, pixels,
+                                                 download->width,
+                                                 download->depth,
+                                                 download->format,
+                                                 download->type,
+                                                 0, slice, 0);
+            memcpy(dest, src, bytesPerRow);
+            continue;
+         }
+
+         for (row = 0; row < download->height; row++) {
+            GLvoid *dest = _mesa_image_address3d(pack, pixels,
+                                                 download->width,
+                                                 download->height,
+                                                 download->format,
+                                                 download->type,
+                                                 slice, row, 0);
+            memcpy(dest, src, bytesPerRow);
+            src += tex_xfer->stride;
+         }
+      }
+
+      pipe_buffer_unmap(pipe, buf_xfer);
+   }
+
+   pipe_transfer_unmap(pipe, tex_xfer);
+   free_pbo_download(obj);
+}
+
+
+static inline void
+complete_download(struct st_context *st, struct gl_buffer_object *obj)
+{
+   if (obj && _mesa_is_bufferobj(obj) && st_buffer_object(obj)->download)
+      st_complete_pbo_download(st, st_buffer_object(obj));
+}
+
+
+/**
+ * Complete the pending downloads to any buffer a draw may read or write.
+ * Only called while some download is pending.
+ */
+void
+st_complete_pbo_downloads_for_draw(struct st_context *st,
+                                   const struct _mesa_index_buffer *ib,
+                                   struct gl_buffer_object *indirect)
+{
+   struct gl_context *ctx = st->ctx;
+   struct gl_transform_feedback_object *xfb =
+      ctx->TransformFeedback.CurrentObject;
+   unsigned i;
+
+   for (i = 0; i < VERT_ATTRIB_MAX; i++) {
+      if (ctx->Array._DrawArrays[i])
+         complete_download(st, ctx->Array._DrawArrays[i]->BufferObj);
+   }
+
+   if (ib)
+      complete_download(st, ib->obj);
+   complete_download(st, indirect);
+
+   for (i = 0; i < ctx->Const.MaxUniformBufferBindings; i++)
+      complete_download(st, ctx->UniformBufferBindings[i].BufferObject);
+   for (i = 0; i < ctx->Const.MaxShaderStorageBufferBindings; i++)
+      complete_download(st, ctx->ShaderStorageBufferBindings[i].BufferObject);
+   for (i = 0; i < ctx->Const.MaxAtomicBufferBindings; i++)
+      complete_download(st, ctx->AtomicBufferBindings[i].BufferObject);
+
+   for (i = 0; i < ctx->Const.MaxCombinedTextureImageUnits; i++) {
+      const struct gl_texture_object *texObj = ctx->Texture.Unit[i]._Current;
+
+      if (texObj && texObj->Target == GL_TEXTURE_BUFFER)
+         complete_download(st, texObj->BufferObject);
+   }
+
+   if (xfb) {
+      for (i = 0; i < MAX_FEEDBACK_BUFFERS; i++)
+         complete_download(st, xfb->Buffers[i]);
+   }
+}
+
+
 /**
  * This uses a blit to copy the read buffer to a texture format which matches
  * the format and type combo and then a fast read-back is done using memcpy.
@@ -103,9 +329,10 @@ st_readpixels(struct gl_context *ctx, GLint x, GLint y,
    ubyte *map = NULL;
 
    /* Validate state (to be sure we have up-to-date framebuffer surfaces)
-    * and flush the bitmap cache prior to reading. */
+    * and flush the bitmap cache and pending clears prior to reading. */
    st_validate_state(st);
    st_flush_bitmap_cache(st);
+   st_flush_clear(st);
 
    if (!st->prefer_blit_based_texture_transfer) {
       goto fallback;
@@ -137,9 +364,11 @@ st_readpixels(struct gl_context *ctx, GLint x, GLint y,
 
    /* See if the texture format already matches the format and type,
     * in which case the memcpy-based fast path will likely be used and
-    * we don't have to blit. */
-   if (_mesa_format_matches_format_and_type(rb->Format, format,
-                                            type, pack->SwapBytes, NULL)) {
+    * we don't have to blit.  Reading into a PBO still goes through the
+    * blit, so that the copy can be done later. */
+   if (!_mesa_is_bufferobj(pack->BufferObj) &&
+       _mesa_format_matches_format_and_type(rb->Format, format,
+                                           type, pack->SwapBytes, NULL)) {
       goto fallback;
    }
 
@@ -221,6 +450,12 @@ st_readpixels(struct gl_context *ctx, GLint x, GLint y,
    /* blit */
    st->pipe->blit(st->pipe, &blit);
 
+   if (st_queue_pbo_download(st, dst, pack, pixels, width, height, 1,
+                             format, type, FALSE)) {
+      pipe_resource_reference(&dst, NULL);
+      return;
+   }
+
    /* map resources */
    pixels = _mesa_map_pbo_dest(ctx, pack, pixels);
 
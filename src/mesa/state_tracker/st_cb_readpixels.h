@@ -31,7 +31,34 @@
 
 #include "main/glheader.h"
 
+struct _mesa_index_buffer;
 struct dd_function_table;
+struct gl_buffer_object;
+struct gl_pixelstore_attrib;
+struct pipe_resource;
+struct st_buffer_object;
+struct st_context;
+
+/** Number of PBO downloads still to be completed, in all contexts */
+extern int st_num_pbo_downloads;
+
+extern boolean
+st_queue_pbo_download(struct st_context *st, struct pipe_resource *staging,
+                      const struct gl_pixelstore_attrib *pack,
+                      const GLvoid *pixels,
+                      GLsizei width, GLsizei height, GLsizei depth,
+                      GLenum format, GLenum type, boolean array_1d);
+
+extern void
+st_complete_pbo_download(struct st_context *st, struct st_buffer_object *obj);
+
+extern void
+st_discard_pbo_download(struct st_buffer_object *obj);
+
+extern void
+st_complete_pbo_downloads_for_draw(struct st_context *st,
+                                   const struct _mesa_index_buffer *ib,
+                                   struct gl_buffer_object *indirect);
 
 extern void
 st_init_readpixels_functions(struct dd_function_table *functions);
@@ -35,6 +35,7 @@
 #include "pipe/p_context.h"
 #include "pipe/p_screen.h"
 #include "st_context.h"
+#include "st_cb_clear.h"
 #include "st_cb_syncobj.h"
 
 struct st_sync_object {
@@ -73,6 +74,7 @@ static void st_fence_sync(struct gl_context *ctx, struct gl_sync_object *obj,
    assert(condition == GL_SYNC_GPU_COMMANDS_COMPLETE && flags == 0);
    assert(so->fence == NULL);
 
+   st_flush_clear(st_context(ctx));
    pipe->flush(pipe, &so->fence, 0);
 }
 
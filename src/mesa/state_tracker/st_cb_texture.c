@@ -48,8 +48,10 @@
 
 #include "state_tracker/st_debug.h"
 #include "state_tracker/st_context.h"
+#include "state_tracker/st_cb_clear.h"
 #include "state_tracker/st_cb_fbo.h"
 #include "state_tracker/st_cb_flush.h"
+#include "state_tracker/st_cb_readpixels.h"
 #include "state_tracker/st_cb_texture.h"
 #include "state_tracker/st_cb_bufferobjects.h"
 #include "state_tracker/st_format.h"
@@ -198,6 +200,8 @@ st_MapTextureImage(struct gl_context *ctx,
    GLubyte *map;
    struct pipe_transfer *transfer;
 
+   st_flush_clear(st);
+
    pipeMode = 0x0;
    if (mode & GL_MAP_READ_BIT)
       pipeMode |= PIPE_TRANSFER_READ;
@@ -670,6 +674,8 @@ st_TexSubImage(struct gl_context *ctx, GLuint dims,
    assert(!_mesa_is_format_etc2(texImage->TexFormat) &&
           texImage->TexFormat != MESA_FORMAT_ETC1_RGB8);
 
+   st_flush_clear(st);
+
    if (!st->prefer_blit_based_texture_transfer) {
       goto fallback;
    }
@@ -937,6 +943,8 @@ st_GetTexSubImage(struct gl_context * ctx,
    assert(!_mesa_is_format_etc2(texImage->TexFormat) &&
           texImage->TexFormat != MESA_FORMAT_ETC1_RGB8);
 
+   st_flush_clear(st);
+
    if (!st->prefer_blit_based_texture_transfer &&
        !_mesa_is_format_compressed(texImage->TexFormat)) {
       /* Try to avoid the fallback if we're doing texture decompression here */
@@ -961,9 +969,12 @@ st_GetTexSubImage(struct gl_context * ctx,
    }
 
    /* See if the texture format already matches the format and type,
-    * in which case the memcpy-based fast path will be used. */
-   if (_mesa_format_matches_format_and_type(texImage->TexFormat, format,
-                                            type, ctx->Pack.SwapBytes, NULL)) {
+    * in which case the memcpy-based fast path will be used.  Reading into
+    * a PBO still goes through the blit, so that the copy can be done later.
+    */
+   if (!_mesa_is_bufferobj(ctx->Pack.BufferObj) &&
+       _mesa_format_matches_format_and_type(texImage->TexFormat, format,
+                                           type, ctx->Pack.SwapBytes, NULL)) {
       goto fallback;
    }
 
@@ -1104,6 +1115,18 @@ st_GetTexSubImage(struct gl_context * ctx,
    /* blit/render/decompress */
    st->pipe->blit(st->pipe, &blit);
 
+   mesa_format = st_pipe_format_to_mesa_format(dst_format);
+
+   /* Leave a plain copy into a PBO until the PBO is used. */
+   if (_mesa_format_matches_format_and_type(mesa_format, format, type,
+                                            ctx->Pack.SwapBytes, NULL) &&
+       st_queue_pbo_download(st, dst, &ctx->Pack, pixels,
+                             width, height, depth, format, type,
+                             gl_target == GL_TEXTURE_1D_ARRAY)) {
+      pipe_resource_reference(&dst, NULL);
+      return;
+   }
+
    pixels = _mesa_map_pbo_dest(ctx, &ctx->Pack, pixels);
 
    map = pipe_transfer_map_3d(pipe, dst, 0, PIPE_TRANSFER_READ,
@@ -1112,8 +1135,6 @@ st_GetTexSubImage(struct gl_context * ctx,
       goto end;
    }
 
-   mesa_format = st_pipe_format_to_mesa_format(dst_format);
-
    /* copy/pack data into user buffer */
    if (_mesa_format_matches_format_and_type(mesa_format, format, type,
                                             ctx->Pack.SwapBytes, NULL)) {
@@ -1407,6 +1428,8 @@ st_CopyTexSubImage(struct gl_context *ctx, GLuint dims,
       return;
    }
 
+   st_flush_clear(st);
+
    if (_mesa_texstore_needs_transfer_ops(ctx, texImage->_BaseFormat,
                                          texImage->TexFormat)) {
       goto fallback;
@@ -1891,6 +1914,8 @@ st_ClearTexSubImage(struct gl_context *ctx,
    if (!pt)
       return;
 
+   st_flush_clear(st);
+
    u_box_3d(xoffset, yoffset, zoffset + texImage->Face,
             width, height, depth, &box);
    if (texImage->TexObject->Immutable) {
@@ -72,6 +72,7 @@
 #include "st_texture.h"
 #include "pipe/p_context.h"
 #include "util/u_inlines.h"
+#include "util/u_memory.h"
 #include "util/u_upload_mgr.h"
 #include "cso_cache/cso_context.h"
 
@@ -127,6 +128,9 @@ st_destroy_context_priv(struct st_context *st)
       }
    }
 
+   for (shader = 0; shader < ARRAY_SIZE(st->state.constants); shader++)
+      FREE(st->state.constants[shader].shadow);
+
    if (st->default_texture) {
       st->ctx->Driver.DeleteTexture(st->ctx, st->default_texture);
       st->default_texture = NULL;
@@ -335,7 +339,8 @@ static void st_init_driver_flags(struct gl_driver_flags *f)
 struct st_context *st_create_context(gl_api api, struct pipe_context *pipe,
                                      const struct gl_config *visual,
                                      struct st_context *share,
-                                     const struct st_config_options *options)
+                                     const struct st_config_options *options,
+                                     bool no_error)
 {
    struct gl_context *ctx;
    struct gl_context *shareCtx = share ? share->ctx : NULL;
@@ -352,6 +357,12 @@ struct st_context *st_create_context(gl_api api, struct pipe_context *pipe,
 
    st_init_driver_flags(&ctx->DriverFlags);
 
+   /* This must be set before the dispatch tables are created, to get the
+    * no-error entrypoints.
+    */
+   if (no_error)
+      ctx->Const.ContextFlags |= GL_CONTEXT_FLAG_NO_ERROR_BIT_KHR;
+
    /* XXX: need a capability bit in gallium to query if the pipe
     * driver prefers DP4 or MUL/MAD for vertex transformation.
     */
@@ -402,6 +413,9 @@ void st_destroy_context( struct st_context *st )
    pipe_sampler_view_reference(&st->pixel_xfer.pixelmap_sampler_view, NULL);
    pipe_resource_reference(&st->pixel_xfer.pixelmap_texture, NULL);
 
+   for (i = 0; i < st->last_num_vbuffers; i++)
+      pipe_resource_reference(&st->last_vbuffers[i].buffer, NULL);
+
    _vbo_DestroyContext(st->ctx);
 
    st_destroy_program_variants(st);
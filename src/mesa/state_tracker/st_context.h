@@ -63,6 +63,9 @@ struct u_upload_mgr;
 #define ST_NEW_TESSEVAL_PROGRAM        (1 << 10)
 #define ST_NEW_SAMPLER_VIEWS           (1 << 11)
 
+/** Maximum number of state atoms, see st_atom.c */
+#define ST_MAX_ATOMS 64
+
 
 struct st_state_flags {
    GLuint mesa;
@@ -119,6 +122,9 @@ struct st_context
 
    boolean vertex_array_out_of_memory;
 
+   /** Number of st_flush() calls, for telling whether a query was flushed */
+   unsigned num_flushes;
+
    /* Some state is contained in constant objects.
     * Other state is just parameter values.
     */
@@ -128,12 +134,17 @@ struct st_context
       struct pipe_rasterizer_state          rasterizer;
       struct pipe_sampler_state samplers[PIPE_SHADER_TYPES][PIPE_MAX_SAMPLERS];
       GLuint num_samplers[PIPE_SHADER_TYPES];
+      /** Which of samplers[] are bound, see update_shader_samplers() */
+      GLbitfield samplers_bound[PIPE_SHADER_TYPES];
       struct pipe_sampler_view *sampler_views[PIPE_SHADER_TYPES][PIPE_MAX_SAMPLERS];
       GLuint num_sampler_views[PIPE_SHADER_TYPES];
       struct pipe_clip_state clip;
       struct {
          void *ptr;
          unsigned size;
+         /** Copy of the last values bound, to skip rebinding them */
+         void *shadow;
+         unsigned shadow_size;
       } constants[PIPE_SHADER_TYPES];
       struct pipe_framebuffer_state framebuffer;
       struct pipe_scissor_state scissor[PIPE_MAX_VIEWPORTS];
@@ -150,6 +161,22 @@ struct st_context
 
    struct st_state_flags dirty;
 
+   /**
+    * For each bit of st_state_flags::mesa and st_state_flags::st, the mask
+    * of atoms (bit i is atom i) which depend on it.  Set up by
+    * st_init_atoms().
+    */
+   uint64_t atoms_for_mesa_flag[32];
+   uint64_t atoms_for_st_flag[64];
+
+   /** The dirty flags seen by the last st_validate_state() and its atoms. */
+   struct st_state_flags last_dirty;
+   uint64_t last_atoms;
+
+   /** Number of validations and of times each atom ran, for ST_DEBUG=atoms */
+   unsigned num_validations;
+   unsigned atom_invocations[ST_MAX_ATOMS];
+
    GLboolean vertdata_edgeflags;
    GLboolean edgeflag_culls_prims;
 
@@ -198,6 +225,12 @@ struct st_context
       void *fs;
       void *vs_layered;
       void *gs_layered;
+
+      /** Full-surface clear not yet passed to pipe->clear */
+      unsigned pending_buffers;   /**< PIPE_CLEAR_x bitmask */
+      union pipe_color_union pending_color;
+      double pending_depth;
+      unsigned pending_stencil;
    } clear;
 
    /** used for anything using util_draw_vertex_buffer */
@@ -214,6 +247,14 @@ struct st_context
    /* The number of vertex buffers from the last call of validate_arrays. */
    unsigned last_num_vbuffers;
 
+   /**
+    * Vertex buffers and elements from the last call of validate_arrays, so
+    * that only what changed is bound again.  The buffers are referenced.
+    */
+   struct pipe_vertex_buffer last_vbuffers[PIPE_MAX_SHADER_INPUTS];
+   struct pipe_vertex_element last_velements[PIPE_MAX_ATTRIBS];
+   unsigned last_num_velements;
+
    int32_t draw_stamp;
    int32_t read_stamp;
 
@@ -314,7 +355,8 @@ extern struct st_context *
 st_create_context(gl_api api, struct pipe_context *pipe,
                   const struct gl_config *visual,
                   struct st_context *share,
-                  const struct st_config_options *options);
+                  const struct st_config_options *options,
+                  bool no_error);
 
 extern void
 st_destroy_context(struct st_context *st);
@@ -57,6 +57,8 @@ static const struct debug_named_value st_debug_flags[] = {
    { "buffer",   DEBUG_BUFFER, NULL },
    { "wf",       DEBUG_WIREFRAME, NULL },
    { "precompile",  DEBUG_PRECOMPILE, NULL },
+   { "atoms",    DEBUG_ATOMS, NULL },
+   { "variants", DEBUG_VARIANTS, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -49,6 +49,8 @@
 #include "st_context.h"
 #include "st_atom.h"
 #include "st_cb_bufferobjects.h"
+#include "st_cb_clear.h"
+#include "st_cb_readpixels.h"
 #include "st_cb_xformfb.h"
 #include "st_debug.h"
 #include "st_draw.h"
@@ -56,15 +58,21 @@
 
 #include "pipe/p_context.h"
 #include "pipe/p_defines.h"
+#include "util/u_atomic.h"
 #include "util/u_inlines.h"
 #include "util/u_format.h"
 #include "util/u_prim.h"
 #include "util/u_draw_quad.h"
 #include "util/u_upload_mgr.h"
 #include "draw/draw_context.h"
+#include "hud/hud_counters.h"
 #include "cso_cache/cso_context.h"
 
 
+/** Number of draws handed to the driver at a time */
+#define ST_MAX_BATCHED_DRAWS 32
+
+
 /**
  * This is very similar to vbo_all_varyings_in_vbos() but we are
  * only interested in per-vertex data.  See bug 38626.
@@ -191,15 +199,21 @@ st_draw_vbo(struct gl_context *ctx,
    struct st_context *st = st_context(ctx);
    struct pipe_index_buffer ibuffer = {0};
    struct pipe_draw_info info;
+   struct pipe_draw_info draws[ST_MAX_BATCHED_DRAWS];
    const struct gl_client_array **arrays = ctx->Array._DrawArrays;
-   unsigned i;
+   unsigned i, num_draws = 0;
 
    /* Mesa core state should have been validated already */
    assert(ctx->NewState == 0x0);
 
+   if (unlikely(p_atomic_read(&st_num_pbo_downloads)))
+      st_complete_pbo_downloads_for_draw(st, ib, indirect);
+
    /* Validate state. */
    if (st->dirty.st || ctx->NewDriverState) {
+      int64_t start = hud_counter_begin_time();
       st_validate_state(st);
+      hud_counter_end_time(HUD_COUNTER_VALIDATE_TIME, start);
 
 #if 0
       if (MESA_VERBOSE & VERBOSE_GLSL) {
@@ -210,6 +224,8 @@ st_draw_vbo(struct gl_context *ctx,
 #endif
    }
 
+   st_flush_clear(st);
+
    if (st->vertex_array_out_of_memory) {
       return;
    }
@@ -257,41 +273,54 @@ st_draw_vbo(struct gl_context *ctx,
       info.restart_index = ctx->Array.RestartIndex;
    }
 
-   /* do actual drawing */
+   /* do actual drawing, handing the driver as many draws at a time as
+    * possible (glMultiDraw*, multi-draw indirect, vbo batches)
+    */
    for (i = 0; i < nr_prims; i++) {
-      info.mode = translate_prim(ctx, prims[i].mode);
-      info.start = prims[i].start;
-      info.count = prims[i].count;
-      info.start_instance = prims[i].base_instance;
-      info.instance_count = prims[i].num_instances;
-      info.vertices_per_patch = ctx->TessCtrlProgram.patch_vertices;
-      info.index_bias = prims[i].basevertex;
+      struct pipe_draw_info *draw = &draws[num_draws];
+
+      *draw = info;
+      draw->mode = translate_prim(ctx, prims[i].mode);
+      draw->start = prims[i].start;
+      draw->count = prims[i].count;
+      draw->start_instance = prims[i].base_instance;
+      draw->instance_count = prims[i].num_instances;
+      draw->vertices_per_patch = ctx->TessCtrlProgram.patch_vertices;
+      draw->index_bias = prims[i].basevertex;
       if (!ib) {
-         info.min_index = info.start;
-         info.max_index = info.start + info.count - 1;
+         draw->min_index = draw->start;
+         draw->max_index = draw->start + draw->count - 1;
       }
-      info.indirect_offset = prims[i].indirect_offset;
+      draw->indirect_offset = prims[i].indirect_offset;
 
       if (ST_DEBUG & DEBUG_DRAW) {
          debug_printf("st/draw: mode %s  start %u  count %u  indexed %d\n",
-                      u_prim_name(info.mode),
-                      info.start,
-                      info.count,
-                      info.indexed);
+                      u_prim_name(draw->mode),
+                      draw->start,
+                      draw->count,
+                      draw->indexed);
       }
 
-      if (info.count_from_stream_output || info.indirect) {
-         cso_draw_vbo(st->cso_context, &info);
+      if (draw->count_from_stream_output || draw->indirect) {
+         num_draws++;
       }
-      else if (info.primitive_restart) {
+      else if (draw->primitive_restart) {
          /* don't trim, restarts might be inside index list */
-         cso_draw_vbo(st->cso_context, &info);
+         num_draws++;
+      }
+      else if (u_trim_pipe_prim(prims[i].mode, &draw->count)) {
+         num_draws++;
       }
-      else if (u_trim_pipe_prim(prims[i].mode, &info.count)) {
-         cso_draw_vbo(st->cso_context, &info);
+
+      if (num_draws == ARRAY_SIZE(draws)) {
+         cso_draw_vbo_multi(st->cso_context, draws, num_draws);
+         num_draws = 0;
       }
    }
 
+   if (num_draws)
+      cso_draw_vbo_multi(st->cso_context, draws, num_draws);
+
    if (ib && st->indexbuf_uploader && !_mesa_is_bufferobj(ib->obj)) {
       pipe_resource_reference(&ibuffer.buffer, NULL);
    }
@@ -38,6 +38,7 @@
 
 #include "st_debug.h"
 #include "st_context.h"
+#include "st_cb_clear.h"
 #include "st_texture.h"
 #include "st_gen_mipmap.h"
 #include "st_cb_texture.h"
@@ -86,6 +87,8 @@ st_generate_mipmap(struct gl_context *ctx, GLenum target,
    if (!pt)
       return;
 
+   st_flush_clear(st);
+
    /* not sure if this ultimately actually should work,
       but we're not supporting multisampled textures yet. */
    assert(pt->nr_samples < 2);
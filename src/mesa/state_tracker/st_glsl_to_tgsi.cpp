@@ -336,8 +336,9 @@ struct array_decl {
    unsigned array_size;
 };
 
+/** Rename table entry, indexed by the old temporary register index. */
 struct rename_reg_pair {
-   int old_reg;
+   bool valid;
    int new_reg;
 };
 
@@ -484,7 +485,7 @@ public:
 
    void simplify_cmp(void);
 
-   void rename_temp_registers(int num_renames, struct rename_reg_pair *renames);
+   void rename_temp_registers(struct rename_reg_pair *renames);
    void get_first_temp_read(int *first_reads);
    void get_last_temp_read_first_temp_write(int *last_reads, int *first_writes);
    void get_last_temp_write(int *last_writes);
@@ -3570,10 +3571,12 @@ get_src_arg_mask(st_dst_reg dst, st_src_reg src)
 void
 glsl_to_tgsi_visitor::simplify_cmp(void)
 {
-   int tempWritesSize = 0;
-   unsigned *tempWrites = NULL;
+   unsigned *tempWrites = rzalloc_array(mem_ctx, unsigned, this->next_temp);
    unsigned outputWrites[VARYING_SLOT_TESS_MAX];
 
+   if (!tempWrites)
+      return;
+
    memset(outputWrites, 0, sizeof(outputWrites));
 
    foreach_in_list(glsl_to_tgsi_instruction, inst, &this->instructions) {
@@ -3596,19 +3599,7 @@ glsl_to_tgsi_visitor::simplify_cmp(void)
          prevWriteMask = outputWrites[inst->dst[0].index];
          outputWrites[inst->dst[0].index] |= inst->dst[0].writemask;
       } else if (inst->dst[0].file == PROGRAM_TEMPORARY) {
-         if (inst->dst[0].index >= tempWritesSize) {
-            const int inc = 4096;
-
-            tempWrites = (unsigned*)
-                         realloc(tempWrites,
-                                 (tempWritesSize + inc) * sizeof(unsigned));
-            if (!tempWrites)
-               return;
-
-            memset(tempWrites + tempWritesSize, 0, inc * sizeof(unsigned));
-            tempWritesSize += inc;
-         }
-
+         assert(inst->dst[0].index < this->next_temp);
          prevWriteMask = tempWrites[inst->dst[0].index];
          tempWrites[inst->dst[0].index] |= inst->dst[0].writemask;
       } else
@@ -3627,35 +3618,32 @@ glsl_to_tgsi_visitor::simplify_cmp(void)
       }
    }
 
-   free(tempWrites);
+   ralloc_free(tempWrites);
 }
 
-/* Replaces all references to a temporary register index with another index. */
+/* Replaces all references to a temporary register index with another index.
+ * The renames table is indexed by the old register index. */
 void
-glsl_to_tgsi_visitor::rename_temp_registers(int num_renames, struct rename_reg_pair *renames)
+glsl_to_tgsi_visitor::rename_temp_registers(struct rename_reg_pair *renames)
 {
    foreach_in_list(glsl_to_tgsi_instruction, inst, &this->instructions) {
       unsigned j;
-      int k;
       for (j = 0; j < num_inst_src_regs(inst); j++) {
-         if (inst->src[j].file == PROGRAM_TEMPORARY)
-            for (k = 0; k < num_renames; k++)
-               if (inst->src[j].index == renames[k].old_reg)
-                  inst->src[j].index = renames[k].new_reg;
+         if (inst->src[j].file == PROGRAM_TEMPORARY &&
+             renames[inst->src[j].index].valid)
+            inst->src[j].index = renames[inst->src[j].index].new_reg;
       }
 
       for (j = 0; j < inst->tex_offset_num_offset; j++) {
-         if (inst->tex_offsets[j].file == PROGRAM_TEMPORARY)
-            for (k = 0; k < num_renames; k++)
-               if (inst->tex_offsets[j].index == renames[k].old_reg)
-                  inst->tex_offsets[j].index = renames[k].new_reg;
+         if (inst->tex_offsets[j].file == PROGRAM_TEMPORARY &&
+             renames[inst->tex_offsets[j].index].valid)
+            inst->tex_offsets[j].index = renames[inst->tex_offsets[j].index].new_reg;
       }
 
       for (j = 0; j < num_inst_dst_regs(inst); j++) {
-         if (inst->dst[j].file == PROGRAM_TEMPORARY)
-             for (k = 0; k < num_renames; k++)
-                if (inst->dst[j].index == renames[k].old_reg)
-                   inst->dst[j].index = renames[k].new_reg;
+         if (inst->dst[j].file == PROGRAM_TEMPORARY &&
+             renames[inst->dst[j].index].valid)
+            inst->dst[j].index = renames[inst->dst[j].index].new_reg;
       }
    }
 }
@@ -3692,17 +3680,35 @@ glsl_to_tgsi_visitor::get_first_temp_read(int *first_reads)
    }
 }
 
+/* Records a temporary read at instruction i.  Reads inside a loop are
+ * marked with -2 and remembered in loop_reads, to be moved to the end of the
+ * outermost loop once it's reached. */
+static inline void
+record_temp_read(int *last_reads, int *loop_reads, int *num_loop_reads,
+                 int index, int depth, int i)
+{
+   if (depth == 0) {
+      last_reads[index] = i;
+   } else if (last_reads[index] != -2) {
+      last_reads[index] = -2;
+      loop_reads[(*num_loop_reads)++] = index;
+   }
+}
+
 void
 glsl_to_tgsi_visitor::get_last_temp_read_first_temp_write(int *last_reads, int *first_writes)
 {
    int depth = 0; /* loop depth */
    int loop_start = -1; /* index of the first active BGNLOOP (if any) */
+   int *loop_reads = ralloc_array(mem_ctx, int, this->next_temp);
+   int num_loop_reads = 0;
    unsigned i = 0, j;
    int k;
    foreach_in_list(glsl_to_tgsi_instruction, inst, &this->instructions) {
       for (j = 0; j < num_inst_src_regs(inst); j++) {
          if (inst->src[j].file == PROGRAM_TEMPORARY)
-            last_reads[inst->src[j].index] = (depth == 0) ? i : -2;
+            record_temp_read(last_reads, loop_reads, &num_loop_reads,
+                             inst->src[j].index, depth, i);
       }
       for (j = 0; j < num_inst_dst_regs(inst); j++) {
          if (inst->dst[j].file == PROGRAM_TEMPORARY)
@@ -3711,7 +3717,8 @@ glsl_to_tgsi_visitor::get_last_temp_read_first_temp_write(int *last_reads, int *
       }
       for (j = 0; j < inst->tex_offset_num_offset; j++) {
          if (inst->tex_offsets[j].file == PROGRAM_TEMPORARY)
-            last_reads[inst->tex_offsets[j].index] = (depth == 0) ? i : -2;
+            record_temp_read(last_reads, loop_reads, &num_loop_reads,
+                             inst->tex_offsets[j].index, depth, i);
       }
       if (inst->op == TGSI_OPCODE_BGNLOOP) {
          if(depth++ == 0)
@@ -3719,16 +3726,16 @@ glsl_to_tgsi_visitor::get_last_temp_read_first_temp_write(int *last_reads, int *
       } else if (inst->op == TGSI_OPCODE_ENDLOOP) {
          if (--depth == 0) {
             loop_start = -1;
-            for (k = 0; k < this->next_temp; k++) {
-               if (last_reads[k] == -2) {
-                  last_reads[k] = i;
-               }
-            }
+            for (k = 0; k < num_loop_reads; k++)
+               last_reads[loop_reads[k]] = i;
+            num_loop_reads = 0;
          }
       }
       assert(depth >= 0);
       i++;
    }
+
+   ralloc_free(loop_reads);
 }
 
 void
@@ -3786,6 +3793,11 @@ glsl_to_tgsi_visitor::copy_propagate(void)
                                                   glsl_to_tgsi_instruction *,
                                                   this->next_temp * 4);
    int *acp_level = rzalloc_array(mem_ctx, int, this->next_temp * 4);
+   /* Whether a temporary, or any output, may be the source of an ACP entry.
+    * Writes to other registers don't need to walk the whole ACP.
+    */
+   bool *acp_src_temp = rzalloc_array(mem_ctx, bool, this->next_temp);
+   bool acp_src_output = false;
    int level = 0;
 
    foreach_in_list(glsl_to_tgsi_instruction, inst, &this->instructions) {
@@ -3897,6 +3909,10 @@ glsl_to_tgsi_visitor::copy_propagate(void)
                /* Any output might be written, so no copy propagation
                 * from outputs across this instruction.
                 */
+               if (!acp_src_output)
+                  continue;
+
+               acp_src_output = false;
                for (int r = 0; r < this->next_temp; r++) {
                   for (int c = 0; c < 4; c++) {
                      if (!acp[4 * r + c])
@@ -3917,20 +3933,31 @@ glsl_to_tgsi_visitor::copy_propagate(void)
                }
 
                /* Clear where it's used as src. */
+               bool *src_flag = inst->dst[d].file == PROGRAM_TEMPORARY ?
+                  &acp_src_temp[inst->dst[d].index] : &acp_src_output;
+               bool still_src = false;
+
+               if (!*src_flag)
+                  continue;
+
                for (int r = 0; r < this->next_temp; r++) {
                   for (int c = 0; c < 4; c++) {
-                     if (!acp[4 * r + c])
+                     if (!acp[4 * r + c] ||
+                         acp[4 * r + c]->src[0].file != inst->dst[d].file)
                         continue;
 
                      int src_chan = GET_SWZ(acp[4 * r + c]->src[0].swizzle, c);
 
-                     if (acp[4 * r + c]->src[0].file == inst->dst[d].file &&
-                         acp[4 * r + c]->src[0].index == inst->dst[d].index &&
+                     if (acp[4 * r + c]->src[0].index == inst->dst[d].index &&
                          inst->dst[d].writemask & (1 << src_chan)) {
                         acp[4 * r + c] = NULL;
+                     } else if (inst->dst[d].file == PROGRAM_OUTPUT ||
+                                acp[4 * r + c]->src[0].index == inst->dst[d].index) {
+                        still_src = true;
                      }
                   }
                }
+               *src_flag = still_src;
             }
          }
          break;
@@ -3954,9 +3981,15 @@ glsl_to_tgsi_visitor::copy_propagate(void)
                acp_level[4 * inst->dst[0].index + i] = level;
             }
          }
+
+         if (inst->src[0].file == PROGRAM_TEMPORARY)
+            acp_src_temp[inst->src[0].index] = true;
+         else if (inst->src[0].file == PROGRAM_OUTPUT)
+            acp_src_output = true;
       }
    }
 
+   ralloc_free(acp_src_temp);
    ralloc_free(acp_level);
    ralloc_free(acp);
 }
@@ -4178,16 +4211,30 @@ glsl_to_tgsi_visitor::merge_two_dsts(void)
 /* Merges temporary registers together where possible to reduce the number of
  * registers needed to run a program.
  *
+ * This is a linear scan over the live intervals of the registers, from their
+ * first write to their last read: walking the instructions in order, the
+ * registers whose last read is at the current instruction are released first,
+ * then each register first written there takes over a released register if
+ * there is one.  The intervals are bucketed by instruction index, so no
+ * sorting is needed and the pass is linear in the number of registers and
+ * instructions.
+ *
  * Produces optimal code only after copy propagation and dead code elimination
  * have been run. */
 void
 glsl_to_tgsi_visitor::merge_registers(void)
 {
-   int *last_reads = rzalloc_array(mem_ctx, int, this->next_temp);
-   int *first_writes = rzalloc_array(mem_ctx, int, this->next_temp);
-   struct rename_reg_pair *renames = rzalloc_array(mem_ctx, struct rename_reg_pair, this->next_temp);
-   int i, j;
-   int num_renames = 0;
+   void *tmp_ctx = ralloc_context(NULL);
+   int *last_reads = ralloc_array(tmp_ctx, int, this->next_temp);
+   int *first_writes = ralloc_array(tmp_ctx, int, this->next_temp);
+   struct rename_reg_pair *renames = rzalloc_array(tmp_ctx, struct rename_reg_pair, this->next_temp);
+   int *next_start = ralloc_array(tmp_ctx, int, this->next_temp);
+   int *next_end = ralloc_array(tmp_ctx, int, this->next_temp);
+   int *free_regs = ralloc_array(tmp_ctx, int, this->next_temp);
+   int *start_head, *end_head;
+   int num_free = 0;
+   int num_insts = 0;
+   int i, ip;
 
    /* Read the indices of the last read and first write to each temp register
     * into an array so that we don't have to traverse the instruction list as
@@ -4198,40 +4245,55 @@ glsl_to_tgsi_visitor::merge_registers(void)
    }
    get_last_temp_read_first_temp_write(last_reads, first_writes);
 
-   /* Start looking for registers with non-overlapping usages that can be
-    * merged together. */
    for (i = 0; i < this->next_temp; i++) {
       /* Don't touch unused registers. */
       if (last_reads[i] < 0 || first_writes[i] < 0) continue;
 
-      for (j = 0; j < this->next_temp; j++) {
-         /* Don't touch unused registers. */
-         if (last_reads[j] < 0 || first_writes[j] < 0) continue;
-
-         /* We can merge the two registers if the first write to j is after or
-          * in the same instruction as the last read from i.  Note that the
-          * register at index i will always be used earlier or at the same time
-          * as the register at index j. */
-         if (first_writes[i] <= first_writes[j] &&
-             last_reads[i] <= first_writes[j]) {
-            renames[num_renames].old_reg = j;
-            renames[num_renames].new_reg = i;
-            num_renames++;
-
-            /* Update the first_writes and last_reads arrays with the new
-             * values for the merged register index, and mark the newly unused
-             * register index as such. */
-            last_reads[i] = last_reads[j];
-            first_writes[j] = -1;
-            last_reads[j] = -1;
+      num_insts = MAX2(num_insts, MAX2(last_reads[i], first_writes[i]) + 1);
+   }
+
+   start_head = ralloc_array(tmp_ctx, int, num_insts + 1);
+   end_head = ralloc_array(tmp_ctx, int, num_insts + 1);
+   for (ip = 0; ip <= num_insts; ip++) {
+      start_head[ip] = -1;
+      end_head[ip] = -1;
+   }
+
+   /* Bucket the registers by their first write, keeping them in index order
+    * within an instruction. */
+   for (i = this->next_temp - 1; i >= 0; i--) {
+      if (last_reads[i] < 0 || first_writes[i] < 0) continue;
+
+      next_start[i] = start_head[first_writes[i]];
+      start_head[first_writes[i]] = i;
+   }
+
+   for (ip = 0; ip <= num_insts; ip++) {
+      /* A register is free for reuse from the instruction doing its last
+       * read, as the sources are read before the destination is written. */
+      for (i = end_head[ip]; i >= 0; i = next_end[i])
+         free_regs[num_free++] = renames[i].valid ? renames[i].new_reg : i;
+
+      if (ip == num_insts)
+         break;
+
+      for (i = start_head[ip]; i >= 0; i = next_start[i]) {
+         /* Registers without a read after their first write only live
+          * for the instruction writing them. */
+         int end = MAX2(last_reads[i], first_writes[i] + 1);
+
+         if (num_free) {
+            renames[i].valid = true;
+            renames[i].new_reg = free_regs[--num_free];
          }
+
+         next_end[i] = end_head[end];
+         end_head[end] = i;
       }
    }
 
-   rename_temp_registers(num_renames, renames);
-   ralloc_free(renames);
-   ralloc_free(last_reads);
-   ralloc_free(first_writes);
+   rename_temp_registers(renames);
+   ralloc_free(tmp_ctx);
 }
 
 /* Reassign indices to temporary registers by reusing unused indices created
@@ -4243,7 +4305,6 @@ glsl_to_tgsi_visitor::renumber_registers(void)
    int new_index = 0;
    int *first_reads = rzalloc_array(mem_ctx, int, this->next_temp);
    struct rename_reg_pair *renames = rzalloc_array(mem_ctx, struct rename_reg_pair, this->next_temp);
-   int num_renames = 0;
    for (i = 0; i < this->next_temp; i++) {
       first_reads[i] = -1;
    }
@@ -4252,14 +4313,13 @@ glsl_to_tgsi_visitor::renumber_registers(void)
    for (i = 0; i < this->next_temp; i++) {
       if (first_reads[i] < 0) continue;
       if (i != new_index) {
-         renames[num_renames].old_reg = i;
-         renames[num_renames].new_reg = new_index;
-         num_renames++;
+         renames[i].valid = true;
+         renames[i].new_reg = new_index;
       }
       new_index++;
    }
 
-   rename_temp_registers(num_renames, renames);
+   rename_temp_registers(renames);
    this->next_temp = new_index;
    ralloc_free(renames);
    ralloc_free(first_reads);
@@ -5681,6 +5741,114 @@ st_dump_program_for_shader_db(struct gl_context *ctx,
    }
 }
 
+/**
+ * The GLSL IR lowering and optimization of each stage in st_link_shader().
+ * Stages don't share any IR, so they can be done on separate threads.  The
+ * screen is queried up front so that the threads only touch the IR.
+ */
+struct st_lower_job {
+   struct gl_context *ctx;
+   unsigned num_shaders;
+   struct gl_shader *shaders[MESA_SHADER_STAGES];
+   bool have_dround[MESA_SHADER_STAGES];
+   bool have_dfrexp[MESA_SHADER_STAGES];
+   bool have_gather_offsets;
+};
+
+static void
+st_lower_glsl_ir(const struct st_lower_job *job, unsigned index)
+{
+   struct gl_context *ctx = job->ctx;
+   struct gl_shader *shader = job->shaders[index];
+   bool progress;
+   exec_list *ir = shader->ir;
+   gl_shader_stage stage = _mesa_shader_enum_to_shader_stage(shader->Type);
+   const struct gl_shader_compiler_options *options =
+         &ctx->Const.ShaderCompilerOptions[stage];
+   bool have_dround = job->have_dround[index];
+   bool have_dfrexp = job->have_dfrexp[index];
+
+   /* If there are forms of indirect addressing that the driver
+    * cannot handle, perform the lowering pass.
+    */
+   if (options->EmitNoIndirectInput || options->EmitNoIndirectOutput ||
+       options->EmitNoIndirectTemp || options->EmitNoIndirectUniform) {
+      lower_variable_index_to_cond_assign(shader->Stage, ir,
+                                          options->EmitNoIndirectInput,
+                                          options->EmitNoIndirectOutput,
+                                          options->EmitNoIndirectTemp,
+                                          options->EmitNoIndirectUniform);
+   }
+
+   if (ctx->Extensions.ARB_shading_language_packing) {
+      unsigned lower_inst = LOWER_PACK_SNORM_2x16 |
+                            LOWER_UNPACK_SNORM_2x16 |
+                            LOWER_PACK_UNORM_2x16 |
+                            LOWER_UNPACK_UNORM_2x16 |
+                            LOWER_PACK_SNORM_4x8 |
+                            LOWER_UNPACK_SNORM_4x8 |
+                            LOWER_UNPACK_UNORM_4x8 |
+                            LOWER_PACK_UNORM_4x8 |
+                            LOWER_PACK_HALF_2x16 |
+                            LOWER_UNPACK_HALF_2x16;
+
+      if (ctx->Extensions.ARB_gpu_shader5)
+         lower_inst |= LOWER_PACK_USE_BFI |
+                       LOWER_PACK_USE_BFE;
+
+      lower_packing_builtins(ir, lower_inst);
+   }
+
+   if (!job->have_gather_offsets)
+      lower_offset_arrays(ir);
+   do_mat_op_to_vec(ir);
+   lower_instructions(ir,
+                      MOD_TO_FLOOR |
+                      DIV_TO_MUL_RCP |
+                      EXP_TO_EXP2 |
+                      LOG_TO_LOG2 |
+                      LDEXP_TO_ARITH |
+                      (have_dfrexp ? 0 : DFREXP_DLDEXP_TO_ARITH) |
+                      CARRY_TO_ARITH |
+                      BORROW_TO_ARITH |
+                      (have_dround ? 0 : DOPS_TO_DFRAC) |
+                      (options->EmitNoPow ? POW_TO_EXP2 : 0) |
+                      (!ctx->Const.NativeIntegers ? INT_DIV_TO_MUL_RCP : 0) |
+                      (options->EmitNoSat ? SAT_TO_CLAMP : 0));
+
+   do_vec_index_to_cond_assign(ir);
+   lower_vector_insert(ir, true);
+   lower_quadop_vector(ir, false);
+   lower_noise(ir);
+   if (options->MaxIfDepth == 0) {
+      lower_discard(ir);
+   }
+
+   do {
+      progress = false;
+
+      progress = do_lower_jumps(ir, true, true, options->EmitNoMainReturn, options->EmitNoCont, options->EmitNoLoops) || progress;
+
+      progress = do_common_optimization(ir, true, true, options,
+                                        ctx->Const.NativeIntegers)
+        || progress;
+
+      progress = lower_if_to_cond_assign(ir, options->MaxIfDepth) || progress;
+
+   } while (progress);
+
+   validate_ir_tree(ir);
+}
+
+static void
+st_lower_glsl_ir_stages(void *data, unsigned first, unsigned end)
+{
+   const struct st_lower_job *job = (const struct st_lower_job *) data;
+
+   for (unsigned i = first; i < end; i++)
+      st_lower_glsl_ir(job, i);
+}
+
 /**
  * Link a shader.
  * Called via ctx->Driver.LinkShader()
@@ -5691,95 +5859,32 @@ GLboolean
 st_link_shader(struct gl_context *ctx, struct gl_shader_program *prog)
 {
    struct pipe_screen *pscreen = ctx->st->pipe->screen;
+   struct st_lower_job job;
    assert(prog->LinkStatus);
 
+   job.ctx = ctx;
+   job.num_shaders = 0;
+   job.have_gather_offsets =
+      pscreen->get_param(pscreen, PIPE_CAP_TEXTURE_GATHER_OFFSETS);
+
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
       if (prog->_LinkedShaders[i] == NULL)
          continue;
 
-      bool progress;
-      exec_list *ir = prog->_LinkedShaders[i]->ir;
       gl_shader_stage stage = _mesa_shader_enum_to_shader_stage(prog->_LinkedShaders[i]->Type);
-      const struct gl_shader_compiler_options *options =
-            &ctx->Const.ShaderCompilerOptions[stage];
       unsigned ptarget = st_shader_stage_to_ptarget(stage);
-      bool have_dround = pscreen->get_shader_param(pscreen, ptarget,
-                                                   PIPE_SHADER_CAP_TGSI_DROUND_SUPPORTED);
-      bool have_dfrexp = pscreen->get_shader_param(pscreen, ptarget,
-                                                   PIPE_SHADER_CAP_TGSI_DFRACEXP_DLDEXP_SUPPORTED);
+      unsigned n = job.num_shaders++;
 
-      /* If there are forms of indirect addressing that the driver
-       * cannot handle, perform the lowering pass.
-       */
-      if (options->EmitNoIndirectInput || options->EmitNoIndirectOutput ||
-          options->EmitNoIndirectTemp || options->EmitNoIndirectUniform) {
-         lower_variable_index_to_cond_assign(prog->_LinkedShaders[i]->Stage, ir,
-                                             options->EmitNoIndirectInput,
-                                             options->EmitNoIndirectOutput,
-                                             options->EmitNoIndirectTemp,
-                                             options->EmitNoIndirectUniform);
-      }
-
-      if (ctx->Extensions.ARB_shading_language_packing) {
-         unsigned lower_inst = LOWER_PACK_SNORM_2x16 |
-                               LOWER_UNPACK_SNORM_2x16 |
-                               LOWER_PACK_UNORM_2x16 |
-                               LOWER_UNPACK_UNORM_2x16 |
-                               LOWER_PACK_SNORM_4x8 |
-                               LOWER_UNPACK_SNORM_4x8 |
-                               LOWER_UNPACK_UNORM_4x8 |
-                               LOWER_PACK_UNORM_4x8 |
-                               LOWER_PACK_HALF_2x16 |
-                               LOWER_UNPACK_HALF_2x16;
-
-         if (ctx->Extensions.ARB_gpu_shader5)
-            lower_inst |= LOWER_PACK_USE_BFI |
-                          LOWER_PACK_USE_BFE;
-
-         lower_packing_builtins(ir, lower_inst);
-      }
-
-      if (!pscreen->get_param(pscreen, PIPE_CAP_TEXTURE_GATHER_OFFSETS))
-         lower_offset_arrays(ir);
-      do_mat_op_to_vec(ir);
-      lower_instructions(ir,
-                         MOD_TO_FLOOR |
-                         DIV_TO_MUL_RCP |
-                         EXP_TO_EXP2 |
-                         LOG_TO_LOG2 |
-                         LDEXP_TO_ARITH |
-                         (have_dfrexp ? 0 : DFREXP_DLDEXP_TO_ARITH) |
-                         CARRY_TO_ARITH |
-                         BORROW_TO_ARITH |
-                         (have_dround ? 0 : DOPS_TO_DFRAC) |
-                         (options->EmitNoPow ? POW_TO_EXP2 : 0) |
-                         (!ctx->Const.NativeIntegers ? INT_DIV_TO_MUL_RCP : 0) |
-                         (options->EmitNoSat ? SAT_TO_CLAMP : 0));
-
-      do_vec_index_to_cond_assign(ir);
-      lower_vector_insert(ir, true);
-      lower_quadop_vector(ir, false);
-      lower_noise(ir);
-      if (options->MaxIfDepth == 0) {
-         lower_discard(ir);
-      }
-
-      do {
-         progress = false;
-
-         progress = do_lower_jumps(ir, true, true, options->EmitNoMainReturn, options->EmitNoCont, options->EmitNoLoops) || progress;
-
-         progress = do_common_optimization(ir, true, true, options,
-                                           ctx->Const.NativeIntegers)
-           || progress;
-
-         progress = lower_if_to_cond_assign(ir, options->MaxIfDepth) || progress;
-
-      } while (progress);
-
-      validate_ir_tree(ir);
+      job.shaders[n] = prog->_LinkedShaders[i];
+      job.have_dround[n] = pscreen->get_shader_param(pscreen, ptarget,
+                                                     PIPE_SHADER_CAP_TGSI_DROUND_SUPPORTED);
+      job.have_dfrexp[n] = pscreen->get_shader_param(pscreen, ptarget,
+                                                     PIPE_SHADER_CAP_TGSI_DFRACEXP_DLDEXP_SUPPORTED);
    }
 
+   _mesa_parallel_link_stages(ctx, st_lower_glsl_ir_stages, &job,
+                              job.num_shaders);
+
    for (unsigned i = 0; i < MESA_SHADER_STAGES; i++) {
       struct gl_program *linked_prog;
 
@@ -42,10 +42,12 @@
 #include "pipe/p_defines.h"
 #include "pipe/p_shader_tokens.h"
 #include "draw/draw_context.h"
+#include "hud/hud_counters.h"
 #include "tgsi/tgsi_dump.h"
 #include "tgsi/tgsi_emulate.h"
 #include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_ureg.h"
+#include "util/hash_table.h"
 
 #include "st_debug.h"
 #include "st_cb_bitmap.h"
@@ -499,6 +501,7 @@ st_create_vp_variant(struct st_context *st,
    }
 
    vpv->driver_shader = pipe->create_vs_state(pipe, &vpv->tgsi);
+   hud_counter_add(HUD_COUNTER_SHADER_COMPILES, 1);
    return vpv;
 }
 
@@ -511,22 +514,40 @@ st_get_vp_variant(struct st_context *st,
                   struct st_vertex_program *stvp,
                   const struct st_vp_variant_key *key)
 {
-   struct st_vp_variant *vpv;
+   const uint32_t hash = _mesa_hash_data(key, sizeof(*key));
+   struct st_vp_variant *vpv, **prev;
 
    /* Search for existing variant */
-   for (vpv = stvp->variants; vpv; vpv = vpv->next) {
-      if (memcmp(&vpv->key, key, sizeof(*key)) == 0) {
-         break;
+   for (prev = &stvp->variants; (vpv = *prev); prev = &vpv->next) {
+      if (vpv->key_hash == hash &&
+          memcmp(&vpv->key, key, sizeof(*key)) == 0) {
+         /* Keep the last used variant first, it's most likely the next one
+          * asked for.
+          */
+         if (prev != &stvp->variants) {
+            *prev = vpv->next;
+            vpv->next = stvp->variants;
+            stvp->variants = vpv;
+         }
+         return vpv;
       }
    }
 
-   if (!vpv) {
-      /* create now */
-      vpv = st_create_vp_variant(st, stvp, key);
-      if (vpv) {
-         /* insert into list */
-         vpv->next = stvp->variants;
-         stvp->variants = vpv;
+   /* create now */
+   vpv = st_create_vp_variant(st, stvp, key);
+   if (vpv) {
+      /* insert into list */
+      vpv->key_hash = hash;
+      vpv->next = stvp->variants;
+      stvp->variants = vpv;
+
+      if (ST_DEBUG & DEBUG_VARIANTS) {
+         unsigned count = 0;
+         for (; vpv; vpv = vpv->next)
+            count++;
+         debug_printf("st: vertex program %u now has %u variants\n",
+                      stvp->Base.Base.Id, count);
+         vpv = stvp->variants;
       }
    }
 
@@ -981,6 +1002,7 @@ st_create_fp_variant(struct st_context *st,
 
    /* fill in variant */
    variant->driver_shader = pipe->create_fs_state(pipe, &tgsi);
+   hud_counter_add(HUD_COUNTER_SHADER_COMPILES, 1);
    variant->key = *key;
 
    if (tgsi.tokens != stfp->tgsi.tokens)
@@ -996,22 +1018,40 @@ st_get_fp_variant(struct st_context *st,
                   struct st_fragment_program *stfp,
                   const struct st_fp_variant_key *key)
 {
-   struct st_fp_variant *fpv;
+   const uint32_t hash = _mesa_hash_data(key, sizeof(*key));
+   struct st_fp_variant *fpv, **prev;
 
    /* Search for existing variant */
-   for (fpv = stfp->variants; fpv; fpv = fpv->next) {
-      if (memcmp(&fpv->key, key, sizeof(*key)) == 0) {
-         break;
+   for (prev = &stfp->variants; (fpv = *prev); prev = &fpv->next) {
+      if (fpv->key_hash == hash &&
+          memcmp(&fpv->key, key, sizeof(*key)) == 0) {
+         /* Keep the last used variant first, it's most likely the next one
+          * asked for.
+          */
+         if (prev != &stfp->variants) {
+            *prev = fpv->next;
+            fpv->next = stfp->variants;
+            stfp->variants = fpv;
+         }
+         return fpv;
       }
    }
 
-   if (!fpv) {
-      /* create new */
-      fpv = st_create_fp_variant(st, stfp, key);
-      if (fpv) {
-         /* insert into list */
-         fpv->next = stfp->variants;
-         stfp->variants = fpv;
+   /* create new */
+   fpv = st_create_fp_variant(st, stfp, key);
+   if (fpv) {
+      /* insert into list */
+      fpv->key_hash = hash;
+      fpv->next = stfp->variants;
+      stfp->variants = fpv;
+
+      if (ST_DEBUG & DEBUG_VARIANTS) {
+         unsigned count = 0;
+         for (; fpv; fpv = fpv->next)
+            count++;
+         debug_printf("st: fragment program %u now has %u variants\n",
+                      stfp->Base.Base.Id, count);
+         fpv = stfp->variants;
       }
    }
 
@@ -1344,6 +1384,7 @@ st_create_gp_variant(struct st_context *st,
 
    /* fill in new variant */
    gpv->driver_shader = pipe->create_gs_state(pipe, &stgp->tgsi);
+   hud_counter_add(HUD_COUNTER_SHADER_COMPILES, 1);
    gpv->key = *key;
    return gpv;
 }
@@ -1419,6 +1460,7 @@ st_create_tcp_variant(struct st_context *st,
 
    /* fill in new variant */
    tcpv->driver_shader = pipe->create_tcs_state(pipe, &sttcp->tgsi);
+   hud_counter_add(HUD_COUNTER_SHADER_COMPILES, 1);
    tcpv->key = *key;
    return tcpv;
 }
@@ -1516,6 +1558,7 @@ st_create_tep_variant(struct st_context *st,
 
    /* fill in new variant */
    tepv->driver_shader = pipe->create_tes_state(pipe, &sttep->tgsi);
+   hud_counter_add(HUD_COUNTER_SHADER_COMPILES, 1);
    tepv->key = *key;
    return tepv;
 }
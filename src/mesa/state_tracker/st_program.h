@@ -87,6 +87,9 @@ struct st_fp_variant
    unsigned drawpix_sampler;
    unsigned pixelmap_sampler;
 
+   /** Hash of the key, checked before comparing keys */
+   uint32_t key_hash;
+
    /** next in linked list */
    struct st_fp_variant *next;
 };
@@ -140,6 +143,9 @@ struct st_vp_variant
    /** For using our private draw module (glRasterPos) */
    struct draw_vertex_shader *draw_shader;
 
+   /** Hash of the key, checked before comparing keys */
+   uint32_t key_hash;
+
    /** Next in linked list */
    struct st_vp_variant *next;  
 
@@ -463,6 +463,89 @@ st_texture_get_sampler_view(struct st_context *st,
 }
 
 
+static boolean
+sampler_view_matches(const struct pipe_sampler_view *sv,
+                     const struct pipe_resource *texture,
+                     const struct pipe_sampler_view *templ)
+{
+   if (sv->texture != texture ||
+       sv->format != templ->format ||
+       sv->target != templ->target ||
+       sv->swizzle_r != templ->swizzle_r ||
+       sv->swizzle_g != templ->swizzle_g ||
+       sv->swizzle_b != templ->swizzle_b ||
+       sv->swizzle_a != templ->swizzle_a)
+      return FALSE;
+
+   if (templ->target == PIPE_BUFFER)
+      return sv->u.buf.first_element == templ->u.buf.first_element &&
+             sv->u.buf.last_element == templ->u.buf.last_element;
+
+   return sv->u.tex.first_level == templ->u.tex.first_level &&
+          sv->u.tex.last_level == templ->u.tex.last_level &&
+          sv->u.tex.first_layer == templ->u.tex.first_layer &&
+          sv->u.tex.last_layer == templ->u.tex.last_layer;
+}
+
+
+/**
+ * Return the calling context's sampler view of the texture matching
+ * \p templ, creating it if needed.
+ *
+ * Up to ST_MAX_SAMPLER_VIEWS_PER_CONTEXT views are kept per context, so
+ * that a texture sampled with a few formats, swizzles or level ranges (sRGB
+ * decode on and off, different depth modes for different shaders, ...)
+ * doesn't need a new view each time it's bound.
+ */
+struct pipe_sampler_view *
+st_texture_get_sampler_view_for_template(struct st_context *st,
+                                         struct st_texture_object *stObj,
+                                         const struct pipe_sampler_view *templ)
+{
+   struct pipe_sampler_view **free = NULL, **replace = NULL;
+   unsigned count = 0;
+   GLuint i;
+
+   for (i = 0; i < stObj->num_sampler_views; ++i) {
+      struct pipe_sampler_view **sv = &stObj->sampler_views[i];
+
+      if (!*sv) {
+         if (!free)
+            free = sv;
+         continue;
+      }
+
+      if ((*sv)->context != st->pipe)
+         continue;
+
+      if (sampler_view_matches(*sv, stObj->pt, templ))
+         return *sv;
+
+      /* Views which don't belong to the texture anymore go first. */
+      if (!replace || (*sv)->texture != stObj->pt)
+         replace = sv;
+      count++;
+   }
+
+   if (replace && (count >= ST_MAX_SAMPLER_VIEWS_PER_CONTEXT ||
+                   (*replace)->texture != stObj->pt)) {
+      pipe_sampler_view_reference(replace, NULL);
+      free = replace;
+   }
+   else if (!free) {
+      GLuint old_size = stObj->num_sampler_views * sizeof(void *);
+      GLuint new_size = old_size + sizeof(void *);
+      stObj->sampler_views = REALLOC(stObj->sampler_views, old_size, new_size);
+      free = &stObj->sampler_views[stObj->num_sampler_views++];
+      *free = NULL;
+   }
+
+   *free = st->pipe->create_sampler_view(st->pipe, stObj->pt, templ);
+
+   return *free;
+}
+
+
 /**
  * For the given texture object, release any sampler views which belong
  * to the calling context.
@@ -476,10 +559,8 @@ st_texture_release_sampler_view(struct st_context *st,
    for (i = 0; i < stObj->num_sampler_views; ++i) {
       struct pipe_sampler_view **sv = &stObj->sampler_views[i];
 
-      if (*sv && (*sv)->context == st->pipe) {
+      if (*sv && (*sv)->context == st->pipe)
          pipe_sampler_view_reference(sv, NULL);
-         break;
-      }
    }
 }
 
@@ -68,6 +68,10 @@ struct st_texture_image
 };
 
 
+/** Number of sampler views a context keeps per texture object. */
+#define ST_MAX_SAMPLER_VIEWS_PER_CONTEXT 4
+
+
 /**
  * Subclass of gl_texure_object.
  */
@@ -93,8 +97,9 @@ struct st_texture_object
    /* Number of views in sampler_views array */
    GLuint num_sampler_views;
 
-   /* Array of sampler views (one per context) attached to this texture
-    * object. Created lazily on first binding in context.
+   /* Array of sampler views attached to this texture object, up to
+    * ST_MAX_SAMPLER_VIEWS_PER_CONTEXT per context. Created lazily on first
+    * binding in context.
     */
    struct pipe_sampler_view **sampler_views;
 
@@ -240,6 +245,11 @@ extern struct pipe_sampler_view **
 st_texture_get_sampler_view(struct st_context *st,
                             struct st_texture_object *stObj);
 
+extern struct pipe_sampler_view *
+st_texture_get_sampler_view_for_template(struct st_context *st,
+                                         struct st_texture_object *stObj,
+                                         const struct pipe_sampler_view *templ);
+
 extern void
 st_texture_release_sampler_view(struct st_context *st,
                                 struct st_texture_object *stObj);
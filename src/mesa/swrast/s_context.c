@@ -788,6 +788,14 @@ _swrast_CreateContext( struct gl_context *ctx )
 #endif
    }
 
+#ifdef _OPENMP
+   /* Queue for writing the spans of a triangle on several threads.  Not
+    * worth it (and not allocated) when there's only one thread.
+    */
+   if (maxThreads > 1)
+      swrast->SpanQueue = malloc(SWRAST_SPAN_QUEUE_SIZE * sizeof(SWspan));
+#endif
+
    /* init point span buffer */
    swrast->PointSpan.primitive = GL_POINT;
    swrast->PointSpan.end = 0;
@@ -827,6 +835,8 @@ _swrast_DestroyContext( struct gl_context *ctx )
 
    free( swrast->SpanArrays );
    free( swrast->ZoomedArrays );
+   free( swrast->SpanQueue );
+   free( swrast->FragProgSpanMachine );
    free( swrast->TexelBuffer );
 
    free(swrast->stencil_temp.buf1);
@@ -304,6 +304,14 @@ typedef struct
    SWspanarrays *SpanArrays;
    SWspanarrays *ZoomedArrays;  /**< For pixel zooming */
 
+   /**
+    * Spans of the current triangle waiting to be written by several
+    * threads at once.  Only allocated when OpenMP is enabled and more
+    * than one thread is available.  See s_triangle.c.
+    */
+   SWspan *SpanQueue;
+   GLuint SpanQueueCount;
+
    /**
     * Used to buffer N GL_POINTS, instead of rendering one by one.
     */
@@ -324,6 +332,11 @@ typedef struct
    /** State used during execution of fragment programs */
    struct gl_program_machine FragProgMachine;
 
+   /** Registers for running fragment programs on several fragments at
+    * once.  Allocated on first use.
+    */
+   struct gl_program_span_machine *FragProgSpanMachine;
+
    /** Temporary arrays for stencil operations.  To avoid large stack
     * allocations.
     */
@@ -423,6 +436,9 @@ _swrast_unmap_renderbuffers(struct gl_context *ctx);
  * Fixed point arithmetic macros
  */
 #ifndef FIXED_FRAC_BITS
+/** Max number of spans buffered in SWcontext::SpanQueue */
+#define SWRAST_SPAN_QUEUE_SIZE 64
+
 #define FIXED_FRAC_BITS 11
 #endif
 
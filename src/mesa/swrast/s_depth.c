@@ -34,6 +34,7 @@
 #include "s_context.h"
 #include "s_depth.h"
 #include "s_span.h"
+#include "s_span_simd.h"
 
 
 
@@ -71,6 +72,15 @@ depth_test_span16( struct gl_context *ctx, GLuint n,
 {
    const GLboolean write = ctx->Depth.Mask;
    GLuint passed = 0;
+   GLuint done;
+
+   /* the vector code does the common functions on most of the span */
+   done = _swrast_simd_depth_test16(ctx->Depth.Func, write, n,
+                                    zbuffer, zfrag, mask, &passed);
+   n -= done;
+   zbuffer += done;
+   zfrag += done;
+   mask += done;
 
    /* switch cases ordered from most frequent to less frequent */
    switch (ctx->Depth.Func) {
@@ -119,6 +129,15 @@ depth_test_span32( struct gl_context *ctx, GLuint n,
 {
    const GLboolean write = ctx->Depth.Mask;
    GLuint passed = 0;
+   GLuint done;
+
+   /* the vector code does the common functions on most of the span */
+   done = _swrast_simd_depth_test32(ctx->Depth.Func, write, n,
+                                    zbuffer, zfrag, mask, &passed);
+   n -= done;
+   zbuffer += done;
+   zfrag += done;
+   mask += done;
 
    /* switch cases ordered from most frequent to less frequent */
    switch (ctx->Depth.Func) {
@@ -149,18 +149,16 @@ fetch_texel_deriv( struct gl_context *ctx, const GLfloat texcoord[4],
 
 
 /**
- * Initialize the virtual fragment program machine state prior to running
- * fragment program on a fragment.  This involves initializing the input
- * registers, condition codes, etc.
- * \param machine  the virtual machine state to init
+ * Adjust the input attributes of a fragment for the fragment program:
+ * window position conventions and front/back facing value.
  * \param program  the fragment program we're about to run
  * \param span  the span of pixels we'll operate on
  * \param col  which element (column) of the span we'll operate on
  */
 static void
-init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
-             const struct gl_fragment_program *program,
-             const SWspan *span, GLuint col)
+init_fragment(struct gl_context *ctx,
+              const struct gl_fragment_program *program,
+              const SWspan *span, GLuint col)
 {
    GLfloat *wpos = span->array->attribs[VARYING_SLOT_POS][col];
 
@@ -172,6 +170,28 @@ init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
       wpos[1] += 0.5F;
    }
 
+   /* if running a GLSL program (not ARB_fragment_program) */
+   if (ctx->_Shader->CurrentProgram[MESA_SHADER_FRAGMENT]) {
+      /* Store front/back facing value */
+      span->array->attribs[VARYING_SLOT_FACE][col][0] = 1.0F - span->facing;
+   }
+}
+
+
+/**
+ * Initialize the virtual fragment program machine state prior to running
+ * fragment program on a fragment.  This involves initializing the input
+ * registers, condition codes, etc.
+ * \param machine  the virtual machine state to init
+ * \param program  the fragment program we're about to run
+ * \param span  the span of pixels we'll operate on
+ * \param col  which element (column) of the span we'll operate on
+ */
+static void
+init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
+             const struct gl_fragment_program *program,
+             const SWspan *span, GLuint col)
+{
    /* Setup pointer to input attributes */
    machine->Attribs = span->array->attribs;
 
@@ -181,12 +201,6 @@ init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
 
    machine->Samplers = program->Base.SamplerUnits;
 
-   /* if running a GLSL program (not ARB_fragment_program) */
-   if (ctx->_Shader->CurrentProgram[MESA_SHADER_FRAGMENT]) {
-      /* Store front/back facing value */
-      machine->Attribs[VARYING_SLOT_FACE][col][0] = 1.0F - span->facing;
-   }
-
    machine->CurElement = col;
 
    /* init condition codes */
@@ -203,6 +217,106 @@ init_machine(struct gl_context *ctx, struct gl_program_machine *machine,
 }
 
 
+/**
+ * Store the results of the fragment program for fragment 'i' of the span.
+ * \param outputs  the output registers
+ */
+static void
+store_outputs(struct gl_context *ctx, SWspan *span, GLuint i,
+              GLbitfield64 outputsWritten, const GLfloat (*outputs)[4])
+{
+   /* Store result color */
+   if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_COLOR)) {
+      COPY_4V(span->array->attribs[VARYING_SLOT_COL0][i],
+              outputs[FRAG_RESULT_COLOR]);
+   }
+   else {
+      /* Multiple drawbuffers / render targets
+       * Note that colors beyond 0 and 1 will overwrite other
+       * attributes, such as FOGC, TEX0, TEX1, etc.  That's OK.
+       */
+      GLuint buf;
+      for (buf = 0; buf < ctx->DrawBuffer->_NumColorDrawBuffers; buf++) {
+         if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DATA0 + buf)) {
+            COPY_4V(span->array->attribs[VARYING_SLOT_COL0 + buf][i],
+                    outputs[FRAG_RESULT_DATA0 + buf]);
+         }
+      }
+   }
+
+   /* Store result depth/z */
+   if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DEPTH)) {
+      const GLfloat depth = outputs[FRAG_RESULT_DEPTH][2];
+      if (depth <= 0.0F)
+         span->array->z[i] = 0;
+      else if (depth >= 1.0F)
+         span->array->z[i] = ctx->DrawBuffer->_DepthMax;
+      else
+         span->array->z[i] =
+            (GLuint) (depth * ctx->DrawBuffer->_DepthMaxF + 0.5F);
+   }
+}
+
+
+/**
+ * Run fragment program on the pixels in span from 'start' to 'end' - 1,
+ * PROG_SPAN_WIDTH pixels at a time.
+ */
+static void
+run_program_span(struct gl_context *ctx, SWspan *span,
+                 GLuint start, GLuint end)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const struct gl_fragment_program *program = ctx->FragmentProgram._Current;
+   const GLbitfield64 outputsWritten = program->Base.OutputsWritten;
+   struct gl_program_machine *machine = &swrast->FragProgMachine;
+   struct gl_program_span_machine *regs = swrast->FragProgSpanMachine;
+   GLubyte *mask = span->array->mask;
+   GLuint i, k;
+
+   for (i = start; i < end; i += PROG_SPAN_WIDTH) {
+      const GLuint count = MIN2(end - i, PROG_SPAN_WIDTH);
+      GLboolean any = GL_FALSE;
+
+      for (k = 0; k < count; k++) {
+         if (mask[i + k]) {
+            init_fragment(ctx, program, span, i + k);
+            any = GL_TRUE;
+         }
+      }
+      if (!any)
+         continue;
+
+      init_machine(ctx, machine, program, span, i);
+      _mesa_execute_program_span(ctx, &program->Base, machine, regs,
+                                 count, mask + i);
+
+      for (k = 0; k < count; k++) {
+         if (mask[i + k]) {
+            GLfloat outputs[FRAG_RESULT_MAX][4];
+            GLbitfield64 written = outputsWritten;
+
+            while (written) {
+               const GLuint out = u_bit_scan64(&written);
+               if (out < FRAG_RESULT_MAX) {
+                  outputs[out][0] = regs->Outputs[out][0][k];
+                  outputs[out][1] = regs->Outputs[out][1][k];
+                  outputs[out][2] = regs->Outputs[out][2][k];
+                  outputs[out][3] = regs->Outputs[out][3][k];
+               }
+            }
+            store_outputs(ctx, span, i + k, outputsWritten,
+                          (const GLfloat (*)[4]) outputs);
+         }
+         else {
+            /* killed fragment */
+            span->writeAll = GL_FALSE;
+         }
+      }
+   }
+}
+
+
 /**
  * Run fragment program on the pixels in span from 'start' to 'end' - 1.
  */
@@ -215,42 +329,24 @@ run_program(struct gl_context *ctx, SWspan *span, GLuint start, GLuint end)
    struct gl_program_machine *machine = &swrast->FragProgMachine;
    GLuint i;
 
+   if (_mesa_can_execute_program_span(&program->Base)) {
+      if (!swrast->FragProgSpanMachine)
+         swrast->FragProgSpanMachine =
+            calloc(1, sizeof(struct gl_program_span_machine));
+      if (swrast->FragProgSpanMachine) {
+         run_program_span(ctx, span, start, end);
+         return;
+      }
+   }
+
    for (i = start; i < end; i++) {
       if (span->array->mask[i]) {
+         init_fragment(ctx, program, span, i);
          init_machine(ctx, machine, program, span, i);
 
          if (_mesa_execute_program(ctx, &program->Base, machine)) {
-
-            /* Store result color */
-	    if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_COLOR)) {
-               COPY_4V(span->array->attribs[VARYING_SLOT_COL0][i],
-                       machine->Outputs[FRAG_RESULT_COLOR]);
-            }
-            else {
-               /* Multiple drawbuffers / render targets
-                * Note that colors beyond 0 and 1 will overwrite other
-                * attributes, such as FOGC, TEX0, TEX1, etc.  That's OK.
-                */
-               GLuint buf;
-               for (buf = 0; buf < ctx->DrawBuffer->_NumColorDrawBuffers; buf++) {
-                  if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DATA0 + buf)) {
-                     COPY_4V(span->array->attribs[VARYING_SLOT_COL0 + buf][i],
-                             machine->Outputs[FRAG_RESULT_DATA0 + buf]);
-                  }
-               }
-            }
-
-            /* Store result depth/z */
-            if (outputsWritten & BITFIELD64_BIT(FRAG_RESULT_DEPTH)) {
-               const GLfloat depth = machine->Outputs[FRAG_RESULT_DEPTH][2];
-               if (depth <= 0.0F)
-                  span->array->z[i] = 0;
-               else if (depth >= 1.0F)
-                  span->array->z[i] = ctx->DrawBuffer->_DepthMax;
-               else
-                  span->array->z[i] =
-                     (GLuint) (depth * ctx->DrawBuffer->_DepthMaxF + 0.5F);
-            }
+            store_outputs(ctx, span, i, outputsWritten,
+                          (const GLfloat (*)[4]) machine->Outputs);
          }
          else {
             /* killed fragment */
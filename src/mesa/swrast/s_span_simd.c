@@ -0,0 +1,519 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file s_span_simd.c
+ *
+ * SSE2 and AVX2 kernels for blending, depth and stencil testing of spans.
+ * See s_span_simd.h.
+ *
+ * The code is written once against a handful of vector macros.  The AVX2
+ * versions of the unpack and pack instructions work within 128-bit lanes,
+ * which doesn't matter as long as every unpack is undone by the matching
+ * pack, as is the case here.
+ *
+ * All of the kernels give the same results as the C code they replace,
+ * bit for bit.
+ */
+
+#include <string.h>
+
+#include "main/imports.h"
+#include "s_span_simd.h"
+
+#if defined(SPAN_SIMD_AVX2)
+#define FUNC(name) name##_avx2
+#else
+#define FUNC(name) name##_sse2
+#endif
+
+#ifdef __SSE2__
+
+#include <emmintrin.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#ifdef __AVX2__
+
+typedef __m256i vec;
+
+#define VEC_BYTES 32
+#define vec_load(p)           _mm256_loadu_si256((const __m256i *) (p))
+#define vec_store(p, v)       _mm256_storeu_si256((__m256i *) (p), v)
+#define vec_zero()            _mm256_setzero_si256()
+#define vec_set1_8(x)         _mm256_set1_epi8(x)
+#define vec_set1_32(x)        _mm256_set1_epi32(x)
+#define vec_and(a, b)         _mm256_and_si256(a, b)
+#define vec_andnot(a, b)      _mm256_andnot_si256(a, b)
+#define vec_or(a, b)          _mm256_or_si256(a, b)
+#define vec_xor(a, b)         _mm256_xor_si256(a, b)
+#define vec_add8(a, b)        _mm256_add_epi8(a, b)
+#define vec_sub8(a, b)        _mm256_sub_epi8(a, b)
+#define vec_adds_u8(a, b)     _mm256_adds_epu8(a, b)
+#define vec_subs_u8(a, b)     _mm256_subs_epu8(a, b)
+#define vec_min_u8(a, b)      _mm256_min_epu8(a, b)
+#define vec_max_u8(a, b)      _mm256_max_epu8(a, b)
+#define vec_cmpeq8(a, b)      _mm256_cmpeq_epi8(a, b)
+#define vec_sub16(a, b)       _mm256_sub_epi16(a, b)
+#define vec_madd16(a, b)      _mm256_madd_epi16(a, b)
+#define vec_add32(a, b)       _mm256_add_epi32(a, b)
+#define vec_cmpeq32(a, b)     _mm256_cmpeq_epi32(a, b)
+#define vec_cmpgt32(a, b)     _mm256_cmpgt_epi32(a, b)
+#define vec_slli32(a, n)      _mm256_slli_epi32(a, n)
+#define vec_srai32(a, n)      _mm256_srai_epi32(a, n)
+#define vec_unpacklo8(a, b)   _mm256_unpacklo_epi8(a, b)
+#define vec_unpackhi8(a, b)   _mm256_unpackhi_epi8(a, b)
+#define vec_unpacklo16(a, b)  _mm256_unpacklo_epi16(a, b)
+#define vec_unpackhi16(a, b)  _mm256_unpackhi_epi16(a, b)
+#define vec_packs32(a, b)     _mm256_packs_epi32(a, b)
+#define vec_packus16(a, b)    _mm256_packus_epi16(a, b)
+#define vec_splat_alpha(a)                                               \
+   _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(a, _MM_SHUFFLE(3, 3, 3, 3)), \
+                          _MM_SHUFFLE(3, 3, 3, 3))
+#define vec_movemask32(a)     _mm256_movemask_ps(_mm256_castsi256_ps(a))
+
+/** Zero-extends 8 bytes to 32 bits. */
+static inline vec
+load_u8_as_u32(const GLubyte *p)
+{
+   return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) p));
+}
+
+/** Stores 8 values in [0, 255] as bytes. */
+static inline void
+store_u32_as_u8(GLubyte *p, vec v)
+{
+   const vec b = _mm256_packus_epi16(_mm256_packs_epi32(v, v), vec_zero());
+   const GLuint lo = _mm_cvtsi128_si32(_mm256_castsi256_si128(b));
+   const GLuint hi = _mm_cvtsi128_si32(_mm256_extracti128_si256(b, 1));
+
+   memcpy(p, &lo, 4);
+   memcpy(p + 4, &hi, 4);
+}
+
+/** Zero-extends 8 16-bit values to 32 bits. */
+static inline vec
+load_u16_as_u32(const GLushort *p)
+{
+   return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) p));
+}
+
+/** Stores 8 values in [0, 0xffff] as 16 bits. */
+static inline void
+store_u32_as_u16(GLushort *p, vec v)
+{
+   const vec w = _mm256_permute4x64_epi64(_mm256_packus_epi32(v, v),
+                                          _MM_SHUFFLE(3, 1, 2, 0));
+
+   _mm_storeu_si128((__m128i *) p, _mm256_castsi256_si128(w));
+}
+
+#else /* __AVX2__ */
+
+typedef __m128i vec;
+
+#define VEC_BYTES 16
+#define vec_load(p)           _mm_loadu_si128((const __m128i *) (p))
+#define vec_store(p, v)       _mm_storeu_si128((__m128i *) (p), v)
+#define vec_zero()            _mm_setzero_si128()
+#define vec_set1_8(x)         _mm_set1_epi8(x)
+#define vec_set1_32(x)        _mm_set1_epi32(x)
+#define vec_and(a, b)         _mm_and_si128(a, b)
+#define vec_andnot(a, b)      _mm_andnot_si128(a, b)
+#define vec_or(a, b)          _mm_or_si128(a, b)
+#define vec_xor(a, b)         _mm_xor_si128(a, b)
+#define vec_add8(a, b)        _mm_add_epi8(a, b)
+#define vec_sub8(a, b)        _mm_sub_epi8(a, b)
+#define vec_adds_u8(a, b)     _mm_adds_epu8(a, b)
+#define vec_subs_u8(a, b)     _mm_subs_epu8(a, b)
+#define vec_min_u8(a, b)      _mm_min_epu8(a, b)
+#define vec_max_u8(a, b)      _mm_max_epu8(a, b)
+#define vec_cmpeq8(a, b)      _mm_cmpeq_epi8(a, b)
+#define vec_sub16(a, b)       _mm_sub_epi16(a, b)
+#define vec_madd16(a, b)      _mm_madd_epi16(a, b)
+#define vec_add32(a, b)       _mm_add_epi32(a, b)
+#define vec_cmpeq32(a, b)     _mm_cmpeq_epi32(a, b)
+#define vec_cmpgt32(a, b)     _mm_cmpgt_epi32(a, b)
+#define vec_slli32(a, n)      _mm_slli_epi32(a, n)
+#define vec_srai32(a, n)      _mm_srai_epi32(a, n)
+#define vec_unpacklo8(a, b)   _mm_unpacklo_epi8(a, b)
+#define vec_unpackhi8(a, b)   _mm_unpackhi_epi8(a, b)
+#define vec_unpacklo16(a, b)  _mm_unpacklo_epi16(a, b)
+#define vec_unpackhi16(a, b)  _mm_unpackhi_epi16(a, b)
+#define vec_packs32(a, b)     _mm_packs_epi32(a, b)
+#define vec_packus16(a, b)    _mm_packus_epi16(a, b)
+#define vec_splat_alpha(a)                                               \
+   _mm_shufflehi_epi16(_mm_shufflelo_epi16(a, _MM_SHUFFLE(3, 3, 3, 3)),  \
+                       _MM_SHUFFLE(3, 3, 3, 3))
+#define vec_movemask32(a)     _mm_movemask_ps(_mm_castsi128_ps(a))
+
+/** Zero-extends 4 bytes to 32 bits. */
+static inline vec
+load_u8_as_u32(const GLubyte *p)
+{
+   GLuint bytes;
+   vec v;
+
+   memcpy(&bytes, p, 4);
+   v = _mm_cvtsi32_si128(bytes);
+   v = _mm_unpacklo_epi8(v, vec_zero());
+   return _mm_unpacklo_epi16(v, vec_zero());
+}
+
+/** Stores 4 values in [0, 255] as bytes. */
+static inline void
+store_u32_as_u8(GLubyte *p, vec v)
+{
+   const GLuint bytes =
+      _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packs_epi32(v, v), vec_zero()));
+
+   memcpy(p, &bytes, 4);
+}
+
+/** Zero-extends 4 16-bit values to 32 bits. */
+static inline vec
+load_u16_as_u32(const GLushort *p)
+{
+   return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *) p),
+                             vec_zero());
+}
+
+/** Stores 4 values in [0, 0xffff] as 16 bits.  SSE2 only has a signed
+ * saturating pack, so sign-extend the low halves first.
+ */
+static inline void
+store_u32_as_u16(GLushort *p, vec v)
+{
+   v = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+   _mm_storel_epi64((__m128i *) p, _mm_packs_epi32(v, v));
+}
+
+#endif /* __AVX2__ */
+
+/** Number of 32-bit values in a vector */
+#define VEC_PIXELS (VEC_BYTES / 4)
+
+
+static inline vec
+select_vec(vec mask, vec a, vec b)
+{
+   return vec_or(vec_and(mask, a), vec_andnot(mask, b));
+}
+
+static inline vec
+not_vec(vec a)
+{
+   return vec_xor(a, vec_set1_32(-1));
+}
+
+/** Unsigned 32-bit a < b */
+static inline vec
+cmplt_u32(vec a, vec b)
+{
+   const vec bias = vec_set1_32(INT32_MIN);
+   return vec_cmpgt32(vec_xor(b, bias), vec_xor(a, bias));
+}
+
+/** DIV255() of s_blend.c on 32-bit values */
+static inline vec
+div255(vec x)
+{
+   return vec_srai32(vec_add32(vec_add32(vec_slli32(x, 8), x),
+                               vec_set1_32(256)), 16);
+}
+
+
+/**
+ * blend_transparency_ubyte() on 16-bit channels:
+ * DIV255((src - dst) * src.a) + dst
+ */
+static inline vec
+transparency16(vec src, vec dst)
+{
+   const vec zero = vec_zero();
+   const vec alpha = vec_splat_alpha(src);
+   const vec diff = vec_sub16(src, dst);
+   /* (diff, 0) . (alpha, 0) gives the exact signed products */
+   const vec lo = vec_madd16(vec_unpacklo16(diff, zero),
+                             vec_unpacklo16(alpha, zero));
+   const vec hi = vec_madd16(vec_unpackhi16(diff, zero),
+                             vec_unpackhi16(alpha, zero));
+
+   return vec_packs32(vec_add32(div255(lo), vec_unpacklo16(dst, zero)),
+                      vec_add32(div255(hi), vec_unpackhi16(dst, zero)));
+}
+
+/** blend_modulate() on 16-bit channels: DIV255(src * dst) */
+static inline vec
+modulate16(vec src, vec dst)
+{
+   const vec zero = vec_zero();
+   const vec lo = vec_madd16(vec_unpacklo16(src, zero),
+                             vec_unpacklo16(dst, zero));
+   const vec hi = vec_madd16(vec_unpackhi16(src, zero),
+                             vec_unpackhi16(dst, zero));
+
+   return vec_packs32(div255(lo), div255(hi));
+}
+
+
+/**
+ * Blends whole vectors of RGBA8 pixels.  BLEND_LOOP() computes the result
+ * from the bytes of 'src' and 'dst' directly, BLEND_LOOP16() with 'EXPR16'
+ * applied to their channels widened to 16 bits.
+ */
+#define BLEND_LOOP(EXPR8)                                        \
+   for (; i + VEC_PIXELS <= n; i += VEC_PIXELS) {                \
+      const vec src = vec_load(rgba[i]);                         \
+      const vec dst = vec_load(dest[i]);                         \
+      const vec dead = vec_cmpeq32(load_u8_as_u32(mask + i), zero); \
+      vec_store(rgba[i], select_vec(dead, src, EXPR8));          \
+   }
+
+#define BLEND_LOOP16(EXPR16)                                             \
+   BLEND_LOOP(vec_packus16(EXPR16(vec_unpacklo8(src, zero),              \
+                                  vec_unpacklo8(dst, zero)),             \
+                           EXPR16(vec_unpackhi8(src, zero),              \
+                                  vec_unpackhi8(dst, zero))))
+
+GLuint
+FUNC(_swrast_simd_blend_ubyte)(enum swrast_simd_blend op, GLuint n,
+                               const GLubyte mask[], GLubyte rgba[][4],
+                               const GLubyte dest[][4])
+{
+   const vec zero = vec_zero();
+   GLuint i = 0;
+
+   switch (op) {
+   case SWRAST_SIMD_BLEND_TRANSPARENCY:
+      BLEND_LOOP16(transparency16);
+      break;
+   case SWRAST_SIMD_BLEND_ADD:
+      BLEND_LOOP(vec_adds_u8(src, dst));
+      break;
+   case SWRAST_SIMD_BLEND_MIN:
+      BLEND_LOOP(vec_min_u8(src, dst));
+      break;
+   case SWRAST_SIMD_BLEND_MAX:
+      BLEND_LOOP(vec_max_u8(src, dst));
+      break;
+   case SWRAST_SIMD_BLEND_MODULATE:
+      BLEND_LOOP16(modulate16);
+      break;
+   }
+
+   return i;
+}
+
+
+/**
+ * The depth test for GL_LESS or GL_LEQUAL, 'LOAD' and 'STORE' giving the
+ * Z buffer layout.
+ */
+#define DEPTH_TEST_LOOP(LOAD, STORE)                                     \
+   for (; i + VEC_PIXELS <= n; i += VEC_PIXELS) {                        \
+      const vec m = load_u8_as_u32(mask + i);                            \
+      const vec zb = LOAD(zbuffer + i);                                  \
+      const vec zf = vec_load(zfrag + i);                                \
+      vec pass = less ? cmplt_u32(zf, zb) : not_vec(cmplt_u32(zb, zf));  \
+                                                                         \
+      pass = vec_andnot(vec_cmpeq32(m, vec_zero()), pass);               \
+      if (write)                                                         \
+         STORE(zbuffer + i, select_vec(pass, zf, zb));                   \
+      store_u32_as_u8(mask + i, vec_and(m, pass));                       \
+      count += _mesa_bitcount(vec_movemask32(pass));                     \
+   }
+
+GLuint
+FUNC(_swrast_simd_depth_test16)(GLenum func, GLboolean write, GLuint n,
+                                GLushort zbuffer[], const GLuint zfrag[],
+                                GLubyte mask[], GLuint *passed)
+{
+   const GLboolean less = func == GL_LESS;
+   GLuint i = 0, count = 0;
+
+   assert(func == GL_LESS || func == GL_LEQUAL);
+
+   DEPTH_TEST_LOOP(load_u16_as_u32, store_u32_as_u16);
+
+   *passed += count;
+   return i;
+}
+
+GLuint
+FUNC(_swrast_simd_depth_test32)(GLenum func, GLboolean write, GLuint n,
+                                GLuint zbuffer[], const GLuint zfrag[],
+                                GLubyte mask[], GLuint *passed)
+{
+   const GLboolean less = func == GL_LESS;
+   GLuint i = 0, count = 0;
+
+   assert(func == GL_LESS || func == GL_LEQUAL);
+
+   DEPTH_TEST_LOOP(vec_load, vec_store);
+
+   *passed += count;
+   return i;
+}
+
+
+/*
+ * The stencil values are handled as bytes.  With a stride of 4 only the
+ * lowest byte of each 32-bit lane is a stencil value; the other three
+ * belong to the depth value or to the next pixel, go through the same
+ * computations and are put back unchanged.  Since the last vector may then
+ * touch up to three bytes past the last stencil value, it's always left
+ * to the caller.
+ */
+
+/** Number of stencil values done by one vector */
+static inline GLuint
+stencil_vec_count(GLint stride)
+{
+   return stride == 1 ? VEC_BYTES : VEC_PIXELS;
+}
+
+/** Does a vector of stencil values starting at 'i' fit in the span? */
+static inline GLboolean
+stencil_vec_fits(GLint stride, GLuint i, GLuint n)
+{
+   return stride == 1 ? i + VEC_BYTES <= n : i + VEC_PIXELS < n;
+}
+
+/** 0xff in the bytes of the fragments whose mask[] is set */
+static inline vec
+stencil_live(GLint stride, const GLubyte mask[])
+{
+   if (stride == 1)
+      return not_vec(vec_cmpeq8(vec_load(mask), vec_zero()));
+   else
+      return not_vec(vec_cmpeq32(load_u8_as_u32(mask), vec_zero()));
+}
+
+/** Unsigned byte comparison 'ref FUNC s', as done by do_stencil_test() */
+static inline vec
+stencil_compare(GLenum func, vec ref, vec s)
+{
+   switch (func) {
+   case GL_LESS:
+      return not_vec(vec_cmpeq8(vec_max_u8(ref, s), ref));
+   case GL_LEQUAL:
+      return vec_cmpeq8(vec_min_u8(ref, s), ref);
+   case GL_GREATER:
+      return not_vec(vec_cmpeq8(vec_min_u8(ref, s), ref));
+   case GL_GEQUAL:
+      return vec_cmpeq8(vec_max_u8(ref, s), ref);
+   case GL_EQUAL:
+      return vec_cmpeq8(ref, s);
+   case GL_NOTEQUAL:
+      return not_vec(vec_cmpeq8(ref, s));
+   case GL_ALWAYS:
+      return vec_set1_32(-1);
+   default:
+      return vec_zero();
+   }
+}
+
+GLuint
+FUNC(_swrast_simd_stencil_test)(GLenum func, GLuint n, GLubyte stencil[],
+                                GLint stride, GLubyte ref, GLubyte valueMask,
+                                GLubyte mask[], GLubyte fail[])
+{
+   const GLuint step = stencil_vec_count(stride);
+   const vec refv = vec_set1_8(ref);
+   const vec valueMaskv = vec_set1_8(valueMask);
+   const vec one = stride == 1 ? vec_set1_8(1) : vec_set1_32(1);
+   GLuint i;
+
+   for (i = 0; stencil_vec_fits(stride, i, n); i += step) {
+      const vec s = vec_and(vec_load(stencil + i * stride), valueMaskv);
+      const vec live = stencil_live(stride, mask + i);
+      vec pass = stencil_compare(func, refv, s);
+
+      if (stride == 1) {
+         vec_store(fail + i, vec_and(vec_andnot(pass, live), one));
+         vec_store(mask + i, vec_and(vec_load(mask + i), pass));
+      }
+      else {
+         /* spread the result for the stencil byte over the whole lane */
+         pass = vec_srai32(vec_slli32(pass, 24), 24);
+         store_u32_as_u8(fail + i, vec_and(vec_andnot(pass, live), one));
+         store_u32_as_u8(mask + i,
+                         vec_and(load_u8_as_u32(mask + i), pass));
+      }
+   }
+
+   return i;
+}
+
+GLuint
+FUNC(_swrast_simd_stencil_op)(GLenum oper, GLuint n, GLubyte stencil[],
+                              GLint stride, GLubyte ref, GLubyte wrtmask,
+                              const GLubyte mask[])
+{
+   const GLuint step = stencil_vec_count(stride);
+   /* the bytes to update: the stencil values selected by wrtmask */
+   const vec writable = stride == 1 ? vec_set1_8(wrtmask)
+                                    : vec_set1_32(wrtmask);
+   const vec one = vec_set1_8(1);
+   GLuint i;
+
+   for (i = 0; stencil_vec_fits(stride, i, n); i += step) {
+      GLubyte *p = stencil + i * stride;
+      const vec s = vec_load(p);
+      vec val;
+
+      switch (oper) {
+      case GL_ZERO:
+         val = vec_zero();
+         break;
+      case GL_REPLACE:
+         val = vec_set1_8(ref);
+         break;
+      case GL_INCR:
+         val = vec_adds_u8(s, one);
+         break;
+      case GL_DECR:
+         val = vec_subs_u8(s, one);
+         break;
+      case GL_INCR_WRAP_EXT:
+         val = vec_add8(s, one);
+         break;
+      case GL_DECR_WRAP_EXT:
+         val = vec_sub8(s, one);
+         break;
+      case GL_INVERT:
+         val = not_vec(s);
+         break;
+      default:
+         return i;
+      }
+
+      vec_store(p, select_vec(vec_and(stencil_live(stride, mask + i),
+                                      writable), val, s));
+   }
+
+   return i;
+}
+
+#endif /* __SSE2__ */
@@ -0,0 +1,172 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file s_span_simd.h
+ *
+ * SIMD versions of the most common span operations: 8-bit blending, the
+ * LESS/LEQUAL depth tests and the stencil test and operators.
+ *
+ * s_span_simd.c is built once as is, which gives the SSE2 kernels, and once
+ * with AVX2 enabled when the compiler supports it.  The kernels only handle
+ * whole vectors of pixels and return how many they did; the caller finishes
+ * the span with the regular C code.
+ */
+
+#ifndef S_SPAN_SIMD_H
+#define S_SPAN_SIMD_H
+
+#include "main/glheader.h"
+#include "main/cpuinfo.h"
+
+
+enum swrast_simd_blend {
+   SWRAST_SIMD_BLEND_TRANSPARENCY, /**< GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA */
+   SWRAST_SIMD_BLEND_ADD,          /**< GL_ONE, GL_ONE */
+   SWRAST_SIMD_BLEND_MIN,          /**< GL_MIN */
+   SWRAST_SIMD_BLEND_MAX,          /**< GL_MAX */
+   SWRAST_SIMD_BLEND_MODULATE,     /**< src * dest */
+};
+
+
+#define SWRAST_SIMD_KERNELS(ISA)                                         \
+GLuint                                                                   \
+_swrast_simd_blend_ubyte_##ISA(enum swrast_simd_blend op, GLuint n,      \
+                               const GLubyte mask[], GLubyte rgba[][4],  \
+                               const GLubyte dest[][4]);                 \
+GLuint                                                                   \
+_swrast_simd_depth_test16_##ISA(GLenum func, GLboolean write, GLuint n,  \
+                                GLushort zbuffer[], const GLuint zfrag[],\
+                                GLubyte mask[], GLuint *passed);         \
+GLuint                                                                   \
+_swrast_simd_depth_test32_##ISA(GLenum func, GLboolean write, GLuint n,  \
+                                GLuint zbuffer[], const GLuint zfrag[],  \
+                                GLubyte mask[], GLuint *passed);         \
+GLuint                                                                   \
+_swrast_simd_stencil_test_##ISA(GLenum func, GLuint n, GLubyte stencil[],\
+                                GLint stride, GLubyte ref,               \
+                                GLubyte valueMask, GLubyte mask[],       \
+                                GLubyte fail[]);                         \
+GLuint                                                                   \
+_swrast_simd_stencil_op_##ISA(GLenum oper, GLuint n, GLubyte stencil[],  \
+                              GLint stride, GLubyte ref, GLubyte wrtmask,\
+                              const GLubyte mask[]);
+
+SWRAST_SIMD_KERNELS(sse2)
+SWRAST_SIMD_KERNELS(avx2)
+
+
+/*
+ * Pick the best kernel for the CPU.  When there's none, nothing is done
+ * and 0 is returned.
+ */
+#if defined(USE_AVX2)
+#define SWRAST_SIMD_CALL(name, ...)                      \
+   (cpu_has_avx2 ? name##_avx2(__VA_ARGS__) : name##_sse2(__VA_ARGS__))
+#elif defined(__SSE2__)
+#define SWRAST_SIMD_CALL(name, ...)   name##_sse2(__VA_ARGS__)
+#else
+#define SWRAST_SIMD_CALL(name, ...)   0
+#endif
+
+
+/**
+ * Blend the first pixels of a GL_UNSIGNED_BYTE span, exactly like the
+ * blend_*() functions of s_blend.c.
+ * \return  number of pixels done
+ */
+static inline GLuint
+_swrast_simd_blend_ubyte(enum swrast_simd_blend op, GLuint n,
+                         const GLubyte mask[], GLubyte rgba[][4],
+                         const GLubyte dest[][4])
+{
+   return SWRAST_SIMD_CALL(_swrast_simd_blend_ubyte, op, n, mask, rgba, dest);
+}
+
+
+/**
+ * Depth test the first fragments of a span against a 16-bit Z buffer.
+ * Only GL_LESS and GL_LEQUAL are handled.
+ * \param passed  incremented by the number of fragments which pass
+ * \return  number of fragments done
+ */
+static inline GLuint
+_swrast_simd_depth_test16(GLenum func, GLboolean write, GLuint n,
+                          GLushort zbuffer[], const GLuint zfrag[],
+                          GLubyte mask[], GLuint *passed)
+{
+   if (func != GL_LESS && func != GL_LEQUAL)
+      return 0;
+   return SWRAST_SIMD_CALL(_swrast_simd_depth_test16, func, write, n,
+                           zbuffer, zfrag, mask, passed);
+}
+
+
+/**
+ * Like _swrast_simd_depth_test16(), for 32-bit Z values.
+ */
+static inline GLuint
+_swrast_simd_depth_test32(GLenum func, GLboolean write, GLuint n,
+                          GLuint zbuffer[], const GLuint zfrag[],
+                          GLubyte mask[], GLuint *passed)
+{
+   if (func != GL_LESS && func != GL_LEQUAL)
+      return 0;
+   return SWRAST_SIMD_CALL(_swrast_simd_depth_test32, func, write, n,
+                           zbuffer, zfrag, mask, passed);
+}
+
+
+/**
+ * Stencil test the first fragments of a span.  The stencil values are
+ * either packed (stride 1) or the first byte of 4-byte pixels (stride 4).
+ * \return  number of fragments done
+ */
+static inline GLuint
+_swrast_simd_stencil_test(GLenum func, GLuint n, GLubyte stencil[],
+                          GLint stride, GLubyte ref, GLubyte valueMask,
+                          GLubyte mask[], GLubyte fail[])
+{
+   if (stride != 1 && stride != 4)
+      return 0;
+   return SWRAST_SIMD_CALL(_swrast_simd_stencil_test, func, n, stencil,
+                           stride, ref, valueMask, mask, fail);
+}
+
+
+/**
+ * Apply a stencil operator to the first values of a span, with the same
+ * layouts as _swrast_simd_stencil_test().
+ * \return  number of values done
+ */
+static inline GLuint
+_swrast_simd_stencil_op(GLenum oper, GLuint n, GLubyte stencil[],
+                        GLint stride, GLubyte ref, GLubyte wrtmask,
+                        const GLubyte mask[])
+{
+   if (stride != 1 && stride != 4)
+      return 0;
+   return SWRAST_SIMD_CALL(_swrast_simd_stencil_op, oper, n, stencil,
+                           stride, ref, wrtmask, mask);
+}
+
+#endif /* S_SPAN_SIMD_H */
@@ -35,6 +35,7 @@
 #include "s_depth.h"
 #include "s_stencil.h"
 #include "s_span.h"
+#include "s_span_simd.h"
 
 
 
@@ -133,7 +134,12 @@ apply_stencil_op(const struct gl_context *ctx, GLenum oper, GLuint face,
    const GLubyte ref = _mesa_get_stencil_ref(ctx, face);
    const GLubyte wrtmask = ctx->Stencil.WriteMask[face];
    const GLubyte invmask = (GLubyte) (~wrtmask);
-   GLuint i, j;
+   GLuint i, j, done;
+
+   done = _swrast_simd_stencil_op(oper, n, stencil, stride, ref, wrtmask, mask);
+   n -= done;
+   stencil += done * stride;
+   mask += done;
 
    switch (oper) {
    case GL_KEEP:
@@ -174,23 +180,23 @@ apply_stencil_op(const struct gl_context *ctx, GLenum oper, GLuint face,
 
 
 
-#define STENCIL_TEST(FUNC)                        \
-   for (i = j = 0; i < n; i++, j += stride) {     \
-      if (mask[i]) {                              \
-         s = (GLubyte) (stencil[j] & valueMask);  \
-         if (FUNC) {                              \
-            /* stencil pass */                    \
-            fail[i] = 0;                          \
-         }                                        \
-         else {                                   \
-            /* stencil fail */                    \
-            fail[i] = 1;                          \
-            mask[i] = 0;                          \
-         }                                        \
-      }                                           \
-      else {                                      \
-         fail[i] = 0;                             \
-      }                                           \
+#define STENCIL_TEST(FUNC)                                      \
+   for (i = done, j = done * stride; i < n; i++, j += stride) { \
+      if (mask[i]) {                                            \
+         s = (GLubyte) (stencil[j] & valueMask);                \
+         if (FUNC) {                                            \
+            /* stencil pass */                                  \
+            fail[i] = 0;                                        \
+         }                                                      \
+         else {                                                 \
+            /* stencil fail */                                  \
+            fail[i] = 1;                                        \
+            mask[i] = 0;                                        \
+         }                                                      \
+      }                                                         \
+      else {                                                    \
+         fail[i] = 0;                                           \
+      }                                                         \
    }
 
 
@@ -219,6 +225,7 @@ do_stencil_test(struct gl_context *ctx, GLuint face, GLuint n,
    const GLuint valueMask = ctx->Stencil.ValueMask[face];
    const GLubyte ref = (GLubyte) (_mesa_get_stencil_ref(ctx, face) & valueMask);
    GLubyte s;
+   GLuint done;
 
    /*
     * Perform stencil test.  The results of this operation are stored
@@ -228,7 +235,12 @@ do_stencil_test(struct gl_context *ctx, GLuint face, GLuint n,
     *   ELSE
     *       the stencil fail operator is not to be applied
     *   ENDIF
+    *
+    * The vector code does the first part of the span.
     */
+   done = _swrast_simd_stencil_test(ctx->Stencil.Function[face], n, stencil,
+                                    stride, ref, valueMask, mask, fail);
+
    switch (ctx->Stencil.Function[face]) {
    case GL_NEVER:
       STENCIL_TEST(0);
@@ -42,9 +42,14 @@
 #include "s_aatriangle.h"
 #include "s_context.h"
 #include "s_feedback.h"
+#include "s_fragprog.h"
 #include "s_span.h"
 #include "s_triangle.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 
 /**
  * Test if a triangle should be culled.  Used for feedback and selection mode.
@@ -864,7 +869,11 @@ fast_persp_span(struct gl_context *ctx, SWspan *span,
 /*
  * Render an RGBA triangle with arbitrary attributes.
  */
+#ifdef _OPENMP
+#define NAME general_triangle_direct
+#else
 #define NAME general_triangle
+#endif
 #define INTERP_Z 1
 #define INTERP_RGB 1
 #define INTERP_ALPHA 1
@@ -873,6 +882,83 @@ fast_persp_span(struct gl_context *ctx, SWspan *span,
 #include "s_tritemp.h"
 
 
+#ifdef _OPENMP
+
+/**
+ * Write all the spans in the span queue.  The spans of one triangle
+ * never share a row, so they can be written in any order and by several
+ * threads at once, each one using its own SpanArrays.
+ */
+static void
+flush_span_queue(struct gl_context *ctx)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+   const GLint count = swrast->SpanQueueCount;
+   GLint i;
+
+#pragma omp parallel for schedule(dynamic)
+   for (i = 0; i < count; i++) {
+      SWspan *span = &swrast->SpanQueue[i];
+      span->array = swrast->SpanArrays + omp_get_thread_num();
+      _swrast_write_rgba_span(ctx, span);
+   }
+
+   swrast->SpanQueueCount = 0;
+}
+
+
+static inline void
+queue_span(struct gl_context *ctx, const SWspan *span)
+{
+   SWcontext *swrast = SWRAST_CONTEXT(ctx);
+
+   if (swrast->SpanQueueCount == SWRAST_SPAN_QUEUE_SIZE)
+      flush_span_queue(ctx);
+
+   swrast->SpanQueue[swrast->SpanQueueCount++] = *span;
+}
+
+
+#define NAME general_triangle_queued
+#define INTERP_Z 1
+#define INTERP_RGB 1
+#define INTERP_ALPHA 1
+#define INTERP_ATTRIBS 1
+#define RENDER_SPAN( span )   queue_span(ctx, &span);
+#include "s_tritemp.h"
+
+
+/**
+ * Fragment programs and stencil testing use scratch state that lives in
+ * the SWcontext, so spans can only be written in parallel without them.
+ */
+static inline GLboolean
+can_queue_spans(struct gl_context *ctx)
+{
+   return SWRAST_CONTEXT(ctx)->SpanQueue &&
+          !_swrast_use_fragment_program(ctx) &&
+          !ctx->ATIFragmentShader._Enabled &&
+          !ctx->Stencil._Enabled;
+}
+
+
+static void
+general_triangle(struct gl_context *ctx, const SWvertex *v0,
+                 const SWvertex *v1, const SWvertex *v2)
+{
+   if (can_queue_spans(ctx)) {
+      general_triangle_queued(ctx, v0, v1, v2);
+      /* finish this triangle before the next one may touch its pixels */
+      flush_span_queue(ctx);
+   }
+   else {
+      general_triangle_direct(ctx, v0, v1, v2);
+   }
+}
+
+#endif /* _OPENMP */
+
+
 
 
 /*
@@ -283,6 +283,46 @@ lookup_shininess(const struct gl_context *ctx, GLuint face, GLfloat dp)
       return tab->tab[k] + (f - k) * (tab->tab[k+1] - tab->tab[k]);
 }
 
+/*
+ * light_fast_rgba_single() computes the dot products of the normals with
+ * the light vectors for this many vertices at once.
+ */
+#define LIGHT_DOT_BATCH 64
+
+/*
+ * Compute the dot products of n normals with the _VP_inf_norm and
+ * _h_inf_norm vectors of an infinite light.  This is a loop of its own,
+ * separate from the shading, so that the compiler can vectorize it.
+ */
+static void
+light_dot_products(const GLfloat *normal, GLuint nstride, GLuint n,
+                   const struct gl_light *light,
+                   GLfloat n_dot_VP[], GLfloat n_dot_h[])
+{
+   const GLfloat VPx = light->_VP_inf_norm[0];
+   const GLfloat VPy = light->_VP_inf_norm[1];
+   const GLfloat VPz = light->_VP_inf_norm[2];
+   const GLfloat hx = light->_h_inf_norm[0];
+   const GLfloat hy = light->_h_inf_norm[1];
+   const GLfloat hz = light->_h_inf_norm[2];
+   GLuint i;
+
+   if (nstride == 4 * sizeof(GLfloat)) {
+      const GLfloat (*norm)[4] = (const GLfloat (*)[4]) normal;
+      for (i = 0; i < n; i++) {
+         n_dot_VP[i] = norm[i][0] * VPx + norm[i][1] * VPy + norm[i][2] * VPz;
+         n_dot_h[i] = norm[i][0] * hx + norm[i][1] * hy + norm[i][2] * hz;
+      }
+   }
+   else {
+      for (i = 0; i < n; i++, normal = (const GLfloat *)
+                                 ((const GLubyte *) normal + nstride)) {
+         n_dot_VP[i] = normal[0] * VPx + normal[1] * VPy + normal[2] * VPz;
+         n_dot_h[i] = normal[0] * hx + normal[1] * hy + normal[2] * hz;
+      }
+   }
+}
+
 /* Tables for all the shading functions.
  */
 static light_func _tnl_light_tab[MAX_LIGHT_FUNC];
@@ -424,6 +424,7 @@ static void TAG(light_fast_rgba_single)( struct gl_context *ctx,
    const GLuint nr = VB->Count;
 #else
    const GLuint nr = VB->AttribPtr[_TNL_ATTRIB_NORMAL]->count;
+   GLfloat dot_VP[LIGHT_DOT_BATCH], dot_h[LIGHT_DOT_BATCH];
 #endif
 
 #ifdef TRACE
@@ -448,10 +449,16 @@ static void TAG(light_fast_rgba_single)( struct gl_context *ctx,
 
    for (j = 0; j < nr; j++, STRIDE_F(normal,nstride)) {
 
-      GLfloat n_dot_VP;
+      GLfloat n_dot_VP, n_dot_h;
 
 #if IDX & LIGHT_MATERIAL
       update_materials( ctx, store );
+#else
+      /* The light doesn't change, do the dot products a batch at a time.
+       */
+      if (j % LIGHT_DOT_BATCH == 0)
+         light_dot_products(normal, nstride, MIN2(nr - j, LIGHT_DOT_BATCH),
+                            light, dot_VP, dot_h);
 #endif
 
       /* No attenuation, so incoporate _MatAmbient into base color.
@@ -471,12 +478,18 @@ static void TAG(light_fast_rgba_single)( struct gl_context *ctx,
 #endif
       }
 
+#if IDX & LIGHT_MATERIAL
       n_dot_VP = DOT3(normal, light->_VP_inf_norm);
+      n_dot_h = DOT3(normal, light->_h_inf_norm);
+#else
+      n_dot_VP = dot_VP[j % LIGHT_DOT_BATCH];
+      n_dot_h = dot_h[j % LIGHT_DOT_BATCH];
+#endif
 
       if (n_dot_VP < 0.0F) {
 #if IDX & LIGHT_TWOSIDE
-         GLfloat n_dot_h = -DOT3(normal, light->_h_inf_norm);
          GLfloat sum[3];
+         n_dot_h = -n_dot_h;
          COPY_3V(sum, base[1]);
          ACC_SCALE_SCALAR_3V(sum, -n_dot_VP, light->_MatDiffuse[1]);
          if (n_dot_h > 0.0F) {
@@ -489,7 +502,6 @@ static void TAG(light_fast_rgba_single)( struct gl_context *ctx,
 	 COPY_4FV(Fcolor[j], base[0]);
       }
       else {
-	 GLfloat n_dot_h = DOT3(normal, light->_h_inf_norm);
 	 GLfloat sum[3];
 	 COPY_3V(sum, base[0]);
 	 ACC_SCALE_SCALAR_3V(sum, n_dot_VP, light->_MatDiffuse[0]);
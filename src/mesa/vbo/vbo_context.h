@@ -217,6 +217,17 @@ vbo_compute_max_verts(const struct vbo_exec_context *exec)
 }
 
 
+/**
+ * Whether the immediate mode vertex buffer is kept persistently mapped,
+ * see vbo_exec_vtx_map().
+ */
+static inline GLboolean
+vbo_exec_use_persistent_map(const struct gl_context *ctx)
+{
+   return ctx->Extensions.ARB_buffer_storage;
+}
+
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
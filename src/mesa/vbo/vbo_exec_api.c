@@ -781,7 +781,7 @@ static void GLAPIENTRY vbo_exec_Begin( GLenum mode )
     */
    if (ctx->CurrentDispatch == ctx->OutsideBeginEnd) {
       ctx->CurrentDispatch = ctx->BeginEnd;
-      _glapi_set_dispatch(ctx->CurrentDispatch);
+      _mesa_install_current_dispatch(ctx);
    } else {
       assert(ctx->CurrentDispatch == ctx->Save);
    }
@@ -832,7 +832,7 @@ static void GLAPIENTRY vbo_exec_End( void )
    ctx->Exec = ctx->OutsideBeginEnd;
    if (ctx->CurrentDispatch == ctx->BeginEnd) {
       ctx->CurrentDispatch = ctx->OutsideBeginEnd;
-      _glapi_set_dispatch(ctx->CurrentDispatch);
+      _mesa_install_current_dispatch(ctx);
    }
 
    if (exec->vtx.prim_count > 0) {
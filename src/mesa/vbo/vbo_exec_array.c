@@ -776,6 +776,21 @@ vbo_exec_EvalMesh2(GLenum mode, GLint i1, GLint i2, GLint j1, GLint j2)
 }
 
 
+/**
+ * The parts of the draw validation that are needed even in a
+ * KHR_no_error context: flushing the current attribs and updating the
+ * derived state.
+ */
+static inline void
+vbo_prepare_draw_no_error(struct gl_context *ctx)
+{
+   FLUSH_CURRENT(ctx, 0);
+
+   if (ctx->NewState)
+      _mesa_update_state(ctx);
+}
+
+
 /**
  * Called from glDrawArrays when in immediate mode (not display list mode).
  */
@@ -801,6 +816,19 @@ vbo_exec_DrawArrays(GLenum mode, GLint start, GLsizei count)
 }
 
 
+/**
+ * glDrawArrays for KHR_no_error contexts.
+ */
+static void GLAPIENTRY
+vbo_exec_DrawArrays_no_error(GLenum mode, GLint start, GLsizei count)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   vbo_prepare_draw_no_error(ctx);
+   vbo_draw_arrays(ctx, mode, start, count, 1, 0);
+}
+
+
 /**
  * Called from glDrawArraysInstanced when in immediate mode (not
  * display list mode).
@@ -828,6 +856,20 @@ vbo_exec_DrawArraysInstanced(GLenum mode, GLint start, GLsizei count,
 }
 
 
+/**
+ * glDrawArraysInstanced for KHR_no_error contexts.
+ */
+static void GLAPIENTRY
+vbo_exec_DrawArraysInstanced_no_error(GLenum mode, GLint start, GLsizei count,
+                                      GLsizei numInstances)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   vbo_prepare_draw_no_error(ctx);
+   vbo_draw_arrays(ctx, mode, start, count, numInstances, 0);
+}
+
+
 /**
  * Called from glDrawArraysInstancedBaseInstance when in immediate mode.
  */
@@ -999,14 +1041,14 @@ vbo_validated_drawrangeelements(struct gl_context *ctx, GLenum mode,
 
 
 /**
- * Called by glDrawRangeElementsBaseVertex() in immediate mode.
+ * Do the rendering for glDrawRangeElementsBaseVertex() once the arguments
+ * have been validated: sanitize the index range and draw.
  */
-static void GLAPIENTRY
-vbo_exec_DrawRangeElementsBaseVertex(GLenum mode,
-				     GLuint start, GLuint end,
-				     GLsizei count, GLenum type,
-				     const GLvoid *indices,
-				     GLint basevertex)
+static void
+vbo_draw_range_elements(struct gl_context *ctx, GLenum mode,
+                        GLuint start, GLuint end,
+                        GLsizei count, GLenum type,
+                        const GLvoid *indices, GLint basevertex)
 {
    static GLuint warnCount = 0;
    GLboolean index_bounds_valid = GL_TRUE;
@@ -1016,18 +1058,6 @@ vbo_exec_DrawRangeElementsBaseVertex(GLenum mode,
     */
    GLuint max_element = 2 * 1000 * 1000 * 1000; /* just a big number */
 
-   GET_CURRENT_CONTEXT(ctx);
-
-   if (MESA_VERBOSE & VERBOSE_DRAW)
-      _mesa_debug(ctx,
-                "glDrawRangeElementsBaseVertex(%s, %u, %u, %d, %s, %p, %d)\n",
-                _mesa_enum_to_string(mode), start, end, count,
-                _mesa_enum_to_string(type), indices, basevertex);
-
-   if (!_mesa_validate_DrawRangeElements(ctx, mode, start, end, count,
-                                         type, indices))
-      return;
-
    if ((int) end + basevertex < 0 ||
        start + basevertex >= max_element) {
       /* The application requested we draw using a range of indices that's
@@ -1088,6 +1118,51 @@ vbo_exec_DrawRangeElementsBaseVertex(GLenum mode,
 }
 
 
+/**
+ * Called by glDrawRangeElementsBaseVertex() in immediate mode.
+ */
+static void GLAPIENTRY
+vbo_exec_DrawRangeElementsBaseVertex(GLenum mode,
+				     GLuint start, GLuint end,
+				     GLsizei count, GLenum type,
+				     const GLvoid *indices,
+				     GLint basevertex)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (MESA_VERBOSE & VERBOSE_DRAW)
+      _mesa_debug(ctx,
+                "glDrawRangeElementsBaseVertex(%s, %u, %u, %d, %s, %p, %d)\n",
+                _mesa_enum_to_string(mode), start, end, count,
+                _mesa_enum_to_string(type), indices, basevertex);
+
+   if (!_mesa_validate_DrawRangeElements(ctx, mode, start, end, count,
+                                         type, indices))
+      return;
+
+   vbo_draw_range_elements(ctx, mode, start, end, count, type, indices,
+                           basevertex);
+}
+
+
+/**
+ * glDrawRangeElementsBaseVertex for KHR_no_error contexts.
+ */
+static void GLAPIENTRY
+vbo_exec_DrawRangeElementsBaseVertex_no_error(GLenum mode,
+                                              GLuint start, GLuint end,
+                                              GLsizei count, GLenum type,
+                                              const GLvoid *indices,
+                                              GLint basevertex)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   vbo_prepare_draw_no_error(ctx);
+   vbo_draw_range_elements(ctx, mode, start, end, count, type, indices,
+                           basevertex);
+}
+
+
 /**
  * Called by glDrawRangeElements() in immediate mode.
  */
@@ -1108,6 +1183,19 @@ vbo_exec_DrawRangeElements(GLenum mode, GLuint start, GLuint end,
 }
 
 
+/**
+ * glDrawRangeElements for KHR_no_error contexts.
+ */
+static void GLAPIENTRY
+vbo_exec_DrawRangeElements_no_error(GLenum mode, GLuint start, GLuint end,
+                                    GLsizei count, GLenum type,
+                                    const GLvoid *indices)
+{
+   vbo_exec_DrawRangeElementsBaseVertex_no_error(mode, start, end, count,
+                                                 type, indices, 0);
+}
+
+
 /**
  * Called by glDrawElements() in immediate mode.
  */
@@ -1130,6 +1218,21 @@ vbo_exec_DrawElements(GLenum mode, GLsizei count, GLenum type,
 }
 
 
+/**
+ * glDrawElements for KHR_no_error contexts.
+ */
+static void GLAPIENTRY
+vbo_exec_DrawElements_no_error(GLenum mode, GLsizei count, GLenum type,
+                               const GLvoid *indices)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   vbo_prepare_draw_no_error(ctx);
+   vbo_validated_drawrangeelements(ctx, mode, GL_FALSE, ~0, ~0,
+                                   count, type, indices, 0, 1, 0);
+}
+
+
 /**
  * Called by glDrawElementsBaseVertex() in immediate mode.
  */
@@ -1152,6 +1255,22 @@ vbo_exec_DrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type,
 }
 
 
+/**
+ * glDrawElementsBaseVertex for KHR_no_error contexts.
+ */
+static void GLAPIENTRY
+vbo_exec_DrawElementsBaseVertex_no_error(GLenum mode, GLsizei count,
+                                         GLenum type, const GLvoid *indices,
+                                         GLint basevertex)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   vbo_prepare_draw_no_error(ctx);
+   vbo_validated_drawrangeelements(ctx, mode, GL_FALSE, ~0, ~0,
+                                   count, type, indices, basevertex, 1, 0);
+}
+
+
 /**
  * Called by glDrawElementsInstanced() in immediate mode.
  */
@@ -1175,6 +1294,22 @@ vbo_exec_DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
 }
 
 
+/**
+ * glDrawElementsInstanced for KHR_no_error contexts.
+ */
+static void GLAPIENTRY
+vbo_exec_DrawElementsInstanced_no_error(GLenum mode, GLsizei count,
+                                        GLenum type, const GLvoid *indices,
+                                        GLsizei numInstances)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   vbo_prepare_draw_no_error(ctx);
+   vbo_validated_drawrangeelements(ctx, mode, GL_FALSE, ~0, ~0,
+                                   count, type, indices, 0, numInstances, 0);
+}
+
+
 /**
  * Called by glDrawElementsInstancedBaseVertex() in immediate mode.
  */
@@ -1200,6 +1335,25 @@ vbo_exec_DrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type
 }
 
 
+/**
+ * glDrawElementsInstancedBaseVertex for KHR_no_error contexts.
+ */
+static void GLAPIENTRY
+vbo_exec_DrawElementsInstancedBaseVertex_no_error(GLenum mode, GLsizei count,
+                                                  GLenum type,
+                                                  const GLvoid *indices,
+                                                  GLsizei numInstances,
+                                                  GLint basevertex)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   vbo_prepare_draw_no_error(ctx);
+   vbo_validated_drawrangeelements(ctx, mode, GL_FALSE, ~0, ~0,
+                                   count, type, indices, basevertex,
+                                   numInstances, 0);
+}
+
+
 /**
  * Called by glDrawElementsInstancedBaseInstance() in immediate mode.
  */
@@ -1284,9 +1438,12 @@ vbo_validated_multidrawelements(struct gl_context *ctx, GLenum mode,
 
    vbo_bind_arrays(ctx);
 
-   min_index_ptr = (uintptr_t)indices[0];
+   /* Primitives with a zero count don't read any index. */
+   min_index_ptr = ~(uintptr_t)0;
    max_index_ptr = 0;
    for (i = 0; i < primcount; i++) {
+      if (count[i] == 0)
+         continue;
       min_index_ptr = MIN2(min_index_ptr, (uintptr_t)indices[i]);
       max_index_ptr = MAX2(max_index_ptr, (uintptr_t)indices[i] +
 			   index_type_size * count[i]);
@@ -1300,23 +1457,14 @@ vbo_validated_multidrawelements(struct gl_context *ctx, GLenum mode,
     */
    if (index_type_size != 1) {
       for (i = 0; i < primcount; i++) {
-	 if ((((uintptr_t)indices[i] - min_index_ptr) % index_type_size) != 0) {
+	 if (count[i] != 0 &&
+	     (((uintptr_t)indices[i] - min_index_ptr) % index_type_size) != 0) {
 	    fallback = GL_TRUE;
 	    break;
 	 }
       }
    }
 
-   /* Draw primitives individually if one count is zero, so we can easily skip
-    * that primitive.
-    */
-   for (i = 0; i < primcount; i++) {
-      if (count[i] == 0) {
-         fallback = GL_TRUE;
-         break;
-      }
-   }
-
    /* If the index buffer isn't in a VBO, then treating the application's
     * subranges of the index buffer as one large index buffer may lead to
     * us reading unmapped memory.
@@ -1325,32 +1473,46 @@ vbo_validated_multidrawelements(struct gl_context *ctx, GLenum mode,
       fallback = GL_TRUE;
 
    if (!fallback) {
+      GLsizei num_prims = 0;
+
       ib.count = (max_index_ptr - min_index_ptr) / index_type_size;
       ib.type = type;
       ib.obj = ctx->Array.VAO->IndexBufferObj;
       ib.ptr = (void *)min_index_ptr;
 
+      /* Primitives with a zero count are left out, so that all the others
+       * are still drawn with one draw_prims call.
+       */
       for (i = 0; i < primcount; i++) {
-	 prim[i].begin = (i == 0);
-	 prim[i].end = (i == primcount - 1);
-	 prim[i].weak = 0;
-	 prim[i].pad = 0;
-	 prim[i].mode = mode;
-	 prim[i].start = ((uintptr_t)indices[i] - min_index_ptr) / index_type_size;
-	 prim[i].count = count[i];
-	 prim[i].indexed = 1;
-         prim[i].num_instances = 1;
-         prim[i].base_instance = 0;
-         prim[i].is_indirect = 0;
+         struct _mesa_prim *p = &prim[num_prims];
+
+         if (count[i] == 0)
+            continue;
+
+	 p->begin = (num_prims == 0);
+	 p->end = 0;
+	 p->weak = 0;
+	 p->pad = 0;
+	 p->mode = mode;
+	 p->start = ((uintptr_t)indices[i] - min_index_ptr) / index_type_size;
+	 p->count = count[i];
+	 p->indexed = 1;
+         p->num_instances = 1;
+         p->base_instance = 0;
+         p->is_indirect = 0;
 	 if (basevertex != NULL)
-	    prim[i].basevertex = basevertex[i];
+	    p->basevertex = basevertex[i];
 	 else
-	    prim[i].basevertex = 0;
+	    p->basevertex = 0;
+         num_prims++;
       }
 
-      check_buffers_are_unmapped(exec->array.inputs);
-      vbo->draw_prims(ctx, prim, primcount, &ib,
-                      false, ~0, ~0, NULL, 0, NULL);
+      if (num_prims) {
+         prim[num_prims - 1].end = 1;
+         check_buffers_are_unmapped(exec->array.inputs);
+         vbo->draw_prims(ctx, prim, num_prims, &ib,
+                         false, ~0, ~0, NULL, 0, NULL);
+      }
    } else {
       /* render one prim at a time */
       for (i = 0; i < primcount; i++) {
@@ -1785,6 +1947,39 @@ vbo_exec_MultiDrawElementsIndirect(GLenum mode, GLenum type,
                                            primcount, stride);
 }
 
+/**
+ * Replace the most frequently called drawing functions with variants
+ * that skip the error checking, for KHR_no_error contexts.
+ */
+static void
+vbo_initialize_exec_dispatch_no_error(const struct gl_context *ctx,
+                                      struct _glapi_table *exec)
+{
+   SET_DrawArrays(exec, vbo_exec_DrawArrays_no_error);
+   SET_DrawElements(exec, vbo_exec_DrawElements_no_error);
+
+   if (_mesa_is_desktop_gl(ctx) || _mesa_is_gles3(ctx)) {
+      SET_DrawRangeElements(exec, vbo_exec_DrawRangeElements_no_error);
+      SET_DrawArraysInstancedARB(exec, vbo_exec_DrawArraysInstanced_no_error);
+      SET_DrawElementsInstancedARB(exec,
+                                   vbo_exec_DrawElementsInstanced_no_error);
+   }
+
+   if (ctx->API != API_OPENGLES &&
+       ctx->Extensions.ARB_draw_elements_base_vertex) {
+      SET_DrawElementsBaseVertex(exec,
+                                 vbo_exec_DrawElementsBaseVertex_no_error);
+
+      if (_mesa_is_desktop_gl(ctx) || _mesa_is_gles3(ctx)) {
+         SET_DrawRangeElementsBaseVertex(exec,
+            vbo_exec_DrawRangeElementsBaseVertex_no_error);
+         SET_DrawElementsInstancedBaseVertex(exec,
+            vbo_exec_DrawElementsInstancedBaseVertex_no_error);
+      }
+   }
+}
+
+
 /**
  * Initialize the dispatch table with the VBO functions for drawing.
  */
@@ -1845,6 +2040,9 @@ vbo_initialize_exec_dispatch(const struct gl_context *ctx,
       SET_DrawTransformFeedbackInstanced(exec, vbo_exec_DrawTransformFeedbackInstanced);
       SET_DrawTransformFeedbackStreamInstanced(exec, vbo_exec_DrawTransformFeedbackStreamInstanced);
    }
+
+   if (_mesa_is_no_error_enabled(ctx))
+      vbo_initialize_exec_dispatch_no_error(ctx, exec);
 }
 
 
@@ -233,11 +233,17 @@ vbo_exec_bind_arrays( struct gl_context *ctx )
          exec->vtx.inputs[attr] = &arrays[attr];
 
          if (_mesa_is_bufferobj(exec->vtx.bufferobj)) {
-            /* a real buffer obj: Ptr is an offset, not a pointer */
-            assert(exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Pointer);
+            /* a real buffer obj: Ptr is an offset, not a pointer.  A
+             * persistent mapping may hold earlier batches before this one.
+             */
+            const struct gl_buffer_mapping *mapping =
+               &exec->vtx.bufferobj->Mappings[MAP_INTERNAL];
+
+            assert(mapping->Pointer);
             assert(offset >= 0);
-            arrays[attr].Ptr = (GLubyte *)
-               exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Offset + offset;
+            arrays[attr].Ptr = (GLubyte *) mapping->Offset +
+               ((GLubyte *) exec->vtx.buffer_map -
+                (GLubyte *) mapping->Pointer) + offset;
          }
          else {
             /* Ptr into ordinary app memory */
@@ -274,7 +280,9 @@ vbo_exec_vtx_unmap( struct vbo_exec_context *exec )
    if (_mesa_is_bufferobj(exec->vtx.bufferobj)) {
       struct gl_context *ctx = exec->ctx;
 
-      if (ctx->Driver.FlushMappedBufferRange) {
+      if (ctx->Driver.FlushMappedBufferRange &&
+          (exec->vtx.bufferobj->Mappings[MAP_INTERNAL].AccessFlags &
+           GL_MAP_FLUSH_EXPLICIT_BIT)) {
          GLintptr offset = exec->vtx.buffer_used -
                            exec->vtx.bufferobj->Mappings[MAP_INTERNAL].Offset;
          GLsizeiptr length = (exec->vtx.buffer_ptr - exec->vtx.buffer_map) *
@@ -302,21 +310,40 @@ vbo_exec_vtx_unmap( struct vbo_exec_context *exec )
 
 /**
  * Map the vertex buffer to begin storing glVertex, glColor, etc data.
+ *
+ * With ARB_buffer_storage the buffer is mapped persistently and
+ * coherently.  It then stays mapped across draws and vertex flushes,
+ * with each batch appended after the previous one, and is only unmapped
+ * when it fills up and gets reallocated.
  */
 void
 vbo_exec_vtx_map( struct vbo_exec_context *exec )
 {
    struct gl_context *ctx = exec->ctx;
-   const GLenum accessRange = GL_MAP_WRITE_BIT |  /* for MapBufferRange */
-                              GL_MAP_INVALIDATE_RANGE_BIT |
-                              GL_MAP_UNSYNCHRONIZED_BIT |
-                              GL_MAP_FLUSH_EXPLICIT_BIT |
-                              MESA_MAP_NOWAIT_BIT;
+   const GLboolean persistent = vbo_exec_use_persistent_map(ctx);
+   GLenum accessRange = GL_MAP_WRITE_BIT |  /* for MapBufferRange */
+                        GL_MAP_INVALIDATE_RANGE_BIT |
+                        GL_MAP_UNSYNCHRONIZED_BIT |
+                        GL_MAP_FLUSH_EXPLICIT_BIT |
+                        MESA_MAP_NOWAIT_BIT;
+   GLbitfield storageFlags = GL_MAP_WRITE_BIT |
+                             GL_DYNAMIC_STORAGE_BIT |
+                             GL_CLIENT_STORAGE_BIT;
    const GLenum usage = GL_STREAM_DRAW_ARB;
 
    if (!_mesa_is_bufferobj(exec->vtx.bufferobj))
       return;
 
+   if (persistent) {
+      /* Still mapped from the previous batch. */
+      if (exec->vtx.buffer_map)
+         return;
+
+      accessRange &= ~GL_MAP_FLUSH_EXPLICIT_BIT;
+      accessRange |= GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      storageFlags |= GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+   }
+
    assert(!exec->vtx.buffer_map);
    assert(!exec->vtx.buffer_ptr);
 
@@ -345,9 +372,7 @@ vbo_exec_vtx_map( struct vbo_exec_context *exec )
       if (ctx->Driver.BufferData(ctx, GL_ARRAY_BUFFER_ARB,
                                  VBO_VERT_BUFFER_SIZE,
                                  NULL, usage,
-                                 GL_MAP_WRITE_BIT |
-                                 GL_DYNAMIC_STORAGE_BIT |
-                                 GL_CLIENT_STORAGE_BIT,
+                                 storageFlags,
                                  exec->vtx.bufferobj)) {
          /* buffer allocation worked, now map the buffer */
          exec->vtx.buffer_map =
@@ -392,6 +417,8 @@ vbo_exec_vtx_map( struct vbo_exec_context *exec )
 void
 vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
 {
+   const GLboolean persistent = vbo_exec_use_persistent_map(exec->ctx);
+
    if (0)
       vbo_exec_debug_verts( exec );
 
@@ -411,7 +438,7 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
          if (ctx->NewState)
             _mesa_update_state( ctx );
 
-         if (_mesa_is_bufferobj(exec->vtx.bufferobj)) {
+         if (_mesa_is_bufferobj(exec->vtx.bufferobj) && !persistent) {
             vbo_exec_vtx_unmap( exec );
          }
 
@@ -428,23 +455,38 @@ vbo_exec_vtx_flush(struct vbo_exec_context *exec, GLboolean keepUnmapped)
 				       exec->vtx.vert_count - 1,
 				       NULL, 0, NULL);
 
+         if (persistent) {
+            /* Leave the buffer mapped and start the next batch right
+             * after this one.  Release it once it is nearly full so that
+             * vbo_exec_vtx_map() reallocates it.
+             */
+            exec->vtx.buffer_used += (exec->vtx.buffer_ptr -
+                                      exec->vtx.buffer_map) * sizeof(float);
+            exec->vtx.buffer_map = exec->vtx.buffer_ptr;
+
+            if (VBO_VERT_BUFFER_SIZE <= exec->vtx.buffer_used + 1024)
+               vbo_exec_vtx_unmap( exec );
+         }
+
 	 /* If using a real VBO, get new storage -- unless asked not to.
           */
-         if (_mesa_is_bufferobj(exec->vtx.bufferobj) && !keepUnmapped) {
+         if (_mesa_is_bufferobj(exec->vtx.bufferobj) &&
+             (!keepUnmapped || persistent)) {
             vbo_exec_vtx_map( exec );
          }
       }
    }
 
-   /* May have to unmap explicitly if we didn't draw:
+   /* May have to unmap explicitly if we didn't draw.  A persistent
+    * mapping is kept, see vbo_exec_vtx_map().
     */
-   if (keepUnmapped &&
+   if (keepUnmapped && !persistent &&
        _mesa_is_bufferobj(exec->vtx.bufferobj) &&
        exec->vtx.buffer_map) {
       vbo_exec_vtx_unmap( exec );
    }
 
-   if (keepUnmapped || exec->vtx.vertex_size == 0)
+   if (!exec->vtx.buffer_map || exec->vtx.vertex_size == 0)
       exec->vtx.max_vert = 0;
    else
       exec->vtx.max_vert = vbo_compute_max_verts(exec);
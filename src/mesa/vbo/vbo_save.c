@@ -42,6 +42,7 @@ void vbo_save_init( struct gl_context *ctx )
    struct vbo_save_context *save = &vbo->save;
 
    save->ctx = ctx;
+   save->superblocks = getenv("MESA_VBO_SAVE_SUPERBLOCKS") != NULL;
 
    vbo_save_api_init( save );
 
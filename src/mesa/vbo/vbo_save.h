@@ -96,6 +96,7 @@ struct vbo_save_vertex_list {
  * internally even though this probably isn't allowed for client VBOs?
  */
 #define VBO_SAVE_BUFFER_SIZE (8*1024) /* dwords */
+#define VBO_SAVE_SUPERBLOCK_SIZE (256*1024) /* dwords */
 #define VBO_SAVE_PRIM_SIZE   128
 #define VBO_SAVE_PRIM_MODE_MASK         0x3f
 #define VBO_SAVE_PRIM_WEAK              0x40
@@ -108,6 +109,7 @@ struct vbo_save_vertex_list {
 struct vbo_save_vertex_store {
    struct gl_buffer_object *bufferobj;
    fi_type *buffer;
+   GLuint size;   /**< in dwords */
    GLuint used;
    GLuint refcount;
 };
@@ -153,6 +155,27 @@ struct vbo_save_context {
 
    GLuint opcode_vertex_list;
 
+   /**
+    * MESA_VBO_SAVE_SUPERBLOCKS: share large vertex stores between lists
+    * and keep the array bindings of the previous node when the next one
+    * has the same layout, see vbo_bind_vertex_list().
+    */
+   GLboolean superblocks;
+
+   /** Array layout last installed in superblock mode */
+   struct {
+      GLboolean valid;
+      const struct gl_buffer_object *bufferobj;
+      GLubyte attrsz[VBO_ATTRIB_MAX];
+      GLenum attrtype[VBO_ATTRIB_MAX];
+      GLuint vertex_size;
+      const struct gl_vertex_program *program;
+      GLbitfield64 const_inputs;
+      fi_type const_values[VERT_ATTRIB_MAX][4];
+      GLenum const_types[VERT_ATTRIB_MAX];
+      GLint const_sizes[VERT_ATTRIB_MAX];
+   } bound;
+
    struct vbo_save_copied_vtx copied;
    
    fi_type *current[VBO_ATTRIB_MAX]; /* points into ctx->ListState */
@@ -191,12 +191,14 @@ alloc_vertex_store(struct gl_context *ctx)
     * user.  Perhaps there could be a special number for internal
     * buffers:
     */
+   vertex_store->size = save->superblocks ? VBO_SAVE_SUPERBLOCK_SIZE
+                                          : VBO_SAVE_BUFFER_SIZE;
    vertex_store->bufferobj = ctx->Driver.NewBufferObject(ctx, VBO_BUF_ID);
    if (vertex_store->bufferobj) {
       save->out_of_memory =
          !ctx->Driver.BufferData(ctx,
                                  GL_ARRAY_BUFFER_ARB,
-                                 VBO_SAVE_BUFFER_SIZE * sizeof(GLfloat),
+                                 vertex_store->size * sizeof(GLfloat),
                                  NULL, GL_STATIC_DRAW_ARB,
                                  GL_MAP_WRITE_BIT |
                                  GL_DYNAMIC_STORAGE_BIT,
@@ -314,7 +316,7 @@ _save_reset_counters(struct gl_context *ctx)
    assert(save->buffer == save->buffer_ptr);
 
    if (save->vertex_size)
-      save->max_vert = (VBO_SAVE_BUFFER_SIZE - save->vertex_store->used) /
+      save->max_vert = (save->vertex_store->size - save->vertex_store->used) /
                         save->vertex_size;
    else
       save->max_vert = 0;
@@ -513,7 +515,7 @@ _save_compile_vertex_list(struct gl_context *ctx)
     * the next vertex lists as well.
     */
    if (save->vertex_store->used >
-       VBO_SAVE_BUFFER_SIZE - 16 * (save->vertex_size + 4)) {
+       save->vertex_store->size - 16 * (save->vertex_size + 4)) {
 
       /* Unmap old store:
        */
@@ -532,6 +534,14 @@ _save_compile_vertex_list(struct gl_context *ctx)
       save->out_of_memory = save->buffer_ptr == NULL;
    }
    else {
+      /* In superblock mode start the next list on a vertex boundary so
+       * that it can be drawn from the same array bindings as this one.
+       */
+      if (save->superblocks && save->vertex_size) {
+         save->vertex_store->used = ALIGN_NPOT(save->vertex_store->used,
+                                               save->vertex_size);
+      }
+
       /* update buffer_ptr for next vertex */
       save->buffer_ptr = save->vertex_store->buffer + save->vertex_store->used;
    }
@@ -693,7 +703,7 @@ _save_upgrade_vertex(struct gl_context *ctx, GLuint attr, GLuint newsz)
    save->attrsz[attr] = newsz;
 
    save->vertex_size += newsz - oldsz;
-   save->max_vert = ((VBO_SAVE_BUFFER_SIZE - save->vertex_store->used) /
+   save->max_vert = ((save->vertex_store->size - save->vertex_store->used) /
                      save->vertex_size);
    save->vert_count = 0;
 
@@ -123,23 +123,127 @@ _playback_copy_to_current(struct gl_context *ctx,
 
 
 
+/**
+ * In superblock mode, return whether the node starts on a vertex boundary
+ * of its store, and if so the index of its first vertex.  Such nodes are
+ * drawn with arrays based at the start of the store.
+ */
+static GLboolean
+vbo_node_in_superblock(const struct vbo_save_context *save,
+                       const struct vbo_save_vertex_list *node,
+                       GLuint *first_vertex)
+{
+   const GLuint stride = node->vertex_size * sizeof(GLfloat);
+
+   if (!save->superblocks || stride == 0 || node->buffer_offset % stride)
+      return GL_FALSE;
+
+   *first_vertex = node->buffer_offset / stride;
+   return GL_TRUE;
+}
+
+
+/**
+ * Check whether the arrays installed for the previous superblock node can
+ * be used as they are for this one: same store, same layout, same vertex
+ * program and the same current values behind the non-array inputs.
+ */
+static GLboolean
+vbo_superblock_layout_bound(struct gl_context *ctx,
+                            const struct vbo_save_vertex_list *node)
+{
+   struct vbo_context *vbo = vbo_context(ctx);
+   struct vbo_save_context *save = &vbo->save;
+   GLuint attr;
+
+   if (!save->bound.valid ||
+       ctx->Array.DrawMethod != DRAW_DISPLAY_LIST ||
+       save->bound.bufferobj != node->vertex_store->bufferobj ||
+       save->bound.program != ctx->VertexProgram._Current ||
+       save->bound.vertex_size != node->vertex_size ||
+       memcmp(save->bound.attrsz, node->attrsz, sizeof(node->attrsz)) ||
+       memcmp(save->bound.attrtype, node->attrtype, sizeof(node->attrtype)))
+      return GL_FALSE;
+
+   for (attr = 0; attr < VERT_ATTRIB_MAX; attr++) {
+      const struct gl_client_array *input = save->inputs[attr];
+
+      if (!(save->bound.const_inputs & VERT_BIT(attr)))
+         continue;
+
+      if (input->Type != save->bound.const_types[attr] ||
+          input->Size != save->bound.const_sizes[attr] ||
+          memcmp(input->Ptr, save->bound.const_values[attr],
+                 sizeof(save->bound.const_values[attr])))
+         return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Remember the layout just installed by vbo_bind_vertex_list(), along with
+ * the current values feeding the inputs that are not in the node.
+ */
+static void
+vbo_superblock_record_layout(struct gl_context *ctx,
+                             const struct vbo_save_vertex_list *node,
+                             GLbitfield64 varying_inputs)
+{
+   struct vbo_context *vbo = vbo_context(ctx);
+   struct vbo_save_context *save = &vbo->save;
+   GLuint attr;
+
+   save->bound.valid = GL_TRUE;
+   save->bound.bufferobj = node->vertex_store->bufferobj;
+   save->bound.program = ctx->VertexProgram._Current;
+   save->bound.vertex_size = node->vertex_size;
+   memcpy(save->bound.attrsz, node->attrsz, sizeof(node->attrsz));
+   memcpy(save->bound.attrtype, node->attrtype, sizeof(node->attrtype));
+   save->bound.const_inputs = 0x0;
+
+   for (attr = 0; attr < VERT_ATTRIB_MAX; attr++) {
+      const struct gl_client_array *input = save->inputs[attr];
+
+      /* Only inputs fed from the current values can change behind our
+       * back; the others are either node arrays or unused.
+       */
+      if ((varying_inputs & VERT_BIT(attr)) ||
+          input < vbo->currval || input >= vbo->currval + VBO_ATTRIB_MAX)
+         continue;
+
+      save->bound.const_inputs |= VERT_BIT(attr);
+      save->bound.const_types[attr] = input->Type;
+      save->bound.const_sizes[attr] = input->Size;
+      memcpy(save->bound.const_values[attr], input->Ptr,
+             sizeof(save->bound.const_values[attr]));
+   }
+}
+
+
 /**
  * Treat the vertex storage as a VBO, define vertex arrays pointing
- * into it:
+ * into it.  In superblock mode the arrays start at the beginning of the
+ * store, and are left alone when the previous node had the same layout.
  */
 static void vbo_bind_vertex_list(struct gl_context *ctx,
-                                 const struct vbo_save_vertex_list *node)
+                                 const struct vbo_save_vertex_list *node,
+                                 GLboolean superblock)
 {
    struct vbo_context *vbo = vbo_context(ctx);
    struct vbo_save_context *save = &vbo->save;
    struct gl_client_array *arrays = save->arrays;
-   GLuint buffer_offset = node->buffer_offset;
+   GLuint buffer_offset = superblock ? 0 : node->buffer_offset;
    const GLuint *map;
    GLuint attr;
    GLubyte node_attrsz[VBO_ATTRIB_MAX];  /* copy of node->attrsz[] */
    GLenum node_attrtype[VBO_ATTRIB_MAX];  /* copy of node->attrtype[] */
    GLbitfield64 varying_inputs = 0x0;
 
+   if (superblock && vbo_superblock_layout_bound(ctx, node))
+      return;
+
    memcpy(node_attrsz, node->attrsz, sizeof(node->attrsz));
    memcpy(node_attrtype, node->attrtype, sizeof(node->attrtype));
 
@@ -213,6 +317,11 @@ static void vbo_bind_vertex_list(struct gl_context *ctx,
 
    _mesa_set_varying_vp_inputs( ctx, varying_inputs );
    ctx->NewDriverState |= ctx->DriverFlags.NewArray;
+
+   if (superblock)
+      vbo_superblock_record_layout(ctx, node, varying_inputs);
+   else
+      save->bound.valid = GL_FALSE;
 }
 
 
@@ -252,6 +361,8 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data)
       (const struct vbo_save_vertex_list *) data;
    struct vbo_save_context *save = &vbo_context(ctx)->save;
    GLboolean remap_vertex_store = GL_FALSE;
+   GLboolean superblock;
+   GLuint first_vertex = 0;
 
    if (save->vertex_store && save->vertex_store->buffer) {
       /* The vertex store is currently mapped but we're about to replay
@@ -297,7 +408,9 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data)
          return;
       }
 
-      vbo_bind_vertex_list( ctx, node );
+      superblock = vbo_node_in_superblock(save, node, &first_vertex);
+
+      vbo_bind_vertex_list( ctx, node, superblock );
 
       vbo_draw_method(vbo_context(ctx), DRAW_DISPLAY_LIST);
 
@@ -306,7 +419,29 @@ vbo_save_playback_vertex_list(struct gl_context *ctx, void *data)
       if (ctx->NewState)
 	 _mesa_update_state( ctx );
 
-      if (node->count > 0) {
+      if (node->count > 0 && superblock) {
+         /* The arrays start at the beginning of the store, so move the
+          * primitives to where this node's vertices are.
+          */
+         struct _mesa_prim prim[VBO_SAVE_PRIM_SIZE];
+         GLuint i;
+
+         assert(node->prim_count <= VBO_SAVE_PRIM_SIZE);
+         for (i = 0; i < node->prim_count; i++) {
+            prim[i] = node->prim[i];
+            prim[i].start += first_vertex;
+         }
+
+         vbo_context(ctx)->draw_prims(ctx,
+                                      prim,
+                                      node->prim_count,
+                                      NULL,
+                                      GL_TRUE,
+                                      first_vertex,
+                                      first_vertex + node->count - 1,
+                                      NULL, 0, NULL);
+      }
+      else if (node->count > 0) {
          vbo_context(ctx)->draw_prims(ctx, 
                                       node->prim,
                                       node->prim_count,
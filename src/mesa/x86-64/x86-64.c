@@ -32,6 +32,7 @@
 
 #include "main/glheader.h"
 #include "main/context.h"
+#include "main/cpuinfo.h"
 #include "math/m_xform.h"
 #include "tnl/t_context.h"
 #include "x86-64.h"
@@ -108,7 +109,13 @@ void _mesa_init_all_x86_64_transform_asm(void)
 
    }
 
-   
+#ifdef USE_AVX2
+   if (cpu_has_avx2) {
+      message("AVX2 detected\n");
+      _mesa_init_x86_64_avx2_transform();
+   }
+#endif
+
 #ifdef DEBUG_MATH
    _math_test_all_transform_functions("x86_64");
    _math_test_all_cliptest_functions("x86_64");
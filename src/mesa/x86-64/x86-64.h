@@ -28,4 +28,6 @@
 
 extern void _mesa_init_all_x86_64_transform_asm( void );
 
+extern void _mesa_init_x86_64_avx2_transform( void );
+
 #endif
@@ -0,0 +1,529 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file xform_avx2.c
+ *
+ * AVX2 versions of the most common vertex transform, normal transform and
+ * clip test functions of src/mesa/math.
+ *
+ * Eight vertices are done at a time: their components are gathered into
+ * one register each, so that the arithmetic is the same as that of the C
+ * code for one vertex, and the results are transposed back to the usual
+ * 4-float layout.  The additions and multiplications are done in the same
+ * order as in m_xform_tmp.h, m_norm_tmp.h and m_clip_tmp.h, without fused
+ * multiply-adds, so the results are exactly the same.  The last few
+ * vertices are done one at a time.
+ */
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+#include "c99_math.h"
+#include "main/glheader.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "math/m_matrix.h"
+#include "math/m_vector.h"
+#include "math/m_xform.h"
+#include "x86-64.h"
+
+
+/** Byte offsets of 8 consecutive vertices */
+static inline __m256i
+vertex_offsets(GLuint stride)
+{
+   return _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+                             _mm256_set1_epi32(stride));
+}
+
+/** Component 'c' of 8 vertices */
+static inline __m256
+gather(const GLfloat *from, __m256i offsets, int c)
+{
+   return _mm256_i32gather_ps(from + c, offsets, 1);
+}
+
+/** a * x + b * y + c * z, in that order */
+static inline __m256
+dot3(__m256 a, __m256 x, __m256 b, __m256 y, __m256 c, __m256 z)
+{
+   return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, x),
+                                      _mm256_mul_ps(b, y)),
+                        _mm256_mul_ps(c, z));
+}
+
+/**
+ * Transposes the x, y, z and w components of 8 vertices and stores them
+ * as 8 4-float vectors.  With 'xyz_only', the 4th float of each vector is
+ * left untouched.
+ */
+static inline void
+store_vertices(GLfloat (*to)[4], __m256 x, __m256 y, __m256 z, __m256 w,
+               GLboolean xyz_only)
+{
+   const __m256 xy_lo = _mm256_unpacklo_ps(x, y); /* x0 y0 x1 y1 | x4 ... */
+   const __m256 xy_hi = _mm256_unpackhi_ps(x, y); /* x2 y2 x3 y3 | x6 ... */
+   const __m256 zw_lo = _mm256_unpacklo_ps(z, w);
+   const __m256 zw_hi = _mm256_unpackhi_ps(z, w);
+   const __m256 v04 = _mm256_shuffle_ps(xy_lo, zw_lo, _MM_SHUFFLE(1, 0, 1, 0));
+   const __m256 v15 = _mm256_shuffle_ps(xy_lo, zw_lo, _MM_SHUFFLE(3, 2, 3, 2));
+   const __m256 v26 = _mm256_shuffle_ps(xy_hi, zw_hi, _MM_SHUFFLE(1, 0, 1, 0));
+   const __m256 v37 = _mm256_shuffle_ps(xy_hi, zw_hi, _MM_SHUFFLE(3, 2, 3, 2));
+   const __m256 v01 = _mm256_permute2f128_ps(v04, v15, 0x20);
+   const __m256 v23 = _mm256_permute2f128_ps(v26, v37, 0x20);
+   const __m256 v45 = _mm256_permute2f128_ps(v04, v15, 0x31);
+   const __m256 v67 = _mm256_permute2f128_ps(v26, v37, 0x31);
+
+   if (xyz_only) {
+      const __m256i xyz = _mm256_setr_epi32(-1, -1, -1, 0, -1, -1, -1, 0);
+      _mm256_maskstore_ps(to[0], xyz, v01);
+      _mm256_maskstore_ps(to[2], xyz, v23);
+      _mm256_maskstore_ps(to[4], xyz, v45);
+      _mm256_maskstore_ps(to[6], xyz, v67);
+   }
+   else {
+      _mm256_storeu_ps(to[0], v01);
+      _mm256_storeu_ps(to[2], v23);
+      _mm256_storeu_ps(to[4], v45);
+      _mm256_storeu_ps(to[6], v67);
+   }
+}
+
+
+/**
+ * Transforms 3 or 4 component points by a general or a 3D matrix, like
+ * the transform_points[34]_{general,3d}() functions of m_xform_tmp.h.
+ */
+static inline void
+transform_points(GLvector4f *to_vec, const GLfloat m[16],
+                 const GLvector4f *from_vec, GLuint size, GLboolean is_3d)
+{
+   const GLuint stride = from_vec->stride;
+   const GLfloat *from = from_vec->start;
+   GLfloat (*to)[4] = (GLfloat (*)[4]) to_vec->start;
+   const GLuint count = from_vec->count;
+   const GLuint rows = is_3d ? 3 : 4;
+   GLuint i, j;
+
+   if (count >= 8) {
+      const __m256i offsets = vertex_offsets(stride);
+      __m256 mv[16];
+
+      for (j = 0; j < 16; j++)
+         mv[j] = _mm256_set1_ps(m[j]);
+
+      for (i = 0; i + 8 <= count; i += 8) {
+         const __m256 ox = gather(from, offsets, 0);
+         const __m256 oy = gather(from, offsets, 1);
+         const __m256 oz = gather(from, offsets, 2);
+         __m256 c[4];
+
+         if (size == 4) {
+            const __m256 ow = gather(from, offsets, 3);
+            for (j = 0; j < rows; j++)
+               c[j] = _mm256_add_ps(dot3(mv[j], ox, mv[j + 4], oy,
+                                         mv[j + 8], oz),
+                                    _mm256_mul_ps(mv[j + 12], ow));
+            if (is_3d)
+               c[3] = ow;
+         }
+         else {
+            for (j = 0; j < rows; j++)
+               c[j] = _mm256_add_ps(dot3(mv[j], ox, mv[j + 4], oy,
+                                         mv[j + 8], oz),
+                                    mv[j + 12]);
+            if (is_3d)
+               c[3] = _mm256_setzero_ps();
+         }
+
+         store_vertices(to + i, c[0], c[1], c[2], c[3],
+                        is_3d && size == 3);
+         STRIDE_F(from, 8 * stride);
+      }
+   }
+   else {
+      i = 0;
+   }
+
+   for (; i < count; i++, STRIDE_F(from, stride)) {
+      const GLfloat ox = from[0], oy = from[1], oz = from[2];
+      const GLfloat ow = size == 4 ? from[3] : 1.0F;
+
+      for (j = 0; j < rows; j++) {
+         if (size == 4)
+            to[i][j] = m[j] * ox + m[j + 4] * oy + m[j + 8] * oz
+                     + m[j + 12] * ow;
+         else
+            to[i][j] = m[j] * ox + m[j + 4] * oy + m[j + 8] * oz + m[j + 12];
+      }
+      if (is_3d && size == 4)
+         to[i][3] = ow;
+   }
+
+   if (is_3d && size == 3) {
+      to_vec->size = 3;
+      to_vec->flags |= VEC_SIZE_3;
+   }
+   else {
+      to_vec->size = 4;
+      to_vec->flags |= VEC_SIZE_4;
+   }
+   to_vec->count = from_vec->count;
+}
+
+
+static void
+transform_points3_general_avx2(GLvector4f *to_vec, const GLfloat m[16],
+                               const GLvector4f *from_vec)
+{
+   transform_points(to_vec, m, from_vec, 3, GL_FALSE);
+}
+
+static void
+transform_points3_3d_avx2(GLvector4f *to_vec, const GLfloat m[16],
+                          const GLvector4f *from_vec)
+{
+   transform_points(to_vec, m, from_vec, 3, GL_TRUE);
+}
+
+static void
+transform_points4_general_avx2(GLvector4f *to_vec, const GLfloat m[16],
+                               const GLvector4f *from_vec)
+{
+   transform_points(to_vec, m, from_vec, 4, GL_FALSE);
+}
+
+static void
+transform_points4_3d_avx2(GLvector4f *to_vec, const GLfloat m[16],
+                          const GLvector4f *from_vec)
+{
+   transform_points(to_vec, m, from_vec, 4, GL_TRUE);
+}
+
+
+/**
+ * Transforms normals by the inverse of the modelview matrix and then
+ * rescales or normalizes them according to 'mode', like
+ * transform_normals(), transform_rescale_normals() and
+ * transform_normalize_normals() of m_norm_tmp.h.
+ */
+static inline void
+transform_normals(const GLmatrix *mat, GLfloat scale, const GLvector4f *in,
+                  const GLfloat *lengths, GLvector4f *dest, GLuint mode)
+{
+   GLfloat (*out)[4] = (GLfloat (*)[4]) dest->start;
+   const GLfloat *from = in->start;
+   const GLuint stride = in->stride;
+   const GLuint count = in->count;
+   const GLboolean normalize = mode == NORM_NORMALIZE && !lengths;
+   const GLboolean use_lengths = mode == NORM_NORMALIZE && lengths;
+   GLfloat m[11];
+   GLuint i, j;
+
+   for (j = 0; j < 11; j++) {
+      m[j] = mat->inv[j];
+      if (mode == NORM_RESCALE || (use_lengths && scale != 1.0F))
+         m[j] *= scale;
+   }
+
+   if (count >= 8) {
+      const __m256i offsets = vertex_offsets(stride);
+      const __m256 min_len = _mm256_set1_ps(1e-20F);
+      const __m256 one = _mm256_set1_ps(1.0F);
+      __m256 mv[11];
+
+      for (j = 0; j < 11; j++)
+         mv[j] = _mm256_set1_ps(m[j]);
+
+      for (i = 0; i + 8 <= count; i += 8) {
+         const __m256 ux = gather(from, offsets, 0);
+         const __m256 uy = gather(from, offsets, 1);
+         const __m256 uz = gather(from, offsets, 2);
+         __m256 tx = dot3(ux, mv[0], uy, mv[1], uz, mv[2]);
+         __m256 ty = dot3(ux, mv[4], uy, mv[5], uz, mv[6]);
+         __m256 tz = dot3(ux, mv[8], uy, mv[9], uz, mv[10]);
+
+         if (normalize) {
+            const __m256 len = dot3(tx, tx, ty, ty, tz, tz);
+            const __m256 s = _mm256_div_ps(one, _mm256_sqrt_ps(len));
+            /* too short normals become the zero vector */
+            const __m256 ok = _mm256_cmp_ps(len, min_len, _CMP_GT_OQ);
+            tx = _mm256_and_ps(_mm256_mul_ps(tx, s), ok);
+            ty = _mm256_and_ps(_mm256_mul_ps(ty, s), ok);
+            tz = _mm256_and_ps(_mm256_mul_ps(tz, s), ok);
+         }
+         else if (use_lengths) {
+            const __m256 len = _mm256_loadu_ps(lengths + i);
+            tx = _mm256_mul_ps(tx, len);
+            ty = _mm256_mul_ps(ty, len);
+            tz = _mm256_mul_ps(tz, len);
+         }
+
+         store_vertices(out + i, tx, ty, tz, _mm256_setzero_ps(), GL_TRUE);
+         STRIDE_F(from, 8 * stride);
+      }
+   }
+   else {
+      i = 0;
+   }
+
+   for (; i < count; i++, STRIDE_F(from, stride)) {
+      const GLfloat ux = from[0], uy = from[1], uz = from[2];
+      GLfloat tx = ux * m[0] + uy * m[1] + uz * m[2];
+      GLfloat ty = ux * m[4] + uy * m[5] + uz * m[6];
+      GLfloat tz = ux * m[8] + uy * m[9] + uz * m[10];
+
+      if (normalize) {
+         const GLfloat len = tx * tx + ty * ty + tz * tz;
+         if (len > 1e-20F) {
+            const GLfloat s = 1.0F / sqrtf(len);
+            tx *= s;
+            ty *= s;
+            tz *= s;
+         }
+         else {
+            tx = ty = tz = 0;
+         }
+      }
+      else if (use_lengths) {
+         tx *= lengths[i];
+         ty *= lengths[i];
+         tz *= lengths[i];
+      }
+      out[i][0] = tx;
+      out[i][1] = ty;
+      out[i][2] = tz;
+   }
+
+   dest->count = in->count;
+}
+
+
+static void
+transform_normals_avx2(const GLmatrix *mat, GLfloat scale,
+                       const GLvector4f *in, const GLfloat *lengths,
+                       GLvector4f *dest)
+{
+   transform_normals(mat, scale, in, lengths, dest, 0);
+}
+
+static void
+transform_rescale_normals_avx2(const GLmatrix *mat, GLfloat scale,
+                               const GLvector4f *in, const GLfloat *lengths,
+                               GLvector4f *dest)
+{
+   transform_normals(mat, scale, in, lengths, dest, NORM_RESCALE);
+}
+
+static void
+transform_normalize_normals_avx2(const GLmatrix *mat, GLfloat scale,
+                                 const GLvector4f *in, const GLfloat *lengths,
+                                 GLvector4f *dest)
+{
+   transform_normals(mat, scale, in, lengths, dest, NORM_NORMALIZE);
+}
+
+
+/**
+ * Computes the clip mask of 4 component clip coordinates and, with
+ * 'project', the projected coordinates, like cliptest_points4() and
+ * cliptest_np_points4() of m_clip_tmp.h.
+ */
+static inline void
+cliptest_points4(GLvector4f *clip_vec, GLvector4f *proj_vec,
+                 GLubyte clipMask[], GLubyte *orMask, GLubyte *andMask,
+                 GLboolean viewport_z_clip, GLboolean project)
+{
+   const GLuint stride = clip_vec->stride;
+   const GLfloat *from = (GLfloat *) clip_vec->start;
+   const GLuint count = clip_vec->count;
+   GLfloat (*vProj)[4] = (GLfloat (*)[4]) proj_vec->start;
+   GLuint c = 0;
+   GLubyte tmpAndMask = *andMask;
+   GLubyte tmpOrMask = *orMask;
+   GLuint i;
+
+   if (count >= 8) {
+      const __m256i offsets = vertex_offsets(stride);
+      const __m256 zero = _mm256_setzero_ps();
+      const __m256 one = _mm256_set1_ps(1.0F);
+      const __m256i bits[6] = {
+         _mm256_set1_epi32(CLIP_RIGHT_BIT),
+         _mm256_set1_epi32(CLIP_LEFT_BIT),
+         _mm256_set1_epi32(CLIP_TOP_BIT),
+         _mm256_set1_epi32(CLIP_BOTTOM_BIT),
+         _mm256_set1_epi32(CLIP_FAR_BIT),
+         _mm256_set1_epi32(CLIP_NEAR_BIT),
+      };
+      const int planes = viewport_z_clip ? 6 : 4;
+      __m256i vand = _mm256_set1_epi32(0xff);
+      __m256i vor = _mm256_setzero_si256();
+
+      for (i = 0; i + 8 <= count; i += 8) {
+         const __m256 cw = gather(from, offsets, 3);
+         __m256 cv[3];
+         __m256i mask = _mm256_setzero_si256();
+         __m256i clipped;
+         __m128i mask16;
+         int p;
+
+         cv[0] = gather(from, offsets, 0);
+         cv[1] = gather(from, offsets, 1);
+         cv[2] = gather(from, offsets, 2);
+
+         /* -c + w < 0 and c + w < 0 for each plane */
+         for (p = 0; p < planes; p++) {
+            const __m256 d = (p & 1) ? _mm256_add_ps(cv[p / 2], cw)
+                                     : _mm256_sub_ps(cw, cv[p / 2]);
+            const __m256i out =
+               _mm256_castps_si256(_mm256_cmp_ps(d, zero, _CMP_LT_OQ));
+            mask = _mm256_or_si256(mask, _mm256_and_si256(out, bits[p]));
+         }
+
+         clipped = _mm256_cmpgt_epi32(mask, _mm256_setzero_si256());
+         c += _mesa_bitcount(_mm256_movemask_ps(_mm256_castsi256_ps(clipped)));
+         vor = _mm256_or_si256(vor, mask);
+         vand = _mm256_and_si256(vand, _mm256_or_si256(mask,
+                                   _mm256_andnot_si256(clipped,
+                                      _mm256_set1_epi32(0xff))));
+
+         mask16 = _mm_packus_epi32(_mm256_castsi256_si128(mask),
+                                   _mm256_extracti128_si256(mask, 1));
+         _mm_storel_epi64((__m128i *) (clipMask + i),
+                          _mm_packus_epi16(mask16, mask16));
+
+         if (project) {
+            const __m256 keep = _mm256_castsi256_ps(clipped);
+            const __m256 oow = _mm256_div_ps(one, cw);
+
+            store_vertices(vProj + i,
+                           _mm256_andnot_ps(keep, _mm256_mul_ps(cv[0], oow)),
+                           _mm256_andnot_ps(keep, _mm256_mul_ps(cv[1], oow)),
+                           _mm256_andnot_ps(keep, _mm256_mul_ps(cv[2], oow)),
+                           _mm256_blendv_ps(oow, one, keep), GL_FALSE);
+         }
+         STRIDE_F(from, 8 * stride);
+      }
+
+      {
+         GLuint or_lanes[8], and_lanes[8];
+         int l;
+
+         _mm256_storeu_si256((__m256i *) or_lanes, vor);
+         _mm256_storeu_si256((__m256i *) and_lanes, vand);
+         for (l = 0; l < 8; l++) {
+            tmpOrMask |= or_lanes[l];
+            tmpAndMask &= and_lanes[l];
+         }
+      }
+   }
+   else {
+      i = 0;
+   }
+
+   for (; i < count; i++, STRIDE_F(from, stride)) {
+      const GLfloat cx = from[0];
+      const GLfloat cy = from[1];
+      const GLfloat cz = from[2];
+      const GLfloat cw = from[3];
+      GLubyte mask = 0;
+      if (-cx + cw < 0) mask |= CLIP_RIGHT_BIT;
+      if ( cx + cw < 0) mask |= CLIP_LEFT_BIT;
+      if (-cy + cw < 0) mask |= CLIP_TOP_BIT;
+      if ( cy + cw < 0) mask |= CLIP_BOTTOM_BIT;
+      if (viewport_z_clip) {
+         if (-cz + cw < 0) mask |= CLIP_FAR_BIT;
+         if ( cz + cw < 0) mask |= CLIP_NEAR_BIT;
+      }
+
+      clipMask[i] = mask;
+      if (mask) {
+         c++;
+         tmpAndMask &= mask;
+         tmpOrMask |= mask;
+         if (project) {
+            vProj[i][0] = 0;
+            vProj[i][1] = 0;
+            vProj[i][2] = 0;
+            vProj[i][3] = 1;
+         }
+      }
+      else if (project) {
+         GLfloat oow = 1.0F / cw;
+         vProj[i][0] = cx * oow;
+         vProj[i][1] = cy * oow;
+         vProj[i][2] = cz * oow;
+         vProj[i][3] = oow;
+      }
+   }
+
+   *orMask = tmpOrMask;
+   *andMask = (GLubyte) (c < count ? 0 : tmpAndMask);
+}
+
+
+static GLvector4f *
+cliptest_points4_avx2(GLvector4f *clip_vec, GLvector4f *proj_vec,
+                      GLubyte clipMask[], GLubyte *orMask, GLubyte *andMask,
+                      GLboolean viewport_z_clip)
+{
+   cliptest_points4(clip_vec, proj_vec, clipMask, orMask, andMask,
+                    viewport_z_clip, GL_TRUE);
+
+   proj_vec->flags |= VEC_SIZE_4;
+   proj_vec->size = 4;
+   proj_vec->count = clip_vec->count;
+   return proj_vec;
+}
+
+static GLvector4f *
+cliptest_np_points4_avx2(GLvector4f *clip_vec, GLvector4f *proj_vec,
+                         GLubyte clipMask[], GLubyte *orMask,
+                         GLubyte *andMask, GLboolean viewport_z_clip)
+{
+   cliptest_points4(clip_vec, proj_vec, clipMask, orMask, andMask,
+                    viewport_z_clip, GL_FALSE);
+   return clip_vec;
+}
+
+
+void
+_mesa_init_x86_64_avx2_transform(void)
+{
+   _mesa_transform_tab[3][MATRIX_GENERAL] = transform_points3_general_avx2;
+   _mesa_transform_tab[3][MATRIX_3D] = transform_points3_3d_avx2;
+   _mesa_transform_tab[4][MATRIX_GENERAL] = transform_points4_general_avx2;
+   _mesa_transform_tab[4][MATRIX_3D] = transform_points4_3d_avx2;
+
+   _mesa_normal_tab[NORM_TRANSFORM] = transform_normals_avx2;
+   _mesa_normal_tab[NORM_TRANSFORM | NORM_RESCALE] =
+      transform_rescale_normals_avx2;
+   _mesa_normal_tab[NORM_TRANSFORM | NORM_NORMALIZE] =
+      transform_normalize_normals_avx2;
+
+   _mesa_clip_tab[4] = cliptest_points4_avx2;
+   _mesa_clip_np_tab[4] = cliptest_np_points4_avx2;
+}
+
+#endif /* __AVX2__ */
@@ -55,6 +55,12 @@
 #elif !defined(bit_SSE4_1) && !defined(bit_SSE41)
 #define bit_SSE4_1 0x00080000
 #endif
+#ifndef bit_OSXSAVE
+#define bit_OSXSAVE 0x08000000
+#endif
+#ifndef bit_AVX2
+#define bit_AVX2 0x00000020
+#endif
 #endif
 
 #include "main/imports.h"
@@ -354,6 +360,20 @@ _mesa_get_x86_features(void)
 
       if (ecx & bit_SSE4_1)
          _mesa_x86_cpu_features |= X86_FEATURE_SSE4_1;
+
+      /* AVX2 also needs the OS to save the YMM registers on context
+       * switches, which XCR0 tells.
+       */
+      if ((ecx & bit_OSXSAVE) && __get_cpuid_max(0, NULL) >= 7) {
+         unsigned int xcr0_lo, xcr0_hi;
+
+         __asm__ ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+         if ((xcr0_lo & 0x6) == 0x6) {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            if (ebx & bit_AVX2)
+               _mesa_x86_cpu_features |= X86_FEATURE_AVX2;
+         }
+      }
    }
 #endif /* USE_X86_64_ASM */
 
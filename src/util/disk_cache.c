@@ -0,0 +1,778 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifdef ENABLE_SHADER_CACHE
+
+#include <ctype.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/file.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <errno.h>
+#include <dirent.h>
+
+#include "util/u_atomic.h"
+#include "util/mesa-sha1.h"
+#include "util/ralloc.h"
+#include "util/u_queue.h"
+
+#include "disk_cache.h"
+
+/* Number of bits to mask off from a cache key to get an index. */
+#define CACHE_INDEX_KEY_BITS 16
+
+/* Mask for computing an index from a key. */
+#define CACHE_INDEX_KEY_MASK ((1 << CACHE_INDEX_KEY_BITS) - 1)
+
+/* The number of keys that can be stored in the index. */
+#define CACHE_INDEX_MAX_KEYS (1 << CACHE_INDEX_KEY_BITS)
+
+/* When evicting, shrink the cache to this fraction of its maximum size so
+ * that a cache sitting at its limit doesn't rescan the directory on every
+ * single put.
+ */
+#define CACHE_EVICT_TARGET_NUM 9
+#define CACHE_EVICT_TARGET_DEN 10
+
+/* Number of writes that can be pending before disk_cache_put() blocks. */
+#define CACHE_MAX_QUEUED_WRITES 32
+
+struct disk_cache {
+   /* The path that contains the cache. */
+   char *path;
+
+   /* A pointer to the mmapped index file within the cache directory. */
+   uint8_t *index_mmap;
+   size_t index_mmap_size;
+
+   /* Pointer to total size of all objects in cache (within index_mmap) */
+   uint64_t *size;
+
+   /* Pointer to stored keys, (within index_mmap). */
+   uint8_t *stored_keys;
+
+   /* Maximum size of all cached objects (in bytes). */
+   uint64_t max_size;
+
+   /* Writes the entries put into the cache in the background. */
+   struct util_queue cache_queue;
+};
+
+/* A pending disk_cache_put(), with a copy of the data. */
+struct cache_put_job {
+   struct disk_cache *cache;
+   cache_key key;
+   size_t size;
+   uint8_t data[];
+};
+
+/* Create a directory named 'path' if it does not already exist.
+ *
+ * Returns: 0 if path already exists as a directory or if created.
+ *         -1 in all other cases.
+ */
+static int
+mkdir_if_needed(const char *path)
+{
+   struct stat sb;
+
+   /* If the path exists already, then our work is done if it's a
+    * directory, but it's an error if it is not.
+    */
+   if (stat(path, &sb) == 0) {
+      if (S_ISDIR(sb.st_mode)) {
+         return 0;
+      } else {
+         fprintf(stderr, "Cannot use %s for shader cache (not a directory)"
+                         "---disabling.\n", path);
+         return -1;
+      }
+   }
+
+   int ret = mkdir(path, 0755);
+   if (ret == 0 || (ret == -1 && errno == EEXIST))
+     return 0;
+
+   fprintf(stderr, "Failed to create %s for shader cache (%s)---disabling.\n",
+           path, strerror(errno));
+
+   return -1;
+}
+
+/* Concatenate an existing path and a new name to form a new path.  If the new
+ * path does not exist as a directory, create it then return the resulting
+ * name of the new path (ralloc'ed off of 'ctx').
+ *
+ * Returns NULL on any error, such as:
+ *
+ *      <path> does not exist or is not a directory
+ *      <path>/<name> exists but is not a directory
+ *      <path>/<name> cannot be created as a directory
+ */
+static char *
+concatenate_and_mkdir(void *ctx, const char *path, const char *name)
+{
+   char *new_path;
+   struct stat sb;
+
+   if (stat(path, &sb) != 0 || ! S_ISDIR(sb.st_mode))
+      return NULL;
+
+   new_path = ralloc_asprintf(ctx, "%s/%s", path, name);
+
+   if (mkdir_if_needed(new_path) == 0)
+      return new_path;
+   else
+      return NULL;
+}
+
+/* Parse a size such as "512K", "64M" or "1G" into a byte count. A bare number
+ * is interpreted as gigabytes to match the common case of a large cache.
+ */
+static uint64_t
+parse_max_size(const char *str)
+{
+   char *end;
+   uint64_t size = strtoul(str, &end, 10);
+
+   if (end == str)
+      return 0;
+
+   switch (*end) {
+   case 'K':
+   case 'k':
+      size *= 1024;
+      break;
+   case 'M':
+   case 'm':
+      size *= 1024*1024;
+      break;
+   case '\0':
+   case 'G':
+   case 'g':
+   default:
+      size *= 1024*1024*1024;
+      break;
+   }
+
+   return size;
+}
+
+struct disk_cache *
+disk_cache_create(void)
+{
+   void *local;
+   struct disk_cache *cache = NULL;
+   char *path, *max_size_str;
+   uint64_t max_size;
+   int fd = -1;
+   struct stat sb;
+   size_t size;
+
+   /* A ralloc context for transient data during this invocation. */
+   local = ralloc_context(NULL);
+   if (local == NULL)
+      goto fail;
+
+   /* At user request, disable shader cache entirely. */
+   if (getenv("MESA_GLSL_CACHE_DISABLE"))
+      goto fail;
+
+   /* Determine path for cache based on the first defined name as follows:
+    *
+    *   $MESA_GLSL_CACHE_DIR
+    *   $XDG_CACHE_HOME/mesa
+    *   <pwd.pw_dir>/.cache/mesa
+    */
+   path = getenv("MESA_GLSL_CACHE_DIR");
+   if (path && mkdir_if_needed(path) == -1) {
+      goto fail;
+   }
+
+   if (path == NULL) {
+      char *xdg_cache_home = getenv("XDG_CACHE_HOME");
+
+      if (xdg_cache_home) {
+         if (mkdir_if_needed(xdg_cache_home) == -1)
+            goto fail;
+
+         path = concatenate_and_mkdir(local, xdg_cache_home, "mesa");
+         if (path == NULL)
+            goto fail;
+      }
+   }
+
+   if (path == NULL) {
+      char *buf;
+      size_t buf_size;
+      struct passwd pwd, *result;
+
+      buf_size = sysconf(_SC_GETPW_R_SIZE_MAX);
+      if (buf_size == -1)
+         buf_size = 512;
+
+      /* Loop until buf_size is large enough to query the directory */
+      while (1) {
+         buf = ralloc_size(local, buf_size);
+
+         getpwuid_r(getuid(), &pwd, buf, buf_size, &result);
+         if (result)
+            break;
+
+         if (errno == ERANGE) {
+            ralloc_free(buf);
+            buf = NULL;
+            buf_size *= 2;
+         } else {
+            goto fail;
+         }
+      }
+
+      path = concatenate_and_mkdir(local, pwd.pw_dir, ".cache");
+      if (path == NULL)
+         goto fail;
+
+      path = concatenate_and_mkdir(local, path, "mesa");
+      if (path == NULL)
+         goto fail;
+   }
+
+   cache = ralloc(NULL, struct disk_cache);
+   if (cache == NULL)
+      goto fail;
+
+   cache->path = ralloc_strdup(cache, path);
+   if (cache->path == NULL)
+      goto fail;
+
+   path = ralloc_asprintf(local, "%s/index", cache->path);
+   if (path == NULL)
+      goto fail;
+
+   fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+   if (fd == -1)
+      goto fail;
+
+   if (fstat(fd, &sb) == -1)
+      goto fail;
+
+   /* Force the index file to be the expected size. */
+   size = sizeof(*cache->size) + CACHE_INDEX_MAX_KEYS * CACHE_KEY_SIZE;
+   if (sb.st_size != size) {
+      if (ftruncate(fd, size) == -1)
+         goto fail;
+   }
+
+   /* We map this shared so that other processes see updates that we
+    * make.
+    *
+    * Note: We do use atomic addition to ensure that multiple
+    * processes don't scramble the cache size recorded in the
+    * index. But we don't use any locking to prevent multiple
+    * processes from updating the same entry simultaneously. The idea
+    * is that if either result lands entirely in the index, then
+    * that's equivalent to a well-ordered write followed by an
+    * eviction and a write. On the other hand, if the simultaneous
+    * writes result in a corrupt entry, that's not really any
+    * different than both entries being evicted, (since within the
+    * guarantees of the cryptographic hash, a corrupt entry is
+    * unlikely to ever match a real cache key).
+    */
+   cache->index_mmap = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+   if (cache->index_mmap == MAP_FAILED)
+      goto fail;
+   cache->index_mmap_size = size;
+
+   close(fd);
+   fd = -1;
+
+   cache->size = (uint64_t *) cache->index_mmap;
+   cache->stored_keys = cache->index_mmap + sizeof(uint64_t);
+
+   max_size = 0;
+
+   max_size_str = getenv("MESA_GLSL_CACHE_MAX_SIZE");
+   if (max_size_str)
+      max_size = parse_max_size(max_size_str);
+
+   /* Default to 1GB for maximum cache size. */
+   if (max_size == 0)
+      max_size = 1024*1024*1024;
+
+   cache->max_size = max_size;
+
+   /* If the thread can't be started, entries are written synchronously. */
+   util_queue_init(&cache->cache_queue, "disk_cache", CACHE_MAX_QUEUED_WRITES,
+                   1);
+
+   ralloc_free(local);
+
+   return cache;
+
+ fail:
+   if (fd != -1)
+      close(fd);
+   if (cache)
+      ralloc_free(cache);
+   ralloc_free(local);
+
+   return NULL;
+}
+
+void
+disk_cache_destroy(struct disk_cache *cache)
+{
+   if (cache == NULL)
+      return;
+
+   if (util_queue_is_initialized(&cache->cache_queue)) {
+      util_queue_finish(&cache->cache_queue);
+      util_queue_destroy(&cache->cache_queue);
+   }
+
+   munmap(cache->index_mmap, cache->index_mmap_size);
+
+   ralloc_free(cache);
+}
+
+/* Return a filename within the cache's directory corresponding to 'key'. The
+ * returned filename is ralloced without a parent context, as 'cache' is
+ * shared with the write thread.
+ *
+ * Returns NULL if out of memory.
+ */
+static char *
+get_cache_file(struct disk_cache *cache, const cache_key key)
+{
+   char buf[41];
+
+   _mesa_sha1_format(buf, key);
+
+   return ralloc_asprintf(NULL, "%s/%c%c/%s",
+                          cache->path, buf[0], buf[1], buf + 2);
+}
+
+/* Create the directory that will be needed for the cache file for \key.
+ *
+ * Obviously, the implementation here must closely match
+ * get_cache_file above.
+*/
+static void
+make_cache_file_directory(struct disk_cache *cache, const cache_key key)
+{
+   char *dir;
+   char buf[41];
+
+   _mesa_sha1_format(buf, key);
+
+   dir = ralloc_asprintf(NULL, "%s/%c%c", cache->path, buf[0], buf[1]);
+
+   mkdir_if_needed(dir);
+
+   ralloc_free(dir);
+}
+
+/* Return true if the file name is a cache entry, i.e. a 38-character
+ * hexadecimal remainder of a SHA-1 (this skips index and temporary files).
+ */
+static bool
+is_cache_entry_name(const char *name)
+{
+   unsigned i;
+
+   for (i = 0; name[i]; i++) {
+      if (!isxdigit((unsigned char) name[i]))
+         return false;
+   }
+
+   return i == 2 * CACHE_KEY_SIZE - 2;
+}
+
+struct cache_entry_info {
+   char *path;
+   time_t mtime;
+   uint64_t size;
+};
+
+static int
+compare_entry_mtime(const void *a, const void *b)
+{
+   const struct cache_entry_info *ea = a, *eb = b;
+
+   if (ea->mtime < eb->mtime)
+      return -1;
+   if (ea->mtime > eb->mtime)
+      return 1;
+   return 0;
+}
+
+/* Evict the least recently used entries until the cache, plus \needed bytes,
+ * fits within a fraction of its maximum size.
+ *
+ * Recency is tracked through the modification time of each entry, which
+ * disk_cache_get() refreshes on every hit. Access times are not used as many
+ * systems mount with noatime.
+ */
+static void
+evict_lru_entries(struct disk_cache *cache, uint64_t needed)
+{
+   void *local = ralloc_context(NULL);
+   struct cache_entry_info *entries = NULL;
+   unsigned num_entries = 0, max_entries = 0;
+   uint64_t target, total;
+   unsigned i;
+   DIR *top;
+   struct dirent *sub;
+
+   if (local == NULL)
+      return;
+
+   top = opendir(cache->path);
+   if (top == NULL)
+      goto done;
+
+   while ((sub = readdir(top)) != NULL) {
+      char *dir_path;
+      DIR *dir;
+      struct dirent *entry;
+
+      if (strlen(sub->d_name) != 2 ||
+          !isxdigit((unsigned char) sub->d_name[0]) ||
+          !isxdigit((unsigned char) sub->d_name[1]))
+         continue;
+
+      dir_path = ralloc_asprintf(local, "%s/%s", cache->path, sub->d_name);
+      dir = opendir(dir_path);
+      if (dir == NULL)
+         continue;
+
+      while ((entry = readdir(dir)) != NULL) {
+         struct stat sb;
+         char *entry_path;
+
+         if (!is_cache_entry_name(entry->d_name))
+            continue;
+
+         entry_path = ralloc_asprintf(local, "%s/%s", dir_path,
+                                      entry->d_name);
+         if (stat(entry_path, &sb) != 0 || !S_ISREG(sb.st_mode))
+            continue;
+
+         if (num_entries == max_entries) {
+            max_entries = max_entries ? max_entries * 2 : 256;
+            entries = reralloc(local, entries, struct cache_entry_info,
+                               max_entries);
+            if (entries == NULL) {
+               closedir(dir);
+               closedir(top);
+               goto done;
+            }
+         }
+
+         entries[num_entries].path = entry_path;
+         entries[num_entries].mtime = sb.st_mtime;
+         entries[num_entries].size = (uint64_t) sb.st_blocks * 512;
+         num_entries++;
+      }
+
+      closedir(dir);
+   }
+
+   closedir(top);
+
+   qsort(entries, num_entries, sizeof(*entries), compare_entry_mtime);
+
+   target = cache->max_size / CACHE_EVICT_TARGET_DEN * CACHE_EVICT_TARGET_NUM;
+   total = *cache->size;
+
+   for (i = 0; i < num_entries && total + needed > target; i++) {
+      if (unlink(entries[i].path) != 0)
+         continue;
+
+      p_atomic_add(cache->size, - (int64_t) entries[i].size);
+      total = total > entries[i].size ? total - entries[i].size : 0;
+   }
+
+ done:
+   ralloc_free(local);
+}
+
+void
+disk_cache_remove(struct disk_cache *cache, const cache_key key)
+{
+   struct stat sb;
+
+   char *filename = get_cache_file(cache, key);
+   if (filename == NULL) {
+      return;
+   }
+
+   if (stat(filename, &sb) == -1) {
+      ralloc_free(filename);
+      return;
+   }
+
+   if (unlink(filename) == 0)
+      p_atomic_add(cache->size, - (int64_t) sb.st_blocks * 512);
+
+   ralloc_free(filename);
+}
+
+static void
+write_cache_entry(struct disk_cache *cache,
+                  const cache_key key,
+                  const void *data,
+                  size_t size)
+{
+   int fd = -1, fd_final = -1, err, ret;
+   size_t len;
+   char *filename = NULL, *filename_tmp = NULL;
+   const char *p = data;
+   struct stat sb;
+
+   filename = get_cache_file(cache, key);
+   if (filename == NULL)
+      goto done;
+
+   /* Write to a temporary file to allow for an atomic rename to the
+    * final destination filename, (to prevent any readers from seeing
+    * a partially written file).
+    */
+   filename_tmp = ralloc_asprintf(NULL, "%s.tmp", filename);
+   if (filename_tmp == NULL)
+      goto done;
+
+   fd = open(filename_tmp, O_WRONLY | O_CLOEXEC | O_CREAT, 0644);
+
+   /* Make the two-character subdirectory within the cache as needed. */
+   if (fd == -1) {
+      if (errno != ENOENT)
+         goto done;
+
+      make_cache_file_directory(cache, key);
+
+      fd = open(filename_tmp, O_WRONLY | O_CLOEXEC | O_CREAT, 0644);
+      if (fd == -1)
+         goto done;
+   }
+
+   /* With the temporary file open, we take an exclusive flock on
+    * it. If the flock fails, then another process still has the file
+    * open with the flock held. So just let that file be responsible
+    * for writing the file.
+    */
+   err = flock(fd, LOCK_EX | LOCK_NB);
+   if (err == -1)
+      goto done;
+
+   /* Now that we have the lock on the open temporary file, we can
+    * check to see if the destination file already exists. If so,
+    * another process won the race between when we saw that the file
+    * didn't exist and now. In this case, we don't do anything more,
+    * (to ensure the size accounting of the cache doesn't get off).
+    */
+   fd_final = open(filename, O_RDONLY | O_CLOEXEC);
+   if (fd_final != -1)
+      goto done;
+
+   /* OK, we're now on the hook to write out a file that we know is
+    * not in the cache, and is also not being written out to the cache
+    * by some other process.
+    *
+    * Before we do that, if the cache is too large, evict the least
+    * recently used items to make room.
+    */
+   if (*cache->size + size > cache->max_size)
+      evict_lru_entries(cache, size);
+
+   /* Now, finally, write out the contents to the temporary file, then
+    * rename them atomically to the destination filename, and also
+    * perform an atomic increment of the total cache size.
+    */
+   for (len = 0; len < size; len += ret) {
+      ret = write(fd, p + len, size - len);
+      if (ret == -1) {
+         unlink(filename_tmp);
+         goto done;
+      }
+   }
+
+   rename(filename_tmp, filename);
+
+   if (fstat(fd, &sb) == 0)
+      p_atomic_add(cache->size, (uint64_t) sb.st_blocks * 512);
+
+ done:
+   if (fd_final != -1)
+      close(fd_final);
+   /* This close finally releases the flock, (now that the final file
+    * has been renamed into place and the size has been added).
+    */
+   if (fd != -1)
+      close(fd);
+   if (filename_tmp)
+      ralloc_free(filename_tmp);
+   if (filename)
+      ralloc_free(filename);
+}
+
+static void
+cache_put_job_execute(void *job, int thread_index)
+{
+   struct cache_put_job *put = job;
+
+   write_cache_entry(put->cache, put->key, put->data, put->size);
+   free(put);
+}
+
+void
+disk_cache_put(struct disk_cache *cache,
+          const cache_key key,
+          const void *data,
+          size_t size)
+{
+   struct cache_put_job *put;
+
+   if (util_queue_is_initialized(&cache->cache_queue)) {
+      put = malloc(sizeof(*put) + size);
+      if (put) {
+         put->cache = cache;
+         memcpy(put->key, key, CACHE_KEY_SIZE);
+         put->size = size;
+         memcpy(put->data, data, size);
+
+         util_queue_add_job_with_priority(&cache->cache_queue, put, NULL,
+                                          cache_put_job_execute,
+                                          UTIL_QUEUE_PRIORITY_LOW);
+         return;
+      }
+   }
+
+   write_cache_entry(cache, key, data, size);
+}
+
+void
+disk_cache_wait_for_idle(struct disk_cache *cache)
+{
+   if (util_queue_is_initialized(&cache->cache_queue))
+      util_queue_finish(&cache->cache_queue);
+}
+
+void *
+disk_cache_get(struct disk_cache *cache, const cache_key key, size_t *size)
+{
+   int fd = -1, ret, len;
+   struct stat sb;
+   char *filename = NULL;
+   uint8_t *data = NULL;
+
+   if (size)
+      *size = 0;
+
+   filename = get_cache_file(cache, key);
+   if (filename == NULL)
+      goto fail;
+
+   fd = open(filename, O_RDONLY | O_CLOEXEC);
+   if (fd == -1)
+      goto fail;
+
+   if (fstat(fd, &sb) == -1)
+      goto fail;
+
+   data = malloc(sb.st_size);
+   if (data == NULL)
+      goto fail;
+
+   for (len = 0; len < sb.st_size; len += ret) {
+      ret = read(fd, data + len, sb.st_size - len);
+      if (ret == -1)
+         goto fail;
+      if (ret == 0)
+         break;
+   }
+
+   if (len != sb.st_size)
+      goto fail;
+
+   /* Mark the entry as recently used so that eviction keeps it around. */
+   futimens(fd, NULL);
+
+   ralloc_free(filename);
+   close(fd);
+
+   if (size)
+      *size = sb.st_size;
+
+   return data;
+
+ fail:
+   if (data)
+      free(data);
+   if (filename)
+      ralloc_free(filename);
+   if (fd != -1)
+      close(fd);
+
+   return NULL;
+}
+
+void
+disk_cache_put_key(struct disk_cache *cache, const cache_key key)
+{
+   uint32_t *key_chunk = (uint32_t *) key;
+   int i = *key_chunk & CACHE_INDEX_KEY_MASK;
+   unsigned char *entry;
+
+   entry = &cache->stored_keys[i * CACHE_KEY_SIZE];
+
+   memcpy(entry, key, CACHE_KEY_SIZE);
+}
+
+/* This function lets us test whether a given key was previously
+ * stored in the cache with disk_cache_put_key(). The implement is
+ * efficient by not using syscalls or hitting the disk. It's not
+ * race-free, but the races are benign. If we race with someone else
+ * calling disk_cache_put_key, then that's just an extra cache miss and an
+ * extra recompile.
+ */
+bool
+disk_cache_has_key(struct disk_cache *cache, const cache_key key)
+{
+   uint32_t *key_chunk = (uint32_t *) key;
+   int i = *key_chunk & CACHE_INDEX_KEY_MASK;
+   unsigned char *entry;
+
+   entry = &cache->stored_keys[i * CACHE_KEY_SIZE];
+
+   return memcmp(entry, key, CACHE_KEY_SIZE) == 0;
+}
+
+#endif /* ENABLE_SHADER_CACHE */
@@ -0,0 +1,251 @@
+/*
+ * Copyright © 2014 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* A collection of unit tests for disk_cache.c */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <ftw.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "disk_cache.h"
+
+bool error = false;
+
+static void
+expect_equal(uint64_t actual, uint64_t expected, const char *test)
+{
+   if (actual != expected) {
+      fprintf(stderr, "Error: Test '%s' failed: Expected=%" PRIu64
+              ", Actual=%" PRIu64 "\n", test, expected, actual);
+      error = true;
+   }
+}
+
+static void
+expect_null(void *ptr, const char *test)
+{
+   if (ptr != NULL) {
+      fprintf(stderr, "Error: Test '%s' failed: Result=%p, but expected NULL.\n",
+              test, ptr);
+      error = true;
+   }
+}
+
+static void
+expect_non_null(void *ptr, const char *test)
+{
+   if (ptr == NULL) {
+      fprintf(stderr, "Error: Test '%s' failed: Result=NULL, but expected something else.\n",
+              test);
+      error = true;
+   }
+}
+
+static int
+remove_entry(const char *path,
+             const struct stat *sb,
+             int typeflag,
+             struct FTW *ftwbuf)
+{
+   int err = remove(path);
+
+   if (err)
+      fprintf(stderr, "Error removing %s: %s\n", path, strerror(errno));
+
+   return err;
+}
+
+/* Recursively remove a directory.
+ *
+ * This is equivalent to "rm -rf <dir>" with one bit of protection
+ * that the directory name must begin with "." to ensure we don't
+ * wander around deleting more than intended.
+ *
+ * Returns 0 on success, -1 on any error.
+ */
+static int
+rmrf_local(const char *path)
+{
+   if (path == NULL || *path == '\0' || *path != '.')
+      return -1;
+
+   return nftw(path, remove_entry, 64, FTW_DEPTH | FTW_PHYS | FTW_MOUNT);
+}
+
+#define CACHE_TEST_TMP "./cache-test-tmp"
+
+static void
+test_disk_cache_create(void)
+{
+   struct disk_cache *cache;
+
+   /* Before doing anything else, ensure that with
+    * MESA_GLSL_CACHE_DISABLE set, that disk_cache_create returns NULL.
+    */
+   setenv("MESA_GLSL_CACHE_DISABLE", "1", 1);
+   cache = disk_cache_create();
+   expect_null(cache, "disk_cache_create with MESA_GLSL_CACHE_DISABLE set");
+
+   unsetenv("MESA_GLSL_CACHE_DISABLE");
+
+   rmrf_local(CACHE_TEST_TMP);
+
+   /* A cache directory that cannot be created disables the cache. */
+   setenv("MESA_GLSL_CACHE_DIR", CACHE_TEST_TMP "/no-such-parent/cache", 1);
+   cache = disk_cache_create();
+   expect_null(cache, "disk_cache_create with unreachable MESA_GLSL_CACHE_DIR");
+
+   setenv("MESA_GLSL_CACHE_DIR", CACHE_TEST_TMP, 1);
+   cache = disk_cache_create();
+   expect_non_null(cache, "disk_cache_create with MESA_GLSL_CACHE_DIR set");
+
+   disk_cache_destroy(cache);
+}
+
+static bool
+does_cache_contain(struct disk_cache *cache, const cache_key key)
+{
+   void *result;
+
+   result = disk_cache_get(cache, key, NULL);
+
+   if (result) {
+      free(result);
+      return true;
+   }
+
+   return false;
+}
+
+static void
+test_put_and_get(void)
+{
+   struct disk_cache *cache;
+   char blob[] = "This is a blob of thirty-seven bytes";
+   uint8_t blob_key[20];
+   char string[] = "While this string has thirty-four";
+   uint8_t string_key[20];
+   char *result;
+   size_t size;
+
+   cache = disk_cache_create();
+
+   memset(blob_key, 0x12, sizeof(blob_key));
+   memset(string_key, 0x34, sizeof(string_key));
+
+   /* First test that disk_cache_get returns NULL before anything is added. */
+   result = disk_cache_get(cache, blob_key, &size);
+   expect_null(result, "disk_cache_get with non-existent item (pointer)");
+   expect_equal(size, 0, "disk_cache_get with non-existent item (size)");
+
+   /* Simple test of put and get.  Puts are written in the background, so
+    * wait for them before looking the item up.
+    */
+   disk_cache_put(cache, blob_key, blob, sizeof(blob));
+   disk_cache_wait_for_idle(cache);
+
+   result = disk_cache_get(cache, blob_key, &size);
+   expect_non_null(result, "disk_cache_get of existing item (pointer)");
+   expect_equal(size, sizeof(blob), "disk_cache_get of existing item (size)");
+   if (result)
+      expect_equal(memcmp(result, blob, sizeof(blob)), 0,
+                   "disk_cache_get of existing item (contents)");
+   free(result);
+
+   /* Test put and get of a second item. */
+   disk_cache_put(cache, string_key, string, sizeof(string));
+   disk_cache_wait_for_idle(cache);
+
+   result = disk_cache_get(cache, string_key, &size);
+   expect_non_null(result, "2nd disk_cache_get of existing item (pointer)");
+   expect_equal(size, sizeof(string), "2nd disk_cache_get of existing item (size)");
+   free(result);
+
+   /* Removal only affects the named item. */
+   disk_cache_remove(cache, blob_key);
+   expect_equal(does_cache_contain(cache, blob_key), false,
+                "disk_cache_get after disk_cache_remove");
+   expect_equal(does_cache_contain(cache, string_key), true,
+                "disk_cache_remove leaves other items alone");
+
+   /* Keys recorded with put_key are distinct from stored objects. */
+   expect_equal(disk_cache_has_key(cache, string_key), false,
+                "disk_cache_has_key before disk_cache_put_key");
+   disk_cache_put_key(cache, string_key);
+   expect_equal(disk_cache_has_key(cache, string_key), true,
+                "disk_cache_has_key after disk_cache_put_key");
+
+   disk_cache_destroy(cache);
+
+   /* Set the cache size to 1KB and add an item larger than half of that.
+    * Adding a second such item has to evict the least recently used one.
+    */
+   setenv("MESA_GLSL_CACHE_MAX_SIZE", "1K", 1);
+   cache = disk_cache_create();
+
+   char big[100];
+   uint8_t one_key[20], two_key[20];
+
+   memset(big, 'x', sizeof(big));
+   memset(one_key, 0x56, sizeof(one_key));
+   memset(two_key, 0x78, sizeof(two_key));
+
+   disk_cache_remove(cache, string_key);
+   disk_cache_put(cache, one_key, big, sizeof(big));
+   disk_cache_wait_for_idle(cache);
+   expect_equal(does_cache_contain(cache, one_key), true,
+                "disk_cache_get of item within size limit");
+
+   /* The filesystem reports at least one block per file, so with a limit of
+    * 1KB and two blocks needed only one entry can remain.
+    */
+   disk_cache_put(cache, two_key, big, sizeof(big));
+   disk_cache_wait_for_idle(cache);
+   expect_equal(does_cache_contain(cache, two_key), true,
+                "disk_cache_get of newest item after eviction");
+   expect_equal(does_cache_contain(cache, one_key), false,
+                "disk_cache_get of least recently used item after eviction");
+
+   disk_cache_destroy(cache);
+
+   unsetenv("MESA_GLSL_CACHE_MAX_SIZE");
+}
+
+int
+main(void)
+{
+   test_disk_cache_create();
+
+   test_put_and_get();
+
+   rmrf_local(CACHE_TEST_TMP);
+
+   return error ? 1 : 0;
+}
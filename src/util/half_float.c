@@ -24,9 +24,19 @@
 
 #include <math.h>
 #include <assert.h>
+#include <stdbool.h>
 #include "half_float.h"
 #include "rounding.h"
 
+#if defined(USE_F16C)
+#include <cpuid.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define USE_NEON_HALF
+#endif
+
 typedef union { float f; int32_t i; uint32_t u; } fi_type;
 
 /**
@@ -175,3 +185,159 @@ _mesa_half_to_float(uint16_t val)
    result = fi.f;
    return result;
 }
+
+
+/*
+ * Bulk conversions.
+ *
+ * The hardware conversions round to nearest even, flush nothing and
+ * overflow to infinity like the functions above; only NaNs come out
+ * differently (quieted, with the payload kept), so they are replaced with
+ * the NaNs the functions above return.
+ */
+
+static void
+float_to_half_array_c(uint16_t *dst, const float *src, unsigned n)
+{
+   unsigned i;
+
+   for (i = 0; i < n; i++)
+      dst[i] = _mesa_float_to_half(src[i]);
+}
+
+static void
+half_to_float_array_c(float *dst, const uint16_t *src, unsigned n)
+{
+   unsigned i;
+
+   for (i = 0; i < n; i++)
+      dst[i] = _mesa_half_to_float(src[i]);
+}
+
+#if defined(USE_NEON_HALF)
+
+static void
+float_to_half_array_neon(uint16_t *dst, const float *src, unsigned n)
+{
+   const uint16x4_t sign_mask = vdup_n_u16(0x8000);
+   const uint16x4_t nan = vdup_n_u16(0x7c01);
+   unsigned i = 0;
+
+   for (; i + 4 <= n; i += 4) {
+      const float32x4_t f = vld1q_f32(src + i);
+      const uint16x4_t is_nan = vmovn_u32(vmvnq_u32(vceqq_f32(f, f)));
+      uint16x4_t h = vreinterpret_u16_f16(vcvt_f16_f32(f));
+
+      h = vbsl_u16(is_nan, vorr_u16(vand_u16(h, sign_mask), nan), h);
+      vst1_u16(dst + i, h);
+   }
+
+   float_to_half_array_c(dst + i, src + i, n - i);
+}
+
+static void
+half_to_float_array_neon(float *dst, const uint16_t *src, unsigned n)
+{
+   const uint32x4_t sign_mask = vdupq_n_u32(0x80000000);
+   const uint32x4_t nan = vdupq_n_u32(0x7f800001);
+   unsigned i = 0;
+
+   for (; i + 4 <= n; i += 4) {
+      const float32x4_t f =
+         vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i)));
+      const uint32x4_t is_nan = vmvnq_u32(vceqq_f32(f, f));
+      const uint32x4_t u = vreinterpretq_u32_f32(f);
+
+      vst1q_f32(dst + i, vreinterpretq_f32_u32(
+                   vbslq_u32(is_nan, vorrq_u32(vandq_u32(u, sign_mask), nan),
+                             u)));
+   }
+
+   half_to_float_array_c(dst + i, src + i, n - i);
+}
+
+#endif
+
+#if defined(USE_F16C)
+
+/**
+ * F16C instructions are VEX encoded, so they also need the OS to save the
+ * AVX state.
+ */
+static bool
+cpu_has_f16c(void)
+{
+   unsigned eax, ebx, ecx, edx;
+
+   if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+      return false;
+
+   if (!(ecx & bit_F16C) || !(ecx & bit_AVX) || !(ecx & bit_OSXSAVE))
+      return false;
+
+   __asm__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+   return (eax & 0x6) == 0x6;
+}
+
+#endif
+
+typedef void (*float_to_half_array_func)(uint16_t *, const float *, unsigned);
+typedef void (*half_to_float_array_func)(float *, const uint16_t *, unsigned);
+
+static void
+float_to_half_array_init(uint16_t *dst, const float *src, unsigned n);
+static void
+half_to_float_array_init(float *dst, const uint16_t *src, unsigned n);
+
+/* Start out with functions that pick the implementation for the CPU on the
+ * first call.  Racing threads all store the same pointers.
+ */
+static float_to_half_array_func float_to_half_array =
+   float_to_half_array_init;
+static half_to_float_array_func half_to_float_array =
+   half_to_float_array_init;
+
+static void
+init_array_funcs(void)
+{
+#if defined(USE_F16C)
+   if (cpu_has_f16c()) {
+      half_to_float_array = _mesa_half_to_float_array_f16c;
+      float_to_half_array = _mesa_float_to_half_array_f16c;
+      return;
+   }
+#endif
+#if defined(USE_NEON_HALF)
+   half_to_float_array = half_to_float_array_neon;
+   float_to_half_array = float_to_half_array_neon;
+#else
+   half_to_float_array = half_to_float_array_c;
+   float_to_half_array = float_to_half_array_c;
+#endif
+}
+
+static void
+float_to_half_array_init(uint16_t *dst, const float *src, unsigned n)
+{
+   init_array_funcs();
+   float_to_half_array(dst, src, n);
+}
+
+static void
+half_to_float_array_init(float *dst, const uint16_t *src, unsigned n)
+{
+   init_array_funcs();
+   half_to_float_array(dst, src, n);
+}
+
+void
+_mesa_float_to_half_array(uint16_t *dst, const float *src, unsigned n)
+{
+   float_to_half_array(dst, src, n);
+}
+
+void
+_mesa_half_to_float_array(float *dst, const uint16_t *src, unsigned n)
+{
+   half_to_float_array(dst, src, n);
+}
@@ -34,6 +34,22 @@ extern "C" {
 uint16_t _mesa_float_to_half(float val);
 float _mesa_half_to_float(uint16_t val);
 
+/**
+ * Convert n values at once, with the same results as the functions above
+ * bit for bit.  They use F16C on x86 CPUs that have it and NEON on
+ * AArch64.
+ */
+void _mesa_float_to_half_array(uint16_t *dst, const float *src, unsigned n);
+void _mesa_half_to_float_array(float *dst, const uint16_t *src, unsigned n);
+
+#ifdef USE_F16C
+/* F16C versions of the above, built with -mf16c in half_float_f16c.c. */
+void _mesa_float_to_half_array_f16c(uint16_t *dst, const float *src,
+                                    unsigned n);
+void _mesa_half_to_float_array_f16c(float *dst, const uint16_t *src,
+                                    unsigned n);
+#endif
+
 #ifdef __cplusplus
 } /* extern C */
 #endif
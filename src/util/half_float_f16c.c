@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2016 Mesa contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * \file half_float_f16c.c
+ *
+ * F16C versions of _mesa_float_to_half_array() and
+ * _mesa_half_to_float_array(), built with -mf16c and only called after
+ * half_float.c has checked the CPU.
+ */
+
+#include <immintrin.h>
+
+#include "half_float.h"
+
+void
+_mesa_float_to_half_array_f16c(uint16_t *dst, const float *src, unsigned n)
+{
+   const __m128i sign_mask = _mm_set1_epi16(0x8000);
+   const __m128i nan = _mm_set1_epi16(0x7c01);
+   unsigned i = 0;
+
+   for (; i + 8 <= n; i += 8) {
+      const __m256 f = _mm256_loadu_ps(src + i);
+      const __m256 is_nan = _mm256_cmp_ps(f, f, _CMP_UNORD_Q);
+      const __m128i mask =
+         _mm_packs_epi32(_mm_castps_si128(_mm256_castps256_ps128(is_nan)),
+                         _mm_castps_si128(_mm256_extractf128_ps(is_nan, 1)));
+      __m128i h = _mm256_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT);
+
+      /* all NaNs become the NaN of _mesa_float_to_half(), keeping the sign */
+      h = _mm_or_si128(_mm_andnot_si128(mask, h),
+                       _mm_and_si128(mask, _mm_or_si128(_mm_and_si128(h, sign_mask),
+                                                        nan)));
+      _mm_storeu_si128((__m128i *) (dst + i), h);
+   }
+
+   /* A single vertex attribute or pixel is four values. */
+   for (; i + 4 <= n; i += 4) {
+      const __m128 f = _mm_loadu_ps(src + i);
+      const __m128i is_nan = _mm_castps_si128(_mm_cmpunord_ps(f, f));
+      const __m128i mask = _mm_packs_epi32(is_nan, is_nan);
+      __m128i h = _mm_cvtps_ph(f, _MM_FROUND_TO_NEAREST_INT);
+
+      h = _mm_or_si128(_mm_andnot_si128(mask, h),
+                       _mm_and_si128(mask, _mm_or_si128(_mm_and_si128(h, sign_mask),
+                                                        nan)));
+      _mm_storel_epi64((__m128i *) (dst + i), h);
+   }
+
+   for (; i < n; i++)
+      dst[i] = _mesa_float_to_half(src[i]);
+}
+
+void
+_mesa_half_to_float_array_f16c(float *dst, const uint16_t *src, unsigned n)
+{
+   const __m256 sign_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+   const __m256 nan = _mm256_castsi256_ps(_mm256_set1_epi32(0x7f800001));
+   unsigned i = 0;
+
+   for (; i + 8 <= n; i += 8) {
+      const __m128i h = _mm_loadu_si128((const __m128i *) (src + i));
+      const __m256 f = _mm256_cvtph_ps(h);
+      const __m256 is_nan = _mm256_cmp_ps(f, f, _CMP_UNORD_Q);
+
+      /* all NaNs become the NaN of _mesa_half_to_float(), keeping the sign */
+      _mm256_storeu_ps(dst + i,
+                       _mm256_blendv_ps(f, _mm256_or_ps(_mm256_and_ps(f, sign_mask),
+                                                        nan),
+                                        is_nan));
+   }
+
+   for (; i + 4 <= n; i += 4) {
+      const __m128i h = _mm_loadl_epi64((const __m128i *) (src + i));
+      const __m128 f = _mm_cvtph_ps(h);
+      const __m128 is_nan = _mm_cmpunord_ps(f, f);
+
+      _mm_storeu_ps(dst + i,
+                    _mm_blendv_ps(f, _mm_or_ps(_mm_and_ps(f, _mm256_castps256_ps128(sign_mask)),
+                                               _mm256_castps256_ps128(nan)),
+                                  is_nan));
+   }
+
+   for (; i < n; i++)
+      dst[i] = _mesa_half_to_float(src[i]);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright © 2016 Mesa contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Checks the bulk half-float conversions against the scalar ones. */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "half_float.h"
+
+int main(int argc, char *argv[])
+{
+   /* Every half, and floats over every exponent with mantissas around the
+    * rounding points, of both signs.  The counts leave tails for the
+    * narrower and the scalar code of the SIMD versions.
+    */
+   const unsigned num_halves = 0x10000;
+   const unsigned num_floats = 2 * 256 * 64 + 5;
+   uint16_t *halves = malloc(num_halves * sizeof(uint16_t));
+   uint16_t *halves_out = malloc(num_floats * sizeof(uint16_t));
+   float *floats = malloc(num_floats * sizeof(float));
+   float *floats_out = malloc(num_halves * sizeof(float));
+   bool failed = false;
+   unsigned i;
+
+   if (!halves || !halves_out || !floats || !floats_out)
+      return 1;
+
+   for (i = 0; i < num_halves; i++)
+      halves[i] = i;
+
+   for (i = 0; i < num_floats; i++) {
+      const uint32_t mantissas[] = { 0, 1, 0xfff, 0x1000, 0x1001, 0x2000,
+                                     0x3000, 0x7fffff };
+      uint32_t bits = (i & 1) << 31 | ((i >> 1) & 0xff) << 23 |
+                      ((mantissas[(i >> 9) & 7] + ((i >> 12) << 13)) &
+                       0x7fffff);
+
+      memcpy(&floats[i], &bits, sizeof(bits));
+   }
+
+   _mesa_half_to_float_array(floats_out, halves, num_halves - 3);
+   _mesa_half_to_float_array(floats_out + num_halves - 3,
+                             halves + num_halves - 3, 3);
+   for (i = 0; i < num_halves; i++) {
+      float expected = _mesa_half_to_float(halves[i]);
+
+      if (memcmp(&expected, &floats_out[i], sizeof(float))) {
+         fprintf(stderr, "_mesa_half_to_float_array(0x%04x): expected %a, "
+                         "got %a\n", halves[i], expected, floats_out[i]);
+         failed = true;
+      }
+   }
+
+   _mesa_float_to_half_array(halves_out, floats, num_floats);
+   for (i = 0; i < num_floats; i++) {
+      uint16_t expected = _mesa_float_to_half(floats[i]);
+
+      if (expected != halves_out[i]) {
+         fprintf(stderr, "_mesa_float_to_half_array(%a): expected 0x%04x, "
+                         "got 0x%04x\n", floats[i], expected, halves_out[i]);
+         failed = true;
+      }
+   }
+
+   free(halves);
+   free(halves_out);
+   free(floats);
+   free(floats_out);
+
+   return failed;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright © 2016 Mesa contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "hash64.h"
+
+#define PRIME64_1 0x9E3779B185EBCA87ull
+#define PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define PRIME64_3 0x165667B19E3779F9ull
+#define PRIME64_4 0x85EBCA77C2B2AE63ull
+#define PRIME64_5 0x27D4EB2F165667C5ull
+
+static inline uint64_t
+rotl64(uint64_t x, unsigned r)
+{
+   return (x << r) | (x >> (64 - r));
+}
+
+/* Little endian loads, which compilers turn into plain loads where they
+ * can.
+ */
+static inline uint64_t
+read64(const uint8_t *p)
+{
+   return (uint64_t) p[0] | (uint64_t) p[1] << 8 |
+          (uint64_t) p[2] << 16 | (uint64_t) p[3] << 24 |
+          (uint64_t) p[4] << 32 | (uint64_t) p[5] << 40 |
+          (uint64_t) p[6] << 48 | (uint64_t) p[7] << 56;
+}
+
+static inline uint32_t
+read32(const uint8_t *p)
+{
+   return (uint32_t) p[0] | (uint32_t) p[1] << 8 |
+          (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+static inline uint64_t
+round64(uint64_t acc, uint64_t input)
+{
+   acc += input * PRIME64_2;
+   acc = rotl64(acc, 31);
+   return acc * PRIME64_1;
+}
+
+static inline uint64_t
+merge_round64(uint64_t acc, uint64_t val)
+{
+   acc ^= round64(0, val);
+   return acc * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t
+_mesa_hash64_data(const void *data, size_t size, uint64_t seed)
+{
+   const uint8_t *p = data;
+   const uint8_t *end = p + size;
+   uint64_t h;
+
+   if (size >= 32) {
+      const uint8_t *limit = end - 32;
+      uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+      uint64_t v2 = seed + PRIME64_2;
+      uint64_t v3 = seed;
+      uint64_t v4 = seed - PRIME64_1;
+
+      do {
+         v1 = round64(v1, read64(p));
+         v2 = round64(v2, read64(p + 8));
+         v3 = round64(v3, read64(p + 16));
+         v4 = round64(v4, read64(p + 24));
+         p += 32;
+      } while (p <= limit);
+
+      h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+      h = merge_round64(h, v1);
+      h = merge_round64(h, v2);
+      h = merge_round64(h, v3);
+      h = merge_round64(h, v4);
+   } else {
+      h = seed + PRIME64_5;
+   }
+
+   h += (uint64_t) size;
+
+   while (p + 8 <= end) {
+      h ^= round64(0, read64(p));
+      h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+      p += 8;
+   }
+
+   if (p + 4 <= end) {
+      h ^= (uint64_t) read32(p) * PRIME64_1;
+      h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+      p += 4;
+   }
+
+   while (p < end) {
+      h ^= *p * PRIME64_5;
+      h = rotl64(h, 11) * PRIME64_1;
+      p++;
+   }
+
+   /* avalanche */
+   h ^= h >> 33;
+   h *= PRIME64_2;
+   h ^= h >> 29;
+   h *= PRIME64_3;
+   h ^= h >> 32;
+
+   return h;
+}
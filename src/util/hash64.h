@@ -0,0 +1,58 @@
+/*
+ * Copyright © 2016 Mesa contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Fast non-cryptographic 64-bit hash for in-memory keys.
+ *
+ * This is the XXH64 algorithm by Yann Collet, which consumes 32 bytes per
+ * iteration in four independent lanes and so runs at several bytes per
+ * cycle on large inputs, against about one for byte-wise FNV-1a.  The
+ * results match the reference implementation on all hosts, but they are
+ * not meant to be stored: use SHA-1 (mesa-sha1.h) for on-disk keys.
+ */
+
+#ifndef HASH64_H
+#define HASH64_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint64_t
+_mesa_hash64_data(const void *data, size_t size, uint64_t seed);
+
+/** Folds a 64-bit hash to the 32 bits used by the hash tables. */
+static inline uint32_t
+_mesa_hash64_fold(uint64_t hash)
+{
+   return (uint32_t) (hash ^ (hash >> 32));
+}
+
+#ifdef __cplusplus
+} /* extern C */
+#endif
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * Copyright © 2016 Mesa contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Checks the 64-bit hash against the reference XXH64 results.
+ *
+ * With --bench, also prints the throughput of the hash and of the FNV-1a
+ * hash it replaces for a few key sizes.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "hash64.h"
+#include "hash_table.h"
+
+static const struct {
+   const char *str;
+   uint64_t hash;
+} vectors[] = {
+   { "", 0xef46db3751d8e999ull },
+   { "a", 0xd24ec4f1a98c6e5bull },
+   { "abc", 0x44bc2cf5ad770999ull },
+   { "Nobody inspects the spammish repetition", 0xfbcea83c8a378bf1ull },
+};
+
+static double
+now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void
+bench(void)
+{
+   static uint8_t data[1 << 16];
+   const size_t sizes[] = { 8, 64, 1024, sizeof(data) };
+   volatile uint64_t sink = 0;
+   unsigned i, s;
+
+   for (i = 0; i < sizeof(data); i++)
+      data[i] = i * 7;
+
+   for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+      const size_t size = sizes[s];
+      const unsigned iters = (256 << 20) / size;
+      double t0, t1, t2;
+
+      t0 = now();
+      for (i = 0; i < iters; i++)
+         sink += _mesa_hash64_data(data, size, i);
+      t1 = now();
+      for (i = 0; i < iters; i++)
+         sink += _mesa_fnv32_1a_accumulate_block(i, data, size);
+      t2 = now();
+
+      printf("%6zu bytes: hash64 %8.1f MB/s, fnv1a %8.1f MB/s\n", size,
+             iters * size / (t1 - t0) / 1e6, iters * size / (t2 - t1) / 1e6);
+   }
+   (void) sink;
+}
+
+int
+main(int argc, char *argv[])
+{
+   bool failed = false;
+   unsigned i;
+
+   for (i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++) {
+      uint64_t hash = _mesa_hash64_data(vectors[i].str,
+                                        strlen(vectors[i].str), 0);
+
+      if (hash != vectors[i].hash) {
+         fprintf(stderr, "FAIL: hash of \"%s\" is 0x%016" PRIx64
+                 ", expected 0x%016" PRIx64 "\n",
+                 vectors[i].str, hash, vectors[i].hash);
+         failed = true;
+      }
+   }
+
+   if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+      bench();
+
+   return failed ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright © 2016 Mesa contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Metadata bytes shared by hash_table.c and set.c.
+ *
+ * Both tables have a power-of-two number of entries, split into groups of
+ * HASH_GROUP_SIZE.  Each entry has a metadata byte: HASH_META_EMPTY,
+ * HASH_META_DELETED, or for a present entry 7 bits folded from its hash.
+ * A lookup picks a group from the hash and compares the whole group's
+ * metadata with the wanted byte at once, so only entries which very likely
+ * match get their key compared.  Groups are probed in triangular order,
+ * which visits all of them, and the probe stops at the first group with an
+ * empty entry.
+ *
+ * The hash is scrambled (Fibonacci hashing) before picking the group, as
+ * many of the hash functions in the tree are weak: identity hashes of
+ * aligned pointers or of small integers.
+ */
+
+#ifndef _HASH_META_H
+#define _HASH_META_H
+
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define HASH_GROUP_SIZE    16
+
+#define HASH_META_EMPTY    0x80
+#define HASH_META_DELETED  0xfe
+
+static inline uint8_t
+hash_meta_tag(uint32_t hash)
+{
+   hash ^= hash >> 16;
+   hash ^= hash >> 8;
+   return hash & 0x7f;
+}
+
+static inline uint32_t
+hash_meta_first_group(uint32_t hash, uint32_t size)
+{
+   /* Maps the scrambled hash onto [0, number of groups) */
+   return ((uint64_t) (hash * 0x9e3779b1u) * (size / HASH_GROUP_SIZE)) >> 32;
+}
+
+/** The i-th group (i > 0) probed after \p group. */
+static inline uint32_t
+hash_meta_next_group(uint32_t group, uint32_t i, uint32_t size)
+{
+   return (group + i) & (size / HASH_GROUP_SIZE - 1);
+}
+
+/** Bit mask of the group's entries whose metadata is \p byte. */
+static inline uint32_t
+hash_meta_match(const uint8_t *meta, uint8_t byte)
+{
+#ifdef __SSE2__
+   __m128i m = _mm_loadu_si128((const __m128i *) meta);
+   return _mm_movemask_epi8(_mm_cmpeq_epi8(m, _mm_set1_epi8(byte)));
+#else
+   uint32_t mask = 0;
+   unsigned i;
+
+   for (i = 0; i < HASH_GROUP_SIZE; i++)
+      mask |= (uint32_t) (meta[i] == byte) << i;
+   return mask;
+#endif
+}
+
+/** Bit mask of the group's entries which are empty or deleted. */
+static inline uint32_t
+hash_meta_match_available(const uint8_t *meta)
+{
+#ifdef __SSE2__
+   return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) meta));
+#else
+   uint32_t mask = 0;
+   unsigned i;
+
+   for (i = 0; i < HASH_GROUP_SIZE; i++)
+      mask |= (uint32_t) (meta[i] >> 7) << i;
+   return mask;
+#endif
+}
+
+/** Index of the lowest set bit of a non-zero mask. */
+static inline unsigned
+hash_meta_first_bit(uint32_t mask)
+{
+#if defined(__GNUC__)
+   return __builtin_ctz(mask);
+#else
+   unsigned i = 0;
+
+   while (!(mask & 1)) {
+      mask >>= 1;
+      i++;
+   }
+   return i;
+#endif
+}
+
+#endif /* _HASH_META_H */
@@ -33,9 +33,10 @@
  */
 
 /**
- * Implements an open-addressing, linear-reprobing hash table.
+ * Implements an open-addressing hash table with a power-of-two size.
+ * Entries are found by probing groups of metadata bytes; see hash_meta.h.
  *
- * For more information, see:
+ * For the original design, see:
  *
  * http://cgit.freedesktop.org/~anholt/hash_table/tree/README
  */
@@ -45,68 +46,44 @@
 #include <assert.h>
 
 #include "hash_table.h"
+#include "hash_meta.h"
+#include "hash64.h"
 #include "ralloc.h"
 #include "macros.h"
 
 static const uint32_t deleted_key_value;
 
 /**
- * From Knuth -- a good choice for hash/rehash values is p, p-2 where
- * p and p-2 are both prime.  These tables are sized to have an extra 10%
- * free to avoid exponential performance degradation as the hash table fills
+ * The table is kept at most 7/8 full (deleted entries included) to keep
+ * the probe sequences short.
  */
-static const struct {
-   uint32_t max_entries, size, rehash;
-} hash_sizes[] = {
-   { 2,			5,		3	  },
-   { 4,			7,		5	  },
-   { 8,			13,		11	  },
-   { 16,		19,		17	  },
-   { 32,		43,		41        },
-   { 64,		73,		71        },
-   { 128,		151,		149       },
-   { 256,		283,		281       },
-   { 512,		571,		569       },
-   { 1024,		1153,		1151      },
-   { 2048,		2269,		2267      },
-   { 4096,		4519,		4517      },
-   { 8192,		9013,		9011      },
-   { 16384,		18043,		18041     },
-   { 32768,		36109,		36107     },
-   { 65536,		72091,		72089     },
-   { 131072,		144409,		144407    },
-   { 262144,		288361,		288359    },
-   { 524288,		576883,		576881    },
-   { 1048576,		1153459,	1153457   },
-   { 2097152,		2307163,	2307161   },
-   { 4194304,		4613893,	4613891   },
-   { 8388608,		9227641,	9227639   },
-   { 16777216,		18455029,	18455027  },
-   { 33554432,		36911011,	36911009  },
-   { 67108864,		73819861,	73819859  },
-   { 134217728,		147639589,	147639587 },
-   { 268435456,		295279081,	295279079 },
-   { 536870912,		590559793,	590559791 },
-   { 1073741824,	1181116273,	1181116271},
-   { 2147483648ul,	2362232233ul,	2362232231ul}
-};
-
-static int
-entry_is_free(const struct hash_entry *entry)
+#define MIN_SIZE HASH_GROUP_SIZE
+
+static uint32_t
+max_entries_for_size(uint32_t size)
 {
-   return entry->key == NULL;
+   return size - size / 8;
 }
 
-static int
-entry_is_deleted(const struct hash_table *ht, struct hash_entry *entry)
+/**
+ * Allocates the entries and their metadata bytes in one block, starting
+ * with the entries.
+ */
+static struct hash_entry *
+alloc_table(void *mem_ctx, uint32_t size)
 {
-   return entry->key == ht->deleted_key;
+   struct hash_entry *table;
+
+   table = rzalloc_size(mem_ctx, size * (sizeof(struct hash_entry) + 1));
+   if (table)
+      memset(table + size, HASH_META_EMPTY, size);
+   return table;
 }
 
-static int
-entry_is_present(const struct hash_table *ht, struct hash_entry *entry)
+static inline bool
+entry_is_present(const struct hash_table *ht, const struct hash_entry *entry)
 {
-   return entry->key != NULL && entry->key != ht->deleted_key;
+   return !(ht->meta[entry - ht->table] & HASH_META_EMPTY);
 }
 
 struct hash_table *
@@ -121,13 +98,11 @@ _mesa_hash_table_create(void *mem_ctx,
    if (ht == NULL)
       return NULL;
 
-   ht->size_index = 0;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
+   ht->size = MIN_SIZE;
+   ht->max_entries = max_entries_for_size(ht->size);
    ht->key_hash_function = key_hash_function;
    ht->key_equals_function = key_equals_function;
-   ht->table = rzalloc_array(ht, struct hash_entry, ht->size);
+   ht->table = alloc_table(ht, ht->size);
    ht->entries = 0;
    ht->deleted_entries = 0;
    ht->deleted_key = &deleted_key_value;
@@ -136,6 +111,7 @@ _mesa_hash_table_create(void *mem_ctx,
       ralloc_free(ht);
       return NULL;
    }
+   ht->meta = (uint8_t *) (ht->table + ht->size);
 
    return ht;
 }
@@ -182,26 +158,30 @@ _mesa_hash_table_set_deleted_key(struct hash_table *ht, const void *deleted_key)
 static struct hash_entry *
 hash_table_search(struct hash_table *ht, uint32_t hash, const void *key)
 {
-   uint32_t start_hash_address = hash % ht->size;
-   uint32_t hash_address = start_hash_address;
+   uint8_t tag = hash_meta_tag(hash);
+   uint32_t group = hash_meta_first_group(hash, ht->size);
+   uint32_t i;
 
-   do {
-      uint32_t double_hash;
+   for (i = 1; i <= ht->size / HASH_GROUP_SIZE; i++) {
+      const uint32_t base = group * HASH_GROUP_SIZE;
+      const uint8_t *meta = ht->meta + base;
+      uint32_t match = hash_meta_match(meta, tag);
 
-      struct hash_entry *entry = ht->table + hash_address;
+      while (match) {
+         struct hash_entry *entry =
+            ht->table + base + hash_meta_first_bit(match);
 
-      if (entry_is_free(entry)) {
-         return NULL;
-      } else if (entry_is_present(ht, entry) && entry->hash == hash) {
-         if (ht->key_equals_function(key, entry->key)) {
+         if (entry->hash == hash &&
+             ht->key_equals_function(key, entry->key))
             return entry;
-         }
+         match &= match - 1;
       }
 
-      double_hash = 1 + hash % ht->rehash;
+      if (hash_meta_match(meta, HASH_META_EMPTY))
+         return NULL;
 
-      hash_address = (hash_address + double_hash) % ht->size;
-   } while (hash_address != start_hash_address);
+      group = hash_meta_next_group(group, i, ht->size);
+   }
 
    return NULL;
 }
@@ -227,36 +207,64 @@ _mesa_hash_table_search_pre_hashed(struct hash_table *ht, uint32_t hash,
    return hash_table_search(ht, hash, key);
 }
 
+/**
+ * Puts an entry known not to be in the table into the first empty or
+ * deleted slot of its probe sequence.
+ */
 static struct hash_entry *
-hash_table_insert(struct hash_table *ht, uint32_t hash,
-                  const void *key, void *data);
+hash_table_place(struct hash_table *ht, uint32_t hash)
+{
+   uint32_t group = hash_meta_first_group(hash, ht->size);
+   uint32_t i;
+
+   for (i = 1; i <= ht->size / HASH_GROUP_SIZE; i++) {
+      const uint32_t base = group * HASH_GROUP_SIZE;
+      uint32_t avail = hash_meta_match_available(ht->meta + base);
+
+      if (avail) {
+         uint32_t index = base + hash_meta_first_bit(avail);
+
+         if (ht->meta[index] == HASH_META_DELETED)
+            ht->deleted_entries--;
+         ht->meta[index] = hash_meta_tag(hash);
+         ht->entries++;
+         return ht->table + index;
+      }
+
+      group = hash_meta_next_group(group, i, ht->size);
+   }
+
+   return NULL;
+}
 
 static void
-_mesa_hash_table_rehash(struct hash_table *ht, unsigned new_size_index)
+_mesa_hash_table_rehash(struct hash_table *ht, uint32_t new_size)
 {
    struct hash_table old_ht;
    struct hash_entry *table, *entry;
 
-   if (new_size_index >= ARRAY_SIZE(hash_sizes))
+   if (new_size == 0)
       return;
 
-   table = rzalloc_array(ht, struct hash_entry,
-                         hash_sizes[new_size_index].size);
+   table = alloc_table(ht, new_size);
    if (table == NULL)
       return;
 
    old_ht = *ht;
 
    ht->table = table;
-   ht->size_index = new_size_index;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
+   ht->meta = (uint8_t *) (table + new_size);
+   ht->size = new_size;
+   ht->max_entries = max_entries_for_size(ht->size);
    ht->entries = 0;
    ht->deleted_entries = 0;
 
-   hash_table_foreach(&old_ht, entry) {
-      hash_table_insert(ht, entry->hash, entry->key, entry->data);
+   for (entry = old_ht.table;
+        entry != old_ht.table + old_ht.size;
+        entry++) {
+      if (entry_is_present(&old_ht, entry)) {
+         *hash_table_place(ht, entry->hash) = *entry;
+      }
    }
 
    ralloc_free(old_ht.table);
@@ -266,28 +274,21 @@ static struct hash_entry *
 hash_table_insert(struct hash_table *ht, uint32_t hash,
                   const void *key, void *data)
 {
-   uint32_t start_hash_address, hash_address;
+   uint8_t tag = hash_meta_tag(hash);
+   uint32_t group, i;
    struct hash_entry *available_entry = NULL;
 
    if (ht->entries >= ht->max_entries) {
-      _mesa_hash_table_rehash(ht, ht->size_index + 1);
+      _mesa_hash_table_rehash(ht, ht->size * 2);
    } else if (ht->deleted_entries + ht->entries >= ht->max_entries) {
-      _mesa_hash_table_rehash(ht, ht->size_index);
+      _mesa_hash_table_rehash(ht, ht->size);
    }
 
-   start_hash_address = hash % ht->size;
-   hash_address = start_hash_address;
-   do {
-      struct hash_entry *entry = ht->table + hash_address;
-      uint32_t double_hash;
-
-      if (!entry_is_present(ht, entry)) {
-         /* Stash the first available entry we find */
-         if (available_entry == NULL)
-            available_entry = entry;
-         if (entry_is_free(entry))
-            break;
-      }
+   group = hash_meta_first_group(hash, ht->size);
+   for (i = 1; i <= ht->size / HASH_GROUP_SIZE; i++) {
+      const uint32_t base = group * HASH_GROUP_SIZE;
+      const uint8_t *meta = ht->meta + base;
+      uint32_t match = hash_meta_match(meta, tag);
 
       /* Implement replacement when another insert happens
        * with a matching key.  This is a relatively common
@@ -300,22 +301,38 @@ hash_table_insert(struct hash_table *ht, uint32_t hash,
        * required to avoid memory leaks, perform a search
        * before inserting.
        */
-      if (entry->hash == hash &&
-          ht->key_equals_function(key, entry->key)) {
-         entry->key = key;
-         entry->data = data;
-         return entry;
+      while (match) {
+         struct hash_entry *entry =
+            ht->table + base + hash_meta_first_bit(match);
+
+         if (entry->hash == hash &&
+             ht->key_equals_function(key, entry->key)) {
+            entry->key = key;
+            entry->data = data;
+            return entry;
+         }
+         match &= match - 1;
       }
 
+      /* Stash the first available entry we find */
+      if (available_entry == NULL) {
+         uint32_t avail = hash_meta_match_available(meta);
+         if (avail)
+            available_entry = ht->table + base + hash_meta_first_bit(avail);
+      }
 
-      double_hash = 1 + hash % ht->rehash;
+      if (hash_meta_match(meta, HASH_META_EMPTY))
+         break;
 
-      hash_address = (hash_address + double_hash) % ht->size;
-   } while (hash_address != start_hash_address);
+      group = hash_meta_next_group(group, i, ht->size);
+   }
 
    if (available_entry) {
-      if (entry_is_deleted(ht, available_entry))
+      uint8_t *meta = &ht->meta[available_entry - ht->table];
+
+      if (*meta == HASH_META_DELETED)
          ht->deleted_entries--;
+      *meta = tag;
       available_entry->hash = hash;
       available_entry->key = key;
       available_entry->data = data;
@@ -363,6 +380,7 @@ _mesa_hash_table_remove(struct hash_table *ht,
    if (!entry)
       return;
 
+   ht->meta[entry - ht->table] = HASH_META_DELETED;
    entry->key = ht->deleted_key;
    ht->entries--;
    ht->deleted_entries++;
@@ -405,7 +423,7 @@ _mesa_hash_table_random_entry(struct hash_table *ht,
                               bool (*predicate)(struct hash_entry *entry))
 {
    struct hash_entry *entry;
-   uint32_t i = rand() % ht->size;
+   uint32_t i = rand() & (ht->size - 1);
 
    if (ht->entries == 0)
       return NULL;
@@ -432,16 +450,19 @@ _mesa_hash_table_random_entry(struct hash_table *ht,
  * Quick FNV-1a hash implementation based on:
  * http://www.isthe.com/chongo/tech/comp/fnv/
  *
- * FNV-1a is not be the best hash out there -- Jenkins's lookup3 is supposed
- * to be quite good, and it probably beats FNV.  But FNV has the advantage
- * that it involves almost no code.  For an improvement on both, see Paul
- * Hsieh's http://www.azillionmonkeys.com/qed/hash.html
+ * FNV-1a handles a byte per step, which is only competitive for keys of
+ * a few bytes.  Larger keys go through the 64-bit hash in hash64.h, which
+ * handles 32 bytes per step.
  */
 uint32_t
 _mesa_hash_data(const void *data, size_t size)
 {
-   return _mesa_fnv32_1a_accumulate_block(_mesa_fnv32_1a_offset_bias,
-                                          data, size);
+   if (size < 8) {
+      return _mesa_fnv32_1a_accumulate_block(_mesa_fnv32_1a_offset_bias,
+                                             data, size);
+   }
+
+   return _mesa_hash64_fold(_mesa_hash64_data(data, size, 0));
 }
 
 /** FNV-1a string hash implementation */
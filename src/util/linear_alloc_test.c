@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Force assertions, even on release builds. */
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ralloc.h"
+
+int main(int argc, char *argv[])
+{
+   void *ctx = ralloc_context(NULL);
+   void *lin = linear_alloc_parent(ctx, 0);
+   unsigned *arrays[1000];
+   char *str;
+   unsigned i, j;
+
+   assert(lin);
+   assert(ralloc_parent_of_linear_parent(lin) == ctx);
+
+   /* Enough allocations to need several buffers, including some larger
+    * than a buffer.
+    */
+   for (i = 0; i < 1000; i++) {
+      unsigned count = i % 100 == 0 ? 4096 : i % 13 + 1;
+
+      arrays[i] = linear_zalloc_child_array(lin, unsigned, count);
+      assert(arrays[i]);
+      assert(((uintptr_t) arrays[i] & (sizeof(uintptr_t) - 1)) == 0);
+
+      for (j = 0; j < count; j++) {
+         assert(arrays[i][j] == 0);
+         arrays[i][j] = i;
+      }
+   }
+
+   for (i = 0; i < 1000; i++) {
+      unsigned count = i % 100 == 0 ? 4096 : i % 13 + 1;
+
+      for (j = 0; j < count; j++)
+         assert(arrays[i][j] == i);
+   }
+
+   str = linear_strdup(lin, "foo");
+   assert(strcmp(str, "foo") == 0);
+   assert(linear_strcat(lin, &str, "bar"));
+   assert(strcmp(str, "foobar") == 0);
+   assert(linear_asprintf_append(lin, &str, "%d", 42));
+   assert(strcmp(str, "foobar42") == 0);
+
+   str = linear_asprintf(lin, "%s-%u", "baz", 7u);
+   assert(strcmp(str, "baz-7") == 0);
+
+   /* Freeing the ralloc context releases all the buffers. */
+   ralloc_free(ctx);
+
+   /* So does freeing the linear parent itself. */
+   ctx = ralloc_context(NULL);
+   lin = linear_alloc_parent(ctx, 16);
+   for (i = 0; i < 1000; i++)
+      assert(linear_alloc_child(lin, 64));
+   linear_free_parent(lin);
+   ralloc_free(ctx);
+
+   return 0;
+}
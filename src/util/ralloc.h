@@ -407,6 +407,139 @@ bool ralloc_asprintf_append (char **str, const char *fmt, ...)
 bool ralloc_vasprintf_append(char **str, const char *fmt, va_list args);
 /// @}
 
+/**
+ * \defgroup linear Linear Allocators @{
+ *
+ * A linear allocator hands out memory from a chain of large buffers by
+ * simply bumping an offset.  Allocations ("children") carry no ralloc
+ * header, so they are cheap to create, densely packed, and can't be
+ * freed, resized as ralloc memory or used as ralloc contexts on their
+ * own.  They all go away at once when the linear parent is freed, either
+ * with linear_free_parent() or by freeing its ralloc context.
+ *
+ * This is meant for the many tiny, short-lived objects created by the
+ * compiler front-ends and passes, such as AST nodes or per-pass analysis
+ * data.
+ */
+
+/**
+ * Create a linear allocator along with its first allocation of \p size
+ * bytes.  The returned pointer is the "linear parent" to use for all
+ * subsequent linear_* calls.  The buffers are ralloc'd out of
+ * \p ralloc_ctx, which must not be NULL.
+ *
+ * A \p size of 0 is fine when the parent is only used as an allocator.
+ */
+void *linear_alloc_parent(void *ralloc_ctx, unsigned size) MALLOCLIKE;
+
+/**
+ * Same as linear_alloc_parent(), but the first allocation is zeroed.
+ */
+void *linear_zalloc_parent(void *ralloc_ctx, unsigned size) MALLOCLIKE;
+
+/**
+ * Allocate \p size bytes out of the linear allocator of \p parent.
+ */
+void *linear_alloc_child(void *parent, unsigned size) MALLOCLIKE;
+
+/**
+ * Allocate \p size zeroed bytes out of the linear allocator of \p parent.
+ */
+void *linear_zalloc_child(void *parent, unsigned size) MALLOCLIKE;
+
+/**
+ * Free the linear allocator of \p parent and everything allocated from it.
+ */
+void linear_free_parent(void *parent);
+
+/**
+ * Move all the buffers of the linear allocator of \p parent to another
+ * ralloc context.  Same as ralloc_steal(), for linear allocators.
+ */
+void ralloc_steal_linear_parent(void *new_ralloc_ctx, void *parent);
+
+/**
+ * Return the ralloc context the buffers of \p parent are allocated from.
+ */
+void *ralloc_parent_of_linear_parent(void *parent);
+
+/**
+ * Resize an allocation made by linear_alloc_child().  As it can't be
+ * resized in place, the data is copied to a new allocation and the old one
+ * is wasted until the whole allocator is freed.
+ */
+void *linear_realloc(void *parent, void *old, unsigned new_size);
+
+/**
+ * \def linear_alloc_child_array(parent, type, count)
+ * Allocate an array of \p count objects out of the linear allocator.
+ */
+#define linear_alloc_child_array(parent, type, count) \
+   ((type *) linear_alloc_child(parent, sizeof(type) * (count)))
+
+/**
+ * \def linear_zalloc_child_array(parent, type, count)
+ * Allocate a zeroed array of \p count objects out of the linear allocator.
+ */
+#define linear_zalloc_child_array(parent, type, count) \
+   ((type *) linear_zalloc_child(parent, sizeof(type) * (count)))
+
+/**
+ * Duplicate a string into the linear allocator.
+ * \sa ralloc_strdup
+ */
+char *linear_strdup(void *parent, const char *str);
+
+/**
+ * printf into a string allocated out of the linear allocator.
+ * \sa ralloc_asprintf
+ */
+char *linear_asprintf(void *parent, const char *fmt, ...) PRINTFLIKE(2, 3);
+
+/**
+ * va_list variant of linear_asprintf().
+ * \sa ralloc_vasprintf
+ */
+char *linear_vasprintf(void *parent, const char *fmt, va_list args);
+
+/**
+ * Append formatted text to a string allocated out of the linear allocator.
+ * \p str is updated to the new pointer unless allocation fails.
+ * \sa ralloc_asprintf_append
+ */
+bool linear_asprintf_append(void *parent, char **str,
+                            const char *fmt, ...) PRINTFLIKE(3, 4);
+
+/**
+ * va_list variant of linear_asprintf_append().
+ * \sa ralloc_vasprintf_append
+ */
+bool linear_vasprintf_append(void *parent, char **str,
+                             const char *fmt, va_list args);
+
+/**
+ * Rewrite the tail of a string allocated out of the linear allocator,
+ * starting at \p *start.
+ * \sa ralloc_asprintf_rewrite_tail
+ */
+bool linear_asprintf_rewrite_tail(void *parent, char **str, size_t *start,
+                                  const char *fmt, ...) PRINTFLIKE(4, 5);
+
+/**
+ * va_list variant of linear_asprintf_rewrite_tail().
+ * \sa ralloc_vasprintf_rewrite_tail
+ */
+bool linear_vasprintf_rewrite_tail(void *parent, char **str, size_t *start,
+                                   const char *fmt, va_list args);
+
+/**
+ * Concatenate \p str onto \p dest, which is allocated out of the linear
+ * allocator.
+ * \sa ralloc_strcat
+ */
+bool linear_strcat(void *parent, char **dest, const char *str);
+/// @}
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 #endif
@@ -448,5 +581,33 @@ public:                                                                  \
       ralloc_free(p);                                                    \
    }
 
+/**
+ * Declare C++ new and delete operators which use a linear allocator.
+ *
+ * Same as DECLARE_RALLOC_CXX_OPERATORS, but the context passed to new must
+ * be a linear parent (see linear_alloc_parent).  The objects can't have a
+ * destructor, since nothing would call it: they are released along with
+ * the whole allocator, and delete is a no-op.
+ */
+#define DECLARE_LINEAR_ALLOC_CXX_OPERATORS_TEMPLATE(TYPE, ALLOC_FUNC)    \
+public:                                                                  \
+   static void* operator new(size_t size, void *mem_ctx)                 \
+   {                                                                     \
+      void *p = ALLOC_FUNC(mem_ctx, size);                               \
+      assert(p != NULL);                                                 \
+      return p;                                                          \
+   }                                                                     \
+                                                                         \
+   static void operator delete(void *p)                                  \
+   {                                                                     \
+      /* The memory is released with the whole linear allocator. */      \
+   }
+
+#define DECLARE_LINEAR_ALLOC_CXX_OPERATORS(TYPE) \
+   DECLARE_LINEAR_ALLOC_CXX_OPERATORS_TEMPLATE(TYPE, linear_alloc_child)
+
+#define DECLARE_LINEAR_ZALLOC_CXX_OPERATORS(TYPE) \
+   DECLARE_LINEAR_ALLOC_CXX_OPERATORS_TEMPLATE(TYPE, linear_zalloc_child)
+
 
 #endif
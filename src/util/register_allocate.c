@@ -68,10 +68,23 @@
  * up front and stored in a 2-dimensional array, so that the cost of
  * coloring a node is constant with the number of registers.  We do
  * this during ra_set_finalize().
+ *
+ * Shaders with many thousands of live ranges are not unusual, so the graph
+ * is built with that in mind: small graphs keep an adjacency bitset per node
+ * (allocated in one block) to reject duplicate edges, while large graphs
+ * only keep adjacency lists, which are deduplicated once before
+ * allocation.  Callers that have live intervals can use
+ * ra_add_live_range_interference() instead of testing every pair of nodes,
+ * optionally spreading the work over several threads.
  */
 
 #include <stdbool.h>
+#include <stdlib.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
+#include "c11/threads.h"
 #include "ralloc.h"
 #include "main/imports.h"
 #include "main/macros.h"
@@ -81,6 +94,18 @@
 
 #define NO_REG ~0U
 
+/**
+ * Graphs with more nodes than this don't get adjacency bitsets, which are
+ * quadratic in the node count.
+ */
+#define RA_MAX_DENSE_NODES 4096
+
+/**
+ * Graphs with fewer nodes than this never build their interference on
+ * multiple threads, since starting the threads would cost more than it saves.
+ */
+#define RA_MIN_PARALLEL_NODES 2048
+
 struct ra_reg {
    BITSET_WORD *conflicts;
    unsigned int *conflict_list;
@@ -96,6 +121,9 @@ struct ra_regs {
    unsigned int class_count;
 
    bool round_robin;
+
+   /** Maximum number of threads for ra_add_live_range_interference(). */
+   unsigned int max_interference_threads;
 };
 
 struct ra_class {
@@ -126,6 +154,11 @@ struct ra_node {
     *
     * List of which nodes this node interferes with.  This should be
     * symmetric with the other node.
+    *
+    * The bitset is NULL for sparse graphs, in which case the list may
+    * contain duplicates until ra_finish_adjacency() is called.  The list is
+    * malloc()ed rather than ralloc()ed so that it can be grown from
+    * multiple threads by ra_add_live_range_interference().
     */
    BITSET_WORD *adjacency;
    unsigned int *adjacency_list;
@@ -166,6 +199,17 @@ struct ra_graph {
    struct ra_node *nodes;
    unsigned int count; /**< count of nodes. */
 
+   /**
+    * Set if the graph is too large for adjacency bitsets.
+    */
+   bool sparse;
+
+   /**
+    * Set if adjacency lists may have duplicates, which ra_finish_adjacency()
+    * removes.
+    */
+   bool adjacency_dirty;
+
    unsigned int *stack;
    unsigned int stack_count;
 
@@ -191,6 +235,7 @@ ra_alloc_reg_set(void *mem_ctx, unsigned int count, bool need_conflict_lists)
    regs = rzalloc(mem_ctx, struct ra_regs);
    regs->count = count;
    regs->regs = rzalloc_array(regs, struct ra_reg, count);
+   regs->max_interference_threads = 1;
 
    for (i = 0; i < count; i++) {
       regs->regs[i].conflicts = rzalloc_array(regs->regs, BITSET_WORD,
@@ -387,56 +432,84 @@ ra_set_finalize(struct ra_regs *regs, unsigned int **q_values)
    }
 }
 
+/**
+ * Makes \p n2 a neighbor of \p n1 (but not the other way around).
+ *
+ * This only touches \p n1, so different threads may add the neighbors of
+ * different nodes at the same time.
+ */
 static void
 ra_add_node_adjacency(struct ra_graph *g, unsigned int n1, unsigned int n2)
 {
-   BITSET_SET(g->nodes[n1].adjacency, n2);
+   struct ra_node *node = &g->nodes[n1];
+   int n1_class = node->class;
+   int n2_class = g->nodes[n2].class;
 
-   if (n1 != n2) {
-      int n1_class = g->nodes[n1].class;
-      int n2_class = g->nodes[n2].class;
-      g->nodes[n1].q_total += g->regs->classes[n1_class]->q[n2_class];
-   }
+   if (node->adjacency)
+      BITSET_SET(node->adjacency, n2);
 
-   if (g->nodes[n1].adjacency_count >=
-       g->nodes[n1].adjacency_list_size) {
-      g->nodes[n1].adjacency_list_size *= 2;
-      g->nodes[n1].adjacency_list = reralloc(g, g->nodes[n1].adjacency_list,
-                                             unsigned int,
-                                             g->nodes[n1].adjacency_list_size);
+   node->q_total += g->regs->classes[n1_class]->q[n2_class];
+
+   if (node->adjacency_count >= node->adjacency_list_size) {
+      node->adjacency_list_size *= 2;
+      node->adjacency_list = realloc(node->adjacency_list,
+                                     node->adjacency_list_size *
+                                     sizeof(*node->adjacency_list));
    }
 
-   g->nodes[n1].adjacency_list[g->nodes[n1].adjacency_count] = n2;
-   g->nodes[n1].adjacency_count++;
+   node->adjacency_list[node->adjacency_count] = n2;
+   node->adjacency_count++;
+}
+
+/**
+ * Frees the adjacency lists.  This is the destructor of the node array, as
+ * the graph's own destructor only runs after its children are gone.
+ */
+static void
+ra_nodes_destructor(void *data)
+{
+   struct ra_graph *g = ralloc_parent(data);
+   unsigned int i;
+
+   for (i = 0; i < g->count; i++)
+      free(g->nodes[i].adjacency_list);
 }
 
 struct ra_graph *
 ra_alloc_interference_graph(struct ra_regs *regs, unsigned int count)
 {
    struct ra_graph *g;
+   BITSET_WORD *adjacency = NULL;
+   unsigned int bitset_count = BITSET_WORDS(count);
    unsigned int i;
 
    g = rzalloc(NULL, struct ra_graph);
    g->regs = regs;
    g->nodes = rzalloc_array(g, struct ra_node, count);
    g->count = count;
+   g->sparse = count > RA_MAX_DENSE_NODES;
 
    g->stack = rzalloc_array(g, unsigned int, count);
 
+   if (!g->sparse)
+      adjacency = rzalloc_array(g, BITSET_WORD, count * bitset_count);
+
    for (i = 0; i < count; i++) {
-      int bitset_count = BITSET_WORDS(count);
-      g->nodes[i].adjacency = rzalloc_array(g, BITSET_WORD, bitset_count);
+      if (adjacency) {
+         g->nodes[i].adjacency = &adjacency[i * bitset_count];
+         BITSET_SET(g->nodes[i].adjacency, i);
+      }
 
       g->nodes[i].adjacency_list_size = 4;
       g->nodes[i].adjacency_list =
-         ralloc_array(g, unsigned int, g->nodes[i].adjacency_list_size);
+         malloc(g->nodes[i].adjacency_list_size * sizeof(unsigned int));
       g->nodes[i].adjacency_count = 0;
       g->nodes[i].q_total = 0;
-
-      ra_add_node_adjacency(g, i, i);
       g->nodes[i].reg = NO_REG;
    }
 
+   ralloc_set_destructor(g->nodes, ra_nodes_destructor);
+
    return g;
 }
 
@@ -451,10 +524,232 @@ void
 ra_add_node_interference(struct ra_graph *g,
                          unsigned int n1, unsigned int n2)
 {
-   if (!BITSET_TEST(g->nodes[n1].adjacency, n2)) {
+   if (g->sparse) {
+      if (n1 == n2)
+         return;
+      g->adjacency_dirty = true;
+   } else if (BITSET_TEST(g->nodes[n1].adjacency, n2)) {
+      return;
+   }
+
+   ra_add_node_adjacency(g, n1, n2);
+   ra_add_node_adjacency(g, n2, n1);
+}
+
+/**
+ * Sets the maximum number of threads ra_add_live_range_interference() may
+ * use for large graphs.  0 means one per CPU.  The default is 1.
+ */
+void
+ra_set_parallel_interference(struct ra_regs *regs, unsigned int max_threads)
+{
+   regs->max_interference_threads = max_threads;
+}
+
+struct ra_live_range {
+   int start;
+   int end;
+   unsigned int node;
+};
+
+struct ra_interference_job {
+   struct ra_graph *g;
+   const struct ra_live_range *ranges;
+   unsigned int count;
+
+   /** Only neighbors of nodes in [first_node, end_node) are added. */
+   unsigned int first_node;
+   unsigned int end_node;
+};
+
+static int
+ra_live_range_compare(const void *va, const void *vb)
+{
+   const struct ra_live_range *a = va;
+   const struct ra_live_range *b = vb;
+
+   if (a->start != b->start)
+      return a->start < b->start ? -1 : 1;
+
+   return a->node < b->node ? -1 : a->node > b->node;
+}
+
+static void
+ra_add_neighbor_once(struct ra_graph *g, unsigned int n1, unsigned int n2)
+{
+   if (g->nodes[n1].adjacency == NULL ||
+       !BITSET_TEST(g->nodes[n1].adjacency, n2))
       ra_add_node_adjacency(g, n1, n2);
-      ra_add_node_adjacency(g, n2, n1);
+}
+
+/**
+ * Walks every pair of overlapping ranges, adding the neighbors of the nodes
+ * the job owns.  Ranges are sorted by start, so the ranges overlapping the
+ * one at i that start no earlier than it are the ones right after it, up to
+ * the first one starting after it ends.
+ */
+static int
+ra_interference_job_run(void *data)
+{
+   const struct ra_interference_job *job = data;
+   const struct ra_live_range *ranges = job->ranges;
+   unsigned int i, j;
+
+   for (i = 0; i < job->count; i++) {
+      const unsigned int a = ranges[i].node;
+      const bool owns_a = a >= job->first_node && a < job->end_node;
+
+      for (j = i + 1; j < job->count && ranges[j].start < ranges[i].end; j++) {
+         const unsigned int b = ranges[j].node;
+
+         if (ranges[j].end <= ranges[i].start)
+            continue;
+
+         if (owns_a)
+            ra_add_neighbor_once(job->g, a, b);
+         if (b >= job->first_node && b < job->end_node)
+            ra_add_neighbor_once(job->g, b, a);
+      }
    }
+
+   return 0;
+}
+
+static unsigned int
+ra_get_interference_threads(const struct ra_graph *g, unsigned int count)
+{
+   unsigned int threads = g->regs->max_interference_threads;
+
+   if (count < RA_MIN_PARALLEL_NODES)
+      return 1;
+
+   if (threads == 0) {
+#if defined(_SC_NPROCESSORS_ONLN)
+      long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+      threads = cpus > 0 ? cpus : 1;
+#else
+      threads = 1;
+#endif
+   }
+
+   return MIN2(threads, count / (RA_MIN_PARALLEL_NODES / 2));
+}
+
+/**
+ * Adds interference between nodes first_node to first_node + count - 1
+ * whose live ranges overlap.  The range of node first_node + i is given by
+ * start[i] and end[i], and two ranges a and b overlap unless
+ * end[a] <= start[b] or end[b] <= start[a].  Ranges with start > end (dead
+ * nodes) don't overlap anything.
+ *
+ * This takes time proportional to the number of interfering pairs rather
+ * than to the square of the number of nodes.  As with
+ * ra_add_node_interference(), the node classes must already be set.
+ */
+void
+ra_add_live_range_interference(struct ra_graph *g, unsigned int first_node,
+                               unsigned int count,
+                               const int *start, const int *end)
+{
+   struct ra_live_range *ranges;
+   struct ra_interference_job *jobs;
+   thrd_t *threads;
+   bool *started;
+   unsigned int num_threads, chunk, i;
+
+   if (count == 0)
+      return;
+
+   assert(first_node + count <= g->count);
+
+   ranges = malloc(count * sizeof(*ranges));
+   for (i = 0; i < count; i++) {
+      ranges[i].start = start[i];
+      ranges[i].end = end[i];
+      ranges[i].node = first_node + i;
+   }
+   qsort(ranges, count, sizeof(*ranges), ra_live_range_compare);
+
+   /* Each job owns a block of nodes and only ever touches the adjacency of
+    * those, so they don't need any locking.
+    */
+   num_threads = ra_get_interference_threads(g, count);
+   chunk = (count + num_threads - 1) / num_threads;
+   jobs = calloc(num_threads, sizeof(*jobs));
+   threads = calloc(num_threads, sizeof(*threads));
+
+   for (i = 0; i < num_threads; i++) {
+      jobs[i].g = g;
+      jobs[i].ranges = ranges;
+      jobs[i].count = count;
+      jobs[i].first_node = first_node + MIN2(i * chunk, count);
+      jobs[i].end_node = first_node + MIN2((i + 1) * chunk, count);
+   }
+
+   /* The calling thread does the first job.  If a thread can't be started,
+    * its job is done here as well.
+    */
+   started = calloc(num_threads, sizeof(*started));
+   for (i = 1; i < num_threads; i++) {
+      started[i] = thrd_create(&threads[i], ra_interference_job_run,
+                               &jobs[i]) == thrd_success;
+   }
+
+   ra_interference_job_run(&jobs[0]);
+
+   for (i = 1; i < num_threads; i++) {
+      if (started[i])
+         thrd_join(threads[i], NULL);
+      else
+         ra_interference_job_run(&jobs[i]);
+   }
+
+   if (g->sparse)
+      g->adjacency_dirty = true;
+
+   free(started);
+   free(threads);
+   free(jobs);
+   free(ranges);
+}
+
+/**
+ * Removes the duplicate edges sparse graphs accumulate, and recomputes the
+ * q totals they were counted in.  The first occurrence of each neighbor is
+ * kept, which leaves the lists in the order a dense graph would have them.
+ */
+static void
+ra_finish_adjacency(struct ra_graph *g)
+{
+   unsigned int *seen;
+   unsigned int n, i;
+
+   if (!g->adjacency_dirty)
+      return;
+
+   seen = calloc(g->count, sizeof(*seen));
+
+   for (n = 0; n < g->count; n++) {
+      struct ra_node *node = &g->nodes[n];
+      const unsigned int *q = g->regs->classes[node->class]->q;
+      unsigned int count = 0;
+
+      node->q_total = 0;
+      for (i = 0; i < node->adjacency_count; i++) {
+         unsigned int n2 = node->adjacency_list[i];
+
+         if (seen[n2] == n + 1)
+            continue;
+         seen[n2] = n + 1;
+
+         node->adjacency_list[count++] = n2;
+         node->q_total += q[g->nodes[n2].class];
+      }
+      node->adjacency_count = count;
+   }
+
+   free(seen);
+   g->adjacency_dirty = false;
 }
 
 static bool
@@ -475,7 +770,7 @@ decrement_q(struct ra_graph *g, unsigned int n)
       unsigned int n2 = g->nodes[n].adjacency_list[i];
       unsigned int n2_class = g->nodes[n2].class;
 
-      if (n != n2 && !g->nodes[n2].in_stack) {
+      if (!g->nodes[n2].in_stack) {
          assert(g->nodes[n2].q_total >= g->regs->classes[n2_class]->q[n_class]);
          g->nodes[n2].q_total -= g->regs->classes[n2_class]->q[n_class];
       }
@@ -497,32 +792,50 @@ ra_simplify(struct ra_graph *g)
 {
    bool progress = true;
    unsigned int stack_optimistic_start = UINT_MAX;
+   unsigned int *remaining;
+   unsigned int remaining_count = 0;
    int i;
 
+   /* Rather than walking every node on each pass, keep the nodes that are
+    * still in the graph packed in an array, in the order the passes visit
+    * them.
+    */
+   remaining = malloc(g->count * sizeof(*remaining));
+   for (i = g->count - 1; i >= 0; i--) {
+      if (!g->nodes[i].in_stack && g->nodes[i].reg == NO_REG)
+         remaining[remaining_count++] = i;
+   }
+
    while (progress) {
       unsigned int best_optimistic_node = ~0;
       unsigned int lowest_q_total = ~0;
+      unsigned int j, kept = 0;
 
       progress = false;
 
-      for (i = g->count - 1; i >= 0; i--) {
-	 if (g->nodes[i].in_stack || g->nodes[i].reg != NO_REG)
+      for (j = 0; j < remaining_count; j++) {
+         unsigned int n = remaining[j];
+
+         /* Pushed optimistically at the end of the last pass. */
+	 if (g->nodes[n].in_stack)
 	    continue;
 
-	 if (pq_test(g, i)) {
-	    decrement_q(g, i);
-	    g->stack[g->stack_count] = i;
+	 if (pq_test(g, n)) {
+	    decrement_q(g, n);
+	    g->stack[g->stack_count] = n;
 	    g->stack_count++;
-	    g->nodes[i].in_stack = true;
+	    g->nodes[n].in_stack = true;
 	    progress = true;
 	 } else {
-	    unsigned int new_q_total = g->nodes[i].q_total;
+	    unsigned int new_q_total = g->nodes[n].q_total;
 	    if (new_q_total < lowest_q_total) {
-	       best_optimistic_node = i;
+	       best_optimistic_node = n;
 	       lowest_q_total = new_q_total;
 	    }
+	    remaining[kept++] = n;
 	 }
       }
+      remaining_count = kept;
 
       if (!progress && best_optimistic_node != ~0U) {
          if (stack_optimistic_start == UINT_MAX)
@@ -536,6 +849,7 @@ ra_simplify(struct ra_graph *g)
       }
    }
 
+   free(remaining);
    g->stack_optimistic_start = stack_optimistic_start;
 }
 
@@ -610,6 +924,7 @@ ra_select(struct ra_graph *g)
 bool
 ra_allocate(struct ra_graph *g)
 {
+   ra_finish_adjacency(g);
    ra_simplify(g);
    return ra_select(g);
 }
@@ -654,11 +969,9 @@ ra_get_spill_benefit(struct ra_graph *g, unsigned int n)
     */
    for (j = 0; j < g->nodes[n].adjacency_count; j++) {
       unsigned int n2 = g->nodes[n].adjacency_list[j];
-      if (n != n2) {
-	 unsigned int n2_class = g->nodes[n2].class;
-	 benefit += ((float)g->regs->classes[n_class]->q[n2_class] /
-		     g->regs->classes[n_class]->p);
-      }
+      unsigned int n2_class = g->nodes[n2].class;
+      benefit += ((float)g->regs->classes[n_class]->q[n2_class] /
+                  g->regs->classes[n_class]->p);
    }
 
    return benefit;
@@ -675,6 +988,8 @@ ra_get_best_spill_node(struct ra_graph *g)
    float best_benefit = 0.0;
    unsigned int n;
 
+   ra_finish_adjacency(g);
+
    /* Consider any nodes that we colored successfully or the node we failed to
     * color for spilling. When we failed to color a node in ra_select(), we
     * only considered these nodes, so spilling any other ones would not result
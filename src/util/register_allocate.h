@@ -47,6 +47,8 @@ struct ra_regs;
 struct ra_regs *ra_alloc_reg_set(void *mem_ctx, unsigned int count,
                                  bool need_conflict_lists);
 void ra_set_allocate_round_robin(struct ra_regs *regs);
+void ra_set_parallel_interference(struct ra_regs *regs,
+                                  unsigned int max_threads);
 unsigned int ra_alloc_reg_class(struct ra_regs *regs);
 void ra_add_reg_conflict(struct ra_regs *regs,
 			 unsigned int r1, unsigned int r2);
@@ -74,6 +76,10 @@ struct ra_graph *ra_alloc_interference_graph(struct ra_regs *regs,
 void ra_set_node_class(struct ra_graph *g, unsigned int n, unsigned int c);
 void ra_add_node_interference(struct ra_graph *g,
 			      unsigned int n1, unsigned int n2);
+void ra_add_live_range_interference(struct ra_graph *g,
+                                    unsigned int first_node,
+                                    unsigned int count,
+                                    const int *start, const int *end);
 /** @} */
 
 /** @{ Graph-coloring register allocation */
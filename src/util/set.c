@@ -32,74 +32,48 @@
  *    Keith Packard <keithp@keithp.com>
  */
 
+/**
+ * Implements an open-addressing set with a power-of-two size, probed the
+ * same way as hash_table.c; see hash_meta.h.
+ */
+
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "macros.h"
+#include "hash_meta.h"
 #include "ralloc.h"
 #include "set.h"
 
-/*
- * From Knuth -- a good choice for hash/rehash values is p, p-2 where
- * p and p-2 are both prime.  These tables are sized to have an extra 10%
- * free to avoid exponential performance degradation as the hash table fills
- */
-
 uint32_t deleted_key_value;
 const void *deleted_key = &deleted_key_value;
 
-static const struct {
-   uint32_t max_entries, size, rehash;
-} hash_sizes[] = {
-   { 2,            5,            3            },
-   { 4,            7,            5            },
-   { 8,            13,           11           },
-   { 16,           19,           17           },
-   { 32,           43,           41           },
-   { 64,           73,           71           },
-   { 128,          151,          149          },
-   { 256,          283,          281          },
-   { 512,          571,          569          },
-   { 1024,         1153,         1151         },
-   { 2048,         2269,         2267         },
-   { 4096,         4519,         4517         },
-   { 8192,         9013,         9011         },
-   { 16384,        18043,        18041        },
-   { 32768,        36109,        36107        },
-   { 65536,        72091,        72089        },
-   { 131072,       144409,       144407       },
-   { 262144,       288361,       288359       },
-   { 524288,       576883,       576881       },
-   { 1048576,      1153459,      1153457      },
-   { 2097152,      2307163,      2307161      },
-   { 4194304,      4613893,      4613891      },
-   { 8388608,      9227641,      9227639      },
-   { 16777216,     18455029,     18455027     },
-   { 33554432,     36911011,     36911009     },
-   { 67108864,     73819861,     73819859     },
-   { 134217728,    147639589,    147639587    },
-   { 268435456,    295279081,    295279079    },
-   { 536870912,    590559793,    590559791    },
-   { 1073741824,   1181116273,   1181116271   },
-   { 2147483648ul, 2362232233ul, 2362232231ul }
-};
-
-static int
-entry_is_free(struct set_entry *entry)
+/* At most 7/8 of the entries are in use, deleted ones included. */
+#define MIN_SIZE HASH_GROUP_SIZE
+
+static uint32_t
+max_entries_for_size(uint32_t size)
 {
-   return entry->key == NULL;
+   return size - size / 8;
 }
 
-static int
-entry_is_deleted(struct set_entry *entry)
+/* The entries are followed by their metadata bytes. */
+static struct set_entry *
+alloc_table(void *mem_ctx, uint32_t size)
 {
-   return entry->key == deleted_key;
+   struct set_entry *table;
+
+   table = rzalloc_size(mem_ctx, size * (sizeof(struct set_entry) + 1));
+   if (table)
+      memset(table + size, HASH_META_EMPTY, size);
+   return table;
 }
 
-static int
-entry_is_present(struct set_entry *entry)
+static inline bool
+entry_is_present(const struct set *ht, const struct set_entry *entry)
 {
-   return entry->key != NULL && entry->key != deleted_key;
+   return !(ht->meta[entry - ht->table] & HASH_META_EMPTY);
 }
 
 struct set *
@@ -114,13 +88,11 @@ _mesa_set_create(void *mem_ctx,
    if (ht == NULL)
       return NULL;
 
-   ht->size_index = 0;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
+   ht->size = MIN_SIZE;
+   ht->max_entries = max_entries_for_size(ht->size);
    ht->key_hash_function = key_hash_function;
    ht->key_equals_function = key_equals_function;
-   ht->table = rzalloc_array(ht, struct set_entry, ht->size);
+   ht->table = alloc_table(ht, ht->size);
    ht->entries = 0;
    ht->deleted_entries = 0;
 
@@ -128,6 +100,7 @@ _mesa_set_create(void *mem_ctx,
       ralloc_free(ht);
       return NULL;
    }
+   ht->meta = (uint8_t *) (ht->table + ht->size);
 
    return ht;
 }
@@ -163,26 +136,30 @@ _mesa_set_destroy(struct set *ht, void (*delete_function)(struct set_entry *entr
 static struct set_entry *
 set_search(const struct set *ht, uint32_t hash, const void *key)
 {
-   uint32_t hash_address;
+   uint8_t tag = hash_meta_tag(hash);
+   uint32_t group = hash_meta_first_group(hash, ht->size);
+   uint32_t i;
 
-   hash_address = hash % ht->size;
-   do {
-      uint32_t double_hash;
+   for (i = 1; i <= ht->size / HASH_GROUP_SIZE; i++) {
+      const uint32_t base = group * HASH_GROUP_SIZE;
+      const uint8_t *meta = ht->meta + base;
+      uint32_t match = hash_meta_match(meta, tag);
 
-      struct set_entry *entry = ht->table + hash_address;
+      while (match) {
+         struct set_entry *entry =
+            ht->table + base + hash_meta_first_bit(match);
 
-      if (entry_is_free(entry)) {
-         return NULL;
-      } else if (entry_is_present(entry) && entry->hash == hash) {
-         if (ht->key_equals_function(key, entry->key)) {
+         if (entry->hash == hash &&
+             ht->key_equals_function(key, entry->key))
             return entry;
-         }
+         match &= match - 1;
       }
 
-      double_hash = 1 + hash % ht->rehash;
+      if (hash_meta_match(meta, HASH_META_EMPTY))
+         return NULL;
 
-      hash_address = (hash_address + double_hash) % ht->size;
-   } while (hash_address != hash % ht->size);
+      group = hash_meta_next_group(group, i, ht->size);
+   }
 
    return NULL;
 }
@@ -203,38 +180,60 @@ _mesa_set_search_pre_hashed(const struct set *set, uint32_t hash,
    return set_search(set, hash, key);
 }
 
+/* Finds a free slot for a key known not to be in the set. */
 static struct set_entry *
-set_add(struct set *ht, uint32_t hash, const void *key);
+set_place(struct set *ht, uint32_t hash)
+{
+   uint32_t group = hash_meta_first_group(hash, ht->size);
+   uint32_t i;
+
+   for (i = 1; i <= ht->size / HASH_GROUP_SIZE; i++) {
+      const uint32_t base = group * HASH_GROUP_SIZE;
+      uint32_t avail = hash_meta_match_available(ht->meta + base);
+
+      if (avail) {
+         uint32_t index = base + hash_meta_first_bit(avail);
+
+         if (ht->meta[index] == HASH_META_DELETED)
+            ht->deleted_entries--;
+         ht->meta[index] = hash_meta_tag(hash);
+         ht->entries++;
+         return ht->table + index;
+      }
+
+      group = hash_meta_next_group(group, i, ht->size);
+   }
+
+   return NULL;
+}
 
 static void
-set_rehash(struct set *ht, unsigned new_size_index)
+set_rehash(struct set *ht, uint32_t new_size)
 {
    struct set old_ht;
    struct set_entry *table, *entry;
 
-   if (new_size_index >= ARRAY_SIZE(hash_sizes))
+   if (new_size == 0)
       return;
 
-   table = rzalloc_array(ht, struct set_entry,
-                         hash_sizes[new_size_index].size);
+   table = alloc_table(ht, new_size);
    if (table == NULL)
       return;
 
    old_ht = *ht;
 
    ht->table = table;
-   ht->size_index = new_size_index;
-   ht->size = hash_sizes[ht->size_index].size;
-   ht->rehash = hash_sizes[ht->size_index].rehash;
-   ht->max_entries = hash_sizes[ht->size_index].max_entries;
+   ht->meta = (uint8_t *) (table + new_size);
+   ht->size = new_size;
+   ht->max_entries = max_entries_for_size(ht->size);
    ht->entries = 0;
    ht->deleted_entries = 0;
 
    for (entry = old_ht.table;
         entry != old_ht.table + old_ht.size;
         entry++) {
-      if (entry_is_present(entry)) {
-         set_add(ht, entry->hash, entry->key);
+      if (entry_is_present(&old_ht, entry)) {
+         *set_place(ht, entry->hash) = *entry;
       }
    }
 
@@ -250,27 +249,21 @@ set_rehash(struct set *ht, unsigned new_size_index)
 static struct set_entry *
 set_add(struct set *ht, uint32_t hash, const void *key)
 {
-   uint32_t hash_address;
+   uint8_t tag = hash_meta_tag(hash);
+   uint32_t group, i;
    struct set_entry *available_entry = NULL;
 
    if (ht->entries >= ht->max_entries) {
-      set_rehash(ht, ht->size_index + 1);
+      set_rehash(ht, ht->size * 2);
    } else if (ht->deleted_entries + ht->entries >= ht->max_entries) {
-      set_rehash(ht, ht->size_index);
+      set_rehash(ht, ht->size);
    }
 
-   hash_address = hash % ht->size;
-   do {
-      struct set_entry *entry = ht->table + hash_address;
-      uint32_t double_hash;
-
-      if (!entry_is_present(entry)) {
-         /* Stash the first available entry we find */
-         if (available_entry == NULL)
-            available_entry = entry;
-         if (entry_is_free(entry))
-            break;
-      }
+   group = hash_meta_first_group(hash, ht->size);
+   for (i = 1; i <= ht->size / HASH_GROUP_SIZE; i++) {
+      const uint32_t base = group * HASH_GROUP_SIZE;
+      const uint8_t *meta = ht->meta + base;
+      uint32_t match = hash_meta_match(meta, tag);
 
       /* Implement replacement when another insert happens
        * with a matching key.  This is a relatively common
@@ -282,20 +275,37 @@ set_add(struct set *ht, uint32_t hash, const void *key)
        * If freeing of old keys is required to avoid memory leaks,
        * perform a search before inserting.
        */
-      if (entry->hash == hash &&
-          ht->key_equals_function(key, entry->key)) {
-         entry->key = key;
-         return entry;
+      while (match) {
+         struct set_entry *entry =
+            ht->table + base + hash_meta_first_bit(match);
+
+         if (entry->hash == hash &&
+             ht->key_equals_function(key, entry->key)) {
+            entry->key = key;
+            return entry;
+         }
+         match &= match - 1;
       }
 
-      double_hash = 1 + hash % ht->rehash;
+      /* Stash the first available entry we find */
+      if (available_entry == NULL) {
+         uint32_t avail = hash_meta_match_available(meta);
+         if (avail)
+            available_entry = ht->table + base + hash_meta_first_bit(avail);
+      }
+
+      if (hash_meta_match(meta, HASH_META_EMPTY))
+         break;
 
-      hash_address = (hash_address + double_hash) % ht->size;
-   } while (hash_address != hash % ht->size);
+      group = hash_meta_next_group(group, i, ht->size);
+   }
 
    if (available_entry) {
-      if (entry_is_deleted(available_entry))
+      uint8_t *meta = &ht->meta[available_entry - ht->table];
+
+      if (*meta == HASH_META_DELETED)
          ht->deleted_entries--;
+      *meta = tag;
       available_entry->hash = hash;
       available_entry->key = key;
       ht->entries++;
@@ -335,6 +345,7 @@ _mesa_set_remove(struct set *ht, struct set_entry *entry)
    if (!entry)
       return;
 
+   ht->meta[entry - ht->table] = HASH_META_DELETED;
    entry->key = deleted_key;
    ht->entries--;
    ht->deleted_entries++;
@@ -355,7 +366,7 @@ _mesa_set_next_entry(const struct set *ht, struct set_entry *entry)
       entry = entry + 1;
 
    for (; entry != ht->table + ht->size; entry++) {
-      if (entry_is_present(entry)) {
+      if (entry_is_present(ht, entry)) {
          return entry;
       }
    }
@@ -368,20 +379,20 @@ _mesa_set_random_entry(struct set *ht,
                        int (*predicate)(struct set_entry *entry))
 {
    struct set_entry *entry;
-   uint32_t i = rand() % ht->size;
+   uint32_t i = rand() & (ht->size - 1);
 
    if (ht->entries == 0)
       return NULL;
 
    for (entry = ht->table + i; entry != ht->table + ht->size; entry++) {
-      if (entry_is_present(entry) &&
+      if (entry_is_present(ht, entry) &&
           (!predicate || predicate(entry))) {
          return entry;
       }
    }
 
    for (entry = ht->table; entry != ht->table + i; entry++) {
-      if (entry_is_present(entry) &&
+      if (entry_is_present(ht, entry) &&
           (!predicate || predicate(entry))) {
          return entry;
       }
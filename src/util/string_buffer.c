@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+
+#include "string_buffer.h"
+
+static bool
+ensure_capacity(struct _mesa_string_buffer *str, uint32_t needed)
+{
+   uint32_t capacity;
+   char *buf;
+
+   if (needed <= str->capacity)
+      return true;
+
+   capacity = str->capacity < 16 ? 16 : str->capacity;
+   while (capacity < needed) {
+      /* Don't overflow while doubling. */
+      if (capacity > UINT32_MAX / 2) {
+         capacity = needed;
+         break;
+      }
+      capacity *= 2;
+   }
+
+   buf = reralloc_array_size(str, str->buf, sizeof(char), capacity);
+   if (buf == NULL)
+      return false;
+
+   str->buf = buf;
+   str->capacity = capacity;
+   return true;
+}
+
+struct _mesa_string_buffer *
+_mesa_string_buffer_create(void *mem_ctx, uint32_t initial_capacity)
+{
+   struct _mesa_string_buffer *str;
+
+   str = ralloc(mem_ctx, struct _mesa_string_buffer);
+   if (str == NULL)
+      return NULL;
+
+   str->capacity = initial_capacity ? initial_capacity : 1;
+   str->buf = ralloc_array(str, char, str->capacity);
+   if (str->buf == NULL) {
+      ralloc_free(str);
+      return NULL;
+   }
+
+   str->length = 0;
+   str->buf[0] = '\0';
+   return str;
+}
+
+bool
+_mesa_string_buffer_append_len(struct _mesa_string_buffer *str,
+                               const char *c, uint32_t len)
+{
+   if (len > UINT32_MAX - 1 - str->length)
+      return false;
+
+   if (!ensure_capacity(str, str->length + len + 1))
+      return false;
+
+   memcpy(str->buf + str->length, c, len);
+   str->length += len;
+   str->buf[str->length] = '\0';
+   return true;
+}
+
+bool
+_mesa_string_buffer_vprintf(struct _mesa_string_buffer *str,
+                            const char *format, va_list args)
+{
+   va_list copy;
+   int len;
+
+   /* Try to print into the free space first; most of the time it fits. */
+   va_copy(copy, args);
+   len = vsnprintf(str->buf + str->length, str->capacity - str->length,
+                   format, copy);
+   va_end(copy);
+
+   if (len < 0 || (uint32_t) len > UINT32_MAX - 1 - str->length)
+      return false;
+
+   if (str->length + len + 1 > str->capacity) {
+      if (!ensure_capacity(str, str->length + len + 1))
+         return false;
+
+      va_copy(copy, args);
+      vsnprintf(str->buf + str->length, str->capacity - str->length,
+                format, copy);
+      va_end(copy);
+   }
+
+   str->length += len;
+   return true;
+}
+
+bool
+_mesa_string_buffer_printf(struct _mesa_string_buffer *str,
+                           const char *format, ...)
+{
+   bool ret;
+   va_list args;
+
+   va_start(args, format);
+   ret = _mesa_string_buffer_vprintf(str, format, args);
+   va_end(args);
+   return ret;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Force assertions, even on release builds. */
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "string_buffer.h"
+
+int main(int argc, char *argv[])
+{
+   void *ctx = ralloc_context(NULL);
+   struct _mesa_string_buffer *str;
+   char expected[8192];
+   unsigned i, len = 0;
+
+   str = _mesa_string_buffer_create(ctx, 4);
+   assert(str);
+   assert(str->length == 0 && strcmp(str->buf, "") == 0);
+
+   /* Mix all the ways of appending, well past the initial capacity. */
+   for (i = 0; i < 500; i++) {
+      switch (i % 3) {
+      case 0:
+         assert(_mesa_string_buffer_append(str, "abc"));
+         len += sprintf(expected + len, "abc");
+         break;
+      case 1:
+         assert(_mesa_string_buffer_append_char(str, 'x'));
+         len += sprintf(expected + len, "x");
+         break;
+      case 2:
+         assert(_mesa_string_buffer_printf(str, "%u-%s", i, "long enough "
+                                           "to not fit in the free space"));
+         len += sprintf(expected + len, "%u-%s", i, "long enough "
+                        "to not fit in the free space");
+         break;
+      }
+
+      assert(str->length == len);
+      assert(strcmp(str->buf, expected) == 0);
+   }
+
+   assert(_mesa_string_buffer_append_len(str, "yz\0w", 2));
+   len += sprintf(expected + len, "yz");
+   assert(str->length == len && strcmp(str->buf, expected) == 0);
+
+   _mesa_string_buffer_clear(str);
+   assert(str->length == 0 && strcmp(str->buf, "") == 0);
+   assert(_mesa_string_buffer_printf(str, "%d", 42));
+   assert(strcmp(str->buf, "42") == 0);
+
+   _mesa_string_buffer_destroy(str);
+   ralloc_free(ctx);
+   return 0;
+}
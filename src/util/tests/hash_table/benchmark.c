@@ -0,0 +1,219 @@
+/*
+ * Copyright © 2016 Mesa contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Insert/search/delete throughput of hash_table and set, for a range of
+ * table sizes, with pointer keys (hashed with _mesa_hash_pointer) and
+ * small integer keys (identity hash, like the GL object name tables).
+ *
+ * Not run by "make check"; run it by hand to compare implementations:
+ *
+ *    ./benchmark [total operations per measurement]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include "hash_table.h"
+#include "set.h"
+
+static uint32_t
+key_value(const void *key)
+{
+   return (uint32_t) (uintptr_t) key;
+}
+
+static bool
+key_value_equals(const void *a, const void *b)
+{
+   return a == b;
+}
+
+static double
+now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+struct ops {
+   double insert, search_hit, search_miss, remove;
+};
+
+static void
+print_ops(const char *name, const char *keys, unsigned size,
+          const struct ops *ops, unsigned total)
+{
+   printf("%-10s %-8s %8u  %8.1f %8.1f %8.1f %8.1f\n", name, keys, size,
+          total / ops->insert * 1e-6, total / ops->search_hit * 1e-6,
+          total / ops->search_miss * 1e-6, total / ops->remove * 1e-6);
+}
+
+static void
+bench_hash_table(const void **keys, const void **misses, unsigned size,
+                 unsigned rounds, bool pointers, struct ops *ops)
+{
+   uint32_t (*hash)(const void *) =
+      pointers ? _mesa_hash_pointer : key_value;
+   unsigned r, i;
+   double t;
+
+   memset(ops, 0, sizeof(*ops));
+
+   for (r = 0; r < rounds; r++) {
+      struct hash_table *ht =
+         _mesa_hash_table_create(NULL, hash, key_value_equals);
+
+      t = now();
+      for (i = 0; i < size; i++)
+         _mesa_hash_table_insert(ht, keys[i], NULL);
+      ops->insert += now() - t;
+
+      t = now();
+      for (i = 0; i < size; i++) {
+         if (!_mesa_hash_table_search(ht, keys[i]))
+            abort();
+      }
+      ops->search_hit += now() - t;
+
+      t = now();
+      for (i = 0; i < size; i++) {
+         if (_mesa_hash_table_search(ht, misses[i]))
+            abort();
+      }
+      ops->search_miss += now() - t;
+
+      t = now();
+      for (i = 0; i < size; i++)
+         _mesa_hash_table_remove(ht, _mesa_hash_table_search(ht, keys[i]));
+      ops->remove += now() - t;
+
+      assert(ht->entries == 0);
+      _mesa_hash_table_destroy(ht, NULL);
+   }
+}
+
+static void
+bench_set(const void **keys, const void **misses, unsigned size,
+          unsigned rounds, bool pointers, struct ops *ops)
+{
+   uint32_t (*hash)(const void *) =
+      pointers ? _mesa_hash_pointer : key_value;
+   unsigned r, i;
+   double t;
+
+   memset(ops, 0, sizeof(*ops));
+
+   for (r = 0; r < rounds; r++) {
+      struct set *set = _mesa_set_create(NULL, hash, key_value_equals);
+
+      t = now();
+      for (i = 0; i < size; i++)
+         _mesa_set_add(set, keys[i]);
+      ops->insert += now() - t;
+
+      t = now();
+      for (i = 0; i < size; i++) {
+         if (!_mesa_set_search(set, keys[i]))
+            abort();
+      }
+      ops->search_hit += now() - t;
+
+      t = now();
+      for (i = 0; i < size; i++) {
+         if (_mesa_set_search(set, misses[i]))
+            abort();
+      }
+      ops->search_miss += now() - t;
+
+      t = now();
+      for (i = 0; i < size; i++)
+         _mesa_set_remove(set, _mesa_set_search(set, keys[i]));
+      ops->remove += now() - t;
+
+      assert(set->entries == 0);
+      _mesa_set_destroy(set, NULL);
+   }
+}
+
+int
+main(int argc, char **argv)
+{
+   static const unsigned sizes[] = { 16, 256, 4096, 65536, 1048576 };
+   unsigned total = argc > 1 ? strtoul(argv[1], NULL, 0) : 1 << 22;
+   unsigned max_size = sizes[ARRAY_SIZE(sizes) - 1];
+   const void **keys = malloc(max_size * sizeof(*keys));
+   const void **misses = malloc(max_size * sizeof(*misses));
+   char *storage = malloc(2 * max_size * 16);
+   unsigned s, i, p;
+
+   if (!keys || !misses || !storage)
+      return 1;
+
+   printf("%-10s %-8s %8s  %8s %8s %8s %8s   (Mops/s)\n", "table", "keys",
+          "size", "insert", "hit", "miss", "remove");
+
+   for (p = 0; p < 2; p++) {
+      const bool pointers = p == 0;
+
+      /* Heap-like pointers or small integers, inserted in random order. */
+      for (i = 0; i < max_size; i++) {
+         if (pointers) {
+            keys[i] = storage + 16 * (2 * i);
+            misses[i] = storage + 16 * (2 * i + 1);
+         } else {
+            keys[i] = (const void *) (uintptr_t) (i + 1);
+            misses[i] = (const void *) (uintptr_t) (max_size + i + 1);
+         }
+      }
+      for (i = max_size - 1; i > 0; i--) {
+         unsigned j = rand() % (i + 1);
+         const void *tmp = keys[i];
+         keys[i] = keys[j];
+         keys[j] = tmp;
+      }
+
+      for (s = 0; s < ARRAY_SIZE(sizes); s++) {
+         unsigned rounds = total > sizes[s] ? total / sizes[s] : 1;
+         struct ops ops;
+
+         bench_hash_table(keys, misses, sizes[s], rounds, pointers, &ops);
+         print_ops("hash_table", pointers ? "pointer" : "integer",
+                   sizes[s], &ops, rounds * sizes[s]);
+
+         bench_set(keys, misses, sizes[s], rounds, pointers, &ops);
+         print_ops("set", pointers ? "pointer" : "integer",
+                   sizes[s], &ops, rounds * sizes[s]);
+      }
+   }
+
+   free(keys);
+   free(misses);
+   free(storage);
+
+   return 0;
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright © 2015 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/** @file interval_graphs.c
+ *
+ * Builds interference graphs from random live intervals, the way the i965
+ * backends do, and times building and coloring them.  The graphs built with
+ * ra_add_node_interference() on every pair and with
+ * ra_add_live_range_interference() (single and multithreaded) must color the
+ * same way, and the coloring must be valid.
+ *
+ * Node counts to run can be given on the command line.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ralloc.h"
+#include "register_allocate.h"
+
+#define BASE_REGS 128
+#define MAX_SIZE 4
+
+struct reg_set {
+   struct ra_regs *regs;
+   unsigned int classes[MAX_SIZE];
+   /** First base register of each register. */
+   unsigned int base[BASE_REGS * MAX_SIZE];
+   unsigned int size[BASE_REGS * MAX_SIZE];
+};
+
+struct intervals {
+   unsigned int count;
+   int *start;
+   int *end;
+   unsigned int *size;
+};
+
+static uint32_t seed = 1;
+
+static uint32_t
+next_random(void)
+{
+   seed = seed * 1103515245 + 12345;
+   return seed >> 8;
+}
+
+static double
+now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * A register file of 128 registers with classes of 1 to 4 contiguous
+ * registers, like the one brw_fs_reg_allocate.cpp sets up.
+ */
+static void
+create_reg_set(void *mem_ctx, struct reg_set *set)
+{
+   unsigned int reg_count = 0;
+   unsigned int s, r, i;
+
+   for (s = 1; s <= MAX_SIZE; s++)
+      reg_count += BASE_REGS - s + 1;
+
+   set->regs = ra_alloc_reg_set(mem_ctx, reg_count, true);
+
+   reg_count = 0;
+   for (s = 1; s <= MAX_SIZE; s++) {
+      set->classes[s - 1] = ra_alloc_reg_class(set->regs);
+
+      for (r = 0; r <= BASE_REGS - s; r++) {
+         ra_class_add_reg(set->regs, set->classes[s - 1], reg_count);
+         set->base[reg_count] = r;
+         set->size[reg_count] = s;
+
+         if (s > 1) {
+            for (i = 0; i < s; i++)
+               ra_add_transitive_reg_conflict(set->regs, r + i, reg_count);
+         }
+         reg_count++;
+      }
+   }
+
+   ra_set_finalize(set->regs, NULL);
+}
+
+/**
+ * Random intervals with an average pressure of about 40 registers over a
+ * program proportional in length to the number of intervals.
+ */
+static void
+create_intervals(void *mem_ctx, struct intervals *iv, unsigned int count)
+{
+   const unsigned int length = count * 3 / 2;
+   unsigned int i;
+
+   iv->count = count;
+   iv->start = ralloc_array(mem_ctx, int, count);
+   iv->end = ralloc_array(mem_ctx, int, count);
+   iv->size = ralloc_array(mem_ctx, unsigned int, count);
+
+   for (i = 0; i < count; i++) {
+      /* A few dead values, as left behind by optimizations. */
+      if (next_random() % 64 == 0) {
+         iv->start[i] = length;
+         iv->end[i] = -1;
+      } else {
+         iv->start[i] = next_random() % length;
+         iv->end[i] = iv->start[i] + 1 + next_random() % 48;
+      }
+      iv->size[i] = 1 + next_random() % MAX_SIZE;
+   }
+}
+
+static bool
+intervals_overlap(const struct intervals *iv, unsigned int a, unsigned int b)
+{
+   return !(iv->end[a] <= iv->start[b] || iv->end[b] <= iv->start[a]);
+}
+
+enum build_mode {
+   BUILD_PAIRS,
+   BUILD_RANGES,
+   BUILD_RANGES_THREADED,
+};
+
+static const char *mode_names[] = {
+   "pairs",
+   "ranges",
+   "ranges (threaded)",
+};
+
+static struct ra_graph *
+build_graph(struct reg_set *set, const struct intervals *iv,
+            enum build_mode mode)
+{
+   struct ra_graph *g = ra_alloc_interference_graph(set->regs, iv->count);
+   unsigned int i, j;
+
+   for (i = 0; i < iv->count; i++)
+      ra_set_node_class(g, i, set->classes[iv->size[i] - 1]);
+
+   switch (mode) {
+   case BUILD_PAIRS:
+      for (i = 0; i < iv->count; i++) {
+         for (j = 0; j < i; j++) {
+            if (intervals_overlap(iv, i, j))
+               ra_add_node_interference(g, i, j);
+         }
+      }
+      break;
+   case BUILD_RANGES:
+   case BUILD_RANGES_THREADED:
+      ra_set_parallel_interference(set->regs,
+                                   mode == BUILD_RANGES_THREADED ? 0 : 1);
+      ra_add_live_range_interference(g, 0, iv->count, iv->start, iv->end);
+      break;
+   }
+
+   return g;
+}
+
+static bool
+check_coloring(const struct reg_set *set, const struct intervals *iv,
+               struct ra_graph *g)
+{
+   unsigned int i, j;
+
+   for (i = 0; i < iv->count; i++) {
+      unsigned int ri = ra_get_node_reg(g, i);
+
+      for (j = 0; j < i; j++) {
+         unsigned int rj = ra_get_node_reg(g, j);
+
+         if (!intervals_overlap(iv, i, j))
+            continue;
+
+         if (set->base[ri] < set->base[rj] + set->size[rj] &&
+             set->base[rj] < set->base[ri] + set->size[ri]) {
+            fprintf(stderr, "nodes %u and %u interfere but got registers "
+                    "%u and %u\n", i, j, ri, rj);
+            return false;
+         }
+      }
+   }
+
+   return true;
+}
+
+static bool
+run(void *mem_ctx, struct reg_set *set, unsigned int count)
+{
+   struct intervals iv;
+   unsigned int *colors = NULL;
+   bool first_success = false;
+   bool pass = true;
+   unsigned int mode, i;
+
+   create_intervals(mem_ctx, &iv, count);
+
+   for (mode = BUILD_PAIRS; mode <= BUILD_RANGES_THREADED; mode++) {
+      double t0 = now();
+      struct ra_graph *g = build_graph(set, &iv, mode);
+      double t1 = now();
+      bool success = ra_allocate(g);
+      double t2 = now();
+
+      printf("%6u nodes, %-17s: build %8.3f ms, allocate %8.3f ms%s\n",
+             count, mode_names[mode], (t1 - t0) * 1000, (t2 - t1) * 1000,
+             success ? "" : " (failed)");
+
+      if (mode == BUILD_PAIRS) {
+         first_success = success;
+         if (success) {
+            colors = ralloc_array(mem_ctx, unsigned int, count);
+            for (i = 0; i < count; i++)
+               colors[i] = ra_get_node_reg(g, i);
+            pass = check_coloring(set, &iv, g) && pass;
+         }
+      } else if (success != first_success) {
+         fprintf(stderr, "%s: allocation %s unlike with pairs\n",
+                 mode_names[mode], success ? "succeeded" : "failed");
+         pass = false;
+      } else if (success) {
+         for (i = 0; i < count; i++) {
+            if (ra_get_node_reg(g, i) != colors[i]) {
+               fprintf(stderr, "%s: node %u got register %u instead of %u\n",
+                       mode_names[mode], i, ra_get_node_reg(g, i), colors[i]);
+               pass = false;
+               break;
+            }
+         }
+      }
+
+      ralloc_free(g);
+   }
+
+   return pass;
+}
+
+int
+main(int argc, char **argv)
+{
+   static const unsigned int default_counts[] = { 256, 1024, 4096, 8192 };
+   void *mem_ctx = ralloc_context(NULL);
+   struct reg_set set;
+   bool pass = true;
+   int i;
+
+   create_reg_set(mem_ctx, &set);
+
+   if (argc > 1) {
+      for (i = 1; i < argc; i++)
+         pass = run(mem_ctx, &set, strtoul(argv[i], NULL, 0)) && pass;
+   } else {
+      for (i = 0; i < (int) (sizeof(default_counts) /
+                             sizeof(default_counts[0])); i++)
+         pass = run(mem_ctx, &set, default_counts[i]) && pass;
+   }
+
+   ralloc_free(mem_ctx);
+
+   return pass ? 0 : 1;
+}
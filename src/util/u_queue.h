@@ -0,0 +1,130 @@
+/*
+ * Copyright © 2016 Advanced Micro Devices, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * on the rights to use, copy, modify, merge, publish, distribute, sub
+ * license, and/or sell copies of the Software, and to permit persons to whom
+ * the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHOR(S) AND/OR THEIR SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE. */
+
+/* Job queue with execution in separate threads.
+ *
+ * Jobs can be added from any thread. After that, the wait call can be used
+ * to wait for completion of the job.
+ *
+ * Each priority level has its own ring of max_jobs entries, and threads
+ * always take the oldest job of the highest priority available. Adding a job
+ * to a full ring blocks until a thread takes a job from it.
+ *
+ * A job can be added without a fence if nobody needs to wait for it. It
+ * then owns its memory and must free it in the execute callback.
+ */
+
+#ifndef U_QUEUE_H
+#define U_QUEUE_H
+
+#include <stdbool.h>
+
+#include "c11/threads.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum util_queue_priority {
+   UTIL_QUEUE_PRIORITY_HIGH,
+   UTIL_QUEUE_PRIORITY_NORMAL,
+   UTIL_QUEUE_PRIORITY_LOW,
+   UTIL_QUEUE_NUM_PRIORITIES
+};
+
+/* Job completion fence.
+ * Put this into your job structure.
+ */
+struct util_queue_fence {
+   mtx_t mutex;
+   cnd_t cond;
+   int signalled;
+};
+
+typedef void (*util_queue_execute_func)(void *job, int thread_index);
+
+struct util_queue_job {
+   void *job;
+   struct util_queue_fence *fence;
+   util_queue_execute_func execute;
+};
+
+struct util_queue_ring {
+   int num_queued;
+   int write_idx, read_idx; /* ring buffer pointers */
+   struct util_queue_job *jobs;
+};
+
+/* Put this into your context. */
+struct util_queue {
+   const char *name;
+   mtx_t lock;
+   cnd_t has_queued_cond;
+   cnd_t has_space_cond;
+   cnd_t idle_cond;
+   thrd_t *threads;
+   int num_queued; /* in all rings */
+   int num_running;
+   unsigned num_threads;
+   int kill_threads;
+   int max_jobs;
+   struct util_queue_ring rings[UTIL_QUEUE_NUM_PRIORITIES];
+};
+
+bool util_queue_init(struct util_queue *queue,
+                     const char *name,
+                     unsigned max_jobs,
+                     unsigned num_threads);
+
+/* Jobs still queued are not executed, but their fences are signalled. */
+void util_queue_destroy(struct util_queue *queue);
+
+void util_queue_fence_init(struct util_queue_fence *fence);
+void util_queue_fence_destroy(struct util_queue_fence *fence);
+
+/* Adds a job with UTIL_QUEUE_PRIORITY_NORMAL. */
+void util_queue_add_job(struct util_queue *queue,
+                        void *job,
+                        struct util_queue_fence *fence,
+                        util_queue_execute_func execute);
+void util_queue_add_job_with_priority(struct util_queue *queue,
+                                      void *job,
+                                      struct util_queue_fence *fence,
+                                      util_queue_execute_func execute,
+                                      enum util_queue_priority priority);
+void util_queue_job_wait(struct util_queue_fence *fence);
+
+/* Waits until all the jobs added so far have been executed. */
+void util_queue_finish(struct util_queue *queue);
+
+/* util_queue needs to be cleared to zeroes for this to work */
+static inline bool
+util_queue_is_initialized(struct util_queue *queue)
+{
+   return queue->threads != NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,207 @@
+/*
+ * Copyright © 2016 Mesa contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/* Checks the job queue: fences, priorities, fence-less jobs and finish. */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "u_atomic.h"
+#include "u_queue.h"
+
+#define NUM_JOBS 256
+
+static bool failed = false;
+
+static void
+expect(bool cond, const char *test)
+{
+   if (!cond) {
+      fprintf(stderr, "FAIL: %s\n", test);
+      failed = true;
+   }
+}
+
+/* A job that doesn't return before gate_open() is called, to hold up a
+ * single-threaded queue while other jobs are added.
+ */
+static mtx_t gate_mutex;
+static cnd_t gate_cond;
+static bool gate_is_open;
+
+static void
+gate_job(void *job, int thread_index)
+{
+   mtx_lock(&gate_mutex);
+   while (!gate_is_open)
+      cnd_wait(&gate_cond, &gate_mutex);
+   mtx_unlock(&gate_mutex);
+}
+
+static void
+gate_open(void)
+{
+   mtx_lock(&gate_mutex);
+   gate_is_open = true;
+   cnd_broadcast(&gate_cond);
+   mtx_unlock(&gate_mutex);
+}
+
+struct order_job {
+   struct util_queue_fence fence;
+   unsigned *next;
+   unsigned order;
+};
+
+static void
+order_job(void *job, int thread_index)
+{
+   struct order_job *j = job;
+
+   j->order = p_atomic_inc_return(j->next) - 1;
+}
+
+static unsigned counter;
+
+static void
+count_job(void *job, int thread_index)
+{
+   p_atomic_inc(&counter);
+   free(job);
+}
+
+static void
+test_fences(void)
+{
+   struct util_queue queue;
+   struct order_job jobs[NUM_JOBS];
+   unsigned next = 0;
+   unsigned i;
+
+   if (!util_queue_init(&queue, "test", 8, 4)) {
+      expect(false, "util_queue_init with 4 threads");
+      return;
+   }
+
+   /* Small rings make add_job wait for space. */
+   for (i = 0; i < NUM_JOBS; i++) {
+      util_queue_fence_init(&jobs[i].fence);
+      jobs[i].next = &next;
+      jobs[i].order = ~0u;
+      util_queue_add_job(&queue, &jobs[i], &jobs[i].fence, order_job);
+   }
+
+   for (i = 0; i < NUM_JOBS; i++) {
+      util_queue_job_wait(&jobs[i].fence);
+      expect(jobs[i].order < NUM_JOBS, "job done when its fence is signalled");
+      util_queue_fence_destroy(&jobs[i].fence);
+   }
+   expect(next == NUM_JOBS, "every job runs once");
+
+   util_queue_destroy(&queue);
+}
+
+static void
+test_priorities(void)
+{
+   struct util_queue queue;
+   struct util_queue_fence gate_fence;
+   struct order_job low, normal, high;
+   unsigned next = 0;
+
+   if (!util_queue_init(&queue, "test", 4, 1)) {
+      expect(false, "util_queue_init with 1 thread");
+      return;
+   }
+
+   mtx_init(&gate_mutex, mtx_plain);
+   cnd_init(&gate_cond);
+   gate_is_open = false;
+
+   util_queue_fence_init(&gate_fence);
+   util_queue_fence_init(&low.fence);
+   util_queue_fence_init(&normal.fence);
+   util_queue_fence_init(&high.fence);
+   low.next = normal.next = high.next = &next;
+
+   util_queue_add_job(&queue, &gate_fence, &gate_fence, gate_job);
+   util_queue_add_job_with_priority(&queue, &low, &low.fence, order_job,
+                                    UTIL_QUEUE_PRIORITY_LOW);
+   util_queue_add_job(&queue, &normal, &normal.fence, order_job);
+   util_queue_add_job_with_priority(&queue, &high, &high.fence, order_job,
+                                    UTIL_QUEUE_PRIORITY_HIGH);
+   gate_open();
+
+   util_queue_job_wait(&low.fence);
+   util_queue_job_wait(&normal.fence);
+   util_queue_job_wait(&high.fence);
+   util_queue_job_wait(&gate_fence);
+
+   /* The gate job may not have been taken yet when the others were added,
+    * in which case it ran after the high priority one.
+    */
+   expect(high.order < normal.order, "high priority job before normal one");
+   expect(normal.order < low.order, "normal priority job before low one");
+
+   util_queue_fence_destroy(&gate_fence);
+   util_queue_fence_destroy(&low.fence);
+   util_queue_fence_destroy(&normal.fence);
+   util_queue_fence_destroy(&high.fence);
+   cnd_destroy(&gate_cond);
+   mtx_destroy(&gate_mutex);
+   util_queue_destroy(&queue);
+}
+
+static void
+test_finish(void)
+{
+   struct util_queue queue;
+   unsigned i;
+
+   if (!util_queue_init(&queue, "test", 16, 3)) {
+      expect(false, "util_queue_init with 3 threads");
+      return;
+   }
+
+   counter = 0;
+   for (i = 0; i < NUM_JOBS; i++) {
+      util_queue_add_job_with_priority(&queue, malloc(1), NULL, count_job,
+                                       (enum util_queue_priority)
+                                       (i % UTIL_QUEUE_NUM_PRIORITIES));
+   }
+   util_queue_finish(&queue);
+   expect(counter == NUM_JOBS, "util_queue_finish runs all fence-less jobs");
+
+   util_queue_destroy(&queue);
+}
+
+int
+main(void)
+{
+   test_fences();
+   test_priorities();
+   test_finish();
+
+   return failed ? 1 : 0;
+}